@@ -0,0 +1,196 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "../hal_desktop.h"
+#include <algorithm>
+#include <cmath>
+#include <mooncake_log.h>
+#include <utils/ring_buffer/spsc_ring_buffer.h>
+#include <SDL2/SDL.h>
+
+static const char* TAG = "hal_audio";
+
+static constexpr int MONITOR_CAPACITY = 16384;  // Samples, interleaved stereo (~170 ms)
+static constexpr int MONITOR_MAX_LEAD = 4 * 480 * 2;  // Past this the playback side drops to catch up
+
+struct HalDesktop::MonitorRing {
+    smooth_ui_toolkit::spsc_ring_buffer<float, MONITOR_CAPACITY> ring;
+};
+
+void HalDesktop::audio_init()
+{
+    _monitor = new MonitorRing();
+
+    SDL_AudioSpec want{};
+    want.freq     = HostChain::SAMPLE_RATE;
+    want.format   = AUDIO_F32SYS;
+    want.channels = 2;
+    want.samples  = AUDIO_BLOCK;
+    want.userdata = this;
+
+    SDL_AudioSpec have{};
+    want.callback    = playback_callback;
+    _playback_device = SDL_OpenAudioDevice(nullptr, 0, &want, &have, 0);
+    if (_playback_device == 0) {
+        mclog::tagError(TAG, "no playback device: {}", SDL_GetError());
+    }
+    want.callback   = capture_callback;
+    _capture_device = SDL_OpenAudioDevice(nullptr, 1, &want, &have, 0);
+    if (_capture_device == 0) {
+        mclog::tagWarn(TAG, "no capture device, monitoring off: {}", SDL_GetError());
+    }
+
+    if (_playback_device) SDL_PauseAudioDevice(_playback_device, 0);
+    if (_capture_device) SDL_PauseAudioDevice(_capture_device, 0);
+    setSpeakerVolume(_speaker_volume.load());
+}
+
+void HalDesktop::audio_deinit()
+{
+    if (_capture_device) SDL_CloseAudioDevice(_capture_device);
+    if (_playback_device) SDL_CloseAudioDevice(_playback_device);
+    _capture_device = _playback_device = 0;
+    delete _monitor;
+    _monitor = nullptr;
+}
+
+// Capture: the chain runs here, once per block, then the block goes to playback
+void HalDesktop::capture_callback(void* user, uint8_t* stream, int len)
+{
+    auto* self        = static_cast<HalDesktop*>(user);
+    const float* in   = reinterpret_cast<const float*>(stream);
+    const int frames  = len / static_cast<int>(2 * sizeof(float));
+    float left[HostChain::MAX_FRAMES], right[HostChain::MAX_FRAMES];
+
+    for (int done = 0; done < frames;) {
+        const int n = std::min(frames - done, HostChain::MAX_FRAMES);
+        for (int i = 0; i < n; i++) {
+            left[i]  = in[2 * (done + i)];
+            right[i] = in[2 * (done + i) + 1];
+        }
+
+        {
+            // audioRecord() wants the raw mics, ahead of the chain
+            std::lock_guard<std::mutex> lock(self->_clip_mutex);
+            if (self->_record) {
+                int16_t* rec = self->_record;
+                for (int i = 0; i < n && self->_record_pos + 4 <= self->_record_size; i++) {
+                    rec[self->_record_pos++] = static_cast<int16_t>(std::clamp(left[i], -1.0f, 1.0f) * 32767.0f);
+                    rec[self->_record_pos++] = 0;
+                    rec[self->_record_pos++] = static_cast<int16_t>(std::clamp(right[i], -1.0f, 1.0f) * 32767.0f);
+                    rec[self->_record_pos++] = 0;
+                }
+                if (self->_record_pos + 4 > self->_record_size) {
+                    self->_record = nullptr;
+                    self->_clip_cv.notify_all();
+                }
+            }
+        }
+
+        self->_chain.process(left, right, n);
+        float out[2 * HostChain::MAX_FRAMES];
+        for (int i = 0; i < n; i++) {
+            out[2 * i]     = left[i];
+            out[2 * i + 1] = right[i];
+        }
+        self->_monitor->ring.push_n(out, 2 * n);  // Full: playback stalled, the block is dropped
+        done += n;
+    }
+}
+
+void HalDesktop::playback_callback(void* user, uint8_t* stream, int len)
+{
+    auto* self      = static_cast<HalDesktop*>(user);
+    float* out      = reinterpret_cast<float*>(stream);
+    const int count = len / static_cast<int>(sizeof(float));
+
+    // The two devices' clocks drift apart; keep the monitor latency bounded
+    auto& ring = self->_monitor->ring;
+    if (ring.size() > MONITOR_MAX_LEAD + static_cast<size_t>(count)) ring.skip(ring.size() - MONITOR_MAX_LEAD);
+    const size_t got = ring.pop_n(out, count);
+    std::fill(out + got, out + count, 0.0f);
+
+    std::unique_lock<std::mutex> lock(self->_clip_mutex);
+    if (self->_clip_pos < self->_clip_size) {
+        const float vol = self->_speaker_volume.load(std::memory_order_relaxed) / 100.0f;
+        const size_t n  = std::min(static_cast<size_t>(count), self->_clip_size - self->_clip_pos);
+        for (size_t i = 0; i < n; i++) {
+            out[i] = std::clamp(out[i] + vol * self->_clip[self->_clip_pos + i] / 32768.0f, -1.0f, 1.0f);
+        }
+        self->_clip_pos += n;
+        if (self->_clip_pos >= self->_clip_size) self->finish_clip(lock);
+    }
+}
+
+// Drops the clip, wakes a sync audioPlayBuffer() and hands the buffer back; unlocks first, so
+// done (on the playback callback, or the caller replacing it) can queue the next one
+void HalDesktop::finish_clip(std::unique_lock<std::mutex>& lock)
+{
+    AudioDone_t done = _clip_done;
+    void* user       = _clip_user;
+    _clip            = nullptr;
+    _clip_size       = 0;
+    _clip_pos        = 0;
+    _clip_done       = nullptr;
+    _clip_cv.notify_all();
+    lock.unlock();
+    if (done) done(user);
+}
+
+void HalDesktop::setSpeakerVolume(uint8_t volume)
+{
+    volume = std::min<uint8_t>(volume, 100);
+    _speaker_volume.store(volume, std::memory_order_relaxed);
+    // 0.5 dB a step below 100, the codec's default volume curve
+    _chain.setVolume(volume == 0 ? 0.0f : powf(10.0f, (volume - 100) * 0.5f / 20.0f));
+}
+
+uint8_t HalDesktop::getSpeakerVolume()
+{
+    return _speaker_volume.load(std::memory_order_relaxed);
+}
+
+// [MIC-L, AEC, MIC-R, MIC-HP] like the Tab5; the host has no loopback or headset mic, those stay 0
+size_t HalDesktop::audioRecordInto(int16_t* data, size_t samples, float gain)
+{
+    std::fill(data, data + samples, 0);
+    if (!_capture_device) return 0;
+    std::unique_lock<std::mutex> lock(_clip_mutex);
+    _record      = data;
+    _record_size = samples;
+    _record_pos  = 0;
+    const auto timeout = std::chrono::milliseconds(samples / 4 * 1000 / HostChain::SAMPLE_RATE + 500);
+    if (!_clip_cv.wait_for(lock, timeout, [this] { return !_record; })) {
+        _record = nullptr;
+        mclog::tagWarn(TAG, "capture stalled, record cut short");
+    }
+    return _record_pos;
+}
+
+// Interleaved stereo at 48 kHz; a new clip replaces the one playing, which is handed back
+bool HalDesktop::audioPlayBuffer(const int16_t* data, size_t samples, bool async, AudioDone_t done, void* user)
+{
+    if (!_playback_device) return false;
+    std::unique_lock<std::mutex> lock(_clip_mutex);
+    if (_clip) {
+        finish_clip(lock);
+        lock.lock();
+    }
+    _clip      = data;
+    _clip_size = samples;
+    _clip_pos  = 0;
+    _clip_done = done;
+    _clip_user = user;
+    if (async) return true;
+    // Until it's played out or replaced
+    _clip_cv.wait(lock, [this, data] { return _clip != data || _clip_pos >= _clip_size; });
+    return true;
+}
+
+bool HalDesktop::headPhoneDetect()
+{
+    // The host's output is what the wearer hears
+    return true;
+}
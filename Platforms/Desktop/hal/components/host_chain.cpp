@@ -0,0 +1,296 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "host_chain.h"
+#include "components/profile_schema.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <mooncake_log.h>
+
+static const char* TAG = "HostChain";
+
+static constexpr float SCENE_LOWPASS = 0.0634f;  // One-pole ~500Hz at 48kHz, as on the device
+static constexpr float SCENE_QUIET_DB = -50.0f;  // AudioEngineParams::sceneQuietDb default
+static constexpr float GAIN_SMOOTHING = 0.002f;  // Per sample, ~10ms
+
+static const char* STAGE_NAMES[HostChain::TAG_COUNT] = {"mic gain", "input", "wdrc", "mbc", "tinnitus",
+                                                        "output"};
+
+// Profile keys the stages here (or howizard_offline's blocks) apply, by prefix; the rest are device-only
+static const char* const APPLIED_KEYS[] = {
+    "hpf", "lpf", "eq", "earsLinked", "right", "outputGain", "boostEnabled", "blockSize",
+    "mbc", "limiter", "wdrc", "audiogram", "notch", "hfExt",
+};
+
+static bool hostApplies(const char* key)
+{
+    for (const char* prefix : APPLIED_KEYS) {
+        if (strncmp(key, prefix, strlen(prefix)) == 0) return true;
+    }
+    return false;
+}
+
+HostChain::HostChain()
+{
+    _graph.addStage({micGainProcess, nullptr, this, DspGraph::RATE_48K, TAG_MIC_GAIN}, true);
+    _graph.addStage({inputProcess, nullptr, this, DspGraph::RATE_48K, TAG_INPUT}, true);
+    _wdrcStage = _graph.addStage({wdrcProcess, wdrcReset, this, DspGraph::RATE_48K, TAG_WDRC});
+    _mbcStage = _graph.addStage({mbcProcess, mbcReset, this, DspGraph::RATE_48K, TAG_MBC});
+    _tinnitusStage = _graph.addStage({tinnitusProcess, nullptr, this, DspGraph::RATE_48K, TAG_TINNITUS});
+    _graph.addStage({outputProcess, nullptr, this, DspGraph::RATE_48K, TAG_OUTPUT}, true);
+    configure(_params);
+}
+
+void HostChain::applyProfile(const AudioEngineParams& params)
+{
+    const AudioEngineParams defaults;
+    char value[32];
+    for (int i = 0; i < ProfileSchema::fieldCount(); i++) {
+        const ProfileSchema::Field& f = ProfileSchema::fields()[i];
+        if (hostApplies(f.key) || ProfileSchema::raw(f, params) == ProfileSchema::raw(f, defaults)) continue;
+        ProfileSchema::format(f, params, value, sizeof(value));
+        mclog::tagWarn(TAG, "profile: {}={} is not applied on the host", f.key, value);
+    }
+    _profile.back() = params;
+    _profile.publish();
+}
+
+void HostChain::process(float* left, float* right, int frames)
+{
+    feedScene(left, right, frames);
+    if (_profile.update()) configure(_profile.front());
+    _graph.setEnabled(_tinnitusStage, _tinnitus.activeCount() > 0 || (_earsSplit && _tinnitusR.activeCount() > 0));
+
+    using Clock = std::chrono::steady_clock;
+    auto last = Clock::now();
+    _graph.run(left, right, frames, [&](int tag) {
+        const auto now = Clock::now();
+        if (tag >= 0 && tag < TAG_COUNT) {
+            _stageNs[tag] += std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count();
+        }
+        last = now;
+    });
+    _framesTimed += frames;
+    if (_framesTimed >= static_cast<uint64_t>(STATS_SECONDS) * SAMPLE_RATE) logStats();
+}
+
+// AudioEngine::recalcAllCoeffs at 48kHz, every section at once: the cascades glide to
+// the new coefficients, the crossover and WDRC layout start from clean state
+void HostChain::configure(const AudioEngineParams& p)
+{
+    const bool split = !p.earsLinked;
+    if (split != _earsSplit) {
+        _inputR.reset();
+        _tinnitusR.reset();
+        _earsSplit = split;
+    }
+    configureEar(_input, _tinnitus, p.ear(AUDIO_EAR_LEFT));
+    if (split) configureEar(_inputR, _tinnitusR, p.rightEar);
+
+    Biquad bq;
+    calcHighShelfCoeffs(bq, p.tinnitus.hfExtFreq, p.tinnitus.hfExtGainDb, SAMPLE_RATE);
+    _tinnitus.setSection(SLOT_HF_EXT, bq, p.tinnitus.hfExtEnabled);
+    _tinnitusR.setSection(SLOT_HF_EXT, bq, p.tinnitus.hfExtEnabled);
+
+    // Multiband compressor: crossover splits kept ascending, >= 1/2 octave apart
+    const DynamicsParams& d = p.dynamics;
+    _mbc.setBandCount(d.mbcBands);
+    float prev = 0.0f;
+    for (int s = 0; s < MultibandDynamics::MAX_BANDS - 1; s++) {
+        float fc = std::clamp(std::max(d.crossoverHz[s], prev * 1.414f), 40.0f, 18000.0f);
+        Biquad lp, hp, ap;
+        calcLpfCoeffs(lp, fc, SAMPLE_RATE);
+        calcHpfCoeffs(hp, fc, SAMPLE_RATE);
+        calcAllpassCoeffs(ap, fc, SAMPLE_RATE);
+        _mbc.setSplit(s, lp, hp, ap);
+        prev = fc;
+    }
+    for (int k = 0; k < MultibandDynamics::MAX_BANDS; k++) {
+        const auto& b = d.bands[k];
+        _mbc.setBand(k, b.thresholdDb, b.ratio, b.attackMs, b.releaseMs, b.makeupDb, SAMPLE_RATE);
+    }
+
+    // Hearing-loss fitting: each band's curve from the audiogram at its centre frequency
+    const FittingParams& fit = p.fitting;
+    _wdrc.setLayout(fit.wdrcBands, FittingParams::FREQS_HZ[0], FittingParams::FREQS_HZ[FittingParams::NUM_FREQS - 1],
+                    SAMPLE_RATE);
+    const float kneeDbfs = WDRC_KNEE_SPL - fit.calibrationDbSpl;
+    for (int ear = 0; ear < 2; ear++) {
+        const float* hl = ear == 0 ? fit.audiogramL : fit.audiogramR;
+        for (int k = 0; k < _wdrc.bandCount(); k++) {
+            WdrcFit band = fitWdrcBand(
+                audiogramAt(FittingParams::FREQS_HZ, hl, FittingParams::NUM_FREQS, _wdrc.centerHz(k)), fit.maxGainDb);
+            _wdrc.setCurve(ear, k, kneeDbfs, band.gainDb, band.ratio, fit.maxGainDb);
+        }
+    }
+    _wdrc.setTiming(fit.attackMs, fit.releaseMs, SAMPLE_RATE);
+
+    _graph.setEnabled(_wdrcStage, fit.wdrcEnabled);
+    _graph.setEnabled(_mbcStage, d.mbcEnabled);
+    _params = p;
+}
+
+// AudioEngine::recalcEarCoeffs for one ear, all sections
+void HostChain::configureEar(BiquadCascade& input, BiquadCascade& tinnitus, const EarParams& e)
+{
+    Biquad bq;
+    calcHpfCoeffs(bq, e.hpfFrequency, SAMPLE_RATE);
+    input.setSection(SLOT_HPF, bq, e.hpfEnabled);
+    calcLpfCoeffs(bq, e.lpfFrequency, SAMPLE_RATE);
+    input.setSection(SLOT_LPF, bq, e.lpfEnabled);
+    const float eqGain[EQ_BANDS] = {e.eqLowGain, e.eqMidGain, e.eqHighGain};
+    for (int b = 0; b < EQ_BANDS; b++) {
+        calcFixedEqCoeffs(bq, b, eqGain[b], SAMPLE_RATE);
+        input.setSection(SLOT_EQ_LOW + b, bq, true);
+    }
+    for (int i = 0; i < 6; i++) {
+        const auto& n = e.notches[i];
+        calcNotchCoeffs(bq, n.frequency, n.Q, SAMPLE_RATE);
+        tinnitus.setSection(SLOT_NOTCH0 + i, bq, n.enabled);
+    }
+}
+
+void HostChain::micGainProcess(void* ctx, DspGraph::Block& block)
+{
+    auto* self = static_cast<HostChain*>(ctx);
+    const float target = self->_micGain.load(std::memory_order_relaxed);
+    float g = self->_micGainApplied;
+    for (int i = 0; i < block.frames; i++) {
+        g += GAIN_SMOOTHING * (target - g);
+        block.left[i] *= g;
+        block.right[i] *= g;
+    }
+    self->_micGainApplied = fabsf(g - target) < 1e-5f ? target : g;
+}
+
+// Input HPF / LPF / EQ: one stereo cascade linked, one per ear split
+void HostChain::inputProcess(void* ctx, DspGraph::Block& block)
+{
+    auto* self = static_cast<HostChain*>(ctx);
+    if (self->_earsSplit) {
+        self->_input.process(block.left, nullptr, block.frames);
+        self->_inputR.process(block.right, nullptr, block.frames);
+    } else {
+        self->_input.process(block.left, block.right, block.frames);
+    }
+}
+
+void HostChain::wdrcProcess(void* ctx, DspGraph::Block& block)
+{
+    static_cast<HostChain*>(ctx)->_wdrc.process(block.left, block.right, block.frames);
+}
+
+void HostChain::wdrcReset(void* ctx)
+{
+    static_cast<HostChain*>(ctx)->_wdrc.reset();
+}
+
+void HostChain::mbcProcess(void* ctx, DspGraph::Block& block)
+{
+    static_cast<HostChain*>(ctx)->_mbc.process(block.left, block.right, block.frames);
+}
+
+void HostChain::mbcReset(void* ctx)
+{
+    static_cast<HostChain*>(ctx)->_mbc.reset();
+}
+
+// Notches, then the HF extension shelf
+void HostChain::tinnitusProcess(void* ctx, DspGraph::Block& block)
+{
+    auto* self = static_cast<HostChain*>(ctx);
+    if (self->_earsSplit) {
+        self->_tinnitus.process(block.left, nullptr, block.frames);
+        self->_tinnitusR.process(block.right, nullptr, block.frames);
+    } else {
+        self->_tinnitus.process(block.left, block.right, block.frames);
+    }
+}
+
+// The engine's steps 9-12: per-ear output gain, limiter, then the output kernel's soft clip
+// (boost) and int16 pack, read back as float; the volume follows, as the codec's does.
+// outputMute (on by default, for the wearer's safety) stays with the device
+void HostChain::outputProcess(void* ctx, DspGraph::Block& block)
+{
+    auto* self = static_cast<HostChain*>(ctx);
+    const AudioEngineParams& p = self->_params;
+    float* l = block.left;
+    float* r = block.right;
+    const int n = block.frames;
+
+    float gain = p.outputGain;
+    if (!p.earsLinked && p.rightEar.outputGain != gain) {
+        for (int i = 0; i < n; i++) {
+            l[i] *= gain;
+            r[i] *= p.rightEar.outputGain;
+        }
+        gain = 1.0f;
+    }
+    if (p.dynamics.limiterEnabled) {
+        if (!self->_limiterLive) self->_limiter.reset();
+        self->_limiter.configure(p.dynamics.limiterCeilingDb, p.dynamics.limiterReleaseMs, SAMPLE_RATE);
+        self->_limiter.process(l, r, n, gain);
+        gain = 1.0f;
+    }
+    self->_limiterLive = p.dynamics.limiterEnabled;
+
+    float sumL = 0.0f, sumR = 0.0f, pkL = 0.0f, pkR = 0.0f;
+    int16_t* packed = self->_packed;
+    if (p.boostEnabled) {
+        outputKernel<true, true>(l, r, packed, n, gain, sumL, sumR, pkL, pkR);
+    } else {
+        outputKernel<false, true>(l, r, packed, n, gain, sumL, sumR, pkL, pkR);
+    }
+
+    const float target = self->_volume.load(std::memory_order_relaxed);
+    float g = self->_volumeApplied;
+    for (int i = 0; i < n; i++) {
+        g += GAIN_SMOOTHING * (target - g);
+        l[i] = packed[2 * i] * (g / 32767.0f);
+        r[i] = packed[2 * i + 1] * (g / 32767.0f);
+    }
+    self->_volumeApplied = fabsf(g - target) < 1e-5f ? target : g;
+}
+
+// Same frames as the engine's step 1c: mid-channel power, low band and first difference
+void HostChain::feedScene(const float* left, const float* right, int frames)
+{
+    for (int i = 0; i < frames; i++) {
+        const float x = 0.5f * (left[i] + right[i]);
+        _sceneLow += SCENE_LOWPASS * (x - _sceneLow);
+        const float d = x - _scenePrev;
+        _scenePrev = x;
+        _sceneFrame.power += x * x;
+        _sceneFrame.lowPower += _sceneLow * _sceneLow;
+        _sceneFrame.highPower += d * d;
+        if (++_sceneFill < SCENE_FRAME) continue;
+
+        const float inv = 1.0f / _sceneFill;
+        _sceneFrame.power *= inv;
+        _sceneFrame.lowPower *= inv;
+        _sceneFrame.highPower *= inv;
+        if (_classifier.push(_sceneFrame, SCENE_QUIET_DB) && _classifier.scene() != scene()) {
+            const SceneClassifier::Features& f = _classifier.features();
+            mclog::tagInfo(TAG, "scene: {} (level {:.0f}dB floor {:.0f}dB mod {:.1f}dB active {:.2f})",
+                SceneClassifier::name(_classifier.scene()), f.levelDb, f.floorDb, f.modulationDb, f.activeRatio);
+            _scene.store(_classifier.scene(), std::memory_order_relaxed);
+        }
+        _sceneFrame = SceneFrame{};
+        _sceneFill = 0;
+    }
+}
+
+void HostChain::logStats()
+{
+    // Share of real time, the unit AudioCostModel prices the device stages in
+    const double audioNs = 1e9 * static_cast<double>(_framesTimed) / SAMPLE_RATE;
+    for (int t = 0; t < TAG_COUNT; t++) {
+        mclog::tagInfo(TAG, "{:<10} {:.3f}% of real time", STAGE_NAMES[t], 100.0 * _stageNs[t] / audioNs);
+        _stageNs[t] = 0;
+    }
+    _framesTimed = 0;
+}
@@ -0,0 +1,122 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "utils/dsp_graph/dsp_graph.h"
+#include "utils/dsp_kernels/dsp_kernels.h"
+#include "utils/scene_classifier/scene_classifier.h"
+#include "utils/triple_buffer/triple_buffer.h"
+#include "components/audio_params.h"
+
+/**
+ * @brief The device's portable DSP pieces on the host's live audio
+ *
+ * AudioEngine itself needs ESP-SR, esp-dsp and FreeRTOS, so the desktop runs
+ * the 48kHz part of its chain from the sources the Tab5 compiles (dsp_kernels,
+ * DspGraph, SceneClassifier): mic gain, the input HPF / LPF / 3-band EQ
+ * cascade, WDRC, the multiband compressor, the tinnitus notches and HF shelf,
+ * then output gain, look-ahead limiter and the output kernel's soft clip and
+ * int16 clamp. Ears are linked or split as the profile says. What needs the
+ * 16kHz bus or the SDK (NS, AGC, voice exclusion, AEC, VAD, beamforming,
+ * feedback control, generators) is left out, and applyProfile() names every
+ * profile field it set that this chain therefore ignores.
+ *
+ * Blocks come from the SDL capture callback; each step is timed, and the
+ * per-stage cost goes to the log every STATS_SECONDS, in the audio task's
+ * share-of-real-time terms. howizard_offline feeds the same chain from WAV files.
+ */
+class HostChain {
+public:
+    static constexpr int SAMPLE_RATE = 48000;
+    static constexpr int MAX_FRAMES = 1024;
+    static constexpr int SCENE_FRAME = SAMPLE_RATE * 30 / 1000;
+    static constexpr int STATS_SECONDS = 10;
+
+    enum StageTag {
+        TAG_MIC_GAIN = 0,
+        TAG_INPUT,
+        TAG_WDRC,
+        TAG_MBC,
+        TAG_TINNITUS,
+        TAG_OUTPUT,
+        TAG_COUNT,
+    };
+
+    HostChain();
+
+    // Audio callback: stereo in place
+    void process(float* left, float* right, int frames);
+
+    // Any thread
+    void setMicGain(float gain)
+    {
+        _micGain.store(gain, std::memory_order_relaxed);
+    }
+    // Playback volume after the output kernel, where the codec's sits on the device
+    void setVolume(float gain)
+    {
+        _volume.store(gain, std::memory_order_relaxed);
+    }
+    // Takes effect on the next block (one writer at a time); logs the fields set away
+    // from their defaults that the host stages don't apply
+    void applyProfile(const AudioEngineParams& params);
+    AudioScene scene() const
+    {
+        return static_cast<AudioScene>(_scene.load(std::memory_order_relaxed));
+    }
+
+private:
+    // Engine cascade slots (AudioEngine::InputSlot / TinnitusSlot)
+    enum InputSlot { SLOT_HPF = 0, SLOT_LPF, SLOT_EQ_LOW, SLOT_EQ_MID, SLOT_EQ_HIGH };
+    enum TinnitusSlot { SLOT_NOTCH0 = 0, SLOT_HF_EXT = 6 };
+
+    static void micGainProcess(void* ctx, DspGraph::Block& block);
+    static void inputProcess(void* ctx, DspGraph::Block& block);
+    static void wdrcProcess(void* ctx, DspGraph::Block& block);
+    static void wdrcReset(void* ctx);
+    static void mbcProcess(void* ctx, DspGraph::Block& block);
+    static void mbcReset(void* ctx);
+    static void tinnitusProcess(void* ctx, DspGraph::Block& block);
+    static void outputProcess(void* ctx, DspGraph::Block& block);
+    void configure(const AudioEngineParams& p);
+    void configureEar(BiquadCascade& input, BiquadCascade& tinnitus, const EarParams& e);
+    void feedScene(const float* left, const float* right, int frames);
+    void logStats();
+
+    DspGraph _graph;
+    int _wdrcStage = -1;
+    int _mbcStage = -1;
+    int _tinnitusStage = -1;
+
+    TripleBuffer<AudioEngineParams> _profile;
+    AudioEngineParams _params;  // Audio thread's copy of the last profile
+    BiquadCascade _input;
+    BiquadCascade _inputR;      // Right ear's, unlinked
+    BiquadCascade _tinnitus;
+    BiquadCascade _tinnitusR;
+    bool _earsSplit = false;
+    WdrcFilterbank _wdrc;
+    MultibandDynamics _mbc;
+    LookaheadLimiter _limiter;
+    bool _limiterLive = false;
+    int16_t _packed[2 * MAX_FRAMES] = {};
+
+    float _micGainApplied = 1.0f;
+    float _volumeApplied = 1.0f;
+    std::atomic<float> _micGain{1.0f};
+    std::atomic<float> _volume{1.0f};
+
+    SceneClassifier _classifier;
+    SceneFrame _sceneFrame;
+    float _sceneLow = 0.0f;
+    float _scenePrev = 0.0f;
+    int _sceneFill = 0;
+    std::atomic<uint8_t> _scene{AUDIO_SCENE_QUIET};
+
+    uint64_t _stageNs[TAG_COUNT] = {};
+    uint64_t _framesTimed = 0;
+};
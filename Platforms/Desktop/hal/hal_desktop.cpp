@@ -0,0 +1,116 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "hal_desktop.h"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <thread>
+#include <mooncake_log.h>
+#include <SDL2/SDL.h>
+
+static const std::string _tag = "hal";
+
+void HalDesktop::init()
+{
+    mclog::tagInfo(_tag, "sdl init");
+    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_TIMER) != 0) {
+        mclog::tagError(_tag, "SDL init failed: {}", SDL_GetError());
+    }
+
+    mclog::tagInfo(_tag, "display init");
+    lv_init();
+    lvDisp = lv_sdl_window_create(getDisplayWidth(), getDisplayHeight());
+    lv_sdl_window_set_title(lvDisp, "Howizard");
+
+    mclog::tagInfo(_tag, "input init");
+    lvTouchpad = lv_sdl_mouse_create();
+    lvWheel    = lv_sdl_mousewheel_create();
+    lvKeyboard = lv_sdl_keyboard_create();
+
+    mclog::tagInfo(_tag, "audio init");
+    audio_init();
+}
+
+HalDesktop::~HalDesktop()
+{
+    audio_deinit();
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   System                                   */
+/* -------------------------------------------------------------------------- */
+
+void HalDesktop::delay(uint32_t ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+uint32_t HalDesktop::millis()
+{
+    return SDL_GetTicks();
+}
+
+// LVGL has no task here: its timers run on the main loop, between app updates
+void HalDesktop::waitMainLoopWake(uint32_t timeoutMs)
+{
+    const uint32_t until = millis() + timeoutMs;
+    while (true) {
+        uint32_t next;
+        {
+            std::lock_guard<std::recursive_mutex> lock(_lvgl_mutex);
+            next = lv_timer_handler();
+        }
+        const uint32_t now = millis();
+        if (static_cast<int32_t>(until - now) <= 0) return;
+        next = std::min(next, until - now);
+
+        std::unique_lock<std::mutex> lock(_wake_mutex);
+        if (_wake_cv.wait_for(lock, std::chrono::milliseconds(next), [this] { return _wake_pending; })) {
+            _wake_pending = false;
+            return;
+        }
+    }
+}
+
+void HalDesktop::wakeMainLoop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_wake_mutex);
+        _wake_pending = true;
+    }
+    _wake_cv.notify_one();
+}
+
+void HalDesktop::getRtcTime(tm* time)
+{
+    const time_t now = ::time(nullptr);
+    localtime_r(&now, time);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Display                                  */
+/* -------------------------------------------------------------------------- */
+
+// No backlight: kept so the settings page reads back what it set
+void HalDesktop::setDisplayBrightness(uint8_t brightness)
+{
+    _brightness = std::min<uint8_t>(brightness, 100);
+}
+
+uint8_t HalDesktop::getDisplayBrightness()
+{
+    return _brightness;
+}
+
+void HalDesktop::lvglLock()
+{
+    _lvgl_mutex.lock();
+}
+
+void HalDesktop::lvglUnlock()
+{
+    _lvgl_mutex.unlock();
+}
@@ -0,0 +1,103 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include <hal/hal.h>
+#include <lvgl.h>
+#include "components/host_chain.h"
+
+/**
+ * @brief HAL on SDL2 for UI and DSP iteration on a desktop
+ *
+ * LVGL draws into an SDL window at the Tab5's 1280 x 720, the mouse stands in
+ * for the touch panel and the wheel and keyboard are LVGL encoder / keypad
+ * input. LVGL runs on the main thread: waitMainLoopWake() is where its timers
+ * are serviced, so the app loop is the one the Tab5 runs.
+ *
+ * Audio is an SDL capture and playback pair at 48 kHz stereo: the capture
+ * callback runs HostChain on each block and hands it to the playback callback
+ * through a ring, so the laptop mic is heard processed on its headphones.
+ * audioPlayBuffer() clips mix over it.
+ */
+class HalDesktop : public hal::HalBase {
+public:
+    std::string type() override
+    {
+        return "Desktop";
+    }
+
+    void init() override;
+    ~HalDesktop() override;
+
+    void delay(uint32_t ms) override;
+    uint32_t millis() override;
+    void waitMainLoopWake(uint32_t timeoutMs) override;
+    void wakeMainLoop() override;
+
+    lv_display_t* lvDisp   = nullptr;
+    lv_indev_t* lvKeyboard = nullptr;
+    lv_indev_t* lvWheel    = nullptr;
+
+    void setDisplayBrightness(uint8_t brightness) override;
+    uint8_t getDisplayBrightness() override;
+
+    void lvglLock() override;
+    void lvglUnlock() override;
+
+    void getRtcTime(tm* time) override;
+
+    void setSpeakerVolume(uint8_t volume) override;
+    uint8_t getSpeakerVolume() override;
+    size_t audioRecordInto(int16_t* data, size_t samples, float gain = 80.0f) override;
+    bool audioPlayBuffer(const int16_t* data, size_t samples, bool async = true, AudioDone_t done = nullptr,
+                         void* user = nullptr) override;
+    bool headPhoneDetect() override;
+
+    HostChain& hostChain()
+    {
+        return _chain;
+    }
+
+private:
+    static constexpr int AUDIO_BLOCK = 480;  // 10 ms, the engine's default block
+
+    void audio_init();
+    void audio_deinit();
+    static void capture_callback(void* user, uint8_t* stream, int len);
+    static void playback_callback(void* user, uint8_t* stream, int len);
+
+    std::recursive_mutex _lvgl_mutex;
+    std::mutex _wake_mutex;
+    std::condition_variable _wake_cv;
+    bool _wake_pending = false;
+    uint8_t _brightness = 100;
+
+    HostChain _chain;
+    uint32_t _capture_device  = 0;
+    uint32_t _playback_device = 0;
+    std::atomic<uint8_t> _speaker_volume{60};
+
+    // Capture callback → playback callback, interleaved stereo
+    struct MonitorRing;
+    MonitorRing* _monitor = nullptr;
+
+    // audioPlayBuffer() clips and audioRecordInto() captures, shared with the callbacks under _clip_mutex
+    std::mutex _clip_mutex;
+    std::condition_variable _clip_cv;
+    const int16_t* _clip   = nullptr;  // Interleaved stereo, the caller's
+    size_t _clip_size      = 0;
+    size_t _clip_pos       = 0;
+    AudioDone_t _clip_done = nullptr;
+    void* _clip_user       = nullptr;
+    int16_t* _record       = nullptr;  // [MIC-L, AEC, MIC-R, MIC-HP] frames being filled, the caller's
+    size_t _record_size    = 0;
+    size_t _record_pos     = 0;
+
+    void finish_clip(std::unique_lock<std::mutex>& lock);
+};
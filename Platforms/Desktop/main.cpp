@@ -0,0 +1,31 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "hal/hal_desktop.h"
+#include <app.h>
+#include <hal/hal.h>
+#include <memory>
+
+// Same pacing as the Tab5: LVGL timers are serviced while the loop waits
+static constexpr uint32_t MAIN_LOOP_IDLE_MS = 100;
+
+int main()
+{
+    // HAL injection callback
+    app::InitCallback_t callback;
+
+    callback.onHalInjection = []() {
+        hal::Inject(std::make_unique<HalDesktop>());
+    };
+
+    // Launch Howizard
+    app::Init(callback);
+    while (!app::IsDone()) {
+        app::Update();
+        GetHAL()->waitMainLoopWake(MAIN_LOOP_IDLE_MS);
+    }
+    app::Destroy();
+    return 0;
+}
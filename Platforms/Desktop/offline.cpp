@@ -0,0 +1,174 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+// Offline runs of the host chain: WAV in, a .hwz profile applied, WAV out, as fast as the host goes
+//
+//   ./build_desktop/howizard_offline [-p presets/mild_loss.hwz] in.wav out.wav [in2.wav out2.wav ...]
+//
+// Inputs are converted to 48kHz stereo float (SDL_AudioCVT), so any rate and channel count SDL
+// reads will do; outputs are 16-bit stereo. Each file starts from a fresh chain, processed in the
+// profile's blockSize blocks, and the wall time is reported against the audio's length.
+#include "hal/components/host_chain.h"
+#include "components/profile_schema.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <mooncake_log.h>
+#include <SDL2/SDL.h>
+
+static const char* TAG = "offline";
+
+struct Track {
+    std::vector<float> left;
+    std::vector<float> right;
+};
+
+static bool loadProfile(const char* path, AudioEngineParams& params)
+{
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        mclog::tagError(TAG, "failed to open profile {}", path);
+        return false;
+    }
+    char line[128];
+    while (fgets(line, sizeof(line), f)) {
+        const char* key = nullptr;
+        const char* val = nullptr;
+        if (!ProfileSchema::parseLine(line, params, &key, &val)) {
+            mclog::tagWarn(TAG, "{}: bad value for {}: '{}'", path, key, val);
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+static bool loadWav(const char* path, Track& track)
+{
+    SDL_AudioSpec spec{};
+    Uint8* buf = nullptr;
+    Uint32 len = 0;
+    if (!SDL_LoadWAV(path, &spec, &buf, &len)) {
+        mclog::tagError(TAG, "failed to read {}: {}", path, SDL_GetError());
+        return false;
+    }
+    SDL_AudioCVT cvt;
+    if (SDL_BuildAudioCVT(&cvt, spec.format, spec.channels, spec.freq, AUDIO_F32SYS, 2, HostChain::SAMPLE_RATE) < 0) {
+        mclog::tagError(TAG, "can't convert {}: {}", path, SDL_GetError());
+        SDL_FreeWAV(buf);
+        return false;
+    }
+    std::vector<Uint8> data(static_cast<size_t>(len) * std::max(cvt.len_mult, 1));
+    memcpy(data.data(), buf, len);
+    SDL_FreeWAV(buf);
+    cvt.buf = data.data();
+    cvt.len = static_cast<int>(len);
+    if (SDL_ConvertAudio(&cvt) < 0) {
+        mclog::tagError(TAG, "can't convert {}: {}", path, SDL_GetError());
+        return false;
+    }
+
+    const float* frames = reinterpret_cast<const float*>(data.data());
+    const size_t count = cvt.len_cvt / (2 * sizeof(float));
+    track.left.resize(count);
+    track.right.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        track.left[i] = frames[2 * i];
+        track.right[i] = frames[2 * i + 1];
+    }
+    mclog::tagInfo(TAG, "{}: {} Hz, {} ch, {:.2f} s", path, spec.freq, spec.channels,
+        static_cast<double>(count) / HostChain::SAMPLE_RATE);
+    return true;
+}
+
+static void putLe(FILE* f, uint32_t v, int bytes)
+{
+    for (int i = 0; i < bytes; i++) fputc((v >> (8 * i)) & 0xFF, f);
+}
+
+static bool writeWav(const char* path, const Track& track)
+{
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        mclog::tagError(TAG, "failed to open {} for writing", path);
+        return false;
+    }
+    const uint32_t dataBytes = static_cast<uint32_t>(track.left.size() * 2 * sizeof(int16_t));
+    fwrite("RIFF", 1, 4, f);
+    putLe(f, 36 + dataBytes, 4);
+    fwrite("WAVEfmt ", 1, 8, f);
+    putLe(f, 16, 4);
+    putLe(f, 1, 2);  // PCM
+    putLe(f, 2, 2);
+    putLe(f, HostChain::SAMPLE_RATE, 4);
+    putLe(f, HostChain::SAMPLE_RATE * 2 * sizeof(int16_t), 4);
+    putLe(f, 2 * sizeof(int16_t), 2);
+    putLe(f, 16, 2);
+    fwrite("data", 1, 4, f);
+    putLe(f, dataBytes, 4);
+
+    std::vector<int16_t> pcm(track.left.size() * 2);
+    for (size_t i = 0; i < track.left.size(); i++) {
+        pcm[2 * i] = static_cast<int16_t>(lrintf(std::clamp(track.left[i], -1.0f, 1.0f) * 32767.0f));
+        pcm[2 * i + 1] = static_cast<int16_t>(lrintf(std::clamp(track.right[i], -1.0f, 1.0f) * 32767.0f));
+    }
+    // RIFF is little-endian, like every host this builds on
+    const bool ok = fwrite(pcm.data(), sizeof(int16_t), pcm.size(), f) == pcm.size();
+    if (fclose(f) != 0 || !ok) {
+        mclog::tagError(TAG, "failed to write {}", path);
+        return false;
+    }
+    return true;
+}
+
+static bool processFile(const char* in, const char* out, const AudioEngineParams& params)
+{
+    Track track;
+    if (!loadWav(in, track)) return false;
+
+    auto chain = std::make_unique<HostChain>();
+    chain->applyProfile(params);
+    const int block = std::clamp(params.blockSize, 1, HostChain::MAX_FRAMES);
+    const size_t frames = track.left.size();
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t done = 0; done < frames; done += block) {
+        const int n = static_cast<int>(std::min<size_t>(block, frames - done));
+        chain->process(track.left.data() + done, track.right.data() + done, n);
+    }
+    const double wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const double audioS = static_cast<double>(frames) / HostChain::SAMPLE_RATE;
+    mclog::tagInfo(TAG, "{}: {:.2f} s of audio in {:.1f} ms, {:.0f}x real time", in, audioS, wallS * 1e3,
+        wallS > 0.0 ? audioS / wallS : 0.0);
+    return writeWav(out, track);
+}
+
+int main(int argc, char** argv)
+{
+    AudioEngineParams params;
+    int arg = 1;
+    if (arg + 1 < argc && strcmp(argv[arg], "-p") == 0) {
+        if (!loadProfile(argv[arg + 1], params)) return 1;
+        const auto onOff = [](bool on) { return on ? "on" : "off"; };
+        mclog::tagInfo(TAG, "profile {}: block {}, ears {}, wdrc {}, mbc {}, limiter {}, output gain {:.2f}",
+            argv[arg + 1], params.blockSize, params.earsLinked ? "linked" : "split", onOff(params.fitting.wdrcEnabled),
+            onOff(params.dynamics.mbcEnabled), onOff(params.dynamics.limiterEnabled), params.outputGain);
+        arg += 2;
+    }
+    if (arg >= argc || (argc - arg) % 2 != 0) {
+        fprintf(stderr, "usage: %s [-p profile.hwz] in.wav out.wav [in.wav out.wav ...]\n", argv[0]);
+        return 2;
+    }
+
+    int failed = 0;
+    for (; arg < argc; arg += 2) {
+        if (!processFile(argv[arg], argv[arg + 1], params)) failed++;
+    }
+    return failed ? 1 : 0;
+}
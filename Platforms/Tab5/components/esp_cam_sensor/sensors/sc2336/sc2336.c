@@ -1350,12 +1350,30 @@ static esp_err_t sc2336_write_array(esp_sccb_io_handle_t sccb_handle, sc2336_reg
     int i         = 0;
     esp_err_t ret = ESP_OK;
     while ((ret == ESP_OK) && regarray[i].reg != SC2336_REG_END) {
-        if (regarray[i].reg != SC2336_REG_DELAY) {
-            ret = sc2336_write(sccb_handle, regarray[i].reg, regarray[i].val);
-        } else {
+        if (regarray[i].reg == SC2336_REG_DELAY) {
             delay_ms(regarray[i].val);
+            i++;
+            continue;
+        }
+#if CONFIG_CAMERA_SC2336_SCCB_BURST
+        /* The sensor auto-increments the address, so a run of consecutive registers goes out as one transaction */
+        uint8_t vals[ESP_SCCB_BURST_MAX];
+        int n = 0;
+        do {
+            vals[n] = regarray[i + n].val;
+            n++;
+        } while (n < ESP_SCCB_BURST_MAX && regarray[i + n].reg < SC2336_REG_DELAY &&
+                 regarray[i + n].reg == regarray[i].reg + n);
+        if (n > 1) {
+            ret = esp_sccb_transmit_burst_a16v8(sccb_handle, regarray[i].reg, vals, n);
+        } else {
+            ret = sc2336_write(sccb_handle, regarray[i].reg, regarray[i].val);
         }
+        i += n;
+#else
+        ret = sc2336_write(sccb_handle, regarray[i].reg, regarray[i].val);
         i++;
+#endif
     }
     return ret;
 }
@@ -8,6 +8,8 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include "sdkconfig.h"
 #include "esp_err.h"
 #include "esp_sccb_types.h"
 
@@ -63,6 +65,46 @@ esp_err_t esp_sccb_transmit_reg_a8v16(esp_sccb_io_handle_t io_handle, uint8_t re
  */
 esp_err_t esp_sccb_transmit_reg_a16v16(esp_sccb_io_handle_t io_handle, uint16_t reg_addr, uint16_t reg_val);
 
+/**
+ * @brief Most register values one burst write carries
+ */
+#define ESP_SCCB_BURST_MAX CONFIG_ESP_SCCB_BURST_MAX
+
+/**
+ * @brief Perform one sequential write for 8-bit reg_addr and 8-bit reg_val: reg_vals[i] goes to reg_addr + i.
+ *
+ * One bus transaction (start, address, reg_addr, the values, stop) instead of count; only for sensors
+ * whose SCCB slave auto-increments the register address on writes.
+ *
+ * @param[in] handle SCCB IO handle
+ * @param[in] reg_addr First register address.
+ * @param[in] reg_vals Values for reg_addr, reg_addr + 1, ...
+ * @param[in] count    Number of values, 1 to ESP_SCCB_BURST_MAX.
+ * @return
+ *      - ESP_OK: sccb transmit success
+ *      - ESP_ERR_INVALID_ARG: sccb transmit parameter invalid.
+ *      - ESP_ERR_INVALID_SIZE: count is 0 or more than ESP_SCCB_BURST_MAX.
+ */
+esp_err_t esp_sccb_transmit_burst_a8v8(esp_sccb_io_handle_t io_handle, uint8_t reg_addr, const uint8_t *reg_vals,
+                                       size_t count);
+
+/**
+ * @brief Perform one sequential write for 16-bit reg_addr and 8-bit reg_val: reg_vals[i] goes to reg_addr + i.
+ *
+ * See esp_sccb_transmit_burst_a8v8().
+ *
+ * @param[in] handle SCCB IO handle
+ * @param[in] reg_addr First register address.
+ * @param[in] reg_vals Values for reg_addr, reg_addr + 1, ...
+ * @param[in] count    Number of values, 1 to ESP_SCCB_BURST_MAX.
+ * @return
+ *      - ESP_OK: sccb transmit success
+ *      - ESP_ERR_INVALID_ARG: sccb transmit parameter invalid.
+ *      - ESP_ERR_INVALID_SIZE: count is 0 or more than ESP_SCCB_BURST_MAX.
+ */
+esp_err_t esp_sccb_transmit_burst_a16v8(esp_sccb_io_handle_t io_handle, uint16_t reg_addr, const uint8_t *reg_vals,
+                                        size_t count);
+
 /**
  * @brief Perform a write-read transaction for 8-bit reg_addr and 8-bit reg_val.
  *
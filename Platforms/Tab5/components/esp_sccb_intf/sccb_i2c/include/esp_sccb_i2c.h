@@ -18,6 +18,15 @@ typedef struct {
     uint32_t val_bits_width;             ///< Reg val bit-width
 } sccb_i2c_config_t;
 
+/**
+ * @brief Bus lock taken around every SCCB transaction, for buses shared with other drivers
+ */
+typedef struct {
+    esp_err_t (*lock)(void *ctx, int timeout_ms);  ///< Take the bus; timeout_ms is the transfer timeout (-1: forever)
+    void (*unlock)(void *ctx);                     ///< Give the bus back
+    void *ctx;                                     ///< Passed to both callbacks
+} sccb_i2c_bus_lock_t;
+
 /**
  * @brief New I2C IO handle
  *
@@ -31,3 +40,10 @@ typedef struct {
  */
 esp_err_t sccb_new_i2c_io(i2c_master_bus_handle_t bus_handle, const sccb_i2c_config_t *config,
                           esp_sccb_io_handle_t *io_handle);
+
+/**
+ * @brief Set the bus lock used by all SCCB I2C IO handles
+ *
+ * @param[in]  lock  ///< Bus lock callbacks, copied; NULL to go without
+ */
+void sccb_i2c_set_bus_lock(const sccb_i2c_bus_lock_t *lock);
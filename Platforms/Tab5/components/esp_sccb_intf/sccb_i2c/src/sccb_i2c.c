@@ -44,6 +44,43 @@ static esp_err_t s_sccb_i2c_transmit_receive_reg_a16v16(esp_sccb_io_t *io_handle
                                                         int xfer_timeout_ms);
 static esp_err_t s_sccb_i2c_destroy(esp_sccb_io_t *io_handle);
 
+static sccb_i2c_bus_lock_t s_bus_lock;
+
+void sccb_i2c_set_bus_lock(const sccb_i2c_bus_lock_t *lock)
+{
+    if (lock) {
+        s_bus_lock = *lock;
+    } else {
+        memset(&s_bus_lock, 0, sizeof(s_bus_lock));
+    }
+}
+
+static esp_err_t s_sccb_i2c_tx(i2c_master_dev_handle_t dev, const uint8_t *write_buffer, size_t write_size,
+                               int xfer_timeout_ms)
+{
+    if (s_bus_lock.lock) {
+        ESP_RETURN_ON_ERROR(s_bus_lock.lock(s_bus_lock.ctx, xfer_timeout_ms), TAG, "failed to lock bus");
+    }
+    esp_err_t ret = i2c_master_transmit(dev, write_buffer, write_size, xfer_timeout_ms);
+    if (s_bus_lock.unlock) {
+        s_bus_lock.unlock(s_bus_lock.ctx);
+    }
+    return ret;
+}
+
+static esp_err_t s_sccb_i2c_txrx(i2c_master_dev_handle_t dev, const uint8_t *write_buffer, size_t write_size,
+                                 uint8_t *read_buffer, size_t read_size, int xfer_timeout_ms)
+{
+    if (s_bus_lock.lock) {
+        ESP_RETURN_ON_ERROR(s_bus_lock.lock(s_bus_lock.ctx, xfer_timeout_ms), TAG, "failed to lock bus");
+    }
+    esp_err_t ret = i2c_master_transmit_receive(dev, write_buffer, write_size, read_buffer, read_size, xfer_timeout_ms);
+    if (s_bus_lock.unlock) {
+        s_bus_lock.unlock(s_bus_lock.ctx);
+    }
+    return ret;
+}
+
 esp_err_t sccb_new_i2c_io(i2c_master_bus_handle_t bus_handle, const sccb_i2c_config_t *config,
                           esp_sccb_io_handle_t *io_handle)
 {
@@ -83,7 +120,7 @@ static esp_err_t s_sccb_i2c_transmit_reg_a8v8(esp_sccb_io_t *io_handle, const ui
                                               int xfer_timeout_ms)
 {
     sccb_io_i2c_t *io_i2c = __containerof(io_handle, sccb_io_i2c_t, base);
-    ESP_RETURN_ON_ERROR(i2c_master_transmit(io_i2c->i2c_device, write_buffer, write_size, xfer_timeout_ms), TAG,
+    ESP_RETURN_ON_ERROR(s_sccb_i2c_tx(io_i2c->i2c_device, write_buffer, write_size, xfer_timeout_ms), TAG,
                         "failed to i2c transmit");
 
     return ESP_OK;
@@ -93,7 +130,7 @@ static esp_err_t s_sccb_i2c_transmit_reg_a16v8(esp_sccb_io_t *io_handle, const u
                                                int xfer_timeout_ms)
 {
     sccb_io_i2c_t *io_i2c = __containerof(io_handle, sccb_io_i2c_t, base);
-    ESP_RETURN_ON_ERROR(i2c_master_transmit(io_i2c->i2c_device, write_buffer, write_size, xfer_timeout_ms), TAG,
+    ESP_RETURN_ON_ERROR(s_sccb_i2c_tx(io_i2c->i2c_device, write_buffer, write_size, xfer_timeout_ms), TAG,
                         "failed to i2c transmit");
 
     return ESP_OK;
@@ -103,7 +140,7 @@ static esp_err_t s_sccb_i2c_transmit_reg_a8v16(esp_sccb_io_t *io_handle, const u
                                                int xfer_timeout_ms)
 {
     sccb_io_i2c_t *io_i2c = __containerof(io_handle, sccb_io_i2c_t, base);
-    ESP_RETURN_ON_ERROR(i2c_master_transmit(io_i2c->i2c_device, write_buffer, write_size, xfer_timeout_ms), TAG,
+    ESP_RETURN_ON_ERROR(s_sccb_i2c_tx(io_i2c->i2c_device, write_buffer, write_size, xfer_timeout_ms), TAG,
                         "failed to i2c transmit");
 
     return ESP_OK;
@@ -113,7 +150,7 @@ static esp_err_t s_sccb_i2c_transmit_reg_a16v16(esp_sccb_io_t *io_handle, const
                                                 size_t write_size, int xfer_timeout_ms)
 {
     sccb_io_i2c_t *io_i2c = __containerof(io_handle, sccb_io_i2c_t, base);
-    ESP_RETURN_ON_ERROR(i2c_master_transmit(io_i2c->i2c_device, write_buffer, write_size, xfer_timeout_ms), TAG,
+    ESP_RETURN_ON_ERROR(s_sccb_i2c_tx(io_i2c->i2c_device, write_buffer, write_size, xfer_timeout_ms), TAG,
                         "failed to i2c transmit");
 
     return ESP_OK;
@@ -124,8 +161,8 @@ static esp_err_t s_sccb_i2c_transmit_receive_reg_a8v8(esp_sccb_io_t *io_handle,
                                                       int xfer_timeout_ms)
 {
     sccb_io_i2c_t *io_i2c = __containerof(io_handle, sccb_io_i2c_t, base);
-    ESP_RETURN_ON_ERROR(i2c_master_transmit_receive(io_i2c->i2c_device, write_buffer, write_size, read_buffer,
-                                                    read_size, xfer_timeout_ms),
+    ESP_RETURN_ON_ERROR(s_sccb_i2c_txrx(io_i2c->i2c_device, write_buffer, write_size, read_buffer, read_size,
+                                        xfer_timeout_ms),
                         TAG, "faled to transmit receive");
 
     return ESP_OK;
@@ -136,8 +173,8 @@ static esp_err_t s_sccb_i2c_transmit_receive_reg_a16v8(esp_sccb_io_t *io_handle,
                                                        int xfer_timeout_ms)
 {
     sccb_io_i2c_t *io_i2c = __containerof(io_handle, sccb_io_i2c_t, base);
-    ESP_RETURN_ON_ERROR(i2c_master_transmit_receive(io_i2c->i2c_device, write_buffer, write_size, read_buffer,
-                                                    read_size, xfer_timeout_ms),
+    ESP_RETURN_ON_ERROR(s_sccb_i2c_txrx(io_i2c->i2c_device, write_buffer, write_size, read_buffer, read_size,
+                                        xfer_timeout_ms),
                         TAG, "faled to transmit receive");
 
     return ESP_OK;
@@ -148,8 +185,8 @@ static esp_err_t s_sccb_i2c_transmit_receive_reg_a8v16(esp_sccb_io_t *io_handle,
                                                        int xfer_timeout_ms)
 {
     sccb_io_i2c_t *io_i2c = __containerof(io_handle, sccb_io_i2c_t, base);
-    ESP_RETURN_ON_ERROR(i2c_master_transmit_receive(io_i2c->i2c_device, write_buffer, write_size, read_buffer,
-                                                    read_size, xfer_timeout_ms),
+    ESP_RETURN_ON_ERROR(s_sccb_i2c_txrx(io_i2c->i2c_device, write_buffer, write_size, read_buffer, read_size,
+                                        xfer_timeout_ms),
                         TAG, "faled to transmit receive");
 
     return ESP_OK;
@@ -160,8 +197,8 @@ static esp_err_t s_sccb_i2c_transmit_receive_reg_a16v16(esp_sccb_io_t *io_handle
                                                         int xfer_timeout_ms)
 {
     sccb_io_i2c_t *io_i2c = __containerof(io_handle, sccb_io_i2c_t, base);
-    ESP_RETURN_ON_ERROR(i2c_master_transmit_receive(io_i2c->i2c_device, write_buffer, write_size, read_buffer,
-                                                    read_size, xfer_timeout_ms),
+    ESP_RETURN_ON_ERROR(s_sccb_i2c_txrx(io_i2c->i2c_device, write_buffer, write_size, read_buffer, read_size,
+                                        xfer_timeout_ms),
                         TAG, "faled to transmit receive");
 
     return ESP_OK;
@@ -45,6 +45,38 @@ esp_err_t esp_sccb_transmit_reg_a16v8(esp_sccb_io_handle_t io_handle, uint16_t r
     return io_handle->transmit_reg_a16v8(io_handle, data, 3, ESP_SCCB_TRANS_DEALY);
 }
 
+esp_err_t esp_sccb_transmit_burst_a8v8(esp_sccb_io_handle_t io_handle, uint8_t reg_addr, const uint8_t *reg_vals,
+                                       size_t count)
+{
+    ESP_RETURN_ON_FALSE(io_handle && reg_vals, ESP_ERR_INVALID_ARG, TAG, "invalid argument: null pointer");
+    ESP_RETURN_ON_FALSE(count > 0 && count <= ESP_SCCB_BURST_MAX, ESP_ERR_INVALID_SIZE, TAG, "invalid burst size");
+    ESP_RETURN_ON_FALSE(io_handle->transmit_reg_a8v8, ESP_ERR_NOT_SUPPORTED, TAG,
+                        "controller driver function not supported");
+
+    /* The write ops ship the buffer as is: the address, then every value */
+    uint8_t data[1 + ESP_SCCB_BURST_MAX];
+    data[0] = reg_addr;
+    memcpy(&data[1], reg_vals, count);
+
+    return io_handle->transmit_reg_a8v8(io_handle, data, 1 + count, ESP_SCCB_TRANS_DEALY);
+}
+
+esp_err_t esp_sccb_transmit_burst_a16v8(esp_sccb_io_handle_t io_handle, uint16_t reg_addr, const uint8_t *reg_vals,
+                                        size_t count)
+{
+    ESP_RETURN_ON_FALSE(io_handle && reg_vals, ESP_ERR_INVALID_ARG, TAG, "invalid argument: null pointer");
+    ESP_RETURN_ON_FALSE(count > 0 && count <= ESP_SCCB_BURST_MAX, ESP_ERR_INVALID_SIZE, TAG, "invalid burst size");
+    ESP_RETURN_ON_FALSE(io_handle->transmit_reg_a16v8, ESP_ERR_NOT_SUPPORTED, TAG,
+                        "controller driver function not supported");
+
+    uint8_t data[2 + ESP_SCCB_BURST_MAX];
+    data[0] = (reg_addr & 0xff00) >> 8;
+    data[1] = reg_addr & 0xff;
+    memcpy(&data[2], reg_vals, count);
+
+    return io_handle->transmit_reg_a16v8(io_handle, data, 2 + count, ESP_SCCB_TRANS_DEALY);
+}
+
 esp_err_t esp_sccb_transmit_reg_a8v16(esp_sccb_io_handle_t io_handle, uint8_t reg_addr, uint16_t reg_val)
 {
     esp_err_t ret = ESP_FAIL;
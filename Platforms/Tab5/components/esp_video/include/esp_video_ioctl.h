@@ -15,6 +15,18 @@ extern "C" {
 
 #define VIDIOC_S_SENSOR_FMT _IOWR('V', BASE_VIDIOC_PRIVATE + 1, esp_cam_sensor_format_t)
 #define VIDIOC_G_SENSOR_FMT _IOWR('V', BASE_VIDIOC_PRIVATE + 2, esp_cam_sensor_format_t)
+#define VIDIOC_ENUM_SENSOR_FMT _IOWR('V', BASE_VIDIOC_PRIVATE + 3, struct esp_video_sensor_fmtdesc)
+
+/**
+ * @brief Sensor format enumeration, for VIDIOC_ENUM_SENSOR_FMT
+ *
+ * @note The returned entry is the sensor driver's own table, so it can be
+ *       passed to VIDIOC_S_SENSOR_FMT as is and outlives the call.
+ */
+struct esp_video_sensor_fmtdesc {
+    uint32_t index;                        /*!< Format number, set by the application */
+    const esp_cam_sensor_format_t *format; /*!< Format table entry, set by the driver */
+};
 
 #ifdef __cplusplus
 }
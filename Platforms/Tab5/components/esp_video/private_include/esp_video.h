@@ -556,6 +556,20 @@ esp_err_t esp_video_set_sensor_format(struct esp_video *video, const esp_cam_sen
  */
 esp_err_t esp_video_get_sensor_format(struct esp_video *video, esp_cam_sensor_format_t *format);
 
+/**
+ * @brief Enumerate the formats the sensor supports
+ *
+ * @param video  Video object
+ * @param index  Format number
+ * @param format Set to the sensor's format table entry
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if index is past the last format
+ *      - Others if failed
+ */
+esp_err_t esp_video_enum_sensor_format(struct esp_video *video, uint32_t index, const esp_cam_sensor_format_t **format);
+
 /**
  * @brief Query menu value
  *
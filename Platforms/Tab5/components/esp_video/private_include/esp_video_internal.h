@@ -270,6 +270,10 @@ struct esp_video_ops {
 
     esp_err_t (*get_sensor_format)(struct esp_video *video, esp_cam_sensor_format_t *format);
 
+    /*!< Enumerate the formats the sensor supports */
+
+    esp_err_t (*enum_sensor_format)(struct esp_video *video, uint32_t index, const esp_cam_sensor_format_t **format);
+
     /*!< Query menu value */
 
     esp_err_t (*query_menu)(struct esp_video *video, struct v4l2_querymenu *qmenu);
@@ -486,6 +486,21 @@ static esp_err_t csi_video_get_sensor_format(struct esp_video *video, esp_cam_se
     return esp_cam_sensor_get_format(csi_video->cam_dev, format);
 }
 
+static esp_err_t csi_video_enum_sensor_format(struct esp_video *video, uint32_t index,
+                                              const esp_cam_sensor_format_t **format)
+{
+    esp_cam_sensor_format_array_t formats;
+    struct csi_video *csi_video = VIDEO_PRIV_DATA(struct csi_video *, video);
+
+    ESP_RETURN_ON_ERROR(esp_cam_sensor_query_format(csi_video->cam_dev, &formats), TAG, "failed to query formats");
+    if (index >= formats.count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *format = &formats.format_array[index];
+
+    return ESP_OK;
+}
+
 static esp_err_t csi_video_query_menu(struct esp_video *video, struct v4l2_querymenu *qmenu)
 {
     struct csi_video *csi_video = VIDEO_PRIV_DATA(struct csi_video *, video);
@@ -494,19 +509,20 @@ static esp_err_t csi_video_query_menu(struct esp_video *video, struct v4l2_query
 }
 
 static const struct esp_video_ops s_csi_video_ops = {
-    .init              = csi_video_init,
-    .deinit            = csi_video_deinit,
-    .start             = csi_video_start,
-    .stop              = csi_video_stop,
-    .enum_format       = csi_video_enum_format,
-    .set_format        = csi_video_set_format,
-    .notify            = csi_video_notify,
-    .set_ext_ctrl      = csi_video_set_ext_ctrl,
-    .get_ext_ctrl      = csi_video_get_ext_ctrl,
-    .query_ext_ctrl    = csi_video_query_ext_ctrl,
-    .set_sensor_format = csi_video_set_sensor_format,
-    .get_sensor_format = csi_video_get_sensor_format,
-    .query_menu        = csi_video_query_menu,
+    .init               = csi_video_init,
+    .deinit             = csi_video_deinit,
+    .start              = csi_video_start,
+    .stop               = csi_video_stop,
+    .enum_format        = csi_video_enum_format,
+    .set_format         = csi_video_set_format,
+    .notify             = csi_video_notify,
+    .set_ext_ctrl       = csi_video_set_ext_ctrl,
+    .get_ext_ctrl       = csi_video_get_ext_ctrl,
+    .query_ext_ctrl     = csi_video_query_ext_ctrl,
+    .set_sensor_format  = csi_video_set_sensor_format,
+    .get_sensor_format  = csi_video_get_sensor_format,
+    .enum_sensor_format = csi_video_enum_sensor_format,
+    .query_menu         = csi_video_query_menu,
 };
 
 /**
@@ -56,8 +56,8 @@
 #define ARRAY_SIZE(x) sizeof(x) / sizeof((x)[0])
 #endif
 
-#define ISP_REGION_START (0.2)
-#define ISP_REGION_END   (0.8)
+#define ISP_REGION_START (CONFIG_ESP_VIDEO_ISP_STATS_REGION_START / 100.0)
+#define ISP_REGION_END   (CONFIG_ESP_VIDEO_ISP_STATS_REGION_END / 100.0)
 
 #define ISP_RGB_RG_L 0.5040
 #define ISP_RGB_RG_H 0.8899
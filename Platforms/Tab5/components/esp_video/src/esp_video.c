@@ -1610,6 +1610,38 @@ esp_err_t esp_video_get_sensor_format(struct esp_video *video, esp_cam_sensor_fo
     return ESP_OK;
 }
 
+/**
+ * @brief Enumerate the formats the sensor supports
+ *
+ * @param video  Video object
+ * @param index  Format number
+ * @param format Set to the sensor's format table entry
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if index is past the last format
+ *      - Others if failed
+ */
+esp_err_t esp_video_enum_sensor_format(struct esp_video *video, uint32_t index, const esp_cam_sensor_format_t **format)
+{
+    esp_err_t ret;
+
+    CHECK_VIDEO_OBJ(video);
+
+    if (video->ops->enum_sensor_format) {
+        ret = video->ops->enum_sensor_format(video, index, format);
+        if (ret != ESP_OK) {
+            ESP_LOGD(TAG, "video->ops->enum_sensor_format=%x", ret);
+            return ret;
+        }
+    } else {
+        ESP_LOGD(TAG, "video->ops->enum_sensor_format=NULL");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    return ESP_OK;
+}
+
 /**
  * @brief Query menu value
  *
@@ -30,6 +30,12 @@
 #define ISP_TASK_PRIORITY         11
 #define ISP_TASK_STACK_SIZE       4096
 
+#define IPA_INTERVAL          CONFIG_ESP_VIDEO_ISP_PIPELINE_IPA_INTERVAL
+#define IPA_STABLE_INTERVAL   MAX(CONFIG_ESP_VIDEO_ISP_PIPELINE_STABLE_INTERVAL, IPA_INTERVAL)
+#define IPA_STABLE_RUNS       CONFIG_ESP_VIDEO_ISP_PIPELINE_STABLE_RUNS
+#define IPA_WAKE_LUMA_PERCENT CONFIG_ESP_VIDEO_ISP_PIPELINE_WAKE_LUMA_PERCENT
+#define IPA_WB_GAIN_EPSILON   0.005
+
 #define UNUSED(x) (void)(x)
 
 typedef struct esp_video_isp {
@@ -40,6 +46,16 @@ typedef struct esp_video_isp {
 
     esp_ipa_pipeline_handle_t ipa_pipeline;
     esp_ipa_sensor_t sensor;
+
+    /* IPA rate control */
+
+    uint32_t frames;        /*!< Statistics sets received since the last IPA run */
+    uint32_t interval;      /*!< Current IPA interval in frames */
+    uint32_t stable_runs;   /*!< Consecutive IPA runs that changed nothing */
+    uint32_t ref_luma;      /*!< Mean AE luminance when the output settled */
+    float gain;             /*!< Last pixel gain requested (the sensor rounds it to a step) */
+    float red_gain;         /*!< Last white balance written */
+    float blue_gain;
 } esp_video_isp_t;
 
 static const char *TAG = "ISP";
@@ -483,6 +499,16 @@ static void config_color(esp_video_isp_t *isp, esp_ipa_metadata_t *metadata)
 
 static void config_isp_and_camera(esp_video_isp_t *isp, esp_ipa_metadata_t *metadata)
 {
+    if (metadata->flags & IPA_METADATA_FLAGS_GN) {
+        isp->gain = metadata->gain;
+    }
+    if (metadata->flags & IPA_METADATA_FLAGS_RG) {
+        isp->red_gain = metadata->red_gain;
+    }
+    if (metadata->flags & IPA_METADATA_FLAGS_BG) {
+        isp->blue_gain = metadata->blue_gain;
+    }
+
     config_white_balance(isp, metadata);
     config_exposure_time(isp, metadata);
     config_pixel_gain(isp, metadata);
@@ -541,9 +567,88 @@ static void isp_stats_to_ipa_stats(esp_video_isp_stats_t *isp_stat, esp_ipa_stat
     }
 }
 
+/**
+ * @brief Mean luminance of the AE blocks, or 0 if the set carries no AE statistics
+ */
+static uint32_t ipa_stats_mean_luma(const esp_ipa_stats_t *ipa_stats)
+{
+    uint32_t sum = 0;
+
+    if (!(ipa_stats->flags & IPA_STATS_FLAGS_AE)) {
+        return 0;
+    }
+
+    for (int i = 0; i < ISP_AE_BLOCK_X_NUM * ISP_AE_BLOCK_Y_NUM; i++) {
+        sum += ipa_stats->ae_stats[i].luminance;
+    }
+
+    return sum / (ISP_AE_BLOCK_X_NUM * ISP_AE_BLOCK_Y_NUM);
+}
+
+/**
+ * @brief Check whether the scene moved away from the one the IPA output settled on
+ */
+static bool ipa_scene_changed(esp_video_isp_t *isp, uint32_t luma)
+{
+    uint32_t delta;
+
+    if (isp->interval == IPA_INTERVAL || !luma || !isp->ref_luma) {
+        return false;
+    }
+
+    delta = luma > isp->ref_luma ? luma - isp->ref_luma : isp->ref_luma - luma;
+    return delta * 100 > isp->ref_luma * IPA_WAKE_LUMA_PERCENT;
+}
+
+/**
+ * @brief Check whether IPA output would change exposure, gain or white balance
+ */
+static bool ipa_metadata_changes(esp_video_isp_t *isp, const esp_ipa_metadata_t *metadata)
+{
+    if ((metadata->flags & IPA_METADATA_FLAGS_ET) && metadata->exposure != isp->sensor.cur_exposure) {
+        return true;
+    }
+
+    if ((metadata->flags & IPA_METADATA_FLAGS_GN) && fabsf(metadata->gain - isp->gain) > 0.01f) {
+        return true;
+    }
+
+    if ((metadata->flags & IPA_METADATA_FLAGS_RG) && fabsf(metadata->red_gain - isp->red_gain) > IPA_WB_GAIN_EPSILON) {
+        return true;
+    }
+
+    if ((metadata->flags & IPA_METADATA_FLAGS_BG) &&
+        fabsf(metadata->blue_gain - isp->blue_gain) > IPA_WB_GAIN_EPSILON) {
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Update the IPA interval after a run: back to the base rate while AE/AWB move,
+ *        slower once they have settled
+ */
+static void ipa_update_interval(esp_video_isp_t *isp, bool changed, uint32_t luma)
+{
+    if (changed) {
+        isp->stable_runs = 0;
+        if (isp->interval != IPA_INTERVAL) {
+            ESP_LOGD(TAG, "IPA back to every %d frames", IPA_INTERVAL);
+        }
+        isp->interval = IPA_INTERVAL;
+    } else if (isp->stable_runs < IPA_STABLE_RUNS && ++isp->stable_runs == IPA_STABLE_RUNS) {
+        isp->interval = IPA_STABLE_INTERVAL;
+        isp->ref_luma = luma;
+        ESP_LOGD(TAG, "AE/AWB converged, IPA every %d frames", IPA_STABLE_INTERVAL);
+    }
+}
+
 static void isp_task(void *p)
 {
     esp_err_t ret;
+    bool changed;
+    uint32_t luma;
     struct v4l2_buffer buf;
     esp_ipa_stats_t ipa_stats;
     esp_ipa_metadata_t metadata;
@@ -562,6 +667,16 @@ static void isp_task(void *p)
         if (ioctl(isp->isp_fd, VIDIOC_QBUF, &buf) != 0) {
             ESP_LOGE(TAG, "failed to queue video frame");
         }
+
+        /* Statistics are collected every frame; the algorithms only run every interval frames */
+        luma = ipa_stats_mean_luma(&ipa_stats);
+        if (++isp->frames < isp->interval) {
+            if (!ipa_scene_changed(isp, luma)) {
+                continue;
+            }
+            ipa_update_interval(isp, true, luma);
+        }
+        isp->frames = 0;
         print_stats_info(&ipa_stats);
 
         metadata.flags = 0;
@@ -571,7 +686,9 @@ static void isp_task(void *p)
             continue;
         }
 
+        changed = ipa_metadata_changes(isp, &metadata);
         config_isp_and_camera(isp, &metadata);
+        ipa_update_interval(isp, changed, luma);
     }
 
     vTaskDelete(NULL);
@@ -740,8 +857,9 @@ esp_err_t esp_video_isp_pipeline_init(const esp_video_isp_config_t *config)
         return ESP_ERR_INVALID_ARG;
     }
 
-    isp = malloc(sizeof(esp_video_isp_t));
+    isp = calloc(1, sizeof(esp_video_isp_t));
     ESP_RETURN_ON_FALSE(isp, ESP_ERR_NO_MEM, TAG, "failed to malloc isp");
+    isp->interval = IPA_INTERVAL;
 
     ESP_GOTO_ON_ERROR(esp_ipa_pipeline_create(config->ipa_nums, config->ipa_names, &isp->ipa_pipeline), fail_0, TAG,
                       "failed to create IPA pipeline");
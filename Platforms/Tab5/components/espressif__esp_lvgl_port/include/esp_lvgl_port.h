@@ -18,6 +18,8 @@
 #include "esp_lvgl_port_knob.h"
 #include "esp_lvgl_port_button.h"
 #include "esp_lvgl_port_usbhid.h"
+#include "esp_lvgl_port_ppa_draw.h"
+#include "esp_lvgl_port_mem.h"
 
 #if LVGL_VERSION_MAJOR == 8
 #include "esp_lvgl_port_compatibility.h"
@@ -52,7 +54,11 @@ typedef struct {
     int task_stack;        /*!< LVGL task stack size */
     int task_affinity;     /*!< LVGL task pinned to core (-1 is no affinity) */
     int task_max_sleep_ms; /*!< Maximum sleep in LVGL task */
-    int timer_period_ms;   /*!< LVGL timer tick period in ms */
+    int timer_period_ms;   /*!< LVGL timer tick period in ms (0: LVGL reads esp_timer, no tick interrupt) */
+    int draw_assist_affinity; /*!< SW draw threads after the first pinned to core (-1 is no affinity) */
+    size_t mem_internal_size; /*!< LV_STDLIB_CUSTOM heap: internal RAM region in bytes (0: 64 KB) */
+    size_t mem_psram_size;    /*!< LV_STDLIB_CUSTOM heap: PSRAM region in bytes (0: none) */
+    size_t mem_large_size;    /*!< LV_STDLIB_CUSTOM heap: allocations from this size go to PSRAM first (0: 1 KB) */
 } lvgl_port_cfg_t;
 
 /**
@@ -62,6 +68,7 @@ typedef struct {
 #define ESP_LVGL_PORT_INIT_CONFIG()                                                                                  \
     {                                                                                                                \
         .task_priority = 4, .task_stack = 7168, .task_affinity = -1, .task_max_sleep_ms = 500, .timer_period_ms = 5, \
+        .draw_assist_affinity = -1,                                                                                   \
     }
 
 /**
@@ -117,6 +124,7 @@ void lvgl_port_flush_ready(lv_display_t *disp);
 /**
  * @brief Stop lvgl timer
  *
+ * The LVGL task stays blocked, with no periodic wakeups, until lvgl_port_resume().
  *
  * @return
  *      - ESP_OK on success
@@ -148,6 +156,23 @@ esp_err_t lvgl_port_resume(void);
  */
 esp_err_t lvgl_port_task_wake(lvgl_port_event_type_t event, void *param);
 
+/**
+ * @brief Let the SW draw threads after the first take draw tasks, or park them
+ *
+ * With LV_DRAW_SW_DRAW_UNIT_CNT > 1 on the port's OS layer (esp_lvgl_port_os.h) the extra draw threads run on
+ * lvgl_port_cfg_t::draw_assist_affinity. Parked, they stay blocked and that core is left to other work.
+ * Enabled at start.
+ *
+ * @note Takes the LVGL lock: parking waits for the frame being drawn
+ *
+ * @param enable    true to render on the assist threads too
+ * @return
+ *      - ESP_OK                    on success; when parking, the assist threads are idle on return
+ *      - ESP_ERR_NOT_SUPPORTED     if there is no such thread
+ *      - ESP_ERR_TIMEOUT           if the LVGL lock or a parking thread did not come back
+ */
+esp_err_t lvgl_port_draw_assist_enable(bool enable);
+
 #ifdef __cplusplus
 }
 #endif
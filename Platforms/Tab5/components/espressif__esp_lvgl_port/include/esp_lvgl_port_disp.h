@@ -87,6 +87,9 @@ typedef struct {
         unsigned int
             avoid_tearing : 1; /*!< 1: Use internal MIPI-DSI buffers as a LVGL draw buffers to avoid tearing effect,
                                   enabling this option requires over two LCD buffers and may reduce the frame rate */
+        unsigned int ppa_direct : 1; /*!< 1: With sw_rotate in partial render mode, the PPA rotates each flushed area
+                                        straight into the panel frame buffer and completes the flush from its ISR. No
+                                        rotation buffer is allocated and the draw buffers can be small */
     } flags;
 } lvgl_port_display_dsi_cfg_t;
 
@@ -137,6 +140,88 @@ lv_display_t *lvgl_port_add_disp_rgb(const lvgl_port_display_cfg_t *disp_cfg,
  */
 esp_err_t lvgl_port_remove_disp(lv_display_t *disp);
 
+#if LVGL_VERSION_MAJOR >= 9
+/**
+ * @brief Number of buckets in each frame-time histogram
+ *
+ * Time buckets are powers of two in milliseconds: bucket 0 holds < 1 ms, bucket i (1..6) holds [2^(i-1), 2^i) ms and
+ * the last bucket holds everything from 64 ms up. Dirty-area buckets are shares of the screen: the last bucket is a
+ * full-screen redraw, bucket i (1..6) holds [1/2^(7-i), 1/2^(6-i)) of the screen and bucket 0 anything below 1/64.
+ */
+#define LVGL_PORT_PERF_BUCKETS (8)
+
+/**
+ * @brief Timing histogram of one display pipeline stage
+ */
+typedef struct {
+    uint32_t count;                        /*!< Samples taken */
+    uint32_t max_us;                       /*!< Longest sample */
+    uint64_t total_us;                     /*!< Sum of all samples, for the average */
+    uint32_t hist[LVGL_PORT_PERF_BUCKETS]; /*!< Samples per time bucket */
+} lvgl_port_perf_hist_t;
+
+/**
+ * @brief Frame and flush statistics of the display pipeline
+ *
+ * Only refreshes that redraw something are counted. A frame runs from LVGL's refresh start to refresh ready.
+ */
+typedef struct {
+    lvgl_port_perf_hist_t frame;    /*!< Whole refresh, per frame */
+    lvgl_port_perf_hist_t render;   /*!< Frame time spent outside the flush callback (drawing, and waiting on a busy
+                                         buffer), per frame */
+    lvgl_port_perf_hist_t rotate;   /*!< SW/PPA rotation, per flushed area */
+    lvgl_port_perf_hist_t flush;    /*!< Panel draw call (or PPA direct rotation) to transfer done, per flushed area */
+    lvgl_port_perf_hist_t ppa_draw; /*!< PPA draw unit, dispatch to done, per draw task it took */
+    uint32_t dirty_hist[LVGL_PORT_PERF_BUCKETS]; /*!< Frames per dirty-area bucket */
+    uint64_t dirty_px_total;                     /*!< Redrawn pixels over all frames */
+    uint32_t dirty_px_max;                       /*!< Largest redraw in one frame */
+    uint32_t screen_px;                          /*!< Display size in pixels */
+} lvgl_port_perf_stats_t;
+
+/**
+ * @brief Copy the frame statistics gathered since the last reset
+ *
+ * @note Safe to call from any task; the figures of all displays are summed.
+ *
+ * @param stats Output statistics
+ */
+void lvgl_port_get_perf_stats(lvgl_port_perf_stats_t *stats);
+
+/**
+ * @brief Clear the frame statistics
+ */
+void lvgl_port_reset_perf_stats(void);
+
+/**
+ * @brief Refresh rate policy of a display
+ *
+ * The display is "active" while an input device is pressed and for `active_hold_ms` after, which covers scroll throws
+ * and the animations a tap starts. LVGL already pauses the refresh timer while nothing is invalidated.
+ */
+typedef struct {
+    uint32_t active_period_ms;    /*!< Refresh and `indev` read period while active (0: LV_DEF_REFR_PERIOD) */
+    uint32_t idle_period_ms;      /*!< Refresh period otherwise, e.g. the rate of the meters on screen
+                                       (0: LV_DEF_REFR_PERIOD) */
+    uint32_t active_hold_ms;      /*!< Time the display stays active after the last press */
+    lv_indev_t *indev;            /*!< Input device that wakes the LVGL task itself (lvgl_port_task_wake()), so it can
+                                       poll slowly while idle (NULL: none) */
+    uint32_t idle_read_period_ms; /*!< `indev` read period while idle (0: active_period_ms) */
+} lvgl_port_refresh_cfg_t;
+
+/**
+ * @brief Let the refresh rate of a display follow UI activity
+ *
+ * @note `indev` must stay until the policy is cleared or the display is removed
+ *
+ * @param disp  LVGL display handle (returned from lvgl_port_add_disp)
+ * @param cfg   refresh policy, NULL for the fixed LV_DEF_REFR_PERIOD
+ * @return
+ *      - ESP_OK                    on success
+ *      - ESP_ERR_INVALID_ARG       if disp is NULL or not added through this port
+ */
+esp_err_t lvgl_port_disp_set_refresh(lv_display_t *disp, const lvgl_port_refresh_cfg_t *cfg);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -30,9 +30,12 @@ extern "C" {
 #define LV_DRAW_SW_COLOR_BLEND_TO_RGB565(dsc) _lv_color_blend_to_rgb565_esp(dsc)
 #endif
 
+// No RGB888 fill for the esp32p4 yet, LVGL's C loop is used
+#if !CONFIG_IDF_TARGET_ESP32P4
 #ifndef LV_DRAW_SW_COLOR_BLEND_TO_RGB888
 #define LV_DRAW_SW_COLOR_BLEND_TO_RGB888(dsc, dest_px_size) _lv_color_blend_to_rgb888_esp(dsc, dest_px_size)
 #endif
+#endif
 
 #ifndef LV_DRAW_SW_RGB565_BLEND_NORMAL_TO_RGB565
 #define LV_DRAW_SW_RGB565_BLEND_NORMAL_TO_RGB565(dsc) _lv_rgb565_blend_normal_to_rgb565_esp(dsc)
@@ -42,6 +45,13 @@ extern "C" {
  *      TYPEDEFS
  **********************/
 
+// LVGL 9.2 dropped the leading underscore of the blend descriptor types; its blend
+// sources include this header after lv_draw_sw_blend_private.h, which 9.1 doesn't have
+#ifdef LV_DRAW_SW_BLEND_PRIVATE_H
+typedef lv_draw_sw_blend_fill_dsc_t _lv_draw_sw_blend_fill_dsc_t;
+typedef lv_draw_sw_blend_image_dsc_t _lv_draw_sw_blend_image_dsc_t;
+#endif
+
 typedef struct {
     uint32_t opa;
     void *dst_buf;
@@ -88,6 +98,7 @@ static inline lv_result_t _lv_color_blend_to_rgb565_esp(_lv_draw_sw_blend_fill_d
     return lv_color_blend_to_rgb565_esp(&asm_dsc);
 }
 
+#if !CONFIG_IDF_TARGET_ESP32P4
 extern int lv_color_blend_to_rgb888_esp(asm_dsc_t *asm_dsc);
 
 static inline lv_result_t _lv_color_blend_to_rgb888_esp(_lv_draw_sw_blend_fill_dsc_t *dsc, uint32_t dest_px_size)
@@ -105,6 +116,7 @@ static inline lv_result_t _lv_color_blend_to_rgb888_esp(_lv_draw_sw_blend_fill_d
 
     return lv_color_blend_to_rgb888_esp(&asm_dsc);
 }
+#endif
 
 extern int lv_rgb565_blend_normal_to_rgb565_esp(asm_dsc_t *asm_dsc);
 
@@ -0,0 +1,69 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief ESP LVGL port heap
+ *
+ * With CONFIG_LV_USE_CUSTOM_MALLOC the port provides lv_malloc() and friends on two dedicated regions taken from
+ * the system heap in lv_init(): small, frequently touched objects (widgets, styles, text) live in internal RAM,
+ * allocations of lvgl_port_cfg_t::mem_large_size or more (layers, images, caches) in PSRAM. A full region spills
+ * into the other one. lv_mem_monitor() reports both regions together.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "lvgl.h"
+
+#if LVGL_VERSION_MAJOR >= 9 && LV_USE_STDLIB_MALLOC == LV_STDLIB_CUSTOM
+#define ESP_LVGL_PORT_MEM 1
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef ESP_LVGL_PORT_MEM
+/**
+ * @brief Usage of one region of the LVGL heap
+ */
+typedef struct {
+    size_t total;         /*!< Region size less the allocator's overhead, 0 if the region doesn't exist */
+    size_t free;          /*!< Free bytes */
+    size_t min_free;      /*!< Low-water mark of `free` since lv_init() */
+    size_t largest_free;  /*!< Largest block that can be allocated */
+    uint32_t used_blocks; /*!< Live allocations */
+} lvgl_port_mem_region_stats_t;
+
+/**
+ * @brief Usage of the LVGL heap
+ */
+typedef struct {
+    lvgl_port_mem_region_stats_t internal;
+    lvgl_port_mem_region_stats_t psram;
+    uint32_t spilled; /*!< Allocations that went to the other region because theirs was full */
+} lvgl_port_mem_stats_t;
+
+/**
+ * @brief Get the usage of the LVGL heap
+ *
+ * @note Safe to call from any task, the LVGL lock isn't needed
+ *
+ * @param stats filled with the usage
+ * @return
+ *      - ESP_OK                    on success
+ *      - ESP_ERR_INVALID_ARG       if stats is NULL
+ *      - ESP_ERR_INVALID_STATE     before lv_init()
+ */
+esp_err_t lvgl_port_get_mem_stats(lvgl_port_mem_stats_t *stats);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,46 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief ESP LVGL port OS layer
+ *
+ * LVGL includes this header from lv_os.h with CONFIG_LV_OS_CUSTOM and CONFIG_LV_OS_CUSTOM_INCLUDE
+ * "esp_lvgl_port_os.h". It is LVGL's FreeRTOS layer, except that the SW draw threads are pinned: the first
+ * one to the LVGL task's core, the others to lvgl_port_cfg_t::draw_assist_affinity.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#define ESP_LVGL_PORT_OS 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    void (*callback)(void *);
+    void *user_data;
+    TaskHandle_t task;
+} lv_thread_t;
+
+typedef struct {
+    SemaphoreHandle_t mux; /* Created on first use, LVGL doesn't always call lv_mutex_init() */
+} lv_mutex_t;
+
+typedef struct {
+    TaskHandle_t waiter;   /* Task blocked in lv_thread_sync_wait(), NULL if none */
+    bool signaled;         /* Signal sent while nothing was waiting */
+} lv_thread_sync_t;
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,58 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief ESP LVGL port PPA draw unit
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "lvgl.h"
+#include "sdkconfig.h"
+
+#if CONFIG_IDF_TARGET_ESP32P4 && LVGL_VERSION_MAJOR >= 9
+#define ESP_LVGL_PORT_PPA_DRAW 1
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef ESP_LVGL_PORT_PPA_DRAW
+/**
+ * @brief Configuration of the PPA draw unit
+ */
+typedef struct {
+    uint32_t min_area_px; /*!< Draw tasks smaller than this stay on the CPU (0: 4096 px) */
+} lvgl_port_ppa_draw_cfg_t;
+
+/**
+ * @brief Add an LVGL draw unit that renders on the PPA
+ *
+ * Opaque rectangle fills, RGB565 image blits and alpha blends of untransformed images and layers go to the PPA's
+ * fill, SRM and blend engines; everything else, and anything below `min_area_px`, stays on the SW draw unit.
+ * The PPA owns the whole cache lines of the target rows, the unit draws the few pixels at either edge on the CPU.
+ *
+ * With LV_USE_OS the task completes from the PPA interrupt and LVGL keeps dispatching to the other units meanwhile;
+ * without it the LVGL task blocks on the transfer, leaving its core to other tasks.
+ *
+ * @note Call after lvgl_port_init(). Layer buffers need CONFIG_LV_DRAW_BUF_ALIGN of a cache line for the PPA path.
+ *
+ * @param cfg configuration, NULL for the defaults
+ * @return
+ *      - ESP_OK                    on success
+ *      - ESP_ERR_INVALID_STATE     if already added
+ *      - ESP_ERR_NO_MEM            if memory allocation fails
+ *      - Others                    PPA client registration errors
+ */
+esp_err_t lvgl_port_ppa_draw_init(const lvgl_port_ppa_draw_cfg_t *cfg);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -29,6 +29,7 @@ typedef enum {
  */
 typedef struct {
     unsigned int avoid_tearing : 1; /*!< Use internal RGB buffers as a LVGL draw buffers to avoid tearing effect */
+    unsigned int ppa_direct : 1;    /*!< PPA rotates flushed areas into the panel frame buffer (MIPI-DSI only) */
 } lvgl_port_disp_priv_cfg_t;
 
 /**
@@ -42,6 +43,51 @@ typedef struct {
  */
 bool lvgl_port_task_notify(uint32_t value);
 
+/**
+ * @brief Add one PPA draw task to the frame statistics
+ *
+ * @note Safe to call from the PPA interrupt
+ *
+ * @param us        dispatch to done
+ */
+void lvgl_port_perf_ppa_draw_done(uint32_t us);
+
+/**
+ * @brief Apply the refresh policy of every display to its timers
+ *
+ * @note Called from the LVGL task under the LVGL lock, after reading the input devices
+ */
+void lvgl_port_disp_refresh_update(void);
+
+/**
+ * @brief Set where the LVGL draw threads run
+ *
+ * @note Call before lv_init(); no-op unless LVGL uses the port's OS layer (esp_lvgl_port_os.h)
+ *
+ * @param priority          priority of every draw thread
+ * @param affinity          core of the first draw thread (-1 is no affinity)
+ * @param assist_affinity   core of the others (-1 is no affinity)
+ */
+void lvgl_port_os_set_draw_threads(int priority, int affinity, int assist_affinity);
+
+/**
+ * @brief Put the SW draw units after the first under lvgl_port_draw_assist_enable()
+ *
+ * @note Call right after lv_init(), from the LVGL task
+ */
+void lvgl_port_os_attach_draw_assist(void);
+
+/**
+ * @brief Size the regions of the LVGL heap
+ *
+ * @note Call before lv_init(); no-op unless the port provides LVGL's allocator (esp_lvgl_port_mem.h)
+ *
+ * @param internal_size     internal RAM region in bytes (0: default)
+ * @param psram_size        PSRAM region in bytes (0: none)
+ * @param large_size        allocations from this size go to the PSRAM region first (0: default)
+ */
+void lvgl_port_mem_set_regions(size_t internal_size, size_t psram_size, size_t large_size);
+
 #ifdef __cplusplus
 }
 #endif
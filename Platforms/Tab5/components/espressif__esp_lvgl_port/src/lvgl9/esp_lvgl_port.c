@@ -34,7 +34,9 @@ typedef struct lvgl_port_ctx_s {
     EventGroupHandle_t lvgl_events;
     SemaphoreHandle_t task_init_mux;
     esp_timer_handle_t tick_timer;
+    bool tick_cb;          /* timer_period_ms 0: LVGL reads esp_timer instead of being ticked */
     bool running;
+    volatile bool stopped; /* lvgl_port_stop(): the task blocks until lvgl_port_resume() */
     int task_max_sleep_ms;
     int timer_period_ms;
 } lvgl_port_ctx_t;
@@ -49,6 +51,7 @@ static lvgl_port_ctx_t lvgl_port_ctx;
  *******************************************************************************/
 static void lvgl_port_task(void *arg);
 static esp_err_t lvgl_port_tick_init(void);
+static uint32_t lvgl_port_tick_get(void);
 static void lvgl_port_task_deinit(void);
 
 /*******************************************************************************
@@ -61,6 +64,8 @@ esp_err_t lvgl_port_init(const lvgl_port_cfg_t *cfg)
     ESP_GOTO_ON_FALSE(cfg, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
     ESP_GOTO_ON_FALSE(cfg->task_affinity < (configNUM_CORES), ESP_ERR_INVALID_ARG, err, TAG,
                       "Bad core number for task! Maximum core number is %d", (configNUM_CORES - 1));
+    ESP_GOTO_ON_FALSE(cfg->draw_assist_affinity < (configNUM_CORES), ESP_ERR_INVALID_ARG, err, TAG,
+                      "Bad core number for draw assist! Maximum core number is %d", (configNUM_CORES - 1));
 
     memset(&lvgl_port_ctx, 0, sizeof(lvgl_port_ctx));
 
@@ -84,6 +89,11 @@ esp_err_t lvgl_port_init(const lvgl_port_cfg_t *cfg)
     lvgl_port_ctx.lvgl_events = xEventGroupCreate();
     ESP_GOTO_ON_FALSE(lvgl_port_ctx.lvgl_events, ESP_ERR_NO_MEM, err, TAG, "Create LVGL Event Group fail!");
 
+    /* LVGL starts its draw threads in lv_init() */
+    lvgl_port_os_set_draw_threads(cfg->task_priority, cfg->task_affinity, cfg->draw_assist_affinity);
+    /* ...and its heap */
+    lvgl_port_mem_set_regions(cfg->mem_internal_size, cfg->mem_psram_size, cfg->mem_large_size);
+
     BaseType_t res;
     if (cfg->task_affinity < 0) {
         res = xTaskCreate(lvgl_port_task, "taskLVGL", cfg->task_stack, xTaskGetCurrentTaskHandle(), cfg->task_priority,
@@ -111,9 +121,14 @@ esp_err_t lvgl_port_resume(void)
 {
     esp_err_t ret = ESP_ERR_INVALID_STATE;
 
-    if (lvgl_port_ctx.tick_timer != NULL) {
+    if (lvgl_port_ctx.tick_timer != NULL || lvgl_port_ctx.tick_cb) {
         lv_timer_enable(true);
-        ret = esp_timer_start_periodic(lvgl_port_ctx.tick_timer, lvgl_port_ctx.timer_period_ms * 1000);
+        ret = ESP_OK;
+        if (lvgl_port_ctx.tick_timer != NULL) {
+            ret = esp_timer_start_periodic(lvgl_port_ctx.tick_timer, lvgl_port_ctx.timer_period_ms * 1000);
+        }
+        lvgl_port_ctx.stopped = false;
+        xEventGroupSetBits(lvgl_port_ctx.lvgl_events, LVGL_PORT_EVENT_USER);
     }
 
     return ret;
@@ -123,9 +138,13 @@ esp_err_t lvgl_port_stop(void)
 {
     esp_err_t ret = ESP_ERR_INVALID_STATE;
 
-    if (lvgl_port_ctx.tick_timer != NULL) {
+    if (lvgl_port_ctx.tick_timer != NULL || lvgl_port_ctx.tick_cb) {
+        lvgl_port_ctx.stopped = true;
         lv_timer_enable(false);
-        ret = esp_timer_stop(lvgl_port_ctx.tick_timer);
+        ret = ESP_OK;
+        if (lvgl_port_ctx.tick_timer != NULL) {
+            ret = esp_timer_stop(lvgl_port_ctx.tick_timer);
+        }
     }
 
     return ret;
@@ -236,6 +255,7 @@ static void lvgl_port_task(void *arg)
 
     /* LVGL init */
     lv_init();
+    lvgl_port_os_attach_draw_assist();
     /* LVGL is initialized, notify lvgl_port_init() function about it */
     xTaskNotifyGive(task_to_notify);
     /* Tick init */
@@ -246,7 +266,15 @@ static void lvgl_port_task(void *arg)
     while (lvgl_port_ctx.running) {
         /* Wait for queue or timeout (sleep task) */
         TickType_t wait = (pdMS_TO_TICKS(task_delay_ms) >= 1 ? pdMS_TO_TICKS(task_delay_ms) : 1);
-        events          = xEventGroupWaitBits(lvgl_port_ctx.lvgl_events, 0xFF, pdTRUE, pdFALSE, wait);
+        /* Stopped: with the timers disabled lv_timer_handler() returns 1 and the task would spin,
+         * so it sleeps until lvgl_port_resume() (input events just wake it up to wait again) */
+        if (lvgl_port_ctx.stopped) {
+            wait = portMAX_DELAY;
+        }
+        events = xEventGroupWaitBits(lvgl_port_ctx.lvgl_events, 0xFF, pdTRUE, pdFALSE, wait);
+        if (lvgl_port_ctx.stopped) {
+            continue;
+        }
 
         if (lv_display_get_default() && lvgl_port_lock(0)) {
             /* Call read input devices */
@@ -259,6 +287,7 @@ static void lvgl_port_task(void *arg)
                 }
                 xSemaphoreGive(lvgl_port_ctx.timer_mux);
             }
+            lvgl_port_disp_refresh_update();
 
             /* Handle LVGL */
             task_delay_ms = lv_timer_handler();
@@ -311,8 +340,20 @@ static void lvgl_port_tick_increment(void *arg)
     xSemaphoreGive(lvgl_port_ctx.timer_mux);
 }
 
+static uint32_t lvgl_port_tick_get(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
 static esp_err_t lvgl_port_tick_init(void)
 {
+    /* No periodic interrupt: LVGL reads the time when it needs it */
+    if (lvgl_port_ctx.timer_period_ms == 0) {
+        lv_tick_set_cb(lvgl_port_tick_get);
+        lvgl_port_ctx.tick_cb = true;
+        return ESP_OK;
+    }
+
     // Tick interface for LVGL (using esp_timer to generate 2ms periodic event)
     const esp_timer_create_args_t lvgl_tick_timer_args = {
         .callback = &lvgl_port_tick_increment,
@@ -14,6 +14,7 @@
 #include "freertos/semphr.h"
 #include "esp_heap_caps.h"
 #include "esp_idf_version.h"
+#include "esp_timer.h"
 #include "esp_lcd_panel_io.h"
 #include "esp_lcd_panel_ops.h"
 #include "esp_lvgl_port.h"
@@ -42,12 +43,19 @@ static size_t data_cache_line_size        = 0;
 #define LVGL_PORT_HANDLE_FLUSH_READY 1
 #endif
 
+/* Longest wait for the vsync that shows a swapped frame buffer */
+#define LVGL_PORT_VSYNC_TIMEOUT_MS (100)
+
 #ifndef CONFIG_LV_DRAW_BUF_ALIGN
 #define CONFIG_LV_DRAW_BUF_ALIGN 1
 #endif
 
 static const char* TAG = "LVGL";
 
+/* Frame statistics, shared by all displays. Flush completion is recorded from the panel ISR. */
+static lvgl_port_perf_stats_t perf_stats;
+static portMUX_TYPE perf_lock = portMUX_INITIALIZER_UNLOCKED;
+
 /*******************************************************************************
  * Types definitions
  *******************************************************************************/
@@ -63,6 +71,14 @@ typedef struct {
     lv_display_t* disp_drv; /* LVGL display driver */
     lv_display_rotation_t current_rotation;
     SemaphoreHandle_t trans_sem; /* Idle transfer mutex */
+    void* panel_fb;              /* Panel frame buffer the PPA rotates into (ppa_direct), NULL otherwise */
+    int64_t refr_start_us;       /* Start of the refresh in progress */
+    int64_t flush_start_us;      /* Panel draw call of the area in flight, 0 when idle */
+    uint32_t frame_flush_cb_us;  /* Time spent in the flush callback this frame */
+    uint32_t frame_dirty_px;     /* Pixels flushed this frame */
+    lvgl_port_refresh_cfg_t refresh; /* Refresh policy, with the defaults filled in */
+    bool refresh_set;                /* lvgl_port_disp_set_refresh() gave a policy */
+    int8_t refresh_active;           /* Activity the timers are set for, -1 before the first update */
     struct {
         unsigned int monochrome : 1;   /* True, if display is monochrome and using 1bit for 1px */
         unsigned int swap_bytes : 1;   /* Swap bytes in RGB656 (16-bit) before send to LCD driver */
@@ -89,12 +105,19 @@ static bool lvgl_port_flush_dpi_panel_ready_callback(esp_lcd_panel_handle_t pane
                                                      esp_lcd_dpi_panel_event_data_t* edata, void* user_ctx);
 static bool lvgl_port_flush_dpi_vsync_ready_callback(esp_lcd_panel_handle_t panel_io,
                                                      esp_lcd_dpi_panel_event_data_t* edata, void* user_ctx);
+static bool lvgl_port_ppa_trans_done_callback(ppa_client_handle_t ppa_client, ppa_event_data_t* event_data,
+                                              void* user_data);
 #endif
 #endif
 static void lvgl_port_flush_callback(lv_display_t* drv, const lv_area_t* area, uint8_t* color_map);
+static void lvgl_port_flush_wait_callback(lv_display_t* drv);
 static void lvgl_port_disp_size_update_callback(lv_event_t* e);
 static void lvgl_port_disp_rotation_update(lvgl_port_display_ctx_t* disp_ctx);
 static void lvgl_port_display_invalidate_callback(lv_event_t* e);
+static void lvgl_port_disp_refr_start_callback(lv_event_t* e);
+static void lvgl_port_disp_refr_ready_callback(lv_event_t* e);
+static void lvgl_port_perf_flush_done(lvgl_port_display_ctx_t* disp_ctx);
+static void lvgl_port_disp_refresh_apply(lvgl_port_display_ctx_t* disp_ctx, uint32_t refr_ms, uint32_t read_ms);
 
 /*******************************************************************************
  * Public API functions
@@ -139,8 +162,27 @@ lv_display_t* lvgl_port_add_disp_dsi(const lvgl_port_display_cfg_t* disp_cfg,
     ESP_ERROR_CHECK(esp_cache_get_alignment(MALLOC_CAP_SPIRAM, &data_cache_line_size));
 
     assert(dsi_cfg != NULL);
+    /* The PPA path replaces the panel draw call, so it needs partial mode and the panel's own frame buffer */
+    bool ppa_direct = false;
+    void* panel_fb  = NULL;
+#if (CONFIG_IDF_TARGET_ESP32P4 && ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 3, 0))
+    if (dsi_cfg->flags.ppa_direct) {
+        const ppa_event_callbacks_t ppa_cbs = {
+            .on_trans_done = lvgl_port_ppa_trans_done_callback,
+        };
+        ppa_direct = disp_cfg->flags.sw_rotate && !dsi_cfg->flags.avoid_tearing && !disp_cfg->flags.direct_mode &&
+                     !disp_cfg->flags.full_refresh && !disp_cfg->monochrome &&
+                     esp_lcd_dpi_panel_get_frame_buffer(disp_cfg->panel_handle, 1, &panel_fb) == ESP_OK &&
+                     ppa_client_register_event_callbacks(ppa_srm_handle, &ppa_cbs) == ESP_OK;
+        if (!ppa_direct) {
+            ESP_LOGW(TAG, "PPA direct flush needs sw_rotate in partial mode without avoid_tearing, using the draw call");
+            panel_fb = NULL;
+        }
+    }
+#endif
     const lvgl_port_disp_priv_cfg_t priv_cfg = {
         .avoid_tearing = dsi_cfg->flags.avoid_tearing,
+        .ppa_direct    = ppa_direct,
     };
     lvgl_port_lock(0);
     lv_disp_t* disp = lvgl_port_add_disp_priv(disp_cfg, &priv_cfg);
@@ -160,6 +202,9 @@ lv_display_t* lvgl_port_add_disp_dsi(const lvgl_port_display_cfg_t* disp_cfg,
         /* Register done callback */
         esp_lcd_dpi_panel_register_event_callbacks(disp_ctx->panel_handle, &cbs, disp);
 
+        /* Flushes go straight into the panel frame buffer */
+        disp_ctx->panel_fb = panel_fb;
+
         /* Apply rotation from initial display configuration */
         lvgl_port_disp_rotation_update(disp_ctx);
 #else
@@ -257,10 +302,93 @@ void lvgl_port_flush_ready(lv_display_t* disp)
     lv_disp_flush_ready(disp);
 }
 
+void lvgl_port_get_perf_stats(lvgl_port_perf_stats_t* stats)
+{
+    assert(stats);
+    portENTER_CRITICAL(&perf_lock);
+    *stats = perf_stats;
+    portEXIT_CRITICAL(&perf_lock);
+}
+
+void lvgl_port_reset_perf_stats(void)
+{
+    portENTER_CRITICAL(&perf_lock);
+    memset(&perf_stats, 0, sizeof(perf_stats));
+    portEXIT_CRITICAL(&perf_lock);
+}
+
+esp_err_t lvgl_port_disp_set_refresh(lv_display_t* disp, const lvgl_port_refresh_cfg_t* cfg)
+{
+    ESP_RETURN_ON_FALSE(disp, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    lvgl_port_display_ctx_t* disp_ctx = (lvgl_port_display_ctx_t*)lv_display_get_driver_data(disp);
+    ESP_RETURN_ON_FALSE(disp_ctx, ESP_ERR_INVALID_ARG, TAG, "not an esp_lvgl_port display");
+
+    lvgl_port_lock(0);
+    /* The previous policy's input device goes back to LVGL's default period */
+    if (disp_ctx->refresh_set) {
+        lvgl_port_disp_refresh_apply(disp_ctx, LV_DEF_REFR_PERIOD, LV_DEF_REFR_PERIOD);
+    }
+    disp_ctx->refresh_set    = cfg != NULL;
+    disp_ctx->refresh_active = -1;
+    if (cfg) {
+        disp_ctx->refresh = *cfg;
+        if (disp_ctx->refresh.active_period_ms == 0) {
+            disp_ctx->refresh.active_period_ms = LV_DEF_REFR_PERIOD;
+        }
+        if (disp_ctx->refresh.idle_period_ms == 0) {
+            disp_ctx->refresh.idle_period_ms = LV_DEF_REFR_PERIOD;
+        }
+        if (disp_ctx->refresh.idle_read_period_ms == 0) {
+            disp_ctx->refresh.idle_read_period_ms = disp_ctx->refresh.active_period_ms;
+        }
+    } else {
+        memset(&disp_ctx->refresh, 0, sizeof(disp_ctx->refresh));
+    }
+    lvgl_port_unlock();
+
+    return ESP_OK;
+}
+
+void lvgl_port_disp_refresh_update(void)
+{
+    for (lv_display_t* disp = lv_display_get_next(NULL); disp; disp = lv_display_get_next(disp)) {
+        lvgl_port_display_ctx_t* disp_ctx = (lvgl_port_display_ctx_t*)lv_display_get_driver_data(disp);
+        if (!disp_ctx || !disp_ctx->refresh_set) {
+            continue;
+        }
+        /* A press updates the display's activity time on every read */
+        const int8_t active = lv_display_get_inactive_time(disp) < disp_ctx->refresh.active_hold_ms;
+        if (active == disp_ctx->refresh_active) {
+            continue;
+        }
+        disp_ctx->refresh_active = active;
+        if (active) {
+            lvgl_port_disp_refresh_apply(disp_ctx, disp_ctx->refresh.active_period_ms,
+                                         disp_ctx->refresh.active_period_ms);
+        } else {
+            lvgl_port_disp_refresh_apply(disp_ctx, disp_ctx->refresh.idle_period_ms,
+                                         disp_ctx->refresh.idle_read_period_ms);
+        }
+    }
+}
+
 /*******************************************************************************
  * Private functions
  *******************************************************************************/
 
+static void lvgl_port_disp_refresh_apply(lvgl_port_display_ctx_t* disp_ctx, uint32_t refr_ms, uint32_t read_ms)
+{
+    /* A paused refresh timer (nothing invalidated) stays paused, only its next period changes */
+    lv_timer_t* refr_timer = lv_display_get_refr_timer(disp_ctx->disp_drv);
+    if (refr_timer) {
+        lv_timer_set_period(refr_timer, refr_ms);
+    }
+    lv_timer_t* read_timer = disp_ctx->refresh.indev ? lv_indev_get_read_timer(disp_ctx->refresh.indev) : NULL;
+    if (read_timer) {
+        lv_timer_set_period(read_timer, read_ms);
+    }
+}
+
 static lv_display_t* lvgl_port_add_disp_priv(const lvgl_port_display_cfg_t* disp_cfg,
                                              const lvgl_port_disp_priv_cfg_t* priv_cfg)
 {
@@ -411,15 +539,21 @@ static lv_display_t* lvgl_port_add_disp_priv(const lvgl_port_display_cfg_t* disp
     }
 
     lv_display_set_flush_cb(disp, lvgl_port_flush_callback);
+    if (trans_sem) {
+        /* Block on the vsync semaphore instead of LVGL spinning on the flushing flag */
+        lv_display_set_flush_wait_cb(disp, lvgl_port_flush_wait_callback);
+    }
     lv_display_add_event_cb(disp, lvgl_port_disp_size_update_callback, LV_EVENT_RESOLUTION_CHANGED, disp_ctx);
     lv_display_add_event_cb(disp, lvgl_port_display_invalidate_callback, LV_EVENT_INVALIDATE_AREA, disp_ctx);
     lv_display_add_event_cb(disp, lvgl_port_display_invalidate_callback, LV_EVENT_REFR_REQUEST, disp_ctx);
+    lv_display_add_event_cb(disp, lvgl_port_disp_refr_start_callback, LV_EVENT_REFR_START, disp_ctx);
+    lv_display_add_event_cb(disp, lvgl_port_disp_refr_ready_callback, LV_EVENT_REFR_READY, disp_ctx);
 
     lv_display_set_driver_data(disp, disp_ctx);
     disp_ctx->disp_drv = disp;
 
-    /* Use SW rotation */
-    if (disp_cfg->flags.sw_rotate) {
+    /* Use SW rotation (the PPA direct flush rotates straight into the panel frame buffer instead) */
+    if (disp_cfg->flags.sw_rotate && !(priv_cfg && priv_cfg->ppa_direct)) {
         disp_ctx->draw_buffs[2] = heap_caps_malloc(buffer_size * color_bytes, buff_caps);
         ESP_GOTO_ON_FALSE(disp_ctx->draw_buffs[2], ESP_ERR_NO_MEM, err, TAG,
                           "Not enough memory for LVGL buffer (rotation buffer) allocation!");
@@ -456,6 +590,7 @@ static bool lvgl_port_flush_io_ready_callback(esp_lcd_panel_io_handle_t panel_io
 {
     lv_display_t* disp_drv = (lv_display_t*)user_ctx;
     assert(disp_drv != NULL);
+    lvgl_port_perf_flush_done((lvgl_port_display_ctx_t*)lv_display_get_driver_data(disp_drv));
     lv_disp_flush_ready(disp_drv);
     return false;
 }
@@ -466,6 +601,17 @@ static bool lvgl_port_flush_dpi_panel_ready_callback(esp_lcd_panel_handle_t pane
 {
     lv_display_t* disp_drv = (lv_display_t*)user_ctx;
     assert(disp_drv != NULL);
+    lvgl_port_perf_flush_done((lvgl_port_display_ctx_t*)lv_display_get_driver_data(disp_drv));
+    lv_disp_flush_ready(disp_drv);
+    return false;
+}
+
+static bool lvgl_port_ppa_trans_done_callback(ppa_client_handle_t ppa_client, ppa_event_data_t* event_data,
+                                              void* user_data)
+{
+    lv_display_t* disp_drv = (lv_display_t*)user_data;
+    assert(disp_drv != NULL);
+    lvgl_port_perf_flush_done((lvgl_port_display_ctx_t*)lv_display_get_driver_data(disp_drv));
     lv_disp_flush_ready(disp_drv);
     return false;
 }
@@ -480,6 +626,7 @@ static bool lvgl_port_flush_dpi_vsync_ready_callback(esp_lcd_panel_handle_t pane
     lvgl_port_display_ctx_t* disp_ctx = (lvgl_port_display_ctx_t*)lv_display_get_driver_data(disp_drv);
     assert(disp_ctx != NULL);
 
+    lvgl_port_perf_flush_done(disp_ctx);
     if (disp_ctx->trans_sem) {
         xSemaphoreGiveFromISR(disp_ctx->trans_sem, &need_yield);
     }
@@ -499,6 +646,7 @@ static bool lvgl_port_flush_rgb_vsync_ready_callback(esp_lcd_panel_handle_t pane
     lvgl_port_display_ctx_t* disp_ctx = (lvgl_port_display_ctx_t*)lv_display_get_driver_data(disp_drv);
     assert(disp_ctx != NULL);
 
+    lvgl_port_perf_flush_done(disp_ctx);
     if (disp_ctx->trans_sem) {
         xSemaphoreGiveFromISR(disp_ctx->trans_sem, &need_yield);
     }
@@ -607,6 +755,63 @@ void lvgl_port_rotate_area(lv_display_t* disp, lv_area_t* area)
     }
 }
 
+/* Power-of-two millisecond buckets, see LVGL_PORT_PERF_BUCKETS */
+static inline int lvgl_port_perf_time_bucket(uint32_t us)
+{
+    const uint32_t ms = us / 1000;
+    int bucket        = 0;
+    while (bucket < LVGL_PORT_PERF_BUCKETS - 1 && ms >= (1u << bucket)) {
+        bucket++;
+    }
+    return bucket;
+}
+
+/* Shares of the screen, halving from a full redraw down */
+static inline int lvgl_port_perf_dirty_bucket(uint32_t px, uint32_t screen_px)
+{
+    if (px >= screen_px) {
+        return LVGL_PORT_PERF_BUCKETS - 1;
+    }
+    int bucket         = LVGL_PORT_PERF_BUCKETS - 2;
+    uint32_t threshold = screen_px / 2;
+    while (bucket > 0 && px < threshold) {
+        threshold /= 2;
+        bucket--;
+    }
+    return bucket;
+}
+
+/* Caller holds perf_lock */
+static void lvgl_port_perf_add(lvgl_port_perf_hist_t* hist, uint32_t us)
+{
+    hist->count++;
+    hist->total_us += us;
+    if (us > hist->max_us) {
+        hist->max_us = us;
+    }
+    hist->hist[lvgl_port_perf_time_bucket(us)]++;
+}
+
+/* Called from the panel ISR, or from the flush callback when the draw call is synchronous */
+static void lvgl_port_perf_flush_done(lvgl_port_display_ctx_t* disp_ctx)
+{
+    if (disp_ctx == NULL || disp_ctx->flush_start_us == 0) {
+        return;
+    }
+    const uint32_t flush_us  = (uint32_t)(esp_timer_get_time() - disp_ctx->flush_start_us);
+    disp_ctx->flush_start_us = 0;
+    portENTER_CRITICAL_SAFE(&perf_lock);
+    lvgl_port_perf_add(&perf_stats.flush, flush_us);
+    portEXIT_CRITICAL_SAFE(&perf_lock);
+}
+
+void lvgl_port_perf_ppa_draw_done(uint32_t us)
+{
+    portENTER_CRITICAL_SAFE(&perf_lock);
+    lvgl_port_perf_add(&perf_stats.ppa_draw, us);
+    portEXIT_CRITICAL_SAFE(&perf_lock);
+}
+
 IRAM_ATTR static void rotate_copy_pixel(const uint16_t* from, uint16_t* to, uint16_t x_start, uint16_t y_start,
                                         uint16_t x_end, uint16_t y_end, uint16_t w, uint16_t h, uint16_t rotation)
 {
@@ -665,6 +870,70 @@ IRAM_ATTR static void rotate_copy_pixel(const uint16_t* from, uint16_t* to, uint
     ESP_ERROR_CHECK(ppa_do_scale_rotate_mirror(ppa_srm_handle, &oper_config));
 }
 
+#if (CONFIG_IDF_TARGET_ESP32P4 && ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 3, 0))
+/* Rotate one area straight into the panel frame buffer; lvgl_port_ppa_trans_done_callback() completes the flush */
+static void lvgl_port_ppa_flush_direct(lv_display_t* drv, lvgl_port_display_ctx_t* disp_ctx, const lv_area_t* area,
+                                       uint8_t* color_map)
+{
+    const int32_t ww  = lv_area_get_width(area);
+    const int32_t hh  = lv_area_get_height(area);
+    lv_area_t dest    = *area;
+    lvgl_port_rotate_area(drv, &dest);
+    const int32_t fbw = lv_display_get_physical_horizontal_resolution(drv);
+    const int32_t fbh = lv_display_get_physical_vertical_resolution(drv);
+
+    ppa_srm_rotation_angle_t ppa_rotation = PPA_SRM_ROTATION_ANGLE_0;
+    switch (disp_ctx->current_rotation) {
+        case LV_DISPLAY_ROTATION_90:
+            ppa_rotation = PPA_SRM_ROTATION_ANGLE_90;
+            break;
+        case LV_DISPLAY_ROTATION_180:
+            ppa_rotation = PPA_SRM_ROTATION_ANGLE_180;
+            break;
+        case LV_DISPLAY_ROTATION_270:
+            ppa_rotation = PPA_SRM_ROTATION_ANGLE_270;
+            break;
+        default:
+            break;
+    }
+
+    ppa_srm_oper_config_t oper_config = {
+        .in.buffer         = color_map,
+        .in.pic_w          = ww,
+        .in.pic_h          = hh,
+        .in.block_w        = ww,
+        .in.block_h        = hh,
+        .in.block_offset_x = 0,
+        .in.block_offset_y = 0,
+        .in.srm_cm         = (LV_COLOR_DEPTH == 24) ? PPA_SRM_COLOR_MODE_RGB888 : PPA_SRM_COLOR_MODE_RGB565,
+
+        .out.buffer         = disp_ctx->panel_fb,
+        .out.buffer_size    = ALIGN_UP_BY((LV_COLOR_DEPTH / 8) * fbw * fbh, data_cache_line_size),
+        .out.pic_w          = fbw,
+        .out.pic_h          = fbh,
+        .out.block_offset_x = dest.x1,
+        .out.block_offset_y = dest.y1,
+        .out.srm_cm         = (LV_COLOR_DEPTH == 24) ? PPA_SRM_COLOR_MODE_RGB888 : PPA_SRM_COLOR_MODE_RGB565,
+
+        .rotation_angle = ppa_rotation,
+        .scale_x        = 1.0,
+        .scale_y        = 1.0,
+        .rgb_swap       = 0,
+        .byte_swap      = disp_ctx->flags.swap_bytes,
+        .mode           = PPA_TRANS_MODE_NON_BLOCKING,
+        .user_data      = drv,
+    };
+
+    disp_ctx->flush_start_us = esp_timer_get_time();
+    if (ppa_do_scale_rotate_mirror(ppa_srm_handle, &oper_config) != ESP_OK) {
+        /* Drop the area rather than stall LVGL on a flush that never completes */
+        ESP_LOGE(TAG, "PPA flush failed");
+        disp_ctx->flush_start_us = 0;
+        lv_disp_flush_ready(drv);
+    }
+}
+#endif
+
 static void lvgl_port_flush_callback(lv_display_t* drv, const lv_area_t* area, uint8_t* color_map)
 {
     assert(drv != NULL);
@@ -673,6 +942,18 @@ static void lvgl_port_flush_callback(lv_display_t* drv, const lv_area_t* area, u
     lvgl_port_display_ctx_t* disp_ctx = (lvgl_port_display_ctx_t*)lv_display_get_driver_data(drv);
     assert(disp_ctx != NULL);
 
+    const int64_t cb_start_us = esp_timer_get_time();
+    disp_ctx->frame_dirty_px += lv_area_get_size(area);
+
+#if (CONFIG_IDF_TARGET_ESP32P4 && ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 3, 0))
+    /* Rotation, byte swap and the frame buffer write in one asynchronous PPA pass */
+    if (disp_ctx->panel_fb && disp_ctx->current_rotation > LV_DISPLAY_ROTATION_0) {
+        lvgl_port_ppa_flush_direct(drv, disp_ctx, area, color_map);
+        disp_ctx->frame_flush_cb_us += (uint32_t)(esp_timer_get_time() - cb_start_us);
+        return;
+    }
+#endif
+
     int offsetx1 = area->x1;
     int offsetx2 = area->x2;
     int offsety1 = area->y1;
@@ -710,6 +991,11 @@ static void lvgl_port_flush_callback(lv_display_t* drv, const lv_area_t* area, u
             offsetx2 = area->x2;
             offsety1 = area->y1;
             offsety2 = area->y2;
+
+            const uint32_t rotate_us = (uint32_t)(esp_timer_get_time() - cb_start_us);
+            portENTER_CRITICAL(&perf_lock);
+            lvgl_port_perf_add(&perf_stats.rotate, rotate_us);
+            portEXIT_CRITICAL(&perf_lock);
         }
     }
 
@@ -727,21 +1013,37 @@ static void lvgl_port_flush_callback(lv_display_t* drv, const lv_area_t* area, u
         (disp_ctx->flags.direct_mode || disp_ctx->flags.full_refresh)) {
         if (lv_disp_flush_is_last(drv)) {
             /* If the interface is I80 or SPI, this step cannot be used for drawing. */
+            disp_ctx->flush_start_us = esp_timer_get_time();
+            if (disp_ctx->trans_sem) {
+                /* Drop a vsync that came before this swap */
+                xSemaphoreTake(disp_ctx->trans_sem, 0);
+            }
+            /* On the panel's own frame buffer this only selects it for the next vsync, no copy */
             esp_lcd_panel_draw_bitmap(disp_ctx->panel_handle, 0, 0, lv_disp_get_hor_res(drv), lv_disp_get_ver_res(drv),
                                       color_map);
-            /* Waiting for the last frame buffer to complete transmission */
-            // xSemaphoreTake(disp_ctx->trans_sem, 0);
-            // xSemaphoreTake(disp_ctx->trans_sem, portMAX_DELAY);
+            if (disp_ctx->trans_sem) {
+                /* The buffer just handed over is on screen until the vsync: LVGL must not draw into the other one
+                 * (which it syncs from this one) before then. lvgl_port_flush_wait_callback() completes the flush. */
+                disp_ctx->frame_flush_cb_us += (uint32_t)(esp_timer_get_time() - cb_start_us);
+                return;
+            }
         }
     } else {
+        disp_ctx->flush_start_us = esp_timer_get_time();
         esp_lcd_panel_draw_bitmap(disp_ctx->panel_handle, offsetx1, offsety1, offsetx2 + 1, offsety2 + 1, color_map);
     }
 
     if (disp_ctx->disp_type == LVGL_PORT_DISP_TYPE_RGB ||
         (disp_ctx->disp_type == LVGL_PORT_DISP_TYPE_DSI &&
          (disp_ctx->flags.direct_mode || disp_ctx->flags.full_refresh))) {
+        /* Without an async transfer the draw call is the whole flush */
+        if (disp_ctx->disp_type == LVGL_PORT_DISP_TYPE_DSI) {
+            lvgl_port_perf_flush_done(disp_ctx);
+        }
         lv_disp_flush_ready(drv);
     }
+
+    disp_ctx->frame_flush_cb_us += (uint32_t)(esp_timer_get_time() - cb_start_us);
 }
 
 // static void lvgl_port_flush_callback(lv_display_t *drv, const lv_area_t *area, uint8_t *color_map)
@@ -815,6 +1117,16 @@ static void lvgl_port_flush_callback(lv_display_t* drv, const lv_area_t* area, u
 //     }
 // }
 
+static void lvgl_port_flush_wait_callback(lv_display_t* drv)
+{
+    lvgl_port_display_ctx_t* disp_ctx = (lvgl_port_display_ctx_t*)lv_display_get_driver_data(drv);
+    assert(disp_ctx != NULL && disp_ctx->trans_sem != NULL);
+    if (xSemaphoreTake(disp_ctx->trans_sem, pdMS_TO_TICKS(LVGL_PORT_VSYNC_TIMEOUT_MS)) != pdTRUE) {
+        /* LVGL clears the flushing flag when this returns, so a stalled panel costs a torn frame, not a hang */
+        ESP_LOGW(TAG, "No vsync within %d ms after a frame buffer swap", LVGL_PORT_VSYNC_TIMEOUT_MS);
+    }
+}
+
 static void lvgl_port_disp_rotation_update(lvgl_port_display_ctx_t* disp_ctx)
 {
     assert(disp_ctx != NULL);
@@ -874,3 +1186,40 @@ static void lvgl_port_display_invalidate_callback(lv_event_t* e)
     /* Wake LVGL task, if needed */
     lvgl_port_task_wake(LVGL_PORT_EVENT_DISPLAY, NULL);
 }
+
+static void lvgl_port_disp_refr_start_callback(lv_event_t* e)
+{
+    assert(e);
+    lvgl_port_display_ctx_t* disp_ctx = (lvgl_port_display_ctx_t*)lv_event_get_user_data(e);
+    disp_ctx->refr_start_us           = esp_timer_get_time();
+    disp_ctx->frame_flush_cb_us       = 0;
+    disp_ctx->frame_dirty_px          = 0;
+}
+
+static void lvgl_port_disp_refr_ready_callback(lv_event_t* e)
+{
+    assert(e);
+    lvgl_port_display_ctx_t* disp_ctx = (lvgl_port_display_ctx_t*)lv_event_get_user_data(e);
+    /* Refreshes with nothing invalidated don't count as frames */
+    if (disp_ctx->refr_start_us == 0 || disp_ctx->frame_dirty_px == 0) {
+        return;
+    }
+
+    const uint32_t frame_us  = (uint32_t)(esp_timer_get_time() - disp_ctx->refr_start_us);
+    const uint32_t render_us = frame_us > disp_ctx->frame_flush_cb_us ? frame_us - disp_ctx->frame_flush_cb_us : 0;
+    const uint32_t screen_px = (uint32_t)lv_display_get_horizontal_resolution(disp_ctx->disp_drv) *
+                               (uint32_t)lv_display_get_vertical_resolution(disp_ctx->disp_drv);
+    const uint32_t dirty_px  = disp_ctx->frame_dirty_px;
+    disp_ctx->refr_start_us  = 0;
+
+    portENTER_CRITICAL(&perf_lock);
+    lvgl_port_perf_add(&perf_stats.frame, frame_us);
+    lvgl_port_perf_add(&perf_stats.render, render_us);
+    perf_stats.dirty_hist[lvgl_port_perf_dirty_bucket(dirty_px, screen_px)]++;
+    perf_stats.dirty_px_total += dirty_px;
+    if (dirty_px > perf_stats.dirty_px_max) {
+        perf_stats.dirty_px_max = dirty_px;
+    }
+    perf_stats.screen_px = screen_px;
+    portEXIT_CRITICAL(&perf_lock);
+}
@@ -0,0 +1,291 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_err.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "multi_heap.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_lvgl_port.h"
+#include "esp_lvgl_port_priv.h"
+#include "lvgl.h"
+
+#define MEM_INTERNAL_SIZE_DEFAULT   (64 * 1024)
+#define MEM_LARGE_SIZE_DEFAULT      (1024)
+
+#ifdef ESP_LVGL_PORT_MEM
+
+static const char *TAG = "LVGL";
+
+/*******************************************************************************
+ * Types definitions
+ *******************************************************************************/
+
+typedef struct {
+    uint8_t *base;
+    size_t size;
+    multi_heap_handle_t heap;
+    portMUX_TYPE lock;          /* multi_heap's lock, taken around every heap operation */
+} lvgl_port_mem_region_t;
+
+typedef struct {
+    size_t internal_size;
+    size_t psram_size;
+    size_t large_size;
+    lvgl_port_mem_region_t internal;
+    lvgl_port_mem_region_t psram;
+    uint32_t spilled;
+} lvgl_port_mem_ctx_t;
+
+/*******************************************************************************
+ * Local variables
+ *******************************************************************************/
+
+static lvgl_port_mem_ctx_t lvgl_port_mem_ctx = {
+    .internal_size = MEM_INTERNAL_SIZE_DEFAULT,
+    .large_size = MEM_LARGE_SIZE_DEFAULT,
+};
+
+/*******************************************************************************
+ * Function definitions
+ *******************************************************************************/
+
+static bool lvgl_port_mem_region_init(lvgl_port_mem_region_t *region, size_t size, uint32_t caps);
+static void lvgl_port_mem_region_deinit(lvgl_port_mem_region_t *region);
+static lvgl_port_mem_region_t *lvgl_port_mem_region_of(void *p);
+static void lvgl_port_mem_region_stats(const lvgl_port_mem_region_t *region, lvgl_port_mem_region_stats_t *stats);
+
+/*******************************************************************************
+ * Public API functions
+ *******************************************************************************/
+
+esp_err_t lvgl_port_get_mem_stats(lvgl_port_mem_stats_t *stats)
+{
+    ESP_RETURN_ON_FALSE(stats, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    lvgl_port_mem_ctx_t *ctx = &lvgl_port_mem_ctx;
+    ESP_RETURN_ON_FALSE(ctx->internal.heap || ctx->psram.heap, ESP_ERR_INVALID_STATE, TAG, "LVGL heap not initialized");
+
+    lvgl_port_mem_region_stats(&ctx->internal, &stats->internal);
+    lvgl_port_mem_region_stats(&ctx->psram, &stats->psram);
+    stats->spilled = __atomic_load_n(&ctx->spilled, __ATOMIC_RELAXED);
+    return ESP_OK;
+}
+
+/*******************************************************************************
+ * Private functions
+ *******************************************************************************/
+
+void lvgl_port_mem_set_regions(size_t internal_size, size_t psram_size, size_t large_size)
+{
+    lvgl_port_mem_ctx.internal_size = internal_size ? internal_size : MEM_INTERNAL_SIZE_DEFAULT;
+    lvgl_port_mem_ctx.psram_size = psram_size;
+    lvgl_port_mem_ctx.large_size = large_size ? large_size : MEM_LARGE_SIZE_DEFAULT;
+}
+
+/*******************************************************************************
+ * LVGL stdlib API
+ *******************************************************************************/
+
+void lv_mem_init(void)
+{
+    lvgl_port_mem_ctx_t *ctx = &lvgl_port_mem_ctx;
+    ctx->spilled = 0;
+    if (!lvgl_port_mem_region_init(&ctx->internal, ctx->internal_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)) {
+        ESP_LOGE(TAG, "LVGL heap: no %u B internal region", (unsigned)ctx->internal_size);
+    }
+    if (ctx->psram_size && !lvgl_port_mem_region_init(&ctx->psram, ctx->psram_size, MALLOC_CAP_SPIRAM)) {
+        ESP_LOGE(TAG, "LVGL heap: no %u B PSRAM region", (unsigned)ctx->psram_size);
+    }
+    ESP_LOGI(TAG, "LVGL heap: %u B internal, %u B PSRAM from %u B", (unsigned)ctx->internal.size,
+             (unsigned)ctx->psram.size, (unsigned)ctx->large_size);
+}
+
+void lv_mem_deinit(void)
+{
+    lvgl_port_mem_region_deinit(&lvgl_port_mem_ctx.internal);
+    lvgl_port_mem_region_deinit(&lvgl_port_mem_ctx.psram);
+}
+
+lv_mem_pool_t lv_mem_add_pool(void *mem, size_t bytes)
+{
+    /* Not supported: the regions are sized in lvgl_port_cfg_t */
+    LV_UNUSED(mem);
+    LV_UNUSED(bytes);
+    return NULL;
+}
+
+void lv_mem_remove_pool(lv_mem_pool_t pool)
+{
+    LV_UNUSED(pool);
+}
+
+void *lv_malloc_core(size_t size)
+{
+    lvgl_port_mem_ctx_t *ctx = &lvgl_port_mem_ctx;
+    lvgl_port_mem_region_t *first = &ctx->internal;
+    lvgl_port_mem_region_t *second = &ctx->psram;
+    if (size >= ctx->large_size) {
+        first = &ctx->psram;
+        second = &ctx->internal;
+    }
+
+    void *p = first->heap ? multi_heap_malloc(first->heap, size) : NULL;
+    if (p == NULL && second->heap) {
+        p = multi_heap_malloc(second->heap, size);
+        if (p) {
+            __atomic_add_fetch(&ctx->spilled, 1, __ATOMIC_RELAXED);
+        }
+    }
+    return p;
+}
+
+void *lv_realloc_core(void *p, size_t new_size)
+{
+    if (p == NULL) {
+        return lv_malloc_core(new_size);
+    }
+    lvgl_port_mem_region_t *region = lvgl_port_mem_region_of(p);
+    if (region == NULL) {
+        return NULL;
+    }
+
+    void *p_new = multi_heap_realloc(region->heap, p, new_size);
+    if (p_new) {
+        return p_new;
+    }
+    /* No room in its region: the block moves to wherever lv_malloc_core() finds some */
+    p_new = lv_malloc_core(new_size);
+    if (p_new) {
+        const size_t old_size = multi_heap_get_allocated_size(region->heap, p);
+        memcpy(p_new, p, old_size < new_size ? old_size : new_size);
+        multi_heap_free(region->heap, p);
+    }
+    return p_new;
+}
+
+void lv_free_core(void *p)
+{
+    lvgl_port_mem_region_t *region = lvgl_port_mem_region_of(p);
+    if (region) {
+        multi_heap_free(region->heap, p);
+    } else {
+        ESP_LOGE(TAG, "LVGL heap: free of %p outside the regions", p);
+    }
+}
+
+void lv_mem_monitor_core(lv_mem_monitor_t *mon_p)
+{
+    lv_memzero(mon_p, sizeof(lv_mem_monitor_t));
+
+    lvgl_port_mem_region_t *regions[] = {&lvgl_port_mem_ctx.internal, &lvgl_port_mem_ctx.psram};
+    for (size_t i = 0; i < sizeof(regions) / sizeof(regions[0]); i++) {
+        if (regions[i]->heap == NULL) {
+            continue;
+        }
+        multi_heap_info_t info;
+        multi_heap_get_info(regions[i]->heap, &info);
+        const size_t total = info.total_free_bytes + info.total_allocated_bytes;
+        mon_p->total_size += total;
+        mon_p->free_size += info.total_free_bytes;
+        mon_p->free_cnt += info.free_blocks;
+        mon_p->used_cnt += info.allocated_blocks;
+        mon_p->max_used += total - info.minimum_free_bytes;
+        mon_p->free_biggest_size = LV_MAX(mon_p->free_biggest_size, info.largest_free_block);
+    }
+    if (mon_p->total_size == 0) {
+        return;
+    }
+
+    mon_p->used_pct = 100 - (uint64_t)100U * mon_p->free_size / mon_p->total_size;
+    if (mon_p->free_size > 0) {
+        mon_p->frag_pct = 100 - (uint64_t)100U * mon_p->free_biggest_size / mon_p->free_size;
+    }
+}
+
+lv_result_t lv_mem_test_core(void)
+{
+    lvgl_port_mem_region_t *regions[] = {&lvgl_port_mem_ctx.internal, &lvgl_port_mem_ctx.psram};
+    for (size_t i = 0; i < sizeof(regions) / sizeof(regions[0]); i++) {
+        if (regions[i]->heap && !multi_heap_check(regions[i]->heap, true)) {
+            return LV_RESULT_INVALID;
+        }
+    }
+    return LV_RESULT_OK;
+}
+
+/*******************************************************************************
+ * Private functions
+ *******************************************************************************/
+
+static bool lvgl_port_mem_region_init(lvgl_port_mem_region_t *region, size_t size, uint32_t caps)
+{
+    region->base = heap_caps_malloc(size, caps);
+    if (region->base == NULL) {
+        return false;
+    }
+    region->heap = multi_heap_register(region->base, size);
+    if (region->heap == NULL) {
+        heap_caps_free(region->base);
+        region->base = NULL;
+        return false;
+    }
+    /* LVGL allocates from its task and from the draw threads */
+    portMUX_INITIALIZE(&region->lock);
+    multi_heap_set_lock(region->heap, &region->lock);
+    region->size = size;
+    return true;
+}
+
+static void lvgl_port_mem_region_deinit(lvgl_port_mem_region_t *region)
+{
+    /* The multi_heap lives inside the region, there is nothing else to release */
+    if (region->base) {
+        heap_caps_free(region->base);
+    }
+    region->base = NULL;
+    region->heap = NULL;
+    region->size = 0;
+}
+
+static lvgl_port_mem_region_t *lvgl_port_mem_region_of(void *p)
+{
+    lvgl_port_mem_region_t *regions[] = {&lvgl_port_mem_ctx.internal, &lvgl_port_mem_ctx.psram};
+    for (size_t i = 0; i < sizeof(regions) / sizeof(regions[0]); i++) {
+        const uint8_t *base = regions[i]->base;
+        if (base && (const uint8_t *)p >= base && (const uint8_t *)p < base + regions[i]->size) {
+            return regions[i];
+        }
+    }
+    return NULL;
+}
+
+static void lvgl_port_mem_region_stats(const lvgl_port_mem_region_t *region, lvgl_port_mem_region_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    if (region->heap == NULL) {
+        return;
+    }
+    multi_heap_info_t info;
+    multi_heap_get_info(region->heap, &info);
+    stats->total = info.total_free_bytes + info.total_allocated_bytes;
+    stats->free = info.total_free_bytes;
+    stats->min_free = info.minimum_free_bytes;
+    stats->largest_free = info.largest_free_block;
+    stats->used_blocks = info.allocated_blocks;
+}
+
+#else
+
+void lvgl_port_mem_set_regions(size_t internal_size, size_t psram_size, size_t large_size)
+{
+    (void)internal_size;
+    (void)psram_size;
+    (void)large_size;
+}
+
+#endif /* ESP_LVGL_PORT_MEM */
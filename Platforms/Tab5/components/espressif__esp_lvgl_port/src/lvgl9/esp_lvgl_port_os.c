@@ -0,0 +1,334 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "esp_err.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_lvgl_port.h"
+#include "esp_lvgl_port_priv.h"
+#include "lvgl.h"
+
+#ifdef ESP_LVGL_PORT_OS
+#include "src/draw/lv_draw_private.h"
+#include "src/draw/sw/lv_draw_sw_private.h"
+#endif
+
+static const char *TAG = "LVGL";
+
+#define DRAW_ASSIST_MAX         (3)
+#define DRAW_ASSIST_LOCK_MS     (1000)
+#define DRAW_ASSIST_PARK_MS     (50)
+
+#ifdef ESP_LVGL_PORT_OS
+
+/*******************************************************************************
+ * Types definitions
+ *******************************************************************************/
+
+typedef struct {
+    int priority;
+    int affinity;
+    int assist_affinity;
+    uint32_t thread_cnt;
+    lv_draw_sw_unit_t *assist[DRAW_ASSIST_MAX];   /* SW units of the threads after the first */
+    uint32_t assist_cnt;
+    int32_t (*sw_dispatch)(lv_draw_unit_t *draw_unit, lv_layer_t *layer);
+    volatile bool assist_enabled;
+} lvgl_port_os_ctx_t;
+
+/*******************************************************************************
+ * Local variables
+ *******************************************************************************/
+
+static lvgl_port_os_ctx_t lvgl_port_os_ctx = {
+    .affinity = -1,
+    .assist_affinity = -1,
+    .assist_enabled = true,
+};
+static portMUX_TYPE lvgl_port_os_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/*******************************************************************************
+ * Function definitions
+ *******************************************************************************/
+
+static void lvgl_port_os_thread(void *arg);
+static int32_t lvgl_port_os_assist_dispatch(lv_draw_unit_t *draw_unit, lv_layer_t *layer);
+static bool lvgl_port_os_mutex_check(lv_mutex_t *mutex);
+
+/*******************************************************************************
+ * Public API functions
+ *******************************************************************************/
+
+esp_err_t lvgl_port_draw_assist_enable(bool enable)
+{
+    lvgl_port_os_ctx_t *ctx = &lvgl_port_os_ctx;
+    ESP_RETURN_ON_FALSE(ctx->sw_dispatch, ESP_ERR_NOT_SUPPORTED, TAG, "No SW draw thread besides the first");
+    if (ctx->assist_enabled == enable) {
+        return ESP_OK;
+    }
+
+    /* Dispatching happens under the LVGL lock, so once it is held no new task reaches the assist units */
+    ESP_RETURN_ON_FALSE(lvgl_port_lock(DRAW_ASSIST_LOCK_MS), ESP_ERR_TIMEOUT, TAG, "LVGL lock timeout");
+    ctx->assist_enabled = enable;
+    lvgl_port_unlock();
+    ESP_LOGD(TAG, "Draw assist %s", enable ? "enabled" : "parked");
+    if (enable) {
+        return ESP_OK;
+    }
+
+    /* The frame that held the lock waited for its tasks; a render thread may still be between marking its
+     * task ready and clearing task_act */
+    const int64_t until = esp_timer_get_time() + DRAW_ASSIST_PARK_MS * 1000;
+    for (uint32_t i = 0; i < ctx->assist_cnt; i++) {
+        while (ctx->assist[i]->task_act) {
+            ESP_RETURN_ON_FALSE(esp_timer_get_time() < until, ESP_ERR_TIMEOUT, TAG, "Draw assist still busy");
+            vTaskDelay(1);
+        }
+    }
+    return ESP_OK;
+}
+
+/*******************************************************************************
+ * Private functions
+ *******************************************************************************/
+
+void lvgl_port_os_set_draw_threads(int priority, int affinity, int assist_affinity)
+{
+    lvgl_port_os_ctx.priority = priority;
+    lvgl_port_os_ctx.affinity = affinity;
+    lvgl_port_os_ctx.assist_affinity = assist_affinity;
+}
+
+void lvgl_port_os_attach_draw_assist(void)
+{
+    lvgl_port_os_ctx_t *ctx = &lvgl_port_os_ctx;
+    if (ctx->assist_cnt == 0) {
+        return;
+    }
+
+    /* All SW units share one dispatcher: gate it on the assist units only */
+    ctx->sw_dispatch = ctx->assist[0]->base_unit.dispatch_cb;
+    for (uint32_t i = 0; i < ctx->assist_cnt; i++) {
+        ctx->assist[i]->base_unit.dispatch_cb = lvgl_port_os_assist_dispatch;
+    }
+    ESP_LOGI(TAG, "%"PRIu32" draw assist thread(s) on core %d", ctx->assist_cnt, ctx->assist_affinity);
+}
+
+/*******************************************************************************
+ * LVGL OS API
+ *******************************************************************************/
+
+lv_result_t lv_thread_init(lv_thread_t *thread, lv_thread_prio_t prio, void (*callback)(void *), size_t stack_size,
+                           void *user_data)
+{
+    lvgl_port_os_ctx_t *ctx = &lvgl_port_os_ctx;
+    LV_UNUSED(prio); /* The draw threads stand in for the LVGL task: same priority */
+
+    /* Only the SW draw units start threads in this port */
+    const uint32_t idx = ctx->thread_cnt++;
+    int core = ctx->affinity;
+    if (idx > 0) {
+        if (idx - 1 < DRAW_ASSIST_MAX) {
+            ctx->assist[ctx->assist_cnt++] = user_data;
+        }
+        core = ctx->assist_affinity;
+    }
+
+    thread->callback = callback;
+    thread->user_data = user_data;
+    char name[configMAX_TASK_NAME_LEN];
+    snprintf(name, sizeof(name), "taskLVGLdraw%"PRIu32, idx);
+    BaseType_t res = xTaskCreatePinnedToCore(lvgl_port_os_thread, name, stack_size, thread, ctx->priority,
+                                             &thread->task, core < 0 ? tskNO_AFFINITY : core);
+    if (res != pdPASS) {
+        ESP_LOGE(TAG, "Create %s fail!", name);
+        return LV_RESULT_INVALID;
+    }
+    return LV_RESULT_OK;
+}
+
+lv_result_t lv_thread_delete(lv_thread_t *thread)
+{
+    vTaskDelete(thread->task);
+    thread->task = NULL;
+    return LV_RESULT_OK;
+}
+
+lv_result_t lv_mutex_init(lv_mutex_t *mutex)
+{
+    return lvgl_port_os_mutex_check(mutex) ? LV_RESULT_OK : LV_RESULT_INVALID;
+}
+
+lv_result_t lv_mutex_lock(lv_mutex_t *mutex)
+{
+    if (!lvgl_port_os_mutex_check(mutex) || xSemaphoreTake(mutex->mux, portMAX_DELAY) != pdTRUE) {
+        return LV_RESULT_INVALID;
+    }
+    return LV_RESULT_OK;
+}
+
+lv_result_t lv_mutex_lock_isr(lv_mutex_t *mutex)
+{
+    BaseType_t woken = pdFALSE;
+    if (mutex->mux == NULL || xSemaphoreTakeFromISR(mutex->mux, &woken) != pdTRUE) {
+        return LV_RESULT_INVALID;
+    }
+    portYIELD_FROM_ISR(woken);
+    return LV_RESULT_OK;
+}
+
+lv_result_t lv_mutex_unlock(lv_mutex_t *mutex)
+{
+    if (mutex->mux == NULL || xSemaphoreGive(mutex->mux) != pdTRUE) {
+        return LV_RESULT_INVALID;
+    }
+    return LV_RESULT_OK;
+}
+
+lv_result_t lv_mutex_delete(lv_mutex_t *mutex)
+{
+    if (mutex->mux) {
+        vSemaphoreDelete(mutex->mux);
+        mutex->mux = NULL;
+    }
+    return LV_RESULT_OK;
+}
+
+lv_result_t lv_thread_sync_init(lv_thread_sync_t *sync)
+{
+    sync->waiter = NULL;
+    sync->signaled = false;
+    return LV_RESULT_OK;
+}
+
+lv_result_t lv_thread_sync_wait(lv_thread_sync_t *sync)
+{
+    /* One waiter per sync object in LVGL: the draw thread of a unit, or the LVGL task for the dispatcher */
+    portENTER_CRITICAL(&lvgl_port_os_mux);
+    const bool signaled = sync->signaled;
+    sync->signaled = false;
+    if (!signaled) {
+        sync->waiter = xTaskGetCurrentTaskHandle();
+    }
+    portEXIT_CRITICAL(&lvgl_port_os_mux);
+
+    if (!signaled) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+    return LV_RESULT_OK;
+}
+
+lv_result_t lv_thread_sync_signal(lv_thread_sync_t *sync)
+{
+    portENTER_CRITICAL(&lvgl_port_os_mux);
+    TaskHandle_t waiter = sync->waiter;
+    sync->waiter = NULL;
+    if (waiter == NULL) {
+        sync->signaled = true;
+    }
+    portEXIT_CRITICAL(&lvgl_port_os_mux);
+
+    if (waiter) {
+        xTaskNotifyGive(waiter);
+    }
+    return LV_RESULT_OK;
+}
+
+lv_result_t lv_thread_sync_signal_isr(lv_thread_sync_t *sync)
+{
+    BaseType_t woken = pdFALSE;
+    portENTER_CRITICAL_ISR(&lvgl_port_os_mux);
+    TaskHandle_t waiter = sync->waiter;
+    sync->waiter = NULL;
+    if (waiter == NULL) {
+        sync->signaled = true;
+    }
+    portEXIT_CRITICAL_ISR(&lvgl_port_os_mux);
+
+    if (waiter) {
+        vTaskNotifyGiveFromISR(waiter, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+    return LV_RESULT_OK;
+}
+
+lv_result_t lv_thread_sync_delete(lv_thread_sync_t *sync)
+{
+    sync->waiter = NULL;
+    sync->signaled = false;
+    return LV_RESULT_OK;
+}
+
+/*******************************************************************************
+ * Private functions
+ *******************************************************************************/
+
+static void lvgl_port_os_thread(void *arg)
+{
+    lv_thread_t *thread = arg;
+    thread->callback(thread->user_data);
+    thread->task = NULL;
+    vTaskDelete(NULL);
+}
+
+static int32_t lvgl_port_os_assist_dispatch(lv_draw_unit_t *draw_unit, lv_layer_t *layer)
+{
+    /* Parked: the thread stays blocked on its sync and the other core is left alone */
+    if (!lvgl_port_os_ctx.assist_enabled) {
+        return LV_DRAW_UNIT_IDLE;
+    }
+    return lvgl_port_os_ctx.sw_dispatch(draw_unit, layer);
+}
+
+static bool lvgl_port_os_mutex_check(lv_mutex_t *mutex)
+{
+    if (mutex->mux) {
+        return true;
+    }
+    /* Created outside the critical section; the loser of a race deletes its own */
+    SemaphoreHandle_t mux = xSemaphoreCreateMutex();
+    if (mux == NULL) {
+        ESP_LOGE(TAG, "Create LVGL OS mutex fail!");
+        return false;
+    }
+    portENTER_CRITICAL(&lvgl_port_os_mux);
+    if (mutex->mux == NULL) {
+        mutex->mux = mux;
+        mux = NULL;
+    }
+    portEXIT_CRITICAL(&lvgl_port_os_mux);
+    if (mux) {
+        vSemaphoreDelete(mux);
+    }
+    return true;
+}
+
+#else
+
+esp_err_t lvgl_port_draw_assist_enable(bool enable)
+{
+    (void)enable;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void lvgl_port_os_set_draw_threads(int priority, int affinity, int assist_affinity)
+{
+    (void)priority;
+    (void)affinity;
+    (void)assist_affinity;
+}
+
+void lvgl_port_os_attach_draw_assist(void)
+{
+}
+
+#endif /* ESP_LVGL_PORT_OS */
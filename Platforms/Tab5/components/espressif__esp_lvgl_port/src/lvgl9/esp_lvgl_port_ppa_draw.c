@@ -0,0 +1,507 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <inttypes.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_err.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "driver/ppa.h"
+#include "esp_private/esp_cache_private.h"
+#include "esp_lvgl_port.h"
+#include "esp_lvgl_port_priv.h"
+#include "esp_lvgl_port_ppa_draw.h"
+#include "src/draw/lv_draw_private.h"
+#include "src/draw/sw/lv_draw_sw.h"
+#if LV_USE_OS
+#include "src/core/lv_global.h"
+#endif
+
+static const char *TAG = "LVGL";
+
+#define DRAW_UNIT_ID_PPA        (40)   /* Any ID the other units don't use (SW is 1) */
+#define PPA_DRAW_SCORE          (70)   /* Preference score; below the SW unit's 100 */
+#define PPA_DRAW_MIN_AREA_PX    (4096)
+#define PPA_DRAW_TIMEOUT_MS     (100)
+
+/*******************************************************************************
+ * Types definitions
+ *******************************************************************************/
+
+typedef struct {
+    lv_draw_unit_t base_unit;
+    lv_draw_task_t *volatile task_act; /* Task the PPA works on, NULL when idle */
+    ppa_client_handle_t fill;
+    ppa_client_handle_t srm;
+    ppa_client_handle_t blend;
+    size_t line_size;                  /* Bytes the PPA must own in whole: the larger data cache line */
+    uint32_t min_area_px;
+    int64_t start_us;
+#if !LV_USE_OS
+    SemaphoreHandle_t done_sem;        /* Given by the PPA interrupt */
+#endif
+} lvgl_port_ppa_draw_unit_t;
+
+/* Source of an image or layer task, the way the PPA reads it */
+typedef struct {
+    const uint8_t *data;
+    uint32_t stride;
+    uint32_t h;
+    lv_color_format_t cf;
+} ppa_draw_src_t;
+
+/*******************************************************************************
+ * Local variables
+ *******************************************************************************/
+
+static lvgl_port_ppa_draw_unit_t *ppa_draw_unit;
+
+/*******************************************************************************
+ * Function definitions
+ *******************************************************************************/
+
+static int32_t ppa_draw_evaluate(lv_draw_unit_t *draw_unit, lv_draw_task_t *task);
+static int32_t ppa_draw_dispatch(lv_draw_unit_t *draw_unit, lv_layer_t *layer);
+static bool ppa_draw_trans_done(ppa_client_handle_t ppa_client, ppa_event_data_t *event_data, void *user_data);
+static bool ppa_draw_start(lvgl_port_ppa_draw_unit_t *u, lv_draw_task_t *t);
+static void ppa_draw_sw(lvgl_port_ppa_draw_unit_t *u, lv_draw_task_t *t, const lv_area_t *clip);
+static void ppa_draw_task_done(lvgl_port_ppa_draw_unit_t *u);
+
+/*******************************************************************************
+ * Public API functions
+ *******************************************************************************/
+
+esp_err_t lvgl_port_ppa_draw_init(const lvgl_port_ppa_draw_cfg_t *cfg)
+{
+    esp_err_t ret = ESP_OK;
+    ESP_RETURN_ON_FALSE(ppa_draw_unit == NULL, ESP_ERR_INVALID_STATE, TAG, "PPA draw unit already added");
+
+    size_t line_int = 0, line_ext = 0;
+    ESP_RETURN_ON_ERROR(esp_cache_get_alignment(MALLOC_CAP_DMA, &line_int), TAG, "cache alignment");
+    ESP_RETURN_ON_ERROR(esp_cache_get_alignment(MALLOC_CAP_SPIRAM, &line_ext), TAG, "cache alignment");
+
+    /* One client per engine, one transaction each: the unit works on a single task at a time */
+    ppa_client_handle_t fill = NULL, srm = NULL, blend = NULL;
+#if !LV_USE_OS
+    SemaphoreHandle_t done_sem = NULL;
+#endif
+    const ppa_event_callbacks_t cbs = {
+        .on_trans_done = ppa_draw_trans_done,
+    };
+    ppa_client_config_t client_cfg = {
+        .oper_type             = PPA_OPERATION_FILL,
+        .max_pending_trans_num = 1,
+    };
+    ESP_GOTO_ON_ERROR(ppa_register_client(&client_cfg, &fill), err, TAG, "PPA fill client");
+    ESP_GOTO_ON_ERROR(ppa_client_register_event_callbacks(fill, &cbs), err, TAG, "PPA fill callbacks");
+    client_cfg.oper_type = PPA_OPERATION_SRM;
+    ESP_GOTO_ON_ERROR(ppa_register_client(&client_cfg, &srm), err, TAG, "PPA SRM client");
+    ESP_GOTO_ON_ERROR(ppa_client_register_event_callbacks(srm, &cbs), err, TAG, "PPA SRM callbacks");
+    client_cfg.oper_type = PPA_OPERATION_BLEND;
+    ESP_GOTO_ON_ERROR(ppa_register_client(&client_cfg, &blend), err, TAG, "PPA blend client");
+    ESP_GOTO_ON_ERROR(ppa_client_register_event_callbacks(blend, &cbs), err, TAG, "PPA blend callbacks");
+#if !LV_USE_OS
+    done_sem = xSemaphoreCreateBinary();
+    ESP_GOTO_ON_FALSE(done_sem, ESP_ERR_NO_MEM, err, TAG, "Create PPA draw semaphore fail!");
+#endif
+
+    /* LVGL evaluates and dispatches to the unit as soon as it is in its list */
+    lvgl_port_lock(0);
+    lvgl_port_ppa_draw_unit_t *u = lv_draw_create_unit(sizeof(lvgl_port_ppa_draw_unit_t));
+    if (u) {
+        u->fill        = fill;
+        u->srm         = srm;
+        u->blend       = blend;
+        u->line_size   = line_int > line_ext ? line_int : line_ext;
+        u->min_area_px = (cfg && cfg->min_area_px) ? cfg->min_area_px : PPA_DRAW_MIN_AREA_PX;
+        if (u->line_size < 16) {
+            u->line_size = 16; /* The PPA's own burst alignment, should the line size come back 0 */
+        }
+#if !LV_USE_OS
+        u->done_sem = done_sem;
+#endif
+        u->base_unit.evaluate_cb = ppa_draw_evaluate;
+        u->base_unit.dispatch_cb = ppa_draw_dispatch;
+        ppa_draw_unit            = u;
+    }
+    lvgl_port_unlock();
+    ESP_GOTO_ON_FALSE(u, ESP_ERR_NO_MEM, err, TAG, "Not enough memory for the PPA draw unit!");
+
+    ESP_LOGI(TAG, "PPA draw unit added, %u byte lines, tasks from %" PRIu32 " px", (unsigned)u->line_size,
+             u->min_area_px);
+    return ESP_OK;
+
+err:
+    if (fill) {
+        ppa_unregister_client(fill);
+    }
+    if (srm) {
+        ppa_unregister_client(srm);
+    }
+    if (blend) {
+        ppa_unregister_client(blend);
+    }
+#if !LV_USE_OS
+    if (done_sem) {
+        vSemaphoreDelete(done_sem);
+    }
+#endif
+    return ret;
+}
+
+/*******************************************************************************
+ * Private functions
+ *******************************************************************************/
+
+static inline bool ppa_draw_dest_cf_supported(lv_color_format_t cf)
+{
+    return cf == LV_COLOR_FORMAT_RGB565 || cf == LV_COLOR_FORMAT_ARGB8888;
+}
+
+static bool ppa_draw_image_supported(const lv_draw_image_dsc_t *dsc, const lv_area_t *coords)
+{
+    /* Scaled images stay on the CPU too: the SRM's output size and sampling don't follow LVGL's transform */
+    if (dsc->rotation != 0 || dsc->scale_x != LV_SCALE_NONE || dsc->scale_y != LV_SCALE_NONE || dsc->skew_x != 0 ||
+        dsc->skew_y != 0) {
+        return false;
+    }
+    if (dsc->recolor_opa > LV_OPA_MIN || dsc->blend_mode != LV_BLEND_MODE_NORMAL || dsc->tile ||
+        dsc->clip_radius != 0 || dsc->bitmap_mask_src != NULL || dsc->opa <= LV_OPA_MIN) {
+        return false;
+    }
+    return lv_area_get_width(coords) == dsc->header.w && lv_area_get_height(coords) == dsc->header.h;
+}
+
+static int32_t ppa_draw_evaluate(lv_draw_unit_t *draw_unit, lv_draw_task_t *t)
+{
+    lvgl_port_ppa_draw_unit_t *u       = (lvgl_port_ppa_draw_unit_t *)draw_unit;
+    const lv_draw_dsc_base_t *dsc_base = (const lv_draw_dsc_base_t *)t->draw_dsc;
+    const lv_color_format_t dest_cf    = dsc_base->layer->color_format;
+
+    if (!ppa_draw_dest_cf_supported(dest_cf)) {
+        return 0;
+    }
+
+    /* Small primitives: the PPA setup and completion interrupt cost more than drawing them */
+    lv_area_t draw_area;
+    if (!lv_area_intersect(&draw_area, &t->area, &t->clip_area) || lv_area_get_size(&draw_area) < u->min_area_px) {
+        return 0;
+    }
+
+    switch (t->type) {
+        case LV_DRAW_TASK_TYPE_FILL: {
+            const lv_draw_fill_dsc_t *dsc = (const lv_draw_fill_dsc_t *)t->draw_dsc;
+            if (dsc->radius != 0 || dsc->grad.dir != LV_GRAD_DIR_NONE || dsc->opa < LV_OPA_MAX) {
+                return 0;
+            }
+            break;
+        }
+        case LV_DRAW_TASK_TYPE_IMAGE: {
+            const lv_draw_image_dsc_t *dsc = (const lv_draw_image_dsc_t *)t->draw_dsc;
+            if (lv_image_src_get_type(dsc->src) != LV_IMAGE_SRC_VARIABLE || !ppa_draw_image_supported(dsc, &t->area)) {
+                return 0;
+            }
+            const lv_image_dsc_t *img = (const lv_image_dsc_t *)dsc->src;
+            if (img->header.flags & (LV_IMAGE_FLAGS_COMPRESSED | LV_IMAGE_FLAGS_PREMULTIPLIED)) {
+                return 0;
+            }
+            /* Opaque RGB565 goes through the SRM, anything with alpha through the blender onto RGB565 */
+            const bool blit = img->header.cf == LV_COLOR_FORMAT_RGB565 && dsc->opa >= LV_OPA_MAX;
+            const bool blend = (img->header.cf == LV_COLOR_FORMAT_RGB565 || img->header.cf == LV_COLOR_FORMAT_ARGB8888) &&
+                               dest_cf == LV_COLOR_FORMAT_RGB565;
+            if (!(blit && dest_cf == LV_COLOR_FORMAT_RGB565) && !blend) {
+                return 0;
+            }
+            break;
+        }
+        case LV_DRAW_TASK_TYPE_LAYER: {
+            const lv_draw_image_dsc_t *dsc = (const lv_draw_image_dsc_t *)t->draw_dsc;
+            const lv_layer_t *src_layer    = (const lv_layer_t *)dsc->src;
+            if (dest_cf != LV_COLOR_FORMAT_RGB565 || !ppa_draw_dest_cf_supported(src_layer->color_format)) {
+                return 0;
+            }
+            lv_draw_image_dsc_t check = *dsc;
+            check.header.w            = lv_area_get_width(&src_layer->buf_area);
+            check.header.h            = lv_area_get_height(&src_layer->buf_area);
+            if (!ppa_draw_image_supported(&check, &t->area)) {
+                return 0;
+            }
+            break;
+        }
+        default:
+            return 0;
+    }
+
+    if (t->preference_score > PPA_DRAW_SCORE) {
+        t->preference_score       = PPA_DRAW_SCORE;
+        t->preferred_draw_unit_id = DRAW_UNIT_ID_PPA;
+    }
+    return 1;
+}
+
+static int32_t ppa_draw_dispatch(lv_draw_unit_t *draw_unit, lv_layer_t *layer)
+{
+    lvgl_port_ppa_draw_unit_t *u = (lvgl_port_ppa_draw_unit_t *)draw_unit;
+
+    /* Busy with a transfer */
+    if (u->task_act) {
+        return 0;
+    }
+
+    lv_draw_task_t *t = lv_draw_get_next_available_task(layer, NULL, DRAW_UNIT_ID_PPA);
+    if (t == NULL || t->preferred_draw_unit_id != DRAW_UNIT_ID_PPA) {
+        return LV_DRAW_UNIT_IDLE;
+    }
+    if (lv_draw_layer_alloc_buf(layer) == NULL) {
+        return LV_DRAW_UNIT_IDLE;
+    }
+
+    t->state                   = LV_DRAW_TASK_STATE_IN_PROGRESS;
+    u->base_unit.target_layer  = layer;
+    u->base_unit.clip_area     = &t->clip_area;
+    u->task_act                = t;
+    u->start_us                = esp_timer_get_time();
+
+    if (!ppa_draw_start(u, t)) {
+        /* Drawn on the CPU after all (alignment, or nothing left for the PPA) */
+        u->start_us = 0;
+        ppa_draw_task_done(u);
+        lv_draw_dispatch_request();
+        return 1;
+    }
+
+#if !LV_USE_OS
+    /* No draw threads to hand the wait to: block, so the core runs other tasks while the PPA works */
+    if (xSemaphoreTake(u->done_sem, pdMS_TO_TICKS(PPA_DRAW_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGE(TAG, "PPA draw timed out");
+    }
+    ppa_draw_task_done(u);
+    lv_draw_dispatch_request();
+#endif
+    return 1;
+}
+
+/* From the PPA interrupt */
+static bool ppa_draw_trans_done(ppa_client_handle_t ppa_client, ppa_event_data_t *event_data, void *user_data)
+{
+    lvgl_port_ppa_draw_unit_t *u = (lvgl_port_ppa_draw_unit_t *)user_data;
+#if LV_USE_OS
+    ppa_draw_task_done(u);
+    lv_thread_sync_signal_isr(&LV_GLOBAL_DEFAULT()->draw_info.sync);
+    return false;
+#else
+    BaseType_t need_yield = pdFALSE;
+    xSemaphoreGiveFromISR(u->done_sem, &need_yield);
+    return need_yield == pdTRUE;
+#endif
+}
+
+static void ppa_draw_task_done(lvgl_port_ppa_draw_unit_t *u)
+{
+    lv_draw_task_t *t = u->task_act;
+    if (u->start_us != 0) {
+        lvgl_port_perf_ppa_draw_done((uint32_t)(esp_timer_get_time() - u->start_us));
+    }
+    u->task_act = NULL;
+    t->state    = LV_DRAW_TASK_STATE_READY;
+}
+
+/* Draw the task on the CPU, limited to `clip` */
+static void ppa_draw_sw(lvgl_port_ppa_draw_unit_t *u, lv_draw_task_t *t, const lv_area_t *clip)
+{
+    lv_area_t area;
+    if (!lv_area_intersect(&area, clip, &t->clip_area)) {
+        return;
+    }
+    u->base_unit.clip_area = &area;
+    switch (t->type) {
+        case LV_DRAW_TASK_TYPE_FILL:
+            lv_draw_sw_fill(&u->base_unit, (lv_draw_fill_dsc_t *)t->draw_dsc, &t->area);
+            break;
+        case LV_DRAW_TASK_TYPE_IMAGE:
+            lv_draw_sw_image(&u->base_unit, (const lv_draw_image_dsc_t *)t->draw_dsc, &t->area);
+            break;
+        case LV_DRAW_TASK_TYPE_LAYER:
+            lv_draw_sw_layer(&u->base_unit, (const lv_draw_image_dsc_t *)t->draw_dsc, &t->area);
+            break;
+        default:
+            break;
+    }
+    u->base_unit.clip_area = &t->clip_area;
+}
+
+static inline bool ppa_draw_dma_capable(const void *p)
+{
+    return esp_ptr_dma_capable(p) || esp_ptr_dma_ext_capable(p);
+}
+
+static bool ppa_draw_get_src(const lv_draw_task_t *t, ppa_draw_src_t *src)
+{
+    const lv_draw_image_dsc_t *dsc = (const lv_draw_image_dsc_t *)t->draw_dsc;
+    if (t->type == LV_DRAW_TASK_TYPE_LAYER) {
+        const lv_draw_buf_t *buf = ((const lv_layer_t *)dsc->src)->draw_buf;
+        if (buf == NULL) {
+            return false;
+        }
+        src->data   = buf->data;
+        src->stride = buf->header.stride;
+        src->h      = buf->header.h;
+        src->cf     = buf->header.cf;
+    } else {
+        const lv_image_dsc_t *img = (const lv_image_dsc_t *)dsc->src;
+        src->data                 = img->data;
+        src->stride = img->header.stride ? img->header.stride : lv_draw_buf_width_to_stride(img->header.w, img->header.cf);
+        src->h      = img->header.h;
+        src->cf     = img->header.cf;
+    }
+    /* The PPA has no stride, the picture width stands for it; and flash-mapped images are out of its reach */
+    return src->data != NULL && src->stride % lv_color_format_get_size(src->cf) == 0 && ppa_draw_dma_capable(src->data);
+}
+
+/* Start the PPA on the task, with the CPU drawing what the PPA can't own; false when it's all done on the CPU */
+static bool ppa_draw_start(lvgl_port_ppa_draw_unit_t *u, lv_draw_task_t *t)
+{
+    lv_layer_t *layer   = u->base_unit.target_layer;
+    lv_draw_buf_t *dest = layer->draw_buf;
+
+    lv_area_t draw_area;
+    if (!lv_area_intersect(&draw_area, &t->area, &t->clip_area)) {
+        return false; /*Fully clipped, nothing to do*/
+    }
+
+    ppa_draw_src_t src = {0};
+    if (t->type != LV_DRAW_TASK_TYPE_FILL && !ppa_draw_get_src(t, &src)) {
+        ppa_draw_sw(u, t, &draw_area); /*An empty layer draws nothing here either*/
+        return false;
+    }
+
+    /* The PPA writes back and invalidates the cache over its output: its columns have to be whole cache lines,
+     * so no line it owns is shared with pixels the CPU draws */
+    const uint32_t px_size = lv_color_format_get_size(layer->color_format);
+    const int32_t line_px  = (int32_t)(u->line_size / px_size);
+    const int32_t x1       = draw_area.x1 - layer->buf_area.x1;
+    const int32_t x2       = draw_area.x2 - layer->buf_area.x1 + 1;
+    const int32_t ax1      = (x1 + line_px - 1) / line_px * line_px;
+    const int32_t ax2      = x2 / line_px * line_px;
+    const bool aligned     = ((uintptr_t)dest->data % u->line_size) == 0 && dest->header.stride % u->line_size == 0 &&
+                         ppa_draw_dma_capable(dest->data);
+    if (!aligned || ax2 - ax1 < line_px) {
+        ppa_draw_sw(u, t, &draw_area);
+        return false;
+    }
+
+    lv_area_t edge = draw_area;
+    if (ax1 > x1) {
+        edge.x2 = layer->buf_area.x1 + ax1 - 1;
+        ppa_draw_sw(u, t, &edge);
+    }
+    if (x2 > ax2) {
+        edge.x1 = layer->buf_area.x1 + ax2;
+        edge.x2 = draw_area.x2;
+        ppa_draw_sw(u, t, &edge);
+    }
+    lv_area_t ppa_area = draw_area;
+    ppa_area.x1        = layer->buf_area.x1 + ax1;
+    ppa_area.x2        = layer->buf_area.x1 + ax2 - 1;
+
+    const ppa_out_pic_blk_config_t out = {
+        .buffer         = dest->data,
+        .buffer_size    = dest->header.stride * dest->header.h,
+        .pic_w          = dest->header.stride / px_size,
+        .pic_h          = dest->header.h,
+        .block_offset_x = ppa_area.x1 - layer->buf_area.x1,
+        .block_offset_y = ppa_area.y1 - layer->buf_area.y1,
+    };
+    const uint32_t block_w = lv_area_get_width(&ppa_area);
+    const uint32_t block_h = lv_area_get_height(&ppa_area);
+    const bool dest_rgb565 = layer->color_format == LV_COLOR_FORMAT_RGB565;
+    esp_err_t err          = ESP_OK;
+
+    if (t->type == LV_DRAW_TASK_TYPE_FILL) {
+        const lv_draw_fill_dsc_t *dsc = (const lv_draw_fill_dsc_t *)t->draw_dsc;
+        ppa_fill_oper_config_t oper   = {
+              .out                  = out,
+              .fill_block_w         = block_w,
+              .fill_block_h         = block_h,
+              .fill_argb_color.val  = lv_color_to_u32(dsc->color),
+              .mode                 = PPA_TRANS_MODE_NON_BLOCKING,
+              .user_data            = u,
+        };
+        oper.out.fill_cm = dest_rgb565 ? PPA_FILL_COLOR_MODE_RGB565 : PPA_FILL_COLOR_MODE_ARGB8888;
+        err              = ppa_do_fill(u->fill, &oper);
+    } else {
+        const lv_draw_image_dsc_t *dsc    = (const lv_draw_image_dsc_t *)t->draw_dsc;
+        const bool src_rgb565             = src.cf == LV_COLOR_FORMAT_RGB565;
+        const ppa_in_pic_blk_config_t in = {
+            .buffer         = src.data,
+            .pic_w          = src.stride / lv_color_format_get_size(src.cf),
+            .pic_h          = src.h,
+            .block_w        = block_w,
+            .block_h        = block_h,
+            .block_offset_x = ppa_area.x1 - t->area.x1,
+            .block_offset_y = ppa_area.y1 - t->area.y1,
+        };
+
+        if (src_rgb565 && dsc->opa >= LV_OPA_MAX) {
+            ppa_srm_oper_config_t oper = {
+                .in             = in,
+                .out            = out,
+                .rotation_angle = PPA_SRM_ROTATION_ANGLE_0,
+                .scale_x        = 1.0f,
+                .scale_y        = 1.0f,
+                .mode           = PPA_TRANS_MODE_NON_BLOCKING,
+                .user_data      = u,
+            };
+            oper.in.srm_cm  = PPA_SRM_COLOR_MODE_RGB565;
+            oper.out.srm_cm = PPA_SRM_COLOR_MODE_RGB565;
+            err             = ppa_do_scale_rotate_mirror(u->srm, &oper);
+        } else {
+            /* Straight alpha over the destination, which is also the background picture */
+            ppa_blend_oper_config_t oper = {
+                .in_bg                = {
+                    .buffer         = dest->data,
+                    .pic_w          = out.pic_w,
+                    .pic_h          = out.pic_h,
+                    .block_w        = block_w,
+                    .block_h        = block_h,
+                    .block_offset_x = out.block_offset_x,
+                    .block_offset_y = out.block_offset_y,
+                    .blend_cm       = PPA_BLEND_COLOR_MODE_RGB565,
+                },
+                .in_fg                = in,
+                .out                  = out,
+                .bg_alpha_update_mode = PPA_ALPHA_NO_CHANGE,
+                .mode                 = PPA_TRANS_MODE_NON_BLOCKING,
+                .user_data            = u,
+            };
+            oper.in_fg.blend_cm = src_rgb565 ? PPA_BLEND_COLOR_MODE_RGB565 : PPA_BLEND_COLOR_MODE_ARGB8888;
+            oper.out.blend_cm   = PPA_BLEND_COLOR_MODE_RGB565;
+            if (dsc->opa >= LV_OPA_MAX) {
+                oper.fg_alpha_update_mode = PPA_ALPHA_NO_CHANGE;
+            } else if (src_rgb565) {
+                oper.fg_alpha_update_mode = PPA_ALPHA_FIX_VALUE;
+                oper.fg_alpha_fix_val     = dsc->opa;
+            } else {
+                oper.fg_alpha_update_mode = PPA_ALPHA_SCALE;
+                oper.fg_alpha_scale_ratio = dsc->opa / 255.0f;
+            }
+            err = ppa_do_blend(u->blend, &oper);
+        }
+    }
+
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "PPA draw failed (%s), drawing on the CPU", esp_err_to_name(err));
+        ppa_draw_sw(u, t, &ppa_area);
+        return false;
+    }
+    return true;
+}
@@ -10,7 +10,7 @@
 
 #include "unity.h"
 #include "esp_log.h"
-#include "freertos/FreeRTOS.h"  // for xthal_get_ccount()
+#include "esp_cpu.h"  // for esp_cpu_get_cycle_count(), Xtensa and RISC-V alike
 #include "lv_fill_common.h"
 #include "lv_draw_sw_blend.h"
 #include "lv_draw_sw_blend_to_argb8888.h"
@@ -121,6 +121,7 @@ TEST_CASE("LV Fill benchmark RGB565", "[fill][benchmark][RGB565]")
     free(dest_array_align16);
 }
 
+#if !CONFIG_IDF_TARGET_ESP32P4  // No RGB888 assembly for the esp32p4
 TEST_CASE("LV Fill benchmark RGB888", "[fill][benchmark][RGB888]")
 {
     uint8_t *dest_array_align16 = (uint8_t *)memalign(16, STRIDE * HEIGHT * sizeof(uint8_t) * 3 + UNALIGN_BYTES);
@@ -145,6 +146,7 @@ TEST_CASE("LV Fill benchmark RGB888", "[fill][benchmark][RGB888]")
     lv_fill_benchmark_init(&test_params);
     free(dest_array_align16);
 }
+#endif
 // ------------------------------------------------ Static test functions ----------------------------------------------
 
 static void lv_fill_benchmark_init(bench_test_case_params_t *test_params)
@@ -201,7 +203,7 @@ static float lv_fill_benchmark_run(bench_test_case_params_t *test_params, _lv_dr
         test_params->blend_api_px_func(dsc, 3);
     }
 
-    const unsigned int start_b = xthal_get_ccount();
+    const unsigned int start_b = esp_cpu_get_cycle_count();
     if (test_params->blend_api_func != NULL) {
         for (int i = 0; i < test_params->benchmark_cycles; i++) {
             test_params->blend_api_func(dsc);
@@ -211,7 +213,7 @@ static float lv_fill_benchmark_run(bench_test_case_params_t *test_params, _lv_dr
             test_params->blend_api_px_func(dsc, 3);
         }
     }
-    const unsigned int end_b = xthal_get_ccount();
+    const unsigned int end_b = esp_cpu_get_cycle_count();
 
     const float total_b = end_b - start_b;
     const float cycles  = total_b / (test_params->benchmark_cycles);
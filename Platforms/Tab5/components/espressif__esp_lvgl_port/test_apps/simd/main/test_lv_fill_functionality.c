@@ -7,6 +7,7 @@
 #include <string.h>
 #include <malloc.h>
 #include <inttypes.h>
+#include <sdkconfig.h>
 #include "unity.h"
 #include "esp_log.h"
 #include "lv_fill_common.h"
@@ -157,6 +158,7 @@ TEST_CASE("Test fill functionality RGB565", "[fill][functionality][RGB565]")
     functionality_test_matrix(&test_matrix, &test_case);
 }
 
+#if !CONFIG_IDF_TARGET_ESP32P4  // No RGB888 assembly for the esp32p4
 TEST_CASE("Test fill functionality RGB888", "[fill][functionality][RGB888]")
 {
     test_matrix_params_t test_matrix = {
@@ -180,6 +182,7 @@ TEST_CASE("Test fill functionality RGB888", "[fill][functionality][RGB888]")
     ESP_LOGI(TAG_LV_FILL_FUNC, "running test for RGB888 color format");
     functionality_test_matrix(&test_matrix, &test_case);
 }
+#endif
 // ------------------------------------------------ Static test functions ----------------------------------------------
 
 static void functionality_test_matrix(test_matrix_params_t *test_matrix, func_test_case_params_t *test_case)
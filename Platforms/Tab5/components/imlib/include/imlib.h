@@ -751,12 +751,64 @@ void imlib_set_pixel(image_t *img, int x, int y, int p);
 void imlib_draw_line(image_t *img, int x0, int y0, int x1, int y1, int c, int thickness);
 void imlib_draw_arrow(image_t *img, int x0, int y0, int x1, int y1, int c, int th, int size);
 void imlib_draw_rectangle(image_t *img, int rx, int ry, int rw, int rh, int c, int thickness, bool fill);
+void imlib_fill_span(image_t *img, int x1, int x2, int y, int c);
+void imlib_blend_rectangle(image_t *img, int rx, int ry, int rw, int rh, int c, int alpha);
 void imlib_draw_circle(image_t *img, int cx, int cy, int r, int c, int thickness, bool fill);
 void imlib_draw_ellipse(image_t *img, int cx, int cy, int rx, int ry, int rotation, int c, int thickness, bool fill);
 void imlib_draw_string(image_t *img, int x_off, int y_off, const char *str, int c, float scale, int x_spacing,
                        int y_spacing, bool mono_space, int char_rotation, bool char_hmirror, bool char_vflip,
                        int string_rotation, bool string_hmirror, bool string_hflip);
 
+// 叠加层文字图集: 8x16 ASCII (0x20~0x7E) 按 scale 预先栅格化, 每帧按行 span 绘制
+// PIXFORMAT_GRAYSCALE: A8 覆盖率, 绘制时给颜色, 非整数缩放带抗锯齿边缘 (RGB565 目标上混合)
+// PIXFORMAT_RGB565: 按 fg/bg 预先着色的不透明字符格, 绘制即整行拷贝
+#define IMLIB_GLYPH_W         8
+#define IMLIB_GLYPH_H         16
+#define IMLIB_GLYPH_FIRST     0x20
+#define IMLIB_GLYPH_COUNT     95
+#define IMLIB_GLYPH_SCALE_MIN 0.5f
+#define IMLIB_GLYPH_SCALE_MAX 4.0f
+typedef struct imlib_glyph_atlas {
+    pixformat_t pixfmt;
+    uint8_t bpp;
+    uint16_t cell_w, cell_h;  // 缩放后的字符格, 也是等宽步进
+    uint16_t fg, bg;          // RGB565 图集的着色
+    uint8_t *cells;           // IMLIB_GLYPH_COUNT 个字符格, 每格 cell_w * cell_h 像素
+    uint8_t *spans;           // 每格每行 [x0, x1) 非零覆盖区间
+} imlib_glyph_atlas_t;
+bool imlib_glyph_atlas_init(imlib_glyph_atlas_t *atlas, float scale, pixformat_t pixfmt, int fg, int bg);
+void imlib_glyph_atlas_deinit(imlib_glyph_atlas_t *atlas);
+// 等宽绘制, 返回画过的宽度; dirty 非 NULL 时并入画过的区域 (裁到图像内), 可只回写这块的 cache
+int imlib_draw_string_atlas(image_t *img, const imlib_glyph_atlas_t *atlas, int x_off, int y_off, const char *str,
+                            int c, rectangle_t *dirty);
+
+// 文字框: 用在保留上次内容的叠加层上, 只重画与上次不同的字符格 (先清成背景)
+// 目标内容被别处覆盖后调用 invalidate, 下次整框重画; 每帧新的相机帧直接用 imlib_draw_string_atlas
+#define IMLIB_TEXT_FIELD_MAX 48
+typedef struct imlib_text_field {
+    const imlib_glyph_atlas_t *atlas;
+    int x, y;
+    int c, bg;  // 文字色, A8 图集清格子用的背景色
+    char text[IMLIB_TEXT_FIELD_MAX];
+    uint8_t len;
+    bool valid;  // 目标里是 text 的渲染结果
+} imlib_text_field_t;
+void imlib_text_field_init(imlib_text_field_t *field, const imlib_glyph_atlas_t *atlas, int x, int y, int c, int bg);
+void imlib_text_field_invalidate(imlib_text_field_t *field);
+// 返回是否改动了图像, dirty 非 NULL 时并入改动区域
+bool imlib_text_field_draw(image_t *img, imlib_text_field_t *field, const char *str, rectangle_t *dirty);
+
+// 叠加层绘制基准: 原逐像素实现 (_ref) 与 RGB565 快速路径的 CPU 周期数, 会覆盖 img 内容
+typedef struct imlib_draw_bench {
+    uint32_t boxes_ref, boxes;    // 4 个 200x200 描边矩形, 线宽 3
+    uint32_t bars_ref, bars;      // 8 个 24x300 实心矩形
+    uint32_t labels_ref, labels;  // 4 行 16 字符文字
+    uint32_t labels_atlas;        // 同上, A8 图集
+    uint32_t field_update;        // 文字框只变最后一个字符 (录制时间走秒)
+    uint32_t panel;               // 400x120 半透明面板
+} imlib_draw_bench_t;
+void imlib_draw_benchmark(image_t *img, imlib_draw_bench_t *result);
+
 // void imlib_draw_char_8x16(image_t *fb, int32_t start_x, int32_t start_y, uint8_t ch, uint32_t color);
 // void imlib_draw_char_16x16(image_t *fb, int32_t start_x, int32_t start_y, uint32_t code, uint32_t color);
 // void imlib_draw_string(image_t *fb, uint16_t x, uint16_t y, const char *str, uint32_t color);
@@ -296,15 +296,107 @@ void imlib_draw_arrow(image_t *img, int x0, int y0, int x1, int y1, int c, int t
     imlib_draw_line(img, x1, y1, a1x, a1y, c, th);
 }
 
-static void xLine(image_t *img, int x1, int x2, int y, int c)
+/**
+ * RGB565 像素段填充: 两像素一个 32 位字写入, 每次循环 16 字节
+ */
+static void rgb565_fill(uint16_t *p, int n, uint16_t c)
 {
-    while (x1 <= x2) {
-        imlib_set_pixel(img, x1++, y, c);
+    if (n <= 0) {
+        return;
+    }
+    if (((uintptr_t)p & 2) != 0) {
+        *p++ = c;
+        n--;
+    }
+
+    uint32_t c2  = c | ((uint32_t)c << 16);
+    uint32_t *w  = (uint32_t *)p;
+    int pairs    = n >> 1;
+    for (; pairs >= 4; pairs -= 4, w += 4) {
+        w[0] = c2;
+        w[1] = c2;
+        w[2] = c2;
+        w[3] = c2;
+    }
+    while (pairs--) {
+        *w++ = c2;
+    }
+    if (n & 1) {
+        *(uint16_t *)w = c;
     }
 }
 
+/**
+ * 水平像素段 [x1, x2] 填充, 先裁剪再按格式写入
+ */
+void imlib_fill_span(image_t *img, int x1, int x2, int y, int c)
+{
+    if ((y < 0) || (y >= img->h)) {
+        return;
+    }
+    x1 = IM_MAX(x1, 0);
+    x2 = IM_MIN(x2, img->w - 1);
+    if (x1 > x2) {
+        return;
+    }
+
+    if (img->pixfmt == PIXFORMAT_RGB565) {
+        rgb565_fill(IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y) + x1, x2 - x1 + 1, c);
+    } else {
+        while (x1 <= x2) {
+            imlib_set_pixel(img, x1++, y, c);
+        }
+    }
+}
+
+/**
+ * RGB565 矩形区域 alpha 混合, alpha: 0 (不变) ~ 256 (纯色 c)
+ * 像素展开成 0x07E0F81F 掩码下的 32 位字, 三个通道一次乘法
+ */
+void imlib_blend_rectangle(image_t *img, int rx, int ry, int rw, int rh, int c, int alpha)
+{
+    int x1 = IM_MAX(rx, 0);
+    int x2 = IM_MIN(rx + rw, img->w);
+    int y1 = IM_MAX(ry, 0);
+    int y2 = IM_MIN(ry + rh, img->h);
+
+    if ((x1 >= x2) || (y1 >= y2) || (alpha <= 0)) {
+        return;
+    }
+    if ((alpha >= 256) || (img->pixfmt != PIXFORMAT_RGB565)) {
+        imlib_draw_rectangle(img, x1, y1, x2 - x1, y2 - y1, c, 1, true);
+        return;
+    }
+
+    const uint32_t a5 = (alpha + 4) >> 3;  // 5 位系数, 绿色 6 位也留有余量
+    const uint32_t fg = ((uint32_t)c | ((uint32_t)c << 16)) & 0x07E0F81F;
+    for (int y = y1; y < y2; y++) {
+        uint16_t *p = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y) + x1;
+        for (int n = x2 - x1; n > 0; n--, p++) {
+            uint32_t bg = (*p | ((uint32_t)*p << 16)) & 0x07E0F81F;
+            bg          = (bg + (((fg - bg) * a5) >> 5)) & 0x07E0F81F;
+            *p          = (uint16_t)(bg | (bg >> 16));
+        }
+    }
+}
+
+static void xLine(image_t *img, int x1, int x2, int y, int c)
+{
+    imlib_fill_span(img, x1, x2, y, c);
+}
+
 static void yLine(image_t *img, int x, int y1, int y2, int c)
 {
+    if ((img->pixfmt == PIXFORMAT_RGB565) && (0 <= x) && (x < img->w)) {
+        y1 = IM_MAX(y1, 0);
+        y2 = IM_MIN(y2, img->h - 1);
+        uint16_t *p = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y1) + x;
+        for (; y1 <= y2; y1++, p += img->w) {
+            *p = c;
+        }
+        return;
+    }
+
     while (y1 <= y2) {
         imlib_set_pixel(img, x, y1++, c);
     }
@@ -316,10 +408,8 @@ static void yLine(image_t *img, int x, int y1, int y2, int c)
 void imlib_draw_rectangle(image_t *img, int rx, int ry, int rw, int rh, int c, int thickness, bool fill)
 {
     if (fill) {
-        for (int y = ry, yy = ry + rh; y < yy; y++) {
-            for (int x = rx, xx = rx + rw; x < xx; x++) {
-                imlib_set_pixel(img, x, y, c);
-            }
+        for (int y = IM_MAX(ry, 0), yy = IM_MIN(ry + rh, img->h); y < yy; y++) {
+            imlib_fill_span(img, rx, rx + rw - 1, y, c);
         }
 
     } else if (thickness > 0) {
@@ -624,6 +714,34 @@ typedef struct {
 
 font_t gfont;
 
+/**
+ * 不缩放, 不旋转, 不镜像且完全落在图像内的 RGB565 字符: 按行直接写像素
+ * left/right: 字模左右两半, 每行一个字节, 高位在左; 8 像素宽的字符 right 为 NULL
+ * 返回 false 表示不适用, 由通用路径绘制
+ */
+static bool draw_glyph_rgb565(image_t *img, int x_off, int y_off, const uint8_t *left, const uint8_t *right, int h,
+                              int c)
+{
+    int w = right ? 16 : 8;
+
+    if ((img->pixfmt != PIXFORMAT_RGB565) || (x_off < 0) || (y_off < 0) || (x_off + w > img->w) ||
+        (y_off + h > img->h)) {
+        return false;
+    }
+
+    uint16_t *row = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y_off) + x_off;
+    for (int y = 0; y < h; y++, row += img->w) {
+        uint32_t bits = ((uint32_t)left[y] << 8) | (right ? right[y] : 0);
+        for (uint16_t *p = row; bits & 0xFFFF; bits <<= 1, p++) {
+            if (bits & 0x8000) {
+                *p = c;
+            }
+        }
+    }
+
+    return true;
+}
+
 // 8x16
 // 16x16 分两部分显示
 void imlib_draw_string(image_t *img, int x_off, int y_off, const char *str, int c, float scale, int x_spacing,
@@ -668,7 +786,8 @@ void imlib_draw_string(image_t *img, int x_off, int y_off, const char *str, int
     uint64_t unicode = 0;
     uint8_t bytes    = 0;
     char ch          = 0;
-    glyph_t *g       = (glyph_t *)malloc(sizeof(glyph_t));
+    glyph_t glyph    = {0};
+    glyph_t *g       = &glyph;
     while (*str) {
         bytes = utf8_to_unicode(str, &unicode);
 
@@ -740,7 +859,16 @@ void imlib_draw_string(image_t *img, int x_off, int y_off, const char *str, int
         //     }
         // }
 
-        if (bytes == 1) {
+        bool plain = (scale == 1.0f) && !char_rotation && !string_rotation && !char_hmirror && !char_vflip;
+        bool drawn = false;
+
+        if (plain && (bytes == 1)) {
+            drawn = draw_glyph_rgb565(img, x_off, y_off, g->data, NULL, g->h, c);
+        } else if (plain && (bytes == 3)) {
+            drawn = draw_glyph_rgb565(img, x_off, y_off, g->data, g->data + 16, g->h, c);
+        }
+
+        if (!drawn && (bytes == 1)) {
             for (int y = 0, yy = fast_floorf(g->h * scale); y < yy; y++) {
                 for (int x = 0, xx = fast_floorf(g->w * scale); x < xx; x++) {
                     if (g->data[fast_floorf(y / scale)] & (1 << (g->w - 1 - fast_floorf(x / scale)))) {
@@ -753,7 +881,7 @@ void imlib_draw_string(image_t *img, int x_off, int y_off, const char *str, int
                     }
                 }
             }
-        } else if (bytes == 3) {
+        } else if (!drawn && (bytes == 3)) {
             uint8_t mask = 0;
             uint8_t font_data[32];
             memcpy(font_data, &unicode_font16x16_start[unicode * 32], 32);
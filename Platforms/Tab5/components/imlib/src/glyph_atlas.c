@@ -0,0 +1,299 @@
+/*****************************************************************************
+ glyph atlas
+
+ 视频叠加层文字: 8x16 ASCII 字库按缩放比例预先栅格化一次, 每帧只做按行的 span 拷贝/混合
+ A8 图集存覆盖率, 绘制时给颜色; RGB565 图集按前景/背景色预先着色, 绘制时整行拷贝
+ 文字框 (imlib_text_field_t) 记住上次画的内容, 在保留内容的叠加层上只重画变化的字符格
+
+*****************************************************************************/
+#include "imlib.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "font.h"
+#include "fmath.h"
+
+#define ATLAS_SUPERSAMPLE 4  // 每个目标像素 4x4 采样, 非整数缩放时边缘得到中间覆盖率
+
+static inline const uint8_t *atlas_cell(const imlib_glyph_atlas_t *atlas, int g)
+{
+    return atlas->cells + (size_t)g * atlas->cell_w * atlas->cell_h * atlas->bpp;
+}
+
+static inline const uint8_t *atlas_spans(const imlib_glyph_atlas_t *atlas, int g)
+{
+    return atlas->spans + (size_t)g * atlas->cell_h * 2;
+}
+
+/**
+ * RGB565 与 c 按 8 位覆盖率 a 混合, 同 imlib_blend_rectangle 的 0x07E0F81F 展开
+ */
+static inline uint16_t blend565(uint16_t bg, uint32_t fg, uint32_t a)
+{
+    const uint32_t a5 = (a + 4) >> 3;
+    uint32_t b        = (bg | ((uint32_t)bg << 16)) & 0x07E0F81F;
+    b                 = (b + (((fg - b) * a5) >> 5)) & 0x07E0F81F;
+    return (uint16_t)(b | (b >> 16));
+}
+
+/**
+ * 单个字形在目标像素 (x, y) 处的覆盖率 (0~255): 源点阵在目标像素内的采样命中比例
+ */
+static uint8_t glyph_coverage(const uint8_t *bits, int x, int y, float scale)
+{
+    int hits = 0;
+    for (int j = 0; j < ATLAS_SUPERSAMPLE; j++) {
+        int gy = (int)((y + (j + 0.5f) / ATLAS_SUPERSAMPLE) / scale);
+        if (gy >= IMLIB_GLYPH_H) {
+            continue;
+        }
+        for (int i = 0; i < ATLAS_SUPERSAMPLE; i++) {
+            int gx = (int)((x + (i + 0.5f) / ATLAS_SUPERSAMPLE) / scale);
+            if ((gx < IMLIB_GLYPH_W) && (bits[gy] & (0x80 >> gx))) {
+                hits++;
+            }
+        }
+    }
+    return (uint8_t)((hits * 255 + (ATLAS_SUPERSAMPLE * ATLAS_SUPERSAMPLE) / 2) /
+                     (ATLAS_SUPERSAMPLE * ATLAS_SUPERSAMPLE));
+}
+
+bool imlib_glyph_atlas_init(imlib_glyph_atlas_t *atlas, float scale, pixformat_t pixfmt, int fg, int bg)
+{
+    memset(atlas, 0, sizeof(*atlas));
+    if ((scale < IMLIB_GLYPH_SCALE_MIN) || (scale > IMLIB_GLYPH_SCALE_MAX) ||
+        ((pixfmt != PIXFORMAT_GRAYSCALE) && (pixfmt != PIXFORMAT_RGB565))) {
+        return false;
+    }
+
+    atlas->pixfmt = pixfmt;
+    atlas->bpp    = (pixfmt == PIXFORMAT_RGB565) ? 2 : 1;
+    atlas->cell_w = fast_roundf(IMLIB_GLYPH_W * scale);
+    atlas->cell_h = fast_roundf(IMLIB_GLYPH_H * scale);
+    atlas->fg     = fg;
+    atlas->bg     = bg;
+
+    const size_t cell_px = (size_t)atlas->cell_w * atlas->cell_h;
+    atlas->cells         = malloc(cell_px * atlas->bpp * IMLIB_GLYPH_COUNT);
+    atlas->spans         = malloc((size_t)atlas->cell_h * 2 * IMLIB_GLYPH_COUNT);
+    if ((atlas->cells == NULL) || (atlas->spans == NULL)) {
+        imlib_glyph_atlas_deinit(atlas);
+        return false;
+    }
+
+    const uint32_t fg32 = ((uint32_t)fg | ((uint32_t)fg << 16)) & 0x07E0F81F;
+    for (int g = 0; g < IMLIB_GLYPH_COUNT; g++) {
+        const uint8_t *bits = font_ascii_8x16 + g * IMLIB_GLYPH_H;
+        uint8_t *cell       = (uint8_t *)atlas_cell(atlas, g);
+        uint8_t *span       = (uint8_t *)atlas_spans(atlas, g);
+
+        for (int y = 0; y < atlas->cell_h; y++) {
+            int x0 = atlas->cell_w, x1 = 0;
+            for (int x = 0; x < atlas->cell_w; x++) {
+                uint8_t a = glyph_coverage(bits, x, y, scale);
+                if (a) {
+                    x0 = IM_MIN(x0, x);
+                    x1 = x + 1;
+                }
+                if (atlas->bpp == 2) {
+                    ((uint16_t *)cell)[y * atlas->cell_w + x] = blend565(bg, fg32, a);
+                } else {
+                    cell[y * atlas->cell_w + x] = a;
+                }
+            }
+            // 全空行 x0 == x1
+            span[y * 2]     = (x1 > 0) ? x0 : 0;
+            span[y * 2 + 1] = x1;
+        }
+    }
+
+    return true;
+}
+
+void imlib_glyph_atlas_deinit(imlib_glyph_atlas_t *atlas)
+{
+    free(atlas->cells);
+    free(atlas->spans);
+    atlas->cells = NULL;
+    atlas->spans = NULL;
+}
+
+/**
+ * 画一个字符格, 超出图像的部分裁掉; 不在图集内的字符画成空格
+ * A8: 只写 span 内的像素, 覆盖率 255 直接写 c, 其余混合; RGB565: 整格不透明拷贝, 只画到 RGB565 图像上
+ */
+static void atlas_blit(image_t *img, const imlib_glyph_atlas_t *atlas, int x_off, int y_off, int ch, int c)
+{
+    const int g = ((ch < IMLIB_GLYPH_FIRST) || (ch >= IMLIB_GLYPH_FIRST + IMLIB_GLYPH_COUNT)) ? 0
+                                                                                              : ch - IMLIB_GLYPH_FIRST;
+    const int cx1 = IM_MAX(-x_off, 0);
+    const int cx2 = IM_MIN(atlas->cell_w, img->w - x_off);
+    const int cy1 = IM_MAX(-y_off, 0);
+    const int cy2 = IM_MIN(atlas->cell_h, img->h - y_off);
+    if ((cx1 >= cx2) || (cy1 >= cy2)) {
+        return;
+    }
+
+    if (atlas->bpp == 2) {
+        if (img->pixfmt != PIXFORMAT_RGB565) {
+            return;
+        }
+        const uint16_t *src = (const uint16_t *)atlas_cell(atlas, g) + cy1 * atlas->cell_w + cx1;
+        uint16_t *dst       = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y_off + cy1) + x_off + cx1;
+        for (int y = cy1; y < cy2; y++, src += atlas->cell_w, dst += img->w) {
+            memcpy(dst, src, (cx2 - cx1) * sizeof(uint16_t));
+        }
+        return;
+    }
+
+    const uint8_t *cov  = atlas_cell(atlas, g);
+    const uint8_t *span = atlas_spans(atlas, g);
+    const uint32_t fg32 = ((uint32_t)c | ((uint32_t)c << 16)) & 0x07E0F81F;
+    for (int y = cy1; y < cy2; y++) {
+        const int x1 = IM_MAX(span[y * 2], cx1);
+        const int x2 = IM_MIN(span[y * 2 + 1], cx2);
+        if (x1 >= x2) {
+            continue;
+        }
+        const uint8_t *a = cov + y * atlas->cell_w;
+        if (img->pixfmt == PIXFORMAT_RGB565) {
+            uint16_t *row = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y_off + y) + x_off;
+            for (int x = x1; x < x2; x++) {
+                if (a[x] == 255) {
+                    row[x] = c;
+                } else if (a[x]) {
+                    row[x] = blend565(row[x], fg32, a[x]);
+                }
+            }
+        } else {
+            for (int x = x1; x < x2; x++) {
+                if (a[x] >= 128) {
+                    imlib_set_pixel(img, x_off + x, y_off + y, c);
+                }
+            }
+        }
+    }
+}
+
+static void rect_union(rectangle_t *dirty, int x, int y, int w, int h)
+{
+    if ((w <= 0) || (h <= 0)) {
+        return;
+    }
+    if ((dirty->w <= 0) || (dirty->h <= 0)) {
+        dirty->x = x;
+        dirty->y = y;
+        dirty->w = w;
+        dirty->h = h;
+        return;
+    }
+    int x2   = IM_MAX(dirty->x + dirty->w, x + w);
+    int y2   = IM_MAX(dirty->y + dirty->h, y + h);
+    dirty->x = IM_MIN(dirty->x, x);
+    dirty->y = IM_MIN(dirty->y, y);
+    dirty->w = x2 - dirty->x;
+    dirty->h = y2 - dirty->y;
+}
+
+/**
+ * 裁到图像范围内的字符格区域并入 dirty
+ */
+static void dirty_add_cells(image_t *img, const imlib_glyph_atlas_t *atlas, rectangle_t *dirty, int x, int y, int n)
+{
+    if (dirty == NULL) {
+        return;
+    }
+    int x1 = IM_MAX(x, 0);
+    int x2 = IM_MIN(x + n * atlas->cell_w, img->w);
+    int y1 = IM_MAX(y, 0);
+    int y2 = IM_MIN(y + atlas->cell_h, img->h);
+    rect_union(dirty, x1, y1, x2 - x1, y2 - y1);
+}
+
+/**
+ * 取下一个字符: ASCII 原样返回, 多字节 UTF-8 整个跳过, 返回 0x7F (图集外, 画成空格)
+ */
+static int next_char(const char **str)
+{
+    const unsigned char *s = (const unsigned char *)*str;
+    int ch                 = *s++;
+    if (ch >= 0x80) {
+        while ((*s & 0xC0) == 0x80) {
+            s++;
+        }
+        ch = 0x7F;
+    }
+    *str = (const char *)s;
+    return ch;
+}
+
+int imlib_draw_string_atlas(image_t *img, const imlib_glyph_atlas_t *atlas, int x_off, int y_off, const char *str,
+                            int c, rectangle_t *dirty)
+{
+    int n = 0;
+    for (int x = x_off; *str; x += atlas->cell_w, n++) {
+        atlas_blit(img, atlas, x, y_off, next_char(&str), c);
+    }
+    dirty_add_cells(img, atlas, dirty, x_off, y_off, n);
+    return n * atlas->cell_w;
+}
+
+void imlib_text_field_init(imlib_text_field_t *field, const imlib_glyph_atlas_t *atlas, int x, int y, int c, int bg)
+{
+    memset(field, 0, sizeof(*field));
+    field->atlas = atlas;
+    field->x     = x;
+    field->y     = y;
+    field->c     = c;
+    field->bg    = bg;
+}
+
+void imlib_text_field_invalidate(imlib_text_field_t *field)
+{
+    field->valid = false;
+}
+
+/**
+ * 逐格比较: 内容没变的格子不动, 变了的先清成背景再画 (A8 有半透明边缘, 不能直接叠画)
+ * RGB565 图集的格子本身不透明, 不用清; 新串变短时, 多出的旧格子清掉
+ */
+bool imlib_text_field_draw(image_t *img, imlib_text_field_t *field, const char *str, rectangle_t *dirty)
+{
+    const imlib_glyph_atlas_t *atlas = field->atlas;
+    char text[IMLIB_TEXT_FIELD_MAX];
+    int len = 0;
+    while (*str && (len < IMLIB_TEXT_FIELD_MAX)) {
+        text[len++] = (char)next_char(&str);
+    }
+
+    // 延续连续的变化格子, 合成一个 span 再清除
+    bool drawn = false;
+    int run    = -1;
+    int n      = IM_MAX(len, field->valid ? field->len : 0);
+    for (int i = 0; i <= n; i++) {
+        bool changed = (i < n) && (!field->valid || (i >= field->len) || (i >= len) || (field->text[i] != text[i]));
+        if (changed && (run < 0)) {
+            run = i;
+        }
+        if (changed || (run < 0)) {
+            continue;
+        }
+
+        const int x = field->x + run * atlas->cell_w;
+        if ((atlas->bpp == 1) || (i > len)) {
+            imlib_draw_rectangle(img, x, field->y, (i - run) * atlas->cell_w, atlas->cell_h,
+                                 atlas->bpp == 2 ? atlas->bg : field->bg, 1, true);
+        }
+        for (int k = run; k < IM_MIN(i, len); k++) {
+            atlas_blit(img, atlas, field->x + k * atlas->cell_w, field->y, text[k], field->c);
+        }
+        dirty_add_cells(img, atlas, dirty, x, field->y, i - run);
+        drawn = true;
+        run   = -1;
+    }
+
+    memcpy(field->text, text, len);
+    field->len   = len;
+    field->valid = true;
+    return drawn;
+}
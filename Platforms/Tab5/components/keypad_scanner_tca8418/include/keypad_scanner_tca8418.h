@@ -25,6 +25,8 @@ esp_err_t keypad_scanner_tca8418_irq_init(int int_pin);
 void keypad_scanner_tca8418_enable_int();
 void keypad_scanner_tca8418_disable_int();
 void keypad_scanner_tca8418_clear_irq();
+uint8_t keypad_scanner_tca8418_get_int_stat();
+void keypad_scanner_tca8418_clear_int_stat(uint8_t flags);
 
 extern const char key_value_map[];
 extern const char key_value_map_str[][10];
@@ -274,6 +274,33 @@ void keypad_scanner_tca8418_clear_irq()
     write_reg(TCA8418_REG_INT_STAT, 2);
 }
 
+/**
+ * @brief reads the interrupt status register.
+ *
+ * @return INT_STAT: bit 0 key event (K_INT), bit 1 GPI (GPI_INT)
+ */
+uint8_t keypad_scanner_tca8418_get_int_stat()
+{
+    return read_reg(TCA8418_REG_INT_STAT);
+}
+
+/**
+ * @brief clears interrupt flags; INT is released once none is left set.
+ *
+ * @param [in] flags INT_STAT bits to clear
+ * @details the GPI flag only clears after the GPIO interrupt status
+ *          registers are read, which this does when flags has it.
+ */
+void keypad_scanner_tca8418_clear_int_stat(uint8_t flags)
+{
+    if (flags & 0x02) {
+        read_reg(TCA8418_REG_GPIO_INT_STAT_1);
+        read_reg(TCA8418_REG_GPIO_INT_STAT_2);
+        read_reg(TCA8418_REG_GPIO_INT_STAT_3);
+    }
+    write_reg(TCA8418_REG_INT_STAT, flags);
+}
+
 static void write_reg(uint8_t reg, uint8_t val)
 {
     uint8_t write_buf[2] = {reg, val};
@@ -124,6 +124,78 @@ i2c_master_bus_handle_t bsp_i2c_get_handle(void);
 
 esp_err_t bsp_i2c_scan();
 
+/**
+ * @brief Sys I2C bus arbitration
+ *
+ * Everything on the sys bus takes it through bsp_i2c_acquire()/bsp_i2c_release(), one owner
+ * at a time. A release hands the bus straight to the highest class with a waiter, so a codec
+ * write waits for at most the transaction in flight, never for a queue of IMU or SCCB ones.
+ * Holding the bus across several transactions to one device batches them (one wait, no
+ * interleaving). Holds must not nest. Code that bypasses the arbiter (touch and codec driver
+ * bring-up) only gets the i2c_master driver's per-transfer serialisation.
+ */
+typedef enum {
+    BSP_I2C_CLASS_CODEC = 0, /*!< ES8388 / ES7210 control, speaker amp and headphone detect */
+    BSP_I2C_CLASS_TOUCH,     /*!< GT911 / ST7123 reports */
+    BSP_I2C_CLASS_IMU,       /*!< BMI270 FIFO drains */
+    BSP_I2C_CLASS_TELEMETRY, /*!< INA226, RX8130, power path switches */
+    BSP_I2C_CLASS_CAMERA,    /*!< Camera sensor SCCB */
+    BSP_I2C_CLASS_MAX,
+} bsp_i2c_class_t;
+
+#define BSP_I2C_WAIT_FOREVER UINT32_MAX
+
+typedef struct {
+    uint32_t acquired;      /*!< Holds granted */
+    uint32_t timeouts;      /*!< Acquires that gave up */
+    uint32_t wait_max_us;   /*!< Longest wait for the bus */
+    uint64_t wait_total_us; /*!< For the mean wait, over acquired */
+    uint32_t hold_max_us;   /*!< Longest hold */
+} bsp_i2c_stats_t;
+
+typedef struct {
+    uint8_t reg;   /*!< Register address, one byte */
+    uint8_t *data; /*!< Read into */
+    size_t len;
+} bsp_i2c_reg_read_t;
+
+/**
+ * @brief Take the sys I2C bus for a class of traffic
+ *
+ * @param cls        Priority class, BSP_I2C_CLASS_CODEC first
+ * @param timeout_ms Longest wait, or BSP_I2C_WAIT_FOREVER
+ *
+ * @return
+ *      - ESP_OK                The caller owns the bus until bsp_i2c_release()
+ *      - ESP_ERR_TIMEOUT       Not granted in time
+ *      - ESP_ERR_INVALID_STATE bsp_i2c_init() not called
+ */
+esp_err_t bsp_i2c_acquire(bsp_i2c_class_t cls, uint32_t timeout_ms);
+
+/**
+ * @brief Give the sys I2C bus back, to the highest waiting class
+ *
+ * @param cls The class it was acquired for
+ */
+void bsp_i2c_release(bsp_i2c_class_t cls);
+
+/**
+ * @brief Register reads from one device under a single hold
+ *
+ * @return
+ *      - ESP_OK          All reads done
+ *      - ESP_ERR_TIMEOUT Bus not granted, or a transfer timed out
+ *      - Other           Error of the first failed transfer; the rest are skipped
+ */
+esp_err_t bsp_i2c_read_regs(bsp_i2c_class_t cls, i2c_master_dev_handle_t dev, const bsp_i2c_reg_read_t *reads,
+                            size_t count, uint32_t timeout_ms);
+
+/**
+ * @brief Wait and hold times for a class since boot or bsp_i2c_reset_stats()
+ */
+esp_err_t bsp_i2c_get_stats(bsp_i2c_class_t cls, bsp_i2c_stats_t *stats);
+void bsp_i2c_reset_stats(void);
+
 esp_err_t bsp_ext_i2c_init(void);
 esp_err_t bsp_ext_i2c_deinit(void);
 i2c_master_bus_handle_t bsp_ext_i2c_get_handle(void);
@@ -181,15 +253,58 @@ esp_codec_dev_handle_t bsp_audio_codec_speaker_init(void);
  */
 esp_codec_dev_handle_t bsp_audio_codec_microphone_init(void);
 
+/* I2S DMA ring: 16 x 1ms buffers @48kHz. Small buffers keep the read/write granularity
+ * fine enough for low-latency block sizes; the depth bounds the output queueing delay. */
+#define BSP_I2S_DMA_DESC_NUM  (16)
+#define BSP_I2S_DMA_FRAME_NUM (48)
+
 typedef esp_err_t (*bsp_i2s_read_fn)(void *audio_buffer, size_t len, size_t *bytes_read, uint32_t timeout_ms);
 typedef esp_err_t (*bsp_i2s_write_fn)(void *audio_buffer, size_t len, size_t *bytes_written, uint32_t timeout_ms);
 typedef esp_err_t (*bsp_codec_set_in_gain_fn)(float gain);
 typedef esp_err_t (*bsp_codec_mute_fn)(bool enable);
 typedef int (*bsp_codec_volume_fn)(int volume);
 typedef esp_err_t (*bsp_codec_get_volume_fn)(void);
+/* ES7210 and RX channel at rate/bps with all four slots; the capture ops below keep the rate */
 typedef esp_err_t (*bsp_codec_reconfig_fn)(uint32_t rate, uint32_t bps, i2s_slot_mode_t ch);
 typedef esp_err_t (*bsp_i2s_reconfig_clk_fn)(uint32_t rate, uint32_t bits_cfg, i2s_slot_mode_t ch);
 
+/**
+ * @brief ES7210 capture profile
+ *
+ * slot_mask picks the TDM slots stored in the RX DMA buffers: bit 0 MIC-L, bit 1 AEC loopback,
+ * bit 2 MIC-R, bit 3 MIC-HP. Frames hold only the selected slots, in slot order. The bus keeps
+ * carrying all four. bits is 16, or 24/32 for 32-bit little-endian words, MSB-aligned, that
+ * carry the ES7210's 24-bit samples, at the rate last set by codec_reconfig_fn. Stop zero-copy streaming before changing the profile:
+ * the RX DMA buffers are reallocated. Slot n is ES7210 MIC(n+1); the mic channels outside slot_mask are powered
+ * down (bias, PGA and ADC), and a pair's ADC once both of its mics are out. codec_reconfig_fn powers all four back up.
+ */
+#define BSP_CAPTURE_SLOTS_ALL (0x0F)
+typedef struct {
+    uint8_t slot_mask;
+    uint8_t bits;
+} bsp_capture_profile_t;
+typedef esp_err_t (*bsp_codec_capture_fn)(const bsp_capture_profile_t *profile);
+
+/**
+ * @brief Capture on or off
+ *
+ * Off disables the RX channel and powers the ES7210 down; playback carries on. On powers it
+ * back up and restores the default profile (all four slots, 16-bit) with the PGA reset, so
+ * the caller re-applies its profile and input gain. Stop zero-copy streaming around it.
+ */
+typedef esp_err_t (*bsp_codec_capture_enable_fn)(bool enable);
+
+/**
+ * @brief ES8388 DAC and output drivers on or off
+ *
+ * Off soft-mutes the DAC, waits out the ramp, then turns the output drivers off before the
+ * DACs, so the jack sees no step. On powers the DACs up with the drivers still off, lets them
+ * settle, then enables the drivers and leaves the DAC muted: the caller unmutes. The state
+ * survives i2s_reconfig_clk_fn. Blocks for BSP_CODEC_OUTPUT_RAMP_MS either way.
+ */
+#define BSP_CODEC_OUTPUT_RAMP_MS (40)
+typedef esp_err_t (*bsp_codec_output_power_fn)(bool on);
+
 typedef struct {
     bsp_i2s_read_fn i2s_read;
     bsp_i2s_write_fn i2s_write;
@@ -199,12 +314,68 @@ typedef struct {
     bsp_codec_set_in_gain_fn set_in_gain;
     bsp_codec_reconfig_fn codec_reconfig_fn;
     bsp_i2s_reconfig_clk_fn i2s_reconfig_clk_fn;
+    bsp_codec_capture_fn set_capture_profile;
+    bsp_codec_capture_enable_fn set_capture_enabled;
+    bsp_codec_output_power_fn set_output_power;
 } bsp_codec_config_t;
 
 void bsp_codec_init(void);
 bsp_codec_config_t *bsp_get_codec_handle(void);
 uint8_t bsp_codec_feed_channel(void);
 
+/**
+ * @brief I2S DMA queue overflow counters (incremented from the I2S ISR)
+ *
+ * rx_overflows: RX DMA buffers overwritten before the application read them (input dropped)
+ * tx_overflows: TX DMA buffers replayed/cleared because the application did not write in time (output underrun)
+ */
+typedef struct {
+    uint32_t rx_overflows;
+    uint32_t tx_overflows;
+} bsp_i2s_xrun_counts_t;
+
+void bsp_i2s_get_xrun_counts(bsp_i2s_xrun_counts_t *counts);
+
+/**
+ * @brief Restart the I2S channels after a stall
+ *
+ * Disables and re-enables TX, then RX if it was on, which drops the DMA queues and restarts the
+ * clocks; the codecs' registers are left as they are. Call with the stream stopped, from the task
+ * that reads and writes, so no transfer is in flight.
+ */
+esp_err_t bsp_i2s_reset(void);
+
+/**
+ * @brief Zero-copy, interrupt-paced access to the I2S DMA buffers
+ *
+ * Between start and stop the RX/TX event callbacks hand each finished DMA buffer to the task
+ * that called bsp_i2s_stream_start() instead of the driver's copy queue, so esp_codec_dev_read/
+ * write must not be used meanwhile. RX completions wake that task with a task notification.
+ * Every buffer holds BSP_I2S_DMA_FRAME_NUM frames in the channel's current slot format.
+ *
+ * done_us is the esp_timer time the DMA finished the buffer: filled for RX, played out for TX.
+ * RX and TX share one I2S clock, so a TX buffer plays again (DESC_NUM - 1) buffer periods after
+ * its done_us. The consumer picks the lead between input and output from these stamps. It
+ * primes the lead by skipping TX buffers (silence) or not filling the last ones (dropped
+ * output), instead of preloading the ring. An RX buffer stays valid for about DESC_NUM - 2
+ * buffer periods. Buffers that aged out are skipped and counted in bsp_i2s_xrun_counts_t.
+ *
+ * rx_acquire: next received buffer (cache invalidated), false on timeout
+ * tx_acquire: next free buffer to fill, false on timeout (counted as a TX overflow)
+ * tx_commit:  write the CPU's cached data back before the DMA plays it
+ */
+typedef struct {
+    int16_t *data;
+    int64_t done_us;
+    uint32_t pending; /* Newer buffers of the same direction already waiting */
+} bsp_i2s_stream_buf_t;
+
+esp_err_t bsp_i2s_stream_start(void);
+void bsp_i2s_stream_stop(void);
+bool bsp_i2s_stream_rx_acquire(bsp_i2s_stream_buf_t *buf, uint32_t timeout_ms);
+bool bsp_i2s_stream_tx_acquire(bsp_i2s_stream_buf_t *buf, uint32_t timeout_ms);
+void bsp_i2s_stream_tx_commit(int16_t *buf);
+
 /**************************************************************************************************
  *
  * SPIFFS
@@ -278,6 +449,55 @@ esp_err_t bsp_sdcard_init(char *mount_point, size_t max_files);
  */
 esp_err_t bsp_sdcard_deinit(char *mount_point);
 
+/**
+ * @brief Init SD card for raw sector access, without a filesystem
+ *
+ * For handing the whole card to another owner (USB mass storage); the FAT
+ * mount has to be released with bsp_sdcard_deinit() first. Status and bus
+ * info calls work on the raw card as well.
+ *
+ * @param out_card Card handle for sdmmc_read_sectors() / sdmmc_write_sectors()
+ * @return
+ *    - ESP_OK                  Success
+ *    - ESP_ERR_INVALID_STATE   If the card is mounted or already raw
+ *    - ESP_ERR_NO_MEM          If not enough memory
+ *    - Others                  Fail
+ */
+esp_err_t bsp_sdcard_raw_init(sdmmc_card_t **out_card);
+
+/**
+ * @brief Deinit the raw SD card from bsp_sdcard_raw_init()
+ *
+ * @return
+ *    - ESP_OK: Success
+ *    - ESP_ERR_INVALID_STATE: No raw card
+ *    - Others: Fail
+ */
+esp_err_t bsp_sdcard_raw_deinit(void);
+
+/**
+ * @brief Check that the mounted SD card still answers
+ *
+ * The slot has no card-detect line; this sends a status command (CMD13) to the card.
+ *
+ * @return
+ *    - ESP_OK: Card present and responding
+ *    - ESP_ERR_INVALID_STATE: No card mounted
+ *    - Others: Card removed or not responding
+ */
+esp_err_t bsp_sdcard_get_status(void);
+
+/**
+ * @brief Bus settings the mounted SD card was brought up with
+ *
+ * @param freq_khz Clock the host actually runs the card at
+ * @param bus_width Data lines in use (1, 4 or 8)
+ * @return
+ *    - ESP_OK: Success
+ *    - ESP_ERR_INVALID_STATE: No card mounted
+ */
+esp_err_t bsp_sdcard_get_bus_info(uint32_t *freq_khz, uint8_t *bus_width);
+
 /**************************************************************************************************
  *
  * LCD interface
@@ -311,6 +531,8 @@ typedef struct {
         unsigned int buff_spiram : 1; /*!< Allocated LVGL buffer will be in PSRAM */
         unsigned int
             sw_rotate : 1; /*!< Use software rotation (slower), The feature is unavailable under avoid-tear mode */
+        unsigned int ppa_direct : 1; /*!< With sw_rotate, the PPA rotates flushed areas straight into the panel frame
+                                        buffer asynchronously, so the draw buffers can be a fraction of the screen */
     } flags;
 } bsp_display_cfg_t;
 
@@ -369,6 +591,34 @@ void bsp_display_unlock(void);
  * @param[in] rotation Angle of the display rotation
  */
 void bsp_display_rotate(lv_display_t *disp, lv_disp_rotation_t rotation);
+
+/**
+ * @brief Put the LCD panel to sleep or wake it up
+ *
+ * Display off and sleep in, or sleep out and display on. The backlight is separate
+ * (bsp_display_brightness_set()) and the DSI video stream keeps running.
+ *
+ * @param[in] sleep true to sleep
+ * @return ESP_OK, ESP_ERR_INVALID_STATE before bsp_display_start() or a panel IO error
+ */
+esp_err_t bsp_display_sleep(bool sleep);
+
+/**
+ * @brief Wake callback for touches that should not reach LVGL
+ *
+ * While set, touches are not queued for LVGL: a new press calls cb on the touch task, and that
+ * touch is dropped up to its release (also if cb is cleared meanwhile). NULL restores
+ * normal input.
+ */
+typedef void (*bsp_touch_wake_cb_t)(void);
+
+/**
+ * @brief Set or clear the touch wake callback
+ *
+ * @param[in] cb Called from the touch task; keep it short. NULL to clear
+ * @return ESP_OK, or ESP_ERR_NOT_SUPPORTED for the ST7123 panel, whose touch LVGL reads itself
+ */
+esp_err_t bsp_display_set_touch_wake_cb(bsp_touch_wake_cb_t cb);
 #endif  // BSP_CONFIG_NO_GRAPHIC_LIB == 0
 
 void bsp_io_expander_pi4ioe_init(i2c_master_bus_handle_t bus_handle);
@@ -436,6 +686,41 @@ esp_err_t bsp_usb_host_start(bsp_usb_host_power_mode_t mode, bool limit_500mA);
  */
 esp_err_t bsp_usb_host_stop(void);
 
+/**************************************************************************************************
+ *
+ * Cache access counters
+ *
+ * The P4's L1 data cache and L2 cache count hits and misses per requesting bus, and each HP core
+ * has its own data bus into them, so a core's misses can be told from the other's. DMA masters
+ * (DPI scan-out, CSI, PPA) go around the caches: their share of the PSRAM bandwidth shows up as
+ * slower misses, not as more of them. The counters run free and wrap; take deltas.
+ *
+ **************************************************************************************************/
+
+typedef struct {
+    uint32_t l1_hit;
+    uint32_t l1_miss;
+    uint32_t l2_hit;
+    uint32_t l2_miss;
+} bsp_cache_counts_t;
+
+/**
+ * @brief Start the data bus counters of both cores; calling it again is harmless
+ *
+ * @return
+ *     - ESP_OK                 On success
+ *     - ESP_ERR_NOT_SUPPORTED  The SoC headers have no access counters
+ */
+esp_err_t bsp_cache_counters_start(void);
+
+/**
+ * @brief Read one core's counters (all zero where they are not supported)
+ *
+ * @param[in]  core   0 or 1
+ * @param[out] counts Running totals
+ */
+void bsp_cache_counters_read(int core, bsp_cache_counts_t *counts);
+
 #ifdef __cplusplus
 }
 #endif
@@ -4,6 +4,8 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <stdlib.h>
+#include <string.h>
 #include "sdkconfig.h"
 #include "driver/gpio.h"
 #include "driver/ledc.h"
@@ -18,6 +20,16 @@
 #include "usb/usb_host.h"
 #include "sd_pwr_ctrl_by_on_chip_ldo.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "soc/soc_caps.h"
+#include "soc/soc.h"
+#if __has_include("soc/cache_reg.h")
+#include "soc/cache_reg.h"
+#endif
+#if SOC_CACHE_INTERNAL_MEM_VIA_L1CACHE
+#include "esp_cache.h"
+#endif
 #include "sdmmc_cmd.h"
 #include "esp_lcd_st7703.h"
 #include "esp_lcd_st7123.h"
@@ -29,11 +41,20 @@
 #include "esp_lcd_touch_st7123.h"
 #include "bsp_err_check.h"
 #include "esp_codec_dev_defaults.h"
+#include "esp_sccb_i2c.h"
 
 static const char* TAG = "M5STACK_TAB5";
 
+/* Core for the BSP's own tasks (USB host library, touch reader) */
+#if CONFIG_BSP_SERVICE_TASK_CORE < 0
+#define BSP_SERVICE_TASK_AFFINITY tskNO_AFFINITY
+#else
+#define BSP_SERVICE_TASK_AFFINITY CONFIG_BSP_SERVICE_TASK_CORE
+#endif
+
 #if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
 static lv_indev_t* disp_indev = NULL;
+static esp_lcd_panel_handle_t disp_panel_handle = NULL; /* bsp_display_sleep() */
 #endif  // (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
 
 // Global uSD card handler
@@ -55,6 +76,26 @@ static i2c_master_bus_handle_t grove_i2c_bus_handle = NULL;
 static i2s_chan_handle_t i2s_tx_chan            = NULL;
 static i2s_chan_handle_t i2s_rx_chan            = NULL;
 static const audio_codec_data_if_t* i2s_data_if = NULL; /* Codec data interface */
+static volatile uint32_t i2s_rx_q_ovf_count      = 0;
+static volatile uint32_t i2s_tx_q_ovf_count      = 0;
+
+/* Zero-copy streaming: DMA buffers handed over by the I2S ISR, consumed by one task */
+#define BSP_I2S_STREAM_RING (32) /* Power of two, > BSP_I2S_DMA_DESC_NUM */
+typedef struct {
+    void* buf[BSP_I2S_STREAM_RING];
+    int64_t done_us[BSP_I2S_STREAM_RING];
+    volatile uint32_t head; /* Written by the ISR only */
+    uint32_t tail;          /* Written by the consumer task only */
+    volatile size_t size;   /* Bytes per DMA buffer, from the last event */
+} bsp_i2s_stream_ring_t;
+
+static volatile bool i2s_streaming = false;
+static bsp_i2s_stream_ring_t i2s_rx_ring;
+static bsp_i2s_stream_ring_t i2s_tx_ring;
+static TaskHandle_t i2s_stream_task   = NULL; /* RX completions notify the consumer directly */
+static SemaphoreHandle_t i2s_tx_ready = NULL;
+static void* i2s_tx_last_sent         = NULL;
+static int64_t i2s_tx_last_sent_us    = 0;
 
 //==================================================================================
 // camera 设置输出时钟
@@ -91,6 +132,151 @@ esp_err_t bsp_cam_osc_init(void)
     return ESP_OK;
 }
 
+//==================================================================================
+// i2c arbiter
+//==================================================================================
+/* One owner at a time on the sys bus. A release hands the bus straight to the highest
+ * class with a waiter, so a codec write waits for at most the transaction in flight */
+typedef struct {
+    SemaphoreHandle_t lock;                       /* Guards everything below */
+    SemaphoreHandle_t grant[BSP_I2C_CLASS_MAX];   /* Given on a handoff to that class */
+    uint8_t waiting[BSP_I2C_CLASS_MAX];
+    bool busy;
+    int64_t held_since_us;
+    bsp_i2c_stats_t stats[BSP_I2C_CLASS_MAX];
+} bsp_i2c_arbiter_t;
+
+static bsp_i2c_arbiter_t i2c_arb;
+
+static esp_err_t bsp_i2c_arbiter_init(void)
+{
+    if (i2c_arb.lock) {
+        return ESP_OK;
+    }
+    i2c_arb.lock = xSemaphoreCreateMutex();
+    ESP_RETURN_ON_FALSE(i2c_arb.lock, ESP_ERR_NO_MEM, TAG, "no mem for i2c arbiter");
+    for (int i = 0; i < BSP_I2C_CLASS_MAX; i++) {
+        i2c_arb.grant[i] = xSemaphoreCreateCounting(UINT8_MAX, 0);
+        ESP_RETURN_ON_FALSE(i2c_arb.grant[i], ESP_ERR_NO_MEM, TAG, "no mem for i2c arbiter");
+    }
+    return ESP_OK;
+}
+
+static void bsp_i2c_account_wait(bsp_i2c_class_t cls, int64_t since_us, int64_t now_us)
+{
+    /* With i2c_arb.lock held */
+    bsp_i2c_stats_t* s    = &i2c_arb.stats[cls];
+    const uint32_t wait_us = (uint32_t)(now_us - since_us);
+    s->acquired++;
+    s->wait_total_us += wait_us;
+    if (wait_us > s->wait_max_us) {
+        s->wait_max_us = wait_us;
+    }
+    i2c_arb.held_since_us = now_us;
+}
+
+esp_err_t bsp_i2c_acquire(bsp_i2c_class_t cls, uint32_t timeout_ms)
+{
+    ESP_RETURN_ON_FALSE(cls < BSP_I2C_CLASS_MAX, ESP_ERR_INVALID_ARG, TAG, "invalid i2c class %d", cls);
+    ESP_RETURN_ON_FALSE(i2c_arb.lock, ESP_ERR_INVALID_STATE, TAG, "i2c not initialized");
+
+    const int64_t t0 = esp_timer_get_time();
+    xSemaphoreTake(i2c_arb.lock, portMAX_DELAY);
+    if (!i2c_arb.busy) {
+        i2c_arb.busy = true;
+        bsp_i2c_account_wait(cls, t0, t0);
+        xSemaphoreGive(i2c_arb.lock);
+        return ESP_OK;
+    }
+    i2c_arb.waiting[cls]++;
+    xSemaphoreGive(i2c_arb.lock);
+
+    const TickType_t wait = timeout_ms == BSP_I2C_WAIT_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    bool granted          = xSemaphoreTake(i2c_arb.grant[cls], wait) == pdTRUE;
+
+    xSemaphoreTake(i2c_arb.lock, portMAX_DELAY);
+    if (!granted) {
+        /* A handoff may have landed between the timeout and the lock: take it rather than strand it */
+        granted = xSemaphoreTake(i2c_arb.grant[cls], 0) == pdTRUE;
+        if (!granted) {
+            i2c_arb.waiting[cls]--;
+            i2c_arb.stats[cls].timeouts++;
+        }
+    }
+    if (granted) {
+        bsp_i2c_account_wait(cls, t0, esp_timer_get_time());
+    }
+    xSemaphoreGive(i2c_arb.lock);
+    return granted ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+void bsp_i2c_release(bsp_i2c_class_t cls)
+{
+    if (cls >= BSP_I2C_CLASS_MAX || !i2c_arb.lock) {
+        return;
+    }
+    xSemaphoreTake(i2c_arb.lock, portMAX_DELAY);
+    const uint32_t hold_us = (uint32_t)(esp_timer_get_time() - i2c_arb.held_since_us);
+    if (hold_us > i2c_arb.stats[cls].hold_max_us) {
+        i2c_arb.stats[cls].hold_max_us = hold_us;
+    }
+    /* Busy stays set through a handoff, so a new arrival cannot slip in ahead of a waiter */
+    int next = 0;
+    while (next < BSP_I2C_CLASS_MAX && i2c_arb.waiting[next] == 0) {
+        next++;
+    }
+    if (next < BSP_I2C_CLASS_MAX) {
+        i2c_arb.waiting[next]--;
+        xSemaphoreGive(i2c_arb.grant[next]);
+    } else {
+        i2c_arb.busy = false;
+    }
+    xSemaphoreGive(i2c_arb.lock);
+}
+
+esp_err_t bsp_i2c_get_stats(bsp_i2c_class_t cls, bsp_i2c_stats_t* stats)
+{
+    ESP_RETURN_ON_FALSE(cls < BSP_I2C_CLASS_MAX && stats, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(i2c_arb.lock, ESP_ERR_INVALID_STATE, TAG, "i2c not initialized");
+    xSemaphoreTake(i2c_arb.lock, portMAX_DELAY);
+    *stats = i2c_arb.stats[cls];
+    xSemaphoreGive(i2c_arb.lock);
+    return ESP_OK;
+}
+
+void bsp_i2c_reset_stats(void)
+{
+    if (!i2c_arb.lock) {
+        return;
+    }
+    xSemaphoreTake(i2c_arb.lock, portMAX_DELAY);
+    memset(i2c_arb.stats, 0, sizeof(i2c_arb.stats));
+    xSemaphoreGive(i2c_arb.lock);
+}
+
+esp_err_t bsp_i2c_read_regs(bsp_i2c_class_t cls, i2c_master_dev_handle_t dev, const bsp_i2c_reg_read_t* reads,
+                            size_t count, uint32_t timeout_ms)
+{
+    ESP_RETURN_ON_FALSE(dev && reads, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_ERROR(bsp_i2c_acquire(cls, timeout_ms), TAG, "i2c bus busy");
+    esp_err_t ret = ESP_OK;
+    for (size_t i = 0; i < count && ret == ESP_OK; i++) {
+        ret = i2c_master_transmit_receive(dev, &reads[i].reg, 1, reads[i].data, reads[i].len, timeout_ms);
+    }
+    bsp_i2c_release(cls);
+    return ret;
+}
+
+static esp_err_t bsp_sccb_lock(void* ctx, int timeout_ms)
+{
+    return bsp_i2c_acquire(BSP_I2C_CLASS_CAMERA, timeout_ms < 0 ? BSP_I2C_WAIT_FOREVER : (uint32_t)timeout_ms);
+}
+
+static void bsp_sccb_unlock(void* ctx)
+{
+    bsp_i2c_release(BSP_I2C_CLASS_CAMERA);
+}
+
 //==================================================================================
 // i2c
 //==================================================================================
@@ -109,6 +295,14 @@ esp_err_t bsp_i2c_init(void)
         .flags.enable_internal_pullup = true,
     };
     BSP_ERROR_CHECK_RETURN_ERR(i2c_new_master_bus(&i2c_bus_conf, &i2c_handle));
+    BSP_ERROR_CHECK_RETURN_ERR(bsp_i2c_arbiter_init());
+
+    /* The camera sensor's SCCB traffic (bring-up tables, AE/AWB writes) queues behind everything else */
+    const sccb_i2c_bus_lock_t sccb_lock = {
+        .lock   = bsp_sccb_lock,
+        .unlock = bsp_sccb_unlock,
+    };
+    sccb_i2c_set_bus_lock(&sccb_lock);
 
     i2c_initialized = true;
 
@@ -242,6 +436,24 @@ static i2c_master_dev_handle_t i2c_dev_handle_pi4ioe2;
 #define setbit(x, y) x |= (0x01 << y)
 #define clrbit(x, y) x &= ~(0x01 << y)
 
+/* Read-modify-write of one output, under one hold so two updates to an expander cannot undo each other */
+static void pi4ioe_set_output(i2c_master_dev_handle_t dev, int bit, bool level, bsp_i2c_class_t cls)
+{
+    uint8_t write_buf[2] = {PI4IO_REG_OUT_SET, 0};
+    uint8_t read_buf[1]  = {0};
+
+    bsp_i2c_acquire(cls, BSP_I2C_WAIT_FOREVER);
+    i2c_master_transmit_receive(dev, write_buf, 1, read_buf, 1, I2C_MASTER_TIMEOUT_MS);
+    write_buf[1] = read_buf[0];
+    if (level) {
+        setbit(write_buf[1], bit);
+    } else {
+        clrbit(write_buf[1], bit);
+    }
+    i2c_master_transmit(dev, write_buf, 2, I2C_MASTER_TIMEOUT_MS);
+    bsp_i2c_release(cls);
+}
+
 void bsp_io_expander_pi4ioe_init(i2c_master_bus_handle_t bus_handle)
 {
     uint8_t write_buf[2] = {0};
@@ -325,97 +537,27 @@ void bsp_io_expander_pi4ioe_init(i2c_master_bus_handle_t bus_handle)
 
 void bsp_set_charge_qc_en(bool en)
 {
-    uint8_t write_buf[2] = {0};
-    uint8_t read_buf[1]  = {0};
-
-    write_buf[0] = PI4IO_REG_OUT_SET;
-    i2c_master_transmit_receive(i2c_dev_handle_pi4ioe2, write_buf, 1, read_buf, 1, I2C_MASTER_TIMEOUT_MS);
-
-    write_buf[0] = PI4IO_REG_OUT_SET;
-    write_buf[1] = read_buf[0];
-    if (en) {
-        clrbit(write_buf[1], 5);
-    } else {
-        setbit(write_buf[1], 5);
-    }
-
-    i2c_master_transmit(i2c_dev_handle_pi4ioe2, write_buf, 2, I2C_MASTER_TIMEOUT_MS);
+    pi4ioe_set_output(i2c_dev_handle_pi4ioe2, 5, !en, BSP_I2C_CLASS_TELEMETRY);
 }
 
 void bsp_set_charge_en(bool en)
 {
-    uint8_t write_buf[2] = {0};
-    uint8_t read_buf[1]  = {0};
-
-    write_buf[0] = PI4IO_REG_OUT_SET;
-    i2c_master_transmit_receive(i2c_dev_handle_pi4ioe2, write_buf, 1, read_buf, 1, I2C_MASTER_TIMEOUT_MS);
-
-    write_buf[0] = PI4IO_REG_OUT_SET;
-    write_buf[1] = read_buf[0];
-    if (en) {
-        setbit(write_buf[1], 7);
-    } else {
-        clrbit(write_buf[1], 7);
-    }
-
-    i2c_master_transmit(i2c_dev_handle_pi4ioe2, write_buf, 2, I2C_MASTER_TIMEOUT_MS);
+    pi4ioe_set_output(i2c_dev_handle_pi4ioe2, 7, en, BSP_I2C_CLASS_TELEMETRY);
 }
 
 void bsp_set_usb_5v_en(bool en)
 {
-    uint8_t write_buf[2] = {0};
-    uint8_t read_buf[1]  = {0};
-
-    write_buf[0] = PI4IO_REG_OUT_SET;
-    i2c_master_transmit_receive(i2c_dev_handle_pi4ioe2, write_buf, 1, read_buf, 1, I2C_MASTER_TIMEOUT_MS);
-
-    write_buf[0] = PI4IO_REG_OUT_SET;
-    write_buf[1] = read_buf[0];
-    if (en) {
-        setbit(write_buf[1], 3);
-    } else {
-        clrbit(write_buf[1], 3);
-    }
-
-    i2c_master_transmit(i2c_dev_handle_pi4ioe2, write_buf, 2, I2C_MASTER_TIMEOUT_MS);
+    pi4ioe_set_output(i2c_dev_handle_pi4ioe2, 3, en, BSP_I2C_CLASS_TELEMETRY);
 }
 
 void bsp_set_ext_5v_en(bool en)
 {
-    uint8_t write_buf[2] = {0};
-    uint8_t read_buf[1]  = {0};
-
-    write_buf[0] = PI4IO_REG_OUT_SET;
-    i2c_master_transmit_receive(i2c_dev_handle_pi4ioe1, write_buf, 1, read_buf, 1, I2C_MASTER_TIMEOUT_MS);
-
-    write_buf[0] = PI4IO_REG_OUT_SET;
-    write_buf[1] = read_buf[0];
-    if (en) {
-        setbit(write_buf[1], 2);
-    } else {
-        clrbit(write_buf[1], 2);
-    }
-
-    i2c_master_transmit(i2c_dev_handle_pi4ioe1, write_buf, 2, I2C_MASTER_TIMEOUT_MS);
+    pi4ioe_set_output(i2c_dev_handle_pi4ioe1, 2, en, BSP_I2C_CLASS_TELEMETRY);
 }
 
 void bsp_speaker_enable(bool en)
 {
-    uint8_t write_buf[2] = {0};
-    uint8_t read_buf[1]  = {0};
-
-    write_buf[0] = PI4IO_REG_OUT_SET;
-    i2c_master_transmit_receive(i2c_dev_handle_pi4ioe1, write_buf, 1, read_buf, 1, I2C_MASTER_TIMEOUT_MS);
-
-    write_buf[0] = PI4IO_REG_OUT_SET;
-    write_buf[1] = read_buf[0];
-    if (en) {
-        setbit(write_buf[1], 1);  // P1 = SPK_EN
-    } else {
-        clrbit(write_buf[1], 1);  // P1 = SPK_EN
-    }
-
-    i2c_master_transmit(i2c_dev_handle_pi4ioe1, write_buf, 2, I2C_MASTER_TIMEOUT_MS);
+    pi4ioe_set_output(i2c_dev_handle_pi4ioe1, 1, en, BSP_I2C_CLASS_CODEC);  // P1 = SPK_EN
     ESP_LOGI(TAG, "Speaker amplifier %s", en ? "enabled" : "disabled");
 }
 
@@ -425,6 +567,8 @@ void bsp_generate_poweroff_signal()
     uint8_t write_buf[2] = {0};
     uint8_t read_buf[1]  = {0};
 
+    /* Held throughout: nothing else on the bus matters once the board is going down */
+    bsp_i2c_acquire(BSP_I2C_CLASS_TELEMETRY, BSP_I2C_WAIT_FOREVER);
     write_buf[0] = PI4IO_REG_OUT_SET;
     i2c_master_transmit_receive(i2c_dev_handle_pi4ioe2, write_buf, 1, read_buf, 1, I2C_MASTER_TIMEOUT_MS);
 
@@ -440,6 +584,7 @@ void bsp_generate_poweroff_signal()
         i2c_master_transmit(i2c_dev_handle_pi4ioe2, write_buf, 2, I2C_MASTER_TIMEOUT_MS);
         vTaskDelay(100 / portTICK_PERIOD_MS);
     }
+    bsp_i2c_release(BSP_I2C_CLASS_TELEMETRY);
 }
 
 bool bsp_headphone_detect()
@@ -448,7 +593,9 @@ bool bsp_headphone_detect()
     uint8_t read_buf[1]  = {0};
 
     write_buf[0] = PI4IO_REG_IN_STA;
+    bsp_i2c_acquire(BSP_I2C_CLASS_CODEC, BSP_I2C_WAIT_FOREVER);
     i2c_master_transmit_receive(i2c_dev_handle_pi4ioe1, write_buf, 1, read_buf, 1, I2C_MASTER_TIMEOUT_MS);
+    bsp_i2c_release(BSP_I2C_CLASS_CODEC);
 
     // printf("get %02x\n", read_buf[0]);
 
@@ -467,7 +614,9 @@ bool bsp_usb_c_detect()
     uint8_t read_buf[1]  = {0};
 
     write_buf[0] = PI4IO_REG_IN_STA;
+    bsp_i2c_acquire(BSP_I2C_CLASS_TELEMETRY, BSP_I2C_WAIT_FOREVER);
     i2c_master_transmit_receive(i2c_dev_handle_pi4ioe2, write_buf, 1, read_buf, 1, I2C_MASTER_TIMEOUT_MS);
+    bsp_i2c_release(BSP_I2C_CLASS_TELEMETRY);
 
     // printf("get %02x\n", read_buf[0]);
 
@@ -482,21 +631,7 @@ bool bsp_usb_c_detect()
 
 void bsp_set_ext_antenna_enable(bool en)
 {
-    uint8_t write_buf[2] = {0};
-    uint8_t read_buf[1]  = {0};
-
-    write_buf[0] = PI4IO_REG_OUT_SET;
-    i2c_master_transmit_receive(i2c_dev_handle_pi4ioe1, write_buf, 1, read_buf, 1, I2C_MASTER_TIMEOUT_MS);
-
-    write_buf[0] = PI4IO_REG_OUT_SET;
-    write_buf[1] = read_buf[0];
-    if (en) {
-        setbit(write_buf[1], 0);
-    } else {
-        clrbit(write_buf[1], 0);
-    }
-
-    i2c_master_transmit(i2c_dev_handle_pi4ioe1, write_buf, 2, I2C_MASTER_TIMEOUT_MS);
+    pi4ioe_set_output(i2c_dev_handle_pi4ioe1, 0, en, BSP_I2C_CLASS_TELEMETRY);
 }
 
 void bsp_set_wifi_power_enable(bool en)
@@ -506,6 +641,7 @@ void bsp_set_wifi_power_enable(bool en)
 
     ESP_LOGI(TAG, "set_wifi_power_enable: %d", en);
 
+    bsp_i2c_acquire(BSP_I2C_CLASS_TELEMETRY, BSP_I2C_WAIT_FOREVER);
     write_buf[0] = PI4IO_REG_OUT_SET;
     i2c_master_transmit_receive(i2c_dev_handle_pi4ioe2, write_buf, 1, read_buf, 1, I2C_MASTER_TIMEOUT_MS);
 
@@ -521,6 +657,7 @@ void bsp_set_wifi_power_enable(bool en)
 
     write_buf[0] = PI4IO_REG_OUT_SET;
     i2c_master_transmit_receive(i2c_dev_handle_pi4ioe2, write_buf, 1, read_buf, 1, I2C_MASTER_TIMEOUT_MS);
+    bsp_i2c_release(BSP_I2C_CLASS_TELEMETRY);
     printf("0x%02X: %02x\n", PI4IO_REG_OUT_SET, read_buf[0]);
 }
 
@@ -534,6 +671,7 @@ void bsp_reset_tp()
     uint8_t write_buf[2] = {0};
     uint8_t read_buf[1]  = {0};
 
+    bsp_i2c_acquire(BSP_I2C_CLASS_TOUCH, BSP_I2C_WAIT_FOREVER);
     write_buf[0] = PI4IO_REG_OUT_SET;
     i2c_master_transmit_receive(i2c_dev_handle_pi4ioe1, write_buf, 1, read_buf, 1, I2C_MASTER_TIMEOUT_MS);
 
@@ -549,6 +687,7 @@ void bsp_reset_tp()
     setbit(write_buf[1], 4);
     setbit(write_buf[1], 5);
     i2c_master_transmit(i2c_dev_handle_pi4ioe1, write_buf, 2, I2C_MASTER_TIMEOUT_MS);
+    bsp_i2c_release(BSP_I2C_CLASS_TOUCH);
     vTaskDelay(100 / portTICK_PERIOD_MS);
 }
 
@@ -569,55 +708,67 @@ void bsp_reset_tp()
 #define GPIO_SDMMC_D3  (GPIO_NUM_42)  // SDIO 数据 3
 
 static sdmmc_card_t* card;
+static bool card_raw;  // Brought up by bsp_sdcard_raw_init(), no filesystem on it
 
-esp_err_t bsp_sdcard_init(char* mount_point, size_t max_files)
+static esp_err_t bsp_sdcard_host_config(sdmmc_host_t* host, sdmmc_slot_config_t* slot_config)
 {
-    esp_err_t ret_val = ESP_OK;
-
-    if (NULL != card) {
-        return ESP_ERR_INVALID_STATE;
-    }
-
-    /**
-     * @brief Use settings defined above to initialize SD card and mount FAT filesystem.
-     *   Note: esp_vfs_fat_sdmmc/sdspi_mount is all-in-one convenience functions.
-     *   Please check its source code and implement error recovery when developing
-     *   production applications.
-     *
-     */
-    sdmmc_host_t host = SDMMC_HOST_DEFAULT();
-    host.slot         = SDMMC_HOST_SLOT_0;  //
-    // host.slot = SDMMC_HOST_SLOT_1; //
-    host.max_freq_khz                   = SDMMC_FREQ_HIGHSPEED;
+    *host       = (sdmmc_host_t)SDMMC_HOST_DEFAULT();
+    host->slot  = SDMMC_HOST_SLOT_0;  //
+    // host->slot = SDMMC_HOST_SLOT_1; //
+    host->max_freq_khz                  = SDMMC_FREQ_HIGHSPEED;
     sd_pwr_ctrl_ldo_config_t ldo_config = {
         .ldo_chan_id = BSP_LDO_PROBE_SD_CHAN,  // `LDO_VO4` is used as the SDMMC IO power
     };
     static sd_pwr_ctrl_handle_t pwr_ctrl_handle = NULL;
 
     if (pwr_ctrl_handle == NULL) {
-        ret_val = sd_pwr_ctrl_new_on_chip_ldo(&ldo_config, &pwr_ctrl_handle);
+        esp_err_t ret_val = sd_pwr_ctrl_new_on_chip_ldo(&ldo_config, &pwr_ctrl_handle);
         if (ret_val != ESP_OK) {
             ESP_LOGE(TAG, "Failed to new an on-chip ldo power control driver");
             return ret_val;
         }
     }
-    host.pwr_ctrl_handle = pwr_ctrl_handle;
+    host->pwr_ctrl_handle = pwr_ctrl_handle;
 
     /**
      * @brief This initializes the slot without card detect (CD) and write protect (WP) signals.
      *   Modify slot_config.gpio_cd and slot_config.gpio_wp if your board has these signals.
      *
      */
-    sdmmc_slot_config_t slot_config = SDMMC_SLOT_CONFIG_DEFAULT();
-    slot_config.width               = SDMMC_BUS_WIDTH;
-    slot_config.clk                 = GPIO_SDMMC_CLK;
-    slot_config.cmd                 = GPIO_SDMMC_CMD;
-    slot_config.d0                  = GPIO_SDMMC_D0;
-    slot_config.d1                  = GPIO_SDMMC_D1;
-    slot_config.d2                  = GPIO_SDMMC_D2;
-    slot_config.d3                  = GPIO_SDMMC_D3;
-    // slot_config.cd = GPIO_SDMMC_DET;
-    // slot_config.flags |= SDMMC_SLOT_FLAG_INTERNAL_PULLUP;
+    *slot_config       = (sdmmc_slot_config_t)SDMMC_SLOT_CONFIG_DEFAULT();
+    slot_config->width = SDMMC_BUS_WIDTH;
+    slot_config->clk   = GPIO_SDMMC_CLK;
+    slot_config->cmd   = GPIO_SDMMC_CMD;
+    slot_config->d0    = GPIO_SDMMC_D0;
+    slot_config->d1    = GPIO_SDMMC_D1;
+    slot_config->d2    = GPIO_SDMMC_D2;
+    slot_config->d3    = GPIO_SDMMC_D3;
+    // slot_config->cd = GPIO_SDMMC_DET;
+    // slot_config->flags |= SDMMC_SLOT_FLAG_INTERNAL_PULLUP;
+    return ESP_OK;
+}
+
+esp_err_t bsp_sdcard_init(char* mount_point, size_t max_files)
+{
+    esp_err_t ret_val = ESP_OK;
+
+    if (NULL != card) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    /**
+     * @brief Use settings defined above to initialize SD card and mount FAT filesystem.
+     *   Note: esp_vfs_fat_sdmmc/sdspi_mount is all-in-one convenience functions.
+     *   Please check its source code and implement error recovery when developing
+     *   production applications.
+     *
+     */
+    sdmmc_host_t host;
+    sdmmc_slot_config_t slot_config;
+    ret_val = bsp_sdcard_host_config(&host, &slot_config);
+    if (ret_val != ESP_OK) {
+        return ret_val;
+    }
 
     /**
      * @brief Options for mounting the filesystem.
@@ -628,6 +779,13 @@ esp_err_t bsp_sdcard_init(char* mount_point, size_t max_files)
         .format_if_mount_failed = false, .max_files = max_files, .allocation_unit_size = 16 * 1024};
 
     ret_val = esp_vfs_fat_sdmmc_mount(mount_point, &host, &slot_config, &mount_config, &card);
+    if (ret_val != ESP_OK && ret_val != ESP_FAIL) {
+        /* Card or wiring that can't hold 40 MHz: a 20 MHz bus beats no card */
+        ESP_LOGW(TAG, "High-speed init failed (%s), retrying at %d kHz", esp_err_to_name(ret_val),
+                 SDMMC_FREQ_DEFAULT);
+        host.max_freq_khz = SDMMC_FREQ_DEFAULT;
+        ret_val           = esp_vfs_fat_sdmmc_mount(mount_point, &host, &slot_config, &mount_config, &card);
+    }
 
     /* Check for SDMMC mount result. */
     if (ret_val != ESP_OK) {
@@ -650,9 +808,68 @@ esp_err_t bsp_sdcard_init(char* mount_point, size_t max_files)
     return ret_val;
 }
 
+esp_err_t bsp_sdcard_raw_init(sdmmc_card_t** out_card)
+{
+    if (NULL == out_card) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (NULL != card) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    sdmmc_host_t host;
+    sdmmc_slot_config_t slot_config;
+    esp_err_t ret_val = bsp_sdcard_host_config(&host, &slot_config);
+    if (ret_val != ESP_OK) {
+        return ret_val;
+    }
+    sdmmc_card_t* raw = calloc(1, sizeof(sdmmc_card_t));
+    if (NULL == raw) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    ret_val = host.init();
+    if (ret_val == ESP_OK) {
+        ret_val = sdmmc_host_init_slot(host.slot, &slot_config);
+    }
+    if (ret_val == ESP_OK) {
+        ret_val = sdmmc_card_init(&host, raw);
+        if (ret_val != ESP_OK) {
+            /* Same fallback as the FAT mount */
+            ESP_LOGW(TAG, "High-speed init failed (%s), retrying at %d kHz", esp_err_to_name(ret_val),
+                     SDMMC_FREQ_DEFAULT);
+            host.max_freq_khz = SDMMC_FREQ_DEFAULT;
+            ret_val           = sdmmc_card_init(&host, raw);
+        }
+    }
+    if (ret_val != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize the card (%s)", esp_err_to_name(ret_val));
+        host.deinit();
+        free(raw);
+        return ret_val;
+    }
+
+    card      = raw;
+    card_raw  = true;
+    *out_card = raw;
+    return ESP_OK;
+}
+
+esp_err_t bsp_sdcard_raw_deinit(void)
+{
+    if (NULL == card || !card_raw) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t ret_val = card->host.deinit();
+    free(card);
+    card     = NULL;
+    card_raw = false;
+    return ret_val;
+}
+
 esp_err_t bsp_sdcard_deinit(char* mount_point)
 {
-    if (mount_point == NULL) {
+    if (mount_point == NULL || card_raw) {
         return ESP_ERR_INVALID_STATE;
     }
 
@@ -670,6 +887,24 @@ esp_err_t bsp_sdcard_deinit(char* mount_point)
     return ret_val;
 }
 
+esp_err_t bsp_sdcard_get_status(void)
+{
+    if (NULL == card) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return sdmmc_get_status(card);
+}
+
+esp_err_t bsp_sdcard_get_bus_info(uint32_t* freq_khz, uint8_t* bus_width)
+{
+    if (NULL == card || NULL == freq_khz || NULL == bus_width) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    *freq_khz  = card->real_freq_khz;
+    *bus_width = card->log_bus_width == 2 ? 4 : (card->log_bus_width == 3 ? 8 : 1);
+    return ESP_OK;
+}
+
 //==================================================================================
 // spiffs
 //==================================================================================
@@ -714,6 +949,22 @@ static esp_codec_dev_handle_t record_dev_handle;
 static bsp_codec_config_t g_codec_handle;
 static int volume;
 
+/* Raw register access for the power states esp_codec_dev has no call for */
+static const audio_codec_if_t* s_es8388_if;
+static const audio_codec_if_t* s_es7210_if;
+static bool s_output_off; /* set_output_power(false) holds; put back after a reopen */
+
+/* ES7210: MICx bias/PGA/ADC power at 0x47 + x - 1 (0x08 up, 0xFF down), pair ADC power MIC1/2 and MIC3/4 */
+#define ES7210_REG_MIC1_POWER  (0x47)
+#define ES7210_REG_MIC12_POWER (0x4B)
+#define ES7210_REG_MIC34_POWER (0x4C)
+#define ES7210_POWER_DOWN      (0xFF)
+/* ES8388 DACPOWER: bits 7:6 power the DACs down, bits 5:2 enable LOUT1/ROUT1/LOUT2/ROUT2 */
+#define ES8388_REG_DACPOWER    (0x04)
+#define ES8388_DACPOWER_ON     (0x3C)
+#define ES8388_DACPOWER_DAC    (0x00) /* DACs up, drivers off */
+#define ES8388_DACPOWER_OFF    (0xC0)
+
 /* Can be used for `i2s_std_gpio_config_t` and/or `i2s_std_config_t` initialization */
 #define BSP_I2S_GPIO_CFG                                                                                           \
     {                                                                                                              \
@@ -733,6 +984,199 @@ static int volume;
         .gpio_cfg = BSP_I2S_GPIO_CFG,                                                                 \
     }
 
+/* ES7210 TDM capture: the bus always carries 4 slots, slot_mask picks the ones DMA stores */
+#define BSP_ES7210_TDM_SLOT_CFG(_bits, _mask)            \
+    {                                                    \
+        .data_bit_width = (_bits),                       \
+        .slot_bit_width = I2S_SLOT_BIT_WIDTH_AUTO,       \
+        .slot_mode      = I2S_SLOT_MODE_STEREO,          \
+        .slot_mask      = (i2s_tdm_slot_mask_t)(_mask),  \
+        .ws_width       = I2S_TDM_AUTO_WS_WIDTH,         \
+        .ws_pol         = false,                         \
+        .bit_shift      = true,                          \
+        .left_align     = false,                         \
+        .big_endian     = false,                         \
+        .bit_order_lsb  = false,                         \
+        .skip_mask      = false,                         \
+        .total_slot     = 4,                             \
+    }
+
+static IRAM_ATTR bool bsp_i2s_on_recv_q_ovf(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx)
+{
+    /* While streaming nobody drains the driver's queue, so it overflows by design */
+    if (!i2s_streaming) {
+        i2s_rx_q_ovf_count = i2s_rx_q_ovf_count + 1;
+    }
+    return false;
+}
+
+static IRAM_ATTR bool bsp_i2s_on_send_q_ovf(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx)
+{
+    if (!i2s_streaming) {
+        i2s_tx_q_ovf_count = i2s_tx_q_ovf_count + 1;
+    }
+    return false;
+}
+
+static IRAM_ATTR void bsp_i2s_stream_push(bsp_i2s_stream_ring_t* ring, void* buf, int64_t done_us, size_t size)
+{
+    uint32_t head                                   = ring->head;
+    ring->buf[head & (BSP_I2S_STREAM_RING - 1)]     = buf;
+    ring->done_us[head & (BSP_I2S_STREAM_RING - 1)] = done_us;
+    ring->size                                      = size;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+static IRAM_ATTR bool bsp_i2s_on_recv(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx)
+{
+    if (!i2s_streaming) {
+        return false;
+    }
+    bsp_i2s_stream_push(&i2s_rx_ring, event->dma_buf, esp_timer_get_time(), event->size);
+
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(i2s_stream_task, &woken);
+    return woken == pdTRUE;
+}
+
+static IRAM_ATTR bool bsp_i2s_on_sent(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx)
+{
+    if (!i2s_streaming) {
+        return false;
+    }
+    /* auto_clear wipes the buffer just sent right after this callback returns, which can race
+     * the consumer on the other core. Hand out the one sent before, long since cleared. */
+    const int64_t now_us  = esp_timer_get_time();
+    void* prev            = i2s_tx_last_sent;
+    const int64_t prev_us = i2s_tx_last_sent_us;
+    i2s_tx_last_sent      = event->dma_buf;
+    i2s_tx_last_sent_us   = now_us;
+    if (prev == NULL) {
+        return false;
+    }
+    bsp_i2s_stream_push(&i2s_tx_ring, prev, prev_us, event->size);
+
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(i2s_tx_ready, &woken);
+    return woken == pdTRUE;
+}
+
+/* Oldest buffer still safe to touch, false on timeout. A buffer more than DESC_NUM - 2
+ * places behind the newest is being reused by the DMA already and is skipped. */
+static bool bsp_i2s_stream_pop(bsp_i2s_stream_ring_t* ring, volatile uint32_t* overflows, bool rx,
+                               uint32_t timeout_ms, bsp_i2s_stream_buf_t* out)
+{
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    while (head == ring->tail) {
+        const BaseType_t got = rx ? (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms)) != 0)
+                                  : xSemaphoreTake(i2s_tx_ready, pdMS_TO_TICKS(timeout_ms));
+        if (got != pdTRUE) {
+            return false;
+        }
+        head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    }
+    const uint32_t keep = BSP_I2S_DMA_DESC_NUM - 2;
+    if (head - ring->tail > keep) {
+        *overflows = *overflows + (head - ring->tail - keep);
+        ring->tail = head - keep;
+    }
+    const uint32_t slot = ring->tail & (BSP_I2S_STREAM_RING - 1);
+    out->data           = (int16_t*)ring->buf[slot];
+    out->done_us        = ring->done_us[slot];
+    ring->tail++;
+    out->pending = head - ring->tail;
+    return true;
+}
+
+esp_err_t bsp_i2s_stream_start(void)
+{
+    if (i2s_rx_chan == NULL || i2s_tx_chan == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (i2s_tx_ready == NULL) {
+        i2s_tx_ready = xSemaphoreCreateBinary();
+        if (i2s_tx_ready == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    /* Drop anything left from an earlier session; the ISR only pushes while streaming */
+    i2s_streaming       = false;
+    i2s_stream_task     = xTaskGetCurrentTaskHandle();
+    i2s_rx_ring.tail    = i2s_rx_ring.head;
+    i2s_tx_ring.tail    = i2s_tx_ring.head;
+    i2s_tx_last_sent    = NULL;
+    i2s_tx_last_sent_us = 0;
+    ulTaskNotifyTake(pdTRUE, 0);
+    xSemaphoreTake(i2s_tx_ready, 0);
+    i2s_streaming = true;
+    return ESP_OK;
+}
+
+void bsp_i2s_stream_stop(void)
+{
+    i2s_streaming = false;
+}
+
+bool bsp_i2s_stream_rx_acquire(bsp_i2s_stream_buf_t* buf, uint32_t timeout_ms)
+{
+    if (!bsp_i2s_stream_pop(&i2s_rx_ring, &i2s_rx_q_ovf_count, true, timeout_ms, buf)) {
+        return false;
+    }
+#if SOC_CACHE_INTERNAL_MEM_VIA_L1CACHE
+    /* Same as the driver's read path: drop stale lines before the CPU looks at DMA data */
+    esp_cache_msync(buf->data, i2s_rx_ring.size, ESP_CACHE_MSYNC_FLAG_INVALIDATE);
+#endif
+    return true;
+}
+
+bool bsp_i2s_stream_tx_acquire(bsp_i2s_stream_buf_t* buf, uint32_t timeout_ms)
+{
+    if (!bsp_i2s_stream_pop(&i2s_tx_ring, &i2s_tx_q_ovf_count, false, timeout_ms, buf)) {
+        /* Nothing to write into: this buffer's worth of output is lost */
+        i2s_tx_q_ovf_count = i2s_tx_q_ovf_count + 1;
+        return false;
+    }
+    return true;
+}
+
+void bsp_i2s_stream_tx_commit(int16_t* buf)
+{
+#if SOC_CACHE_INTERNAL_MEM_VIA_L1CACHE
+    /* Same as the driver's write path: the DMA reads memory, not the cache */
+    esp_cache_msync(buf, i2s_tx_ring.size, ESP_CACHE_MSYNC_FLAG_DIR_C2M);
+#else
+    (void)buf;
+#endif
+}
+
+void bsp_i2s_get_xrun_counts(bsp_i2s_xrun_counts_t* counts)
+{
+    counts->rx_overflows = i2s_rx_q_ovf_count;
+    counts->tx_overflows = i2s_tx_q_ovf_count;
+}
+
+esp_err_t bsp_i2s_reset(void)
+{
+    ESP_RETURN_ON_FALSE(i2s_rx_chan != NULL && i2s_tx_chan != NULL, ESP_ERR_INVALID_STATE, TAG, "I2S not initialized");
+    ESP_RETURN_ON_FALSE(!i2s_streaming, ESP_ERR_INVALID_STATE, TAG, "stop the stream first");
+
+    /* RX may be off already (capture disabled): it stays off then */
+    esp_err_t ret = i2s_channel_disable(i2s_rx_chan);
+    ESP_RETURN_ON_FALSE(ret == ESP_OK || ret == ESP_ERR_INVALID_STATE, ret, TAG, "RX disable failed");
+    const bool rx_on = ret == ESP_OK;
+    ret = i2s_channel_disable(i2s_tx_chan);
+    ESP_RETURN_ON_FALSE(ret == ESP_OK || ret == ESP_ERR_INVALID_STATE, ret, TAG, "TX disable failed");
+
+    /* TX first: it drives the clock both directions run on */
+    ESP_RETURN_ON_ERROR(i2s_channel_enable(i2s_tx_chan), TAG, "TX enable failed");
+    if (rx_on) {
+        ESP_RETURN_ON_ERROR(i2s_channel_enable(i2s_rx_chan), TAG, "RX enable failed");
+    }
+    ESP_LOGI(TAG, "I2S channels restarted");
+    return ESP_OK;
+}
+
 esp_err_t bsp_audio_init(const i2s_std_config_t* i2s_config)
 {
     if (i2s_tx_chan && i2s_rx_chan) {
@@ -743,6 +1187,8 @@ esp_err_t bsp_audio_init(const i2s_std_config_t* i2s_config)
     /* Setup I2S peripheral */
     i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(CONFIG_BSP_I2S_NUM, I2S_ROLE_MASTER);
     chan_cfg.auto_clear        = true;  // Auto clear the legacy data in the DMA buffer
+    chan_cfg.dma_desc_num      = BSP_I2S_DMA_DESC_NUM;
+    chan_cfg.dma_frame_num     = BSP_I2S_DMA_FRAME_NUM;
     ESP_ERROR_CHECK(i2s_new_channel(&chan_cfg, &i2s_tx_chan, &i2s_rx_chan));
 
     /* Setup I2S channels */
@@ -755,6 +1201,12 @@ esp_err_t bsp_audio_init(const i2s_std_config_t* i2s_config)
 
     if (i2s_tx_chan != NULL) {
         ESP_ERROR_CHECK(i2s_channel_init_std_mode(i2s_tx_chan, p_i2s_cfg));
+        // Callbacks can only be registered before the channel is enabled
+        const i2s_event_callbacks_t tx_cbs = {
+            .on_sent       = bsp_i2s_on_sent,
+            .on_send_q_ovf = bsp_i2s_on_send_q_ovf,
+        };
+        ESP_ERROR_CHECK(i2s_channel_register_event_callback(i2s_tx_chan, &tx_cbs, NULL));
         ESP_ERROR_CHECK(i2s_channel_enable(i2s_tx_chan));
     }
 
@@ -772,23 +1224,17 @@ esp_err_t bsp_audio_init(const i2s_std_config_t* i2s_config)
                 .mclk_multiple   = I2S_MCLK_MULTIPLE_256,
                 .bclk_div        = 8,
             },
-        .slot_cfg = {.data_bit_width = I2S_DATA_BIT_WIDTH_16BIT,
-                     .slot_bit_width = I2S_SLOT_BIT_WIDTH_AUTO,
-                     .slot_mode      = I2S_SLOT_MODE_STEREO,
-                     .slot_mask      = (I2S_TDM_SLOT0 | I2S_TDM_SLOT1 | I2S_TDM_SLOT2 | I2S_TDM_SLOT3),
-                     .ws_width       = I2S_TDM_AUTO_WS_WIDTH,
-                     .ws_pol         = false,
-                     .bit_shift      = true,
-                     .left_align     = false,
-                     .big_endian     = false,
-                     .bit_order_lsb  = false,
-                     .skip_mask      = false,
-                     .total_slot     = I2S_TDM_AUTO_SLOT_NUM},
+        .slot_cfg = BSP_ES7210_TDM_SLOT_CFG(I2S_DATA_BIT_WIDTH_16BIT, BSP_CAPTURE_SLOTS_ALL),
         .gpio_cfg = BSP_I2S_GPIO_CFG,
     };
 
     if (i2s_rx_chan != NULL) {
         ESP_ERROR_CHECK(i2s_channel_init_tdm_mode(i2s_rx_chan, &tdm_cfg));
+        const i2s_event_callbacks_t rx_cbs = {
+            .on_recv       = bsp_i2s_on_recv,
+            .on_recv_q_ovf = bsp_i2s_on_recv_q_ovf,
+        };
+        ESP_ERROR_CHECK(i2s_channel_register_event_callback(i2s_rx_chan, &rx_cbs, NULL));
         ESP_ERROR_CHECK(i2s_channel_enable(i2s_rx_chan));
     }
 
@@ -841,6 +1287,7 @@ esp_codec_dev_handle_t bsp_audio_codec_speaker_init(void)
     };
     const audio_codec_if_t* es8388_dev = es8388_codec_new(&es8388_cfg);
     BSP_NULL_CHECK(es8388_dev, NULL);
+    s_es8388_if = es8388_dev;
 
     esp_codec_dev_cfg_t codec_dev_cfg = {
         .dev_type = ESP_CODEC_DEV_TYPE_OUT,
@@ -879,6 +1326,7 @@ esp_codec_dev_handle_t bsp_audio_codec_microphone_init(void)
     es7210_cfg.mic_selected            = ES7210_SEL_MIC1 | ES7210_SEL_MIC2 | ES7210_SEL_MIC3 | ES7210_SEL_MIC4;
     const audio_codec_if_t* es7210_dev = es7210_codec_new(&es7210_cfg);
     BSP_NULL_CHECK(es7210_dev, NULL);
+    s_es7210_if = es7210_dev;
 
     esp_codec_dev_cfg_t codec_es7210_dev_cfg = {
         .dev_type =
@@ -890,12 +1338,11 @@ esp_codec_dev_handle_t bsp_audio_codec_microphone_init(void)
     return esp_codec_dev_new(&codec_es7210_dev_cfg);
 }
 
+/* Straight from the RX channel, so a stalled codec returns after timeout_ms with what arrived */
 static esp_err_t bsp_i2s_read(void* audio_buffer, size_t len, size_t* bytes_read, uint32_t timeout_ms)
 {
-    esp_err_t ret = ESP_OK;
-    ret           = esp_codec_dev_read(record_dev_handle, audio_buffer, len);
-    *bytes_read   = len;
-    return ret;
+    *bytes_read = 0;
+    return i2s_channel_read(i2s_rx_chan, audio_buffer, len, bytes_read, timeout_ms);
 }
 
 static esp_err_t bsp_i2s_write(void* audio_buffer, size_t len, size_t* bytes_written, uint32_t timeout_ms)
@@ -906,15 +1353,21 @@ static esp_err_t bsp_i2s_write(void* audio_buffer, size_t len, size_t* bytes_wri
     return ret;
 }
 
+/* Codec register traffic goes first on the shared bus; it has to land within the audio block it was meant for */
 static esp_err_t bsp_codec_set_in_gain(float gain)
 {
-    return esp_codec_dev_set_in_gain(record_dev_handle, gain);
+    ESP_RETURN_ON_ERROR(bsp_i2c_acquire(BSP_I2C_CLASS_CODEC, BSP_I2C_WAIT_FOREVER), TAG, "i2c bus");
+    esp_err_t ret = esp_codec_dev_set_in_gain(record_dev_handle, gain);
+    bsp_i2c_release(BSP_I2C_CLASS_CODEC);
+    return ret;
 }
 
 static esp_err_t bsp_codec_set_mute(bool enable)
 {
     esp_err_t ret = ESP_OK;
-    ret           = esp_codec_dev_set_out_mute(play_dev_handle, enable);
+    ESP_RETURN_ON_ERROR(bsp_i2c_acquire(BSP_I2C_CLASS_CODEC, BSP_I2C_WAIT_FOREVER), TAG, "i2c bus");
+    ret = esp_codec_dev_set_out_mute(play_dev_handle, enable);
+    bsp_i2c_release(BSP_I2C_CLASS_CODEC);
     return ret;
 }
 
@@ -922,6 +1375,7 @@ static esp_err_t bsp_codec_set_volume(int v)
 {
     esp_err_t ret = ESP_OK;
 
+    ESP_RETURN_ON_ERROR(bsp_i2c_acquire(BSP_I2C_CLASS_CODEC, BSP_I2C_WAIT_FOREVER), TAG, "i2c bus");
     if (v <= 0) {
         volume = 0;
         ret    = esp_codec_dev_set_out_mute(play_dev_handle, true);
@@ -930,6 +1384,7 @@ static esp_err_t bsp_codec_set_volume(int v)
         ret    = esp_codec_dev_set_out_mute(play_dev_handle, false);
         ret |= esp_codec_dev_set_out_vol(play_dev_handle, volume);
     }
+    bsp_i2c_release(BSP_I2C_CLASS_CODEC);
 
     return ret;
 }
@@ -954,14 +1409,25 @@ static esp_err_t bsp_codec_es8388_set(uint32_t rate, uint32_t bps, i2s_slot_mode
         .bits_per_sample = bps,
     };
 
+    ESP_RETURN_ON_ERROR(bsp_i2c_acquire(BSP_I2C_CLASS_CODEC, BSP_I2C_WAIT_FOREVER), TAG, "i2c bus");
     if (play_dev_handle) {
         ret = esp_codec_dev_close(play_dev_handle);
     }
     ret = esp_codec_dev_open(play_dev_handle, &fs);
+    /* Opening powers the output stage up; an output that was off stays off */
+    if (ret == ESP_OK && s_output_off && s_es8388_if) {
+        ret = s_es8388_if->set_reg(s_es8388_if, ES8388_REG_DACPOWER, ES8388_DACPOWER_OFF) == ESP_CODEC_DEV_OK
+                  ? ESP_OK
+                  : ESP_FAIL;
+    }
+    bsp_i2c_release(BSP_I2C_CLASS_CODEC);
 
     return ret;
 }
 
+/* Rate the ES7210 was last opened at; capture profile changes and power-up keep it */
+static uint32_t s_capture_rate = 48000;
+
 static esp_err_t bsp_codec_es7210_set(uint32_t rate, uint32_t bps, i2s_slot_mode_t ch)
 {
     esp_err_t ret = ESP_OK;
@@ -972,16 +1438,136 @@ static esp_err_t bsp_codec_es7210_set(uint32_t rate, uint32_t bps, i2s_slot_mode
         .bits_per_sample = bps,
     };
 
+    ESP_RETURN_ON_ERROR(bsp_i2c_acquire(BSP_I2C_CLASS_CODEC, BSP_I2C_WAIT_FOREVER), TAG, "i2c bus");
     if (record_dev_handle) {
         ret = esp_codec_dev_close(record_dev_handle);
     }
     ret = esp_codec_dev_open(record_dev_handle, &fs);
+    bsp_i2c_release(BSP_I2C_CLASS_CODEC);
+    if (ret == ESP_OK) {
+        s_capture_rate = rate;
+    }
 
     // esp_codec_dev_set_in_gain(record_dev_handle, 80.0); // Set codec input gain
 
     return ret;
 }
 
+/* Power down the ES7210 mics outside slot_mask, after an open has powered all four up. Caller holds the bus */
+static esp_err_t bsp_es7210_power_slots(uint8_t slot_mask)
+{
+    int ret = ESP_CODEC_DEV_OK;
+    for (int i = 0; i < 4; i++) {
+        if (!(slot_mask & (1 << i))) {
+            ret |= s_es7210_if->set_reg(s_es7210_if, ES7210_REG_MIC1_POWER + i, ES7210_POWER_DOWN);
+        }
+    }
+    if (!(slot_mask & 0x03)) {
+        ret |= s_es7210_if->set_reg(s_es7210_if, ES7210_REG_MIC12_POWER, ES7210_POWER_DOWN);
+    }
+    if (!(slot_mask & 0x0C)) {
+        ret |= s_es7210_if->set_reg(s_es7210_if, ES7210_REG_MIC34_POWER, ES7210_POWER_DOWN);
+    }
+    return ret == ESP_CODEC_DEV_OK ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t bsp_codec_set_capture_profile(const bsp_capture_profile_t* profile)
+{
+    ESP_RETURN_ON_FALSE(profile != NULL, ESP_ERR_INVALID_ARG, TAG, "no capture profile");
+    ESP_RETURN_ON_FALSE(profile->slot_mask != 0 && (profile->slot_mask & ~BSP_CAPTURE_SLOTS_ALL) == 0,
+                        ESP_ERR_INVALID_ARG, TAG, "invalid capture slot mask 0x%x", profile->slot_mask);
+    ESP_RETURN_ON_FALSE(profile->bits == 16 || profile->bits == 24 || profile->bits == 32, ESP_ERR_INVALID_ARG, TAG,
+                        "unsupported capture bits %d", profile->bits);
+    ESP_RETURN_ON_FALSE(i2s_rx_chan != NULL && record_dev_handle != NULL, ESP_ERR_INVALID_STATE, TAG,
+                        "codec not initialized");
+
+    /* 24-bit samples travel in 32-bit TDM words, the ES7210 has no 24-bit slot framing */
+    const uint32_t bits = profile->bits == 16 ? 16 : 32;
+
+    /* Codec and I2S at the new word length with all four slots, as esp_codec_dev expects */
+    ESP_RETURN_ON_ERROR(bsp_codec_es7210_set(s_capture_rate, bits, 4), TAG, "ES7210 reconfig failed");
+
+    /* Then keep only the wanted slots in DMA memory; the bus framing stays at four slots */
+    const i2s_tdm_slot_config_t slot_cfg = BSP_ES7210_TDM_SLOT_CFG(bits, profile->slot_mask);
+    ESP_RETURN_ON_ERROR(i2s_channel_disable(i2s_rx_chan), TAG, "RX disable failed");
+    esp_err_t ret = i2s_channel_reconfig_tdm_slot(i2s_rx_chan, &slot_cfg);
+    ESP_RETURN_ON_ERROR(i2s_channel_enable(i2s_rx_chan), TAG, "RX enable failed");
+    ESP_RETURN_ON_ERROR(ret, TAG, "RX slot reconfig failed");
+
+    /* Mics no slot is stored for only draw current; a failure here leaves them on, harmlessly */
+    if (profile->slot_mask != BSP_CAPTURE_SLOTS_ALL && s_es7210_if) {
+        ESP_RETURN_ON_ERROR(bsp_i2c_acquire(BSP_I2C_CLASS_CODEC, BSP_I2C_WAIT_FOREVER), TAG, "i2c bus");
+        ret = bsp_es7210_power_slots(profile->slot_mask);
+        bsp_i2c_release(BSP_I2C_CLASS_CODEC);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "ES7210 unused mic power-down failed");
+        }
+    }
+
+    ESP_LOGI(TAG, "capture profile: slots 0x%x, %d-bit", profile->slot_mask, (int)bits);
+    return ESP_OK;
+}
+
+static esp_err_t bsp_codec_set_capture_enabled(bool enable)
+{
+    ESP_RETURN_ON_FALSE(i2s_rx_chan != NULL && record_dev_handle != NULL, ESP_ERR_INVALID_STATE, TAG,
+                        "codec not initialized");
+
+    if (!enable) {
+        /* Closing the device puts the ES7210 in standby; the RX channel may already be off then */
+        ESP_RETURN_ON_ERROR(bsp_i2c_acquire(BSP_I2C_CLASS_CODEC, BSP_I2C_WAIT_FOREVER), TAG, "i2c bus");
+        esp_err_t ret = esp_codec_dev_close(record_dev_handle);
+        bsp_i2c_release(BSP_I2C_CLASS_CODEC);
+        ESP_RETURN_ON_FALSE(ret == ESP_CODEC_DEV_OK, ESP_FAIL, TAG, "ES7210 close failed");
+        ret = i2s_channel_disable(i2s_rx_chan);
+        ESP_RETURN_ON_FALSE(ret == ESP_OK || ret == ESP_ERR_INVALID_STATE, ret, TAG, "RX disable failed");
+        ESP_LOGI(TAG, "capture off");
+        return ESP_OK;
+    }
+
+    ESP_RETURN_ON_ERROR(bsp_codec_es7210_set(s_capture_rate, 16, 4), TAG, "ES7210 reopen failed");
+    const i2s_tdm_slot_config_t slot_cfg = BSP_ES7210_TDM_SLOT_CFG(I2S_DATA_BIT_WIDTH_16BIT, BSP_CAPTURE_SLOTS_ALL);
+    esp_err_t ret = i2s_channel_disable(i2s_rx_chan);
+    ESP_RETURN_ON_FALSE(ret == ESP_OK || ret == ESP_ERR_INVALID_STATE, ret, TAG, "RX disable failed");
+    ret = i2s_channel_reconfig_tdm_slot(i2s_rx_chan, &slot_cfg);
+    ESP_RETURN_ON_ERROR(i2s_channel_enable(i2s_rx_chan), TAG, "RX enable failed");
+    ESP_RETURN_ON_ERROR(ret, TAG, "RX slot reconfig failed");
+    ESP_LOGI(TAG, "capture on");
+    return ESP_OK;
+}
+
+/* The bus is let go over the ramp waits; the DAC stays muted throughout, so nothing on it can pop */
+static esp_err_t bsp_codec_set_output_power(bool on)
+{
+    ESP_RETURN_ON_FALSE(play_dev_handle != NULL && s_es8388_if != NULL, ESP_ERR_INVALID_STATE, TAG,
+                        "codec not initialized");
+
+    int ret = ESP_CODEC_DEV_OK;
+    ESP_RETURN_ON_ERROR(bsp_i2c_acquire(BSP_I2C_CLASS_CODEC, BSP_I2C_WAIT_FOREVER), TAG, "i2c bus");
+    ret |= esp_codec_dev_set_out_mute(play_dev_handle, true);
+    if (on) {
+        ret |= s_es8388_if->set_reg(s_es8388_if, ES8388_REG_DACPOWER, ES8388_DACPOWER_DAC);
+    }
+    bsp_i2c_release(BSP_I2C_CLASS_CODEC);
+
+    /* Off: the soft-mute ramp runs out into live drivers. On: the DAC outputs settle at mid-rail */
+    vTaskDelay(pdMS_TO_TICKS(BSP_CODEC_OUTPUT_RAMP_MS));
+
+    ESP_RETURN_ON_ERROR(bsp_i2c_acquire(BSP_I2C_CLASS_CODEC, BSP_I2C_WAIT_FOREVER), TAG, "i2c bus");
+    if (on) {
+        ret |= s_es8388_if->set_reg(s_es8388_if, ES8388_REG_DACPOWER, ES8388_DACPOWER_ON);
+    } else {
+        ret |= s_es8388_if->set_reg(s_es8388_if, ES8388_REG_DACPOWER, ES8388_DACPOWER_DAC);
+        ret |= s_es8388_if->set_reg(s_es8388_if, ES8388_REG_DACPOWER, ES8388_DACPOWER_OFF);
+    }
+    bsp_i2c_release(BSP_I2C_CLASS_CODEC);
+    ESP_RETURN_ON_FALSE(ret == ESP_CODEC_DEV_OK, ESP_FAIL, TAG, "ES8388 output power %s failed", on ? "up" : "down");
+
+    s_output_off = !on;
+    ESP_LOGI(TAG, "output stage %s", on ? "on" : "off");
+    return ESP_OK;
+}
+
 void bsp_codec_init(void)
 {
     play_dev_handle = bsp_audio_codec_speaker_init();
@@ -1006,6 +1592,9 @@ void bsp_codec_init(void)
     codec_cfg->set_in_gain         = bsp_codec_set_in_gain;  // 麦克风输入增益设置
     codec_cfg->codec_reconfig_fn   = bsp_codec_es7210_set;
     codec_cfg->i2s_reconfig_clk_fn = bsp_codec_es8388_set;
+    codec_cfg->set_capture_profile = bsp_codec_set_capture_profile;
+    codec_cfg->set_capture_enabled = bsp_codec_set_capture_enabled;
+    codec_cfg->set_output_power    = bsp_codec_set_output_power;
 
     codec_cfg->set_volume(80);
 }
@@ -1190,7 +1779,7 @@ esp_err_t bsp_display_new_with_handles(const bsp_display_config_t* config, bsp_l
         .dpi_clk_src        = MIPI_DSI_DPI_CLK_SRC_DEFAULT,
         .dpi_clock_freq_mhz = 60,  // 720*1280 RGB24 60Hz RGB24 // 80,
         .pixel_format       = LCD_COLOR_PIXEL_FORMAT_RGB565,
-        .num_fbs            = 1,
+        .num_fbs            = CONFIG_BSP_LCD_DPI_BUFFER_NUMS,
         .video_timing =
             {
                 .h_size            = BSP_LCD_H_RES,
@@ -1236,7 +1825,7 @@ esp_err_t bsp_display_new_with_handles(const bsp_display_config_t* config, bsp_l
         .dpi_clk_src = MIPI_DSI_DPI_CLK_SRC_DEFAULT,
         .dpi_clock_freq_mhz = 60,                       // LCD_MIPI_DSI_DPI_CLK_MHZ_ST7703,
         .pixel_format = LCD_COLOR_PIXEL_FORMAT_RGB565,  // LCD_COLOR_PIXEL_FORMAT_RGB888,
-        .num_fbs = 1,
+        .num_fbs = CONFIG_BSP_LCD_DPI_BUFFER_NUMS,
         .video_timing =
             {
                 .h_size = BSP_LCD_H_RES,  // lcd_param.width,
@@ -1412,7 +2001,7 @@ esp_err_t bsp_display_new_with_handles_to_st7123(const bsp_display_config_t* con
         .dpi_clk_src        = MIPI_DSI_DPI_CLK_SRC_DEFAULT,
         .dpi_clock_freq_mhz = 70,  // ST7123 DPI clock frequency
         .pixel_format       = LCD_COLOR_PIXEL_FORMAT_RGB565,
-        .num_fbs            = 1,
+        .num_fbs            = CONFIG_BSP_LCD_DPI_BUFFER_NUMS,
         .video_timing =
             {
                 .h_size            = 720,
@@ -1527,6 +2116,7 @@ static lv_display_t* bsp_display_lcd_init(const bsp_display_cfg_t* cfg)
     } else {
         BSP_ERROR_CHECK_RETURN_NULL(bsp_display_new_with_handles(NULL, &lcd_panels));
     }
+    disp_panel_handle = lcd_panels.panel;
 
     /* Add LCD screen */
     ESP_LOGD(TAG, "Add LCD screen");
@@ -1577,6 +2167,7 @@ static lv_display_t* bsp_display_lcd_init(const bsp_display_cfg_t* cfg)
 #else
                                                      .avoid_tearing = false,
 #endif
+                                                     .ppa_direct = cfg->flags.ppa_direct,
                                                  }};
 
     return lvgl_port_add_disp_dsi(&disp_cfg, &dpi_cfg);
@@ -1589,29 +2180,156 @@ esp_lcd_touch_handle_t bsp_display_get_touch_handle(void)
     return _lcd_touch_handle;
 }
 
-static void lvgl_read_cb(lv_indev_t* indev, lv_indev_data_t* data)
-{
-    if (_lcd_touch_handle == NULL) {
-        data->state = LV_INDEV_STATE_REL;
-        return;
+/* GT911 pipeline: the INT line wakes a reader task (BSP_SERVICE_TASK_CORE), which does the I2C read and queues
+ * the sample. LVGL's read callback only drains the queue, so the LVGL task never waits on I2C and
+ * nothing reads the controller while the screen is untouched. Each queued sample also wakes the
+ * LVGL task, which reads the indev right away instead of on its next timer tick. */
+#define BSP_TOUCH_RING             16 /* Samples, power of two (~160 ms of 100 Hz reports) */
+#define BSP_TOUCH_POLL_MS          10 /* Without the INT line: controller report period */
+#define BSP_TOUCH_RELEASE_MS       50 /* Pressed and no report for this long: read anyway */
+#define BSP_TOUCH_PREDICT_MAX_US   30000
+#define BSP_TOUCH_TASK_PRIORITY    5 /* Above the LVGL task */
+
+typedef struct {
+    int16_t x;
+    int16_t y;
+    bool pressed;
+    int64_t t_us;
+} bsp_touch_sample_t;
+
+static bsp_touch_sample_t touch_ring[BSP_TOUCH_RING];
+static uint32_t touch_head; /* Written by the touch task */
+static uint32_t touch_tail; /* Written by the LVGL task */
+static TaskHandle_t touch_task;
+static bool touch_irq;
+static volatile bsp_touch_wake_cb_t touch_wake_cb; /* Set: touches go here instead of to LVGL */
+static bool touch_swallow;                          /* Touch task: the touch that woke is still down */
+
+/* LVGL task only: what the indev last reported, and the velocity estimate (px/us) */
+static bsp_touch_sample_t touch_cur;
+static float touch_vx;
+static float touch_vy;
+
+static void IRAM_ATTR bsp_touch_isr(esp_lcd_touch_handle_t tp)
+{
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(touch_task, &woken);
+    if (woken == pdTRUE) {
+        portYIELD_FROM_ISR();
     }
+}
 
-    uint16_t touch_x[1];
-    uint16_t touch_y[1];
-    uint16_t touch_strength[1];
-    uint8_t touch_cnt = 0;
+static void bsp_touch_task(void* arg)
+{
+    esp_lcd_touch_handle_t tp = (esp_lcd_touch_handle_t)arg;
+    bool queued_pressed       = false; /* State of the last queued sample */
 
-    esp_lcd_touch_read_data(_lcd_touch_handle);
-    bool touchpad_pressed =
-        esp_lcd_touch_get_coordinates(_lcd_touch_handle, touch_x, touch_y, touch_strength, &touch_cnt, 1);
+    /* Started once bsp_display_indev_init() has settled touch_irq */
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    for (;;) {
+        /* The GT911 pulses INT on every report while a finger is down and once on release;
+         * the timeout only covers a release edge that went missing */
+        TickType_t wait = queued_pressed || touch_swallow ? pdMS_TO_TICKS(BSP_TOUCH_RELEASE_MS) : portMAX_DELAY;
+        if (!touch_irq) {
+            wait = pdMS_TO_TICKS(BSP_TOUCH_POLL_MS);
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
 
-    if (!touchpad_pressed) {
-        data->state = LV_INDEV_STATE_REL;
-    } else {
-        data->state   = LV_INDEV_STATE_PR;
-        data->point.x = touch_x[0];
-        data->point.y = touch_y[0];
+        if (bsp_i2c_acquire(BSP_I2C_CLASS_TOUCH, BSP_TOUCH_RELEASE_MS) != ESP_OK) {
+            continue;
+        }
+        const esp_err_t read = esp_lcd_touch_read_data(tp);
+        bsp_i2c_release(BSP_I2C_CLASS_TOUCH);
+        if (read != ESP_OK) {
+            continue;
+        }
+        uint16_t x[1]   = {0};
+        uint16_t y[1]   = {0};
+        uint8_t cnt     = 0;
+        const bool down = esp_lcd_touch_get_coordinates(tp, x, y, NULL, &cnt, 1) && cnt > 0;
+        /* A wake touch never reaches LVGL, not even its tail after the callback is cleared */
+        const bsp_touch_wake_cb_t wake_cb = touch_wake_cb;
+        if (wake_cb || touch_swallow) {
+            if (down && wake_cb && !touch_swallow) {
+                wake_cb();
+            }
+            touch_swallow = down;
+            continue;
+        }
+        if (!down && !queued_pressed) {
+            continue;
+        }
+
+        /* Full: LVGL is stalled. Drop the sample; a release is retried on the next timeout */
+        const uint32_t head = touch_head;
+        if (head - __atomic_load_n(&touch_tail, __ATOMIC_ACQUIRE) >= BSP_TOUCH_RING) {
+            continue;
+        }
+        bsp_touch_sample_t* slot = &touch_ring[head & (BSP_TOUCH_RING - 1)];
+        slot->x                  = (int16_t)x[0];
+        slot->y                  = (int16_t)y[0];
+        slot->pressed            = down;
+        slot->t_us               = esp_timer_get_time();
+        __atomic_store_n(&touch_head, head + 1, __ATOMIC_RELEASE);
+        queued_pressed = down;
+
+        lvgl_port_task_wake(LVGL_PORT_EVENT_TOUCH, disp_indev);
+    }
+}
+
+#if CONFIG_BSP_TOUCH_PREDICT_MS > 0
+static int16_t bsp_touch_clamp(float v, int max)
+{
+    return (int16_t)(v < 0.0f ? 0.0f : (v > (float)(max - 1) ? (float)(max - 1) : v));
+}
+#endif
+
+/* Samples of one state are merged into the newest; a press or release is always reported on a
+ * read of its own (continue_reading), so a quick tap between two reads is not lost */
+static void lvgl_read_cb(lv_indev_t* indev, lv_indev_data_t* data)
+{
+    const uint32_t head = __atomic_load_n(&touch_head, __ATOMIC_ACQUIRE);
+    uint32_t tail       = touch_tail;
+    bool took           = false;
+    while (tail != head) {
+        const bsp_touch_sample_t s = touch_ring[tail & (BSP_TOUCH_RING - 1)];
+        if (took && s.pressed != touch_cur.pressed) {
+            break;
+        }
+        if (s.pressed && touch_cur.pressed && s.t_us > touch_cur.t_us) {
+            /* Half-and-half average of the per-report velocity */
+            const float dt = (float)(s.t_us - touch_cur.t_us);
+            touch_vx       = 0.5f * touch_vx + 0.5f * (float)(s.x - touch_cur.x) / dt;
+            touch_vy       = 0.5f * touch_vy + 0.5f * (float)(s.y - touch_cur.y) / dt;
+        } else if (s.pressed) {
+            touch_vx = touch_vy = 0.0f;
+        }
+        touch_cur = s;
+        tail++;
+        took = true;
+    }
+    __atomic_store_n(&touch_tail, tail, __ATOMIC_RELEASE);
+    data->continue_reading = tail != head;
+
+    if (!touch_cur.pressed) {
+        /* Releases land exactly where the finger was */
+        data->state   = LV_INDEV_STATE_REL;
+        data->point.x = touch_cur.x;
+        data->point.y = touch_cur.y;
+        return;
     }
+    data->state = LV_INDEV_STATE_PR;
+#if CONFIG_BSP_TOUCH_PREDICT_MS > 0
+    /* Extrapolate over the sample's age plus the configured lead; a stale sample is not moved */
+    const int64_t lead = esp_timer_get_time() - touch_cur.t_us + CONFIG_BSP_TOUCH_PREDICT_MS * 1000;
+    if (lead < BSP_TOUCH_PREDICT_MAX_US) {
+        data->point.x = bsp_touch_clamp(touch_cur.x + touch_vx * (float)lead, BSP_LCD_H_RES);
+        data->point.y = bsp_touch_clamp(touch_cur.y + touch_vy * (float)lead, BSP_LCD_V_RES);
+        return;
+    }
+#endif
+    data->point.x = touch_cur.x;
+    data->point.y = touch_cur.y;
 }
 
 static lv_indev_t* bsp_display_indev_init(lv_display_t* disp)
@@ -1622,11 +2340,27 @@ static lv_indev_t* bsp_display_indev_init(lv_display_t* disp)
     assert(tp);
     _lcd_touch_handle = tp;
 
+    /* The indev stays in timer mode: its periodic reads only look at the queue, and keep
+     * long-press and scroll-throw timing going between reports */
     disp_indev = lv_indev_create();
     lv_indev_set_type(disp_indev, LV_INDEV_TYPE_POINTER);
     lv_indev_set_read_cb(disp_indev, lvgl_read_cb);
     lv_indev_set_display(disp_indev, disp);
 
+    if (xTaskCreatePinnedToCore(bsp_touch_task, "touch", 3072, tp, BSP_TOUCH_TASK_PRIORITY, &touch_task,
+                                BSP_SERVICE_TASK_AFFINITY) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create touch task");
+        return disp_indev;
+    }
+#if CONFIG_BSP_TOUCH_INTERRUPT
+    touch_irq = tp->config.int_gpio_num != GPIO_NUM_NC &&
+                esp_lcd_touch_register_interrupt_callback(tp, bsp_touch_isr) == ESP_OK;
+#endif
+    if (!touch_irq) {
+        ESP_LOGW(TAG, "Touch INT unavailable, polling every %d ms", BSP_TOUCH_POLL_MS);
+    }
+    xTaskNotifyGive(touch_task);
+
     return disp_indev;
 }
 
@@ -1737,6 +2471,13 @@ lv_display_t* bsp_display_start_with_config(const bsp_display_cfg_t* cfg)
 
     BSP_NULL_CHECK(disp = bsp_display_lcd_init(cfg), NULL);
 
+#ifdef ESP_LVGL_PORT_PPA_DRAW
+    /* Large fills, blits (the camera canvas) and image blends on the PPA */
+    if (lvgl_port_ppa_draw_init(NULL) != ESP_OK) {
+        ESP_LOGW(TAG, "PPA draw unit not added, drawing on the CPU");
+    }
+#endif
+
     // 动态检测显示屏类型并初始化对应的触摸屏
     bsp_display_type_t display_type = bsp_detect_display_type();
 
@@ -1764,6 +2505,39 @@ bool bsp_display_lock(uint32_t timeout_ms)
     return lvgl_port_lock(timeout_ms);
 }
 
+esp_err_t bsp_display_sleep(bool sleep)
+{
+    if (disp_panel_handle == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    /* Display off before sleep in, sleep out before display on; the video stream keeps running */
+    esp_err_t ret = ESP_OK;
+    if (sleep) {
+        ret = esp_lcd_panel_disp_on_off(disp_panel_handle, false);
+    }
+    const esp_err_t slept = esp_lcd_panel_disp_sleep(disp_panel_handle, sleep);
+    if (slept != ESP_OK && slept != ESP_ERR_NOT_SUPPORTED) {
+        ret = slept;
+    }
+    if (!sleep) {
+        if (slept == ESP_OK) {
+            vTaskDelay(pdMS_TO_TICKS(120)); /* Sleep out to the next command (MIPI DCS) */
+        }
+        ret = esp_lcd_panel_disp_on_off(disp_panel_handle, true);
+    }
+    return ret;
+}
+
+esp_err_t bsp_display_set_touch_wake_cb(bsp_touch_wake_cb_t cb)
+{
+    if (touch_task == NULL) {
+        return ESP_ERR_NOT_SUPPORTED; /* ST7123: its touch is read by the LVGL port */
+    }
+    touch_wake_cb = cb;
+    xTaskNotifyGive(touch_task); /* Picks up a finger already down */
+    return ESP_OK;
+}
+
 void bsp_display_unlock(void)
 {
     lvgl_port_unlock();
@@ -1801,7 +2575,8 @@ esp_err_t bsp_usb_host_start(bsp_usb_host_power_mode_t mode, bool limit_500mA)
     BSP_ERROR_CHECK_RETURN_ERR(usb_host_install(&host_config));
 
     // Create a task that will handle USB library events
-    if (xTaskCreate(usb_lib_task, "usb_lib", 4096, NULL, 10, &usb_host_task) != pdTRUE) {
+    if (xTaskCreatePinnedToCore(usb_lib_task, "usb_lib", 4096, NULL, 10, &usb_host_task, BSP_SERVICE_TASK_AFFINITY) !=
+        pdTRUE) {
         ESP_LOGE(TAG, "Creating USB host lib task failed");
         abort();
     }
@@ -1818,3 +2593,43 @@ esp_err_t bsp_usb_host_stop(void)
     }
     return ESP_OK;
 }
+
+/* Data bus n is HP core n on both levels */
+#if defined(CACHE_L1_CACHE_ACS_CNT_CTRL_REG) && defined(CACHE_L2_CACHE_ACS_CNT_CTRL_REG) && \
+    defined(CACHE_L1_DBUS0_ACS_MISS_CNT_REG) && defined(CACHE_L1_DBUS1_ACS_MISS_CNT_REG) && \
+    defined(CACHE_L2_DBUS0_ACS_MISS_CNT_REG) && defined(CACHE_L2_DBUS1_ACS_MISS_CNT_REG)
+#define BSP_CACHE_COUNTERS 1
+#else
+#define BSP_CACHE_COUNTERS 0
+#endif
+
+esp_err_t bsp_cache_counters_start(void)
+{
+#if BSP_CACHE_COUNTERS
+    REG_SET_BIT(CACHE_L1_CACHE_ACS_CNT_CTRL_REG, CACHE_L1_DBUS0_CNT_ENA | CACHE_L1_DBUS1_CNT_ENA);
+    REG_SET_BIT(CACHE_L2_CACHE_ACS_CNT_CTRL_REG, CACHE_L2_DBUS0_CNT_ENA | CACHE_L2_DBUS1_CNT_ENA);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+void bsp_cache_counters_read(int core, bsp_cache_counts_t *counts)
+{
+#if BSP_CACHE_COUNTERS
+    if (core == 0) {
+        counts->l1_hit  = REG_READ(CACHE_L1_DBUS0_ACS_HIT_CNT_REG);
+        counts->l1_miss = REG_READ(CACHE_L1_DBUS0_ACS_MISS_CNT_REG);
+        counts->l2_hit  = REG_READ(CACHE_L2_DBUS0_ACS_HIT_CNT_REG);
+        counts->l2_miss = REG_READ(CACHE_L2_DBUS0_ACS_MISS_CNT_REG);
+    } else {
+        counts->l1_hit  = REG_READ(CACHE_L1_DBUS1_ACS_HIT_CNT_REG);
+        counts->l1_miss = REG_READ(CACHE_L1_DBUS1_ACS_MISS_CNT_REG);
+        counts->l2_hit  = REG_READ(CACHE_L2_DBUS1_ACS_HIT_CNT_REG);
+        counts->l2_miss = REG_READ(CACHE_L2_DBUS1_ACS_MISS_CNT_REG);
+    }
+#else
+    (void)core;
+    memset(counts, 0, sizeof(*counts));
+#endif
+}
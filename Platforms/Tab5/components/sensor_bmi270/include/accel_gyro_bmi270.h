@@ -17,6 +17,16 @@ bool accel_gyro_bmi270_check_irq(void);
 void accel_gyro_bmi270_clear_irq_int(void);
 bool accel_gyro_bmi270_motion_irq(void);
 
+/* FIFO: accel + gyro frames at the enable_sensor() ODR */
+#define BMI270_FIFO_FRAME_BYTES 13   /* Header, accel, gyro */
+#define BMI270_FIFO_MAX_FRAMES  64   /* Per accel_gyro_bmi270_fifo_read() */
+
+bool accel_gyro_bmi270_fifo_enable(uint16_t watermark_frames);
+void accel_gyro_bmi270_fifo_disable(void);
+/* Drains up to *count frames in a single burst read; *count is set to the frames read */
+bool accel_gyro_bmi270_fifo_read(struct bmi2_sens_axes_data *accel, struct bmi2_sens_axes_data *gyro,
+                                 uint16_t *count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -253,6 +253,75 @@ void accel_gyro_bmi270_get_data(struct bmi2_sens_data *data)
     bmi2_get_sensor_data(data, &bmi270);
 }
 
+/*
+ * Header mode, no sensor time frame, oldest frames dropped when full: whatever is
+ * read is whole accel + gyro frames, the newest ones.
+ */
+bool accel_gyro_bmi270_fifo_enable(uint16_t watermark_frames)
+{
+    if (i2c_dev_handle_bmi270 == NULL) {
+        ESP_LOGE(TAG, "i2c_dev_handle_bmi270 is NULL");
+        return false;
+    }
+
+    int8_t rslt = bmi2_set_fifo_config(BMI2_FIFO_ALL_EN | BMI2_FIFO_TIME_EN | BMI2_FIFO_STOP_ON_FULL, BMI2_DISABLE,
+                                       &bmi270);
+    if (rslt == BMI2_OK) {
+        rslt = bmi2_set_fifo_config(BMI2_FIFO_ACC_EN | BMI2_FIFO_GYR_EN | BMI2_FIFO_HEADER_EN, BMI2_ENABLE, &bmi270);
+    }
+    if (rslt == BMI2_OK) {
+        rslt = bmi2_set_fifo_wm(watermark_frames * BMI270_FIFO_FRAME_BYTES, &bmi270);
+    }
+    bmi2_error_codes_print_result(rslt);
+    return rslt == BMI2_OK;
+}
+
+void accel_gyro_bmi270_fifo_disable(void)
+{
+    if (i2c_dev_handle_bmi270 == NULL) {
+        return;
+    }
+    bmi2_error_codes_print_result(bmi2_set_fifo_config(BMI2_FIFO_ALL_EN, BMI2_DISABLE, &bmi270));
+}
+
+bool accel_gyro_bmi270_fifo_read(struct bmi2_sens_axes_data *accel, struct bmi2_sens_axes_data *gyro,
+                                 uint16_t *count)
+{
+    static uint8_t fifo_data[BMI270_FIFO_MAX_FRAMES * BMI270_FIFO_FRAME_BYTES];
+
+    if (i2c_dev_handle_bmi270 == NULL) {
+        ESP_LOGE(TAG, "i2c_dev_handle_bmi270 is NULL");
+        return false;
+    }
+
+    uint16_t length = 0;
+    if (bmi2_get_fifo_length(&length, &bmi270) != BMI2_OK) {
+        return false;
+    }
+    uint16_t frames = *count < BMI270_FIFO_MAX_FRAMES ? *count : BMI270_FIFO_MAX_FRAMES;
+    *count          = 0;
+    if (length > frames * BMI270_FIFO_FRAME_BYTES) {
+        length = frames * BMI270_FIFO_FRAME_BYTES;  // The rest stays queued for the next read
+    }
+    if (length == 0) {
+        return true;
+    }
+
+    struct bmi2_fifo_frame fifo = {0};
+    fifo.data                   = fifo_data;
+    fifo.length                 = length;
+    if (bmi2_read_fifo_data(&fifo, &bmi270) != BMI2_OK) {
+        return false;
+    }
+
+    uint16_t accel_count = frames;
+    uint16_t gyro_count  = frames;
+    bmi2_extract_accel(accel, &accel_count, &fifo, &bmi270);
+    bmi2_extract_gyro(gyro, &gyro_count, &fifo, &bmi270);
+    *count = accel_count < gyro_count ? accel_count : gyro_count;
+    return true;
+}
+
 bool accel_gyro_bmi270_check_irq(void)
 {
     if (i2c_dev_handle_bmi270 == NULL) {
@@ -299,7 +368,8 @@ void accel_gyro_bmi270_clear_irq_int(void)
 
 static int8_t bmi270_i2c_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, void *intf_ptr)
 {
-    if ((reg_data == NULL) || (len == 0) || (len > 32)) {
+    // No length cap: a FIFO drain is one burst of up to BMI270_FIFO_MAX_FRAMES frames
+    if ((reg_data == NULL) || (len == 0)) {
         return -1;
     }
 
@@ -10,6 +10,10 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
+// The UI redraws from LVGL timers; the main loop only steps app lifecycles, so
+// it sleeps until an app asks for a pass or this long has gone by
+static constexpr uint32_t MAIN_LOOP_IDLE_MS = 100;
+
 extern "C" void app_main(void)
 {
     // HAL injection callback
@@ -23,7 +27,7 @@ extern "C" void app_main(void)
     app::Init(callback);
     while (!app::IsDone()) {
         app::Update();
-        vTaskDelay(1);
+        GetHAL()->waitMainLoopWake(MAIN_LOOP_IDLE_MS);
     }
     app::Destroy();
 }
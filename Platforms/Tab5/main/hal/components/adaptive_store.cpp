@@ -0,0 +1,177 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "adaptive_store.h"
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <mooncake_log.h>
+#include <esp_heap_caps.h>
+#include <nvs.h>
+
+static const char* TAG = "Adaptive";
+
+// NVS blob: magic, taps, path, headphones, count, then count floats
+static constexpr size_t HEADER_WORDS = 5;
+static constexpr size_t MAX_NVS_FLOATS = 2 * 512;  // Both weight vectors of a 512-tap NLMS
+
+AdaptiveStore& AdaptiveStore::getInstance()
+{
+    static AdaptiveStore instance;
+    return instance;
+}
+
+const char* AdaptiveStore::nvsKey(Kind kind)
+{
+    switch (kind) {
+        case KIND_VE_NLMS: return "adapt_ve";
+        case KIND_FBC: return "adapt_fbc";
+        default: return nullptr;  // Too big for NVS, PSRAM only
+    }
+}
+
+size_t AdaptiveStore::totalCount(const Span* spans, int numSpans)
+{
+    size_t count = 0;
+    for (int i = 0; i < numSpans; i++) count += spans[i].count;
+    return count;
+}
+
+bool AdaptiveStore::reserve(Snapshot& snap, size_t count)
+{
+    if (count <= snap.capacity) return true;
+    float* data = static_cast<float*>(heap_caps_malloc(count * sizeof(float), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+    if (!data) return false;
+    heap_caps_free(snap.data);
+    snap.data = data;
+    snap.capacity = count;
+    return true;
+}
+
+void AdaptiveStore::load()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_loaded) return;
+    _loaded = true;
+
+    // NVS is brought up at boot (NvsStorage); without it there is nothing stored
+    nvs_handle_t nvs;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) return;
+    std::vector<uint32_t> blob;
+    for (int k = 0; k < KIND_COUNT; k++) {
+        const char* key = nvsKey(static_cast<Kind>(k));
+        size_t bytes = 0;
+        if (!key || nvs_get_blob(nvs, key, nullptr, &bytes) != ESP_OK) continue;
+        if (bytes < HEADER_WORDS * sizeof(uint32_t) || bytes % sizeof(uint32_t) != 0 ||
+            bytes > (HEADER_WORDS + MAX_NVS_FLOATS) * sizeof(uint32_t)) {
+            mclog::tagWarn(TAG, "{}: stored snapshot has a bad size ({} bytes)", key, bytes);
+            continue;
+        }
+        blob.resize(bytes / sizeof(uint32_t));
+        if (nvs_get_blob(nvs, key, blob.data(), &bytes) != ESP_OK) continue;
+        const size_t count = blob[4];
+        if (blob[0] != BLOB_MAGIC || count != blob.size() - HEADER_WORDS) continue;
+
+        Snapshot& snap = _snaps[k];
+        if (!reserve(snap, count)) break;
+        snap.key.taps = blob[1];
+        snap.key.path = blob[2];
+        snap.key.headphones = blob[3] != 0;
+        std::memcpy(snap.data, &blob[HEADER_WORDS], count * sizeof(float));
+        snap.count = count;
+        snap.valid = true;
+        snap.dirty = false;
+        mclog::tagInfo(TAG, "{}: snapshot loaded ({} taps)", key, snap.key.taps);
+    }
+    nvs_close(nvs);
+}
+
+bool AdaptiveStore::save(Kind kind, const Key& key, const Span* spans, int numSpans)
+{
+    if (kind >= KIND_COUNT || numSpans <= 0) return false;
+    const size_t count = totalCount(spans, numSpans);
+    if (count == 0) return false;
+
+    // Nothing learned (no reference while it ran) or diverged: the last good snapshot stays
+    bool moved = false;
+    for (int i = 0; i < numSpans; i++) {
+        for (size_t j = 0; j < spans[i].count; j++) {
+            const float v = spans[i].data[j];
+            if (!std::isfinite(v)) return false;
+            moved |= v != 0.0f;
+        }
+    }
+    if (!moved) return false;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    Snapshot& snap = _snaps[kind];
+    if (!reserve(snap, count)) {
+        mclog::tagWarn(TAG, "no PSRAM for a {}-float snapshot", count);
+        return false;
+    }
+    float* out = snap.data;
+    for (int i = 0; i < numSpans; i++) {
+        std::memcpy(out, spans[i].data, spans[i].count * sizeof(float));
+        out += spans[i].count;
+    }
+    snap.key = key;
+    snap.count = count;
+    snap.valid = true;
+    snap.dirty = true;
+    return true;
+}
+
+bool AdaptiveStore::restore(Kind kind, const Key& key, const Span* spans, int numSpans)
+{
+    if (kind >= KIND_COUNT || numSpans <= 0) return false;
+    std::unique_lock<std::mutex> lock(_mutex, std::try_to_lock);
+    if (!lock.owns_lock()) return false;
+    const Snapshot& snap = _snaps[kind];
+    if (!snap.valid || !(snap.key == key) || snap.count != totalCount(spans, numSpans)) return false;
+    const float* in = snap.data;
+    for (int i = 0; i < numSpans; i++) {
+        std::memcpy(spans[i].data, in, spans[i].count * sizeof(float));
+        in += spans[i].count;
+    }
+    return true;
+}
+
+void AdaptiveStore::persist()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    nvs_handle_t nvs = 0;
+    bool opened = false;
+    bool wrote = false;
+    std::vector<uint32_t> blob;
+    for (int k = 0; k < KIND_COUNT; k++) {
+        Snapshot& snap = _snaps[k];
+        const char* key = nvsKey(static_cast<Kind>(k));
+        if (!snap.dirty || !key || snap.count > MAX_NVS_FLOATS) continue;
+        if (!opened) {
+            if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+                mclog::tagError(TAG, "NVS open failed, snapshots kept in PSRAM only");
+                return;
+            }
+            opened = true;
+        }
+        blob.assign(HEADER_WORDS + snap.count, 0);
+        blob[0] = BLOB_MAGIC;
+        blob[1] = snap.key.taps;
+        blob[2] = snap.key.path;
+        blob[3] = snap.key.headphones ? 1 : 0;
+        blob[4] = static_cast<uint32_t>(snap.count);
+        std::memcpy(&blob[HEADER_WORDS], snap.data, snap.count * sizeof(float));
+        const esp_err_t ret = nvs_set_blob(nvs, key, blob.data(), blob.size() * sizeof(uint32_t));
+        if (ret != ESP_OK) {
+            mclog::tagError(TAG, "{}: snapshot write failed: {}", key, esp_err_to_name(ret));
+            continue;
+        }
+        snap.dirty = false;
+        wrote = true;
+    }
+    if (!opened) return;
+    if (wrote && nvs_commit(nvs) != ESP_OK) mclog::tagError(TAG, "snapshot commit failed");
+    nvs_close(nvs);
+}
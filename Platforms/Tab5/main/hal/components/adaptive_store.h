@@ -0,0 +1,92 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * @brief Converged adaptive-filter state kept across engine restarts, so voice exclusion and the
+ * feedback canceller pick up where they stopped instead of re-converging from zero
+ *
+ * One snapshot per kind, in PSRAM. AudioEngine::stop() saves each filter it is about to destroy
+ * and the audio task restores a filter right after creating it, when the key still matches: the
+ * same tap count, jack state and path fingerprint (the params that shape what the filter models,
+ * see adaptiveKey() in audio_engine.cpp). A snapshot that isn't finite or never moved off zero is
+ * not saved, so a filter that ran without a reference keeps the last good one.
+ *
+ * The kinds small enough (the time-domain NLMS filters, 4 KB at 512 taps) are also persisted to
+ * NVS from stop(), where the flash write stalls no audio, and read back on the first start after
+ * boot. The FDAF and subband states (up to 33 KB at 2048 taps, 9 KB at 512) stay in PSRAM and last
+ * until reboot.
+ *
+ * The ESP-SR NS, AGC and AEC handles expose no state to read or load, so those start fresh.
+ */
+class AdaptiveStore {
+public:
+    static constexpr const char* NVS_NAMESPACE = "howizard";
+    static constexpr uint32_t BLOB_MAGIC = 0x53444841;  // "AHDS" little-endian
+    static constexpr int MAX_SPANS = 3;                 // Weights L, R, per-bin power
+
+    enum Kind : uint8_t {
+        KIND_VE_NLMS = 0,
+        KIND_VE_FDAF,
+        KIND_FBC,
+        KIND_VE_SUBBAND,
+        KIND_COUNT,
+    };
+
+    struct Key {
+        uint32_t taps = 0;
+        uint32_t path = 0;         // Fingerprint of the params the filter's path depends on
+        bool headphones = false;
+
+        bool operator==(const Key& o) const
+        {
+            return taps == o.taps && path == o.path && headphones == o.headphones;
+        }
+    };
+
+    // A piece of a filter's state; a snapshot is its spans back to back
+    struct Span {
+        float* data;
+        size_t count;
+    };
+
+    static AdaptiveStore& getInstance();
+
+    // Reads the NVS snapshots once per boot; call before the audio task starts
+    void load();
+    // Copies the spans in; false if they hold nothing worth keeping or PSRAM is out
+    bool save(Kind kind, const Key& key, const Span* spans, int numSpans);
+    // Copies a snapshot with this key and size out; false (spans untouched) if there is none.
+    // Never waits: from the audio task, a store busy elsewhere counts as no snapshot
+    bool restore(Kind kind, const Key& key, const Span* spans, int numSpans);
+    // Writes the snapshots saved since the last persist to NVS; not from the audio task
+    void persist();
+
+private:
+    AdaptiveStore() = default;
+    AdaptiveStore(const AdaptiveStore&) = delete;
+    AdaptiveStore& operator=(const AdaptiveStore&) = delete;
+
+    struct Snapshot {
+        Key key;
+        float* data = nullptr;  // PSRAM, capacity floats
+        size_t count = 0;
+        size_t capacity = 0;
+        bool valid = false;
+        bool dirty = false;     // Saved, not yet in NVS
+    };
+
+    static const char* nvsKey(Kind kind);
+    static size_t totalCount(const Span* spans, int numSpans);
+    bool reserve(Snapshot& snap, size_t count);  // Caller holds _mutex
+
+    std::mutex _mutex;
+    Snapshot _snaps[KIND_COUNT];
+    bool _loaded = false;
+};
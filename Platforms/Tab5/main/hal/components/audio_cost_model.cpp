@@ -0,0 +1,321 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "audio_cost_model.h"
+#include <mooncake_log.h>
+#include <algorithm>
+#include <cstring>
+
+static const char* TAG = "AudioCost";
+
+// Names as runBenchmark() records them, in Kernel order
+static const char* const BENCH_NAMES[] = {
+    "resample 48k>16k", "resample 16k>48k", "biquad x8 stereo",
+    "nlms 64 taps", "nlms 128 taps", "nlms 256 taps", "nlms 512 taps",
+    "subband nlms 512 taps",
+    "ns aggressive", "agc digital", "vad",
+    "aec sr low cost", "aec sr high perf",
+    "afe vc chain",
+    "limiter", "output stage",
+};
+
+// Share of real time per kernel before a benchmark has run: about half of each
+// kernel's benchmark limit, i.e. pessimistic for a kernel that passes
+static const float DEFAULT_PCT[] = {
+    0.5f, 0.5f, 2.0f,
+    1.0f, 2.0f, 4.0f, 8.0f,
+    5.0f,
+    3.0f, 1.5f, 1.0f,
+    6.0f, 10.0f,
+    15.0f,
+    1.0f, 0.75f,
+};
+
+static constexpr float NOMINAL_RATE = 48000.0f;  // The rate the benchmark times the kernels at
+
+// Stages the benchmark doesn't time (share of real time)
+static constexpr float BLOCK_OVERHEAD_US = 40.0f;  // Task wake, DMA handoff, metering, telemetry per block
+static constexpr float BEAM_DAS_PCT     = 1.0f;
+static constexpr float BEAM_GSC_PCT     = 3.0f;
+static constexpr float WIND_PCT         = 0.2f;    // 8:1 decimated coherence, one HPF update per change
+static constexpr float SCENE_PCT        = 0.1f;    // Scene frame sums; the classifier runs on the control task
+static constexpr float FREQ_SHIFT_PCT   = 0.5f;
+static constexpr float SPECTRAL_PCT     = 3.0f;    // Shared WOLA frame, 256-point FFT, scaled by size / hop
+static constexpr float MBC_PCT          = 3.0f;
+static constexpr float WDRC_PCT         = 4.0f;
+static constexpr float LINKED_AGC_PCT   = 0.5f;    // Envelope per 16 frames, one gain ramp over both ears
+static constexpr float GENERATOR_PCT    = 0.5f;    // Per noise / tone / binaural generator
+static constexpr float FDAF_PER_PART    = 0.5f;    // Per 64-tap partition
+static constexpr float FIR_FFT_PCT      = 2.0f;    // Correction FIR: the two 128-point transforms per 64 samples
+static constexpr float FIR_PER_PART     = 0.25f;   // Correction FIR: per 64-tap partition, both ears
+static constexpr int   FIR_PRICED_TAPS  = 2048;    // The IR is on the card, not in the params: priced at the longest
+
+AudioCostModel& AudioCostModel::getInstance()
+{
+    static AudioCostModel instance;
+    return instance;
+}
+
+AudioCostModel::AudioCostModel()
+{
+    static_assert(sizeof(BENCH_NAMES) / sizeof(BENCH_NAMES[0]) == K_COUNT, "one bench name per kernel");
+    static_assert(sizeof(DEFAULT_PCT) / sizeof(DEFAULT_PCT[0]) == K_COUNT, "one default per kernel");
+    std::copy(DEFAULT_PCT, DEFAULT_PCT + K_COUNT, _pct);
+}
+
+void AudioCostModel::calibrate(const AudioBenchReport& report)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    int matched = 0;
+    for (int k = 0; k < K_COUNT; k++) {
+        for (int i = 0; i < report.count; i++) {
+            if (report.results[i].name && strcmp(report.results[i].name, BENCH_NAMES[k]) == 0) {
+                _pct[k] = report.results[i].realtimePct;
+                matched++;
+                break;
+            }
+        }
+    }
+    // A partial run (ESP-SR handle missing) keeps the defaults for what it skipped
+    _calibrated = matched > 0;
+    mclog::tagInfo(TAG, "calibrated from benchmark: {}/{} kernels @ {} MHz", matched, static_cast<int>(K_COUNT),
+        report.cpuMhz);
+}
+
+bool AudioCostModel::isCalibrated() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _calibrated;
+}
+
+// Stereo NLMS along the benchmarked tap lengths, linear between (and beyond) them
+float AudioCostModel::nlmsPct(const float* pct, int taps) const
+{
+    static const int points[] = {64, 128, 256, 512};
+    int i = 0;
+    while (i < 2 && taps > points[i + 1]) i++;
+    const float t = static_cast<float>(taps - points[i]) / (points[i + 1] - points[i]);
+    return std::max(0.0f, pct[K_NLMS64 + i] + t * (pct[K_NLMS64 + i + 1] - pct[K_NLMS64 + i]));
+}
+
+AudioCostEstimate AudioCostModel::estimate(const AudioEngineParams& params) const
+{
+    return price(params, splitEars(params));
+}
+
+bool AudioCostModel::splitEars(const AudioEngineParams& p) const
+{
+    // One lane in mono; nothing to move without per-lane NS or AGC on the bus
+    const bool agc = p.agcEnabled && !p.agcLinked && !p.fitting.wdrcEnabled && !p.dynamics.mbcEnabled;
+    const bool laneNs = p.nsEnabled && !p.nsLinked;
+    if (p.earSplit == 0 || p.beamMode > 0 || p.busAfe || !(laneNs || agc)) return false;
+    if (p.earSplit == 2) return true;
+    if (price(p, false).audioCorePct <= BUDGET_PCT) return false;
+    return price(p, true).aecCorePct <= BUDGET_PCT;
+}
+
+AudioCostEstimate AudioCostModel::price(const AudioEngineParams& p, bool splitEars) const
+{
+    float pct[K_COUNT];
+    AudioCostEstimate est;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::copy(_pct, _pct + K_COUNT, pct);
+        est.calibrated = _calibrated;
+    }
+
+    // Every stage does per-sample work: below 48 kHz it costs proportionally less
+    const float rateScale = std::max(1, p.sampleRate) / NOMINAL_RATE;
+    auto add = [&](const char* name, float cost, int core, bool measured) {
+        cost *= rateScale;
+        if (cost <= 0.0f || est.count == AudioCostEstimate::MAX_ITEMS) return;
+        est.items[est.count++] = {name, cost, core, measured && est.calibrated};
+        (core == 0 ? est.aecCorePct : est.audioCorePct) += cost;
+    };
+    // The bus stages work on 16 kHz frames whatever the engine rate; the resamplers into it do scale
+    auto addBus = [&](const char* name, float cost, int core, bool measured) {
+        add(name, cost / rateScale, core, measured);
+    };
+
+    const auto& tin = p.tinnitus;
+    const bool mono = p.beamMode > 0;
+    const int lanes = mono ? 1 : 2;
+    const int blockSize = std::max(1, p.blockSize);
+
+    add("block overhead", BLOCK_OVERHEAD_US * NOMINAL_RATE / blockSize / 1e4f, 1, false);
+    // Input extract costs about what the output stage does
+    add("convert in/out", 2.0f * pct[K_OUTPUT], 1, true);
+
+    if (p.beamMode == 1) add("beam delay-and-sum", BEAM_DAS_PCT, 1, false);
+    if (p.beamMode == 2) add("beam gsc", BEAM_GSC_PCT, 1, false);
+    if (p.windMode > 0) add("wind detector", WIND_PCT, 1, false);
+    if (p.sceneAuto) add("scene frames", SCENE_PCT, 1, false);
+    if (p.fbcEnabled) {
+        // Mono NLMS at 48 kHz: three times the bus rate, half the stereo kernel
+        add("feedback canceller", 1.5f * nlmsPct(pct, p.fbcFilterLength), 1, true);
+        if (p.fbcShiftHz > 0.0f) add("frequency shift", FREQ_SHIFT_PCT, 1, false);
+    }
+
+    // Linked ears share one stereo cascade; unlinked, each ear is a mono one (half a stereo section)
+    const EarParams ears[2] = {p.ear(AUDIO_EAR_LEFT), p.ear(AUDIO_EAR_RIGHT)};
+    const bool unlinked = !p.earsLinked && !mono;
+    auto inputSections = [](const EarParams& e) {
+        const bool eq = e.eqLowGain != 0.0f || e.eqMidGain != 0.0f || e.eqHighGain != 0.0f;
+        return (e.hpfEnabled ? 1 : 0) + (e.lpfEnabled ? 1 : 0) + (eq ? 3 : 0);
+    };
+    add("input filters",
+        pct[K_BIQUAD8] * (unlinked ? (inputSections(ears[0]) + inputSections(ears[1])) / 16.0f
+                                   : inputSections(ears[0]) / 8.0f),
+        1, true);
+
+    // 16 kHz bus. The engine only runs VE with headphones in; priced as if they are
+    const bool wdrc = p.fitting.wdrcEnabled;
+    const bool mbc = p.dynamics.mbcEnabled;
+    // Linked AGC runs at 48 kHz off the bus
+    const bool agcLinked = p.agcEnabled && p.agcLinked && !wdrc && !mbc;
+    const bool agc = p.agcEnabled && !p.agcLinked && !wdrc && !mbc;
+    const bool ve = p.veEnabled;
+    if (ve || p.nsEnabled || agc) {
+        const bool ref = ve || p.busAfe;
+        add("bus resample", pct[K_RESAMPLE_DOWN] * (lanes + (ref ? 1 : 0)) + pct[K_RESAMPLE_UP] * lanes, 1, true);
+        // The high band's reference takes a second upsample per lane
+        if (p.busBandSplit) add("bus band split", pct[K_RESAMPLE_UP] * lanes, 1, true);
+    }
+    if (p.busAfe) {
+        // The whole bus in one AFE on the worker; timed with AEC, NS and AGC all on, so an
+        // upper bound for fewer
+        if (ve) addBus("reference vad", pct[K_VAD], 1, true);
+        if (ve || p.nsEnabled || agc) addBus("afe vc chain", pct[K_AFE], 0, true);
+    } else if (ve) {
+        addBus("reference vad", pct[K_VAD], 1, true);
+        if (p.veMode == 0) {
+            addBus("ve nlms", nlmsPct(pct, p.veFilterLength), 1, true);
+        } else if (p.veMode == 2) {
+            addBus("ve fdaf", FDAF_PER_PART * std::max(1, p.veFilterLength / 64), 1, false);
+        } else if (p.veMode == 3) {
+            // Band MACs scale with the taps; the three 16-point FFTs per hop are small beside them
+            addBus("ve subband", pct[K_SUBBAND512] * std::max(64, p.veFilterLength) / 512.0f, 1, true);
+        } else {
+            const bool high = p.veAecMode == 1 || p.veAecMode == 4;
+            // The benchmark times the shared two-mic handle; per-lane is one per channel
+            addBus(high ? "aec high perf" : "aec low cost",
+                pct[high ? K_AEC_HIGH : K_AEC_LOW] * (p.veAecShared ? 1 : 2), 0, true);
+            if (p.veVadEnabled) addBus("aec vad", pct[K_VAD], 0, true);
+        }
+    }
+    // Split ears: the right lane runs on Core 0 while the audio core does the left
+    // Linked NS: one instance on the mid signal, on the audio core
+    // busAfe: the AFE priced above does NS and AGC
+    const bool nsLinked = p.nsEnabled && p.nsLinked && !mono && !p.busAfe;
+    const int localLanes = splitEars ? 1 : lanes;
+    if (nsLinked) {
+        addBus("noise suppression (linked)", pct[K_NS], 1, true);
+    } else if (p.nsEnabled && !p.busAfe) {
+        addBus("noise suppression", pct[K_NS] * localLanes, 1, true);
+    }
+    if (agc && !p.busAfe) addBus("agc", pct[K_AGC] * localLanes, 1, true);
+    if (agcLinked) add("agc (linked)", LINKED_AGC_PCT, 1, false);
+    if (splitEars) {
+        if (p.nsEnabled && !nsLinked) addBus("noise suppression (right ear)", pct[K_NS], 0, true);
+        if (agc) addBus("agc (right ear)", pct[K_AGC], 0, true);
+    }
+
+    if (p.fitting.nfcEnabled) {
+        const int hop = std::max(1, p.spectralHop);
+        add("spectral frame", SPECTRAL_PCT * (p.spectralFftSize / 256.0f) * (64.0f / hop), 1, false);
+    }
+    if (mbc) add("multiband compressor", MBC_PCT, 1, false);
+    if (wdrc) add("wdrc fitting", WDRC_PCT, 1, false);
+
+    auto tinnitusSections = [&](const EarParams& e) {
+        int n = tin.hfExtEnabled ? 1 : 0;
+        for (const auto& notch : e.notches) n += notch.enabled ? 1 : 0;
+        return n;
+    };
+    add("tinnitus filters",
+        pct[K_BIQUAD8] * (!p.earsLinked ? (tinnitusSections(ears[0]) + tinnitusSections(ears[1])) / 16.0f
+                                        : tinnitusSections(ears[0]) / 8.0f),
+        1, true);
+    const int generators = (tin.noiseType != 0 ? 1 : 0) + (tin.toneFinderEnabled ? 1 : 0) + (tin.binauralEnabled ? 1 : 0);
+    add("generators", GENERATOR_PCT * generators, 1, false);
+
+    if (p.firEnabled) add("correction fir", FIR_FFT_PCT + FIR_PER_PART * (FIR_PRICED_TAPS / 64), 1, false);
+    if (p.dynamics.limiterEnabled) add("limiter", pct[K_LIMITER], 1, true);
+    // A-weighting is three sections, K two, on a stereo copy of the output
+    if (p.doseMode > 0) add("dosimeter", pct[K_BIQUAD8] * (p.doseWeighting == 1 ? 2 : 3) / 8.0f, 1, true);
+
+    est.overBudget = est.audioCorePct > BUDGET_PCT || est.aecCorePct > BUDGET_PCT;
+    return est;
+}
+
+bool AudioCostModel::fitToBudget(AudioEngineParams& params, std::vector<std::string>* changes) const
+{
+    auto note = [&](const std::string& what) {
+        if (changes) changes->push_back(what);
+        mclog::tagWarn(TAG, "over budget, {}", what);
+    };
+
+    // Cheapest-quality-loss first; each step is re-priced before the next
+    for (int guard = 0; guard < 16; guard++) {
+        const AudioCostEstimate est = estimate(params);
+        if (!est.overBudget) return true;
+
+        if (est.aecCorePct > BUDGET_PCT && params.veEnabled && params.veMode == 1) {
+            if (params.veAecMode == 1 || params.veAecMode == 4) {
+                params.veAecMode -= 1;  // SR/VOIP high perf → low cost
+                note("AEC high perf -> low cost");
+                continue;
+            }
+            if (!params.veAecShared) {
+                params.veAecShared = true;
+                note("AEC per-lane -> shared");
+                continue;
+            }
+        }
+        if (est.audioCorePct > BUDGET_PCT) {
+            if (params.veEnabled && (params.veMode == 0 || params.veMode == 3) && params.veFilterLength > 128) {
+                params.veFilterLength /= 2;
+                note(fmt::format("VE {} taps -> {}", params.veMode == 0 ? "NLMS" : "subband", params.veFilterLength));
+                continue;
+            }
+            if (params.veEnabled && params.veMode == 2 && params.veFilterLength > 512) {
+                params.veFilterLength /= 2;
+                note(fmt::format("VE FDAF taps -> {}", params.veFilterLength));
+                continue;
+            }
+            if (params.fbcEnabled && params.fbcFilterLength > 128) {
+                params.fbcFilterLength /= 2;
+                note(fmt::format("feedback canceller taps -> {}", params.fbcFilterLength));
+                continue;
+            }
+            if (params.fitting.nfcEnabled && params.spectralHop < params.spectralFftSize / 2) {
+                params.spectralHop *= 2;
+                note(fmt::format("spectral hop -> {}", params.spectralHop));
+                continue;
+            }
+            // Fewer, longer blocks: less per-block overhead at the price of latency
+            int next = params.blockSize;
+            for (int size : AudioEngine::BLOCK_SIZES) {
+                if (size > params.blockSize) {
+                    next = size;
+                    break;
+                }
+            }
+            if (next != params.blockSize) {
+                params.blockSize = next;
+                note(fmt::format("block size -> {}", next));
+                continue;
+            }
+        }
+        break;
+    }
+
+    const AudioCostEstimate est = estimate(params);
+    if (est.overBudget) {
+        mclog::tagWarn(TAG, "still over budget at the cheapest modes: audio core {:.0f}%, AEC core {:.0f}%",
+            est.audioCorePct, est.aecCorePct);
+    }
+    return !est.overBudget;
+}
@@ -0,0 +1,92 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include "audio_engine.h"
+#include <mutex>
+#include <string>
+#include <vector>
+
+// One priced stage of a parameter set
+struct AudioCostItem {
+    const char* name = "";
+    float pct = 0.0f;         // Share of one core's real time
+    int   core = 1;           // 1 = audio task, 0 = AEC / split-ear worker
+    bool  measured = false;   // From the benchmark, not a fixed estimate
+};
+
+struct AudioCostEstimate {
+    static constexpr int MAX_ITEMS = 24;
+
+    AudioCostItem items[MAX_ITEMS];
+    int   count = 0;
+    float audioCorePct = 0.0f;  // Core 1: the block loop
+    float aecCorePct = 0.0f;    // Core 0: AEC and split-ear workers (share the core with the UI)
+    bool  calibrated = false;   // Kernel costs come from a benchmark run
+    bool  overBudget = false;   // Either core above AudioCostModel::BUDGET_PCT
+};
+
+/**
+ * @brief CPU cost model for an AudioEngineParams set
+ *
+ * Predicts what a parameter set costs on the audio core and the AEC worker
+ * before it reaches the engine, so a profile that stacks AEC high-perf, long
+ * NLMS filters and every notch can be stepped down instead of dropping blocks.
+ * Kernel costs start from conservative defaults and are replaced by the
+ * measured figures each time the DSP benchmark runs; stages the benchmark
+ * doesn't time keep fixed estimates.
+ */
+class AudioCostModel {
+public:
+    // Headroom for DMA waits, ISRs and, on Core 0, the UI
+    static constexpr float BUDGET_PCT = 75.0f;
+
+    static AudioCostModel& getInstance();
+
+    // Take the kernel costs from a finished benchmark
+    void calibrate(const AudioBenchReport& report);
+    bool isCalibrated() const;
+
+    AudioCostEstimate estimate(const AudioEngineParams& params) const;
+
+    // Whether the right ear's NS / AGC lane goes to Core 0: earSplit 2, or 1 (auto)
+    // when the audio core is over budget without it and Core 0 has room for it
+    bool splitEars(const AudioEngineParams& params) const;
+
+    // Steps the enabled features down to cheaper modes (never switches one off)
+    // until the estimate fits. Each change is described in `changes`. Returns
+    // false if the params are still over budget at the cheapest modes.
+    bool fitToBudget(AudioEngineParams& params, std::vector<std::string>* changes = nullptr) const;
+
+private:
+    AudioCostModel();
+
+    enum Kernel {
+        K_RESAMPLE_DOWN = 0,
+        K_RESAMPLE_UP,
+        K_BIQUAD8,
+        K_NLMS64,
+        K_NLMS128,
+        K_NLMS256,
+        K_NLMS512,
+        K_SUBBAND512,
+        K_NS,
+        K_AGC,
+        K_VAD,
+        K_AEC_LOW,
+        K_AEC_HIGH,
+        K_AFE,
+        K_LIMITER,
+        K_OUTPUT,
+        K_COUNT
+    };
+
+    float nlmsPct(const float* pct, int taps) const;
+    AudioCostEstimate price(const AudioEngineParams& params, bool splitEars) const;
+
+    mutable std::mutex _mutex;
+    float _pct[K_COUNT];
+    bool _calibrated = false;
+};
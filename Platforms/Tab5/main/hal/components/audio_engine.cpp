@@ -4,971 +4,5691 @@
  * SPDX-License-Identifier: MIT
  */
 #include "audio_engine.h"
+#include "adaptive_store.h"
+#include "profile_manager.h"
+#include "sd_storage.h"
+#include "audio_cost_model.h"
+#include "audio_stages.h"
+#include "cpu_governor.h"
+#include "audio_session.h"
+#include "audio_recorder.h"
+#include "noise_dosimeter.h"
+#include "usb_audio.h"
+#include "rtp_stream.h"
+#include "../utils/dsp_graph/dsp_graph.h"
 #include <mooncake_log.h>
 #include <bsp/m5stack_tab5.h>
 #include <cmath>
 #include <cstring>
 #include <algorithm>
+#include <numeric>
+#include <memory>
+#include <vector>
 #include <esp_heap_caps.h>
+#include <esp_memory_utils.h>
+#include <esp_cpu.h>
+#include <esp_timer.h>
+#include <esp_private/esp_clk.h>
+#include <sdkconfig.h>
+#if CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#endif
+#include <dsps_fft2r.h>
+
+#if CONFIG_IDF_TARGET_ESP32P4 && CONFIG_DSP_OPTIMIZED
+#include <dsps_dotprod.h>
+#define AUDIO_ENGINE_USE_DSPS_DOTPROD 1
+#endif
 
 extern "C" {
 #include <esp_ns.h>
 #include <esp_agc.h>
 #include <esp_aec.h>
 #include <esp_vad.h>
+#include <esp_afe_config.h>
+#include <esp_afe_sr_models.h>
 }
 
 static const char* TAG = "AudioEngine";
 
 // ─────────────────────────────────────────────────────────────────────────────
-// Polyphase Resampler (21-tap Kaiser-windowed sinc, ~70dB stopband)
-// Ported from Boosted speech_dsp.cpp
+// Polyphase Resampler (Kaiser-windowed sinc, ~70dB stopband): 3:1 from 48kHz,
+// 2:1 half-band from 32kHz. Ported from Boosted speech_dsp.cpp
+//
+// The kernel is split into its polyphase branches at init() and the zero taps
+// are dropped, leaving 7 + 1 + 7 = 15 MACs per 16kHz sample at 3:1 and 8 + 1 = 9
+// at 2:1, in both directions. Each branch is a plain contiguous FIR over a
+// history+block working buffer, so the inner loops have no bounds checks and
+// map directly onto dsps_fir_f32 / PIE dot-product kernels if they are ever
+// swapped in.
 // ─────────────────────────────────────────────────────────────────────────────
 
 class Resampler {
 public:
     static constexpr int FILTER_TAPS = 21;
-    static constexpr int HALF_TAPS = FILTER_TAPS / 2;  // 10
-
-    void init(bool downsample) {
+    static constexpr int HALFBAND_TAPS = 15;
+    static constexpr int MAX_PHASES = 3;
+    static constexpr int PHASE_TAPS = (HALFBAND_TAPS + 1) / 2;  // 8, the longest branch (2:1)
+    static constexpr int HIST = PHASE_TAPS - 1;                 // 7 samples per branch
+    static constexpr int MAX_FRAMES = 160;                      // 16kHz samples per pass
+
+    // Anti-alias / anti-imaging low-pass, shared by both directions: sinc at 8kHz
+    // (the 16kHz Nyquist), Kaiser window β=5, about -3dB at 7kHz per pass. Each
+    // polyphase branch sums to exactly 1/3, so DC passes at unity both ways and
+    // a round trip is x[n - 18] minus only what lies above the cut (BusBandSplit).
+    static constexpr float KERNEL[FILTER_TAPS] = {
+        -0.0010101f,  0.0000000f,  0.0061627f,  0.0113008f,  0.0000000f, -0.0304238f,
+        -0.0474781f,  0.0000000f,  0.1257192f,  0.2690627f,  0.3333333f,  0.2690627f,
+         0.1257192f,  0.0000000f, -0.0474781f, -0.0304238f,  0.0000000f,  0.0113008f,
+         0.0061627f,  0.0000000f, -0.0010101f
+    };
+
+    // The same design at 32kHz, as long in time: a half-band, every other tap but
+    // the centre is zero. Both branches sum to exactly 1/2; a round trip is x[n - 13]
+    static constexpr float HALFBAND_KERNEL[HALFBAND_TAPS] = {
+        -0.0016662f,  0.0000000f,  0.0172001f,  0.0000000f, -0.0690200f,  0.0000000f,
+         0.3034860f,  0.5000000f,  0.3034860f,  0.0000000f, -0.0690200f,  0.0000000f,
+         0.0172001f,  0.0000000f, -0.0016662f
+    };
+
+    static constexpr int taps(int ratio) { return ratio == 2 ? HALFBAND_TAPS : FILTER_TAPS; }
+    static constexpr const float* kernel(int ratio) { return ratio == 2 ? HALFBAND_KERNEL : KERNEL; }
+
+    // ratio: 3 (48kHz) or 2 (32kHz)
+    void init(bool downsample, int ratio = 3) {
         _downsample = downsample;
-        static const float lpf_coeffs[FILTER_TAPS] = {
-            -0.0029f, -0.0056f,  0.0000f,  0.0175f,  0.0303f,  0.0000f,
-            -0.0657f, -0.1186f,  0.0000f,  0.3125f,  0.5002f,  0.3125f,
-             0.0000f, -0.1186f, -0.0657f,  0.0000f,  0.0303f,  0.0175f,
-             0.0000f, -0.0056f, -0.0029f
-        };
-        std::memcpy(_coeffs, lpf_coeffs, sizeof(lpf_coeffs));
-        std::memset(_history, 0, sizeof(_history));
-        std::memset(_upHistory, 0, sizeof(_upHistory));
-    }
-
-    void downsample3(const float* in, float* out, size_t outFrames) {
-        size_t inFrames = outFrames * 3;
-        for (size_t i = 0; i < outFrames; i++) {
-            float sum = 0.0f;
-            size_t inIdx = i * 3;
-            for (int t = 0; t < FILTER_TAPS; t++) {
-                int srcIdx = static_cast<int>(inIdx) - HALF_TAPS + t;
-                float sample;
-                if (srcIdx < 0) {
-                    int histIdx = HALF_TAPS + srcIdx;
-                    sample = (histIdx >= 0) ? _history[histIdx] : 0.0f;
-                } else if (srcIdx < static_cast<int>(inFrames)) {
-                    sample = in[srcIdx];
-                } else {
-                    sample = 0.0f;
+        _ratio = ratio == 2 ? 2 : 3;
+        const int n = taps(_ratio);
+        const float* h = kernel(_ratio);
+
+        // Branch p holds taps h[ratio * k + p]; keep only the non-zero k range and
+        // store it reversed so branch output = dot(coef, x[i - kMax .. i - kMin])
+        for (int p = 0; p < _ratio; p++) {
+            int kMin = PHASE_TAPS, kMax = -1;
+            for (int k = 0; k * _ratio + p < n; k++) {
+                if (h[k * _ratio + p] != 0.0f) {
+                    kMin = std::min(kMin, k);
+                    kMax = std::max(kMax, k);
                 }
-                sum += sample * _coeffs[t];
             }
-            out[i] = sum;
-        }
-        if (inFrames >= static_cast<size_t>(HALF_TAPS)) {
-            for (int i = 0; i < HALF_TAPS; i++) {
-                _history[i] = in[inFrames - HALF_TAPS + i];
+            _len[p] = kMax - kMin + 1;
+            _kMax[p] = kMax;
+            for (int j = 0; j < _len[p]; j++) {
+                _dsCoef[p][j] = h[(kMax - j) * _ratio + p];
+                _usCoef[p][j] = _dsCoef[p][j] * _ratio;  // Zero-stuffing gain
             }
         }
+
+        std::memset(_dsWork, 0, sizeof(_dsWork));
+        std::memset(_usWork, 0, sizeof(_usWork));
     }
 
-    void upsample3(const float* in, float* out, size_t inFrames) {
-        for (size_t i = 0; i < inFrames; i++) {
-            for (int phase = 0; phase < 3; phase++) {
+    int ratio() const { return _ratio; }
+
+    // Engine rate → 16kHz: in[outFrames * ratio] → out[outFrames]
+    void downsample(const float* in, float* out, size_t outFrames) {
+        while (outFrames > 0) {
+            int n = static_cast<int>(std::min(outFrames, static_cast<size_t>(MAX_FRAMES)));
+
+            // Deinterleave into branch streams: stream q sample m = x[ratio * m + ratio - 1 - q]
+            if (_ratio == 3) {
+                for (int m = 0; m < n; m++) {
+                    _dsWork[0][HIST + m] = in[m * 3 + 2];
+                    _dsWork[1][HIST + m] = in[m * 3 + 1];
+                    _dsWork[2][HIST + m] = in[m * 3 + 0];
+                }
+            } else {
+                for (int m = 0; m < n; m++) {
+                    _dsWork[0][HIST + m] = in[m * 2 + 1];
+                    _dsWork[1][HIST + m] = in[m * 2 + 0];
+                }
+            }
+
+            for (int i = 0; i < n; i++) {
                 float sum = 0.0f;
-                for (int t = 0; t < 7; t++) {
-                    int srcIdx = static_cast<int>(i) - 3 + t;
-                    float sample;
-                    if (srcIdx < 0) {
-                        int histIdx = 3 + srcIdx;
-                        sample = (histIdx >= 0) ? _upHistory[histIdx] : 0.0f;
-                    } else if (srcIdx < static_cast<int>(inFrames)) {
-                        sample = in[srcIdx];
-                    } else {
-                        sample = 0.0f;
-                    }
-                    int coeffIdx = t * 3 + phase;
-                    if (coeffIdx < FILTER_TAPS) {
-                        sum += sample * _coeffs[coeffIdx];
+                for (int p = 0; p < _ratio; p++) {
+                    const float* x = &_dsWork[p][HIST + i - _kMax[p]];
+                    const float* c = _dsCoef[p];
+                    for (int j = 0; j < _len[p]; j++) {
+                        sum += c[j] * x[j];
                     }
                 }
-                out[i * 3 + phase] = sum * 3.0f;
+                out[i] = sum;
             }
+
+            for (int p = 0; p < _ratio; p++) {
+                std::memmove(_dsWork[p], &_dsWork[p][n], HIST * sizeof(float));
+            }
+
+            in += n * _ratio;
+            out += n;
+            outFrames -= n;
         }
-        if (inFrames >= 3) {
-            for (int i = 0; i < 3; i++) {
-                _upHistory[i] = in[inFrames - 3 + i];
+    }
+
+    // 16kHz → engine rate: in[inFrames] → out[inFrames * ratio]
+    void upsample(const float* in, float* out, size_t inFrames) {
+        while (inFrames > 0) {
+            int n = static_cast<int>(std::min(inFrames, static_cast<size_t>(MAX_FRAMES)));
+
+            std::memcpy(&_usWork[HIST], in, n * sizeof(float));
+
+            for (int i = 0; i < n; i++) {
+                for (int p = 0; p < _ratio; p++) {
+                    const float* x = &_usWork[HIST + i - _kMax[p]];
+                    const float* c = _usCoef[p];
+                    float sum = 0.0f;
+                    for (int j = 0; j < _len[p]; j++) {
+                        sum += c[j] * x[j];
+                    }
+                    out[i * _ratio + p] = sum;
+                }
             }
+
+            std::memmove(_usWork, &_usWork[n], HIST * sizeof(float));
+
+            in += n;
+            out += n * _ratio;
+            inFrames -= n;
         }
     }
 
 private:
     bool _downsample = true;
-    float _coeffs[FILTER_TAPS] = {};
-    float _history[HALF_TAPS] = {};
-    float _upHistory[3] = {};
+    int _ratio = 3;
+    float _dsCoef[MAX_PHASES][PHASE_TAPS] = {};
+    float _usCoef[MAX_PHASES][PHASE_TAPS] = {};
+    int _len[MAX_PHASES] = {};
+    int _kMax[MAX_PHASES] = {};
+    float _dsWork[MAX_PHASES][HIST + MAX_FRAMES] = {};  // Per-branch history + block
+    float _usWork[HIST + MAX_FRAMES] = {};              // History + block
 };
 
 // ─────────────────────────────────────────────────────────────────────────────
-// NLMS Adaptive Filter (Voice Exclusion)
+// Scratch arena: one cache-line-aligned allocation carved into work buffers
+//
+// carve() is run twice with the same sequence of take() calls: first on an
+// unbacked arena to size the layout, then on the real allocation. Every buffer
+// starts on its own cache line so no two hot buffers share one.
 // ─────────────────────────────────────────────────────────────────────────────
 
-class NlmsFilter {
+class ScratchArena {
 public:
-    void init(int filterLength) {
+    static constexpr size_t ALIGN = 128;  // L2 cache line (CONFIG_CACHE_L2_CACHE_LINE_128B)
+
+    bool init(size_t bytes, uint32_t caps) {
         destroy();
-        _len = filterLength;
-        _weights = new float[_len]();     // zero-initialized
-        _refBuf = new float[_len]();      // circular reference buffer
-        _pos = 0;
+        _base = static_cast<uint8_t*>(heap_caps_aligned_calloc(ALIGN, 1, bytes, caps));
+        _size = _base ? bytes : 0;
+        _used = 0;
+        return _base != nullptr;
     }
 
     void destroy() {
-        delete[] _weights;
-        delete[] _refBuf;
-        _weights = nullptr;
-        _refBuf = nullptr;
-        _len = 0;
-        _pos = 0;
+        if (_base) heap_caps_free(_base);
+        _base = nullptr;
+        _size = 0;
+        _used = 0;
     }
 
-    void reset() {
-        if (_weights) std::memset(_weights, 0, _len * sizeof(float));
-        if (_refBuf)  std::memset(_refBuf, 0, _len * sizeof(float));
-        _pos = 0;
+    // Unbacked arenas only count bytes (sizing pass) and return nullptr
+    template <typename T>
+    T* take(size_t count) {
+        size_t offset = _used;
+        _used += (count * sizeof(T) + ALIGN - 1) & ~(ALIGN - 1);
+        if (!_base || _used > _size) return nullptr;
+        return reinterpret_cast<T*>(_base + offset);
     }
 
-    // Returns the voice estimate (what should be subtracted from primary).
-    // Weight update uses the true (unclamped) error for correct convergence.
-    float process(float ref, float primary, float stepSize) {
-        if (!_weights || !_refBuf || _len <= 0) return 0.0f;
+    size_t used() const { return _used; }
+    bool isInternal() const { return _base && esp_ptr_internal(_base); }
 
-        // 1. Store reference sample in circular buffer
-        _refBuf[_pos] = ref;
-
-        // 2. Compute estimate = dot(weights, refBuffer)
-        float estimate = 0.0f;
-        float power = 0.0f;
-        for (int i = 0; i < _len; i++) {
-            int idx = (_pos - i + _len) % _len;
-            float r = _refBuf[idx];
-            estimate += _weights[i] * r;
-            power += r * r;
-        }
+private:
+    uint8_t* _base = nullptr;
+    size_t _size = 0;
+    size_t _used = 0;
+};
 
-        // 3. True error for weight update (never clamped)
-        float error = primary - estimate;
+// ─────────────────────────────────────────────────────────────────────────────
+// Masking noise generator (tinnitus relief)
+//
+// One xorshift32 stream per channel with unrelated seeds, so L and R are
+// decorrelated and the masker fills the stereo field instead of sitting in
+// the middle of the head. Pink uses Paul Kellet's 7-pole refined filter
+// (±0.05 dB from 9 Hz up), brown a leaky integrator. A whole block is
+// generated at once; band-limiting happens afterwards in the biquad cascade.
+// ─────────────────────────────────────────────────────────────────────────────
 
-        // 4. Normalized step: stepSize / (power + floor)
-        float normStep = stepSize / (power + 1e-4f);  // Larger floor for stability during quiet periods
+class MaskingNoise {
+public:
+    void reset()
+    {
+        for (int c = 0; c < 2; c++) {
+            _rng[c] = c ? 0x9E3779B9u : 0x12345678u;
+            for (float& b : _pink[c]) b = 0.0f;
+            _brown[c] = 0.0f;
+        }
+    }
 
-        // 5. Update weights using true error
-        for (int i = 0; i < _len; i++) {
-            int idx = (_pos - i + _len) % _len;
-            _weights[i] += normStep * error * _refBuf[idx];
-            // Coefficient sanity check - soft clipping with gradual decay
-            constexpr float maxWeight = 5.0f;
-            if (fabsf(_weights[i]) > maxWeight) {
-                _weights[i] *= 0.95f;  // Gradual decay instead of hard reset
+    // type: 1=White, 2=Pink, 3=Brown (noiseType)
+    void generate(int type, float* outL, float* outR, int frames)
+    {
+        float* out[2] = {outL, outR};
+        for (int c = 0; c < 2; c++) {
+            uint32_t s = _rng[c];
+            float* o = out[c];
+            if (type == 2) {
+                float* b = _pink[c];
+                for (int i = 0; i < frames; i++) {
+                    float white = nextWhite(s);
+                    b[0] = 0.99886f * b[0] + white * 0.0555179f;
+                    b[1] = 0.99332f * b[1] + white * 0.0750759f;
+                    b[2] = 0.96900f * b[2] + white * 0.1538520f;
+                    b[3] = 0.86650f * b[3] + white * 0.3104856f;
+                    b[4] = 0.55000f * b[4] + white * 0.5329522f;
+                    b[5] = -0.7616f * b[5] - white * 0.0168980f;
+                    o[i] = (b[0] + b[1] + b[2] + b[3] + b[4] + b[5] + b[6] + white * 0.5362f) * PINK_GAIN;
+                    b[6] = white * 0.115926f;
+                }
+            } else if (type == 3) {
+                float brown = _brown[c];
+                for (int i = 0; i < frames; i++) {
+                    brown = 0.998f * brown + nextWhite(s) * 0.02f;
+                    o[i] = brown;
+                }
+                _brown[c] = brown;
+            } else {
+                for (int i = 0; i < frames; i++) o[i] = nextWhite(s);
             }
+            _rng[c] = s;
         }
+    }
 
-        // Advance circular buffer position
-        _pos = (_pos + 1) % _len;
+private:
+    static constexpr float PINK_GAIN = 0.11f;  // Kellet's output scale, back to ~unity peak
 
-        // Return the estimate (caller subtracts with blend + attenuation clamp)
-        return estimate;
+    static inline float nextWhite(uint32_t& s)
+    {
+        s ^= s << 13;
+        s ^= s >> 17;
+        s ^= s << 5;
+        return (float)((int32_t)s) * (1.0f / 2147483648.0f);  // [-1, 1]
     }
 
-    bool isInitialized() const { return _weights != nullptr; }
-
-private:
-    float* _weights = nullptr;
-    float* _refBuf = nullptr;
-    int _len = 0;
-    int _pos = 0;
+    uint32_t _rng[2] = {0x12345678u, 0x9E3779B9u};
+    float _pink[2][7] = {};
+    float _brown[2] = {};
 };
 
 // ─────────────────────────────────────────────────────────────────────────────
-// Singleton
+// Stereo-linked AGC (48kHz, one gain for both ears)
+//
+// Only the side chain is decimated: the detector reads max(L², R²) averaged
+// over SEGMENT samples, so the signal itself never leaves 48kHz. Its envelope
+// sets a gain toward the target level, capped at the compression gain, and
+// held below the gate so silence isn't pumped up. With the limiter on, the
+// gain also keeps each segment's peak under the target. The gain falls fast
+// and rises slowly (in dB), and runs as a linear ramp across each segment.
+// Mode 3 (fixed) applies the compression gain, limiter permitting.
 // ─────────────────────────────────────────────────────────────────────────────
 
-AudioEngine& AudioEngine::getInstance()
-{
-    static AudioEngine instance;
-    return instance;
-}
+class LinkedAgc {
+public:
+    static constexpr int SEGMENT = 16;         // Side-chain decimation: 3kHz control rate @ 48kHz
+    static constexpr float GATE_DB = -60.0f;   // Envelope level below which the gain holds
 
-// ─────────────────────────────────────────────────────────────────────────────
-// Biquad filter - Direct Form II Transposed
-// ─────────────────────────────────────────────────────────────────────────────
+    void configure(int mode, int compressionGainDb, bool limiter, int targetDbfs, float sampleRate)
+    {
+        const float segmentRate = sampleRate / SEGMENT;
+        auto coef = [&](float seconds) { return 1.0f - expf(-1.0f / (seconds * segmentRate)); };
+        _fixed = mode == 3;
+        _maxGainDb = static_cast<float>(compressionGainDb);
+        _targetDb = static_cast<float>(targetDbfs);
+        _limiter = limiter;
+        _envAttack = coef(0.010f);
+        _envRelease = coef(0.300f);
+        _gainFall = coef(0.005f);
+        _gainRise = coef(0.250f);
+    }
 
-float AudioEngine::Biquad::process(float in)
-{
-    float out = b0 * in + z1;
-    z1 = b1 * in - a1 * out + z2;
-    z2 = b2 * in - a2 * out;
-    return out;
-}
+    void reset()
+    {
+        _env = 0.0f;
+        _gainDb = 0.0f;
+        _gain = 1.0f;
+    }
 
-void AudioEngine::Biquad::reset()
-{
-    z1 = 0.0f;
-    z2 = 0.0f;
-}
+    // In place on both channels; returns the block's mean gain (dB). hold keeps the
+    // gain where it is (the wearer talking), the limiter still pulls it down
+    float process(float* left, float* right, int frames, bool hold)
+    {
+        float sumDb = 0.0f;
+        for (int start = 0; start < frames; start += SEGMENT) {
+            const int n = std::min(SEGMENT, frames - start);
+            float* l = left + start;
+            float* r = right + start;
+
+            float power = 0.0f, peak = 0.0f;
+            for (int i = 0; i < n; i++) {
+                const float m = std::max(l[i] * l[i], r[i] * r[i]);
+                power += m;
+                peak = std::max(peak, m);
+            }
+            power /= n;
+
+            float wantDb = _maxGainDb;
+            if (!_fixed) {
+                _env += (power > _env ? _envAttack : _envRelease) * (power - _env);
+                const float levelDb = 10.0f * log10f(_env + 1e-12f);
+                wantDb = levelDb < GATE_DB || hold ? _gainDb : std::clamp(_targetDb - levelDb, 0.0f, _maxGainDb);
+            }
+            if (_limiter && peak > 0.0f) wantDb = std::min(wantDb, _targetDb - 10.0f * log10f(peak));
+            _gainDb += (wantDb < _gainDb ? _gainFall : _gainRise) * (wantDb - _gainDb);
+
+            const float target = powf(10.0f, _gainDb / 20.0f);
+            const float step = (target - _gain) / n;
+            for (int i = 0; i < n; i++) {
+                _gain += step;
+                l[i] *= _gain;
+                r[i] *= _gain;
+            }
+            _gain = target;
+            sumDb += _gainDb * n;
+        }
+        return frames > 0 ? sumDb / frames : 0.0f;
+    }
+
+private:
+    bool _fixed = false;
+    bool _limiter = true;
+    float _maxGainDb = 9.0f;
+    float _targetDb = -3.0f;
+    float _envAttack = 0.0f, _envRelease = 0.0f;
+    float _gainFall = 0.0f, _gainRise = 0.0f;
+    float _env = 0.0f;
+    float _gainDb = 0.0f;
+    float _gain = 1.0f;
+};
 
 // ─────────────────────────────────────────────────────────────────────────────
-// Coefficient calculations (Audio EQ Cookbook - Robert Bristow-Johnson)
+// Frequency shifter (feedback decorrelation, stereo)
+//
+// Single-sideband modulation: two chains of 2nd-order allpass sections (Olli
+// Niemitalo's 8th-order Hilbert pair) hold a 90° phase difference over roughly
+// 20 Hz - 20 kHz and are mixed with a quadrature oscillator. Shifting the mic
+// path a few Hz keeps the speaker signal from matching the incoming sound, so
+// the feedback canceller doesn't converge onto the wanted signal, and the loop
+// never sits at the same gain peak long enough to build up.
 // ─────────────────────────────────────────────────────────────────────────────
 
-void AudioEngine::calcHpfCoeffs(Biquad& bq, float freq, float sampleRate)
-{
-    float w0 = 2.0f * M_PI * freq / sampleRate;
-    float cosw0 = cosf(w0);
-    float sinw0 = sinf(w0);
-    float alpha = sinw0 / (2.0f * 0.7071f);  // Q = 0.7071 (Butterworth)
+class FrequencyShifter {
+public:
+    void setShift(float hz, float sampleRate)
+    {
+        _sin.setFrequency(hz, sampleRate);
+        _cos.setFrequency(hz, sampleRate);
+    }
 
-    float a0 = 1.0f + alpha;
-    bq.b0 = ((1.0f + cosw0) / 2.0f) / a0;
-    bq.b1 = (-(1.0f + cosw0)) / a0;
-    bq.b2 = ((1.0f + cosw0) / 2.0f) / a0;
-    bq.a1 = (-2.0f * cosw0) / a0;
-    bq.a2 = (1.0f - alpha) / a0;
-}
+    void reset()
+    {
+        std::memset(_state, 0, sizeof(_state));
+        std::memset(_delay, 0, sizeof(_delay));
+        _sin.reset(0);
+        _cos.reset(1u << 30);  // Quarter period ahead
+    }
 
-void AudioEngine::calcLpfCoeffs(Biquad& bq, float freq, float sampleRate)
-{
-    float w0 = 2.0f * M_PI * freq / sampleRate;
-    float cosw0 = cosf(w0);
-    float sinw0 = sinf(w0);
-    float alpha = sinw0 / (2.0f * 0.7071f);  // Q = 0.7071 (Butterworth)
+    void process(float* left, float* right, int frames)
+    {
+        float* io[2] = {left, right};
+        for (int i = 0; i < frames; i++) {
+            const float s = _sin.next();
+            const float c = _cos.next();
+            for (int ch = 0; ch < 2; ch++) {
+                float in = io[ch][i];
+                float a = in, b = in;
+                for (int k = 0; k < SECTIONS; k++) {
+                    a = section(_state[ch][0][k], COEF_A[k], a);
+                    b = section(_state[ch][1][k], COEF_B[k], b);
+                }
+                // Chain A lags one more sample; then (A, B) is an analytic pair
+                float aDelayed = _delay[ch];
+                _delay[ch] = a;
+                io[ch][i] = aDelayed * c + b * s;
+            }
+        }
+    }
 
-    float a0 = 1.0f + alpha;
-    bq.b0 = ((1.0f - cosw0) / 2.0f) / a0;
-    bq.b1 = (1.0f - cosw0) / a0;
-    bq.b2 = ((1.0f - cosw0) / 2.0f) / a0;
-    bq.a1 = (-2.0f * cosw0) / a0;
-    bq.a2 = (1.0f - alpha) / a0;
-}
+private:
+    static constexpr int SECTIONS = 4;
+    // a^2 of each section: y[n] = a^2 * (x[n] + y[n-2]) - x[n-2]
+    static constexpr float COEF_A[SECTIONS] = {0.4794008655888f, 0.8762184935393f, 0.9765975895082f, 0.9974992559356f};
+    static constexpr float COEF_B[SECTIONS] = {0.1617584983677f, 0.7330289323415f, 0.9453497003291f, 0.9905991566845f};
 
-void AudioEngine::calcPeakEqCoeffs(Biquad& bq, float freq, float gainDb, float Q, float sampleRate)
-{
-    if (fabsf(gainDb) < 0.1f) {
-        // Unity gain - bypass
-        bq.b0 = 1.0f; bq.b1 = 0.0f; bq.b2 = 0.0f;
-        bq.a1 = 0.0f; bq.a2 = 0.0f;
-        return;
+    struct Section {
+        float x1 = 0.0f, x2 = 0.0f, y1 = 0.0f, y2 = 0.0f;
+    };
+
+    static float section(Section& st, float coef, float in)
+    {
+        float out = coef * (in + st.y2) - st.x2;
+        st.x2 = st.x1;
+        st.x1 = in;
+        st.y2 = st.y1;
+        st.y1 = out;
+        return out;
     }
 
-    float A = powf(10.0f, gainDb / 40.0f);  // sqrt of linear gain
-    float w0 = 2.0f * M_PI * freq / sampleRate;
-    float cosw0 = cosf(w0);
-    float sinw0 = sinf(w0);
-    float alpha = sinw0 / (2.0f * Q);
+    Section _state[2][2][SECTIONS];  // [channel][chain A/B][section]
+    float _delay[2] = {};
+    Oscillator _sin;
+    Oscillator _cos;
+};
 
-    float a0 = 1.0f + alpha / A;
-    bq.b0 = (1.0f + alpha * A) / a0;
-    bq.b1 = (-2.0f * cosw0) / a0;
-    bq.b2 = (1.0f - alpha * A) / a0;
-    bq.a1 = (-2.0f * cosw0) / a0;
-    bq.a2 = (1.0f - alpha / A) / a0;
-}
+// ─────────────────────────────────────────────────────────────────────────────
+// Howl detector (spectral peak tests on the mono mix)
+//
+// Every HOP samples the last FFT_SIZE are Hann-windowed and transformed.
+// A howl is a single loud spectral peak that stands well above the mean bin
+// power (PAPR), has neither harmonics nor a subharmonic (PHPR: voiced speech
+// and instruments always do), is loud enough to matter and stays within one
+// bin for HOLD_SAMPLES. The peak is refined by parabolic interpolation of
+// the log power so a narrow notch lands on it.
+// ─────────────────────────────────────────────────────────────────────────────
 
-// Notch filter coefficients (Audio EQ Cookbook - notch/band-stop)
-void AudioEngine::calcNotchCoeffs(Biquad& bq, float freq, float Q, float sampleRate)
-{
-    float w0 = 2.0f * M_PI * freq / sampleRate;
-    float cosw0 = cosf(w0);
-    float sinw0 = sinf(w0);
-    float alpha = sinw0 / (2.0f * Q);
+class HowlDetector {
+public:
+    static constexpr int FFT_SIZE = 512;                    // 93.75 Hz bins @ 48kHz
+    static constexpr int BINS = FFT_SIZE / 2;
+    static constexpr int HOP = 480;                         // 10ms, whatever the block size
+    static constexpr float MIN_HZ = 150.0f;
+    static constexpr float MIN_PEAK = 1e-4f;                // -40 dBFS tone (peak normalized to amplitude^2)
+    static constexpr float PAPR = 20.0f;                    // 13 dB over the mean bin
+    static constexpr float PHPR = 31.6f;                    // 15 dB over harmonic / subharmonic bins
+    static constexpr int HOLD_SAMPLES = 48000 * 200 / 1000;
+    static constexpr int COOLDOWN_SAMPLES = 48000 / 2;
+
+    // Also builds the window, so a detector carved from zeroed memory is ready after reset()
+    void reset()
+    {
+        // Hann scaled so an on-bin sinusoid of amplitude A peaks at A^2
+        for (int i = 0; i < FFT_SIZE; i++) {
+            _window[i] = (4.0f / FFT_SIZE) * (0.5f - 0.5f * cosf(2.0f * static_cast<float>(M_PI) * i / FFT_SIZE));
+        }
+        std::memset(_hist, 0, sizeof(_hist));
+        _ready = WolaProcessor::initFftTables();
+        _pending = 0;
+        _peakBin = -1;
+        _stable = 0;
+        _cooldown = 0;
+    }
 
-    float a0 = 1.0f + alpha;
-    bq.b0 = 1.0f / a0;
-    bq.b1 = (-2.0f * cosw0) / a0;
-    bq.b2 = 1.0f / a0;
-    bq.a1 = (-2.0f * cosw0) / a0;
-    bq.a2 = (1.0f - alpha) / a0;
-}
+    // Returns true once per confirmed howl; hz receives its frequency
+    bool process(const float* left, const float* right, int frames, float sampleRate, float& hz)
+    {
+        frames = std::min(frames, FFT_SIZE);
+        std::memmove(_hist, _hist + frames, (FFT_SIZE - frames) * sizeof(float));
+        float* tail = _hist + FFT_SIZE - frames;
+        for (int i = 0; i < frames; i++) tail[i] = 0.5f * (left[i] + right[i]);
+        _pending += frames;
+        if (_pending < HOP || !_ready) return false;
+        const int step = _pending;
+        _pending = 0;
+        if (_cooldown > 0) _cooldown = std::max(0, _cooldown - step);
+
+        for (int i = 0; i < FFT_SIZE; i++) {
+            _fft[2 * i] = _hist[i] * _window[i];
+            _fft[2 * i + 1] = 0.0f;
+        }
+        dsps_fft2r_fc32(_fft, FFT_SIZE);
+        dsps_bit_rev_fc32(_fft, FFT_SIZE);
 
-// High-shelf filter coefficients (Audio EQ Cookbook)
-void AudioEngine::calcHighShelfCoeffs(Biquad& bq, float freq, float gainDb, float sampleRate)
-{
-    if (fabsf(gainDb) < 0.1f) {
-        // Unity gain - bypass
-        bq.b0 = 1.0f; bq.b1 = 0.0f; bq.b2 = 0.0f;
-        bq.a1 = 0.0f; bq.a2 = 0.0f;
-        return;
+        float total = 0.0f;
+        for (int k = 1; k < BINS; k++) {
+            _power[k] = _fft[2 * k] * _fft[2 * k] + _fft[2 * k + 1] * _fft[2 * k + 1];
+            total += _power[k];
+        }
+        const int kMin = std::max(2, static_cast<int>(ceilf(MIN_HZ * FFT_SIZE / sampleRate)));
+        int peak = kMin;
+        for (int k = kMin + 1; k < BINS - 1; k++) {
+            if (_power[k] > _power[peak]) peak = k;
+        }
+        const float p = _power[peak];
+        bool howl = p >= MIN_PEAK && p * (BINS - 1) >= PAPR * total &&
+                    clearAround(2 * peak, p) && clearAround(3 * peak, p) && clearAround(peak / 2, p);
+
+        // A frame that fails the tests only backs the count off, so speech
+        // sitting on top of a building howl does not restart it every time
+        if (!howl) {
+            _stable = std::max(0, _stable - step);
+            if (_stable == 0) _peakBin = -1;
+        } else if (_peakBin >= 0 && std::abs(peak - _peakBin) <= 1) {
+            _stable += step;
+            _peakBin = peak;
+        } else {
+            _stable = step;
+            _peakBin = peak;
+        }
+        if (_stable < HOLD_SAMPLES || _cooldown > 0) return false;
+
+        float a = logf(_power[peak - 1] + 1e-20f);
+        float b = logf(p + 1e-20f);
+        float c = logf(_power[peak + 1] + 1e-20f);
+        float den = a - 2.0f * b + c;
+        float delta = (den < 0.0f) ? std::clamp(0.5f * (a - c) / den, -0.5f, 0.5f) : 0.0f;
+        hz = (peak + delta) * sampleRate / FFT_SIZE;
+        _stable = 0;
+        _cooldown = COOLDOWN_SAMPLES;
+        return true;
     }
 
-    float A = powf(10.0f, gainDb / 40.0f);
-    float w0 = 2.0f * M_PI * freq / sampleRate;
-    float cosw0 = cosf(w0);
-    float sinw0 = sinf(w0);
-    float S = 1.0f;  // Shelf slope
-    float alpha = sinw0 / 2.0f * sqrtf((A + 1.0f/A) * (1.0f/S - 1.0f) + 2.0f);
-    float sqrtA2alpha = 2.0f * sqrtf(A) * alpha;
-
-    float a0 = (A + 1.0f) - (A - 1.0f) * cosw0 + sqrtA2alpha;
-    bq.b0 = (A * ((A + 1.0f) + (A - 1.0f) * cosw0 + sqrtA2alpha)) / a0;
-    bq.b1 = (-2.0f * A * ((A - 1.0f) + (A + 1.0f) * cosw0)) / a0;
-    bq.b2 = (A * ((A + 1.0f) + (A - 1.0f) * cosw0 - sqrtA2alpha)) / a0;
-    bq.a1 = (2.0f * ((A - 1.0f) - (A + 1.0f) * cosw0)) / a0;
-    bq.a2 = ((A + 1.0f) - (A - 1.0f) * cosw0 - sqrtA2alpha) / a0;
-}
+private:
+    // True when bins k-1..k+1 (where they exist) stay PHPR below the peak
+    bool clearAround(int k, float peakPower) const
+    {
+        for (int j = std::max(1, k - 1); j <= std::min(BINS - 1, k + 1); j++) {
+            if (_power[j] * PHPR > peakPower) return false;
+        }
+        return true;
+    }
 
-void AudioEngine::recalcAllCoeffs()
-{
-    // HPF
-    calcHpfCoeffs(_hpfL, _params.hpfFrequency, SAMPLE_RATE);
-    calcHpfCoeffs(_hpfR, _params.hpfFrequency, SAMPLE_RATE);
+    float _hist[FFT_SIZE];
+    float _window[FFT_SIZE];
+    alignas(16) float _fft[2 * FFT_SIZE];
+    float _power[BINS] = {};
+    bool _ready = false;
+    int _pending = 0;   // Samples pushed since the last analysis
+    int _peakBin = -1;
+    int _stable = 0;
+    int _cooldown = 0;
+};
 
-    // LPF
-    calcLpfCoeffs(_lpfL, _params.lpfFrequency, SAMPLE_RATE);
-    calcLpfCoeffs(_lpfR, _params.lpfFrequency, SAMPLE_RATE);
+// ─────────────────────────────────────────────────────────────────────────────
+// Two-mic beamformer (MIC-L / MIC-R → mono front-end)
+//
+// Both mics pass through 4-tap Lagrange fractional delays centred on a fixed
+// base delay, so steering only moves the split between them and the added
+// latency stays constant. Delay-and-sum averages the aligned pair. GSC also
+// forms a blocking branch (aligned L - R, which nulls the look direction) and
+// adapts a short NLMS filter that removes whatever of it leaks into the fixed
+// beam, i.e. off-axis noise.
+// ─────────────────────────────────────────────────────────────────────────────
 
-    // EQ bands (Q = 1.4 for musical EQ)
-    calcPeakEqCoeffs(_eqLowL, 250.0f, _params.eqLowGain, 1.4f, SAMPLE_RATE);
-    calcPeakEqCoeffs(_eqLowR, 250.0f, _params.eqLowGain, 1.4f, SAMPLE_RATE);
+class Beamformer {
+public:
+    static constexpr int MAX_FRAMES = 480;                 // 48kHz samples per pass
+    static constexpr int BASE_DELAY = 8;                   // Centre of the steering range (samples)
+    static constexpr float MAX_LAG = BASE_DELAY - 2.0f;    // Keeps both Lagrange windows in history
+    static constexpr int HIST = 2 * BASE_DELAY + 4;
+    static constexpr int GSC_TAPS = 32;
+    static constexpr int GSC_DELAY = GSC_TAPS / 2;         // Fixed-beam delay so the canceller can be two-sided
 
-    calcPeakEqCoeffs(_eqMidL, 1000.0f, _params.eqMidGain, 1.4f, SAMPLE_RATE);
-    calcPeakEqCoeffs(_eqMidR, 1000.0f, _params.eqMidGain, 1.4f, SAMPLE_RATE);
+    void reset() {
+        std::memset(_workL, 0, sizeof(_workL));
+        std::memset(_workR, 0, sizeof(_workR));
+        std::memset(_blockBuf, 0, sizeof(_blockBuf));
+        std::memset(_beamHist, 0, sizeof(_beamHist));
+        std::memset(_weights, 0, sizeof(_weights));
+        _pos = 0;
+        _beamPos = 0;
+        _power = 0.0f;
+    }
 
-    calcPeakEqCoeffs(_eqHighL, 4000.0f, _params.eqHighGain, 1.4f, SAMPLE_RATE);
-    calcPeakEqCoeffs(_eqHighR, 4000.0f, _params.eqHighGain, 1.4f, SAMPLE_RATE);
+    // lagSamples > 0: sound from the look direction reaches MIC-L first
+    void setSteering(float lagSamples) {
+        lagSamples = std::clamp(lagSamples, -2.0f * MAX_LAG, 2.0f * MAX_LAG);
+        lagrange(BASE_DELAY + 0.5f * lagSamples, _tapsL, _offL);
+        lagrange(BASE_DELAY - 0.5f * lagSamples, _tapsR, _offR);
+    }
 
-    // VE reference signal conditioning filters (mono, applied to HP mic at 48kHz)
-    calcHpfCoeffs(_veRefHpfBq, _params.veRefHpf, SAMPLE_RATE);
-    calcLpfCoeffs(_veRefLpfBq, _params.veRefLpf, SAMPLE_RATE);
+    // out may alias l or r
+    void process(const float* l, const float* r, float* out, int frames, bool adaptive, float stepSize) {
+        std::memcpy(_workL + HIST, l, frames * sizeof(float));
+        std::memcpy(_workR + HIST, r, frames * sizeof(float));
+
+        for (int i = 0; i < frames; i++) {
+            const float* xl = _workL + HIST + i - _offL;  // xl[-k] = L[n - off - k]
+            const float* xr = _workR + HIST + i - _offR;
+            float al = _tapsL[0] * xl[0] + _tapsL[1] * xl[-1] + _tapsL[2] * xl[-2] + _tapsL[3] * xl[-3];
+            float ar = _tapsR[0] * xr[0] + _tapsR[1] * xr[-1] + _tapsR[2] * xr[-2] + _tapsR[3] * xr[-3];
+            float beam = 0.5f * (al + ar);
+
+            if (!adaptive) {
+                out[i] = beam;
+                continue;
+            }
 
-    // Tinnitus relief: Notch filters (6 pairs)
-    for (int i = 0; i < 6; i++) {
-        auto& n = _params.tinnitus.notches[i];
-        if (n.enabled) {
-            calcNotchCoeffs(_notchL[i], n.frequency, n.Q, SAMPLE_RATE);
-            calcNotchCoeffs(_notchR[i], n.frequency, n.Q, SAMPLE_RATE);
-        } else {
-            // Bypass - unity gain
-            _notchL[i].b0 = 1.0f; _notchL[i].b1 = 0.0f; _notchL[i].b2 = 0.0f;
-            _notchL[i].a1 = 0.0f; _notchL[i].a2 = 0.0f;
-            _notchR[i] = _notchL[i];
+            // Blocking branch into the mirrored delay line (newest at _pos)
+            float block = al - ar;
+            _pos = (_pos == 0) ? GSC_TAPS - 1 : _pos - 1;
+            float oldest = _blockBuf[_pos];
+            _blockBuf[_pos] = block;
+            _blockBuf[_pos + GSC_TAPS] = block;
+            _power = std::max(0.0f, _power + block * block - oldest * oldest);
+            const float* u = &_blockBuf[_pos];
+
+            // Fixed beam delayed to the canceller's centre tap
+            float delayed = _beamHist[_beamPos];
+            _beamHist[_beamPos] = beam;
+            _beamPos = (_beamPos + 1 == GSC_DELAY) ? 0 : _beamPos + 1;
+
+            float noise = 0.0f;
+            for (int k = 0; k < GSC_TAPS; k++) noise += _weights[k] * u[k];
+            float e = delayed - noise;
+            out[i] = e;
+
+            float g = stepSize * e / (_power + 1e-6f);
+            for (int k = 0; k < GSC_TAPS; k++) {
+                float w = _weights[k] + g * u[k];
+                _weights[k] = (fabsf(w) > 2.0f) ? w * 0.95f : w;
+            }
         }
+
+        std::memmove(_workL, _workL + frames, HIST * sizeof(float));
+        std::memmove(_workR, _workR + frames, HIST * sizeof(float));
     }
 
-    // Tinnitus relief: High-frequency extension shelf
-    if (_params.tinnitus.hfExtEnabled) {
-        calcHighShelfCoeffs(_hfExtL, _params.tinnitus.hfExtFreq, _params.tinnitus.hfExtGainDb, SAMPLE_RATE);
-        calcHighShelfCoeffs(_hfExtR, _params.tinnitus.hfExtFreq, _params.tinnitus.hfExtGainDb, SAMPLE_RATE);
-    } else {
-        _hfExtL.b0 = 1.0f; _hfExtL.b1 = 0.0f; _hfExtL.b2 = 0.0f;
-        _hfExtL.a1 = 0.0f; _hfExtL.a2 = 0.0f;
-        _hfExtR = _hfExtL;
+private:
+    // Third-order Lagrange fractional delay: y[n] = sum taps[k] * x[n - off - k]
+    static void lagrange(float delay, float* taps, int& off) {
+        off = static_cast<int>(floorf(delay)) - 1;
+        float d = delay - off;  // In [1, 2): the well-conditioned middle of the 4-tap window
+        for (int k = 0; k < 4; k++) {
+            float t = 1.0f;
+            for (int j = 0; j < 4; j++) {
+                if (j != k) t *= (d - j) / static_cast<float>(k - j);
+            }
+            taps[k] = t;
+        }
     }
 
-    // Tinnitus relief: Noise bandpass filters
-    calcHpfCoeffs(_noiseHpfL, _params.tinnitus.noiseLowCut, SAMPLE_RATE);
-    calcHpfCoeffs(_noiseHpfR, _params.tinnitus.noiseLowCut, SAMPLE_RATE);
-    calcLpfCoeffs(_noiseLpfL, _params.tinnitus.noiseHighCut, SAMPLE_RATE);
-    calcLpfCoeffs(_noiseLpfR, _params.tinnitus.noiseHighCut, SAMPLE_RATE);
-}
+    float _workL[HIST + MAX_FRAMES] = {};
+    float _workR[HIST + MAX_FRAMES] = {};
+    float _tapsL[4] = {0.0f, 1.0f, 0.0f, 0.0f};
+    float _tapsR[4] = {0.0f, 1.0f, 0.0f, 0.0f};
+    int _offL = BASE_DELAY - 1;
+    int _offR = BASE_DELAY - 1;
+
+    // GSC state
+    float _blockBuf[2 * GSC_TAPS] = {};  // Mirrored blocking-branch delay line
+    float _beamHist[GSC_DELAY] = {};
+    float _weights[GSC_TAPS] = {};
+    int _pos = 0;
+    int _beamPos = 0;
+    float _power = 0.0f;
+};
 
 // ─────────────────────────────────────────────────────────────────────────────
-// NS handle management
+// Stereo NLMS Adaptive Filter (Voice Exclusion)
+//
+// Both channels cancel the same HP-mic reference, so they share one delay line
+// and one window power; only the weights are per channel. Each sample reads the
+// reference window once for both dot products and once for both weight updates.
 // ─────────────────────────────────────────────────────────────────────────────
 
-static void destroyNsHandles(void*& handleL, void*& handleR)
-{
-    if (handleL) {
-        ns_destroy(static_cast<ns_handle_t>(handleL));
-        handleL = nullptr;
+class StereoNlmsFilter {
+public:
+    void init(int filterLength) {
+        destroy();
+        _len = filterLength;
+        // Per-sample hot loop: internal RAM first, PSRAM only if that is exhausted
+        auto alloc = [](size_t count) {
+            return static_cast<float*>(heap_caps_calloc_prefer(count, sizeof(float), 2,
+                MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+        };
+        _weightsL = alloc(_len);
+        _weightsR = alloc(_len);
+        // Mirrored delay line: every sample is stored at pos and pos + len, so the
+        // newest-first tap window &_refBuf[_pos] is always contiguous
+        _refBuf = alloc(2 * _len);
+        _pos = 0;
+        _power = 0.0f;
     }
-    if (handleR) {
-        ns_destroy(static_cast<ns_handle_t>(handleR));
-        handleR = nullptr;
+
+    void destroy() {
+        heap_caps_free(_weightsL);
+        heap_caps_free(_weightsR);
+        heap_caps_free(_refBuf);
+        _weightsL = nullptr;
+        _weightsR = nullptr;
+        _refBuf = nullptr;
+        _len = 0;
+        _pos = 0;
+        _power = 0.0f;
     }
-}
 
-static void createNsHandles(void*& handleL, void*& handleR, int mode)
-{
-    handleL = ns_pro_create(10, mode, 16000);
-    handleR = ns_pro_create(10, mode, 16000);
-    if (!handleL || !handleR) {
-        mclog::tagError("AudioEngine", "failed to create NS handles (mode={})", mode);
-        destroyNsHandles(handleL, handleR);
-    } else {
-        mclog::tagInfo("AudioEngine", "NS handles created (mode={})", mode);
+    void reset() {
+        if (_weightsL) std::memset(_weightsL, 0, _len * sizeof(float));
+        if (_weightsR) std::memset(_weightsR, 0, _len * sizeof(float));
+        if (_refBuf)   std::memset(_refBuf, 0, 2 * _len * sizeof(float));
+        _pos = 0;
+        _power = 0.0f;
     }
-}
 
-// ─────────────────────────────────────────────────────────────────────────────
-// AGC handle management
-// ─────────────────────────────────────────────────────────────────────────────
+    // Computes the voice estimates (what should be subtracted from each primary).
+    // Weight updates use the true (unclamped) errors for correct convergence.
+    void process(float ref, float primaryL, float primaryR, float stepSize, float& estL, float& estR) {
+        estL = estR = 0.0f;
+        if (!isInitialized() || _len <= 0) return;
 
-static void destroyAgcHandles(void*& handleL, void*& handleR)
-{
-    if (handleL) {
-        esp_agc_close(handleL);
-        handleL = nullptr;
+        // 1. Push reference: step back one slot, the sample leaving the window is there
+        _pos = (_pos == 0) ? _len - 1 : _pos - 1;
+        float oldest = _refBuf[_pos];
+        _refBuf[_pos] = ref;
+        _refBuf[_pos + _len] = ref;
+        const float* x = &_refBuf[_pos];  // x[i] = ref[n - i]
+
+        // 2. Running window power; re-summed once per wrap so rounding can't drift
+        if (_pos == 0) {
+            float sum = 0.0f;
+            for (int i = 0; i < _len; i++) sum += x[i] * x[i];
+            _power = sum;
+        } else {
+            _power = std::max(0.0f, _power + ref * ref - oldest * oldest);
+        }
+
+        // 3. Estimates = dot(weights, window) for both channels
+        dotProduct2(_weightsL, _weightsR, x, _len, estL, estR);
+
+        // 4. Normalized step: stepSize / (power + floor), shared by both channels
+        float normStep = stepSize / (_power + 1e-4f);  // Larger floor for stability during quiet periods
+        const float kL = normStep * (primaryL - estL);
+        const float kR = normStep * (primaryR - estR);
+
+        // 5. Update both weight vectors in one pass. Divergence shows up in the
+        // estimates, which the health monitor checks once per block
+        for (int i = 0; i < _len; i++) {
+            float xi = x[i];
+            _weightsL[i] += kL * xi;
+            _weightsR[i] += kR * xi;
+        }
     }
-    if (handleR) {
-        esp_agc_close(handleR);
-        handleR = nullptr;
+
+    bool isInitialized() const { return _weightsL && _weightsR && _refBuf; }
+    int length() const { return _len; }
+
+    // What a warm start needs: the weights (the window refills within one length)
+    int stateSpans(AdaptiveStore::Span* spans) {
+        if (!isInitialized()) return 0;
+        spans[0] = {_weightsL, static_cast<size_t>(_len)};
+        spans[1] = {_weightsR, static_cast<size_t>(_len)};
+        return 2;
     }
-}
 
-static void createAgcHandles(void*& handleL, void*& handleR, int mode)
+private:
+    static void dotProduct2(const float* wL, const float* wR, const float* x, int len, float& outL, float& outR) {
+#if AUDIO_ENGINE_USE_DSPS_DOTPROD
+        // SIMD kernel twice; the window is L1-resident after the first pass
+        dsps_dotprod_f32(wL, x, &outL, len);
+        dsps_dotprod_f32(wR, x, &outR, len);
+#else
+        // One window load feeds both channels; two accumulators per channel
+        float l0 = 0.0f, l1 = 0.0f, r0 = 0.0f, r1 = 0.0f;
+        int i = 0;
+        for (; i + 2 <= len; i += 2) {
+            float x0 = x[i], x1 = x[i + 1];
+            l0 += wL[i] * x0;
+            l1 += wL[i + 1] * x1;
+            r0 += wR[i] * x0;
+            r1 += wR[i + 1] * x1;
+        }
+        for (; i < len; i++) {
+            l0 += wL[i] * x[i];
+            r0 += wR[i] * x[i];
+        }
+        outL = l0 + l1;
+        outR = r0 + r1;
+#endif
+    }
+
+    float* _weightsL = nullptr;
+    float* _weightsR = nullptr;
+    float* _refBuf = nullptr;  // 2 * _len (mirrored), shared by both channels
+    int _len = 0;
+    int _pos = 0;
+    float _power = 0.0f;       // Sum of squares over the current window
+};
+
+static void destroyNlmsFilter(void*& handle)
 {
-    handleL = esp_agc_open(static_cast<agc_mode_t>(mode), 16000);
-    handleR = esp_agc_open(static_cast<agc_mode_t>(mode), 16000);
-    if (!handleL || !handleR) {
-        mclog::tagError("AudioEngine", "failed to create AGC handles (mode={})", mode);
-        destroyAgcHandles(handleL, handleR);
-    } else {
-        mclog::tagInfo("AudioEngine", "AGC handles created (mode={})", mode);
+    if (handle) {
+        auto* nlms = static_cast<StereoNlmsFilter*>(handle);
+        nlms->destroy();
+        delete nlms;
+        handle = nullptr;
     }
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
-// AEC handle management
+// Two real signals through one complex FFT (FDAF, correction FIR)
+//
+// A forward transform of a + j * b splits into both half spectra. Packing
+// conj(A) + j * conj(B) over the full Hermitian extension makes a forward
+// transform return FFT_N * (a + j * b) in time, so no inverse FFT is needed.
 // ─────────────────────────────────────────────────────────────────────────────
 
-static void destroyAecHandles(void*& handleL, void*& handleR)
-{
-    if (handleL) {
-        aec_destroy(static_cast<aec_handle_t*>(handleL));
-        handleL = nullptr;
+template <int FFT_N>
+struct RealPairFft {
+    static constexpr int HALF = FFT_N / 2;
+    static constexpr int BINS = HALF + 1;  // Non-redundant bins of a real spectrum
+
+    static void transform(float* data) {
+        dsps_fft2r_fc32(data, FFT_N);
+        dsps_bit_rev_fc32(data, FFT_N);
     }
-    if (handleR) {
-        aec_destroy(static_cast<aec_handle_t*>(handleR));
-        handleR = nullptr;
+
+    static void pack(float* fft, const float* a, const float* b) {
+        for (int k = 0; k < FFT_N; k++) {
+            int m = (k <= HALF) ? k : FFT_N - k;
+            float sgn = (k <= HALF) ? 1.0f : -1.0f;  // Upper bins are conjugates
+            float ar = a[2 * m], ai = sgn * a[2 * m + 1];
+            float br = b[2 * m], bi = sgn * b[2 * m + 1];
+            fft[2 * k] = ar + bi;
+            fft[2 * k + 1] = br - ai;
+        }
     }
-}
 
-static void createAecHandles(void*& handleL, void*& handleR, int aecMode, int filterLen)
-{
-    // ESP-SR AEC: aec_create(sample_rate, filter_length, channel_num, mode)
-    // Each handle processes one mono channel
-    handleL = aec_create(16000, filterLen, 1, static_cast<aec_mode_t>(aecMode));
-    handleR = aec_create(16000, filterLen, 1, static_cast<aec_mode_t>(aecMode));
-    if (!handleL || !handleR) {
-        mclog::tagError("AudioEngine", "failed to create AEC handles (mode={}, flen={})", aecMode, filterLen);
-        destroyAecHandles(handleL, handleR);
-    } else {
-        mclog::tagInfo("AudioEngine", "AEC handles created (mode={}, flen={})", aecMode, filterLen);
+    static void unpack(const float* fft, float* a, float* b) {
+        for (int k = 0; k < BINS; k++) {
+            int m = (k == 0) ? 0 : FFT_N - k;
+            float zr = fft[2 * k], zi = fft[2 * k + 1];
+            float mr = fft[2 * m], mi = fft[2 * m + 1];
+            a[2 * k] = 0.5f * (zr + mr);
+            a[2 * k + 1] = 0.5f * (zi - mi);
+            b[2 * k] = 0.5f * (zi + mi);
+            b[2 * k + 1] = -0.5f * (zr - mr);
+        }
     }
-}
+};
 
 // ─────────────────────────────────────────────────────────────────────────────
-// VAD handle management
+// Partitioned-Block Frequency-Domain NLMS (Voice Exclusion, long paths)
+//
+// Overlap-save PBFDAF: the filter is split into P partitions of BLOCK taps,
+// each held as a spectrum, so one block costs a handful of 64-point FFTs plus
+// P complex MACs per bin instead of 2 * taps MACs per sample. Step size is
+// normalized per bin, which also converges faster on coloured speech than the
+// time-domain filter. Both channels share the reference spectra and power, and
+// are carried through the inverse/forward transforms as the real and
+// imaginary halves of one complex FFT. The gradient constraint is applied to
+// one partition per block (rotating), keeping the filter linear-convolution
+// exact without paying 2 * P FFTs every block.
 // ─────────────────────────────────────────────────────────────────────────────
 
-static void destroyVadHandle(void*& handle)
-{
-    if (handle) {
-        vad_destroy(static_cast<vad_handle_t>(handle));
-        handle = nullptr;
+class StereoFdafFilter {
+public:
+    static constexpr int BLOCK = 32;           // Taps per partition; the 160-sample frame is 5 blocks
+    static constexpr int FFT_N = 2 * BLOCK;    // Overlap-save transform size
+    static constexpr int BINS = BLOCK + 1;     // Non-redundant bins of a real spectrum
+
+    void init(int filterLength) {
+        destroy();
+        if (!WolaProcessor::initFftTables()) {
+            mclog::tagError(TAG, "FDAF: FFT table init failed");
+            return;
+        }
+        _partitions = std::max(1, (filterLength + BLOCK - 1) / BLOCK);
+        const size_t specFloats = static_cast<size_t>(_partitions) * BINS * 2;
+        // Touched every block: internal RAM first, PSRAM only if that is exhausted
+        auto alloc = [](size_t count) {
+            return static_cast<float*>(heap_caps_calloc_prefer(count, sizeof(float), 2,
+                MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+        };
+        _refSpec = alloc(specFloats);
+        _weightsL = alloc(specFloats);
+        _weightsR = alloc(specFloats);
+        _power = alloc(BINS);
+        _refPrev = alloc(BLOCK);
+        _fft = static_cast<float*>(heap_caps_aligned_calloc(16, FFT_N * 2, sizeof(float),
+            MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+        _head = 0;
+        _constrainPos = 0;
+    }
+
+    void destroy() {
+        float** bufs[] = {&_refSpec, &_weightsL, &_weightsR, &_power, &_refPrev, &_fft};
+        for (float** b : bufs) {
+            heap_caps_free(*b);
+            *b = nullptr;
+        }
+        _partitions = 0;
+        _head = 0;
+        _constrainPos = 0;
+    }
+
+    void reset() {
+        if (!isInitialized()) return;
+        const size_t specBytes = static_cast<size_t>(_partitions) * BINS * 2 * sizeof(float);
+        std::memset(_refSpec, 0, specBytes);
+        std::memset(_weightsL, 0, specBytes);
+        std::memset(_weightsR, 0, specBytes);
+        std::memset(_power, 0, BINS * sizeof(float));
+        std::memset(_refPrev, 0, BLOCK * sizeof(float));
+        _head = 0;
+        _constrainPos = 0;
+    }
+
+    // Computes the voice estimates for `count` samples (a multiple of BLOCK).
+    // Weight updates use the true (unclamped) errors for correct convergence.
+    void process(const float* ref, const float* primaryL, const float* primaryR, int count,
+                 float stepSize, float* estL, float* estR) {
+        if (!isInitialized()) {
+            std::memset(estL, 0, count * sizeof(float));
+            std::memset(estR, 0, count * sizeof(float));
+            return;
+        }
+        for (int off = 0; off + BLOCK <= count; off += BLOCK) {
+            processBlock(ref + off, primaryL + off, primaryR + off, stepSize, estL + off, estR + off);
+        }
+    }
+
+    bool isInitialized() const { return _refSpec && _weightsL && _weightsR && _power && _refPrev && _fft; }
+    int length() const { return _partitions * BLOCK; }
+
+    // What a warm start needs: the weight spectra, and the bin power so the first
+    // blocks' steps are normalized as before the restart rather than from zero power
+    int stateSpans(AdaptiveStore::Span* spans) {
+        if (!isInitialized()) return 0;
+        const size_t specFloats = static_cast<size_t>(_partitions) * BINS * 2;
+        spans[0] = {_weightsL, specFloats};
+        spans[1] = {_weightsR, specFloats};
+        spans[2] = {_power, static_cast<size_t>(BINS)};
+        return 3;
+    }
+
+private:
+    static constexpr float POWER_SMOOTH = 0.9f;   // Per-bin reference power averaging
+    static constexpr float POWER_FLOOR = 1e-4f;   // Keeps quiet bins from blowing up the step
+
+    float* spectrum(float* base, int partition) const { return base + partition * BINS * 2; }
+
+    using PairFft = RealPairFft<FFT_N>;
+
+    static void fft(float* data) { PairFft::transform(data); }
+    void packInverse(const float* a, const float* b) { PairFft::pack(_fft, a, b); }
+    void unpackForward(float* a, float* b) const { PairFft::unpack(_fft, a, b); }
+
+    void processBlock(const float* ref, const float* primaryL, const float* primaryR, float stepSize,
+                      float* estL, float* estR) {
+        constexpr float invN = 1.0f / FFT_N;
+        const int P = _partitions;
+
+        // 1. Newest reference spectrum: FFT of [previous block, this block]
+        for (int i = 0; i < BLOCK; i++) {
+            _fft[2 * i] = _refPrev[i];
+            _fft[2 * i + 1] = 0.0f;
+            _fft[2 * (BLOCK + i)] = ref[i];
+            _fft[2 * (BLOCK + i) + 1] = 0.0f;
+        }
+        std::memcpy(_refPrev, ref, BLOCK * sizeof(float));
+        fft(_fft);
+        _head = (_head == 0) ? P - 1 : _head - 1;
+        float* x0 = spectrum(_refSpec, _head);
+        std::memcpy(x0, _fft, BINS * 2 * sizeof(float));
+
+        // 2. Smoothed per-bin reference power
+        for (int k = 0; k < BINS; k++) {
+            float p = x0[2 * k] * x0[2 * k] + x0[2 * k + 1] * x0[2 * k + 1];
+            _power[k] = POWER_SMOOTH * _power[k] + (1.0f - POWER_SMOOTH) * p;
+        }
+
+        // 3. Estimates: Y = sum over partitions of W[p] * X[n - p]
+        float yL[BINS * 2] = {};
+        float yR[BINS * 2] = {};
+        for (int p = 0, xi = _head; p < P; p++, xi = (xi + 1 == P) ? 0 : xi + 1) {
+            const float* x = spectrum(_refSpec, xi);
+            const float* wl = spectrum(_weightsL, p);
+            const float* wr = spectrum(_weightsR, p);
+            for (int k = 0; k < BINS; k++) {
+                float xr = x[2 * k], xim = x[2 * k + 1];
+                yL[2 * k]     += wl[2 * k] * xr - wl[2 * k + 1] * xim;
+                yL[2 * k + 1] += wl[2 * k] * xim + wl[2 * k + 1] * xr;
+                yR[2 * k]     += wr[2 * k] * xr - wr[2 * k + 1] * xim;
+                yR[2 * k + 1] += wr[2 * k] * xim + wr[2 * k + 1] * xr;
+            }
+        }
+        packInverse(yL, yR);
+        fft(_fft);
+        // Overlap-save: only the last BLOCK outputs are linear convolution
+        for (int i = 0; i < BLOCK; i++) {
+            estL[i] = _fft[2 * (BLOCK + i)] * invN;
+            estR[i] = _fft[2 * (BLOCK + i) + 1] * invN;
+        }
+
+        // 4. Error spectra of [0, e], both channels in one transform
+        for (int i = 0; i < BLOCK; i++) {
+            _fft[2 * i] = 0.0f;
+            _fft[2 * i + 1] = 0.0f;
+            _fft[2 * (BLOCK + i)] = primaryL[i] - estL[i];
+            _fft[2 * (BLOCK + i) + 1] = primaryR[i] - estR[i];
+        }
+        fft(_fft);
+        float eL[BINS * 2], eR[BINS * 2];
+        unpackForward(eL, eR);
+
+        // 5. Normalized per-bin step. Summing over P partitions behaves like a
+        // P-tap NLMS per bin, so the window power is P times the bin power.
+        for (int k = 0; k < BINS; k++) {
+            float g = stepSize / (P * _power[k] + POWER_FLOOR);
+            eL[2 * k] *= g; eL[2 * k + 1] *= g;
+            eR[2 * k] *= g; eR[2 * k + 1] *= g;
+        }
+
+        // 6. Unconstrained update: W[p] += mu * E * conj(X[n - p])
+        for (int p = 0, xi = _head; p < P; p++, xi = (xi + 1 == P) ? 0 : xi + 1) {
+            const float* x = spectrum(_refSpec, xi);
+            float* wl = spectrum(_weightsL, p);
+            float* wr = spectrum(_weightsR, p);
+            for (int k = 0; k < BINS; k++) {
+                float xr = x[2 * k], xim = x[2 * k + 1];
+                wl[2 * k]     += eL[2 * k] * xr + eL[2 * k + 1] * xim;
+                wl[2 * k + 1] += eL[2 * k + 1] * xr - eL[2 * k] * xim;
+                wr[2 * k]     += eR[2 * k] * xr + eR[2 * k + 1] * xim;
+                wr[2 * k + 1] += eR[2 * k + 1] * xr - eR[2 * k] * xim;
+            }
+        }
+
+        // 7. Gradient constraint on one partition: zero its circular tail in time
+        float* wl = spectrum(_weightsL, _constrainPos);
+        float* wr = spectrum(_weightsR, _constrainPos);
+        packInverse(wl, wr);
+        fft(_fft);
+        for (int i = 0; i < BLOCK; i++) {
+            _fft[2 * i] *= invN;
+            _fft[2 * i + 1] *= invN;
+            _fft[2 * (BLOCK + i)] = 0.0f;
+            _fft[2 * (BLOCK + i) + 1] = 0.0f;
+        }
+        fft(_fft);
+        unpackForward(wl, wr);
+        _constrainPos = (_constrainPos + 1 == P) ? 0 : _constrainPos + 1;
+    }
+
+    float* _refSpec = nullptr;   // P reference spectra (BINS complex each), newest at _head
+    float* _weightsL = nullptr;  // P weight spectra per channel, partition 0 = shortest delay
+    float* _weightsR = nullptr;
+    float* _power = nullptr;     // BINS smoothed |X|^2, shared by both channels
+    float* _refPrev = nullptr;   // Previous reference block (overlap-save history)
+    float* _fft = nullptr;       // FFT_N complex work buffer (16-byte aligned for esp-dsp)
+    int _partitions = 0;
+    int _head = 0;
+    int _constrainPos = 0;
+};
+
+static void destroyFdafFilter(void*& handle)
+{
+    if (handle) {
+        auto* fdaf = static_cast<StereoFdafFilter*>(handle);
+        fdaf->destroy();
+        delete fdaf;
+        handle = nullptr;
+    }
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Subband NLMS (Voice Exclusion, veMode 3)
+//
+// A 16-point sqrt-Hann WOLA bank at hop 8 (2x oversampled) splits the
+// reference and both primaries into 9 complex bands 1kHz apart. Each band runs
+// its own complex NLMS at the decimated rate, taps / HOP long and normalized
+// by its own window power, so every band converges at the rate the loudest
+// one would on coloured speech. Both channels share the reference bands and
+// their power. Per sample that is 9 bands x 2 channels x 8 real MACs x
+// taps / HOP^2, a little over half the time-domain filter's 4 x taps, plus
+// three 16-point FFTs per hop. Bands BAND_GATE under the loudest hold their
+// weights rather than adapt on what the reference LPF left of them.
+// The estimates come out of the synthesis bank LATENCY samples late, so the
+// primaries are delayed in place to match.
+// ─────────────────────────────────────────────────────────────────────────────
+
+class StereoSubbandNlms {
+public:
+    static constexpr int FFT_N = 16;
+    static constexpr int HOP = FFT_N / 2;
+    static constexpr int BANDS = FFT_N / 2 + 1;
+    static constexpr int LATENCY = FFT_N;  // Bus samples, analysis through synthesis
+
+    void init(int filterLength) {
+        destroy();
+        if (!WolaProcessor::initFftTables()) {
+            mclog::tagError(TAG, "subband NLMS: FFT table init failed");
+            return;
+        }
+        _taps = std::max(2, (filterLength + HOP - 1) / HOP);
+        const size_t bandFloats = static_cast<size_t>(BANDS) * _taps * 2;
+        // Touched every hop: internal RAM first, PSRAM only if that is exhausted
+        auto alloc = [](size_t count) {
+            return static_cast<float*>(heap_caps_calloc_prefer(count, sizeof(float), 2,
+                MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+        };
+        _weightsL = alloc(bandFloats);
+        _weightsR = alloc(bandFloats);
+        // Mirrored per band like the time-domain line: the newest-first window is contiguous
+        _refBands = alloc(2 * bandFloats);
+        _fft = static_cast<float*>(heap_caps_aligned_calloc(16, FFT_N * 2, sizeof(float),
+            MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+        for (int n = 0; n < FFT_N; n++) _window[n] = sinf(static_cast<float>(M_PI) * n / FFT_N);
+        clearStreams();
+    }
+
+    void destroy() {
+        float** bufs[] = {&_weightsL, &_weightsR, &_refBands, &_fft};
+        for (float** b : bufs) {
+            heap_caps_free(*b);
+            *b = nullptr;
+        }
+        _taps = 0;
+        clearStreams();
+    }
+
+    void reset() {
+        if (!isInitialized()) return;
+        const size_t bandBytes = static_cast<size_t>(BANDS) * _taps * 2 * sizeof(float);
+        std::memset(_weightsL, 0, bandBytes);
+        std::memset(_weightsR, 0, bandBytes);
+        std::memset(_refBands, 0, 2 * bandBytes);
+        clearStreams();
+    }
+
+    // Computes the voice estimates for `count` samples and delays the primaries in
+    // place by LATENCY to line up with them. Weight updates use the true (unclamped)
+    // errors for correct convergence.
+    void process(const float* ref, float* primaryL, float* primaryR, int count, float stepSize,
+                 float* estL, float* estR) {
+        if (!isInitialized()) {
+            std::memset(estL, 0, count * sizeof(float));
+            std::memset(estR, 0, count * sizeof(float));
+            return;
+        }
+        for (int i = 0; i < count; i++) {
+            estL[i] = _outL[_pos];
+            estR[i] = _outR[_pos];
+            push(ref[i], primaryL[i], primaryR[i]);
+            if (_pos == 0) runFrame(stepSize);
+        }
+    }
+
+    // No estimates, weights held: the primaries keep the same LATENCY so the bus
+    // timing doesn't move (quiet path)
+    void hold(float* primaryL, float* primaryR, int count) {
+        std::memset(_olaL, 0, sizeof(_olaL));
+        std::memset(_olaR, 0, sizeof(_olaR));
+        std::memset(_outL, 0, sizeof(_outL));
+        std::memset(_outR, 0, sizeof(_outR));
+        for (int i = 0; i < count; i++) {
+            push(0.0f, primaryL[i], primaryR[i]);
+            if (_pos == 0) shiftInputs();
+        }
+    }
+
+    bool isInitialized() const { return _weightsL && _weightsR && _refBands && _fft; }
+    int length() const { return _taps * HOP; }
+
+    // What a warm start needs: the band weights (the windows refill within taps hops)
+    int stateSpans(AdaptiveStore::Span* spans) {
+        if (!isInitialized()) return 0;
+        const size_t bandFloats = static_cast<size_t>(BANDS) * _taps * 2;
+        spans[0] = {_weightsL, bandFloats};
+        spans[1] = {_weightsR, bandFloats};
+        return 2;
+    }
+
+private:
+    static constexpr float POWER_FLOOR = 1e-4f;  // Keeps quiet bands from blowing up the step
+    static constexpr float BAND_GATE = 1e-4f;    // -40dB under the loudest band: hold
+
+    using PairFft = RealPairFft<FFT_N>;
+
+    float* band(float* base, int k, int copies) const { return base + static_cast<size_t>(k) * _taps * 2 * copies; }
+
+    void clearStreams() {
+        std::memset(_inRef, 0, sizeof(_inRef));
+        std::memset(_inL, 0, sizeof(_inL));
+        std::memset(_inR, 0, sizeof(_inR));
+        std::memset(_delayL, 0, sizeof(_delayL));
+        std::memset(_delayR, 0, sizeof(_delayR));
+        std::memset(_olaL, 0, sizeof(_olaL));
+        std::memset(_olaR, 0, sizeof(_olaR));
+        std::memset(_outL, 0, sizeof(_outL));
+        std::memset(_outR, 0, sizeof(_outR));
+        std::memset(_power, 0, sizeof(_power));
+        _pos = 0;
+        _head = 0;
+    }
+
+    // One sample in, the delayed primaries out; _pos wraps to 0 when a hop is complete
+    void push(float ref, float& primaryL, float& primaryR) {
+        _inRef[FFT_N - HOP + _pos] = ref;
+        _inL[FFT_N - HOP + _pos] = primaryL;
+        _inR[FFT_N - HOP + _pos] = primaryR;
+        primaryL = _delayL[_pos];
+        primaryR = _delayR[_pos];
+        _pos = (_pos + 1 == HOP) ? 0 : _pos + 1;
+    }
+
+    // The oldest hop of the window is what the finished output hop lines up with
+    void shiftInputs() {
+        std::memcpy(_delayL, _inL, HOP * sizeof(float));
+        std::memcpy(_delayR, _inR, HOP * sizeof(float));
+        std::memmove(_inRef, _inRef + HOP, (FFT_N - HOP) * sizeof(float));
+        std::memmove(_inL, _inL + HOP, (FFT_N - HOP) * sizeof(float));
+        std::memmove(_inR, _inR + HOP, (FFT_N - HOP) * sizeof(float));
+    }
+
+    void runFrame(float stepSize) {
+        // Inverse transform and the overlap of FFT_N / (2 * HOP) squared windows
+        constexpr float synthGain = 2.0f * HOP / (static_cast<float>(FFT_N) * FFT_N);
+
+        // 1. Reference bands into each band's window, with its running power
+        //    (re-summed once per wrap so rounding can't drift)
+        for (int n = 0; n < FFT_N; n++) {
+            _fft[2 * n] = _inRef[n] * _window[n];
+            _fft[2 * n + 1] = 0.0f;
+        }
+        PairFft::transform(_fft);
+        _head = (_head == 0) ? _taps - 1 : _head - 1;
+        float maxPower = 0.0f;
+        for (int k = 0; k < BANDS; k++) {
+            float* line = band(_refBands, k, 2);
+            const float xr = _fft[2 * k], xi = _fft[2 * k + 1];
+            const float oldest = line[2 * _head] * line[2 * _head] + line[2 * _head + 1] * line[2 * _head + 1];
+            line[2 * _head] = line[2 * (_head + _taps)] = xr;
+            line[2 * _head + 1] = line[2 * (_head + _taps) + 1] = xi;
+            if (_head == 0) {
+                float sum = 0.0f;
+                for (int t = 0; t < 2 * _taps; t++) sum += line[t] * line[t];
+                _power[k] = sum;
+            } else {
+                _power[k] = std::max(0.0f, _power[k] + xr * xr + xi * xi - oldest);
+            }
+            maxPower = std::max(maxPower, _power[k]);
+        }
+
+        // 2. Primary bands, both channels in one transform
+        for (int n = 0; n < FFT_N; n++) {
+            _fft[2 * n] = _inL[n] * _window[n];
+            _fft[2 * n + 1] = _inR[n] * _window[n];
+        }
+        PairFft::transform(_fft);
+        float dL[BANDS * 2], dR[BANDS * 2];
+        PairFft::unpack(_fft, dL, dR);
+
+        // 3. Per band: estimate Y = sum W[t] * X[m - t], then W += mu * E * conj(X) / power
+        float yL[BANDS * 2], yR[BANDS * 2];
+        const float gate = BAND_GATE * maxPower;
+        for (int k = 0; k < BANDS; k++) {
+            const float* x = band(_refBands, k, 2) + 2 * _head;
+            float* wl = band(_weightsL, k, 1);
+            float* wr = band(_weightsR, k, 1);
+            float lr = 0.0f, li = 0.0f, rr = 0.0f, ri = 0.0f;
+            for (int t = 0; t < _taps; t++) {
+                const float xr = x[2 * t], xi = x[2 * t + 1];
+                lr += wl[2 * t] * xr - wl[2 * t + 1] * xi;
+                li += wl[2 * t] * xi + wl[2 * t + 1] * xr;
+                rr += wr[2 * t] * xr - wr[2 * t + 1] * xi;
+                ri += wr[2 * t] * xi + wr[2 * t + 1] * xr;
+            }
+            yL[2 * k] = lr; yL[2 * k + 1] = li;
+            yR[2 * k] = rr; yR[2 * k + 1] = ri;
+
+            if (stepSize <= 0.0f || _power[k] <= gate) continue;
+            const float g = stepSize / (_power[k] + POWER_FLOOR);
+            const float elr = g * (dL[2 * k] - lr), eli = g * (dL[2 * k + 1] - li);
+            const float err = g * (dR[2 * k] - rr), eri = g * (dR[2 * k + 1] - ri);
+            for (int t = 0; t < _taps; t++) {
+                const float xr = x[2 * t], xi = x[2 * t + 1];
+                wl[2 * t]     += elr * xr + eli * xi;
+                wl[2 * t + 1] += eli * xr - elr * xi;
+                wr[2 * t]     += err * xr + eri * xi;
+                wr[2 * t + 1] += eri * xr - err * xi;
+            }
+        }
+
+        // 4. Synthesis: both estimates through one transform, windowed, overlap-added
+        PairFft::pack(_fft, yL, yR);
+        PairFft::transform(_fft);
+        for (int n = 0; n < FFT_N; n++) {
+            const float w = _window[n] * synthGain;
+            _olaL[n] += _fft[2 * n] * w;
+            _olaR[n] += _fft[2 * n + 1] * w;
+        }
+        std::memcpy(_outL, _olaL, HOP * sizeof(float));
+        std::memcpy(_outR, _olaR, HOP * sizeof(float));
+        std::memmove(_olaL, _olaL + HOP, (FFT_N - HOP) * sizeof(float));
+        std::memmove(_olaR, _olaR + HOP, (FFT_N - HOP) * sizeof(float));
+        std::memset(_olaL + FFT_N - HOP, 0, HOP * sizeof(float));
+        std::memset(_olaR + FFT_N - HOP, 0, HOP * sizeof(float));
+        shiftInputs();
+    }
+
+    float* _weightsL = nullptr;  // BANDS x taps complex per channel, tap 0 = newest
+    float* _weightsR = nullptr;
+    float* _refBands = nullptr;  // BANDS x 2 * taps complex (mirrored), shared by both channels
+    float* _fft = nullptr;       // FFT_N complex work buffer (16-byte aligned for esp-dsp)
+    float _window[FFT_N] = {};   // sqrt-Hann, analysis and synthesis (squares sum to 1 at hop N / 2)
+    float _inRef[FFT_N], _inL[FFT_N], _inR[FFT_N];  // Last FFT_N samples; the newer half fills
+    float _delayL[HOP], _delayR[HOP];              // Primaries in step with _outL / _outR
+    float _olaL[FFT_N], _olaR[FFT_N];
+    float _outL[HOP], _outR[HOP];                  // Finished estimate hop being played out
+    float _power[BANDS];         // Per-band window power
+    int _taps = 0;               // Per band
+    int _pos = 0;
+    int _head = 0;
+};
+
+static void destroySubbandFilter(void*& handle)
+{
+    if (handle) {
+        auto* subband = static_cast<StereoSubbandNlms*>(handle);
+        subband->destroy();
+        delete subband;
+        handle = nullptr;
+    }
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Adaptive filter warm start (AdaptiveStore)
+//
+// A snapshot is only reused on the path it was learned on. The key folds in
+// the params that scale or colour that path, in coarse steps so a small
+// slider nudge keeps the snapshot (NLMS closes a small gain error quickly;
+// starting from zero is what costs seconds).
+// ─────────────────────────────────────────────────────────────────────────────
+
+static AdaptiveStore::Key adaptiveKey(AdaptiveStore::Kind kind, int taps, const AudioEngineParams& p, bool headphones)
+{
+    uint32_t h = 2166136261u;  // FNV-1a over the quantized params
+    auto mix = [&h](long v) {
+        for (int i = 0; i < 4; i++) {
+            h ^= static_cast<uint32_t>(v >> (8 * i)) & 0xFF;
+            h *= 16777619u;
+        }
+    };
+    auto db = [](float linear) { return std::lround(20.0f * std::log10(std::max(linear, 1e-3f))); };
+    mix(kind);
+    mix(std::lround(p.micGain / 10.0f));  // Scales the primary (VE) and the loop (FBC) alike
+    mix(p.beamMode);
+    if (kind == AdaptiveStore::KIND_FBC) {
+        // Loudspeaker → mic: the codec volume is in the loop, the digital gain is ahead of the loopback
+        mix(p.outputVolume / 5);
+    } else {
+        // HP mic → primary: the reference conditioning is part of what the weights invert
+        mix(db(p.veRefGain));
+        mix(std::lround(p.veRefHpf / 10.0f));
+        mix(std::lround(p.veRefLpf / 100.0f));
+    }
+    AdaptiveStore::Key key;
+    key.taps = static_cast<uint32_t>(taps);
+    key.path = h;
+    key.headphones = headphones;
+    return key;
+}
+
+template <typename Filter>
+static bool warmStartFilter(Filter* filter, AdaptiveStore::Kind kind, const AdaptiveStore::Key& key)
+{
+    AdaptiveStore::Span spans[AdaptiveStore::MAX_SPANS];
+    const int n = filter->stateSpans(spans);
+    return n > 0 && AdaptiveStore::getInstance().restore(kind, key, spans, n);
+}
+
+template <typename Filter>
+static void snapshotFilter(void* handle, AdaptiveStore::Kind kind, const AudioEngineParams& p, bool headphones)
+{
+    if (!handle) return;
+    auto* filter = static_cast<Filter*>(handle);
+    AdaptiveStore::Span spans[AdaptiveStore::MAX_SPANS];
+    const int n = filter->stateSpans(spans);
+    if (n > 0) AdaptiveStore::getInstance().save(kind, adaptiveKey(kind, filter->length(), p, headphones), spans, n);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Correction FIR (8g): headphone correction / linear-phase fitting IRs
+//
+// Uniformly partitioned overlap-save convolution. The IR is cut into P
+// partitions of BLOCK taps, each held as a spectrum, so every BLOCK of output
+// costs one forward and one inverse transform plus P complex MACs per bin,
+// whatever the engine's block size. Both ears share each transform as its real
+// and imaginary halves. Samples are queued in BLOCK frames, which adds BLOCK
+// samples of delay. An IR of SHORT_TAPS or less runs direct-form instead, with
+// no added delay, the taps in internal RAM.
+// Built by create() off the audio task: it allocates and transforms the IR.
+// ─────────────────────────────────────────────────────────────────────────────
+
+class FirConvolver {
+public:
+    static constexpr int BLOCK = 64;          // Taps per partition, 1.3 ms of queueing
+    static constexpr int FFT_N = 2 * BLOCK;
+    static constexpr int BINS = BLOCK + 1;
+    static constexpr int SHORT_TAPS = 32;     // Direct form up to about the cost of the two transforms
+    static constexpr int MAX_TAPS = 2048;
+
+    // nullptr if the IR is empty or not finite, or memory is short
+    static FirConvolver* create(const float* irL, const float* irR, int taps) {
+        if (taps <= 0) return nullptr;
+        taps = std::min(taps, MAX_TAPS);
+        for (int i = 0; i < taps; i++) {
+            if (!std::isfinite(irL[i]) || !std::isfinite(irR[i])) return nullptr;
+        }
+        auto* fir = new FirConvolver();
+        const bool ok = taps <= SHORT_TAPS ? fir->initDirect(irL, irR, taps) : fir->initPartitioned(irL, irR, taps);
+        if (!ok) {
+            delete fir;
+            return nullptr;
+        }
+        return fir;
+    }
+
+    ~FirConvolver() {
+        float** bufs[] = {&_ir[0], &_ir[1], &_hist[0], &_hist[1], &_spec[0], &_spec[1], &_inSpec[0], &_inSpec[1],
+                          &_prev[0], &_prev[1], &_inQ[0], &_inQ[1], &_outQ[0], &_outQ[1], &_fft};
+        for (float** b : bufs) heap_caps_free(*b);
+    }
+
+    void reset() {
+        if (_partitions == 0) {
+            for (int c = 0; c < 2; c++) std::memset(_hist[c], 0, 2 * _taps * sizeof(float));
+            _pos = 0;
+            return;
+        }
+        const size_t specBytes = static_cast<size_t>(_partitions) * BINS * 2 * sizeof(float);
+        for (int c = 0; c < 2; c++) {
+            std::memset(_inSpec[c], 0, specBytes);
+            std::memset(_prev[c], 0, BLOCK * sizeof(float));
+            std::memset(_inQ[c], 0, BLOCK * sizeof(float));
+            std::memset(_outQ[c], 0, BLOCK * sizeof(float));
+        }
+        _fill = 0;
+        _head = 0;
+    }
+
+    void process(float* left, float* right, int frames) {
+        if (_partitions == 0) {
+            processDirect(left, right, frames);
+            return;
+        }
+        while (frames > 0) {
+            // In goes to the queue, out comes the block convolved BLOCK samples ago
+            const int n = std::min(frames, BLOCK - _fill);
+            std::memcpy(_inQ[0] + _fill, left, n * sizeof(float));
+            std::memcpy(_inQ[1] + _fill, right, n * sizeof(float));
+            std::memcpy(left, _outQ[0] + _fill, n * sizeof(float));
+            std::memcpy(right, _outQ[1] + _fill, n * sizeof(float));
+            _fill += n;
+            left += n;
+            right += n;
+            frames -= n;
+            if (_fill == BLOCK) {
+                convolveBlock();
+                _fill = 0;
+            }
+        }
+    }
+
+    int taps() const { return _taps; }
+    int latencySamples() const { return _partitions > 0 ? BLOCK : 0; }
+
+private:
+    using PairFft = RealPairFft<FFT_N>;
+
+    FirConvolver() = default;
+
+    float* spectrum(float* base, int partition) const { return base + partition * BINS * 2; }
+
+    bool initDirect(const float* irL, const float* irR, int taps) {
+        _taps = taps;
+        // Read for every output sample: internal RAM only
+        auto alloc = [](size_t count) {
+            return static_cast<float*>(heap_caps_calloc(count, sizeof(float), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+        };
+        for (int c = 0; c < 2; c++) {
+            _ir[c] = alloc(taps);
+            // Mirrored like the NLMS delay line: &_hist[c][_pos] is the newest-first window
+            _hist[c] = alloc(2 * taps);
+            if (!_ir[c] || !_hist[c]) return false;
+        }
+        std::memcpy(_ir[0], irL, taps * sizeof(float));
+        std::memcpy(_ir[1], irR, taps * sizeof(float));
+        return true;
+    }
+
+    bool initPartitioned(const float* irL, const float* irR, int taps) {
+        if (!WolaProcessor::initFftTables()) {
+            mclog::tagError(TAG, "correction FIR: FFT table init failed");
+            return false;
+        }
+        _taps = taps;
+        _partitions = (taps + BLOCK - 1) / BLOCK;
+        const size_t specFloats = static_cast<size_t>(_partitions) * BINS * 2;
+        // Touched every BLOCK: internal RAM first, PSRAM only if that is exhausted
+        auto alloc = [](size_t count) {
+            return static_cast<float*>(heap_caps_calloc_prefer(count, sizeof(float), 2,
+                MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+        };
+        for (int c = 0; c < 2; c++) {
+            _spec[c] = alloc(specFloats);
+            _inSpec[c] = alloc(specFloats);
+            _prev[c] = alloc(BLOCK);
+            _inQ[c] = alloc(BLOCK);
+            _outQ[c] = alloc(BLOCK);
+            if (!_spec[c] || !_inSpec[c] || !_prev[c] || !_inQ[c] || !_outQ[c]) return false;
+        }
+        _fft = static_cast<float*>(heap_caps_aligned_calloc(16, FFT_N * 2, sizeof(float),
+            MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+        if (!_fft) return false;
+
+        // Partition spectra of [h[pB .. pB + B - 1], 0 ... 0], both ears per transform
+        for (int p = 0; p < _partitions; p++) {
+            std::memset(_fft, 0, FFT_N * 2 * sizeof(float));
+            for (int i = 0; i < BLOCK && p * BLOCK + i < taps; i++) {
+                _fft[2 * i] = irL[p * BLOCK + i];
+                _fft[2 * i + 1] = irR[p * BLOCK + i];
+            }
+            PairFft::transform(_fft);
+            PairFft::unpack(_fft, spectrum(_spec[0], p), spectrum(_spec[1], p));
+        }
+        return true;
+    }
+
+    static float dot(const float* h, const float* x, int len) {
+#if AUDIO_ENGINE_USE_DSPS_DOTPROD
+        float out;
+        dsps_dotprod_f32(h, x, &out, len);
+        return out;
+#else
+        float a0 = 0.0f, a1 = 0.0f;
+        int i = 0;
+        for (; i + 2 <= len; i += 2) {
+            a0 += h[i] * x[i];
+            a1 += h[i + 1] * x[i + 1];
+        }
+        for (; i < len; i++) a0 += h[i] * x[i];
+        return a0 + a1;
+#endif
+    }
+
+    void processDirect(float* left, float* right, int frames) {
+        float* bufs[2] = {left, right};
+        for (int i = 0; i < frames; i++) {
+            _pos = (_pos == 0) ? _taps - 1 : _pos - 1;
+            for (int c = 0; c < 2; c++) {
+                _hist[c][_pos] = bufs[c][i];
+                _hist[c][_pos + _taps] = bufs[c][i];
+                bufs[c][i] = dot(_ir[c], &_hist[c][_pos], _taps);
+            }
+        }
+    }
+
+    void convolveBlock() {
+        constexpr float invN = 1.0f / FFT_N;
+        const int P = _partitions;
+
+        // 1. Newest input spectra: FFT of [previous block, this block], left + j * right
+        for (int i = 0; i < BLOCK; i++) {
+            _fft[2 * i] = _prev[0][i];
+            _fft[2 * i + 1] = _prev[1][i];
+            _fft[2 * (BLOCK + i)] = _inQ[0][i];
+            _fft[2 * (BLOCK + i) + 1] = _inQ[1][i];
+        }
+        std::memcpy(_prev[0], _inQ[0], BLOCK * sizeof(float));
+        std::memcpy(_prev[1], _inQ[1], BLOCK * sizeof(float));
+        PairFft::transform(_fft);
+        _head = (_head == 0) ? P - 1 : _head - 1;
+        PairFft::unpack(_fft, spectrum(_inSpec[0], _head), spectrum(_inSpec[1], _head));
+
+        // 2. Y = sum over partitions of H[p] * X[n - p], per ear
+        float y[2][BINS * 2] = {};
+        for (int c = 0; c < 2; c++) {
+            float* yc = y[c];
+            for (int p = 0, xi = _head; p < P; p++, xi = (xi + 1 == P) ? 0 : xi + 1) {
+                const float* x = spectrum(_inSpec[c], xi);
+                const float* h = spectrum(_spec[c], p);
+                for (int k = 0; k < BINS; k++) {
+                    float xr = x[2 * k], xim = x[2 * k + 1];
+                    yc[2 * k]     += h[2 * k] * xr - h[2 * k + 1] * xim;
+                    yc[2 * k + 1] += h[2 * k] * xim + h[2 * k + 1] * xr;
+                }
+            }
+        }
+
+        // 3. Back to time; overlap-save keeps the last BLOCK outputs (linear convolution)
+        PairFft::pack(_fft, y[0], y[1]);
+        PairFft::transform(_fft);
+        for (int i = 0; i < BLOCK; i++) {
+            _outQ[0][i] = _fft[2 * (BLOCK + i)] * invN;
+            _outQ[1][i] = _fft[2 * (BLOCK + i) + 1] * invN;
+        }
+    }
+
+    float* _ir[2] = {};      // Direct form: taps per ear, internal RAM
+    float* _hist[2] = {};    // Direct form: 2 * taps mirrored history per ear
+    float* _spec[2] = {};    // Partitioned: P IR spectra per ear, partition 0 = shortest delay
+    float* _inSpec[2] = {};  // Partitioned: P input spectra per ear, newest at _head
+    float* _prev[2] = {};    // Previous input block (overlap-save history)
+    float* _inQ[2] = {};     // Input frame being filled
+    float* _outQ[2] = {};    // Output of the last frame, drained while the next fills
+    float* _fft = nullptr;   // FFT_N complex work buffer (16-byte aligned for esp-dsp)
+    int _taps = 0;
+    int _partitions = 0;     // 0 = direct form
+    int _pos = 0;
+    int _fill = 0;
+    int _head = 0;
+};
+
+static void destroyFirConvolver(void*& handle)
+{
+    delete static_cast<FirConvolver*>(handle);
+    handle = nullptr;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Singleton
+// ─────────────────────────────────────────────────────────────────────────────
+
+AudioEngine& AudioEngine::getInstance()
+{
+    static AudioEngine instance;
+    return instance;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Frequency lowering (nonlinear frequency compression, WOLA client)
+// ─────────────────────────────────────────────────────────────────────────────
+
+namespace {
+
+constexpr float TWO_PI = 2.0f * static_cast<float>(M_PI);
+
+inline float wrapPhase(float x)
+{
+    return x - TWO_PI * floorf(x * (1.0f / TWO_PI) + 0.5f);
+}
+
+// |error| < 1e-5 rad
+inline float fastAtan2(float y, float x)
+{
+    float ax = fabsf(x), ay = fabsf(y);
+    float hi = std::max(ax, ay);
+    if (hi == 0.0f) return 0.0f;
+    float z = std::min(ax, ay) / hi;
+    float z2 = z * z;
+    float a = z * (0.99997726f + z2 * (-0.33262347f + z2 * (0.19354346f +
+                   z2 * (-0.11643287f + z2 * (0.05265332f + z2 * -0.01172120f)))));
+    if (ay > ax) a = 0.5f * static_cast<float>(M_PI) - a;
+    if (x < 0.0f) a = static_cast<float>(M_PI) - a;
+    return (y < 0.0f) ? -a : a;
+}
+
+}  // namespace
+
+void AudioEngine::FrequencyCompressor::configure(float cutoffHz, float ratio)
+{
+    if (cutoffHz == _cutoffHz && ratio == _ratio) return;
+    _cutoffHz = cutoffHz;
+    _ratio = std::max(ratio, 1.0f);
+    _dirty = true;
+}
+
+void AudioEngine::FrequencyCompressor::reset()
+{
+    std::memset(_anaPhase, 0, sizeof(_anaPhase));
+    std::memset(_synPhase, 0, sizeof(_synPhase));
+}
+
+void AudioEngine::FrequencyCompressor::rebuild(int bins, float binHz)
+{
+    _bins = std::min(bins, MAX_BINS);
+    _binHz = binHz;
+    _firstBin = std::min(_bins, static_cast<int>(ceilf(_cutoffHz / binHz)));
+    const float inv = 1.0f / _ratio;
+    for (int k = _firstBin; k < _bins; k++) {
+        // f_out = fc * (f / fc)^(1 / ratio), in bins; slope = d f_out / d f
+        float rel = k * binHz / _cutoffHz;
+        float pw = powf(rel, inv);
+        _mapBin[k] = _cutoffHz * pw / binHz;
+        _mapSlope[k] = inv * pw / rel;
+    }
+    reset();
+    _dirty = false;
+}
+
+void AudioEngine::FrequencyCompressor::processFrame(void* ctx, WolaProcessor::Frame& frame)
+{
+    auto* self = static_cast<FrequencyCompressor*>(ctx);
+    if (self->_dirty || frame.bins != self->_bins || frame.binHz != self->_binHz) {
+        self->rebuild(frame.bins, frame.binHz);
+    }
+    self->compress(frame.left, 0, frame.bins, frame.hop);
+    self->compress(frame.right, 1, frame.bins, frame.hop);
+}
+
+void AudioEngine::FrequencyCompressor::compress(float* spec, int ch, int bins, int hop)
+{
+    const int first = _firstBin;
+    if (first >= _bins) return;
+    const int fftSize = 2 * (bins - 1);
+    const float advance = TWO_PI * hop / fftSize;   // Phase per hop of a bin-centred tone, per bin
+    const float toBins = 1.0f / advance;             // Phase deviation per hop → bins
+    float* anaPhase = _anaPhase[ch];
+    float* synPhase = _synPhase[ch];
+
+    for (int j = first; j < _bins; j++) _power[j] = _peak[j] = 0.0f;
+
+    // Analysis: instantaneous frequency of every source bin, mapped down
+    for (int k = first; k < _bins; k++) {
+        float re = spec[2 * k], im = spec[2 * k + 1];
+        float p = re * re + im * im;
+        float ph = fastAtan2(im, re);
+        float dev = wrapPhase(ph - anaPhase[k] - advance * k) * toBins;
+        anaPhase[k] = ph;
+        float m = _mapBin[k] + _mapSlope[k] * dev;
+        int j = static_cast<int>(m + 0.5f);
+        if (j >= _bins) continue;
+        j = std::max(j, first);
+        _power[j] += p;
+        if (p > _peak[j]) {
+            _peak[j] = p;
+            _freqBin[j] = m;
+        }
+    }
+
+    // Synthesis: power-preserving magnitude, phase advanced at the mapped frequency
+    for (int j = first; j < _bins; j++) {
+        if (_power[j] <= 0.0f) {
+            spec[2 * j] = spec[2 * j + 1] = 0.0f;
+            continue;
+        }
+        float ph = wrapPhase(synPhase[j] + advance * _freqBin[j]);
+        synPhase[j] = ph;
+        float s, c;
+        fastSinCos(ph, s, c);
+        float mag = sqrtf(_power[j]);
+        spec[2 * j] = mag * c;
+        spec[2 * j + 1] = mag * s;
+    }
+}
+
+void AudioEngine::recalcEarCoeffs(BiquadCascade& input, BiquadCascade& tinnitus, const EarParams& e,
+                                  const EarParams& o, bool all)
+{
+    Biquad bq;
+
+    // HPF / LPF
+    if (all || e.hpfEnabled != o.hpfEnabled || e.hpfFrequency != o.hpfFrequency) {
+        calcHpfCoeffs(bq, e.hpfFrequency, _sampleRate);
+        input.setSection(SLOT_HPF, bq, e.hpfEnabled);
+    }
+    if (all || e.lpfEnabled != o.lpfEnabled || e.lpfFrequency != o.lpfFrequency) {
+        calcLpfCoeffs(bq, e.lpfFrequency, _sampleRate);
+        input.setSection(SLOT_LPF, bq, e.lpfEnabled);
+    }
+
+    // EQ bands (Q = 1.4 for musical EQ); 0 dB bands are dropped from the cascade
+    if (all || e.eqLowGain != o.eqLowGain) {
+        calcFixedEqCoeffs(bq, 0, e.eqLowGain, _sampleRate);
+        input.setSection(SLOT_EQ_LOW, bq, true);
+    }
+    if (all || e.eqMidGain != o.eqMidGain) {
+        calcFixedEqCoeffs(bq, 1, e.eqMidGain, _sampleRate);
+        input.setSection(SLOT_EQ_MID, bq, true);
+    }
+    if (all || e.eqHighGain != o.eqHighGain) {
+        calcFixedEqCoeffs(bq, 2, e.eqHighGain, _sampleRate);
+        input.setSection(SLOT_EQ_HIGH, bq, true);
+    }
+
+    // Tinnitus relief: Notch filters (6 pairs)
+    for (int i = 0; i < 6; i++) {
+        auto& n = e.notches[i];
+        auto& on = o.notches[i];
+        if (all || n.enabled != on.enabled || n.frequency != on.frequency || n.Q != on.Q) {
+            calcNotchCoeffs(bq, n.frequency, n.Q, _sampleRate);
+            tinnitus.setSection(SLOT_NOTCH0 + i, bq, n.enabled);
+        }
+    }
+}
+
+void AudioEngine::recalcAllCoeffs(const AudioEngineParams& p)
+{
+    // Only recompute sections whose inputs moved since the last call
+    const AudioEngineParams& o = _coeffParams;
+    const bool all = !_coeffParamsValid;
+    Biquad bq;
+
+    // Per-ear sections. Linked, the left ear's block is computed once into the stereo
+    // cascades; unlinked, the right ear gets a pair of its own and each side runs mono
+    const bool split = !p.earsLinked;
+    const bool splitChanged = all || split != _earsSplit;
+    if (split && !_earsSplit) {
+        // The right lane leaves with its history and glides from the shared sections to its own
+        _inputCascadeR.takeChannel(_inputCascade, 1, 0, true);
+        _tinnitusCascadeR.takeChannel(_tinnitusCascade, 1, 0, true);
+    } else if (!split && _earsSplit) {
+        _inputCascade.takeChannel(_inputCascadeR, 0, 1, false);
+        _tinnitusCascade.takeChannel(_tinnitusCascadeR, 0, 1, false);
+    }
+    _earsSplit = split;
+    recalcEarCoeffs(_inputCascade, _tinnitusCascade, p.ear(AUDIO_EAR_LEFT), o.ear(AUDIO_EAR_LEFT), all);
+    if (split) {
+        recalcEarCoeffs(_inputCascadeR, _tinnitusCascadeR, p.rightEar, o.ear(AUDIO_EAR_RIGHT), splitChanged);
+    }
+
+    // VE reference signal conditioning filters (mono, applied to HP mic at 48kHz)
+    if (all || p.veRefHpf != o.veRefHpf) {
+        calcHpfCoeffs(_veRefHpfBq, p.veRefHpf, _sampleRate);
+    }
+    if (all || p.veRefLpf != o.veRefLpf) {
+        calcLpfCoeffs(_veRefLpfBq, p.veRefLpf, _sampleRate);
+    }
+
+    // Tinnitus relief: High-frequency extension shelf (not per ear, so both right-ear places get it)
+    if (splitChanged || p.tinnitus.hfExtEnabled != o.tinnitus.hfExtEnabled ||
+        p.tinnitus.hfExtFreq != o.tinnitus.hfExtFreq || p.tinnitus.hfExtGainDb != o.tinnitus.hfExtGainDb) {
+        calcHighShelfCoeffs(bq, p.tinnitus.hfExtFreq, p.tinnitus.hfExtGainDb, _sampleRate);
+        _tinnitusCascade.setSection(SLOT_HF_EXT, bq, p.tinnitus.hfExtEnabled);
+        _tinnitusCascadeR.setSection(SLOT_HF_EXT, bq, p.tinnitus.hfExtEnabled);
+    }
+
+    // Tinnitus relief: Noise bandpass filters
+    if (all || p.tinnitus.noiseLowCut != o.tinnitus.noiseLowCut) {
+        calcHpfCoeffs(bq, p.tinnitus.noiseLowCut, _sampleRate);
+        _noiseCascade.setSection(SLOT_NOISE_HPF, bq, true);
+    }
+    if (all || p.tinnitus.noiseHighCut != o.tinnitus.noiseHighCut) {
+        calcLpfCoeffs(bq, p.tinnitus.noiseHighCut, _sampleRate);
+        _noiseCascade.setSection(SLOT_NOISE_LPF, bq, true);
+    }
+
+    // Multiband compressor: crossover splits (kept ascending, ≥ 1/2 octave apart) and band curves
+    const DynamicsParams& d = p.dynamics;
+    const DynamicsParams& od = o.dynamics;
+    if (all || d.mbcBands != od.mbcBands ||
+        std::memcmp(d.crossoverHz, od.crossoverHz, sizeof(d.crossoverHz)) != 0) {
+        _mbc.setBandCount(d.mbcBands);
+        float prev = 0.0f;
+        for (int s = 0; s < MultibandDynamics::MAX_BANDS - 1; s++) {
+            float fc = std::clamp(std::max(d.crossoverHz[s], prev * 1.414f), 40.0f, 18000.0f);
+            Biquad lp, hp, ap;
+            calcLpfCoeffs(lp, fc, _sampleRate);
+            calcHpfCoeffs(hp, fc, _sampleRate);
+            calcAllpassCoeffs(ap, fc, _sampleRate);
+            _mbc.setSplit(s, lp, hp, ap);
+            prev = fc;
+        }
+    }
+    for (int k = 0; k < MultibandDynamics::MAX_BANDS; k++) {
+        const auto& b = d.bands[k];
+        const auto& ob = od.bands[k];
+        if (all || b.thresholdDb != ob.thresholdDb || b.ratio != ob.ratio || b.attackMs != ob.attackMs ||
+            b.releaseMs != ob.releaseMs || b.makeupDb != ob.makeupDb) {
+            _mbc.setBand(k, b.thresholdDb, b.ratio, b.attackMs, b.releaseMs, b.makeupDb, _sampleRate);
+        }
+    }
+
+    // Hearing-loss fitting: each band's curve from the audiogram at its centre frequency
+    const FittingParams& fit = p.fitting;
+    const FittingParams& ofit = o.fitting;
+    const bool layoutChanged = all || fit.wdrcBands != ofit.wdrcBands;
+    if (layoutChanged) {
+        _wdrc.setLayout(fit.wdrcBands, FittingParams::FREQS_HZ[0],
+                        FittingParams::FREQS_HZ[FittingParams::NUM_FREQS - 1], _sampleRate);
+    }
+    if (layoutChanged || fit.calibrationDbSpl != ofit.calibrationDbSpl || fit.maxGainDb != ofit.maxGainDb ||
+        std::memcmp(fit.audiogramL, ofit.audiogramL, sizeof(fit.audiogramL)) != 0 ||
+        std::memcmp(fit.audiogramR, ofit.audiogramR, sizeof(fit.audiogramR)) != 0) {
+        const float kneeDbfs = WDRC_KNEE_SPL - fit.calibrationDbSpl;
+        for (int ear = 0; ear < 2; ear++) {
+            const float* hl = ear == 0 ? fit.audiogramL : fit.audiogramR;
+            for (int k = 0; k < _wdrc.bandCount(); k++) {
+                WdrcFit band = fitWdrcBand(
+                    audiogramAt(FittingParams::FREQS_HZ, hl, FittingParams::NUM_FREQS, _wdrc.centerHz(k)),
+                    fit.maxGainDb);
+                _wdrc.setCurve(ear, k, kneeDbfs, band.gainDb, band.ratio, fit.maxGainDb);
+            }
+        }
+    }
+    if (all || fit.attackMs != ofit.attackMs || fit.releaseMs != ofit.releaseMs) {
+        _wdrc.setTiming(fit.attackMs, fit.releaseMs, _sampleRate);
+    }
+
+    _coeffParams = p;
+    _coeffParamsValid = true;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// NS handle management
+// ─────────────────────────────────────────────────────────────────────────────
+
+static void destroyNsHandles(void*& handleL, void*& handleR)
+{
+    if constexpr (!audio_stages::NS) return;
+    if (handleL) {
+        ns_destroy(static_cast<ns_handle_t>(handleL));
+        handleL = nullptr;
+    }
+    if (handleR) {
+        ns_destroy(static_cast<ns_handle_t>(handleR));
+        handleR = nullptr;
+    }
+}
+
+static void createNsHandles(void*& handleL, void*& handleR, int mode)
+{
+    if constexpr (!audio_stages::NS) return;
+    handleL = ns_pro_create(10, mode, 16000);
+    handleR = ns_pro_create(10, mode, 16000);
+    if (!handleL || !handleR) {
+        mclog::tagError("AudioEngine", "failed to create NS handles (mode={})", mode);
+        destroyNsHandles(handleL, handleR);
+    } else {
+        mclog::tagInfo("AudioEngine", "NS handles created (mode={})", mode);
+    }
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// AGC handle management
+// ─────────────────────────────────────────────────────────────────────────────
+
+static void destroyAgcHandles(void*& handleL, void*& handleR)
+{
+    if constexpr (!audio_stages::AGC) return;
+    if (handleL) {
+        esp_agc_close(handleL);
+        handleL = nullptr;
+    }
+    if (handleR) {
+        esp_agc_close(handleR);
+        handleR = nullptr;
+    }
+}
+
+static void createAgcHandles(void*& handleL, void*& handleR, int mode)
+{
+    if constexpr (!audio_stages::AGC) return;
+    handleL = esp_agc_open(static_cast<agc_mode_t>(mode), 16000);
+    handleR = esp_agc_open(static_cast<agc_mode_t>(mode), 16000);
+    if (!handleL || !handleR) {
+        mclog::tagError("AudioEngine", "failed to create AGC handles (mode={})", mode);
+        destroyAgcHandles(handleL, handleR);
+    } else {
+        mclog::tagInfo("AudioEngine", "AGC handles created (mode={})", mode);
+    }
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// AEC handle management
+// ─────────────────────────────────────────────────────────────────────────────
+
+static void destroyAecHandles(void*& handleL, void*& handleR)
+{
+    if constexpr (!audio_stages::AEC) return;
+    if (handleL) {
+        aec_destroy(static_cast<aec_handle_t*>(handleL));
+        handleL = nullptr;
+    }
+    if (handleR) {
+        aec_destroy(static_cast<aec_handle_t*>(handleR));
+        handleR = nullptr;
+    }
+}
+
+static void createAecHandles(void*& handleL, void*& handleR, int aecMode, int filterLen, bool shared)
+{
+    if constexpr (!audio_stages::AEC) return;
+    // ESP-SR AEC: aec_create(sample_rate, filter_length, channel_num, mode)
+    // Shared: one two-mic handle (interleaved L/R) reusing the reference
+    // spectrum and far-end state; otherwise one mono handle per channel
+    if (shared) {
+        handleL = aec_create(16000, filterLen, 2, static_cast<aec_mode_t>(aecMode));
+    } else {
+        handleL = aec_create(16000, filterLen, 1, static_cast<aec_mode_t>(aecMode));
+        handleR = aec_create(16000, filterLen, 1, static_cast<aec_mode_t>(aecMode));
+    }
+    if (!handleL || (!shared && !handleR)) {
+        mclog::tagError("AudioEngine", "failed to create AEC handles (mode={}, flen={}, shared={})",
+            aecMode, filterLen, shared);
+        destroyAecHandles(handleL, handleR);
+    } else {
+        mclog::tagInfo("AudioEngine", "AEC handles created (mode={}, flen={}, shared={})", aecMode, filterLen, shared);
+    }
+}
+
+// AEC worker config word: what the audio task wants the worker's handles to be
+static int packAecConfig(int aecMode, int filterLen, bool shared)
+{
+    return (shared ? 0x100 : 0) | ((aecMode & 0xF) << 4) | (filterLen & 0xF);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// AFE bus handle management
+// ─────────────────────────────────────────────────────────────────────────────
+
+// busAfe: the same worker config word, flagged, with the AFE's stages in it
+static constexpr int AFE_CONFIG = 0x200;
+static constexpr int AFE_CONFIG_AEC = 0x400;
+static constexpr int AFE_CONFIG_NS = 0x800;
+static constexpr int AFE_CONFIG_AGC = 0x1000;
+
+static int packAfeConfig(bool aec, bool ns, bool agc, int aecMode, int filterLen, int agcGainDb, int agcTargetDbfs)
+{
+    return AFE_CONFIG | (aec ? AFE_CONFIG_AEC : 0) | (ns ? AFE_CONFIG_NS : 0) | (agc ? AFE_CONFIG_AGC : 0) |
+           ((std::clamp(agcGainDb, 0, 90) & 0x7F) << 13) | ((std::clamp(-agcTargetDbfs, 0, 31) & 0x1F) << 20) |
+           ((aecMode & 0xF) << 4) | (filterLen & 0xF);
+}
+
+// The interface table goes with the instance
+struct AfeHandle {
+    const esp_afe_sr_iface_t* iface = nullptr;
+    esp_afe_sr_data_t* data = nullptr;
+    int feedChunk = 0;  // Frames per feed(), each a (mic, ref) pair
+};
+
+static void destroyAfeHandle(AfeHandle& afe)
+{
+    if constexpr (!audio_stages::AFE) return;
+    if (afe.data) afe.iface->destroy(afe.data);
+    afe = AfeHandle{};
+}
+
+static void createAfeHandle(AfeHandle& afe, int config, int frame)
+{
+    if constexpr (!audio_stages::AFE) return;
+    const int aecMode = (config >> 4) & 0xF;
+    const bool highPerf = aecMode == AEC_MODE_SR_HIGH_PERF || aecMode == AEC_MODE_VOIP_HIGH_PERF;
+    // "MR": one mic, then the reference. No model list: WebRTC NS and AGC, and no
+    // wake word or vadnet, whose models this image doesn't flash
+    afe_config_t* cfg = afe_config_init("MR", nullptr, AFE_TYPE_VC, highPerf ? AFE_MODE_HIGH_PERF : AFE_MODE_LOW_COST);
+    if (!cfg) {
+        mclog::tagError("AudioEngine", "AFE config failed (config={:#x})", config);
+        return;
+    }
+    cfg->aec_init = (config & AFE_CONFIG_AEC) != 0;
+    cfg->aec_mode = static_cast<decltype(cfg->aec_mode)>(aecMode);
+    cfg->aec_filter_length = config & 0xF;
+    cfg->se_init = false;
+    cfg->ns_init = (config & AFE_CONFIG_NS) != 0;
+    cfg->afe_ns_mode = AFE_NS_MODE_WEBRTC;
+    cfg->agc_init = (config & AFE_CONFIG_AGC) != 0;
+    cfg->agc_mode = AFE_AGC_MODE_WEBRTC;
+    cfg->agc_compression_gain_db = (config >> 13) & 0x7F;
+    cfg->agc_target_level_dbfs = (config >> 20) & 0x1F;
+    cfg->vad_init = false;
+    cfg->wakenet_init = false;
+    cfg->afe_perferred_core = 0;  // The worker's core; feed() and fetch() both run on it
+    cfg->memory_alloc_mode = AFE_MEMORY_ALLOC_MORE_PSRAM;
+
+    afe.iface = esp_afe_handle_from_config(cfg);
+    afe.data = afe.iface ? afe.iface->create_from_config(cfg) : nullptr;
+    afe_config_free(cfg);
+    if (afe.data) afe.feedChunk = afe.iface->get_feed_chunksize(afe.data);
+    // Bridge frames are fed whole, in feed-sized pieces
+    if (!afe.data || afe.feedChunk <= 0 || frame % afe.feedChunk != 0) {
+        mclog::tagError("AudioEngine", "failed to create AFE (config={:#x}, feed chunk={})", config, afe.feedChunk);
+        destroyAfeHandle(afe);
+    } else {
+        mclog::tagInfo("AudioEngine", "AFE created (aec={}, ns={}, agc={}, {}, feed chunk={})",
+            (config & AFE_CONFIG_AEC) != 0, (config & AFE_CONFIG_NS) != 0, (config & AFE_CONFIG_AGC) != 0,
+            highPerf ? "high perf" : "low cost", afe.feedChunk);
+    }
+}
+
+// Feeds one frame of (mic, ref) pairs and appends whatever the AFE has finished to
+// out (capacity samples), oldest dropped first should it ever back up
+static int runAfeFrame(AfeHandle& afe, const int16_t* pairs, int frame, int16_t* out, int fill, int capacity)
+{
+    if constexpr (!audio_stages::AFE) return fill;
+    for (int off = 0; off < frame; off += afe.feedChunk) afe.iface->feed(afe.data, pairs + 2 * off);
+    for (;;) {
+        afe_fetch_result_t* res = afe.iface->fetch_with_delay(afe.data, 0);
+        if (!res || res->ret_value != ESP_OK || res->data_size <= 0) break;
+        const int n = std::min<int>(res->data_size / sizeof(int16_t), capacity);
+        if (fill + n > capacity) {
+            const int drop = fill + n - capacity;
+            memmove(out, out + drop, (fill - drop) * sizeof(int16_t));
+            fill -= drop;
+        }
+        memcpy(out + fill, res->data, n * sizeof(int16_t));
+        fill += n;
+    }
+    return fill;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// VAD handle management
+// ─────────────────────────────────────────────────────────────────────────────
+
+static void destroyVadHandle(void*& handle)
+{
+    if constexpr (!audio_stages::VAD) return;
+    if (handle) {
+        vad_destroy(static_cast<vad_handle_t>(handle));
+        handle = nullptr;
+    }
+}
+
+static void createVadHandle(void*& handle, int vadMode)
+{
+    if constexpr (!audio_stages::VAD) return;
+    vad_handle_t h = vad_create(static_cast<vad_mode_t>(vadMode));
+    handle = h;
+    if (!handle) {
+        mclog::tagError("AudioEngine", "failed to create VAD handle (mode={})", vadMode);
+    } else {
+        mclog::tagInfo("AudioEngine", "VAD handle created (mode={})", vadMode);
+    }
+}
+
+// Per-frame VAD decisions smoothed with onset hysteresis and a release hangover,
+// so one 10ms miss mid-word doesn't drop the NLMS step or close the output gate
+struct VadHangover {
+    static constexpr int ONSET_FRAMES   = 2;   // 20ms of speech to open
+    static constexpr int HANGOVER_FRAMES = 20; // 200ms of silence to close
+
+    bool active = false;
+    int  run = 0;  // Consecutive frames disagreeing with the current decision
+
+    void reset() { active = false; run = 0; }
+
+    bool update(bool speech)
+    {
+        if (speech == active) {
+            run = 0;
+        } else if (++run >= (active ? HANGOVER_FRAMES : ONSET_FRAMES)) {
+            active = speech;
+            run = 0;
+        }
+        return active;
+    }
+};
+
+// Own voice: the wearer's speech reaches the headset mic (ch3) far louder than the
+// room mics, a talker across the table the other way round. A block counts when the
+// conditioned HP mic is over HP_FLOOR and ratio times the room mics' power, and, while
+// the reference VAD has run in the last bus frames, when it heard speech as well.
+// Timed in samples, so every block size opens and closes alike.
+struct OwnVoiceDetector {
+    static constexpr float HP_FLOOR = 1e-6f;             // -60 dBFS
+    static constexpr int ONSET_SAMPLES = 20 * 48;        // 20ms @ 48kHz to open
+    static constexpr int HANGOVER_SAMPLES = 200 * 48;    // 200ms to close
+    static constexpr int VAD_VALID_SAMPLES = 2 * 480;    // A VAD word holds for two bus frames
+
+    bool active = false;
+    int  run = 0;          // Samples disagreeing with the current decision
+    bool vadSpeech = false;
+    int  vadSamples = 0;   // Left before the last VAD word goes stale
+
+    void reset() { *this = OwnVoiceDetector{}; }
+
+    void vad(bool speech)
+    {
+        vadSpeech = speech;
+        vadSamples = VAD_VALID_SAMPLES;
+    }
+
+    bool update(float hpPower, float roomPower, float ratio, int samples)
+    {
+        bool speech = hpPower > HP_FLOOR && hpPower > ratio * roomPower;
+        if (vadSamples > 0) {
+            speech = speech && vadSpeech;
+            vadSamples -= samples;
+        }
+        if (speech == active) {
+            run = 0;
+        } else if ((run += samples) >= (active ? HANGOVER_SAMPLES : ONSET_SAMPLES)) {
+            active = speech;
+            run = 0;
+        }
+        return active;
+    }
+};
+
+// Input activity for the quiet path: quiet after holdSamples of blocks under the
+// threshold, active again on the first block over it (no onset delay, so the
+// full chain is back within the block that needs it)
+struct ActivityGate {
+    bool quiet = false;
+    int  quietSamples = 0;  // Run of samples under the threshold
+
+    bool update(float power, float thresholdPower, int samples, int holdSamples)
+    {
+        if (power > thresholdPower) {
+            quiet = false;
+            quietSamples = 0;
+        } else if (!quiet && (quietSamples += samples) >= holdSamples) {
+            quiet = true;
+        }
+        return quiet;
+    }
+};
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Wind / handling noise detector: MIC-L ↔ MIC-R coherence below ~500Hz
+//
+// Sound from anywhere reaches both mics 60mm apart nearly in phase at low
+// frequencies; turbulence at each port (wind, a finger on the case) does not.
+// The mics are decimated 8:1 by boxcar sums and band-limited to ~30-500Hz
+// there, and one coherence value per block comes from the smoothed auto- and
+// cross-powers. Mic self-noise is incoherent too, so a band under LEVEL_FLOOR
+// is never wind. About 10 operations per input sample.
+// ─────────────────────────────────────────────────────────────────────────────
+
+struct WindDetector {
+    static constexpr int   DECIMATION  = 8;        // 48kHz → 6kHz
+    static constexpr float DC_POLE     = 0.97f;    // ~30Hz DC blocker at 6kHz
+    static constexpr float LOWPASS     = 0.41f;    // One-pole ~500Hz at 6kHz
+    static constexpr float SMOOTH_S    = 0.1f;     // Power averaging
+    static constexpr float COH_CALM    = 0.8f;     // At or above: no wind
+    static constexpr float COH_WINDY   = 0.4f;     // At or below: full wind
+    static constexpr float LEVEL_FLOOR = 1e-5f;    // -50 dBFS low-band power
+    static constexpr float ATTACK_S    = 0.05f;
+    static constexpr float RELEASE_S   = 1.0f;
+    static constexpr float MIC_ENTER   = 4.0f;     // 6dB power ratio picks the calmer mic...
+    static constexpr float MIC_LEAVE   = 2.0f;     // ...and under 3dB (or wind half gone) both again
+
+    float amount = 0.0f;  // 0 = calm, 1 = full wind
+    int   calmMic = 0;    // -1 = MIC-L is the calmer one, +1 = MIC-R, 0 = neither stands out
+
+    void reset() { *this = WindDetector{}; }
+
+    void update(const float* left, const float* right, int frames, float sampleRate)
+    {
+        float sll = 0.0f, srr = 0.0f, slr = 0.0f;
+        int n = 0;
+        for (int i = 0; i < frames; i++) {
+            _accL += left[i];
+            _accR += right[i];
+            if (++_phase < DECIMATION) continue;
+            _phase = 0;
+            const float xl = _accL * (1.0f / DECIMATION), xr = _accR * (1.0f / DECIMATION);
+            _accL = _accR = 0.0f;
+            const float hl = xl - _prevL + DC_POLE * _hpL, hr = xr - _prevR + DC_POLE * _hpR;
+            _prevL = xl; _prevR = xr; _hpL = hl; _hpR = hr;
+            _lpL += LOWPASS * (hl - _lpL);
+            _lpR += LOWPASS * (hr - _lpR);
+            sll += _lpL * _lpL;
+            srr += _lpR * _lpR;
+            slr += _lpL * _lpR;
+            n++;
+        }
+        if (n == 0) return;
+
+        const float seconds = frames / sampleRate;
+        const float a = std::min(1.0f, seconds / SMOOTH_S);
+        _pl += a * (sll / n - _pl);
+        _pr += a * (srr / n - _pr);
+        _plr += a * (slr / n - _plr);
+
+        float target = 0.0f;
+        if (std::max(_pl, _pr) > LEVEL_FLOOR) {
+            const float coherence = _plr / sqrtf(_pl * _pr + 1e-20f);
+            target = std::clamp((COH_CALM - coherence) / (COH_CALM - COH_WINDY), 0.0f, 1.0f);
+        }
+        // A gust is on at once; the release bridges the lulls between gusts
+        amount += std::min(1.0f, seconds / (target > amount ? ATTACK_S : RELEASE_S)) * (target - amount);
+
+        if (calmMic == 0) {
+            if (amount > 0.5f && _pl > MIC_ENTER * _pr) calmMic = 1;
+            else if (amount > 0.5f && _pr > MIC_ENTER * _pl) calmMic = -1;
+        } else {
+            const float ratio = calmMic > 0 ? _pl / (_pr + 1e-20f) : _pr / (_pl + 1e-20f);
+            if (amount < 0.25f || ratio < MIC_LEAVE) calmMic = 0;
+        }
+    }
+
+private:
+    float _accL = 0.0f, _accR = 0.0f;
+    int   _phase = 0;
+    float _prevL = 0.0f, _prevR = 0.0f, _hpL = 0.0f, _hpR = 0.0f;
+    float _lpL = 0.0f, _lpR = 0.0f;
+    float _pl = 0.0f, _pr = 0.0f, _plr = 0.0f;
+};
+
+// ─────────────────────────────────────────────────────────────────────────────
+// 16kHz bus output FIFO: whole 160-sample frames in, per-block chunks out
+// Primed with (frame - gcd(frame, chunk)) zeros so every block finds a full
+// chunk: at 48kHz that is frame - chunk, at 32kHz the chunks don't tile the frame.
+// ─────────────────────────────────────────────────────────────────────────────
+
+struct BusFifo {
+    // Priming, subband VE's delay on the band split's, and the largest chunk (a 480-sample block at 32kHz)
+    static constexpr int CAPACITY = 160 + StereoSubbandNlms::LATENCY + 240;
+    float buf[CAPACITY];
+    int count = 0;
+
+    void reset(int prime) { memset(buf, 0, sizeof(buf)); count = prime; }
+
+    void push(const float* data, int n) {
+        n = std::min(n, CAPACITY - count);
+        memcpy(buf + count, data, n * sizeof(float));
+        count += n;
+    }
+
+    void pop(float* out, int n) {
+        int avail = std::min(n, count);
+        memcpy(out, buf, avail * sizeof(float));
+        if (avail < n) memset(out + avail, 0, (n - avail) * sizeof(float));
+        count -= avail;
+        memmove(buf, buf + avail, count * sizeof(float));
+    }
+};
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Bus band split: what the 16kHz bus can't carry bypasses it at 48kHz
+//
+// The high band is what a bare resampler round trip loses, x[n - d] -
+// up(down(x)), d = taps - ratio (18 at 48kHz, 13 at 32kHz). An untouched copy of each 16kHz chunk goes through a FIFO
+// primed like the bus output's and its own upsampler, so the reference comes
+// out in step with the processed low band, and the input is delayed to match.
+// While the bus stages leave the signal alone the two bands add up to exactly
+// the input delayed. The bus's broadband gain is carried onto the high band, so
+// NS and AGC still move the whole spectrum, just not per bin above 7kHz.
+// ─────────────────────────────────────────────────────────────────────────────
+
+class BusBandSplit {
+public:
+    static constexpr int roundTripDelay(int ratio) { return Resampler::taps(ratio) - ratio; }
+    static constexpr int RING = 1024;        // Delay + one block = 3 * (160 + subband VE latency) + 18 at most
+    static constexpr int CHUNK = 16;         // 16kHz samples per reference pass (stack scratch)
+    static constexpr float MAX_GAIN = 4.0f;  // AGC boost carried up to +12dB
+
+    // prime16k: the bus output FIFO's priming, i.e. its delay in 16kHz samples; ratio: the bus resamplers'
+    void reset(int prime16k, int ratio = 3)
+    {
+        _refUp.init(false, ratio);
+        _ratio = _refUp.ratio();
+        _refFifo.reset(prime16k);
+        memset(_ring, 0, sizeof(_ring));
+        _write = 0;
+        _delay = _ratio * prime16k + roundTripDelay(_ratio);
+        _gain = 1.0f;
+    }
+
+    // After the bus downsample: the engine-rate block and the 16kHz chunk it became
+    void capture(const float* in48, const float* in16, int frames16k)
+    {
+        _refFifo.push(in16, frames16k);
+        for (int i = 0; i < _ratio * frames16k; i++) {
+            _ring[_write] = in48[i];
+            _write = (_write + 1) & (RING - 1);
+        }
+    }
+
+    // After the bus upsample: adds the matching high band into out48, its gain
+    // moving toward targetGain by smoothing per sample
+    void restore(float* out48, int frames16k, float targetGain, float smoothing)
+    {
+        int read = (_write - _ratio * frames16k - _delay) & (RING - 1);
+        float ref16[CHUNK], ref48[3 * CHUNK];
+        for (int start = 0; start < frames16k; start += CHUNK) {
+            const int n = std::min(CHUNK, frames16k - start);
+            _refFifo.pop(ref16, n);
+            _refUp.upsample(ref16, ref48, n);
+            float* out = out48 + _ratio * start;
+            for (int i = 0; i < _ratio * n; i++) {
+                _gain += smoothing * (targetGain - _gain);
+                out[i] += _gain * (_ring[read] - ref48[i]);
+                read = (read + 1) & (RING - 1);
+            }
+        }
+    }
+
+private:
+    Resampler _refUp;
+    BusFifo _refFifo;
+    float _ring[RING];
+    int _write = 0;
+    int _ratio = 3;
+    int _delay = roundTripDelay(3);
+    float _gain = 1.0f;
+};
+
+// Snap a requested block size to the nearest supported one
+static int snapBlockSize(int samples)
+{
+    int best = AudioEngine::BLOCK_SIZES[0];
+    for (int size : AudioEngine::BLOCK_SIZES) {
+        if (std::abs(size - samples) < std::abs(best - samples)) best = size;
+    }
+    return best;
+}
+
+// Same for the engine rate
+static int snapSampleRate(int hz)
+{
+    int best = AudioEngine::SAMPLE_RATES[0];
+    for (int rate : AudioEngine::SAMPLE_RATES) {
+        if (std::abs(rate - hz) < std::abs(best - hz)) best = rate;
+    }
+    return best;
+}
+
+// The 16kHz bus's resampling ratio from an engine rate: 3 or 2, 0 where it isn't a whole one (24kHz)
+static int busRatioFor(int sampleRate)
+{
+    return sampleRate % 16000 == 0 ? sampleRate / 16000 : 0;
+}
+
+static int blockSizeIndex(int samples)
+{
+    for (int i = 0; i < AudioLatencyInfo::NUM_MODES; i++) {
+        if (AudioEngine::BLOCK_SIZES[i] == samples) return i;
+    }
+    return AudioLatencyInfo::NUM_MODES - 1;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// float ↔ int16 conversion for ESP-SR frames
+// ─────────────────────────────────────────────────────────────────────────────
+
+static inline void floatToInt16(const float* in, int16_t* out, int count)
+{
+    for (int i = 0; i < count; i++) {
+        float s = std::clamp(in[i], -1.0f, 1.0f);
+        out[i] = static_cast<int16_t>(s * 32767.0f);
+    }
+}
+
+static inline void int16ToFloat(const int16_t* in, float* out, int count)
+{
+    constexpr float scale = 1.0f / 32768.0f;
+    for (int i = 0; i < count; i++) {
+        out[i] = static_cast<float>(in[i]) * scale;
+    }
+}
+
+// Where each input lane sits in a captured frame; follows the BSP capture profile
+struct CaptureLayout {
+    int stride = 4;                   // Slots per frame
+    int offset[4] = {0, 1, 2, 3};     // MIC-L, AEC loopback, MIC-R, MIC-HP (-1 = not captured)
+    bool wide = false;                // 32-bit words (24-bit ES7210 samples) instead of int16
+
+    int frameBytes() const
+    {
+        return stride * (wide ? 4 : 2);
+    }
+};
+
+static CaptureLayout captureLayout(const bsp_capture_profile_t& profile)
+{
+    CaptureLayout layout;
+    layout.stride = 0;
+    for (int slot = 0; slot < 4; slot++) {
+        layout.offset[slot] = (profile.slot_mask & (1u << slot)) ? layout.stride++ : -1;
+    }
+    layout.wide = profile.bits > 16;
+    return layout;
+}
+
+// De-interleave one stretch of captured frames to float [-1.0, 1.0]:
+// MIC-L (slot 0), AEC loopback (slot 1), MIC-R (slot 2), MIC-HP (slot 3).
+// Lanes the capture profile leaves out come out silent.
+template <typename T>
+static void deinterleaveInput(const T* in, int count, const CaptureLayout& layout,
+                              float* l, float* ref, float* r, float* hp)
+{
+    constexpr float scale = 1.0f / (sizeof(T) == 2 ? 32768.0f : 2147483648.0f);
+    float* lanes[4] = {l, ref, r, hp};
+    for (int c = 0; c < 4; c++) {
+        float* out = lanes[c];
+        if (layout.offset[c] < 0) {
+            memset(out, 0, count * sizeof(float));
+            continue;
+        }
+        const T* src = in + layout.offset[c];
+        for (int i = 0; i < count; i++) {
+            out[i] = static_cast<float>(src[i * layout.stride]) * scale;
+        }
+    }
+}
+
+static void deinterleaveInput(const void* in, int count, const CaptureLayout& layout,
+                              float* l, float* ref, float* r, float* hp)
+{
+    if (layout.wide) {
+        deinterleaveInput(static_cast<const int32_t*>(in), count, layout, l, ref, r, hp);
+    } else {
+        deinterleaveInput(static_cast<const int16_t*>(in), count, layout, l, ref, r, hp);
+    }
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// AEC frame bridge: 160-sample bus frames in, 512-sample AEC frames through,
+// 160-sample frames out at a constant delay
+//
+// One circular history per channel, indexed by absolute 16kHz sample count.
+// AEC frames are gathered straight out of the ring and their blended output is
+// written back over the same samples, so nothing is copied or shifted and no
+// input is dropped. Output trails input by the worst-case fill of a pending
+// AEC frame plus one frame for the worker round trip, which makes the added
+// latency fixed regardless of frame phase or worker scheduling.
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Largest number of samples a partial AEC frame can hold after a bus frame
+static constexpr int aecBridgeWorstFill(int inFrame, int aecFrame)
+{
+    int worst = 0;
+    for (int written = inFrame; written % aecFrame != 0; written += inFrame) {
+        worst = std::max(worst, written % aecFrame);
+    }
+    return worst;
+}
+
+struct AecFrameBridge {
+    static constexpr int IN_FRAME = 160;
+    static constexpr int AEC_FRAME = 512;
+    // 480 samples of framing + 512 of worker pipeline = 992 samples (62ms)
+    static constexpr int LATENCY = aecBridgeWorstFill(IN_FRAME, AEC_FRAME) + AEC_FRAME;
+    static constexpr int CAPACITY = 2048;  // Power of two holding LATENCY + IN_FRAME of history
+    static constexpr int MASK = CAPACITY - 1;
+    static_assert(CAPACITY >= LATENCY + IN_FRAME && CAPACITY >= AEC_FRAME, "AEC bridge ring too small");
+
+    float* ringL = nullptr;   // CAPACITY each, carved from the AEC arena
+    float* ringR = nullptr;
+    float* ringHP = nullptr;
+    uint32_t epoch = 0;       // Bumped on reset so in-flight worker results can be discarded
+    int64_t written = 0;      // Bus samples pushed
+    int64_t gathered = 0;     // Samples handed to AEC (whole frames)
+    int64_t processed = 0;    // Samples whose AEC output has been written back
+
+    void reset() {
+        if (ringL) {
+            memset(ringL, 0, CAPACITY * sizeof(float));
+            memset(ringR, 0, CAPACITY * sizeof(float));
+            memset(ringHP, 0, CAPACITY * sizeof(float));
+        }
+        epoch++;
+        written = 0;
+        gathered = 0;
+        processed = 0;
+    }
+
+    void push(const float* l, const float* r, const float* hp) {
+        int pos = static_cast<int>(written & MASK);
+        int first = std::min(IN_FRAME, CAPACITY - pos);
+        memcpy(ringL + pos, l, first * sizeof(float));
+        memcpy(ringR + pos, r, first * sizeof(float));
+        memcpy(ringHP + pos, hp, first * sizeof(float));
+        memcpy(ringL, l + first, (IN_FRAME - first) * sizeof(float));
+        memcpy(ringR, r + first, (IN_FRAME - first) * sizeof(float));
+        memcpy(ringHP, hp + first, (IN_FRAME - first) * sizeof(float));
+        written += IN_FRAME;
+    }
+
+    bool frameReady() const { return written - gathered >= AEC_FRAME; }
+
+    // Converts the next AEC frame to int16, reading across the ring wrap;
+    // returns the frame's first sample position
+    int64_t gather(int16_t* l, int16_t* r, int16_t* hp) {
+        int pos = static_cast<int>(gathered & MASK);
+        int first = std::min(AEC_FRAME, CAPACITY - pos);
+        floatToInt16(ringL + pos, l, first);
+        floatToInt16(ringR + pos, r, first);
+        floatToInt16(ringHP + pos, hp, first);
+        floatToInt16(ringL, l + first, AEC_FRAME - first);
+        floatToInt16(ringR, r + first, AEC_FRAME - first);
+        floatToInt16(ringHP, hp + first, AEC_FRAME - first);
+        int64_t start = gathered;
+        gathered += AEC_FRAME;
+        return start;
+    }
+
+    // Blends AEC output over the frame's dry samples in place (0 = dry, 1 = AEC).
+    // Frames that came back after their samples were emitted are dropped.
+    bool scatter(int64_t start, const int16_t* l, const int16_t* r, float blend) {
+        if (start < written - LATENCY - IN_FRAME) return false;  // pop() already passed it
+        constexpr float i16scale = 1.0f / 32768.0f;
+        for (int i = 0; i < AEC_FRAME; i++) {
+            int pos = static_cast<int>((start + i) & MASK);
+            float aecL = static_cast<float>(l[i]) * i16scale;
+            float aecR = static_cast<float>(r[i]) * i16scale;
+            ringL[pos] = (1.0f - blend) * ringL[pos] + blend * aecL;
+            ringR[pos] = (1.0f - blend) * ringR[pos] + blend * aecR;
+        }
+        processed = start + AEC_FRAME;
+        return true;
+    }
+
+    // Emits the frame LATENCY samples behind the newest input; returns false
+    // if part of it never came back from AEC (it goes out dry)
+    bool pop(float* l, float* r) const {
+        int64_t start = written - LATENCY - IN_FRAME;
+        int pos = static_cast<int>(start & MASK);
+        int first = std::min(IN_FRAME, CAPACITY - pos);
+        memcpy(l, ringL + pos, first * sizeof(float));
+        memcpy(r, ringR + pos, first * sizeof(float));
+        memcpy(l + first, ringL, (IN_FRAME - first) * sizeof(float));
+        memcpy(r + first, ringR, (IN_FRAME - first) * sizeof(float));
+        return start < 0 || processed >= start + IN_FRAME;
+    }
+};
+
+// Mean power of a stereo block (telemetry only)
+static inline float blockPower(const float* l, const float* r, int count)
+{
+    float sum = 0.0f;
+    for (int i = 0; i < count; i++) {
+        sum += l[i] * l[i] + r[i] * r[i];
+    }
+    return sum / (2.0f * count);
+}
+
+static inline float blockPower(const int16_t* l, const int16_t* r, int count)
+{
+    int64_t sum = 0;
+    for (int i = 0; i < count; i++) {
+        sum += (int32_t)l[i] * l[i] + (int32_t)r[i] * r[i];
+    }
+    return (float)sum / (2.0f * count * 32768.0f * 32768.0f);
+}
+
+// Numerical health: a stage whose block mean square is past this (+40 dBFS), or
+// not finite, has diverged. One test per block replaces per-sample isnan checks.
+static constexpr float HEALTH_MAX_POWER = 1e4f;
+
+static const char* const kHealthStageNames[AUDIO_HEALTH_COUNT] = {
+    "feedback canceller", "beamformer", "input filters", "VE", "AEC bridge", "linked AGC", "hearing chain",
+};
+
+static const char* const kRestartReasonNames[] = {"none", "read stall", "health resets", "no heartbeat"};
+
+// r may be nullptr (mono); NaN compares false, so it fails here too
+static inline bool blockHealthy(const float* l, const float* r, int count)
+{
+    return blockPower(l, r ? r : l, count) <= HEALTH_MAX_POWER;
+}
+
+static inline float powerRatioDb(float outPow, float inPow)
+{
+    constexpr float floor = 1e-10f;
+    return 10.0f * log10f((outPow + floor) / (inPow + floor));
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Start / Stop
+// ─────────────────────────────────────────────────────────────────────────────
+
+void AudioEngine::start()
+{
+    // Core 1 is the audio task's: LVGL's second draw thread stops rendering there first. Outside _mutex,
+    // which UI callbacks take under the LVGL lock this waits for
+    lvgl_port_draw_assist_enable(false);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_running) {
+        // The running engine wants core 1 to itself too: left disabled
+        mclog::tagWarn(TAG, "already running");
+        return;
+    }
+    if (_audioTask.isRunning() || _aecTask.isRunning() || _earTask.isRunning()) {
+        mclog::tagError(TAG, "previous tasks never exited, not restarting");
+        // stop() gave core 1 back to LVGL unless it's the audio task that is stuck there
+        const bool audioCoreIdle = !_audioTask.isRunning();
+        lock.unlock();
+        if (audioCoreIdle) lvgl_port_draw_assist_enable(true);
+        return;
+    }
+
+    const int rate = snapSampleRate(_params.sampleRate);
+    if (rate != _sampleRate) _coeffParamsValid = false;  // Every coefficient was designed for the old rate
+    if (!busRatioFor(rate) && (_params.veEnabled || _params.nsEnabled || !_params.agcLinked || _params.busAfe)) {
+        mclog::tagWarn(TAG, "no 16kHz bus at {} Hz: VE, NS and busAfe are off, AGC runs linked", rate);
+    }
+    _sampleRate = rate;
+    mclog::tagInfo(TAG, "starting audio engine at {} Hz", _sampleRate);
+    _running = true;
+    publishParams();
+
+    // Disable speaker amplifier to prevent feedback (headphone-only output)
+    bsp_speaker_enable(false);
+
+    // Reset filter state
+    _inputCascade.reset();
+    _inputCascadeR.reset();
+    _tinnitusCascade.reset();
+    _tinnitusCascadeR.reset();
+    _noiseCascade.reset();
+    _veRefHpfBq.reset(); _veRefLpfBq.reset();
+
+    // AEC worker on Core 0 (below the I/O task, above UI); it creates the AEC
+    // and NS/AGC/VAD handles once the audio task asks for them
+    for (int k = 0; k < SR_KINDS; k++) {
+        _srRequest[k].store(0, std::memory_order_relaxed);
+        _srMode[k] = -1;
+    }
+    _abSwitchPending.store(false, std::memory_order_relaxed);  // The first generation plays as is
+    _noiseLoopDone.store(0, std::memory_order_relaxed);
+    _noiseLoopInUse.store(0, std::memory_order_relaxed);
+    _aecConfig.store(-1, std::memory_order_relaxed);
+    _aecReady.store(false, std::memory_order_relaxed);
+    _afeLag16k.store(0, std::memory_order_relaxed);
+    _latencyProbeRequested.store(false, std::memory_order_relaxed);
+    _probeBusy.store(false, std::memory_order_relaxed);
+    _latCaptureReady.store(false, std::memory_order_relaxed);
+    _specCaptureReady.store(false, std::memory_order_relaxed);
+    _specFrame = 0;
+    if (_spectrumEnabled.load(std::memory_order_relaxed) && !allocSpectrumBuffers()) {
+        _spectrumEnabled.store(false, std::memory_order_relaxed);
+    }
+    if (!_aecTask.create(aecTask, "audio_aec", 20480, this, 9, 0)) {
+        mclog::tagError(TAG, "failed to create AEC worker, AEC mode unavailable");
+    }
+    // Split-ear worker on Core 0, above the AEC worker: it holds up the audio task while it runs
+    _earPending.store(false, std::memory_order_relaxed);
+    if (!_earTask.create(earTask, "audio_ear", 8192, this, 10, 0)) {
+        mclog::tagWarn(TAG, "failed to create split-ear worker, both ears run on the audio core");
+    }
+
+    // Control task on Core 0, just above idle: codec and jack I2C never land on the audio core.
+    // It also formats the audio task trace records, hence the stack for vformat
+    _hpDetected.store(bsp_headphone_detect(), std::memory_order_relaxed);
+    _micPgaApplied.store(NAN, std::memory_order_relaxed);
+    // Today's dose so far, before the control task adds to it
+    NoiseDosimeter::getInstance().load();
+    if (!_ctlTask.create(controlTask, "audio_ctl", 4096, this, 2, 0)) {
+        mclog::tagError(TAG, "failed to create control task, codec settings and jack state frozen");
+    }
+
+    // Warm-start snapshots from the last run; the first start after boot reads them from NVS
+    AdaptiveStore::getInstance().load();
+
+    if (!_audioTask.create(audioTask, "audio_eng", 32768, this, 10, core_policy::DSP_CORE)) {
+        mclog::tagError(TAG, "failed to create audio task");
+    }
+}
+
+void AudioEngine::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_running) return;
+        _running = false;
+    }
+
+    // The audio task is the one using the handles below: nothing goes until it has returned. It notices
+    // _running within one block; if it doesn't, leak rather than free under it (start() refuses meanwhile)
+    if (!_audioTask.join(pdMS_TO_TICKS(STOP_TIMEOUT_MS))) {
+        mclog::tagError(TAG, "audio task did not exit, keeping its resources");
+        return;
+    }
+    // Core 1 is idle until the next start: LVGL may render on it meanwhile
+    lvgl_port_draw_assist_enable(true);
+    // The split-ear worker runs on the NS/AGC handles too (idle now, between frames)
+    if (!_earTask.sendKillSignalAndWaitDelete(pdMS_TO_TICKS(STOP_TIMEOUT_MS))) {
+        mclog::tagError(TAG, "split-ear worker did not exit, keeping its resources");
+        return;
+    }
+
+    // Destroy NS handles
+    destroyNsHandles(_nsHandleL, _nsHandleR);
+
+    // Destroy AGC handles
+    destroyAgcHandles(_agcHandleL, _agcHandleR);
+
+    // Keep what the adaptive filters learned for the next start. The audio task is gone,
+    // so the NVS write (cache-disabled flash access) stalls nothing
+    {
+        AudioEngineParams params;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            params = _params;
+        }
+        const bool hp = _hpDetected.load(std::memory_order_relaxed);
+        snapshotFilter<StereoNlmsFilter>(_nlms, AdaptiveStore::KIND_VE_NLMS, params, hp);
+        snapshotFilter<StereoFdafFilter>(_fdaf, AdaptiveStore::KIND_VE_FDAF, params, hp);
+        snapshotFilter<StereoSubbandNlms>(_subband, AdaptiveStore::KIND_VE_SUBBAND, params, hp);
+        snapshotFilter<StereoNlmsFilter>(_fbc, AdaptiveStore::KIND_FBC, params, hp);
+        AdaptiveStore::getInstance().persist();
+    }
+
+    // Destroy NLMS filters
+    destroyNlmsFilter(_nlms);
+    destroyFdafFilter(_fdaf);
+    destroySubbandFilter(_subband);
+    destroyNlmsFilter(_fbc);
+
+    // Spectral frame buffers (clients stay registered for the next start)
+    _wola.deinit();
+
+    if (!_ctlTask.sendKillSignalAndWaitDelete(pdMS_TO_TICKS(STOP_TIMEOUT_MS))) {
+        mclog::tagWarn(TAG, "control task did not exit in time");
+    }
+    NoiseDosimeter::getInstance().persist();
+    // The correction FIR is read again on the next start; nothing holds its memory meanwhile
+    destroyFirConvolver(_fir);
+    for (SpscRing<void*, 4>* ring : {&_firRetired, &_firHandover}) {
+        void* fir;
+        while (ring->pop(fir)) destroyFirConvolver(fir);
+    }
+
+    // The AEC worker frees its handles on exit; wait for it before anything else goes
+    if (!_aecTask.sendKillSignalAndWaitDelete(pdMS_TO_TICKS(STOP_TIMEOUT_MS))) {
+        mclog::tagError(TAG, "AEC worker did not exit, keeping its resources");
+        return;
+    }
+
+    // Destroy VAD handle
+    destroyVadHandle(_vadHandleRef);
+
+    // Sets the worker delivered after the audio task stopped looking
+    SrHandles undelivered;
+    while (_srHandover.pop(undelivered)) freeSrHandles(undelivered);
+
+    // Noise loops (both tasks are gone now)
+    for (auto& loop : _noiseLoop) {
+        if (loop) heap_caps_free(loop);
+        loop = nullptr;
+    }
+
+    heap_caps_free(_latMls);
+    heap_caps_free(_latCapture);
+    _latMls = _latCapture = nullptr;
+    heap_caps_free(_specCapture);
+    heap_caps_free(_specWindow);
+    heap_caps_free(_specFft);
+    _specCapture = _specWindow = _specFft = nullptr;
+
+    // Mute codec output, with the output stage back on (muted) for other players
+    bsp_codec_config_t* codec = bsp_get_codec_handle();
+    if (codec) {
+        if (codec->set_output_power && !_outputPowered.load(std::memory_order_relaxed)) {
+            if (codec->set_output_power(true) == ESP_OK) {
+                _outputPowered.store(true, std::memory_order_relaxed);
+            } else {
+                mclog::tagWarn(TAG, "output stage did not power back up");
+            }
+        }
+        codec->set_mute(true);
+    }
+
+    // Re-enable speaker amplifier for normal use
+    bsp_speaker_enable(true);
+
+    mclog::tagInfo(TAG, "audio engine stopped");
+}
+
+bool AudioEngine::isRunning()
+{
+    return _running.load(std::memory_order_acquire);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Thread-safe parameter access
+// Setters edit _params under _mutex (UI side only), then publish a copy to
+// the audio task through _paramsBuffer. The audio task never takes _mutex
+// to read params, so a slow UI writer can't stall a DSP block.
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Switches off what audio_stages left out of the build
+void AudioEngine::maskBuildStages(AudioEngineParams& p)
+{
+    if constexpr (!audio_stages::NS) p.nsEnabled = false;
+    if constexpr (!audio_stages::AGC) p.agcLinked = true;  // The linked AGC needs no ESP-SR
+    if constexpr (!audio_stages::AEC) {
+        if (p.veMode == 1) p.veMode = 0;  // NLMS is the nearest voice exclusion left
+    }
+    if constexpr (!audio_stages::VAD) p.veVadEnabled = false;
+    if constexpr (!audio_stages::AFE) p.busAfe = false;
+    if constexpr (!audio_stages::TINNITUS) {
+        p.tinnitus.noiseType = 0;
+        p.tinnitus.toneFinderEnabled = false;
+        p.tinnitus.binauralEnabled = false;
+    }
+}
+
+void AudioEngine::maskRateStages(AudioEngineParams& p, int sampleRate)
+{
+    p.sampleRate = sampleRate;
+    if (busRatioFor(sampleRate)) return;
+    // The 16kHz bus resamples by a whole ratio only
+    p.veEnabled = false;
+    p.nsEnabled = false;
+    p.agcLinked = true;
+    p.busAfe = false;
+}
+
+// Stages a scene tier lets run, as bits; each still only runs if the user has it on
+enum : uint8_t {
+    SCENE_STAGE_NS = 1 << 0,
+    SCENE_STAGE_VE = 1 << 1,
+    SCENE_STAGE_BEAM = 1 << 2,
+};
+
+uint8_t AudioEngine::sceneStages(const AudioEngineParams& p, AudioScene scene)
+{
+    uint8_t allowed;
+    switch (scene) {
+        case AUDIO_SCENE_QUIET: allowed = 0; break;
+        case AUDIO_SCENE_SPEECH: allowed = SCENE_STAGE_VE; break;
+        case AUDIO_SCENE_STEADY: allowed = SCENE_STAGE_VE | SCENE_STAGE_NS; break;
+        default: allowed = SCENE_STAGE_VE | SCENE_STAGE_NS | SCENE_STAGE_BEAM; break;
+    }
+    const uint8_t set = (p.nsEnabled ? SCENE_STAGE_NS : 0) | (p.veEnabled ? SCENE_STAGE_VE : 0) |
+                        (p.beamMode > 0 ? SCENE_STAGE_BEAM : 0);
+    return allowed & set;
+}
+
+void AudioEngine::applySceneTier(AudioEngineParams& p, AudioScene scene)
+{
+    const uint8_t stages = sceneStages(p, scene);
+    p.nsEnabled = stages & SCENE_STAGE_NS;
+    p.veEnabled = stages & SCENE_STAGE_VE;
+    if (!(stages & SCENE_STAGE_BEAM)) p.beamMode = 0;
+}
+
+void AudioEngine::setSceneTier(AudioScene scene)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto old = static_cast<AudioScene>(_sceneTier.exchange(scene, std::memory_order_relaxed));
+    if (!_params.sceneAuto || sceneStages(_params, old) == sceneStages(_params, scene)) return;
+    // Stage handles come and go at the trough of the dip, as on an A/B switch
+    _abSwitchPending.store(true, std::memory_order_release);
+    publishParams();
+}
+
+// Caller holds _mutex
+void AudioEngine::publishParams()
+{
+    if (_paramBatchDepth > 0) {
+        _paramBatchDirty = true;
+        return;
+    }
+    if (const uint32_t moved = changedParamFields(_params, _paramsGenBase)) {
+        _paramGens.latest++;
+        for (int f = 0; f < AUDIO_PARAM_FIELD_COUNT; f++) {
+            if (moved & (1u << f)) _paramGens.field[f] = _paramGens.latest;
+        }
+        _paramsGenBase = _params;
+    }
+
+    // The audio task sees only the stages this build has; _params keeps what the user set
+    AudioEngineParams& published = _paramsBuffer.back();
+    published = _params;
+    maskBuildStages(published);
+    maskRateStages(published, _running ? _sampleRate : snapSampleRate(_params.sampleRate));
+    if (_params.sceneAuto) applySceneTier(published, static_cast<AudioScene>(_sceneTier.load(std::memory_order_relaxed)));
+    // Auto split-ear is decided here, off the audio task: the cost model takes a lock
+    published.earSplit = AudioCostModel::getInstance().splitEars(published) ? 2 : 0;
+
+    // A costlier feature set gets its clock before the audio task sees it
+    CpuGovernor::getInstance().prepare(published);
+    _paramsBuffer.publish();
+
+    // Codec-side settings go to the control task, which writes only what changed
+    _codecVolumeWanted.store(_params.outputVolume, std::memory_order_relaxed);
+    _codecMuteWanted.store(_params.outputMute, std::memory_order_relaxed);
+    _micGainWanted.store(_params.micGain, std::memory_order_relaxed);
+    _firWanted.store(_params.firEnabled ? _params.firIr : 0, std::memory_order_relaxed);
+    _sceneQuietDb.store(_params.sceneQuietDb, std::memory_order_relaxed);
+    _doseCalDbSpl.store(_params.fitting.calibrationDbSpl, std::memory_order_relaxed);
+    _ctlTask.notify();
+}
+
+// Bit per AudioParamField that differs between a and b
+uint32_t AudioEngine::changedParamFields(const AudioEngineParams& a, const AudioEngineParams& b)
+{
+    uint32_t moved = 0;
+    auto mark = [&](AudioParamField f, bool differs) {
+        if (differs) moved |= 1u << f;
+    };
+    // Per ear: the left ear's top-level fields and the right ear as it's heard (the left one while linked)
+    const EarParams la = a.ear(AUDIO_EAR_LEFT), lb = b.ear(AUDIO_EAR_LEFT);
+    const EarParams ra = a.ear(AUDIO_EAR_RIGHT), rb = b.ear(AUDIO_EAR_RIGHT);
+    auto ears = [&](auto differs) {
+        return differs(la, lb) || differs(ra, rb);
+    };
+    const TinnitusReliefParams& ta = a.tinnitus;
+    const TinnitusReliefParams& tb = b.tinnitus;
+
+    mark(AUDIO_PARAM_EARS, a.earsLinked != b.earsLinked);
+    mark(AUDIO_PARAM_HPF, ears([](const EarParams& x, const EarParams& y) {
+        return x.hpfEnabled != y.hpfEnabled || x.hpfFrequency != y.hpfFrequency;
+    }));
+    mark(AUDIO_PARAM_LPF, ears([](const EarParams& x, const EarParams& y) {
+        return x.lpfEnabled != y.lpfEnabled || x.lpfFrequency != y.lpfFrequency;
+    }));
+    mark(AUDIO_PARAM_EQ, ears([](const EarParams& x, const EarParams& y) {
+        return x.eqLowGain != y.eqLowGain || x.eqMidGain != y.eqMidGain || x.eqHighGain != y.eqHighGain;
+    }));
+    mark(AUDIO_PARAM_OUTPUT_GAIN, ears([](const EarParams& x, const EarParams& y) {
+        return x.outputGain != y.outputGain;
+    }));
+    mark(AUDIO_PARAM_NOTCHES, ears([](const EarParams& x, const EarParams& y) {
+        for (int i = 0; i < 6; i++) {
+            if (x.notches[i].enabled != y.notches[i].enabled || x.notches[i].frequency != y.notches[i].frequency ||
+                x.notches[i].Q != y.notches[i].Q) {
+                return true;
+            }
+        }
+        return false;
+    }));
+    mark(AUDIO_PARAM_NS, a.nsEnabled != b.nsEnabled || a.nsMode != b.nsMode || a.nsLinked != b.nsLinked);
+    mark(AUDIO_PARAM_AGC, a.agcEnabled != b.agcEnabled || a.agcMode != b.agcMode ||
+                          a.agcCompressionGainDb != b.agcCompressionGainDb ||
+                          a.agcLimiterEnabled != b.agcLimiterEnabled ||
+                          a.agcTargetLevelDbfs != b.agcTargetLevelDbfs || a.agcLinked != b.agcLinked);
+    mark(AUDIO_PARAM_VE, a.veEnabled != b.veEnabled || a.veBlend != b.veBlend || a.veStepSize != b.veStepSize ||
+                         a.veFilterLength != b.veFilterLength || a.veMaxAttenuation != b.veMaxAttenuation ||
+                         a.veRefGain != b.veRefGain || a.veRefHpf != b.veRefHpf || a.veRefLpf != b.veRefLpf ||
+                         a.veMode != b.veMode || a.veAecMode != b.veAecMode ||
+                         a.veAecFilterLen != b.veAecFilterLen || a.veAecShared != b.veAecShared ||
+                         a.veVadEnabled != b.veVadEnabled || a.veVadMode != b.veVadMode);
+    mark(AUDIO_PARAM_VE_GATE, a.veVadGateEnabled != b.veVadGateEnabled || a.veVadGateAtten != b.veVadGateAtten);
+    mark(AUDIO_PARAM_LEVELS, a.outputVolume != b.outputVolume || a.micGain != b.micGain);
+    mark(AUDIO_PARAM_BOOST, a.boostEnabled != b.boostEnabled);
+    mark(AUDIO_PARAM_BLOCK_SIZE, a.blockSize != b.blockSize);
+    mark(AUDIO_PARAM_NOISE, ta.noiseType != tb.noiseType || ta.noiseLevel != tb.noiseLevel ||
+                            ta.noiseLowCut != tb.noiseLowCut || ta.noiseHighCut != tb.noiseHighCut);
+    mark(AUDIO_PARAM_TONE_FINDER, ta.toneFinderEnabled != tb.toneFinderEnabled ||
+                                  ta.toneFinderFreq != tb.toneFinderFreq || ta.toneFinderLevel != tb.toneFinderLevel);
+    mark(AUDIO_PARAM_HF_EXT, ta.hfExtEnabled != tb.hfExtEnabled || ta.hfExtFreq != tb.hfExtFreq ||
+                             ta.hfExtGainDb != tb.hfExtGainDb);
+    mark(AUDIO_PARAM_BINAURAL, ta.binauralEnabled != tb.binauralEnabled || ta.binauralCarrier != tb.binauralCarrier ||
+                               ta.binauralBeat != tb.binauralBeat || ta.binauralLevel != tb.binauralLevel);
+    return moved;
+}
+
+void AudioEngine::setParams(const AudioEngineParams& p)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params = p;
+    publishParams();
+}
+
+AudioEngineParams AudioEngine::getParams()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _params;
+}
+
+AudioEngineParams AudioEngine::getParams(AudioParamGenerations& gens)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    gens = _paramGens;
+    return _params;
+}
+
+void AudioEngine::beginParamBatch()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _paramBatchDepth++;
+}
+
+void AudioEngine::endParamBatch()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_paramBatchDepth == 0 || --_paramBatchDepth > 0 || !_paramBatchDirty) return;
+    _paramBatchDirty = false;
+    publishParams();
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// A/B comparison
+// The slots live with _params on the writer side; a switch is an ordinary
+// publish flagged so the audio task fades out before it takes the new
+// generation and back in once the slot's handle sets are installed.
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Caller holds _mutex
+void AudioEngine::pinAbHandles()
+{
+    uint32_t pinned[SR_KINDS] = {};
+    auto pin = [&](int kind, bool on, int mode) {
+        if (on && mode >= 0 && mode < 32) pinned[kind] |= 1u << mode;
+    };
+    for (int s = 0; s < 2; s++) {
+        if (!_abLoaded[s]) continue;
+        const AudioEngineParams& p = _abParams[s];
+        pin(SR_NS, p.nsEnabled, p.nsMode);
+        pin(SR_AGC, p.agcEnabled && !p.agcLinked, p.agcMode);
+        pin(SR_VAD, p.veEnabled && p.veVadEnabled, p.veVadMode);
+    }
+    for (int k = 0; k < SR_KINDS; k++) _srPinned[k].store(pinned[k], std::memory_order_relaxed);
+    _aecTask.notify();
+}
+
+void AudioEngine::setAbSlot(int slot, const AudioEngineParams& p)
+{
+    if (slot < 0 || slot > 1) return;
+    std::lock_guard<std::mutex> lock(_mutex);
+    _abParams[slot] = p;
+    _abLoaded[slot] = true;
+    pinAbHandles();
+    if (slot != _abActive) return;
+    const int volume = _params.outputVolume;
+    const bool mute = _params.outputMute;
+    _params = p;
+    _params.outputVolume = volume;
+    _params.outputMute = mute;
+    _abSwitchPending.store(true, std::memory_order_release);
+    publishParams();
+}
+
+bool AudioEngine::selectAbSlot(int slot)
+{
+    if (slot < 0 || slot > 1) return false;
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_abLoaded[slot]) return false;
+    if (slot == _abActive) return true;
+    if (_abActive >= 0) _abParams[_abActive] = _params;
+    const int volume = _params.outputVolume;
+    const bool mute = _params.outputMute;
+    _params = _abParams[slot];
+    _params.outputVolume = volume;
+    _params.outputMute = mute;
+    _abActive = slot;
+    _abSwitchPending.store(true, std::memory_order_release);
+    publishParams();
+    mclog::tagInfo(TAG, "A/B: slot {} active", slot == 0 ? 'A' : 'B');
+    return true;
+}
+
+int AudioEngine::abSlot()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _abActive;
+}
+
+void AudioEngine::clearAbSlots()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _abLoaded[0] = _abLoaded[1] = false;
+    _abActive = -1;
+    pinAbHandles();
+}
+
+AudioLevels AudioEngine::getLevels()
+{
+    _levelsBuffer.update();
+    return _levelsBuffer.front();
+}
+
+size_t AudioEngine::drainLevels(AudioLevels* out, size_t maxFrames)
+{
+    return _levelsRing.pop_n(out, maxFrames);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Stage profiler (consumer side)
+// ─────────────────────────────────────────────────────────────────────────────
+
+static const char* const kStageNames[AUDIO_STAGE_COUNT] = {
+    "read", "convert in", "feedback", "beamform", "input filt", "ref+meter", "resample", "VE",
+    "NS", "AGC", "ear join", "spectral", "dynamics", "tinnitus", "mixer", "correction", "output", "write",
+    "DSP total",
+};
+
+void AudioEngine::setProfilingEnabled(bool enabled)
+{
+    if (enabled && !_profilingEnabled.load(std::memory_order_relaxed)) {
+        // Start from an empty window so stale blocks don't skew the stats
+        StageCycles discard[8];
+        while (_stageRing.pop_n(discard, 8) > 0) {}
+        _stageWindowHead = 0;
+        _stageWindowCount = 0;
+    }
+    _profilingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool AudioEngine::isProfilingEnabled() const
+{
+    return _profilingEnabled.load(std::memory_order_relaxed);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Spectrum analyzer (consumer side)
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Under _mutex, or before the audio task exists
+bool AudioEngine::allocSpectrumBuffers()
+{
+    if (_specCapture) return true;
+    if (SPEC_FFT > CONFIG_DSP_MAX_FFT_SIZE || !WolaProcessor::initFftTables()) {
+        mclog::tagError(TAG, "spectrum analyzer needs a {}-point FFT table", SPEC_FFT);
+        return false;
+    }
+    _specCapture = static_cast<float*>(heap_caps_malloc(2 * SPEC_FFT * sizeof(float), MALLOC_CAP_SPIRAM));
+    _specWindow = static_cast<float*>(heap_caps_malloc(SPEC_FFT * sizeof(float),
+        MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+    _specFft = static_cast<float*>(heap_caps_aligned_calloc(16, 2 * SPEC_FFT, sizeof(float),
+        MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+    if (!_specCapture || !_specWindow || !_specFft) {
+        mclog::tagError(TAG, "failed to allocate spectrum analyzer buffers");
+        heap_caps_free(_specCapture);
+        heap_caps_free(_specWindow);
+        heap_caps_free(_specFft);
+        _specCapture = _specWindow = _specFft = nullptr;
+        return false;
+    }
+    for (int i = 0; i < SPEC_FFT; i++) {
+        _specWindow[i] = 0.5f - 0.5f * cosf(2.0f * static_cast<float>(M_PI) * i / SPEC_FFT);
+    }
+    return true;
+}
+
+// Under _mutex: the analyzer runs while the UI or a remote client wants it
+bool AudioEngine::updateSpectrumEnabled()
+{
+    const bool enabled = _spectrumUi || _spectrumRemote;
+    if (enabled == _spectrumEnabled.load(std::memory_order_relaxed)) return true;
+    if (enabled && _running.load(std::memory_order_acquire) && !allocSpectrumBuffers()) return false;
+    // Release: the buffers are visible to the audio task before the flag
+    _spectrumEnabled.store(enabled, std::memory_order_release);
+    return true;
+}
+
+void AudioEngine::setSpectrumEnabled(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _spectrumUi = enabled;
+    if (!updateSpectrumEnabled()) _spectrumUi = false;
+}
+
+bool AudioEngine::getSpectrum(AudioSpectrum& out)
+{
+    if (!_spectrumBuffer.update()) return false;
+    out = _spectrumBuffer.front();
+    return true;
+}
+
+void AudioEngine::setLevelTapEnabled(LevelTap tap, bool enabled)
+{
+    const uint8_t bit = 1 << tap;
+    if (enabled) {
+        _levelTaps.fetch_or(bit, std::memory_order_release);
+    } else {
+        _levelTaps.fetch_and(static_cast<uint8_t>(~bit), std::memory_order_release);
+    }
+}
+
+bool AudioEngine::getTapLevels(LevelTap tap, AudioLevels& out)
+{
+    if (!_tapLevelsBuffer[tap].update()) return false;
+    out = _tapLevelsBuffer[tap].front();
+    return true;
+}
+
+void AudioEngine::setRemoteTelemetryEnabled(bool enabled)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _spectrumRemote = enabled;
+        if (!updateSpectrumEnabled()) _spectrumRemote = false;  // Levels still go out
+        _remoteSpectrum.store(_spectrumRemote, std::memory_order_release);
+    }
+    setLevelTapEnabled(LEVEL_TAP_REMOTE, enabled);
+}
+
+bool AudioEngine::getRemoteSpectrum(AudioSpectrum& out)
+{
+    if (!_remoteSpectrumBuffer.update()) return false;
+    out = _remoteSpectrumBuffer.front();
+    return true;
+}
+
+void AudioEngine::setAutoDegradeEnabled(bool enabled)
+{
+    _autoDegradeEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool AudioEngine::isAutoDegradeEnabled() const
+{
+    return _autoDegradeEnabled.load(std::memory_order_relaxed);
+}
+
+void AudioEngine::resetXrunStats()
+{
+    _xrunResetRequested.store(true, std::memory_order_relaxed);
+}
+
+AudioStageStats AudioEngine::getStageStats()
+{
+    StageCycles batch[16];
+    size_t n;
+    while ((n = _stageRing.pop_n(batch, 16)) > 0) {
+        for (size_t b = 0; b < n; b++) {
+            for (int s = 0; s < AUDIO_STAGE_COUNT; s++) {
+                _stageWindow[s][_stageWindowHead] = batch[b].cycles[s];
+            }
+            _stageWindowHead = (_stageWindowHead + 1) % STAGE_WINDOW_BLOCKS;
+            _stageWindowCount = std::min(_stageWindowCount + 1, STAGE_WINDOW_BLOCKS);
+        }
+    }
+
+    AudioStageStats stats;
+    stats.windowBlocks = _stageWindowCount;
+    stats.droppedBlocks = _stageRing.dropped();
+    // The cycles were counted under the audio_dsp lock, at the DFS maximum the governor set
+    stats.cpuMhz = CpuGovernor::getInstance().getStats().freqMhz;
+
+    uint32_t sorted[STAGE_WINDOW_BLOCKS];
+    const size_t count = _stageWindowCount;
+    for (int s = 0; s < AUDIO_STAGE_COUNT; s++) {
+        auto& st = stats.stages[s];
+        st.name = kStageNames[s];
+        if (count == 0) continue;
+
+        // Window order doesn't matter for the summary, only the first count slots are valid
+        uint64_t sum = 0;
+        uint32_t lo = UINT32_MAX, hi = 0;
+        for (size_t i = 0; i < count; i++) {
+            uint32_t c = _stageWindow[s][i];
+            sorted[i] = c;
+            sum += c;
+            lo = std::min(lo, c);
+            hi = std::max(hi, c);
+        }
+        size_t k = (count * 99) / 100;
+        if (k >= count) k = count - 1;
+        std::nth_element(sorted, sorted + k, sorted + count);
+
+        st.minCycles = lo;
+        st.maxCycles = hi;
+        st.avgCycles = static_cast<uint32_t>(sum / count);
+        st.p99Cycles = sorted[k];
+    }
+    return stats;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Hearing chain: the 48kHz stages between the bus and the generators, as
+// DspGraph stages. processLoop points the context at its per-block state and
+// switches the stages on and off; the graph runs whichever are on, in order.
+// ─────────────────────────────────────────────────────────────────────────────
+
+struct AudioEngine::HearingChain {
+    AudioEngine* engine = nullptr;
+    const AudioEngineParams* params = nullptr;
+    AudioLevels* levels = nullptr;
+    FrequencyShifter* shifter = nullptr;
+
+    // ── 7e'. Spectral stages: one shared WOLA analysis/synthesis for every registered client ──
+    static void spectral(void* ctx, DspGraph::Block& b)
+    {
+        static_cast<HearingChain*>(ctx)->engine->_wola.process(b.left, b.right, b.frames);
+    }
+    static void spectralReset(void* ctx)
+    {
+        // Re-entering starts from silence rather than replaying stale frames
+        auto* self = static_cast<HearingChain*>(ctx);
+        self->engine->_wola.reset();
+        self->engine->_nfc.reset();
+    }
+
+    // ── 7f. VAD-based gating with smoothing (attenuate output during non-speech) ──
+    // This reduces transient sounds (footsteps, etc.) when VAD detects silence
+    // Works with both NLMS and AEC modes
+    static void vadGate(void* ctx, DspGraph::Block& b)
+    {
+        auto* self = static_cast<HearingChain*>(ctx);
+        AudioEngine* e = self->engine;
+
+        // Calculate target gate value
+        float target = self->levels->vadSpeechDetected ? 1.0f : self->params->veVadGateAtten;
+
+        // Apply exponential smoothing to prevent clicks on transitions
+        // Smoothing: 5% per 480 samples gives ~200ms attack/release, scaled to the block size
+        const float smoothAlpha = 0.05f * b.frames / BLOCK_SIZE;
+        e->_vadGateSmoothed = (1.0f - smoothAlpha) * e->_vadGateSmoothed + smoothAlpha * target;
+
+        // Apply smoothed gate to output
+        for (int i = 0; i < b.frames; i++) {
+            b.left[i] *= e->_vadGateSmoothed;
+            b.right[i] *= e->_vadGateSmoothed;
+        }
+        self->levels->vadGateGain = e->_vadGateSmoothed;
+    }
+
+    // ── 7f'. Fitted mixer bus: streamed media joins ahead of WDRC / MBC and gets the fitting ──
+    static void fittedMix(void* ctx, DspGraph::Block& b)
+    {
+        AudioEngine* e = static_cast<HearingChain*>(ctx)->engine;
+        e->_mixer.mix(b.left, b.right, b.frames, e->_sampleRate, AudioMixer::BUS_FITTED);
+    }
+
+    // ── 7g. Audiogram-fitted WDRC (per ear; replaces the 16kHz AGC when on) ──
+    static void wdrc(void* ctx, DspGraph::Block& b)
+    {
+        auto* self = static_cast<HearingChain*>(ctx);
+        self->engine->_wdrc.process(b.left, b.right, b.frames);
+        self->engine->_wdrc.takeMeanGainDb(self->levels->wdrcGainDb);
+    }
+    static void wdrcReset(void* ctx)
+    {
+        static_cast<HearingChain*>(ctx)->engine->_wdrc.reset();
+    }
+
+    // ── 7h. Multiband compressor (48kHz, full band; replaces the 16kHz AGC when on) ──
+    static void mbc(void* ctx, DspGraph::Block& b)
+    {
+        auto* self = static_cast<HearingChain*>(ctx);
+        self->engine->_mbc.process(b.left, b.right, b.frames);
+        for (int k = 0; k < MultibandDynamics::MAX_BANDS; k++) {
+            self->levels->mbcGainReductionDb[k] = self->engine->_mbc.takeGainReductionDb(k);
+        }
+    }
+    static void mbcReset(void* ctx)
+    {
+        static_cast<HearingChain*>(ctx)->engine->_mbc.reset();
+    }
+
+    // ── 7i. Feedback decorrelation: shift the mic path a few Hz (generators stay exact) ──
+    // Breaks the loop's phase lock and keeps the canceller from adapting to the talker
+    static void shift(void* ctx, DspGraph::Block& b)
+    {
+        static_cast<HearingChain*>(ctx)->shifter->process(b.left, b.right, b.frames);
+    }
+    static void shiftReset(void* ctx)
+    {
+        static_cast<HearingChain*>(ctx)->shifter->reset();
+    }
+
+    // ── 8. Tinnitus Relief: Notch Filters (6 configurable) → HF extension shelf ──
+    // On while any section is live (enabled, fading out, or a parked howl notch)
+    static void tinnitus(void* ctx, DspGraph::Block& b)
+    {
+        AudioEngine* e = static_cast<HearingChain*>(ctx)->engine;
+        if (e->_earsSplit) {
+            e->_tinnitusCascade.process(b.left, nullptr, b.frames);
+            e->_tinnitusCascadeR.process(b.right, nullptr, b.frames);
+        } else {
+            e->_tinnitusCascade.process(b.left, b.right, b.frames);
+        }
+    }
+};
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Kernel micro-benchmark
+//
+// Each kernel gets a few untimed warm-up calls (caches, coefficient glides,
+// adaptive state) and is then timed over BENCH_RUNS calls; the best call is
+// kept, which also filters out preemption when the engine runs alongside.
+// Limits are shares of real time on one core, set with headroom over what the
+// kernels need today so they only trip on real regressions.
+// ─────────────────────────────────────────────────────────────────────────────
+
+namespace {
+
+constexpr int BENCH_WARMUP = 8;
+constexpr int BENCH_RUNS = 16;
+constexpr int BENCH_FRAMES = 480;      // One 10ms block at 48kHz
+constexpr int BENCH_AEC_FRAME = 512;   // ESP-SR AEC frame at 16kHz
+
+// Work buffers for one run; internal RAM like the engine's hot arena
+struct BenchBuffers {
+    float l[BENCH_FRAMES], r[BENCH_FRAMES];
+    float ref[BENCH_FRAMES], hp[BENCH_FRAMES];
+    float work[BENCH_FRAMES];
+    int16_t in16[BENCH_AEC_FRAME], ref16[BENCH_AEC_FRAME], out16[2 * BENCH_FRAMES];
+    int16_t mic2[2 * BENCH_AEC_FRAME], out2[2 * BENCH_AEC_FRAME];  // Shared AEC: interleaved L/R
+};
+
+template <typename Fn>
+uint32_t benchBestCycles(Fn&& fn)
+{
+    for (int i = 0; i < BENCH_WARMUP; i++) fn();
+    uint32_t best = UINT32_MAX;
+    for (int i = 0; i < BENCH_RUNS; i++) {
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        fn();
+        best = std::min(best, esp_cpu_get_cycle_count() - t0);
+    }
+    return best;
+}
+
+}  // namespace
+
+bool AudioEngine::startBenchmark()
+{
+    bool expected = false;
+    if (!_benchBusy.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+        mclog::tagWarn(TAG, "benchmark already running");
+        return false;
+    }
+    _benchReady.store(false, std::memory_order_relaxed);
+    // Core 1 like the audio task, but lowest priority: never steals its deadlines.
+    // ESP-SR needs the same stack as the AEC worker.
+    if (xTaskCreatePinnedToCore(benchTask, "audio_bench", 20480, this, 1, nullptr, core_policy::DSP_CORE) != pdPASS) {
+        mclog::tagError(TAG, "failed to create benchmark task");
+        _benchBusy.store(false, std::memory_order_release);
+        return false;
+    }
+    return true;
+}
+
+bool AudioEngine::getBenchmarkReport(AudioBenchReport& out)
+{
+    if (!_benchReady.load(std::memory_order_acquire)) return false;
+    out = _benchReport;
+    return true;
+}
+
+bool AudioEngine::isBenchmarkRunning() const
+{
+    return _benchBusy.load(std::memory_order_acquire);
+}
+
+void AudioEngine::benchTask(void* param)
+{
+    auto* self = static_cast<AudioEngine*>(param);
+    self->runBenchmark(self->_benchReport);
+    self->_benchReady.store(true, std::memory_order_release);
+    self->_benchBusy.store(false, std::memory_order_release);
+    vTaskDelete(nullptr);
+}
+
+// Kernel equivalence checks: 100ms of log sweep (20Hz-20kHz) plus noise through
+// each optimized kernel and a straightforward scalar version of the same math.
+// Tolerances absorb reordered float sums (PIE kernels, DF2 vs DF2T), nothing more.
+// Entry address of a non-virtual member function: the first word of the member pointer (Itanium C++ ABI)
+template <typename Pmf>
+static const void* memberCode(Pmf pmf)
+{
+    const void* code;
+    static_assert(sizeof(pmf) >= sizeof(code), "unexpected member pointer layout");
+    std::memcpy(&code, &pmf, sizeof(code));
+    return code;
+}
+
+void AudioEngine::runKernelChecks(AudioBenchReport& report)
+{
+    constexpr int N48 = 10 * BLOCK_SIZE;
+    constexpr int N16 = N48 / 3;
+    auto alloc = [](size_t count) {
+        return static_cast<float*>(heap_caps_calloc_prefer(count, sizeof(float), 2,
+            MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+    };
+    float* sigL = alloc(N48);
+    float* sigR = alloc(N48);
+    float* outA = alloc(2 * N48);
+    float* outB = alloc(2 * N48);
+    if (!sigL || !sigR || !outA || !outB) {
+        mclog::tagError(TAG, "checks: out of memory");
+        heap_caps_free(sigL);
+        heap_caps_free(sigR);
+        heap_caps_free(outA);
+        heap_caps_free(outB);
+        return;
+    }
+
+    uint32_t seed = 0x2545F491u;
+    auto noise = [&seed]() {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return static_cast<int32_t>(seed) * (1.0f / 2147483648.0f);
+    };
+    float phase = 0.0f;
+    for (int i = 0; i < N48; i++) {
+        float f = 20.0f * powf(1000.0f, static_cast<float>(i) / N48);
+        phase = wrapPhase(phase + TWO_PI * f / SAMPLE_RATE);
+        sigL[i] = 0.25f * sinf(phase) + 0.05f * noise();
+        sigR[i] = 0.25f * cosf(phase) + 0.05f * noise();
+    }
+
+    auto check = [&](const char* name, float maxError, float tolerance) {
+        if (report.checkCount == AudioBenchReport::MAX_CHECKS) return;
+        auto& c = report.checks[report.checkCount++];
+        c.name = name;
+        c.maxError = maxError;
+        c.tolerance = tolerance;
+        c.passed = maxError <= tolerance;  // NaN fails
+    };
+    auto maxDiff = [](const float* a, const float* b, int n) {
+        float worst = 0.0f;
+        for (int i = 0; i < n; i++) {
+            float d = fabsf(a[i] - b[i]);
+            worst = (d > worst || std::isnan(d)) ? d : worst;
+        }
+        return worst;
+    };
+
+    // Resampler: polyphase branches vs the direct FIR (zero-stuffed on the way up), 3:1 and 2:1
+    for (int ratio : {3, 2}) {
+        const int n16 = N48 / ratio;
+        const int taps = Resampler::taps(ratio);
+        const float* h = Resampler::kernel(ratio);
+        auto* rs = new Resampler();
+        rs->init(true, ratio);
+        for (int b = 0; b < n16; b += NS_FRAME_16K) rs->downsample(sigL + ratio * b, outA + b, NS_FRAME_16K);
+        for (int i = 0; i < n16; i++) {
+            float sum = 0.0f;
+            for (int t = 0; t < taps; t++) {
+                int n = ratio * i + ratio - 1 - t;
+                if (n >= 0) sum += h[t] * sigL[n];
+            }
+            outB[i] = sum;
+        }
+        check(ratio == 3 ? "resampler down" : "half-band down", maxDiff(outA, outB, n16), 1e-5f);
+
+        rs->init(false, ratio);
+        for (int b = 0; b < n16; b += NS_FRAME_16K) rs->upsample(sigR + b, outA + ratio * b, NS_FRAME_16K);
+        for (int n = 0; n < N48; n++) {
+            float sum = 0.0f;
+            for (int t = n % ratio; t < taps && t <= n; t += ratio) {
+                sum += h[t] * sigR[(n - t) / ratio];
+            }
+            outB[n] = ratio * sum;
+        }
+        check(ratio == 3 ? "resampler up" : "half-band up", maxDiff(outA, outB, N48), 1e-5f);
+        delete rs;
+    }
+
+    // Bus band split: with the bus stages left out, low band + high band is the input delayed
+    for (int ratio : {3, 2}) {
+        constexpr int BLOCK = 96;
+        const int chunk = BLOCK / ratio;
+        const int prime = NS_FRAME_16K - chunk;
+        auto* down = new Resampler();
+        auto* up = new Resampler();
+        auto* fifo = new BusFifo();
+        auto* split = new BusBandSplit();
+        down->init(true, ratio);
+        up->init(false, ratio);
+        fifo->reset(prime);
+        split->reset(prime, ratio);
+        float low[BLOCK / 2];
+        for (int b = 0; b < N48; b += BLOCK) {
+            down->downsample(sigL + b, low, chunk);
+            split->capture(sigL + b, low, chunk);
+            fifo->push(low, chunk);
+            fifo->pop(low, chunk);
+            up->upsample(low, outA + b, chunk);
+            split->restore(outA + b, chunk, 1.0f, 1.0f);
+        }
+        const int delay = ratio * prime + BusBandSplit::roundTripDelay(ratio);
+        check(ratio == 3 ? "bus band split" : "half-band split", maxDiff(outA + delay, sigL, N48 - delay), 1e-5f);
+        delete split;
+        delete fifo;
+        delete up;
+        delete down;
+    }
+
+    // Correction FIR: partitioned convolution vs the direct sum, BLOCK samples late, on a
+    // block size the partitions don't divide
+    {
+        constexpr int TAPS = 300;
+        std::vector<float> irL(TAPS), irR(TAPS);
+        for (int t = 0; t < TAPS; t++) {
+            irL[t] = sinf(0.37f * t) * expf(-0.01f * t);
+            irR[t] = cosf(0.21f * t) / (1.0f + t);
+        }
+        if (auto* fir = FirConvolver::create(irL.data(), irR.data(), TAPS)) {
+            std::memcpy(outA, sigL, N48 * sizeof(float));
+            std::memcpy(outA + N48, sigR, N48 * sizeof(float));
+            for (int b = 0; b < N48; b += BLOCK_SIZE) fir->process(outA + b, outA + N48 + b, BLOCK_SIZE);
+            const int delay = fir->latencySamples();
+            for (int n = 0; n < N48 - delay; n++) {
+                float sumL = 0.0f, sumR = 0.0f;
+                for (int t = 0; t < TAPS && t <= n; t++) {
+                    sumL += irL[t] * sigL[n - t];
+                    sumR += irR[t] * sigR[n - t];
+                }
+                outB[n] = sumL;
+                outB[N48 + n] = sumR;
+            }
+            check("correction fir", std::max(maxDiff(outA + delay, outB, N48 - delay),
+                                             maxDiff(outA + N48 + delay, outB + N48, N48 - delay)), 1e-4f);
+            delete fir;
+        } else {
+            check("correction fir", NAN, 1e-4f);
+        }
+    }
+
+    // BiquadCascade (settled, esp-dsp DF2 on P4) vs chained scalar DF2T sections
+    {
+        constexpr int SECTIONS = BiquadCascade::MAX_SECTIONS;
+        auto* cascade = new BiquadCascade();
+        Biquad ref[SECTIONS][2];
+        for (int s = 0; s < SECTIONS; s++) {
+            Biquad bq;
+            if (s == 0) {
+                calcHpfCoeffs(bq, 80.0f, SAMPLE_RATE);
+            } else if (s == SECTIONS - 1) {
+                calcLpfCoeffs(bq, 12000.0f, SAMPLE_RATE);
+            } else {
+                calcPeakEqCoeffs(bq, 200.0f * (1 << (s - 1)), s % 2 ? 6.0f : -6.0f, 1.4f, SAMPLE_RATE);
+            }
+            cascade->setSection(s, bq, true);
+            ref[s][0] = ref[s][1] = bq;
+        }
+        // Finish the fade-in glide on silence, then start both from clean state
+        std::memset(outA, 0, 2 * BLOCK_SIZE * sizeof(float));
+        for (int i = 0; i < 128; i++) cascade->process(outA, outA + BLOCK_SIZE, BLOCK_SIZE);
+        cascade->reset();
+
+        std::memcpy(outA, sigL, N48 * sizeof(float));
+        std::memcpy(outA + N48, sigR, N48 * sizeof(float));
+        for (int b = 0; b < N48; b += BLOCK_SIZE) cascade->process(outA + b, outA + N48 + b, BLOCK_SIZE);
+        for (int i = 0; i < N48; i++) {
+            float l = sigL[i], r = sigR[i];
+            for (int s = 0; s < SECTIONS; s++) {
+                l = ref[s][0].process(l);
+                r = ref[s][1].process(r);
+            }
+            outB[i] = l;
+            outB[N48 + i] = r;
+        }
+        check("biquad cascade", maxDiff(outA, outB, 2 * N48), 1e-4f);
+        delete cascade;
+    }
+
+    // StereoNlmsFilter (mirrored line, running power, dual dot product) vs a
+    // modulo delay line with the power summed fresh every sample
+    {
+        constexpr int TAPS = 128;
+        auto* nlms = new StereoNlmsFilter();
+        nlms->init(TAPS);
+        float* wL = alloc(TAPS);
+        float* wR = alloc(TAPS);
+        float* line = alloc(TAPS);
+        if (nlms->isInitialized() && wL && wR && line) {
+            int pos = 0;
+            float worst = 0.0f;
+            for (int n = 0; n < N16; n++) {
+                // Reference path: the voice reaching each mic through a short echo
+                float x = sigL[3 * n];
+                float pL = 0.6f * (n >= 3 ? sigL[3 * (n - 3)] : 0.0f) + 0.02f * sigR[3 * n];
+                float pR = 0.4f * (n >= 7 ? sigL[3 * (n - 7)] : 0.0f) - 0.02f * sigR[3 * n];
+                float estL, estR;
+                nlms->process(x, pL, pR, 0.05f, estL, estR);
+
+                pos = (pos + TAPS - 1) % TAPS;
+                line[pos] = x;
+                float power = 0.0f, refL = 0.0f, refR = 0.0f;
+                for (int i = 0; i < TAPS; i++) {
+                    float xi = line[(pos + i) % TAPS];
+                    power += xi * xi;
+                    refL += wL[i] * xi;
+                    refR += wR[i] * xi;
+                }
+                float step = 0.05f / (power + 1e-4f);
+                float kL = step * (pL - refL), kR = step * (pR - refR);
+                for (int i = 0; i < TAPS; i++) {
+                    float xi = line[(pos + i) % TAPS];
+                    float a = wL[i] + kL * xi, b = wR[i] + kR * xi;
+                    wL[i] = fabsf(a) > 5.0f ? a * 0.95f : a;
+                    wR[i] = fabsf(b) > 5.0f ? b * 0.95f : b;
+                }
+                float d = std::max(fabsf(estL - refL), fabsf(estR - refR));
+                worst = (d > worst || std::isnan(d)) ? d : worst;
+            }
+            check("nlms 128 taps", worst, 1e-3f);
+        }
+        heap_caps_free(wL);
+        heap_caps_free(wR);
+        heap_caps_free(line);
+        nlms->destroy();
+        delete nlms;
+    }
+
+    // StereoSubbandNlms: on echo paths a whole number of hops long the bands are exact,
+    // so the residual over the last quarter must all but vanish (packing, delay, overlap-add)
+    {
+        auto* subband = new StereoSubbandNlms();
+        subband->init(64);
+        float* ref = alloc(N16);
+        if (subband->isInitialized() && ref) {
+            float* pL = outA;
+            float* pR = outA + N16;
+            float* estL = outB;
+            float* estR = outB + N16;
+            constexpr int HOP = StereoSubbandNlms::HOP;
+            for (int n = 0; n < N16; n++) {
+                ref[n] = sigL[3 * n];
+                pL[n] = n >= HOP ? 0.6f * sigL[3 * (n - HOP)] : 0.0f;
+                pR[n] = n >= 2 * HOP ? -0.4f * sigL[3 * (n - 2 * HOP)] : 0.0f;
+            }
+            for (int off = 0; off < N16; off += NS_FRAME_16K) {
+                subband->process(ref + off, pL + off, pR + off, NS_FRAME_16K, 0.5f, estL + off, estR + off);
+            }
+            float power = 0.0f, residual = 0.0f;
+            for (int n = 3 * N16 / 4; n < N16; n++) {
+                power += pL[n] * pL[n] + pR[n] * pR[n];
+                residual += (pL[n] - estL[n]) * (pL[n] - estL[n]) + (pR[n] - estR[n]) * (pR[n] - estR[n]);
+            }
+            check("subband nlms", residual / std::max(power, 1e-9f), 1e-3f);
+        }
+        heap_caps_free(ref);
+        subband->destroy();
+        delete subband;
+    }
+
+    // Fused output stage vs gain → Padé soft clip → clamp → int16 one step at a time
+    {
+        auto* packed = reinterpret_cast<int16_t*>(outA);
+        float sumL = 0.0f, sumR = 0.0f, pkL = 0.0f, pkR = 0.0f;
+        const float gain = 3.0f;  // Drives the sweep well into the clipper
+        for (int b = 0; b < N48; b += BLOCK_SIZE) {
+            outputKernel<true, true>(sigL + b, sigR + b, packed + 2 * b, BLOCK_SIZE, gain, sumL, sumR, pkL, pkR);
+        }
+        auto clip = [](float v) {
+            float x = std::clamp(v * 1.5f, -3.0f, 3.0f);
+            float t = x * (27.0f + x * x) / (27.0f + 9.0f * x * x);
+            return t / (1.5f * (27.0f + 2.25f) / (27.0f + 9.0f * 2.25f));
+        };
+        float worst = 0.0f;
+        for (int i = 0; i < N48; i++) {
+            float l = std::clamp(clip(sigL[i] * gain), -1.0f, 1.0f);
+            float r = std::clamp(clip(sigR[i] * gain), -1.0f, 1.0f);
+            float dl = fabsf(packed[2 * i] - l * 32767.0f);
+            float dr = fabsf(packed[2 * i + 1] - r * 32767.0f);
+            worst = std::max(worst, std::max(dl, dr) / 32768.0f);
+        }
+        check("output stage", worst, 2.0f / 32768.0f);  // Truncation plus one LSB
+    }
+
+    // ── Hot code placement: what main/linker.lf maps to internal RAM is still there ──
+    {
+        struct HotCode {
+            const char* name;
+            const void* code;
+        };
+        const HotCode hot[] = {
+            {"processLoop", memberCode(&AudioEngine::processLoop)},
+            {"HearingChain::wdrc", reinterpret_cast<const void*>(&HearingChain::wdrc)},
+            {"Biquad::process", memberCode(&Biquad::process)},
+            {"BiquadCascade::process", memberCode(&BiquadCascade::process)},
+            {"MultibandDynamics::process", memberCode(&MultibandDynamics::process)},
+            {"WdrcFilterbank::process", memberCode(&WdrcFilterbank::process)},
+            {"HowlDetector::process", memberCode(&HowlDetector::process)},
+            {"StereoNlmsFilter::process", memberCode(&StereoNlmsFilter::process)},
+            {"Beamformer::process", memberCode(&Beamformer::process)},
+            {"FrequencyShifter::process", memberCode(&FrequencyShifter::process)},
+            {"LookaheadLimiter::process", memberCode(&LookaheadLimiter::process)},
+            {"LinkedAgc::process", memberCode(&LinkedAgc::process)},
+            {"BusBandSplit::restore", memberCode(&BusBandSplit::restore)},
+            {"FirConvolver::process", memberCode(&FirConvolver::process)},
+            {"outputKernel", reinterpret_cast<const void*>(&outputKernel<false, true>)},
+            {"outputKernel boost", reinterpret_cast<const void*>(&outputKernel<true, true>)},
+        };
+        int misplaced = 0;
+        for (const auto& h : hot) {
+            if (!esp_ptr_internal(h.code)) {
+                mclog::tagWarn(TAG, "checks: {} runs from {} (outside internal RAM)", h.name, h.code);
+                misplaced++;
+            }
+        }
+        check("hot code placement", static_cast<float>(misplaced), 0.0f);
+    }
+
+    heap_caps_free(sigL);
+    heap_caps_free(sigR);
+    heap_caps_free(outA);
+    heap_caps_free(outB);
+}
+
+void AudioEngine::runBenchmark(AudioBenchReport& report)
+{
+    static_assert(BENCH_FRAMES == BLOCK_SIZE && BENCH_FRAMES == 3 * NS_FRAME_16K, "bench frame sizes");
+    report = AudioBenchReport{};
+    report.engineRunning = _running.load(std::memory_order_acquire);
+
+    // A fast kernel that is wrong doesn't deserve a time
+    runKernelChecks(report);
+
+    auto* buf = static_cast<BenchBuffers*>(heap_caps_calloc(1, sizeof(BenchBuffers),
+        MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+    if (!buf) {
+        mclog::tagError(TAG, "benchmark: out of internal memory");
+        return;
+    }
+
+#if CONFIG_PM_ENABLE
+    // One clock for the whole run, the one the audio task holds for its blocks
+    esp_pm_lock_handle_t benchPmLock = nullptr;
+    if (esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "audio_bench", &benchPmLock) == ESP_OK) {
+        esp_pm_lock_acquire(benchPmLock);
+    } else {
+        benchPmLock = nullptr;
+    }
+#endif
+    report.cpuMhz = esp_clk_cpu_freq() / 1000000;
+
+    // Band-limited-ish noise around -20 dBFS, decorrelated per lane
+    uint32_t seed = 0x1234567u;
+    auto noise = [&seed]() {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return (static_cast<int32_t>(seed) * (1.0f / 2147483648.0f)) * 0.1f;
+    };
+    for (int i = 0; i < BENCH_FRAMES; i++) {
+        buf->l[i] = noise();
+        buf->r[i] = noise();
+        buf->ref[i] = noise();
+        buf->hp[i] = 0.5f * buf->l[i] + noise();
+    }
+    for (int i = 0; i < BENCH_AEC_FRAME; i++) {
+        buf->in16[i] = static_cast<int16_t>(buf->l[i % BENCH_FRAMES] * 32767.0f);
+        buf->ref16[i] = static_cast<int16_t>(buf->ref[i % BENCH_FRAMES] * 32767.0f);
+        buf->mic2[2 * i] = buf->in16[i];
+        buf->mic2[2 * i + 1] = static_cast<int16_t>(buf->r[i % BENCH_FRAMES] * 32767.0f);
+    }
+
+    const float cpuHz = report.cpuMhz * 1e6f;
+    auto record = [&](const char* name, uint32_t frames, uint32_t rate, float limitPct, uint32_t cycles) {
+        if (report.count == AudioBenchReport::MAX_RESULTS) return;
+        auto& r = report.results[report.count++];
+        r.name = name;
+        r.frames = frames;
+        r.rate = rate;
+        r.cycles = cycles;
+        r.cyclesPerSample = static_cast<float>(cycles) / frames;
+        r.realtimePct = 100.0f * cycles * rate / (cpuHz * frames);
+        r.limitPct = limitPct;
+        r.passed = r.realtimePct <= limitPct;
+    };
+
+    // 48k ↔ 16k bus, one lane
+    {
+        auto* rs = new Resampler();
+        rs->init(true);
+        record("resample 48k>16k", BENCH_FRAMES, SAMPLE_RATE, 1.0f, benchBestCycles([&] {
+            rs->downsample(buf->l, buf->work, NS_FRAME_16K);
+        }));
+        rs->init(false);
+        record("resample 16k>48k", NS_FRAME_16K, 16000, 1.0f, benchBestCycles([&] {
+            rs->upsample(buf->work, buf->r, NS_FRAME_16K);
+        }));
+        delete rs;
+    }
+
+    // Full 8-section stereo cascade (the tinnitus notch bank with EQ-like sections)
+    {
+        auto* cascade = new BiquadCascade();
+        for (int s = 0; s < BiquadCascade::MAX_SECTIONS; s++) {
+            Biquad bq;
+            calcPeakEqCoeffs(bq, 250.0f * (s + 1), 6.0f, 1.4f, SAMPLE_RATE);
+            cascade->setSection(s, bq, true);
+        }
+        // Let the coefficient glide settle so the steady-state path is what gets timed
+        for (int i = 0; i < 64; i++) cascade->process(buf->l, buf->r, BENCH_FRAMES);
+        record("biquad x8 stereo", BENCH_FRAMES, SAMPLE_RATE, 4.0f, benchBestCycles([&] {
+            cascade->process(buf->l, buf->r, BENCH_FRAMES);
+        }));
+        delete cascade;
+    }
+
+    // HPF + LPF + one EQ band, the usual input chain: the largest fused kernel size that gets hit
+    {
+        auto* cascade = new BiquadCascade();
+        Biquad bq;
+        calcHpfCoeffs(bq, 100.0f, SAMPLE_RATE);
+        cascade->setSection(SLOT_HPF, bq, true);
+        calcLpfCoeffs(bq, 8000.0f, SAMPLE_RATE);
+        cascade->setSection(SLOT_LPF, bq, true);
+        calcPeakEqCoeffs(bq, 2000.0f, 6.0f, 1.4f, SAMPLE_RATE);
+        cascade->setSection(SLOT_EQ_MID, bq, true);
+        for (int i = 0; i < 64; i++) cascade->process(buf->l, buf->r, BENCH_FRAMES);
+        record("biquad x3 stereo", BENCH_FRAMES, SAMPLE_RATE, 2.0f, benchBestCycles([&] {
+            cascade->process(buf->l, buf->r, BENCH_FRAMES);
+        }));
+        delete cascade;
+    }
+
+    // Voice-exclusion NLMS at each power-of-two tap length, one 10ms bus frame
+    {
+        static const char* const names[] = {"nlms 64 taps", "nlms 128 taps", "nlms 256 taps", "nlms 512 taps"};
+        int taps = 64;
+        for (const char* name : names) {
+            auto* nlms = new StereoNlmsFilter();
+            nlms->init(taps);
+            if (nlms->isInitialized()) {
+                float estL, estR;
+                record(name, NS_FRAME_16K, 16000, taps / 32.0f, benchBestCycles([&] {
+                    for (int i = 0; i < NS_FRAME_16K; i++) {
+                        nlms->process(buf->hp[i], buf->l[i], buf->r[i], 0.01f, estL, estR);
+                    }
+                }));
+            }
+            nlms->destroy();
+            delete nlms;
+            taps *= 2;
+        }
+    }
+
+    // Subband VE at the longest time-domain length, what it is priced against
+    {
+        auto* subband = new StereoSubbandNlms();
+        subband->init(512);
+        if (subband->isInitialized()) {
+            record("subband nlms 512 taps", NS_FRAME_16K, 16000, 10.0f, benchBestCycles([&] {
+                subband->process(buf->hp, buf->l, buf->r, NS_FRAME_16K, 0.01f, buf->work, buf->work + NS_FRAME_16K);
+            }));
+        }
+        subband->destroy();
+        delete subband;
+    }
+
+    // ESP-SR stages, one lane at the engine's default modes
+    {
+        void* nsL = nullptr;
+        void* nsR = nullptr;
+        createNsHandles(nsL, nsR, 2);
+        if (audio_stages::NS && nsL) {
+            record("ns aggressive", NS_FRAME_16K, 16000, 6.0f, benchBestCycles([&] {
+                ns_process(static_cast<ns_handle_t>(nsL), buf->in16, buf->out16);
+            }));
+        }
+        destroyNsHandles(nsL, nsR);
+
+        void* agcL = nullptr;
+        void* agcR = nullptr;
+        createAgcHandles(agcL, agcR, 2);
+        if (audio_stages::AGC && agcL) {
+            set_agc_config(agcL, 9, 1, -3);
+            record("agc digital", NS_FRAME_16K, 16000, 3.0f, benchBestCycles([&] {
+                esp_agc_process(agcL, buf->in16, buf->out16, NS_FRAME_16K, 16000);
+            }));
+        }
+        destroyAgcHandles(agcL, agcR);
+
+        void* vad = nullptr;
+        createVadHandle(vad, 3);
+        if (audio_stages::VAD && vad) {
+            record("vad", NS_FRAME_16K, 16000, 2.0f, benchBestCycles([&] {
+                vad_process(static_cast<vad_handle_t>(vad), buf->in16, 16000, 10);
+            }));
+        }
+        destroyVadHandle(vad);
+
+        static const char* const aecNames[] = {"aec sr low cost", "aec sr high perf"};
+        for (int mode = 0; mode < 2; mode++) {
+            void* aecL = nullptr;
+            void* aecR = nullptr;
+            createAecHandles(aecL, aecR, mode, 4, true);
+            if (audio_stages::AEC && aecL) {
+                // Shared two-mic handle, one AEC frame (32ms)
+                record(aecNames[mode], BENCH_AEC_FRAME, 16000, mode == 0 ? 12.0f : 20.0f, benchBestCycles([&] {
+                    aec_process(static_cast<aec_handle_t*>(aecL), buf->mic2, buf->ref16, buf->out2);
+                }));
+            }
+            destroyAecHandles(aecL, aecR);
+        }
+
+        // The same chain as one AFE (busAfe): AEC high perf, NS and AGC on (mid, ref) pairs.
+        // feed() and fetch() both run on this task, so the cycles are the whole AFE
+        AfeHandle afe;
+        createAfeHandle(afe, packAfeConfig(true, true, true, 1, 4, 9, -3), BENCH_AEC_FRAME);
+        if (audio_stages::AFE && afe.data) {
+            for (int i = 0; i < BENCH_AEC_FRAME; i++) buf->mic2[2 * i + 1] = buf->ref16[i];
+            // Its own buffering: how much goes in before the first output comes back
+            int fed = 0;
+            while (fed < 8 * BENCH_AEC_FRAME &&
+                   runAfeFrame(afe, buf->mic2, BENCH_AEC_FRAME, buf->out2, 0, 2 * BENCH_AEC_FRAME) == 0) {
+                fed += BENCH_AEC_FRAME;
+            }
+            record("afe vc chain", BENCH_AEC_FRAME, 16000, 25.0f, benchBestCycles([&] {
+                runAfeFrame(afe, buf->mic2, BENCH_AEC_FRAME, buf->out2, 0, 2 * BENCH_AEC_FRAME);
+            }));
+            // Against the hand-built chain at the same settings: two NS and AGC lanes on the
+            // audio core, the shared AEC on the worker
+            auto pctOf = [&](const char* name) {
+                for (int i = 0; i < report.count; i++) {
+                    if (strcmp(report.results[i].name, name) == 0) return report.results[i].realtimePct;
+                }
+                return 0.0f;
+            };
+            const float chainPct = 2.0f * (pctOf("ns aggressive") + pctOf("agc digital")) + pctOf("aec sr high perf");
+            mclog::tagInfo(TAG, "afe vc chain {:.2f}% rt vs {:.2f}% for the separate stages; "
+                "first output after {:.1f} ms, on top of the {:.1f} ms frame bridge",
+                pctOf("afe vc chain"), chainPct, (fed + BENCH_AEC_FRAME) * 1000.0f / 16000.0f,
+                AecFrameBridge::LATENCY * 1000.0f / 16000.0f);
+        }
+        destroyAfeHandle(afe);
+    }
+
+    // Output end of the chain at 48kHz
+    {
+        auto* limiter = new LookaheadLimiter();
+        limiter->configure(-1.0f, 50.0f, SAMPLE_RATE);
+        limiter->reset();
+        record("limiter", BENCH_FRAMES, SAMPLE_RATE, 2.0f, benchBestCycles([&] {
+            limiter->process(buf->l, buf->r, BENCH_FRAMES, 1.0f);
+        }));
+        delete limiter;
+
+        float sumL = 0.0f, sumR = 0.0f, pkL = 0.0f, pkR = 0.0f;
+        record("output stage", BENCH_FRAMES, SAMPLE_RATE, 1.5f, benchBestCycles([&] {
+            outputKernel<true, true>(buf->l, buf->r, buf->out16, BENCH_FRAMES, 1.2f, sumL, sumR, pkL, pkR);
+        }));
+    }
+
+#if CONFIG_PM_ENABLE
+    if (benchPmLock) {
+        esp_pm_lock_release(benchPmLock);
+        esp_pm_lock_delete(benchPmLock);
+    }
+#endif
+    heap_caps_free(buf);
+
+    report.passed = report.count > 0 && report.checkCount > 0;
+    mclog::tagInfo(TAG, "DSP kernel checks vs scalar references");
+    for (int i = 0; i < report.checkCount; i++) {
+        const auto& c = report.checks[i];
+        report.passed = report.passed && c.passed;
+        mclog::tagInfo(TAG, "  {:<18} max err {:.3g} (tolerance {:.3g}) {}",
+            c.name, c.maxError, c.tolerance, c.passed ? "PASS" : "FAIL");
+    }
+    mclog::tagInfo(TAG, "DSP kernel benchmark @ {} MHz{} (best of {} calls)", report.cpuMhz,
+        report.engineRunning ? ", engine running" : "", BENCH_RUNS);
+    for (int i = 0; i < report.count; i++) {
+        const auto& r = report.results[i];
+        report.passed = report.passed && r.passed;
+        mclog::tagInfo(TAG, "  {:<18} {:>4} @ {:>5} Hz {:>9} cyc {:>8.1f} cyc/smp {:>6.2f}% rt (limit {:.1f}%) {}",
+            r.name, r.frames, r.rate, r.cycles, r.cyclesPerSample, r.realtimePct, r.limitPct,
+            r.passed ? "PASS" : "FAIL");
+    }
+    if (report.passed) {
+        mclog::tagInfo(TAG, "benchmark passed");
+    } else {
+        mclog::tagWarn(TAG, "benchmark FAILED: a kernel is off its reference or over its budget");
+    }
+
+    // The timings are real either way; the cost model prices profiles with them from now on
+    if (report.count > 0) AudioCostModel::getInstance().calibrate(report);
+}
+
+void AudioEngine::setMicGain(float gain)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.micGain = std::clamp(gain, 0.0f, 240.0f);
+    publishParams();
+}
+
+void AudioEngine::setCaptureBits(int bits)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.captureBits = bits > 16 ? 24 : 16;
+    publishParams();
+}
+
+void AudioEngine::setBeamMode(int mode)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.beamMode = std::clamp(mode, 0, 2);
+    publishParams();
+}
+
+void AudioEngine::setBeamSteering(float degrees)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.beamSteerDeg = std::clamp(degrees, -90.0f, 90.0f);
+    publishParams();
+}
+
+void AudioEngine::setBeamMicSpacing(float mm)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.beamMicSpacingMm = std::clamp(mm, 10.0f, 150.0f);
+    publishParams();
+}
+
+void AudioEngine::setWindReduction(int mode, float hpfMaxHz)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.windMode = std::clamp(mode, 0, 2);
+    _params.windHpfMaxHz = std::clamp(hpfMaxHz, 100.0f, 500.0f);
+    publishParams();
+}
+
+void AudioEngine::setEarsLinked(bool linked)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    // Linking hands the right ear the left one's settings, so unlinking again starts from them
+    if (linked) _params.rightEar = _params.ear(AUDIO_EAR_LEFT);
+    _params.earsLinked = linked;
+    publishParams();
+}
+
+void AudioEngine::setHpf(bool enabled, float freq, AudioEar ear)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    freq = std::clamp(freq, 20.0f, 2000.0f);
+    if (ear != AUDIO_EAR_RIGHT) {
+        _params.hpfEnabled = enabled;
+        _params.hpfFrequency = freq;
+    }
+    if (ear != AUDIO_EAR_LEFT) {
+        _params.rightEar.hpfEnabled = enabled;
+        _params.rightEar.hpfFrequency = freq;
     }
+    publishParams();
+}
+
+void AudioEngine::setLpf(bool enabled, float freq, AudioEar ear)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    freq = std::clamp(freq, 500.0f, 20000.0f);
+    if (ear != AUDIO_EAR_RIGHT) {
+        _params.lpfEnabled = enabled;
+        _params.lpfFrequency = freq;
+    }
+    if (ear != AUDIO_EAR_LEFT) {
+        _params.rightEar.lpfEnabled = enabled;
+        _params.rightEar.lpfFrequency = freq;
+    }
+    publishParams();
+}
+
+void AudioEngine::setEqLow(float gainDb, AudioEar ear)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    gainDb = std::clamp(gainDb, -12.0f, 12.0f);
+    if (ear != AUDIO_EAR_RIGHT) _params.eqLowGain = gainDb;
+    if (ear != AUDIO_EAR_LEFT) _params.rightEar.eqLowGain = gainDb;
+    publishParams();
+}
+
+void AudioEngine::setEqMid(float gainDb, AudioEar ear)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    gainDb = std::clamp(gainDb, -12.0f, 12.0f);
+    if (ear != AUDIO_EAR_RIGHT) _params.eqMidGain = gainDb;
+    if (ear != AUDIO_EAR_LEFT) _params.rightEar.eqMidGain = gainDb;
+    publishParams();
+}
+
+void AudioEngine::setEqHigh(float gainDb, AudioEar ear)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    gainDb = std::clamp(gainDb, -12.0f, 12.0f);
+    if (ear != AUDIO_EAR_RIGHT) _params.eqHighGain = gainDb;
+    if (ear != AUDIO_EAR_LEFT) _params.rightEar.eqHighGain = gainDb;
+    publishParams();
+}
+
+void AudioEngine::setNsEnabled(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.nsEnabled = enabled;
+    publishParams();
+}
+
+void AudioEngine::setNsMode(int mode)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.nsMode = std::clamp(mode, 0, 2);
+    publishParams();
+}
+
+void AudioEngine::setNsLinked(bool linked)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.nsLinked = linked;
+    publishParams();
+}
+
+void AudioEngine::setAgcEnabled(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.agcEnabled = enabled;
+    publishParams();
+}
+
+void AudioEngine::setAgcMode(int mode)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.agcMode = std::clamp(mode, 0, 3);
+    publishParams();
+}
+
+void AudioEngine::setAgcCompressionGain(int gainDb)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.agcCompressionGainDb = std::clamp(gainDb, 0, 90);
+    publishParams();
+}
+
+void AudioEngine::setAgcLimiterEnabled(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.agcLimiterEnabled = enabled;
+    publishParams();
+}
+
+void AudioEngine::setAgcTargetLevel(int levelDbfs)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.agcTargetLevelDbfs = std::clamp(levelDbfs, -31, 0);
+    publishParams();
+}
+
+void AudioEngine::setAgcLinked(bool linked)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.agcLinked = linked;
+    publishParams();
+}
+
+void AudioEngine::setVeEnabled(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.veEnabled = enabled;
+    publishParams();
+}
+
+void AudioEngine::setVeBlend(float blend)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.veBlend = std::clamp(blend, 0.0f, 1.0f);
+    publishParams();
 }
 
-static void createVadHandle(void*& handle, int vadMode)
+void AudioEngine::setVeStepSize(float stepSize)
 {
-    vad_handle_t h = vad_create(static_cast<vad_mode_t>(vadMode));
-    handle = h;
-    if (!handle) {
-        mclog::tagError("AudioEngine", "failed to create VAD handle (mode={})", vadMode);
-    } else {
-        mclog::tagInfo("AudioEngine", "VAD handle created (mode={})", vadMode);
-    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.veStepSize = std::clamp(stepSize, 0.01f, 1.0f);
+    publishParams();
 }
 
-// ─────────────────────────────────────────────────────────────────────────────
-// AEC Ring Buffer (accumulate 160-sample blocks → 512-sample AEC frames)
-// ─────────────────────────────────────────────────────────────────────────────
+void AudioEngine::setVeFilterLength(int taps)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.veFilterLength = std::clamp(taps, 16, FDAF_MAX_TAPS);
+    publishParams();
+}
 
-struct AecRingBuf {
-    float buf[512];
-    int writePos = 0;
+void AudioEngine::setVeMaxAttenuation(float atten)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.veMaxAttenuation = std::clamp(atten, 0.0f, 1.0f);
+    publishParams();
+}
 
-    void reset() { writePos = 0; memset(buf, 0, sizeof(buf)); }
+void AudioEngine::setVeRefGain(float gain)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.veRefGain = std::clamp(gain, 0.1f, 5.0f);
+    publishParams();
+}
 
-    void push(const float* data, int count) {
-        for (int i = 0; i < count && writePos < 512; i++) {
-            buf[writePos++] = data[i];
-        }
-    }
+void AudioEngine::setVeRefHpf(float freq)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.veRefHpf = std::clamp(freq, 20.0f, 500.0f);
+    publishParams();
+}
 
-    bool ready() const { return writePos >= 512; }
+void AudioEngine::setVeRefLpf(float freq)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.veRefLpf = std::clamp(freq, 1000.0f, 8000.0f);
+    publishParams();
+}
 
-    void consume() { writePos = 0; }
-};
+void AudioEngine::setVeMode(int mode)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.veMode = std::clamp(mode, 0, 3);
+    publishParams();
+}
 
-// ─────────────────────────────────────────────────────────────────────────────
-// Start / Stop
-// ─────────────────────────────────────────────────────────────────────────────
+void AudioEngine::setVeAecMode(int mode)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.veAecMode = mode;
+    publishParams();
+}
 
-void AudioEngine::start()
+void AudioEngine::setVeAecFilterLen(int len)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    if (_running) {
-        mclog::tagWarn(TAG, "already running");
-        return;
-    }
+    _params.veAecFilterLen = std::clamp(len, 1, 6);
+    publishParams();
+}
 
-    mclog::tagInfo(TAG, "starting audio engine");
-    _running = true;
-    _paramsChanged = true;
+void AudioEngine::setVeAecShared(bool shared)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.veAecShared = shared;
+    publishParams();
+}
 
-    // Disable speaker amplifier to prevent feedback (headphone-only output)
-    bsp_speaker_enable(false);
+void AudioEngine::setVeVadEnabled(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.veVadEnabled = enabled;
+    publishParams();
+}
 
-    // Reset filter state
-    _hpfL.reset(); _hpfR.reset();
-    _lpfL.reset(); _lpfR.reset();
-    _eqLowL.reset(); _eqLowR.reset();
-    _eqMidL.reset(); _eqMidR.reset();
-    _eqHighL.reset(); _eqHighR.reset();
-    _veRefHpfBq.reset(); _veRefLpfBq.reset();
+void AudioEngine::setVeVadMode(int mode)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.veVadMode = std::clamp(mode, 0, 4);
+    publishParams();
+}
 
-    // Create NS handles if NS is enabled
-    if (_params.nsEnabled) {
-        createNsHandles(_nsHandleL, _nsHandleR, _params.nsMode);
-    }
+void AudioEngine::setOutputGain(float gain, AudioEar ear)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    gain = std::clamp(gain, 0.0f, 6.0f);  // Extended range for boost mode
+    if (ear != AUDIO_EAR_RIGHT) _params.outputGain = gain;
+    if (ear != AUDIO_EAR_LEFT) _params.rightEar.outputGain = gain;
+    publishParams();
+}
 
-    // Create AGC handles if AGC is enabled
-    if (_params.agcEnabled) {
-        createAgcHandles(_agcHandleL, _agcHandleR, _params.agcMode);
-    }
+void AudioEngine::setBoostEnabled(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.boostEnabled = enabled;
+    publishParams();
+}
 
-    xTaskCreatePinnedToCore(audioTask, "audio_eng", 32768, this, 10, &_taskHandle, 1);
+void AudioEngine::setBlockSize(int samples)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.blockSize = snapBlockSize(samples);
+    publishParams();
 }
 
-void AudioEngine::stop()
+void AudioEngine::setSampleRate(int hz)
 {
+    bool restart = false;
     {
         std::lock_guard<std::mutex> lock(_mutex);
-        if (!_running) return;
-        _running = false;
+        _params.sampleRate = snapSampleRate(hz);
+        publishParams();
+        restart = _running && _params.sampleRate != _sampleRate;
     }
-
-    // Wait for task to exit
-    if (_taskHandle) {
-        // Give the task time to notice _running=false and exit
-        vTaskDelay(pdMS_TO_TICKS(50));
-        _taskHandle = nullptr;
+    // Every stage and the codec clock are set up for the rate at start
+    if (restart) {
+        mclog::tagInfo(TAG, "restarting at {} Hz", snapSampleRate(hz));
+        stop();
+        start();
     }
+}
 
-    // Destroy NS handles
-    destroyNsHandles(_nsHandleL, _nsHandleR);
+void AudioEngine::setBusBandSplit(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.busBandSplit = enabled;
+    publishParams();
+}
 
-    // Destroy AGC handles
-    destroyAgcHandles(_agcHandleL, _agcHandleR);
+void AudioEngine::setBusAfe(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.busAfe = enabled;
+    publishParams();
+}
 
-    // Destroy NLMS filters
-    if (_nlmsL) {
-        static_cast<NlmsFilter*>(_nlmsL)->destroy();
-        delete static_cast<NlmsFilter*>(_nlmsL);
-        _nlmsL = nullptr;
-    }
-    if (_nlmsR) {
-        static_cast<NlmsFilter*>(_nlmsR)->destroy();
-        delete static_cast<NlmsFilter*>(_nlmsR);
-        _nlmsR = nullptr;
+void AudioEngine::setQuietPath(bool enabled, float thresholdDb, int holdMs)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.quietPathEnabled = enabled;
+    _params.quietThresholdDb = std::clamp(thresholdDb, -90.0f, -30.0f);
+    _params.quietHoldMs = std::clamp(holdMs, 100, 10000);
+    publishParams();
+}
+
+void AudioEngine::setSceneAuto(bool enabled, float quietDb)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (enabled && !_params.sceneAuto) {
+        // Every stage as set until the classifier has seen the room
+        _sceneTier.store(AUDIO_SCENE_BABBLE, std::memory_order_relaxed);
     }
+    _params.sceneAuto = enabled;
+    _params.sceneQuietDb = std::clamp(quietDb, -80.0f, -20.0f);
+    publishParams();
+}
 
-    // Destroy AEC handles
-    destroyAecHandles(_aecHandleL, _aecHandleR);
+void AudioEngine::setCorrectionFir(bool enabled, int ir)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.firEnabled = enabled;
+    _params.firIr = std::clamp(ir, 1, 99);
+    publishParams();
+}
 
-    // Destroy VAD handle
-    destroyVadHandle(_vadHandleRef);
+void AudioEngine::setDosimeter(int mode, int weighting)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.doseMode = std::clamp(mode, 0, 2);
+    _params.doseWeighting = std::clamp(weighting, 0, 1);
+    publishParams();
+}
 
-    // Mute codec output
-    bsp_codec_config_t* codec = bsp_get_codec_handle();
-    if (codec) {
-        codec->set_mute(true);
+void AudioEngine::setSpectralFrame(int fftSize, int hop)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    // Round down to a power of two, then to the nearest allowed overlap
+    int n = WolaProcessor::MIN_FFT;
+    while (n * 2 <= std::min(fftSize, WolaProcessor::MAX_FFT)) n *= 2;
+    int h = n / 2;
+    while (h > n / 8 && h > hop) h /= 2;
+    _params.spectralFftSize = n;
+    _params.spectralHop = h;
+    publishParams();
+}
+
+void AudioEngine::requestLatencyMeasurement(int source)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_running.load(std::memory_order_acquire)) return;
+    if (!_latCapture) {
+        _latMls = static_cast<float*>(heap_caps_malloc(LAT_MLS_LEN * sizeof(float), MALLOC_CAP_SPIRAM));
+        _latCapture = static_cast<float*>(heap_caps_malloc(LAT_CAPTURE_LEN * sizeof(float), MALLOC_CAP_SPIRAM));
+        if (!_latMls || !_latCapture) {
+            mclog::tagError(TAG, "failed to allocate latency test buffers");
+            heap_caps_free(_latMls);
+            heap_caps_free(_latCapture);
+            _latMls = _latCapture = nullptr;
+            return;
+        }
+        // x^10 + x^7 + 1 Fibonacci LFSR: one full 1023-chip period
+        uint32_t lfsr = 1;
+        for (int i = 0; i < LAT_MLS_LEN; i++) {
+            _latMls[i] = (lfsr & 1) ? 1.0f : -1.0f;
+            const uint32_t bit = (lfsr ^ (lfsr >> 3)) & 1;
+            lfsr = (lfsr >> 1) | (bit << 9);
+        }
     }
+    _latencySource.store(std::clamp(source, 0, 1), std::memory_order_relaxed);
+    // Release: the buffers are visible to the audio task before the request
+    _latencyProbeRequested.store(true, std::memory_order_release);
+}
 
-    // Re-enable speaker amplifier for normal use
-    bsp_speaker_enable(true);
+void AudioEngine::setVeVadGateEnabled(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.veVadGateEnabled = enabled;
+    publishParams();
+}
 
-    mclog::tagInfo(TAG, "audio engine stopped");
+void AudioEngine::setVeVadGateAtten(float atten)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.veVadGateAtten = std::clamp(atten, 0.0f, 1.0f);
+    publishParams();
 }
 
-bool AudioEngine::isRunning()
+void AudioEngine::setOwnVoice(float ratioDb, float duckDb)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    return _running;
+    _params.ownVoiceRatioDb = std::clamp(ratioDb, 0.0f, 20.0f);
+    _params.ownVoiceDuckDb = std::clamp(duckDb, 0.0f, 12.0f);
+    publishParams();
 }
 
-// ─────────────────────────────────────────────────────────────────────────────
-// Thread-safe parameter access
-// ─────────────────────────────────────────────────────────────────────────────
+void AudioEngine::setFbcEnabled(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.fbcEnabled = enabled;
+    publishParams();
+}
 
-void AudioEngine::setParams(const AudioEngineParams& p)
+void AudioEngine::setFbcFilterLength(int taps)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params = p;
-    _paramsChanged = true;
+    _params.fbcFilterLength = std::clamp(taps, 32, FBC_MAX_TAPS);
+    publishParams();
 }
 
-AudioEngineParams AudioEngine::getParams()
+void AudioEngine::setFbcStepSize(float stepSize)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    return _params;
+    _params.fbcStepSize = std::clamp(stepSize, 0.0005f, 0.05f);
+    publishParams();
 }
 
-AudioLevels AudioEngine::getLevels()
+void AudioEngine::setFbcShift(float hz)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    return _levels;
+    _params.fbcShiftHz = std::clamp(hz, 0.0f, 20.0f);
+    publishParams();
 }
 
-void AudioEngine::setMicGain(float gain)
+void AudioEngine::setHowlSuppression(bool enabled)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.micGain = std::clamp(gain, 0.0f, 240.0f);
-    _paramsChanged = true;
+    _params.howlSuppression = enabled;
+    publishParams();
 }
 
-void AudioEngine::setHpf(bool enabled, float freq)
+void AudioEngine::setOutputVolume(int vol)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.hpfEnabled = enabled;
-    _params.hpfFrequency = std::clamp(freq, 20.0f, 2000.0f);
-    _paramsChanged = true;
+    _params.outputVolume = std::clamp(vol, 0, 100);
+    publishParams();
 }
 
-void AudioEngine::setLpf(bool enabled, float freq)
+void AudioEngine::setMute(bool mute)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.lpfEnabled = enabled;
-    _params.lpfFrequency = std::clamp(freq, 500.0f, 20000.0f);
-    _paramsChanged = true;
+    _params.outputMute = mute;
+    publishParams();
 }
 
-void AudioEngine::setEqLow(float gainDb)
+// ─────────────────────────────────────────────────────────────────────────────
+// Tinnitus Relief Setters
+// ─────────────────────────────────────────────────────────────────────────────
+
+void AudioEngine::setNotchEnabled(int idx, bool enabled, AudioEar ear)
 {
+    if (idx < 0 || idx >= 6) return;
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.eqLowGain = std::clamp(gainDb, -12.0f, 12.0f);
-    _paramsChanged = true;
+    if (ear != AUDIO_EAR_RIGHT) _params.tinnitus.notches[idx].enabled = enabled;
+    if (ear != AUDIO_EAR_LEFT) _params.rightEar.notches[idx].enabled = enabled;
+    publishParams();
 }
 
-void AudioEngine::setEqMid(float gainDb)
+void AudioEngine::setNotchFrequency(int idx, float freq, AudioEar ear)
 {
+    if (idx < 0 || idx >= 6) return;
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.eqMidGain = std::clamp(gainDb, -12.0f, 12.0f);
-    _paramsChanged = true;
+    freq = std::clamp(freq, 500.0f, 12000.0f);
+    if (ear != AUDIO_EAR_RIGHT) _params.tinnitus.notches[idx].frequency = freq;
+    if (ear != AUDIO_EAR_LEFT) _params.rightEar.notches[idx].frequency = freq;
+    publishParams();
 }
 
-void AudioEngine::setEqHigh(float gainDb)
+void AudioEngine::setNotchQ(int idx, float Q, AudioEar ear)
 {
+    if (idx < 0 || idx >= 6) return;
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.eqHighGain = std::clamp(gainDb, -12.0f, 12.0f);
-    _paramsChanged = true;
+    Q = std::clamp(Q, 1.0f, 16.0f);
+    if (ear != AUDIO_EAR_RIGHT) _params.tinnitus.notches[idx].Q = Q;
+    if (ear != AUDIO_EAR_LEFT) _params.rightEar.notches[idx].Q = Q;
+    publishParams();
 }
 
-void AudioEngine::setNsEnabled(bool enabled)
+void AudioEngine::setNoiseType(int type)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.nsEnabled = enabled;
-    _paramsChanged = true;
+    _params.tinnitus.noiseType = std::clamp(type, 0, 3);
+    publishParams();
 }
 
-void AudioEngine::setNsMode(int mode)
+void AudioEngine::setNoiseLevel(float level)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.nsMode = std::clamp(mode, 0, 2);
-    _paramsChanged = true;
+    _params.tinnitus.noiseLevel = std::clamp(level, 0.0f, 1.0f);
+    publishParams();
 }
 
-void AudioEngine::setAgcEnabled(bool enabled)
+void AudioEngine::setNoiseLowCut(float freq)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.agcEnabled = enabled;
-    _paramsChanged = true;
+    _params.tinnitus.noiseLowCut = std::clamp(freq, 20.0f, 2000.0f);
+    publishParams();
 }
 
-void AudioEngine::setAgcMode(int mode)
+void AudioEngine::setNoiseHighCut(float freq)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.agcMode = std::clamp(mode, 0, 3);
-    _paramsChanged = true;
+    _params.tinnitus.noiseHighCut = std::clamp(freq, 1000.0f, 16000.0f);
+    publishParams();
 }
 
-void AudioEngine::setAgcCompressionGain(int gainDb)
+void AudioEngine::setToneFinderEnabled(bool enabled)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.agcCompressionGainDb = std::clamp(gainDb, 0, 90);
-    _paramsChanged = true;
+    _params.tinnitus.toneFinderEnabled = enabled;
+    publishParams();
 }
 
-void AudioEngine::setAgcLimiterEnabled(bool enabled)
+void AudioEngine::setToneFinderFreq(float freq)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.agcLimiterEnabled = enabled;
-    _paramsChanged = true;
+    _params.tinnitus.toneFinderFreq = std::clamp(freq, 200.0f, 12000.0f);
+    publishParams();
 }
 
-void AudioEngine::setAgcTargetLevel(int levelDbfs)
+void AudioEngine::setToneFinderLevel(float level)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.agcTargetLevelDbfs = std::clamp(levelDbfs, -31, 0);
-    _paramsChanged = true;
+    _params.tinnitus.toneFinderLevel = std::clamp(level, 0.0f, 1.0f);
+    publishParams();
 }
 
-void AudioEngine::setVeEnabled(bool enabled)
+void AudioEngine::setHfExtEnabled(bool enabled)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.veEnabled = enabled;
-    _paramsChanged = true;
+    _params.tinnitus.hfExtEnabled = enabled;
+    publishParams();
 }
 
-void AudioEngine::setVeBlend(float blend)
+void AudioEngine::setHfExtFreq(float freq)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.veBlend = std::clamp(blend, 0.0f, 1.0f);
-    _paramsChanged = true;
+    _params.tinnitus.hfExtFreq = std::clamp(freq, 4000.0f, 12000.0f);
+    publishParams();
 }
 
-void AudioEngine::setVeStepSize(float stepSize)
+void AudioEngine::setHfExtGainDb(float gainDb)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.veStepSize = std::clamp(stepSize, 0.01f, 1.0f);
-    _paramsChanged = true;
+    _params.tinnitus.hfExtGainDb = std::clamp(gainDb, 0.0f, 12.0f);
+    publishParams();
 }
 
-void AudioEngine::setVeFilterLength(int taps)
+void AudioEngine::setBinauralEnabled(bool enabled)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.veFilterLength = std::clamp(taps, 16, 512);
-    _paramsChanged = true;
+    _params.tinnitus.binauralEnabled = enabled;
+    publishParams();
 }
 
-void AudioEngine::setVeMaxAttenuation(float atten)
+void AudioEngine::setBinauralCarrier(float freq)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.veMaxAttenuation = std::clamp(atten, 0.0f, 1.0f);
-    _paramsChanged = true;
+    _params.tinnitus.binauralCarrier = std::clamp(freq, 50.0f, 500.0f);
+    publishParams();
 }
 
-void AudioEngine::setVeRefGain(float gain)
+void AudioEngine::setBinauralBeat(float freq)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.veRefGain = std::clamp(gain, 0.1f, 5.0f);
-    _paramsChanged = true;
+    _params.tinnitus.binauralBeat = std::clamp(freq, 1.0f, 40.0f);
+    publishParams();
 }
 
-void AudioEngine::setVeRefHpf(float freq)
+void AudioEngine::setBinauralLevel(float level)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.veRefHpf = std::clamp(freq, 20.0f, 500.0f);
-    _paramsChanged = true;
+    _params.tinnitus.binauralLevel = std::clamp(level, 0.0f, 1.0f);
+    publishParams();
 }
 
-void AudioEngine::setVeRefLpf(float freq)
+void AudioEngine::setMbcEnabled(bool enabled)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.veRefLpf = std::clamp(freq, 1000.0f, 8000.0f);
-    _paramsChanged = true;
+    _params.dynamics.mbcEnabled = enabled;
+    publishParams();
 }
 
-void AudioEngine::setVeMode(int mode)
+void AudioEngine::setMbcBandCount(int bands)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.veMode = std::clamp(mode, 0, 1);
-    _paramsChanged = true;
+    _params.dynamics.mbcBands = std::clamp(bands, 3, 4);
+    publishParams();
 }
 
-void AudioEngine::setVeAecMode(int mode)
+void AudioEngine::setMbcCrossover(int idx, float freq)
 {
+    if (idx < 0 || idx >= 3) return;
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.veAecMode = mode;
-    _paramsChanged = true;
+    _params.dynamics.crossoverHz[idx] = std::clamp(freq, 40.0f, 16000.0f);
+    publishParams();
 }
 
-void AudioEngine::setVeAecFilterLen(int len)
+void AudioEngine::setMbcBand(int idx, float thresholdDb, float ratio, float attackMs, float releaseMs, float makeupDb)
 {
+    if (idx < 0 || idx >= 4) return;
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.veAecFilterLen = std::clamp(len, 1, 6);
-    _paramsChanged = true;
+    auto& b = _params.dynamics.bands[idx];
+    b.thresholdDb = std::clamp(thresholdDb, -60.0f, 0.0f);
+    b.ratio = std::clamp(ratio, 1.0f, 20.0f);
+    b.attackMs = std::clamp(attackMs, 0.1f, 100.0f);
+    b.releaseMs = std::clamp(releaseMs, 10.0f, 2000.0f);
+    b.makeupDb = std::clamp(makeupDb, 0.0f, 24.0f);
+    publishParams();
 }
 
-void AudioEngine::setVeVadEnabled(bool enabled)
+void AudioEngine::setLimiter(bool enabled, float ceilingDb, float releaseMs)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.dynamics.limiterEnabled = enabled;
+    _params.dynamics.limiterCeilingDb = std::clamp(ceilingDb, -12.0f, 0.0f);
+    _params.dynamics.limiterReleaseMs = std::clamp(releaseMs, 5.0f, 1000.0f);
+    publishParams();
+}
+
+void AudioEngine::setWdrcEnabled(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.fitting.wdrcEnabled = enabled;
+    publishParams();
+}
+
+void AudioEngine::setWdrcBandCount(int bands)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.fitting.wdrcBands = std::clamp(bands, 8, WdrcFilterbank::MAX_BANDS);
+    publishParams();
+}
+
+void AudioEngine::setAudiogram(int ear, const float* thresholdsDbHl)
+{
+    if (ear < 0 || ear > 1 || !thresholdsDbHl) return;
+    std::lock_guard<std::mutex> lock(_mutex);
+    float* hl = ear == 0 ? _params.fitting.audiogramL : _params.fitting.audiogramR;
+    for (int i = 0; i < FittingParams::NUM_FREQS; i++) {
+        hl[i] = std::clamp(thresholdsDbHl[i], -10.0f, 120.0f);
+    }
+    publishParams();
+}
+
+void AudioEngine::setWdrcCalibration(float dbSpl)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.fitting.calibrationDbSpl = std::clamp(dbSpl, 80.0f, 130.0f);
+    publishParams();
+}
+
+void AudioEngine::setWdrcMaxGain(float db)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.veVadEnabled = enabled;
-    _paramsChanged = true;
+    _params.fitting.maxGainDb = std::clamp(db, 0.0f, 60.0f);
+    publishParams();
 }
 
-void AudioEngine::setVeVadMode(int mode)
+void AudioEngine::setWdrcTiming(float attackMs, float releaseMs)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.veVadMode = std::clamp(mode, 0, 4);
-    _paramsChanged = true;
+    _params.fitting.attackMs = std::clamp(attackMs, 1.0f, 50.0f);
+    _params.fitting.releaseMs = std::clamp(releaseMs, 20.0f, 1000.0f);
+    publishParams();
 }
 
-void AudioEngine::setOutputGain(float gain)
+void AudioEngine::setFrequencyLowering(bool enabled, float cutoffHz, float ratio)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.outputGain = std::clamp(gain, 0.0f, 6.0f);  // Extended range for boost mode
-    _paramsChanged = true;
+    _params.fitting.nfcEnabled = enabled;
+    _params.fitting.nfcCutoffHz = std::clamp(cutoffHz, 1000.0f, 6000.0f);
+    _params.fitting.nfcRatio = std::clamp(ratio, 1.0f, 4.0f);
+    publishParams();
 }
 
-void AudioEngine::setBoostEnabled(bool enabled)
+void AudioEngine::setSessionActive(bool active)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.boostEnabled = enabled;
-    _paramsChanged = true;
+    if (active && !_params.tinnitus.sessionActive) _params.tinnitus.sessionElapsedMs = 0;
+    _params.tinnitus.sessionActive = active;
+    publishParams();
 }
 
-void AudioEngine::setVeVadGateEnabled(bool enabled)
+void AudioEngine::setSessionDuration(uint32_t ms)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.veVadGateEnabled = enabled;
-    _paramsChanged = true;
+    _params.tinnitus.sessionDurationMs = std::clamp<uint32_t>(ms, 60000, 12 * 3600000);
+    publishParams();
 }
 
-void AudioEngine::setVeVadGateAtten(float atten)
+void AudioEngine::setSessionFade(float ms)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.veVadGateAtten = std::clamp(atten, 0.0f, 1.0f);
-    _paramsChanged = true;
+    _params.tinnitus.sessionFadeMs = std::clamp(ms, 0.0f, 300000.0f);
+    publishParams();
 }
 
-void AudioEngine::setOutputVolume(int vol)
+void AudioEngine::setOutputOnly(bool enabled)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _params.outputVolume = std::clamp(vol, 0, 100);
-    _paramsChanged = true;
+    _params.tinnitus.outputOnly = enabled;
+    publishParams();
 }
 
-void AudioEngine::setMute(bool mute)
+// ─────────────────────────────────────────────────────────────────────────────
+// Masking noise loop renderer (worker side)
+//
+// Renders PREROLL + NOISE_LOOP_FRAMES + NOISE_LOOP_XFADE samples of filtered
+// noise. The pre-roll settles the band-limiting filters and is dropped; the
+// extra tail is equal-power crossfaded over the loop's head, so playback runs
+// from the last sample straight back into the first without a seam.
+// ─────────────────────────────────────────────────────────────────────────────
+
+struct AudioEngine::NoiseLoopRender {
+    static constexpr int PREROLL = SAMPLE_RATE / 2;
+    static constexpr int SLICE_BLOCKS = 8;  // ~1ms of worker time per pass
+
+    NoiseLoopSpec spec;
+    bool pending = false;  // Waiting for a buffer the audio task isn't reading
+    bool active = false;
+    int buf = 0;
+    int pos = 0;  // Loop-relative frame; negative during the pre-roll
+    MaskingNoise noise;
+    BiquadCascade cascade;
+    float blockL[BLOCK_SIZE];
+    float blockR[BLOCK_SIZE];
+};
+
+void AudioEngine::serviceNoiseLoop(NoiseLoopRender& r)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    _params.outputMute = mute;
-    _paramsChanged = true;
+    NoiseLoopSpec spec;
+    while (_noiseLoopRequests.pop(spec)) {
+        r.spec = spec;
+        r.pending = spec.type > 0;
+        r.active = false;
+    }
+
+    if (r.pending) {
+        uint32_t inUse = _noiseLoopInUse.load(std::memory_order_acquire);
+        int target = !(inUse & 1) ? 0 : !(inUse & 2) ? 1 : -1;
+        if (target < 0) return;
+        if (!_noiseLoop[target]) {
+            _noiseLoop[target] = static_cast<int16_t*>(heap_caps_malloc(
+                NOISE_LOOP_FRAMES * 2 * sizeof(int16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+            if (!_noiseLoop[target]) {
+                mclog::tagWarn(TAG, "no PSRAM for noise loop, masking noise stays live");
+                r.pending = false;
+                return;
+            }
+        }
+        r.pending = false;
+        r.active = true;
+        r.buf = target;
+        r.pos = -NoiseLoopRender::PREROLL;
+        r.noise.reset();
+        r.cascade = BiquadCascade{};
+        Biquad bq;
+        calcHpfCoeffs(bq, r.spec.lowCut, _sampleRate);
+        r.cascade.setSection(SLOT_NOISE_HPF, bq, true);
+        calcLpfCoeffs(bq, r.spec.highCut, _sampleRate);
+        r.cascade.setSection(SLOT_NOISE_LPF, bq, true);
+    }
+    if (!r.active) return;
+
+    int16_t* loop = _noiseLoop[r.buf];
+    constexpr int END = NOISE_LOOP_FRAMES + NOISE_LOOP_XFADE;
+    for (int b = 0; b < NoiseLoopRender::SLICE_BLOCKS && r.pos < END; b++) {
+        int n = std::min(BLOCK_SIZE, END - r.pos);
+        if (r.pos < 0) n = std::min(n, -r.pos);  // Don't straddle the end of the pre-roll
+        r.noise.generate(r.spec.type, r.blockL, r.blockR, n);
+        r.cascade.process(r.blockL, r.blockR, n);
+        for (int i = 0; i < n; i++, r.pos++) {
+            if (r.pos < 0) continue;
+            float l = r.blockL[i], rr = r.blockR[i];
+            int at = r.pos;
+            if (at >= NOISE_LOOP_FRAMES) {
+                // Tail over the head: all tail at the seam, all head XFADE later
+                at -= NOISE_LOOP_FRAMES;
+                float theta = (float)M_PI_2 * at / NOISE_LOOP_XFADE;
+                float gHead = sinf(theta), gTail = cosf(theta);
+                l = loop[2 * at] * (1.0f / 32767.0f) * gHead + l * gTail;
+                rr = loop[2 * at + 1] * (1.0f / 32767.0f) * gHead + rr * gTail;
+            }
+            loop[2 * at]     = static_cast<int16_t>(std::clamp(l, -1.0f, 1.0f) * 32767.0f);
+            loop[2 * at + 1] = static_cast<int16_t>(std::clamp(rr, -1.0f, 1.0f) * 32767.0f);
+        }
+    }
+
+    if (r.pos >= END) {
+        r.active = false;
+        _noiseLoopDone.store((r.spec.seq << 1) | static_cast<uint32_t>(r.buf), std::memory_order_release);
+        mclog::tagInfo(TAG, "noise loop ready (type={}, {:.0f}-{:.0f}Hz, buffer {})",
+            r.spec.type, r.spec.lowCut, r.spec.highCut, r.buf);
+    }
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
-// Tinnitus Relief Setters
+// Control task: codec settings and jack detect (all the control-plane I2C)
 // ─────────────────────────────────────────────────────────────────────────────
 
-void AudioEngine::setNotchEnabled(int idx, bool enabled)
+void AudioEngine::controlTask(void* param)
 {
-    if (idx < 0 || idx >= 6) return;
-    std::lock_guard<std::mutex> lock(_mutex);
-    _params.tinnitus.notches[idx].enabled = enabled;
-    _paramsChanged = true;
+    auto* self = static_cast<AudioEngine*>(param);
+    self->controlLoop();
 }
 
-void AudioEngine::setNotchFrequency(int idx, float freq)
+void AudioEngine::controlLoop()
 {
-    if (idx < 0 || idx >= 6) return;
-    std::lock_guard<std::mutex> lock(_mutex);
-    _params.tinnitus.notches[idx].frequency = std::clamp(freq, 500.0f, 12000.0f);
-    _paramsChanged = true;
+    bsp_codec_config_t* codec = bsp_get_codec_handle();
+    int volume = -1;
+    int mute = -1;
+    float gainSeen = NAN;
+    TickType_t gainSince = 0;
+    TickType_t lastPoll = xTaskGetTickCount();
+    // Two matching reads in a row before a change counts, so a wiggling plug doesn't flap VE
+    bool hpLast = _hpDetected.load(std::memory_order_relaxed);
+    int firPosted = 0;  // IR number last sent to the storage task; kept across disable
+    // Audio watchdog: armed by the first heartbeat, so the audio task's setup isn't a stall
+    uint32_t beatSeen = _audioBeat.load(std::memory_order_relaxed);
+    TickType_t beatSince = lastPoll;
+    bool watchdogArmed = false;
+    bool watchdogFired = false;
+    bool wedgedLogged = false;
+    TickType_t outputNeededAt = lastPoll;
+    bool outputFailed = false;  // Last power switch failed: the next try waits OUTPUT_IDLE_MS
+    TickType_t outputFailedAt = 0;
+    SceneClassifier scenes;
+    SceneFrame sceneFrames[16];
+    while (_sceneFrames.pop_n(sceneFrames, 16) > 0) {
+        // Left from the last run
+    }
+    DoseSecond doseSeconds[4];
+    while (_doseSeconds.pop_n(doseSeconds, 4) > 0) {
+        // Left from the last run
+    }
+
+    while (_running.load(std::memory_order_acquire)) {
+        const TickType_t now = xTaskGetTickCount();
+
+        // Scene tiers: the audio task sends frames only while sceneAuto is on; the tier
+        // holds until a closed window says otherwise
+        size_t got;
+        while ((got = _sceneFrames.pop_n(sceneFrames, 16)) > 0) {
+            const float quietDb = _sceneQuietDb.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < got; i++) {
+                if (!scenes.push(sceneFrames[i], quietDb)) continue;
+                const AudioScene scene = scenes.scene();
+                if (scene == getScene()) continue;
+                const SceneClassifier::Features& f = scenes.features();
+                mclog::tagInfo(TAG, "scene: {} (level {:.0f}dB floor {:.0f}dB mod {:.1f}dB active {:.2f} low {:.2f} high {:.2f})",
+                    SceneClassifier::name(scene), f.levelDb, f.floorDb, f.modulationDb, f.activeRatio,
+                    f.lowShare, f.highShare);
+                setSceneTier(scene);
+            }
+        }
+
+        // Noise dose: ear SPL from the calibration (0 dBFS sine at full volume) and the
+        // codec volume, 0.5dB a step on esp_codec_dev's default curve; 0 is silence
+        while ((got = _doseSeconds.pop_n(doseSeconds, 4)) > 0) {
+            NoiseDosimeter& dosimeter = NoiseDosimeter::getInstance();
+            const int codecVolume = _codecVolumeWanted.load(std::memory_order_relaxed);
+            const float offsetDb = _doseCalDbSpl.load(std::memory_order_relaxed) + (codecVolume - 100) * 0.5f;
+            for (size_t i = 0; i < got; i++) {
+                const DoseSecond& d = doseSeconds[i];
+                dosimeter.addSecond(codecVolume > 0 ? d.meanSquare : 0.0f, offsetDb, d.cutDb, d.seconds);
+            }
+            _doseLimitDb.store(dosimeter.status().limitDb, std::memory_order_relaxed);
+        }
+
+        // Correction IR: read off the card and transformed on the storage task. A failed
+        // read isn't retried until the number changes; a full queue is, next poll
+        const int ir = _firWanted.load(std::memory_order_relaxed);
+        if (ir > 0 && ir != firPosted &&
+            SdStorage::getInstance().post(loadFirJob, new int(ir))) {
+            firPosted = ir;
+        }
+        void* deadFir;
+        while (_firRetired.pop(deadFir)) destroyFirConvolver(deadFir);
+
+        // Output power, outside _codecMutex: the switch waits out the ramps and only touches
+        // the ES8388, which nothing else here does. Either way the DAC is left muted
+        if (codec && codec->set_output_power) {
+            const bool needed = _probeBusy.load(std::memory_order_acquire) ||
+                                (_hpDetected.load(std::memory_order_relaxed) &&
+                                    !_codecMuteWanted.load(std::memory_order_relaxed) &&
+                                    _codecVolumeWanted.load(std::memory_order_relaxed) > 0);
+            if (needed) outputNeededAt = now;
+            const bool powered = _outputPowered.load(std::memory_order_relaxed);
+            if (needed != powered && (needed || now - outputNeededAt >= pdMS_TO_TICKS(OUTPUT_IDLE_MS)) &&
+                (!outputFailed || now - outputFailedAt >= pdMS_TO_TICKS(OUTPUT_IDLE_MS))) {
+                outputFailed = codec->set_output_power(needed) != ESP_OK;
+                if (outputFailed) {
+                    outputFailedAt = now;
+                    mclog::tagWarn(TAG, "output stage power {} failed", needed ? "up" : "down");
+                } else {
+                    _outputPowered.store(needed, std::memory_order_release);
+                    mute = 1;
+                    mclog::tagInfo(TAG, "output stage {}", needed ? "on" : "off (idle)");
+                }
+            }
+        }
+
+        if (codec) {
+            std::lock_guard<std::mutex> lock(_codecMutex);
+            if (_codecResync.exchange(false, std::memory_order_acq_rel)) {
+                volume = mute = -1;
+                _micPgaApplied.store(NAN, std::memory_order_release);
+            }
+            int v = _codecVolumeWanted.load(std::memory_order_relaxed);
+            if (v != volume) {
+                codec->set_volume(v);
+                volume = v;
+            }
+            // Unmuted only once the output stage is up
+            int m = (_codecMuteWanted.load(std::memory_order_relaxed) ||
+                        !_outputPowered.load(std::memory_order_relaxed)) ? 1 : 0;
+            if (m != mute) {
+                codec->set_mute(m != 0);
+                mute = m;
+            }
+            // The audio task covers a mic gain change digitally right away; the PGA (3dB
+            // steps) only follows once the gain has held, so a slider drag is one step
+            float g = _micGainWanted.load(std::memory_order_relaxed);
+            float pga = _micPgaApplied.load(std::memory_order_relaxed);
+            if (g != gainSeen) {
+                gainSeen = g;
+                gainSince = now;
+            }
+            if (g != pga && (std::isnan(pga) || now - gainSince >= pdMS_TO_TICKS(PGA_SETTLE_MS))) {
+                codec->set_in_gain(g);
+                _micPgaApplied.store(g, std::memory_order_release);
+            }
+        }
+
+        if (now - lastPoll >= pdMS_TO_TICKS(HP_POLL_MS)) {
+            lastPoll = now;
+            bool hp = bsp_headphone_detect();
+            if (hp == hpLast && hp != _hpDetected.load(std::memory_order_relaxed)) {
+                _hpDetected.store(hp, std::memory_order_release);
+                mclog::tagInfo(TAG, "headphones {}", hp ? "connected" : "disconnected");
+            }
+            hpLast = hp;
+        }
+
+        // A missed heartbeat asks the audio task for a hot restart; it sees the request once its
+        // bounded read returns. Still nothing after STOP_TIMEOUT_MS: it is stuck inside the driver
+        // and deleting it would leave the driver's lock held, so it is only reported
+        const uint32_t beat = _audioBeat.load(std::memory_order_relaxed);
+        if (beat != beatSeen) {
+            beatSeen = beat;
+            beatSince = now;
+            watchdogArmed = true;
+            watchdogFired = wedgedLogged = false;
+        } else if (watchdogArmed && now - beatSince >= pdMS_TO_TICKS(WATCHDOG_STALL_MS)) {
+            if (!watchdogFired) {
+                watchdogFired = true;
+                uint8_t none = AUDIO_RESTART_NONE;
+                _restartRequest.compare_exchange_strong(none, AUDIO_RESTART_WATCHDOG, std::memory_order_acq_rel);
+                mclog::tagWarn(TAG, "watchdog: no audio block for {}ms, hot restart requested",
+                    pdTICKS_TO_MS(now - beatSince));
+            } else if (!wedgedLogged && now - beatSince >= pdMS_TO_TICKS(STOP_TIMEOUT_MS)) {
+                wedgedLogged = true;
+                mclog::tagError(TAG, "watchdog: audio task unresponsive for {}ms", pdTICKS_TO_MS(now - beatSince));
+            }
+        }
+
+        if (_latCaptureReady.load(std::memory_order_acquire)) analyseLatencyCapture();
+        if (_specCaptureReady.load(std::memory_order_acquire)) analyseSpectrumCapture();
+
+        // The audio task logs through the trace ring (mclog::traceXxx), so its messages
+        // are formatted and hit the UART here instead of inside a block deadline
+        mclog::trace_flush();
+
+        // Woken early by publishParams(); a pending PGA move is picked up on the next poll. The
+        // headphone poll keeps its own HP_POLL_MS period, the wake is the watchdog's
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(WATCHDOG_POLL_MS));
+    }
+    mclog::trace_flush();
 }
 
-void AudioEngine::setNotchQ(int idx, float Q)
+void AudioEngine::loadFirJob(void* arg)
 {
-    if (idx < 0 || idx >= 6) return;
-    std::lock_guard<std::mutex> lock(_mutex);
-    _params.tinnitus.notches[idx].Q = std::clamp(Q, 1.0f, 16.0f);
-    _paramsChanged = true;
+    const int ir = *std::unique_ptr<int>(static_cast<int*>(arg));
+    std::vector<float> left, right;
+    if (!ProfileManager::loadImpulseResponse(ir, left, right)) return;
+    void* fir = FirConvolver::create(left.data(), right.data(), static_cast<int>(left.size()));
+    if (!fir) {
+        mclog::tagError(TAG, "correction FIR {}: not built (IR not finite, or out of memory)", ir);
+        return;
+    }
+    // Picked up at the next block, or at the next start if the engine is stopped
+    if (!getInstance()._firHandover.push(fir)) {
+        mclog::tagWarn(TAG, "correction FIR {}: handover full, dropped", ir);
+        destroyFirConvolver(fir);
+    }
 }
 
-void AudioEngine::setNoiseType(int type)
+// Linear cross-correlation of the MLS burst against every lag of the capture. One
+// period has sidelobes around sqrt(N) against a peak of N, so a clean return stands
+// ~30 dB clear; the peak is then refined between samples on a parabola.
+void AudioEngine::analyseLatencyCapture()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    _params.tinnitus.noiseType = std::clamp(type, 0, 3);
-    _paramsChanged = true;
+    auto correlate = [this](int lag) {
+        float r = 0.0f;
+#if AUDIO_ENGINE_USE_DSPS_DOTPROD
+        dsps_dotprod_f32(_latMls, _latCapture + lag, &r, LAT_MLS_LEN);
+#else
+        const float* x = _latCapture + lag;
+        float r0 = 0.0f, r1 = 0.0f;
+        int i = 0;
+        for (; i + 2 <= LAT_MLS_LEN; i += 2) {
+            r0 += _latMls[i] * x[i];
+            r1 += _latMls[i + 1] * x[i + 1];
+        }
+        for (; i < LAT_MLS_LEN; i++) r0 += _latMls[i] * x[i];
+        r = r0 + r1;
+#endif
+        return r;
+    };
+
+    float best = 0.0f;
+    int bestLag = -1;
+    float sumSq = 0.0f;
+    for (int lag = 0; lag <= LAT_MAX_LAG; lag++) {
+        const float r = correlate(lag);
+        sumSq += r * r;
+        // Either polarity: the return may be inverted somewhere along the path
+        if (fabsf(r) > fabsf(best)) {
+            best = r;
+            bestLag = lag;
+        }
+    }
+
+    int32_t lagQ8 = -1;
+    float ratio = 0.0f;
+    if (bestLag >= 0 && sumSq > 0.0f) {
+        ratio = fabsf(best) / sqrtf(sumSq / (LAT_MAX_LAG + 1));
+        if (ratio >= LAT_MIN_PEAK_RATIO) {
+            float frac = 0.0f;
+            if (bestLag > 0 && bestLag < LAT_MAX_LAG) {
+                const float sign = best < 0.0f ? -1.0f : 1.0f;
+                const float a = sign * correlate(bestLag - 1);
+                const float c = sign * correlate(bestLag + 1);
+                const float den = a - 2.0f * fabsf(best) + c;
+                if (den < 0.0f) frac = std::clamp(0.5f * (a - c) / den, -0.5f, 0.5f);
+            }
+            lagQ8 = std::max<int32_t>(0, lrintf((bestLag + frac) * 256.0f));
+        }
+    }
+    _latPeakRatio.store(ratio, std::memory_order_relaxed);
+    _latLagQ8.store(lagQ8, std::memory_order_relaxed);
+    _latCaptureReady.store(false, std::memory_order_release);
 }
 
-void AudioEngine::setNoiseLevel(float level)
+// Input in the real part and output in the imaginary part of one complex FFT, split
+// with Z[N-k] as in the WOLA frame. Bin powers are summed over each third-octave band;
+// bands narrower than a bin (below ~300 Hz) take the bin nearest their centre.
+void AudioEngine::analyseSpectrumCapture()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    _params.tinnitus.noiseLevel = std::clamp(level, 0.0f, 1.0f);
-    _paramsChanged = true;
+    constexpr int n = SPEC_FFT;
+    const float* in = _specCapture;
+    const float* out = _specCapture + n;
+    for (int i = 0; i < n; i++) {
+        _specFft[2 * i] = in[i] * _specWindow[i];
+        _specFft[2 * i + 1] = out[i] * _specWindow[i];
+    }
+    // The capture is copied out; the audio task may start the next one
+    _specCaptureReady.store(false, std::memory_order_release);
+
+    dsps_fft2r_fc32(_specFft, n);
+    dsps_bit_rev_fc32(_specFft, n);
+
+    // A full-scale sine through the Hann window sums to 3N^2/32 over its bins
+    constexpr float norm = 32.0f / (3.0f * n * n);
+    const float binHz = static_cast<float>(_sampleRate) / n;
+    const bool first = _specFrame == 0;
+    AudioSpectrum& spec = _spectrumBuffer.back();
+    for (int b = 0; b < AudioSpectrum::BANDS; b++) {
+        const float fc = AudioSpectrum::bandHz(b);
+        int lo = static_cast<int>(ceilf(fc * 0.8909f / binHz));   // 2^(-1/6)
+        int hi = static_cast<int>(floorf(fc * 1.1225f / binHz));  // 2^(1/6)
+        lo = std::max(lo, 1);
+        hi = std::min(hi, n / 2 - 1);
+        if (hi < lo) lo = hi = std::min(static_cast<int>(lrintf(fc / binHz)), n / 2 - 1);
+        float pin = 0.0f, pout = 0.0f;
+        for (int k = lo; k <= hi; k++) {
+            const float zr = _specFft[2 * k], zi = _specFft[2 * k + 1];
+            const float nr = _specFft[2 * (n - k)], ni = _specFft[2 * (n - k) + 1];
+            pin += 0.25f * ((zr + nr) * (zr + nr) + (zi - ni) * (zi - ni));
+            pout += 0.25f * ((zi + ni) * (zi + ni) + (zr - nr) * (zr - nr));
+        }
+        float* avg = _specPower[0] + b;
+        *avg = first ? pin * norm : *avg + SPEC_SMOOTH * (pin * norm - *avg);
+        avg = _specPower[1] + b;
+        *avg = first ? pout * norm : *avg + SPEC_SMOOTH * (pout * norm - *avg);
+        spec.inputDb[b] = std::max(AudioSpectrum::DB_FLOOR, 10.0f * log10f(_specPower[0][b] + 1e-12f));
+        spec.outputDb[b] = std::max(AudioSpectrum::DB_FLOOR, 10.0f * log10f(_specPower[1][b] + 1e-12f));
+    }
+    spec.frame = ++_specFrame;
+    if (_remoteSpectrum.load(std::memory_order_acquire)) {
+        _remoteSpectrumBuffer.back() = spec;
+        _remoteSpectrumBuffer.publish();
+    }
+    _spectrumBuffer.publish();
 }
 
-void AudioEngine::setNoiseLowCut(float freq)
+// ─────────────────────────────────────────────────────────────────────────────
+// AEC worker task (runs on Core 0)
+//
+// Owns the AEC handles, so they are only ever created, used and destroyed on
+// this task. The audio task never waits on it: frames go in through _aecJobs,
+// come back through _aecResults, and the frame bridge's extra AEC frame of
+// latency is the worker's deadline. With busAfe the same frames go through
+// one AFE instead, on the mid signal.
+// ─────────────────────────────────────────────────────────────────────────────
+
+void AudioEngine::aecTask(void* param)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    _params.tinnitus.noiseLowCut = std::clamp(freq, 20.0f, 2000.0f);
-    _paramsChanged = true;
+    auto* self = static_cast<AudioEngine*>(param);
+    self->aecWorkerLoop();
 }
 
-void AudioEngine::setNoiseHighCut(float freq)
+void AudioEngine::aecWorkerLoop()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    _params.tinnitus.noiseHighCut = std::clamp(freq, 1000.0f, 16000.0f);
-    _paramsChanged = true;
+    mclog::tagInfo(TAG, "AEC worker started on core {}", xPortGetCoreID());
+
+    AecJob job;
+    AecResult result;
+    int config = -1;
+    bool shared = false;
+    int16_t micPair[2 * AEC_FRAME_16K];  // Interleaved L/R for the shared two-mic handle, (mid, ref) for the AFE
+    int16_t outPair[2 * AEC_FRAME_16K];  // AFE: fetched output not yet sent back
+    AfeHandle afe;
+    int afeFill = 0;
+    uint32_t afeEpoch = 0;
+    int64_t afeFed = 0;                  // Samples into the AFE this epoch, and out of it
+    int64_t afeFetched = 0;
+    SrHandles srPool[SR_KINDS][SR_WARM_PER_KIND];
+    uint32_t srServed[SR_KINDS] = {};
+    auto* noiseRender = new NoiseLoopRender();
+
+    while (_running.load(std::memory_order_acquire)) {
+        serviceSrHandles(srPool, srServed);
+        serviceNoiseLoop(*noiseRender);
+
+        int wanted = _aecConfig.load(std::memory_order_acquire);
+        if (wanted != config) {
+            _aecReady.store(false, std::memory_order_release);
+            destroyAecHandles(_aecHandleL, _aecHandleR);
+            destroyAfeHandle(afe);
+            shared = (wanted & 0x100) != 0;
+            if (wanted >= 0 && (wanted & AFE_CONFIG)) {
+                createAfeHandle(afe, wanted, AEC_FRAME_16K);
+                afeFill = 0;
+                afeFed = afeFetched = 0;
+                afeEpoch = job.epoch - 1;  // Whatever comes next starts an epoch
+            } else if (wanted >= 0) {
+                createAecHandles(_aecHandleL, _aecHandleR, (wanted >> 4) & 0xF, wanted & 0xF, shared);
+            }
+            config = wanted;
+            _aecReady.store(afe.data || (_aecHandleL && (shared || _aecHandleR)), std::memory_order_release);
+        }
+
+        if (!_aecJobs.pop(job)) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+            continue;
+        }
+        if (!_aecReady.load(std::memory_order_relaxed)) continue;
+
+        if (afe.data) {
+            if (job.epoch != afeEpoch) {
+                // A bridge reset: the AFE's history belongs to the old stream
+                afe.iface->reset_buffer(afe.data);
+                afeFill = 0;
+                afeFed = afeFetched = 0;
+                afeEpoch = job.epoch;
+            }
+            for (int i = 0; i < AEC_FRAME_16K; i++) {
+                micPair[2 * i + 0] = static_cast<int16_t>((job.inL[i] + job.inR[i]) >> 1);
+                micPair[2 * i + 1] = job.ref[i];
+            }
+            const int before = afeFill;
+            afeFill = runAfeFrame(afe, micPair, AEC_FRAME_16K, outPair, afeFill, 2 * AEC_FRAME_16K);
+            afeFed += AEC_FRAME_16K;
+            afeFetched += std::max(0, afeFill - before);
+            // Until the AFE has a frame's worth out (its own buffering) the bridge sends the
+            // frames dry; after that each job's result is the AFE's latest frame, so the
+            // AFE delay rides on top of the bridge's as a constant lag
+            if (afeFill < AEC_FRAME_16K) continue;
+            _afeLag16k.store(static_cast<int>(afeFed - afeFetched) + afeFill - AEC_FRAME_16K,
+                             std::memory_order_relaxed);
+            memcpy(result.outL, outPair, AEC_FRAME_16K * sizeof(int16_t));
+            memcpy(result.outR, outPair, AEC_FRAME_16K * sizeof(int16_t));
+            afeFill -= AEC_FRAME_16K;
+            memmove(outPair, outPair + AEC_FRAME_16K, afeFill * sizeof(int16_t));
+            result.epoch = job.epoch;
+            result.pos = job.pos;
+            _aecResults.push(result);
+            continue;
+        }
+        if constexpr (!audio_stages::AEC) continue;  // Never ready; keeps aec_process out of the image
+
+        if (shared) {
+            for (int i = 0; i < AEC_FRAME_16K; i++) {
+                micPair[2 * i + 0] = job.inL[i];
+                micPair[2 * i + 1] = job.inR[i];
+            }
+            aec_process(static_cast<aec_handle_t*>(_aecHandleL), micPair, job.ref, outPair);
+            for (int i = 0; i < AEC_FRAME_16K; i++) {
+                result.outL[i] = outPair[2 * i + 0];
+                result.outR[i] = outPair[2 * i + 1];
+            }
+        } else {
+            aec_process(static_cast<aec_handle_t*>(_aecHandleL), job.inL, job.ref, result.outL);
+            aec_process(static_cast<aec_handle_t*>(_aecHandleR), job.inR, job.ref, result.outR);
+        }
+        result.epoch = job.epoch;
+        result.pos = job.pos;
+        _aecResults.push(result);
+    }
+
+    _aecReady.store(false, std::memory_order_release);
+    destroyAecHandles(_aecHandleL, _aecHandleR);
+    destroyAfeHandle(afe);
+    SrHandles retired;
+    while (_srRetired.pop(retired)) freeSrHandles(retired);
+    for (auto& warm : srPool) {
+        for (auto& set : warm) {
+            if (set.mode >= 0) freeSrHandles(set);
+        }
+    }
+    delete noiseRender;
+    mclog::tagInfo(TAG, "AEC worker stopped");
 }
 
-void AudioEngine::setToneFinderEnabled(bool enabled)
+// ─────────────────────────────────────────────────────────────────────────────
+// Split-ear worker (Core 0)
+//
+// Fork-join per bus frame: the audio task fills _earLane, raises _earPending and
+// notifies; this task runs the lane and drops the flag. It sits above the AEC
+// worker, so a 32ms AEC frame never holds up a 10ms bus frame.
+// ─────────────────────────────────────────────────────────────────────────────
+
+void AudioEngine::runEarLaneNs(EarLane& lane)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    _params.tinnitus.toneFinderEnabled = enabled;
-    _paramsChanged = true;
+    floatToInt16(lane.f, lane.q, NS_FRAME_16K);
+    lane.pow[0] = lane.pow[1] = blockPower(lane.q, lane.q, NS_FRAME_16K);
+    if (audio_stages::NS && lane.ns) {
+        ns_process(static_cast<ns_handle_t>(lane.ns), lane.q, lane.qNext);
+        std::swap(lane.q, lane.qNext);
+        lane.pow[1] = blockPower(lane.q, lane.q, NS_FRAME_16K);
+    }
 }
 
-void AudioEngine::setToneFinderFreq(float freq)
+void AudioEngine::runEarLaneAgc(EarLane& lane)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    _params.tinnitus.toneFinderFreq = std::clamp(freq, 200.0f, 12000.0f);
-    _paramsChanged = true;
+    lane.pow[2] = lane.pow[1];
+    if (audio_stages::AGC && lane.agc) {
+        esp_agc_process(lane.agc, lane.q, lane.qNext, NS_FRAME_16K, 16000);
+        std::swap(lane.q, lane.qNext);
+        lane.pow[2] = blockPower(lane.q, lane.q, NS_FRAME_16K);
+    }
+    int16ToFloat(lane.q, lane.f, NS_FRAME_16K);
 }
 
-void AudioEngine::setToneFinderLevel(float level)
+void AudioEngine::earTask(void* param)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    _params.tinnitus.toneFinderLevel = std::clamp(level, 0.0f, 1.0f);
-    _paramsChanged = true;
+    auto* self = static_cast<AudioEngine*>(param);
+    self->earWorkerLoop();
 }
 
-void AudioEngine::setHfExtEnabled(bool enabled)
+void AudioEngine::earWorkerLoop()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    _params.tinnitus.hfExtEnabled = enabled;
-    _paramsChanged = true;
+    mclog::tagInfo(TAG, "split-ear worker started on core {}", xPortGetCoreID());
+
+    while (!_earTask.checkKillSignal()) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (!_earPending.load(std::memory_order_acquire)) continue;
+        runEarLaneNs(_earLane);
+        runEarLaneAgc(_earLane);
+        _earPending.store(false, std::memory_order_release);
+        _audioTask.notify();  // For a join that stopped spinning
+    }
 }
 
-void AudioEngine::setHfExtFreq(float freq)
+// ─────────────────────────────────────────────────────────────────────────────
+// ESP-SR handle service
+//
+// The audio task only ever swaps pointers: it posts the mode it wants, keeps
+// running the installed set until the worker delivers the new one, and sends
+// released sets back. The worker does every create/destroy and keeps the last
+// SR_WARM_PER_KIND sets of each kind warm, so toggling between presets reuses
+// state that is already initialized.
+// ─────────────────────────────────────────────────────────────────────────────
+
+void AudioEngine::buildSrHandles(SrHandles& h)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    _params.tinnitus.hfExtFreq = std::clamp(freq, 4000.0f, 12000.0f);
-    _paramsChanged = true;
+    switch (h.kind) {
+        case SR_NS:  createNsHandles(h.l, h.r, h.mode); break;
+        case SR_AGC: createAgcHandles(h.l, h.r, h.mode); break;
+        case SR_VAD: createVadHandle(h.l, h.mode); break;
+    }
 }
 
-void AudioEngine::setHfExtGainDb(float gainDb)
+void AudioEngine::freeSrHandles(SrHandles& h)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    _params.tinnitus.hfExtGainDb = std::clamp(gainDb, 0.0f, 12.0f);
-    _paramsChanged = true;
+    switch (h.kind) {
+        case SR_NS:  destroyNsHandles(h.l, h.r); break;
+        case SR_AGC: destroyAgcHandles(h.l, h.r); break;
+        case SR_VAD: destroyVadHandle(h.l); break;
+    }
+    h.mode = -1;
 }
 
-void AudioEngine::setBinauralEnabled(bool enabled)
+void AudioEngine::requestSrHandles(int kind, int mode)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    _params.tinnitus.binauralEnabled = enabled;
-    _paramsChanged = true;
+    void** slots[SR_KINDS][2] = {
+        {&_nsHandleL, &_nsHandleR}, {&_agcHandleL, &_agcHandleR}, {&_vadHandleRef, nullptr}};
+
+    // Off: release now. A mode already installed needs nothing built, but the
+    // new request word still cancels any delivery that is in flight.
+    if (mode < 0 || mode == _srMode[kind]) {
+        if (mode < 0 && _srMode[kind] >= 0) {
+            SrHandles old;
+            old.kind = kind;
+            old.mode = _srMode[kind];
+            old.l = *slots[kind][0];
+            old.r = slots[kind][1] ? *slots[kind][1] : nullptr;
+            *slots[kind][0] = nullptr;
+            if (slots[kind][1]) *slots[kind][1] = nullptr;
+            _srMode[kind] = -1;
+            retireSrHandles(old);
+        }
+        _srRequest[kind].store(++_srSeq << 8, std::memory_order_release);
+        _aecTask.notify();
+        return;
+    }
+
+    uint32_t word = (++_srSeq << 8) | static_cast<uint32_t>(mode + 1);
+    _srRequest[kind].store(word, std::memory_order_release);
+    if (_aecTask.isRunning()) {
+        _aecTask.notify();
+        return;
+    }
+
+    // No worker (it failed to start): build inline as a last resort
+    SrHandles h;
+    h.kind = kind;
+    h.mode = mode;
+    h.request = word;
+    buildSrHandles(h);
+    if (h.l) _srHandover.push(h);
 }
 
-void AudioEngine::setBinauralCarrier(float freq)
+unsigned AudioEngine::installSrHandles()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    _params.tinnitus.binauralCarrier = std::clamp(freq, 50.0f, 500.0f);
-    _paramsChanged = true;
+    void** slots[SR_KINDS][2] = {
+        {&_nsHandleL, &_nsHandleR}, {&_agcHandleL, &_agcHandleR}, {&_vadHandleRef, nullptr}};
+    unsigned installed = 0;
+    SrHandles h;
+    while (_srHandover.pop(h)) {
+        if (h.request != _srRequest[h.kind].load(std::memory_order_relaxed)) {
+            retireSrHandles(h);  // Superseded while it was being built
+            continue;
+        }
+        SrHandles old;
+        old.kind = h.kind;
+        old.mode = _srMode[h.kind];
+        old.l = *slots[h.kind][0];
+        old.r = slots[h.kind][1] ? *slots[h.kind][1] : nullptr;
+        *slots[h.kind][0] = h.l;
+        if (slots[h.kind][1]) *slots[h.kind][1] = h.r;
+        _srMode[h.kind] = h.mode;
+        if (old.mode >= 0) retireSrHandles(old);
+        installed |= 1u << h.kind;
+    }
+    return installed;
 }
 
-void AudioEngine::setBinauralBeat(float freq)
+void AudioEngine::retireSrHandles(const SrHandles& h)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    _params.tinnitus.binauralBeat = std::clamp(freq, 1.0f, 40.0f);
-    _paramsChanged = true;
+    if (_aecTask.isRunning() && _srRetired.push(h)) return;
+    // Worker gone or backed up: pay for the destroy here rather than leak
+    SrHandles dead = h;
+    freeSrHandles(dead);
 }
 
-void AudioEngine::setBinauralLevel(float level)
+void AudioEngine::serviceSrHandles(SrHandles (*pool)[SR_WARM_PER_KIND], uint32_t* served)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    _params.tinnitus.binauralLevel = std::clamp(level, 0.0f, 1.0f);
-    _paramsChanged = true;
+    // Released sets go to the front of their kind's warm list; the oldest set no
+    // A/B slot needs falls off. With every kept set pinned, an unpinned one is dropped.
+    auto keepWarm = [&](const SrHandles& h) {
+        SrHandles* warm = pool[h.kind];
+        const uint32_t pinned = _srPinned[h.kind].load(std::memory_order_relaxed);
+        auto isPinned = [&](int mode) { return mode >= 0 && mode < 32 && (pinned & (1u << mode)); };
+        int victim = -1;
+        for (int i = SR_WARM_PER_KIND - 1; i >= 0 && victim < 0; i--) {
+            if (!isPinned(warm[i].mode)) victim = i;
+        }
+        if (victim < 0) {
+            if (!isPinned(h.mode)) {
+                SrHandles dead = h;
+                freeSrHandles(dead);
+                return;
+            }
+            victim = SR_WARM_PER_KIND - 1;
+        }
+        if (warm[victim].mode >= 0) freeSrHandles(warm[victim]);
+        for (int i = victim; i > 0; i--) warm[i] = warm[i - 1];
+        warm[0] = h;
+    };
+    SrHandles h;
+    while (_srRetired.pop(h)) keepWarm(h);
+
+    for (int k = 0; k < SR_KINDS; k++) {
+        uint32_t word = _srRequest[k].load(std::memory_order_acquire);
+        if (word == served[k]) continue;
+        int mode = static_cast<int>(word & 0xFF) - 1;
+        if (mode >= 0) {
+            SrHandles set;
+            SrHandles* warm = pool[k];
+            for (int i = 0; i < SR_WARM_PER_KIND; i++) {
+                if (warm[i].mode != mode) continue;
+                set = warm[i];
+                for (int j = i; j < SR_WARM_PER_KIND - 1; j++) warm[j] = warm[j + 1];
+                warm[SR_WARM_PER_KIND - 1] = SrHandles{};
+                break;
+            }
+            if (set.mode < 0) {
+                set.kind = k;
+                set.mode = mode;
+                buildSrHandles(set);
+            }
+            set.request = word;
+            if (set.l && !_srHandover.push(set)) {
+                // Audio task hasn't drained yet; keep it warm and retry next pass
+                keepWarm(set);
+                continue;
+            }
+        }
+        served[k] = word;
+    }
+
+    // A/B slots: build what the inactive slot will ask for ahead of the switch,
+    // one set per pass so AEC frames keep their deadline
+    for (int k = 0; k < SR_KINDS; k++) {
+        uint32_t missing = _srPinned[k].load(std::memory_order_relaxed);
+        const int servedMode = static_cast<int>(served[k] & 0xFF) - 1;
+        if (servedMode >= 0) missing &= ~(1u << servedMode);
+        for (int i = 0; i < SR_WARM_PER_KIND; i++) {
+            if (pool[k][i].mode >= 0) missing &= ~(1u << pool[k][i].mode);
+        }
+        if (missing == 0) continue;
+        SrHandles set;
+        set.kind = k;
+        set.mode = __builtin_ctz(missing);
+        buildSrHandles(set);
+        if (set.l) {
+            keepWarm(set);
+        } else {
+            _srPinned[k].fetch_and(~(1u << set.mode), std::memory_order_relaxed);  // Don't retry every pass
+        }
+        break;
+    }
+}
+
+bool AudioEngine::srHandlesPending() const
+{
+    for (int k = 0; k < SR_KINDS; k++) {
+        int mode = static_cast<int>(_srRequest[k].load(std::memory_order_relaxed) & 0xFF) - 1;
+        if (mode >= 0 && mode != _srMode[k]) return true;
+    }
+    return false;
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -979,7 +5699,6 @@ void AudioEngine::audioTask(void* param)
 {
     auto* self = static_cast<AudioEngine*>(param);
     self->processLoop();
-    vTaskDelete(nullptr);
 }
 
 void AudioEngine::processLoop()
@@ -989,227 +5708,795 @@ void AudioEngine::processLoop()
     bsp_codec_config_t* codec = bsp_get_codec_handle();
     if (!codec) {
         mclog::tagError(TAG, "failed to get codec handle");
-        std::lock_guard<std::mutex> lock(_mutex);
         _running = false;
         return;
     }
 
-    // Configure codec for 48kHz stereo output
-    codec->i2s_reconfig_clk_fn(SAMPLE_RATE, 16, I2S_SLOT_MODE_STEREO);
-    codec->set_volume(100);
-    codec->set_mute(true);  // Start muted
-
-    // Allocate I/O buffers
-    const size_t inBufBytes = BLOCK_SIZE * NUM_CHANNELS_IN * sizeof(int16_t);
-    const size_t outBufBytes = BLOCK_SIZE * NUM_CHANNELS_OUT * sizeof(int16_t);
-
-    int16_t* inBuf = new int16_t[BLOCK_SIZE * NUM_CHANNELS_IN];
-    int16_t* outBuf = new int16_t[BLOCK_SIZE * NUM_CHANNELS_OUT];
-    float* floatL = new float[BLOCK_SIZE];
-    float* floatR = new float[BLOCK_SIZE];
-    float* floatHP = new float[BLOCK_SIZE];  // Headphone mic (CH3) for voice exclusion
-
-    // NS processing buffers (16kHz domain)
-    float* down16kL = new float[NS_FRAME_16K];
-    float* down16kR = new float[NS_FRAME_16K];
-    int16_t* ns16kIn = new int16_t[NS_FRAME_16K];
-    int16_t* ns16kOut = new int16_t[NS_FRAME_16K];
-    float* up48kL = new float[BLOCK_SIZE];
-    float* up48kR = new float[BLOCK_SIZE];
-
-    // NS Resamplers
-    Resampler resamplerDownL, resamplerDownR;
-    Resampler resamplerUpL, resamplerUpR;
-    resamplerDownL.init(true);
-    resamplerDownR.init(true);
-    resamplerUpL.init(false);
-    resamplerUpR.init(false);
-
-    // VE Resamplers (separate state from NS resamplers)
-    Resampler veResDownL, veResDownR, veResDownHP;
-    Resampler veResUpL, veResUpR;
-    veResDownL.init(true);
-    veResDownR.init(true);
-    veResDownHP.init(true);
-    veResUpL.init(false);
-    veResUpR.init(false);
-
-    // VE 16kHz processing buffers
-    float* veDown16kL  = new float[NS_FRAME_16K];  // 160 samples
-    float* veDown16kR  = new float[NS_FRAME_16K];
-    float* veDown16kHP = new float[NS_FRAME_16K];
-    float* veEst16kL   = new float[NS_FRAME_16K];  // NLMS estimates at 16kHz
-    float* veEst16kR   = new float[NS_FRAME_16K];
-    float* veEstUp48kL = new float[BLOCK_SIZE];     // Upsampled estimates
-    float* veEstUp48kR = new float[BLOCK_SIZE];
-
-    // AEC ring buffers (accumulate 160→512 sample frames for AEC processing)
-    AecRingBuf aecRingL, aecRingR, aecRingHP;
-    AecRingBuf aecOutRingL, aecOutRingR;  // Output ring buffers
-    aecRingL.reset(); aecRingR.reset(); aecRingHP.reset();
-    aecOutRingL.reset(); aecOutRingR.reset();
-
-    // AEC 16kHz I/O buffers (512 samples, aligned for ESP-SR)
-    int16_t* aec16kInL  = static_cast<int16_t*>(heap_caps_aligned_alloc(16, AEC_FRAME_16K * sizeof(int16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
-    int16_t* aec16kInR  = static_cast<int16_t*>(heap_caps_aligned_alloc(16, AEC_FRAME_16K * sizeof(int16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
-    int16_t* aec16kRef  = static_cast<int16_t*>(heap_caps_aligned_alloc(16, AEC_FRAME_16K * sizeof(int16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
-    int16_t* aec16kOutL = static_cast<int16_t*>(heap_caps_aligned_alloc(16, AEC_FRAME_16K * sizeof(int16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
-    int16_t* aec16kOutR = static_cast<int16_t*>(heap_caps_aligned_alloc(16, AEC_FRAME_16K * sizeof(int16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
-
-    // VAD buffer (uses the AEC frame size for analysis)
-    int16_t* vad16kBuf = static_cast<int16_t*>(heap_caps_aligned_alloc(16, AEC_FRAME_16K * sizeof(int16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
-
-    // AEC output float buffers for upsampling
-    float* aecFloat16kL = new float[AEC_FRAME_16K];
-    float* aecFloat16kR = new float[AEC_FRAME_16K];
-
-    // AEC Resamplers (separate from VE NLMS resamplers)
-    Resampler aecResDownL, aecResDownR, aecResDownHP;
-    Resampler aecResUpL, aecResUpR;
-    aecResDownL.init(true);
-    aecResDownR.init(true);
-    aecResDownHP.init(true);
-    aecResUpL.init(false);
-    aecResUpR.init(false);
-
-    // AEC 16kHz downsampled buffers per block (160 samples from 480 @ 48kHz)
-    float* aecDown16kBlockL  = new float[NS_FRAME_16K];
-    float* aecDown16kBlockR  = new float[NS_FRAME_16K];
-    float* aecDown16kBlockHP = new float[NS_FRAME_16K];
-
-    // AGC Resamplers (separate state from NS/VE resamplers)
-    Resampler agcResDownL, agcResDownR;
-    Resampler agcResUpL, agcResUpR;
-    agcResDownL.init(true);
-    agcResDownR.init(true);
-    agcResUpL.init(false);
-    agcResUpR.init(false);
-
-    // AGC 16kHz processing buffers
-    float* agcDown16kL = new float[NS_FRAME_16K];   // 160 samples
-    float* agcDown16kR = new float[NS_FRAME_16K];
-    int16_t* agc16kIn  = new int16_t[NS_FRAME_16K];
-    int16_t* agc16kOut = new int16_t[NS_FRAME_16K];
-
-    mclog::tagInfo(TAG, "buffers allocated: in={}B out={}B", inBufBytes, outBufBytes);
-
-    // Local copy of params to minimize lock time
-    AudioEngineParams localParams;
-    bool localParamsChanged = true;
-    bool prevNsEnabled = false;
-    int prevNsMode = -1;
-    bool prevVeEnabled = false;
-    int prevVeFilterLength = -1;
-    bool prevAgcEnabled = false;
-    int prevAgcMode = -1;
-    int prevAgcCompressionGainDb = -1;
-    bool prevAgcLimiterEnabled = true;
-    int prevAgcTargetLevelDbfs = -99;
-    bool prevVeAecActive = false;  // Track AEC mode activation
-    int prevVeAecMode = -1;
-    int prevVeAecFilterLen = -1;
-    bool prevVeVadEnabled = false;
-    int prevVeVadMode = -1;
-    bool hpDetected = false;
-    int hpDetectCounter = 0;
-    static constexpr int HP_DETECT_INTERVAL = 48;  // check every ~48 blocks (~480ms)
-    bool aecOutputReady = false;  // True once AEC has produced its first output frame
+    // Latched by start(); the whole session runs at it
+    const int sampleRate = _sampleRate;
+    // USB audio, RTP and the recorder are fixed 48kHz streams: they pause at other rates
+    const bool nominalTaps = sampleRate == SAMPLE_RATE;
+    const int meterFrame = sampleRate / 100;  // 10ms
+
+    // Stereo output at the engine rate: no re-clock when another user left the codec in this format
+    if (AudioSession::acquire(AudioSession::USER_ENGINE, sampleRate, 16, I2S_SLOT_MODE_STEREO) != ESP_OK) {
+        mclog::tagError(TAG, "audio session unavailable (codec busy in another format)");
+        _running = false;
+        return;
+    }
+    {
+        // The session may have re-clocked the codec: have the control task rewrite everything
+        std::lock_guard<std::mutex> lock(_codecMutex);
+        codec->set_volume(100);
+        codec->set_mute(true);  // Start muted
+        _codecResync.store(true, std::memory_order_release);
+    }
+    // The session clocks TX; the ES7210 follows only when told
+    if (sampleRate != SAMPLE_RATE) {
+        std::lock_guard<std::mutex> lock(_codecMutex);
+        if (!codec->codec_reconfig_fn || codec->codec_reconfig_fn(sampleRate, 16, static_cast<i2s_slot_mode_t>(4)) != ESP_OK) {
+            mclog::tagError(TAG, "capture at {} Hz unavailable", sampleRate);
+            AudioSession::release(AudioSession::USER_ENGINE);
+            _running = false;
+            return;
+        }
+    }
+    _ctlTask.notify();
+
+    // Per-block work buffers, carved from one internal-RAM arena
+    // (sized for the largest block; smaller blocks use a prefix)
+    int32_t* inBuf = nullptr;     // Raw captured frames (room for four 32-bit slots)
+    int16_t* outBuf = nullptr;
+    float* floatL = nullptr;
+    float* floatR = nullptr;
+    float* floatHP = nullptr;     // Headphone mic (CH3) for voice exclusion
+    float* floatRef = nullptr;    // AEC loopback (CH1): feedback canceller reference, latency test
+    // 16kHz analysis bus: one shared downsample/upsample around VE → NS → AGC
+    float* bus16kL = nullptr;     // Frame accumulator: up to a frame in progress plus a block's chunk
+    float* bus16kR = nullptr;
+    float* bus16kHP = nullptr;    // Conditioned VE reference
+    int16_t* bus16kIn = nullptr;  // int16 scratch for ESP-SR calls (L lane of NS → AGC)
+    int16_t* bus16kOut = nullptr;
+    int16_t* bus16kInR = nullptr; // R lane of NS → AGC
+    int16_t* bus16kOutR = nullptr;
+    float* bus16kMid = nullptr;   // Linked NS: (L + R) / 2 of the frame
+    float* bus16kUpL = nullptr;   // Sub-block chunk drained from the output FIFO
+    float* bus16kUpR = nullptr;
+    float* veEstL = nullptr;      // VE voice estimates for the current frame
+    float* veEstR = nullptr;
+    float* noiseL = nullptr;      // Masking noise block, per channel
+    float* noiseR = nullptr;
+    float* doseL = nullptr;       // Weighted copy of the output for the dosimeter
+    float* doseR = nullptr;
+    HowlDetector* howl = nullptr; // Spectral howl tests (FFT frame + history, ~9KB)
+    BusBandSplit* bandSplit = nullptr;  // [L, R] high band around the bus (ring + reference upsampler, ~8KB each)
+    // AEC worker frames (512 samples @ 16kHz, touched once per AEC frame)
+    AecJob* aecJob = nullptr;
+    AecResult* aecResult = nullptr;
+
+    auto carveHot = [&](ScratchArena& a) {
+        inBuf     = a.take<int32_t>(BLOCK_SIZE * NUM_CHANNELS_IN);
+        outBuf    = a.take<int16_t>(BLOCK_SIZE * NUM_CHANNELS_OUT);
+        floatL    = a.take<float>(BLOCK_SIZE);
+        floatR    = a.take<float>(BLOCK_SIZE);
+        floatHP   = a.take<float>(BLOCK_SIZE);
+        floatRef  = a.take<float>(BLOCK_SIZE);
+        bus16kL   = a.take<float>(2 * NS_FRAME_16K);
+        bus16kR   = a.take<float>(2 * NS_FRAME_16K);
+        bus16kHP  = a.take<float>(2 * NS_FRAME_16K);
+        bus16kIn  = a.take<int16_t>(NS_FRAME_16K);
+        bus16kOut = a.take<int16_t>(NS_FRAME_16K);
+        bus16kInR = a.take<int16_t>(NS_FRAME_16K);
+        bus16kOutR = a.take<int16_t>(NS_FRAME_16K);
+        bus16kMid = a.take<float>(NS_FRAME_16K);
+        bus16kUpL = a.take<float>(BLOCK_SIZE / 2);  // 32kHz: a block's chunk is half of it
+        bus16kUpR = a.take<float>(BLOCK_SIZE / 2);
+        veEstL    = a.take<float>(NS_FRAME_16K);
+        veEstR    = a.take<float>(NS_FRAME_16K);
+        noiseL    = a.take<float>(BLOCK_SIZE);
+        noiseR    = a.take<float>(BLOCK_SIZE);
+        doseL     = a.take<float>(BLOCK_SIZE);
+        doseR     = a.take<float>(BLOCK_SIZE);
+        howl      = a.take<HowlDetector>(1);
+        bandSplit = a.take<BusBandSplit>(2);
+    };
+    AecFrameBridge aecBridge;
+    static_assert(AecFrameBridge::IN_FRAME == NS_FRAME_16K && AecFrameBridge::AEC_FRAME == AEC_FRAME_16K,
+                  "AEC bridge framing must match the bus and ESP-SR AEC frames");
+    auto carveAec = [&](ScratchArena& a) {
+        aecJob     = a.take<AecJob>(1);
+        aecResult  = a.take<AecResult>(1);
+        aecBridge.ringL  = a.take<float>(AecFrameBridge::CAPACITY);
+        aecBridge.ringR  = a.take<float>(AecFrameBridge::CAPACITY);
+        aecBridge.ringHP = a.take<float>(AecFrameBridge::CAPACITY);
+    };
+
+    ScratchArena hotArena, aecArena;
+    {
+        ScratchArena sizing;
+        carveHot(sizing);
+        const size_t hotBytes = sizing.used();
+        ScratchArena aecSizing;
+        carveAec(aecSizing);
+        const size_t aecBytes = aecSizing.used();
+
+        // Hot buffers must be internal; check headroom so we don't starve other tasks
+        const uint32_t internalCaps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+        size_t largestInternal = heap_caps_get_largest_free_block(internalCaps);
+        if (largestInternal < hotBytes + INTERNAL_RAM_RESERVE || !hotArena.init(hotBytes, internalCaps)) {
+            mclog::tagWarn(TAG, "internal RAM low (largest block {}B), work buffers fall back to PSRAM", largestInternal);
+            hotArena.init(hotBytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        }
+        // AEC frames are only touched every 32ms; PSRAM is an acceptable fallback
+        largestInternal = heap_caps_get_largest_free_block(internalCaps);
+        if (largestInternal < aecBytes + INTERNAL_RAM_RESERVE || !aecArena.init(aecBytes, internalCaps)) {
+            aecArena.init(aecBytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        }
+    }
+    carveHot(hotArena);
+    carveAec(aecArena);
+    if (!inBuf || !aecJob) {
+        mclog::tagError(TAG, "failed to allocate audio work buffers");
+        hotArena.destroy();
+        aecArena.destroy();
+        AudioSession::release(AudioSession::USER_ENGINE);
+        _running = false;
+        return;
+    }
+
+    BusFifo busOutL, busOutR;
+    int busFill = 0;                               // 16kHz samples accumulated toward a frame
+
+    // 3:1 at 48kHz, 2:1 half-band at 32kHz; at 24kHz the bus stays off (maskRateStages)
+    const int busRatio = std::max(busRatioFor(sampleRate), 2);
+    const int busResamplerDelay = Resampler::taps(busRatio) - 1;  // ↓ + ↑ group delay, engine-rate samples
+    Resampler busDownL, busDownR, busDownHP;
+    Resampler busUpL, busUpR;
+    busDownL.init(true, busRatio);
+    busDownR.init(true, busRatio);
+    busDownHP.init(true, busRatio);
+    busUpL.init(false, busRatio);
+    busUpR.init(false, busRatio);
+
+    aecBridge.reset();
+
+    Beamformer beamformer;
+    beamformer.reset();
+
+    VadHangover vadHangover;
+
+    MaskingNoise maskingNoise;
+    maskingNoise.reset();
+    uint32_t noiseLoopSeq = 0;
+    int noiseLoopBuf = -1;      // Loop being played, -1 = live generation
+    int noiseLoopFadeOut = -1;  // Loop being faded out under live noise this block
+    int noiseLoopPos = 0;
+    int prevNoiseType = -1;
+    bool prevSessionActive = false;
+    bool prevNfcEnabled = false;
+    LookaheadLimiter limiter;
+    limiter.reset();
+    LinkedAgc linkedAgc;
+    OwnVoiceDetector ownVoice;    // One decision per block (5b) for the NLMS step, linked AGC and duck
+    float ownVoiceGain = 1.0f;    // Output duck (8h), per sample toward 1 or the duck gain
+    const float ownDuckAttack = 1.0f - expf(-1.0f / (0.03f * sampleRate));
+    const float ownDuckRelease = 1.0f - expf(-1.0f / (0.15f * sampleRate));
+    bool prevAgcLinkedActive = false;
+    bool prevLimiterEnabled = false;
+    // Dosimeter: weighting on a copy of the final output, summed into one-second records
+    BiquadCascade doseCascade;
+    int doseWeighting = -1;
+    float doseCutDb = 0.0f;        // Applied cut, ramped toward the dosimeter's limit
+    double doseEnergy = 0.0;       // Sum of squares this second, louder ear
+    double doseCutSum = 0.0;       // Sum of cut * samples, for the second's mean cut
+    int doseSamples = 0;
+    const float doseCutStep = 5.0f / sampleRate;  // dB per sample (5 dB/s)
+    uint64_t sessionSamples = 0;  // Samples into the current session
+    bool sessionOff = false;      // Session over: bus and generators are skipped
+    float prevNoiseLowCut = -1.0f, prevNoiseHighCut = -1.0f;
+
+    mclog::tagInfo(TAG, "buffers allocated: work={}B ({}) aec={}B ({})",
+        hotArena.used(), hotArena.isInternal() ? "internal" : "PSRAM",
+        aecArena.used(), aecArena.isInternal() ? "internal" : "PSRAM");
+
+    // Local copy of params (refreshed from _paramsBuffer) and task-owned meters
+    AudioEngineParams localParams;
+    AudioLevels levels;
+    levels.sampleRate = sampleRate;
+    bool localParamsChanged = true;
+    // A/B switch dip: fade out on the old slot, swap, hold for handle sets, fade in
+    enum { AB_IDLE, AB_FADE_OUT, AB_HOLD, AB_FADE_IN } abPhase = AB_IDLE;
+    float abGain = 1.0f;
+    int abHoldSamples = 0;
+    const float AB_STEP = 1000.0f / (AB_FADE_MS * sampleRate);
+    const int AB_HOLD_MAX = AB_HOLD_MAX_MS * sampleRate / 1000;
+    bool prevNsEnabled = false;
+    int prevNsMode = -1;
+    bool prevVeEnabled = false;
+    int prevVeFilterLength = -1;
+    int prevVeMode = -1;
+    bool prevAgcEnabled = false;
+    bool prevAgcLinked = false;
+    int prevAgcMode = -1;
+    int prevAgcCompressionGainDb = -1;
+    bool prevAgcLimiterEnabled = true;
+    int prevAgcTargetLevelDbfs = -99;
+    auto applyAgcConfig = [&]() {
+        if constexpr (!audio_stages::AGC) return;
+        for (void* h : {_agcHandleL, _agcHandleR}) {
+            if (h) {
+                set_agc_config(h, localParams.agcCompressionGainDb, localParams.agcLimiterEnabled ? 1 : 0,
+                               localParams.agcTargetLevelDbfs);
+            }
+        }
+    };
+    int prevAecConfig = -1;  // Worker config word last sent (AEC mode or busAfe)
+    bool prevVeVadEnabled = false;
+    int prevVeVadMode = -1;
+    bool prevAecRunning = false;  // Bridge is restarted whenever AEC resumes
+    bool prevBusActive = false;   // Resampler history is reset on bus enter/exit
+    float nsLinkGain = 1.0f;      // Linked NS gain at the end of the last frame
+    static constexpr float NS_LINK_FLOOR = 1e-9f;  // Mid frame power (-90 dBFS) below which the gain holds
+    bool prevBandSplit = false;   // High band rings restart with the band split
+    int prevVeDelay16k = 0;       // ... and when subband VE moves the low band's delay
+    float busGain = 1.0f;         // Broadband gain of the last processed bus frame (high band, quiet path)
+    ActivityGate activity;        // Input activity for the quiet path
+    WindDetector wind;            // Wind / handling noise (windMode)
+    SceneFrame sceneFrame;        // Scene tiers: sums over the frame in progress (sceneAuto)
+    int sceneSamples = 0;
+    float sceneLow = 0.0f, scenePrev = 0.0f;
+    const int SCENE_FRAME_SAMPLES = SCENE_FRAME_MS * sampleRate / 1000;
+    const float SCENE_LOWPASS = 1.0f - expf(-TWO_PI * 500.0f / sampleRate);  // One-pole ~500Hz
+    float windHpfHz = -1.0f;      // Wind corner in the input cascades' HPF: 0 = the ears' own, -1 = re-apply
+    float windMix = 0.0f;         // -1 = both channels on MIC-L ... +1 = both on MIC-R
+    static constexpr float WIND_HPF_BASE = 80.0f;                           // Corner where the wind starts rising
+    const float WIND_MIX_STEP = 1000.0f / (10.0f * sampleRate);  // 10ms mic crossfade
+    const float bandSmoothing = 1.0f - expf(-1.0f / (0.005f * sampleRate));  // 5ms toward each frame's gain
+    int prevBeamMode = 0;
+
+    // Feedback control: forward-path shifter, howl detector and the notches it parks
+    FrequencyShifter shifter;
+    shifter.reset();
+    howl->reset();
+    struct AutoNotch {
+        float freq = 0.0f;
+        int ageSamples = 0;
+        bool active = false;
+    };
+    AutoNotch autoNotches[6];
+    static constexpr float AUTO_NOTCH_Q = 10.0f;
+    static constexpr float AUTO_NOTCH_MATCH = 0.03f;             // Same howl if within 3%
+    const int AUTO_NOTCH_HOLD = 30 * sampleRate;                 // Released after 30s
+    Biquad notchBq;
+    // A howl is in both ears, so its notch parks in both ears' cascades, and only
+    // where neither ear's user notch owns the slot
+    auto userNotchInSlot = [&](int i) {
+        return localParams.tinnitus.notches[i].enabled ||
+               (!localParams.earsLinked && localParams.rightEar.notches[i].enabled);
+    };
+    auto parkAutoNotch = [&](int i) {
+        calcNotchCoeffs(notchBq, autoNotches[i].freq, AUTO_NOTCH_Q, sampleRate);
+        _tinnitusCascade.setSection(SLOT_NOTCH0 + i, notchBq, true);
+        _tinnitusCascadeR.setSection(SLOT_NOTCH0 + i, notchBq, true);
+    };
+    auto releaseAutoNotch = [&](int i) {
+        // Hand the slot back to the user's (disabled or just enabled) notch
+        for (int ear = 0; ear < 2; ear++) {
+            const auto& n = localParams.ear(static_cast<AudioEar>(ear)).notches[i];
+            calcNotchCoeffs(notchBq, n.frequency, n.Q, sampleRate);
+            (ear == 0 ? _tinnitusCascade : _tinnitusCascadeR).setSection(SLOT_NOTCH0 + i, notchBq, n.enabled);
+        }
+        autoNotches[i] = AutoNotch{};
+    };
+    bool prevFbcEnabled = false;
+    int prevFbcFilterLength = -1;
+    bool prevFirActive = false;
+    bool prevHowlActive = false;
+
+    // Hearing chain (7e'-8): registered in chain order, switched per block below
+    HearingChain chain;
+    chain.engine = this;
+    chain.params = &localParams;
+    chain.levels = &levels;
+    chain.shifter = &shifter;
+    DspGraph hearing;
+    auto addStage = [&](DspGraph::ProcessFn process, DspGraph::ResetFn reset, AudioStage tag, bool enabled = false) {
+        return hearing.addStage({process, reset, &chain, DspGraph::RATE_48K, tag}, enabled);
+    };
+    const int spectralStage = addStage(HearingChain::spectral, HearingChain::spectralReset, AUDIO_STAGE_SPECTRAL);
+    const int vadGateStage  = addStage(HearingChain::vadGate, nullptr, AUDIO_STAGE_DYNAMICS);
+    addStage(HearingChain::fittedMix, nullptr, AUDIO_STAGE_MIXER, true);  // Voices come and go on their own
+    const int wdrcStage     = addStage(HearingChain::wdrc, HearingChain::wdrcReset, AUDIO_STAGE_DYNAMICS);
+    const int mbcStage      = addStage(HearingChain::mbc, HearingChain::mbcReset, AUDIO_STAGE_DYNAMICS);
+    const int shiftStage    = addStage(HearingChain::shift, HearingChain::shiftReset, AUDIO_STAGE_FEEDBACK);
+    const int tinnitusStage = addStage(HearingChain::tinnitus, nullptr, AUDIO_STAGE_TINNITUS);
+
+    // Mic gain trim: covers the gap between micGain and the PGA the control task last set
+    constexpr float PGA_MAX_DB = 37.5f;     // ES7210 PGA ceiling; esp_codec_dev clamps above it
+    float micTrim = 1.0f;
+
+    // Deadline-miss detector state
+    int64_t prevReadUs = 0;
+    // Watchdog state: empty reads in a row, health resets in the current second, and the open
+    // restart (the last good read before it; restarts that brought no block back since)
+    int emptyReads = 0;
+    int healthResets = 0;
+    int healthWindowSamples = 0;
+    int64_t lastGoodReadUs = 0;
+    int64_t recoverySinceUs = 0;
+    int failedRestarts = 0;
+    int degradeWindowSamples = 0;
+    int degradeWindowMisses = 0;
+    bool aecDegraded = false;     // AEC forced to SR_LOW_COST by the degrade policy
+    bsp_i2s_xrun_counts_t xrunBase = {};
+    bsp_i2s_get_xrun_counts(&xrunBase);
+
+    // Cache counters of this core's data bus, sampled at read done and the deadline check
+    const int cacheCore = esp_cpu_get_core_id();
+    levels.cache.available = bsp_cache_counters_start() == ESP_OK;
+    bsp_cache_counts_t cacheMark = {};
+
+    // Block size and 10ms metering frame accumulation
+    int blockSize = 0;  // Applied from localParams on the first pass
+    int meterSamples = 0;
+    float meterSumL = 0.0f, meterSumR = 0.0f, meterSumHP = 0.0f;
+    float meterPkL = 0.0f, meterPkR = 0.0f, meterPkHP = 0.0f;
+
+    // Latency test: MLS bursts out, each captured back from the AEC loopback (ch1) or the
+    // HP mic (ch3) and handed to the control task for the cross-correlation
+    enum { PROBE_IDLE, PROBE_ARMED, PROBE_RUNNING, PROBE_ANALYSING } probeState = PROBE_IDLE;
+    uint64_t samplesIn = 0;       // Frames read since start
+    uint64_t samplesOut = 0;      // Frames written since start
+    uint64_t probeOutIndex = 0;   // Output frame the current burst started on
+    int probeBusDelay = 0;        // Engine-rate samples of bus framing delay at probe time
+    int probeSource = AudioLatencyInfo::SOURCE_LOOPBACK;
+    int probeRun = 0;
+    int probeValid = 0;
+    float probeMs[AudioLatencyInfo::RUNS] = {};
+    float probeWorstRatio = 0.0f;
+    static constexpr int16_t PROBE_AMPLITUDE = 8000;    // ~-12 dBFS
+
+    // Spectrum analyzer: the same SPEC_FFT sample positions are copied from the input
+    // (stage 2) and the output (before stage 9), so both frames cover one stretch of time
+    int specPos = -1;             // Next capture index, < 0 = not capturing
+    int specWait = 0;             // Samples until the next frame may start
+
+    // Zero-copy I/O: de-interleave straight out of the RX DMA buffers and pack
+    // straight into the TX ones; the codec read/write path is the fallback
+    static_assert(BLOCK_SIZE % BSP_I2S_DMA_FRAME_NUM == 0, "blocks are whole DMA buffers");
+    static constexpr int MAX_DMA_BUFS = BLOCK_SIZE / BSP_I2S_DMA_FRAME_NUM;
+    static constexpr uint32_t STREAM_TIMEOUT_MS = 100;
+    const void* rxBufs[MAX_DMA_BUFS] = {};
+    int16_t* txBufs[MAX_DMA_BUFS] = {};
+    // Duplex clock: RX and TX run off one I2S clock, so the DMA timestamps fix the
+    // input → output lead; a TX buffer plays again DESC_NUM - 1 periods after it finished
+    const int32_t DMA_PERIOD_US = 1000000LL * BSP_I2S_DMA_FRAME_NUM / sampleRate;
+    const int32_t TX_REPLAY_US = (BSP_I2S_DMA_DESC_NUM - 1) * DMA_PERIOD_US;
+    int64_t rxDoneUs = 0;      // DMA completion of the block's last input buffer
+    int64_t txDoneUs = 0;      // Completion stamp of the last TX buffer filled
+    int64_t txNextDoneUs = 0;  // Expected completion stamp of the next TX buffer (0 = unknown)
+    // Buffers between two stamps were lost (overrun, stream restart, lead trim); the
+    // sample counters still advance over them so the latency test stays aligned
+    auto missedFrames = [DMA_PERIOD_US](int64_t prevUs, int64_t nowUs) -> int {
+        if (prevUs == 0) return 0;
+        int64_t missed = (nowUs - prevUs + DMA_PERIOD_US / 2) / DMA_PERIOD_US - 1;
+        return missed > 0 ? static_cast<int>(missed) * BSP_I2S_DMA_FRAME_NUM : 0;
+    };
+    bool zeroCopy = bsp_i2s_stream_start() == ESP_OK;
+    mclog::tagInfo(TAG, "I2S path: {}", zeroCopy ? "zero-copy DMA streaming" : "codec read/write");
+
+    // Capture profile: only the TDM slots the active stages read, at the requested
+    // word length. bsp_codec_init leaves all four slots at 16 bits.
+    bsp_capture_profile_t capture = {BSP_CAPTURE_SLOTS_ALL, 16};
+    bsp_capture_profile_t captureTried = capture;  // Last profile asked for (no retry storm)
+    CaptureLayout layout = captureLayout(capture);
+
+    // Output-only mode: capture off, generators written OUTPUT_ONLY_BLOCK frames at a time
+    bool outputOnly = false;
+    bool outputOnlyRejected = false;  // Couldn't enter; not retried until the param drops
+    int16_t* outputOnlyBuf = nullptr;
+
+#if CONFIG_PM_ENABLE
+    // Full CPU clock from the end of a read to the next one; while this task waits on the
+    // DMA, DFS may scale down if nothing else holds a lock (the HAL's audio-only mode)
+    esp_pm_lock_handle_t dspPmLock = nullptr;
+    if (esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "audio_dsp", &dspPmLock) != ESP_OK) dspPmLock = nullptr;
+    bool dspPmHeld = false;
+#endif
+
+    // Stages 8b-8e on floatL/R: the capture loop runs them after the hearing chain,
+    // output-only mode on silence
+    auto tinnitusGenerators = [&](int count) {
+        // ── 8b. Tinnitus Relief: Add Masking Noise ──
+        // Plays the worker's pre-rendered loop once one matches the current settings
+        if (audio_stages::TINNITUS && localParams.tinnitus.noiseType > 0 && !sessionOff) {
+            float noiseLevel = localParams.tinnitus.noiseLevel;
+            constexpr float loopScale = 1.0f / 32767.0f;
+            if (noiseLoopBuf < 0) {
+                maskingNoise.generate(localParams.tinnitus.noiseType, noiseL, noiseR, count);
+                _noiseCascade.process(noiseL, noiseR, count);
+
+                // Crossfade over one block when leaving a loop (fade = 1 → 0) or
+                // entering one (0 → 1), so brown noise doesn't step
+                uint32_t done = _noiseLoopDone.load(std::memory_order_acquire);
+                int fadeBuf = noiseLoopFadeOut;
+                bool entering = (done >> 1) == (noiseLoopSeq & 0x7FFFFFFFu);
+                if (entering) {
+                    fadeBuf = static_cast<int>(done & 1);
+                    _noiseLoopInUse.store(1u << fadeBuf, std::memory_order_release);
+                    noiseLoopPos = 0;
+                }
+                if (fadeBuf >= 0) {
+                    const int16_t* loop = _noiseLoop[fadeBuf];
+                    float step = 1.0f / count;
+                    for (int i = 0; i < count; i++) {
+                        float t = entering ? i * step : 1.0f - i * step;
+                        noiseL[i] += t * (loop[2 * noiseLoopPos] * loopScale - noiseL[i]);
+                        noiseR[i] += t * (loop[2 * noiseLoopPos + 1] * loopScale - noiseR[i]);
+                        if (++noiseLoopPos == NOISE_LOOP_FRAMES) noiseLoopPos = 0;
+                    }
+                }
+                if (entering) {
+                    noiseLoopBuf = fadeBuf;
+                    noiseLoopFadeOut = -1;
+                } else if (noiseLoopFadeOut >= 0) {
+                    noiseLoopFadeOut = -1;
+                    _noiseLoopInUse.store(0, std::memory_order_release);
+                }
+
+                for (int i = 0; i < count; i++) {
+                    floatL[i] += noiseL[i] * noiseLevel;
+                    floatR[i] += noiseR[i] * noiseLevel;
+                }
+            } else {
+                const int16_t* loop = _noiseLoop[noiseLoopBuf];
+                float g = noiseLevel * loopScale;
+                for (int i = 0; i < count; i++) {
+                    floatL[i] += loop[2 * noiseLoopPos] * g;
+                    floatR[i] += loop[2 * noiseLoopPos + 1] * g;
+                    if (++noiseLoopPos == NOISE_LOOP_FRAMES) noiseLoopPos = 0;
+                }
+            }
+        }
+
+        // ── 8c. Tinnitus Relief: Tone Finder (pure tone generator) ──
+        if (audio_stages::TINNITUS && localParams.tinnitus.toneFinderEnabled && !sessionOff) {
+            float freq = localParams.tinnitus.toneFinderFreq;
+            float level = localParams.tinnitus.toneFinderLevel;
+            _toneOsc.setFrequency(freq, sampleRate);
+            for (int i = 0; i < count; i++) {
+                float tone = _toneOsc.next() * level;
+                floatL[i] += tone;
+                floatR[i] += tone;
+            }
+        }
+
+        // ── 8d. Tinnitus Relief: Binaural Beats ──
+        if (audio_stages::TINNITUS && localParams.tinnitus.binauralEnabled && !sessionOff) {
+            float carrier = localParams.tinnitus.binauralCarrier;
+            float beat = localParams.tinnitus.binauralBeat;
+            float level = localParams.tinnitus.binauralLevel;
+            _binauralOscL.setFrequency(carrier, sampleRate);
+            _binauralOscR.setFrequency(carrier + beat, sampleRate);
+            for (int i = 0; i < count; i++) {
+                floatL[i] += _binauralOscL.next() * level;
+                floatR[i] += _binauralOscR.next() * level;
+            }
+        }
+
+        // ── 8e. Tinnitus session envelope (fade in → hold → fade out → off) ──
+        if (localParams.tinnitus.sessionActive) {
+            const uint64_t total = (uint64_t)localParams.tinnitus.sessionDurationMs * sampleRate / 1000;
+            const float fade = localParams.tinnitus.sessionFadeMs * (sampleRate / 1000.0f);
+            auto envelope = [&](uint64_t s) {
+                if (s >= total) return 0.0f;
+                if (fade < 1.0f) return 1.0f;
+                float g = std::min((float)s, (float)(total - s)) / fade;
+                return std::min(g, 1.0f);
+            };
+            float g0 = envelope(sessionSamples);
+            sessionSamples += count;
+            float g1 = envelope(sessionSamples);
+            if (g0 < 1.0f || g1 < 1.0f) {
+                float step = (g1 - g0) / count;
+                for (int i = 0; i < count; i++) {
+                    float g = g0 + step * i;
+                    floatL[i] *= g;
+                    floatR[i] *= g;
+                }
+            }
+            if (sessionSamples >= total && !sessionOff) {
+                sessionOff = true;
+                mclog::traceInfo(TAG, "tinnitus session finished after {} min, DSP stages off",
+                    localParams.tinnitus.sessionDurationMs / 60000);
+            }
+            levels.sessionElapsedMs = (uint32_t)(std::min(sessionSamples, total) * 1000 / sampleRate);
+            levels.sessionGain = g1;
+        } else {
+            levels.sessionElapsedMs = 0;
+            levels.sessionGain = 1.0f;
+        }
+        levels.sessionEnded = sessionOff;
+    };
+
+    // A/B switch dip on floatL/R (stage 8e')
+    auto abSwitchDip = [&](int count) {
+        if (abPhase != AB_IDLE) {
+            if (abPhase == AB_HOLD) {
+                abHoldSamples += count;
+                if (!srHandlesPending() || abHoldSamples >= AB_HOLD_MAX) abPhase = AB_FADE_IN;
+            }
+            const float step = abPhase == AB_FADE_IN ? AB_STEP : -AB_STEP;
+            for (int i = 0; i < count; i++) {
+                abGain = std::clamp(abGain + step, 0.0f, 1.0f);
+                floatL[i] *= abGain;
+                floatR[i] *= abGain;
+            }
+            if (abPhase == AB_FADE_IN && abGain >= 1.0f) abPhase = AB_IDLE;
+        }
+    };
+
+    // Stages 9-12 up to the kernel: dose cut, limiter, dosimeter. Returns the gain left
+    // for the output kernel.
+    auto finalGain = [&](int count, float gain, bool mute) -> float {
+        // Dose spent (mode 2): the output comes down to what holds the ear at a safe level
+        const float doseTarget = localParams.doseMode == 2 ? _doseLimitDb.load(std::memory_order_relaxed) : 0.0f;
+        if (doseCutDb != doseTarget) {
+            const float step = doseCutStep * count;
+            doseCutDb = std::clamp(doseTarget, doseCutDb - step, doseCutDb + step);
+        }
+        if (doseCutDb > 0.0f) gain *= powf(10.0f, -doseCutDb / 20.0f);
+
+        // Brickwall limiter takes the output gain so it sees the final level
+        const DynamicsParams& dyn = localParams.dynamics;
+        if (dyn.limiterEnabled) {
+            if (!prevLimiterEnabled) limiter.reset();
+            limiter.configure(dyn.limiterCeilingDb, dyn.limiterReleaseMs, sampleRate);
+            float g = limiter.process(floatL, floatR, count, gain);
+            levels.limiterGainReductionDb = 20.0f * log10f(std::max(g, 1e-5f));
+            gain = 1.0f;
+        } else {
+            levels.limiterGainReductionDb = 0.0f;
+        }
+        prevLimiterEnabled = dyn.limiterEnabled;
+
+        // Dosimeter: weighted energy of the louder ear at the final level (boost clip aside)
+        if (localParams.doseMode > 0) {
+            if (localParams.doseWeighting != doseWeighting) {
+                Biquad wbq[BiquadCascade::MAX_SECTIONS];
+                const int n = calcWeightingCoeffs(wbq, localParams.doseWeighting, sampleRate);
+                for (int s = 0; s < BiquadCascade::MAX_SECTIONS; s++) doseCascade.setSection(s, wbq[s], s < n);
+                doseWeighting = localParams.doseWeighting;
+            }
+            float sumL = 0.0f, sumR = 0.0f;
+            if (!mute) {
+                for (int i = 0; i < count; i++) {
+                    doseL[i] = floatL[i] * gain;
+                    doseR[i] = floatR[i] * gain;
+                }
+                doseCascade.process(doseL, doseR, count);
+                for (int i = 0; i < count; i++) {
+                    sumL += doseL[i] * doseL[i];
+                    sumR += doseR[i] * doseR[i];
+                }
+            }
+            doseEnergy += std::max(sumL, sumR);
+            doseCutSum += static_cast<double>(doseCutDb) * count;
+            doseSamples += count;
+            if (doseSamples >= sampleRate) {
+                const DoseSecond second{static_cast<float>(doseEnergy / doseSamples),
+                                        static_cast<float>(doseCutSum / doseSamples),
+                                        static_cast<float>(doseSamples) / sampleRate};
+                _doseSeconds.push(second);  // Full: the control task is behind, the second is dropped
+                doseEnergy = doseCutSum = 0.0;
+                doseSamples = 0;
+            }
+        }
+        return gain;
+    };
+
+    // Publish to the UI: one 10ms metering frame (latest value + history ring)
+    auto publishLevels = [&]() {
+        const float inv = 1.0f / (float)meterSamples;
+        levels.rmsLeft = sqrtf(meterSumL * inv);
+        levels.rmsRight = sqrtf(meterSumR * inv);
+        levels.rmsHP = sqrtf(meterSumHP * inv);
+        // Peak hold with decay
+        levels.peakLeft = std::max(meterPkL, levels.peakLeft * PEAK_DECAY);
+        levels.peakRight = std::max(meterPkR, levels.peakRight * PEAK_DECAY);
+        levels.peakHP = std::max(meterPkHP, levels.peakHP * PEAK_DECAY);
+        levels.blockIndex++;
+
+        _levelsBuffer.back() = levels;
+        _levelsBuffer.publish();
+        _levelsRing.push(levels);
+        const uint8_t taps = _levelTaps.load(std::memory_order_relaxed);
+        if (taps != 0 && levels.blockIndex % TAP_LEVEL_DECIMATION == 0) {
+            for (int t = 0; t < LEVEL_TAP_COUNT; t++) {
+                if (!(taps & (1 << t))) continue;
+                _tapLevelsBuffer[t].back() = levels;
+                _tapLevelsBuffer[t].publish();
+            }
+        }
+
+        meterSamples = 0;
+        meterSumL = meterSumR = meterSumHP = 0.0f;
+        meterPkL = meterPkR = meterPkHP = 0.0f;
+    };
 
     while (true) {
         // Check if we should stop
-        {
-            std::lock_guard<std::mutex> lock(_mutex);
-            if (!_running) break;
-
-            // Snapshot params
-            if (_paramsChanged) {
-                localParams = _params;
+        if (!_running.load(std::memory_order_acquire)) break;
+        _audioBeat.fetch_add(1, std::memory_order_relaxed);
+
+        // Pick up the latest published params (wait-free). An A/B switch is held
+        // back until the output has faded out, then taken in one go.
+        if (_paramsBuffer.update()) {
+            if (_abSwitchPending.exchange(false, std::memory_order_acquire)) abPhase = AB_FADE_OUT;
+            if (abPhase != AB_FADE_OUT) {
+                localParams = _paramsBuffer.front();
                 localParamsChanged = true;
-                _paramsChanged = false;
             }
         }
+        if (abPhase == AB_FADE_OUT && abGain <= 0.0f) {
+            localParams = _paramsBuffer.front();
+            localParamsChanged = true;
+            abPhase = AB_HOLD;
+            abHoldSamples = 0;
+        }
+
+        // Auto-degrade switched off: restore the AEC mode the user asked for
+        if (aecDegraded && !_autoDegradeEnabled.load(std::memory_order_relaxed)) {
+            aecDegraded = false;
+            localParams = _paramsBuffer.front();
+            localParamsChanged = true;
+            mclog::traceInfo(TAG, "auto-degrade off, AEC mode restored to {}", localParams.veAecMode);
+        }
+        if (aecDegraded) {
+            localParams.veAecMode = 0;  // SR_LOW_COST
+        }
+
+        if (_xrunResetRequested.exchange(false, std::memory_order_relaxed)) {
+            levels.xrun = AudioXrunStats{};
+            levels.cache.worstL2Miss = 0;
+            levels.cache.worstBlockL2Miss = 0;
+            bsp_i2s_get_xrun_counts(&xrunBase);
+        }
+
+        // Swap in a correction FIR the storage task has built; the control task frees the old one
+        void* newFir;
+        if (_firHandover.pop(newFir)) {
+            if (_fir && !_firRetired.push(_fir)) destroyFirConvolver(_fir);  // Backed up: pay here rather than leak
+            _fir = newFir;
+            mclog::traceInfo(TAG, "correction FIR installed ({} taps)", static_cast<FirConvolver*>(_fir)->taps());
+        }
+
+        // Swap in NS/AGC/VAD sets the worker has finished building
+        if (unsigned installed = installSrHandles()) {
+            if (installed & (1u << SR_AGC)) applyAgcConfig();
+            if (installed & (1u << SR_VAD)) vadHangover.reset();
+        }
 
         // Recalculate filter coefficients if params changed
         if (localParamsChanged) {
             localParamsChanged = false;
 
-            // Apply mic gain
-            codec->set_in_gain(localParams.micGain);
-
-            // Apply codec volume
-            codec->set_volume(localParams.outputVolume);
+            // Block size change: restart bus framing and metering at the new size
+            int newBlockSize = snapBlockSize(localParams.blockSize);
+            if (newBlockSize != blockSize) {
+                blockSize = newBlockSize;
+                prevBusActive = !prevBusActive;  // Forces the bus reset below (framing + history)
+                meterSamples = 0;
+                meterSumL = meterSumR = meterSumHP = 0.0f;
+                meterPkL = meterPkR = meterPkHP = 0.0f;
+                levels.latency.blockSize = blockSize;
+                probeState = PROBE_IDLE;
+                mclog::traceInfo(TAG, "block size {} ({:.1f} ms)", blockSize, blockSize * 1000.0f / sampleRate);
+            }
 
-            // Apply mute
-            codec->set_mute(localParams.outputMute);
+            if (localParams.beamMode != prevBeamMode) {
+                // Mono ↔ stereo switch: restart filter and bus history on both lanes
+                beamformer.reset();
+                _inputCascade.reset();
+                _inputCascadeR.reset();
+                prevBusActive = !prevBusActive;
+                prevBeamMode = localParams.beamMode;
+            }
 
-            // Handle NS enable/mode changes
+            // Handle NS enable/mode changes (handles arrive from the worker)
             if (localParams.nsEnabled != prevNsEnabled || localParams.nsMode != prevNsMode) {
-                if (localParams.nsEnabled) {
-                    // Recreate NS handles with new mode
-                    destroyNsHandles(_nsHandleL, _nsHandleR);
-                    createNsHandles(_nsHandleL, _nsHandleR, localParams.nsMode);
-                } else {
-                    destroyNsHandles(_nsHandleL, _nsHandleR);
-                }
+                requestSrHandles(SR_NS, localParams.nsEnabled ? localParams.nsMode : -1);
                 prevNsEnabled = localParams.nsEnabled;
                 prevNsMode = localParams.nsMode;
             }
 
-            // Handle VE enable/filter-length changes
+            // Handle VE enable/mode/filter-length changes
             if (localParams.veEnabled != prevVeEnabled ||
+                localParams.veMode != prevVeMode ||
                 localParams.veFilterLength != prevVeFilterLength) {
-                if (localParams.veEnabled) {
-                    // Destroy old and create new NLMS filters
-                    if (_nlmsL) {
-                        static_cast<NlmsFilter*>(_nlmsL)->destroy();
-                        delete static_cast<NlmsFilter*>(_nlmsL);
-                    }
-                    if (_nlmsR) {
-                        static_cast<NlmsFilter*>(_nlmsR)->destroy();
-                        delete static_cast<NlmsFilter*>(_nlmsR);
-                    }
-                    auto* nlL = new NlmsFilter();
-                    auto* nlR = new NlmsFilter();
-                    nlL->init(localParams.veFilterLength);
-                    nlR->init(localParams.veFilterLength);
-                    _nlmsL = nlL;
-                    _nlmsR = nlR;
-                    mclog::tagInfo(TAG, "NLMS filters created (taps={})", localParams.veFilterLength);
-                } else {
-                    if (_nlmsL) {
-                        static_cast<NlmsFilter*>(_nlmsL)->destroy();
-                        delete static_cast<NlmsFilter*>(_nlmsL);
-                        _nlmsL = nullptr;
-                    }
-                    if (_nlmsR) {
-                        static_cast<NlmsFilter*>(_nlmsR)->destroy();
-                        delete static_cast<NlmsFilter*>(_nlmsR);
-                        _nlmsR = nullptr;
-                    }
+                // Destroy old and create the filter for the active mode
+                destroyNlmsFilter(_nlms);
+                destroyFdafFilter(_fdaf);
+                destroySubbandFilter(_subband);
+                if (localParams.veEnabled && localParams.veMode == 0) {
+                    int taps = std::min(localParams.veFilterLength, NLMS_MAX_TAPS);
+                    auto* nlms = new StereoNlmsFilter();
+                    nlms->init(taps);
+                    _nlms = nlms;
+                    const bool warm = warmStartFilter(nlms, AdaptiveStore::KIND_VE_NLMS,
+                        adaptiveKey(AdaptiveStore::KIND_VE_NLMS, taps, localParams, _hpDetected.load(std::memory_order_relaxed)));
+                    mclog::tagInfo(TAG, "NLMS filter created (taps={}, stereo shared reference{})", taps,
+                        warm ? ", warm start" : "");
+                } else if (localParams.veEnabled && localParams.veMode == 2) {
+                    int taps = std::clamp(localParams.veFilterLength, StereoFdafFilter::BLOCK, FDAF_MAX_TAPS);
+                    auto* fdaf = new StereoFdafFilter();
+                    fdaf->init(taps);
+                    _fdaf = fdaf;
+                    const bool warm = warmStartFilter(fdaf, AdaptiveStore::KIND_VE_FDAF,
+                        adaptiveKey(AdaptiveStore::KIND_VE_FDAF, fdaf->length(), localParams,
+                                    _hpDetected.load(std::memory_order_relaxed)));
+                    mclog::tagInfo(TAG, "FDAF filter created (taps={}, {} partitions of {}{})", taps,
+                        (taps + StereoFdafFilter::BLOCK - 1) / StereoFdafFilter::BLOCK, StereoFdafFilter::BLOCK,
+                        warm ? ", warm start" : "");
+                } else if (localParams.veEnabled && localParams.veMode == 3) {
+                    int taps = std::min(localParams.veFilterLength, NLMS_MAX_TAPS);
+                    auto* subband = new StereoSubbandNlms();
+                    subband->init(taps);
+                    _subband = subband;
+                    const bool warm = warmStartFilter(subband, AdaptiveStore::KIND_VE_SUBBAND,
+                        adaptiveKey(AdaptiveStore::KIND_VE_SUBBAND, subband->length(), localParams,
+                                    _hpDetected.load(std::memory_order_relaxed)));
+                    mclog::tagInfo(TAG, "subband NLMS created (taps={}, {} bands of {}{})", taps,
+                        StereoSubbandNlms::BANDS, subband->length() / StereoSubbandNlms::HOP,
+                        warm ? ", warm start" : "");
                 }
                 prevVeEnabled = localParams.veEnabled;
+                prevVeMode = localParams.veMode;
                 prevVeFilterLength = localParams.veFilterLength;
             }
 
-            // Handle AEC enable/mode changes (when VE enabled in AEC mode)
+            // Feedback canceller: same NLMS as VE, on the 48kHz playback loopback
+            if (localParams.fbcEnabled != prevFbcEnabled || localParams.fbcFilterLength != prevFbcFilterLength) {
+                destroyNlmsFilter(_fbc);
+                if (localParams.fbcEnabled) {
+                    int taps = std::clamp(localParams.fbcFilterLength, 32, FBC_MAX_TAPS);
+                    auto* fbc = new StereoNlmsFilter();
+                    fbc->init(taps);
+                    _fbc = fbc;
+                    const bool warm = warmStartFilter(fbc, AdaptiveStore::KIND_FBC,
+                        adaptiveKey(AdaptiveStore::KIND_FBC, taps, localParams, _hpDetected.load(std::memory_order_relaxed)));
+                    mclog::tagInfo(TAG, "feedback canceller created (taps={}, {:.1f} ms path{})", taps,
+                        taps * 1000.0f / sampleRate, warm ? ", warm start" : "");
+                }
+                prevFbcEnabled = localParams.fbcEnabled;
+                prevFbcFilterLength = localParams.fbcFilterLength;
+            }
+            shifter.setShift(localParams.fbcShiftHz, sampleRate);
+
+            // Handle AEC enable/mode changes (when VE enabled in AEC mode), or the AFE's (busAfe)
             {
                 bool aecWanted = localParams.veEnabled && localParams.veMode == 1;
-                if (aecWanted != prevVeAecActive ||
-                    localParams.veAecMode != prevVeAecMode ||
-                    localParams.veAecFilterLen != prevVeAecFilterLen) {
-                    if (aecWanted) {
-                        destroyAecHandles(_aecHandleL, _aecHandleR);
-                        createAecHandles(_aecHandleL, _aecHandleR, localParams.veAecMode, localParams.veAecFilterLen);
-                        // Reset ring buffers when recreating AEC
-                        aecRingL.reset(); aecRingR.reset(); aecRingHP.reset();
-                        aecOutRingL.reset(); aecOutRingR.reset();
-                        aecOutputReady = false;
-                    } else {
-                        destroyAecHandles(_aecHandleL, _aecHandleR);
-                    }
-                    prevVeAecActive = aecWanted;
-                    prevVeAecMode = localParams.veAecMode;
-                    prevVeAecFilterLen = localParams.veAecFilterLen;
+                // The AFE takes over the bus stages as they are set; their 48kHz and quiet-path
+                // gating stays with the bus
+                const bool afeAec = localParams.veEnabled;
+                const bool afeNs = localParams.nsEnabled;
+                const bool afeAgc = localParams.agcEnabled && !localParams.agcLinked &&
+                                    !localParams.fitting.wdrcEnabled && !localParams.dynamics.mbcEnabled;
+                int aecConfig = -1;
+                if (localParams.busAfe && (afeAec || afeNs || afeAgc)) {
+                    aecConfig = packAfeConfig(afeAec, afeNs, afeAgc, localParams.veAecMode, localParams.veAecFilterLen,
+                                              localParams.agcCompressionGainDb, localParams.agcTargetLevelDbfs);
+                } else if (aecWanted) {
+                    aecConfig = packAecConfig(localParams.veAecMode, localParams.veAecFilterLen,
+                                              localParams.veAecShared);
+                }
+                if (aecConfig != prevAecConfig) {
+                    // The worker rebuilds its handles; restart the bridge so frames
+                    // from the old instance are not blended into the new stream
+                    _aecConfig.store(aecConfig, std::memory_order_release);
+                    _aecTask.notify();
+                    aecBridge.reset();
+                    prevAecConfig = aecConfig;
                 }
             }
 
@@ -1218,54 +6505,101 @@ void AudioEngine::processLoop()
                 // VAD is wanted when VE is enabled AND VAD is enabled (works with both modes)
                 bool vadWanted = localParams.veEnabled && localParams.veVadEnabled;
                 if (vadWanted != prevVeVadEnabled || localParams.veVadMode != prevVeVadMode) {
-                    if (vadWanted) {
-                        destroyVadHandle(_vadHandleRef);
-                        createVadHandle(_vadHandleRef, localParams.veVadMode);
-                    } else {
-                        destroyVadHandle(_vadHandleRef);
-                    }
+                    requestSrHandles(SR_VAD, vadWanted ? localParams.veVadMode : -1);
                     prevVeVadEnabled = vadWanted;
                     prevVeVadMode = localParams.veVadMode;
                 }
             }
 
-            // Handle AGC enable/config changes
+            // Spectral stages register with the shared frame while they are on
+            if (localParams.fitting.nfcEnabled) {
+                _nfc.configure(localParams.fitting.nfcCutoffHz, localParams.fitting.nfcRatio);
+                if (!prevNfcEnabled) _nfc.reset();
+                _wola.addClient(FrequencyCompressor::processFrame, &_nfc);
+            } else {
+                _wola.removeClient(FrequencyCompressor::processFrame, &_nfc);
+            }
+            prevNfcEnabled = localParams.fitting.nfcEnabled;
+
+            // Shared spectral transform: allocated only while a spectral stage is registered
+            if (_wola.clientCount() > 0) {
+                if (_wola.fftSize() != localParams.spectralFftSize || _wola.hop() != localParams.spectralHop ||
+                    _wola.sampleRate() != sampleRate) {
+                    if (_wola.init(localParams.spectralFftSize, localParams.spectralHop, sampleRate)) {
+                        mclog::tagInfo(TAG, "WOLA frame created (fft={}, hop={}, {} clients)",
+                            localParams.spectralFftSize, localParams.spectralHop, _wola.clientCount());
+                    } else {
+                        mclog::tagError(TAG, "WOLA init failed (fft={}, hop={})",
+                            localParams.spectralFftSize, localParams.spectralHop);
+                    }
+                }
+            } else if (_wola.isInitialized()) {
+                _wola.deinit();
+            }
+
+            // Handle AGC enable/mode changes (handles arrive from the worker);
+            // the rest of the AGC config is applied in place. The linked AGC is
+            // the engine's own and needs no handles.
+            if (localParams.agcEnabled != prevAgcEnabled || localParams.agcLinked != prevAgcLinked ||
+                localParams.agcMode != prevAgcMode) {
+                requestSrHandles(SR_AGC, localParams.agcEnabled && !localParams.agcLinked ? localParams.agcMode : -1);
+            }
             if (localParams.agcEnabled != prevAgcEnabled ||
+                localParams.agcLinked != prevAgcLinked ||
                 localParams.agcMode != prevAgcMode ||
                 localParams.agcCompressionGainDb != prevAgcCompressionGainDb ||
                 localParams.agcLimiterEnabled != prevAgcLimiterEnabled ||
                 localParams.agcTargetLevelDbfs != prevAgcTargetLevelDbfs) {
-                if (localParams.agcEnabled) {
-                    // Recreate AGC handles with new config
-                    destroyAgcHandles(_agcHandleL, _agcHandleR);
-                    createAgcHandles(_agcHandleL, _agcHandleR, localParams.agcMode);
-                    // Configure AGC parameters on each handle
-                    if (_agcHandleL) {
-                        set_agc_config(_agcHandleL,
-                            localParams.agcCompressionGainDb,
-                            localParams.agcLimiterEnabled ? 1 : 0,
-                            localParams.agcTargetLevelDbfs);
-                    }
-                    if (_agcHandleR) {
-                        set_agc_config(_agcHandleR,
-                            localParams.agcCompressionGainDb,
-                            localParams.agcLimiterEnabled ? 1 : 0,
-                            localParams.agcTargetLevelDbfs);
-                    }
-                } else {
-                    destroyAgcHandles(_agcHandleL, _agcHandleR);
-                }
+                applyAgcConfig();
                 prevAgcEnabled = localParams.agcEnabled;
+                prevAgcLinked = localParams.agcLinked;
                 prevAgcMode = localParams.agcMode;
                 prevAgcCompressionGainDb = localParams.agcCompressionGainDb;
                 prevAgcLimiterEnabled = localParams.agcLimiterEnabled;
                 prevAgcTargetLevelDbfs = localParams.agcTargetLevelDbfs;
             }
 
+            // Session start (or resume from sessionElapsedMs) / cancel
+            if (localParams.tinnitus.sessionActive != prevSessionActive) {
+                sessionSamples = (uint64_t)localParams.tinnitus.sessionElapsedMs * sampleRate / 1000;
+                sessionOff = false;
+                prevSessionActive = localParams.tinnitus.sessionActive;
+            }
+
+            // Masking noise settings changed: go live now, ask the worker for a new loop
+            if (localParams.tinnitus.noiseType != prevNoiseType ||
+                localParams.tinnitus.noiseLowCut != prevNoiseLowCut ||
+                localParams.tinnitus.noiseHighCut != prevNoiseHighCut) {
+                noiseLoopFadeOut = noiseLoopBuf;
+                noiseLoopBuf = -1;
+                _noiseLoopInUse.store(noiseLoopFadeOut >= 0 ? 1u << noiseLoopFadeOut : 0u, std::memory_order_release);
+                NoiseLoopSpec spec;
+                spec.seq = ++noiseLoopSeq;
+                spec.type = localParams.tinnitus.noiseType;
+                spec.lowCut = localParams.tinnitus.noiseLowCut;
+                spec.highCut = localParams.tinnitus.noiseHighCut;
+                if (_aecTask.isRunning() && _noiseLoopRequests.push(spec)) _aecTask.notify();
+                prevNoiseType = localParams.tinnitus.noiseType;
+                prevNoiseLowCut = localParams.tinnitus.noiseLowCut;
+                prevNoiseHighCut = localParams.tinnitus.noiseHighCut;
+            }
+
             // Recalculate all biquad coefficients
-            recalcAllCoeffs();
+            recalcAllCoeffs(localParams);
+            windHpfHz = -1.0f;  // The ears' HPF may have moved under the wind corner
+            if (localParams.windMode == 0) wind.reset();
+
+            // Parked howl notches keep their slots unless the user's notch now owns it
+            for (int i = 0; i < 6; i++) {
+                if (!autoNotches[i].active) continue;
+                if (userNotchInSlot(i)) {
+                    releaseAutoNotch(i);
+                } else {
+                    parkAutoNotch(i);
+                }
+            }
 
-            mclog::tagInfo(TAG, "params updated: micGain={:.0f} vol={} mute={} hpf={}/{:.0f}Hz lpf={}/{:.0f}Hz eq={:.1f}/{:.1f}/{:.1f}dB ns={}/mode={} ve={}/blend={:.2f} gain={:.2f}",
+            mclog::traceInfo(TAG, "params updated: micGain={:.0f} vol={} mute={} hpf={}/{:.0f}Hz lpf={}/{:.0f}Hz eq={:.1f}/{:.1f}/{:.1f}dB ns={}/mode={} ve={}/blend={:.2f} gain={:.2f}",
                 localParams.micGain, localParams.outputVolume, localParams.outputMute,
                 localParams.hpfEnabled, localParams.hpfFrequency,
                 localParams.lpfEnabled, localParams.lpfFrequency,
@@ -1275,134 +6609,552 @@ void AudioEngine::processLoop()
                 localParams.outputGain);
         }
 
-        // ── 1. Read from I2S (4-channel input) ──
-        size_t bytesRead = 0;
-        codec->i2s_read(inBuf, inBufBytes, &bytesRead, portMAX_DELAY);
+        // Head motion for this block: beam compensation here, VE step gating at 7b
+        const uint8_t motion = _motionState.load(std::memory_order_relaxed);
+        levels.motion = motion;
 
-        int samplesRead = bytesRead / (NUM_CHANNELS_IN * sizeof(int16_t));
-        if (samplesRead <= 0) continue;
+        // Beam steering: inter-mic lag in 48 kHz samples for the requested angle. Every
+        // block, not only on a params change: the tracker and motion offsets move on their own.
+        {
+            constexpr float SPEED_OF_SOUND = 343.0f;
+            const float tracked = _beamTrackDeg.load(std::memory_order_relaxed);
+            const float steerDeg = std::isnan(tracked)
+                ? std::clamp(localParams.beamSteerDeg + _motionYawDeg.load(std::memory_order_relaxed),
+                             -90.0f, 90.0f)
+                : tracked;
+            levels.beamSteerDeg = steerDeg;
+            float lag = localParams.beamMicSpacingMm * 0.001f * sinf(steerDeg * (float)M_PI / 180.0f) /
+                        SPEED_OF_SOUND * sampleRate;
+            beamformer.setSteering(lag);
+        }
 
-        // ── 2. Extract MIC-L (ch0), MIC-R (ch2), MIC-HP (ch3), convert to float [-1.0, 1.0] ──
-        constexpr float scale = 1.0f / 32768.0f;
-        for (int i = 0; i < samplesRead; i++) {
-            floatL[i]  = (float)inBuf[i * NUM_CHANNELS_IN + 0] * scale;  // MIC-L
-            floatR[i]  = (float)inBuf[i * NUM_CHANNELS_IN + 2] * scale;  // MIC-R
-            floatHP[i] = (float)inBuf[i * NUM_CHANNELS_IN + 3] * scale;  // MIC-HP
+        // Output only: pure generator sessions switch capture off (RX disabled, ES7210 powered
+        // down) and skip the hearing chain. Like a capture profile switch, the stream stops
+        // around it; coming back, capture is at the BSP defaults and re-narrowed below.
+        if (!localParams.tinnitus.outputOnly) outputOnlyRejected = false;
+        const bool outputOnlyWant = audio_stages::TINNITUS && localParams.tinnitus.outputOnly &&
+                                    probeState == PROBE_IDLE && codec->set_capture_enabled && !outputOnlyRejected;
+        bool restoreCapture = outputOnly && !outputOnlyWant;
+        if (outputOnlyWant && !outputOnly) {
+            const size_t bytes = OUTPUT_ONLY_BLOCK * NUM_CHANNELS_OUT * sizeof(int16_t);
+            outputOnlyBuf = static_cast<int16_t*>(heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+            if (!outputOnlyBuf) outputOnlyBuf = static_cast<int16_t*>(heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM));
+            if (outputOnlyBuf) {
+                if (zeroCopy) bsp_i2s_stream_stop();
+                std::lock_guard<std::mutex> codecLock(_codecMutex);
+                outputOnly = codec->set_capture_enabled(false) == ESP_OK;
+                restoreCapture = !outputOnly;
+            }
+            if (outputOnly) {
+                mclog::tagInfo(TAG, "output only: capture off, {}-frame blocks", OUTPUT_ONLY_BLOCK);
+            } else {
+                outputOnlyRejected = true;
+                mclog::tagWarn(TAG, "output only unavailable ({}), capture stays on",
+                    outputOnlyBuf ? "codec" : "no memory");
+            }
+        }
+        if (restoreCapture) {
+            {
+                std::lock_guard<std::mutex> codecLock(_codecMutex);
+                if (codec->set_capture_enabled(true) != ESP_OK) mclog::tagWarn(TAG, "capture restart failed");
+            }
+            outputOnly = false;
+            heap_caps_free(outputOnlyBuf);
+            outputOnlyBuf = nullptr;
+            capture = captureTried = {BSP_CAPTURE_SLOTS_ALL, 16};
+            layout = captureLayout(capture);
+            // The ES7210 came back with its PGA reset: have the control task rewrite it
+            _codecResync.store(true, std::memory_order_release);
+            _ctlTask.notify();
+            if (zeroCopy && bsp_i2s_stream_start() != ESP_OK) {
+                zeroCopy = false;
+                mclog::tagWarn(TAG, "I2S stream restart failed, using codec read/write");
+            }
+            rxDoneUs = txDoneUs = txNextDoneUs = 0;
+            prevReadUs = 0;
+            prevBusActive = !prevBusActive;  // Bus history is from before the gap
+            mclog::tagInfo(TAG, "output only off, capture on");
         }
 
-        // ── 3. Apply HPF ──
-        if (localParams.hpfEnabled) {
-            for (int i = 0; i < samplesRead; i++) {
-                floatL[i] = _hpfL.process(floatL[i]);
-                floatR[i] = _hpfR.process(floatR[i]);
+        // Watchdog hot restart: the I2S channels restart in place and the stream history goes,
+        // everything else (arena, params, filters, voices) carries on. A dead RX also gets the
+        // capture profile rewritten below, which resets the ES7210
+        const uint8_t restartReason = _restartRequest.exchange(AUDIO_RESTART_NONE, std::memory_order_acq_rel);
+        if (restartReason != AUDIO_RESTART_NONE) {
+            if (zeroCopy) bsp_i2s_stream_stop();
+            esp_err_t reset;
+            {
+                std::lock_guard<std::mutex> codecLock(_codecMutex);
+                reset = bsp_i2s_reset();
             }
+            if (restartReason != AUDIO_RESTART_HEALTH && !outputOnly) captureTried = {0, 0};
+            _codecResync.store(true, std::memory_order_release);
+            _ctlTask.notify();
+            if (zeroCopy && bsp_i2s_stream_start() != ESP_OK) {
+                zeroCopy = false;
+                mclog::traceWarn(TAG, "I2S stream restart failed, using codec read/write");
+            }
+            rxDoneUs = txDoneUs = txNextDoneUs = 0;
+            prevReadUs = 0;
+            prevBusActive = !prevBusActive;
+            aecBridge.reset();
+            emptyReads = healthResets = healthWindowSamples = 0;
+            if (recoverySinceUs == 0) {
+                recoverySinceUs = lastGoodReadUs ? lastGoodReadUs : esp_timer_get_time();
+            } else {
+                failedRestarts++;
+            }
+            levels.health.hotRestarts++;
+            levels.health.restartReason = restartReason;
+            mclog::traceWarn(TAG, "watchdog: hot restart #{} ({}){}", levels.health.hotRestarts,
+                kRestartReasonNames[restartReason], reset == ESP_OK ? "" : ", I2S reset failed");
         }
 
-        // ── 4. Apply LPF ──
-        if (localParams.lpfEnabled) {
-            for (int i = 0; i < samplesRead; i++) {
-                floatL[i] = _lpfL.process(floatL[i]);
-                floatR[i] = _lpfR.process(floatR[i]);
+        if (outputOnly) {
+#if CONFIG_PM_ENABLE
+            if (dspPmLock && !dspPmHeld) {
+                esp_pm_lock_acquire(dspPmLock);
+                dspPmHeld = true;
+            }
+#endif
+            AudioRecorder& recorder = AudioRecorder::getInstance();
+            UsbAudio& usbAudio = UsbAudio::getInstance();
+            const bool recordOut = nominalTaps && recorder.wants(AudioRecorder::SOURCE_OUTPUT);
+            const bool usbOut = nominalTaps && usbAudio.wants(UsbAudio::SOURCE_OUTPUT);
+            RtpStream& rtp = RtpStream::getInstance();
+            const bool rtpOut = nominalTaps && rtp.wants();
+            const bool mute = localParams.outputMute || sessionOff;
+            const float gainL = localParams.outputGain;
+            const float gainR = localParams.earsLinked ? gainL : localParams.rightEar.outputGain;
+            auto kernel = localParams.boostEnabled
+                ? (mute ? outputKernel<true, false> : outputKernel<true, true>)
+                : (mute ? outputKernel<false, false> : outputKernel<false, true>);
+
+            // Stages 8b-12 on silence, BLOCK_SIZE at a time into the one large buffer
+            for (int off = 0; off < OUTPUT_ONLY_BLOCK; off += BLOCK_SIZE) {
+                const int count = std::min(BLOCK_SIZE, OUTPUT_ONLY_BLOCK - off);
+                memset(floatL, 0, count * sizeof(float));
+                memset(floatR, 0, count * sizeof(float));
+                tinnitusGenerators(count);
+                abSwitchDip(count);
+                _mixer.mix(floatL, floatR, count, sampleRate);
+                float gain = gainL;
+                if (gainR != gainL) {
+                    for (int i = 0; i < count; i++) {
+                        floatL[i] *= gainL;
+                        floatR[i] *= gainR;
+                    }
+                    gain = 1.0f;
+                }
+                gain = finalGain(count, gain, mute);
+                int16_t* dst = outputOnlyBuf + off * NUM_CHANNELS_OUT;
+                kernel(floatL, floatR, dst, count, gain, meterSumL, meterSumR, meterPkL, meterPkR);
+                if (mute) memset(dst, 0, count * NUM_CHANNELS_OUT * sizeof(int16_t));
+                if (recordOut) recorder.push(AudioRecorder::SOURCE_OUTPUT, dst, count);
+                if (usbOut) usbAudio.push(dst, count);
+                if (rtpOut) rtp.push(dst, count);
+                meterSamples += count;
+                if (meterSamples >= meterFrame) {
+                    levels.outputOnly = true;
+                    levels.latency.estimateMs = (OUTPUT_ONLY_BLOCK + BSP_I2S_DMA_DESC_NUM * BSP_I2S_DMA_FRAME_NUM) *
+                                                1000.0f / sampleRate;
+                    publishLevels();
+                }
+            }
+
+            // One write for the whole block: the task sleeps in the driver while the DMA drains
+#if CONFIG_PM_ENABLE
+            if (dspPmHeld) {
+                esp_pm_lock_release(dspPmLock);
+                dspPmHeld = false;
+            }
+#endif
+            size_t bytesWritten = 0;
+            codec->i2s_write(outputOnlyBuf, OUTPUT_ONLY_BLOCK * NUM_CHANNELS_OUT * sizeof(int16_t),
+                             &bytesWritten, portMAX_DELAY);
+            samplesOut += OUTPUT_ONLY_BLOCK;
+
+            bsp_i2s_xrun_counts_t xrunNow;
+            bsp_i2s_get_xrun_counts(&xrunNow);
+            levels.xrun.txUnderruns = xrunNow.tx_overflows - xrunBase.tx_overflows;
+            continue;
+        }
+        levels.outputOnly = false;
+
+        // Capture profile: MIC-L/R always, the loopback for the feedback canceller and the
+        // latency test, the HP mic for voice exclusion and the acoustic latency test. The RX
+        // DMA buffers are reallocated, so the stream restarts around the switch and the TX
+        // lead re-primes.
+        if (codec->set_capture_profile) {
+            bsp_capture_profile_t want = {0x05, static_cast<uint8_t>(localParams.captureBits > 16 ? 24 : 16)};
+            const bool probing = probeState != PROBE_IDLE;
+            const bool probeHp = probeSource == AudioLatencyInfo::SOURCE_HP_MIC;
+            if (localParams.fbcEnabled || (probing && !probeHp)) want.slot_mask |= 0x02;
+            if (localParams.veEnabled || (probing && probeHp)) want.slot_mask |= 0x08;
+            if (want.slot_mask != captureTried.slot_mask || want.bits != captureTried.bits) {
+                captureTried = want;
+                if (zeroCopy) bsp_i2s_stream_stop();
+                std::unique_lock<std::mutex> codecLock(_codecMutex);
+                if (codec->set_capture_profile(&want) == ESP_OK) {
+                    capture = want;
+                    layout = captureLayout(capture);
+                    // The ES7210 reset drops the PGA; put back what the control task last set
+                    const float pga = _micPgaApplied.load(std::memory_order_acquire);
+                    if (!std::isnan(pga)) codec->set_in_gain(pga);
+                    mclog::tagInfo(TAG, "capture: slots 0x{:x}, {}-bit ({} B/frame)",
+                        capture.slot_mask, capture.bits, layout.frameBytes());
+                } else {
+                    mclog::tagWarn(TAG, "capture profile 0x{:x}/{}-bit rejected, keeping 0x{:x}/{}-bit",
+                        want.slot_mask, want.bits, capture.slot_mask, capture.bits);
+                }
+                codecLock.unlock();
+                if (zeroCopy && bsp_i2s_stream_start() != ESP_OK) {
+                    zeroCopy = false;
+                    mclog::tagWarn(TAG, "I2S stream restart failed, using codec read/write");
+                }
+                txNextDoneUs = 0;
             }
         }
 
-        // ── 5. Apply 3-band EQ ──
-        for (int i = 0; i < samplesRead; i++) {
-            floatL[i] = _eqLowL.process(floatL[i]);
-            floatR[i] = _eqLowR.process(floatR[i]);
+        // Stage profiler: lap() charges the cycles since the previous lap to a stage
+        const bool profiling = _profilingEnabled.load(std::memory_order_relaxed);
+        const bool spectrumOn = _spectrumEnabled.load(std::memory_order_acquire) && _specCapture;
+        StageCycles stageCycles = {};
+        uint32_t lapMark = profiling ? esp_cpu_get_cycle_count() : 0;
+        uint32_t dspMark = 0;
+        auto lap = [&](AudioStage stage) {
+            if (!profiling) return;
+            uint32_t now = esp_cpu_get_cycle_count();
+            stageCycles.cycles[stage] += now - lapMark;
+            lapMark = now;
+        };
+        // Health test after an adaptive stage: false means it diverged, the block is
+        // silenced and the caller resets that stage only
+        auto healthy = [&](AudioHealthStage stage, float* l, float* r, int count) {
+            if (blockHealthy(l, r, count)) return true;
+            memset(l, 0, count * sizeof(float));
+            if (r) memset(r, 0, count * sizeof(float));
+            levels.health.resets[stage]++;
+            healthResets++;
+            mclog::traceWarn(TAG, "health: {} diverged, state reset", kHealthStageNames[stage]);
+            return false;
+        };
+
+        // ── 1. Read from I2S (4-channel input) ──
+#if CONFIG_PM_ENABLE
+        if (dspPmHeld) {
+            esp_pm_lock_release(dspPmLock);
+            dspPmHeld = false;
         }
-        for (int i = 0; i < samplesRead; i++) {
-            floatL[i] = _eqMidL.process(floatL[i]);
-            floatR[i] = _eqMidR.process(floatR[i]);
+#endif
+        // Zero-copy: collect the block's RX DMA buffers, converted in place in stage 2
+        int samplesRead = 0;
+        int rxCount = 0;
+        if (zeroCopy) {
+            const int want = blockSize / BSP_I2S_DMA_FRAME_NUM;
+            bsp_i2s_stream_buf_t rx;
+            while (rxCount < want && bsp_i2s_stream_rx_acquire(&rx, RX_STALL_MS)) {
+                if (rxCount == 0) samplesIn += missedFrames(rxDoneUs, rx.done_us);
+                rxBufs[rxCount++] = rx.data;
+                rxDoneUs = rx.done_us;
+                levels.xrun.rxBacklog = rx.pending;
+            }
+            samplesRead = rxCount * BSP_I2S_DMA_FRAME_NUM;
+        } else {
+            size_t bytesRead = 0;
+            codec->i2s_read(inBuf, blockSize * layout.frameBytes(), &bytesRead, RX_STALL_MS);
+            samplesRead = bytesRead / layout.frameBytes();
         }
-        for (int i = 0; i < samplesRead; i++) {
-            floatL[i] = _eqHighL.process(floatL[i]);
-            floatR[i] = _eqHighR.process(floatR[i]);
+        // Nothing within RX_STALL_MS, twice: the RX side is dead. Restarts that don't bring it
+        // back are spaced out, doubling the wait each time
+        if (samplesRead <= 0) {
+            if (++emptyReads >= RX_STALL_READS << std::min(failedRestarts, 6)) {
+                uint8_t none = AUDIO_RESTART_NONE;
+                _restartRequest.compare_exchange_strong(none, AUDIO_RESTART_READ_STALL, std::memory_order_acq_rel);
+                emptyReads = 0;
+            }
+            continue;
+        }
+        emptyReads = 0;
+#if CONFIG_PM_ENABLE
+        if (dspPmLock) {
+            esp_pm_lock_acquire(dspPmLock);
+            dspPmHeld = true;
+        }
+#endif
+        lap(AUDIO_STAGE_READ);
+        dspMark = lapMark;
+
+        // Read-to-read period: a long gap means the loop stalled and input was lost
+        const int64_t readDoneUs = esp_timer_get_time();
+        if (levels.cache.available) bsp_cache_counters_read(cacheCore, &cacheMark);
+        const uint32_t blockPeriodUs = static_cast<uint32_t>(1000000ull * samplesRead / sampleRate);
+        if (prevReadUs != 0) {
+            uint32_t periodUs = static_cast<uint32_t>(readDoneUs - prevReadUs);
+            levels.xrun.worstPeriodUs = std::max(levels.xrun.worstPeriodUs, periodUs);
+            if (periodUs > blockPeriodUs * 3 / 2) levels.xrun.lateReads++;
+        }
+        prevReadUs = readDoneUs;
+        if (recoverySinceUs != 0) {
+            levels.health.recoveryUs = static_cast<uint32_t>(readDoneUs - recoverySinceUs);
+            mclog::traceInfo(TAG, "watchdog: audio back after {}us", levels.health.recoveryUs);
+            recoverySinceUs = 0;
+            failedRestarts = 0;
+        }
+        lastGoodReadUs = readDoneUs;
+
+        // ── 2. Extract MIC-L (ch0), loopback (ch1), MIC-R (ch2), MIC-HP (ch3), convert to float [-1.0, 1.0] ──
+        if (zeroCopy) {
+            for (int b = 0; b < rxCount; b++) {
+                const int off = b * BSP_I2S_DMA_FRAME_NUM;
+                deinterleaveInput(rxBufs[b], BSP_I2S_DMA_FRAME_NUM, layout,
+                    floatL + off, floatRef + off, floatR + off, floatHP + off);
+            }
+        } else {
+            deinterleaveInput(inBuf, samplesRead, layout, floatL, floatRef, floatR, floatHP);
         }
 
-        // ── 5b. Tinnitus Relief: Notch Filters (6 configurable) ──
-        for (int n = 0; n < 6; n++) {
-            if (localParams.tinnitus.notches[n].enabled) {
+        // Until the PGA catches up with a gain change, make up the difference digitally.
+        // Ramped over the block (~20ms time constant) so slider drags don't zipper.
+        {
+            const float pga = _micPgaApplied.load(std::memory_order_acquire);
+            float trimDb = 0.0f;
+            if (!std::isnan(pga)) {
+                trimDb = std::clamp(localParams.micGain, 0.0f, PGA_MAX_DB) - std::clamp(pga, 0.0f, PGA_MAX_DB);
+            }
+            const float target = powf(10.0f, trimDb / 20.0f);
+            if (target != micTrim || micTrim != 1.0f) {
+                const float alpha = 1.0f - expf(-static_cast<float>(samplesRead) / (0.020f * sampleRate));
+                const float next = std::fabs(target - micTrim) < 1e-4f ? target : micTrim + alpha * (target - micTrim);
+                const float step = (next - micTrim) / samplesRead;
+                float g = micTrim;
                 for (int i = 0; i < samplesRead; i++) {
-                    floatL[i] = _notchL[n].process(floatL[i]);
-                    floatR[i] = _notchR[n].process(floatR[i]);
+                    g += step;
+                    floatL[i] *= g;
+                    floatRef[i] *= g;
+                    floatR[i] *= g;
+                    floatHP[i] *= g;
                 }
+                micTrim = next;
             }
         }
 
-        // ── 5c. Tinnitus Relief: High-Frequency Extension (shelf boost) ──
-        if (localParams.tinnitus.hfExtEnabled) {
-            for (int i = 0; i < samplesRead; i++) {
-                floatL[i] = _hfExtL.process(floatL[i]);
-                floatR[i] = _hfExtR.process(floatR[i]);
+        // Spectrum analyzer: start a frame once the interval is up and the last one was taken
+        int specTake = 0;
+        if (spectrumOn) {
+            specWait -= samplesRead;
+            if (specPos < 0 && specWait <= 0 && !_specCaptureReady.load(std::memory_order_acquire)) {
+                specPos = 0;
+                specWait = SPEC_INTERVAL;
+            }
+            if (specPos >= 0) {
+                specTake = std::min(samplesRead, SPEC_FFT - specPos);
+                float* dst = _specCapture + specPos;
+                for (int i = 0; i < specTake; i++) dst[i] = 0.5f * (floatL[i] + floatR[i]);
             }
+        } else {
+            specPos = -1;
         }
 
-        // ── 5d. Tinnitus Relief: Add Masking Noise ──
-        if (localParams.tinnitus.noiseType > 0) {
-            float noiseLevel = localParams.tinnitus.noiseLevel;
+        // Latency test: capture the burst's return, then collect the control task's lag
+        if (probeState == PROBE_RUNNING) {
+            const float* lane = probeSource == AudioLatencyInfo::SOURCE_HP_MIC ? floatHP : floatRef;
+            const int64_t base = static_cast<int64_t>(samplesIn) - static_cast<int64_t>(probeOutIndex);
             for (int i = 0; i < samplesRead; i++) {
-                // XORshift PRNG for white noise
-                _noiseState ^= _noiseState << 13;
-                _noiseState ^= _noiseState >> 17;
-                _noiseState ^= _noiseState << 5;
-                float white = ((float)((int32_t)_noiseState) / 2147483648.0f);  // [-1, 1]
-
-                float noise = white;
-                if (localParams.tinnitus.noiseType == 2) {
-                    // Pink noise: simple IIR filter (Voss-McCartney approximation)
-                    static float pinkState = 0.0f;
-                    pinkState = 0.99765f * pinkState + white * 0.0990460f;
-                    noise = pinkState + white * 0.2f;
-                } else if (localParams.tinnitus.noiseType == 3) {
-                    // Brown noise: leaky integrator
-                    static float brownState = 0.0f;
-                    brownState = 0.998f * brownState + white * 0.02f;
-                    noise = brownState;
+                const int64_t pos = base + i;
+                if (pos >= 0 && pos < LAT_CAPTURE_LEN) _latCapture[pos] = lane[i];
+            }
+            if (base + samplesRead >= LAT_CAPTURE_LEN) {
+                probeState = PROBE_ANALYSING;
+                _latCaptureReady.store(true, std::memory_order_release);
+                _ctlTask.notify();
+            }
+        } else if (probeState == PROBE_ANALYSING && !_latCaptureReady.load(std::memory_order_acquire)) {
+            const int32_t lagQ8 = _latLagQ8.load(std::memory_order_relaxed);
+            probeRun++;
+            if (lagQ8 >= 0) {
+                const float ratio = _latPeakRatio.load(std::memory_order_relaxed);
+                probeWorstRatio = probeValid ? std::min(probeWorstRatio, ratio) : ratio;
+                probeMs[probeValid++] = (lagQ8 / 256.0f + probeBusDelay) * 1000.0f / sampleRate;
+            }
+            levels.latency.runsDone = probeRun;
+            levels.latency.runsValid = probeValid;
+            probeState = PROBE_ARMED;
+            if (probeRun >= AudioLatencyInfo::RUNS) {
+                probeState = PROBE_IDLE;
+                levels.latency.lastFailed = probeValid == 0;
+                if (probeValid > 0) {
+                    float sum = 0.0f, lo = probeMs[0], hi = probeMs[0];
+                    for (int r = 0; r < probeValid; r++) {
+                        sum += probeMs[r];
+                        lo = std::min(lo, probeMs[r]);
+                        hi = std::max(hi, probeMs[r]);
+                    }
+                    const float mean = sum / probeValid;
+                    float var = 0.0f;
+                    for (int r = 0; r < probeValid; r++) var += (probeMs[r] - mean) * (probeMs[r] - mean);
+                    const float jitter = sqrtf(var / probeValid);
+                    const int mode = blockSizeIndex(blockSize);
+                    levels.latency.measuredMs[mode] = mean;
+                    levels.latency.jitterMs[mode] = jitter;
+                    levels.latency.spreadMs = hi - lo;
+                    levels.latency.peakRatioDb = 20.0f * log10f(probeWorstRatio);
+                    mclog::traceInfo(TAG, "latency test ({}): {:.2f} ms, jitter {:.3f} ms, spread {:.3f} ms, {}/{} runs @ block {}",
+                        probeSource == AudioLatencyInfo::SOURCE_HP_MIC ? "hp mic" : "loopback",
+                        mean, jitter, hi - lo, probeValid, probeRun, blockSize);
+                } else {
+                    mclog::traceWarn(TAG, "latency test: no correlation peak in {} runs (best {:.1f} dB)",
+                        probeRun, 20.0f * log10f(std::max(_latPeakRatio.load(std::memory_order_relaxed), 1e-3f)));
                 }
-
-                // Band-limit the noise
-                noise = _noiseHpfL.process(noise);
-                noise = _noiseLpfL.process(noise);
-
-                // Mix into output
-                floatL[i] += noise * noiseLevel;
-                floatR[i] += noise * noiseLevel;
+            }
+        }
+        samplesIn += samplesRead;
+
+        // Raw 4-ch capture for the recorder, in slot order, before any DSP touches it
+        AudioRecorder& recorder = AudioRecorder::getInstance();
+        if (nominalTaps && recorder.wants(AudioRecorder::SOURCE_INPUT)) {
+            int16_t raw[BSP_I2S_DMA_FRAME_NUM * NUM_CHANNELS_IN];
+            const float* lanes[NUM_CHANNELS_IN] = {floatL, floatRef, floatR, floatHP};
+            for (int off = 0; off < samplesRead; off += BSP_I2S_DMA_FRAME_NUM) {
+                const int n = std::min(BSP_I2S_DMA_FRAME_NUM, samplesRead - off);
+                for (int i = 0; i < n; i++) {
+                    for (int c = 0; c < NUM_CHANNELS_IN; c++) {
+                        raw[i * NUM_CHANNELS_IN + c] =
+                            static_cast<int16_t>(std::clamp(lanes[c][off + i], -1.0f, 1.0f) * 32767.0f);
+                    }
+                }
+                recorder.push(AudioRecorder::SOURCE_INPUT, raw, n);
+            }
+        }
+        UsbAudio& usbAudio = UsbAudio::getInstance();
+        if (nominalTaps && usbAudio.wants(UsbAudio::SOURCE_MICS)) {
+            int16_t mics[BSP_I2S_DMA_FRAME_NUM * 2];
+            for (int off = 0; off < samplesRead; off += BSP_I2S_DMA_FRAME_NUM) {
+                const int n = std::min(BSP_I2S_DMA_FRAME_NUM, samplesRead - off);
+                for (int i = 0; i < n; i++) {
+                    mics[2 * i] = static_cast<int16_t>(std::clamp(floatL[off + i], -1.0f, 1.0f) * 32767.0f);
+                    mics[2 * i + 1] = static_cast<int16_t>(std::clamp(floatR[off + i], -1.0f, 1.0f) * 32767.0f);
+                }
+                usbAudio.push(mics, n);
+            }
+        }
+        lap(AUDIO_STAGE_CONVERT_IN);
+
+        // ── 1b. Input activity: after quietHoldMs under quietThresholdDb the chain
+        // takes its quiet path (input filters and bus stages asleep, state kept),
+        // and the first block back over the threshold runs the full chain again ──
+        const bool quietPath = localParams.quietPathEnabled && !sessionOff &&
+            activity.update(blockPower(floatL, floatR, samplesRead),
+                            powf(10.0f, localParams.quietThresholdDb / 10.0f), samplesRead,
+                            localParams.quietHoldMs * (sampleRate / 1000));
+        levels.quietPath = quietPath;
+
+        // ── 1c. Scene frames: mid-channel power, low band and first difference summed
+        // over SCENE_FRAME_MS for the classifier on the control task ──
+        if (localParams.sceneAuto && !sessionOff) {
+            float p = 0.0f, pl = 0.0f, ph = 0.0f;
+            for (int i = 0; i < samplesRead; i++) {
+                const float x = 0.5f * (floatL[i] + floatR[i]);
+                sceneLow += SCENE_LOWPASS * (x - sceneLow);
+                const float d = x - scenePrev;
+                scenePrev = x;
+                p += x * x;
+                pl += sceneLow * sceneLow;
+                ph += d * d;
+            }
+            sceneFrame.power += p;
+            sceneFrame.lowPower += pl;
+            sceneFrame.highPower += ph;
+            if ((sceneSamples += samplesRead) >= SCENE_FRAME_SAMPLES) {
+                const float inv = 1.0f / sceneSamples;
+                sceneFrame.power *= inv;
+                sceneFrame.lowPower *= inv;
+                sceneFrame.highPower *= inv;
+                _sceneFrames.push(sceneFrame);  // Full: the control task is behind, the frame is dropped
+                sceneFrame = SceneFrame{};
+                sceneSamples = 0;
             }
         }
 
-        // ── 5e. Tinnitus Relief: Tone Finder (pure tone generator) ──
-        if (localParams.tinnitus.toneFinderEnabled) {
-            float freq = localParams.tinnitus.toneFinderFreq;
-            float level = localParams.tinnitus.toneFinderLevel;
-            float phaseInc = 2.0f * M_PI * freq / (float)SAMPLE_RATE;
+        // ── 2a. Feedback canceller: subtract the modelled speaker → mic path from both mics ──
+        // The AEC loopback (ch1) is the DAC output, sample-aligned with the mics
+        const bool fbcActive = localParams.fbcEnabled && _fbc && !sessionOff;
+        if (fbcActive) {
+            auto* fbc = static_cast<StereoNlmsFilter*>(_fbc);
+            const float mu = localParams.fbcStepSize;
             for (int i = 0; i < samplesRead; i++) {
-                float tone = sinf(_tonePhase) * level;
-                _tonePhase += phaseInc;
-                if (_tonePhase >= 2.0f * M_PI) _tonePhase -= 2.0f * M_PI;
-                floatL[i] += tone;
-                floatR[i] += tone;
+                float estL, estR;
+                fbc->process(floatRef[i], floatL[i], floatR[i], mu, estL, estR);
+                floatL[i] -= estL;
+                floatR[i] -= estR;
             }
+            if (!healthy(AUDIO_HEALTH_FEEDBACK, floatL, floatR, samplesRead)) fbc->reset();
+            lap(AUDIO_STAGE_FEEDBACK);
         }
 
-        // ── 5f. Tinnitus Relief: Binaural Beats ──
-        if (localParams.tinnitus.binauralEnabled) {
-            float carrier = localParams.tinnitus.binauralCarrier;
-            float beat = localParams.tinnitus.binauralBeat;
-            float level = localParams.tinnitus.binauralLevel;
-            float phaseIncL = 2.0f * M_PI * carrier / (float)SAMPLE_RATE;
-            float phaseIncR = 2.0f * M_PI * (carrier + beat) / (float)SAMPLE_RATE;
+        // ── 2a'. Wind / handling noise: the low-band coherence raises the input HPF
+        // corner (same pair for both channels, run in 3) and in mode 2 moves both
+        // channels onto the calmer mic, ahead of the beamformer ──
+        float windTargetHz = 0.0f;
+        float windMixTarget = 0.0f;
+        if (localParams.windMode > 0 && !sessionOff) {
+            wind.update(floatL, floatR, samplesRead, sampleRate);
+            // Sixteenths of the wind amount, so the cascades glide between a handful of corners
+            const float steps = roundf(wind.amount * 16.0f) / 16.0f;
+            if (steps > 0.0f) windTargetHz = WIND_HPF_BASE * powf(localParams.windHpfMaxHz / WIND_HPF_BASE, steps);
+            if (localParams.windMode == 2) windMixTarget = static_cast<float>(wind.calmMic);
+        }
+        if (windTargetHz != windHpfHz) {
+            // Each ear keeps the higher of its own corner and the wind's; 0 hands it back
+            auto applyWindHpf = [&](BiquadCascade& cascade, const EarParams& e) {
+                const float fc = std::max(e.hpfEnabled ? e.hpfFrequency : 0.0f, windTargetHz);
+                Biquad bq;
+                calcHpfCoeffs(bq, fc > 0.0f ? fc : e.hpfFrequency, sampleRate);
+                cascade.setSection(SLOT_HPF, bq, fc > 0.0f);
+            };
+            applyWindHpf(_inputCascade, localParams.ear(AUDIO_EAR_LEFT));
+            if (_earsSplit) applyWindHpf(_inputCascadeR, localParams.ear(AUDIO_EAR_RIGHT));
+            windHpfHz = windTargetHz;
+        }
+        if (windMixTarget != 0.0f || windMix != 0.0f) {
             for (int i = 0; i < samplesRead; i++) {
-                floatL[i] += sinf(_binauralPhaseL) * level;
-                floatR[i] += sinf(_binauralPhaseR) * level;
-                _binauralPhaseL += phaseIncL;
-                _binauralPhaseR += phaseIncR;
-                if (_binauralPhaseL >= 2.0f * M_PI) _binauralPhaseL -= 2.0f * M_PI;
-                if (_binauralPhaseR >= 2.0f * M_PI) _binauralPhaseR -= 2.0f * M_PI;
+                windMix += std::clamp(windMixTarget - windMix, -WIND_MIX_STEP, WIND_MIX_STEP);
+                if (windMix > 0.0f) {
+                    floatL[i] += windMix * (floatR[i] - floatL[i]);
+                } else {
+                    floatR[i] -= windMix * (floatL[i] - floatR[i]);
+                }
             }
         }
+        levels.windLevel = localParams.windMode > 0 ? wind.amount : 0.0f;
+        levels.windMic = static_cast<int8_t>(windMixTarget);
+
+        // ── 2b. Beamformer: MIC-L + MIC-R → one steered channel in floatL ──
+        // The chain runs mono from here on and is duplicated to both outputs after the bus
+        const bool mono = localParams.beamMode > 0;
+        if (mono) {
+            beamformer.process(floatL, floatR, floatL, samplesRead, localParams.beamMode == 2, 0.05f);
+            if (!healthy(AUDIO_HEALTH_BEAM, floatL, nullptr, samplesRead)) beamformer.reset();
+            lap(AUDIO_STAGE_BEAM);
+        }
+
+        // ── 3. Input filters: HPF → LPF → 3-band EQ (one cascade pass) ──
+        // Unlinked ears run their own cascades; the mono chain has only the left ear's
+        if (quietPath) {
+            // Nothing to shape; the cascades pick up from their last state
+        } else if (_earsSplit && !mono) {
+            _inputCascade.process(floatL, nullptr, samplesRead);
+            _inputCascadeR.process(floatR, nullptr, samplesRead);
+        } else {
+            _inputCascade.process(floatL, mono ? nullptr : floatR, samplesRead);
+        }
+        if (!quietPath && !healthy(AUDIO_HEALTH_INPUT_FILTERS, floatL, mono ? nullptr : floatR, samplesRead)) {
+            _inputCascade.reset();
+            _inputCascadeR.reset();
+        }
+        lap(AUDIO_STAGE_INPUT_FILTERS);
 
-        // ── 6. Reference signal conditioning (applied to HP mic before VE) ──
+        // ── 4. Reference signal conditioning (applied to HP mic before VE) ──
         // Apply gain, HPF, LPF to the reference signal so NLMS sees clean voice
         {
             float refGain = localParams.veRefGain;
@@ -1418,371 +7170,722 @@ void AudioEngine::processLoop()
             }
         }
 
-        // ── 6b. HP mic level metering ──
-        {
-            float sumHP = 0.0f, pkHP = 0.0f;
-            for (int i = 0; i < samplesRead; i++) {
-                float absHP = fabsf(floatHP[i]);
-                sumHP += floatHP[i] * floatHP[i];
-                if (absHP > pkHP) pkHP = absHP;
-            }
-            std::lock_guard<std::mutex> lock(_mutex);
-            _levels.rmsHP = sqrtf(sumHP / (float)samplesRead);
-            _levels.peakHP = std::max(pkHP, _levels.peakHP * PEAK_DECAY);
+        // ── 5. HP mic level metering (accumulated over the 10ms metering frame) ──
+        for (int i = 0; i < samplesRead; i++) {
+            float absHP = fabsf(floatHP[i]);
+            meterSumHP += floatHP[i] * floatHP[i];
+            if (absHP > meterPkHP) meterPkHP = absHP;
         }
 
-        // ── 7. Voice Exclusion (NLMS or AEC @ 16kHz, uses conditioned HP mic as ref) ──
-        // Poll headphone detect periodically (not every sample)
-        if (++hpDetectCounter >= HP_DETECT_INTERVAL) {
-            hpDetectCounter = 0;
-            hpDetected = bsp_headphone_detect();
+        // ── 5b. Own voice: conditioned HP mic against the room mics (after the input
+        // filters), plus the reference VAD's last word. Shared by the NLMS step gate (7b),
+        // the linked AGC (7e'') and the output duck (8h) ──
+        // Jack state from the detect task (no I2C on this core)
+        const bool hpDetected = _hpDetected.load(std::memory_order_acquire);
+        const bool ownVoiceActive = hpDetected && !sessionOff &&
+            ownVoice.update(blockPower(floatHP, floatHP, samplesRead),
+                            blockPower(floatL, mono ? floatL : floatR, samplesRead),
+                            powf(10.0f, localParams.ownVoiceRatioDb / 10.0f), samplesRead);
+        levels.ownVoice = ownVoiceActive;
+        lap(AUDIO_STAGE_REF_METER);
+
+        // ── 7. 16kHz analysis bus (downsample once → VE → NS → AGC → upsample once) ──
+
+        // busAfe: one AFE on the worker is the whole bus, the separate stages stand down
+        const bool afeMode = audio_stages::AFE && prevAecConfig >= 0 && (prevAecConfig & AFE_CONFIG);
+        bool afeActive    = afeMode && !sessionOff && _aecReady.load(std::memory_order_acquire);
+        bool veNlmsActive = !afeMode && localParams.veEnabled && hpDetected && !sessionOff &&
+                            ((localParams.veMode == 0 && _nlms) || (localParams.veMode == 2 && _fdaf) ||
+                             (localParams.veMode == 3 && _subband));
+        bool veAecActive  = audio_stages::AEC && !afeMode && localParams.veEnabled && hpDetected &&
+                            localParams.veMode == 1 && !sessionOff && _aecReady.load(std::memory_order_acquire);
+        bool nsActive     = audio_stages::NS && !afeMode && localParams.nsEnabled && _nsHandleL && _nsHandleR &&
+                            !sessionOff;
+        const bool bridgeActive = veAecActive || afeActive;
+        if (bridgeActive != prevAecRunning) {
+            // Don't resume from stale history after a headphone or mode change
+            aecBridge.reset();
+            prevAecRunning = bridgeActive;
+        }
+        bool wdrcActive   = localParams.fitting.wdrcEnabled && !sessionOff;
+        bool mbcActive    = localParams.dynamics.mbcEnabled && !sessionOff;
+        const bool agcWanted = localParams.agcEnabled && !sessionOff && !mbcActive && !wdrcActive;
+        bool agcLinkedActive = agcWanted && localParams.agcLinked;  // 48kHz, off the bus (7e'')
+        bool agcActive    = audio_stages::AGC && !afeMode && agcWanted && !localParams.agcLinked &&
+                            _agcHandleL && _agcHandleR;
+        bool busActive    = (veNlmsActive || bridgeActive || nsActive || agcActive) && samplesRead == blockSize;
+        // Resolved to 0 or 2 in publishParams (AudioCostModel::splitEars)
+        const bool earSplit = localParams.earSplit == 2 && _earTask.isRunning();
+        const int chunk16k = samplesRead / busRatio;
+        // Output FIFO priming: at 32kHz the chunks don't tile the frame, and some blocks complete two
+        const int busPrime16k = NS_FRAME_16K - std::gcd(chunk16k, NS_FRAME_16K);
+        // Subband VE delays the bus signal by its filterbank
+        const int veDelay16k = (busActive && veNlmsActive && localParams.veMode == 3) ? StereoSubbandNlms::LATENCY : 0;
+        // The frame bridge's constant delay, and with busAfe the AFE's own on top
+        const int bridgeDelay16k = !(busActive && bridgeActive) ? 0
+            : AecFrameBridge::LATENCY + (afeActive ? _afeLag16k.load(std::memory_order_relaxed) : 0);
+
+        if (busActive != prevBusActive) {
+            // Drop stale history so re-entering the bus doesn't replay old audio
+            busDownL.init(true, busRatio); busDownR.init(true, busRatio); busDownHP.init(true, busRatio);
+            busUpL.init(false, busRatio); busUpR.init(false, busRatio);
+            busFill = 0;
+            busOutL.reset(busPrime16k);
+            busOutR.reset(busPrime16k);
+            nsLinkGain = 1.0f;
+            busGain = 1.0f;
+            prevBusActive = busActive;
+        }
+        const bool bandSplitActive = busActive && localParams.busBandSplit;
+        if (bandSplitActive && (!prevBandSplit || veDelay16k != prevVeDelay16k)) {
+            // In step with the bus output FIFO's delay, whenever the split (re)joins it
+            bandSplit[0].reset(busPrime16k + veDelay16k, busRatio);
+            bandSplit[1].reset(busPrime16k + veDelay16k, busRatio);
+        }
+        prevBandSplit = bandSplitActive;
+        prevVeDelay16k = veDelay16k;
+
+        // Bus telemetry holds its last frame value while the stage stays active
+        if (!busActive || !nsActive) levels.nsGainDb = 0.0f;
+        if (!agcLinkedActive && (!busActive || !agcActive)) levels.agcGainDb = 0.0f;
+
+        if (busActive) {
+            // ── 7a. Downsample to 16kHz into the frame accumulator ──
+            busDownL.downsample(floatL, bus16kL + busFill, chunk16k);
+            if (!mono) busDownR.downsample(floatR, bus16kR + busFill, chunk16k);
+            if (bandSplitActive) {
+                bandSplit[0].capture(floatL, bus16kL + busFill, chunk16k);
+                if (!mono) bandSplit[1].capture(floatR, bus16kR + busFill, chunk16k);
+            }
+            if (veNlmsActive || bridgeActive) {
+                busDownHP.downsample(floatHP, bus16kHP + busFill, chunk16k);
+            }
+            busFill += chunk16k;
+            lap(AUDIO_STAGE_RESAMPLE);
         }
 
-        if (localParams.veEnabled && hpDetected && samplesRead == BLOCK_SIZE) {
-            float blend = localParams.veBlend;
+        // VE → NS → AGC run once per complete 160-sample frame
+        while (busActive && busFill >= NS_FRAME_16K) {
+            busFill -= NS_FRAME_16K;
+            // Frame power into the bus stages, for busGain
+            const float busPowIn = quietPath ? 0.0f : blockPower(bus16kL, mono ? bus16kL : bus16kR, NS_FRAME_16K);
+
+            // The AFE's frames replace the bus signal outright
+            float blend = afeActive ? 1.0f : localParams.veBlend;
             float maxAtt = localParams.veMaxAttenuation;
 
-            if (localParams.veMode == 0 && _nlmsL && _nlmsR) {
-                // ── NLMS mode with VAD-based double-talk protection ──
-                float step = localParams.veStepSize;
+            // VE keeps its stereo filters; in mono both lanes carry the beam
+            if (mono && (veNlmsActive || bridgeActive)) {
+                memcpy(bus16kR, bus16kL, NS_FRAME_16K * sizeof(float));
+            }
 
-                veResDownL.downsample3(floatL, veDown16kL, NS_FRAME_16K);
-                veResDownR.downsample3(floatR, veDown16kR, NS_FRAME_16K);
-                veResDownHP.downsample3(floatHP, veDown16kHP, NS_FRAME_16K);
+            // ── 7a'. Reference VAD: one 10ms word per bus frame, for the own-voice
+            // decision (5b, from the next block) and the 7f output gate ──
+            if ((veNlmsActive || bridgeActive) && !quietPath && audio_stages::VAD && _vadHandleRef) {
+                floatToInt16(bus16kHP, bus16kIn, NS_FRAME_16K);
+                const bool rawSpeech = vad_process(static_cast<vad_handle_t>(_vadHandleRef),
+                                                   bus16kIn, 16000, 10) == VAD_SPEECH;
+                ownVoice.vad(rawSpeech);
+                levels.vadSpeechDetected = vadHangover.update(rawSpeech);
+            }
 
-                // Run VAD on reference signal for double-talk protection
-                bool refSpeechActive = false;
-                if (_vadHandleRef && localParams.veVadEnabled) {
-                    // Convert 16kHz float to int16 for VAD (reuse existing buffer space)
-                    for (int i = 0; i < NS_FRAME_16K; i++) {
-                        float s = std::clamp(veDown16kHP[i], -1.0f, 1.0f);
-                        ns16kIn[i] = static_cast<int16_t>(s * 32767.0f);
-                    }
-                    // VAD processes 10ms frames (160 samples @ 16kHz)
-                    vad_state_t vadState = vad_process(
-                        static_cast<vad_handle_t>(_vadHandleRef),
-                        ns16kIn, 16000, 10);
-                    refSpeechActive = (vadState == VAD_SPEECH);
-                    {
-                        std::lock_guard<std::mutex> lock(_mutex);
-                        _levels.vadSpeechDetected = refSpeechActive;
+            if (quietPath) {
+                // Quiet path: no VE. The NLMS/FDAF filters hold their coefficients; the AEC
+                // bridge and the subband bank keep running so the bus delay holds, and their
+                // frames go out dry
+                if (veNlmsActive && localParams.veMode == 3) {
+                    static_cast<StereoSubbandNlms*>(_subband)->hold(bus16kL, bus16kR, NS_FRAME_16K);
+                }
+                if (bridgeActive) {
+                    aecBridge.push(bus16kL, bus16kR, bus16kHP);
+                    while (_aecResults.pop(*aecResult)) {
+                        if (aecResult->epoch != aecBridge.epoch) continue;
+                        aecBridge.scatter(aecResult->pos, aecResult->outL, aecResult->outR, blend);
                     }
+                    if (aecBridge.frameReady()) aecBridge.gather(aecJob->inL, aecJob->inR, aecJob->ref);
+                    aecBridge.pop(bus16kL, bus16kR);
+                }
+            } else if (veNlmsActive) {
+                // ── 7b. VE: NLMS / FDAF mode with VAD-based double-talk protection ──
+                static_assert(NS_FRAME_16K % StereoFdafFilter::BLOCK == 0, "FDAF blocks must tile the bus frame");
+                float step = localParams.veStepSize;
+
+                // Gate step size: the filter learns the headset → room path from the wearer's voice
+                float effectiveStep = ownVoiceActive ? step : 0.001f;
+                // Rapid head rotation moves the echo path faster than the filter tracks:
+                // hold the coefficients until it settles. Walking shakes it less; slow down.
+                if (motion == AUDIO_MOTION_TURNING) {
+                    effectiveStep = 0.0f;
+                } else if (motion == AUDIO_MOTION_WALKING) {
+                    effectiveStep *= 0.5f;
+                }
+
+                if (localParams.veMode == 2) {
+                    // Block mode: estimates for the whole frame, then the same blend/clamp
+                    static_cast<StereoFdafFilter*>(_fdaf)->process(
+                        bus16kHP, bus16kL, bus16kR, NS_FRAME_16K, effectiveStep, veEstL, veEstR);
+                } else if (localParams.veMode == 3) {
+                    // Same, against the primaries delayed in step with the estimates
+                    static_cast<StereoSubbandNlms*>(_subband)->process(
+                        bus16kHP, bus16kL, bus16kR, NS_FRAME_16K, effectiveStep, veEstL, veEstR);
                 } else {
-                    // No VAD available, use simple RMS threshold for speech detection
-                    float refRms = 0.0f;
+                    auto* nlms = static_cast<StereoNlmsFilter*>(_nlms);
                     for (int i = 0; i < NS_FRAME_16K; i++) {
-                        refRms += veDown16kHP[i] * veDown16kHP[i];
+                        nlms->process(bus16kHP[i], bus16kL[i], bus16kR[i], effectiveStep, veEstL[i], veEstR[i]);
                     }
-                    refRms = sqrtf(refRms / NS_FRAME_16K);
-                    refSpeechActive = (refRms > 0.02f);  // Simple threshold
                 }
 
-                // Gate step size: reduce during non-speech to prevent incorrect adaptation
-                float effectiveStep = refSpeechActive ? step : 0.001f;
-
-                auto* nlL = static_cast<NlmsFilter*>(_nlmsL);
-                auto* nlR = static_cast<NlmsFilter*>(_nlmsR);
-
+                // Subtract the voice estimate directly in the 16kHz domain
                 for (int i = 0; i < NS_FRAME_16K; i++) {
-                    veEst16kL[i] = nlL->process(veDown16kHP[i], veDown16kL[i], effectiveStep);
-                    veEst16kR[i] = nlR->process(veDown16kHP[i], veDown16kR[i], effectiveStep);
+                    float estL = veEstL[i], estR = veEstR[i];
+                    float maxRemL = fabsf(bus16kL[i]) * maxAtt;
+                    float maxRemR = fabsf(bus16kR[i]) * maxAtt;
+                    bus16kL[i] -= blend * std::clamp(estL, -maxRemL, maxRemL);
+                    bus16kR[i] -= blend * std::clamp(estR, -maxRemR, maxRemR);
+                }
+                if (!healthy(AUDIO_HEALTH_VE, bus16kL, bus16kR, NS_FRAME_16K)) {
+                    if (localParams.veMode == 2) {
+                        static_cast<StereoFdafFilter*>(_fdaf)->reset();
+                    } else if (localParams.veMode == 3) {
+                        static_cast<StereoSubbandNlms*>(_subband)->reset();
+                    } else {
+                        static_cast<StereoNlmsFilter*>(_nlms)->reset();
+                    }
                 }
 
-                veResUpL.upsample3(veEst16kL, veEstUp48kL, NS_FRAME_16K);
-                veResUpR.upsample3(veEst16kR, veEstUp48kR, NS_FRAME_16K);
+            } else if (bridgeActive) {
+                // ── 7b. VE: AEC mode, or the whole bus with busAfe (frame bridge ⇄ Core 0 worker,
+                // 512-sample frames) ──
+                aecBridge.push(bus16kL, bus16kR, bus16kHP);
 
-                for (int i = 0; i < samplesRead; i++) {
-                    float maxRemL = fabsf(floatL[i]) * maxAtt;
-                    float maxRemR = fabsf(floatR[i]) * maxAtt;
-                    float remL = std::clamp(veEstUp48kL[i], -maxRemL, maxRemL);
-                    float remR = std::clamp(veEstUp48kR[i], -maxRemR, maxRemR);
-                    floatL[i] -= blend * remL;
-                    floatR[i] -= blend * remR;
-                    if (std::isnan(floatL[i])) floatL[i] = 0.0f;
-                    if (std::isnan(floatR[i])) floatR[i] = 0.0f;
+                // Blend back whatever the worker has finished since the last frame
+                while (_aecResults.pop(*aecResult)) {
+                    if (aecResult->epoch != aecBridge.epoch) continue;  // From before a reset
+                    aecBridge.scatter(aecResult->pos, aecResult->outL, aecResult->outR, blend);
                 }
 
-            } else if (localParams.veMode == 1 && _aecHandleL && _aecHandleR) {
-                // ── AEC mode (ring buffer → 512-sample frames) ──
-                constexpr float i16scale = 1.0f / 32768.0f;
-
-                // Downsample this block to 16kHz (480→160)
-                aecResDownL.downsample3(floatL, aecDown16kBlockL, NS_FRAME_16K);
-                aecResDownR.downsample3(floatR, aecDown16kBlockR, NS_FRAME_16K);
-                aecResDownHP.downsample3(floatHP, aecDown16kBlockHP, NS_FRAME_16K);
-
-                // Push 160 samples into ring buffers
-                aecRingL.push(aecDown16kBlockL, NS_FRAME_16K);
-                aecRingR.push(aecDown16kBlockR, NS_FRAME_16K);
-                aecRingHP.push(aecDown16kBlockHP, NS_FRAME_16K);
-
-                // When we have 512 samples, process one AEC frame
-                if (aecRingL.ready() && aecRingR.ready() && aecRingHP.ready()) {
-                    // Convert float→int16 for AEC
-                    for (int i = 0; i < AEC_FRAME_16K; i++) {
-                        float sL = std::clamp(aecRingL.buf[i], -1.0f, 1.0f);
-                        float sR = std::clamp(aecRingR.buf[i], -1.0f, 1.0f);
-                        float sHP = std::clamp(aecRingHP.buf[i], -1.0f, 1.0f);
-                        aec16kInL[i] = static_cast<int16_t>(sL * 32767.0f);
-                        aec16kInR[i] = static_cast<int16_t>(sR * 32767.0f);
-                        aec16kRef[i] = static_cast<int16_t>(sHP * 32767.0f);
-                    }
+                // At most one AEC frame completes per bus frame (160 < 512)
+                if (aecBridge.frameReady()) {
+                    aecJob->epoch = aecBridge.epoch;
+                    aecJob->pos = aecBridge.gather(aecJob->inL, aecJob->inR, aecJob->ref);
 
-                    // Run VAD on reference signal if enabled
-                    if (_vadHandleRef) {
-                        // VAD processes 30ms frames (480 samples @ 16kHz)
-                        // We'll check the first 480 samples of our 512-sample buffer
-                        vad_state_t vadState = vad_process(
-                            static_cast<vad_handle_t>(_vadHandleRef),
-                            aec16kRef, 16000, 30);
-                        std::lock_guard<std::mutex> lock(_mutex);
-                        _levels.vadSpeechDetected = (vadState == VAD_SPEECH);
-                    }
+                    // Hand the frame to the worker; a full queue means it is two
+                    // frames behind, and the frame goes out dry
+                    if (_aecJobs.push(*aecJob)) _aecTask.notify();
+                }
 
-                    // Process AEC: input signal + reference → cleaned output
-                    aec_process(static_cast<aec_handle_t*>(_aecHandleL),
-                                aec16kInL, aec16kRef, aec16kOutL);
-                    aec_process(static_cast<aec_handle_t*>(_aecHandleR),
-                                aec16kInR, aec16kRef, aec16kOutR);
+                // Constant-delay output (silent for the first LATENCY samples after a reset)
+                if (!aecBridge.pop(bus16kL, bus16kR)) levels.xrun.aecLateFrames++;
+                if (!healthy(AUDIO_HEALTH_AEC, bus16kL, bus16kR, NS_FRAME_16K)) aecBridge.reset();
+            }
 
-                    // Convert AEC output to float and store in output ring buffers
-                    for (int i = 0; i < AEC_FRAME_16K; i++) {
-                        aecOutRingL.buf[i] = static_cast<float>(aec16kOutL[i]) * i16scale;
-                        aecOutRingR.buf[i] = static_cast<float>(aec16kOutR[i]) * i16scale;
-                    }
-                    aecOutRingL.writePos = AEC_FRAME_16K;
-                    aecOutRingR.writePos = AEC_FRAME_16K;
-
-                    // Consume input ring buffers
-                    aecRingL.consume();
-                    aecRingR.consume();
-                    aecRingHP.consume();
-                    aecOutputReady = true;
+            lap(AUDIO_STAGE_VE);
+
+            // ── 7c'. Linked NS: one instance on the mid signal. Its frame gain goes to
+            // both lanes as a per-sample ramp, so the ears never get different suppression
+            // and the stereo image holds still ──
+            const bool nsLink = nsActive && !quietPath && !mono && localParams.nsLinked;
+            if (nsLink) {
+                for (int i = 0; i < NS_FRAME_16K; i++) bus16kMid[i] = 0.5f * (bus16kL[i] + bus16kR[i]);
+                EarLane mid{bus16kMid, bus16kIn, bus16kOut, _nsHandleL, nullptr};
+                runEarLaneNs(mid);
+                // A silent frame says nothing about the noise: hold the gain
+                const float target = mid.pow[0] > NS_LINK_FLOOR
+                    ? std::min(1.0f, sqrtf(mid.pow[1] / mid.pow[0])) : nsLinkGain;
+                const float step = (target - nsLinkGain) / NS_FRAME_16K;
+                for (int i = 0; i < NS_FRAME_16K; i++) {
+                    nsLinkGain += step;
+                    bus16kL[i] *= nsLinkGain;
+                    bus16kR[i] *= nsLinkGain;
                 }
+                nsLinkGain = target;
+                levels.nsGainDb = powerRatioDb(mid.pow[1], mid.pow[0]);
+            }
 
-                // Apply AEC output: blend with original signal
-                // During startup transient (no output yet), pass through unchanged
-                if (aecOutputReady && aecOutRingL.writePos > 0) {
-                    // Upsample the AEC output back to 48kHz
-                    // We process NS_FRAME_16K (160) samples from AEC output per block
-                    int consumeCount = std::min(NS_FRAME_16K, aecOutRingL.writePos);
-
-                    // Use temporary buffers for upsample input
-                    float aecChunkL[NS_FRAME_16K];
-                    float aecChunkR[NS_FRAME_16K];
-                    memcpy(aecChunkL, aecOutRingL.buf, consumeCount * sizeof(float));
-                    memcpy(aecChunkR, aecOutRingR.buf, consumeCount * sizeof(float));
-
-                    // Shift remaining data in output ring
-                    int remaining = aecOutRingL.writePos - consumeCount;
-                    if (remaining > 0) {
-                        memmove(aecOutRingL.buf, aecOutRingL.buf + consumeCount, remaining * sizeof(float));
-                        memmove(aecOutRingR.buf, aecOutRingR.buf + consumeCount, remaining * sizeof(float));
-                    }
-                    aecOutRingL.writePos = remaining;
-                    aecOutRingR.writePos = remaining;
-
-                    // Upsample to 48kHz
-                    aecResUpL.upsample3(aecChunkL, veEstUp48kL, consumeCount);
-                    aecResUpR.upsample3(aecChunkR, veEstUp48kR, consumeCount);
-
-                    // Replace signal with blended AEC output
-                    int outCount = consumeCount * 3;
-                    for (int i = 0; i < samplesRead && i < outCount; i++) {
-                        float aecL = std::clamp(veEstUp48kL[i], -1.0f, 1.0f);
-                        float aecR = std::clamp(veEstUp48kR[i], -1.0f, 1.0f);
-                        // Blend: 0 = original, 1 = full AEC output
-                        floatL[i] = (1.0f - blend) * floatL[i] + blend * aecL;
-                        floatR[i] = (1.0f - blend) * floatR[i] + blend * aecR;
-                        if (std::isnan(floatL[i])) floatL[i] = 0.0f;
-                        if (std::isnan(floatR[i])) floatR[i] = 0.0f;
-                    }
-                }
+            // ── 7c/7d. NS → AGC back to back on int16 frames ──
+            // One float → int16 pass in and one back out per lane; each stage
+            // ping-pongs between the lane's two buffers. In split-ear mode the
+            // right lane runs on the Core 0 worker meanwhile.
+            const bool laneNs = nsActive && !quietPath && !nsLink;
+            const bool laneAgc = agcActive && !quietPath;
+            const bool fixedPoint = laneNs || laneAgc;
+            const bool stereoLanes = fixedPoint && !mono;
+            const bool fork = stereoLanes && earSplit;
+            EarLane laneL{bus16kL, bus16kIn, bus16kOut, laneNs ? _nsHandleL : nullptr,
+                          laneAgc ? _agcHandleL : nullptr};
+            if (stereoLanes) {
+                _earLane = EarLane{bus16kR, bus16kInR, bus16kOutR, laneNs ? _nsHandleR : nullptr,
+                                   laneAgc ? _agcHandleR : nullptr};
+            }
+            if (fork) {
+                _earPending.store(true, std::memory_order_release);
+                _earTask.notify();
             }
-        }
 
-        // ── 7b. VAD-based gating with smoothing (attenuate output during non-speech) ──
-        // This reduces transient sounds (footsteps, etc.) when VAD detects silence
-        // Now works with both NLMS and AEC modes
-        if (localParams.veVadGateEnabled && localParams.veEnabled) {
-            bool speechDetected = false;
-            {
-                std::lock_guard<std::mutex> lock(_mutex);
-                speechDetected = _levels.vadSpeechDetected;
+            if (fixedPoint) {
+                runEarLaneNs(laneL);
+                if (stereoLanes && !fork) runEarLaneNs(_earLane);
             }
+            lap(AUDIO_STAGE_NS);
 
-            // Calculate target gate value
-            float target = speechDetected ? 1.0f : localParams.veVadGateAtten;
+            // AGC (after NS, before gain)
+            if (fixedPoint) {
+                runEarLaneAgc(laneL);
+                if (stereoLanes && !fork) runEarLaneAgc(_earLane);
+            }
+            lap(AUDIO_STAGE_AGC);
+
+            if (fork) {
+                // The worker started first on the same work: usually done, or nearly
+                const int64_t joinStart = esp_timer_get_time();
+                bool late = false;
+                while (_earPending.load(std::memory_order_acquire)) {
+                    if (!late && esp_timer_get_time() - joinStart > EAR_SPIN_US) {
+                        late = true;
+                        levels.xrun.earLateFrames++;
+                    }
+                    if (late) ulTaskNotifyTake(pdTRUE, 1);
+                }
+                lap(AUDIO_STAGE_EAR_JOIN);
+            }
 
-            // Apply exponential smoothing to prevent clicks on transitions
-            // Smoothing: 0.95 gives ~200ms attack/release at 48kHz/480 block size
-            constexpr float smoothAlpha = 0.05f;  // 5% per block toward target
-            _vadGateSmoothed = (1.0f - smoothAlpha) * _vadGateSmoothed + smoothAlpha * target;
+            if (fixedPoint) {
+                // Telemetry over both lanes, as one stereo block
+                float pow[3];
+                for (int k = 0; k < 3; k++) {
+                    pow[k] = stereoLanes ? 0.5f * (laneL.pow[k] + _earLane.pow[k]) : laneL.pow[k];
+                }
+                if (laneNs) levels.nsGainDb = powerRatioDb(pow[1], pow[0]);
+                if (laneAgc) levels.agcGainDb = powerRatioDb(pow[2], pow[1]);
+            }
 
-            // Apply smoothed gate to output
-            for (int i = 0; i < samplesRead; i++) {
-                floatL[i] *= _vadGateSmoothed;
-                floatR[i] *= _vadGateSmoothed;
+            if (quietPath) {
+                // The stages sleep with their state intact; the frame keeps the gain they last applied
+                for (int i = 0; i < NS_FRAME_16K; i++) {
+                    bus16kL[i] *= busGain;
+                    bus16kR[i] *= busGain;
+                }
+            } else if (busPowIn > NS_LINK_FLOOR) {
+                const float powOut = blockPower(bus16kL, mono ? bus16kL : bus16kR, NS_FRAME_16K);
+                busGain = std::min(sqrtf(powOut / busPowIn), BusBandSplit::MAX_GAIN);
             }
-        }
 
-        // ── 8. Noise Suppression (downsample → NS → upsample) ──
-        if (localParams.nsEnabled && _nsHandleL && _nsHandleR && samplesRead == BLOCK_SIZE) {
-            // Downsample 48kHz → 16kHz (480 → 160 samples)
-            resamplerDownL.downsample3(floatL, down16kL, NS_FRAME_16K);
-            resamplerDownR.downsample3(floatR, down16kR, NS_FRAME_16K);
+            busOutL.push(bus16kL, NS_FRAME_16K);
+            if (!mono) busOutR.push(bus16kR, NS_FRAME_16K);
 
-            // Process Left channel: float → int16 → NS → int16 → float
-            for (int i = 0; i < NS_FRAME_16K; i++) {
-                float s = std::clamp(down16kL[i], -1.0f, 1.0f);
-                ns16kIn[i] = static_cast<int16_t>(s * 32767.0f);
-            }
-            ns_process(static_cast<ns_handle_t>(_nsHandleL), ns16kIn, ns16kOut);
-            for (int i = 0; i < NS_FRAME_16K; i++) {
-                down16kL[i] = static_cast<float>(ns16kOut[i]) * scale;
+            // What's past the frame (32kHz) starts the next one
+            if (busFill > 0) {
+                memmove(bus16kL, bus16kL + NS_FRAME_16K, busFill * sizeof(float));
+                memmove(bus16kR, bus16kR + NS_FRAME_16K, busFill * sizeof(float));
+                memmove(bus16kHP, bus16kHP + NS_FRAME_16K, busFill * sizeof(float));
             }
+        }
 
-            // Process Right channel
-            for (int i = 0; i < NS_FRAME_16K; i++) {
-                float s = std::clamp(down16kR[i], -1.0f, 1.0f);
-                ns16kIn[i] = static_cast<int16_t>(s * 32767.0f);
+        if (busActive) {
+            // ── 7e. Upsample 16kHz → engine rate (one block's chunk from the output FIFO) ──
+            busOutL.pop(bus16kUpL, chunk16k);
+            busUpL.upsample(bus16kUpL, floatL, chunk16k);
+            if (!mono) {
+                busOutR.pop(bus16kUpR, chunk16k);
+                busUpR.upsample(bus16kUpR, floatR, chunk16k);
             }
-            ns_process(static_cast<ns_handle_t>(_nsHandleR), ns16kIn, ns16kOut);
-            for (int i = 0; i < NS_FRAME_16K; i++) {
-                down16kR[i] = static_cast<float>(ns16kOut[i]) * scale;
+            // Band split: the high band rejoins, delayed to match and at the bus's gain
+            if (bandSplitActive) {
+                bandSplit[0].restore(floatL, chunk16k, busGain, bandSmoothing);
+                if (!mono) bandSplit[1].restore(floatR, chunk16k, busGain, bandSmoothing);
             }
+            lap(AUDIO_STAGE_RESAMPLE);
+        }
 
-            // Upsample 16kHz → 48kHz (160 → 480 samples)
-            resamplerUpL.upsample3(down16kL, floatL, NS_FRAME_16K);
-            resamplerUpR.upsample3(down16kR, floatR, NS_FRAME_16K);
+        // Mono chain: both outputs carry the beam from here on
+        if (mono) memcpy(floatR, floatL, samplesRead * sizeof(float));
+
+        // ── 7e''. Linked AGC: one gain from max(L, R), applied at 48kHz where the bus AGC would be ──
+        if (agcLinkedActive) {
+            if (!prevAgcLinkedActive) linkedAgc.reset();
+            linkedAgc.configure(localParams.agcMode, localParams.agcCompressionGainDb, localParams.agcLimiterEnabled,
+                                localParams.agcTargetLevelDbfs, sampleRate);
+            // Own voice would pull the gain down for the room, then pump it back up
+            levels.agcGainDb = linkedAgc.process(floatL, floatR, samplesRead, ownVoiceActive);
+            if (!healthy(AUDIO_HEALTH_LINKED_AGC, floatL, floatR, samplesRead)) linkedAgc.reset();
+            lap(AUDIO_STAGE_AGC);
+        }
+        prevAgcLinkedActive = agcLinkedActive;
+
+        // ── 7e'-8. Hearing chain: spectral → VAD gate → fitted mixer → WDRC → MBC → shift → notches/shelf ──
+        // Only a change in what's on recompiles the plan; a stage entering it is reset first
+        hearing.setEnabled(spectralStage, _wola.isInitialized() && _wola.clientCount() > 0 && !sessionOff);
+        hearing.setEnabled(vadGateStage, localParams.veVadGateEnabled && localParams.veEnabled);
+        hearing.setEnabled(wdrcStage, wdrcActive);
+        hearing.setEnabled(mbcStage, mbcActive);
+        hearing.setEnabled(shiftStage, fbcActive && localParams.fbcShiftHz > 0.0f);
+        hearing.setEnabled(tinnitusStage,
+                           _tinnitusCascade.activeCount() > 0 || (_earsSplit && _tinnitusCascadeR.activeCount() > 0));
+        hearing.run(floatL, floatR, samplesRead, [&](int tag) { lap(static_cast<AudioStage>(tag)); });
+        // Re-entering the plan resets every stage in it; the tinnitus cascades aren't on a reset callback
+        if (hearing.planSize() > 0 && !healthy(AUDIO_HEALTH_CHAIN, floatL, floatR, samplesRead)) {
+            hearing.clear();
+            _tinnitusCascade.reset();
+            _tinnitusCascadeR.reset();
         }
 
-        // ── 8b. AGC (downsample → AGC → upsample, after NS, before gain) ──
-        if (localParams.agcEnabled && _agcHandleL && _agcHandleR && samplesRead == BLOCK_SIZE) {
-            // Downsample 48kHz → 16kHz (480 → 160 samples)
-            agcResDownL.downsample3(floatL, agcDown16kL, NS_FRAME_16K);
-            agcResDownR.downsample3(floatR, agcDown16kR, NS_FRAME_16K);
+        // Telemetry of the stages that are off
+        if (!hearing.inPlan(vadGateStage)) levels.vadGateGain = 1.0f;
+        if (!hearing.inPlan(wdrcStage)) levels.wdrcGainDb[0] = levels.wdrcGainDb[1] = 0.0f;
+        if (!hearing.inPlan(mbcStage)) {
+            for (float& gr : levels.mbcGainReductionDb) gr = 0.0f;
+        }
 
-            // Process Left channel: float → int16 → AGC → int16 → float
-            for (int i = 0; i < NS_FRAME_16K; i++) {
-                float s = std::clamp(agcDown16kL[i], -1.0f, 1.0f);
-                agc16kIn[i] = static_cast<int16_t>(s * 32767.0f);
+        // ── 8a. Howl detector: park a narrow notch on each confirmed howl ──
+        // Looks at the notched mic path before the generators, so tones and maskers
+        // never read as feedback and a parked notch clears its own howl
+        const bool howlActive = localParams.fbcEnabled && localParams.howlSuppression && !sessionOff;
+        if (howlActive) {
+            if (!prevHowlActive) howl->reset();
+            float hz = 0.0f;
+            if (howl->process(floatL, floatR, samplesRead, sampleRate, hz)) {
+                // The same howl again re-centres its notch; otherwise a free slot, else the oldest
+                int slot = -1;
+                for (int i = 0; i < 6 && slot < 0; i++) {
+                    if (autoNotches[i].active && fabsf(hz - autoNotches[i].freq) < AUTO_NOTCH_MATCH * hz) slot = i;
+                }
+                for (int i = 0; i < 6 && slot < 0; i++) {
+                    if (!autoNotches[i].active && !userNotchInSlot(i)) slot = i;
+                }
+                if (slot < 0) {
+                    for (int i = 0; i < 6; i++) {
+                        if (autoNotches[i].active &&
+                            (slot < 0 || autoNotches[i].ageSamples > autoNotches[slot].ageSamples)) {
+                            slot = i;
+                        }
+                    }
+                }
+                if (slot >= 0) {
+                    autoNotches[slot] = AutoNotch{hz, 0, true};
+                    parkAutoNotch(slot);
+                    mclog::traceInfo(TAG, "howl at {:.0f} Hz, notch parked in slot {}", hz, slot);
+                } else {
+                    mclog::traceWarn(TAG, "howl at {:.0f} Hz, all notch slots are in use", hz);
+                }
+                levels.howlHz = hz;
             }
-            esp_agc_process(_agcHandleL, agc16kIn, agc16kOut, NS_FRAME_16K, 16000);
-            for (int i = 0; i < NS_FRAME_16K; i++) {
-                agcDown16kL[i] = static_cast<float>(agc16kOut[i]) * scale;
+            lap(AUDIO_STAGE_FEEDBACK);
+        }
+        prevHowlActive = howlActive;
+        levels.autoNotches = 0;
+        for (int i = 0; i < 6; i++) {
+            if (!autoNotches[i].active) continue;
+            autoNotches[i].ageSamples += samplesRead;
+            if (!howlActive || autoNotches[i].ageSamples >= AUTO_NOTCH_HOLD) {
+                releaseAutoNotch(i);
+            } else {
+                levels.autoNotches++;
             }
+        }
 
-            // Process Right channel
-            for (int i = 0; i < NS_FRAME_16K; i++) {
-                float s = std::clamp(agcDown16kR[i], -1.0f, 1.0f);
-                agc16kIn[i] = static_cast<int16_t>(s * 32767.0f);
-            }
-            esp_agc_process(_agcHandleR, agc16kIn, agc16kOut, NS_FRAME_16K, 16000);
-            for (int i = 0; i < NS_FRAME_16K; i++) {
-                agcDown16kR[i] = static_cast<float>(agc16kOut[i]) * scale;
-            }
+        // ── 8b-8e. Tinnitus Relief generators and session envelope ──
+        // Generators run after the 16kHz bus so NS/AGC never see (or band-limit) them
+        tinnitusGenerators(samplesRead);
 
-            // Upsample 16kHz → 48kHz (160 → 480 samples)
-            agcResUpL.upsample3(agcDown16kL, floatL, NS_FRAME_16K);
-            agcResUpR.upsample3(agcDown16kR, floatR, NS_FRAME_16K);
-        }
+        // ── 8e'. A/B switch dip (the mixer's voices join after it and don't dip) ──
+        abSwitchDip(samplesRead);
 
-        // ── 9. Apply output gain ──
-        float gain = localParams.outputGain;
-        for (int i = 0; i < samplesRead; i++) {
-            floatL[i] *= gain;
-            floatR[i] *= gain;
+        lap(AUDIO_STAGE_TINNITUS);
+
+        // ── 8f. Mixer: SFX / media voices join after the hearing chain, program ducked under them ──
+        _mixer.mix(floatL, floatR, samplesRead, sampleRate);
+        lap(AUDIO_STAGE_MIXER);
+
+        // ── 8g. Correction FIR: the headphone / fitting IR, on the voices too ──
+        const bool firActive = localParams.firEnabled && _fir;
+        if (firActive) {
+            auto* fir = static_cast<FirConvolver*>(_fir);
+            if (!prevFirActive) fir->reset();  // Re-entering starts from silence, not stale history
+            fir->process(floatL, floatR, samplesRead);
+        }
+        prevFirActive = firActive;
+        lap(AUDIO_STAGE_CORRECTION);
+
+        // ── 8h. Own-voice duck: the output steps down while the wearer talks, so their
+        // voice booming in the occluded ear canal isn't amplified on top ──
+        const float duckTarget = ownVoiceActive && localParams.ownVoiceDuckDb > 0.0f
+            ? powf(10.0f, -localParams.ownVoiceDuckDb / 20.0f) : 1.0f;
+        if (duckTarget != 1.0f || ownVoiceGain != 1.0f) {
+            const float k = duckTarget < ownVoiceGain ? ownDuckAttack : ownDuckRelease;
+            for (int i = 0; i < samplesRead; i++) {
+                ownVoiceGain += k * (duckTarget - ownVoiceGain);
+                floatL[i] *= ownVoiceGain;
+                floatR[i] *= ownVoiceGain;
+            }
+            if (fabsf(ownVoiceGain - duckTarget) < 1e-4f) ownVoiceGain = duckTarget;
         }
 
-        // ── 9b. Soft clipping for boost mode (tanh-based saturation) ──
-        if (localParams.boostEnabled) {
-            // Soft clip: prevents harsh digital clipping at high gains
-            // tanh(x * drive) / tanh(drive) gives smooth saturation
-            constexpr float drive = 1.5f;
-            constexpr float tanhDrive = 0.9051f;  // tanh(1.5)
-            constexpr float invTanhDrive = 1.0f / tanhDrive;
+        // Unlinked ears with different gains: each side takes its own here, and the
+        // limiter and output kernel carry on at unity
+        float outputGain = localParams.outputGain;
+        if (!localParams.earsLinked && localParams.rightEar.outputGain != outputGain) {
+            const float gainR = localParams.rightEar.outputGain;
             for (int i = 0; i < samplesRead; i++) {
-                floatL[i] = tanhf(floatL[i] * drive) * invTanhDrive;
-                floatR[i] = tanhf(floatR[i] * drive) * invTanhDrive;
+                floatL[i] *= outputGain;
+                floatR[i] *= gainR;
             }
+            outputGain = 1.0f;
         }
 
-        // ── 10. Compute RMS + peak for level metering ──
-        float sumL = 0.0f, sumR = 0.0f;
-        float pkL = 0.0f, pkR = 0.0f;
-        for (int i = 0; i < samplesRead; i++) {
-            float absL = fabsf(floatL[i]);
-            float absR = fabsf(floatR[i]);
-            sumL += floatL[i] * floatL[i];
-            sumR += floatR[i] * floatR[i];
-            if (absL > pkL) pkL = absL;
-            if (absR > pkR) pkR = absR;
+        // Spectrum analyzer: the output side of the frame, at the output gain (limiter and clip excluded)
+        if (specTake > 0) {
+            const float g = (localParams.outputMute || sessionOff) ? 0.0f : 0.5f * outputGain;
+            float* dst = _specCapture + SPEC_FFT + specPos;
+            for (int i = 0; i < specTake; i++) dst[i] = g * (floatL[i] + floatR[i]);
+            specPos += specTake;
+            if (specPos >= SPEC_FFT) {
+                specPos = -1;
+                _specCaptureReady.store(true, std::memory_order_release);
+                _ctlTask.notify();
+            }
         }
+
+        // ── 9-12. Output kernel: gain, soft clip (boost), metering, clamp, int16 pack, mute ──
+        uint32_t txWaitUs = 0;   // Zero-copy: time spent waiting for free TX buffers
+        int droppedTail = 0;     // Zero-copy: output samples left unplayed by a lead trim
         {
-            std::lock_guard<std::mutex> lock(_mutex);
-            _levels.rmsLeft = sqrtf(sumL / (float)samplesRead);
-            _levels.rmsRight = sqrtf(sumR / (float)samplesRead);
-            // Peak hold with decay
-            _levels.peakLeft = std::max(pkL, _levels.peakLeft * PEAK_DECAY);
-            _levels.peakRight = std::max(pkR, _levels.peakRight * PEAK_DECAY);
+            const bool mute = localParams.outputMute || sessionOff;
+            const float gain = finalGain(samplesRead, outputGain, mute);
+
+            auto kernel = localParams.boostEnabled
+                ? (mute ? outputKernel<true, false> : outputKernel<true, true>)
+                : (mute ? outputKernel<false, false> : outputKernel<false, true>);
+            if (zeroCopy) {
+                // One TX DMA buffer per chunk. The block's first sample should play leadTarget
+                // after its last input buffer completed; once off by most of a period, slip
+                // whole buffers: skip TX buffers (1ms silence) when short, leave trailing
+                // chunks unplayed when long. Unplayed chunks still meter into outBuf.
+                const int chunks = samplesRead / BSP_I2S_DMA_FRAME_NUM;
+                const int32_t leadTargetUs = std::min<int32_t>(blockPeriodUs + 2 * DMA_PERIOD_US,
+                    (BSP_I2S_DMA_DESC_NUM - 2) * DMA_PERIOD_US);
+                const int32_t slackUs = DMA_PERIOD_US * 3 / 4;
+                int play = chunks;
+                if (txNextDoneUs != 0) {
+                    int32_t lead = static_cast<int32_t>(txNextDoneUs + TX_REPLAY_US - rxDoneUs);
+                    if (lead > leadTargetUs + slackUs) {
+                        play = std::max(0, chunks - (lead - leadTargetUs + DMA_PERIOD_US / 2) / DMA_PERIOD_US);
+                    }
+                }
+                for (int b = 0; b < chunks; b++) {
+                    const int off = b * BSP_I2S_DMA_FRAME_NUM;
+                    txBufs[b] = nullptr;
+                    if (b < play) {
+                        // Waiting for the DMA to free a buffer is I/O, not DSP
+                        lap(AUDIO_STAGE_OUTPUT);
+                        const int64_t waitStart = esp_timer_get_time();
+                        bsp_i2s_stream_buf_t tx;
+                        bool ok = bsp_i2s_stream_tx_acquire(&tx, STREAM_TIMEOUT_MS);
+                        while (ok && b == 0 && tx.done_us + TX_REPLAY_US - rxDoneUs < leadTargetUs - slackUs) {
+                            levels.xrun.clockTrims++;
+                            ok = bsp_i2s_stream_tx_acquire(&tx, STREAM_TIMEOUT_MS);
+                        }
+                        txWaitUs += static_cast<uint32_t>(esp_timer_get_time() - waitStart);
+                        lap(AUDIO_STAGE_WRITE);
+                        if (ok) {
+                            if (b == 0) {
+                                levels.xrun.txLeadUs = static_cast<int32_t>(tx.done_us + TX_REPLAY_US - rxDoneUs);
+                                samplesOut += missedFrames(txDoneUs, tx.done_us);
+                            }
+                            txBufs[b] = tx.data;
+                            txDoneUs = tx.done_us;
+                            txNextDoneUs = tx.done_us + DMA_PERIOD_US;
+                        }
+                    }
+                    int16_t* dst = txBufs[b] ? txBufs[b] : outBuf + off * NUM_CHANNELS_OUT;
+                    kernel(floatL + off, floatR + off, dst, BSP_I2S_DMA_FRAME_NUM, gain,
+                        meterSumL, meterSumR, meterPkL, meterPkR);
+                    if (mute) memset(dst, 0, BSP_I2S_DMA_FRAME_NUM * NUM_CHANNELS_OUT * sizeof(int16_t));
+                }
+                if (play < chunks) {
+                    levels.xrun.clockTrims += chunks - play;
+                    droppedTail = (chunks - play) * BSP_I2S_DMA_FRAME_NUM;
+                }
+            } else {
+                kernel(floatL, floatR, outBuf, samplesRead, gain, meterSumL, meterSumR, meterPkL, meterPkR);
+                if (mute) memset(outBuf, 0, samplesRead * NUM_CHANNELS_OUT * sizeof(int16_t));
+            }
+            meterSamples += samplesRead;
         }
 
-        // ── 11. Clamp and convert to int16 stereo output ──
-        for (int i = 0; i < samplesRead; i++) {
-            float l = std::clamp(floatL[i], -1.0f, 1.0f);
-            float r = std::clamp(floatR[i], -1.0f, 1.0f);
-            outBuf[i * 2 + 0] = (int16_t)(l * 32767.0f);
-            outBuf[i * 2 + 1] = (int16_t)(r * 32767.0f);
+        // Latency test: the burst replaces the program on both channels
+        if (_latencyProbeRequested.exchange(false, std::memory_order_acquire) && probeState == PROBE_IDLE) {
+            probeState = (localParams.outputMute || !_latCapture) ? PROBE_IDLE : PROBE_ARMED;
+            probeSource = _latencySource.load(std::memory_order_relaxed);
+            probeRun = probeValid = 0;
+            levels.latency.source = static_cast<uint8_t>(probeSource);
+            levels.latency.runsDone = levels.latency.runsValid = 0;
+            levels.latency.lastFailed = probeState == PROBE_IDLE;
+        }
+        const bool probeBusy = probeState != PROBE_IDLE;
+        if (probeBusy != _probeBusy.load(std::memory_order_relaxed)) {
+            _probeBusy.store(probeBusy, std::memory_order_release);
+            _ctlTask.notify();  // The output stage may be off: it powers up for the bursts
+        }
+        // Each burst waits for a capture profile with its lane, the output stage and the previous analysis
+        const int probeLane = probeSource == AudioLatencyInfo::SOURCE_HP_MIC ? 3 : 1;
+        if (probeState == PROBE_ARMED && layout.offset[probeLane] >= 0 &&
+            _outputPowered.load(std::memory_order_acquire) && !_latCaptureReady.load(std::memory_order_acquire)) {
+            probeOutIndex = samplesOut;
+            probeBusDelay = busActive ? busRatio * busPrime16k + busResamplerDelay : 0;
+            probeBusDelay += busRatio * bridgeDelay16k;
+            probeBusDelay += busRatio * veDelay16k;
+            if (hearing.inPlan(spectralStage)) probeBusDelay += _wola.latencySamples();
+            if (localParams.dynamics.limiterEnabled) probeBusDelay += LookaheadLimiter::LOOKAHEAD;
+            probeState = PROBE_RUNNING;
+        }
+        if (probeState == PROBE_RUNNING) {
+            const int64_t chip0 = static_cast<int64_t>(samplesOut) - static_cast<int64_t>(probeOutIndex);
+            const int end = static_cast<int>(std::min<int64_t>(samplesRead, LAT_MLS_LEN - chip0));
+            for (int i = 0; i < end; i++) {
+                const int b = i / BSP_I2S_DMA_FRAME_NUM;
+                int16_t* frame = (zeroCopy && txBufs[b])
+                    ? txBufs[b] + (i - b * BSP_I2S_DMA_FRAME_NUM) * NUM_CHANNELS_OUT
+                    : outBuf + i * NUM_CHANNELS_OUT;
+                const int16_t v = _latMls[chip0 + i] > 0.0f ? PROBE_AMPLITUDE : -PROBE_AMPLITUDE;
+                frame[0] = v;
+                frame[1] = v;
+            }
+        }
+        levels.latency.measuring = probeState != PROBE_IDLE;
+
+        lap(AUDIO_STAGE_OUTPUT);
+        if (profiling) stageCycles.cycles[AUDIO_STAGE_DSP] = lapMark - dspMark - stageCycles.cycles[AUDIO_STAGE_WRITE];
+
+        // Deadline check: DSP time must fit in one block period or the DMA runs dry
+        {
+            uint32_t blockUs = static_cast<uint32_t>(esp_timer_get_time() - readDoneUs) - txWaitUs;
+            bool missed = blockUs > blockPeriodUs;
+            levels.xrun.blockUs = blockUs;
+            if (levels.cache.available) {
+                // The counters wrap; unsigned deltas stay right across one wrap
+                bsp_cache_counts_t cacheNow;
+                bsp_cache_counters_read(cacheCore, &cacheNow);
+                const uint32_t l1Hit = cacheNow.l1_hit - cacheMark.l1_hit;
+                levels.cache.l1Miss = cacheNow.l1_miss - cacheMark.l1_miss;
+                levels.cache.l2Miss = cacheNow.l2_miss - cacheMark.l2_miss;
+                const uint32_t l1Total = l1Hit + levels.cache.l1Miss;
+                levels.cache.l1HitPct = l1Total ? 100.0f * l1Hit / l1Total : 100.0f;
+                levels.cache.worstL2Miss = std::max(levels.cache.worstL2Miss, levels.cache.l2Miss);
+                if (blockUs > levels.xrun.worstBlockUs) levels.cache.worstBlockL2Miss = levels.cache.l2Miss;
+            }
+            levels.xrun.worstBlockUs = std::max(levels.xrun.worstBlockUs, blockUs);
+            if (blockUs > _blockPeakUs.load(std::memory_order_relaxed)) {
+                _blockPeakUs.store(blockUs, std::memory_order_relaxed);
+            }
+            _blockPeriodUs.store(blockPeriodUs, std::memory_order_relaxed);
+            if (missed) levels.xrun.deadlineMisses++;
+
+            bsp_i2s_xrun_counts_t xrunNow;
+            bsp_i2s_get_xrun_counts(&xrunNow);
+            levels.xrun.rxOverruns = xrunNow.rx_overflows - xrunBase.rx_overflows;
+            levels.xrun.txUnderruns = xrunNow.tx_overflows - xrunBase.tx_overflows;
+
+            // Degrade policy: too many misses in one window with a high-cost AEC mode
+            if (missed) degradeWindowMisses++;
+            degradeWindowSamples += samplesRead;
+            if (degradeWindowSamples >= sampleRate * DEGRADE_WINDOW_S) {
+                if (!aecDegraded && veAecActive && localParams.veAecMode != 0 &&
+                    degradeWindowMisses >= DEGRADE_MISS_THRESHOLD &&
+                    _autoDegradeEnabled.load(std::memory_order_relaxed)) {
+                    mclog::traceWarn(TAG, "{} deadline misses in 1s, dropping AEC mode {} to SR_LOW_COST",
+                        degradeWindowMisses, localParams.veAecMode);
+                    aecDegraded = true;
+                    localParams.veAecMode = 0;
+                    localParamsChanged = true;
+                }
+                degradeWindowSamples = 0;
+                degradeWindowMisses = 0;
+            }
+            levels.xrun.aecDegraded = aecDegraded;
+
+            // Health storm: stages diverging block after block point at bad input, not at a
+            // stage; the I2S restart is cheaper than letting the chain reset itself all second
+            healthWindowSamples += samplesRead;
+            if (healthWindowSamples >= sampleRate) {
+                if (healthResets >= HEALTH_RESTART_RESETS) {
+                    mclog::traceWarn(TAG, "{} health resets in 1s", healthResets);
+                    uint8_t none = AUDIO_RESTART_NONE;
+                    _restartRequest.compare_exchange_strong(none, AUDIO_RESTART_HEALTH, std::memory_order_acq_rel);
+                }
+                healthWindowSamples = 0;
+                healthResets = 0;
+            }
         }
 
-        // ── 12. Apply mute (zero buffer) ──
-        if (localParams.outputMute) {
-            memset(outBuf, 0, samplesRead * NUM_CHANNELS_OUT * sizeof(int16_t));
+        // Publish to the UI once per 10ms metering frame (latest value + history ring)
+        if (meterSamples >= meterFrame) {
+            // Upper-bound estimate: input block + processing block + TX DMA queue + bus framing
+            // Duplex: one input block plus the measured TX lead; codec path: blocking I/O plus a full TX ring
+            int estSamples = zeroCopy
+                ? blockSize + static_cast<int>(static_cast<int64_t>(levels.xrun.txLeadUs) * sampleRate / 1000000)
+                : 2 * blockSize + BSP_I2S_DMA_DESC_NUM * BSP_I2S_DMA_FRAME_NUM;
+            if (busActive) estSamples += busRatio * busPrime16k + busResamplerDelay;
+            estSamples += busRatio * bridgeDelay16k;
+            estSamples += busRatio * veDelay16k;
+            if (hearing.inPlan(spectralStage)) estSamples += _wola.latencySamples();
+            if (localParams.dynamics.limiterEnabled) estSamples += LookaheadLimiter::LOOKAHEAD;
+            if (firActive) estSamples += static_cast<FirConvolver*>(_fir)->latencySamples();
+            levels.latency.aecDelayMs = bridgeDelay16k * 1000.0f / 16000.0f;
+            levels.latency.estimateMs = estSamples * 1000.0f / sampleRate;
+
+            publishLevels();
         }
 
         // ── 13. Write to I2S (stereo output) ──
-        size_t bytesWritten = 0;
-        codec->i2s_write(outBuf, samplesRead * NUM_CHANNELS_OUT * sizeof(int16_t),
-                         &bytesWritten, portMAX_DELAY);
-    }
-
-    // Cleanup
-    delete[] inBuf;
-    delete[] outBuf;
-    delete[] floatL;
-    delete[] floatR;
-    delete[] floatHP;
-    delete[] down16kL;
-    delete[] down16kR;
-    delete[] ns16kIn;
-    delete[] ns16kOut;
-    delete[] up48kL;
-    delete[] up48kR;
-    delete[] veDown16kL;
-    delete[] veDown16kR;
-    delete[] veDown16kHP;
-    delete[] veEst16kL;
-    delete[] veEst16kR;
-    delete[] veEstUp48kL;
-    delete[] veEstUp48kR;
-    delete[] agcDown16kL;
-    delete[] agcDown16kR;
-    delete[] agc16kIn;
-    delete[] agc16kOut;
-
-    // AEC buffers (heap_caps allocated)
-    heap_caps_free(aec16kInL);
-    heap_caps_free(aec16kInR);
-    heap_caps_free(aec16kRef);
-    heap_caps_free(aec16kOutL);
-    heap_caps_free(aec16kOutR);
-    heap_caps_free(vad16kBuf);
-    delete[] aecFloat16kL;
-    delete[] aecFloat16kR;
-    delete[] aecDown16kBlockL;
-    delete[] aecDown16kBlockR;
-    delete[] aecDown16kBlockHP;
+        // Zero-copy: the block already sits in TX DMA memory, only the cache write-back is left
+        // The recorder, USB and RTP get exactly what goes out, before the DMA can reclaim it
+        const bool recordOut = nominalTaps && recorder.wants(AudioRecorder::SOURCE_OUTPUT);
+        const bool usbOut = nominalTaps && usbAudio.wants(UsbAudio::SOURCE_OUTPUT);
+        RtpStream& rtp = RtpStream::getInstance();
+        const bool rtpOut = nominalTaps && rtp.wants();
+        if (zeroCopy) {
+            for (int b = 0; b < samplesRead / BSP_I2S_DMA_FRAME_NUM; b++) {
+                if (!txBufs[b]) continue;
+                if (recordOut) recorder.push(AudioRecorder::SOURCE_OUTPUT, txBufs[b], BSP_I2S_DMA_FRAME_NUM);
+                if (usbOut) usbAudio.push(txBufs[b], BSP_I2S_DMA_FRAME_NUM);
+                if (rtpOut) rtp.push(txBufs[b], BSP_I2S_DMA_FRAME_NUM);
+                bsp_i2s_stream_tx_commit(txBufs[b]);
+            }
+        } else {
+            if (recordOut) recorder.push(AudioRecorder::SOURCE_OUTPUT, outBuf, samplesRead);
+            if (usbOut) usbAudio.push(outBuf, samplesRead);
+            if (rtpOut) rtp.push(outBuf, samplesRead);
+            size_t bytesWritten = 0;
+            codec->i2s_write(outBuf, samplesRead * NUM_CHANNELS_OUT * sizeof(int16_t),
+                             &bytesWritten, portMAX_DELAY);
+        }
+        samplesOut += samplesRead - droppedTail;
+        if (profiling) {
+            lap(AUDIO_STAGE_WRITE);
+            _stageRing.push(stageCycles);
+        }
+    }
+
+    // Cleanup: hand the codec back in its default capture format
+#if CONFIG_PM_ENABLE
+    if (dspPmHeld) esp_pm_lock_release(dspPmLock);
+    if (dspPmLock) esp_pm_lock_delete(dspPmLock);
+#endif
+    if (outputOnly) {
+        std::lock_guard<std::mutex> codecLock(_codecMutex);
+        codec->set_capture_enabled(true);
+        capture = {BSP_CAPTURE_SLOTS_ALL, 16};
+    }
+    heap_caps_free(outputOnlyBuf);
+    if (zeroCopy) bsp_i2s_stream_stop();
+    if (codec->set_capture_profile && (capture.slot_mask != BSP_CAPTURE_SLOTS_ALL || capture.bits != 16)) {
+        const bsp_capture_profile_t defaults = {BSP_CAPTURE_SLOTS_ALL, 16};
+        codec->set_capture_profile(&defaults);
+    }
+    if (sampleRate != SAMPLE_RATE) codec->codec_reconfig_fn(SAMPLE_RATE, 16, static_cast<i2s_slot_mode_t>(4));
+    AudioSession::release(AudioSession::USER_ENGINE);
+    hotArena.destroy();
+    aecArena.destroy();
 
     mclog::tagInfo(TAG, "audio task exiting");
 }
@@ -4,10 +4,23 @@
  * SPDX-License-Identifier: MIT
  */
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <cstdint>
 #include <mutex>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include "audio_params.h"
+#include "../utils/triple_buffer/triple_buffer.h"
+#include "../utils/spsc_ring/spsc_ring.h"
+#include "../utils/oscillator/oscillator.h"
+#include "../utils/wola/wola.h"
+#include "../utils/dsp_kernels/dsp_kernels.h"
+#include "../utils/audio_mixer/audio_mixer.h"
+#include "../utils/core_policy/core_policy.h"
+#include "../utils/task_controller/task_controller.h"
+#include "../utils/scene_classifier/scene_classifier.h"
 
 /**
  * @brief Real-time audio processing engine for Howizard
@@ -15,104 +28,158 @@
  * Runs a continuous mic→DSP→headphone pipeline on a dedicated FreeRTOS task (Core 1).
  * Bypasses the HAL audio API for direct BSP codec access (streaming, not batch).
  *
- * DSP chain: HPF → LPF → EQ(3-band) → [VoiceExclusion] → [NS] → [AGC] → OutputGain → Clamp → Mute
+ * DSP chain (48kHz unless noted):
+ *   HPF → LPF → EQ(3-band)
+ *   → 16kHz bus: ↓3 → [VoiceExclusion] → [NS] → [AGC] → ↑3  (only when one of them is active)
+ *                (band split: above ~7kHz bypasses the bus, delayed and gain-tracked)
+ *   → [Linked AGC] (48kHz, instead of the bus AGC when agcLinked)
+ *   → [VAD gate] → Notches → HF shelf → Tinnitus generators → OutputGain → Clamp → Mute
+ *
+ * In a quiet room (quietPathEnabled) the input filters and the bus stages sleep
+ * until the mics pick up again, and the bus holds the gain they last applied.
+ *
+ * The 48kHz stages between the bus and the generators (spectral, VAD gate, fitted
+ * mixer bus, WDRC, MBC, frequency shift, notches/shelf) are a DspGraph: each is
+ * switched on or off per block, and the plan is recompiled only when that set
+ * changes, so stages that are off cost nothing.
+ *
+ * Filters, EQ, notches and output gain are per ear. Linked ears share one stereo
+ * cascade; unlinked, each ear runs its own (AudioEngineParams::rightEar).
+ *
+ * The block size is selectable at runtime (48/96/240/480 samples). The 16kHz bus
+ * always processes 160-sample frames; smaller blocks are accumulated into a frame
+ * and drained back out, so bus stages add one frame of latency minus one block.
  */
 
-// Tinnitus Relief Parameters
-struct TinnitusReliefParams {
-    // Notch filters (6 configurable notch filters for tinnitus frequency suppression)
-    struct NotchConfig {
-        bool enabled = false;
-        float frequency = 4000.0f;   // Center frequency (500-12000 Hz)
-        float Q = 8.0f;              // Quality factor (1-16, higher = narrower)
-    } notches[6];
-
-    // Masking noise generator
-    int noiseType = 0;               // 0=OFF, 1=WHITE, 2=PINK, 3=BROWN
-    float noiseLevel = 0.3f;         // 0.0-1.0 mix level
-    float noiseLowCut = 100.0f;      // Low cutoff Hz (20-2000)
-    float noiseHighCut = 8000.0f;    // High cutoff Hz (1000-16000)
-
-    // Tone finder (pure tone generator for pitch matching)
-    bool toneFinderEnabled = false;
-    float toneFinderFreq = 4000.0f;  // Frequency (200-12000 Hz)
-    float toneFinderLevel = 0.3f;    // 0.0-1.0 output level
-
-    // High frequency extension (shelf boost)
-    bool hfExtEnabled = false;
-    float hfExtFreq = 8000.0f;       // Shelf frequency (4000-12000 Hz)
-    float hfExtGainDb = 6.0f;        // 0-12 dB boost
-
-    // Binaural beats generator
-    bool binauralEnabled = false;
-    float binauralCarrier = 200.0f;  // Base frequency (50-500 Hz)
-    float binauralBeat = 10.0f;      // Beat frequency (1-40 Hz)
-    float binauralLevel = 0.3f;      // 0.0-1.0 output level
-
-    // Session timer
-    bool sessionActive = false;
-    uint32_t sessionDurationMs = 3600000;  // Session length (default 1 hour)
-    uint32_t sessionElapsedMs = 0;         // Elapsed time
-    float sessionFadeMs = 30000.0f;        // Fade in/out duration (30 sec)
+// Groups of AudioEngineParams fields a UI shows together. Each publish that moves a
+// field stamps its group with the new params generation (AudioParamGenerations).
+// Per-ear groups cover both the left ear's top-level fields and rightEar. Fields no
+// group lists (beam, dynamics, fitting, session...) aren't tracked.
+enum AudioParamField : uint8_t {
+    AUDIO_PARAM_EARS = 0,       // earsLinked
+    AUDIO_PARAM_HPF,            // hpfEnabled, hpfFrequency
+    AUDIO_PARAM_LPF,            // lpfEnabled, lpfFrequency
+    AUDIO_PARAM_EQ,             // eqLowGain, eqMidGain, eqHighGain
+    AUDIO_PARAM_OUTPUT_GAIN,    // outputGain
+    AUDIO_PARAM_NOTCHES,        // tinnitus.notches
+    AUDIO_PARAM_NS,             // nsEnabled, nsMode, nsLinked
+    AUDIO_PARAM_AGC,            // agc*
+    AUDIO_PARAM_VE,             // ve* except the VAD gate
+    AUDIO_PARAM_VE_GATE,        // veVadGateEnabled, veVadGateAtten
+    AUDIO_PARAM_LEVELS,         // outputVolume, micGain
+    AUDIO_PARAM_BOOST,          // boostEnabled
+    AUDIO_PARAM_BLOCK_SIZE,     // blockSize, sampleRate
+    AUDIO_PARAM_NOISE,          // tinnitus.noise*
+    AUDIO_PARAM_TONE_FINDER,    // tinnitus.toneFinder*
+    AUDIO_PARAM_HF_EXT,         // tinnitus.hfExt*
+    AUDIO_PARAM_BINAURAL,       // tinnitus.binaural*
+    AUDIO_PARAM_FIELD_COUNT
+};
+
+// When each field group last changed. Generations only grow; a reader keeps the
+// `latest` it synced to and touches only the groups that moved past it.
+struct AudioParamGenerations {
+    uint32_t latest = 0;
+    uint32_t field[AUDIO_PARAM_FIELD_COUNT] = {};
+
+    bool changedSince(AudioParamField f, uint32_t gen) const
+    {
+        return field[f] > gen;
+    }
+};
+
+// Real-time health of the audio loop (cumulative since start or resetXrunStats())
+struct AudioXrunStats {
+    uint32_t deadlineMisses = 0;  // Blocks whose DSP time exceeded the block period
+    uint32_t lateReads      = 0;  // Read-to-read periods > 1.5 blocks (loop stalled)
+    uint32_t rxOverruns     = 0;  // I2S RX DMA queue overflows (input dropped)
+    uint32_t txUnderruns    = 0;  // I2S TX DMA queue overflows (output starved)
+    uint32_t blockUs        = 0;  // DSP time of the latest block
+    uint32_t worstBlockUs   = 0;  // Worst DSP time seen
+    uint32_t worstPeriodUs  = 0;  // Worst read-to-read period seen
+    bool     aecDegraded    = false;  // Auto-degrade has forced AEC to SR_LOW_COST
+    uint32_t aecLateFrames  = 0;  // Bus frames emitted before the AEC worker returned them (passed dry)
+    uint32_t earLateFrames  = 0;  // Split-ear bus frames where the left lane waited past EAR_SPIN_US for the right
+    // Duplex DMA clock (zero-copy I2S only; all 0 on the codec read/write path)
+    int32_t  txLeadUs       = 0;  // Last input buffer done → first output sample of the block played
+    uint32_t rxBacklog      = 0;  // RX buffers of the next block already waiting (> 0: loop behind)
+    uint32_t clockTrims     = 0;  // 1ms TX slips that pulled the lead back to its target
+};
+
+// Cache traffic of the audio core's data bus over one block's DSP (read done → deadline
+// check). DMA masters bypass the caches, so PSRAM contention from the camera or LCD
+// shows up here as slower misses rather than more of them; a block that missed its
+// deadline with an ordinary miss count was starved, one with a high count thrashed.
+struct AudioCacheStats {
+    bool     available       = false;  // The SoC exposes the counters
+    uint32_t l1Miss          = 0;      // Latest block
+    uint32_t l2Miss          = 0;      // Latest block (L1 misses that went on to PSRAM)
+    float    l1HitPct        = 0.0f;   // Latest block
+    uint32_t worstL2Miss     = 0;      // Most L2 misses in one block
+    uint32_t worstBlockL2Miss = 0;     // L2 misses of the block that set AudioXrunStats::worstBlockUs
+};
+
+// Stages the numerical health monitor tests once per block (or bus frame)
+enum AudioHealthStage : uint8_t {
+    AUDIO_HEALTH_FEEDBACK = 0,  // Feedback canceller NLMS
+    AUDIO_HEALTH_BEAM,          // Beamformer GSC
+    AUDIO_HEALTH_INPUT_FILTERS, // HPF/LPF/EQ cascades
+    AUDIO_HEALTH_VE,            // VE NLMS / FDAF
+    AUDIO_HEALTH_AEC,           // AEC frame bridge
+    AUDIO_HEALTH_LINKED_AGC,    // 48kHz linked AGC
+    AUDIO_HEALTH_CHAIN,         // Hearing chain (DspGraph stages)
+    AUDIO_HEALTH_COUNT
 };
 
-struct AudioEngineParams {
-    // Input
-    float micGain         = 180.0f;  // ES7210 PGA (0-240)
-
-    // Filters
-    bool  hpfEnabled      = true;
-    float hpfFrequency    = 80.0f;   // Hz (20-500)
-    bool  lpfEnabled      = false;
-    float lpfFrequency    = 18000.0f;// Hz (2000-20000)
-
-    // EQ (3-band parametric, peaking filters)
-    float eqLowGain       = 0.0f;    // dB (-12 to +12) @ 250 Hz
-    float eqMidGain       = 0.0f;    // dB (-12 to +12) @ 1000 Hz
-    float eqHighGain      = 0.0f;    // dB (-12 to +12) @ 4000 Hz
-
-    // Noise Suppression (ESP-SR standalone NS)
-    bool  nsEnabled       = false;
-    int   nsMode          = 2;       // 0=Mild, 1=Medium, 2=Aggressive (default: aggressive)
-
-    // AGC (ESP-SR Automatic Gain Control @ 16kHz)
-    bool  agcEnabled           = false;
-    int   agcMode              = 2;      // 0=Saturation, 1=Analog, 2=Digital, 3=Fixed
-    int   agcCompressionGainDb = 9;      // 0–90 dB
-    bool  agcLimiterEnabled    = true;   // Built-in limiter
-    int   agcTargetLevelDbfs   = -3;     // 0 to -31 dBFS
-
-    // Voice Exclusion (NLMS adaptive filter @ 16kHz, uses headset mic as reference)
-    bool  veEnabled        = false;
-    float veBlend          = 0.7f;     // 0.0–1.0: mix of original vs cleaned (higher for better cancellation)
-    float veStepSize       = 0.10f;    // 0.01–1.0: NLMS adaptation rate (slightly faster convergence)
-    int   veFilterLength   = 128;      // 16–512 taps (longer for better voice modeling ~8ms)
-    float veMaxAttenuation = 0.8f;     // 0.0–1.0: safety limit (more aggressive cancellation)
-
-    // Voice Exclusion - Reference signal conditioning (applied to HP mic before NLMS)
-    float veRefGain        = 0.5f;     // 0.1–5.0: reference signal gain multiplier (reduced)
-    float veRefHpf         = 80.0f;    // 20–500 Hz: reference HPF (matches UI default)
-    float veRefLpf         = 4000.0f;  // 1000–8000 Hz: reference LPF (matches UI default)
-
-    // Voice Exclusion - AEC mode (alternative to NLMS)
-    int   veMode           = 0;        // 0=NLMS, 1=AEC
-    int   veAecMode        = 1;        // 0=SR_LOW_COST, 1=SR_HIGH_PERF, 3=VOIP_LOW_COST, 4=VOIP_HIGH_PERF
-    int   veAecFilterLen   = 4;        // 1–6 (AEC filter length parameter)
-    bool  veVadEnabled     = true;     // VAD for double-talk detection (AEC mode)
-    int   veVadMode        = 3;        // 0–4: Normal to Very Very Very Aggressive
-
-    // Voice Exclusion - VAD Gating (attenuates output during non-speech)
-    bool  veVadGateEnabled = true;     // Enable VAD-based gating
-    float veVadGateAtten   = 0.15f;    // 0.0–1.0: attenuation during silence (0.15 = -16dB)
-
-    // Output
-    float outputGain      = 1.5f;    // Linear (0.0-6.0, extended for boost)
-    int   outputVolume    = 100;     // Codec volume (0-100)
-    bool  outputMute      = true;    // MUTED by default (safety)
-    bool  boostEnabled    = false;   // Enable soft clipping for high gain levels
-
-    // Tinnitus Relief (embedded struct)
-    TinnitusReliefParams tinnitus;
+// Blocks a stage returned non-finite or far above full scale; each one reset that
+// stage's state and went out silent
+struct AudioHealthStats {
+    uint32_t resets[AUDIO_HEALTH_COUNT] = {};
+    // Watchdog hot restarts: I2S channels restarted from the audio task, with the work
+    // arena, params and adaptive filters kept
+    uint32_t hotRestarts = 0;
+    uint32_t recoveryUs = 0;      // Last one: last good read → first block back
+    uint8_t  restartReason = 0;   // Last one: AudioRestartReason
+};
+
+// What asked for the last watchdog hot restart
+enum AudioRestartReason : uint8_t {
+    AUDIO_RESTART_NONE = 0,
+    AUDIO_RESTART_READ_STALL,   // RX_STALL_READS reads in a row came back empty
+    AUDIO_RESTART_HEALTH,       // HEALTH_RESTART_RESETS health resets within a second
+    AUDIO_RESTART_WATCHDOG,     // The control task saw no block for WATCHDOG_STALL_MS
+};
+
+// Latency report for the current block size (ms)
+struct AudioLatencyInfo {
+    static constexpr int NUM_MODES = 4;  // Index matches AudioEngine::BLOCK_SIZES
+    static constexpr int RUNS = 8;       // MLS bursts per measurement
+
+    // Where the test signal is picked back up
+    enum Source : uint8_t {
+        SOURCE_LOOPBACK = 0,  // Codec AEC loopback (ch1), electrical round trip
+        SOURCE_HP_MIC,        // Headphone mic (ch3), acoustic round trip through the earpiece
+    };
+
+    int   blockSize  = 480;
+    float estimateMs = 0.0f;      // I/O blocks + TX DMA depth (or duplex lead) + 16kHz bus framing + AEC delay
+    float aecDelayMs = 0.0f;      // Constant 160→512 AEC frame-bridge delay, plus the AFE's with busAfe (0 when off)
+    float measuredMs[NUM_MODES] = {-1.0f, -1.0f, -1.0f, -1.0f};  // Mean end-to-end per mode (-1 = none)
+    float jitterMs[NUM_MODES]   = {-1.0f, -1.0f, -1.0f, -1.0f};  // Std deviation over the runs
+    float spreadMs    = 0.0f;     // Max - min of the last measurement's valid runs
+    float peakRatioDb = 0.0f;     // Weakest valid correlation peak over the correlation RMS
+    int   runsDone    = 0;        // Runs of the last (or current) measurement
+    int   runsValid   = 0;        // Runs with a clear correlation peak
+    uint8_t source    = SOURCE_LOOPBACK;
+    bool  measuring  = false;
+    bool  lastFailed = false;     // No valid run (muted output, no loopback or nothing on the HP mic)
+};
+
+// Head motion from the IMU, AudioEngine::setMotionState()
+enum AudioMotion : uint8_t {
+    AUDIO_MOTION_STILL = 0,
+    AUDIO_MOTION_TURNING,  // Rapid rotation: VE adaptation frozen
+    AUDIO_MOTION_WALKING,  // Gait: VE step halved
 };
 
 struct AudioLevels {
@@ -123,6 +190,120 @@ struct AudioLevels {
     float rmsHP     = 0.0f;  // Headphone mic level (for VE reference monitoring)
     float peakHP    = 0.0f;
     bool  vadSpeechDetected = false;  // VAD state (true = speech detected)
+    bool  ownVoice = false;           // The wearer is talking (HP mic vs room mics, plus VAD)
+    float vadGateGain = 1.0f;  // Smoothed VAD gate gain applied this block (1.0 = open)
+    float nsGainDb    = 0.0f;  // NS output/input level this block (<= 0 = reduction)
+    float agcGainDb   = 0.0f;  // AGC output/input level this block
+    float mbcGainReductionDb[4] = {};  // Deepest per-band compression this block (<= 0)
+    float limiterGainReductionDb = 0.0f;
+    float wdrcGainDb[2] = {};  // Mean fitted band gain this block, [0]=left ear, [1]=right ear
+    float howlHz = 0.0f;       // Frequency of the last detected howl (0 = none yet)
+    int   autoNotches = 0;     // Howl notches currently parked in tinnitus notch slots
+    uint8_t motion = AUDIO_MOTION_STILL;  // Head motion the audio task applied this block
+    float beamSteerDeg = 0.0f;            // Steering angle used this block, motion compensation included
+    uint32_t blockIndex = 0;   // Monotonic audio block counter (10ms per block)
+    uint32_t sessionElapsedMs = 0;  // Tinnitus session progress (0 when no session)
+    float sessionGain = 1.0f;       // Session envelope gain at the end of this block
+    bool  sessionEnded = false;     // Session ran out; DSP stages are powered down
+    bool  outputOnly = false;       // Generators only, capture off (TinnitusReliefParams::outputOnly)
+    int   sampleRate = 48000;       // Rate the engine runs at (AudioEngineParams::sampleRate as of start())
+    bool  quietPath = false;        // Input quiet: input filters and bus stages asleep this block
+    float windLevel = 0.0f;         // Wind detector, 0 = calm to 1 = full wind (0 with windMode off)
+    int8_t windMic = 0;             // Both channels on one mic: -1 = MIC-L, +1 = MIC-R, 0 = both mics
+    AudioXrunStats xrun;
+    AudioCacheStats cache;  // Cleared with the xrun stats
+    AudioHealthStats health;
+    AudioLatencyInfo latency;
+};
+
+// Third-octave band levels of the input (after mic gain) and the output (after the
+// mixer and output gain, before the limiter), from one Hann-windowed 1024-point frame
+// of each, smoothed over a few frames
+struct AudioSpectrum {
+    static constexpr int BANDS = 23;          // Centres 1000 * 2^(k/3) Hz, k = -10..12 (100 Hz - 16 kHz)
+    static constexpr int FIRST_BAND = -10;
+    static constexpr float DB_FLOOR = -90.0f; // dB relative to a full-scale sine
+    float inputDb[BANDS] = {};
+    float outputDb[BANDS] = {};
+    uint32_t frame = 0;                       // Analysed frames since start()
+
+    static float bandHz(int band)
+    {
+        return 1000.0f * exp2f((band + FIRST_BAND) / 3.0f);
+    }
+};
+
+// processLoop stages timed by the optional cycle-count profiler
+enum AudioStage : uint8_t {
+    AUDIO_STAGE_READ = 0,       // 1.  I2S read (includes DMA wait)
+    AUDIO_STAGE_CONVERT_IN,     // 2.  int16 → float extract
+    AUDIO_STAGE_FEEDBACK,       // 2a/7i/8a. Feedback canceller, frequency shift, howl detector
+    AUDIO_STAGE_BEAM,           // 2b. Two-mic beamformer (mono chain only)
+    AUDIO_STAGE_INPUT_FILTERS,  // 3.  HPF → LPF → EQ cascade
+    AUDIO_STAGE_REF_METER,      // 4-5. Reference conditioning + HP metering
+    AUDIO_STAGE_RESAMPLE,       // 7a/7e. 48k ↔ 16k bus
+    AUDIO_STAGE_VE,             // 7b. NLMS / AEC voice exclusion
+    AUDIO_STAGE_NS,             // 7c. Noise suppression
+    AUDIO_STAGE_AGC,            // 7d. AGC
+    AUDIO_STAGE_EAR_JOIN,       // 7d'. Waiting for the Core 0 right-ear lane (split-ear mode)
+    AUDIO_STAGE_SPECTRAL,       // 7e'. Shared WOLA transform + spectral stages
+    AUDIO_STAGE_DYNAMICS,       // 7f-7h. VAD gate, WDRC fitting, multiband compressor
+    AUDIO_STAGE_TINNITUS,       // 8-8e. Notches, shelf, generators, session envelope
+    AUDIO_STAGE_MIXER,          // 8f. SFX / media voices mixed in, program ducking
+    AUDIO_STAGE_CORRECTION,     // 8g. Correction FIR
+    AUDIO_STAGE_OUTPUT,         // 9-12. Limiter, gain, soft clip, metering, int16 convert
+    AUDIO_STAGE_WRITE,          // 13. I2S write (includes DMA wait)
+    AUDIO_STAGE_DSP,            // 2-12. Everything between read and write
+    AUDIO_STAGE_COUNT
+};
+
+struct AudioStageStats {
+    struct Stage {
+        const char* name  = "";
+        uint32_t minCycles = 0;
+        uint32_t avgCycles = 0;
+        uint32_t maxCycles = 0;
+        uint32_t p99Cycles = 0;
+    };
+    Stage stages[AUDIO_STAGE_COUNT];
+    uint32_t windowBlocks = 0;  // Blocks currently in the rolling window
+    uint32_t droppedBlocks = 0; // Samples lost because the consumer fell behind
+    uint32_t cpuMhz = 0;        // Cycles → µs: cycles / cpuMhz
+};
+
+// DSP kernel micro-benchmark: every building block timed on its own over
+// synthetic input, best of several calls, and judged by its share of real
+// time on one core (the same share of every block, whatever the block size)
+struct AudioBenchResult {
+    const char* name = "";
+    uint32_t frames  = 0;             // Samples per timed call, at the kernel's own rate
+    uint32_t rate    = 0;             // 48000 or 16000
+    uint32_t cycles  = 0;             // Best call
+    float cyclesPerSample = 0.0f;
+    float realtimePct = 0.0f;         // Core time per second of audio
+    float limitPct    = 0.0f;         // Fails above this
+    bool  passed      = false;
+};
+
+// Equivalence check run before the timings: the optimized kernel against a
+// plain scalar reference over a log sweep plus noise, worst-case difference
+struct AudioCheckResult {
+    const char* name = "";
+    float maxError  = 0.0f;           // Largest |kernel - reference| (full scale = 1.0)
+    float tolerance = 0.0f;
+    bool  passed    = false;
+};
+
+struct AudioBenchReport {
+    static constexpr int MAX_RESULTS = 17;
+    static constexpr int MAX_CHECKS = 13;
+    AudioBenchResult results[MAX_RESULTS];
+    int count = 0;
+    AudioCheckResult checks[MAX_CHECKS];
+    int checkCount = 0;
+    uint32_t cpuMhz = 0;
+    bool passed = false;              // Every check and every kernel within its limit
+    bool engineRunning = false;       // Ran alongside the audio task (preemption/cache noise)
 };
 
 class AudioEngine {
@@ -133,25 +314,180 @@ public:
     void stop();
     bool isRunning();
 
+    // Voices mixed into the output after the hearing chain (SFX, media playback).
+    // Lets other audio play while the engine owns I2S; see AudioMixer.
+    AudioMixer& mixer()
+    {
+        return _mixer;
+    }
+
     // Thread-safe parameter access
     void setParams(const AudioEngineParams& p);
     AudioEngineParams getParams();
+    // Same snapshot, with the generation each field group last changed in
+    AudioEngineParams getParams(AudioParamGenerations& gens);
+    // Setters between begin and end edit the master copy but publish once, at the end,
+    // so a burst of edits reaches the audio task as one params generation
+    void beginParamBatch();
+    void endParamBatch();
+
+    // A/B comparison: two complete parameter sets held side by side. Their NS/AGC/VAD
+    // handle sets are kept built, and switching dips the output for AB_FADE_MS on each
+    // side of the swap, so the chain's state resets land in silence instead of clicking.
+    // Output volume and mute are the listener's and carry over; edits made while a
+    // slot is active are kept in that slot.
+    static constexpr int AB_FADE_MS = 10;
+    static constexpr int AB_HOLD_MAX_MS = 50;  // Longest wait at the trough for handle sets
+    void setAbSlot(int slot, const AudioEngineParams& p);  // Active slot: switches with the dip
+    bool selectAbSlot(int slot);  // false if the slot was never set
+    int abSlot();                 // Active slot, -1 when not comparing
+    void clearAbSlots();
+    // Latest level frame. Wait-free; call from a single consumer (the UI task).
     AudioLevels getLevels();
+    // Drain per-block level frames (oldest first) for meter smoothing/history.
+    // Wait-free; single consumer. Returns the number of frames copied.
+    size_t drainLevels(AudioLevels* out, size_t maxFrames);
+    static constexpr size_t LEVEL_RING_FRAMES = 256;  // ~2.5s of 10ms blocks
+
+    // Per-stage cycle profiler (off by default; costs a few cycle reads per block).
+    // getStageStats() drains the audio task's samples into a rolling window and
+    // summarizes it; call both from a single consumer (the UI task).
+    void setProfilingEnabled(bool enabled);
+    bool isProfilingEnabled() const;
+    AudioStageStats getStageStats();
+    static constexpr size_t STAGE_WINDOW_BLOCKS = 256;  // ~2.5s of 10ms blocks
+
+    // Input vs output spectrum analyzer (off by default). While enabled the audio task
+    // copies a frame of each 25 times a second and the control task does the
+    // FFT, so the audio core only pays for the copy. Buffers live from the first enable
+    // until stop(). getSpectrum() is true when a newer frame landed in `out`; wait-free,
+    // single consumer (the UI task).
+    void setSpectrumEnabled(bool enabled);
+    bool getSpectrum(AudioSpectrum& out);
+
+    // Level taps: consumers beside the UI. While a tap is enabled the audio task also
+    // hands every TAP_LEVEL_DECIMATION-th level frame to that tap's triple buffer.
+    // getTapLevels() is wait-free, single consumer per tap, and true when a newer
+    // frame landed in `out`.
+    enum LevelTap : uint8_t {
+        LEVEL_TAP_REMOTE = 0,  // RemoteTuning sender task
+        LEVEL_TAP_RS485,       // Modbus slave on the RS485 task
+        LEVEL_TAP_STRESS,      // StressTest harness task
+        LEVEL_TAP_COUNT,
+    };
+    static constexpr uint32_t TAP_LEVEL_DECIMATION = 3;  // 33 frames per second
+    void setLevelTapEnabled(LevelTap tap, bool enabled);
+    bool getTapLevels(LevelTap tap, AudioLevels& out);
+
+    // Remote tuning client: the remote level tap, plus a copy of each spectrum frame
+    // from the control task (the analyzer runs for as long as the UI or the remote
+    // side wants it). getRemoteSpectrum() is single consumer like getTapLevels().
+    void setRemoteTelemetryEnabled(bool enabled);
+    bool getRemoteSpectrum(AudioSpectrum& out);
+
+    // Kernel micro-benchmark (resampler, biquad cascade, NLMS per tap length,
+    // NS/AGC/VAD/AEC, limiter, output stage) on a low-priority Core 1 task,
+    // preceded by equivalence checks of the optimized kernels against scalar
+    // references. Logged with pass/fail per line; poll getBenchmarkReport().
+    bool startBenchmark();                           // false while a run is in progress
+    bool getBenchmarkReport(AudioBenchReport& out);  // true once a finished report is available
+    bool isBenchmarkRunning() const;
+
+    // Deadline-miss policy: when enabled and misses pile up while AEC runs in a
+    // high-cost mode, the audio task drops AEC to SR_LOW_COST until disabled.
+    // Counters are reported in AudioLevels::xrun.
+    void setAutoDegradeEnabled(bool enabled);
+    bool isAutoDegradeEnabled() const;
+    void resetXrunStats();
+
+    // Block size / low-latency mode. Sizes not in BLOCK_SIZES snap to the nearest.
+    void setBlockSize(int samples);
+    // I/O and DSP rate, one of SAMPLE_RATES; a running engine restarts at the new rate
+    void setSampleRate(int hz);
+    // Frame of the WOLA transform shared by spectral stages (applied while any of them is on)
+    void setSpectralFrame(int fftSize, int hop);
+    // 16kHz bus stages see only the low band; the high band bypasses them at 48kHz (BusBandSplit)
+    void setBusBandSplit(bool enabled);
+    // Run the 16kHz bus through one ESP-SR AFE (see AudioEngineParams::busAfe)
+    void setBusAfe(bool enabled);
+    // Quiet path for silent rooms (see AudioEngineParams::quietPathEnabled)
+    void setQuietPath(bool enabled, float thresholdDb, int holdMs);
+    // Scene tiers (see AudioEngineParams::sceneAuto)
+    void setSceneAuto(bool enabled, float quietDb);
+    // Scene the tiers follow; AUDIO_SCENE_BABBLE (every stage as set) while sceneAuto is off
+    AudioScene getScene() const
+    {
+        return static_cast<AudioScene>(_sceneTier.load(std::memory_order_relaxed));
+    }
+    // Correction FIR; the IR is read on the storage task when the number changes
+    void setCorrectionFir(bool enabled, int ir);
+    // Output noise dose (see AudioEngineParams::doseMode); NoiseDosimeter::status() reads it
+    void setDosimeter(int mode, int weighting);
+    static constexpr int BLOCK_SIZES[AudioLatencyInfo::NUM_MODES] = {48, 96, 240, 480};
+    static constexpr int SAMPLE_RATES[3] = {48000, 32000, 24000};
+    // Plays AudioLatencyInfo::RUNS bursts of a maximum-length sequence and cross-correlates
+    // each against its return on the given source. Output must be unmuted. Mean and jitter
+    // land in AudioLevels::latency for the current block size.
+    void requestLatencyMeasurement(int source = AudioLatencyInfo::SOURCE_LOOPBACK);
 
     // Convenience setters
     void setMicGain(float gain);
-    void setHpf(bool enabled, float freq);
-    void setLpf(bool enabled, float freq);
-    void setEqLow(float gainDb);
-    void setEqMid(float gainDb);
-    void setEqHigh(float gainDb);
+    void setCaptureBits(int bits);
+    void setBeamMode(int mode);
+    void setBeamSteering(float degrees);
+    void setBeamMicSpacing(float mm);
+    // Wind / handling noise reduction (see AudioEngineParams::windMode)
+    void setWindReduction(int mode, float hpfMaxHz);
+    // Live steering from a tracker (face detector), overriding beamSteerDeg
+    // without touching params: not persisted, not journaled. NAN hands
+    // steering back to the parameter.
+    void setBeamTracking(float degrees)
+    {
+        _beamTrackDeg.store(std::isnan(degrees) ? degrees : std::clamp(degrees, -90.0f, 90.0f),
+                            std::memory_order_relaxed);
+    }
+    float getBeamTracking() const
+    {
+        return _beamTrackDeg.load(std::memory_order_relaxed);
+    }
+    // Head motion (MotionMonitor): TURNING freezes the VE adaptation, WALKING
+    // halves its step. yawDeg turns the beamSteerDeg beam against the head's
+    // rotation; a tracker's bearing already follows the head and is left
+    // alone. Not persisted, not journaled.
+    void setMotionState(AudioMotion state, float yawDeg)
+    {
+        _motionYawDeg.store(std::isnan(yawDeg) ? 0.0f : std::clamp(yawDeg, -90.0f, 90.0f),
+                            std::memory_order_relaxed);
+        _motionState.store(state, std::memory_order_relaxed);
+    }
+    AudioMotion getMotionState() const
+    {
+        return static_cast<AudioMotion>(_motionState.load(std::memory_order_relaxed));
+    }
+    // Worst block DSP time (us) since the previous call, and the block period it
+    // is measured against; for the CPU governor
+    uint32_t takeBlockPeakUs(uint32_t& periodUs)
+    {
+        periodUs = _blockPeriodUs.load(std::memory_order_relaxed);
+        return _blockPeakUs.exchange(0, std::memory_order_relaxed);
+    }
+    // Per-ear setters (filters, EQ, output gain, notches) write both blocks unless
+    // told otherwise; a right-ear edit is heard only while the ears are unlinked
+    void setEarsLinked(bool linked);
+    void setHpf(bool enabled, float freq, AudioEar ear = AUDIO_EAR_BOTH);
+    void setLpf(bool enabled, float freq, AudioEar ear = AUDIO_EAR_BOTH);
+    void setEqLow(float gainDb, AudioEar ear = AUDIO_EAR_BOTH);
+    void setEqMid(float gainDb, AudioEar ear = AUDIO_EAR_BOTH);
+    void setEqHigh(float gainDb, AudioEar ear = AUDIO_EAR_BOTH);
     void setNsEnabled(bool enabled);
     void setNsMode(int mode);
+    void setNsLinked(bool linked);
     void setAgcEnabled(bool enabled);
     void setAgcMode(int mode);
     void setAgcCompressionGain(int gainDb);
     void setAgcLimiterEnabled(bool enabled);
     void setAgcTargetLevel(int levelDbfs);
+    void setAgcLinked(bool linked);
     void setVeEnabled(bool enabled);
     void setVeBlend(float blend);
     void setVeStepSize(float stepSize);
@@ -163,19 +499,29 @@ public:
     void setVeMode(int mode);
     void setVeAecMode(int mode);
     void setVeAecFilterLen(int len);
+    void setVeAecShared(bool shared);
     void setVeVadEnabled(bool enabled);
     void setVeVadMode(int mode);
-    void setOutputGain(float gain);
+    void setOutputGain(float gain, AudioEar ear = AUDIO_EAR_BOTH);
     void setOutputVolume(int vol);
     void setMute(bool mute);
     void setBoostEnabled(bool enabled);
     void setVeVadGateEnabled(bool enabled);
     void setVeVadGateAtten(float atten);
+    // Own-voice detector (see AudioEngineParams::ownVoiceRatioDb)
+    void setOwnVoice(float ratioDb, float duckDb);
+
+    // Feedback cancellation setters
+    void setFbcEnabled(bool enabled);
+    void setFbcFilterLength(int taps);
+    void setFbcStepSize(float stepSize);
+    void setFbcShift(float hz);
+    void setHowlSuppression(bool enabled);
 
     // Tinnitus relief setters
-    void setNotchEnabled(int idx, bool enabled);
-    void setNotchFrequency(int idx, float freq);
-    void setNotchQ(int idx, float Q);
+    void setNotchEnabled(int idx, bool enabled, AudioEar ear = AUDIO_EAR_BOTH);
+    void setNotchFrequency(int idx, float freq, AudioEar ear = AUDIO_EAR_BOTH);
+    void setNotchQ(int idx, float Q, AudioEar ear = AUDIO_EAR_BOTH);
     void setNoiseType(int type);
     void setNoiseLevel(float level);
     void setNoiseLowCut(float freq);
@@ -190,6 +536,26 @@ public:
     void setBinauralCarrier(float freq);
     void setBinauralBeat(float freq);
     void setBinauralLevel(float level);
+    void setSessionActive(bool active);
+    void setSessionDuration(uint32_t ms);
+    void setSessionFade(float ms);
+    void setOutputOnly(bool enabled);
+
+    // Dynamics setters
+    void setMbcEnabled(bool enabled);
+    void setMbcBandCount(int bands);
+    void setMbcCrossover(int idx, float freq);
+    void setMbcBand(int idx, float thresholdDb, float ratio, float attackMs, float releaseMs, float makeupDb);
+    void setLimiter(bool enabled, float ceilingDb, float releaseMs);
+
+    // Hearing-loss fitting setters (ear: 0=left, 1=right)
+    void setWdrcEnabled(bool enabled);
+    void setWdrcBandCount(int bands);
+    void setAudiogram(int ear, const float* thresholdsDbHl);  // FittingParams::NUM_FREQS values
+    void setWdrcCalibration(float dbSpl);
+    void setWdrcMaxGain(float db);
+    void setWdrcTiming(float attackMs, float releaseMs);
+    void setFrequencyLowering(bool enabled, float cutoffHz, float ratio);
 
 private:
     AudioEngine() = default;
@@ -197,66 +563,224 @@ private:
     AudioEngine(const AudioEngine&) = delete;
     AudioEngine& operator=(const AudioEngine&) = delete;
 
-    // Biquad filter (Direct Form II Transposed)
-    struct Biquad {
-        float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f;
-        float a1 = 0.0f, a2 = 0.0f;
-        float z1 = 0.0f, z2 = 0.0f;
+    // Nonlinear frequency compression as a client of the shared WOLA frame.
+    // Bins above the cutoff are remapped on a log-frequency scale; a phase
+    // vocoder carries each bin's instantaneous frequency through the same map
+    // and re-accumulates the output phase, so moved tones stay tones. Only
+    // bins above the cutoff are touched; atan2 and sin/cos are polynomials.
+    struct FrequencyCompressor {
+        static constexpr int MAX_BINS = WolaProcessor::MAX_FFT / 2 + 1;
 
-        float process(float in);
+        // Takes effect on the next frame (tables are rebuilt for the frame layout)
+        void configure(float cutoffHz, float ratio);
         void reset();
+        static void processFrame(void* ctx, WolaProcessor::Frame& frame);
+
+    private:
+        void rebuild(int bins, float binHz);
+        void compress(float* spec, int ch, int bins, int hop);
+
+        float _cutoffHz = 2000.0f, _ratio = 2.0f;
+        bool _dirty = true;
+        int _bins = 0;                       // Layout the tables were built for
+        float _binHz = 0.0f;
+        int _firstBin = 0;                   // First bin above the cutoff
+        float _mapBin[MAX_BINS] = {};        // Destination of each bin centre (bins)
+        float _mapSlope[MAX_BINS] = {};      // d(destination) / d(source) at the centre
+        float _anaPhase[2][MAX_BINS] = {};   // Last analysis phase per source bin
+        float _synPhase[2][MAX_BINS] = {};   // Accumulated output phase per destination bin
+        float _power[MAX_BINS] = {};         // Per-channel scratch: power landing in each bin
+        float _peak[MAX_BINS] = {};          //   strongest contribution
+        float _freqBin[MAX_BINS] = {};       //   and its mapped frequency (bins)
     };
 
-    void calcHpfCoeffs(Biquad& bq, float freq, float sampleRate);
-    void calcLpfCoeffs(Biquad& bq, float freq, float sampleRate);
-    void calcPeakEqCoeffs(Biquad& bq, float freq, float gainDb, float Q, float sampleRate);
-    void calcNotchCoeffs(Biquad& bq, float freq, float Q, float sampleRate);
-    void calcHighShelfCoeffs(Biquad& bq, float freq, float gainDb, float sampleRate);
-    void recalcAllCoeffs();
-
-    // FreeRTOS task
+    // Cascade slot layout
+    enum InputSlot { SLOT_HPF = 0, SLOT_LPF, SLOT_EQ_LOW, SLOT_EQ_MID, SLOT_EQ_HIGH };
+    enum TinnitusSlot { SLOT_NOTCH0 = 0, SLOT_HF_EXT = 6 };
+    enum NoiseSlot { SLOT_NOISE_HPF = 0, SLOT_NOISE_LPF };
+
+    void recalcAllCoeffs(const AudioEngineParams& p);
+    // One ear's filter, EQ and notch sections, those that moved from o (all: every one)
+    void recalcEarCoeffs(BiquadCascade& input, BiquadCascade& tinnitus, const EarParams& e, const EarParams& o,
+                         bool all);
+    static void maskBuildStages(AudioEngineParams& p);
+    // What runs at sampleRate: the 16kHz bus stages need a whole ratio to it (48 or 32 kHz)
+    static void maskRateStages(AudioEngineParams& p, int sampleRate);
+    void publishParams();
+    static uint32_t changedParamFields(const AudioEngineParams& a, const AudioEngineParams& b);
+    void pinAbHandles();  // Caller holds _mutex
+
+    // FreeRTOS tasks
     static void audioTask(void* param);
     void processLoop();
-
-    // Per-channel filter state (L and R)
-    Biquad _hpfL, _hpfR;
-    Biquad _lpfL, _lpfR;
-    Biquad _eqLowL, _eqLowR;
-    Biquad _eqMidL, _eqMidR;
-    Biquad _eqHighL, _eqHighR;
+    struct HearingChain;  // processLoop's DspGraph stages (audio_engine.cpp)
+    static void aecTask(void* param);
+    void aecWorkerLoop();
+    static void earTask(void* param);
+    void earWorkerLoop();
+    static void controlTask(void* param);
+    static void benchTask(void* param);
+    void runBenchmark(AudioBenchReport& report);
+    void runKernelChecks(AudioBenchReport& report);
+    void controlLoop();
+    void analyseLatencyCapture();
+    bool allocSpectrumBuffers();
+    bool updateSpectrumEnabled();
+    void analyseSpectrumCapture();
+
+    // Stereo input filters: HPF → LPF → EQ(3-band). With the ears unlinked the
+    // left ear runs mono on _inputCascade and the right one on _inputCascadeR
+    BiquadCascade _inputCascade;
+    BiquadCascade _inputCascadeR;
 
     // VE reference signal conditioning filters (mono, applied to HP mic)
     Biquad _veRefHpfBq;
     Biquad _veRefLpfBq;
 
-    // Tinnitus relief filters (per-channel)
-    Biquad _notchL[6], _notchR[6];    // 6 notch filters
-    Biquad _hfExtL, _hfExtR;           // High-frequency extension shelf
-    Biquad _noiseLpfL, _noiseLpfR;     // Noise band-limiting LPF
-    Biquad _noiseHpfL, _noiseHpfR;     // Noise band-limiting HPF
+    // Tinnitus relief filters: 6 notches → HF extension shelf (stereo)
+    BiquadCascade _tinnitusCascade;
+    BiquadCascade _tinnitusCascadeR;  // Right ear's, unlinked
+    // Masking noise band-limiting: HPF → LPF (stereo, decorrelated channels)
+    BiquadCascade _noiseCascade;
+
+    // Shared analysis/synthesis for the spectral stages (7e'), sized while a client is registered
+    WolaProcessor _wola;
+    AudioMixer _mixer;
+    FrequencyCompressor _nfc;
+
+    // Audiogram-fitted WDRC (7g) and 48kHz multiband compressor (7h)
+    WdrcFilterbank _wdrc;
+    MultibandDynamics _mbc;
 
     // Tone generator state
-    float _tonePhase = 0.0f;
-    float _binauralPhaseL = 0.0f;
-    float _binauralPhaseR = 0.0f;
-    uint32_t _noiseState = 0x12345678; // PRNG state for noise
+    Oscillator _toneOsc;
+    Oscillator _binauralOscL;
+    Oscillator _binauralOscR;
 
     // VAD gate smoothing state (prevents clicks on speech/silence transitions)
     float _vadGateSmoothed = 1.0f;
 
     // State
-    AudioEngineParams _params;
-    AudioLevels _levels;
-    std::mutex _mutex;
-    bool _running = false;
-    bool _paramsChanged = true;  // Force initial coefficient calc
-    TaskHandle_t _taskHandle = nullptr;
-
+    AudioEngineParams _params;   // Writer-side master copy (guarded by _mutex)
+    std::mutex _mutex;           // Serializes UI-side writers; never taken for params on the audio task
+    int _paramBatchDepth = 0;    // Open beginParamBatch() calls (guarded by _mutex)
+    bool _paramBatchDirty = false;  // A setter ran inside the batch
+    AudioEngineParams _paramsGenBase;    // _params as of the last publish, diffed for generations (guarded by _mutex)
+    AudioParamGenerations _paramGens;    // Guarded by _mutex
+    AudioEngineParams _abParams[2];  // A/B slots (guarded by _mutex)
+    bool _abLoaded[2] = {false, false};
+    int _abActive = -1;
+    std::atomic<bool> _abSwitchPending{false};  // Next params generation is a slot switch
+    std::atomic<bool> _running{false};
+
+    // Params handoff to the audio task (wait-free, latest value wins)
+    TripleBuffer<AudioEngineParams> _paramsBuffer;
+
+    // Level telemetry from the audio task (latest frame + per-block history)
+    TripleBuffer<AudioLevels> _levelsBuffer;
+    SpscRing<AudioLevels, LEVEL_RING_FRAMES> _levelsRing;
+
+    // Stage profiler: raw per-block samples from the audio task, then the
+    // consumer-side rolling window the stats are computed over
+    struct StageCycles {
+        uint32_t cycles[AUDIO_STAGE_COUNT];
+    };
+    std::atomic<bool> _profilingEnabled{false};
+    SpscRing<StageCycles, 64> _stageRing;
+
+    std::atomic<float> _beamTrackDeg{NAN};  // setBeamTracking(), read by the audio task each block
+    std::atomic<uint8_t> _motionState{AUDIO_MOTION_STILL};  // setMotionState(), likewise
+    std::atomic<float> _motionYawDeg{0.0f};
+    std::atomic<uint32_t> _blockPeakUs{0};    // Written by the audio task, reset by takeBlockPeakUs()
+    std::atomic<uint32_t> _blockPeriodUs{0};
+
+    // Deadline-miss detector controls (read by the audio task each block)
+    std::atomic<bool> _autoDegradeEnabled{false};
+    std::atomic<bool> _xrunResetRequested{false};
+    std::atomic<bool> _latencyProbeRequested{false};
+    std::atomic<int> _latencySource{AudioLatencyInfo::SOURCE_LOOPBACK};
+    uint32_t _stageWindow[AUDIO_STAGE_COUNT][STAGE_WINDOW_BLOCKS] = {};
+    size_t _stageWindowHead = 0;
+    size_t _stageWindowCount = 0;
+
+    // Latency test: the audio task plays an MLS burst and captures its return, the control
+    // task correlates the capture and hands back the lag. Buffers live from the first
+    // request until stop().
+    static constexpr int LAT_MLS_LEN = 1023;             // Order-10 sequence, ~21 ms
+    static constexpr int LAT_MAX_LAG = 4096;             // Search window, ~85 ms
+    static constexpr int LAT_CAPTURE_LEN = LAT_MLS_LEN + LAT_MAX_LAG;
+    static constexpr float LAT_MIN_PEAK_RATIO = 8.0f;    // 18 dB over the correlation RMS
+    float* _latMls = nullptr;                            // ±1 chips
+    float* _latCapture = nullptr;                        // LAT_CAPTURE_LEN samples from burst start
+    std::atomic<bool> _latCaptureReady{false};           // Capture handed to the control task
+    std::atomic<int32_t> _latLagQ8{-1};                  // Lag in 1/256 samples, < 0 = no peak
+    std::atomic<float> _latPeakRatio{0.0f};
+
+    // Spectrum analyzer: the audio task fills _specCapture (input frame, then output frame,
+    // mono) and hands it over with _specCaptureReady; the control task transforms both in
+    // one complex FFT and publishes band levels. Latest frame wins, the UI only ever
+    // draws the newest, hence a triple buffer rather than a ring.
+    static constexpr int SPEC_FFT = 1024;                // 46.9 Hz bins, 21 ms
+    static constexpr int SPEC_INTERVAL = 1920;           // Samples between frame starts (25 per second)
+    static constexpr float SPEC_SMOOTH = 0.4f;           // Per-frame step of the band power average
+    std::atomic<bool> _spectrumEnabled{false};           // UI or remote wants it
+    bool _spectrumUi = false;                            // Guarded by _mutex
+    bool _spectrumRemote = false;                        // Guarded by _mutex
+    std::atomic<bool> _specCaptureReady{false};
+    float* _specCapture = nullptr;                       // 2 * SPEC_FFT samples (PSRAM)
+    float* _specWindow = nullptr;                        // Hann, SPEC_FFT (internal)
+    float* _specFft = nullptr;                           // Complex SPEC_FFT (internal, 16-byte aligned)
+    float _specPower[2][AudioSpectrum::BANDS] = {};      // Control task: smoothed band power
+    uint32_t _specFrame = 0;
+    TripleBuffer<AudioSpectrum> _spectrumBuffer;
+
+    // Level taps and the remote spectrum copy
+    std::atomic<uint8_t> _levelTaps{0};  // Bit per LevelTap
+    TripleBuffer<AudioLevels> _tapLevelsBuffer[LEVEL_TAP_COUNT];
+    std::atomic<bool> _remoteSpectrum{false};
+    TripleBuffer<AudioSpectrum> _remoteSpectrumBuffer;
+
+    // Benchmark report, written by the bench task and published by _benchReady
+    AudioBenchReport _benchReport;
+    std::atomic<bool> _benchBusy{false};
+    std::atomic<bool> _benchReady{false};
+
+    // Params the current filter coefficients were computed from (dirty tracking)
+    AudioEngineParams _coeffParams;
+    bool _coeffParamsValid = false;
+    bool _earsSplit = false;  // The per-ear cascades run unlinked (set with the coefficients)
+    TaskController_t _audioTask;
+    static constexpr uint32_t STOP_TIMEOUT_MS = 500;  // Per task; the audio task's longest block is one I2S read
+
+    // Audio watchdog. The audio task restarts its own I/O in place (bsp_i2s_reset, the capture
+    // profile rewritten, stream history dropped): nothing is freed or re-created, so sound is back
+    // within a few blocks. It asks for that itself on a dead RX stream or a health-reset storm;
+    // the control task asks on missing block heartbeats and wakes it
+    static constexpr uint32_t RX_STALL_MS = 20;         // Read wait before a read counts as empty
+    static constexpr int RX_STALL_READS = 2;
+    static constexpr uint32_t WATCHDOG_POLL_MS = 20;    // Control task wake period while running
+    static constexpr uint32_t WATCHDOG_STALL_MS = 80;   // Above one output-only write (42.7ms)
+    static constexpr int HEALTH_RESTART_RESETS = 8;
+    std::atomic<uint32_t> _audioBeat{0};                // Blocks written
+    std::atomic<uint8_t> _restartRequest{AUDIO_RESTART_NONE};
+
+    // Nominal rate: the 16kHz bus, the fixed EQ tables and the benchmark are built for it. What the
+    // engine actually runs at is _sampleRate, latched from _params.sampleRate at start()
     static constexpr int SAMPLE_RATE = 48000;
-    static constexpr int BLOCK_SIZE = 480;      // ~10.0ms latency (480/48000 = 10ms)
-    static constexpr int NUM_CHANNELS_IN = 4;   // MIC-L, AEC, MIC-R, MIC-HP
+    int _sampleRate = SAMPLE_RATE;
+    static constexpr int BLOCK_SIZE = 480;      // Largest block and the 10ms metering frame
+    static constexpr int OUTPUT_ONLY_BLOCK = 2048;  // Output-only mode: samples generated per write (42.7ms)
+    static constexpr int NUM_CHANNELS_IN = 4;   // MIC-L, AEC (playback reference), MIC-R, MIC-HP
     static constexpr int NUM_CHANNELS_OUT = 2;  // Stereo
     static constexpr int NS_FRAME_16K = 160;    // 10ms @ 16kHz (480/3)
+    static constexpr int NLMS_MAX_TAPS = 512;   // Time-domain VE cost ceiling
+    static constexpr int FBC_MAX_TAPS = 512;    // 48kHz feedback path ceiling (10.7ms)
+    static constexpr int FDAF_MAX_TAPS = 2048;  // 128ms @ 16kHz
+    static constexpr size_t INTERNAL_RAM_RESERVE = 32 * 1024;  // Internal RAM left for other tasks after the work arena
+
+    // Deadline-miss detector: degrade trigger
+    static constexpr int DEGRADE_WINDOW_S = 1;                  // Observation window
+    static constexpr int DEGRADE_MISS_THRESHOLD = 5;            // Misses per window that trigger degrade
 
     // Peak hold decay factor per block (~300ms decay)
     static constexpr float PEAK_DECAY = 0.97f;
@@ -269,11 +793,43 @@ private:
     void* _agcHandleL = nullptr;
     void* _agcHandleR = nullptr;
 
-    // NLMS Voice Exclusion filter instances (opaque, typed in .cpp)
-    void* _nlmsL = nullptr;
-    void* _nlmsR = nullptr;
+    // NLMS Voice Exclusion filter, both channels on a shared reference (opaque, typed in .cpp)
+    void* _nlms = nullptr;
+    // Partitioned frequency-domain NLMS for long paths (veMode 2, opaque, typed in .cpp)
+    void* _fdaf = nullptr;
+    // Per-band NLMS behind a 9-band WOLA bank (veMode 3, opaque, typed in .cpp)
+    void* _subband = nullptr;
+    // Feedback canceller: same stereo NLMS at 48kHz on the playback loopback (opaque, typed in .cpp)
+    void* _fbc = nullptr;
+    // Correction FIR (opaque, typed in .cpp). The storage task reads the IR and builds the
+    // convolver, the audio task swaps it in whole, the control task frees the one it replaced
+    void* _fir = nullptr;                  // Audio task
+    SpscRing<void*, 4> _firHandover;       // Storage task → audio task
+    SpscRing<void*, 4> _firRetired;        // Audio task → control task
+    std::atomic<int> _firWanted{0};        // IR number while enabled, 0 = none
+    static void loadFirJob(void* arg);
+
+    // Scene tiers: the audio task sums SceneFrames, the control task classifies them
+    static constexpr int SCENE_FRAME_MS = 30;
+    SpscRing<SceneFrame, 64> _sceneFrames;  // Audio task → control task (~2s)
+    std::atomic<uint8_t> _sceneTier{AUDIO_SCENE_BABBLE};
+    std::atomic<float> _sceneQuietDb{-50.0f};
+    static uint8_t sceneStages(const AudioEngineParams& p, AudioScene scene);
+    static void applySceneTier(AudioEngineParams& p, AudioScene scene);
+    void setSceneTier(AudioScene scene);  // Control task
+
+    // Noise dose: the audio task hands one weighted second at a time to the control task,
+    // which feeds NoiseDosimeter and returns the limit it asks for
+    struct DoseSecond {
+        float meanSquare;  // Louder ear, weighted, after the limiter
+        float cutDb;       // Dose cut applied over the second
+        float seconds;
+    };
+    SpscRing<DoseSecond, 8> _doseSeconds;     // Audio task → control task
+    std::atomic<float> _doseLimitDb{0.0f};    // Control task → audio task
+    std::atomic<float> _doseCalDbSpl{100.0f};
 
-    // AEC handles (opaque pointers, typed in .cpp via esp_aec.h)
+    // AEC handles (opaque pointers, typed in .cpp via esp_aec.h), owned by the AEC worker
     void* _aecHandleL = nullptr;
     void* _aecHandleR = nullptr;
 
@@ -282,4 +838,116 @@ private:
 
     // AEC frame bridging constants
     static constexpr int AEC_FRAME_16K = 512;  // AEC needs 512 samples @ 16kHz (32ms)
+
+    // AEC worker (Core 0): runs aec_process for both channels off the I/O core,
+    // one AEC frame behind the audio task
+    struct AecJob {
+        uint32_t epoch = 0;  // Frame-bridge generation; results from an older one are dropped
+        int64_t  pos = 0;    // First 16kHz bus sample of the frame
+        int16_t  inL[AEC_FRAME_16K];
+        int16_t  inR[AEC_FRAME_16K];
+        int16_t  ref[AEC_FRAME_16K];
+    };
+    struct AecResult {
+        uint32_t epoch = 0;
+        int64_t  pos = 0;
+        int16_t  outL[AEC_FRAME_16K];
+        int16_t  outR[AEC_FRAME_16K];
+    };
+    SpscRing<AecJob, 2> _aecJobs;         // Audio task → worker
+    SpscRing<AecResult, 2> _aecResults;   // Worker → audio task
+    std::atomic<int> _aecConfig{-1};      // Wanted handles (packAecConfig()/packAfeConfig() in .cpp), -1 = none
+    std::atomic<bool> _aecReady{false};   // Worker holds handles for the current _aecConfig
+    std::atomic<int> _afeLag16k{0};       // busAfe: the AFE's own delay, on top of the bridge's
+    TaskController_t _aecTask;
+
+    // Split-ear mode (earSplit): per bus frame the audio task hands the right
+    // lane's NS → AGC to a Core 0 worker, runs the left lane itself and joins
+    // before the frame goes on. The reference VAD and VE before them run once.
+    struct EarLane {
+        float* f = nullptr;        // The lane's bus frame, float in and out
+        int16_t* q = nullptr;      // int16 ping-pong pair
+        int16_t* qNext = nullptr;
+        void* ns = nullptr;        // nullptr = stage off for this frame
+        void* agc = nullptr;
+        float pow[3] = {};         // Lane power into NS, out of NS, out of AGC
+    };
+    static void runEarLaneNs(EarLane& lane);   // float → int16, NS
+    static void runEarLaneAgc(EarLane& lane);  // AGC, int16 → float
+    static constexpr uint32_t EAR_SPIN_US = 1000;  // The join spins this long, then blocks
+    EarLane _earLane;                      // The right lane; the worker's while _earPending
+    std::atomic<bool> _earPending{false};
+    TaskController_t _earTask;
+
+    // Control task: a low-priority Core 0 task that owns the control-plane I2C
+    // (codec volume/mute/PGA, jack detect) so the audio task never issues it.
+    // Codec settings are diffed against what was last written and only changes
+    // go out; the audio task reads the jack state once per block.
+    static constexpr int HP_POLL_MS = 100;
+    static constexpr int PGA_SETTLE_MS = 300;   // Mic gain must hold this long before the PGA moves
+    std::atomic<bool> _hpDetected{false};
+    TaskController_t _ctlTask;
+    std::atomic<int> _codecVolumeWanted{100};
+    std::atomic<bool> _codecMuteWanted{true};
+    std::atomic<float> _micGainWanted{0.0f};
+    std::atomic<float> _micPgaApplied{NAN};     // dB the ES7210 PGA is at; NaN until first written
+    std::atomic<bool> _codecResync{false};      // Codec state unknown: rewrite it all
+    std::mutex _codecMutex;                     // Control task vs capture-profile switches
+    // Output power: with the speaker amp held off, the ES8388 DAC and drivers only matter while
+    // headphones are in and unmuted (or a latency test plays). Powered off once that has been
+    // untrue for OUTPUT_IDLE_MS, so a mute tap doesn't cycle them; back on at once. The unused
+    // ES7210 mics go down with each capture profile, in the BSP.
+    static constexpr int OUTPUT_IDLE_MS = 2000;
+    std::atomic<bool> _outputPowered{true};     // Control task; the latency bursts wait for it
+    std::atomic<bool> _probeBusy{false};        // Audio task: a latency test is armed or running
+
+    // NS/AGC/VAD handles are built by the same worker and handed over whole, so
+    // ns_pro_create/esp_agc_open/vad_create never run on the audio core. The
+    // old set keeps running until its replacement arrives; released sets go back
+    // to the worker, which keeps the most recent modes warm for quick switching.
+    enum SrKind { SR_NS = 0, SR_AGC, SR_VAD, SR_KINDS };
+    static constexpr int SR_WARM_PER_KIND = 2;
+    struct SrHandles {
+        int      kind = SR_NS;
+        int      mode = -1;
+        uint32_t request = 0;  // _srRequest word this set answers
+        void*    l = nullptr;
+        void*    r = nullptr;  // Unused for VAD
+    };
+    SpscRing<SrHandles, 8> _srHandover;  // Worker → audio task
+    SpscRing<SrHandles, 8> _srRetired;   // Audio task → worker
+    std::atomic<uint32_t> _srRequest[SR_KINDS]{};  // (seq << 8) | (mode + 1); low byte 0 = nothing to build
+    int _srMode[SR_KINDS] = {-1, -1, -1};         // Installed mode per kind (audio task only)
+    std::atomic<uint32_t> _srPinned[SR_KINDS]{};   // Bit per mode an A/B slot needs kept warm
+    uint32_t _srSeq = 0;
+
+    // Audio task side: ask for / install / release handle sets
+    void requestSrHandles(int kind, int mode);
+    unsigned installSrHandles();  // Returns a mask of (1 << kind) for sets installed
+    bool srHandlesPending() const;  // A requested set hasn't been installed yet
+    void retireSrHandles(const SrHandles& h);
+    // Worker side: recycle released sets and answer new requests
+    static void buildSrHandles(SrHandles& h);
+    static void freeSrHandles(SrHandles& h);
+    void serviceSrHandles(SrHandles (*pool)[SR_WARM_PER_KIND], uint32_t* served);
+
+    // Pre-rendered masking noise: the worker renders a band-limited, seamlessly
+    // looping stretch into PSRAM (int16, interleaved L/R) whenever the noise
+    // type or cuts change, a slice per pass so AEC frames keep their deadline.
+    // The audio task plays it with one mix-add per sample and generates live
+    // noise until a loop for the current settings is ready.
+    static constexpr int NOISE_LOOP_FRAMES = 8 * SAMPLE_RATE;  // 8s, 1.5MB per buffer
+    static constexpr int NOISE_LOOP_XFADE = SAMPLE_RATE / 4;   // Loop-seam crossfade
+    struct NoiseLoopSpec {
+        uint32_t seq = 0;
+        int      type = 0;  // noiseType; 0 cancels any render
+        float    lowCut = 0.0f;
+        float    highCut = 0.0f;
+    };
+    struct NoiseLoopRender;  // Worker-side render state (.cpp)
+    SpscRing<NoiseLoopSpec, 4> _noiseLoopRequests;  // Audio task → worker
+    std::atomic<uint32_t> _noiseLoopDone{0};        // (seq << 1) | buffer of the last finished loop
+    std::atomic<uint32_t> _noiseLoopInUse{0};       // Bit per buffer the audio task may read
+    int16_t* _noiseLoop[2] = {};
+    void serviceNoiseLoop(NoiseLoopRender& r);
 };
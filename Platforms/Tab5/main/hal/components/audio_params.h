@@ -0,0 +1,287 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <cstdint>
+
+/*
+ * AudioEngineParams and the blocks it embeds, apart from the engine: the
+ * profile format (ProfileSchema) and the desktop tools use them without the
+ * FreeRTOS and ESP-SR headers audio_engine.h pulls in.
+ */
+
+// Tinnitus Relief Parameters
+struct TinnitusReliefParams {
+    // Notch filters (6 configurable notch filters for tinnitus frequency suppression)
+    struct NotchConfig {
+        bool enabled = false;
+        float frequency = 4000.0f;   // Center frequency (500-12000 Hz)
+        float Q = 8.0f;              // Quality factor (1-16, higher = narrower)
+    } notches[6];
+
+    // Masking noise generator
+    int noiseType = 0;               // 0=OFF, 1=WHITE, 2=PINK, 3=BROWN
+    float noiseLevel = 0.3f;         // 0.0-1.0 mix level
+    float noiseLowCut = 100.0f;      // Low cutoff Hz (20-2000)
+    float noiseHighCut = 8000.0f;    // High cutoff Hz (1000-16000)
+
+    // Tone finder (pure tone generator for pitch matching)
+    bool toneFinderEnabled = false;
+    float toneFinderFreq = 4000.0f;  // Frequency (200-12000 Hz)
+    float toneFinderLevel = 0.3f;    // 0.0-1.0 output level
+
+    // High frequency extension (shelf boost)
+    bool hfExtEnabled = false;
+    float hfExtFreq = 8000.0f;       // Shelf frequency (4000-12000 Hz)
+    float hfExtGainDb = 6.0f;        // 0-12 dB boost
+
+    // Binaural beats generator
+    bool binauralEnabled = false;
+    float binauralCarrier = 200.0f;  // Base frequency (50-500 Hz)
+    float binauralBeat = 10.0f;      // Beat frequency (1-40 Hz)
+    float binauralLevel = 0.3f;      // 0.0-1.0 output level
+
+    // Session timer: the whole output fades in, plays for the duration and fades
+    // out; once it ends the bus and generators stop until the session is restarted
+    bool sessionActive = false;
+    uint32_t sessionDurationMs = 3600000;  // Session length (default 1 hour)
+    uint32_t sessionElapsedMs = 0;         // Start point when sessionActive turns on (resume)
+    float sessionFadeMs = 30000.0f;        // Fade in/out duration (30 sec)
+
+    // Output only: the generators and mixer voices go straight out in OUTPUT_ONLY_BLOCK
+    // blocks with capture off (RX channel disabled, ES7210 powered down). The mics and
+    // the whole hearing chain are idle meanwhile; for overnight masking
+    bool outputOnly = false;
+};
+
+// 48kHz dynamics: multiband compressor (after the bus) and look-ahead limiter (after output gain)
+struct DynamicsParams {
+    bool  mbcEnabled = false;           // Full-band alternative to the 16kHz AGC (AGC is skipped while on)
+    int   mbcBands   = 3;               // 3 or 4
+    float crossoverHz[3] = {250.0f, 2000.0f, 6000.0f};  // Ascending split points (third one: 4 bands)
+    struct BandConfig {
+        float thresholdDb = -24.0f;     // dBFS (-60 to 0)
+        float ratio       = 2.0f;       // 1-20 : 1
+        float attackMs    = 5.0f;       // 0.1-100
+        float releaseMs   = 120.0f;     // 10-2000
+        float makeupDb    = 0.0f;       // 0-24 dB
+    } bands[4];
+
+    bool  limiterEnabled   = false;     // Brickwall on the final output (1.3ms look-ahead)
+    float limiterCeilingDb = -1.0f;     // dBFS (-12 to 0)
+    float limiterReleaseMs = 50.0f;     // 5-1000
+};
+
+// Which ear a per-ear setter writes
+enum AudioEar : uint8_t {
+    AUDIO_EAR_LEFT = 0,
+    AUDIO_EAR_RIGHT,
+    AUDIO_EAR_BOTH,  // Both blocks, so they still match when the ears are unlinked
+};
+
+// One ear's input filters, EQ, notches and output gain. AudioEngineParams keeps the
+// left ear in its top-level fields and the right one in rightEar.
+struct EarParams {
+    bool  hpfEnabled   = true;
+    float hpfFrequency = 80.0f;
+    bool  lpfEnabled   = false;
+    float lpfFrequency = 18000.0f;
+    float eqLowGain    = 0.0f;
+    float eqMidGain    = 0.0f;
+    float eqHighGain   = 0.0f;
+    TinnitusReliefParams::NotchConfig notches[6];
+    float outputGain   = 1.5f;
+
+    bool operator==(const EarParams& o) const
+    {
+        if (hpfEnabled != o.hpfEnabled || hpfFrequency != o.hpfFrequency || lpfEnabled != o.lpfEnabled ||
+            lpfFrequency != o.lpfFrequency || eqLowGain != o.eqLowGain || eqMidGain != o.eqMidGain ||
+            eqHighGain != o.eqHighGain || outputGain != o.outputGain) {
+            return false;
+        }
+        for (int i = 0; i < 6; i++) {
+            if (notches[i].enabled != o.notches[i].enabled || notches[i].frequency != o.notches[i].frequency ||
+                notches[i].Q != o.notches[i].Q) {
+                return false;
+            }
+        }
+        return true;
+    }
+    bool operator!=(const EarParams& o) const
+    {
+        return !(*this == o);
+    }
+};
+
+// Audiogram-driven WDRC: per-ear hearing-loss fitting on a log-spaced filterbank
+struct FittingParams {
+    static constexpr int NUM_FREQS = 8;
+    static constexpr float FREQS_HZ[NUM_FREQS] = {250.0f, 500.0f, 1000.0f, 2000.0f,
+                                                  3000.0f, 4000.0f, 6000.0f, 8000.0f};
+
+    bool  wdrcEnabled = false;          // AGC is skipped while on (the fitting sets the gain)
+    int   wdrcBands   = 12;             // 8-16 bands, 250 Hz to 8 kHz
+    float audiogramL[NUM_FREQS] = {};   // Hearing thresholds, dB HL (-10 to 120) at FREQS_HZ
+    float audiogramR[NUM_FREQS] = {};
+    float calibrationDbSpl = 100.0f;    // Ear SPL of a 0 dBFS sine (80-130, headphone-dependent)
+    float maxGainDb  = 40.0f;           // Per-band gain cap (0-60)
+    float attackMs   = 5.0f;            // 1-50
+    float releaseMs  = 100.0f;          // 20-1000
+
+    // Frequency lowering: f_out = cutoff * (f / cutoff)^(1 / ratio) above the cutoff
+    bool  nfcEnabled  = false;          // Runs in the shared spectral frame (7e')
+    float nfcCutoffHz = 2000.0f;        // 1000-6000, nothing below it moves
+    float nfcRatio    = 2.0f;           // 1.0-4.0 (2: 8 kHz → 4 kHz with a 2 kHz cutoff)
+};
+
+struct AudioEngineParams {
+    // Input
+    float micGain         = 180.0f;  // ES7210 PGA (0-240)
+    int   captureBits     = 16;      // 16, or 24 (ES7210 24-bit samples) for headroom at high mic gain
+    int   beamMode        = 0;       // 0=Off (stereo), 1=Delay-and-sum, 2=GSC (mono chain)
+    float beamSteerDeg    = 0.0f;    // -90..+90, 0 = broadside, + = toward MIC-L
+    float beamMicSpacingMm = 60.0f;  // MIC-L ↔ MIC-R distance (enclosure-dependent)
+    // Wind / handling noise (MIC-L ↔ MIC-R coherence below ~500 Hz): the HPF corner rises with
+    // the wind toward windHpfMaxHz, never below the ear's own HPF; mode 2 also puts both
+    // channels on the calmer mic while one port takes the brunt
+    int   windMode        = 0;       // 0=Off, 1=Adaptive HPF, 2=Adaptive HPF + calmer mic
+    float windHpfMaxHz    = 300.0f;  // HPF corner at full wind (100-500)
+
+    // Filters
+    bool  hpfEnabled      = true;
+    float hpfFrequency    = 80.0f;   // Hz (20-500)
+    bool  lpfEnabled      = false;
+    float lpfFrequency    = 18000.0f;// Hz (2000-20000)
+
+    // EQ (3-band parametric, peaking filters)
+    float eqLowGain       = 0.0f;    // dB (-12 to +12) @ 250 Hz
+    float eqMidGain       = 0.0f;    // dB (-12 to +12) @ 1000 Hz
+    float eqHighGain      = 0.0f;    // dB (-12 to +12) @ 4000 Hz
+
+    // Noise Suppression (ESP-SR standalone NS)
+    bool  nsEnabled       = false;
+    int   nsMode          = 2;       // 0=Mild, 1=Medium, 2=Aggressive (default: aggressive)
+    bool  nsLinked        = false;   // One NS on (L+R)/2, its frame gain applied to both ears (half the cost)
+
+    // AGC (ESP-SR Automatic Gain Control @ 16kHz)
+    bool  agcEnabled           = false;
+    int   agcMode              = 2;      // 0=Saturation, 1=Analog, 2=Digital, 3=Fixed
+    int   agcCompressionGainDb = 9;      // 0–90 dB
+    bool  agcLimiterEnabled    = true;   // Built-in limiter
+    int   agcTargetLevelDbfs   = -3;     // 0 to -31 dBFS
+    bool  agcLinked            = false;  // One gain computer on max(L,R) at 48kHz: no bus round trip, same gain both ears
+
+    // Voice Exclusion (NLMS adaptive filter @ 16kHz, uses headset mic as reference)
+    bool  veEnabled        = false;
+    float veBlend          = 0.7f;     // 0.0–1.0: mix of original vs cleaned (higher for better cancellation)
+    float veStepSize       = 0.10f;    // 0.01–1.0: NLMS adaptation rate (slightly faster convergence)
+    int   veFilterLength   = 128;      // 16–512 taps NLMS / subband (~8ms), up to 2048 in FDAF mode (128ms)
+    float veMaxAttenuation = 0.8f;     // 0.0–1.0: safety limit (more aggressive cancellation)
+
+    // Voice Exclusion - Reference signal conditioning (applied to HP mic before NLMS)
+    float veRefGain        = 0.5f;     // 0.1–5.0: reference signal gain multiplier (reduced)
+    float veRefHpf         = 80.0f;    // 20–500 Hz: reference HPF (matches UI default)
+    float veRefLpf         = 4000.0f;  // 1000–8000 Hz: reference LPF (matches UI default)
+
+    // Voice Exclusion - AEC mode (alternative to NLMS)
+    int   veMode           = 0;        // 0=NLMS, 1=AEC, 2=FDAF (partitioned frequency-domain NLMS), 3=subband NLMS
+    int   veAecMode        = 1;        // 0=SR_LOW_COST, 1=SR_HIGH_PERF, 3=VOIP_LOW_COST, 4=VOIP_HIGH_PERF
+    int   veAecFilterLen   = 4;        // 1–6 (AEC filter length parameter)
+    bool  veAecShared      = false;    // One two-mic AEC instance for L+R (shared far-end state, ~half the cost)
+    bool  veVadEnabled     = true;     // VAD for double-talk detection (AEC mode)
+    int   veVadMode        = 3;        // 0–4: Normal to Very Very Very Aggressive
+
+    // Voice Exclusion - VAD Gating (attenuates output during non-speech)
+    bool  veVadGateEnabled = true;     // Enable VAD-based gating
+    float veVadGateAtten   = 0.15f;    // 0.0–1.0: attenuation during silence (0.15 = -16dB)
+
+    // Own voice: headphone mic (conditioned as the VE reference) against the room mics, with
+    // the reference VAD where it runs. One decision per block gates the VE step, holds the
+    // linked AGC and ducks the output against occlusion boom
+    float ownVoiceRatioDb  = 6.0f;     // 0–20 dB: HP mic over the room mics while the wearer talks
+    float ownVoiceDuckDb   = 0.0f;     // 0–12 dB: output reduction while they talk (0 = off)
+
+    // Acoustic feedback cancellation (48kHz NLMS on the AEC playback loopback, ch1)
+    bool  fbcEnabled       = false;
+    int   fbcFilterLength  = 128;      // 32–512 taps (~2.7ms, 10.7ms max speaker → mic path)
+    float fbcStepSize      = 0.005f;   // 0.0005–0.05: small, the loudspeaker signal is mostly the talker
+    float fbcShiftHz       = 5.0f;     // 0–20 Hz forward-path frequency shift (decorrelation, 0 = off)
+    bool  howlSuppression  = true;     // Park notches on detected howls (free tinnitus notch slots)
+
+    // Output
+    float outputGain      = 1.5f;    // Linear (0.0-6.0, extended for boost)
+    int   outputVolume    = 100;     // Codec volume (0-100)
+    bool  outputMute      = true;    // MUTED by default (safety)
+    bool  boostEnabled    = false;   // Enable soft clipping for high gain levels
+    // Correction FIR (headphone correction, linear-phase fitting) on everything going out,
+    // IR from ProfileManager::IR_DIR/<firIr>.wav; 64 extra samples of delay above 32 taps
+    bool  firEnabled      = false;
+    int   firIr           = 1;       // IR file number (1-99)
+    // Noise dosimeter (NoiseDosimeter) on the output, ear SPL from fitting.calibrationDbSpl and
+    // the codec volume: 0=Off, 1=Meter and warn, 2=Also cut the output to a safe level past 100%
+    int   doseMode        = 1;
+    int   doseWeighting   = 0;       // 0=A (IEC 61672), 1=K (BS.1770)
+
+    // Engine
+    int   blockSize       = 480;     // Samples per I/O block: 48/96/240/480 (1/2/5/10 ms at 48kHz)
+    // I/O and DSP rate: 48000, 32000 or 24000, latched at start(). Below 48kHz profiles that only
+    // need 10-12kHz of bandwidth cut the I2S, DMA and per-sample cost. At 32kHz the 16kHz bus
+    // resamples 2:1; at 24kHz its stages (VE, NS, ESP-SR AGC) are off and AGC runs linked. The USB,
+    // RTP and recorder taps pause below 48kHz
+    int   sampleRate      = 48000;
+    int   spectralFftSize = 256;     // Shared WOLA transform for spectral stages: 64-1024 (power of 2)
+    int   spectralHop     = 64;      // fftSize/2, /4 or /8 (latency = fftSize samples)
+    int   earSplit        = 1;       // Right-ear NS/AGC on Core 0: 0=Off, 1=Auto (Core 1 over budget), 2=On
+    bool  busBandSplit    = true;    // Only the band below ~7kHz takes the 16kHz bus; the rest bypasses it, gain-tracked
+    // The bus as one ESP-SR AFE (voice communication) on the Core 0 worker instead of the VE/NS/AGC
+    // stages: AEC if veEnabled (modes and filter length from veAec*), NS if nsEnabled, AGC if
+    // agcEnabled and not agcLinked. One instance on the mid signal, so the bus goes out mono, a
+    // few frames later (AecFrameBridge). Needs CONFIG_HOWIZARD_AUDIO_AFE
+    bool  busAfe          = false;
+    // Quiet path: after quietHoldMs of input under quietThresholdDb, the input filters and the
+    // bus stages (VE, NS, AGC) sleep with their state kept and the bus holds its last gain.
+    // Notches, the hearing chain, generators and output run as usual; one loud block wakes it all.
+    bool  quietPathEnabled = true;
+    float quietThresholdDb = -60.0f; // Mic block power, dBFS (-90 to -30)
+    int   quietHoldMs      = 1000;   // 100-10000
+    // Scene tiers: the control task sorts ~1s windows of the mics into an AudioScene and lets
+    // the heavy stages run only where the scene needs them, each at most as set here. Quiet:
+    // no NS, voice exclusion or beamformer; speech adds voice exclusion; steady noise adds
+    // NS; babble runs all three. A tier change goes through the A/B dip
+    bool  sceneAuto        = false;
+    float sceneQuietDb     = -50.0f; // Noise floor under which a room counts as quiet, dBFS (-80 to -20)
+
+    // Per-ear blocks. Linked, the left ear's fields above (filters, EQ, tinnitus
+    // notches, output gain) drive both ears from one coefficient set and rightEar
+    // is ignored; unlinked, rightEar drives the right ear.
+    bool  earsLinked      = true;
+    EarParams rightEar;
+
+    // Dynamics (embedded struct)
+    DynamicsParams dynamics;
+
+    // Hearing-loss fitting (embedded struct)
+    FittingParams fitting;
+
+    // Tinnitus Relief (embedded struct)
+    TinnitusReliefParams tinnitus;
+
+    // The block an ear is heard with (the right ear reads the left one while linked)
+    EarParams ear(AudioEar which) const
+    {
+        if (which == AUDIO_EAR_RIGHT && !earsLinked) return rightEar;
+        EarParams e;
+        e.hpfEnabled = hpfEnabled;
+        e.hpfFrequency = hpfFrequency;
+        e.lpfEnabled = lpfEnabled;
+        e.lpfFrequency = lpfFrequency;
+        e.eqLowGain = eqLowGain;
+        e.eqMidGain = eqMidGain;
+        e.eqHighGain = eqHighGain;
+        for (int i = 0; i < 6; i++) e.notches[i] = tinnitus.notches[i];
+        e.outputGain = outputGain;
+        return e;
+    }
+};
@@ -0,0 +1,269 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "audio_recorder.h"
+#include "sd_storage.h"
+#include <mooncake_log.h>
+#include <algorithm>
+#include <cstring>
+#include <esp_heap_caps.h>
+#include <new>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char* TAG = "AudioRec";
+
+AudioRecorder& AudioRecorder::getInstance()
+{
+    static AudioRecorder instance;
+    return instance;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// WAV files
+// ─────────────────────────────────────────────────────────────────────────────
+
+static void putLe(uint8_t* p, uint32_t v, int bytes)
+{
+    for (int i = 0; i < bytes; i++) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+void AudioRecorder::writeWavHeader(FILE* f, int channels, uint32_t dataBytes)
+{
+    // RIFF + fmt + JUNK padding + data header = exactly HEADER_BYTES
+    uint8_t h[HEADER_BYTES] = {};
+    const uint32_t junk = HEADER_BYTES - 12 - 24 - 8 - 8;
+    memcpy(h, "RIFF", 4);
+    putLe(h + 4, HEADER_BYTES - 8 + dataBytes, 4);
+    memcpy(h + 8, "WAVE", 4);
+    memcpy(h + 12, "fmt ", 4);
+    putLe(h + 16, 16, 4);
+    putLe(h + 20, 1, 2);  // PCM
+    putLe(h + 22, channels, 2);
+    putLe(h + 24, SAMPLE_RATE, 4);
+    putLe(h + 28, SAMPLE_RATE * channels * 2, 4);
+    putLe(h + 32, channels * 2, 2);
+    putLe(h + 34, 16, 2);
+    memcpy(h + 36, "JUNK", 4);
+    putLe(h + 40, junk, 4);
+    uint8_t* data = h + 44 + junk;
+    memcpy(data, "data", 4);
+    putLe(data + 4, dataBytes, 4);
+    fseek(f, 0, SEEK_SET);
+    fwrite(h, 1, sizeof(h), f);
+}
+
+bool AudioRecorder::openStream(Stream& st, const std::string& path, int channels)
+{
+    if (!st.ring) {
+        void* mem = heap_caps_malloc(sizeof(Ring), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!mem) {
+            mclog::tagError(TAG, "no PSRAM for the {} ring", path);
+            return false;
+        }
+        st.ring = static_cast<Ring*>(mem);
+    }
+    st.file = fopen(path.c_str(), "wb");
+    if (!st.file) {
+        mclog::tagError(TAG, "failed to create {}", path);
+        return false;
+    }
+    // Writes are already large and aligned; stdio buffering would only add a copy
+    setvbuf(st.file, nullptr, _IONBF, 0);
+    st.channels = channels;
+    // Neither side is running: start the ring over (it holds no resources to destroy)
+    new (st.ring) Ring();
+    st.queued.store(0, std::memory_order_relaxed);
+    st.dataBytes = 0;
+    st.reserved = 0;
+    st.failed = false;
+    writeWavHeader(st.file, channels, 0);
+    if (!SdStorage::reserve(st.file, st.reserved, HEADER_BYTES + WRITE_CHUNK)) {
+        mclog::tagWarn(TAG, "{}: preallocation failed, writing without it", path);
+        st.reserved = UINT32_MAX;
+    }
+    return true;
+}
+
+void AudioRecorder::closeStream(Stream& st)
+{
+    if (!st.file) return;
+    if (!st.failed) writeWavHeader(st.file, st.channels, st.dataBytes);
+    // Give back the preallocated tail past the last sample
+    if (st.reserved != 0 && ftruncate(fileno(st.file), HEADER_BYTES + st.dataBytes) != 0) {
+        mclog::tagWarn(TAG, "failed to trim the preallocated tail");
+    }
+    fclose(st.file);
+    st.file = nullptr;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Control
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool AudioRecorder::start(uint8_t sources, const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    sources &= SOURCE_OUTPUT | SOURCE_INPUT;
+    // Also covers a writer that missed its stop() join and may still hold the files
+    if (_writer.isRunning()) {
+        mclog::tagWarn(TAG, "already recording");
+        return false;
+    }
+    if (!sources) return false;
+
+    if (!_staging) {
+        _staging = static_cast<uint8_t*>(heap_caps_aligned_alloc(64, WRITE_CHUNK,
+            MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA | MALLOC_CAP_8BIT));
+        if (!_staging) {
+            mclog::tagError(TAG, "no internal RAM for the write buffer");
+            return false;
+        }
+    }
+    if (!SdStorage::getInstance().mount()) {
+        mclog::tagError(TAG, "failed to mount SD card");
+        return false;
+    }
+    struct stat sb;
+    if (stat(RECORDINGS_DIR, &sb) != 0) mkdir(RECORDINGS_DIR, 0755);
+
+    std::string base = name;
+    for (int n = 1; base.empty() && n < 10000; n++) {
+        char candidate[48];
+        snprintf(candidate, sizeof(candidate), "rec_%04d", n);
+        std::string probe = std::string(RECORDINGS_DIR) + "/" + candidate;
+        if (stat((probe + "_out.wav").c_str(), &sb) != 0 && stat((probe + "_in.wav").c_str(), &sb) != 0) {
+            base = candidate;
+        }
+    }
+    const std::string prefix = std::string(RECORDINGS_DIR) + "/" + base;
+
+    bool ok = true;
+    if (sources & SOURCE_OUTPUT) ok = openStream(_streams[0], prefix + "_out.wav", 2);
+    if (ok && (sources & SOURCE_INPUT)) ok = openStream(_streams[1], prefix + "_in.wav", 4);
+    if (!ok) {
+        for (auto& st : _streams) closeStream(st);
+        return false;
+    }
+
+    _droppedBlocks.store(0, std::memory_order_relaxed);
+    _bytesWritten.store(0, std::memory_order_relaxed);
+    _writeErrors.store(0, std::memory_order_relaxed);
+    _peakFillPct.store(0, std::memory_order_relaxed);
+    _outBytes.store(0, std::memory_order_relaxed);
+    // Core 0, under the AEC worker and the UI: SD latency must never reach the audio core
+    if (!_writer.create(writerTask, "audio_rec", 4096, this, 3, 0)) {
+        for (auto& st : _streams) closeStream(st);
+        mclog::tagError(TAG, "failed to create writer task");
+        return false;
+    }
+    _sources.store(sources, std::memory_order_release);
+    mclog::tagInfo(TAG, "recording to {} (sources 0x{:x})", prefix, sources);
+    return true;
+}
+
+void AudioRecorder::stop()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_writer.isRunning()) return;
+    _sources.store(0, std::memory_order_release);
+    // The final flush is bounded by the rings: a few MB/s card clears them in well under a second
+    if (!_writer.sendKillSignalAndWaitDelete(pdMS_TO_TICKS(STOP_TIMEOUT_MS))) {
+        // Still writing: it keeps the files and rings, and start() refuses until a later stop() joins it
+        mclog::tagWarn(TAG, "writer did not finish in {} ms", STOP_TIMEOUT_MS);
+    }
+}
+
+AudioRecorderStats AudioRecorder::getStats()
+{
+    AudioRecorderStats s;
+    s.recording = isRecording();
+    s.bytesWritten = _bytesWritten.load(std::memory_order_relaxed);
+    s.droppedBlocks = _droppedBlocks.load(std::memory_order_relaxed);
+    s.writeErrors = _writeErrors.load(std::memory_order_relaxed);
+    s.peakFillPct = _peakFillPct.load(std::memory_order_relaxed);
+    s.durationMs = static_cast<uint32_t>(static_cast<uint64_t>(_outBytes.load(std::memory_order_relaxed)) * 1000 /
+        (SAMPLE_RATE * 2 * sizeof(int16_t)));
+    return s;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Audio task side
+// ─────────────────────────────────────────────────────────────────────────────
+
+void AudioRecorder::push(Source s, const int16_t* frames, int count)
+{
+    Stream& st = _streams[s == SOURCE_OUTPUT ? 0 : 1];
+    if (!st.ring || count <= 0) return;
+    const uint32_t bytes = count * st.channels * sizeof(int16_t);
+    // Whole blocks or nothing, so the file never holds a partial frame
+    if (st.ring->available() < bytes) {
+        _droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    st.ring->push_n(reinterpret_cast<const uint8_t*>(frames), bytes);
+    st.queued.store(st.queued.load(std::memory_order_relaxed) + bytes, std::memory_order_release);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Writer task
+// ─────────────────────────────────────────────────────────────────────────────
+
+void AudioRecorder::writerTask(void* param)
+{
+    auto* self = static_cast<AudioRecorder*>(param);
+    self->writerLoop();
+}
+
+bool AudioRecorder::drain(Stream& st, bool all)
+{
+    if (!st.file) return false;
+    // Only what was queued on entry, so a busy producer can't keep the writer here
+    size_t pending = st.ring->size();
+    uint32_t pct = static_cast<uint32_t>(static_cast<uint64_t>(pending) * 100 / RING_BYTES);
+    if (pct > _peakFillPct.load(std::memory_order_relaxed)) _peakFillPct.store(pct, std::memory_order_relaxed);
+
+    bool wrote = false;
+    while (pending >= WRITE_CHUNK || (all && pending > 0)) {
+        // Keep draining after a failure so the audio task doesn't see a full ring forever
+        const uint32_t n = st.ring->pop_n(_staging, WRITE_CHUNK);
+        pending -= n;
+        if (st.failed) continue;
+        if (st.reserved != UINT32_MAX && !SdStorage::reserve(st.file, st.reserved, HEADER_BYTES + st.dataBytes + n)) {
+            st.reserved = UINT32_MAX;  // Keep writing into whatever space is left
+        }
+        if (fwrite(_staging, 1, n, st.file) != n) {
+            st.failed = true;
+            _writeErrors.fetch_add(1, std::memory_order_relaxed);
+            mclog::tagError(TAG, "SD write failed after {} bytes", st.dataBytes);
+            continue;
+        }
+        st.dataBytes += n;
+        _bytesWritten.fetch_add(n, std::memory_order_relaxed);
+        if (&st == &_streams[0]) _outBytes.fetch_add(n, std::memory_order_relaxed);
+        wrote = true;
+    }
+    return wrote;
+}
+
+void AudioRecorder::writerLoop()
+{
+    while (true) {
+        const bool stopping = _writer.checkKillSignal();
+        if (stopping) {
+            // A block pushed just before _sources cleared may still be landing
+            vTaskDelay(pdMS_TO_TICKS(20));
+        }
+        for (auto& st : _streams) drain(st, stopping);
+        if (stopping) break;
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(WRITER_POLL_MS));
+    }
+
+    for (auto& st : _streams) {
+        if (st.file) mclog::tagInfo(TAG, "{}-ch stream: {} bytes", st.channels, st.dataBytes);
+        closeStream(st);
+    }
+    mclog::tagInfo(TAG, "recording stopped, {} blocks dropped", _droppedBlocks.load(std::memory_order_relaxed));
+}
@@ -0,0 +1,113 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include "sd_storage.h"
+#include "../utils/spsc_ring/spsc_ring.h"
+#include "../utils/task_controller/task_controller.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+struct AudioRecorderStats {
+    bool recording = false;
+    uint32_t durationMs = 0;      // Audio written so far (output stream if present)
+    uint32_t bytesWritten = 0;    // All streams, WAV data only
+    uint32_t droppedBlocks = 0;   // Blocks the audio task couldn't queue (ring full)
+    uint32_t writeErrors = 0;     // Short fwrites; that stream stops writing
+    uint32_t peakFillPct = 0;     // Highest ring fill seen by the writer
+};
+
+/**
+ * @brief Streaming WAV recorder for the engine's output and raw input
+ *
+ * The audio task copies each block into a per-stream byte ring in PSRAM and
+ * never waits: a block that doesn't fit is dropped whole and counted. A
+ * low-priority writer task on Core 0 drains the rings in 32KB sector-aligned
+ * fwrites from internal RAM to /sd/Recordings/<name>_out.wav (stereo output)
+ * and <name>_in.wav (4-ch input in slot order), then patches the WAV sizes on
+ * stop. The header is padded to one 512-byte sector so every data write stays
+ * sector-aligned. Files grow in SdStorage::PREALLOC_STEP extents, trimmed to
+ * the data on stop.
+ */
+class AudioRecorder {
+public:
+    enum Source : uint8_t {
+        SOURCE_OUTPUT = 1 << 0,  // Processed stereo output, as sent to I2S
+        SOURCE_INPUT  = 1 << 1,  // MIC-L, AEC loopback, MIC-R, MIC-HP before any DSP
+    };
+
+    static constexpr const char* RECORDINGS_DIR = "/sd/Recordings";
+    static constexpr uint32_t SAMPLE_RATE = 48000;
+
+    static AudioRecorder& getInstance();
+
+    // Mounts SD and starts writing; name "" picks the next free rec_NNNN
+    bool start(uint8_t sources, const std::string& name = "");
+    // Flushes what's queued and finalizes the files
+    void stop();
+    bool isRecording() const
+    {
+        return _sources.load(std::memory_order_relaxed) != 0;
+    }
+    AudioRecorderStats getStats();
+    // WAV position of the next output block: stereo frames the audio task has queued,
+    // i.e. the I2S clock as recorded. For stamping other streams against the audio.
+    uint32_t outputFrames() const
+    {
+        return _streams[0].queued.load(std::memory_order_acquire) / (2 * sizeof(int16_t));
+    }
+
+    // ── Audio task (wait-free) ──
+    bool wants(Source s) const
+    {
+        return (_sources.load(std::memory_order_relaxed) & s) != 0;
+    }
+    void push(Source s, const int16_t* frames, int count);
+
+private:
+    AudioRecorder() = default;
+    AudioRecorder(const AudioRecorder&) = delete;
+    AudioRecorder& operator=(const AudioRecorder&) = delete;
+
+    static constexpr uint32_t RING_BYTES = 512 * 1024;  // Per stream: ~2.7s output, ~1.4s input
+    static constexpr uint32_t WRITE_CHUNK = SdStorage::IO_CHUNK;  // Sector multiple
+    static constexpr uint32_t HEADER_BYTES = 512;       // WAV header padded to one sector
+    static constexpr int WRITER_POLL_MS = 50;
+    static constexpr int STOP_TIMEOUT_MS = 3000;  // Final flush of both rings on a slow card
+
+    using Ring = SpscRing<uint8_t, RING_BYTES>;
+    struct Stream {
+        FILE* file = nullptr;
+        Ring* ring = nullptr;             // PSRAM, kept once allocated; rebuilt empty per recording
+        int channels = 0;
+        std::atomic<uint32_t> queued{0};  // Audio task: bytes pushed this recording
+        uint32_t dataBytes = 0;         // Writer-only
+        uint32_t reserved = 0;          // Writer-only: bytes preallocated, UINT32_MAX = gave up
+        bool failed = false;            // Writer-only
+    };
+
+    static void writerTask(void* param);
+    void writerLoop();
+    bool drain(Stream& st, bool all);
+    bool openStream(Stream& st, const std::string& path, int channels);
+    void closeStream(Stream& st);
+    static void writeWavHeader(FILE* f, int channels, uint32_t dataBytes);
+
+    std::mutex _mutex;  // start/stop
+    Stream _streams[2];  // Output, input
+    uint8_t* _staging = nullptr;
+    std::atomic<uint8_t> _sources{0};
+    TaskController_t _writer;  // Stop request, wake-up and join
+    std::atomic<uint32_t> _droppedBlocks{0};
+    std::atomic<uint32_t> _bytesWritten{0};
+    std::atomic<uint32_t> _writeErrors{0};
+    std::atomic<uint32_t> _peakFillPct{0};
+    std::atomic<uint32_t> _outBytes{0};
+};
@@ -0,0 +1,107 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "audio_session.h"
+#include <mooncake_log.h>
+#include <esp_err.h>
+#include <mutex>
+
+static const char* TAG = "audio_session";
+
+namespace {
+
+struct AudioFormat {
+    uint32_t rate;
+    uint32_t bits;
+    i2s_slot_mode_t ch;
+
+    bool operator==(const AudioFormat& o) const
+    {
+        return rate == o.rate && bits == o.bits && ch == o.ch;
+    }
+};
+
+std::mutex sessionMutex;
+// bsp_codec_init leaves the ES8388 open at 48 kHz / 16-bit stereo
+AudioFormat current = {48000, 16, I2S_SLOT_MODE_STEREO};
+bool currentValid = true;
+int refs[AudioSession::USER_COUNT] = {};
+int totalRefs = 0;
+
+const char* userName(AudioSession::User user)
+{
+    switch (user) {
+        case AudioSession::USER_ENGINE:      return "engine";
+        case AudioSession::USER_SFX:         return "sfx";
+        case AudioSession::USER_PLAYBACK:    return "playback";
+        case AudioSession::USER_RECORD_TEST: return "record test";
+        default:                             return "?";
+    }
+}
+
+esp_err_t applyFormatLocked(AudioSession::User user, const AudioFormat& format)
+{
+    if (currentValid && format == current) return ESP_OK;
+
+    // Re-clocking stops the channel under everyone else playing
+    if (totalRefs - refs[user] > 0) {
+        mclog::tagWarn(TAG, "{} wants {} Hz/{}-bit/{}ch while {} other user(s) run {} Hz/{}-bit/{}ch",
+            userName(user), format.rate, format.bits, (int)format.ch,
+            totalRefs - refs[user], current.rate, current.bits, (int)current.ch);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    bsp_codec_config_t* codec = bsp_get_codec_handle();
+    esp_err_t err = codec->i2s_reconfig_clk_fn(format.rate, format.bits, format.ch);
+    // After a failed reconfig the channel state is unknown: the next request retries
+    currentValid = err == ESP_OK;
+    if (err != ESP_OK) {
+        mclog::tagError(TAG, "I2S reconfig to {} Hz/{}-bit/{}ch failed: {}", format.rate, format.bits,
+            (int)format.ch, esp_err_to_name(err));
+        return err;
+    }
+    current = format;
+    mclog::tagInfo(TAG, "I2S clock {} Hz/{}-bit/{}ch for {}", format.rate, format.bits, (int)format.ch,
+        userName(user));
+    return ESP_OK;
+}
+
+}  // namespace
+
+esp_err_t AudioSession::acquire(User user, uint32_t rate, uint32_t bits, i2s_slot_mode_t ch)
+{
+    if (user < 0 || user >= USER_COUNT) return ESP_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    esp_err_t err = applyFormatLocked(user, {rate, bits, ch});
+    if (err != ESP_OK) return err;
+    refs[user]++;
+    totalRefs++;
+    return ESP_OK;
+}
+
+void AudioSession::release(User user)
+{
+    if (user < 0 || user >= USER_COUNT) return;
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    if (refs[user] == 0) {
+        mclog::tagWarn(TAG, "{} released a session it does not hold", userName(user));
+        return;
+    }
+    refs[user]--;
+    totalRefs--;
+}
+
+esp_err_t AudioSession::setFormat(User user, uint32_t rate, uint32_t bits, i2s_slot_mode_t ch)
+{
+    if (user < 0 || user >= USER_COUNT) return ESP_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    return applyFormatLocked(user, {rate, bits, ch});
+}
+
+int AudioSession::activeUsers()
+{
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    return totalRefs;
+}
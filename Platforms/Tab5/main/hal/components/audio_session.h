@@ -0,0 +1,38 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <bsp/m5stack_tab5.h>
+
+/**
+ * @brief Owner of the shared I2S playback clock
+ *
+ * Every codec user acquires a session with the format it plays instead of
+ * re-clocking I2S itself. The channel is only reconfigured when the format
+ * actually changes, so handing the codec between the engine, SFX and playback
+ * in the running format is instant and glitch-free. While anyone else holds a
+ * session, a request for a different format is refused rather than re-clocking
+ * under them.
+ */
+class AudioSession {
+public:
+    enum User {
+        USER_ENGINE,
+        USER_SFX,
+        USER_PLAYBACK,
+        USER_RECORD_TEST,
+        USER_COUNT,
+    };
+
+    // Reference-counted per user; every successful acquire needs one release
+    static esp_err_t acquire(User user, uint32_t rate = 48000, uint32_t bits = 16,
+                             i2s_slot_mode_t ch = I2S_SLOT_MODE_STEREO);
+    static void release(User user);
+
+    // Format change inside a held session (e.g. the next MP3 at another rate)
+    static esp_err_t setFormat(User user, uint32_t rate, uint32_t bits, i2s_slot_mode_t ch);
+
+    static int activeUsers();
+};
@@ -0,0 +1,59 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <sdkconfig.h>
+
+/**
+ * @brief DSP stages built into this image (Kconfig "Howizard → Audio DSP stages")
+ *
+ * Each flag is a constant in the stage's activation test in the block loop
+ * and an if constexpr ahead of every ESP-SR handle create and call, so a stage
+ * that is off folds away, loop branch included, and its library objects are
+ * never linked. The engine publishes params with the missing stages switched
+ * off; the setters and profiles keep the user's values, so a profile saved
+ * on a full build loads unchanged on a reduced one.
+ */
+namespace audio_stages {
+
+#if CONFIG_HOWIZARD_AUDIO_NS
+inline constexpr bool NS = true;
+#else
+inline constexpr bool NS = false;
+#endif
+
+#if CONFIG_HOWIZARD_AUDIO_AGC
+inline constexpr bool AGC = true;
+#else
+inline constexpr bool AGC = false;
+#endif
+
+#if CONFIG_HOWIZARD_AUDIO_AEC
+inline constexpr bool AEC = true;
+#else
+inline constexpr bool AEC = false;
+#endif
+
+#if CONFIG_HOWIZARD_AUDIO_VAD
+inline constexpr bool VAD = true;
+#else
+inline constexpr bool VAD = false;
+#endif
+
+// One ESP-SR AFE for the whole bus (busAfe), instead of the NS/AGC/AEC stages
+#if CONFIG_HOWIZARD_AUDIO_AFE
+inline constexpr bool AFE = true;
+#else
+inline constexpr bool AFE = false;
+#endif
+
+// Masking noise, tone finder and binaural beats (the notches and HF shelf stay: howl suppression uses the notches)
+#if CONFIG_HOWIZARD_AUDIO_TINNITUS
+inline constexpr bool TINNITUS = true;
+#else
+inline constexpr bool TINNITUS = false;
+#endif
+
+}  // namespace audio_stages
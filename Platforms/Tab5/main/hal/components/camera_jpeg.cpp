@@ -0,0 +1,165 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "camera_jpeg.h"
+#include <mooncake_log.h>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include "linux/videodev2.h"
+#include "esp_video_device.h"
+
+static const char* TAG = "CamJpeg";
+
+CameraJpeg& CameraJpeg::getInstance()
+{
+    static CameraJpeg instance;
+    return instance;
+}
+
+bool CameraJpeg::open(uint32_t width, uint32_t height)
+{
+    _fd = ::open(ESP_VIDEO_JPEG_DEVICE_NAME, O_RDONLY);
+    if (_fd < 0) {
+        mclog::tagError(TAG, "no JPEG device (CONFIG_ESP_VIDEO_ENABLE_HW_JPEG_VIDEO_DEVICE)");
+        return false;
+    }
+
+    // OUTPUT takes raw frames from the caller's memory, CAPTURE returns the JPEG
+    struct v4l2_format format;
+    memset(&format, 0, sizeof(format));
+    format.type                = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+    format.fmt.pix.width       = width;
+    format.fmt.pix.height      = height;
+    format.fmt.pix.pixelformat = V4L2_PIX_FMT_RGB565;
+    bool ok = ioctl(_fd, VIDIOC_S_FMT, &format) == 0;
+    format.type                = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    format.fmt.pix.pixelformat = V4L2_PIX_FMT_JPEG;
+    ok = ok && ioctl(_fd, VIDIOC_S_FMT, &format) == 0;
+
+    struct v4l2_ext_control control;
+    struct v4l2_ext_controls controls;
+    memset(&control, 0, sizeof(control));
+    memset(&controls, 0, sizeof(controls));
+    control.id          = V4L2_CID_JPEG_COMPRESSION_QUALITY;
+    control.value       = QUALITY;
+    controls.ctrl_class = V4L2_CTRL_CLASS_JPEG;
+    controls.count      = 1;
+    controls.controls   = &control;
+    if (ok && ioctl(_fd, VIDIOC_S_EXT_CTRLS, &controls) != 0) {
+        mclog::tagWarn(TAG, "quality left at the driver default");
+    }
+
+    struct v4l2_requestbuffers req;
+    memset(&req, 0, sizeof(req));
+    req.count  = 1;
+    req.type   = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+    req.memory = V4L2_MEMORY_USERPTR;
+    ok = ok && ioctl(_fd, VIDIOC_REQBUFS, &req) == 0;
+    req.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    ok = ok && ioctl(_fd, VIDIOC_REQBUFS, &req) == 0;
+
+    struct v4l2_buffer buf;
+    memset(&buf, 0, sizeof(buf));
+    buf.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index  = 0;
+    ok = ok && ioctl(_fd, VIDIOC_QUERYBUF, &buf) == 0;
+    if (ok) {
+        _out = static_cast<uint8_t*>(mmap(nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, buf.m.offset));
+        _outSize = buf.length;
+        ok = _out != nullptr && ioctl(_fd, VIDIOC_QBUF, &buf) == 0;
+    }
+
+    int type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+    ok = ok && ioctl(_fd, VIDIOC_STREAMON, &type) == 0;
+    type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    ok = ok && ioctl(_fd, VIDIOC_STREAMON, &type) == 0;
+    if (!ok) {
+        mclog::tagError(TAG, "JPEG device setup failed");
+        ::close(_fd);
+        _fd  = -1;
+        _out = nullptr;
+        return false;
+    }
+    mclog::tagInfo(TAG, "JPEG encoder {}x{} q{}, {} byte output", width, height, QUALITY, _outSize);
+    return true;
+}
+
+void CameraJpeg::close()
+{
+    if (_fd < 0) return;
+    int type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+    ioctl(_fd, VIDIOC_STREAMOFF, &type);
+    type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    ioctl(_fd, VIDIOC_STREAMOFF, &type);
+    ::close(_fd);
+    _fd  = -1;
+    _out = nullptr;
+}
+
+void CameraJpeg::encode(const uint8_t* frame, uint32_t size, uint32_t width, uint32_t height)
+{
+    if (width != _width || height != _height) {
+        close();  // Formats are fixed once streaming; a new size also gets a new try
+        _failed = false;
+        _width  = width;
+        _height = height;
+    }
+    if (_failed) return;
+    if (_fd < 0 && !open(width, height)) {
+        _failed = true;
+        return;
+    }
+
+    struct v4l2_buffer src;
+    memset(&src, 0, sizeof(src));
+    src.type      = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+    src.memory    = V4L2_MEMORY_USERPTR;
+    src.index     = 0;
+    src.m.userptr = reinterpret_cast<unsigned long>(frame);
+    src.length    = size;
+    if (ioctl(_fd, VIDIOC_QBUF, &src) != 0) {
+        mclog::tagError(TAG, "frame not accepted (alignment?)");
+        _failed = true;
+        return;
+    }
+
+    struct v4l2_buffer dst;
+    memset(&dst, 0, sizeof(dst));
+    dst.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    dst.memory = V4L2_MEMORY_MMAP;
+    const bool encoded = ioctl(_fd, VIDIOC_DQBUF, &dst) == 0;
+    // The source comes back once the encoder is done with it
+    ioctl(_fd, VIDIOC_DQBUF, &src);
+    if (!encoded) return;
+
+    if (dst.bytesused > 0) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _latest.assign(_out, _out + dst.bytesused);
+        _seq++;
+    }
+    _published.notify_all();
+    ioctl(_fd, VIDIOC_QBUF, &dst);
+}
+
+uint32_t CameraJpeg::sequence()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _seq;
+}
+
+bool CameraJpeg::waitFrame(std::vector<uint8_t>& out, uint32_t& seq, uint32_t timeoutMs)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_published.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&] { return _seq != seq; })) return false;
+    out = _latest;
+    seq = _seq;
+    return true;
+}
@@ -0,0 +1,72 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Hardware JPEG encoding of camera preview frames
+ *
+ * Wraps the esp_video JPEG M2M device. While anyone wants frames (an MJPEG
+ * stream connection, a pending snapshot), the camera present task hands each
+ * frame it puts on screen to encode(): the frame is queued to the encoder as a
+ * USERPTR buffer straight from where it is shown, so the raw image is never
+ * copied, and only the compressed result is published for waitFrame(). The
+ * frame stays on screen, and so untouched, until encode() returns. With no
+ * clients nothing is encoded.
+ */
+class CameraJpeg {
+public:
+    static constexpr int QUALITY = 80;
+
+    static CameraJpeg& getInstance();
+
+    void addClient()
+    {
+        _clients.fetch_add(1, std::memory_order_relaxed);
+    }
+    void removeClient()
+    {
+        _clients.fetch_sub(1, std::memory_order_relaxed);
+    }
+    bool wanted() const
+    {
+        return _clients.load(std::memory_order_relaxed) > 0;
+    }
+
+    // Present task: encode an RGB565 frame; the device is opened on first use
+    // and reopened when the preview size changes
+    void encode(const uint8_t* frame, uint32_t size, uint32_t width, uint32_t height);
+
+    // Published frame count, to wait for one newer than now
+    uint32_t sequence();
+    // Copy out the first frame published after `seq` and advance seq to it; false on timeout
+    bool waitFrame(std::vector<uint8_t>& out, uint32_t& seq, uint32_t timeoutMs);
+
+private:
+    CameraJpeg() = default;
+    CameraJpeg(const CameraJpeg&) = delete;
+    CameraJpeg& operator=(const CameraJpeg&) = delete;
+
+    bool open(uint32_t width, uint32_t height);  // Present task
+    void close();
+
+    int _fd = -1;
+    bool _failed = false;  // Device missing / misconfigured: don't retry every frame
+    uint8_t* _out = nullptr;  // Encoder CAPTURE buffer (mmapped)
+    uint32_t _outSize = 0;
+    uint32_t _width = 0;   // Of the frames encode() was last given
+    uint32_t _height = 0;
+    std::atomic<int> _clients{0};
+
+    std::mutex _mutex;  // _latest, _seq
+    std::condition_variable _published;
+    std::vector<uint8_t> _latest;
+    uint32_t _seq = 0;
+};
@@ -0,0 +1,202 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "cpu_governor.h"
+#include "audio_cost_model.h"
+#include "../utils/core_policy/core_policy.h"
+#include <mooncake_log.h>
+#include <algorithm>
+#include <sdkconfig.h>
+#if CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#endif
+
+static const char* TAG = "CpuGov";
+
+static constexpr int GOVERNOR_STACK = 3072;
+static constexpr UBaseType_t GOVERNOR_PRIORITY = 1;
+
+CpuGovernor& CpuGovernor::getInstance()
+{
+    static CpuGovernor instance;
+    return instance;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Control
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool CpuGovernor::setEnabled(bool enabled)
+{
+#if CONFIG_PM_ENABLE
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!enabled) {
+        if (!_enabled.load(std::memory_order_relaxed)) return true;
+        _enabled.store(false, std::memory_order_relaxed);
+        apply(0);  // Back to the full clock; the task goes idle
+        mclog::tagInfo(TAG, "governor off");
+        return true;
+    }
+    if (_enabled.load(std::memory_order_relaxed)) return true;
+
+    for (int i = 0; i < STEP_COUNT; i++) {
+        _steps[i] = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ >> i;
+        _stepValid[i] = true;  // Until esp_pm_configure() turns it down
+    }
+    _step = 0;
+    _quietWindows = 0;
+    _floorStep = stepFor(static_cast<float>(_floorMhz));
+    _stats = {};
+    if (!_task && xTaskCreatePinnedToCore(governorTask, "cpu_gov", GOVERNOR_STACK, this, GOVERNOR_PRIORITY,
+                      &_task, core_policy::SYSTEM_AFFINITY) != pdPASS) {
+        _task = nullptr;
+        mclog::tagError(TAG, "failed to create governor task");
+        return false;
+    }
+    apply(0);
+    _enabled.store(true, std::memory_order_release);
+    xTaskNotifyGive(_task);
+    mclog::tagInfo(TAG, "governor on, {}-{} MHz, floor {} MHz", _steps[STEP_COUNT - 1], _steps[0], _floorMhz);
+    return true;
+#else
+    if (enabled) mclog::tagWarn(TAG, "built without CONFIG_PM_ENABLE");
+    return !enabled;
+#endif
+}
+
+void CpuGovernor::setFloorMhz(uint32_t mhz)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _floorMhz = mhz;
+    if (!_enabled.load(std::memory_order_relaxed)) return;
+    _floorStep = stepFor(static_cast<float>(mhz));
+    if (_step > _floorStep) {
+        apply(_floorStep);
+        _stats.raises++;
+    }
+}
+
+CpuGovernorStats CpuGovernor::getStats()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    CpuGovernorStats s = _stats;
+    s.enabled = isEnabled();
+    s.freqMhz = s.enabled ? _steps[_step] : CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    s.floorMhz = _floorMhz;
+    return s;
+}
+
+void CpuGovernor::prepare(const AudioEngineParams& params)
+{
+    if (!isEnabled()) return;
+    const AudioCostEstimate est = AudioCostModel::getInstance().estimate(params);
+    // Model shares are of one core at the full clock
+    const float modelMhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * std::max(est.audioCorePct, est.aecCorePct) / TARGET_PCT;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!isEnabled()) return;
+    const int want = std::min(stepFor(modelMhz), _floorStep);
+    if (want < _step) {
+        apply(want);
+        _stats.raises++;
+    }
+    _quietWindows = 0;  // The new load is measured before anything is lowered
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Governor task
+// ─────────────────────────────────────────────────────────────────────────────
+
+void CpuGovernor::governorTask(void* param)
+{
+    static_cast<CpuGovernor*>(param)->governorLoop();
+}
+
+void CpuGovernor::governorLoop()
+{
+    AudioEngine& engine = AudioEngine::getInstance();
+    while (true) {
+        if (!isEnabled()) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            uint32_t periodUs;
+            engine.takeBlockPeakUs(periodUs);  // Peaks from before the enable are not this clock's
+            continue;
+        }
+        vTaskDelay(pdMS_TO_TICKS(WINDOW_MS));
+        // Params first: the engine's lock is never taken under ours
+        const AudioEngineParams params = engine.getParams();
+        uint32_t periodUs = 0;
+        const uint32_t peakUs = engine.takeBlockPeakUs(periodUs);
+        evaluate(params, peakUs, periodUs);
+    }
+}
+
+void CpuGovernor::evaluate(const AudioEngineParams& params, uint32_t peakUs, uint32_t periodUs)
+{
+    const AudioCostEstimate est = AudioCostModel::getInstance().estimate(params);
+    const float modelPct = std::max(est.audioCorePct, est.aecCorePct);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!isEnabled()) return;
+    const float mhz = static_cast<float>(_steps[_step]);
+    const float loadPct = periodUs > 0 ? 100.0f * peakUs / periodUs : 0.0f;
+    _stats.loadPct = loadPct;
+    _stats.predictedPct = modelPct * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ / mhz;
+
+    // Clock each input needs to sit at a share of the block period
+    auto need = [&](float pct) {
+        return std::max(mhz * loadPct / pct, CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * modelPct / pct);
+    };
+
+    const int up = std::min(stepFor(need(TARGET_PCT)), _floorStep);
+    if (up < _step) {
+        apply(up);
+        _stats.raises++;
+        _quietWindows = 0;
+        return;
+    }
+
+    // One step down, once the load has had room at the lower clock for a while
+    int down = _step + 1;
+    while (down < STEP_COUNT && !_stepValid[down]) down++;
+    if (down > _floorStep || down >= STEP_COUNT || need(LOWER_PCT) > _steps[down]) {
+        _quietWindows = 0;
+        return;
+    }
+    if (++_quietWindows < LOWER_WINDOWS) return;
+    _quietWindows = 0;
+    if (apply(down)) _stats.lowers++;
+}
+
+int CpuGovernor::stepFor(float mhz) const
+{
+    int step = 0;
+    for (int i = 0; i < STEP_COUNT; i++) {
+        if (_stepValid[i] && _steps[i] >= mhz) step = i;
+    }
+    return step;
+}
+
+bool CpuGovernor::apply(int step)
+{
+#if CONFIG_PM_ENABLE
+    esp_pm_config_t pm_config = {};
+    pm_config.max_freq_mhz = _steps[step];
+    pm_config.min_freq_mhz = std::min<int>(CONFIG_HOWIZARD_AUDIO_ONLY_MIN_CPU_MHZ, _steps[step]);
+    pm_config.light_sleep_enable = false;
+    const esp_err_t err = esp_pm_configure(&pm_config);
+    if (err != ESP_OK) {
+        // Not a clock this chip can run; never picked again
+        mclog::tagWarn(TAG, "{} MHz refused ({}), step dropped", _steps[step], esp_err_to_name(err));
+        if (step > 0) _stepValid[step] = false;
+        return false;
+    }
+    mclog::tagInfo(TAG, "{} -> {} MHz", _steps[_step], _steps[step]);
+    _step = step;
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,90 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "audio_engine.h"
+
+struct CpuGovernorStats {
+    bool enabled = false;
+    uint32_t freqMhz = 0;       // DFS maximum now configured
+    uint32_t floorMhz = 0;
+    float loadPct = 0.0f;       // Worst block DSP time of the last window, share of the block period
+    float predictedPct = 0.0f;  // Cost model for the current params, at the configured clock
+    uint32_t raises = 0;
+    uint32_t lowers = 0;
+};
+
+/**
+ * @brief CPU clock picked from the audio engine's load
+ *
+ * Sets the DFS maximum (esp_pm_configure) to the lowest of STEP_COUNT clocks
+ * (the default CPU clock, a half and a quarter of it) that keeps the audio
+ * block time under TARGET_PCT of the block period. Two inputs:
+ *
+ *  - the worst measured block DSP time of each WINDOW_MS window, scaled by
+ *    clock ratio (the loop is compute bound; PSRAM stalls make the scaling
+ *    optimistic, which the target's headroom covers);
+ *  - the AudioCostModel estimate of the params, on the audio core and the
+ *    AEC worker, since the clock is shared by both cores.
+ *
+ * prepare() runs in AudioEngine::publishParams() before new params reach the
+ * audio task, so turning on AEC or NS raises the clock first instead of
+ * missing blocks until the next window. Raising is immediate; lowering takes
+ * one step at a time, after LOWER_WINDOWS windows in a row have room under
+ * LOWER_PCT at the next step down. The floor (setFloorMhz) keeps the UI
+ * usable while the display is on.
+ *
+ * Needs CONFIG_PM_ENABLE; without it setEnabled() returns false.
+ */
+class CpuGovernor {
+public:
+    static constexpr float TARGET_PCT = 60.0f;
+    static constexpr float LOWER_PCT = 45.0f;
+    static constexpr uint32_t WINDOW_MS = 500;
+    static constexpr uint32_t LOWER_WINDOWS = 6;
+    static constexpr int STEP_COUNT = 3;
+
+    static CpuGovernor& getInstance();
+
+    bool setEnabled(bool enabled);
+    bool isEnabled() const
+    {
+        return _enabled.load(std::memory_order_relaxed);
+    }
+    void setFloorMhz(uint32_t mhz);
+    CpuGovernorStats getStats();
+
+    // Before params reach the audio task: raises the clock now if they need more
+    void prepare(const AudioEngineParams& params);
+
+private:
+    CpuGovernor() = default;
+    CpuGovernor(const CpuGovernor&) = delete;
+    CpuGovernor& operator=(const CpuGovernor&) = delete;
+
+    static void governorTask(void* param);
+    void governorLoop();
+    void evaluate(const AudioEngineParams& params, uint32_t peakUs, uint32_t periodUs);
+    // Lowest step at or above mhz (the top step if none)
+    int stepFor(float mhz) const;
+    bool apply(int step);
+
+    std::mutex _mutex;  // Everything below
+    std::atomic<bool> _enabled{false};
+    TaskHandle_t _task = nullptr;
+
+    uint32_t _steps[STEP_COUNT] = {};  // Descending
+    bool _stepValid[STEP_COUNT] = {};
+    int _step = 0;                     // Configured, index into _steps
+    int _floorStep = STEP_COUNT - 1;
+    uint32_t _floorMhz = 0;
+    uint32_t _quietWindows = 0;
+    CpuGovernorStats _stats;
+};
@@ -0,0 +1,224 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "face_tracker.h"
+#include "audio_engine.h"
+#include <mooncake_log.h>
+#include <algorithm>
+#include <cmath>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <sdkconfig.h>
+#if CONFIG_HOWIZARD_FACE_STEERING
+#include "human_face_detect.h"
+#endif
+
+static const char* TAG = "FaceTrack";
+
+static constexpr int DETECTOR_STACK = 8192;
+static constexpr UBaseType_t DETECTOR_PRIORITY = 2;  // Under LVGL and the camera tasks
+
+FaceTracker& FaceTracker::getInstance()
+{
+    static FaceTracker instance;
+    return instance;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Control
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool FaceTracker::setEnabled(bool enabled)
+{
+#if CONFIG_HOWIZARD_FACE_STEERING
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!enabled) {
+        _enabled.store(false, std::memory_order_relaxed);
+        if (_task) xTaskNotifyGive(_task);  // Hands the beam back and goes idle
+        return true;
+    }
+    if (_enabled.load(std::memory_order_relaxed)) return true;
+
+    if (!_image) {
+        _image = static_cast<uint8_t*>(heap_caps_aligned_calloc(128, DET_WIDTH * DET_HEIGHT * 2, 1,
+            MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA));
+    }
+    if (!_image) {
+        mclog::tagError(TAG, "no internal RAM for the detection image");
+        return false;
+    }
+    if (!_ppa) {
+        ppa_client_config_t config = {};
+        config.oper_type = PPA_OPERATION_SRM;
+        config.max_pending_trans_num = 1;
+        if (ppa_register_client(&config, &_ppa) != ESP_OK) {
+            mclog::tagError(TAG, "no PPA client");
+            _ppa = nullptr;
+            return false;
+        }
+    }
+    // Kept after the first enable: the model stays loaded and the task blocked
+    if (!_task && xTaskCreatePinnedToCore(detectorTask, "face_det", DETECTOR_STACK, this, DETECTOR_PRIORITY,
+                      &_task, 0) != pdPASS) {
+        _task = nullptr;
+        mclog::tagError(TAG, "failed to create detector task");
+        return false;
+    }
+    _nextUs.store(0, std::memory_order_relaxed);
+    _busy.store(false, std::memory_order_relaxed);
+    _enabled.store(true, std::memory_order_release);
+    mclog::tagInfo(TAG, "face steering on");
+    return true;
+#else
+    if (enabled) mclog::tagWarn(TAG, "built without CONFIG_HOWIZARD_FACE_STEERING");
+    return !enabled;
+#endif
+}
+
+FaceTrackerStats FaceTracker::getStats()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    FaceTrackerStats s = _stats;
+    s.enabled = isEnabled();
+    return s;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Camera present task side
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool FaceTracker::wanted() const
+{
+    return _enabled.load(std::memory_order_acquire) && !_busy.load(std::memory_order_acquire) &&
+           esp_timer_get_time() >= _nextUs.load(std::memory_order_relaxed);
+}
+
+void FaceTracker::offer(const uint8_t* rgb565, uint32_t width, uint32_t height, bool mirrored)
+{
+    // Downscale only: the detector gets its own copy and the frame is released on return
+    ppa_srm_oper_config_t srm = {};
+    srm.in.buffer = rgb565;
+    srm.in.pic_w = width;
+    srm.in.pic_h = height;
+    srm.in.block_w = width;
+    srm.in.block_h = height;
+    srm.in.srm_cm = PPA_SRM_COLOR_MODE_RGB565;
+    srm.out.buffer = _image;
+    srm.out.buffer_size = DET_WIDTH * DET_HEIGHT * 2;
+    srm.out.pic_w = DET_WIDTH;
+    srm.out.pic_h = DET_HEIGHT;
+    srm.out.srm_cm = PPA_SRM_COLOR_MODE_RGB565;
+    srm.rotation_angle = PPA_SRM_ROTATION_ANGLE_0;
+    srm.scale_x = static_cast<float>(DET_WIDTH) / width;
+    srm.scale_y = static_cast<float>(DET_HEIGHT) / height;
+    srm.mode = PPA_TRANS_MODE_BLOCKING;
+    _nextUs.store(esp_timer_get_time() + MIN_INTERVAL_MS * 1000, std::memory_order_relaxed);
+    if (ppa_do_scale_rotate_mirror(_ppa, &srm) != ESP_OK) return;
+    _mirrored = mirrored;
+    _busy.store(true, std::memory_order_release);
+    xTaskNotifyGive(_task);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Detector task
+// ─────────────────────────────────────────────────────────────────────────────
+
+void FaceTracker::detectorTask(void* param)
+{
+    static_cast<FaceTracker*>(param)->detectorLoop();
+}
+
+void FaceTracker::detectorLoop()
+{
+    while (true) {
+        // Woken per frame; LOST_MS without one (camera stopped) counts as no face
+        const bool woken = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LOST_MS)) > 0;
+        if (!_enabled.load(std::memory_order_acquire)) {
+            steer(NAN, false);
+            _busy.store(false, std::memory_order_release);
+            continue;
+        }
+        if (woken && _busy.load(std::memory_order_acquire)) {
+            detect();
+            _busy.store(false, std::memory_order_release);
+        } else {
+            steer(0.0f, false);
+        }
+    }
+}
+
+void FaceTracker::detect()
+{
+#if CONFIG_HOWIZARD_FACE_STEERING
+    if (!_detector) {
+        _detector = new HumanFaceDetect();
+        mclog::tagInfo(TAG, "face model loaded");
+    }
+
+    const int64_t t0 = esp_timer_get_time();
+    dl::image::img_t img = {};
+    img.data = _image;
+    img.width = DET_WIDTH;
+    img.height = DET_HEIGHT;
+    img.pix_type = dl::image::DL_IMAGE_PIX_TYPE_RGB565;
+    auto& results = _detector->run(img);
+
+    // Largest confident face: the closest person, usually the one being addressed
+    int faces = 0;
+    int bestArea = 0;
+    float bestX = 0.0f;
+    for (const auto& r : results) {
+        if (r.score < MIN_SCORE || r.box.size() < 4) continue;
+        faces++;
+        const int area = (r.box[2] - r.box[0]) * (r.box[3] - r.box[1]);
+        if (area <= bestArea) continue;
+        bestArea = area;
+        // Keypoints: left eye, left mouth corner, nose, right eye, right mouth corner (x, y)
+        bestX = r.keypoint.size() >= 10 ? 0.5f * (r.keypoint[2] + r.keypoint[8]) : 0.5f * (r.box[0] + r.box[2]);
+    }
+    const uint32_t runUs = static_cast<uint32_t>(esp_timer_get_time() - t0);
+
+    // 1/DUTY_DIVIDER of the core at most, however long a detection takes
+    const uint32_t intervalMs = std::max<uint32_t>(MIN_INTERVAL_MS, runUs * DUTY_DIVIDER / 1000);
+    _nextUs.store(t0 + static_cast<int64_t>(intervalMs) * 1000, std::memory_order_relaxed);
+
+    if (faces > 0) {
+        // Pinhole model. Unmirrored, the camera's right (image right) is the user's left, the
+        // MIC-L side, so image right is a positive bearing; the selfie view flips that.
+        float nx = (bestX - DET_WIDTH * 0.5f) / (DET_WIDTH * 0.5f);
+        if (_mirrored) nx = -nx;
+        const float halfFov = CAMERA_HFOV_DEG * 0.5f * static_cast<float>(M_PI) / 180.0f;
+        steer(atanf(nx * tanf(halfFov)) * 180.0f / static_cast<float>(M_PI), true);
+    } else {
+        steer(0.0f, false);
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stats.faces = faces;
+    _stats.runUs = runUs;
+    _stats.intervalMs = intervalMs;
+#endif
+}
+
+void FaceTracker::steer(float bearingDeg, bool seen)
+{
+    AudioEngine& engine = AudioEngine::getInstance();
+    const int64_t now = esp_timer_get_time();
+    if (seen) {
+        const float target = _tracking ? _bearing + SMOOTHING * (bearingDeg - _bearing) : bearingDeg;
+        _bearing = _tracking ? std::clamp(target, _bearing - MAX_STEP_DEG, _bearing + MAX_STEP_DEG) : target;
+        _lastSeenUs = now;
+        _tracking = true;
+        engine.setBeamTracking(_bearing);
+    } else if (_tracking && (std::isnan(bearingDeg) || now - _lastSeenUs > LOST_MS * 1000)) {
+        // Hold through brief misses (a turned head, a blink of the detector), then let go
+        _tracking = false;
+        engine.setBeamTracking(NAN);
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stats.tracking = _tracking;
+    _stats.bearingDeg = _bearing;
+}
@@ -0,0 +1,100 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <driver/ppa.h>
+
+class HumanFaceDetect;
+
+struct FaceTrackerStats {
+    bool enabled = false;
+    bool tracking = false;     // A face seen within LOST_MS, steering the beam
+    float bearingDeg = 0.0f;   // Smoothed steering angle, + = toward MIC-L
+    int faces = 0;             // In the last detection
+    uint32_t runUs = 0;        // Last detection
+    uint32_t intervalMs = 0;   // Current frame interval
+};
+
+/**
+ * @brief Face / lip bearing for the two-mic beamformer
+ *
+ * At most every MIN_INTERVAL_MS the camera present task hands the frame it
+ * just put on screen to offer(); the PPA scales it to DET_WIDTH x DET_HEIGHT
+ * RGB565 in internal RAM (a blocking pass of a few hundred microseconds) and
+ * a Core 0 task runs the esp-dl human face detector on it. The largest face's
+ * mouth (the midpoint of its mouth-corner keypoints, the box centre without
+ * them) becomes a horizontal bearing through the lens field of view, and is
+ * smoothed and slew limited into AudioEngine::setBeamTracking(), which is not
+ * a parameter change, so nothing is journaled. With no face for LOST_MS the
+ * beam goes back to the beamSteerDeg parameter.
+ *
+ * CPU is bounded two ways: the interval never drops below MIN_INTERVAL_MS
+ * (5 fps), and it stretches to DUTY_DIVIDER x the last detection time, so the
+ * detector never takes more than 1/DUTY_DIVIDER of Core 0 however slow it runs.
+ *
+ * Needs CONFIG_HOWIZARD_FACE_STEERING (pulls in esp-dl and the model in the
+ * human_face_det partition); without it setEnabled() returns false.
+ */
+class FaceTracker {
+public:
+    static constexpr uint32_t DET_WIDTH = 320;
+    static constexpr uint32_t DET_HEIGHT = 180;
+    static constexpr uint32_t MIN_INTERVAL_MS = 200;
+    static constexpr uint32_t DUTY_DIVIDER = 4;
+    static constexpr uint32_t LOST_MS = 2000;
+    static constexpr float MIN_SCORE = 0.5f;
+    static constexpr float CAMERA_HFOV_DEG = 70.0f;  // SC2336 module lens
+    static constexpr float SMOOTHING = 0.4f;         // Weight of a new bearing
+    static constexpr float MAX_STEP_DEG = 6.0f;      // Per detection
+
+    static FaceTracker& getInstance();
+
+    bool setEnabled(bool enabled);
+    bool isEnabled() const
+    {
+        return _enabled.load(std::memory_order_relaxed);
+    }
+    FaceTrackerStats getStats();
+
+    // ── Camera present task ──
+    // Enabled, the detector idle and the interval elapsed
+    bool wanted() const;
+    // An RGB565 width x height frame, valid for the duration of the call;
+    // mirrored: shown flipped left-right (selfie view)
+    void offer(const uint8_t* rgb565, uint32_t width, uint32_t height, bool mirrored);
+
+private:
+    FaceTracker() = default;
+    FaceTracker(const FaceTracker&) = delete;
+    FaceTracker& operator=(const FaceTracker&) = delete;
+
+    static void detectorTask(void* param);
+    void detectorLoop();
+    void detect();
+    void steer(float bearingDeg, bool seen);
+
+    std::mutex _mutex;  // setEnabled, _stats
+    std::atomic<bool> _enabled{false};
+    std::atomic<bool> _busy{false};       // Frame in _image not yet detected
+    std::atomic<int64_t> _nextUs{0};      // Earliest time for the next frame
+    TaskHandle_t _task = nullptr;
+
+    ppa_client_handle_t _ppa = nullptr;
+    uint8_t* _image = nullptr;  // DET_WIDTH x DET_HEIGHT RGB565, internal RAM
+    bool _mirrored = false;
+
+    // Detector task only
+    HumanFaceDetect* _detector = nullptr;  // Model loaded on first detection
+    float _bearing = 0.0f;
+    int64_t _lastSeenUs = 0;
+    bool _tracking = false;
+
+    FaceTrackerStats _stats;
+};
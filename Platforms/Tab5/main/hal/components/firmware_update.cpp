@@ -0,0 +1,302 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "firmware_update.h"
+#include "audio_engine.h"
+#include "sd_storage.h"
+#include "wifi_link.h"
+#include "../utils/core_policy/core_policy.h"
+#include <mooncake_log.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <esp_app_desc.h>
+#include <esp_app_format.h>
+#include <esp_crt_bundle.h>
+#include <esp_heap_caps.h>
+#include <esp_http_client.h>
+#include <esp_ota_ops.h>
+#include <esp_timer.h>
+
+static const char* TAG = "OTA";
+
+static constexpr int UPDATE_STACK = 6144;  // TLS handshake for https sources
+static constexpr UBaseType_t UPDATE_PRIORITY = 3;  // Below the web server and the Wi-Fi link
+static constexpr int VERIFY_STACK = 3072;
+static constexpr int HTTP_BUFFER = 4096;
+
+FirmwareUpdate& FirmwareUpdate::getInstance()
+{
+    static FirmwareUpdate instance;
+    return instance;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Sources
+// ─────────────────────────────────────────────────────────────────────────────
+
+namespace {
+
+struct Source {
+    FILE* file = nullptr;
+    esp_http_client_handle_t http = nullptr;
+
+    // Bytes read, 0 at the end of the image, negative on an error
+    int read(uint8_t* out, size_t len)
+    {
+        if (file) {
+            const size_t n = fread(out, 1, len, file);
+            return (n == 0 && ferror(file)) ? -1 : static_cast<int>(n);
+        }
+        return esp_http_client_read(http, reinterpret_cast<char*>(out), len);
+    }
+
+    ~Source()
+    {
+        if (file) fclose(file);
+        if (http) {
+            esp_http_client_close(http);
+            esp_http_client_cleanup(http);
+        }
+    }
+};
+
+bool isUrl(const std::string& source)
+{
+    return source.rfind("http://", 0) == 0 || source.rfind("https://", 0) == 0;
+}
+
+}  // namespace
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Control
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool FirmwareUpdate::start(const std::string& source)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_running.load(std::memory_order_acquire)) return false;
+    _buffer = static_cast<uint8_t*>(heap_caps_malloc(CHUNK, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+    if (!_buffer) {
+        mclog::tagError(TAG, "no internal RAM for the {} KB chunk", CHUNK / 1024);
+        return false;
+    }
+    _source = source;
+    _stats = FirmwareUpdateStats();
+    _stats.state = STATE_RUNNING;
+    _written.store(0, std::memory_order_relaxed);
+    _cancel.store(false, std::memory_order_relaxed);
+    _running.store(true, std::memory_order_release);
+    if (xTaskCreatePinnedToCore(updateTask, "ota", UPDATE_STACK, this, UPDATE_PRIORITY, &_task,
+                                core_policy::SYSTEM_AFFINITY) != pdPASS) {
+        _running.store(false, std::memory_order_relaxed);
+        _stats.state = STATE_FAILED;
+        _stats.error = ESP_ERR_NO_MEM;
+        _task = nullptr;
+        heap_caps_free(_buffer);
+        _buffer = nullptr;
+        mclog::tagError(TAG, "failed to create update task");
+        return false;
+    }
+    return true;
+}
+
+void FirmwareUpdate::cancel()
+{
+    _cancel.store(true, std::memory_order_release);
+}
+
+FirmwareUpdateStats FirmwareUpdate::getStats()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    FirmwareUpdateStats s = _stats;
+    s.written = _written.load(std::memory_order_relaxed);
+    return s;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Update task
+// ─────────────────────────────────────────────────────────────────────────────
+
+void FirmwareUpdate::updateTask(void* param)
+{
+    auto* self = static_cast<FirmwareUpdate*>(param);
+    const int64_t startUs = esp_timer_get_time();
+    const esp_err_t ret = self->update();
+    if (isUrl(self->_source)) WifiLink::getInstance().want(WifiLink::CLIENT_FIRMWARE_UPDATE, false);
+    {
+        std::lock_guard<std::mutex> lock(self->_mutex);
+        self->_stats.elapsedMs = static_cast<uint32_t>((esp_timer_get_time() - startUs) / 1000);
+        self->_stats.state = ret == ESP_OK ? STATE_READY : STATE_FAILED;
+        self->_stats.error = ret;
+        heap_caps_free(self->_buffer);
+        self->_buffer = nullptr;
+        self->_task = nullptr;
+    }
+    if (ret == ESP_OK) {
+        mclog::tagInfo(TAG, "{} bytes written, reboot to run the update", self->_written.load());
+    } else {
+        mclog::tagError(TAG, "update failed: {}", esp_err_to_name(ret));
+    }
+    self->_running.store(false, std::memory_order_release);
+    vTaskDelete(nullptr);
+}
+
+esp_err_t FirmwareUpdate::update()
+{
+    const esp_partition_t* target = esp_ota_get_next_update_partition(nullptr);
+    if (!target) {
+        mclog::tagError(TAG, "no OTA slot in the partition table");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    Source src;
+    uint32_t total = 0;
+    if (isUrl(_source)) {
+        WifiLink& link = WifiLink::getInstance();
+        link.want(WifiLink::CLIENT_FIRMWARE_UPDATE, true);
+        for (uint32_t waited = 0; !link.isConnected(); waited += 100) {
+            if (waited >= LINK_WAIT_MS || _cancel.load(std::memory_order_acquire)) return ESP_ERR_TIMEOUT;
+            vTaskDelay(pdMS_TO_TICKS(100));
+        }
+        esp_http_client_config_t config = {};
+        config.url = _source.c_str();
+        config.timeout_ms = HTTP_TIMEOUT_MS;
+        config.buffer_size = HTTP_BUFFER;
+        config.crt_bundle_attach = esp_crt_bundle_attach;
+        src.http = esp_http_client_init(&config);
+        if (!src.http) return ESP_ERR_NO_MEM;
+        esp_err_t ret = esp_http_client_open(src.http, 0);
+        if (ret != ESP_OK) return ret;
+        const int64_t length = esp_http_client_fetch_headers(src.http);
+        const int status = esp_http_client_get_status_code(src.http);
+        if (status != 200) {
+            mclog::tagError(TAG, "HTTP {} from {}", status, _source);
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        total = length > 0 ? static_cast<uint32_t>(length) : 0;
+    } else {
+        if (_source.rfind(SdStorage::MOUNT_POINT, 0) == 0 && !SdStorage::getInstance().mount()) return ESP_ERR_NOT_FOUND;
+        src.file = fopen(_source.c_str(), "rb");
+        if (!src.file) {
+            mclog::tagError(TAG, "can't open {}", _source);
+            return ESP_ERR_NOT_FOUND;
+        }
+        setvbuf(src.file, nullptr, _IONBF, 0);  // CHUNK reads go straight to the card
+        fseek(src.file, 0, SEEK_END);
+        total = static_cast<uint32_t>(ftell(src.file));
+        fseek(src.file, 0, SEEK_SET);
+    }
+    if (total > target->size) {
+        mclog::tagError(TAG, "image of {} bytes > {} slot of {}", total, target->label, target->size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats.total = total;
+    }
+    mclog::tagInfo(TAG, "{} -> {} ({} bytes)", _source, target->label, total);
+
+    esp_ota_handle_t handle = 0;
+    esp_err_t ret = esp_ota_begin(target, OTA_WITH_SEQUENTIAL_WRITES, &handle);
+    if (ret != ESP_OK) return ret;
+
+    uint32_t written = 0;
+    uint32_t maxWriteUs = 0;
+    bool end = false;
+    while (!end && ret == ESP_OK) {
+        if (_cancel.load(std::memory_order_acquire)) {
+            mclog::tagWarn(TAG, "cancelled at {} bytes", written);
+            ret = ESP_ERR_INVALID_STATE;
+            break;
+        }
+        // Only whole chunks go to flash; a short one is the tail of the image
+        size_t fill = 0;
+        while (fill < CHUNK) {
+            const int n = src.read(_buffer + fill, CHUNK - fill);
+            if (n < 0) {
+                ret = ESP_ERR_INVALID_RESPONSE;
+                break;
+            }
+            if (n == 0) {
+                end = true;
+                break;
+            }
+            fill += n;
+        }
+        if (ret != ESP_OK || fill == 0) break;
+        if (written == 0 && !checkImage(_buffer, fill)) {
+            ret = ESP_ERR_OTA_VALIDATE_FAILED;
+            break;
+        }
+        const int64_t t0 = esp_timer_get_time();
+        ret = esp_ota_write(handle, _buffer, fill);
+        maxWriteUs = std::max(maxWriteUs, static_cast<uint32_t>(esp_timer_get_time() - t0));
+        written += fill;
+        _written.store(written, std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats.maxWriteUs = maxWriteUs;
+    }
+    if (ret == ESP_OK && total > 0 && written != total) {
+        mclog::tagError(TAG, "short image: {} of {} bytes", written, total);
+        ret = ESP_ERR_INVALID_SIZE;
+    }
+    if (ret != ESP_OK) {
+        esp_ota_abort(handle);
+        return ret;
+    }
+    ret = esp_ota_end(handle);  // Checks the image hash
+    if (ret != ESP_OK) return ret;
+    return esp_ota_set_boot_partition(target);
+}
+
+bool FirmwareUpdate::checkImage(const uint8_t* data, size_t len)
+{
+    constexpr size_t DESC_OFFSET = sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t);
+    if (len < DESC_OFFSET + sizeof(esp_app_desc_t)) return false;
+    esp_app_desc_t desc;
+    std::memcpy(&desc, data + DESC_OFFSET, sizeof(desc));
+    const esp_app_desc_t* running = esp_app_get_description();
+    if (desc.magic_word != ESP_APP_DESC_MAGIC_WORD
+        || std::strncmp(desc.project_name, running->project_name, sizeof(desc.project_name)) != 0) {
+        mclog::tagError(TAG, "not a {} image", running->project_name);
+        return false;
+    }
+    mclog::tagInfo(TAG, "image version '{}' (running '{}')", desc.version, running->version);
+    return true;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Boot verification
+// ─────────────────────────────────────────────────────────────────────────────
+
+void FirmwareUpdate::checkBoot()
+{
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    esp_ota_img_states_t state;
+    if (!running || esp_ota_get_state_partition(running, &state) != ESP_OK) return;
+    if (state != ESP_OTA_IMG_PENDING_VERIFY) return;
+    mclog::tagInfo(TAG, "{} pending verification, confirming in {} s", running->label, HEALTHY_MS / 1000);
+    if (xTaskCreatePinnedToCore(verifyTask, "ota_verify", VERIFY_STACK, this, 1, nullptr,
+                                core_policy::SYSTEM_AFFINITY) != pdPASS) {
+        // Not confirming would roll back a working image on the next reset
+        esp_ota_mark_app_valid_cancel_rollback();
+    }
+}
+
+void FirmwareUpdate::verifyTask(void* param)
+{
+    vTaskDelay(pdMS_TO_TICKS(HEALTHY_MS));
+    if (AudioEngine::getInstance().isRunning()) {
+        esp_ota_mark_app_valid_cancel_rollback();
+        mclog::tagInfo(TAG, "update confirmed");
+    } else {
+        mclog::tagError(TAG, "audio engine not running after {} s, rolling back", HEALTHY_MS / 1000);
+        esp_ota_mark_app_invalid_rollback_and_reboot();
+    }
+    vTaskDelete(nullptr);
+}
@@ -0,0 +1,94 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_err.h>
+
+struct FirmwareUpdateStats {
+    uint8_t state = 0;       // FirmwareUpdate::State
+    uint32_t written = 0;    // Image bytes in flash
+    uint32_t total = 0;      // Image size, 0 while unknown (chunked HTTP)
+    uint32_t elapsedMs = 0;
+    uint32_t maxWriteUs = 0; // Longest esp_ota_write(), i.e. the longest flash-busy stretch
+    esp_err_t error = 0;     // Why the last update failed
+};
+
+/**
+ * @brief OTA into the idle app slot (ota_0 / ota_1), from the SD card or HTTP
+ *
+ * A Core 0 task below the web server streams the image through one CHUNK
+ * buffer in internal RAM: fill it from the source, hand it whole to
+ * esp_ota_write(), repeat. 16 KB is four flash sectors, so writes stay sector
+ * aligned and the driver gets long page-program runs. The partition is erased
+ * as it is written (OTA_WITH_SEQUENTIAL_WRITES) rather than all up front, so
+ * no single call holds the flash for the seconds a 6 MB erase takes. With
+ * code and rodata executing from PSRAM (SPIRAM_XIP_FROM_PSRAM) the audio task
+ * on Core 1 keeps running through flash operations; nothing here touches the
+ * engine.
+ *
+ * The first chunk's app descriptor is checked against the running firmware's
+ * project name before anything is written, esp_ota_end() verifies the image
+ * hash, and only then does the boot partition switch. The update takes effect
+ * on the next reboot.
+ *
+ * Rollback (BOOTLOADER_APP_ROLLBACK_ENABLE): a freshly updated image boots in
+ * PENDING_VERIFY. checkBoot() confirms it once the audio engine has run for
+ * HEALTHY_MS, and rolls back to the previous slot if it hasn't; a crash or
+ * watchdog reset before that lets the bootloader roll back on its own.
+ */
+class FirmwareUpdate {
+public:
+    enum State : uint8_t {
+        STATE_IDLE = 0,
+        STATE_RUNNING,
+        STATE_READY,   // Boot partition switched, reboot to run it
+        STATE_FAILED,
+    };
+
+    static constexpr size_t CHUNK = 16 * 1024;
+    static constexpr uint32_t HEALTHY_MS = 30000;
+    static constexpr uint32_t LINK_WAIT_MS = 30000;  // For the station link to associate
+    static constexpr int HTTP_TIMEOUT_MS = 10000;
+
+    static FirmwareUpdate& getInstance();
+
+    // source: an absolute VFS path ("/sd/...") or an http(s):// URL. false if one is running
+    bool start(const std::string& source);
+    void cancel();
+    bool isRunning() const
+    {
+        return _running.load(std::memory_order_acquire);
+    }
+    FirmwareUpdateStats getStats();
+
+    // At boot, after bring-up
+    void checkBoot();
+
+private:
+    FirmwareUpdate() = default;
+    FirmwareUpdate(const FirmwareUpdate&) = delete;
+    FirmwareUpdate& operator=(const FirmwareUpdate&) = delete;
+
+    static void updateTask(void* param);
+    esp_err_t update();
+    bool checkImage(const uint8_t* data, size_t len);
+    static void verifyTask(void* param);
+
+    std::mutex _mutex;  // start, _source, _stats
+    std::atomic<bool> _running{false};
+    std::atomic<bool> _cancel{false};
+    TaskHandle_t _task = nullptr;
+    std::string _source;
+    FirmwareUpdateStats _stats;
+    std::atomic<uint32_t> _written{0};
+    uint8_t* _buffer = nullptr;  // CHUNK bytes, internal RAM, while an update runs
+};
@@ -13,12 +13,22 @@
 #include <freertos/task.h>
 #include <thread>
 #include <mutex>
-#include <audio_player.h>
+#include <atomic>
+#include <esp_heap_caps.h>
+#include "audio_session.h"
+#include "audio_engine.h"
+#include "media_player.h"
+#include "../utils/mp3_decoder/mp3_decoder.h"
+#include "../utils/core_policy/core_policy.h"
 
 static const char* TAG = "audio";
 
 static uint8_t _current_speaker_volume = 60;
 
+// How far the engine's program is pulled down under mixed-in audio
+static constexpr float SFX_DUCK_DB   = 6.0f;
+static constexpr float MUSIC_DUCK_DB = 12.0f;
+
 void HalEsp32::setSpeakerVolume(uint8_t volume)
 {
     _current_speaker_volume = std::clamp((int)volume, 0, 100);
@@ -30,32 +40,63 @@ uint8_t HalEsp32::getSpeakerVolume()
     return _current_speaker_volume;
 }
 
-void HalEsp32::audioRecord(std::vector<int16_t>& data, uint16_t durationMs, float gain)
+size_t HalEsp32::audioRecordInto(int16_t* data, size_t samples, float gain)
 {
-    data.resize(48000 * 4 * durationMs / 1000);
-
-    // ESP_LOGI(TAG, "start record");
     bsp_codec_config_t* codec_handle = bsp_get_codec_handle();
     codec_handle->set_in_gain(gain);
     size_t bytes_read = 0;
-    codec_handle->i2s_read((char*)data.data(), (48000 * 4 * durationMs / 1000) * sizeof(uint16_t), &bytes_read,
-                           portMAX_DELAY);
-    // ESP_LOGI(TAG, "record done, %d bytes", bytes_read);
+    codec_handle->i2s_read((char*)data, samples * sizeof(int16_t), &bytes_read, portMAX_DELAY);
+    return bytes_read / sizeof(int16_t);
+}
+
+// While the engine owns I2S, other audio joins its output as a mixer voice
+// instead of writing to the codec. Returns false when the engine isn't running.
+static bool _play_through_engine(const int16_t* data, size_t samples, float duckDb)
+{
+    AudioEngine& engine = AudioEngine::getInstance();
+    if (!engine.isRunning()) {
+        return false;
+    }
+    AudioMixer& mixer = engine.mixer();
+    int voice         = mixer.openVoice(48000, 2, _current_speaker_volume / 100.0f, duckDb);
+    if (voice < 0) {
+        mclog::tagWarn(TAG, "no free mixer voice, sfx dropped");
+        return true;
+    }
+    size_t frames = samples / 2;
+    mixer.write(voice, data, frames, frames * 1000 / 48000 + 200);
+    mixer.closeVoice(voice);
+    return true;
 }
 
+static void _play_direct(const int16_t* data, size_t samples)
+{
+    if (!_play_through_engine(data, samples, SFX_DUCK_DB)) {
+        bsp_codec_config_t* codec_handle = bsp_get_codec_handle();
+        codec_handle->set_volume(_current_speaker_volume);
+        size_t bytes_written = 0;
+        if (AudioSession::acquire(AudioSession::USER_SFX) == ESP_OK) {
+            codec_handle->i2s_write(data, samples * sizeof(int16_t), &bytes_written, portMAX_DELAY);
+            AudioSession::release(AudioSession::USER_SFX);
+        }
+    }
+}
+
+// The queued clip is the caller's buffer; done hands it back
 struct AudioTaskData_t {
     std::mutex mutex;
-    bool is_task_running  = false;
-    bool is_audio_ready   = false;
-    bool is_audio_playing = false;
-    std::vector<int16_t> audio_data;
+    bool is_task_running           = false;
+    bool is_audio_ready            = false;
+    bool is_audio_playing          = false;
+    const int16_t* audio_data      = nullptr;
+    size_t audio_samples           = 0;
+    hal::HalBase::AudioDone_t done = nullptr;
+    void* done_user                = nullptr;
 };
 static AudioTaskData_t _audio_task_data;
 
 void _audio_play_task(void* param)
 {
-    size_t bytes_written = 0;
-
     while (true) {
         _audio_task_data.mutex.lock();
 
@@ -63,18 +104,19 @@ void _audio_play_task(void* param)
             _audio_task_data.is_audio_playing = true;
             _audio_task_data.mutex.unlock();
 
-            bsp_codec_config_t* codec_handle = bsp_get_codec_handle();
-            codec_handle->set_volume(_current_speaker_volume);
-            codec_handle->i2s_reconfig_clk_fn(48000, 16, I2S_SLOT_MODE_STEREO);
-            codec_handle->i2s_write(_audio_task_data.audio_data.data(),
-                                    _audio_task_data.audio_data.size() * sizeof(uint16_t), &bytes_written,
-                                    portMAX_DELAY);
+            _play_direct(_audio_task_data.audio_data, _audio_task_data.audio_samples);
 
             _audio_task_data.mutex.lock();
+            hal::HalBase::AudioDone_t done = _audio_task_data.done;
+            void* done_user                = _audio_task_data.done_user;
+            _audio_task_data.audio_data       = nullptr;
+            _audio_task_data.done             = nullptr;
             _audio_task_data.is_audio_playing = false;
             _audio_task_data.is_audio_ready   = false;
             _audio_task_data.mutex.unlock();
 
+            // Unlocked, so done can queue the next clip
+            if (done) done(done_user);
             continue;
         }
 
@@ -83,30 +125,31 @@ void _audio_play_task(void* param)
     }
 }
 
-void HalEsp32::audioPlay(std::vector<int16_t>& data, bool async)
+bool HalEsp32::audioPlayBuffer(const int16_t* data, size_t samples, bool async, AudioDone_t done, void* user)
 {
-    if (async) {
-        std::lock_guard<std::mutex> lock(_audio_task_data.mutex);
+    if (!async) {
+        _play_direct(data, samples);
+        return true;
+    }
 
-        if (_audio_task_data.is_audio_playing) {
-            mclog::tagWarn(TAG, "audio is playing");
-            return;
-        }
+    std::lock_guard<std::mutex> lock(_audio_task_data.mutex);
 
-        if (!_audio_task_data.is_task_running) {
-            _audio_task_data.is_task_running = true;
-            xTaskCreate(_audio_play_task, "audio", 4096, nullptr, 5, nullptr);
-        }
+    if (_audio_task_data.is_audio_ready || _audio_task_data.is_audio_playing) {
+        mclog::tagWarn(TAG, "audio is playing");
+        return false;
+    }
 
-        _audio_task_data.audio_data     = data;
-        _audio_task_data.is_audio_ready = true;
-    } else {
-        bsp_codec_config_t* codec_handle = bsp_get_codec_handle();
-        codec_handle->set_volume(_current_speaker_volume);
-        size_t bytes_written = 0;
-        codec_handle->i2s_reconfig_clk_fn(48000, 16, I2S_SLOT_MODE_STEREO);
-        codec_handle->i2s_write(data.data(), data.size() * sizeof(uint16_t), &bytes_written, portMAX_DELAY);
+    if (!_audio_task_data.is_task_running) {
+        _audio_task_data.is_task_running = true;
+        xTaskCreatePinnedToCore(_audio_play_task, "audio", 4096, nullptr, 5, nullptr, core_policy::SYSTEM_AFFINITY);
     }
+
+    _audio_task_data.audio_data     = data;
+    _audio_task_data.audio_samples  = samples;
+    _audio_task_data.done           = done;
+    _audio_task_data.done_user      = user;
+    _audio_task_data.is_audio_ready = true;
+    return true;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -190,12 +233,14 @@ static void _rec_test_task(void* param)
 
     size_t bytes_written = 0;
     codec_handle->set_volume(_current_speaker_volume);
-    codec_handle->i2s_reconfig_clk_fn(48000, 16, I2S_SLOT_MODE_STEREO);
 
-    mclog::tagInfo(TAG, "start playback");
-    codec_handle->i2s_write(_rec_test_data.audio_buffer, (48000 * 2 * 3) * sizeof(uint16_t), &bytes_written,
-                            portMAX_DELAY);
-    mclog::tagInfo(TAG, "playback done");
+    if (AudioSession::acquire(AudioSession::USER_RECORD_TEST) == ESP_OK) {
+        mclog::tagInfo(TAG, "start playback");
+        codec_handle->i2s_write(_rec_test_data.audio_buffer, (48000 * 2 * 3) * sizeof(uint16_t), &bytes_written,
+                                portMAX_DELAY);
+        mclog::tagInfo(TAG, "playback done");
+        AudioSession::release(AudioSession::USER_RECORD_TEST);
+    }
 
     _rec_test_data.mutex.lock();
     _rec_test_data.state = hal::HalBase::MIC_TEST_IDLE;
@@ -215,7 +260,7 @@ static void try_create_rec_test_task(bool isDualMic)
         if (_rec_test_data.state == hal::HalBase::MIC_TEST_IDLE) {
             _rec_test_data.isDualMic = isDualMic;
             _rec_test_data.state     = hal::HalBase::MIC_TEST_RECORDING;
-            xTaskCreate(_rec_test_task, "rec", 4096, nullptr, 5, nullptr);
+            xTaskCreatePinnedToCore(_rec_test_task, "rec", 4096, nullptr, 5, nullptr, core_policy::SYSTEM_AFFINITY);
             _rec_test_data.mutex.unlock();
             return;
         }
@@ -271,79 +316,229 @@ struct MusicTestData_t {
 };
 static MusicTestData_t _music_test_data;
 
-static esp_err_t audio_mute_function(AUDIO_PLAYER_MUTE_SETTING setting)
+// EMBED_TXTFILES appends a NUL that isn't part of the stream
+static void _mp3_source(Mp3PlayTarget_t target, const uint8_t*& data, size_t& size)
 {
-    bsp_codec_config_t* codec_handle = bsp_get_codec_handle();
-    codec_handle->set_mute(setting == AUDIO_PLAYER_MUTE ? true : false);
-    return ESP_OK;
+    switch (target) {
+        case MP3_PLAY_TARGET_CANON_IN_D:
+            data = canon_in_d_mp3_start;
+            size = (canon_in_d_mp3_end - canon_in_d_mp3_start) - 1;
+            break;
+        case MP3_PLAY_TARGET_STARTUP_SFX:
+            data = startup_sfx_mp3_start;
+            size = (startup_sfx_mp3_end - startup_sfx_mp3_start) - 1;
+            break;
+        case MP3_PLAY_TARGET_SHUTDOWN_SFX:
+            data = shutdown_sfx_mp3_start;
+            size = (shutdown_sfx_mp3_end - shutdown_sfx_mp3_start) - 1;
+            break;
+    }
 }
 
-static void audio_player_callback(audio_player_cb_ctx_t* ctx)
+// Short SFX decoded once into PSRAM, so they start without a decoder spin-up
+struct SfxPcm_t {
+    int16_t* pcm     = nullptr;
+    size_t frames    = 0;
+    uint32_t rate    = 0;
+    int channels     = 0;
+    std::atomic<bool> ready{false};
+};
+static SfxPcm_t _sfx_cache[2];  // Startup, shutdown
+
+static SfxPcm_t* _sfx_cached(Mp3PlayTarget_t target)
 {
-    mclog::tagInfo(TAG, "audio event: {}", (int)ctx->audio_event);
+    SfxPcm_t* sfx = nullptr;
+    if (target == MP3_PLAY_TARGET_STARTUP_SFX) sfx = &_sfx_cache[0];
+    if (target == MP3_PLAY_TARGET_SHUTDOWN_SFX) sfx = &_sfx_cache[1];
+    return sfx && sfx->ready.load(std::memory_order_acquire) ? sfx : nullptr;
+}
 
-    audio_player_state_t state = audio_player_get_state();
-    mclog::tagInfo(TAG, "audio state: {}", (int)state);
+static bool _sfx_decode(Mp3PlayTarget_t target, SfxPcm_t& sfx)
+{
+    const uint8_t* data = nullptr;
+    size_t size         = 0;
+    _mp3_source(target, data, size);
 
-    if (state == AUDIO_PLAYER_STATE_IDLE) {
-        GetHAL()->stopPlayMusicTest();
+    Mp3Decoder decoder;
+    if (!decoder.open(data, size)) {
+        return false;
+    }
+    size_t capacity = 0;
+    size_t samples  = 0;
+    int16_t* pcm    = nullptr;
+    while (true) {
+        if (samples + Mp3Decoder::MAX_FRAME_SAMPLES > capacity) {
+            capacity += 48000 * 2;  // Grow ~1s of stereo at a time
+            auto* grown = static_cast<int16_t*>(
+                heap_caps_realloc(pcm, capacity * sizeof(int16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+            if (!grown) {
+                heap_caps_free(pcm);
+                return false;
+            }
+            pcm = grown;
+        }
+        int n = decoder.decodeFrame(pcm + samples);
+        if (n <= 0) {
+            break;
+        }
+        // One format per cached clip: stop at a mid-stream change rather than mislabel it
+        if (sfx.channels != 0 && (decoder.sampleRate() != sfx.rate || decoder.channels() != sfx.channels)) {
+            break;
+        }
+        sfx.rate     = decoder.sampleRate();
+        sfx.channels = decoder.channels();
+        samples += n;
+    }
+    if (samples == 0) {
+        heap_caps_free(pcm);
+        return false;
     }
+    sfx.pcm    = pcm;
+    sfx.frames = samples / sfx.channels;
+    sfx.ready.store(true, std::memory_order_release);
+    return true;
 }
 
-static void _music_play_task(void* param)
+static void _sfx_cache_task(void* param)
 {
-    bsp_codec_config_t* codec_handle = bsp_get_codec_handle();
-    codec_handle->set_volume(_current_speaker_volume);
-    codec_handle->i2s_reconfig_clk_fn(48000, 16, I2S_SLOT_MODE_STEREO);
-
-    audio_player_config_t config = {
-        .mute_fn    = audio_mute_function,
-        .clk_set_fn = codec_handle->i2s_reconfig_clk_fn,
-        .write_fn   = codec_handle->i2s_write,
-        .priority   = 8,
-        .coreID     = 1,
-    };
-    ESP_ERROR_CHECK(audio_player_new(config));
-    audio_player_callback_register(audio_player_callback, NULL);
-
-    size_t mp3_size = 0;
-    FILE* fp        = nullptr;
-    switch (_music_test_data.target) {
-        case MP3_PLAY_TARGET_CANON_IN_D:
-            mp3_size = (canon_in_d_mp3_end - canon_in_d_mp3_start) - 1;
-            fp       = fmemopen((void*)canon_in_d_mp3_start, mp3_size, "rb");
-            break;
-        case MP3_PLAY_TARGET_STARTUP_SFX:
-            mp3_size = (startup_sfx_mp3_end - startup_sfx_mp3_start) - 1;
-            fp       = fmemopen((void*)startup_sfx_mp3_start, mp3_size, "rb");
-            break;
-        case MP3_PLAY_TARGET_SHUTDOWN_SFX:
-            mp3_size = (shutdown_sfx_mp3_end - shutdown_sfx_mp3_start) - 1;
-            fp       = fmemopen((void*)shutdown_sfx_mp3_start, mp3_size, "rb");
-            break;
+    const Mp3PlayTarget_t targets[2] = {MP3_PLAY_TARGET_STARTUP_SFX, MP3_PLAY_TARGET_SHUTDOWN_SFX};
+    for (int i = 0; i < 2; i++) {
+        if (_sfx_decode(targets[i], _sfx_cache[i])) {
+            mclog::tagInfo(TAG, "sfx {} cached: {} frames @ {}Hz", i, _sfx_cache[i].frames, _sfx_cache[i].rate);
+        } else {
+            mclog::tagWarn(TAG, "sfx {} cache failed, will stream", i);
+        }
     }
+    vTaskDelete(NULL);
+}
 
-    esp_err_t ret = audio_player_play(fp);
-    if (ret != ESP_OK) {
-        mclog::tagError(TAG, "audio play failed");
-        vTaskDelete(NULL);
-        return;
+void HalEsp32::sfx_cache_init()
+{
+    // Low priority: boot carries on, playback streams from flash until the cache lands
+    xTaskCreatePinnedToCore(_sfx_cache_task, "sfx_cache", 6144, nullptr, 2, nullptr, core_policy::SYSTEM_AFFINITY);
+}
+
+// PCM destination: a mixer voice while the engine owns I2S, otherwise the codec under a session
+class PcmOutput {
+public:
+    bool open(AudioSession::User user, float duckDb)
+    {
+        _user = user;
+        if (AudioEngine::getInstance().isRunning()) {
+            _voice = AudioEngine::getInstance().mixer().openVoice(48000, 2, _current_speaker_volume / 100.0f, duckDb);
+            return _voice >= 0;
+        }
+        if (AudioSession::acquire(user) != ESP_OK) {
+            return false;
+        }
+        _session = true;
+        bsp_get_codec_handle()->set_volume(_current_speaker_volume);
+        return true;
     }
 
-    while (1) {
-        vTaskDelay(pdMS_TO_TICKS(100));
+    bool setFormat(uint32_t rate, int channels)
+    {
+        if (rate == _rate && channels == _channels) {
+            return true;
+        }
+        bool ok = _voice >= 0
+                      ? AudioEngine::getInstance().mixer().setVoiceFormat(_voice, rate, channels)
+                      : AudioSession::setFormat(_user, rate, 16,
+                                                channels == 1 ? I2S_SLOT_MODE_MONO : I2S_SLOT_MODE_STEREO) == ESP_OK;
+        if (ok) {
+            _rate     = rate;
+            _channels = channels;
+        }
+        return ok;
+    }
 
-        std::lock_guard<std::mutex> lock(_music_test_data.mutex);
-        if (_music_test_data.killSignal) {
-            break;
+    bool write(const int16_t* pcm, size_t frames)
+    {
+        if (_voice >= 0) {
+            return AudioEngine::getInstance().mixer().write(_voice, pcm, frames, 1000) == frames;
         }
+        size_t bytes         = frames * _channels * sizeof(int16_t);
+        size_t bytes_written = 0;
+        bsp_get_codec_handle()->i2s_write((void*)pcm, bytes, &bytes_written, 1000);
+        return bytes_written == bytes;
     }
 
-    ret = audio_player_delete();
-    if (ret != ESP_OK) {
-        mclog::tagError(TAG, "audio player delete failed");
+    void close(bool drop)
+    {
+        if (_voice >= 0) {
+            AudioEngine::getInstance().mixer().closeVoice(_voice, drop);
+        }
+        if (_session) {
+            AudioSession::release(_user);
+        }
+        _voice   = -1;
+        _session = false;
     }
 
+private:
+    AudioSession::User _user = AudioSession::USER_PLAYBACK;
+    int _voice               = -1;
+    bool _session            = false;
+    uint32_t _rate           = 48000;
+    int _channels            = 2;
+};
+
+static bool _music_killed()
+{
+    std::lock_guard<std::mutex> lock(_music_test_data.mutex);
+    return _music_test_data.killSignal;
+}
+
+static void _music_play_task(void* param)
+{
+    const Mp3PlayTarget_t target = _music_test_data.target;
+    const float duck_db          = target == MP3_PLAY_TARGET_CANON_IN_D ? MUSIC_DUCK_DB : SFX_DUCK_DB;
+
+    PcmOutput out;
+    bool killed = false;
+    if (!out.open(AudioSession::USER_PLAYBACK, duck_db)) {
+        mclog::tagError(TAG, "audio output busy, music play aborted");
+    } else if (SfxPcm_t* sfx = _sfx_cached(target)) {
+        // Cached clip: straight out of PSRAM, in ~20ms chunks so a stop still lands promptly
+        const size_t chunk = 1024;
+        if (out.setFormat(sfx->rate, sfx->channels)) {
+            for (size_t done = 0; done < sfx->frames && !killed; done += chunk) {
+                size_t n = std::min(chunk, sfx->frames - done);
+                if (!out.write(sfx->pcm + done * sfx->channels, n)) {
+                    break;
+                }
+                killed = _music_killed();
+            }
+        }
+    } else {
+        // Decode frame by frame from the mapped flash image
+        const uint8_t* data = nullptr;
+        size_t size         = 0;
+        _mp3_source(target, data, size);
+        Mp3Decoder decoder;
+        auto* pcm = static_cast<int16_t*>(
+            heap_caps_malloc(Mp3Decoder::MAX_FRAME_SAMPLES * sizeof(int16_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+        if (!pcm || !decoder.open(data, size)) {
+            mclog::tagError(TAG, "mp3 decoder init failed");
+        } else {
+            int n;
+            while (!killed && (n = decoder.decodeFrame(pcm)) > 0) {
+                if (!out.setFormat(decoder.sampleRate(), decoder.channels())) {
+                    mclog::tagError(TAG, "unsupported mp3 format: {}Hz {}ch", decoder.sampleRate(),
+                                    decoder.channels());
+                    break;
+                }
+                if (!out.write(pcm, n / decoder.channels())) {
+                    mclog::tagWarn(TAG, "audio write timeout");
+                    break;
+                }
+                killed = _music_killed();
+            }
+        }
+        heap_caps_free(pcm);
+    }
+    out.close(killed);
+
     _music_test_data.mutex.lock();
     _music_test_data.state      = hal::HalBase::MUSIC_PLAY_IDLE;
     _music_test_data.killSignal = false;
@@ -358,7 +553,7 @@ void try_create_music_play_task(Mp3PlayTarget_t target)
         _music_test_data.state      = hal::HalBase::MUSIC_PLAY_PLAYING;
         _music_test_data.target     = target;
         _music_test_data.killSignal = false;
-        xTaskCreate(_music_play_task, "music", 3000, nullptr, 5, nullptr);
+        xTaskCreatePinnedToCore(_music_play_task, "music", 6144, nullptr, 5, nullptr, core_policy::SYSTEM_AFFINITY);
     } else {
         mclog::tagWarn(TAG, "music play is running");
     }
@@ -382,6 +577,25 @@ void HalEsp32::stopPlayMusicTest()
     _music_test_data.killSignal = true;
 }
 
+/* -------------------------------------------------------------------------- */
+/*                                  SD media                                  */
+/* -------------------------------------------------------------------------- */
+bool HalEsp32::startMediaPlayback(const std::string& path, bool replaceMics)
+{
+    return MediaPlayer::getInstance().play(path, replaceMics ? MediaPlayer::INPUT_REPLACE : MediaPlayer::INPUT_MIX,
+                                           _current_speaker_volume / 100.0f);
+}
+
+void HalEsp32::stopMediaPlayback()
+{
+    MediaPlayer::getInstance().stop();
+}
+
+bool HalEsp32::isMediaPlaying()
+{
+    return MediaPlayer::getInstance().isPlaying();
+}
+
 /* -------------------------------------------------------------------------- */
 /*                                     SFX                                    */
 /* -------------------------------------------------------------------------- */
@@ -5,7 +5,13 @@
  */
 #include "hal/hal_esp32.h"
 #include "../utils/task_controller/task_controller.h"
+#include "../utils/core_policy/core_policy.h"
+#include "camera_jpeg.h"
+#include "video_recorder.h"
+#include "face_tracker.h"
+#include "sd_storage.h"
 #include <mooncake_log.h>
+#include <atomic>
 #include <vector>
 #include <driver/gpio.h>
 #include <memory>
@@ -13,6 +19,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_event.h"
+#include "esp_attr.h"
 #include "esp_err.h"
 #include "esp_log.h"
 #include "esp_timer.h"
@@ -22,9 +29,11 @@
 #include <sys/mman.h>
 #include <sys/param.h>
 #include <sys/errno.h>
+#include <sys/stat.h>
 #include "linux/videodev2.h"
 #include "esp_video_init.h"
 #include "esp_video_device.h"
+#include "esp_video_ioctl.h"
 #include "driver/i2c_master.h"
 #include "driver/ppa.h"
 #include "imlib.h"
@@ -36,6 +45,8 @@
 static lv_obj_t* camera_canvas;
 // extern uint8_t* frame_buf;
 static QueueHandle_t queue_camera_ctrl = NULL;
+static TaskController_t camera_task;
+static constexpr TickType_t CAMERA_STOP_TIMEOUT = pdMS_TO_TICKS(2000);  // Frames in flight, stream off, PPA teardown
 // 定义任务控制标志
 #define TASK_CONTROL_PAUSE  0
 #define TASK_CONTROL_RESUME 1
@@ -46,8 +57,11 @@ static std::mutex camera_mutex;
 
 static const char* TAG = "camera";
 
-#define EXAMPLE_VIDEO_BUFFER_COUNT 2
-#define MEMORY_TYPE                V4L2_MEMORY_MMAP
+#define EXAMPLE_VIDEO_BUFFER_COUNT CONFIG_HOWIZARD_CAMERA_BUFFERS  // 3: one filling, up to two in the PPA
+#define MEMORY_TYPE                V4L2_MEMORY_USERPTR                // From frame_pool, see below
+#define PREVIEW_SLOTS              3
+#define CAMERA_FRAME_BYTES         (CAMERA_WIDTH * CAMERA_HEIGHT * 2)
+#define CAMERA_BUFFER_ALIGN        CONFIG_CACHE_L2_CACHE_LINE_SIZE    // PPA, JPEG and H.264 USERPTR all need it
 #define CAM_DEV_PATH               ESP_VIDEO_MIPI_CSI_DEVICE_NAME
 #ifndef ARRAY_SIZE
 #define ARRAY_SIZE(arr) (sizeof(arr) / sizeof(arr[0]))
@@ -137,10 +151,7 @@ exit_0:
 
 static esp_err_t new_cam(int cam_fd, cam_t** ret_wc)
 {
-    int ret;
     struct v4l2_format format;
-    int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    struct v4l2_requestbuffers req;
     cam_t* wc;
 
     memset(&format, 0, sizeof(struct v4l2_format));
@@ -150,7 +161,7 @@ static esp_err_t new_cam(int cam_fd, cam_t** ret_wc)
         return ESP_FAIL;
     }
 
-    wc = (cam_t*)malloc(sizeof(cam_t));
+    wc = (cam_t*)calloc(1, sizeof(cam_t));
     if (!wc) {
         return ESP_ERR_NO_MEM;
     }
@@ -160,61 +171,346 @@ static esp_err_t new_cam(int cam_fd, cam_t** ret_wc)
     wc->height       = format.fmt.pix.height;
     wc->pixel_format = format.fmt.pix.pixelformat;
 
+    *ret_wc = wc;
+    return ESP_OK;
+}
+
+/*
+ * Frame memory. The capture buffers (V4L2 USERPTR) and the PPA preview slots
+ * are CAMERA_FRAME_BYTES blocks from one pool in PSRAM, L2 cache line aligned.
+ * The pool survives stop/start, so a restart neither reallocates 1.8 MB blocks
+ * nor fragments PSRAM. releaseCameraBuffers() hands it back once the camera UI
+ * closes. The driver owns no frame memory of its own: with MMAP it kept its
+ * buffers for good once requested.
+ */
+#define FRAME_POOL_SIZE (EXAMPLE_VIDEO_BUFFER_COUNT + PREVIEW_SLOTS)
+
+static uint8_t* frame_pool[FRAME_POOL_SIZE];
+
+static uint8_t* frame_pool_get(int i)
+{
+    if (!frame_pool[i]) {
+        // Not zeroed: only the CSI DMA and the PPA ever write these, and a CPU fill would leave
+        // 1.8 MB of dirty lines whose writebacks race the first DMA fill
+        frame_pool[i] = (uint8_t*)heap_caps_aligned_alloc(CAMERA_BUFFER_ALIGN, CAMERA_FRAME_BYTES,
+                                                          MALLOC_CAP_DMA | MALLOC_CAP_SPIRAM);
+        if (!frame_pool[i]) {
+            ESP_LOGE(TAG, "no PSRAM for camera frame %d", i);
+        }
+    }
+    return frame_pool[i];
+}
+
+static size_t frame_pool_release()
+{
+    size_t freed = 0;
+    for (int i = 0; i < FRAME_POOL_SIZE; i++) {
+        if (frame_pool[i]) {
+            heap_caps_free(frame_pool[i]);
+            frame_pool[i] = NULL;
+            freed += CAMERA_FRAME_BYTES;
+        }
+    }
+    return freed;
+}
+
+static esp_err_t cam_stream_on(cam_t* wc)
+{
+    int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    struct v4l2_requestbuffers req;
+
     memset(&req, 0, sizeof(req));
     req.count  = ARRAY_SIZE(wc->buffer);
     req.type   = type;
     req.memory = MEMORY_TYPE;
     if (ioctl(wc->fd, VIDIOC_REQBUFS, &req) != 0) {
         ESP_LOGE(TAG, "failed to req buffers");
-        ret = ESP_FAIL;
-        goto errout;
+        return ESP_FAIL;
     }
 
     for (int i = 0; i < ARRAY_SIZE(wc->buffer); i++) {
         struct v4l2_buffer buf;
 
-        memset(&buf, 0, sizeof(buf));
-        buf.type   = type;
-        buf.memory = MEMORY_TYPE;
-        buf.index  = i;
-        if (ioctl(wc->fd, VIDIOC_QUERYBUF, &buf) != 0) {
-            ESP_LOGE(TAG, "failed to query buffer");
-            ret = ESP_FAIL;
-            goto errout;
-        }
-
-        wc->buffer[i] = (uint8_t*)mmap(NULL, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, wc->fd, buf.m.offset);
+        wc->buffer[i] = frame_pool_get(i);
         if (!wc->buffer[i]) {
-            ESP_LOGE(TAG, "failed to map buffer");
-            ret = ESP_FAIL;
-            goto errout;
+            return ESP_ERR_NO_MEM;
         }
 
+        memset(&buf, 0, sizeof(buf));
+        buf.type      = type;
+        buf.memory    = MEMORY_TYPE;
+        buf.index     = i;
+        buf.m.userptr = (unsigned long)wc->buffer[i];
+        buf.length    = CAMERA_FRAME_BYTES;
         if (ioctl(wc->fd, VIDIOC_QBUF, &buf) != 0) {
             ESP_LOGE(TAG, "failed to queue frame buffer");
-            ret = ESP_FAIL;
-            goto errout;
+            return ESP_FAIL;
         }
     }
 
     if (ioctl(wc->fd, VIDIOC_STREAMON, &type)) {
         ESP_LOGE(TAG, "failed to start stream");
-        ret = ESP_FAIL;
-        goto errout;
+        return ESP_FAIL;
     }
-
-    *ret_wc = wc;
     return ESP_OK;
+}
 
-errout:
-    free(wc);
-    return ret;
+// The sensor stops between captures instead of filling buffers nobody reads
+static void cam_stream_off(cam_t* wc)
+{
+    int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (ioctl(wc->fd, VIDIOC_STREAMOFF, &type) != 0) {
+        ESP_LOGE(TAG, "failed to stop stream");
+    }
+}
+
+/*
+ * Sensor mode per preview size. Of the sensor's RAW modes (through the ISP)
+ * whose frames fit a pool buffer, the one with the lowest pixel rate that
+ * still covers width x height once cropped to that aspect ratio. On the SC2336
+ * the binned 640x480 mode covers anything up to 640x360 at a little over half
+ * the CSI, ISP and PSRAM traffic of 720p30. Equal rates go to the slower MIPI
+ * clock (RAW8 before RAW10). If no mode is large enough, the largest one is
+ * used and the PPA upscales.
+ */
+static const esp_cam_sensor_format_t* cam_pick_mode(int fd, uint32_t width, uint32_t height)
+{
+    const esp_cam_sensor_format_t* best    = NULL;
+    const esp_cam_sensor_format_t* largest = NULL;
+    uint64_t best_rate                     = UINT64_MAX;
+    uint32_t largest_area                  = 0;
+
+    for (uint32_t i = 0;; i++) {
+        struct esp_video_sensor_fmtdesc desc;
+        memset(&desc, 0, sizeof(desc));
+        desc.index = i;
+        if (ioctl(fd, VIDIOC_ENUM_SENSOR_FMT, &desc) != 0) {
+            break;
+        }
+        const esp_cam_sensor_format_t* mode = desc.format;
+        if (mode->port != ESP_CAM_SENSOR_MIPI_CSI || !mode->isp_info ||
+            (uint32_t)mode->width * mode->height * 2 > CAMERA_FRAME_BYTES) {
+            continue;
+        }
+
+        const uint32_t crop_w = MIN((uint32_t)mode->width, mode->height * width / height);
+        const uint32_t crop_h = MIN((uint32_t)mode->height, mode->width * height / width);
+        if (crop_w * crop_h > largest_area) {
+            largest_area = crop_w * crop_h;
+            largest      = mode;
+        }
+        if (crop_w < width || crop_h < height) {
+            continue;
+        }
+        const uint64_t rate = (uint64_t)mode->width * mode->height * mode->fps;
+        if (rate < best_rate || (rate == best_rate && mode->mipi_info.mipi_clk < best->mipi_info.mipi_clk)) {
+            best_rate = rate;
+            best      = mode;
+        }
+    }
+    return best ? best : largest;
+}
+
+// Only while the stream is off; the ISP output is RGB565 again after a sensor mode change
+static esp_err_t cam_set_mode(cam_t* wc, uint32_t width, uint32_t height)
+{
+    const esp_cam_sensor_format_t* mode = cam_pick_mode(wc->fd, width, height);
+    if (!mode) {
+        return ESP_ERR_NOT_SUPPORTED;  // Stays in whatever mode it is in
+    }
+
+    esp_cam_sensor_format_t current;
+    if (ioctl(wc->fd, VIDIOC_G_SENSOR_FMT, &current) == 0 && strcmp(current.name, mode->name) == 0) {
+        return ESP_OK;
+    }
+    if (ioctl(wc->fd, VIDIOC_S_SENSOR_FMT, mode) != 0) {
+        ESP_LOGE(TAG, "failed to set sensor mode %s", mode->name);
+        return ESP_FAIL;
+    }
+
+    struct v4l2_format format;
+    memset(&format, 0, sizeof(format));
+    format.type                = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    format.fmt.pix.width       = mode->width;
+    format.fmt.pix.height      = mode->height;
+    format.fmt.pix.pixelformat = EXAMPLE_VIDEO_FMT_RGB565;
+    if (ioctl(wc->fd, VIDIOC_S_FMT, &format) != 0) {
+        ESP_LOGE(TAG, "failed to set format");
+        return ESP_FAIL;
+    }
+    wc->width  = mode->width;
+    wc->height = mode->height;
+    ESP_LOGI(TAG, "sensor mode %s", mode->name);
+    return ESP_OK;
 }
 
-// static HumanFaceDetect* human_face_detector;
 static bool cam_is_initial = false;
 static cam_t* camera       = NULL;
 
+/*
+ * Preview pipeline. The capture task dequeues a frame and hands it to the PPA
+ * without waiting (a mirror into one of PREVIEW_SLOTS output buffers); the PPA
+ * completion interrupt passes the job on to the present task, which requeues
+ * the V4L2 buffer and swaps the finished slot into the canvas. The slot that
+ * was on screen returns to the free list only then, so the PPA never writes a
+ * buffer LVGL may be reading. DQBUF paces the loop at the sensor frame rate.
+ *
+ * Mirror / flip go to the sensor as V4L2_CID_HFLIP / VFLIP (esp_video maps them
+ * to ESP_CAM_SENSOR_HMIRROR / VFLIP). When it takes both, there is nothing left
+ * for the PPA to do and no copy is made: each V4L2 buffer is wrapped in an
+ * lv_image_dsc_t and shown as captured. The buffer on screen belongs to the
+ * display; the present task requeues it only once the next frame has
+ * replaced it.
+ *
+ * The preview size (setCameraPreviewSize) picks the sensor mode, see
+ * cam_pick_mode(). The PPA crops the frame to the preview aspect ratio and
+ * scales it to size; only an exact fit with the sensor orientation is shown
+ * directly.
+ */
+#define PREVIEW_JOB_EXIT   UINT32_MAX
+#define PREVIEW_JOB_DIRECT 0xFF  // Slot field: the V4L2 buffer itself goes on screen
+
+typedef struct {
+    bool hmirror = true;  // Requested orientation
+    bool vflip   = false;
+    bool direct;          // The sensor applies it, frames are shown in place
+    uint32_t want_w = CAMERA_WIDTH;  // Requested size
+    uint32_t want_h = CAMERA_HEIGHT;
+    uint32_t out_w;                  // Frames on screen
+    uint32_t out_h;
+    uint32_t out_bytes;              // out_w x out_h RGB565 up to a cache line; the PPA syncs this much per frame
+    uint32_t crop_x;                 // Of the captured frame, to out_w x out_h
+    uint32_t crop_y;
+    uint32_t crop_w;
+    uint32_t crop_h;
+    uint8_t* slot[PREVIEW_SLOTS];
+    lv_image_dsc_t slot_dsc[PREVIEW_SLOTS];
+    lv_image_dsc_t frame_dsc[EXAMPLE_VIDEO_BUFFER_COUNT];
+    QueueHandle_t free_slots;  // int: slots the PPA may write
+    QueueHandle_t done_jobs;   // uint32_t preview_job(), from the PPA ISR
+    TaskHandle_t capture_task;
+    std::atomic<uint32_t> presented;
+} preview_t;
+
+static preview_t preview;
+
+static inline uint32_t preview_job(uint32_t v4l2_index, int slot)
+{
+    return (v4l2_index << 8) | (uint32_t)slot;
+}
+
+static void preview_dsc_init(lv_image_dsc_t* dsc, uint8_t* data, uint32_t width, uint32_t height)
+{
+    const uint32_t size = width * height * 2;
+    memset(dsc, 0, sizeof(*dsc));
+    dsc->header.magic  = LV_IMAGE_HEADER_MAGIC;
+    dsc->header.cf     = LV_COLOR_FORMAT_RGB565;
+    dsc->header.w      = width;
+    dsc->header.h      = height;
+    dsc->header.stride = width * 2;
+    dsc->data          = data;
+    dsc->data_size     = size;
+}
+
+static void preview_requeue(uint32_t v4l2_index)
+{
+    struct v4l2_buffer buf;
+    memset(&buf, 0, sizeof(buf));
+    buf.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory    = MEMORY_TYPE;
+    buf.index     = v4l2_index;
+    buf.m.userptr = (unsigned long)camera->buffer[v4l2_index];
+    buf.length    = CAMERA_FRAME_BYTES;
+    if (ioctl(camera->fd, VIDIOC_QBUF, &buf) != 0) {
+        ESP_LOGE(TAG, "failed to free video frame");
+    }
+}
+
+// Swap the canvas onto dsc; LVGL only renders under the display lock, so what it showed before is no longer read
+static void preview_show(const lv_image_dsc_t* dsc)
+{
+    bsp_display_lock(0);
+    lv_image_cache_drop(dsc);  // Same source, new pixels
+    lv_image_set_src(camera_canvas, dsc);
+    bsp_display_unlock();
+}
+
+static bool set_sensor_ctrl(int fd, uint32_t id, int32_t value)
+{
+    struct v4l2_ext_control control;
+    struct v4l2_ext_controls controls;
+    memset(&control, 0, sizeof(control));
+    memset(&controls, 0, sizeof(controls));
+    control.id          = id;
+    control.value       = value;
+    controls.ctrl_class = V4L2_CTRL_CLASS_USER;
+    controls.count      = 1;
+    controls.controls   = &control;
+    return ioctl(fd, VIDIOC_S_EXT_CTRLS, &controls) == 0;
+}
+
+// Orient in the sensor if it can, so frames need no PPA pass
+static bool set_sensor_flip(int fd, bool hmirror, bool vflip)
+{
+    const bool h = set_sensor_ctrl(fd, V4L2_CID_HFLIP, hmirror ? 1 : 0);
+    const bool v = set_sensor_ctrl(fd, V4L2_CID_VFLIP, vflip ? 1 : 0);
+    return h && v;
+}
+
+static bool IRAM_ATTR on_preview_ppa_done(ppa_client_handle_t client, ppa_event_data_t* event_data, void* user_data)
+{
+    BaseType_t woken = pdFALSE;
+    const uint32_t job = (uint32_t)(uintptr_t)user_data;
+    xQueueSendFromISR(preview.done_jobs, &job, &woken);
+    return woken == pdTRUE;
+}
+
+static void app_camera_present(void* arg)
+{
+    int shown       = -1;  // Slot on screen (PPA path)
+    int shown_frame = -1;  // V4L2 buffer on screen (direct path)
+    uint32_t job;
+    while (xQueueReceive(preview.done_jobs, &job, portMAX_DELAY) == pdPASS && job != PREVIEW_JOB_EXIT) {
+        const uint32_t index = job >> 8;
+        const int slot       = (int)(job & 0xFF);
+        const lv_image_dsc_t* dsc = slot == PREVIEW_JOB_DIRECT ? &preview.frame_dsc[index] : &preview.slot_dsc[slot];
+        if (slot == PREVIEW_JOB_DIRECT) {
+            preview_show(dsc);
+            if (shown_frame >= 0) {
+                preview_requeue(shown_frame);
+            }
+            shown_frame = index;
+        } else {
+            preview_requeue(index);
+            preview_show(dsc);
+            if (shown >= 0) {
+                xQueueSend(preview.free_slots, &shown, 0);
+            }
+            shown = slot;
+        }
+        // The frame on screen stays put until the next one replaces it, which is after this
+        CameraJpeg& jpeg = CameraJpeg::getInstance();
+        if (jpeg.wanted()) {
+            jpeg.encode(dsc->data, dsc->data_size, dsc->header.w, dsc->header.h);
+        }
+        VideoRecorder& recorder = VideoRecorder::getInstance();
+        if (recorder.wanted() && dsc->header.w == VideoRecorder::WIDTH && dsc->header.h == VideoRecorder::HEIGHT) {
+            recorder.pushFrame(dsc->data, dsc->data_size);
+        }
+        FaceTracker& faces = FaceTracker::getInstance();
+        if (faces.wanted()) {
+            faces.offer(dsc->data, dsc->header.w, dsc->header.h, preview.hmirror);
+        }
+        preview.presented.fetch_add(1);
+    }
+    // Back to the driver before the capture task stops the stream
+    if (shown_frame >= 0) {
+        preview_requeue(shown_frame);
+    }
+    xTaskNotifyGive(preview.capture_task);
+    vTaskDelete(NULL);
+}
+
 void app_camera_display(void* arg)
 {
     /* camera config */
@@ -223,7 +519,7 @@ void app_camera_display(void* arg)
             {
                 .init_sccb  = false,
                 .i2c_handle = NULL,
-                .freq       = 400000,  // TAB5_MIPI_CSI_SCCB_I2C_FREQ,
+                .freq       = CONFIG_HOWIZARD_CAMERA_SCCB_HZ,  // TAB5_MIPI_CSI_SCCB_I2C_FREQ: 400000
             },
         .reset_pin = -1,  // TAB5_MIPI_CSI_CAM_SENSOR_RESET_PIN,
         .pwdn_pin  = -1,  // TAB5_MIPI_CSI_CAM_SENSOR_PWDN_PIN,
@@ -237,7 +533,6 @@ void app_camera_display(void* arg)
     };
 
     if (!cam_is_initial) {
-        camera = (cam_t*)malloc(sizeof(cam_t));
         printf("\n============= video init ==============\n");
         cam_is_initial = true;
         ESP_ERROR_CHECK(esp_video_init(&cam_config));
@@ -245,85 +540,132 @@ void app_camera_display(void* arg)
         int video_cam_fd = app_video_open(CAM_DEV_PATH, EXAMPLE_VIDEO_FMT_RGB565);
         if (video_cam_fd < 0) {
             ESP_LOGE(TAG, "video cam open failed");
+            camera_mutex.lock();
+            is_camera_capturing = false;
+            camera_mutex.unlock();
             return;
         }
         ESP_ERROR_CHECK(new_cam(video_cam_fd, &camera));
     }
 
+    camera_mutex.lock();
+    preview.out_w = preview.want_w;
+    preview.out_h = preview.want_h;
+    camera_mutex.unlock();
+    preview.out_bytes = (preview.out_w * preview.out_h * 2 + CAMERA_BUFFER_ALIGN - 1) & ~(CAMERA_BUFFER_ALIGN - 1);
+    cam_set_mode(camera, preview.out_w, preview.out_h);
+    preview.crop_w = MIN(camera->width, camera->height * preview.out_w / preview.out_h);
+    preview.crop_h = MIN(camera->height, camera->width * preview.out_h / preview.out_w);
+    preview.crop_x = (camera->width - preview.crop_w) / 2;
+    preview.crop_y = (camera->height - preview.crop_h) / 2;
+    const bool fits = camera->width == preview.out_w && camera->height == preview.out_h;
+
+    // After the mode change: a new register table may reset the sensor orientation
+    camera_mutex.lock();
+    preview.direct = set_sensor_flip(camera->fd, preview.hmirror, preview.vflip) && fits;
+    camera_mutex.unlock();
+    ESP_LOGI(TAG, "preview: %" PRIu32 "x%" PRIu32 " from %" PRIu32 "x%" PRIu32 ", %s", preview.out_w, preview.out_h,
+             camera->width, camera->height, preview.direct ? "sensor orientation, zero-copy" : "PPA");
+
+    if (cam_stream_on(camera) != ESP_OK) {
+        cam_stream_off(camera);
+        camera_mutex.lock();
+        is_camera_capturing = false;
+        camera_mutex.unlock();
+        return;
+    }
+
     struct v4l2_buffer buf;
 
-    /* */
-    uint16_t screen_width  = 1280;  // 640;//lcd_height();
-    uint16_t screen_height = 720;   // 480;//lcd_width();
-    uint8_t* img_show_data = NULL;
-    uint32_t img_show_size = screen_width * screen_height * 2;
-    // uint32_t img_offset = 280 * 720 * 2;
-    uint32_t img_offset = 0;
-    static image_t* img_show;  // 初始化静态变量时不能使用非常量表达式
-    if (img_show == NULL) {
-        img_show    = (image_t*)malloc(sizeof(image_t));
-        img_show->w = 720,            // screen_width;
-                                      // img_show->h = 720, // screen_height;
-            img_show->h      = 1280,  // screen_height;
-            img_show->pixfmt = PIXFORMAT_RGB565;
-        img_show->size       = img_show->w * img_show->h * img_show->bpp;
-        img_show_data        = (uint8_t*)heap_caps_calloc(img_show_size, 1, MALLOC_CAP_DMA | MALLOC_CAP_SPIRAM);
-        img_show->data       = img_show_data + img_offset;
-        if (img_show->data == NULL) {
-            ESP_LOGE(TAG, "malloc for img_show->data failed");
-        }
+    preview.free_slots   = xQueueCreate(PREVIEW_SLOTS, sizeof(int));
+    preview.done_jobs    = xQueueCreate(PREVIEW_SLOTS + 1, sizeof(uint32_t));  // + 1 for PREVIEW_JOB_EXIT
+    preview.capture_task = xTaskGetCurrentTaskHandle();
+    preview.presented    = 0;
+    for (int i = 0; i < EXAMPLE_VIDEO_BUFFER_COUNT; i++) {
+        preview_dsc_init(&preview.frame_dsc[i], camera->buffer[i], camera->width, camera->height);
     }
 
     ppa_client_handle_t ppa_srm_handle = NULL;
-    ppa_client_config_t ppa_srm_config = {
-        .oper_type             = PPA_OPERATION_SRM,
-        .max_pending_trans_num = 1,
-    };
-    ESP_ERROR_CHECK(ppa_register_client(&ppa_srm_config, &ppa_srm_handle));
+    if (!preview.direct) {
+        for (int i = 0; i < PREVIEW_SLOTS; i++) {
+            // Cache-line aligned: the JPEG encoder takes slots as USERPTR buffers
+            preview.slot[i] = frame_pool_get(EXAMPLE_VIDEO_BUFFER_COUNT + i);
+            if (preview.slot[i] != NULL) {
+                preview_dsc_init(&preview.slot_dsc[i], preview.slot[i], preview.out_w, preview.out_h);
+                xQueueSend(preview.free_slots, &i, 0);
+            }
+        }
+
+        ppa_client_config_t ppa_srm_config = {
+            .oper_type             = PPA_OPERATION_SRM,
+            .max_pending_trans_num = PREVIEW_SLOTS - 1,  // The third slot is on screen
+        };
+        ESP_ERROR_CHECK(ppa_register_client(&ppa_srm_config, &ppa_srm_handle));
+        ppa_event_callbacks_t ppa_cbs = {
+            .on_trans_done = on_preview_ppa_done,
+        };
+        ESP_ERROR_CHECK(ppa_client_register_event_callbacks(ppa_srm_handle, &ppa_cbs));
+    }
 
-    int task_control = 0;
+    xTaskCreatePinnedToCore(app_camera_present, "cam_show", 4 * 1024, NULL, 5, NULL, core_policy::SYSTEM_AFFINITY);
+
+    int task_control   = 0;
+    uint32_t submitted = 0;
     while (1) {
+        // A slot first: with two frames in the PPA, the sensor keeps the V4L2 buffers meanwhile
+        int slot = PREVIEW_JOB_DIRECT;
+        if (!preview.direct) {
+            xQueueReceive(preview.free_slots, &slot, portMAX_DELAY);
+        }
+
         memset(&buf, 0, sizeof(buf));
         buf.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
         buf.memory = MEMORY_TYPE;
         if (ioctl(camera->fd, VIDIOC_DQBUF, &buf) != 0) {
             ESP_LOGE(TAG, "failed to receive video frame");
+            if (!preview.direct) {
+                xQueueSend(preview.free_slots, &slot, 0);
+            }
             break;
         }
 
-        ppa_srm_oper_config_t srm_config = {.in             = {.buffer         = camera->buffer[buf.index],
-                                                               .pic_w          = 1280,
-                                                               .pic_h          = 720,
-                                                               .block_w        = 1280,
-                                                               .block_h        = 720,
-                                                               .block_offset_x = 0,
-                                                               .block_offset_y = 0,
-                                                               .srm_cm         = PPA_SRM_COLOR_MODE_RGB565},
-                                            .out            = {.buffer         = img_show_data,
-                                                               .buffer_size    = img_show_size,
-                                                               .pic_w          = 1280,
-                                                               .pic_h          = 720,
-                                                               .block_offset_x = 0,
-                                                               .block_offset_y = 0,
-                                                               .srm_cm         = PPA_SRM_COLOR_MODE_RGB565},
-                                            .rotation_angle = PPA_SRM_ROTATION_ANGLE_0,
-                                            .scale_x        = 1,
-                                            .scale_y        = 1,
-                                            .mirror_x       = true,
-                                            .mirror_y       = false,
-                                            .rgb_swap       = false,
-                                            .byte_swap      = false,
-                                            .mode           = PPA_TRANS_MODE_BLOCKING};
-        ppa_do_scale_rotate_mirror(ppa_srm_handle, &srm_config);
-
-        // auto detect_results = human_face_detector->run(dl_img); // format: hwc
-
-        bsp_display_lock(0);
-        lv_canvas_set_buffer(camera_canvas, img_show->data, CAMERA_WIDTH, CAMERA_HEIGHT, LV_COLOR_FORMAT_RGB565);
-        bsp_display_unlock();
-
-        if (ioctl(camera->fd, VIDIOC_QBUF, &buf) != 0) {
-            ESP_LOGE(TAG, "failed to free video frame");
+        if (preview.direct) {
+            // One frame on screen, one queued here at most: the queue never fills
+            const uint32_t job = preview_job(buf.index, PREVIEW_JOB_DIRECT);
+            xQueueSend(preview.done_jobs, &job, portMAX_DELAY);
+            submitted++;
+        } else {
+            ppa_srm_oper_config_t srm_config = {.in             = {.buffer         = camera->buffer[buf.index],
+                                                                   .pic_w          = camera->width,
+                                                                   .pic_h          = camera->height,
+                                                                   .block_w        = preview.crop_w,
+                                                                   .block_h        = preview.crop_h,
+                                                                   .block_offset_x = preview.crop_x,
+                                                                   .block_offset_y = preview.crop_y,
+                                                                   .srm_cm         = PPA_SRM_COLOR_MODE_RGB565},
+                                                .out            = {.buffer         = preview.slot[slot],
+                                                                   .buffer_size    = preview.out_bytes,
+                                                                   .pic_w          = preview.out_w,
+                                                                   .pic_h          = preview.out_h,
+                                                                   .block_offset_x = 0,
+                                                                   .block_offset_y = 0,
+                                                                   .srm_cm         = PPA_SRM_COLOR_MODE_RGB565},
+                                                .rotation_angle = PPA_SRM_ROTATION_ANGLE_0,
+                                                .scale_x        = (float)preview.out_w / preview.crop_w,
+                                                .scale_y        = (float)preview.out_h / preview.crop_h,
+                                                .mirror_x       = preview.hmirror,
+                                                .mirror_y       = preview.vflip,
+                                                .rgb_swap       = false,
+                                                .byte_swap      = false,
+                                                .mode           = PPA_TRANS_MODE_NON_BLOCKING,
+                                                .user_data      = (void*)(uintptr_t)preview_job(buf.index, slot)};
+            if (ppa_do_scale_rotate_mirror(ppa_srm_handle, &srm_config) == ESP_OK) {
+                submitted++;
+            } else {
+                ESP_LOGE(TAG, "ppa srm failed");
+                preview_requeue(buf.index);
+                xQueueSend(preview.free_slots, &slot, 0);
+            }
         }
 
         if (xQueueReceive(queue_camera_ctrl, &task_control, 0) == pdPASS) {
@@ -338,54 +680,79 @@ void app_camera_display(void* arg)
                 }
             }
         }
-
-        vTaskDelay(pdMS_TO_TICKS(10));
     }
 
     ESP_LOGI(TAG, "task exit");
-    ppa_unregister_client(ppa_srm_handle);
-    // delete human_face_detector;
-    if (img_show_data) {
-        heap_caps_free(img_show_data);
-        img_show_data = NULL;
+    // Let the frames in flight land before tearing the pipeline down
+    while (preview.presented.load() < submitted) {
+        vTaskDelay(pdMS_TO_TICKS(5));
+    }
+    const uint32_t exit_job = PREVIEW_JOB_EXIT;
+    xQueueSend(preview.done_jobs, &exit_job, portMAX_DELAY);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    if (ppa_srm_handle) {
+        ppa_unregister_client(ppa_srm_handle);
     }
-    if (img_show) {
-        heap_caps_free(img_show);
-        img_show = NULL;
+    for (int i = 0; i < PREVIEW_SLOTS; i++) {
+        preview.slot[i] = NULL;  // Stay in frame_pool for the next start
     }
-    // close(camera->fd);
+    vQueueDelete(preview.done_jobs);
+    vQueueDelete(preview.free_slots);
+    cam_stream_off(camera);
 
     camera_mutex.lock();
     is_camera_capturing = false;
     camera_mutex.unlock();
-
-    vTaskDelete(NULL);
 }
 
 void HalEsp32::startCameraCapture(lv_obj_t* imgCanvas)
 {
     mclog::tagInfo(TAG, "start camera capture");
 
+    // A capture task that outlived its stop still owns the stream and the preview queues
+    if (!camera_task.join(0)) {
+        mclog::tagError(TAG, "previous capture task still running");
+        return;
+    }
+
     camera_canvas = imgCanvas;
 
-    queue_camera_ctrl = xQueueCreate(10, sizeof(int));
     if (queue_camera_ctrl == NULL) {
-        ESP_LOGD(TAG, "Failed to create semaphore\n");
+        queue_camera_ctrl = xQueueCreate(10, sizeof(int));
+        if (queue_camera_ctrl == NULL) {
+            mclog::tagError(TAG, "failed to create control queue");
+            return;
+        }
     }
+    xQueueReset(queue_camera_ctrl);
 
     is_camera_capturing = true;
-    xTaskCreatePinnedToCore(app_camera_display, "cam", 8 * 1024, NULL, 5, NULL, 1);
+    if (!camera_task.create(app_camera_display, "cam", 8 * 1024, NULL, 5, core_policy::SYSTEM_AFFINITY)) {
+        mclog::tagError(TAG, "failed to create capture task");
+        is_camera_capturing = false;
+    }
 }
 
 void HalEsp32::stopCameraCapture()
 {
     mclog::tagInfo(TAG, "stop camera capture");
+    VideoRecorder::getInstance().stop();  // No frames to record past this point
+
+    if (!camera_task.isRunning()) {
+        return;
+    }
 
-    int control_state = 0;  // pause
+    int control_state = TASK_CONTROL_PAUSE;
     xQueueSend(queue_camera_ctrl, &control_state, portMAX_DELAY);
 
-    control_state = 2;  // exit
+    control_state = TASK_CONTROL_EXIT;
     xQueueSend(queue_camera_ctrl, &control_state, portMAX_DELAY);
+
+    // Returns with the stream off and every preview buffer back, so a restart can't race the teardown
+    if (!camera_task.join(CAMERA_STOP_TIMEOUT)) {
+        mclog::tagWarn(TAG, "capture task did not exit in time");
+    }
 }
 
 bool HalEsp32::isCameraCapturing()
@@ -393,3 +760,118 @@ bool HalEsp32::isCameraCapturing()
     std::lock_guard<std::mutex> lock(camera_mutex);
     return is_camera_capturing;
 }
+
+bool HalEsp32::setCameraMirror(bool hmirror, bool vflip)
+{
+    std::lock_guard<std::mutex> lock(camera_mutex);
+    preview.hmirror = hmirror;
+    preview.vflip   = vflip;
+    if (!is_camera_capturing || !camera) {
+        return true;  // Applied when capture starts
+    }
+    if (preview.direct) {
+        // The sensor took it before; if it refuses now, the PPA path comes back on the next start
+        return set_sensor_flip(camera->fd, hmirror, vflip);
+    }
+    return true;  // The PPA reads the flags per frame
+}
+
+bool HalEsp32::setCameraPreviewSize(uint32_t width, uint32_t height)
+{
+    if (width == 0 || height == 0) {
+        width  = CAMERA_WIDTH;
+        height = CAMERA_HEIGHT;
+    }
+    if (width > CAMERA_WIDTH || height > CAMERA_HEIGHT || width < 16 || height < 16) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(camera_mutex);
+    preview.want_w = width & ~1u;  // Even, for the JPEG and PPA block sizes
+    preview.want_h = height & ~1u;
+    return true;
+}
+
+bool HalEsp32::saveCameraSnapshot(std::string& savedPath)
+{
+    if (!isCameraCapturing()) {
+        return false;
+    }
+
+    // Encoded by the present task from the next frame on screen
+    CameraJpeg& jpeg = CameraJpeg::getInstance();
+    std::vector<uint8_t> frame;
+    uint32_t seq = jpeg.sequence();
+    jpeg.addClient();
+    const bool got = jpeg.waitFrame(frame, seq, 1000);
+    jpeg.removeClient();
+    if (!got || !SdStorage::getInstance().mount()) {
+        return false;
+    }
+
+    static int next_index = 1;
+    char path[48];
+    struct stat st;
+    snprintf(path, sizeof(path), "%s/DCIM", SdStorage::MOUNT_POINT);
+    mkdir(path, 0777);
+    do {
+        snprintf(path, sizeof(path), "%s/DCIM/IMG_%04d.JPG", SdStorage::MOUNT_POINT, next_index++);
+    } while (stat(path, &st) == 0 && next_index < 10000);
+
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        ESP_LOGE(TAG, "open %s failed", path);
+        return false;
+    }
+    const bool ok = fwrite(frame.data(), 1, frame.size(), f) == frame.size();
+    fclose(f);
+    if (ok) {
+        savedPath = path;
+        mclog::tagInfo(TAG, "snapshot {} ({} bytes)", savedPath, frame.size());
+    }
+    return ok;
+}
+
+bool HalEsp32::startSessionRecording()
+{
+    if (!isCameraCapturing()) {
+        return false;
+    }
+    if (preview.out_w != VideoRecorder::WIDTH || preview.out_h != VideoRecorder::HEIGHT) {
+        mclog::tagWarn(TAG, "recording needs the full-size preview");
+        return false;
+    }
+    return VideoRecorder::getInstance().start();
+}
+
+void HalEsp32::stopSessionRecording()
+{
+    VideoRecorder::getInstance().stop();
+}
+
+bool HalEsp32::isSessionRecording()
+{
+    return VideoRecorder::getInstance().isRecording();
+}
+
+bool HalEsp32::setFaceSteering(bool enabled)
+{
+    return FaceTracker::getInstance().setEnabled(enabled);
+}
+
+bool HalEsp32::isFaceSteering()
+{
+    return FaceTracker::getInstance().isEnabled();
+}
+
+bool HalEsp32::releaseCameraBuffers()
+{
+    std::lock_guard<std::mutex> lock(camera_mutex);
+    if (is_camera_capturing) {
+        return false;
+    }
+    const size_t freed = frame_pool_release();
+    if (freed) {
+        mclog::tagInfo(TAG, "released {} KB of camera frame memory", freed / 1024);
+    }
+    return true;
+}
@@ -17,6 +17,8 @@
 #include "freertos/queue.h"
 #include "esp_timer.h"
 #include "accel_gyro_bmi270.h"
+#include "imu_fifo.h"
+#include "motion_monitor.h"
 
 static const std::string _tag = "imu";
 
@@ -40,20 +42,83 @@ void HalEsp32::imu_init()
         mclog::tagInfo(_tag, "imu irq detected! clear it!");
     }
     accel_gyro_bmi270_enable_sensor();
+    ImuFifo::getInstance().start();
+}
+
+static void to_imu_data(const ImuSample& s, HalBase::IMUData_t& data)
+{
+    data.accelX = s.accelX;
+    data.accelY = s.accelY;
+    data.accelZ = s.accelZ;
+    data.gyroX  = s.gyroX;
+    data.gyroY  = s.gyroY;
+    data.gyroZ  = s.gyroZ;
 }
 
 void HalEsp32::updateImuData()
 {
-    static struct bmi2_sens_data bmi_sensor_data;
-    accel_gyro_bmi270_get_data(&bmi_sensor_data);
-
-    /* 根据设置量程转换 */
-    imuData.accelX = bmi_sensor_data.acc.y / 835.92 / 10.0f;  // m/s^2
-    imuData.accelY = -bmi_sensor_data.acc.x / 835.92 / 10.0f;
-    imuData.accelZ = -bmi_sensor_data.acc.z / 835.92 / 10.0f;
-    imuData.gyroX  = bmi_sensor_data.gyr.y / 32.768 / 10.0f;  // °/s   gyro_raw*2*1000/2^16 --> 0.0305
-    imuData.gyroY  = bmi_sensor_data.gyr.x / 32.768 / 10.0f;
-    imuData.gyroZ  = -bmi_sensor_data.gyr.z / 32.768 / 10.0f;
+    // The FIFO drain has it already; no bus traffic per call
+    ImuSample sample;
+    if (!ImuFifo::getInstance().latest(sample)) {
+        static struct bmi2_sens_data bmi_sensor_data;
+        bsp_i2c_acquire(BSP_I2C_CLASS_IMU, BSP_I2C_WAIT_FOREVER);
+        accel_gyro_bmi270_get_data(&bmi_sensor_data);
+        bsp_i2c_release(BSP_I2C_CLASS_IMU);
+        ImuFifo::convert(bmi_sensor_data.acc, bmi_sensor_data.gyr, sample);
+    }
+    to_imu_data(sample, imuData);
+}
+
+size_t HalEsp32::getImuSamples(std::vector<IMUSample_t>& samples, uint32_t& seq)
+{
+    ImuSample batch[32];
+    samples.clear();
+    size_t n;
+    do {
+        n = ImuFifo::getInstance().read(batch, 32, seq);
+        for (size_t i = 0; i < n; i++) {
+            IMUSample_t s;
+            s.timeUs = batch[i].timeUs;
+            to_imu_data(batch[i], s.data);
+            samples.push_back(s);
+        }
+    } while (n == 32);
+    return samples.size();
+}
+
+bool HalEsp32::setMotionAwareAudio(bool enabled)
+{
+    return MotionMonitor::getInstance().setEnabled(enabled);
+}
+
+bool HalEsp32::isMotionAwareAudio()
+{
+    return MotionMonitor::getInstance().isEnabled();
+}
+
+// Audio-only mode wake: a knock on the case is a step between two consecutive samples
+// far larger than handling, walking or a set-down makes
+static constexpr float TAP_JERK_MS2 = 10.0f;
+
+bool HalEsp32::imu_tap_detected(uint32_t& seq)
+{
+    ImuSample batch[16];
+    bool tap = false;
+    // One sample back: the step from the last sample of the previous call counts too
+    uint32_t from = seq > 0 ? seq - 1 : 0;
+    size_t n;
+    do {
+        n = ImuFifo::getInstance().read(batch, 16, from);
+        for (size_t i = 1; i < n && !tap; i++) {
+            const float dx = batch[i].accelX - batch[i - 1].accelX;
+            const float dy = batch[i].accelY - batch[i - 1].accelY;
+            const float dz = batch[i].accelZ - batch[i - 1].accelZ;
+            tap = dx * dx + dy * dy + dz * dz > TAP_JERK_MS2 * TAP_JERK_MS2;
+        }
+        if (n == 16) from--;  // Overlap the next batch by one sample
+    } while (n == 16);
+    seq = from;
+    return tap;
 }
 
 void HalEsp32::sleepAndShakeWakeup()
@@ -61,6 +126,8 @@ void HalEsp32::sleepAndShakeWakeup()
     mclog::tagInfo(_tag, "start aleep and shake wakeup");
 
     clearRtcIrq();
+    MotionMonitor::getInstance().setEnabled(false);
+    ImuFifo::getInstance().stop();  // Off the bus before the sensor is reconfigured
     clearImuIrq();
 
     delay(200);
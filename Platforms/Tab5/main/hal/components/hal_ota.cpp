@@ -0,0 +1,38 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "hal/hal_esp32.h"
+#include "firmware_update.h"
+#include <mooncake_log.h>
+
+static const std::string _tag = "ota";
+
+bool HalEsp32::startFirmwareUpdate(const std::string& source)
+{
+    const bool url = source.rfind("http://", 0) == 0 || source.rfind("https://", 0) == 0;
+    if (url && !wifi_station_begin()) {
+        mclog::tagError(_tag, "no station link for {}", source);
+        return false;
+    }
+    return FirmwareUpdate::getInstance().start(source);
+}
+
+void HalEsp32::cancelFirmwareUpdate()
+{
+    FirmwareUpdate::getInstance().cancel();
+}
+
+int HalEsp32::getFirmwareUpdateProgress()
+{
+    const FirmwareUpdateStats s = FirmwareUpdate::getInstance().getStats();
+    switch (s.state) {
+        case FirmwareUpdate::STATE_RUNNING:
+            return s.total > 0 ? static_cast<int>(static_cast<uint64_t>(s.written) * 99 / s.total) : 0;
+        case FirmwareUpdate::STATE_READY:
+            return 100;
+        default:
+            return -1;
+    }
+}
@@ -4,6 +4,11 @@
  * SPDX-License-Identifier: MIT
  */
 #include "hal/hal_esp32.h"
+#include "power_telemetry.h"
+#include "imu_fifo.h"
+#include "cpu_governor.h"
+#include "session_schedule.h"
+#include "session_store.h"
 #include <mooncake_log.h>
 #include <driver/gpio.h>
 #include <freertos/FreeRTOS.h>
@@ -12,16 +17,54 @@
 #include <esp_sleep.h>
 #include <esp_check.h>
 #include <esp_pm.h>
+#include <esp_lvgl_port.h>
+#include <sdkconfig.h>
+#include <mutex>
 
 static const std::string _tag = "power";
 
 void HalEsp32::updatePowerMonitorData()
 {
     // mclog::tagInfo(_tag, "update power monitor");
+    auto& telemetry = PowerTelemetry::getInstance();
+    PowerSample sample;
+    if (telemetry.latest(sample)) {
+        // Cached by the telemetry task; no bus traffic
+        const PowerTelemetryStats stats = telemetry.getStats();
+        powerMonitorData.busVoltage   = sample.busVoltage;
+        powerMonitorData.shuntVoltage = sample.shuntVoltage;
+        powerMonitorData.busPower     = sample.busPower;
+        powerMonitorData.shuntCurrent = sample.shuntCurrent;
+        powerMonitorData.chargeMah    = static_cast<float>(stats.chargeMah);
+        powerMonitorData.energyMwh    = static_cast<float>(stats.energyMwh);
+        return;
+    }
+
+    // Before the first conversion: one hold for the four reads; a busy bus just keeps the last values
+    if (bsp_i2c_acquire(BSP_I2C_CLASS_TELEMETRY, 100) != ESP_OK) {
+        return;
+    }
     powerMonitorData.busVoltage   = ina226.readBusVoltage();
     powerMonitorData.shuntVoltage = ina226.readShuntVoltage();
     powerMonitorData.busPower     = ina226.readBusPower();
     powerMonitorData.shuntCurrent = ina226.readShuntCurrent();
+    bsp_i2c_release(BSP_I2C_CLASS_TELEMETRY);
+}
+
+size_t HalEsp32::getPowerHistory(std::vector<PMData_t>& history)
+{
+    static PowerSample averages[PowerTelemetry::HISTORY_SIZE];  // Too big for the caller's stack
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    const size_t n = PowerTelemetry::getInstance().history(averages, PowerTelemetry::HISTORY_SIZE);
+    history.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        history[i].busVoltage   = averages[i].busVoltage;
+        history[i].shuntVoltage = averages[i].shuntVoltage;
+        history[i].busPower     = averages[i].busPower;
+        history[i].shuntCurrent = averages[i].shuntCurrent;
+    }
+    return n;
 }
 
 void HalEsp32::setChargeQcEnable(bool enable)
@@ -106,7 +149,9 @@ void HalEsp32::sleepAndTouchWakeup()
     uint8_t touch_cnt = 0;
 
     while (1) {
+        bsp_i2c_acquire(BSP_I2C_CLASS_TOUCH, BSP_I2C_WAIT_FOREVER);
         esp_lcd_touch_read_data(_lcd_touch_handle);
+        bsp_i2c_release(BSP_I2C_CLASS_TOUCH);
         bool touchpad_pressed =
             esp_lcd_touch_get_coordinates(_lcd_touch_handle, touch_x, touch_y, touch_strength, &touch_cnt, 1);
         // mclog::tagInfo(_tag, "touchpad pressed: {}", touchpad_pressed);
@@ -117,7 +162,9 @@ void HalEsp32::sleepAndTouchWakeup()
     }
 
     while (1) {
+        bsp_i2c_acquire(BSP_I2C_CLASS_TOUCH, BSP_I2C_WAIT_FOREVER);
         esp_lcd_touch_read_data(_lcd_touch_handle);
+        bsp_i2c_release(BSP_I2C_CLASS_TOUCH);
         bool touchpad_pressed =
             esp_lcd_touch_get_coordinates(_lcd_touch_handle, touch_x, touch_y, touch_strength, &touch_cnt, 1);
         // mclog::tagInfo(_tag, "touchpad pressed: {}", touchpad_pressed);
@@ -134,6 +181,90 @@ void HalEsp32::sleepAndTouchWakeup()
     setDisplayBrightness(brightness);
 }
 
+#if CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t _ui_pm_lock = nullptr;  // Full CPU clock except in audio-only mode
+#endif
+static std::mutex _audio_only_mutex;
+
+void HalEsp32::pm_init()
+{
+#if CONFIG_PM_ENABLE
+    // DFS only: the I2S stream never stops, and its driver keeps light sleep out while it runs
+    if (esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "ui", &_ui_pm_lock) != ESP_OK) {
+        _ui_pm_lock = nullptr;
+        mclog::tagError(_tag, "no pm lock, clock scaling off");
+        return;
+    }
+    esp_pm_lock_acquire(_ui_pm_lock);  // Before configure: the clock never dips
+    esp_pm_config_t pm_config = {};
+    pm_config.max_freq_mhz       = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    pm_config.min_freq_mhz       = CONFIG_HOWIZARD_AUDIO_ONLY_MIN_CPU_MHZ;
+    pm_config.light_sleep_enable = false;
+    const esp_err_t err = esp_pm_configure(&pm_config);
+    if (err != ESP_OK) {
+        mclog::tagError(_tag, "pm configure failed: {}", esp_err_to_name(err));
+    } else {
+        mclog::tagInfo(_tag, "dfs {}-{} MHz", pm_config.min_freq_mhz, pm_config.max_freq_mhz);
+    }
+#if CONFIG_HOWIZARD_CPU_GOVERNOR
+    if (err == ESP_OK) {
+        CpuGovernor::getInstance().setFloorMhz(CONFIG_HOWIZARD_CPU_GOVERNOR_UI_MIN_MHZ);
+        CpuGovernor::getInstance().setEnabled(true);
+    }
+#endif
+#endif
+}
+
+bool HalEsp32::setAudioOnlyMode(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(_audio_only_mutex);
+    if (enabled == _audio_only.load(std::memory_order_relaxed)) {
+        return true;
+    }
+
+    if (enabled) {
+        mclog::tagInfo(_tag, "audio-only mode on");
+        // The UI's brightness setting is kept for the way back
+        bsp_display_brightness_set(0);
+        bsp_display_sleep(true);
+        lvgl_port_stop();  // From an LVGL callback too: the task stops after this handler pass
+        _audio_only_wake.store(false, std::memory_order_relaxed);
+        _audio_only_imu_seq = ImuFifo::getInstance().getStats().samples;
+        if (bsp_display_set_touch_wake_cb(&HalEsp32::requestAudioOnlyWake) != ESP_OK) {
+            mclog::tagWarn(_tag, "no touch wake on this panel");
+        }
+#if CONFIG_PM_ENABLE
+        if (_ui_pm_lock) esp_pm_lock_release(_ui_pm_lock);
+#endif
+        CpuGovernor::getInstance().setFloorMhz(0);  // Only the audio load counts now
+        _audio_only.store(true, std::memory_order_release);
+        return true;
+    }
+
+#if CONFIG_HOWIZARD_CPU_GOVERNOR
+    CpuGovernor::getInstance().setFloorMhz(CONFIG_HOWIZARD_CPU_GOVERNOR_UI_MIN_MHZ);
+#endif
+#if CONFIG_PM_ENABLE
+    if (_ui_pm_lock) esp_pm_lock_acquire(_ui_pm_lock);
+#endif
+    _audio_only.store(false, std::memory_order_release);
+    bsp_display_set_touch_wake_cb(nullptr);
+    bsp_display_sleep(false);
+    lvgl_port_resume();
+    lvglLock();
+    lv_obj_invalidate(lv_screen_active());
+    lvglUnlock();
+    bsp_display_brightness_set(_current_lcd_brightness);
+    wakeMainLoop();  // A held loop returns to its app updates
+    mclog::tagInfo(_tag, "audio-only mode off");
+    return true;
+}
+
+bool HalEsp32::isAudioOnlyMode()
+{
+    return _audio_only.load(std::memory_order_relaxed);
+}
+
 void HalEsp32::sleepAndRtcWakeup()
 {
     mclog::tagInfo(_tag, "start sleep and rtc wakeup");
@@ -145,6 +276,7 @@ void HalEsp32::sleepAndRtcWakeup()
 
     mclog::tagInfo(_tag, "set rtc alarm");
     struct tm time;
+    bsp_i2c_acquire(BSP_I2C_CLASS_TELEMETRY, BSP_I2C_WAIT_FOREVER);
     rx8130.getTime(&time);
     time.tm_hour = 0;
     time.tm_min  = 1;
@@ -154,6 +286,7 @@ void HalEsp32::sleepAndRtcWakeup()
     time.tm_min  = 2;
     time.tm_sec  = 0;
     rx8130.setAlarmIrq(&time);
+    bsp_i2c_release(BSP_I2C_CLASS_TELEMETRY);
 
     // delay(800);
     powerOff();
@@ -161,3 +294,34 @@ void HalEsp32::sleepAndRtcWakeup()
         delay(100);
     }
 }
+
+bool HalEsp32::sleepUntilSession(uint8_t hour, uint8_t minute)
+{
+    mclog::tagInfo(_tag, "start sleep until session at {:02d}:{:02d}", hour, minute);
+    if (!SessionSchedule::getInstance().arm(hour, minute, AudioEngine::getInstance().getParams())) {
+        return false;
+    }
+    SessionStore::getInstance().flush();  // App close never runs on this way out
+
+    clearRtcIrq();
+    clearImuIrq();
+
+    delay(200);
+
+    struct tm time = {};
+    time.tm_hour = hour;
+    time.tm_min  = minute;
+    bsp_i2c_acquire(BSP_I2C_CLASS_TELEMETRY, BSP_I2C_WAIT_FOREVER);
+    rx8130.setAlarmIrq(&time);
+    bsp_i2c_release(BSP_I2C_CLASS_TELEMETRY);
+
+    powerOff();
+    while (1) {
+        delay(100);
+    }
+}
+
+bool HalEsp32::isSessionWakeup()
+{
+    return SessionSchedule::getInstance().isClaimed();
+}
@@ -4,7 +4,10 @@
  * SPDX-License-Identifier: MIT
  */
 #include "hal/hal_esp32.h"
+#include "../utils/core_policy/core_policy.h"
+#include "modbus_slave.h"
 #include <mooncake_log.h>
+#include <algorithm>
 #include <vector>
 #include <driver/gpio.h>
 #include <memory>
@@ -14,71 +17,126 @@
 #define TAG "hal_rs485"
 
 // RS485
-#define TAB5_RS485_BUF_SIZE (127)
+// Driver-side rings: a burst lands in the driver while the task is busy
+#define TAB5_RS485_RX_RING_SIZE     (1024)
+#define TAB5_RS485_TX_RING_SIZE     (1024)
+#define TAB5_RS485_EVENT_QUEUE_SIZE (16)
+// Bytes moved per uart_read_bytes / uart_write_bytes call
+#define TAB5_RS485_CHUNK_SIZE (256)
 // Timeout threshold for UART = number of symbols (~10 tics) with unchanged state on receive pin
 #define TAB5_RS485_READ_TOUT        (3)  // 3.5T * 8 = 28 ticks, TOUT=3 -> ~24..33 ticks
-#define TAB5_RS485_PACKET_READ_TICS (100 / portTICK_PERIOD_MS)
+// Longest wait for an rx event before queued tx goes out anyway
+#define TAB5_RS485_TX_POLL_TICS (10 / portTICK_PERIOD_MS)
 static uart_port_t tab5_rs485_uart_num = UART_NUM_1;
+static QueueHandle_t tab5_rs485_events = nullptr;
 
 #define TAB5_SYS_RS485_TX_PIN 20
 #define TAB5_SYS_RS485_RX_PIN 21
 #define TAB5_SYS_RS485_DE_PIN 34
 
-static void tab5_rs485_echo_send(const int port, uint8_t* str, uint8_t length)
-{
-    if (uart_write_bytes((uart_port_t)port, str, length) != length) {
-        ESP_LOGE(TAG, "Send data critical failure.");
-        // add your code to handle sending failure here
-        abort();
-    }
-}
-
 static void _rs485_test_task(void* param)
 {
-    // Allocate buffers for UART
-    uint8_t* data  = (uint8_t*)malloc(TAB5_RS485_BUF_SIZE);
-    uint8_t* wdata = (uint8_t*)malloc(TAB5_RS485_BUF_SIZE);
+    auto& monitor = GetHAL()->uartMonitorData;
+    uint8_t chunk[TAB5_RS485_CHUNK_SIZE];
+    uint32_t rx_lost = 0;
 
-    int count               = 0;
-    uint64_t last_send_time = 0;
     while (1) {
-        // Read data from UART
-        memset(data, 0, TAB5_RS485_BUF_SIZE);
-        int len = uart_read_bytes(tab5_rs485_uart_num, data, TAB5_RS485_BUF_SIZE, TAB5_RS485_PACKET_READ_TICS);
-
-        // Write data back to UART
-        if (len > 0) {
-            // printf("Received [%u] : %s\n", len, data);
-            // tab5_rs485_echo_send(tab5_rs485_uart_num, data, len);
-
-            std::lock_guard<std::mutex> lock(GetHAL()->uartMonitorData.mutex);
-            for (int i = 0; i < len; i++) {
-                GetHAL()->uartMonitorData.rxQueue.push(data[i]);
-            }
-            while (GetHAL()->uartMonitorData.rxQueue.size() > 4096) {
-                GetHAL()->uartMonitorData.rxQueue.pop();
+        // Woken by the driver per rx FIFO threshold / TOUT, not per byte
+        uart_event_t event;
+        if (xQueueReceive(tab5_rs485_events, &event, TAB5_RS485_TX_POLL_TICS) == pdTRUE) {
+            switch (event.type) {
+                case UART_DATA: {
+                    size_t pending = 0;
+                    uart_get_buffered_data_len(tab5_rs485_uart_num, &pending);
+                    while (pending > 0) {
+                        const int len = uart_read_bytes(tab5_rs485_uart_num, chunk,
+                                                        std::min<size_t>(pending, sizeof(chunk)), 0);
+                        if (len <= 0) break;
+                        monitor.rx.push_n(chunk, len);
+                        pending -= std::min<size_t>(pending, len);
+                    }
+                    break;
+                }
+                case UART_FIFO_OVF:
+                case UART_BUFFER_FULL:
+                    // The driver can't keep a consistent stream past this: start clean
+                    uart_flush_input(tab5_rs485_uart_num);
+                    xQueueReset(tab5_rs485_events);
+                    mclog::tagWarn(TAG, "rx overflow ({}), input flushed", ++rx_lost);
+                    break;
+                default:
+                    break;
             }
         }
 
-        {
-            std::lock_guard<std::mutex> lock(GetHAL()->uartMonitorData.mutex);
-            while (!GetHAL()->uartMonitorData.txQueue.empty()) {
-                uint8_t txData = GetHAL()->uartMonitorData.txQueue.front();
-                GetHAL()->uartMonitorData.txQueue.pop();
-                uart_write_bytes(tab5_rs485_uart_num, &txData, 1);
-            }
+        // Queued tx in chunks; uart_write_bytes only copies into the driver's tx ring
+        size_t len;
+        while ((len = monitor.tx.pop_n(chunk, sizeof(chunk))) > 0) {
+            uart_write_bytes(tab5_rs485_uart_num, chunk, len);
         }
+    }
+}
+
+#if CONFIG_HOWIZARD_RS485_MODBUS
+// Modbus RTU: a frame ends at the line going quiet, which the driver reports as a TOUT data event
+static void _rs485_modbus_task(void* param)
+{
+    ModbusSlave& slave = ModbusSlave::getInstance();
+    slave.begin(CONFIG_HOWIZARD_RS485_MODBUS_ADDRESS);
+
+    uint8_t frame[ModbusSlave::MAX_FRAME];
+    uint8_t response[ModbusSlave::MAX_FRAME];
+    size_t frame_len = 0;
+    bool overlong    = false;
 
-        vTaskDelay(10 / portTICK_PERIOD_MS);
+    while (1) {
+        uart_event_t event;
+        if (xQueueReceive(tab5_rs485_events, &event, portMAX_DELAY) != pdTRUE) continue;
+        switch (event.type) {
+            case UART_DATA: {
+                size_t pending = 0;
+                uart_get_buffered_data_len(tab5_rs485_uart_num, &pending);
+                while (pending > 0) {
+                    if (frame_len == sizeof(frame)) {
+                        // Longer than any RTU frame: drop it through to the next gap
+                        overlong  = true;
+                        frame_len = 0;
+                    }
+                    const int len = uart_read_bytes(tab5_rs485_uart_num, frame + frame_len,
+                                                    std::min(pending, sizeof(frame) - frame_len), 0);
+                    if (len <= 0) break;
+                    frame_len += len;
+                    pending -= std::min<size_t>(pending, len);
+                }
+                if (!event.timeout_flag) break;
+                if (!overlong) {
+                    const size_t n = slave.handle(frame, frame_len, response);
+                    if (n > 0) uart_write_bytes(tab5_rs485_uart_num, response, n);
+                }
+                frame_len = 0;
+                overlong  = false;
+                break;
+            }
+            case UART_FIFO_OVF:
+            case UART_BUFFER_FULL:
+                uart_flush_input(tab5_rs485_uart_num);
+                xQueueReset(tab5_rs485_events);
+                frame_len = 0;
+                overlong  = false;
+                break;
+            default:
+                break;
+        }
     }
 }
+#endif
 
 void HalEsp32::rs485_init()
 {
     mclog::tagInfo(TAG, "rs485 init");
 
     uart_config_t uart_config;
-    uart_config.baud_rate           = 115200;
+    uart_config.baud_rate           = CONFIG_HOWIZARD_RS485_BAUD;
     uart_config.data_bits           = UART_DATA_8_BITS;
     uart_config.parity              = UART_PARITY_DISABLE;
     uart_config.stop_bits           = UART_STOP_BITS_1;
@@ -86,9 +144,9 @@ void HalEsp32::rs485_init()
     uart_config.rx_flow_ctrl_thresh = 122;
     uart_config.source_clk          = UART_SCLK_DEFAULT;
 
-    // Install UART driver (we don't need an event queue here)
-    // In this example we don't even use a buffer for sending data.
-    ESP_ERROR_CHECK(uart_driver_install(tab5_rs485_uart_num, TAB5_RS485_BUF_SIZE * 2, 0, 0, NULL, 0));
+    // Install UART driver with an event queue, so reads follow the driver instead of polling
+    ESP_ERROR_CHECK(uart_driver_install(tab5_rs485_uart_num, TAB5_RS485_RX_RING_SIZE, TAB5_RS485_TX_RING_SIZE,
+                                        TAB5_RS485_EVENT_QUEUE_SIZE, &tab5_rs485_events, 0));
 
     // Configure UART parameters
     ESP_ERROR_CHECK(uart_param_config(tab5_rs485_uart_num, &uart_config));
@@ -105,5 +163,9 @@ void HalEsp32::rs485_init()
     // Set read timeout of UART TOUT feature
     ESP_ERROR_CHECK(uart_set_rx_timeout(tab5_rs485_uart_num, TAB5_RS485_READ_TOUT));
 
-    xTaskCreate(_rs485_test_task, "rs485", 2000, NULL, 5, NULL);
+#if CONFIG_HOWIZARD_RS485_MODBUS
+    xTaskCreatePinnedToCore(_rs485_modbus_task, "rs485", 4096, NULL, 5, NULL, core_policy::SYSTEM_AFFINITY);
+#else
+    xTaskCreatePinnedToCore(_rs485_test_task, "rs485", 3072, NULL, 5, NULL, core_policy::SYSTEM_AFFINITY);
+#endif
 }
@@ -0,0 +1,120 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "hal/hal_esp32.h"
+#include "cpu_governor.h"
+#include <mooncake_log.h>
+#include <algorithm>
+#include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_heap_caps.h>
+#include <esp_lvgl_port.h>
+
+static const std::string _tag = "system";
+
+// Run-time counters from the previous update, so loads are per-interval, not since boot
+struct RunTimeSample_t {
+    TaskHandle_t handle;
+    configRUN_TIME_COUNTER_TYPE runTime;
+};
+static std::vector<TaskStatus_t> _task_status;
+static std::vector<RunTimeSample_t> _prev_run_time;
+static configRUN_TIME_COUNTER_TYPE _prev_total_run_time = 0;
+
+static void fill_heap_stats(hal::HalBase::HeapStats_t& stats, uint32_t caps)
+{
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, caps);
+    stats.totalBytes   = heap_caps_get_total_size(caps);
+    stats.freeBytes    = info.total_free_bytes;
+    stats.minFreeBytes = info.minimum_free_bytes;
+    stats.largestFree  = info.largest_free_block;
+}
+
+void HalEsp32::updateSystemStats()
+{
+    // A little headroom for tasks created between the count and the snapshot
+    _task_status.resize(uxTaskGetNumberOfTasks() + 4);
+    configRUN_TIME_COUNTER_TYPE total_run_time = 0;
+    UBaseType_t count = uxTaskGetSystemState(_task_status.data(), _task_status.size(), &total_run_time);
+    if (count == 0) {
+        mclog::tagWarn(_tag, "task snapshot failed");
+        return;
+    }
+
+    // The run-time clock is shared by both cores: every core gets this much per interval
+    const configRUN_TIME_COUNTER_TYPE elapsed = total_run_time - _prev_total_run_time;
+    const bool have_prev = _prev_total_run_time != 0 && elapsed > 0;
+
+    std::vector<RunTimeSample_t> run_time;
+    run_time.reserve(count);
+    systemStats.tasks.clear();
+    systemStats.tasks.reserve(count);
+    float idle[2] = {0.0f, 0.0f};
+
+    for (UBaseType_t i = 0; i < count; i++) {
+        const TaskStatus_t& ts = _task_status[i];
+        run_time.push_back({ts.xHandle, ts.ulRunTimeCounter});
+
+        float percent = 0.0f;
+        if (have_prev) {
+            auto prev = std::find_if(_prev_run_time.begin(), _prev_run_time.end(),
+                                     [&](const RunTimeSample_t& s) { return s.handle == ts.xHandle; });
+            // New tasks count from zero
+            configRUN_TIME_COUNTER_TYPE before = prev != _prev_run_time.end() ? prev->runTime : 0;
+            percent = 100.0f * static_cast<float>(ts.ulRunTimeCounter - before) / static_cast<float>(elapsed);
+        }
+
+        for (int core = 0; core < 2; core++) {
+            if (ts.xHandle == xTaskGetIdleTaskHandleForCore(core)) {
+                idle[core] = percent;
+            }
+        }
+
+        TaskStats_t task;
+        task.name           = ts.pcTaskName;
+        task.core           = ts.xCoreID == tskNO_AFFINITY ? -1 : static_cast<int>(ts.xCoreID);
+        task.priority       = static_cast<int>(ts.uxCurrentPriority);
+        task.cpuPercent     = percent;
+        task.stackFreeBytes = ts.usStackHighWaterMark;  // Stack is counted in bytes on ESP-IDF
+        systemStats.tasks.push_back(std::move(task));
+    }
+
+    std::sort(systemStats.tasks.begin(), systemStats.tasks.end(),
+              [](const TaskStats_t& a, const TaskStats_t& b) { return a.cpuPercent > b.cpuPercent; });
+
+    for (int core = 0; core < 2; core++) {
+        systemStats.coreLoad[core] = have_prev ? std::clamp(100.0f - idle[core], 0.0f, 100.0f) : 0.0f;
+    }
+
+    _prev_run_time.swap(run_time);
+    _prev_total_run_time = total_run_time;
+    systemStats.cpuMaxMhz = CpuGovernor::getInstance().getStats().freqMhz;
+
+    updateHeapStats();
+}
+
+void HalEsp32::updateHeapStats()
+{
+    fill_heap_stats(systemStats.heapInternal, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    fill_heap_stats(systemStats.heapDma, MALLOC_CAP_DMA);
+    fill_heap_stats(systemStats.heapPsram, MALLOC_CAP_SPIRAM);
+
+#ifdef ESP_LVGL_PORT_MEM
+    lvgl_port_mem_stats_t lvgl;
+    if (lvgl_port_get_mem_stats(&lvgl) == ESP_OK) {
+        auto fill = [](hal::HalBase::HeapStats_t& stats, const lvgl_port_mem_region_stats_t& region) {
+            stats.totalBytes   = region.total;
+            stats.freeBytes    = region.free;
+            stats.minFreeBytes = region.min_free;
+            stats.largestFree  = region.largest_free;
+        };
+        fill(systemStats.lvglInternal, lvgl.internal);
+        fill(systemStats.lvglPsram, lvgl.psram);
+        systemStats.lvglSpilled = lvgl.spilled;
+    }
+#endif
+}
@@ -4,12 +4,15 @@
  * SPDX-License-Identifier: MIT
  */
 #include "hal/hal_esp32.h"
+#include "../utils/spsc_ring/spsc_ring.h"
 #include <mooncake_log.h>
+#include <algorithm>
+#include <atomic>
 #include <vector>
 #include <driver/gpio.h>
 #include <memory>
-#include <mutex>
 #include <lvgl.h>
+#include <esp_lvgl_port.h>
 #include <usb/usb_host.h>
 #include <usb/hid_host.h>
 #include <usb/hid_usage_keyboard.h>
@@ -19,10 +22,30 @@
 
 #define TAG "usba"
 
-static std::mutex _usba_detect_mutex;
-static bool _is_usba_connected = false;
+static std::atomic<bool> _is_usba_connected{false};
 static lv_obj_t* _cursor_img;
 
+// HID reports reach LVGL as events: the HID driver task pushes, the LVGL task pops in the read
+// callbacks of two event-mode indevs, woken through lvgl_port_task_wake() instead of polled
+struct HidPointerEvent {
+    int16_t x;
+    int16_t y;
+    bool pressed;
+};
+struct HidKeyEvent {
+    uint32_t key;  // LV_KEY_* or a character
+    bool pressed;
+};
+static SpscRing<HidPointerEvent, 64> _pointer_events;
+static SpscRing<HidKeyEvent, 32> _key_events;
+static lv_indev_t* _lv_mouse    = nullptr;
+static lv_indev_t* _lv_keyboard = nullptr;
+
+static void hid_wake_lvgl()
+{
+    lvgl_port_task_wake(LVGL_PORT_EVENT_TOUCH, nullptr);
+}
+
 QueueHandle_t app_event_queue = NULL;
 typedef enum { APP_EVENT = 0, APP_EVENT_HID_HOST } app_event_group_t;
 
@@ -83,18 +106,81 @@ static void hid_host_mouse_report_callback(const uint8_t* const data, const int
     y_pos = std::clamp(y_pos, 0, 1280);
 
     hid_print_new_device_report_header(HID_PROTOCOL_MOUSE);
+    HalEsp32::requestAudioOnlyWake();
 
     // printf("X: %06d\tY: %06d\t|%c|%c|\r", x_pos, y_pos, (mouse_report->buttons.button1 ? 'o' : ' '),
     //        (mouse_report->buttons.button2 ? 'o' : ' '));
 
-    GetHAL()->hidMouseData.mutex.lock();
-    GetHAL()->hidMouseData.x        = x_pos;
-    GetHAL()->hidMouseData.y        = y_pos;
-    GetHAL()->hidMouseData.btnLeft  = mouse_report->buttons.button1;
-    GetHAL()->hidMouseData.btnRight = mouse_report->buttons.button2;
-    GetHAL()->hidMouseData.mutex.unlock();
+    _pointer_events.push({static_cast<int16_t>(x_pos), static_cast<int16_t>(y_pos),
+                          static_cast<bool>(mouse_report->buttons.button1)});
+    hid_wake_lvgl();
+}
+
+// Boot keyboard usages (HID Usage Tables, keyboard page) LVGL has a navigation key for
+static uint32_t hid_key_to_lv(uint8_t usage, bool shift)
+{
+    static constexpr char LOWER[] = "abcdefghijklmnopqrstuvwxyz1234567890";
+    static constexpr char UPPER[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ!@#$%^&*()";
+    if (usage >= 0x04 && usage <= 0x27) return shift ? UPPER[usage - 0x04] : LOWER[usage - 0x04];
+    switch (usage) {
+        case 0x28: return LV_KEY_ENTER;
+        case 0x29: return LV_KEY_ESC;
+        case 0x2A: return LV_KEY_BACKSPACE;
+        case 0x2B: return shift ? LV_KEY_PREV : LV_KEY_NEXT;
+        case 0x2C: return ' ';
+        case 0x2D: return shift ? '_' : '-';
+        case 0x2E: return shift ? '+' : '=';
+        case 0x36: return shift ? '<' : ',';
+        case 0x37: return shift ? '>' : '.';
+        case 0x38: return shift ? '?' : '/';
+        case 0x4A: return LV_KEY_HOME;
+        case 0x4C: return LV_KEY_DEL;
+        case 0x4D: return LV_KEY_END;
+        case 0x4F: return LV_KEY_RIGHT;
+        case 0x50: return LV_KEY_LEFT;
+        case 0x51: return LV_KEY_DOWN;
+        case 0x52: return LV_KEY_UP;
+        default: return 0;
+    }
+}
+
+static void hid_host_keyboard_report_callback(const uint8_t* const data, const int length)
+{
+    hid_keyboard_input_report_boot_t* kb_report = (hid_keyboard_input_report_boot_t*)data;
+
+    if (length < sizeof(hid_keyboard_input_report_boot_t)) {
+        return;
+    }
+
+    // A boot report lists the keys held now: presses and releases are the difference to the last one
+    static uint8_t prev_keys[HID_KEYBOARD_KEY_MAX] = {0};
+    const bool shift = kb_report->modifier.val & (HID_LEFT_SHIFT | HID_RIGHT_SHIFT);
+    auto held        = [](const uint8_t* keys, uint8_t usage) {
+        return std::find(keys, keys + HID_KEYBOARD_KEY_MAX, usage) != keys + HID_KEYBOARD_KEY_MAX;
+    };
+
+    bool queued = false;
+    for (int i = 0; i < HID_KEYBOARD_KEY_MAX; i++) {
+        const uint8_t released = prev_keys[i];
+        if (released > HID_KEY_ERROR_UNDEFINED && !held(kb_report->key, released)) {
+            const uint32_t key = hid_key_to_lv(released, shift);
+            if (key) queued |= _key_events.push({key, false});
+        }
+    }
+    for (int i = 0; i < HID_KEYBOARD_KEY_MAX; i++) {
+        const uint8_t pressed = kb_report->key[i];
+        if (pressed > HID_KEY_ERROR_UNDEFINED && !held(prev_keys, pressed)) {
+            const uint32_t key = hid_key_to_lv(pressed, shift);
+            if (key) queued |= _key_events.push({key, true});
+        }
+    }
+    std::copy(kb_report->key, kb_report->key + HID_KEYBOARD_KEY_MAX, prev_keys);
 
-    fflush(stdout);
+    if (queued) {
+        hid_print_new_device_report_header(HID_PROTOCOL_KEYBOARD);
+        HalEsp32::requestAudioOnlyWake();
+        hid_wake_lvgl();
+    }
 }
 
 void hid_host_interface_callback(hid_host_device_handle_t hid_device_handle, const hid_host_interface_event_t event,
@@ -111,7 +197,7 @@ void hid_host_interface_callback(hid_host_device_handle_t hid_device_handle, con
 
             if (HID_SUBCLASS_BOOT_INTERFACE == dev_params.sub_class) {
                 if (HID_PROTOCOL_KEYBOARD == dev_params.proto) {
-                    // hid_host_keyboard_report_callback(data, data_length);
+                    hid_host_keyboard_report_callback(data, data_length);
                 } else if (HID_PROTOCOL_MOUSE == dev_params.proto) {
                     hid_host_mouse_report_callback(data, data_length);
                 }
@@ -124,9 +210,9 @@ void hid_host_interface_callback(hid_host_device_handle_t hid_device_handle, con
             ESP_LOGI(TAG, "HID Device, protocol '%s' DISCONNECTED", hid_proto_name_str[dev_params.proto]);
             ESP_ERROR_CHECK(hid_host_device_close(hid_device_handle));
 
-            _usba_detect_mutex.lock();
-            _is_usba_connected = false;
-            _usba_detect_mutex.unlock();
+            // The read callbacks hide the cursor and drop anything still held
+            _is_usba_connected.store(false, std::memory_order_release);
+            hid_wake_lvgl();
 
             break;
         case HID_HOST_INTERFACE_EVENT_TRANSFER_ERROR:
@@ -158,9 +244,8 @@ void hid_host_device_event(hid_host_device_handle_t hid_device_handle, const hid
             }
             ESP_ERROR_CHECK(hid_host_device_start(hid_device_handle));
 
-            _usba_detect_mutex.lock();
-            _is_usba_connected = true;
-            _usba_detect_mutex.unlock();
+            _is_usba_connected.store(true, std::memory_order_release);
+            hid_wake_lvgl();
 
             break;
         }
@@ -228,26 +313,37 @@ static void tab5_usb_host_task(void* pvParameters)
     }
 }
 
+// Event mode: LVGL runs these only when hid_wake_lvgl() asked, one event per read, so any
+// left over wake it again
 static void lvgl_mouse_read_cb(lv_indev_t* indev, lv_indev_data_t* data)
 {
-    _usba_detect_mutex.lock();
-    if (!_is_usba_connected) {
-        _usba_detect_mutex.unlock();
-        data->state = LV_INDEV_STATE_REL;
-        if (lv_obj_get_style_opa(_cursor_img, LV_PART_MAIN) == LV_OPA_COVER) {
-            lv_obj_set_style_opa(_cursor_img, LV_OPA_TRANSP, LV_PART_MAIN);
-        }
-        return;
-    }
-    _usba_detect_mutex.unlock();
-    if (lv_obj_get_style_opa(_cursor_img, LV_PART_MAIN) == LV_OPA_TRANSP) {
-        lv_obj_set_style_opa(_cursor_img, LV_OPA_COVER, LV_PART_MAIN);
+    static HidPointerEvent last = {720 / 2, 1280 / 2, false};
+
+    const bool connected = _is_usba_connected.load(std::memory_order_acquire);
+    const lv_opa_t opa   = connected ? LV_OPA_COVER : LV_OPA_TRANSP;
+    if (lv_obj_get_style_opa(_cursor_img, LV_PART_MAIN) != opa) {
+        lv_obj_set_style_opa(_cursor_img, opa, LV_PART_MAIN);
     }
 
-    std::lock_guard<std::mutex> lock(GetHAL()->hidMouseData.mutex);
-    data->point.x = GetHAL()->hidMouseData.x;
-    data->point.y = GetHAL()->hidMouseData.y;
-    data->state   = GetHAL()->hidMouseData.btnLeft ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+    HidPointerEvent event;
+    if (_pointer_events.pop(event)) last = event;
+    if (!connected) last.pressed = false;
+    data->point.x = last.x;
+    data->point.y = last.y;
+    data->state   = last.pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+    if (!_pointer_events.empty()) hid_wake_lvgl();
+}
+
+static void lvgl_keyboard_read_cb(lv_indev_t* indev, lv_indev_data_t* data)
+{
+    static HidKeyEvent last = {0, false};
+
+    HidKeyEvent event;
+    if (_key_events.pop(event)) last = event;
+    if (!_is_usba_connected.load(std::memory_order_acquire)) last.pressed = false;
+    data->key   = last.key;
+    data->state = last.pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+    if (!_key_events.empty()) hid_wake_lvgl();
 }
 
 void HalEsp32::hid_init()
@@ -255,18 +351,30 @@ void HalEsp32::hid_init()
     mclog::tagInfo(TAG, "hid init");
     xTaskCreatePinnedToCore(tab5_usb_host_task, "usba", 4096 * 2, NULL, 5, NULL, 0);
 
-    auto lvMouse = lv_indev_create();
-    lv_indev_set_type(lvMouse, LV_INDEV_TYPE_POINTER);
-    lv_indev_set_read_cb(lvMouse, lvgl_mouse_read_cb);
-    lv_indev_set_display(lvMouse, lvDisp);
+    _lv_mouse = lv_indev_create();
+    lv_indev_set_type(_lv_mouse, LV_INDEV_TYPE_POINTER);
+    lv_indev_set_read_cb(_lv_mouse, lvgl_mouse_read_cb);
+    lv_indev_set_display(_lv_mouse, lvDisp);
+    lv_indev_set_mode(_lv_mouse, LV_INDEV_MODE_EVENT);
 
     _cursor_img = lv_image_create(lv_screen_active()); /*Create an image object for the cursor */
     lv_image_set_src(_cursor_img, &mouse_cursor);      /*Set the image source*/
-    lv_indev_set_cursor(lvMouse, _cursor_img);         /*Connect the image  object to the driver*/
+    lv_obj_set_style_opa(_cursor_img, LV_OPA_TRANSP, LV_PART_MAIN);
+    lv_indev_set_cursor(_lv_mouse, _cursor_img); /*Connect the image  object to the driver*/
+
+    // Keyboard: Tab / arrows / Enter move through and operate the default group, which widgets
+    // created from here on join
+    _lv_keyboard = lv_indev_create();
+    lv_indev_set_type(_lv_keyboard, LV_INDEV_TYPE_KEYPAD);
+    lv_indev_set_read_cb(_lv_keyboard, lvgl_keyboard_read_cb);
+    lv_indev_set_display(_lv_keyboard, lvDisp);
+    lv_indev_set_mode(_lv_keyboard, LV_INDEV_MODE_EVENT);
+    lv_group_t* group = lv_group_create();
+    lv_group_set_default(group);
+    lv_indev_set_group(_lv_keyboard, group);
 }
 
 bool HalEsp32::usbADetect()
 {
-    std::lock_guard<std::mutex> lock(_usba_detect_mutex);
-    return _is_usba_connected;
+    return _is_usba_connected.load(std::memory_order_acquire);
 }
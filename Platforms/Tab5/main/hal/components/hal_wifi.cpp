@@ -4,18 +4,22 @@
  * SPDX-License-Identifier: MIT
  */
 #include "hal/hal_esp32.h"
+#include "../utils/core_policy/core_policy.h"
+#include "camera_jpeg.h"
+#include "remote_tuning.h"
+#include "wifi_link.h"
+#include "nvs_storage.h"
 #include <mooncake_log.h>
 #include <vector>
 #include <memory>
+#include <mutex>
 #include <string.h>
 #include <bsp/m5stack_tab5.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/event_groups.h>
 #include <esp_wifi.h>
-#include <nvs_flash.h>
 #include <esp_event.h>
 #include <esp_log.h>
-#include <nvs_flash.h>
 #include <esp_netif.h>
 #include <esp_http_server.h>
 
@@ -68,17 +72,60 @@ esp_err_t hello_get_handler(httpd_req_t* req)
     return ESP_OK;
 }
 
+#define STREAM_BOUNDARY "howizardframe"
+
+// MJPEG of the camera preview while it runs; the connection holds its server task until the client goes
+esp_err_t stream_get_handler(httpd_req_t* req)
+{
+    CameraJpeg& jpeg = CameraJpeg::getInstance();
+    httpd_resp_set_type(req, "multipart/x-mixed-replace;boundary=" STREAM_BOUNDARY);
+
+    std::vector<uint8_t> frame;
+    uint32_t seq  = jpeg.sequence();
+    esp_err_t ret = ESP_OK;
+    jpeg.addClient();
+    while (ret == ESP_OK) {
+        if (!jpeg.waitFrame(frame, seq, 2000)) {
+            ESP_LOGI(TAG, "stream: no frames (camera stopped)");
+            break;
+        }
+        char part[96];
+        const int len = snprintf(part, sizeof(part),
+                                 "\r\n--" STREAM_BOUNDARY "\r\nContent-Type: image/jpeg\r\nContent-Length: %u\r\n\r\n",
+                                 (unsigned)frame.size());
+        ret = httpd_resp_send_chunk(req, part, len);
+        if (ret == ESP_OK) {
+            ret = httpd_resp_send_chunk(req, reinterpret_cast<const char*>(frame.data()), frame.size());
+        }
+    }
+    jpeg.removeClient();
+    httpd_resp_send_chunk(req, nullptr, 0);
+    return ESP_OK;
+}
+
 // URI 路由
 httpd_uri_t hello_uri = {.uri = "/", .method = HTTP_GET, .handler = hello_get_handler, .user_ctx = nullptr};
+httpd_uri_t stream_uri = {.uri = "/stream", .method = HTTP_GET, .handler = stream_get_handler, .user_ctx = nullptr};
+
+static std::mutex s_server_mutex;
+static httpd_handle_t s_server = nullptr;
 
-// 启动 Web Server
+// 启动 Web Server; once, shared by the softAP and the station link
 httpd_handle_t start_webserver()
 {
+    std::lock_guard<std::mutex> lock(s_server_mutex);
+    if (s_server) return s_server;
+
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     httpd_handle_t server = nullptr;
+    config.core_id = core_policy::SYSTEM_AFFINITY;
+    config.close_fn = RemoteTuning::closeSocket;  // Frees the tuning client slot
 
     if (httpd_start(&server, &config) == ESP_OK) {
         httpd_register_uri_handler(server, &hello_uri);
+        httpd_register_uri_handler(server, &stream_uri);
+        RemoteTuning::getInstance().start(server);
+        s_server = server;
     }
     return server;
 }
@@ -86,14 +133,10 @@ httpd_handle_t start_webserver()
 // 初始化 Wi-Fi AP 模式
 void wifi_init_softap()
 {
-    ESP_ERROR_CHECK(esp_netif_init());
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
+    ESP_ERROR_CHECK(WifiLink::initStack() ? ESP_OK : ESP_FAIL);
 
     esp_netif_create_default_wifi_ap();
 
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
-
     wifi_config_t wifi_config = {};
     std::strncpy(reinterpret_cast<char*>(wifi_config.ap.ssid), WIFI_SSID, sizeof(wifi_config.ap.ssid));
     std::strncpy(reinterpret_cast<char*>(wifi_config.ap.password), WIFI_PASS, sizeof(wifi_config.ap.password));
@@ -101,9 +144,13 @@ void wifi_init_softap()
     wifi_config.ap.max_connection = MAX_STA_CONN;
     wifi_config.ap.authmode       = WIFI_AUTH_OPEN;
 
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_AP));
+    // Keep a running station link: APSTA, and no restart of the already started radio
+    WifiLink& link = WifiLink::getInstance();
+    link.setAccessPointActive(true);
+    const bool sta = link.isRadioOn();
+    ESP_ERROR_CHECK(esp_wifi_set_mode(sta ? WIFI_MODE_APSTA : WIFI_MODE_AP));
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_AP, &wifi_config));
-    ESP_ERROR_CHECK(esp_wifi_start());
+    if (!sta) ESP_ERROR_CHECK(esp_wifi_start());
 
     ESP_LOGI(TAG, "Wi-Fi AP started. SSID:%s password:%s", WIFI_SSID, WIFI_PASS);
 }
@@ -123,14 +170,13 @@ bool HalEsp32::wifi_init()
 {
     mclog::tagInfo(TAG, "wifi init");
 
-    esp_err_t ret = nvs_flash_init();
-    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-        ESP_ERROR_CHECK(nvs_flash_erase());
-        ret = nvs_flash_init();
+    // The Wi-Fi driver keeps its settings in NVS, brought up at boot
+    if (!NvsStorage::getInstance().ready()) {
+        mclog::tagError(TAG, "NVS unavailable, not starting the AP");
+        return false;
     }
-    ESP_ERROR_CHECK(ret);
 
-    xTaskCreate(wifi_ap_test_task, "ap", 4096, nullptr, 5, nullptr);
+    xTaskCreatePinnedToCore(wifi_ap_test_task, "ap", 4096, nullptr, 5, nullptr, core_policy::SYSTEM_AFFINITY);
     return true;
 }
 
@@ -150,3 +196,19 @@ void HalEsp32::startWifiAp()
 {
     wifi_init();
 }
+
+bool HalEsp32::wifi_station_begin()
+{
+    return WifiLink::getInstance().begin([] { start_webserver(); });
+}
+
+void HalEsp32::setRemoteTuningEnabled(bool enabled)
+{
+    if (enabled && !wifi_station_begin()) return;
+    WifiLink::getInstance().want(WifiLink::CLIENT_REMOTE_TUNING, enabled);
+}
+
+bool HalEsp32::isWifiConnected()
+{
+    return WifiLink::getInstance().isConnected();
+}
@@ -0,0 +1,181 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "imu_fifo.h"
+#include "../utils/core_policy/core_policy.h"
+#include <mooncake_log.h>
+#include <algorithm>
+#include <bsp/m5stack_tab5.h>
+#include <esp_timer.h>
+
+static const char* TAG = "ImuFifo";
+
+static constexpr int DRAIN_STACK = 3072;
+static constexpr UBaseType_t DRAIN_PRIORITY = 2;
+
+ImuFifo& ImuFifo::getInstance()
+{
+    static ImuFifo instance;
+    return instance;
+}
+
+void ImuFifo::convert(const bmi2_sens_axes_data& accel, const bmi2_sens_axes_data& gyro, ImuSample& out)
+{
+    /* 根据设置量程转换 */
+    out.accelX = accel.y / 835.92 / 10.0f;  // m/s^2
+    out.accelY = -accel.x / 835.92 / 10.0f;
+    out.accelZ = -accel.z / 835.92 / 10.0f;
+    out.gyroX = gyro.y / 32.768 / 10.0f;  // °/s   gyro_raw*2*1000/2^16 --> 0.0305
+    out.gyroY = gyro.x / 32.768 / 10.0f;
+    out.gyroZ = -gyro.z / 32.768 / 10.0f;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Control
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool ImuFifo::start()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_running.load(std::memory_order_relaxed)) return true;
+
+    if (!accel_gyro_bmi270_fifo_enable(WATERMARK_FRAMES)) {
+        mclog::tagError(TAG, "FIFO setup failed");
+        return false;
+    }
+    _head = 0;
+    _lastUs = 0;
+    _stats = {};
+    _stopRequested.store(false, std::memory_order_relaxed);
+    _running.store(true, std::memory_order_release);
+    _drainAlive.store(true, std::memory_order_release);
+    if (xTaskCreatePinnedToCore(drainTask, "imu_fifo", DRAIN_STACK, this, DRAIN_PRIORITY, &_task,
+                                core_policy::SYSTEM_AFFINITY) != pdPASS) {
+        _running.store(false, std::memory_order_relaxed);
+        _drainAlive.store(false, std::memory_order_relaxed);
+        _task = nullptr;
+        accel_gyro_bmi270_fifo_disable();
+        mclog::tagError(TAG, "failed to create drain task");
+        return false;
+    }
+    mclog::tagInfo(TAG, "{} Hz, {} frames per drain", ODR_HZ, WATERMARK_FRAMES);
+    return true;
+}
+
+void ImuFifo::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_running.load(std::memory_order_relaxed)) return;
+        _stopRequested.store(true, std::memory_order_release);
+    }
+    // At most one drain period plus a drain
+    for (int i = 0; i < 50 && _drainAlive.load(std::memory_order_acquire); i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _task = nullptr;
+    _running.store(false, std::memory_order_release);
+    accel_gyro_bmi270_fifo_disable();
+}
+
+ImuFifoStats ImuFifo::getStats()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    ImuFifoStats s = _stats;
+    s.running = isRunning();
+    s.samples = _head;
+    return s;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Readers
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool ImuFifo::latest(ImuSample& out)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_head == 0) return false;
+    out = _ring[(_head - 1) % RING_SIZE];
+    return true;
+}
+
+size_t ImuFifo::read(ImuSample* out, size_t max, uint32_t& seq)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    const uint32_t oldest = _head > RING_SIZE ? _head - RING_SIZE : 0;
+    if (seq > _head) seq = _head;  // From before a restart
+    if (seq < oldest) {
+        // Skipped over by the writer; the reader resumes at the oldest sample kept
+        if (seq != 0) _stats.overruns += oldest - seq;
+        seq = oldest;
+    }
+    size_t n = 0;
+    while (n < max && seq < _head) {
+        out[n++] = _ring[seq++ % RING_SIZE];
+    }
+    return n;
+}
+
+void ImuFifo::setListener(Listener listener, void* ctx)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _listener.store(nullptr, std::memory_order_release);
+    _listenerCtx = ctx;
+    _listener.store(listener, std::memory_order_release);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Drain task
+// ─────────────────────────────────────────────────────────────────────────────
+
+void ImuFifo::drainTask(void* param)
+{
+    static_cast<ImuFifo*>(param)->drainLoop();
+}
+
+void ImuFifo::drainLoop()
+{
+    const TickType_t period = pdMS_TO_TICKS(WATERMARK_FRAMES * 1000 / ODR_HZ);
+    TickType_t wake = xTaskGetTickCount();
+    while (!_stopRequested.load(std::memory_order_acquire)) {
+        vTaskDelayUntil(&wake, period);
+        const uint32_t before = _head;
+        drain();
+        Listener listener = _listener.load(std::memory_order_acquire);
+        if (listener && _head != before) listener(_listenerCtx);
+    }
+    _drainAlive.store(false, std::memory_order_release);
+    vTaskDelete(nullptr);
+}
+
+void ImuFifo::drain()
+{
+    // Twice at most: a late wakeup can leave more than one read's worth queued
+    for (int pass = 0; pass < 2; pass++) {
+        uint16_t count = BMI270_FIFO_MAX_FRAMES;
+        // One hold per pass: the codec and touch get the bus between the two
+        if (bsp_i2c_acquire(BSP_I2C_CLASS_IMU, WATERMARK_FRAMES * 1000 / ODR_HZ) != ESP_OK) return;
+        const bool ok = accel_gyro_bmi270_fifo_read(_accel, _gyro, &count);
+        bsp_i2c_release(BSP_I2C_CLASS_IMU);
+        const int64_t now = esp_timer_get_time();
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!ok) {
+            _stats.readErrors++;
+            return;
+        }
+        _stats.drains++;
+        // The last frame is the newest; the ones before it go back at the ODR
+        for (uint16_t i = 0; i < count; i++) {
+            ImuSample& s = _ring[_head % RING_SIZE];
+            convert(_accel[i], _gyro[i], s);
+            s.timeUs = std::max<int64_t>(now - (count - 1 - i) * PERIOD_US, _lastUs + 1);
+            _lastUs = s.timeUs;
+            _head++;
+        }
+        if (count < BMI270_FIFO_MAX_FRAMES) return;
+    }
+}
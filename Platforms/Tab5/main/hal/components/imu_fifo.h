@@ -0,0 +1,104 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "accel_gyro_bmi270.h"
+
+// HAL axes and units: m/s^2, °/s
+struct ImuSample {
+    int64_t timeUs = 0;  // esp_timer time the sample was taken (back-dated from the drain)
+    float accelX = 0.0f;
+    float accelY = 0.0f;
+    float accelZ = 0.0f;
+    float gyroX = 0.0f;
+    float gyroY = 0.0f;
+    float gyroZ = 0.0f;
+};
+
+struct ImuFifoStats {
+    bool running = false;
+    uint32_t samples = 0;     // Into the ring since start
+    uint32_t drains = 0;      // Burst reads
+    uint32_t readErrors = 0;
+    uint32_t overruns = 0;    // Samples readers lost to the ring wrapping
+};
+
+/**
+ * @brief Batched BMI270 accel + gyro over the sensor FIFO
+ *
+ * The BMI270 queues accel + gyro frames at ODR_HZ in its FIFO, with a
+ * watermark of WATERMARK_FRAMES. A Core 0 task drains it once per watermark
+ * period: a FIFO length read, then all the frames in a single I2C burst (plus
+ * the driver's two-byte config read). That is three transactions on the shared
+ * internal bus (codec, IO expander, touch, INA226) per WATERMARK_FRAMES
+ * samples, not one per sample. Samples are converted to HAL axes and units,
+ * timestamped back from the drain time at the ODR, and kept in a RING_SIZE
+ * ring. Readers follow the ring with a sequence number, and latest() serves
+ * updateImuData() with no bus traffic.
+ *
+ * On Tab5 the BMI270 INT1 line only wakes the board from power off, so the
+ * ESP32-P4 gets no watermark interrupt. The drain is timed to the watermark
+ * period instead, and the FIFO holds far more frames than one period's worth.
+ */
+class ImuFifo {
+public:
+    static constexpr uint32_t ODR_HZ = 200;           // accel_gyro_bmi270_enable_sensor()
+    static constexpr uint32_t WATERMARK_FRAMES = 16;  // 80 ms
+    static constexpr uint32_t RING_SIZE = 256;        // 1.28 s
+    static constexpr int64_t PERIOD_US = 1000000 / ODR_HZ;
+
+    static ImuFifo& getInstance();
+
+    // The sensor must be initialised and enabled
+    bool start();
+    void stop();
+    bool isRunning() const
+    {
+        return _running.load(std::memory_order_relaxed);
+    }
+    ImuFifoStats getStats();
+
+    // Newest sample; false before the first drain
+    bool latest(ImuSample& out);
+    // Samples after `seq` (0: the oldest kept), oldest first; advances seq past the last copied
+    size_t read(ImuSample* out, size_t max, uint32_t& seq);
+    // Called on the drain task after each drain that added samples (nullptr: none); keep it short
+    using Listener = void (*)(void* ctx);
+    void setListener(Listener listener, void* ctx);
+
+    static void convert(const bmi2_sens_axes_data& accel, const bmi2_sens_axes_data& gyro, ImuSample& out);
+
+private:
+    ImuFifo() = default;
+    ImuFifo(const ImuFifo&) = delete;
+    ImuFifo& operator=(const ImuFifo&) = delete;
+
+    static void drainTask(void* param);
+    void drainLoop();
+    void drain();
+
+    std::mutex _mutex;  // start/stop, the ring
+    std::atomic<bool> _running{false};
+    std::atomic<bool> _stopRequested{false};
+    std::atomic<bool> _drainAlive{false};
+    TaskHandle_t _task = nullptr;
+    std::atomic<Listener> _listener{nullptr};
+    void* _listenerCtx = nullptr;
+
+    // Drain task only
+    bmi2_sens_axes_data _accel[BMI270_FIFO_MAX_FRAMES];
+    bmi2_sens_axes_data _gyro[BMI270_FIFO_MAX_FRAMES];
+    int64_t _lastUs = 0;
+
+    ImuSample _ring[RING_SIZE];
+    uint32_t _head = 0;  // Samples written, the next one goes to _ring[_head % RING_SIZE]
+    ImuFifoStats _stats;
+};
@@ -0,0 +1,172 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "keypad_controls.h"
+#include "audio_engine.h"
+#include "../utils/core_policy/core_policy.h"
+#include <mooncake_log.h>
+#include <bsp/m5stack_tab5.h>
+#include <driver/gpio.h>
+#include <esp_attr.h>
+#include <keypad_scanner_tca8418.h>
+
+static const char* TAG = "Keypad";
+
+static constexpr int KEYPAD_STACK = 3072;
+static constexpr UBaseType_t KEYPAD_PRIORITY = 3;  // Above the telemetry and IMU readers: a press is felt
+static constexpr uint32_t INT_TIMEOUT_MS = 1000;   // A missed edge costs a second, not the keypad
+
+static constexpr uint8_t INT_STAT_OVR_FLOW = 0x08;
+static constexpr int MAX_DRAIN_PASSES = 4;  // INT held low by something never cleared must not spin the task
+static constexpr uint8_t EVENT_PRESS = 0x80;
+
+KeypadControls& KeypadControls::getInstance()
+{
+    static KeypadControls instance;
+    return instance;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Control
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool KeypadControls::start(int intGpio)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_running.load(std::memory_order_relaxed)) return true;
+    if (intGpio < 0) return false;
+
+    bsp_ext_i2c_init();
+    i2c_master_bus_handle_t bus = bsp_ext_i2c_get_handle();
+    if (!bus || i2c_master_probe(bus, I2C_ADDR, 50) != ESP_OK) {
+        mclog::tagInfo(TAG, "no keyboard accessory");
+        return false;
+    }
+    keypad_scanner_tca8418_init(bus);
+    keypad_scanner_tca8418_matrix(ROWS, COLUMNS);
+    keypad_scanner_tca8418_flush();
+
+    _intGpio = intGpio;
+    _stats = {};
+    _running.store(true, std::memory_order_release);
+    if (xTaskCreatePinnedToCore(keypadTask, "keypad", KEYPAD_STACK, this, KEYPAD_PRIORITY, &_task,
+                                core_policy::SYSTEM_AFFINITY) != pdPASS) {
+        _running.store(false, std::memory_order_relaxed);
+        _task = nullptr;
+        mclog::tagError(TAG, "failed to create keypad task");
+        return false;
+    }
+
+    // INT is open drain, active low, held while events are queued
+    gpio_config_t io = {};
+    io.pin_bit_mask = 1ULL << intGpio;
+    io.mode = GPIO_MODE_INPUT;
+    io.pull_up_en = GPIO_PULLUP_ENABLE;
+    io.intr_type = GPIO_INTR_NEGEDGE;
+    esp_err_t err = gpio_config(&io);
+    if (err == ESP_OK) {
+        err = gpio_install_isr_service(0);
+        if (err == ESP_ERR_INVALID_STATE) err = ESP_OK;  // Already installed
+    }
+    if (err == ESP_OK) err = gpio_isr_handler_add(static_cast<gpio_num_t>(intGpio), intIsr, this);
+    if (err != ESP_OK) {
+        mclog::tagWarn(TAG, "INT on GPIO {} failed ({}), polling every {} ms", intGpio, esp_err_to_name(err),
+                       INT_TIMEOUT_MS);
+    }
+    keypad_scanner_tca8418_enable_int();
+    xTaskNotifyGive(_task);  // Anything pressed before the edge could be seen
+    mclog::tagInfo(TAG, "{}x{} keypad on GPIO {}", ROWS, COLUMNS, intGpio);
+    return true;
+}
+
+KeypadStats KeypadControls::getStats()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    KeypadStats s = _stats;
+    s.running = isRunning();
+    return s;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Keypad task
+// ─────────────────────────────────────────────────────────────────────────────
+
+void IRAM_ATTR KeypadControls::intIsr(void* arg)
+{
+    TaskHandle_t task = static_cast<KeypadControls*>(arg)->_task;
+    if (!task) return;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(task, &woken);
+    if (woken == pdTRUE) portYIELD_FROM_ISR();
+}
+
+void KeypadControls::keypadTask(void* param)
+{
+    static_cast<KeypadControls*>(param)->keypadLoop();
+}
+
+void KeypadControls::keypadLoop()
+{
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(INT_TIMEOUT_MS));
+        // INT only falls once while events stay queued: drain until it is released
+        for (int pass = 0; pass < MAX_DRAIN_PASSES; pass++) {
+            drain();
+            if (gpio_get_level(static_cast<gpio_num_t>(_intGpio)) != 0) break;
+        }
+    }
+}
+
+void KeypadControls::drain()
+{
+    const uint8_t intStat = keypad_scanner_tca8418_get_int_stat();
+    if (intStat == 0) return;
+
+    uint8_t events[FIFO_DEPTH];
+    int count = 0;
+    while (count < FIFO_DEPTH) {
+        const uint8_t event = keypad_scanner_tca8418_get_event();
+        if (event == 0) break;
+        events[count++] = event;
+    }
+    // The Fn key is a GPI: its events come through the FIFO too, so its flag is just cleared
+    keypad_scanner_tca8418_clear_int_stat(intStat);
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats.events += count;
+        if (intStat & INT_STAT_OVR_FLOW) _stats.overflows++;
+    }
+    for (int i = 0; i < count; i++) {
+        if (events[i] & EVENT_PRESS) apply(events[i] & 0x7F);
+    }
+}
+
+void KeypadControls::apply(uint8_t key)
+{
+    AudioEngine& engine = AudioEngine::getInstance();
+    switch (key) {
+        case KEY_UP:
+        case KEY_DOWN: {
+            const int step = key == KEY_UP ? VOLUME_STEP : -VOLUME_STEP;
+            engine.setOutputVolume(engine.getParams().outputVolume + step);
+            break;
+        }
+        case KEY_M:
+            engine.setMute(!engine.getParams().outputMute);
+            break;
+        case KEY_A:
+        case KEY_B:
+            if (!engine.selectAbSlot(key == KEY_A ? 0 : 1)) {
+                mclog::tagInfo(TAG, "A/B slot {} not set", key == KEY_A ? "A" : "B");
+            }
+            break;
+        default:
+            return;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stats.actions++;
+    _stats.lastKey = key;
+}
@@ -0,0 +1,78 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+struct KeypadStats {
+    bool running = false;
+    uint32_t events = 0;     // Key events drained from the TCA8418
+    uint32_t actions = 0;    // Presses that reached the engine
+    uint32_t overflows = 0;  // Drains that found the chip's FIFO full (events lost)
+    uint8_t lastKey = 0;     // Key number of the last press, 0 if none
+};
+
+/**
+ * @brief Audio controls from the keyboard accessory's TCA8418, off the UI path
+ *
+ * The TCA8418 (Port A I2C, 0x34) scans the 8x9 matrix on its own and queues up
+ * to FIFO_DEPTH press / release events, pulling INT low while any is pending.
+ * A Core 0 task sleeps on the INT falling edge, drains the queue (and again
+ * while INT stays low, for events that landed during the drain) and maps
+ * presses straight to AudioEngine setters:
+ *
+ *  - UP / DOWN: output volume by VOLUME_STEP
+ *  - M: mute toggle
+ *  - A / B: select A/B comparison slot 0 / 1
+ *
+ * Nothing goes through LVGL or the main loop, so the keys work in audio-only
+ * mode without turning the display on. start() probes for the chip and
+ * returns false without the accessory; Port A stays in use while it runs.
+ */
+class KeypadControls {
+public:
+    static constexpr uint8_t I2C_ADDR = 0x34;
+    static constexpr uint8_t ROWS = 8;
+    static constexpr uint8_t COLUMNS = 9;
+    static constexpr int FIFO_DEPTH = 10;
+    static constexpr int VOLUME_STEP = 5;
+
+    // Key numbers (row * 10 + column + 1), see key_value_map_str
+    static constexpr uint8_t KEY_M = 25;
+    static constexpr uint8_t KEY_UP = 59;
+    static constexpr uint8_t KEY_A = 63;
+    static constexpr uint8_t KEY_DOWN = 69;
+    static constexpr uint8_t KEY_B = 73;
+
+    static KeypadControls& getInstance();
+
+    bool start(int intGpio);
+    bool isRunning() const
+    {
+        return _running.load(std::memory_order_relaxed);
+    }
+    KeypadStats getStats();
+
+private:
+    KeypadControls() = default;
+    KeypadControls(const KeypadControls&) = delete;
+    KeypadControls& operator=(const KeypadControls&) = delete;
+
+    static void intIsr(void* arg);
+    static void keypadTask(void* param);
+    void keypadLoop();
+    void drain();
+    void apply(uint8_t key);
+
+    std::mutex _mutex;  // _stats
+    std::atomic<bool> _running{false};
+    TaskHandle_t _task = nullptr;
+    int _intGpio = -1;
+    KeypadStats _stats;
+};
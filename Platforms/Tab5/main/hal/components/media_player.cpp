@@ -0,0 +1,436 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "media_player.h"
+#include "audio_engine.h"
+#include "../utils/mp3_decoder/mp3_decoder.h"
+#include <mooncake_log.h>
+#include <algorithm>
+#include <cstring>
+#include <strings.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+static const char* TAG = "Media";
+
+MediaPlayer& MediaPlayer::getInstance()
+{
+    static MediaPlayer instance;
+    return instance;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Files
+// ─────────────────────────────────────────────────────────────────────────────
+
+MediaPlayer::Format MediaPlayer::formatOf(const std::string& path)
+{
+    const size_t dot = path.rfind('.');
+    if (dot == std::string::npos) return FORMAT_NONE;
+    const char* ext = path.c_str() + dot + 1;
+    if (strcasecmp(ext, "mp3") == 0) return FORMAT_MP3;
+    if (strcasecmp(ext, "wav") == 0) return FORMAT_WAV;
+    return FORMAT_NONE;
+}
+
+static uint32_t getLe(const uint8_t* p, int bytes)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < bytes; i++) v |= static_cast<uint32_t>(p[i]) << (8 * i);
+    return v;
+}
+
+bool MediaPlayer::openMp3(FILE* f)
+{
+    // A leading ID3v2 tag (cover art can make it hundreds of KB) is seeked over, not read
+    uint8_t h[10] = {};
+    const size_t n = fread(h, 1, sizeof(h), f);
+    const size_t tag = n == sizeof(h) ? Mp3Decoder::id3Size(h) : 0;
+    if (fseek(f, static_cast<long>(tag), SEEK_SET) != 0) return false;
+    fseek(f, 0, SEEK_END);
+    const long size = ftell(f);
+    if (size <= static_cast<long>(tag) || fseek(f, static_cast<long>(tag), SEEK_SET) != 0) return false;
+    _dataLeft = static_cast<uint32_t>(size - tag);
+    return true;
+}
+
+bool MediaPlayer::openWav(FILE* f)
+{
+    uint8_t h[12];
+    if (fread(h, 1, sizeof(h), f) != sizeof(h) || memcmp(h, "RIFF", 4) != 0 || memcmp(h + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+    // Chunks up to "data"; "fmt " must come first, anything else (LIST, JUNK) is skipped
+    _wavRate = 0;
+    uint8_t ch[8];
+    while (fread(ch, 1, sizeof(ch), f) == sizeof(ch)) {
+        const uint32_t size = getLe(ch + 4, 4);
+        if (memcmp(ch, "fmt ", 4) == 0) {
+            uint8_t fmt[16];
+            if (size < sizeof(fmt) || fread(fmt, 1, sizeof(fmt), f) != sizeof(fmt)) return false;
+            const uint32_t tag = getLe(fmt, 2);
+            _wavChannels = static_cast<int>(getLe(fmt + 2, 2));
+            _wavRate = getLe(fmt + 4, 4);
+            _wavBits = static_cast<int>(getLe(fmt + 14, 2));
+            // PCM, or WAVE_FORMAT_EXTENSIBLE, which this writer and most others only use for PCM
+            if ((tag != 1 && tag != 0xFFFE) || (_wavChannels != 1 && _wavChannels != 2) ||
+                (_wavBits != 16 && _wavBits != 24) || _wavRate == 0) {
+                mclog::tagWarn(TAG, "unsupported WAV: format {}, {} ch, {}-bit", tag, _wavChannels, _wavBits);
+                return false;
+            }
+            if (fseek(f, static_cast<long>((size - sizeof(fmt) + 1) & ~1u), SEEK_CUR) != 0) return false;
+        } else if (memcmp(ch, "data", 4) == 0) {
+            if (_wavRate == 0) return false;
+            const uint32_t frameBytes = _wavChannels * _wavBits / 8;
+            _dataLeft = size / frameBytes * frameBytes;
+            return _dataLeft > 0;
+        } else if (fseek(f, static_cast<long>((size + 1) & ~1u), SEEK_CUR) != 0) {
+            return false;
+        }
+    }
+    return false;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Control
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool MediaPlayer::play(const std::string& path, Input input, float gain)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!stopLocked()) return false;
+
+    const Format format = formatOf(path);
+    if (format == FORMAT_NONE) {
+        mclog::tagWarn(TAG, "{}: not an MP3 or WAV file", path);
+        return false;
+    }
+    if (!AudioEngine::getInstance().isRunning()) {
+        mclog::tagWarn(TAG, "audio engine not running, nothing to play through");
+        return false;
+    }
+    if (!_ring) {
+        _ring = static_cast<uint8_t*>(heap_caps_malloc(PREFETCH_BYTES, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+        if (!_ring) {
+            mclog::tagError(TAG, "no PSRAM for the prefetch ring");
+            return false;
+        }
+    }
+    if (!SdStorage::getInstance().mount()) {
+        mclog::tagError(TAG, "failed to mount SD card");
+        return false;
+    }
+    _file = fopen(path.c_str(), "rb");
+    if (!_file) {
+        mclog::tagError(TAG, "failed to open {}", path);
+        return false;
+    }
+    // Reads are already large; stdio buffering would only add a copy
+    setvbuf(_file, nullptr, _IONBF, 0);
+    _format = format;
+    if (!(format == FORMAT_MP3 ? openMp3(_file) : openWav(_file))) {
+        mclog::tagError(TAG, "{}: unreadable header", path);
+        fclose(_file);
+        _file = nullptr;
+        return false;
+    }
+
+    _gain = gain;
+    _duckDb = input == INPUT_REPLACE ? REPLACE_DUCK_DB : MIX_DUCK_DB;
+    _head.store(0, std::memory_order_relaxed);
+    _tail.store(0, std::memory_order_relaxed);
+    _readerDone.store(false, std::memory_order_relaxed);
+    _stopRequested.store(false, std::memory_order_relaxed);
+    _playedUs.store(0, std::memory_order_relaxed);
+    _sampleRate.store(0, std::memory_order_relaxed);
+    _channels.store(0, std::memory_order_relaxed);
+    _starvations.store(0, std::memory_order_relaxed);
+    _readErrors.store(0, std::memory_order_relaxed);
+    _worstReadUs.store(0, std::memory_order_relaxed);
+    _lowFillPct.store(100, std::memory_order_relaxed);
+    _filled = false;
+    _readerHandle = nullptr;
+    _decoderHandle = nullptr;
+
+    // Core 0, the writer's priority for the card and one above for the decoder, which
+    // only waits on the voice: SD latency must never reach the audio core
+    _readerAlive.store(true, std::memory_order_release);
+    if (xTaskCreatePinnedToCore(readerTask, "media_rd", 4096, this, 3, &_readerHandle, 0) != pdPASS) {
+        _readerAlive.store(false, std::memory_order_release);
+        _readerHandle = nullptr;
+        fclose(_file);
+        _file = nullptr;
+        mclog::tagError(TAG, "failed to create reader task");
+        return false;
+    }
+    _decoderAlive.store(true, std::memory_order_release);
+    if (xTaskCreatePinnedToCore(decoderTask, "media_dec", 6144, this, 4, &_decoderHandle, 0) != pdPASS) {
+        _decoderAlive.store(false, std::memory_order_release);
+        _decoderHandle = nullptr;
+        _stopRequested.store(true, std::memory_order_release);  // The reader closes the file
+        xTaskNotifyGive(_readerHandle);
+        mclog::tagError(TAG, "failed to create decoder task");
+        return false;
+    }
+    mclog::tagInfo(TAG, "playing {} ({} the mics)", path, input == INPUT_REPLACE ? "replacing" : "mixed with");
+    return true;
+}
+
+void MediaPlayer::stop()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    stopLocked();
+}
+
+bool MediaPlayer::stopLocked()
+{
+    if (!isPlaying()) return true;
+    _stopRequested.store(true, std::memory_order_release);
+    if (_readerHandle) xTaskNotifyGive(_readerHandle);
+    if (_decoderHandle) xTaskNotifyGive(_decoderHandle);
+    // Both tasks check in at least every POLL_MS / VOICE_TIMEOUT_MS, the reader after its current fread
+    for (int i = 0; i < 100 && isPlaying(); i++) vTaskDelay(pdMS_TO_TICKS(10));
+    if (isPlaying()) {
+        mclog::tagWarn(TAG, "player did not stop in time");
+        return false;
+    }
+    return true;
+}
+
+MediaPlayerStats MediaPlayer::getStats()
+{
+    MediaPlayerStats s;
+    s.playing = isPlaying();
+    s.positionMs = static_cast<uint32_t>(_playedUs.load(std::memory_order_relaxed) / 1000);
+    s.sampleRate = _sampleRate.load(std::memory_order_relaxed);
+    s.channels = _channels.load(std::memory_order_relaxed);
+    s.starvations = _starvations.load(std::memory_order_relaxed);
+    s.readErrors = _readErrors.load(std::memory_order_relaxed);
+    s.worstReadUs = _worstReadUs.load(std::memory_order_relaxed);
+    s.lowFillPct = _lowFillPct.load(std::memory_order_relaxed);
+    return s;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Reader task
+// ─────────────────────────────────────────────────────────────────────────────
+
+void MediaPlayer::readerTask(void* param)
+{
+    auto* self = static_cast<MediaPlayer*>(param);
+    self->readerLoop();
+    self->_readerAlive.store(false, std::memory_order_release);
+    vTaskDelete(nullptr);
+}
+
+void MediaPlayer::readerLoop()
+{
+    auto* staging = static_cast<uint8_t*>(heap_caps_aligned_alloc(64, READ_CHUNK,
+        MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA | MALLOC_CAP_8BIT));
+    if (!staging) mclog::tagError(TAG, "no internal RAM for the read buffer");
+
+    while (staging && _dataLeft > 0 && !_stopRequested.load(std::memory_order_acquire)) {
+        const uint32_t head = _head.load(std::memory_order_relaxed);
+        const uint32_t fill = head - _tail.load(std::memory_order_acquire);
+        if (PREFETCH_BYTES - fill < READ_CHUNK) {
+            _filled = true;
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(POLL_MS));
+            continue;
+        }
+        if (_filled) {
+            const uint32_t pct = static_cast<uint32_t>(static_cast<uint64_t>(fill) * 100 / PREFETCH_BYTES);
+            if (pct < _lowFillPct.load(std::memory_order_relaxed)) _lowFillPct.store(pct, std::memory_order_relaxed);
+        }
+
+        const uint32_t want = std::min(READ_CHUNK, _dataLeft);
+        const int64_t start = esp_timer_get_time();
+        const size_t n = fread(staging, 1, want, _file);
+        const uint32_t us = static_cast<uint32_t>(esp_timer_get_time() - start);
+        if (us > _worstReadUs.load(std::memory_order_relaxed)) _worstReadUs.store(us, std::memory_order_relaxed);
+
+        const uint32_t pos = head & (PREFETCH_BYTES - 1);
+        const uint32_t first = std::min<uint32_t>(n, PREFETCH_BYTES - pos);
+        memcpy(_ring + pos, staging, first);
+        memcpy(_ring, staging + first, n - first);
+        _head.store(head + n, std::memory_order_release);
+        _dataLeft -= n;
+        if (_decoderHandle) xTaskNotifyGive(_decoderHandle);
+        if (n != want) {
+            // Short of the size the header promised: a card error, or a file cut short
+            if (ferror(_file)) {
+                _readErrors.fetch_add(1, std::memory_order_relaxed);
+                mclog::tagError(TAG, "SD read failed, {} bytes short", _dataLeft);
+            }
+            break;
+        }
+    }
+
+    heap_caps_free(staging);
+    fclose(_file);
+    _file = nullptr;
+    _readerDone.store(true, std::memory_order_release);
+    if (_decoderHandle) xTaskNotifyGive(_decoderHandle);
+    // The decoder notifies this task until it is done; stay until then
+    while (!_stopRequested.load(std::memory_order_acquire)) ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(POLL_MS));
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Decoder task
+// ─────────────────────────────────────────────────────────────────────────────
+
+void MediaPlayer::decoderTask(void* param)
+{
+    auto* self = static_cast<MediaPlayer*>(param);
+    self->decoderLoop();
+    self->_decoderAlive.store(false, std::memory_order_release);
+    vTaskDelete(nullptr);
+}
+
+// Up to `max` bytes from the ring, a whole number of `multiple`s
+size_t MediaPlayer::pull(uint8_t* dst, size_t max, size_t multiple)
+{
+    const uint32_t tail = _tail.load(std::memory_order_relaxed);
+    const uint32_t avail = _head.load(std::memory_order_acquire) - tail;
+    size_t n = std::min<size_t>(avail, max);
+    n -= n % multiple;
+    if (n == 0) return 0;
+    const uint32_t pos = tail & (PREFETCH_BYTES - 1);
+    const size_t first = std::min<size_t>(n, PREFETCH_BYTES - pos);
+    memcpy(dst, _ring + pos, first);
+    memcpy(dst + first, _ring, n - first);
+    _tail.store(tail + n, std::memory_order_release);
+    if (_readerHandle) xTaskNotifyGive(_readerHandle);
+    return n;
+}
+
+// Ring empty: false once the reader is done (the file has ended), otherwise waits for more
+bool MediaPlayer::waitForData()
+{
+    if (_readerDone.load(std::memory_order_acquire)) {
+        return _head.load(std::memory_order_acquire) != _tail.load(std::memory_order_relaxed);
+    }
+    if (_stopRequested.load(std::memory_order_acquire)) return false;
+    // Not before the first chunk has landed: that wait is the start, not a stall
+    if (_head.load(std::memory_order_relaxed) != 0) _starvations.fetch_add(1, std::memory_order_relaxed);
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(POLL_MS));
+    return true;
+}
+
+// Queues frames on the voice (opened at the first frame, reformatted when the format changes)
+bool MediaPlayer::emit(const int16_t* pcm, size_t frames, uint32_t rate, int channels)
+{
+    AudioEngine& engine = AudioEngine::getInstance();
+    AudioMixer& mixer = engine.mixer();
+    if (_voice < 0) {
+        _voice = mixer.openVoice(rate, channels, _gain, _duckDb, AudioMixer::BUS_FITTED);
+        if (_voice < 0) {
+            mclog::tagError(TAG, "no free mixer voice");
+            return false;
+        }
+    } else if (rate != _voiceRate || channels != _voiceChannels) {
+        if (!mixer.setVoiceFormat(_voice, rate, channels)) return false;
+    }
+    if (rate != _voiceRate || channels != _voiceChannels) {
+        _voiceRate = rate;
+        _voiceChannels = channels;
+        _sampleRate.store(rate, std::memory_order_relaxed);
+        _channels.store(static_cast<uint8_t>(channels), std::memory_order_relaxed);
+    }
+
+    while (frames > 0) {
+        if (_stopRequested.load(std::memory_order_acquire)) return false;
+        const size_t n = mixer.write(_voice, pcm, frames, VOICE_TIMEOUT_MS);
+        if (n == 0 && !engine.isRunning()) {
+            mclog::tagWarn(TAG, "audio engine stopped, playback ends");
+            return false;
+        }
+        pcm += n * channels;
+        frames -= n;
+        _playedUs.fetch_add(static_cast<uint64_t>(n) * 1000000 / rate, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+void MediaPlayer::decodeMp3(uint8_t* window, int16_t* pcm)
+{
+    Mp3Decoder decoder;
+    if (!decoder.openStream()) {
+        mclog::tagError(TAG, "mp3 decoder init failed");
+        return;
+    }
+    size_t have = 0;  // Bytes of the window handed to the decoder
+    while (!_stopRequested.load(std::memory_order_acquire)) {
+        // Keep two frames ahead so a frame never straddles the window's end unseen
+        if (decoder.remaining() < 2 * Mp3Decoder::MAX_FRAME_BYTES) {
+            const size_t left = decoder.remaining();
+            memmove(window, window + have - left, left);
+            have = left + pull(window + left, WINDOW_BYTES - left, 1);
+            decoder.setInput(window, have);
+        }
+        const int n = decoder.decodeFrame(pcm);
+        if (n <= 0) {
+            if (_head.load(std::memory_order_acquire) == _tail.load(std::memory_order_relaxed) && !waitForData()) {
+                break;
+            }
+            continue;
+        }
+        if (!emit(pcm, n / decoder.channels(), decoder.sampleRate(), decoder.channels())) break;
+    }
+}
+
+void MediaPlayer::decodeWav(uint8_t* window, int16_t* pcm)
+{
+    const size_t frameBytes = _wavChannels * _wavBits / 8;
+    while (!_stopRequested.load(std::memory_order_acquire)) {
+        const size_t got = pull(window, std::min<size_t>(WINDOW_BYTES, WAV_FRAMES * frameBytes), frameBytes);
+        if (got == 0) {
+            if (!waitForData()) break;
+            // A partial last frame never completes; it isn't played
+            if (_readerDone.load(std::memory_order_acquire)) break;
+            continue;
+        }
+        const size_t samples = got / (_wavBits / 8);
+        if (_wavBits == 16) {
+            memcpy(pcm, window, got);
+        } else {
+            // 24-bit: the top two bytes of each little-endian sample
+            for (size_t i = 0; i < samples; i++) {
+                pcm[i] = static_cast<int16_t>(window[3 * i + 1] | window[3 * i + 2] << 8);
+            }
+        }
+        if (!emit(pcm, samples / _wavChannels, _wavRate, _wavChannels)) break;
+    }
+}
+
+void MediaPlayer::decoderLoop()
+{
+    static_assert(WAV_FRAMES * 2 <= Mp3Decoder::MAX_FRAME_SAMPLES, "WAV chunk must fit the pcm buffer");
+    auto* window = static_cast<uint8_t*>(heap_caps_malloc(WINDOW_BYTES, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+    auto* pcm = static_cast<int16_t*>(
+        heap_caps_malloc(Mp3Decoder::MAX_FRAME_SAMPLES * sizeof(int16_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+    _voice = -1;
+    _voiceRate = 0;
+    _voiceChannels = 0;
+
+    if (!window || !pcm) {
+        mclog::tagError(TAG, "no internal RAM for the decoder");
+    } else if (_format == FORMAT_MP3) {
+        decodeMp3(window, pcm);
+    } else {
+        decodeWav(window, pcm);
+    }
+
+    const bool stopped = _stopRequested.load(std::memory_order_acquire);
+    if (_voice >= 0) AudioEngine::getInstance().mixer().closeVoice(_voice, stopped);  // Natural end: let it play out
+    _voice = -1;
+    heap_caps_free(window);
+    heap_caps_free(pcm);
+    // The reader may still be going if decoding failed; it notifies this task until it exits
+    _stopRequested.store(true, std::memory_order_release);
+    if (_readerHandle) xTaskNotifyGive(_readerHandle);
+    while (_readerAlive.load(std::memory_order_acquire)) vTaskDelay(pdMS_TO_TICKS(10));
+    mclog::tagInfo(TAG, "playback {} after {} ms, {} starvations", stopped ? "stopped" : "ended",
+        _playedUs.load(std::memory_order_relaxed) / 1000, _starvations.load(std::memory_order_relaxed));
+}
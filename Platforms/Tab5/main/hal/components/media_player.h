@@ -0,0 +1,129 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include "sd_storage.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+struct MediaPlayerStats {
+    bool playing = false;
+    uint32_t positionMs = 0;      // Audio handed to the engine so far
+    uint32_t sampleRate = 0;      // Source format (0 until the first frame)
+    uint8_t channels = 0;
+    uint32_t starvations = 0;     // Decoder found the prefetch ring empty before the end of the file
+    uint32_t readErrors = 0;      // Failed freads; playback ends at the first
+    uint32_t worstReadUs = 0;     // Slowest single READ_CHUNK read
+    uint32_t lowFillPct = 100;    // Lowest prefetch fill seen once it had filled up
+};
+
+/**
+ * @brief SD music player feeding the engine's fitted bus
+ *
+ * MP3 and 16/24-bit PCM WAV files from the card play through the user's
+ * hearing profile: the decoded PCM goes into an AudioMixer voice on
+ * BUS_FITTED, which joins the chain ahead of WDRC / MBC, either mixed with
+ * the mics or in their place (the program on that bus ducked all the way).
+ *
+ * A reader task on Core 0 keeps a PREFETCH_BYTES ring in PSRAM topped up in
+ * READ_CHUNK sequential freads, through a 64-byte-aligned internal buffer the
+ * SDMMC DMA writes directly. A decoder task, also on Core 0, drains it into
+ * the voice ring, blocking on the voice rather than the card, so an SD stall
+ * only lowers the prefetch fill; the audio task only ever sees the voice.
+ *
+ * Needs the engine running. One file at a time; play() replaces the current one.
+ */
+class MediaPlayer {
+public:
+    enum Input : uint8_t {
+        INPUT_MIX = 0,  // Mics stay on, ducked MIX_DUCK_DB under the media
+        INPUT_REPLACE,  // Media in place of the mics
+    };
+
+    static constexpr const char* MEDIA_DIR = "/sd/Music";
+
+    static MediaPlayer& getInstance();
+
+    // Absolute path under /sd; the format goes by the extension (.mp3, .wav)
+    bool play(const std::string& path, Input input = INPUT_MIX, float gain = 1.0f);
+    // Drops what is queued and ends playback
+    void stop();
+    bool isPlaying() const
+    {
+        return _decoderAlive.load(std::memory_order_acquire) || _readerAlive.load(std::memory_order_acquire);
+    }
+    MediaPlayerStats getStats();
+
+private:
+    MediaPlayer() = default;
+    MediaPlayer(const MediaPlayer&) = delete;
+    MediaPlayer& operator=(const MediaPlayer&) = delete;
+
+    enum Format : uint8_t { FORMAT_NONE, FORMAT_MP3, FORMAT_WAV };
+
+    static constexpr uint32_t PREFETCH_BYTES = 1024 * 1024;  // ~65s of 128kbps MP3, ~5.4s of 48kHz stereo WAV
+    static constexpr uint32_t READ_CHUNK = SdStorage::IO_CHUNK;
+    static constexpr uint32_t WINDOW_BYTES = 16 * 1024;      // Decoder's linear view of the ring
+    static constexpr uint32_t WAV_FRAMES = 1024;             // Frames converted per voice write
+    static constexpr int POLL_MS = 50;
+    static constexpr uint32_t VOICE_TIMEOUT_MS = 100;
+    static constexpr float MIX_DUCK_DB = 6.0f;
+    static constexpr float REPLACE_DUCK_DB = 60.0f;
+
+    static Format formatOf(const std::string& path);
+    bool stopLocked();
+    bool openMp3(FILE* f);
+    bool openWav(FILE* f);
+
+    static void readerTask(void* param);
+    void readerLoop();
+    static void decoderTask(void* param);
+    void decoderLoop();
+    void decodeMp3(uint8_t* window, int16_t* pcm);
+    void decodeWav(uint8_t* window, int16_t* pcm);
+    size_t pull(uint8_t* dst, size_t max, size_t multiple);
+    bool emit(const int16_t* pcm, size_t frames, uint32_t rate, int channels);
+    bool waitForData();
+
+    std::mutex _mutex;  // play/stop
+    FILE* _file = nullptr;           // Reader-owned while playing
+    uint8_t* _ring = nullptr;        // PREFETCH_BYTES in PSRAM, kept once allocated
+    std::atomic<uint32_t> _head{0};  // Reader
+    std::atomic<uint32_t> _tail{0};  // Decoder
+    std::atomic<bool> _readerDone{false};  // File fully in the ring, or the read failed
+    std::atomic<bool> _stopRequested{false};
+    std::atomic<bool> _readerAlive{false};
+    std::atomic<bool> _decoderAlive{false};
+    TaskHandle_t _readerHandle = nullptr;
+    TaskHandle_t _decoderHandle = nullptr;
+
+    // Set by play() before the tasks start
+    Format _format = FORMAT_NONE;
+    uint32_t _dataLeft = 0;      // Bytes the reader may still read (WAV: to the end of the data chunk)
+    uint32_t _wavRate = 0;
+    int _wavChannels = 0;
+    int _wavBits = 0;
+    float _gain = 1.0f;
+    float _duckDb = MIX_DUCK_DB;
+
+    // Decoder-only
+    int _voice = -1;
+    uint32_t _voiceRate = 0;
+    int _voiceChannels = 0;
+
+    std::atomic<uint64_t> _playedUs{0};
+    std::atomic<uint32_t> _sampleRate{0};
+    std::atomic<uint8_t> _channels{0};
+    std::atomic<uint32_t> _starvations{0};
+    std::atomic<uint32_t> _readErrors{0};
+    std::atomic<uint32_t> _worstReadUs{0};
+    std::atomic<uint32_t> _lowFillPct{100};
+    bool _filled = false;  // Reader-only: the ring has been full once, fill tracking is on
+};
@@ -0,0 +1,263 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "modbus_slave.h"
+#include "profile_schema.h"
+#include <mooncake_log.h>
+#include <algorithm>
+#include <cmath>
+
+static const char* TAG = "Modbus";
+
+static constexpr uint8_t FN_READ_HOLDING = 0x03;
+static constexpr uint8_t FN_READ_INPUT = 0x04;
+static constexpr uint8_t FN_WRITE_SINGLE = 0x06;
+static constexpr uint8_t FN_WRITE_MULTIPLE = 0x10;
+
+static constexpr int EX_ILLEGAL_FUNCTION = 1;
+static constexpr int EX_ILLEGAL_ADDRESS = 2;
+static constexpr int EX_ILLEGAL_VALUE = 3;
+
+static constexpr uint16_t MAX_READ = 125;   // Registers per read request
+static constexpr uint16_t MAX_WRITE = 123;  // Registers per write-multiple request
+static constexpr float LEVEL_FLOOR = 1e-5f;  // -100 dBFS
+
+ModbusSlave& ModbusSlave::getInstance()
+{
+    static ModbusSlave instance;
+    return instance;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Framing
+// ─────────────────────────────────────────────────────────────────────────────
+
+static uint16_t be16(const uint8_t* p)
+{
+    return static_cast<uint16_t>(p[0] << 8 | p[1]);
+}
+
+static void putBe16(uint8_t* p, uint16_t v)
+{
+    p[0] = v >> 8;
+    p[1] = v & 0xFF;
+}
+
+static uint16_t centiDb(float db)
+{
+    return static_cast<uint16_t>(static_cast<int16_t>(std::clamp(lrintf(db * 100.0f), -32768L, 32767L)));
+}
+
+uint16_t ModbusSlave::crc16(const uint8_t* data, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+    return crc;
+}
+
+void ModbusSlave::begin(uint8_t address)
+{
+    _address = address;
+    AudioEngine::getInstance().setLevelTapEnabled(AudioEngine::LEVEL_TAP_RS485, true);
+    mclog::tagInfo(TAG, "RTU slave at address {}, {} holding registers", address, 2 * ProfileSchema::fieldCount());
+}
+
+ModbusStats ModbusSlave::getStats() const
+{
+    ModbusStats s;
+    s.frames = _frames.load(std::memory_order_relaxed);
+    s.crcErrors = _crcErrors.load(std::memory_order_relaxed);
+    s.exceptions = _exceptions.load(std::memory_order_relaxed);
+    s.writes = _writes.load(std::memory_order_relaxed);
+    return s;
+}
+
+size_t ModbusSlave::handle(const uint8_t* frame, size_t len, uint8_t* response)
+{
+    if (len < 4 || len > MAX_FRAME) return 0;  // Line noise, or two frames run together
+    if (crc16(frame, len - 2) != static_cast<uint16_t>(frame[len - 1] << 8 | frame[len - 2])) {
+        _crcErrors.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+    const uint8_t unit = frame[0];
+    if (unit != _address && unit != BROADCAST) return 0;
+    _frames.fetch_add(1, std::memory_order_relaxed);
+
+    const uint8_t fn = frame[1];
+    const uint8_t* pdu = frame + 2;
+    const size_t pduLen = len - 4;
+    response[0] = _address;
+    response[1] = fn;
+
+    int result = -EX_ILLEGAL_FUNCTION;
+    switch (fn) {
+        case FN_READ_HOLDING:
+        case FN_READ_INPUT: {
+            if (pduLen != 4) return 0;
+            const uint16_t count = be16(pdu + 2);
+            if (count < 1 || count > MAX_READ) {
+                result = -EX_ILLEGAL_VALUE;
+                break;
+            }
+            result = fn == FN_READ_HOLDING ? readHolding(be16(pdu), count, response + 3)
+                                           : readInput(be16(pdu), count, response + 3);
+            if (result >= 0) {
+                response[2] = static_cast<uint8_t>(2 * count);
+                result = 1 + 2 * count;
+            }
+            break;
+        }
+        case FN_WRITE_SINGLE:
+            if (pduLen != 4) return 0;
+            result = writeRegisters(be16(pdu), 1, pdu + 2);
+            if (result >= 0) {
+                std::copy(pdu, pdu + 4, response + 2);  // Echo of the request
+                result = 4;
+            }
+            break;
+        case FN_WRITE_MULTIPLE: {
+            if (pduLen < 5) return 0;
+            const uint16_t count = be16(pdu + 2);
+            if (count < 1 || count > MAX_WRITE || pdu[4] != 2 * count || pduLen != 5u + pdu[4]) {
+                result = -EX_ILLEGAL_VALUE;
+                break;
+            }
+            result = writeRegisters(be16(pdu), count, pdu + 5);
+            if (result >= 0) {
+                std::copy(pdu, pdu + 4, response + 2);  // Start and count
+                result = 4;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    if (unit == BROADCAST) return 0;
+
+    size_t n;
+    if (result < 0) {
+        response[1] = fn | 0x80;
+        response[2] = static_cast<uint8_t>(-result);
+        n = 3;
+        _exceptions.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        n = 2 + result;
+    }
+    const uint16_t crc = crc16(response, n);
+    response[n++] = crc & 0xFF;
+    response[n++] = crc >> 8;
+    return n;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Registers
+// ─────────────────────────────────────────────────────────────────────────────
+
+int ModbusSlave::readHolding(uint16_t start, uint16_t count, uint8_t* out)
+{
+    const int regs = 2 * ProfileSchema::fieldCount();
+    if (start + count > regs) return -EX_ILLEGAL_ADDRESS;
+
+    const AudioEngineParams params = AudioEngine::getInstance().getParams();
+    const ProfileSchema::Field* fields = ProfileSchema::fields();
+    for (int r = start; r < start + count; r++) {
+        const uint32_t word = ProfileSchema::raw(fields[r / 2], params);
+        putBe16(out, (r & 1) ? word & 0xFFFF : word >> 16);
+        out += 2;
+    }
+    return 0;
+}
+
+int ModbusSlave::writeRegisters(uint16_t start, uint16_t count, const uint8_t* values)
+{
+    const int regs = 2 * ProfileSchema::fieldCount();
+    if (start + count > regs) return -EX_ILLEGAL_ADDRESS;
+
+    AudioEngine& engine = AudioEngine::getInstance();
+    AudioEngineParams params = engine.getParams();
+    const ProfileSchema::Field* fields = ProfileSchema::fields();
+    const int end = start + count;
+    // Whole words per field, so a float is never clamped with only one half written
+    for (int f = start / 2; f <= (end - 1) / 2; f++) {
+        uint32_t word = ProfileSchema::raw(fields[f], params);
+        const int hi = 2 * f, lo = 2 * f + 1;
+        if (hi >= start) word = (word & 0x0000FFFF) | static_cast<uint32_t>(be16(values + 2 * (hi - start))) << 16;
+        if (lo < end) word = (word & 0xFFFF0000) | be16(values + 2 * (lo - start));
+        ProfileSchema::setRaw(fields[f], word, params);
+    }
+    engine.setParams(params);  // One params generation per request
+    _writes.fetch_add(1, std::memory_order_relaxed);
+    return 0;
+}
+
+int ModbusSlave::readInput(uint16_t start, uint16_t count, uint8_t* out)
+{
+    AudioEngine& engine = AudioEngine::getInstance();
+    engine.getTapLevels(AudioEngine::LEVEL_TAP_RS485, _levels);
+    if (start <= INPUT_LEVELS + LEVEL_FLAGS && start + count > INPUT_LEVELS + LEVEL_FLAGS) {
+        _muted = engine.getParams().outputMute;
+    }
+    for (int r = start; r < start + count; r++) {
+        uint16_t value = 0;
+        if (!inputRegister(r, value)) return -EX_ILLEGAL_ADDRESS;
+        putBe16(out, value);
+        out += 2;
+    }
+    return 0;
+}
+
+bool ModbusSlave::inputRegister(uint16_t reg, uint16_t& value)
+{
+    const int fieldCount = ProfileSchema::fieldCount();
+    if (reg >= INPUT_TAGS && reg < INPUT_TAGS + 2 * fieldCount) {
+        const int r = reg - INPUT_TAGS;
+        const uint32_t tag = ProfileSchema::fields()[r / 2].tag;
+        value = (r & 1) ? tag & 0xFFFF : tag >> 16;
+        return true;
+    }
+    switch (reg) {
+        case INPUT_LEVELS + LEVEL_RMS_L:
+            value = centiDb(20.0f * log10f(std::max(_levels.rmsLeft, LEVEL_FLOOR)));
+            return true;
+        case INPUT_LEVELS + LEVEL_RMS_R:
+            value = centiDb(20.0f * log10f(std::max(_levels.rmsRight, LEVEL_FLOOR)));
+            return true;
+        case INPUT_LEVELS + LEVEL_PEAK_L:
+            value = centiDb(20.0f * log10f(std::max(_levels.peakLeft, LEVEL_FLOOR)));
+            return true;
+        case INPUT_LEVELS + LEVEL_PEAK_R:
+            value = centiDb(20.0f * log10f(std::max(_levels.peakRight, LEVEL_FLOOR)));
+            return true;
+        case INPUT_LEVELS + LEVEL_NS_GAIN:
+            value = centiDb(_levels.nsGainDb);
+            return true;
+        case INPUT_LEVELS + LEVEL_AGC_GAIN:
+            value = centiDb(_levels.agcGainDb);
+            return true;
+        case INPUT_LEVELS + LEVEL_LIMITER_GR:
+            value = centiDb(_levels.limiterGainReductionDb);
+            return true;
+        case INPUT_LEVELS + LEVEL_FLAGS:
+            value = (_levels.vadSpeechDetected ? 1 : 0) | (_levels.sessionEnded ? 2 : 0) | (_muted ? 4 : 0);
+            return true;
+        case INPUT_LEVELS + LEVEL_BLOCK_HI:
+            value = _levels.blockIndex >> 16;
+            return true;
+        case INPUT_LEVELS + LEVEL_BLOCK_LO:
+            value = _levels.blockIndex & 0xFFFF;
+            return true;
+        case INPUT_INFO:
+            value = PROTOCOL_VERSION;
+            return true;
+        case INPUT_INFO + 1:
+            value = static_cast<uint16_t>(fieldCount);
+            return true;
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,98 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include "audio_engine.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+struct ModbusStats {
+    uint32_t frames = 0;      // Well-formed frames addressed to this unit (or broadcast)
+    uint32_t crcErrors = 0;   // Frames dropped on a bad CRC
+    uint32_t exceptions = 0;  // Exception responses sent
+    uint32_t writes = 0;      // Requests that changed engine params
+};
+
+/**
+ * @brief Modbus RTU slave mapping registers onto the engine, for fixed installations
+ *
+ * Holding registers are the ProfileSchema fields in table order, two per field:
+ * field i's raw 32-bit word (bools 0/1, ints as two's complement, floats as IEEE
+ * bits) at HOLDING_FIELDS + 2i, high word first. A write (0x06 / 0x10) lands in
+ * one setParams() per request, clamped like a profile load; writing one half of a
+ * field keeps the other half's current value.
+ *
+ * Input registers:
+ *  - INPUT_LEVELS: the latest level frame (LEVEL_* order): levels and gains as
+ *    int16 centi-dB, a flags word, the block index as two registers
+ *  - INPUT_INFO: protocol version, field count
+ *  - INPUT_TAGS + 2i: field i's tag (FNV-1a of its key), high word first, so a
+ *    master can check its map against this firmware's table
+ *
+ * Functions 0x03, 0x04, 0x06 and 0x10; others get exception 01. Address 0 is a
+ * broadcast: writes apply, nothing is answered. handle() works on caller buffers
+ * only, no allocation. Levels come from the engine's RS485 level tap, enabled
+ * while the slave runs.
+ */
+class ModbusSlave {
+public:
+    static constexpr size_t MAX_FRAME = 256;  // RTU ADU limit
+    static constexpr uint8_t BROADCAST = 0;
+    static constexpr uint16_t PROTOCOL_VERSION = 1;
+
+    static constexpr uint16_t HOLDING_FIELDS = 0x0000;
+    static constexpr uint16_t INPUT_LEVELS = 0x0000;
+    static constexpr uint16_t INPUT_INFO = 0x0100;
+    static constexpr uint16_t INPUT_TAGS = 0x1000;
+
+    enum Level : uint8_t {
+        LEVEL_RMS_L = 0,  // centi-dBFS
+        LEVEL_RMS_R,
+        LEVEL_PEAK_L,
+        LEVEL_PEAK_R,
+        LEVEL_NS_GAIN,    // centi-dB
+        LEVEL_AGC_GAIN,
+        LEVEL_LIMITER_GR,
+        LEVEL_FLAGS,      // Bit 0 speech, bit 1 session ended, bit 2 output muted
+        LEVEL_BLOCK_HI,
+        LEVEL_BLOCK_LO,
+        LEVEL_COUNT,
+    };
+
+    static ModbusSlave& getInstance();
+
+    void begin(uint8_t address);
+    uint8_t address() const
+    {
+        return _address;
+    }
+
+    // One complete RTU frame (silence-delimited) in; returns the response length
+    // written to `response` (MAX_FRAME bytes), 0 when nothing is to be sent
+    size_t handle(const uint8_t* frame, size_t len, uint8_t* response);
+    ModbusStats getStats() const;
+
+    static uint16_t crc16(const uint8_t* data, size_t len);
+
+private:
+    ModbusSlave() = default;
+    ModbusSlave(const ModbusSlave&) = delete;
+    ModbusSlave& operator=(const ModbusSlave&) = delete;
+
+    // 0, or a negated exception code
+    int readHolding(uint16_t start, uint16_t count, uint8_t* out);
+    int readInput(uint16_t start, uint16_t count, uint8_t* out);
+    int writeRegisters(uint16_t start, uint16_t count, const uint8_t* values);
+    bool inputRegister(uint16_t reg, uint16_t& value);
+
+    uint8_t _address = 1;
+    AudioLevels _levels;  // RS485 task: latest tap frame
+    bool _muted = false;  // RS485 task: outputMute at the last LEVEL_FLAGS read
+    std::atomic<uint32_t> _frames{0};
+    std::atomic<uint32_t> _crcErrors{0};
+    std::atomic<uint32_t> _exceptions{0};
+    std::atomic<uint32_t> _writes{0};
+};
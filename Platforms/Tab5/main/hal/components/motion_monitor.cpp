@@ -0,0 +1,157 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "motion_monitor.h"
+#include <mooncake_log.h>
+#include <algorithm>
+#include <cmath>
+
+static const char* TAG = "Motion";
+
+MotionMonitor& MotionMonitor::getInstance()
+{
+    static MotionMonitor instance;
+    return instance;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Control
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool MotionMonitor::setEnabled(bool enabled)
+{
+    ImuFifo& fifo = ImuFifo::getInstance();
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!enabled) {
+        if (!_enabled.load(std::memory_order_relaxed)) return true;
+        _enabled.store(false, std::memory_order_relaxed);
+        fifo.setListener(nullptr, nullptr);
+        AudioEngine::getInstance().setMotionState(AUDIO_MOTION_STILL, 0.0f);
+        _stats.enabled = false;
+        mclog::tagInfo(TAG, "motion-aware audio off");
+        return true;
+    }
+    if (_enabled.load(std::memory_order_relaxed)) return true;
+    if (!fifo.isRunning()) {
+        mclog::tagWarn(TAG, "IMU FIFO not running");
+        return false;
+    }
+    _resetRequested.store(true, std::memory_order_release);
+    _stats = {};
+    _stats.enabled = true;
+    _enabled.store(true, std::memory_order_release);
+    fifo.setListener(onDrain, this);
+    mclog::tagInfo(TAG, "motion-aware audio on");
+    return true;
+}
+
+MotionMonitorStats MotionMonitor::getStats()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Drain task
+// ─────────────────────────────────────────────────────────────────────────────
+
+void MotionMonitor::onDrain(void* ctx)
+{
+    static_cast<MotionMonitor*>(ctx)->update();
+}
+
+void MotionMonitor::update()
+{
+    if (_resetRequested.exchange(false, std::memory_order_acq_rel)) {
+        // Start from the newest sample, its gravity and a centred beam
+        _seq = 0;
+        _lastUs = 0;
+        _rate = _yawRate = _gaitSquare = _comp = _quietS = 0.0f;
+        _magMean = 0.0f;
+        _state = AUDIO_MOTION_STILL;
+        _turns = _walks = 0;
+        ImuSample s;
+        if (ImuFifo::getInstance().latest(s)) {
+            _seq = ImuFifo::getInstance().getStats().samples;
+            // HAL axes back to the sensor frame (see below)
+            _gravity[0] = -s.accelY;
+            _gravity[1] = s.accelX;
+            _gravity[2] = -s.accelZ;
+            _magMean = sqrtf(_gravity[0] * _gravity[0] + _gravity[1] * _gravity[1] + _gravity[2] * _gravity[2]);
+        }
+    }
+
+    size_t n;
+    do {
+        n = ImuFifo::getInstance().read(_batch, ImuFifo::WATERMARK_FRAMES, _seq);
+        for (size_t i = 0; i < n; i++) process(_batch[i]);
+    } while (n == ImuFifo::WATERMARK_FRAMES);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_enabled.load(std::memory_order_relaxed)) return;  // Disabled during this drain
+    AudioEngine::getInstance().setMotionState(_state, _comp);
+    _stats.state = _state;
+    _stats.rateDps = _rate;
+    _stats.yawRateDps = _yawRate;
+    _stats.gaitRms = sqrtf(_gaitSquare);
+    _stats.yawCompDeg = _comp;
+    _stats.turns = _turns;
+    _stats.walks = _walks;
+}
+
+void MotionMonitor::process(const ImuSample& s)
+{
+    const float dt = _lastUs ? std::clamp((s.timeUs - _lastUs) * 1e-6f, 0.0f, 0.1f)
+                             : 1.0f / ImuFifo::ODR_HZ;
+    _lastUs = s.timeUs;
+
+    // ImuFifo::convert() maps accel and gyro to HAL axes differently; undo both
+    // so gravity and rotation share the sensor's right-handed frame
+    const float a[3] = {-s.accelY, s.accelX, -s.accelZ};
+    const float w[3] = {s.gyroY, s.gyroX, -s.gyroZ};
+
+    const float kGravity = dt / (GRAVITY_TAU_S + dt);
+    for (int k = 0; k < 3; k++) _gravity[k] += kGravity * (a[k] - _gravity[k]);
+    const float g = sqrtf(_gravity[0] * _gravity[0] + _gravity[1] * _gravity[1] + _gravity[2] * _gravity[2]);
+
+    // A resting accelerometer reads +g along up, so the gravity vector is the up axis
+    _yawRate = g > 1.0f ? (w[0] * _gravity[0] + w[1] * _gravity[1] + w[2] * _gravity[2]) / g : 0.0f;
+    const float rate = sqrtf(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+    _rate += dt / (RATE_TAU_S + dt) * (rate - _rate);
+
+    const float mag = sqrtf(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+    _magMean += kGravity * (mag - _magMean);
+    const float bounce = mag - _magMean;
+    _gaitSquare += dt / (GAIT_TAU_S + dt) * (bounce * bounce - _gaitSquare);
+    const float gait = sqrtf(_gaitSquare);
+
+    // Turning outranks walking: the echo path moves fastest then
+    if (_rate > TURN_ENTER_DPS) {
+        if (_state != AUDIO_MOTION_TURNING) _turns++;
+        _state = AUDIO_MOTION_TURNING;
+        _quietS = 0.0f;
+    } else if (_state == AUDIO_MOTION_TURNING) {
+        _quietS = _rate < TURN_EXIT_DPS ? _quietS + dt : 0.0f;
+        if (_quietS * 1000.0f >= TURN_HOLD_MS) {
+            _state = AUDIO_MOTION_STILL;
+            _quietS = 0.0f;
+        }
+    } else if (gait > WALK_ENTER_MS2) {
+        if (_state != AUDIO_MOTION_WALKING) _walks++;
+        _state = AUDIO_MOTION_WALKING;
+        _quietS = 0.0f;
+    } else if (_state == AUDIO_MOTION_WALKING) {
+        _quietS = gait < WALK_EXIT_MS2 ? _quietS + dt : 0.0f;
+        if (_quietS * 1000.0f >= WALK_HOLD_MS) {
+            _state = AUDIO_MOTION_STILL;
+            _quietS = 0.0f;
+        }
+    }
+
+    // Turning left (+ about up) moves a talker who was ahead toward MIC-R, a negative bearing
+    if (std::fabs(_yawRate) > YAW_DEADBAND_DPS) _comp -= _yawRate * dt;
+    if (_state == AUDIO_MOTION_STILL) _comp -= _comp * dt / RECENTER_S;
+    _comp = std::clamp(_comp, -MAX_COMP_DEG, MAX_COMP_DEG);
+}
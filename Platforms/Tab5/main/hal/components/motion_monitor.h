@@ -0,0 +1,102 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include "audio_engine.h"
+#include "imu_fifo.h"
+
+struct MotionMonitorStats {
+    bool enabled = false;
+    AudioMotion state = AUDIO_MOTION_STILL;
+    float rateDps = 0.0f;      // Smoothed angular rate magnitude
+    float yawRateDps = 0.0f;   // About gravity, + = counter-clockwise seen from above
+    float gaitRms = 0.0f;      // m/s^2, high-passed acceleration magnitude
+    float yawCompDeg = 0.0f;   // Added to the beam steering, + = toward MIC-L
+    uint32_t turns = 0;        // Entries into TURNING since enabled
+    uint32_t walks = 0;        // Entries into WALKING since enabled
+};
+
+/**
+ * @brief Head motion state for the audio engine from the batched IMU stream
+ *
+ * Runs on the ImuFifo drain task, once per drain (WATERMARK_FRAMES samples),
+ * so it costs no bus traffic and no task of its own. Gravity is the low-passed
+ * accelerometer; the yaw rate is the gyro projected on it, which holds however
+ * the device is worn or held.
+ *
+ *  - TURNING: the smoothed rate magnitude above TURN_ENTER_DPS; left once it
+ *    stays under TURN_EXIT_DPS for TURN_HOLD_MS.
+ *  - WALKING: the RMS of the high-passed acceleration magnitude (gait bounce)
+ *    above WALK_ENTER_MS2; left once it stays under WALK_EXIT_MS2 for
+ *    WALK_HOLD_MS.
+ *  - STILL otherwise.
+ *
+ * The yaw rate is also integrated into a bearing offset with the opposite
+ * sign (turning left moves a talker ahead toward the right mic), decaying
+ * back to zero over RECENTER_S while still: the wearer turning to face the
+ * talker ends with the beam ahead again. Both go to
+ * AudioEngine::setMotionState() after each drain.
+ *
+ * The sign assumes MIC-L on the wearer's left with the device upright; off by
+ * default, since Tab5 is usually held or on a desk rather than worn.
+ */
+class MotionMonitor {
+public:
+    static constexpr float TURN_ENTER_DPS = 60.0f;
+    static constexpr float TURN_EXIT_DPS = 25.0f;
+    static constexpr uint32_t TURN_HOLD_MS = 200;
+    static constexpr float WALK_ENTER_MS2 = 0.8f;
+    static constexpr float WALK_EXIT_MS2 = 0.4f;
+    static constexpr uint32_t WALK_HOLD_MS = 1000;
+    static constexpr float RATE_TAU_S = 0.05f;     // Rate magnitude smoothing
+    static constexpr float GRAVITY_TAU_S = 0.5f;   // Gravity and the gait high-pass
+    static constexpr float GAIT_TAU_S = 1.0f;      // Gait mean square
+    static constexpr float YAW_DEADBAND_DPS = 3.0f;  // Gyro offset and tremor, not integrated
+    static constexpr float RECENTER_S = 3.0f;
+    static constexpr float MAX_COMP_DEG = 90.0f;
+
+    static MotionMonitor& getInstance();
+
+    // Needs the IMU FIFO running; false otherwise
+    bool setEnabled(bool enabled);
+    bool isEnabled() const
+    {
+        return _enabled.load(std::memory_order_relaxed);
+    }
+    MotionMonitorStats getStats();
+
+private:
+    MotionMonitor() = default;
+    MotionMonitor(const MotionMonitor&) = delete;
+    MotionMonitor& operator=(const MotionMonitor&) = delete;
+
+    static void onDrain(void* ctx);
+    void update();
+    void process(const ImuSample& s);
+
+    std::mutex _mutex;  // setEnabled, _stats, publishing
+    std::atomic<bool> _enabled{false};
+    std::atomic<bool> _resetRequested{false};
+
+    // Drain task only
+    ImuSample _batch[ImuFifo::WATERMARK_FRAMES];
+    uint32_t _seq = 0;
+    int64_t _lastUs = 0;
+    float _gravity[3] = {};
+    float _rate = 0.0f;
+    float _yawRate = 0.0f;
+    float _magMean = 0.0f;
+    float _gaitSquare = 0.0f;
+    float _comp = 0.0f;
+    AudioMotion _state = AUDIO_MOTION_STILL;
+    float _quietS = 0.0f;  // Time under the current state's exit threshold
+    uint32_t _turns = 0;
+    uint32_t _walks = 0;
+
+    MotionMonitorStats _stats;
+};
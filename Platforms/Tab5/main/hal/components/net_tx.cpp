@@ -0,0 +1,204 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "net_tx.h"
+#include <mooncake_log.h>
+#include <esp_timer.h>
+#include <sdkconfig.h>
+#include <lwip/ip_addr.h>
+#include <lwip/pbuf.h>
+#include <lwip/udp.h>
+#include <lwip/priv/tcpip_priv.h>
+
+static const char* TAG = "NetTx";
+
+// SDIO link to the C6, from the ESP-Hosted config when it says
+#ifdef CONFIG_ESP_HOSTED_SDIO_CLOCK_FREQ_KHZ
+static constexpr uint32_t SDIO_CLOCK_KHZ = CONFIG_ESP_HOSTED_SDIO_CLOCK_FREQ_KHZ;
+#else
+static constexpr uint32_t SDIO_CLOCK_KHZ = 40000;
+#endif
+#ifdef CONFIG_ESP_HOSTED_SDIO_BUS_WIDTH
+static constexpr uint32_t SDIO_BUS_WIDTH = CONFIG_ESP_HOSTED_SDIO_BUS_WIDTH;
+#else
+static constexpr uint32_t SDIO_BUS_WIDTH = 4;
+#endif
+// Per datagram on the link: UDP + IPv4 + Ethernet headers and the ESP-Hosted frame header
+static constexpr uint32_t LINK_OVERHEAD_BYTES = 8 + 20 + 14 + 12;
+
+// ─────────────────────────────────────────────────────────────────────────────
+// tcpip thread calls
+// ─────────────────────────────────────────────────────────────────────────────
+
+namespace {
+
+struct FlowCall {
+    tcpip_api_call_data call;  // First: tcpip_api_call() hands this back
+    udp_pcb* pcb = nullptr;
+    ip_addr_t addr;
+    uint16_t port = 0;
+    uint8_t tos = 0;
+    pbuf** batch = nullptr;
+    int count = 0;
+    int sent = 0;
+    uint32_t bytes = 0;
+};
+
+err_t openOnTcpip(tcpip_api_call_data* call)
+{
+    auto* c = reinterpret_cast<FlowCall*>(call);
+    c->pcb = udp_new_ip_type(IPADDR_TYPE_V4);
+    if (!c->pcb) return ERR_MEM;
+    const err_t err = udp_connect(c->pcb, &c->addr, c->port);
+    if (err != ERR_OK) {
+        udp_remove(c->pcb);
+        c->pcb = nullptr;
+        return err;
+    }
+    c->pcb->tos = c->tos;
+    return ERR_OK;
+}
+
+err_t closeOnTcpip(tcpip_api_call_data* call)
+{
+    udp_remove(reinterpret_cast<FlowCall*>(call)->pcb);
+    return ERR_OK;
+}
+
+err_t sendOnTcpip(tcpip_api_call_data* call)
+{
+    auto* c = reinterpret_cast<FlowCall*>(call);
+    for (int i = 0; i < c->count; i++) {
+        pbuf* p = c->batch[i];
+        const uint16_t len = p->tot_len;
+        if (udp_send(c->pcb, p) == ERR_OK) {
+            c->sent++;
+            c->bytes += len;
+        }
+        pbuf_free(p);
+        c->batch[i] = nullptr;
+    }
+    return ERR_OK;
+}
+
+}  // namespace
+
+// ─────────────────────────────────────────────────────────────────────────────
+// UdpFlow
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool UdpFlow::open(const char* host, uint16_t port, uint8_t tos)
+{
+    close();
+    FlowCall c;
+    if (!host || !ipaddr_aton(host, &c.addr)) {
+        mclog::tagError(TAG, "bad destination '{}'", host ? host : "");
+        return false;
+    }
+    c.port = port;
+    c.tos = tos;
+    if (tcpip_api_call(openOnTcpip, &c.call) != ERR_OK || !c.pcb) {
+        mclog::tagError(TAG, "no UDP pcb to {}:{}", host, port);
+        return false;
+    }
+    _pcb = c.pcb;
+    return true;
+}
+
+void UdpFlow::close()
+{
+    if (_prepared) {
+        pbuf_free(_prepared);
+        _prepared = nullptr;
+    }
+    for (int i = 0; i < _count; i++) pbuf_free(_batch[i]);
+    _count = 0;
+    if (!_pcb) return;
+    FlowCall c;
+    c.pcb = _pcb;
+    tcpip_api_call(closeOnTcpip, &c.call);
+    _pcb = nullptr;
+}
+
+uint8_t* UdpFlow::prepare(size_t len)
+{
+    if (_prepared) {
+        pbuf_free(_prepared);
+        _prepared = nullptr;
+    }
+    if (!_pcb || _count == MAX_BATCH) return nullptr;
+    // PBUF_TRANSPORT leaves headroom for UDP, IP and link headers in the same buffer
+    _prepared = pbuf_alloc(PBUF_TRANSPORT, static_cast<uint16_t>(len), PBUF_RAM);
+    if (!_prepared) {
+        NetTx::getInstance().countAllocFail();
+        return nullptr;
+    }
+    return static_cast<uint8_t*>(_prepared->payload);
+}
+
+void UdpFlow::commit()
+{
+    if (!_prepared) return;
+    _batch[_count++] = _prepared;
+    _prepared = nullptr;
+}
+
+int UdpFlow::flush()
+{
+    if (_count == 0) return 0;
+    FlowCall c;
+    c.pcb = _pcb;
+    c.batch = _batch;
+    c.count = _count;
+    tcpip_api_call(sendOnTcpip, &c.call);
+    NetTx::getInstance().countSent(c.sent, c.bytes, _count - c.sent);
+    _count = 0;
+    return c.sent;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// NetTx
+// ─────────────────────────────────────────────────────────────────────────────
+
+NetTx& NetTx::getInstance()
+{
+    static NetTx instance;
+    return instance;
+}
+
+void NetTx::countSent(uint32_t packets, uint32_t bytes, uint32_t errors)
+{
+    _packets.fetch_add(packets, std::memory_order_relaxed);
+    _bytes.fetch_add(bytes, std::memory_order_relaxed);
+    _batches.fetch_add(1, std::memory_order_relaxed);
+    if (errors) _sendErrors.fetch_add(errors, std::memory_order_relaxed);
+}
+
+NetTxStats NetTx::getStats()
+{
+    NetTxStats s;
+    s.packets = _packets.load(std::memory_order_relaxed);
+    s.bytes = _bytes.load(std::memory_order_relaxed);
+    s.batches = _batches.load(std::memory_order_relaxed);
+    s.copies = s.packets;
+    s.allocFails = _allocFails.load(std::memory_order_relaxed);
+    s.sendErrors = _sendErrors.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    const int64_t now = esp_timer_get_time();
+    if (_lastUs != 0 && now > _lastUs) {
+        const float seconds = (now - _lastUs) * 1e-6f;
+        const uint32_t packets = s.packets - _lastPackets;
+        const uint32_t bytes = s.bytes - _lastBytes;
+        s.packetsPerSec = packets / seconds;
+        s.bytesPerSec = bytes / seconds;
+        const float linkBitsPerSec = static_cast<float>(SDIO_CLOCK_KHZ) * 1000.0f * SDIO_BUS_WIDTH;
+        s.sdioUtilization = (bytes + packets * LINK_OVERHEAD_BYTES) * 8.0f / seconds / linkBitsPerSec;
+    }
+    _lastUs = now;
+    _lastPackets = s.packets;
+    _lastBytes = s.bytes;
+    return s;
+}
@@ -0,0 +1,106 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+struct udp_pcb;
+struct pbuf;
+
+struct NetTxStats {
+    uint32_t packets = 0;        // Datagrams handed to the stack, all flows, since boot
+    uint32_t bytes = 0;          // Their payload bytes
+    uint32_t batches = 0;        // tcpip thread round trips that carried them
+    uint32_t copies = 0;         // Payload copies on our side of the stack (one per datagram: the fill itself)
+    uint32_t allocFails = 0;     // pbuf pool exhausted, datagram not built
+    uint32_t sendErrors = 0;     // udp_send() refusals (queue full on the way to the C6)
+    float packetsPerSec = 0.0f;  // Since the previous getStats()
+    float bytesPerSec = 0.0f;
+    float sdioUtilization = 0.0f;  // Estimated share of the SDIO link these datagrams occupy, 0..1
+};
+
+/**
+ * @brief Outgoing UDP flow on the raw lwIP API, built in place and sent in batches
+ *
+ * The socket path runs one message through the tcpip thread per send() and
+ * stages the payload in a caller buffer first. A flow instead hands out the
+ * payload of a single PBUF_RAM pbuf with transport headroom (prepare()); the
+ * caller writes the datagram straight into it from its ring, converting as it
+ * goes, and commit()s it. flush() then sends everything committed in one
+ * tcpip_api_call. A single pbuf (not a header + payload chain) means the IP and
+ * UDP headers go into the headroom and the netif doesn't flatten it again, so
+ * the only copy left after the fill is ESP-Hosted's into its SDIO buffer.
+ *
+ * One producer task per flow. Totals over all flows are in NetTx::getStats().
+ */
+class UdpFlow {
+public:
+    static constexpr int MAX_BATCH = 16;
+
+    UdpFlow() = default;
+    UdpFlow(const UdpFlow&) = delete;
+    UdpFlow& operator=(const UdpFlow&) = delete;
+    ~UdpFlow()
+    {
+        close();
+    }
+
+    // host is a dotted IPv4 address; tos goes in every datagram's IP header
+    bool open(const char* host, uint16_t port, uint8_t tos = 0);
+    void close();
+    bool isOpen() const
+    {
+        return _pcb != nullptr;
+    }
+
+    // len bytes to write the datagram into, valid until commit(); nullptr when
+    // the pool is out or MAX_BATCH datagrams are waiting for flush()
+    uint8_t* prepare(size_t len);
+    void commit();
+    // Sends the committed datagrams in one tcpip thread pass; returns how many the stack took
+    int flush();
+
+private:
+    udp_pcb* _pcb = nullptr;
+    pbuf* _prepared = nullptr;
+    pbuf* _batch[MAX_BATCH] = {};
+    int _count = 0;
+};
+
+/**
+ * @brief Transport counters for every UdpFlow, for sizing streams against the C6 link
+ */
+class NetTx {
+public:
+    static NetTx& getInstance();
+
+    NetTxStats getStats();
+
+    // ── UdpFlow ──
+    void countSent(uint32_t packets, uint32_t bytes, uint32_t errors);
+    void countAllocFail()
+    {
+        _allocFails.fetch_add(1, std::memory_order_relaxed);
+    }
+
+private:
+    NetTx() = default;
+    NetTx(const NetTx&) = delete;
+    NetTx& operator=(const NetTx&) = delete;
+
+    std::atomic<uint32_t> _packets{0};
+    std::atomic<uint32_t> _bytes{0};
+    std::atomic<uint32_t> _batches{0};
+    std::atomic<uint32_t> _allocFails{0};
+    std::atomic<uint32_t> _sendErrors{0};
+
+    std::mutex _mutex;  // Rate window
+    int64_t _lastUs = 0;
+    uint32_t _lastPackets = 0;
+    uint32_t _lastBytes = 0;
+};
@@ -0,0 +1,187 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "noise_dosimeter.h"
+#include "sd_storage.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <sys/stat.h>
+#include <mooncake_log.h>
+#include <nvs.h>
+
+static const char* TAG = "Dose";
+
+static constexpr uint32_t BLOB_MAGIC = 0x45534F44;  // "DOSE" little-endian
+static constexpr int MIN_CLOCK_YEAR = 2024;         // Older: the clock isn't set, there is no "today"
+static constexpr float LIMIT_RELEASE_DB = 1.0f;     // Per second, once the level drops
+
+struct DoseBlob {
+    uint32_t magic;
+    int32_t day;
+    float dose;
+};
+
+NoiseDosimeter& NoiseDosimeter::getInstance()
+{
+    static NoiseDosimeter instance;
+    return instance;
+}
+
+int NoiseDosimeter::today()
+{
+    const time_t now = time(nullptr);
+    tm local;
+    localtime_r(&now, &local);
+    if (local.tm_year + 1900 < MIN_CLOCK_YEAR) return 0;
+    return (local.tm_year + 1900) * 10000 + (local.tm_mon + 1) * 100 + local.tm_mday;
+}
+
+void NoiseDosimeter::load()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_loaded) return;
+    _loaded = true;
+    _day = today();
+
+    nvs_handle_t nvs;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) return;
+    DoseBlob blob;
+    size_t bytes = sizeof(blob);
+    const esp_err_t ret = nvs_get_blob(nvs, NVS_KEY, &blob, &bytes);
+    nvs_close(nvs);
+    // Without a set clock every boot would be the same day: start from zero instead
+    if (ret != ESP_OK || bytes != sizeof(blob) || blob.magic != BLOB_MAGIC || _day == 0 || blob.day != _day ||
+        !std::isfinite(blob.dose)) {
+        return;
+    }
+    _dose = std::max(0.0f, blob.dose);
+    _warned = _dose >= WARN_DOSE;
+    mclog::tagInfo(TAG, "today's dose so far: {:.1f}%", _dose * 100.0f);
+}
+
+void NoiseDosimeter::addSecond(float meanSquare, float splOffsetDb, float cutDb, float seconds)
+{
+    if (seconds <= 0.0f) return;
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    const int day = today();
+    if (day != _day) {
+        // Midnight (or the clock just got set): the finished day's minutes go out first
+        closeMinute();
+        flushLog();
+        _day = day;
+        _dose = 0.0f;
+        _warned = false;
+        _limitDb = 0.0f;
+        writeNvs();
+    }
+
+    // Sine-referenced: full-scale sine (mean square 0.5) is the calibration level
+    const float levelDb = meanSquare > 0.0f ? std::max(0.0f, 10.0f * log10f(2.0f * meanSquare) + splOffsetDb) : 0.0f;
+    _levelDb = levelDb;
+    if (meanSquare > 0.0f) {
+        // Allowed time at L is CRITERION_HOURS / 2^((L - CRITERION_DBA) / EXCHANGE_DB)
+        _dose += seconds / (CRITERION_HOURS * 3600.0f) * exp2f((levelDb - CRITERION_DBA) / EXCHANGE_DB);
+        _minuteEnergy += std::pow(10.0, levelDb / 10.0) * seconds;
+    }
+    _minuteSeconds += seconds;
+    _minuteMaxDb = std::max(_minuteMaxDb, levelDb);
+
+    if (!_warned && _dose >= WARN_DOSE) {
+        _warned = true;
+        mclog::tagWarn(TAG, "noise dose at {:.0f}% of the daily allowance", _dose * 100.0f);
+    }
+    if (_dose >= 1.0f) {
+        // cutDb is already in levelDb: the ear would be at levelDb + cutDb without it
+        const float want = std::clamp(levelDb + cutDb - SAFE_DBA, 0.0f, MAX_LIMIT_DB);
+        const float released = _limitDb - LIMIT_RELEASE_DB * seconds;
+        if (meanSquare > 0.0f && _limitDb == 0.0f && want > 0.0f) {
+            mclog::tagWarn(TAG, "daily noise dose spent, output held at {:.0f} dB SPL", SAFE_DBA);
+        }
+        _limitDb = meanSquare > 0.0f ? std::max(want, released) : std::max(0.0f, released);
+    }
+
+    if (_minuteSeconds >= 60.0f) closeMinute();
+}
+
+void NoiseDosimeter::closeMinute()
+{
+    if (_minuteSeconds <= 0.0f) return;
+    const double mean = _minuteEnergy / _minuteSeconds;
+    _laeqDb = mean > 0.0 ? static_cast<float>(10.0 * std::log10(mean)) : 0.0f;
+
+    MinuteRecord& r = _batch.records[_batch.count++];
+    r.minute = static_cast<uint32_t>(time(nullptr) / 60);
+    r.laeqDb = static_cast<uint8_t>(std::clamp(lrintf(_laeqDb), 0L, 255L));
+    r.lmaxDb = static_cast<uint8_t>(std::clamp(lrintf(_minuteMaxDb), 0L, 255L));
+    r.dosePermille = static_cast<uint16_t>(std::clamp(lrintf(_dose * 1000.0f), 0L, 65535L));
+    _batch.day = _day;
+    _minuteEnergy = 0.0;
+    _minuteSeconds = 0.0f;
+    _minuteMaxDb = 0.0f;
+
+    if (_batch.count == LOG_BATCH) flushLog();
+    if (++_minutesSincePersist >= PERSIST_MINUTES) writeNvs();
+}
+
+void NoiseDosimeter::flushLog()
+{
+    if (_batch.count == 0) return;
+    auto* batch = new LogBatch(_batch);
+    if (!SdStorage::getInstance().post(appendJob, batch)) delete batch;  // Queue full: these minutes are lost
+    _batch.count = 0;
+}
+
+void NoiseDosimeter::appendJob(void* arg)
+{
+    std::unique_ptr<LogBatch> batch(static_cast<LogBatch*>(arg));
+    if (!SdStorage::getInstance().mount()) return;
+    struct stat sb;
+    if (stat(LOG_DIR, &sb) != 0) mkdir(LOG_DIR, 0755);
+    char path[48];
+    snprintf(path, sizeof(path), "%s/%08d.bin", LOG_DIR, batch->day);
+    FILE* f = fopen(path, "ab");
+    if (!f) {
+        mclog::tagWarn(TAG, "cannot open {}", path);
+        return;
+    }
+    fwrite(batch->records, sizeof(MinuteRecord), batch->count, f);
+    fclose(f);
+}
+
+void NoiseDosimeter::writeNvs()
+{
+    _minutesSincePersist = 0;
+    if (_day == 0) return;
+    nvs_handle_t nvs;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) return;
+    const DoseBlob blob{BLOB_MAGIC, _day, _dose};
+    if (nvs_set_blob(nvs, NVS_KEY, &blob, sizeof(blob)) != ESP_OK || nvs_commit(nvs) != ESP_OK) {
+        mclog::tagWarn(TAG, "dose write failed");
+    }
+    nvs_close(nvs);
+}
+
+void NoiseDosimeter::persist()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    flushLog();
+    writeNvs();
+}
+
+NoiseDosimeter::Status NoiseDosimeter::status()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Status s;
+    s.dose = _dose;
+    s.levelDb = _levelDb;
+    s.laeqDb = _laeqDb;
+    s.limitDb = _limitDb;
+    s.warning = _warned;
+    return s;
+}
@@ -0,0 +1,101 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <cstdint>
+#include <mutex>
+
+/**
+ * @brief Daily noise dose at the headphones, from the engine's weighted output level
+ *
+ * The audio task sums the A- (or K-) weighted output energy and hands the control
+ * task one mean square per second; addSecond() turns it into ear SPL with the
+ * calibration and codec volume, and integrates the dose on the NIOSH criterion:
+ * CRITERION_DBA for CRITERION_HOURS is 100 %, every EXCHANGE_DB more halves the
+ * allowed time. Everything is incremental: a second costs one log and one power.
+ *
+ * Each minute becomes an 8-byte MinuteRecord; batches of LOG_BATCH go to the
+ * storage task, appended to LOG_DIR/<yyyymmdd>.bin (lost without a card). The day's
+ * dose goes to NVS every PERSIST_MINUTES and from persist(), so a reboot doesn't
+ * reset it; it restarts at local midnight.
+ *
+ * Past the dose, Status::limitDb is the output cut that holds the ear at SAFE_DBA, for
+ * the engine to apply when its dose mode asks for it.
+ */
+class NoiseDosimeter {
+public:
+    static constexpr const char* NVS_NAMESPACE = "howizard";
+    static constexpr const char* NVS_KEY = "dose";
+    static constexpr const char* LOG_DIR = "/sd/Dose";
+    static constexpr float CRITERION_DBA = 85.0f;
+    static constexpr float CRITERION_HOURS = 8.0f;
+    static constexpr float EXCHANGE_DB = 3.0f;
+    static constexpr float WARN_DOSE = 0.5f;     // NIOSH action level
+    static constexpr float SAFE_DBA = 75.0f;     // Ear level the limit holds once the dose is spent
+    static constexpr float MAX_LIMIT_DB = 30.0f;
+    static constexpr int LOG_BATCH = 10;         // Minutes per SD append
+    static constexpr int PERSIST_MINUTES = 10;
+
+    struct MinuteRecord {
+        uint32_t minute;        // Unix time / 60
+        uint8_t laeqDb;         // Equivalent level over the minute, dB SPL
+        uint8_t lmaxDb;         // Loudest second
+        uint16_t dosePermille;  // Day's dose at the end of the minute, 0.1 % steps (saturates)
+    };
+    static_assert(sizeof(MinuteRecord) == 8, "compact records");
+
+    struct Status {
+        float dose = 0.0f;       // Fraction of the daily allowance (1 = 100 %)
+        float levelDb = 0.0f;    // Last second, dB SPL (weighted)
+        float laeqDb = 0.0f;     // Last full minute
+        float limitDb = 0.0f;    // Output cut the limit asks for (0 = none)
+        bool warning = false;    // Dose past WARN_DOSE
+    };
+
+    static NoiseDosimeter& getInstance();
+
+    // Reads today's dose from NVS once per boot
+    void load();
+    // One second of output: weighted mean square of the louder ear (0 dBFS sine = 0.5),
+    // the dB that take it to ear SPL (calibration plus codec volume) and the dose cut the
+    // engine had applied to it. Control task
+    void addSecond(float meanSquare, float splOffsetDb, float cutDb, float seconds);
+    // Day's dose to NVS, pending minutes to the card; not from the audio task
+    void persist();
+    Status status();
+
+private:
+    NoiseDosimeter() = default;
+    NoiseDosimeter(const NoiseDosimeter&) = delete;
+    NoiseDosimeter& operator=(const NoiseDosimeter&) = delete;
+
+    struct LogBatch {
+        int day;
+        int count;
+        MinuteRecord records[LOG_BATCH];
+    };
+
+    static int today();  // yyyymmdd, local time
+    static void appendJob(void* arg);
+    void closeMinute();  // Callers hold _mutex
+    void flushLog();     // Callers hold _mutex
+    void writeNvs();     // Callers hold _mutex
+
+    std::mutex _mutex;
+    bool _loaded = false;
+    int _day = 0;
+    float _dose = 0.0f;
+    float _limitDb = 0.0f;
+    float _levelDb = 0.0f;
+    float _laeqDb = 0.0f;
+    bool _warned = false;
+
+    // Minute in progress
+    double _minuteEnergy = 0.0;  // Sum of 10^(L/10) * seconds
+    float _minuteSeconds = 0.0f;
+    float _minuteMaxDb = 0.0f;
+    int _minutesSincePersist = 0;
+    LogBatch _batch = {};
+};
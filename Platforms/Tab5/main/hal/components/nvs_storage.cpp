@@ -0,0 +1,41 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "nvs_storage.h"
+#include <mooncake_log.h>
+#include <esp_err.h>
+#include <nvs_flash.h>
+
+static const char* TAG = "Nvs";
+
+NvsStorage& NvsStorage::getInstance()
+{
+    static NvsStorage instance;
+    return instance;
+}
+
+bool NvsStorage::init()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_attempted) return _ready.load(std::memory_order_relaxed);
+    _attempted = true;
+
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        // Unmountable as it is: the stored sessions, bookings and dose are lost either way
+        mclog::tagWarn(TAG, "partition unusable ({}), erasing it", esp_err_to_name(ret));
+        ret = nvs_flash_erase();
+        if (ret == ESP_OK) {
+            _erased.store(true, std::memory_order_release);
+            ret = nvs_flash_init();
+        }
+    }
+    if (ret != ESP_OK) {
+        mclog::tagError(TAG, "init failed: {}, running without NVS", esp_err_to_name(ret));
+        return false;
+    }
+    _ready.store(true, std::memory_order_release);
+    return true;
+}
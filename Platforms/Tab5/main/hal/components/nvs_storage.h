@@ -0,0 +1,50 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <mutex>
+
+/**
+ * @brief Owner of the default NVS partition bring-up
+ *
+ * HalEsp32::init() calls init() first thing, before anything reads the
+ * "howizard" namespace (the session booking is claimed a few lines later).
+ * Every other user (SessionStore, SessionSchedule, AdaptiveStore,
+ * NoiseDosimeter, WifiLink and the Wi-Fi AP) relies on that and at most checks
+ * ready() or calls init() again for its result; none of them calls
+ * nvs_flash_init() itself.
+ *
+ * The partition is erased in one case only: nvs_flash_init() reporting that
+ * it has no free pages or was written by a newer NVS format. The partition
+ * can't be opened at all then, so erasing is the only way back to working
+ * storage. It is logged, and wasErased() lets the stores tell a reset from a
+ * first boot. Any other failure leaves the partition untouched and ready()
+ * false, so the stores skip NVS for this boot instead of losing it.
+ */
+class NvsStorage {
+public:
+    static NvsStorage& getInstance();
+
+    // Brings the partition up once; later calls return the first result
+    bool init();
+    bool ready() const
+    {
+        return _ready.load(std::memory_order_acquire);
+    }
+    // This boot's init() had to erase the partition to get it mounted
+    bool wasErased() const
+    {
+        return _erased.load(std::memory_order_acquire);
+    }
+
+private:
+    NvsStorage() = default;
+
+    std::mutex _mutex;
+    bool _attempted = false;
+    std::atomic<bool> _ready{false};
+    std::atomic<bool> _erased{false};
+};
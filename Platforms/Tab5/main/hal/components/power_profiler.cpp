@@ -0,0 +1,315 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "power_profiler.h"
+#include "audio_engine.h"
+#include "power_telemetry.h"
+#include "hal/hal_esp32.h"
+#include <mooncake_log.h>
+#include <algorithm>
+#include <bsp/m5stack_tab5.h>
+#include <cmath>
+#include <string>
+
+static const char* TAG = "PowerProf";
+
+static const char* const FEATURE_NAMES[] = {
+    "engine", "unmuted", "beam", "filters", "ns", "agc", "ve nlms", "ve aec", "ve fdaf",
+    "fbc", "mbc", "wdrc", "spectral", "limiter", "generators",
+};
+
+static std::string featureList(uint32_t features)
+{
+    if (features == 0) return "idle";
+    std::string s;
+    for (size_t f = 0; f < sizeof(FEATURE_NAMES) / sizeof(FEATURE_NAMES[0]); f++) {
+        if (!(features & (1u << f))) continue;
+        if (!s.empty()) s += ' ';
+        s += FEATURE_NAMES[f];
+    }
+    return s;
+}
+
+PowerProfiler& PowerProfiler::getInstance()
+{
+    static PowerProfiler instance;
+    return instance;
+}
+
+bool PowerProfiler::start()
+{
+    static_assert(sizeof(FEATURE_NAMES) / sizeof(FEATURE_NAMES[0]) == F_COUNT, "one name per feature");
+    static_assert(F_COUNT <= PowerProfileReport::MAX_FEATURES, "report holds every feature");
+    if (_taskAlive.load(std::memory_order_acquire)) return true;
+
+    reset();
+    _running.store(true, std::memory_order_release);
+    _taskAlive.store(true, std::memory_order_release);
+    // Core 0 at the bottom: the I2C reads must never delay the audio core or the UI
+    if (xTaskCreatePinnedToCore(profilerTask, "pwr_prof", 4096, this, 1, &_taskHandle, 0) != pdPASS) {
+        _running.store(false, std::memory_order_release);
+        _taskAlive.store(false, std::memory_order_release);
+        _taskHandle = nullptr;
+        mclog::tagError(TAG, "failed to create profiler task");
+        return false;
+    }
+    mclog::tagInfo(TAG, "profiling every {} ms", SAMPLE_MS);
+    return true;
+}
+
+void PowerProfiler::stop()
+{
+    if (!_taskAlive.load(std::memory_order_acquire)) return;
+    _running.store(false, std::memory_order_release);
+    for (int i = 0; i < 50 && _taskAlive.load(std::memory_order_acquire); i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    if (_taskAlive.load(std::memory_order_acquire)) mclog::tagWarn(TAG, "profiler task did not stop in time");
+    _taskHandle = nullptr;
+    logReport();
+}
+
+void PowerProfiler::reset()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _bins.clear();
+    _bins.reserve(MAX_BINS);
+    _droppedBins = 0;
+    _samples = 0;
+    _sumMw = 0.0;
+    _lastMw = 0.0f;
+    std::fill(&_xtx[0][0], &_xtx[0][0] + FIT_N * FIT_N, 0.0);
+    std::fill(_xty, _xty + FIT_N, 0.0);
+    std::fill(_onCount, _onCount + F_COUNT, 0u);
+    _brightMin = 100;
+    _brightMax = 0;
+    _windowMw = 0.0;
+    _windowMa = 0.0;
+    _windowCount = 0;
+}
+
+void PowerProfiler::profilerTask(void* arg)
+{
+    auto* self = static_cast<PowerProfiler*>(arg);
+    TickType_t wake = xTaskGetTickCount();
+    while (self->_running.load(std::memory_order_acquire)) {
+        self->sample();
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(SAMPLE_MS));
+    }
+    self->_taskAlive.store(false, std::memory_order_release);
+    vTaskDelete(nullptr);
+}
+
+uint32_t PowerProfiler::currentFeatures()
+{
+    auto& engine = AudioEngine::getInstance();
+    if (!engine.isRunning()) return 0;
+    const AudioEngineParams p = engine.getParams();
+    const auto& tin = p.tinnitus;
+
+    uint32_t f = 1u << F_ENGINE;
+    auto set = [&](Feature bit, bool on) {
+        if (on) f |= 1u << bit;
+    };
+    set(F_UNMUTED, !p.outputMute);
+    set(F_BEAM, p.beamMode > 0);
+    for (AudioEar ear : {AUDIO_EAR_LEFT, AUDIO_EAR_RIGHT}) {
+        const EarParams e = p.ear(ear);
+        set(F_FILTERS, e.hpfEnabled || e.lpfEnabled || e.eqLowGain != 0.0f || e.eqMidGain != 0.0f || e.eqHighGain != 0.0f);
+    }
+    set(F_NS, p.nsEnabled);
+    // The engine skips AGC under WDRC or the MBC
+    set(F_AGC, p.agcEnabled && !p.fitting.wdrcEnabled && !p.dynamics.mbcEnabled);
+    set(F_VE_NLMS, p.veEnabled && (p.veMode == 0 || p.veMode == 3));  // Subband: same kind of load
+    set(F_VE_AEC, p.veEnabled && p.veMode == 1);
+    set(F_VE_FDAF, p.veEnabled && p.veMode == 2);
+    set(F_FBC, p.fbcEnabled);
+    set(F_MBC, p.dynamics.mbcEnabled);
+    set(F_WDRC, p.fitting.wdrcEnabled);
+    set(F_SPECTRAL, p.fitting.nfcEnabled);
+    set(F_LIMITER, p.dynamics.limiterEnabled);
+    set(F_GENERATORS, tin.noiseType != 0 || tin.toneFinderEnabled || tin.binauralEnabled);
+    return f;
+}
+
+void PowerProfiler::sample()
+{
+    auto* hal = static_cast<HalEsp32*>(GetHAL());
+    // The power register is unsigned; the shunt current's sign only says charge vs discharge
+    float mW;
+    float mA;
+    PowerSample cached;
+    if (PowerTelemetry::getInstance().latest(cached)) {
+        // Sample and hold of the telemetry task's last result, no bus traffic
+        mW = cached.busPower * 1000.0f;
+        mA = std::fabs(cached.shuntCurrent) * 1000.0f;
+    } else {
+        if (bsp_i2c_acquire(BSP_I2C_CLASS_TELEMETRY, 100) != ESP_OK) return;
+        mW = hal->ina226.readBusPower() * 1000.0f;
+        mA = std::fabs(hal->ina226.readShuntCurrent()) * 1000.0f;
+        bsp_i2c_release(BSP_I2C_CLASS_TELEMETRY);
+    }
+    const uint32_t features = currentFeatures();
+    const int rawBrightness = hal->getDisplayBrightness();
+    const int brightness = (rawBrightness + 5) / 10 * 10;
+    const int uiState = _uiState.load(std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _samples++;
+        _sumMw += mW;
+        _lastMw = mW;
+        _brightMin = std::min(_brightMin, rawBrightness);
+        _brightMax = std::max(_brightMax, rawBrightness);
+
+        auto bin = std::find_if(_bins.begin(), _bins.end(), [&](const Bin& b) {
+            return b.features == features && b.brightness == brightness && b.uiState == uiState;
+        });
+        if (bin == _bins.end() && _bins.size() < MAX_BINS) {
+            Bin b;
+            b.features = features;
+            b.brightness = brightness;
+            b.uiState = uiState;
+            b.minMw = mW;
+            b.maxMw = mW;
+            _bins.push_back(b);
+            bin = _bins.end() - 1;
+        }
+        if (bin != _bins.end()) {
+            bin->samples++;
+            bin->sumMw += mW;
+            bin->minMw = std::min(bin->minMw, mW);
+            bin->maxMw = std::max(bin->maxMw, mW);
+        } else {
+            _droppedBins++;
+        }
+
+        double x[FIT_N];
+        for (int f = 0; f < F_COUNT; f++) {
+            x[f] = (features >> f) & 1u;
+            if (x[f] != 0.0) _onCount[f]++;
+        }
+        x[F_COUNT] = rawBrightness / 10.0;
+        x[F_COUNT + 1] = 1.0;
+        for (int i = 0; i < FIT_N; i++) {
+            for (int j = 0; j < FIT_N; j++) _xtx[i][j] += x[i] * x[j];
+            _xty[i] += x[i] * mW;
+        }
+    }
+
+    _windowMw += mW;
+    _windowMa += mA;
+    if (++_windowCount >= LOG_EVERY) {
+        mclog::tagInfo(TAG, "{:.0f} mW {:.0f} mA  bri {}%  ui {}  [{}]", _windowMw / _windowCount,
+            _windowMa / _windowCount, rawBrightness, uiState, featureList(features));
+        _windowMw = 0.0;
+        _windowMa = 0.0;
+        _windowCount = 0;
+    }
+}
+
+// Least squares over the regressors that actually varied; the rest stay 0. Caller holds _mutex.
+bool PowerProfiler::solveFit(double* coef, bool* observed)
+{
+    std::fill(coef, coef + FIT_N, 0.0);
+    int idx[FIT_N];
+    int n = 0;
+    for (int f = 0; f < F_COUNT; f++) {
+        // A feature that was always on (or off) can't be told apart from the base draw
+        observed[f] = _onCount[f] > 0 && _onCount[f] < _samples;
+        if (observed[f]) idx[n++] = f;
+    }
+    observed[F_COUNT] = _brightMax > _brightMin;
+    if (observed[F_COUNT]) idx[n++] = F_COUNT;
+    observed[F_COUNT + 1] = true;
+    idx[n++] = F_COUNT + 1;
+    if (_samples < static_cast<uint32_t>(2 * n)) return false;
+
+    // Augmented [A | b], with a small ridge so features that only ever moved together stay finite
+    double a[FIT_N][FIT_N + 1];
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) a[i][j] = _xtx[idx[i]][idx[j]];
+        a[i][n] = _xty[idx[i]];
+        if (idx[i] != F_COUNT + 1) a[i][i] += 1e-3 * _samples;
+    }
+    for (int col = 0; col < n; col++) {
+        int pivot = col;
+        for (int r = col + 1; r < n; r++) {
+            if (std::fabs(a[r][col]) > std::fabs(a[pivot][col])) pivot = r;
+        }
+        if (std::fabs(a[pivot][col]) < 1e-9) return false;
+        if (pivot != col) {
+            for (int j = 0; j <= n; j++) std::swap(a[col][j], a[pivot][j]);
+        }
+        for (int r = 0; r < n; r++) {
+            if (r == col) continue;
+            const double k = a[r][col] / a[col][col];
+            for (int j = col; j <= n; j++) a[r][j] -= k * a[col][j];
+        }
+    }
+    for (int i = 0; i < n; i++) coef[idx[i]] = a[i][n] / a[i][i];
+    return true;
+}
+
+PowerProfileReport PowerProfiler::getReport()
+{
+    PowerProfileReport r;
+    r.running = isRunning();
+    std::lock_guard<std::mutex> lock(_mutex);
+    r.samples = _samples;
+    r.seconds = _samples * SAMPLE_MS / 1000.0f;
+    r.lastMw = _lastMw;
+    r.avgMw = _samples ? static_cast<float>(_sumMw / _samples) : 0.0f;
+
+    double coef[FIT_N];
+    bool observed[FIT_N];
+    if (!solveFit(coef, observed)) return r;
+    r.baseMw = static_cast<float>(coef[F_COUNT + 1]);
+    r.perBrightnessMw = static_cast<float>(coef[F_COUNT]);
+    for (int f = 0; f < F_COUNT; f++) {
+        r.features[r.featureCount++] = {FEATURE_NAMES[f], static_cast<float>(coef[f]), observed[f]};
+    }
+    std::sort(r.features, r.features + r.featureCount, [](const PowerFeatureCost& a, const PowerFeatureCost& b) {
+        if (a.observed != b.observed) return a.observed;
+        return a.mW > b.mW;
+    });
+    return r;
+}
+
+void PowerProfiler::logReport()
+{
+    const PowerProfileReport r = getReport();
+    std::vector<Bin> bins;
+    uint32_t dropped;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        bins = _bins;
+        dropped = _droppedBins;
+    }
+    std::sort(bins.begin(), bins.end(), [](const Bin& a, const Bin& b) {
+        return a.sumMw / a.samples > b.sumMw / b.samples;
+    });
+
+    mclog::tagInfo(TAG, "power report: {} samples over {:.0f} s, {:.0f} mW average", r.samples, r.seconds, r.avgMw);
+    for (const auto& b : bins) {
+        mclog::tagInfo(TAG, "  {:>5.0f} mW ({:.0f}-{:.0f})  {:>5.1f} s  bri {:>3}%  ui {}  [{}]", b.sumMw / b.samples,
+            b.minMw, b.maxMw, b.samples * SAMPLE_MS / 1000.0f, b.brightness, b.uiState, featureList(b.features));
+    }
+    if (dropped) mclog::tagWarn(TAG, "  {} samples in states past the {}-bin table", dropped, MAX_BINS);
+
+    if (r.featureCount == 0) {
+        mclog::tagInfo(TAG, "  too few samples to attribute per feature");
+        return;
+    }
+    mclog::tagInfo(TAG, "  fit: base {:.0f} mW, backlight {:+.1f} mW per 10%", r.baseMw, r.perBrightnessMw);
+    for (int i = 0; i < r.featureCount; i++) {
+        const auto& f = r.features[i];
+        if (f.observed) {
+            mclog::tagInfo(TAG, "  {:<12} {:+.0f} mW", f.name, f.mW);
+        } else {
+            mclog::tagInfo(TAG, "  {:<12} not toggled", f.name);
+        }
+    }
+}
@@ -0,0 +1,135 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// One feature's fitted share of the power draw
+struct PowerFeatureCost {
+    const char* name = "";
+    float mW = 0.0f;         // Added draw while the feature is on
+    bool observed = false;   // Seen both on and off, so the fit means something
+};
+
+struct PowerProfileReport {
+    static constexpr int MAX_FEATURES = 16;
+
+    bool running = false;
+    uint32_t samples = 0;
+    float seconds = 0.0f;
+    float lastMw = 0.0f;
+    float avgMw = 0.0f;
+    float baseMw = 0.0f;          // Fitted draw with every feature off, screen dark
+    float perBrightnessMw = 0.0f; // Fitted draw per 10% backlight
+    PowerFeatureCost features[MAX_FEATURES];  // Costliest first
+    int featureCount = 0;
+};
+
+/**
+ * @brief Sampled power-per-feature profiler on the INA226
+ *
+ * A low-priority task on Core 0 takes the cached INA226 result (PowerTelemetry)
+ * every SAMPLE_MS and tags each sample with the audio engine's active feature
+ * set, the backlight level and the UI state the app last reported. Samples are
+ * binned per state (mean mW
+ * per bin) and also fed to a running least-squares fit of
+ * mW = base + brightness + sum(feature costs), which is what attributes the
+ * draw to individual features even when they are only ever seen in
+ * combination. A 1 s average is logged while the profiler runs and the full
+ * table on stop.
+ */
+class PowerProfiler {
+public:
+    static constexpr int SAMPLE_MS = 100;  // Time-weighted: results change every PowerTelemetry::CONVERSION_MS
+    static constexpr int LOG_EVERY = 10;   // Samples per logged line
+    static constexpr int MAX_BINS  = 48;
+
+    static PowerProfiler& getInstance();
+
+    bool start();
+    void stop();
+    bool isRunning() const
+    {
+        return _running.load(std::memory_order_acquire);
+    }
+    // App view state (e.g. the visible panel); part of each sample's bin
+    void setUiState(int state)
+    {
+        _uiState.store(state, std::memory_order_relaxed);
+    }
+    PowerProfileReport getReport();
+    // Full bin table and fit to the log
+    void logReport();
+
+private:
+    PowerProfiler() = default;
+    PowerProfiler(const PowerProfiler&) = delete;
+    PowerProfiler& operator=(const PowerProfiler&) = delete;
+
+    enum Feature {
+        F_ENGINE = 0,  // Engine running: I2S, codec, the block loop itself
+        F_UNMUTED,     // Output amp driven
+        F_BEAM,
+        F_FILTERS,
+        F_NS,
+        F_AGC,
+        F_VE_NLMS,
+        F_VE_AEC,
+        F_VE_FDAF,
+        F_FBC,
+        F_MBC,
+        F_WDRC,
+        F_SPECTRAL,
+        F_LIMITER,
+        F_GENERATORS,
+        F_COUNT
+    };
+    // Regressors: one per feature, the backlight, then the intercept
+    static constexpr int FIT_N = F_COUNT + 2;
+
+    struct Bin {
+        uint32_t features = 0;
+        int brightness = 0;  // Rounded to 10%
+        int uiState = 0;
+        uint32_t samples = 0;
+        double sumMw = 0.0;
+        float minMw = 0.0f;
+        float maxMw = 0.0f;
+    };
+
+    static void profilerTask(void* arg);
+    void sample();
+    uint32_t currentFeatures();
+    void reset();
+    // Solves the normal equations; false while too few samples
+    bool solveFit(double* coef, bool* observed);
+
+    std::mutex _mutex;  // Everything below _running, between the task and readers
+    std::atomic<bool> _running{false};
+    std::atomic<bool> _taskAlive{false};
+    std::atomic<int> _uiState{0};
+    TaskHandle_t _taskHandle = nullptr;
+
+    std::vector<Bin> _bins;
+    uint32_t _droppedBins = 0;  // Samples whose state found no free bin
+    uint32_t _samples = 0;
+    double _sumMw = 0.0;
+    float _lastMw = 0.0f;
+    double _xtx[FIT_N][FIT_N] = {};
+    double _xty[FIT_N] = {};
+    uint32_t _onCount[F_COUNT] = {};
+    int _brightMin = 100;  // Backlight range seen; a constant backlight isn't fitted
+    int _brightMax = 0;
+
+    // Task-only: the current 1 s window
+    double _windowMw = 0.0;
+    double _windowMa = 0.0;
+    int _windowCount = 0;
+};
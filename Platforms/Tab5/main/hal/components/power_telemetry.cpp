@@ -0,0 +1,232 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "power_telemetry.h"
+#include "../utils/core_policy/core_policy.h"
+#include <mooncake_log.h>
+#include <algorithm>
+#include <cmath>
+#include <bsp/m5stack_tab5.h>
+#include <driver/gpio.h>
+#include <esp_attr.h>
+#include <esp_timer.h>
+
+static const char* TAG = "PowerTel";
+
+static constexpr int READER_STACK = 3072;
+static constexpr UBaseType_t READER_PRIORITY = 2;
+
+PowerTelemetry& PowerTelemetry::getInstance()
+{
+    static PowerTelemetry instance;
+    return instance;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Control
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool PowerTelemetry::start(INA226* ina, int alertGpio)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_running.load(std::memory_order_relaxed)) return true;
+    if (!ina) return false;
+
+    _ina = ina;
+    _alertGpio = alertGpio >= 0 && setupAlertGpio(alertGpio) ? alertGpio : -1;
+    if (bsp_i2c_acquire(BSP_I2C_CLASS_TELEMETRY, BSP_I2C_WAIT_FOREVER) != ESP_OK) return false;
+    _ina->configure(AVERAGES, INA226_BUS_CONV_TIME_1100US, INA226_SHUNT_CONV_TIME_1100US,
+                    INA226_MODE_SHUNT_BUS_CONT);
+    if (_alertGpio >= 0) {
+        // ALERT is open drain, active low; latched until the Mask/Enable read
+        _ina->enableConversionReadyAlert();
+        _ina->setAlertLatch(true);
+    } else {
+        _ina->disableAlerts();
+    }
+    _ina->getMaskEnable();
+    bsp_i2c_release(BSP_I2C_CLASS_TELEMETRY);
+
+    _stats = {};
+    _stats.alertDriven = _alertGpio >= 0;
+    _haveLatest = false;
+    _bucketCount = 0;
+    _historyHead = 0;
+
+    _running.store(true, std::memory_order_release);
+    if (xTaskCreatePinnedToCore(readerTask, "power_tel", READER_STACK, this, READER_PRIORITY, &_task,
+                                core_policy::SYSTEM_AFFINITY) != pdPASS) {
+        _running.store(false, std::memory_order_relaxed);
+        _task = nullptr;
+        mclog::tagError(TAG, "failed to create reader task");
+        return false;
+    }
+
+    mclog::tagInfo(TAG, "{} averages, {} ms per result, {}", AVERAGE_COUNT, CONVERSION_MS,
+                   _alertGpio >= 0 ? "ALERT driven" : "polled");
+    return true;
+}
+
+bool PowerTelemetry::setupAlertGpio(int gpio)
+{
+    gpio_config_t io = {};
+    io.pin_bit_mask = 1ULL << gpio;
+    io.mode = GPIO_MODE_INPUT;
+    io.pull_up_en = GPIO_PULLUP_ENABLE;
+    io.intr_type = GPIO_INTR_NEGEDGE;
+    esp_err_t err = gpio_config(&io);
+    if (err == ESP_OK) {
+        err = gpio_install_isr_service(0);
+        if (err == ESP_ERR_INVALID_STATE) err = ESP_OK;  // Already installed
+    }
+    if (err == ESP_OK) err = gpio_isr_handler_add(static_cast<gpio_num_t>(gpio), alertIsr, this);
+    if (err != ESP_OK) {
+        mclog::tagError(TAG, "ALERT on GPIO {} failed ({}), polling instead", gpio, esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
+PowerTelemetryStats PowerTelemetry::getStats()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    PowerTelemetryStats s = _stats;
+    s.running = isRunning();
+    return s;
+}
+
+void PowerTelemetry::resetCounters()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stats.chargeMah = 0.0;
+    _stats.energyMwh = 0.0;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Readers
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool PowerTelemetry::latest(PowerSample& out)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_haveLatest) return false;
+    out = _latest;
+    return true;
+}
+
+size_t PowerTelemetry::history(PowerSample* out, size_t max)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    const uint32_t kept = std::min(_historyHead, HISTORY_SIZE);
+    const size_t n = std::min<size_t>(max, kept);
+    // The newest n, oldest first
+    for (size_t i = 0; i < n; i++) {
+        out[i] = _history[(_historyHead - n + i) % HISTORY_SIZE];
+    }
+    return n;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Reader task
+// ─────────────────────────────────────────────────────────────────────────────
+
+void IRAM_ATTR PowerTelemetry::alertIsr(void* arg)
+{
+    TaskHandle_t task = static_cast<PowerTelemetry*>(arg)->_task;
+    if (!task) return;  // Before the reader exists
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(task, &woken);
+    if (woken == pdTRUE) portYIELD_FROM_ISR();
+}
+
+void PowerTelemetry::readerTask(void* param)
+{
+    static_cast<PowerTelemetry*>(param)->readerLoop();
+}
+
+void PowerTelemetry::readerLoop()
+{
+    const TickType_t pollPeriod = pdMS_TO_TICKS(CONVERSION_MS / 2);
+    const TickType_t alertTimeout = pdMS_TO_TICKS(CONVERSION_MS * 2);
+    TickType_t wake = xTaskGetTickCount();
+    while (true) {
+        if (_alertGpio >= 0) {
+            // A missed edge leaves ALERT latched low; the timeout read clears it and re-arms
+            if (ulTaskNotifyTake(pdTRUE, alertTimeout) == 0) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stats.alertTimeouts++;
+            }
+        } else {
+            vTaskDelayUntil(&wake, pollPeriod);
+        }
+        poll();
+    }
+}
+
+void PowerTelemetry::poll()
+{
+    if (bsp_i2c_acquire(BSP_I2C_CLASS_TELEMETRY, CONVERSION_MS) != ESP_OK) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats.busTimeouts++;
+        return;
+    }
+    // Reading Mask/Enable clears the flag and the latched ALERT
+    const bool ready = (_ina->getMaskEnable() & INA226_BIT_CVRF) != 0;
+    PowerSample s;
+    if (ready) {
+        s.busVoltage = _ina->readBusVoltage();
+        s.shuntVoltage = _ina->readShuntVoltage();
+        s.shuntCurrent = _ina->readShuntCurrent();
+    }
+    bsp_i2c_release(BSP_I2C_CLASS_TELEMETRY);
+
+    if (!ready) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats.notReady++;
+        return;
+    }
+    s.timeUs = esp_timer_get_time();
+    s.busPower = s.busVoltage * std::abs(s.shuntCurrent);  // Unsigned, as the power register
+    accumulate(s);
+}
+
+void PowerTelemetry::accumulate(const PowerSample& s)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_haveLatest) {
+        const int64_t dt = s.timeUs - _latest.timeUs;
+        if (dt > 0 && dt <= MAX_GAP_US) {
+            // us to hours, then A h and W h to mAh and mWh; trapezoids over the interval
+            const double hours = dt / 3.6e9;
+            _stats.chargeMah += 0.5 * (s.shuntCurrent + _latest.shuntCurrent) * 1000.0 * hours;
+            _stats.energyMwh += 0.5 * (s.busPower + _latest.busPower) * 1000.0 * hours;
+        }
+    }
+    _latest = s;
+    _haveLatest = true;
+    _stats.conversions++;
+
+    // Whole esp_timer seconds: a result in a new second closes the last one's average
+    const int64_t second = s.timeUs / 1000000;
+    if (_bucketCount > 0 && second != _bucketSecond) {
+        PowerSample& avg = _history[_historyHead % HISTORY_SIZE];
+        avg.timeUs = _bucketSecond * 1000000;
+        avg.busVoltage = _bucketSum.busVoltage / _bucketCount;
+        avg.shuntVoltage = _bucketSum.shuntVoltage / _bucketCount;
+        avg.shuntCurrent = _bucketSum.shuntCurrent / _bucketCount;
+        avg.busPower = _bucketSum.busPower / _bucketCount;
+        _historyHead++;
+        _bucketCount = 0;
+    }
+    if (_bucketCount == 0) {
+        _bucketSecond = second;
+        _bucketSum = {};
+    }
+    _bucketSum.busVoltage += s.busVoltage;
+    _bucketSum.shuntVoltage += s.shuntVoltage;
+    _bucketSum.shuntCurrent += s.shuntCurrent;
+    _bucketSum.busPower += s.busPower;
+    _bucketCount++;
+}
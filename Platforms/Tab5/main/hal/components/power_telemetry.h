@@ -0,0 +1,107 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <ina226.hpp>
+
+// V, A (signed: the sign says charge vs discharge), W
+struct PowerSample {
+    int64_t timeUs = 0;  // esp_timer time the conversion was read
+    float busVoltage = 0.0f;
+    float shuntVoltage = 0.0f;
+    float shuntCurrent = 0.0f;
+    float busPower = 0.0f;
+};
+
+struct PowerTelemetryStats {
+    bool running = false;
+    bool alertDriven = false;   // false: conversion-ready flag polled
+    uint32_t conversions = 0;   // Read since start
+    uint32_t notReady = 0;      // Polls or alerts that found no new conversion
+    uint32_t alertTimeouts = 0; // Alert mode: a conversion period passed without an edge
+    uint32_t busTimeouts = 0;
+    double chargeMah = 0.0;     // Integral of the shunt current since the last reset
+    double energyMwh = 0.0;     // Integral of the bus power since the last reset
+};
+
+/**
+ * @brief Cached INA226 readings, a coulomb counter and a rolling history
+ *
+ * The INA226 runs continuously with AVERAGES on-chip averaging of both
+ * channels, one averaged result per CONVERSION_MS. A Core 0 task reads each
+ * result once: the Mask/Enable read that reports conversion-ready (and clears
+ * it and a latched ALERT), then bus voltage, shunt voltage and current under
+ * one telemetry hold on the shared bus. Power is bus voltage times current, the
+ * product the chip's power register holds, one transaction less.
+ *
+ * With CONFIG_HOWIZARD_INA226_ALERT_GPIO set, ALERT is programmed as
+ * conversion-ready (latched) and the task reads on its falling edge. Otherwise
+ * it polls the flag at twice the conversion rate, so clock drift between the
+ * chip and the ESP32-P4 never skips a conversion.
+ *
+ * Each result feeds the charge and energy integrals and a 1 s average in a
+ * HISTORY_SIZE ring. Readers (the HAL's power monitor data, the power
+ * profiler) get the cached values with no bus traffic.
+ */
+class PowerTelemetry {
+public:
+    static constexpr ina226_averages_t AVERAGES = INA226_AVERAGES_64;
+    static constexpr uint32_t AVERAGE_COUNT = 64;
+    static constexpr uint32_t CONVERSION_MS = AVERAGE_COUNT * (1100 + 1100) / 1000;  // 140 ms, both channels
+    static constexpr uint32_t HISTORY_SIZE = 300;                                      // 1 s each, 5 min
+    static constexpr int64_t MAX_GAP_US = 2000000;  // Longer gaps (a stalled task) are not integrated
+
+    static PowerTelemetry& getInstance();
+
+    // The INA226 must be begun and calibrated; start() sets the averaging and mode
+    bool start(INA226* ina, int alertGpio);
+    bool isRunning() const
+    {
+        return _running.load(std::memory_order_relaxed);
+    }
+    PowerTelemetryStats getStats();
+    void resetCounters();
+
+    // Newest conversion; false before the first
+    bool latest(PowerSample& out);
+    // Newest max 1 s averages (timeUs: the second's start), oldest first; returns the number copied
+    size_t history(PowerSample* out, size_t max);
+
+private:
+    PowerTelemetry() = default;
+    PowerTelemetry(const PowerTelemetry&) = delete;
+    PowerTelemetry& operator=(const PowerTelemetry&) = delete;
+
+    bool setupAlertGpio(int gpio);
+    static void alertIsr(void* arg);
+    static void readerTask(void* param);
+    void readerLoop();
+    void poll();
+    void accumulate(const PowerSample& s);
+
+    INA226* _ina = nullptr;
+    int _alertGpio = -1;
+    std::atomic<bool> _running{false};
+    TaskHandle_t _task = nullptr;
+
+    std::mutex _mutex;  // Everything below
+    PowerSample _latest;
+    bool _haveLatest = false;
+    PowerTelemetryStats _stats;
+
+    // Current 1 s bucket
+    int64_t _bucketSecond = 0;
+    uint32_t _bucketCount = 0;
+    PowerSample _bucketSum;
+
+    PowerSample _history[HISTORY_SIZE];
+    uint32_t _historyHead = 0;  // Averages written, the next goes to _history[_historyHead % HISTORY_SIZE]
+};
@@ -4,34 +4,31 @@
  * SPDX-License-Identifier: MIT
  */
 #include "profile_manager.h"
+#include "profile_schema.h"
+#include "sd_storage.h"
 #include <mooncake_log.h>
-#include <bsp/m5stack_tab5.h>
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
-#include <cstdlib>
-#include <dirent.h>
+#include <esp_rom_crc.h>
+#include <iterator>
+#include <memory>
+#include <string_view>
 #include <sys/stat.h>
+#include <unistd.h>
 
 static const char* TAG = "ProfileMgr";
 
+std::mutex ProfileManager::_mutex;
+std::vector<ProfileManager::Entry> ProfileManager::_index;
+std::string ProfileManager::_defaultName;
+uint32_t ProfileManager::_indexGeneration = 0;
+std::atomic<size_t> ProfileManager::_indexProgress{0};
+
 // ─────────────────────────────────────────────────────────────────────────────
-// SD mount/unmount (follows existing scanSdCard() pattern)
+// Directory helpers
 // ─────────────────────────────────────────────────────────────────────────────
 
-bool ProfileManager::mountSd()
-{
-    if (bsp_sdcard_init(const_cast<char*>("/sd"), 25) != ESP_OK) {
-        mclog::tagError(TAG, "failed to mount SD card");
-        return false;
-    }
-    return true;
-}
-
-void ProfileManager::unmountSd()
-{
-    bsp_sdcard_deinit(const_cast<char*>("/sd"));
-}
-
 bool ProfileManager::ensureDirectory()
 {
     struct stat st;
@@ -45,9 +42,9 @@ bool ProfileManager::ensureDirectory()
     return true;
 }
 
-std::string ProfileManager::profilePath(const std::string& name)
+std::string ProfileManager::profilePath(const std::string& name, const char* ext)
 {
-    return std::string(PROFILES_DIR) + "/" + name + FILE_EXT;
+    return std::string(PROFILES_DIR) + "/" + name + ext;
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -63,66 +60,27 @@ bool ProfileManager::serialize(const std::string& path, const AudioEngineParams&
     }
 
     fprintf(f, "%s\n", FILE_HEADER);
-    fprintf(f, "micGain=%.1f\n", params.micGain);
-    fprintf(f, "hpfEnabled=%d\n", params.hpfEnabled ? 1 : 0);
-    fprintf(f, "hpfFrequency=%.1f\n", params.hpfFrequency);
-    fprintf(f, "lpfEnabled=%d\n", params.lpfEnabled ? 1 : 0);
-    fprintf(f, "lpfFrequency=%.1f\n", params.lpfFrequency);
-    fprintf(f, "eqLowGain=%.1f\n", params.eqLowGain);
-    fprintf(f, "eqMidGain=%.1f\n", params.eqMidGain);
-    fprintf(f, "eqHighGain=%.1f\n", params.eqHighGain);
-    fprintf(f, "nsEnabled=%d\n", params.nsEnabled ? 1 : 0);
-    fprintf(f, "nsMode=%d\n", params.nsMode);
-    fprintf(f, "agcEnabled=%d\n", params.agcEnabled ? 1 : 0);
-    fprintf(f, "agcMode=%d\n", params.agcMode);
-    fprintf(f, "agcCompressionGainDb=%d\n", params.agcCompressionGainDb);
-    fprintf(f, "agcLimiterEnabled=%d\n", params.agcLimiterEnabled ? 1 : 0);
-    fprintf(f, "agcTargetLevelDbfs=%d\n", params.agcTargetLevelDbfs);
-    fprintf(f, "veEnabled=%d\n", params.veEnabled ? 1 : 0);
-    fprintf(f, "veBlend=%.2f\n", params.veBlend);
-    fprintf(f, "veStepSize=%.2f\n", params.veStepSize);
-    fprintf(f, "veFilterLength=%d\n", params.veFilterLength);
-    fprintf(f, "veMaxAttenuation=%.2f\n", params.veMaxAttenuation);
-    fprintf(f, "veRefGain=%.2f\n", params.veRefGain);
-    fprintf(f, "veRefHpf=%.1f\n", params.veRefHpf);
-    fprintf(f, "veRefLpf=%.1f\n", params.veRefLpf);
-    fprintf(f, "veMode=%d\n", params.veMode);
-    fprintf(f, "veAecMode=%d\n", params.veAecMode);
-    fprintf(f, "veAecFilterLen=%d\n", params.veAecFilterLen);
-    fprintf(f, "veVadEnabled=%d\n", params.veVadEnabled ? 1 : 0);
-    fprintf(f, "veVadMode=%d\n", params.veVadMode);
-    fprintf(f, "veVadGateEnabled=%d\n", params.veVadGateEnabled ? 1 : 0);
-    fprintf(f, "veVadGateAtten=%.2f\n", params.veVadGateAtten);
-    fprintf(f, "outputGain=%.2f\n", params.outputGain);
-    fprintf(f, "outputVolume=%d\n", params.outputVolume);
-    fprintf(f, "outputMute=%d\n", params.outputMute ? 1 : 0);
-    fprintf(f, "boostEnabled=%d\n", params.boostEnabled ? 1 : 0);
-
-    // Tinnitus relief params
-    for (int i = 0; i < 6; i++) {
-        fprintf(f, "notch%d_enabled=%d\n", i, params.tinnitus.notches[i].enabled ? 1 : 0);
-        fprintf(f, "notch%d_frequency=%.1f\n", i, params.tinnitus.notches[i].frequency);
-        fprintf(f, "notch%d_Q=%.1f\n", i, params.tinnitus.notches[i].Q);
-    }
-    fprintf(f, "noiseType=%d\n", params.tinnitus.noiseType);
-    fprintf(f, "noiseLevel=%.2f\n", params.tinnitus.noiseLevel);
-    fprintf(f, "noiseLowCut=%.1f\n", params.tinnitus.noiseLowCut);
-    fprintf(f, "noiseHighCut=%.1f\n", params.tinnitus.noiseHighCut);
-    fprintf(f, "toneFinderEnabled=%d\n", params.tinnitus.toneFinderEnabled ? 1 : 0);
-    fprintf(f, "toneFinderFreq=%.1f\n", params.tinnitus.toneFinderFreq);
-    fprintf(f, "toneFinderLevel=%.2f\n", params.tinnitus.toneFinderLevel);
-    fprintf(f, "hfExtEnabled=%d\n", params.tinnitus.hfExtEnabled ? 1 : 0);
-    fprintf(f, "hfExtFreq=%.1f\n", params.tinnitus.hfExtFreq);
-    fprintf(f, "hfExtGainDb=%.1f\n", params.tinnitus.hfExtGainDb);
-    fprintf(f, "binauralEnabled=%d\n", params.tinnitus.binauralEnabled ? 1 : 0);
-    fprintf(f, "binauralCarrier=%.1f\n", params.tinnitus.binauralCarrier);
-    fprintf(f, "binauralBeat=%.1f\n", params.tinnitus.binauralBeat);
-    fprintf(f, "binauralLevel=%.2f\n", params.tinnitus.binauralLevel);
+    char val[32];
+    const ProfileSchema::Field* fields = ProfileSchema::fields();
+    for (int i = 0; i < ProfileSchema::fieldCount(); i++) {
+        ProfileSchema::format(fields[i], params, val, sizeof(val));
+        fprintf(f, "%s=%s\n", fields[i].key, val);
+    }
 
     fclose(f);
     return true;
 }
 
+// One "key=value" line, split in place
+static void applyLine(char* line, AudioEngineParams& params, const char* source)
+{
+    const char* key = nullptr;
+    const char* val = nullptr;
+    if (!ProfileSchema::parseLine(line, params, &key, &val)) {
+        mclog::tagWarn(TAG, "{}: bad value for {}: '{}'", source, key, val);
+    }
+}
+
 bool ProfileManager::deserialize(const std::string& path, AudioEngineParams& params)
 {
     FILE* f = fopen(path.c_str(), "r");
@@ -132,199 +90,262 @@ bool ProfileManager::deserialize(const std::string& path, AudioEngineParams& par
     }
 
     char line[128];
-    while (fgets(line, sizeof(line), f)) {
-        // Skip comments and empty lines
-        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') continue;
-
-        // Find the '=' separator
-        char* eq = strchr(line, '=');
-        if (!eq) continue;
-
-        *eq = '\0';
-        const char* key = line;
-        const char* val = eq + 1;
-
-        // Strip trailing newline from value
-        char* nl = strchr(const_cast<char*>(val), '\n');
-        if (nl) *nl = '\0';
-        nl = strchr(const_cast<char*>(val), '\r');
-        if (nl) *nl = '\0';
-
-        // Parse each field
-        if (strcmp(key, "micGain") == 0)              params.micGain = strtof(val, nullptr);
-        else if (strcmp(key, "hpfEnabled") == 0)      params.hpfEnabled = atoi(val) != 0;
-        else if (strcmp(key, "hpfFrequency") == 0)    params.hpfFrequency = strtof(val, nullptr);
-        else if (strcmp(key, "lpfEnabled") == 0)      params.lpfEnabled = atoi(val) != 0;
-        else if (strcmp(key, "lpfFrequency") == 0)    params.lpfFrequency = strtof(val, nullptr);
-        else if (strcmp(key, "eqLowGain") == 0)       params.eqLowGain = strtof(val, nullptr);
-        else if (strcmp(key, "eqMidGain") == 0)       params.eqMidGain = strtof(val, nullptr);
-        else if (strcmp(key, "eqHighGain") == 0)      params.eqHighGain = strtof(val, nullptr);
-        else if (strcmp(key, "nsEnabled") == 0)        params.nsEnabled = atoi(val) != 0;
-        else if (strcmp(key, "nsMode") == 0)           params.nsMode = atoi(val);
-        else if (strcmp(key, "agcEnabled") == 0)       params.agcEnabled = atoi(val) != 0;
-        else if (strcmp(key, "agcMode") == 0)          params.agcMode = atoi(val);
-        else if (strcmp(key, "agcCompressionGainDb") == 0) params.agcCompressionGainDb = atoi(val);
-        else if (strcmp(key, "agcLimiterEnabled") == 0) params.agcLimiterEnabled = atoi(val) != 0;
-        else if (strcmp(key, "agcTargetLevelDbfs") == 0) params.agcTargetLevelDbfs = atoi(val);
-        else if (strcmp(key, "veEnabled") == 0)        params.veEnabled = atoi(val) != 0;
-        else if (strcmp(key, "veBlend") == 0)          params.veBlend = strtof(val, nullptr);
-        else if (strcmp(key, "veStepSize") == 0)       params.veStepSize = strtof(val, nullptr);
-        else if (strcmp(key, "veFilterLength") == 0)   params.veFilterLength = atoi(val);
-        else if (strcmp(key, "veMaxAttenuation") == 0) params.veMaxAttenuation = strtof(val, nullptr);
-        else if (strcmp(key, "veRefGain") == 0)        params.veRefGain = strtof(val, nullptr);
-        else if (strcmp(key, "veRefHpf") == 0)         params.veRefHpf = strtof(val, nullptr);
-        else if (strcmp(key, "veRefLpf") == 0)         params.veRefLpf = strtof(val, nullptr);
-        else if (strcmp(key, "veMode") == 0)           params.veMode = atoi(val);
-        else if (strcmp(key, "veAecMode") == 0)        params.veAecMode = atoi(val);
-        else if (strcmp(key, "veAecFilterLen") == 0)   params.veAecFilterLen = atoi(val);
-        else if (strcmp(key, "veVadEnabled") == 0)     params.veVadEnabled = atoi(val) != 0;
-        else if (strcmp(key, "veVadMode") == 0)        params.veVadMode = atoi(val);
-        else if (strcmp(key, "veVadGateEnabled") == 0) params.veVadGateEnabled = atoi(val) != 0;
-        else if (strcmp(key, "veVadGateAtten") == 0)   params.veVadGateAtten = strtof(val, nullptr);
-        else if (strcmp(key, "outputGain") == 0)       params.outputGain = strtof(val, nullptr);
-        else if (strcmp(key, "outputVolume") == 0)     params.outputVolume = atoi(val);
-        else if (strcmp(key, "outputMute") == 0)       params.outputMute = atoi(val) != 0;
-        else if (strcmp(key, "boostEnabled") == 0)     params.boostEnabled = atoi(val) != 0;
-        // Tinnitus relief params
-        else if (strncmp(key, "notch", 5) == 0) {
-            // Parse notch0_enabled, notch0_frequency, notch0_Q, etc.
-            int idx = key[5] - '0';
-            if (idx >= 0 && idx < 6) {
-                const char* field = key + 7;  // skip "notchN_"
-                if (strcmp(field, "enabled") == 0)   params.tinnitus.notches[idx].enabled = atoi(val) != 0;
-                else if (strcmp(field, "frequency") == 0) params.tinnitus.notches[idx].frequency = strtof(val, nullptr);
-                else if (strcmp(field, "Q") == 0)    params.tinnitus.notches[idx].Q = strtof(val, nullptr);
-            }
-        }
-        else if (strcmp(key, "noiseType") == 0)         params.tinnitus.noiseType = atoi(val);
-        else if (strcmp(key, "noiseLevel") == 0)        params.tinnitus.noiseLevel = strtof(val, nullptr);
-        else if (strcmp(key, "noiseLowCut") == 0)       params.tinnitus.noiseLowCut = strtof(val, nullptr);
-        else if (strcmp(key, "noiseHighCut") == 0)      params.tinnitus.noiseHighCut = strtof(val, nullptr);
-        else if (strcmp(key, "toneFinderEnabled") == 0) params.tinnitus.toneFinderEnabled = atoi(val) != 0;
-        else if (strcmp(key, "toneFinderFreq") == 0)    params.tinnitus.toneFinderFreq = strtof(val, nullptr);
-        else if (strcmp(key, "toneFinderLevel") == 0)   params.tinnitus.toneFinderLevel = strtof(val, nullptr);
-        else if (strcmp(key, "hfExtEnabled") == 0)      params.tinnitus.hfExtEnabled = atoi(val) != 0;
-        else if (strcmp(key, "hfExtFreq") == 0)         params.tinnitus.hfExtFreq = strtof(val, nullptr);
-        else if (strcmp(key, "hfExtGainDb") == 0)       params.tinnitus.hfExtGainDb = strtof(val, nullptr);
-        else if (strcmp(key, "binauralEnabled") == 0)   params.tinnitus.binauralEnabled = atoi(val) != 0;
-        else if (strcmp(key, "binauralCarrier") == 0)   params.tinnitus.binauralCarrier = strtof(val, nullptr);
-        else if (strcmp(key, "binauralBeat") == 0)      params.tinnitus.binauralBeat = strtof(val, nullptr);
-        else if (strcmp(key, "binauralLevel") == 0)     params.tinnitus.binauralLevel = strtof(val, nullptr);
-    }
+    while (fgets(line, sizeof(line), f)) applyLine(line, params, path.c_str());
 
     fclose(f);
     return true;
 }
 
+// Same format from memory; each line is copied out, the text itself is never written
+void ProfileManager::deserializeText(const char* text, size_t len, AudioEngineParams& params, const char* source)
+{
+    char line[128];
+    const char* end = text + len;
+    while (text < end) {
+        const char* nl = static_cast<const char*>(memchr(text, '\n', end - text));
+        const char* stop = nl ? nl : end;
+        const size_t n = std::min<size_t>(stop - text, sizeof(line) - 1);
+        memcpy(line, text, n);
+        line[n] = '\0';
+        applyLine(line, params, source);
+        text = nl ? nl + 1 : end;
+    }
+}
+
 // ─────────────────────────────────────────────────────────────────────────────
-// Public API
+// Built-in presets
+// The .hwz files under presets/ are embedded by main/CMakeLists.txt
+// (EMBED_TXTFILES, NUL-terminated) and parsed in place: the app image's
+// rodata is already mapped through the flash cache, so nothing is copied.
 // ─────────────────────────────────────────────────────────────────────────────
 
-bool ProfileManager::saveProfile(const std::string& name, const AudioEngineParams& params)
+extern const char mild_loss_hwz_start[] asm("_binary_mild_loss_hwz_start");
+extern const char mild_loss_hwz_end[] asm("_binary_mild_loss_hwz_end");
+extern const char moderate_loss_hwz_start[] asm("_binary_moderate_loss_hwz_start");
+extern const char moderate_loss_hwz_end[] asm("_binary_moderate_loss_hwz_end");
+extern const char tinnitus_relief_hwz_start[] asm("_binary_tinnitus_relief_hwz_start");
+extern const char tinnitus_relief_hwz_end[] asm("_binary_tinnitus_relief_hwz_end");
+extern const char conversation_in_noise_hwz_start[] asm("_binary_conversation_in_noise_hwz_start");
+extern const char conversation_in_noise_hwz_end[] asm("_binary_conversation_in_noise_hwz_end");
+
+struct BuiltinPreset {
+    const char* name;
+    const char* start;
+    const char* end;  // Past the NUL EMBED_TXTFILES appends
+};
+static const BuiltinPreset BUILTIN_PRESETS[] = {
+    {"Mild Loss", mild_loss_hwz_start, mild_loss_hwz_end},
+    {"Moderate Loss", moderate_loss_hwz_start, moderate_loss_hwz_end},
+    {"Tinnitus Relief", tinnitus_relief_hwz_start, tinnitus_relief_hwz_end},
+    {"Conversation in Noise", conversation_in_noise_hwz_start, conversation_in_noise_hwz_end},
+};
+
+static const BuiltinPreset* findBuiltin(const std::string& name)
 {
-    if (!mountSd()) return false;
-    if (!ensureDirectory()) { unmountSd(); return false; }
-
-    std::string path = profilePath(name);
-    bool ok = serialize(path, params);
-
-    if (ok) {
-        mclog::tagInfo(TAG, "saved profile: {}", name);
+    for (const auto& b : BUILTIN_PRESETS) {
+        if (name == b.name) return &b;
     }
+    return nullptr;
+}
 
-    unmountSd();
-    return ok;
+std::vector<std::string> ProfileManager::listBuiltinPresets()
+{
+    std::vector<std::string> names;
+    for (const auto& b : BUILTIN_PRESETS) names.emplace_back(b.name);
+    return names;
 }
 
-bool ProfileManager::loadProfile(const std::string& name, AudioEngineParams& params)
+bool ProfileManager::isBuiltinPreset(const std::string& name)
 {
-    if (!mountSd()) return false;
+    return findBuiltin(name) != nullptr;
+}
 
-    std::string path = profilePath(name);
-    bool ok = deserialize(path, params);
+bool ProfileManager::loadBuiltinPreset(const std::string& name, AudioEngineParams& params)
+{
+    const BuiltinPreset* b = findBuiltin(name);
+    if (!b) return false;
+    params = AudioEngineParams{};
+    deserializeText(b->start, b->end - b->start - 1, params, b->name);
+    mclog::tagInfo(TAG, "loaded built-in preset: {}", name);
+    return true;
+}
 
-    if (ok) {
-        mclog::tagInfo(TAG, "loaded profile: {}", name);
+// ─────────────────────────────────────────────────────────────────────────────
+// Binary copy (.hwb)
+// ─────────────────────────────────────────────────────────────────────────────
+
+struct BinaryHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;  // (tag, value) records after the header
+    uint32_t crc;    // CRC32 of the records
+};
+static constexpr uint16_t MAX_BINARY_RECORDS = 1024;
+
+bool ProfileManager::serializeBinary(const std::string& name, const AudioEngineParams& params)
+{
+    std::vector<uint32_t> records;
+    ProfileSchema::encode(params, records);
+    const size_t bytes = records.size() * sizeof(uint32_t);
+    const BinaryHeader header{BINARY_MAGIC, BINARY_VERSION, static_cast<uint16_t>(records.size() / 2),
+                              esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(records.data()), bytes)};
+
+    const std::string tmp = profilePath(name, TEMP_EXT);
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) {
+        mclog::tagError(TAG, "failed to open for write: {}", tmp);
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 && fwrite(records.data(), bytes, 1, f) == 1;
+    ok = ok && fflush(f) == 0 && fsync(fileno(f)) == 0;
+    fclose(f);
+    if (!ok) {
+        mclog::tagError(TAG, "short write: {}", tmp);
+        remove(tmp.c_str());
+        return false;
     }
 
-    unmountSd();
-    return ok;
+    // FATFS can't rename over a file; a cut between these two leaves the .tmp for rebuildIndex
+    const std::string bin = profilePath(name, BINARY_EXT);
+    remove(bin.c_str());
+    if (rename(tmp.c_str(), bin.c_str()) != 0) {
+        mclog::tagError(TAG, "failed to replace {}", bin);
+        return false;
+    }
+    return true;
 }
 
-bool ProfileManager::deleteProfile(const std::string& name)
+bool ProfileManager::deserializeBinary(const std::string& path, AudioEngineParams& params)
 {
-    if (!mountSd()) return false;
-
-    std::string path = profilePath(name);
-    int rc = remove(path.c_str());
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
 
-    if (rc == 0) {
-        mclog::tagInfo(TAG, "deleted profile: {}", name);
-    } else {
-        mclog::tagError(TAG, "failed to delete: {}", name);
+    BinaryHeader header;
+    std::vector<uint32_t> records;
+    bool ok = fread(&header, sizeof(header), 1, f) == 1 && header.magic == BINARY_MAGIC &&
+              header.version >= 1 && header.version <= BINARY_VERSION && header.count <= MAX_BINARY_RECORDS;
+    if (ok) {
+        records.resize(2 * header.count);
+        ok = fread(records.data(), sizeof(uint32_t), records.size(), f) == records.size();
+    }
+    fclose(f);
+    const size_t bytes = records.size() * sizeof(uint32_t);
+    if (!ok || esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(records.data()), bytes) != header.crc) {
+        mclog::tagWarn(TAG, "{}: damaged or unsupported binary profile", path);
+        return false;
     }
 
-    unmountSd();
-    return rc == 0;
+    ProfileSchema::decode(records.data(), header.count, params);
+    return true;
 }
 
-std::vector<std::string> ProfileManager::listProfiles()
+// ─────────────────────────────────────────────────────────────────────────────
+// In-RAM index
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool ProfileManager::ensureIndex()
 {
-    std::vector<std::string> names;
+    auto& sd = SdStorage::getInstance();
+    if (!sd.mount()) {
+        _index.clear();
+        _defaultName.clear();
+        _indexGeneration = 0;
+        return false;
+    }
+    if (_indexGeneration != sd.generation()) rebuildIndex();
+    return true;
+}
 
-    if (!mountSd()) return names;
+void ProfileManager::rebuildIndex()
+{
+    _index.clear();
+    _indexGeneration = SdStorage::getInstance().generation();
     ensureDirectory();
+    _defaultName = readDefaultName();
 
-    DIR* dir = opendir(PROFILES_DIR);
-    if (!dir) {
-        mclog::tagError(TAG, "failed to open profiles dir");
-        unmountSd();
-        return names;
+    // Profile names from any of the three files, skipping hidden files. The
+    // scan hands out names in a fixed buffer; a string is only made once per
+    // profile, kept sorted so the other two files of a profile are found fast.
+    std::vector<std::string> names;
+    auto visit = [](const SdDirEntry& entry, void* user) {
+        auto& names = *static_cast<std::vector<std::string>*>(user);
+        const size_t len = strlen(entry.name);
+        if (entry.isDir || len <= 4 || entry.name[0] == '.') return true;
+        const char* ext = entry.name + len - 4;
+        if (strcmp(ext, FILE_EXT) != 0 && strcmp(ext, BINARY_EXT) != 0 && strcmp(ext, TEMP_EXT) != 0) return true;
+        const std::string_view name(entry.name, len - 4);
+        auto at = std::lower_bound(names.begin(), names.end(), name,
+                                   [](const std::string& a, std::string_view b) { return a < b; });
+        if (at == names.end() || *at != name) names.emplace(at, name);
+        return true;
+    };
+    SdStorage::scanDir(PROFILES_DIR, visit, &names);
+
+    _index.reserve(names.size());
+    _indexProgress.store(0, std::memory_order_relaxed);
+    for (auto& name : names) {
+        Entry e;
+        if (loadEntry(name, e)) _index.push_back(std::move(e));
+        _indexProgress.fetch_add(1, std::memory_order_relaxed);
     }
+    _indexProgress.store(0, std::memory_order_relaxed);
 
-    struct dirent* entry;
-    while ((entry = readdir(dir)) != nullptr) {
-        if (entry->d_type != DT_REG) continue;
-
-        std::string fname = entry->d_name;
-        // Filter .hwz files, skip hidden files
-        if (fname.size() > 4 && fname[0] != '.' &&
-            fname.substr(fname.size() - 4) == FILE_EXT) {
-            names.push_back(fname.substr(0, fname.size() - 4));
-        }
-    }
+    mclog::tagInfo(TAG, "indexed {} profile(s), default '{}'", _index.size(), _defaultName);
+}
 
-    closedir(dir);
-    unmountSd();
-    return names;
+size_t ProfileManager::indexProgress()
+{
+    return _indexProgress.load(std::memory_order_relaxed);
 }
 
-bool ProfileManager::setDefaultProfile(const std::string& name)
+// Parsed over the defaults, so keys a file lacks load as defaults
+bool ProfileManager::loadEntry(const std::string& name, Entry& e)
 {
-    if (!mountSd()) return false;
-    if (!ensureDirectory()) { unmountSd(); return false; }
+    e.name = name;
+    const std::string text = profilePath(name);
+    const std::string bin = profilePath(name, BINARY_EXT);
+    const std::string tmp = profilePath(name, TEMP_EXT);
+    struct stat st;
 
-    FILE* f = fopen(DEFAULT_FILE, "w");
-    if (!f) {
-        mclog::tagError(TAG, "failed to write default file");
-        unmountSd();
-        return false;
+    bool hasBin = stat(bin.c_str(), &st) == 0;
+    time_t binTime = hasBin ? st.st_mtime : 0;
+    if (!hasBin && stat(tmp.c_str(), &st) == 0) {
+        // Cut between removing the old .hwb and the rename: the new copy is complete if its CRC holds
+        AudioEngineParams probe;
+        if (deserializeBinary(tmp, probe) && rename(tmp.c_str(), bin.c_str()) == 0) {
+            mclog::tagWarn(TAG, "recovered binary profile: {}", name);
+            hasBin = true;
+            binTime = st.st_mtime;
+        }
     }
+    const bool hasText = stat(text.c_str(), &st) == 0;
+    const time_t textTime = hasText ? st.st_mtime : 0;
 
-    fprintf(f, "%s\n", name.c_str());
-    fclose(f);
+    if (hasBin && (!hasText || binTime >= textTime) && deserializeBinary(bin, e.params)) {
+        e.mtime = binTime;
+        return true;
+    }
+    if (!hasText || !deserialize(text, e.params)) return false;
+    e.mtime = textTime;
 
-    mclog::tagInfo(TAG, "default profile set: {}", name);
-    unmountSd();
+    // Imported (new, edited or the binary copy was bad): give it a fresh binary copy
+    auto* w = new PendingWrite{name, e.params, false};
+    if (!SdStorage::getInstance().post(writeProfileJob, w)) delete w;
+    mclog::tagInfo(TAG, "imported text profile: {}", name);
     return true;
 }
 
-std::string ProfileManager::getDefaultProfile()
+ProfileManager::Entry* ProfileManager::findEntry(const std::string& name)
 {
-    std::string result;
-
-    if (!mountSd()) return result;
+    for (auto& e : _index) {
+        if (e.name == name) return &e;
+    }
+    return nullptr;
+}
 
+std::string ProfileManager::readDefaultName()
+{
+    std::string result;
     FILE* f = fopen(DEFAULT_FILE, "r");
     if (f) {
         char buf[128];
@@ -338,73 +359,292 @@ std::string ProfileManager::getDefaultProfile()
         }
         fclose(f);
     }
-
-    unmountSd();
     return result;
 }
 
-bool ProfileManager::loadDefaultProfile(AudioEngineParams& params)
+// ─────────────────────────────────────────────────────────────────────────────
+// Queued writes (storage task)
+// ─────────────────────────────────────────────────────────────────────────────
+
+void ProfileManager::writeProfileJob(void* arg)
 {
-    if (!mountSd()) return false;
-    ensureDirectory();
+    std::unique_ptr<PendingWrite> w(static_cast<PendingWrite*>(arg));
+    if (!SdStorage::getInstance().mount() || !ensureDirectory()) {
+        mclog::tagError(TAG, "profile '{}' not written: SD card unavailable", w->name);
+        return;
+    }
+    // Text export first, so the binary copy is never the older one
+    if (w->exportText && !serialize(profilePath(w->name), w->params)) return;
+    if (serializeBinary(w->name, w->params)) {
+        mclog::tagInfo(TAG, "saved profile: {}", w->name);
+    }
+}
 
-    // Read default profile name
-    FILE* f = fopen(DEFAULT_FILE, "r");
+void ProfileManager::deleteProfileJob(void* arg)
+{
+    std::unique_ptr<std::string> name(static_cast<std::string*>(arg));
+    if (!SdStorage::getInstance().mount()) {
+        mclog::tagError(TAG, "profile '{}' not deleted: SD card unavailable", *name);
+        return;
+    }
+    const bool text = remove(profilePath(*name).c_str()) == 0;
+    const bool bin = remove(profilePath(*name, BINARY_EXT).c_str()) == 0;
+    remove(profilePath(*name, TEMP_EXT).c_str());
+    if (text || bin) {
+        mclog::tagInfo(TAG, "deleted profile: {}", *name);
+    } else {
+        mclog::tagError(TAG, "failed to delete: {}", *name);
+    }
+}
+
+void ProfileManager::writeDefaultJob(void* arg)
+{
+    std::unique_ptr<std::string> name(static_cast<std::string*>(arg));
+    if (!SdStorage::getInstance().mount() || !ensureDirectory()) {
+        mclog::tagError(TAG, "default profile not written: SD card unavailable");
+        return;
+    }
+    FILE* f = fopen(DEFAULT_FILE, "w");
     if (!f) {
-        mclog::tagInfo(TAG, "no default profile configured");
-        unmountSd();
-        return false;
+        mclog::tagError(TAG, "failed to write default file");
+        return;
     }
+    fprintf(f, "%s\n", name->c_str());
+    fclose(f);
+    mclog::tagInfo(TAG, "default profile set: {}", *name);
+}
 
-    char buf[128];
-    if (!fgets(buf, sizeof(buf), f)) {
-        fclose(f);
-        unmountSd();
+// ─────────────────────────────────────────────────────────────────────────────
+// Public API
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool ProfileManager::saveProfile(const std::string& name, const AudioEngineParams& params)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!ensureIndex()) return false;
+
+    auto* w = new PendingWrite{name, params};
+    if (!SdStorage::getInstance().post(writeProfileJob, w)) {
+        delete w;
         return false;
     }
-    fclose(f);
 
-    // Strip newline
-    char* nl = strchr(buf, '\n');
-    if (nl) *nl = '\0';
-    nl = strchr(buf, '\r');
-    if (nl) *nl = '\0';
+    Entry* e = findEntry(name);
+    if (!e) {
+        _index.push_back(Entry{});
+        e = &_index.back();
+        e->name = name;
+    }
+    e->params = params;
+    e->mtime = time(nullptr);
+    return true;
+}
 
-    if (strlen(buf) == 0) {
-        unmountSd();
+bool ProfileManager::loadProfile(const std::string& name, AudioEngineParams& params)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    const Entry* e = ensureIndex() ? findEntry(name) : nullptr;
+    if (!e) {
+        if (loadBuiltinPreset(name, params)) return true;
+        mclog::tagError(TAG, "no such profile: {}", name);
         return false;
     }
+    params = e->params;
+    mclog::tagInfo(TAG, "loaded profile: {}", name);
+    return true;
+}
 
-    std::string name = buf;
-    std::string path = profilePath(name);
-    bool ok = deserialize(path, params);
+bool ProfileManager::deleteProfile(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!ensureIndex()) return false;
+
+    const Entry* e = findEntry(name);
+    if (!e) {
+        if (isBuiltinPreset(name)) {
+            mclog::tagWarn(TAG, "built-in preset '{}' is read-only", name);
+        } else {
+            mclog::tagError(TAG, "failed to delete: {}", name);
+        }
+        return false;
+    }
+    auto* arg = new std::string(name);
+    if (!SdStorage::getInstance().post(deleteProfileJob, arg)) {
+        delete arg;
+        return false;
+    }
+    _index.erase(_index.begin() + (e - _index.data()));
+    return true;
+}
 
-    if (ok) {
-        mclog::tagInfo(TAG, "auto-loaded default profile: {}", name);
-    } else {
-        mclog::tagWarn(TAG, "default profile '{}' not found", name);
+std::vector<std::string> ProfileManager::listProfiles(size_t* builtinCount)
+{
+    std::vector<std::string> names;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (ensureIndex()) {
+        names.reserve(_index.size() + std::size(BUILTIN_PRESETS));
+        for (const auto& e : _index) names.push_back(e.name);
     }
 
-    unmountSd();
-    return ok;
+    // Presets after the card's profiles; an SD profile of the same name shadows one
+    size_t builtins = 0;
+    for (const auto& b : BUILTIN_PRESETS) {
+        if (findEntry(b.name)) continue;
+        names.emplace_back(b.name);
+        builtins++;
+    }
+    if (builtinCount) *builtinCount = builtins;
+    return names;
 }
 
-bool ProfileManager::isSdCardAccessible()
+bool ProfileManager::setDefaultProfile(const std::string& name)
 {
-    if (!mountSd()) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!ensureIndex()) return false;
+
+    auto* arg = new std::string(name);
+    if (!SdStorage::getInstance().post(writeDefaultJob, arg)) {
+        delete arg;
         return false;
     }
-    unmountSd();
+    _defaultName = name;
     return true;
 }
 
+std::string ProfileManager::getDefaultProfile()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!ensureIndex()) return std::string();
+    return _defaultName;
+}
+
+bool ProfileManager::loadDefaultProfile(AudioEngineParams& params)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!ensureIndex()) return false;
+
+    if (_defaultName.empty()) {
+        mclog::tagInfo(TAG, "no default profile configured");
+        return false;
+    }
+    const Entry* e = findEntry(_defaultName);
+    if (!e) {
+        if (loadBuiltinPreset(_defaultName, params)) return true;
+        mclog::tagWarn(TAG, "default profile '{}' not found", _defaultName);
+        return false;
+    }
+    params = e->params;
+    mclog::tagInfo(TAG, "auto-loaded default profile: {}", _defaultName);
+    return true;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Correction impulse responses (WAV)
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool ProfileManager::loadImpulseResponse(int number, std::vector<float>& left, std::vector<float>& right)
+{
+    if (!SdStorage::getInstance().mount()) {
+        mclog::tagError(TAG, "IR {} not loaded: SD card unavailable", number);
+        return false;
+    }
+    const std::string path = std::string(IR_DIR) + "/" + std::to_string(number) + ".wav";
+    std::unique_ptr<FILE, int (*)(FILE*)> f(fopen(path.c_str(), "rb"), fclose);
+    if (!f) {
+        mclog::tagWarn(TAG, "no correction IR at {}", path);
+        return false;
+    }
+    auto u16 = [](const uint8_t* p) { return static_cast<uint32_t>(p[0] | p[1] << 8); };
+    auto u32 = [](const uint8_t* p) { return static_cast<uint32_t>(p[0] | p[1] << 8 | p[2] << 16 | p[3] << 24); };
+
+    uint8_t riff[12];
+    if (fread(riff, 1, sizeof(riff), f.get()) != sizeof(riff) || memcmp(riff, "RIFF", 4) != 0 ||
+        memcmp(riff + 8, "WAVE", 4) != 0) {
+        mclog::tagError(TAG, "{}: not a WAV file", path);
+        return false;
+    }
+    // fmt, then data; anything else (LIST, fact, JUNK) is skipped
+    uint32_t format = 0, channels = 0, rate = 0, bits = 0, dataBytes = 0;
+    for (;;) {
+        uint8_t chunk[8];
+        if (fread(chunk, 1, sizeof(chunk), f.get()) != sizeof(chunk)) {
+            mclog::tagError(TAG, "{}: no data chunk", path);
+            return false;
+        }
+        const uint32_t size = u32(chunk + 4);
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16 && size <= 64) {
+            uint8_t fmt[64];
+            if (fread(fmt, 1, size, f.get()) != size) return false;
+            format = u16(fmt);
+            channels = u16(fmt + 2);
+            rate = u32(fmt + 4);
+            bits = u16(fmt + 14);
+            if (format == 0xFFFE && size >= 26) format = u16(fmt + 24);  // WAVE_FORMAT_EXTENSIBLE sub-format
+            if ((size & 1) && fseek(f.get(), 1, SEEK_CUR) != 0) return false;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            dataBytes = size;
+            break;
+        } else if (fseek(f.get(), size + (size & 1), SEEK_CUR) != 0) {
+            return false;  // Chunks are word-aligned
+        }
+    }
+    const bool pcm = format == 1 && (bits == 16 || bits == 24 || bits == 32);
+    const bool ieee = format == 3 && bits == 32;
+    if ((!pcm && !ieee) || (channels != 1 && channels != 2) || rate != 48000) {
+        mclog::tagError(TAG, "{}: need 48 kHz mono/stereo PCM or float, got format {} {} ch {} Hz {} bit", path,
+            format, channels, rate, bits);
+        return false;
+    }
+
+    const uint32_t frameBytes = channels * bits / 8;
+    uint32_t frames = dataBytes / frameBytes;
+    if (frames > static_cast<uint32_t>(MAX_IR_TAPS)) {
+        mclog::tagWarn(TAG, "{}: {} taps, cut to {}", path, frames, MAX_IR_TAPS);
+        frames = MAX_IR_TAPS;
+    }
+    if (frames == 0) return false;
+    std::vector<uint8_t> raw(static_cast<size_t>(frames) * frameBytes);
+    if (fread(raw.data(), 1, raw.size(), f.get()) != raw.size()) {
+        mclog::tagError(TAG, "{}: short read", path);
+        return false;
+    }
+    auto sample = [&](const uint8_t* p) {
+        if (ieee) {
+            float v;
+            memcpy(&v, p, sizeof(v));
+            return v;
+        }
+        switch (bits) {
+            case 16: return static_cast<int16_t>(u16(p)) * (1.0f / 32768.0f);
+            case 24: return static_cast<int32_t>(u16(p) << 8 | static_cast<uint32_t>(p[2]) << 24) * (1.0f / 2147483648.0f);
+            default: return static_cast<int32_t>(u32(p)) * (1.0f / 2147483648.0f);
+        }
+    };
+    left.resize(frames);
+    right.resize(frames);
+    const uint32_t step = bits / 8;
+    for (uint32_t i = 0; i < frames; i++) {
+        const uint8_t* p = &raw[static_cast<size_t>(i) * frameBytes];
+        left[i] = sample(p);
+        right[i] = channels == 2 ? sample(p + step) : left[i];
+    }
+    mclog::tagInfo(TAG, "correction IR {}: {} taps, {}", number, frames, channels == 2 ? "stereo" : "mono");
+    return true;
+}
+
+bool ProfileManager::isSdCardAccessible()
+{
+    return SdStorage::getInstance().mount();
+}
+
 bool ProfileManager::formatSdCard()
 {
     // Note: Formatting requires unmounting first, then using FATFS formatting
     // For now, just try to mount and create the profiles directory
     mclog::tagInfo(TAG, "attempting to prepare SD card...");
 
-    if (!mountSd()) {
+    if (!SdStorage::getInstance().mount()) {
         mclog::tagError(TAG, "cannot mount SD card for formatting");
         return false;
     }
@@ -412,8 +652,6 @@ bool ProfileManager::formatSdCard()
     // Try to create the profiles directory
     bool ok = ensureDirectory();
 
-    unmountSd();
-
     if (ok) {
         mclog::tagInfo(TAG, "SD card prepared successfully");
     }
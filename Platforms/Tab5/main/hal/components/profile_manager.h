@@ -5,6 +5,9 @@
  */
 #pragma once
 #include "audio_engine.h"
+#include <atomic>
+#include <ctime>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -12,18 +15,40 @@
  * @brief Profile save/load manager for Howizard audio settings
  *
  * Stores profiles as key=value text files on SD card at /sd/Profiles/<name>.hwz
- * Mounts/unmounts SD per operation following existing BSP pattern.
+ * plus a binary copy, <name>.hwb: a header with magic, schema version, record
+ * count and the CRC32 of the (tag, value) word pairs that follow, one pair per
+ * ProfileSchema field. The device reads the binary copy; the text file is the
+ * editable export and wins when it is newer (edited on a PC) or the binary copy
+ * is missing or fails its CRC. Binary writes go to <name>.tmp, fsync, then
+ * replace the old .hwb; a .tmp left without a .hwb by a power cut is promoted
+ * on the next index read if its CRC holds.
+ * The card stays mounted (SdStorage). The first call after a mount reads every
+ * profile into an in-RAM index (name, mtime, parsed params) plus the default
+ * name; list/load/getDefault are then memory operations. Save, delete and
+ * setDefault update the index at once and queue the file write on the storage
+ * task, so their result means "accepted", not "on the card".
+ *
+ * A few read-only presets are built into the firmware (the .hwz files in
+ * presets/) and need no card. They list after the SD profiles, load and act
+ * as the default like one, and cannot be deleted; an SD profile saved under
+ * a preset's name shadows it.
  */
 class ProfileManager {
 public:
     static constexpr const char* PROFILES_DIR = "/sd/Profiles";
     static constexpr const char* DEFAULT_FILE = "/sd/Profiles/.default";
     static constexpr const char* FILE_EXT = ".hwz";
+    static constexpr const char* BINARY_EXT = ".hwb";
+    static constexpr const char* TEMP_EXT = ".tmp";
+    static constexpr uint32_t BINARY_MAGIC = 0x425A5748;  // "HWZB" little-endian
+    static constexpr uint16_t BINARY_VERSION = 1;        // Record layout; new fields only add tags
     static constexpr const char* FILE_HEADER = "# Howizard Audio Profile v1";
+    static constexpr const char* IR_DIR = "/sd/Profiles/IR";  // Correction FIRs, <fir_ir>.wav
+    static constexpr int MAX_IR_TAPS = 2048;
 
     /**
      * @brief Save current params to a named profile on SD card
-     * @return true on success
+     * @return true if the profile was indexed and its write queued
      */
     static bool saveProfile(const std::string& name, const AudioEngineParams& params);
 
@@ -40,10 +65,18 @@ public:
     static bool deleteProfile(const std::string& name);
 
     /**
-     * @brief List all available profile names on SD card
-     * @return vector of profile names (without extension)
+     * @brief List SD card profiles, then the built-in presets they don't shadow
+     * @param builtinCount if set, receives how many trailing names are built-in
+     * @return vector of profile names (without extension); presets only without a card
      */
-    static std::vector<std::string> listProfiles();
+    static std::vector<std::string> listProfiles(size_t* builtinCount = nullptr);
+
+    /**
+     * @brief Read-only presets compiled into the firmware, usable without an SD card
+     */
+    static std::vector<std::string> listBuiltinPresets();
+    static bool isBuiltinPreset(const std::string& name);
+    static bool loadBuiltinPreset(const std::string& name, AudioEngineParams& params);
 
     /**
      * @brief Set a profile as the default (auto-loaded on boot)
@@ -58,14 +91,27 @@ public:
     static std::string getDefaultProfile();
 
     /**
-     * @brief Full cycle: mount SD, read default name, load profile, unmount
+     * @brief Load the default profile, if one is set and present
      * @return true if a default profile was loaded
      */
     static bool loadDefaultProfile(AudioEngineParams& params);
 
+    /**
+     * @brief Profiles read so far by an index rebuild in progress (0 when none is)
+     */
+    static size_t indexProgress();
+
+    /**
+     * @brief Read correction impulse response <number>.wav from IR_DIR (the fir_ir field)
+     * 48 kHz WAV, 16/24/32-bit PCM or 32-bit float, mono (both ears) or stereo (left, right).
+     * An IR longer than MAX_IR_TAPS is cut there. Reads the card: storage task only.
+     * @return true with left and right the same, nonzero length
+     */
+    static bool loadImpulseResponse(int number, std::vector<float>& left, std::vector<float>& right);
+
     /**
      * @brief Check if SD card is accessible
-     * @return true if SD card can be mounted
+     * @return true if SD card is (or can be) mounted
      */
     static bool isSdCardAccessible();
 
@@ -76,10 +122,38 @@ public:
     static bool formatSdCard();
 
 private:
-    static bool mountSd();
-    static void unmountSd();
+    struct Entry {
+        std::string name;
+        time_t mtime = 0;
+        AudioEngineParams params;
+    };
+
+    // Queued file operations, run on the storage task
+    struct PendingWrite {
+        std::string name;
+        AudioEngineParams params;
+        bool exportText = true;  // false: refresh only the binary copy of an imported text file
+    };
+    static void writeProfileJob(void* arg);
+    static void deleteProfileJob(void* arg);
+    static void writeDefaultJob(void* arg);
+
+    static bool ensureIndex();  // Caller holds _mutex
+    static void rebuildIndex();
+    static Entry* findEntry(const std::string& name);
+    static std::string readDefaultName();
     static bool ensureDirectory();
-    static std::string profilePath(const std::string& name);
+    static std::string profilePath(const std::string& name, const char* ext = FILE_EXT);
     static bool serialize(const std::string& path, const AudioEngineParams& params);
     static bool deserialize(const std::string& path, AudioEngineParams& params);
+    static void deserializeText(const char* text, size_t len, AudioEngineParams& params, const char* source);
+    static bool serializeBinary(const std::string& name, const AudioEngineParams& params);  // Atomic
+    static bool deserializeBinary(const std::string& path, AudioEngineParams& params);
+    static bool loadEntry(const std::string& name, Entry& e);
+
+    static std::mutex _mutex;  // Index
+    static std::vector<Entry> _index;
+    static std::string _defaultName;
+    static uint32_t _indexGeneration;  // SdStorage generation the index was read from; 0 = none
+    static std::atomic<size_t> _indexProgress;  // Read without _mutex, by the UI
 };
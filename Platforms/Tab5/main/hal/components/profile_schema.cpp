@@ -0,0 +1,415 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "profile_schema.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+
+using Field = ProfileSchema::Field;
+using Type = ProfileSchema::Type;
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Field table (file order; ranges are the engine setters' clamp bounds)
+// ─────────────────────────────────────────────────────────────────────────────
+
+#define F_OFF(member) static_cast<uint16_t>(offsetof(AudioEngineParams, member))
+#define F_TAG(key) ProfileSchema::keyTag(key)
+#define F_BOOL(key, member)               {key, Type::BOOL, 0, F_OFF(member), 1.0f, 0.0f, F_TAG(key)}
+#define F_INT(key, member, lo, hi)        {key, Type::INT, 0, F_OFF(member), lo, hi, F_TAG(key)}
+#define F_INT_ANY(key, member)            {key, Type::INT, 0, F_OFF(member), 1.0f, 0.0f, F_TAG(key)}
+#define F_FLOAT(key, member, dec, lo, hi) {key, Type::FLOAT, dec, F_OFF(member), lo, hi, F_TAG(key)}
+
+#define MBC_BAND(i)                                                                     \
+    F_FLOAT("mbcBand" #i "_threshold", dynamics.bands[i].thresholdDb, 1, -60.0f, 0.0f), \
+    F_FLOAT("mbcBand" #i "_ratio", dynamics.bands[i].ratio, 2, 1.0f, 20.0f),           \
+    F_FLOAT("mbcBand" #i "_attack", dynamics.bands[i].attackMs, 1, 0.1f, 100.0f),      \
+    F_FLOAT("mbcBand" #i "_release", dynamics.bands[i].releaseMs, 1, 10.0f, 2000.0f),  \
+    F_FLOAT("mbcBand" #i "_makeup", dynamics.bands[i].makeupDb, 1, 0.0f, 24.0f)
+
+// Audiogram keys carry the test frequency
+#define AUDIOGRAM(i, hz)                                                          \
+    F_FLOAT("audiogramL_" #hz, fitting.audiogramL[i], 1, -10.0f, 120.0f),         \
+    F_FLOAT("audiogramR_" #hz, fitting.audiogramR[i], 1, -10.0f, 120.0f)
+
+#define NOTCH(i)                                                                         \
+    F_BOOL("notch" #i "_enabled", tinnitus.notches[i].enabled),                          \
+    F_FLOAT("notch" #i "_frequency", tinnitus.notches[i].frequency, 1, 500.0f, 12000.0f), \
+    F_FLOAT("notch" #i "_Q", tinnitus.notches[i].Q, 1, 1.0f, 16.0f)
+
+// The right ear's notches; the notchN keys are the left ear's (both ears', while linked)
+#define RIGHT_NOTCH(i)                                                                            \
+    F_BOOL("rightNotch" #i "_enabled", rightEar.notches[i].enabled),                              \
+    F_FLOAT("rightNotch" #i "_frequency", rightEar.notches[i].frequency, 1, 500.0f, 12000.0f),    \
+    F_FLOAT("rightNotch" #i "_Q", rightEar.notches[i].Q, 1, 1.0f, 16.0f)
+
+static constexpr Field FIELDS[] = {
+    F_FLOAT("micGain", micGain, 1, 0.0f, 240.0f),
+    F_INT_ANY("captureBits", captureBits),
+    F_INT("beamMode", beamMode, 0, 2),
+    F_FLOAT("beamSteerDeg", beamSteerDeg, 1, -90.0f, 90.0f),
+    F_FLOAT("beamMicSpacingMm", beamMicSpacingMm, 1, 10.0f, 150.0f),
+    F_INT("windMode", windMode, 0, 2),
+    F_FLOAT("windHpfMaxHz", windHpfMaxHz, 0, 100.0f, 500.0f),
+    F_BOOL("hpfEnabled", hpfEnabled),
+    F_FLOAT("hpfFrequency", hpfFrequency, 1, 20.0f, 2000.0f),
+    F_BOOL("lpfEnabled", lpfEnabled),
+    F_FLOAT("lpfFrequency", lpfFrequency, 1, 500.0f, 20000.0f),
+    F_FLOAT("eqLowGain", eqLowGain, 1, -12.0f, 12.0f),
+    F_FLOAT("eqMidGain", eqMidGain, 1, -12.0f, 12.0f),
+    F_FLOAT("eqHighGain", eqHighGain, 1, -12.0f, 12.0f),
+    F_BOOL("nsEnabled", nsEnabled),
+    F_INT("nsMode", nsMode, 0, 2),
+    F_BOOL("nsLinked", nsLinked),
+    F_BOOL("agcEnabled", agcEnabled),
+    F_INT("agcMode", agcMode, 0, 3),
+    F_INT("agcCompressionGainDb", agcCompressionGainDb, 0, 90),
+    F_BOOL("agcLimiterEnabled", agcLimiterEnabled),
+    F_INT("agcTargetLevelDbfs", agcTargetLevelDbfs, -31, 0),
+    F_BOOL("agcLinked", agcLinked),
+    F_BOOL("veEnabled", veEnabled),
+    F_FLOAT("veBlend", veBlend, 2, 0.0f, 1.0f),
+    F_FLOAT("veStepSize", veStepSize, 2, 0.01f, 1.0f),
+    F_INT("veFilterLength", veFilterLength, 16, 2048),  // AudioEngine::FDAF_MAX_TAPS
+    F_FLOAT("veMaxAttenuation", veMaxAttenuation, 2, 0.0f, 1.0f),
+    F_FLOAT("veRefGain", veRefGain, 2, 0.1f, 5.0f),
+    F_FLOAT("veRefHpf", veRefHpf, 1, 20.0f, 500.0f),
+    F_FLOAT("veRefLpf", veRefLpf, 1, 1000.0f, 8000.0f),
+    F_INT("veMode", veMode, 0, 3),
+    F_INT_ANY("veAecMode", veAecMode),
+    F_INT("veAecFilterLen", veAecFilterLen, 1, 6),
+    F_BOOL("veAecShared", veAecShared),
+    F_BOOL("veVadEnabled", veVadEnabled),
+    F_INT("veVadMode", veVadMode, 0, 4),
+    F_BOOL("veVadGateEnabled", veVadGateEnabled),
+    F_FLOAT("veVadGateAtten", veVadGateAtten, 2, 0.0f, 1.0f),
+    F_FLOAT("ownVoiceRatioDb", ownVoiceRatioDb, 1, 0.0f, 20.0f),
+    F_FLOAT("ownVoiceDuckDb", ownVoiceDuckDb, 1, 0.0f, 12.0f),
+    F_BOOL("fbcEnabled", fbcEnabled),
+    F_INT("fbcFilterLength", fbcFilterLength, 32, 512),  // AudioEngine::FBC_MAX_TAPS
+    F_FLOAT("fbcStepSize", fbcStepSize, 4, 0.0005f, 0.05f),
+    F_FLOAT("fbcShiftHz", fbcShiftHz, 1, 0.0f, 20.0f),
+    F_BOOL("howlSuppression", howlSuppression),
+    F_FLOAT("outputGain", outputGain, 2, 0.0f, 6.0f),
+    F_INT("outputVolume", outputVolume, 0, 100),
+    F_BOOL("outputMute", outputMute),
+    F_BOOL("boostEnabled", boostEnabled),
+    F_BOOL("firEnabled", firEnabled),
+    F_INT("firIr", firIr, 1, 99),
+    F_INT("doseMode", doseMode, 0, 2),
+    F_INT("doseWeighting", doseWeighting, 0, 1),
+    // Snapped to allowed values by the engine, not clamped
+    F_INT_ANY("blockSize", blockSize),
+    F_INT_ANY("sampleRate", sampleRate),
+    F_INT_ANY("spectralFftSize", spectralFftSize),
+    F_INT_ANY("spectralHop", spectralHop),
+    F_INT("earSplit", earSplit, 0, 2),
+    F_BOOL("busBandSplit", busBandSplit),
+    F_BOOL("busAfe", busAfe),
+    F_BOOL("quietPathEnabled", quietPathEnabled),
+    F_FLOAT("quietThresholdDb", quietThresholdDb, 1, -90.0f, -30.0f),
+    F_INT("quietHoldMs", quietHoldMs, 100, 10000),
+    F_BOOL("sceneAuto", sceneAuto),
+    F_FLOAT("sceneQuietDb", sceneQuietDb, 1, -80.0f, -20.0f),
+
+    // Right ear
+    F_BOOL("earsLinked", earsLinked),
+    F_BOOL("rightHpfEnabled", rightEar.hpfEnabled),
+    F_FLOAT("rightHpfFrequency", rightEar.hpfFrequency, 1, 20.0f, 2000.0f),
+    F_BOOL("rightLpfEnabled", rightEar.lpfEnabled),
+    F_FLOAT("rightLpfFrequency", rightEar.lpfFrequency, 1, 500.0f, 20000.0f),
+    F_FLOAT("rightEqLowGain", rightEar.eqLowGain, 1, -12.0f, 12.0f),
+    F_FLOAT("rightEqMidGain", rightEar.eqMidGain, 1, -12.0f, 12.0f),
+    F_FLOAT("rightEqHighGain", rightEar.eqHighGain, 1, -12.0f, 12.0f),
+    RIGHT_NOTCH(0),
+    RIGHT_NOTCH(1),
+    RIGHT_NOTCH(2),
+    RIGHT_NOTCH(3),
+    RIGHT_NOTCH(4),
+    RIGHT_NOTCH(5),
+    F_FLOAT("rightOutputGain", rightEar.outputGain, 2, 0.0f, 6.0f),
+
+    // Dynamics
+    F_BOOL("mbcEnabled", dynamics.mbcEnabled),
+    F_INT("mbcBands", dynamics.mbcBands, 3, 4),
+    F_FLOAT("mbcCrossover0", dynamics.crossoverHz[0], 1, 40.0f, 16000.0f),
+    F_FLOAT("mbcCrossover1", dynamics.crossoverHz[1], 1, 40.0f, 16000.0f),
+    F_FLOAT("mbcCrossover2", dynamics.crossoverHz[2], 1, 40.0f, 16000.0f),
+    MBC_BAND(0),
+    MBC_BAND(1),
+    MBC_BAND(2),
+    MBC_BAND(3),
+    F_BOOL("limiterEnabled", dynamics.limiterEnabled),
+    F_FLOAT("limiterCeilingDb", dynamics.limiterCeilingDb, 1, -12.0f, 0.0f),
+    F_FLOAT("limiterReleaseMs", dynamics.limiterReleaseMs, 1, 5.0f, 1000.0f),
+
+    // Hearing-loss fitting
+    F_BOOL("wdrcEnabled", fitting.wdrcEnabled),
+    F_INT("wdrcBands", fitting.wdrcBands, 8, 16),  // WdrcFilterbank::MAX_BANDS
+    AUDIOGRAM(0, 250),
+    AUDIOGRAM(1, 500),
+    AUDIOGRAM(2, 1000),
+    AUDIOGRAM(3, 2000),
+    AUDIOGRAM(4, 3000),
+    AUDIOGRAM(5, 4000),
+    AUDIOGRAM(6, 6000),
+    AUDIOGRAM(7, 8000),
+    F_FLOAT("wdrcCalibrationDbSpl", fitting.calibrationDbSpl, 1, 80.0f, 130.0f),
+    F_FLOAT("wdrcMaxGainDb", fitting.maxGainDb, 1, 0.0f, 60.0f),
+    F_FLOAT("wdrcAttackMs", fitting.attackMs, 1, 1.0f, 50.0f),
+    F_FLOAT("wdrcReleaseMs", fitting.releaseMs, 1, 20.0f, 1000.0f),
+    F_BOOL("nfcEnabled", fitting.nfcEnabled),
+    F_FLOAT("nfcCutoffHz", fitting.nfcCutoffHz, 0, 1000.0f, 6000.0f),
+    F_FLOAT("nfcRatio", fitting.nfcRatio, 2, 1.0f, 4.0f),
+
+    // Tinnitus relief
+    NOTCH(0),
+    NOTCH(1),
+    NOTCH(2),
+    NOTCH(3),
+    NOTCH(4),
+    NOTCH(5),
+    F_INT("noiseType", tinnitus.noiseType, 0, 3),
+    F_FLOAT("noiseLevel", tinnitus.noiseLevel, 2, 0.0f, 1.0f),
+    F_FLOAT("noiseLowCut", tinnitus.noiseLowCut, 1, 20.0f, 2000.0f),
+    F_FLOAT("noiseHighCut", tinnitus.noiseHighCut, 1, 1000.0f, 16000.0f),
+    F_BOOL("toneFinderEnabled", tinnitus.toneFinderEnabled),
+    F_FLOAT("toneFinderFreq", tinnitus.toneFinderFreq, 1, 200.0f, 12000.0f),
+    F_FLOAT("toneFinderLevel", tinnitus.toneFinderLevel, 2, 0.0f, 1.0f),
+    F_BOOL("hfExtEnabled", tinnitus.hfExtEnabled),
+    F_FLOAT("hfExtFreq", tinnitus.hfExtFreq, 1, 4000.0f, 12000.0f),
+    F_FLOAT("hfExtGainDb", tinnitus.hfExtGainDb, 1, 0.0f, 12.0f),
+    F_BOOL("binauralEnabled", tinnitus.binauralEnabled),
+    F_FLOAT("binauralCarrier", tinnitus.binauralCarrier, 1, 50.0f, 500.0f),
+    F_FLOAT("binauralBeat", tinnitus.binauralBeat, 1, 1.0f, 40.0f),
+    F_FLOAT("binauralLevel", tinnitus.binauralLevel, 2, 0.0f, 1.0f),
+    {"sessionDurationMs", Type::UINT, 0, F_OFF(tinnitus.sessionDurationMs), 60000.0f, 12 * 3600000.0f,
+     F_TAG("sessionDurationMs")},
+    F_FLOAT("sessionFadeMs", tinnitus.sessionFadeMs, 0, 0.0f, 300000.0f),
+    F_BOOL("outputOnly", tinnitus.outputOnly),
+};
+
+#undef RIGHT_NOTCH
+#undef NOTCH
+#undef AUDIOGRAM
+#undef MBC_BAND
+#undef F_FLOAT
+#undef F_INT_ANY
+#undef F_INT
+#undef F_BOOL
+#undef F_TAG
+#undef F_OFF
+
+static constexpr int FIELD_COUNT = static_cast<int>(sizeof(FIELDS) / sizeof(FIELDS[0]));
+static_assert(FIELD_COUNT <= 255, "sorted index is uint8_t");
+static_assert(sizeof(AudioEngineParams) <= UINT16_MAX, "field offsets are uint16_t");
+
+// The AUDIOGRAM() keys must follow the engine's test frequencies
+static constexpr bool audiogramKeysMatch()
+{
+    constexpr int hz[] = {250, 500, 1000, 2000, 3000, 4000, 6000, 8000};
+    if (sizeof(hz) / sizeof(hz[0]) != FittingParams::NUM_FREQS) return false;
+    for (int i = 0; i < FittingParams::NUM_FREQS; i++) {
+        if (static_cast<int>(FittingParams::FREQS_HZ[i]) != hz[i]) return false;
+    }
+    return true;
+}
+static_assert(audiogramKeysMatch(), "update AUDIOGRAM() entries for the new FittingParams::FREQS_HZ");
+
+// Field indices sorted by key, for find()
+static constexpr auto SORTED = [] {
+    std::array<uint8_t, FIELD_COUNT> idx{};
+    for (int i = 0; i < FIELD_COUNT; i++) idx[i] = static_cast<uint8_t>(i);
+    std::sort(idx.begin(), idx.end(), [](uint8_t a, uint8_t b) {
+        return std::string_view(FIELDS[a].key) < std::string_view(FIELDS[b].key);
+    });
+    return idx;
+}();
+
+static constexpr bool keysUnique()
+{
+    for (int i = 1; i < FIELD_COUNT; i++) {
+        if (std::string_view(FIELDS[SORTED[i - 1]].key) == std::string_view(FIELDS[SORTED[i]].key)) return false;
+    }
+    return true;
+}
+static_assert(keysUnique(), "duplicate profile key");
+
+// Field indices sorted by tag, for findTag()
+static constexpr auto BY_TAG = [] {
+    std::array<uint8_t, FIELD_COUNT> idx{};
+    for (int i = 0; i < FIELD_COUNT; i++) idx[i] = static_cast<uint8_t>(i);
+    std::sort(idx.begin(), idx.end(), [](uint8_t a, uint8_t b) { return FIELDS[a].tag < FIELDS[b].tag; });
+    return idx;
+}();
+
+static constexpr bool tagsUnique()
+{
+    for (int i = 1; i < FIELD_COUNT; i++) {
+        if (FIELDS[BY_TAG[i - 1]].tag == FIELDS[BY_TAG[i]].tag) return false;
+    }
+    return true;
+}
+static_assert(tagsUnique(), "profile key hash collision; rename the new key");
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Access
+// ─────────────────────────────────────────────────────────────────────────────
+
+const Field* ProfileSchema::fields()
+{
+    return FIELDS;
+}
+
+int ProfileSchema::fieldCount()
+{
+    return FIELD_COUNT;
+}
+
+const Field* ProfileSchema::find(const char* key)
+{
+    const std::string_view k(key);
+    auto it = std::lower_bound(SORTED.begin(), SORTED.end(), k,
+                               [](uint8_t i, std::string_view v) { return std::string_view(FIELDS[i].key) < v; });
+    if (it == SORTED.end() || std::string_view(FIELDS[*it].key) != k) return nullptr;
+    return &FIELDS[*it];
+}
+
+const Field* ProfileSchema::findTag(uint32_t tag)
+{
+    auto it = std::lower_bound(BY_TAG.begin(), BY_TAG.end(), tag,
+                               [](uint8_t i, uint32_t t) { return FIELDS[i].tag < t; });
+    if (it == BY_TAG.end() || FIELDS[*it].tag != tag) return nullptr;
+    return &FIELDS[*it];
+}
+
+static void* member(const Field& f, AudioEngineParams& params)
+{
+    return reinterpret_cast<uint8_t*>(&params) + f.offset;
+}
+
+static const void* member(const Field& f, const AudioEngineParams& params)
+{
+    return reinterpret_cast<const uint8_t*>(&params) + f.offset;
+}
+
+int ProfileSchema::format(const Field& f, const AudioEngineParams& params, char* buf, size_t size)
+{
+    const void* m = member(f, params);
+    switch (f.type) {
+        case Type::BOOL:  return snprintf(buf, size, "%d", *static_cast<const bool*>(m) ? 1 : 0);
+        case Type::INT:   return snprintf(buf, size, "%d", *static_cast<const int*>(m));
+        case Type::UINT:  return snprintf(buf, size, "%u", static_cast<unsigned>(*static_cast<const uint32_t*>(m)));
+        case Type::FLOAT: return snprintf(buf, size, "%.*f", f.decimals, *static_cast<const float*>(m));
+    }
+    return 0;
+}
+
+bool ProfileSchema::parse(const Field& f, const char* text, AudioEngineParams& params)
+{
+    char* end = nullptr;
+    void* m = member(f, params);
+    const bool ranged = f.min <= f.max;
+
+    if (f.type == Type::FLOAT) {
+        float v = strtof(text, &end);
+        if (end == text) return false;
+        if (ranged) v = std::clamp(v, f.min, f.max);
+        *static_cast<float*>(m) = v;
+        return true;
+    }
+
+    long v = strtol(text, &end, 10);
+    if (end == text) return false;
+    if (ranged) v = std::clamp(v, static_cast<long>(f.min), static_cast<long>(f.max));
+    switch (f.type) {
+        case Type::BOOL: *static_cast<bool*>(m) = v != 0; break;
+        case Type::INT:  *static_cast<int*>(m) = static_cast<int>(v); break;
+        case Type::UINT: *static_cast<uint32_t*>(m) = static_cast<uint32_t>(std::max(v, 0L)); break;
+        default:         break;
+    }
+    return true;
+}
+
+bool ProfileSchema::parseLine(char* line, AudioEngineParams& params, const char** key, const char** value)
+{
+    if (line[0] == '#' || line[0] == '\n' || line[0] == '\r' || line[0] == '\0') return true;
+    char* eq = strchr(line, '=');
+    if (!eq) return true;
+
+    *eq = '\0';
+    char* val = eq + 1;
+    val[strcspn(val, "\r\n")] = '\0';
+    *key = line;
+    *value = val;
+
+    // Unknown keys (newer files, removed settings) are skipped
+    const Field* f = find(line);
+    return !f || parse(*f, val, params);
+}
+
+uint32_t ProfileSchema::raw(const Field& f, const AudioEngineParams& params)
+{
+    const void* m = member(f, params);
+    uint32_t word = 0;
+    if (f.type == Type::BOOL) {
+        word = *static_cast<const bool*>(m) ? 1 : 0;
+    } else {
+        memcpy(&word, m, sizeof(word));  // int, uint32_t and float are all one word
+    }
+    return word;
+}
+
+void ProfileSchema::setRaw(const Field& f, uint32_t word, AudioEngineParams& params)
+{
+    void* m = member(f, params);
+    const bool ranged = f.min <= f.max;
+    switch (f.type) {
+        case Type::BOOL:
+            *static_cast<bool*>(m) = word != 0;
+            break;
+        case Type::INT: {
+            int32_t v;
+            memcpy(&v, &word, sizeof(v));
+            if (ranged) v = std::clamp(v, static_cast<int32_t>(f.min), static_cast<int32_t>(f.max));
+            *static_cast<int*>(m) = v;
+            break;
+        }
+        case Type::UINT:
+            if (ranged) word = std::clamp(word, static_cast<uint32_t>(f.min), static_cast<uint32_t>(f.max));
+            *static_cast<uint32_t*>(m) = word;
+            break;
+        case Type::FLOAT: {
+            float v;
+            memcpy(&v, &word, sizeof(v));
+            if (v != v) return;  // NaN: keep the current value
+            if (ranged) v = std::clamp(v, f.min, f.max);
+            *static_cast<float*>(m) = v;
+            break;
+        }
+    }
+}
+
+void ProfileSchema::encode(const AudioEngineParams& params, std::vector<uint32_t>& records)
+{
+    records.resize(2 * FIELD_COUNT);
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        records[2 * i] = FIELDS[i].tag;
+        records[2 * i + 1] = raw(FIELDS[i], params);
+    }
+}
+
+void ProfileSchema::decode(const uint32_t* records, int count, AudioEngineParams& params)
+{
+    // Same schema: record i is field i. Otherwise look the tag up
+    for (int i = 0; i < count; i++) {
+        const uint32_t tag = records[2 * i];
+        const Field* field = (i < FIELD_COUNT && FIELDS[i].tag == tag) ? &FIELDS[i] : findTag(tag);
+        if (field) setRaw(*field, records[2 * i + 1], params);
+    }
+}
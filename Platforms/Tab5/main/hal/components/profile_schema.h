@@ -0,0 +1,72 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include "audio_params.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Field registry behind the profile file format
+ *
+ * One constexpr table lists every persisted AudioEngineParams member (nested
+ * dynamics, fitting and tinnitus fields included) with its key, type, offset,
+ * text precision and valid range. Both directions of the .hwz format walk it,
+ * so a field can't be written but not read back. The range is the bound the
+ * member's engine setter clamps to; loaded values are clamped the same way.
+ * Key lookup is a binary search over an index sorted at compile time.
+ *
+ * The binary format identifies a field by its tag, a 32-bit FNV-1a hash of
+ * the key: tags follow the keys, so reordering the table or adding fields
+ * keeps old blobs readable, and a blob from newer firmware just carries tags
+ * this one skips. Values travel as raw 32-bit words.
+ */
+class ProfileSchema {
+public:
+    enum class Type : uint8_t { BOOL, INT, UINT, FLOAT };
+
+    struct Field {
+        const char* key;
+        Type type;
+        uint8_t decimals;  // FLOAT: digits written after the point
+        uint16_t offset;   // Into AudioEngineParams
+        float min;         // min > max: not range-checked (bools, snapped values)
+        float max;
+        uint32_t tag;      // keyTag(key)
+    };
+
+    static constexpr uint32_t keyTag(const char* key)
+    {
+        uint32_t h = 2166136261u;
+        for (; *key; key++) h = (h ^ static_cast<uint8_t>(*key)) * 16777619u;
+        return h;
+    }
+
+    // In file order
+    static const Field* fields();
+    static int fieldCount();
+    // nullptr for an unknown key or tag
+    static const Field* find(const char* key);
+    static const Field* findTag(uint32_t tag);
+
+    // Value text for the field's member of params, snprintf-style return
+    static int format(const Field& f, const AudioEngineParams& params, char* buf, size_t size);
+    // Parse and clamp text into the field's member; false (params untouched) if it doesn't parse
+    static bool parse(const Field& f, const char* text, AudioEngineParams& params);
+    // One "key=value" line of the text format, split in place. Comments, blank lines and
+    // unknown keys are skipped; false only for a known key whose value doesn't parse, with
+    // key and value pointing into the line for the caller's warning
+    static bool parseLine(char* line, AudioEngineParams& params, const char** key, const char** value);
+
+    // The member as a 32-bit word (bools as 0/1), and back with the same clamp as parse()
+    static uint32_t raw(const Field& f, const AudioEngineParams& params);
+    static void setRaw(const Field& f, uint32_t word, AudioEngineParams& params);
+
+    // Binary records: a (tag, raw value) word pair per field, in table order
+    static void encode(const AudioEngineParams& params, std::vector<uint32_t>& records);
+    // Applies `count` pairs; unknown tags are skipped
+    static void decode(const uint32_t* records, int count, AudioEngineParams& params);
+};
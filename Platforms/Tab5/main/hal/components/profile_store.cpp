@@ -0,0 +1,92 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "profile_store.h"
+#include "profile_manager.h"
+#include "sd_storage.h"
+#include <mooncake_log.h>
+#include <esp_lvgl_port.h>
+#include <lvgl.h>
+
+static const char* TAG = "ProfileStore";
+
+bool ProfileStore::list(Done done)
+{
+    return submit(Op::LIST, std::string(), nullptr, done);
+}
+
+bool ProfileStore::load(const std::string& name, Done done)
+{
+    return submit(Op::LOAD, name, nullptr, done);
+}
+
+bool ProfileStore::save(const std::string& name, const AudioEngineParams& params, Done done)
+{
+    return submit(Op::SAVE, name, &params, done);
+}
+
+bool ProfileStore::remove(const std::string& name, Done done)
+{
+    return submit(Op::REMOVE, name, nullptr, done);
+}
+
+bool ProfileStore::setDefault(const std::string& name, Done done)
+{
+    return submit(Op::SET_DEFAULT, name, nullptr, done);
+}
+
+bool ProfileStore::submit(Op op, const std::string& name, const AudioEngineParams* params, Done done)
+{
+    auto* req = new Request{};
+    req->result.op = op;
+    req->result.name = name;
+    if (params) req->result.params = *params;
+    req->done = done;
+    req->user = _user;
+    req->state = _state;
+
+    _state->pending.fetch_add(1, std::memory_order_relaxed);
+    if (!SdStorage::getInstance().post(run, req)) {
+        _state->pending.fetch_sub(1, std::memory_order_relaxed);
+        delete req;
+        return false;
+    }
+    return true;
+}
+
+void ProfileStore::run(void* arg)
+{
+    auto* req = static_cast<Request*>(arg);
+    Result& r = req->result;
+
+    switch (r.op) {
+        case Op::LIST:
+            r.ok = ProfileManager::isSdCardAccessible();
+            r.names = ProfileManager::listProfiles(&r.builtins);
+            if (r.ok) r.defaultName = ProfileManager::getDefaultProfile();
+            break;
+        case Op::LOAD:        r.ok = ProfileManager::loadProfile(r.name, r.params); break;
+        case Op::SAVE:        r.ok = ProfileManager::saveProfile(r.name, r.params); break;
+        case Op::REMOVE:      r.ok = ProfileManager::deleteProfile(r.name); break;
+        case Op::SET_DEFAULT: r.ok = ProfileManager::setDefaultProfile(r.name); break;
+    }
+
+    // lv_async_call registers an LVGL timer, so it needs the lock off the LVGL task
+    lvgl_port_lock(0);
+    const bool queued = lv_async_call(complete, req) == LV_RESULT_OK;
+    lvgl_port_unlock();
+    if (!queued) {
+        mclog::tagError(TAG, "no LVGL memory for the completion, result dropped");
+        req->state->pending.fetch_sub(1, std::memory_order_relaxed);
+        delete req;
+    }
+}
+
+void ProfileStore::complete(void* arg)
+{
+    std::unique_ptr<Request> req(static_cast<Request*>(arg));
+    req->state->pending.fetch_sub(1, std::memory_order_relaxed);
+    if (req->state->alive && req->done) req->done(req->user, req->result);
+}
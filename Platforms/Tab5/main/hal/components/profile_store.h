@@ -0,0 +1,81 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include "audio_engine.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Asynchronous ProfileManager front end for the LVGL thread
+ *
+ * Each call queues the ProfileManager operation on the SdStorage task and
+ * returns at once; on completion the result is handed back to the LVGL task
+ * through lv_async_call, so the callback may touch widgets directly. A mount
+ * attempt or the first index read after a card swap can take hundreds of ms
+ * and never blocks touch or rendering this way.
+ *
+ * Owned by the LVGL side and destroyed there: results for a store that is
+ * gone are dropped instead of calling back into a deleted owner.
+ */
+class ProfileStore {
+public:
+    enum class Op { LIST, LOAD, SAVE, REMOVE, SET_DEFAULT };
+
+    struct Result {
+        Op op = Op::LIST;
+        bool ok = false;                 // LIST: SD card usable
+        std::string name;                // Profile the request was for
+        AudioEngineParams params;        // LOAD
+        std::vector<std::string> names;  // LIST: SD profiles, then built-in presets
+        size_t builtins = 0;             // LIST: trailing names that are built-in
+        std::string defaultName;         // LIST
+    };
+    // Runs on the LVGL task, under the LVGL lock
+    using Done = void (*)(void* user, const Result& result);
+
+    explicit ProfileStore(void* user) : _user(user), _state(std::make_shared<State>()) {}
+    ~ProfileStore()
+    {
+        _state->alive = false;
+    }
+    ProfileStore(const ProfileStore&) = delete;
+    ProfileStore& operator=(const ProfileStore&) = delete;
+
+    // false if the request could not be queued; done is not called then
+    bool list(Done done);
+    bool load(const std::string& name, Done done);
+    bool save(const std::string& name, const AudioEngineParams& params, Done done);
+    bool remove(const std::string& name, Done done);
+    bool setDefault(const std::string& name, Done done);
+
+    // Requests queued or running whose callback hasn't run yet
+    bool busy() const
+    {
+        return _state->pending.load(std::memory_order_relaxed) > 0;
+    }
+
+private:
+    // Shared with the requests in flight, so they can outlive the store
+    struct State {
+        bool alive = true;  // LVGL task only
+        std::atomic<int> pending{0};
+    };
+    struct Request {
+        Result result;
+        Done done;
+        void* user;
+        std::shared_ptr<State> state;
+    };
+
+    bool submit(Op op, const std::string& name, const AudioEngineParams* params, Done done);
+    static void run(void* arg);       // Storage task
+    static void complete(void* arg);  // LVGL task
+
+    void* _user;
+    std::shared_ptr<State> _state;
+};
@@ -0,0 +1,331 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "remote_tuning.h"
+#include "audio_engine.h"
+#include "profile_schema.h"
+#include "wifi_link.h"
+#include "../utils/core_policy/core_policy.h"
+#include <mooncake_log.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unistd.h>
+
+static const char* TAG = "Remote";
+
+static constexpr int SENDER_STACK = 4096;
+static constexpr UBaseType_t SENDER_PRIORITY = 2;
+static constexpr size_t HEADER_BYTES = 4;
+static constexpr float LEVEL_FLOOR = 1e-5f;  // -100 dBFS
+
+RemoteTuning& RemoteTuning::getInstance()
+{
+    static RemoteTuning instance;
+    return instance;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Wire helpers (little endian, like the CPU)
+// ─────────────────────────────────────────────────────────────────────────────
+
+static void putHeader(std::vector<uint8_t>& buf, uint8_t kind, uint8_t flags, uint16_t count)
+{
+    buf[0] = kind;
+    buf[1] = flags;
+    std::memcpy(&buf[2], &count, sizeof(count));
+}
+
+template <typename T>
+static void put(std::vector<uint8_t>& buf, T value)
+{
+    const size_t at = buf.size();
+    buf.resize(at + sizeof(T));
+    std::memcpy(&buf[at], &value, sizeof(T));
+}
+
+static int16_t centiDb(float db)
+{
+    return static_cast<int16_t>(std::clamp(lrintf(db * 100.0f), -32768L, 32767L));
+}
+
+static int16_t centiDbOf(float linear)
+{
+    return centiDb(20.0f * log10f(std::max(linear, LEVEL_FLOOR)));
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Control
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool RemoteTuning::start(httpd_handle_t server)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_running.load(std::memory_order_relaxed)) return true;
+    if (!server) return false;
+
+    httpd_uri_t ws = {};
+    ws.uri = URI;
+    ws.method = HTTP_GET;
+    ws.handler = wsHandler;
+    ws.user_ctx = this;
+    ws.is_websocket = true;
+    const esp_err_t err = httpd_register_uri_handler(server, &ws);
+    if (err != ESP_OK) {
+        mclog::tagError(TAG, "failed to register {}: {}", URI, esp_err_to_name(err));
+        return false;
+    }
+
+    _server = server;
+    _stats = {};
+    _tx.reserve(HEADER_BYTES + 2 * ProfileSchema::fieldCount() * sizeof(uint32_t));
+    _running.store(true, std::memory_order_release);
+    if (xTaskCreatePinnedToCore(senderTask, "remote_tx", SENDER_STACK, this, SENDER_PRIORITY, &_task,
+                                core_policy::SYSTEM_AFFINITY) != pdPASS) {
+        _running.store(false, std::memory_order_relaxed);
+        _task = nullptr;
+        httpd_unregister_uri_handler(server, URI, HTTP_GET);
+        mclog::tagError(TAG, "failed to create sender task");
+        return false;
+    }
+    mclog::tagInfo(TAG, "tuning channel on ws://<ap>{}", URI);
+    return true;
+}
+
+void RemoteTuning::closeSocket(httpd_handle_t server, int fd)
+{
+    (void)server;
+    getInstance().disconnect(fd);
+    close(fd);
+}
+
+RemoteTuningStats RemoteTuning::getStats()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    RemoteTuningStats s = _stats;
+    s.running = isRunning();
+    s.connected = _clientFd.load(std::memory_order_relaxed) >= 0;
+    return s;
+}
+
+void RemoteTuning::disconnect(int fd)
+{
+    int expected = fd;
+    if (!_clientFd.compare_exchange_strong(expected, -1, std::memory_order_acq_rel)) return;
+    AudioEngine::getInstance().setRemoteTelemetryEnabled(false);
+    WifiLink::getInstance().want(WifiLink::CLIENT_REMOTE_SESSION, false);
+    mclog::tagInfo(TAG, "client {} gone", fd);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Incoming (httpd task)
+// ─────────────────────────────────────────────────────────────────────────────
+
+esp_err_t RemoteTuning::wsHandler(httpd_req_t* req)
+{
+    auto* self = static_cast<RemoteTuning*>(req->user_ctx);
+    const int fd = httpd_req_to_sockfd(req);
+
+    // The upgrade request: the handshake is done, claim the one client slot
+    if (req->method == HTTP_GET) {
+        int expected = -1;
+        if (!self->_clientFd.compare_exchange_strong(expected, fd, std::memory_order_acq_rel)) {
+            std::lock_guard<std::mutex> lock(self->_mutex);
+            self->_stats.rejected++;
+            mclog::tagWarn(TAG, "client {} refused, {} is connected", fd, expected);
+            return ESP_FAIL;  // Closes the socket
+        }
+        AudioEngine::getInstance().setRemoteTelemetryEnabled(true);
+        WifiLink::getInstance().want(WifiLink::CLIENT_REMOTE_SESSION, true);  // No linger-off mid-session
+        {
+            std::lock_guard<std::mutex> lock(self->_mutex);
+            self->_stats.sessions++;
+        }
+        xTaskNotifyGive(self->_task);
+        mclog::tagInfo(TAG, "client {} connected", fd);
+        return ESP_OK;
+    }
+    return self->receive(req);
+}
+
+esp_err_t RemoteTuning::receive(httpd_req_t* req)
+{
+    httpd_ws_frame_t frame = {};
+    esp_err_t ret = httpd_ws_recv_frame(req, &frame, 0);  // Length only
+    if (ret != ESP_OK) return ret;
+
+    // Ping / pong / close are answered by the server itself
+    if (frame.len > MAX_RX_BYTES) {
+        mclog::tagWarn(TAG, "{}-byte frame from {}, dropping the connection", frame.len, httpd_req_to_sockfd(req));
+        return ESP_FAIL;
+    }
+    const bool usable = frame.type == HTTPD_WS_TYPE_BINARY &&
+                        httpd_req_to_sockfd(req) == _clientFd.load(std::memory_order_acquire);
+    if (frame.len > 0) {
+        _rx.resize(frame.len);
+        frame.payload = _rx.data();
+        ret = httpd_ws_recv_frame(req, &frame, frame.len);
+        if (ret != ESP_OK) return ret;
+    }
+
+    if (!usable || !applyParams(_rx.data(), frame.len)) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats.badFrames++;
+    }
+    return ESP_OK;
+}
+
+bool RemoteTuning::applyParams(const uint8_t* payload, size_t len)
+{
+    if (len < HEADER_BYTES || payload[0] != KIND_PARAMS) return false;
+    uint16_t count = 0;
+    std::memcpy(&count, payload + 2, sizeof(count));
+    if (len != HEADER_BYTES + count * 2 * sizeof(uint32_t)) return false;
+
+    AudioEngine& engine = AudioEngine::getInstance();
+    AudioEngineParams params = engine.getParams();
+    uint32_t applied = 0, unknown = 0;
+    for (int i = 0; i < count; i++) {
+        uint32_t record[2];
+        std::memcpy(record, payload + HEADER_BYTES + i * sizeof(record), sizeof(record));
+        const ProfileSchema::Field* field = ProfileSchema::findTag(record[0]);
+        if (!field) {
+            unknown++;
+            continue;
+        }
+        ProfileSchema::setRaw(*field, record[1], params);
+        applied++;
+    }
+    if (applied > 0) engine.setParams(params);  // One params generation for the whole frame
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stats.paramFrames++;
+    _stats.paramRecords += applied;
+    _stats.unknownRecords += unknown;
+    return true;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Outgoing (sender task builds, httpd task writes)
+// ─────────────────────────────────────────────────────────────────────────────
+
+void RemoteTuning::senderTask(void* param)
+{
+    static_cast<RemoteTuning*>(param)->senderLoop();
+}
+
+void RemoteTuning::senderLoop()
+{
+    const TickType_t period = pdMS_TO_TICKS(1000 / TELEMETRY_HZ);
+    TickType_t wake = xTaskGetTickCount();
+    int lastFd = -1;
+    uint32_t tick = 0;
+
+    while (true) {
+        const int fd = _clientFd.load(std::memory_order_acquire);
+        if (fd < 0) {
+            lastFd = -1;
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            wake = xTaskGetTickCount();
+            continue;
+        }
+        vTaskDelayUntil(&wake, period);
+        if (_txQueued.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stats.skipped++;
+            continue;
+        }
+
+        // A new client first gets every field; after that, changes ride a tick now and then
+        const bool fresh = fd != lastFd;
+        bool params = false;
+        if (fresh || ++tick % PARAMS_EVERY_TICKS == 0) params = buildParamDeltas(fresh);
+        if (!params && !buildTelemetry()) continue;
+        lastFd = fd;
+
+        _txQueued.store(true, std::memory_order_release);
+        if (httpd_queue_work(_server, sendWork, this) != ESP_OK) {
+            _txQueued.store(false, std::memory_order_relaxed);
+            if (params) lastFd = -1;  // Those changes never left: resend every field
+        }
+    }
+}
+
+bool RemoteTuning::buildParamDeltas(bool full)
+{
+    ProfileSchema::encode(AudioEngine::getInstance().getParams(), _records);
+    if (full) _sentRecords.clear();
+
+    _tx.resize(HEADER_BYTES);
+    uint16_t count = 0;
+    for (size_t i = 0; i + 1 < _records.size(); i += 2) {
+        const bool same = i + 1 < _sentRecords.size() && _sentRecords[i] == _records[i] &&
+                          _sentRecords[i + 1] == _records[i + 1];
+        if (same) continue;
+        put(_tx, _records[i]);
+        put(_tx, _records[i + 1]);
+        count++;
+    }
+    if (count == 0) return false;
+    putHeader(_tx, KIND_PARAMS, 0, count);
+    _sentRecords.swap(_records);
+    return true;
+}
+
+bool RemoteTuning::buildTelemetry()
+{
+    AudioEngine& engine = AudioEngine::getInstance();
+    AudioLevels levels;
+    if (!engine.getTapLevels(AudioEngine::LEVEL_TAP_REMOTE, levels)) return false;
+    AudioSpectrum spectrum;
+    const bool withSpectrum = engine.getRemoteSpectrum(spectrum);
+
+    uint8_t flags = 0;
+    if (levels.vadSpeechDetected) flags |= FLAG_SPEECH;
+    if (withSpectrum) flags |= FLAG_SPECTRUM;
+    if (levels.sessionEnded) flags |= FLAG_SESSION_ENDED;
+
+    _tx.resize(HEADER_BYTES);
+    putHeader(_tx, KIND_TELEMETRY, flags, LEVEL_COUNT);
+    put(_tx, levels.blockIndex);
+    put(_tx, centiDbOf(levels.rmsLeft));
+    put(_tx, centiDbOf(levels.rmsRight));
+    put(_tx, centiDbOf(levels.peakLeft));
+    put(_tx, centiDbOf(levels.peakRight));
+    put(_tx, centiDb(levels.nsGainDb));
+    put(_tx, centiDb(levels.agcGainDb));
+    put(_tx, centiDb(levels.limiterGainReductionDb));
+    put(_tx, centiDb(levels.wdrcGainDb[0]));
+    put(_tx, centiDb(levels.wdrcGainDb[1]));
+    for (float gr : levels.mbcGainReductionDb) put(_tx, centiDb(gr));
+
+    if (withSpectrum) {
+        put(_tx, spectrum.frame);
+        for (float db : spectrum.inputDb) put(_tx, static_cast<int8_t>(std::clamp(lrintf(db), -128L, 127L)));
+        for (float db : spectrum.outputDb) put(_tx, static_cast<int8_t>(std::clamp(lrintf(db), -128L, 127L)));
+    }
+    return true;
+}
+
+void RemoteTuning::sendWork(void* arg)
+{
+    auto* self = static_cast<RemoteTuning*>(arg);
+    const int fd = self->_clientFd.load(std::memory_order_acquire);
+    if (fd >= 0) {
+        httpd_ws_frame_t frame = {};
+        frame.final = true;
+        frame.type = HTTPD_WS_TYPE_BINARY;
+        frame.payload = self->_tx.data();
+        frame.len = self->_tx.size();
+        const esp_err_t err = httpd_ws_send_frame_async(self->_server, fd, &frame);
+        if (err == ESP_OK) {
+            std::lock_guard<std::mutex> lock(self->_mutex);
+            self->_stats.sent++;
+        } else {
+            mclog::tagWarn(TAG, "send to {} failed: {}", fd, esp_err_to_name(err));
+        }
+    }
+    self->_txQueued.store(false, std::memory_order_release);
+}
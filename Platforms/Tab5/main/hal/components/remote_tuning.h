@@ -0,0 +1,121 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <esp_http_server.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+struct RemoteTuningStats {
+    bool running = false;
+    bool connected = false;
+    uint32_t sessions = 0;        // Clients accepted
+    uint32_t rejected = 0;        // Connections turned away while one was open
+    uint32_t paramFrames = 0;     // PARAMS frames applied
+    uint32_t paramRecords = 0;    // Records applied from them
+    uint32_t unknownRecords = 0;  // Tags this firmware doesn't know (skipped)
+    uint32_t badFrames = 0;       // Frames that didn't parse
+    uint32_t sent = 0;            // Frames written to the client
+    uint32_t skipped = 0;         // Ticks dropped because the previous send was still queued
+};
+
+/**
+ * @brief Binary WebSocket channel for tuning from a laptop over the softAP
+ *
+ * One client at a time on /ws, over one persistent connection. Every frame, both
+ * ways, starts with a 4-byte header { u8 kind, u8 flags, u16 count }, little endian:
+ *
+ *  - KIND_PARAMS: `count` ProfileSchema (tag, raw value) word pairs. From the client
+ *    they are applied on top of the live params in one setParams() (so one params
+ *    generation, clamped like a profile load, unknown tags skipped). To the client
+ *    they are what changed since the last PARAMS frame, whoever changed it; the
+ *    first one after connecting carries every field.
+ *  - KIND_TELEMETRY (to the client, TELEMETRY_HZ): a block index word, then `count`
+ *    int16 centi-dB levels (LEVEL_* order), then with FLAG_SPECTRUM a spectrum frame
+ *    word and the input and output band levels as int8 dB.
+ *
+ * The audio task only copies level frames it already builds into a second triple
+ * buffer (AudioEngine::setRemoteTelemetryEnabled), and only while a client is
+ * connected. Params come in through the httpd task and go out of the AudioEngine
+ * setter path; frames are built on a Core 0 sender task and written by the httpd
+ * task through httpd_queue_work(), one at a time: a tick that finds the previous
+ * frame still queued is skipped rather than buffered, so a slow link sees fresher
+ * frames, not later ones. The server has one task, so the channel stalls while a
+ * /stream client holds it.
+ */
+class RemoteTuning {
+public:
+    static constexpr const char* URI = "/ws";
+    static constexpr uint32_t TELEMETRY_HZ = 30;
+    static constexpr uint32_t PARAMS_EVERY_TICKS = 6;  // Outgoing param deltas at 5 Hz
+    static constexpr size_t MAX_RX_BYTES = 4096;
+
+    static constexpr uint8_t KIND_TELEMETRY = 0x01;
+    static constexpr uint8_t KIND_PARAMS = 0x02;
+
+    static constexpr uint8_t FLAG_SPEECH = 0x01;
+    static constexpr uint8_t FLAG_SPECTRUM = 0x02;
+    static constexpr uint8_t FLAG_SESSION_ENDED = 0x04;
+
+    enum Level : uint8_t {
+        LEVEL_RMS_L = 0,
+        LEVEL_RMS_R,
+        LEVEL_PEAK_L,
+        LEVEL_PEAK_R,
+        LEVEL_NS_GAIN,
+        LEVEL_AGC_GAIN,
+        LEVEL_LIMITER_GR,
+        LEVEL_WDRC_L,
+        LEVEL_WDRC_R,
+        LEVEL_MBC_GR_0,  // Four bands
+        LEVEL_COUNT = LEVEL_MBC_GR_0 + 4,
+    };
+
+    static RemoteTuning& getInstance();
+
+    // Registers /ws on the server and starts the sender task
+    bool start(httpd_handle_t server);
+    // httpd_config_t::close_fn: drops the client when its socket goes, then closes it
+    static void closeSocket(httpd_handle_t server, int fd);
+    bool isRunning() const
+    {
+        return _running.load(std::memory_order_relaxed);
+    }
+    RemoteTuningStats getStats();
+
+private:
+    RemoteTuning() = default;
+    RemoteTuning(const RemoteTuning&) = delete;
+    RemoteTuning& operator=(const RemoteTuning&) = delete;
+
+    static esp_err_t wsHandler(httpd_req_t* req);
+    esp_err_t receive(httpd_req_t* req);
+    bool applyParams(const uint8_t* payload, size_t len);
+    void disconnect(int fd);
+
+    static void senderTask(void* param);
+    void senderLoop();
+    bool buildTelemetry();
+    bool buildParamDeltas(bool full);
+    static void sendWork(void* arg);
+
+    std::mutex _mutex;  // _stats
+    std::atomic<bool> _running{false};
+    TaskHandle_t _task = nullptr;
+    httpd_handle_t _server = nullptr;
+    std::atomic<int> _clientFd{-1};
+    RemoteTuningStats _stats;
+
+    // Sender task builds, httpd task sends; _txQueued hands _tx over and back
+    std::atomic<bool> _txQueued{false};
+    std::vector<uint8_t> _tx;
+    std::vector<uint32_t> _records;      // Sender task: params now
+    std::vector<uint32_t> _sentRecords;  // Sender task: params as the client last heard them
+    std::vector<uint8_t> _rx;            // httpd task
+};
@@ -0,0 +1,204 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "rtp_stream.h"
+#include "../utils/core_policy/core_policy.h"
+#include <mooncake_log.h>
+#include <algorithm>
+#include <cstring>
+#include <esp_heap_caps.h>
+#include <esp_random.h>
+
+static const char* TAG = "RTP";
+
+static constexpr int SENDER_STACK = 3072;
+static constexpr UBaseType_t SENDER_PRIORITY = 6;  // Above the web server: a late batch is an audible gap
+static constexpr int DSCP_EF_TOS = 0xB8;
+
+RtpStream& RtpStream::getInstance()
+{
+    static RtpStream instance;
+    return instance;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Control
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool RtpStream::start(const char* host, uint16_t port)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_senderAlive.load(std::memory_order_acquire)) return true;
+
+    if (!_ring) {
+        _ring = static_cast<int16_t*>(heap_caps_calloc(RING_FRAMES * 2, sizeof(int16_t),
+            MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+        if (!_ring) {
+            mclog::tagError(TAG, "no PSRAM for the RTP ring");
+            return false;
+        }
+    }
+
+    // Connected: the route and ARP entry are resolved once, not per packet
+    if (!_flow.open(host, port, DSCP_EF_TOS)) return false;
+
+    _ssrc = esp_random();
+    _sequence = static_cast<uint16_t>(esp_random());
+    _timestamp = esp_random();
+    _packets.store(0, std::memory_order_relaxed);
+    _sendErrors.store(0, std::memory_order_relaxed);
+    _overflows.store(0, std::memory_order_relaxed);
+    _skippedFrames.store(0, std::memory_order_relaxed);
+    // Start from an empty queue so the receiver doesn't get stale audio
+    _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+
+    _senderAlive.store(true, std::memory_order_release);
+    _streaming.store(true, std::memory_order_release);
+    if (xTaskCreatePinnedToCore(senderTask, "rtp_tx", SENDER_STACK, this, SENDER_PRIORITY, &_task,
+                                core_policy::SYSTEM_AFFINITY) != pdPASS) {
+        _streaming.store(false, std::memory_order_relaxed);
+        _senderAlive.store(false, std::memory_order_relaxed);
+        _task = nullptr;
+        _flow.close();
+        mclog::tagError(TAG, "failed to create sender task");
+        return false;
+    }
+    mclog::tagInfo(TAG, "streaming L16/48000/2 to {}:{} (pt {})", host, port, PAYLOAD_TYPE);
+    return true;
+}
+
+void RtpStream::stop()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_senderAlive.load(std::memory_order_acquire)) return;
+    _streaming.store(false, std::memory_order_release);
+    xTaskNotifyGive(_task);
+    for (int i = 0; i < 50 && _senderAlive.load(std::memory_order_acquire); i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    if (_senderAlive.load(std::memory_order_acquire)) mclog::tagWarn(TAG, "sender did not finish in time");
+    _task = nullptr;
+    mclog::tagInfo(TAG, "stream stopped after {} packets", _packets.load(std::memory_order_relaxed));
+}
+
+RtpStreamStats RtpStream::getStats()
+{
+    RtpStreamStats s;
+    s.streaming = isStreaming();
+    s.packets = _packets.load(std::memory_order_relaxed);
+    s.sendErrors = _sendErrors.load(std::memory_order_relaxed);
+    s.overflows = _overflows.load(std::memory_order_relaxed);
+    s.skippedFrames = _skippedFrames.load(std::memory_order_relaxed);
+    s.fillFrames = _fillFrames.load(std::memory_order_relaxed);
+    return s;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Audio task side
+// ─────────────────────────────────────────────────────────────────────────────
+
+void RtpStream::push(const int16_t* stereo, int frames)
+{
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    const uint32_t tail = _tail.load(std::memory_order_acquire);
+    const uint32_t space = RING_FRAMES - (head - tail);
+    const uint32_t n = std::min<uint32_t>(frames, space);
+    if (n < static_cast<uint32_t>(frames)) _overflows.fetch_add(frames - n, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < n; i++, head++) {
+        const uint32_t pos = (head & (RING_FRAMES - 1)) * 2;
+        _ring[pos] = stereo[2 * i];
+        _ring[pos + 1] = stereo[2 * i + 1];
+    }
+    _head.store(head, std::memory_order_release);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Sender task
+// ─────────────────────────────────────────────────────────────────────────────
+
+void RtpStream::senderTask(void* param)
+{
+    auto* self = static_cast<RtpStream*>(param);
+    self->senderLoop();
+    self->_flow.close();
+    self->_senderAlive.store(false, std::memory_order_release);
+    vTaskDelete(nullptr);
+}
+
+void RtpStream::senderLoop()
+{
+    bool marker = true;  // First packet of the talkspurt
+    while (_streaming.load(std::memory_order_acquire)) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(BATCH_MS));
+
+        const uint32_t head = _head.load(std::memory_order_acquire);
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (head - tail > MAX_QUEUE_FRAMES) {
+            // Behind after a link stall: drop the backlog, keep the timeline
+            const uint32_t skip = head - tail - TARGET_FRAMES;
+            tail += skip;
+            _tail.store(tail, std::memory_order_release);
+            _timestamp += skip;
+            _skippedFrames.fetch_add(skip, std::memory_order_relaxed);
+            marker = true;
+        }
+        _fillFrames.store(head - tail, std::memory_order_relaxed);
+        // Everything due goes to the stack in one tcpip thread pass per MAX_BATCH packets
+        int queued = 0;
+        while (_head.load(std::memory_order_acquire) - _tail.load(std::memory_order_relaxed) >= PACKET_FRAMES) {
+            if (queued == UdpFlow::MAX_BATCH) {
+                flushPackets(queued);
+                queued = 0;
+            }
+            if (!buildPacket(marker)) break;  // pbuf pool dry: the rest waits for the next wake
+            marker = false;
+            queued++;
+        }
+        flushPackets(queued);
+    }
+}
+
+void RtpStream::flushPackets(int queued)
+{
+    if (queued == 0) return;
+    const int sent = _flow.flush();
+    _packets.fetch_add(sent, std::memory_order_relaxed);
+    // Refused when the queue to the C6 is full: the receiver conceals them
+    if (sent < queued) _sendErrors.fetch_add(queued - sent, std::memory_order_relaxed);
+}
+
+bool RtpStream::buildPacket(bool marker)
+{
+    // Written straight into the datagram's pbuf: the ring-to-packet copy is the only one on our side
+    uint8_t* packet = _flow.prepare(PACKET_BYTES);
+    if (!packet) return false;
+
+    // RFC 3550 fixed header: V=2, no padding / extension / CSRC
+    packet[0] = 0x80;
+    packet[1] = PAYLOAD_TYPE | (marker ? 0x80 : 0x00);
+    packet[2] = _sequence >> 8;
+    packet[3] = _sequence & 0xFF;
+    for (int i = 0; i < 4; i++) {
+        packet[4 + i] = _timestamp >> (24 - 8 * i);
+        packet[8 + i] = _ssrc >> (24 - 8 * i);
+    }
+
+    // L16 is big endian
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    uint8_t* out = packet + HEADER_BYTES;
+    for (uint32_t i = 0; i < PACKET_FRAMES; i++, tail++) {
+        const uint32_t pos = (tail & (RING_FRAMES - 1)) * 2;
+        for (int c = 0; c < 2; c++) {
+            const uint16_t s = static_cast<uint16_t>(_ring[pos + c]);
+            *out++ = s >> 8;
+            *out++ = s & 0xFF;
+        }
+    }
+    _tail.store(tail, std::memory_order_release);
+    _sequence++;
+    _timestamp += PACKET_FRAMES;
+    _flow.commit();
+    return true;
+}
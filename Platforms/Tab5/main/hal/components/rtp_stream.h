@@ -0,0 +1,105 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include "net_tx.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+struct RtpStreamStats {
+    bool streaming = false;
+    uint32_t packets = 0;       // RTP packets sent
+    uint32_t sendErrors = 0;    // Packets the network stack refused (dropped, sequence still advances)
+    uint32_t overflows = 0;     // Frames the audio task couldn't queue (sender stalled)
+    uint32_t skippedFrames = 0; // Frames dropped by the sender to get back under MAX_QUEUE_FRAMES
+    uint32_t fillFrames = 0;    // Queue depth at the last send
+};
+
+/**
+ * @brief Processed output as RTP over UDP, to a second listener or a recorder
+ *
+ * The audio task queues what goes out to I2S into a wait-free stereo ring in
+ * PSRAM (like UsbAudio) and never touches the network. A Core 0 task wakes
+ * every BATCH_MS and sends what has built up as back-to-back RTP/L16 packets
+ * (RFC 3551: big-endian 16-bit PCM, 48 kHz stereo, dynamic payload type
+ * PAYLOAD_TYPE), each PACKET_FRAMES long so it fills one datagram without IP
+ * fragmentation. One wake-up per few packets instead of a send per 10 ms block
+ * keeps transactions over the SDIO link to the C6 Wi-Fi coprocessor down. The
+ * packets of a wake-up are built in their pbufs and go to lwIP together, one
+ * tcpip thread pass per batch (UdpFlow).
+ *
+ * RTP timestamps count I2S frames, so the receiver's jitter buffer tracks the
+ * device clock. When the link stalls and the queue passes MAX_QUEUE_FRAMES,
+ * the sender skips ahead to TARGET_FRAMES instead of delivering a backlog late:
+ * the timestamp jumps by what was skipped and the marker bit is set, so the
+ * receiver sees a gap rather than ever-growing latency. Packets carry DSCP EF
+ * for the Wi-Fi voice access category.
+ */
+class RtpStream {
+public:
+    static constexpr uint32_t SAMPLE_RATE = 48000;
+    static constexpr uint8_t PAYLOAD_TYPE = 96;        // SDP: a=rtpmap:96 L16/48000/2
+    static constexpr uint16_t DEFAULT_PORT = 5004;
+    static constexpr uint32_t PACKET_FRAMES = 360;     // 7.5 ms: 12 + 1440 bytes in a 1472-byte datagram
+    static constexpr uint32_t BATCH_MS = 15;           // Two packets per wake-up
+    static constexpr uint32_t TARGET_FRAMES = 2 * PACKET_FRAMES;
+    static constexpr uint32_t MAX_QUEUE_FRAMES = 4800; // 100 ms
+
+    static RtpStream& getInstance();
+
+    // host is a dotted IPv4 address (a softAP client or a multicast group)
+    bool start(const char* host, uint16_t port = DEFAULT_PORT);
+    void stop();
+    bool isStreaming() const
+    {
+        return _streaming.load(std::memory_order_relaxed);
+    }
+    RtpStreamStats getStats();
+
+    // ── Audio task (wait-free) ──
+    bool wants() const
+    {
+        return _streaming.load(std::memory_order_relaxed);
+    }
+    void push(const int16_t* stereo, int frames);
+
+private:
+    RtpStream() = default;
+    RtpStream(const RtpStream&) = delete;
+    RtpStream& operator=(const RtpStream&) = delete;
+
+    static constexpr uint32_t RING_FRAMES = 8192;  // ~170 ms
+    static constexpr size_t HEADER_BYTES = 12;
+
+    static constexpr size_t PACKET_BYTES = HEADER_BYTES + PACKET_FRAMES * 2 * sizeof(int16_t);
+
+    static void senderTask(void* param);
+    void senderLoop();
+    bool buildPacket(bool marker);
+    void flushPackets(int queued);
+
+    std::mutex _mutex;  // start/stop
+    int16_t* _ring = nullptr;  // RING_FRAMES stereo frames, PSRAM, allocated on first start
+    std::atomic<uint32_t> _head{0};  // Audio task
+    std::atomic<uint32_t> _tail{0};  // Sender
+    std::atomic<bool> _streaming{false};
+    std::atomic<bool> _senderAlive{false};
+    TaskHandle_t _task = nullptr;
+
+    // Sender task only
+    UdpFlow _flow;
+    uint16_t _sequence = 0;
+    uint32_t _timestamp = 0;
+    uint32_t _ssrc = 0;
+
+    std::atomic<uint32_t> _packets{0};
+    std::atomic<uint32_t> _sendErrors{0};
+    std::atomic<uint32_t> _overflows{0};
+    std::atomic<uint32_t> _skippedFrames{0};
+    std::atomic<uint32_t> _fillFrames{0};
+};
@@ -0,0 +1,364 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "sampling_profiler.h"
+#include "sd_storage.h"
+#include "../utils/core_policy/core_policy.h"
+#include <mooncake_log.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <sys/stat.h>
+#include <esp_app_desc.h>
+#include <esp_attr.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <sdkconfig.h>
+#if CONFIG_IDF_TARGET_ARCH_RISCV
+#include <riscv/csr.h>
+#endif
+
+static const char* TAG = "Profiler";
+
+SamplingProfiler& SamplingProfiler::getInstance()
+{
+    static SamplingProfiler instance;
+    return instance;
+}
+
+bool SamplingProfiler::start(const SamplingProfileConfig& config)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_taskAlive.load(std::memory_order_acquire)) return false;
+    if ((config.coreMask & 0x3) == 0 || config.seconds == 0) return false;
+    for (CoreRing& ring : _rings) {
+        if (!ring.slots) {
+            // The ISR writes here: internal RAM, reachable with the cache off
+            ring.slots = static_cast<Sample*>(
+                heap_caps_malloc(RING_SAMPLES * sizeof(Sample), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+        }
+    }
+    if (!_buckets) {
+        _buckets = static_cast<Bucket*>(heap_caps_malloc(MAX_BUCKETS * sizeof(Bucket), MALLOC_CAP_SPIRAM));
+    }
+    if (!_rings[0].slots || !_rings[1].slots || !_buckets) {
+        mclog::tagError(TAG, "no memory for the sample rings");
+        return false;
+    }
+
+    _config = config;
+    _config.hz = std::clamp(config.hz, MIN_HZ, MAX_HZ);
+    _config.bucketShift = std::min<uint8_t>(config.bucketShift, 16);
+    _report = SamplingProfileReport();
+    _report.running = true;
+    _stopRequested.store(false, std::memory_order_relaxed);
+    _taskAlive.store(true, std::memory_order_release);
+    // Below everything it measures; it only has to keep the rings from filling
+    if (xTaskCreatePinnedToCore(aggregatorTask, "prof_agg", 4096, this, 1, &_task, core_policy::SYSTEM_AFFINITY) !=
+        pdPASS) {
+        _taskAlive.store(false, std::memory_order_release);
+        _report.running = false;
+        _task = nullptr;
+        mclog::tagError(TAG, "failed to create profiler task");
+        return false;
+    }
+    mclog::tagInfo(TAG, "start: {}s at {} Hz, cores 0x{:x}, bucket shift {}", _config.seconds, _config.hz,
+        _config.coreMask, _config.bucketShift);
+    return true;
+}
+
+void SamplingProfiler::stop()
+{
+    _stopRequested.store(true, std::memory_order_release);
+}
+
+SamplingProfileReport SamplingProfiler::getReport()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _report;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Sampling
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool IRAM_ATTR SamplingProfiler::sampleIsr(gptimer_handle_t timer, const gptimer_alarm_event_data_t* event,
+                                           void* ctx)
+{
+    (void)timer;
+    (void)event;
+    auto* ring = static_cast<CoreRing*>(ctx);
+#if CONFIG_IDF_TARGET_ARCH_RISCV
+    // The interrupt entry stacks mepc and restores it before mret, so nested
+    // interrupts leave it intact: it is still the PC this one interrupted
+    const uint32_t pc = RV_READ_CSR(mepc);
+#else
+    const uint32_t pc = 0;
+#endif
+    const uint32_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= RING_SAMPLES) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    ring->slots[head % RING_SAMPLES] = {pc, xTaskGetCurrentTaskHandle()};
+    ring->head.store(head + 1, std::memory_order_release);
+    return false;
+}
+
+void SamplingProfiler::timerTask(void* arg)
+{
+    auto* ring = static_cast<CoreRing*>(arg);
+    SamplingProfiler* self = ring->self;
+
+    gptimer_handle_t timer = nullptr;
+    gptimer_config_t timerConfig = {};
+    timerConfig.clk_src = GPTIMER_CLK_SRC_DEFAULT;
+    timerConfig.direction = GPTIMER_COUNT_UP;
+    timerConfig.resolution_hz = TIMER_HZ;
+    gptimer_alarm_config_t alarm = {};
+    alarm.alarm_count = TIMER_HZ / self->_config.hz;
+    alarm.reload_count = 0;
+    alarm.flags.auto_reload_on_alarm = true;
+    gptimer_event_callbacks_t callbacks = {};
+    callbacks.on_alarm = sampleIsr;
+
+    // The interrupt is allocated on this core when the callback is registered
+    esp_err_t err = gptimer_new_timer(&timerConfig, &timer);
+    if (err == ESP_OK) err = gptimer_set_alarm_action(timer, &alarm);
+    if (err == ESP_OK) err = gptimer_register_event_callbacks(timer, &callbacks, ring);
+    if (err == ESP_OK) err = gptimer_enable(timer);
+    if (err == ESP_OK) err = gptimer_start(timer);
+    if (err == ESP_OK) {
+        ring->armed.store(true, std::memory_order_release);
+    } else {
+        mclog::tagError(TAG, "core {} timer: {}", ring->core, esp_err_to_name(err));
+    }
+    xTaskNotifyGive(self->_task);
+
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (ring->armed.load(std::memory_order_acquire)) {
+        gptimer_stop(timer);
+        gptimer_disable(timer);
+        ring->armed.store(false, std::memory_order_release);
+    }
+    if (timer) {
+        // A failed enable leaves the timer disabled, which is what delete needs
+        gptimer_del_timer(timer);
+    }
+    ring->owner = nullptr;
+    xTaskNotifyGive(self->_task);
+    vTaskDelete(nullptr);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Aggregator task
+// ─────────────────────────────────────────────────────────────────────────────
+
+void SamplingProfiler::aggregatorTask(void* arg)
+{
+    auto* self = static_cast<SamplingProfiler*>(arg);
+    self->run();
+    self->_taskAlive.store(false, std::memory_order_release);
+    vTaskDelete(nullptr);
+}
+
+void SamplingProfiler::run()
+{
+    memset(_buckets, 0, MAX_BUCKETS * sizeof(Bucket));
+    _bucketCount = 0;
+    _unbinned = 0;
+    _binned[0] = _binned[1] = 0;
+    _nameCount = 0;
+
+    // One helper per profiled core; each notifies once armed (or failed) and once gone
+    uint32_t helpers = 0;
+    for (int c = 0; c < 2; c++) {
+        CoreRing& ring = _rings[c];
+        ring.head.store(0, std::memory_order_relaxed);
+        ring.tail.store(0, std::memory_order_relaxed);
+        ring.dropped.store(0, std::memory_order_relaxed);
+        ring.self = this;
+        ring.core = c;
+        ring.owner = nullptr;
+        if (!(_config.coreMask & (1 << c))) continue;
+        // Above the audio task so a start/stop isn't held up behind a DSP block
+        if (xTaskCreatePinnedToCore(timerTask, "prof_tmr", 3072, &ring, configMAX_PRIORITIES - 1, &ring.owner, c) !=
+            pdPASS) {
+            ring.owner = nullptr;
+            mclog::tagError(TAG, "failed to create core {} timer task", c);
+            continue;
+        }
+        helpers++;
+    }
+    for (uint32_t ready = 0; ready < helpers;) {
+        ready += ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+
+    const int64_t startUs = esp_timer_get_time();
+    const int64_t endUs = startUs + static_cast<int64_t>(_config.seconds) * 1000000;
+    while (!_stopRequested.load(std::memory_order_acquire) && esp_timer_get_time() < endUs) {
+        vTaskDelay(pdMS_TO_TICKS(DRAIN_MS));
+        drain();
+        std::lock_guard<std::mutex> lock(_mutex);
+        _report.samples[0] = _binned[0];
+        _report.samples[1] = _binned[1];
+        _report.dropped = _unbinned + _rings[0].dropped.load(std::memory_order_relaxed) +
+                          _rings[1].dropped.load(std::memory_order_relaxed);
+        _report.buckets = _bucketCount;
+    }
+
+    for (CoreRing& ring : _rings) {
+        if (ring.owner) xTaskNotifyGive(ring.owner);
+    }
+    for (uint32_t gone = 0; gone < helpers;) {
+        gone += ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+    drain();
+    const float seconds = (esp_timer_get_time() - startUs) / 1e6f;
+    const uint32_t dropped = _unbinned + _rings[0].dropped.load(std::memory_order_relaxed) +
+                             _rings[1].dropped.load(std::memory_order_relaxed);
+
+    const bool written = dump();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _report.samples[0] = _binned[0];
+        _report.samples[1] = _binned[1];
+        _report.dropped = dropped;
+        _report.buckets = _bucketCount;
+        _report.written = written;
+        _report.running = false;
+    }
+    mclog::tagInfo(TAG, "{:.1f}s: {} + {} samples in {} buckets, {} dropped, {}", seconds, _binned[0], _binned[1],
+        _bucketCount, dropped, written ? _report.path : "not written");
+}
+
+void SamplingProfiler::drain()
+{
+    _namesLearned = false;
+    for (int c = 0; c < 2; c++) {
+        CoreRing& ring = _rings[c];
+        const uint32_t head = ring.head.load(std::memory_order_acquire);
+        uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+        for (; tail != head; tail++) {
+            bin(c, ring.slots[tail % RING_SAMPLES]);
+        }
+        ring.tail.store(tail, std::memory_order_release);
+    }
+}
+
+void SamplingProfiler::bin(int core, const Sample& s)
+{
+    const uint32_t pc = s.pc >> _config.bucketShift << _config.bucketShift;
+    uint32_t h = (pc >> 1) * 2654435761u ^ static_cast<uint32_t>(reinterpret_cast<uintptr_t>(s.task)) ^ core;
+    for (uint32_t probe = 0; probe < MAX_BUCKETS; probe++, h++) {
+        Bucket& b = _buckets[h % MAX_BUCKETS];
+        if (b.count == 0) {
+            // Full past 7/8, probing gets long: count the rest instead
+            if (_bucketCount >= MAX_BUCKETS / 8 * 7) break;
+            b = {pc, s.task, 1, static_cast<uint8_t>(core)};
+            _bucketCount++;
+            _binned[core]++;
+            taskName(s.task);  // Named now, while the task is known to be alive
+            return;
+        }
+        if (b.pc == pc && b.task == s.task && b.core == core) {
+            b.count++;
+            _binned[core]++;
+            return;
+        }
+    }
+    _unbinned++;
+}
+
+void SamplingProfiler::learnTaskNames()
+{
+    _namesLearned = true;
+    std::vector<TaskStatus_t> status(uxTaskGetNumberOfTasks() + 4);
+    const UBaseType_t count = uxTaskGetSystemState(status.data(), status.size(), nullptr);
+    for (UBaseType_t i = 0; i < count && _nameCount < MAX_TASKS; i++) {
+        const TaskStatus_t& ts = status[i];
+        bool known = false;
+        for (uint32_t n = 0; n < _nameCount && !known; n++) {
+            known = _names[n].handle == ts.xHandle;
+        }
+        if (known) continue;
+        TaskName& entry = _names[_nameCount++];
+        entry.handle = ts.xHandle;
+        strncpy(entry.name, ts.pcTaskName, sizeof(entry.name) - 1);
+        entry.name[sizeof(entry.name) - 1] = '\0';
+        // Folded stacks split frames on ';' and the count on the last space
+        for (char* p = entry.name; *p; p++) {
+            if (*p == ' ' || *p == ';') *p = '_';
+        }
+    }
+}
+
+const char* SamplingProfiler::taskName(TaskHandle_t handle)
+{
+    for (int pass = 0; pass < 2; pass++) {
+        for (uint32_t n = 0; n < _nameCount; n++) {
+            if (_names[n].handle == handle) return _names[n].name;
+        }
+        // One snapshot per drain at most; a task gone by then stays unnamed
+        if (pass == 0 && !_namesLearned) {
+            learnTaskNames();
+        } else {
+            break;
+        }
+    }
+    return nullptr;
+}
+
+bool SamplingProfiler::dump()
+{
+    if (!SdStorage::getInstance().mount()) {
+        mclog::tagWarn(TAG, "no card, profile not written");
+        return false;
+    }
+    if (mkdir(DUMP_DIR, 0777) != 0 && errno != EEXIST) {
+        mclog::tagError(TAG, "mkdir {} failed: {}", DUMP_DIR, strerror(errno));
+        return false;
+    }
+    // First free name, searched from where the last run of this boot stopped
+    char path[sizeof(_report.path)];
+    struct stat st;
+    do {
+        snprintf(path, sizeof(path), "%s/prof_%03u.txt", DUMP_DIR, (unsigned)_dumpIndex++);
+    } while (stat(path, &st) == 0 && _dumpIndex < 1000);
+
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        mclog::tagError(TAG, "open {} failed: {}", path, strerror(errno));
+        return false;
+    }
+    char sha[65];
+    esp_app_get_elf_sha256(sha, sizeof(sha));
+    // '#' lines are metadata: grep -v '^#' before handing the file to a flame graph tool
+    fprintf(f, "# howizard sampling profile\n# elf_sha256 %s\n# hz %u cores 0x%x bucket_shift %u\n", sha,
+            (unsigned)_config.hz, (unsigned)_config.coreMask, (unsigned)_config.bucketShift);
+    fprintf(f, "# samples core0 %u core1 %u\n", (unsigned)_binned[0], (unsigned)_binned[1]);
+    bool ok = !ferror(f);
+    for (uint32_t i = 0; i < MAX_BUCKETS && ok; i++) {
+        const Bucket& b = _buckets[i];
+        if (b.count == 0) continue;
+        const char* name = taskName(b.task);
+        if (name) {
+            ok = fprintf(f, "core%u;%s;0x%08x %u\n", (unsigned)b.core, name, (unsigned)b.pc, (unsigned)b.count) > 0;
+        } else {
+            ok = fprintf(f, "core%u;task_%p;0x%08x %u\n", (unsigned)b.core, b.task, (unsigned)b.pc,
+                         (unsigned)b.count) > 0;
+        }
+    }
+    ok = fclose(f) == 0 && ok;
+    if (!ok) {
+        mclog::tagError(TAG, "write {} failed", path);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    strncpy(_report.path, path, sizeof(_report.path) - 1);
+    return true;
+}
@@ -0,0 +1,130 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <driver/gptimer.h>
+
+struct SamplingProfileConfig {
+    uint32_t seconds = 10;
+    uint32_t hz = 997;         // Per core; prime, so it doesn't lock onto the 1ms I2S or LVGL periods
+    uint8_t coreMask = 0x3;    // Bit n samples core n; Core 1 pays the interrupt inside DSP blocks
+    uint8_t bucketShift = 0;   // PC bits dropped per bucket (0 = exact address)
+};
+
+struct SamplingProfileReport {
+    bool running = false;
+    uint32_t samples[2] = {};  // Per core, binned
+    uint32_t dropped = 0;      // Ring full, or the table out of buckets
+    uint32_t buckets = 0;      // Distinct (core, task, PC bucket)
+    char path[48] = {};        // Last dump ("" until the first one is written)
+    bool written = false;      // Last dump made it to the card
+};
+
+/**
+ * @brief Statistical PC sampler for hot spots outside the annotated audio stages
+ *
+ * A gptimer per profiled core interrupts at SamplingProfileConfig::hz; its ISR
+ * (in IRAM, the image runs from PSRAM) reads mepc, the interrupted PC, and the
+ * core's current task into a single-producer ring in internal RAM. A
+ * low-priority Core 0 task drains the rings every DRAIN_MS into a table keyed by
+ * (core, task, PC >> bucketShift) and, at the end of the run, writes it to
+ * /sd/profile as folded lines for flame graph tools:
+ *
+ *     core1;audio;0x4ff0a2c4 312
+ *
+ * The header carries the app ELF's SHA-256 so the host symbolizes against the
+ * right build: with `addr2line -fe firmware.elf` on the third field the lines
+ * become task;function stacks (one frame deep; only the PC is sampled). A PC
+ * inside another ISR is charged to the task it interrupted.
+ *
+ * The timers are owned by one helper task per core, since a gptimer's interrupt
+ * lands on the core that registered its callback.
+ */
+class SamplingProfiler {
+public:
+    static constexpr const char* DUMP_DIR = "/sd/profile";
+    static constexpr uint32_t RING_SAMPLES = 1024;   // Per core, internal RAM; ~1s at the default rate
+    static constexpr uint32_t TIMER_HZ = 1000000;
+    static constexpr uint32_t MAX_BUCKETS = 8192;
+    static constexpr uint32_t MAX_TASKS = 48;
+    static constexpr uint32_t DRAIN_MS = 50;
+    static constexpr uint32_t MIN_HZ = 10;
+    static constexpr uint32_t MAX_HZ = 10000;
+
+    static SamplingProfiler& getInstance();
+
+    bool start(const SamplingProfileConfig& config = SamplingProfileConfig());
+    // Ends the run early; what was sampled is still written
+    void stop();
+    bool isRunning() const
+    {
+        return _taskAlive.load(std::memory_order_acquire);
+    }
+    SamplingProfileReport getReport();
+
+private:
+    SamplingProfiler() = default;
+    SamplingProfiler(const SamplingProfiler&) = delete;
+    SamplingProfiler& operator=(const SamplingProfiler&) = delete;
+
+    struct Sample {
+        uint32_t pc;
+        TaskHandle_t task;
+    };
+    // ISR → aggregator, one per core
+    struct CoreRing {
+        Sample* slots = nullptr;
+        std::atomic<uint32_t> head{0};  // ISR
+        std::atomic<uint32_t> tail{0};  // Aggregator
+        std::atomic<uint32_t> dropped{0};
+        std::atomic<bool> armed{false};  // Timer running
+        TaskHandle_t owner = nullptr;    // Helper task holding the timer
+        SamplingProfiler* self = nullptr;
+        int core = 0;
+    };
+    struct Bucket {
+        uint32_t pc;  // Bucket base
+        TaskHandle_t task;
+        uint32_t count;  // 0 = free
+        uint8_t core;
+    };
+    struct TaskName {
+        TaskHandle_t handle;
+        char name[configMAX_TASK_NAME_LEN];
+    };
+
+    static bool sampleIsr(gptimer_handle_t timer, const gptimer_alarm_event_data_t* event, void* ctx);
+    static void timerTask(void* arg);
+    static void aggregatorTask(void* arg);
+    void run();
+    void drain();
+    void bin(int core, const Sample& s);
+    void learnTaskNames();
+    const char* taskName(TaskHandle_t handle);
+    bool dump();
+
+    std::mutex _mutex;  // start/stop, _report
+    SamplingProfileConfig _config;
+    SamplingProfileReport _report;
+    std::atomic<bool> _stopRequested{false};
+    std::atomic<bool> _taskAlive{false};
+    TaskHandle_t _task = nullptr;
+    CoreRing _rings[2];
+    uint32_t _dumpIndex = 0;
+
+    // Aggregator-only
+    Bucket* _buckets = nullptr;  // MAX_BUCKETS in PSRAM, kept once allocated
+    uint32_t _bucketCount = 0;
+    uint32_t _unbinned = 0;
+    uint32_t _binned[2] = {};
+    TaskName _names[MAX_TASKS] = {};
+    uint32_t _nameCount = 0;
+    bool _namesLearned = false;  // A snapshot was taken this drain
+};
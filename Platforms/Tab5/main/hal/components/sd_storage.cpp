@@ -0,0 +1,276 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "sd_storage.h"
+#include "../utils/core_policy/core_policy.h"
+#include <mooncake_log.h>
+#include <bsp/m5stack_tab5.h>
+#include <algorithm>
+#include <cstring>
+#include <dirent.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <unistd.h>
+
+static const char* TAG = "SdStorage";
+
+SdStorage& SdStorage::getInstance()
+{
+    static SdStorage instance;
+    return instance;
+}
+
+bool SdStorage::startWorker()
+{
+    if (_worker) return true;
+    _queue = xQueueCreate(QUEUE_LEN, sizeof(Request));
+    if (!_queue) {
+        mclog::tagError(TAG, "failed to create job queue");
+        return false;
+    }
+    // Low priority: SD latency is allowed to be seconds, the UI and audio are not
+    if (xTaskCreatePinnedToCore(workerTask, "sd_storage", 4096, this, 3, &_worker, core_policy::SYSTEM_AFFINITY) !=
+        pdPASS) {
+        mclog::tagError(TAG, "failed to create worker task");
+        vQueueDelete(_queue);
+        _queue  = nullptr;
+        _worker = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool SdStorage::mount()
+{
+    if (_mounted.load(std::memory_order_acquire)) return true;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_mounted.load(std::memory_order_relaxed)) return true;
+    if (_suspended.load(std::memory_order_relaxed)) return false;
+    startWorker();
+
+    const TickType_t now = xTaskGetTickCount();
+    if (_attempted && now - _lastAttempt < pdMS_TO_TICKS(RETRY_MS)) return false;
+    _attempted   = true;
+    _lastAttempt = now;
+
+    if (bsp_sdcard_init(const_cast<char*>(MOUNT_POINT), MAX_FILES) != ESP_OK) {
+        mclog::tagError(TAG, "failed to mount SD card");
+        return false;
+    }
+    _generation.fetch_add(1, std::memory_order_relaxed);
+    _mounted.store(true, std::memory_order_release);
+    mclog::tagInfo(TAG, "SD card mounted at {}", MOUNT_POINT);
+    return true;
+}
+
+bool SdStorage::post(Job job, void* arg)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!startWorker()) return false;
+    }
+    const Request req{job, arg};
+    if (xQueueSend(_queue, &req, 0) != pdTRUE) {
+        mclog::tagWarn(TAG, "job queue full");
+        return false;
+    }
+    return true;
+}
+
+void SdStorage::suspend()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_suspended.load(std::memory_order_relaxed)) return;
+    _suspended.store(true, std::memory_order_release);
+    if (_mounted.load(std::memory_order_relaxed)) {
+        _mounted.store(false, std::memory_order_release);
+        bsp_sdcard_deinit(const_cast<char*>(MOUNT_POINT));
+    }
+    mclog::tagInfo(TAG, "SD card handed over, {} unmounted", MOUNT_POINT);
+}
+
+void SdStorage::resume()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_suspended.load(std::memory_order_relaxed)) return;
+    _suspended.store(false, std::memory_order_release);
+    // The next mount() is a new generation: the host may have changed anything
+    _attempted = false;
+    mclog::tagInfo(TAG, "SD card back");
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Worker
+// ─────────────────────────────────────────────────────────────────────────────
+
+void SdStorage::workerTask(void* param)
+{
+    static_cast<SdStorage*>(param)->workerLoop();
+}
+
+void SdStorage::workerLoop()
+{
+    for (;;) {
+        Request req;
+        if (xQueueReceive(_queue, &req, pdMS_TO_TICKS(WATCH_MS)) == pdTRUE) {
+            req.job(req.arg);
+        } else {
+            checkCard();
+        }
+    }
+}
+
+void SdStorage::checkCard()
+{
+    if (!_mounted.load(std::memory_order_acquire)) return;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (bsp_sdcard_get_status() == ESP_OK) return;
+
+    // Open files on the old card fail from here on; the next mount() brings a new generation
+    mclog::tagWarn(TAG, "SD card removed, unmounting");
+    _mounted.store(false, std::memory_order_release);
+    bsp_sdcard_deinit(const_cast<char*>(MOUNT_POINT));
+    _attempted = false;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Directory scan
+// ─────────────────────────────────────────────────────────────────────────────
+
+size_t SdStorage::scanDir(const char* path, DirVisit visit, void* user, size_t offset, size_t limit, bool* more)
+{
+    if (more) *more = false;
+    DIR* dir = opendir(path);
+    if (!dir) {
+        mclog::tagError(TAG, "failed to open directory: {}", path);
+        return 0;
+    }
+
+    SdDirEntry e;
+    size_t seen = 0;
+    size_t visited = 0;
+    struct dirent* d;
+    while ((d = readdir(dir)) != nullptr) {
+        if (strcmp(d->d_name, ".") == 0 || strcmp(d->d_name, "..") == 0) continue;
+        if (seen++ < offset) continue;
+        if (limit && visited == limit) {
+            if (more) *more = true;
+            break;
+        }
+        snprintf(e.name, sizeof(e.name), "%s", d->d_name);
+        e.isDir = d->d_type == DT_DIR;
+        visited++;
+        if (!visit(e, user)) break;
+    }
+    closedir(dir);
+    return visited;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Bulk I/O
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool SdStorage::reserve(FILE* f, uint32_t& reserved, uint32_t bytes)
+{
+    if (bytes <= reserved) return true;
+    const long pos = ftell(f);
+    uint32_t target = reserved;
+    while (target < bytes) target += PREALLOC_STEP;
+    // FatFs allocates the cluster chain when a writable file is seeked past its end
+    if (pos < 0 || fseek(f, static_cast<long>(target), SEEK_SET) != 0 || fseek(f, pos, SEEK_SET) != 0) {
+        return false;
+    }
+    reserved = target;
+    return true;
+}
+
+bool SdStorage::startBenchmark()
+{
+    int idle = BENCH_IDLE;
+    if (!_benchState.compare_exchange_strong(idle, BENCH_RUNNING)) {
+        int done = BENCH_DONE;
+        if (!_benchState.compare_exchange_strong(done, BENCH_RUNNING)) return false;
+    }
+    if (!post(benchmarkJob, this)) {
+        _benchState.store(BENCH_IDLE, std::memory_order_release);
+        return false;
+    }
+    return true;
+}
+
+bool SdStorage::getBenchmark(SdBenchResult& out)
+{
+    if (_benchState.load(std::memory_order_acquire) != BENCH_DONE) return false;
+    out = _benchResult;
+    return true;
+}
+
+void SdStorage::benchmarkJob(void* arg)
+{
+    auto* self = static_cast<SdStorage*>(arg);
+    self->_benchResult = self->runBenchmark();
+    self->_benchState.store(BENCH_DONE, std::memory_order_release);
+}
+
+SdBenchResult SdStorage::runBenchmark()
+{
+    SdBenchResult r;
+    if (!mount()) return r;
+    bsp_sdcard_get_bus_info(&r.freqKhz, &r.busWidth);
+
+    auto* buf = static_cast<uint8_t*>(
+        heap_caps_aligned_alloc(64, IO_CHUNK, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA | MALLOC_CAP_8BIT));
+    if (!buf) {
+        mclog::tagError(TAG, "benchmark: no internal RAM for the buffer");
+        return r;
+    }
+    for (uint32_t i = 0; i < IO_CHUNK; i++) buf[i] = static_cast<uint8_t>(i * 31 + 7);
+
+    const char* path = "/sd/.sdbench.tmp";
+    FILE* f = fopen(path, "wb");
+    bool ok = f != nullptr;
+    if (ok) {
+        setvbuf(f, nullptr, _IONBF, 0);
+        uint32_t reserved = 0;
+        ok = reserve(f, reserved, BENCH_BYTES);
+        const int64_t t0 = esp_timer_get_time();
+        for (uint32_t done = 0; ok && done < BENCH_BYTES; done += IO_CHUNK) {
+            const int64_t w0 = esp_timer_get_time();
+            ok = fwrite(buf, 1, IO_CHUNK, f) == IO_CHUNK;
+            r.worstWriteUs = std::max(r.worstWriteUs, static_cast<uint32_t>(esp_timer_get_time() - w0));
+        }
+        ok = ok && fsync(fileno(f)) == 0;
+        const int64_t t1 = esp_timer_get_time();
+        fclose(f);
+        if (ok && t1 > t0) r.writeKBps = static_cast<uint32_t>(BENCH_BYTES * 1000000ull / 1024 / (t1 - t0));
+    }
+
+    if (ok && (f = fopen(path, "rb")) != nullptr) {
+        setvbuf(f, nullptr, _IONBF, 0);
+        const int64_t t0 = esp_timer_get_time();
+        for (uint32_t done = 0; ok && done < BENCH_BYTES; done += IO_CHUNK) {
+            ok = fread(buf, 1, IO_CHUNK, f) == IO_CHUNK;
+        }
+        const int64_t t1 = esp_timer_get_time();
+        fclose(f);
+        if (ok && t1 > t0) r.readKBps = static_cast<uint32_t>(BENCH_BYTES * 1000000ull / 1024 / (t1 - t0));
+    } else {
+        ok = false;
+    }
+    remove(path);
+    heap_caps_free(buf);
+
+    r.ok = ok;
+    r.bytes = ok ? BENCH_BYTES : 0;
+    if (ok) {
+        mclog::tagInfo(TAG, "benchmark: write {} KB/s (worst chunk {} us), read {} KB/s, {} kHz {}-bit",
+            r.writeKBps, r.worstWriteUs, r.readKBps, r.freqKhz, r.busWidth);
+    } else {
+        mclog::tagError(TAG, "benchmark failed");
+    }
+    return r;
+}
@@ -0,0 +1,140 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+/**
+ * @brief Owner of the /sd mount and the storage worker task
+ *
+ * The card is mounted on first use and stays mounted; callers that used to
+ * init/deinit the BSP SD card around every operation call mount() instead,
+ * which is a flag check once the card is up. The slot has no card-detect
+ * line, so the worker task polls the card status every WATCH_MS while idle
+ * and unmounts when the card stops answering. A failed mount is not retried
+ * for RETRY_MS, so a missing card doesn't stall every caller.
+ *
+ * generation() changes on every successful mount; anything caching card
+ * contents compares it to know when a (possibly different) card came back.
+ * Work posted with post() runs in order on the worker task.
+ *
+ * suspend() hands the card to another owner (USB mass storage): the FAT mount
+ * is released and mount() fails until resume(), so nothing on the device
+ * touches the filesystem while a host does.
+ */
+struct SdBenchResult {
+    bool ok = false;
+    uint32_t bytes = 0;        // Written, then read back
+    uint32_t writeKBps = 0;    // Including the closing fsync
+    uint32_t readKBps = 0;
+    uint32_t worstWriteUs = 0; // Slowest single IO_CHUNK write
+    uint32_t freqKhz = 0;      // Bus the card was brought up with
+    uint8_t busWidth = 0;
+};
+
+// One directory entry, valid for the duration of the visit
+struct SdDirEntry {
+    char name[256];  // FatFs long names are at most 255 bytes
+    bool isDir;
+};
+
+class SdStorage {
+public:
+    static constexpr const char* MOUNT_POINT = "/sd";
+    static constexpr int MAX_FILES = 25;
+    static constexpr int WATCH_MS = 1000;
+    static constexpr int RETRY_MS = 2000;
+    static constexpr int QUEUE_LEN = 16;
+    // Bulk writers (recorder) move data in IO_CHUNK writes from 64-byte-aligned
+    // internal RAM the SDMMC DMA reads directly, unbuffered, into extents grown
+    // PREALLOC_STEP at a time so the FAT isn't updated on every write
+    static constexpr uint32_t IO_CHUNK = 32 * 1024;
+    static constexpr uint32_t PREALLOC_STEP = 8 * 1024 * 1024;
+    static constexpr uint32_t BENCH_BYTES = 4 * 1024 * 1024;
+
+    using Job = void (*)(void* arg);
+    using DirVisit = bool (*)(const SdDirEntry& entry, void* user);  // false stops the scan
+
+    static SdStorage& getInstance();
+
+    // Mount if not mounted yet; true when the card is usable
+    bool mount();
+    bool isMounted() const
+    {
+        return _mounted.load(std::memory_order_acquire);
+    }
+    uint32_t generation() const
+    {
+        return _generation.load(std::memory_order_acquire);
+    }
+    // Run job(arg) on the storage task; false (job not run) if the queue is full
+    bool post(Job job, void* arg);
+
+    // Unmount and keep the card unmounted until resume(); files open on it fail
+    // from here on. Call from a posted job so queued work finishes first.
+    void suspend();
+    void resume();
+    bool isSuspended() const
+    {
+        return _suspended.load(std::memory_order_acquire);
+    }
+
+    // Stream the entries of `path` (an absolute VFS path; "." and ".." left out)
+    // through visit, with no allocation per entry: skip `offset`, then visit up to
+    // `limit` (0 = all). Returns the number visited; *more says whether entries
+    // remain past the page. The card must be mounted.
+    static size_t scanDir(const char* path, DirVisit visit, void* user, size_t offset = 0, size_t limit = 0,
+                          bool* more = nullptr);
+
+    // Sequential throughput test (BENCH_BYTES written and read back in IO_CHUNKs)
+    // on the storage task. false while one is queued or running.
+    bool startBenchmark();
+    bool isBenchmarkRunning() const
+    {
+        return _benchState.load(std::memory_order_acquire) == BENCH_RUNNING;
+    }
+    // true once a finished result is available
+    bool getBenchmark(SdBenchResult& out);
+
+    // Grow f's allocation to at least `bytes` in PREALLOC_STEPs; the file
+    // position is kept. Trim with ftruncate() when the file is closed.
+    static bool reserve(FILE* f, uint32_t& reserved, uint32_t bytes);
+
+private:
+    SdStorage() = default;
+    SdStorage(const SdStorage&) = delete;
+    SdStorage& operator=(const SdStorage&) = delete;
+
+    struct Request {
+        Job job;
+        void* arg;
+    };
+
+    enum { BENCH_IDLE, BENCH_RUNNING, BENCH_DONE };
+
+    bool startWorker();
+    static void workerTask(void* param);
+    void workerLoop();
+    void checkCard();
+    static void benchmarkJob(void* arg);
+    SdBenchResult runBenchmark();
+
+    std::mutex _mutex;  // Mount state changes
+    std::atomic<bool> _mounted{false};
+    std::atomic<bool> _suspended{false};
+    std::atomic<uint32_t> _generation{0};
+    TickType_t _lastAttempt = 0;
+    bool _attempted = false;
+    QueueHandle_t _queue = nullptr;
+    TaskHandle_t _worker = nullptr;
+    std::atomic<int> _benchState{BENCH_IDLE};
+    SdBenchResult _benchResult;  // Written by the worker before BENCH_DONE
+};
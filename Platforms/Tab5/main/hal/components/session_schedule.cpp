@@ -0,0 +1,117 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "session_schedule.h"
+#include "profile_schema.h"
+#include "nvs_storage.h"
+#include <mooncake_log.h>
+#include <vector>
+#include <nvs.h>
+
+static const char* TAG = "Schedule";
+
+static constexpr size_t MAX_BLOB_BYTES = 8 * 1024;
+
+SessionSchedule& SessionSchedule::getInstance()
+{
+    static SessionSchedule instance;
+    return instance;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Booking
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool SessionSchedule::arm(uint8_t hour, uint8_t minute, const AudioEngineParams& session)
+{
+    if (hour > 23 || minute > 59) return false;
+    if (!NvsStorage::getInstance().ready()) return false;
+
+    std::vector<uint32_t> records;
+    ProfileSchema::encode(session, records);
+
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (ret == ESP_OK) {
+        // Profile first: a time key is never left pointing at an older profile
+        ret = nvs_set_blob(nvs, NVS_PARAMS_KEY, records.data(), records.size() * sizeof(uint32_t));
+        if (ret == ESP_OK) ret = nvs_set_u16(nvs, NVS_TIME_KEY, static_cast<uint16_t>(hour << 8 | minute));
+        if (ret == ESP_OK) ret = nvs_commit(nvs);
+        nvs_close(nvs);
+    }
+    if (ret != ESP_OK) {
+        mclog::tagError(TAG, "booking failed: {}", esp_err_to_name(ret));
+        return false;
+    }
+    mclog::tagInfo(TAG, "session booked for {:02d}:{:02d}", hour, minute);
+    return true;
+}
+
+void SessionSchedule::disarm()
+{
+    if (!NvsStorage::getInstance().ready()) return;
+    nvs_handle_t nvs;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) return;
+    if (nvs_erase_key(nvs, NVS_TIME_KEY) == ESP_OK) nvs_commit(nvs);
+    nvs_close(nvs);
+}
+
+bool SessionSchedule::isArmed(uint8_t* hour, uint8_t* minute)
+{
+    if (!NvsStorage::getInstance().ready()) return false;
+    nvs_handle_t nvs;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) return false;
+    uint16_t time = 0;
+    const esp_err_t ret = nvs_get_u16(nvs, NVS_TIME_KEY, &time);
+    nvs_close(nvs);
+    if (ret != ESP_OK) return false;
+    if (hour) *hour = time >> 8;
+    if (minute) *minute = time & 0xFF;
+    return true;
+}
+
+bool SessionSchedule::claim(bool alarmFired)
+{
+    uint8_t hour = 0, minute = 0;
+    if (!isArmed(&hour, &minute)) return false;
+    disarm();
+    if (!alarmFired) {
+        // Powered on by hand before the alarm: the booking is dropped, the RTC alarm was disabled at boot
+        mclog::tagInfo(TAG, "booking for {:02d}:{:02d} cancelled by a manual power-on", hour, minute);
+        return false;
+    }
+    _claimed = true;
+    mclog::tagInfo(TAG, "woken for the {:02d}:{:02d} session", hour, minute);
+    return true;
+}
+
+bool SessionSchedule::loadSession(AudioEngineParams& params)
+{
+    if (!_claimed || !NvsStorage::getInstance().ready()) return false;
+
+    nvs_handle_t nvs;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) return false;
+    size_t bytes = 0;
+    std::vector<uint32_t> records;
+    esp_err_t ret = nvs_get_blob(nvs, NVS_PARAMS_KEY, nullptr, &bytes);
+    if (ret == ESP_OK && bytes > 0 && bytes <= MAX_BLOB_BYTES && bytes % (2 * sizeof(uint32_t)) == 0) {
+        records.resize(bytes / sizeof(uint32_t));
+        ret = nvs_get_blob(nvs, NVS_PARAMS_KEY, records.data(), &bytes);
+    } else if (ret == ESP_OK) {
+        ret = ESP_ERR_INVALID_SIZE;
+    }
+    nvs_close(nvs);
+    if (ret != ESP_OK) {
+        mclog::tagWarn(TAG, "session profile unreadable: {}", esp_err_to_name(ret));
+        return false;
+    }
+
+    ProfileSchema::decode(records.data(), static_cast<int>(records.size() / 2), params);
+    // From silence: the session envelope is the fade-in
+    params.tinnitus.sessionActive = true;
+    params.tinnitus.sessionElapsedMs = 0;
+    params.outputMute = false;
+    return true;
+}
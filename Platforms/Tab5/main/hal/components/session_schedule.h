@@ -0,0 +1,49 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include "audio_engine.h"
+#include <cstdint>
+
+/**
+ * @brief A tinnitus session booked for an RTC alarm wake-up, kept in NVS
+ *
+ * arm() stores the wake time and the session profile (engine params as
+ * ProfileSchema records, like SessionStore) before the device powers off with
+ * the RX8130 alarm set. At the next boot the HAL claim()s the booking when the
+ * alarm flag is what powered it on: the booking is one-shot and is cleared
+ * then, so a later power-on by hand boots normally. The profile comes back
+ * with the session timer started from zero and the output unmuted, so the
+ * session envelope fades it in over sessionFadeMs.
+ */
+class SessionSchedule {
+public:
+    static constexpr const char* NVS_NAMESPACE = "howizard";
+    static constexpr const char* NVS_TIME_KEY = "sched_time";      // hour << 8 | minute
+    static constexpr const char* NVS_PARAMS_KEY = "sched_params";
+
+    static SessionSchedule& getInstance();
+
+    // false if NVS could not take it; nothing is armed then
+    bool arm(uint8_t hour, uint8_t minute, const AudioEngineParams& session);
+    void disarm();
+    bool isArmed(uint8_t* hour = nullptr, uint8_t* minute = nullptr);
+
+    // Boot: the RTC alarm fired with a booking armed. Clears the booking either way.
+    bool claim(bool alarmFired);
+    bool isClaimed() const
+    {
+        return _claimed;
+    }
+    // The claimed booking's profile, ready to start; false if unreadable
+    bool loadSession(AudioEngineParams& params);
+
+private:
+    SessionSchedule() = default;
+    SessionSchedule(const SessionSchedule&) = delete;
+    SessionSchedule& operator=(const SessionSchedule&) = delete;
+
+    bool _claimed = false;
+};
@@ -0,0 +1,392 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "session_store.h"
+#include "profile_schema.h"
+#include "nvs_storage.h"
+#include "../utils/core_policy/core_policy.h"
+#include <algorithm>
+#include <cstddef>
+#include <mooncake_log.h>
+#include <esp_rom_crc.h>
+#include <nvs.h>
+
+static const char* TAG = "Session";
+
+static constexpr size_t MAX_BLOB_BYTES = 8 * 1024;
+static constexpr size_t MAX_SECTORS = 64;
+
+SessionStore& SessionStore::getInstance()
+{
+    static SessionStore instance;
+    return instance;
+}
+
+void SessionStore::encodeSession(const AudioEngineParams& params, std::vector<uint32_t>& records)
+{
+    AudioEngineParams p = params;
+    p.outputMute = true;  // Toggling mute is not a settings change worth a flash write
+    ProfileSchema::encode(p, records);
+}
+
+bool SessionStore::recordValid(const JournalRecord& r)
+{
+    return r.seq != 0 && r.seq != UINT32_MAX &&
+           r.check == esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&r), offsetof(JournalRecord, check));
+}
+
+bool SessionStore::load(AudioEngineParams& params)
+{
+    if (!NvsStorage::getInstance().ready()) return false;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    openJournal();
+
+    nvs_handle_t nvs;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        mclog::tagInfo(TAG, "no stored session{}", NvsStorage::getInstance().wasErased() ? " (NVS was erased)" : "");
+        return false;
+    }
+    size_t bytes = 0;
+    std::vector<uint32_t> records;
+    esp_err_t ret = nvs_get_blob(nvs, NVS_KEY, nullptr, &bytes);
+    if (ret == ESP_OK && bytes > 0 && bytes <= MAX_BLOB_BYTES && bytes % (2 * sizeof(uint32_t)) == 0) {
+        records.resize(bytes / sizeof(uint32_t));
+        ret = nvs_get_blob(nvs, NVS_KEY, records.data(), &bytes);
+    } else if (ret == ESP_OK) {
+        ret = ESP_ERR_INVALID_SIZE;
+    }
+    nvs_close(nvs);
+    if (ret != ESP_OK) {
+        // The journal is a diff against a snapshot; without one its records are dropped
+        if (ret != ESP_ERR_NVS_NOT_FOUND) mclog::tagWarn(TAG, "stored session unreadable: {}", esp_err_to_name(ret));
+        return false;
+    }
+
+    ProfileSchema::decode(records.data(), static_cast<int>(records.size() / 2), params);
+    params.outputMute = true;
+    encodeSession(params, _stored);
+
+    const int replayed = replayJournal(params);
+    encodeSession(params, _journaled);
+    _expected = _journaled;
+    mclog::tagInfo(TAG, "restored last session ({} bytes, {} journal records)", bytes, replayed);
+    return true;
+}
+
+bool SessionStore::write(const std::vector<uint32_t>& records, uint32_t seq)
+{
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (ret == ESP_OK) {
+        // Blob first: a crash in between leaves an older seq, and replaying records
+        // the blob already holds is harmless
+        ret = nvs_set_blob(nvs, NVS_KEY, records.data(), records.size() * sizeof(uint32_t));
+        if (ret == ESP_OK) ret = nvs_set_u32(nvs, NVS_SEQ_KEY, seq);
+        if (ret == ESP_OK) ret = nvs_commit(nvs);
+        nvs_close(nvs);
+    }
+    if (ret != ESP_OK) {
+        mclog::tagError(TAG, "session write failed: {}", esp_err_to_name(ret));
+        return false;
+    }
+    _stored = records;
+    _snapSeq = seq;
+    mclog::tagInfo(TAG, "session saved");
+    return true;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Journal ring
+// ─────────────────────────────────────────────────────────────────────────────
+
+void SessionStore::openJournal()
+{
+    if (_journalOpened) return;
+    _journalOpened = true;
+
+    nvs_handle_t nvs;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK) {
+        if (nvs_get_u32(nvs, NVS_SEQ_KEY, &_snapSeq) != ESP_OK) _snapSeq = 0;
+        nvs_close(nvs);
+    }
+    _seq = _snapSeq;
+
+    _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                          static_cast<esp_partition_subtype_t>(JOURNAL_SUBTYPE), JOURNAL_PARTITION);
+    if (!_partition) {
+        mclog::tagWarn(TAG, "no journal partition, session kept as snapshot only");
+        return;
+    }
+    const size_t sectors = std::min<size_t>(_partition->size / SECTOR_BYTES, MAX_SECTORS);
+    if (sectors < 2) {
+        mclog::tagWarn(TAG, "journal partition too small");
+        _partition = nullptr;
+        return;
+    }
+    _slots = sectors * RECORDS_PER_SECTOR;
+    _sectorFirst.assign(sectors, 0);
+    _sectorLast.assign(sectors, 0);
+    _sectorDirty.assign(sectors, false);
+
+    // The newest record sits in the sector with the highest seq; the ring resumes
+    // after the last slot programmed there (a torn record is skipped, not reused)
+    std::vector<JournalRecord> buf(RECORDS_PER_SECTOR);
+    size_t newest = sectors;
+    size_t newestUsed = 0;
+    uint32_t maxSeq = 0;
+    for (size_t s = 0; s < sectors; s++) {
+        if (esp_partition_read(_partition, s * SECTOR_BYTES, buf.data(), SECTOR_BYTES) != ESP_OK) {
+            mclog::tagError(TAG, "journal read failed");
+            _partition = nullptr;
+            return;
+        }
+        size_t used = 0;
+        for (size_t k = 0; k < RECORDS_PER_SECTOR; k++) {
+            const JournalRecord& r = buf[k];
+            if (r.seq == UINT32_MAX && r.tag == UINT32_MAX && r.value == UINT32_MAX && r.check == UINT32_MAX) continue;
+            used = k + 1;
+            _sectorDirty[s] = true;
+            if (!recordValid(r)) continue;
+            if (_sectorFirst[s] == 0 || r.seq < _sectorFirst[s]) _sectorFirst[s] = r.seq;
+            _sectorLast[s] = std::max(_sectorLast[s], r.seq);
+        }
+        if (_sectorLast[s] > maxSeq) {
+            maxSeq = _sectorLast[s];
+            newest = s;
+            newestUsed = used;
+        }
+    }
+    // A reflashed / erased partition restarts below the snapshot: keep counting past it
+    _seq = std::max(maxSeq, _snapSeq);
+    _head = newest == sectors ? 0 : (newest * RECORDS_PER_SECTOR + newestUsed) % _slots;
+    mclog::tagInfo(TAG, "journal: {} sectors, seq {}, snapshot at {}", sectors, _seq, _snapSeq);
+}
+
+int SessionStore::replayJournal(AudioEngineParams& params)
+{
+    if (!_partition) return 0;
+
+    // Sectors in write order; only ones with records past the snapshot matter
+    std::vector<size_t> order;
+    for (size_t s = 0; s < _sectorLast.size(); s++) {
+        if (_sectorLast[s] > _snapSeq) order.push_back(s);
+    }
+    std::sort(order.begin(), order.end(), [this](size_t a, size_t b) { return _sectorFirst[a] < _sectorFirst[b]; });
+
+    std::vector<JournalRecord> buf(RECORDS_PER_SECTOR);
+    int replayed = 0;
+    for (size_t s : order) {
+        if (esp_partition_read(_partition, s * SECTOR_BYTES, buf.data(), SECTOR_BYTES) != ESP_OK) break;
+        for (const JournalRecord& r : buf) {
+            if (!recordValid(r) || r.seq <= _snapSeq) continue;
+            if (const ProfileSchema::Field* f = ProfileSchema::findTag(r.tag)) ProfileSchema::setRaw(*f, r.value, params);
+            replayed++;
+        }
+    }
+    params.outputMute = true;
+    return replayed;
+}
+
+bool SessionStore::appendRecord(uint32_t tag, uint32_t value)
+{
+    const size_t slot = _head;
+    const size_t sector = slot / RECORDS_PER_SECTOR;
+    if (slot % RECORDS_PER_SECTOR == 0 && _sectorDirty[sector]) {
+        // Come round to the oldest sector: records in it the snapshot doesn't cover go into one first
+        if (_sectorLast[sector] > _snapSeq && !write(_journaled, _seq)) return false;
+        if (esp_partition_erase_range(_partition, sector * SECTOR_BYTES, SECTOR_BYTES) != ESP_OK) return false;
+        _sectorDirty[sector] = false;
+        _sectorFirst[sector] = 0;
+        _sectorLast[sector] = 0;
+    }
+
+    JournalRecord r = {_seq + 1, tag, value, 0};
+    r.check = esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&r), offsetof(JournalRecord, check));
+    _sectorDirty[sector] = true;  // Even if the write fails part-way
+    _head = (slot + 1) % _slots;
+    if (esp_partition_write(_partition, slot * sizeof(JournalRecord), &r, sizeof(r)) != ESP_OK) return false;
+    _seq = r.seq;
+    if (_sectorFirst[sector] == 0) _sectorFirst[sector] = r.seq;
+    _sectorLast[sector] = r.seq;
+    return true;
+}
+
+void SessionStore::journal(const std::vector<uint32_t>& current)
+{
+    for (size_t i = 1; i < current.size(); i += 2) {
+        if (current[i] == _journaled[i]) continue;
+        if (_partition && !appendRecord(current[i - 1], current[i])) {
+            // The snapshot will carry the change; crash safety falls back to it
+            mclog::tagError(TAG, "journal write failed, snapshot only from now");
+            _partition = nullptr;
+        }
+        _journaled[i] = current[i];
+    }
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Undo history
+// ─────────────────────────────────────────────────────────────────────────────
+
+void SessionStore::capture(const std::vector<uint32_t>& current, TickType_t now)
+{
+    if (_expected.size() != current.size()) {
+        _expected = current;
+        return;
+    }
+
+    bool changed = false;
+    for (size_t i = 1; i < current.size(); i += 2) {
+        if (current[i] == _expected[i]) continue;
+        changed = true;
+        if (!_stepOpen) {
+            _undo.emplace_back();
+            if (_undo.size() > UNDO_DEPTH) _undo.pop_front();
+            _redo.clear();
+            _stepOpen = true;
+        }
+        Step& step = _undo.back();
+        const uint32_t tag = current[i - 1];
+        auto it = std::find_if(step.begin(), step.end(), [tag](const Change& c) { return c.tag == tag; });
+        if (it == step.end()) {
+            step.push_back({tag, _expected[i], current[i]});
+        } else if (it->before == current[i]) {
+            step.erase(it);  // Dragged back to where it started
+        } else {
+            it->after = current[i];
+        }
+    }
+    _expected = current;
+    if (changed) {
+        _stepAt = now;
+    } else if (_stepOpen && now - _stepAt >= pdMS_TO_TICKS(STEP_QUIET_MS)) {
+        closeStep();
+    }
+    publishHistory();
+}
+
+void SessionStore::closeStep()
+{
+    if (!_stepOpen) return;
+    _stepOpen = false;
+    if (_undo.back().empty()) _undo.pop_back();
+}
+
+bool SessionStore::travel(std::deque<Step>& from, std::deque<Step>& to, bool forward)
+{
+    auto& engine = AudioEngine::getInstance();
+    AudioEngineParams params = engine.getParams();
+    std::vector<uint32_t> current;
+    encodeSession(params, current);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_task) return false;
+    // Edits the watch task hasn't seen yet end the open step first
+    capture(current, xTaskGetTickCount());
+    closeStep();
+    if (from.empty()) {
+        publishHistory();
+        return false;
+    }
+
+    for (const Change& c : from.back()) {
+        if (const ProfileSchema::Field* f = ProfileSchema::findTag(c.tag)) {
+            ProfileSchema::setRaw(*f, forward ? c.after : c.before, params);
+        }
+    }
+    engine.setParams(params);
+    to.push_back(std::move(from.back()));
+    from.pop_back();
+    // Journaled by the next poll, but not a new step
+    encodeSession(params, _expected);
+    publishHistory();
+    return true;
+}
+
+bool SessionStore::undo()
+{
+    return travel(_undo, _redo, false);
+}
+
+bool SessionStore::redo()
+{
+    return travel(_redo, _undo, true);
+}
+
+void SessionStore::publishHistory()
+{
+    _canUndo.store(!_undo.empty() && !_undo.back().empty(), std::memory_order_relaxed);
+    _canRedo.store(!_redo.empty(), std::memory_order_relaxed);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Watch task
+// ─────────────────────────────────────────────────────────────────────────────
+
+void SessionStore::start()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_task) return;
+    if (!NvsStorage::getInstance().ready()) return;
+    openJournal();
+    if (xTaskCreatePinnedToCore(watchTask, "session", 3072, this, 1, &_task, core_policy::SYSTEM_AFFINITY) != pdPASS) {
+        mclog::tagError(TAG, "failed to create watch task");
+        _task = nullptr;
+    }
+}
+
+void SessionStore::flush()
+{
+    std::vector<uint32_t> records;
+    encodeSession(AudioEngine::getInstance().getParams(), records);
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_journaled.empty()) {
+        _journaled = records;
+    } else {
+        journal(records);
+    }
+    if (_journaled != _stored) write(_journaled, _seq);
+}
+
+void SessionStore::watchTask(void* param)
+{
+    static_cast<SessionStore*>(param)->watchLoop();
+}
+
+void SessionStore::watchLoop()
+{
+    std::vector<uint32_t> current;
+    TickType_t changedAt = xTaskGetTickCount();
+    TickType_t lastWrite = changedAt;  // No snapshot in the first minutes after boot
+
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(POLL_MS));
+        encodeSession(AudioEngine::getInstance().getParams(), current);
+        const TickType_t now = xTaskGetTickCount();
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_journaled.empty()) {
+            // Nothing restored: journal records need a snapshot to apply to
+            _journaled = current;
+            _expected = current;
+            write(_journaled, _seq);
+            lastWrite = now;
+            continue;
+        }
+        capture(current, now);
+        if (current != _journaled) {
+            journal(current);
+            changedAt = now;
+            continue;
+        }
+        if (_journaled == _stored || now - changedAt < pdMS_TO_TICKS(SETTLE_MS) ||
+            now - lastWrite < pdMS_TO_TICKS(MIN_INTERVAL_MS)) {
+            continue;
+        }
+        write(_journaled, _seq);
+        lastWrite = now;
+    }
+}
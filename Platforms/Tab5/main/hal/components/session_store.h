@@ -0,0 +1,133 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include "audio_engine.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <esp_partition.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+/**
+ * @brief Last-session engine params in NVS plus a change journal, for a boot that doesn't wait on SD
+ *
+ * The params are stored as ProfileSchema binary records (tag, value pairs), so
+ * a firmware update that adds or reorders fields still restores the rest. A
+ * low-priority task samples the engine params every POLL_MS and appends each
+ * field that changed as one 16-byte (sequence, tag, value, CRC) record to the
+ * "journal" flash partition, a ring of erase sectors: a slider move costs a
+ * record, not a rewrite of the whole session, and a crash loses at most one
+ * poll of edits. The NVS blob is the journal's snapshot: once the params have
+ * been unchanged for SETTLE_MS, at most every MIN_INTERVAL_MS, it is rewritten
+ * with the sequence number it covers, and when the ring comes round to a
+ * sector holding records newer than that, the snapshot is taken first. load()
+ * replays the records past the snapshot on top of it. A sector erase (which
+ * stalls the audio core on cache-disabled flash access, like an NVS write)
+ * happens once every RECORDS_PER_SECTOR records. flush() journals and
+ * snapshots a pending change at once, for app close. Without the partition
+ * the snapshot alone is kept, as before the journal.
+ *
+ * The same diffs feed an in-RAM undo history: changes closer together than
+ * STEP_QUIET_MS (one slider drag, a profile load) form one step, up to
+ * UNDO_DEPTH steps. undo() / redo() set the engine params and are journaled
+ * like any other change.
+ *
+ * Mute is not part of the session: the engine always starts muted.
+ */
+class SessionStore {
+public:
+    static constexpr const char* NVS_NAMESPACE = "howizard";
+    static constexpr const char* NVS_KEY = "session";
+    static constexpr const char* NVS_SEQ_KEY = "session_seq";
+    static constexpr const char* JOURNAL_PARTITION = "journal";
+    static constexpr int JOURNAL_SUBTYPE = 0x40;  // Custom data subtype, see partitions.csv
+    static constexpr size_t SECTOR_BYTES = 4096;
+    static constexpr int POLL_MS = 250;
+    static constexpr int SETTLE_MS = 10000;
+    static constexpr int MIN_INTERVAL_MS = 300000;
+    static constexpr int STEP_QUIET_MS = 1000;
+    static constexpr size_t UNDO_DEPTH = 32;
+
+    static SessionStore& getInstance();
+
+    // false if nothing is stored (first boot, erased NVS); params untouched then
+    bool load(AudioEngineParams& params);
+    // Start watching the engine params; idempotent
+    void start();
+    void flush();
+
+    // Revert / reapply the last step; false if there is none. Flush pending UI edits first.
+    bool undo();
+    bool redo();
+    // Lock-free, for polling from the UI
+    bool canUndo() const
+    {
+        return _canUndo.load(std::memory_order_relaxed);
+    }
+    bool canRedo() const
+    {
+        return _canRedo.load(std::memory_order_relaxed);
+    }
+
+private:
+    SessionStore() = default;
+    SessionStore(const SessionStore&) = delete;
+    SessionStore& operator=(const SessionStore&) = delete;
+
+    struct JournalRecord {
+        uint32_t seq;    // 1-based, increasing across boots; erased flash reads 0xFFFFFFFF
+        uint32_t tag;    // ProfileSchema tag
+        uint32_t value;  // ProfileSchema raw word
+        uint32_t check;  // CRC-32 of the words above
+    };
+    static constexpr size_t RECORDS_PER_SECTOR = SECTOR_BYTES / sizeof(JournalRecord);
+
+    struct Change {
+        uint32_t tag;
+        uint32_t before;
+        uint32_t after;
+    };
+    using Step = std::vector<Change>;
+
+    static void encodeSession(const AudioEngineParams& params, std::vector<uint32_t>& records);
+    static bool recordValid(const JournalRecord& r);
+    // Callers hold _mutex
+    bool write(const std::vector<uint32_t>& records, uint32_t seq);
+    void openJournal();
+    int replayJournal(AudioEngineParams& params);
+    bool appendRecord(uint32_t tag, uint32_t value);
+    void journal(const std::vector<uint32_t>& current);
+    void capture(const std::vector<uint32_t>& current, TickType_t now);
+    void closeStep();
+    void publishHistory();
+    bool travel(std::deque<Step>& from, std::deque<Step>& to, bool forward);  // Locks
+    static void watchTask(void* param);
+    void watchLoop();
+
+    std::mutex _mutex;                 // Everything below
+    std::vector<uint32_t> _stored;     // NVS snapshot
+    std::vector<uint32_t> _journaled;  // Snapshot plus journal: what the next boot restores
+    std::vector<uint32_t> _expected;   // What the undo history accounts for
+    uint32_t _snapSeq = 0;             // Last journal record the snapshot covers
+    uint32_t _seq = 0;                 // Last journal record written
+    bool _journalOpened = false;
+    const esp_partition_t* _partition = nullptr;
+    size_t _slots = 0;                 // Records in the ring
+    size_t _head = 0;                  // Next slot to write
+    std::vector<uint32_t> _sectorFirst;  // Lowest / highest valid seq per sector, 0 if none
+    std::vector<uint32_t> _sectorLast;
+    std::vector<bool> _sectorDirty;    // Not erased
+    std::deque<Step> _undo;
+    std::deque<Step> _redo;
+    bool _stepOpen = false;            // _undo.back() still collects changes
+    TickType_t _stepAt = 0;
+    std::atomic<bool> _canUndo{false};
+    std::atomic<bool> _canRedo{false};
+    TaskHandle_t _task = nullptr;
+};
@@ -0,0 +1,445 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "stress_test.h"
+#include "audio_engine.h"
+#include "net_tx.h"
+#include "sd_storage.h"
+#include "wifi_link.h"
+#include "hal/hal_esp32.h"
+#include "../utils/core_policy/core_policy.h"
+#include <mooncake_log.h>
+#include <algorithm>
+#include <cstring>
+#include <bsp/m5stack_tab5.h>
+#include <esp_cache.h>
+#include <esp_heap_caps.h>
+#include <esp_netif.h>
+#include <esp_timer.h>
+
+static const char* TAG = "Stress";
+
+static const char* const LOAD_NAMES[] = {"stress_ui", "stress_sd", "stress_wifi"};
+
+namespace {
+
+// Arguments of one generator task
+struct LoadArg {
+    StressTest* self;
+    uint8_t load;
+};
+
+// Same run across phases: every bus stage and the heaviest VE, everything else as set
+AudioEngineParams heavyParams(AudioEngineParams p)
+{
+    p.beamMode = 2;
+    p.nsEnabled = true;
+    p.agcEnabled = true;
+    p.veEnabled = true;
+    p.veMode = 1;
+    p.veAecMode = 1;
+    p.fbcEnabled = true;
+    p.fitting.wdrcEnabled = true;
+    p.dynamics.mbcEnabled = true;
+    p.dynamics.limiterEnabled = true;
+    // Nothing may sleep through the run
+    p.quietPathEnabled = false;
+    p.sceneAuto = false;
+    return p;
+}
+
+}  // namespace
+
+StressTest& StressTest::getInstance()
+{
+    static StressTest instance;
+    return instance;
+}
+
+bool StressTest::start(const StressConfig& config)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_taskAlive.load(std::memory_order_acquire)) return false;
+    if (!AudioEngine::getInstance().isRunning()) {
+        mclog::tagWarn(TAG, "engine not running");
+        return false;
+    }
+    if (!_probeSrc) {
+        // Cache-line aligned for esp_cache_msync()
+        _probeSrc = static_cast<uint8_t*>(heap_caps_aligned_alloc(128, PROBE_BYTES, MALLOC_CAP_SPIRAM));
+        _probeDst = static_cast<uint8_t*>(heap_caps_aligned_alloc(128, PROBE_BYTES, MALLOC_CAP_SPIRAM));
+        if (!_probeSrc || !_probeDst) {
+            heap_caps_free(_probeSrc);
+            heap_caps_free(_probeDst);
+            _probeSrc = _probeDst = nullptr;
+            mclog::tagError(TAG, "no PSRAM for the copy probe");
+            return false;
+        }
+        memset(_probeSrc, 0x5a, PROBE_BYTES);
+    }
+
+    _config = config;
+    _report = StressReport();
+    _report.running = true;
+    _stopRequested.store(false, std::memory_order_relaxed);
+    _taskAlive.store(true, std::memory_order_release);
+    // Above the generators, so the probe samples on time, but below LVGL and the camera
+    if (xTaskCreatePinnedToCore(runTask, "stress", 4096, this, 3, &_task, core_policy::SYSTEM_AFFINITY) != pdPASS) {
+        _taskAlive.store(false, std::memory_order_release);
+        _report.running = false;
+        _task = nullptr;
+        mclog::tagError(TAG, "failed to create stress task");
+        return false;
+    }
+    mclog::tagInfo(TAG, "start: {}s baseline, {}s loaded (camera {}, UI {} fps, SD {} KB/s, Wi-Fi {} KB/s)",
+        config.baselineS, config.durationS, config.camera ? "on" : "off", config.uiFps, config.sdKBps,
+        config.wifiKBps);
+    return true;
+}
+
+void StressTest::stop()
+{
+    _stopRequested.store(true, std::memory_order_release);
+}
+
+StressReport StressTest::getReport()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    StressReport r = _report;
+    r.uiFrames = _uiFrames.load(std::memory_order_relaxed);
+    r.sdKB = _sdKB.load(std::memory_order_relaxed);
+    r.sdErrors = _sdErrors.load(std::memory_order_relaxed);
+    r.wifiKB = _wifiKB.load(std::memory_order_relaxed);
+    r.wifiDrops = _wifiDrops.load(std::memory_order_relaxed);
+    return r;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Harness task
+// ─────────────────────────────────────────────────────────────────────────────
+
+void StressTest::runTask(void* arg)
+{
+    auto* self = static_cast<StressTest*>(arg);
+    self->run();
+    self->_taskAlive.store(false, std::memory_order_release);
+    vTaskDelete(nullptr);
+}
+
+void StressTest::run()
+{
+    AudioEngine& engine = AudioEngine::getInstance();
+    const AudioEngineParams saved = engine.getParams();
+    if (_config.heavyAudio) engine.setParams(heavyParams(saved));
+    engine.setLevelTapEnabled(AudioEngine::LEVEL_TAP_STRESS, true);
+    _uiFrames.store(0, std::memory_order_relaxed);
+    _sdKB.store(0, std::memory_order_relaxed);
+    _sdErrors.store(0, std::memory_order_relaxed);
+    _wifiKB.store(0, std::memory_order_relaxed);
+    _wifiDrops.store(0, std::memory_order_relaxed);
+
+    StressPhase baseline, loaded;
+    bool ok = runPhase(_config.baselineS, baseline);
+    bool camera = false;
+    if (ok && !_stopRequested.load(std::memory_order_acquire)) {
+        camera = _config.camera && startCamera();
+        startLoads();
+        ok = runPhase(_config.durationS, loaded);
+        stopLoads();
+        stopCamera();
+    }
+
+    engine.setLevelTapEnabled(AudioEngine::LEVEL_TAP_STRESS, false);
+    if (_config.heavyAudio) engine.setParams(saved);
+
+    float pressure = 0.0f;
+    if (baseline.psramMBps > 0.0f && loaded.psramMBps > 0.0f) {
+        pressure = std::max(0.0f, 100.0f * (1.0f - loaded.psramMBps / baseline.psramMBps));
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _report.running = false;
+        _report.ok = ok;
+        _report.baseline = baseline;
+        _report.loaded = loaded;
+        _report.bandwidthPressurePct = pressure;
+        _report.camera = camera;
+    }
+
+    auto logPhase = [](const char* name, const StressPhase& p) {
+        mclog::tagInfo(TAG, "{}: {} blocks, {} misses ({:.2f}%), worst block {} us, worst period {} us, "
+            "late reads {}, RX overruns {}, TX underruns {}, PSRAM copy {:.0f} MB/s (worst {:.0f})",
+            name, p.blocks, p.deadlineMisses, p.missPct, p.worstBlockUs, p.worstPeriodUs, p.lateReads,
+            p.rxOverruns, p.txUnderruns, p.psramMBps, p.psramWorstMBps);
+    };
+    logPhase("baseline", baseline);
+    logPhase("loaded", loaded);
+    mclog::tagInfo(TAG, "loads: camera {}, {} UI frames, SD {} KB ({} errors), Wi-Fi {} KB ({} dropped); "
+        "PSRAM bandwidth pressure {:.0f}%{}", camera ? "on" : "off", _uiFrames.load(), _sdKB.load(),
+        _sdErrors.load(), _wifiKB.load(), _wifiDrops.load(), pressure, ok ? "" : " (incomplete)");
+}
+
+bool StressTest::runPhase(uint32_t seconds, StressPhase& phase)
+{
+    AudioEngine& engine = AudioEngine::getInstance();
+    engine.resetXrunStats();
+    // The reset lands on the next block; the first tap frame after it starts the phase
+    vTaskDelay(pdMS_TO_TICKS(PROBE_MS));
+    AudioLevels levels;
+    while (engine.getTapLevels(AudioEngine::LEVEL_TAP_STRESS, levels)) {
+        // Frames from before the reset
+    }
+    vTaskDelay(pdMS_TO_TICKS(PROBE_MS));
+    if (!engine.getTapLevels(AudioEngine::LEVEL_TAP_STRESS, levels)) return false;
+    const uint32_t firstBlock = levels.blockIndex;
+
+    double sumMBps = 0.0;
+    uint32_t probes = 0;
+    float worst = 0.0f;
+    TickType_t wake = xTaskGetTickCount();
+    const TickType_t end = wake + pdMS_TO_TICKS(seconds * 1000);
+    while (xTaskGetTickCount() < end && !_stopRequested.load(std::memory_order_acquire)) {
+        const float mbps = probeCopy();
+        sumMBps += mbps;
+        worst = probes == 0 ? mbps : std::min(worst, mbps);
+        probes++;
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(PROBE_MS));
+    }
+    if (!engine.isRunning()) return false;
+
+    // Tap frames come every few blocks; the last one is at most that stale
+    vTaskDelay(pdMS_TO_TICKS(PROBE_MS));
+    engine.getTapLevels(AudioEngine::LEVEL_TAP_STRESS, levels);
+    const AudioXrunStats& x = levels.xrun;
+    phase.blocks = levels.blockIndex - firstBlock;
+    phase.deadlineMisses = x.deadlineMisses;
+    phase.lateReads = x.lateReads;
+    phase.rxOverruns = x.rxOverruns;
+    phase.txUnderruns = x.txUnderruns;
+    phase.worstBlockUs = x.worstBlockUs;
+    phase.worstPeriodUs = x.worstPeriodUs;
+    phase.missPct = phase.blocks ? 100.0f * x.deadlineMisses / phase.blocks : 0.0f;
+    phase.psramMBps = probes ? static_cast<float>(sumMBps / probes) : 0.0f;
+    phase.psramWorstMBps = worst;
+    return phase.blocks > 0;
+}
+
+float StressTest::probeCopy()
+{
+    // Out of the cache first and written back after, so the copy goes to PSRAM both ways
+    esp_cache_msync(_probeSrc, PROBE_BYTES, ESP_CACHE_MSYNC_FLAG_INVALIDATE);
+    const int64_t t0 = esp_timer_get_time();
+    memcpy(_probeDst, _probeSrc, PROBE_BYTES);
+    esp_cache_msync(_probeDst, PROBE_BYTES, ESP_CACHE_MSYNC_FLAG_DIR_C2M);
+    const int64_t us = std::max<int64_t>(1, esp_timer_get_time() - t0);
+    return static_cast<float>(PROBE_BYTES) / us;  // Bytes per us = MB/s
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Camera
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool StressTest::startCamera()
+{
+    auto* hal = GetHAL();
+    if (hal->isCameraCapturing()) {
+        mclog::tagInfo(TAG, "camera already running, left as it is");
+        return true;
+    }
+    if (!bsp_display_lock(1000)) return false;
+    lv_obj_t* image = lv_image_create(lv_layer_top());
+    lv_obj_set_size(image, LV_PCT(100), LV_PCT(100));
+    lv_obj_center(image);
+    bsp_display_unlock();
+
+    _cameraImage = image;
+    hal->setCameraPreviewSize(1280, 720);
+    hal->startCameraCapture(image);
+    if (!hal->isCameraCapturing()) {
+        stopCamera();
+        mclog::tagWarn(TAG, "camera didn't start");
+        return false;
+    }
+    return true;
+}
+
+void StressTest::stopCamera()
+{
+    if (!_cameraImage) return;
+    auto* hal = GetHAL();
+    hal->stopCameraCapture();
+    hal->setCameraPreviewSize(0, 0);
+    bsp_display_lock(0);
+    lv_obj_delete(static_cast<lv_obj_t*>(_cameraImage));
+    bsp_display_unlock();
+    _cameraImage = nullptr;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Load generators
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool StressTest::startLoads()
+{
+    static LoadArg args[LOAD_COUNT];
+    const bool wanted[LOAD_COUNT] = {_config.uiFps > 0, _config.sdKBps > 0, _config.wifiKBps > 0};
+    // UI at the LVGL task's priority, SD at the storage worker's, Wi-Fi at the senders'
+    static const UBaseType_t priorities[LOAD_COUNT] = {2, 2, 4};
+    _loadsRunning.store(true, std::memory_order_release);
+    bool ok = true;
+    for (uint8_t l = 0; l < LOAD_COUNT; l++) {
+        if (!wanted[l]) continue;
+        args[l] = {this, l};
+        _loadsAlive.fetch_or(1 << l, std::memory_order_acq_rel);
+        if (xTaskCreatePinnedToCore(loadTask, LOAD_NAMES[l], 4096, &args[l], priorities[l], nullptr,
+                                    core_policy::SYSTEM_AFFINITY) != pdPASS) {
+            _loadsAlive.fetch_and(static_cast<uint8_t>(~(1 << l)), std::memory_order_acq_rel);
+            mclog::tagError(TAG, "failed to create {}", LOAD_NAMES[l]);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+void StressTest::stopLoads()
+{
+    _loadsRunning.store(false, std::memory_order_release);
+    // An SD write or a Wi-Fi flush in progress finishes first
+    for (int i = 0; i < 200 && _loadsAlive.load(std::memory_order_acquire); i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    if (_loadsAlive.load(std::memory_order_acquire)) mclog::tagWarn(TAG, "load generators did not stop in time");
+}
+
+void StressTest::loadTask(void* arg)
+{
+    const LoadArg a = *static_cast<LoadArg*>(arg);
+    switch (a.load) {
+        case LOAD_UI:
+            a.self->uiLoop();
+            break;
+        case LOAD_SD:
+            a.self->sdLoop();
+            break;
+        case LOAD_WIFI:
+            a.self->wifiLoop();
+            break;
+    }
+    a.self->_loadsAlive.fetch_and(static_cast<uint8_t>(~(1 << a.load)), std::memory_order_acq_rel);
+    vTaskDelete(nullptr);
+}
+
+void StressTest::uiLoop()
+{
+    // The LVGL task redraws the whole screen on its next pass, like a panel switch
+    TickType_t wake = xTaskGetTickCount();
+    const TickType_t period = std::max<TickType_t>(1, pdMS_TO_TICKS(1000 / _config.uiFps));
+    while (_loadsRunning.load(std::memory_order_acquire)) {
+        if (bsp_display_lock(100)) {
+            lv_obj_invalidate(lv_screen_active());
+            bsp_display_unlock();
+            _uiFrames.fetch_add(1, std::memory_order_relaxed);
+        }
+        vTaskDelayUntil(&wake, period);
+    }
+}
+
+void StressTest::sdLoop()
+{
+    constexpr uint32_t CHUNK = SdStorage::IO_CHUNK;
+    if (!SdStorage::getInstance().mount()) {
+        mclog::tagWarn(TAG, "SD load: no card");
+        return;
+    }
+    // Same path as the recorder: aligned internal RAM the SDMMC DMA reads, unbuffered, preallocated
+    auto* buf = static_cast<uint8_t*>(
+        heap_caps_aligned_alloc(64, CHUNK, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA | MALLOC_CAP_8BIT));
+    const char* path = "/sd/.stress.tmp";
+    FILE* f = buf ? fopen(path, "wb") : nullptr;
+    if (!f) {
+        heap_caps_free(buf);
+        _sdErrors.fetch_add(1, std::memory_order_relaxed);
+        mclog::tagWarn(TAG, "SD load: can't open {}", path);
+        return;
+    }
+    setvbuf(f, nullptr, _IONBF, 0);
+    memset(buf, 0xa5, CHUNK);
+    uint32_t reserved = 0;
+    SdStorage::reserve(f, reserved, SD_FILE_BYTES);
+
+    // Paced per chunk; a slow card just falls behind the rate
+    const int64_t chunkUs = 1000000ll * CHUNK / 1024 / _config.sdKBps;
+    int64_t next = esp_timer_get_time();
+    uint32_t offset = 0;
+    while (_loadsRunning.load(std::memory_order_acquire)) {
+        if (offset >= SD_FILE_BYTES) {
+            fseek(f, 0, SEEK_SET);
+            offset = 0;
+        }
+        if (fwrite(buf, 1, CHUNK, f) == CHUNK) {
+            _sdKB.fetch_add(CHUNK / 1024, std::memory_order_relaxed);
+        } else {
+            _sdErrors.fetch_add(1, std::memory_order_relaxed);
+        }
+        offset += CHUNK;
+        next += chunkUs;
+        const int64_t wait = next - esp_timer_get_time();
+        if (wait > 0) {
+            vTaskDelay(std::max<TickType_t>(1, pdMS_TO_TICKS(wait / 1000)));
+        } else {
+            next = esp_timer_get_time();
+        }
+    }
+    fclose(f);
+    remove(path);
+    heap_caps_free(buf);
+}
+
+void StressTest::wifiLoop()
+{
+    WifiLink& link = WifiLink::getInstance();
+    link.want(WifiLink::CLIENT_STRESS_TEST, true);
+    for (uint32_t waited = 0; !link.isConnected(); waited += 100) {
+        if (waited >= LINK_WAIT_MS || !_loadsRunning.load(std::memory_order_acquire)) {
+            if (waited >= LINK_WAIT_MS) mclog::tagWarn(TAG, "Wi-Fi load: no link");
+            link.want(WifiLink::CLIENT_STRESS_TEST, false);
+            return;
+        }
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+
+    // The gateway always answers ARP; the discard port throws the datagrams away
+    esp_netif_ip_info_t ip = {};
+    char host[16] = {};
+    esp_netif_t* netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    UdpFlow flow;
+    if (!netif || esp_netif_get_ip_info(netif, &ip) != ESP_OK || !esp_ip4addr_ntoa(&ip.gw, host, sizeof(host)) ||
+        !flow.open(host, WIFI_PORT)) {
+        mclog::tagWarn(TAG, "Wi-Fi load: can't open a flow to the gateway");
+        link.want(WifiLink::CLIENT_STRESS_TEST, false);
+        return;
+    }
+
+    // One batch every tick's worth of the rate
+    constexpr uint32_t BATCH_MS = 10;
+    const uint32_t perBatch =
+        std::clamp<uint32_t>(_config.wifiKBps * 1024 / WIFI_DATAGRAM * BATCH_MS / 1000, 1, UdpFlow::MAX_BATCH);
+    TickType_t wake = xTaskGetTickCount();
+    while (_loadsRunning.load(std::memory_order_acquire)) {
+        uint32_t queued = 0;
+        for (; queued < perBatch; queued++) {
+            uint8_t* payload = flow.prepare(WIFI_DATAGRAM);
+            if (!payload) break;
+            memset(payload, 0, WIFI_DATAGRAM);
+            flow.commit();
+        }
+        const int sent = queued ? flow.flush() : 0;
+        _wifiKB.fetch_add(sent * WIFI_DATAGRAM / 1024, std::memory_order_relaxed);
+        _wifiDrops.fetch_add(perBatch - sent, std::memory_order_relaxed);
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(BATCH_MS));
+    }
+    flow.close();
+    link.want(WifiLink::CLIENT_STRESS_TEST, false);
+}
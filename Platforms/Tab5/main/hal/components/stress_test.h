@@ -0,0 +1,132 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Load generators and their intensity; 0 turns a generator off
+struct StressConfig {
+    uint32_t baselineS = 5;     // Audio alone first, same profile
+    uint32_t durationS = 30;    // Then with every load below running
+    bool heavyAudio = true;     // Every 16kHz bus stage, the GSC, FBC, WDRC + MBC for the run
+    bool camera = true;         // 1280 x 720 preview through the PPA, full screen on the top layer
+    uint32_t uiFps = 30;        // Full-screen invalidations a second
+    uint32_t sdKBps = 2048;     // Sequential writes in SdStorage::IO_CHUNKs
+    uint32_t wifiKBps = 512;    // UDP to the gateway's discard port
+};
+
+// Audio loop health over one phase
+struct StressPhase {
+    uint32_t blocks = 0;
+    uint32_t deadlineMisses = 0;
+    uint32_t lateReads = 0;
+    uint32_t rxOverruns = 0;
+    uint32_t txUnderruns = 0;
+    uint32_t worstBlockUs = 0;
+    uint32_t worstPeriodUs = 0;
+    float missPct = 0.0f;       // Deadline misses per block
+    float psramMBps = 0.0f;     // Mean of the copy probe
+    float psramWorstMBps = 0.0f;
+};
+
+struct StressReport {
+    bool running = false;
+    bool ok = false;            // Both phases ran with the engine up
+    StressPhase baseline;
+    StressPhase loaded;
+    float bandwidthPressurePct = 0.0f;  // PSRAM copy throughput the loads took away
+    bool camera = false;        // The preview ran (started here or already on)
+    uint32_t uiFrames = 0;      // Invalidations issued
+    uint32_t sdKB = 0;          // Written
+    uint32_t sdErrors = 0;
+    uint32_t wifiKB = 0;        // Taken by the stack
+    uint32_t wifiDrops = 0;     // Datagrams the pbuf pool or the stack refused
+};
+
+/**
+ * @brief Reproducible contention run: audio next to the camera, UI, SD and Wi-Fi
+ *
+ * A Core 0 task runs the engine (with StressConfig::heavyAudio, on a heavy copy of
+ * the live params, put back afterwards) for a baseline phase on its own, then
+ * starts every configured load generator and runs the loaded phase. Each phase
+ * starts from resetXrunStats() and reads the engine through its own level tap,
+ * so the UI's meters are untouched; the deadline-miss rate is misses over the
+ * phase's block count.
+ *
+ * Memory pressure is measured, not generated: every PROBE_MS the task times a
+ * PROBE_BYTES PSRAM-to-PSRAM copy, and the loaded phase's mean against the
+ * baseline's is how much of the PSRAM bandwidth the loads took. The generators
+ * (UI, SD, Wi-Fi) are Core 0 tasks at the priorities of the subsystems they
+ * stand in for; the camera is the real preview pipeline.
+ *
+ * The report is logged at the end of a run. Needs the engine running.
+ */
+class StressTest {
+public:
+    static constexpr uint32_t PROBE_MS = 50;
+    static constexpr uint32_t PROBE_BYTES = 64 * 1024;
+    static constexpr uint32_t SD_FILE_BYTES = 16 * 1024 * 1024;  // The writer wraps here
+    static constexpr uint32_t WIFI_DATAGRAM = 1024;
+    static constexpr uint16_t WIFI_PORT = 9;                     // Discard
+    static constexpr uint32_t LINK_WAIT_MS = 15000;
+
+    static StressTest& getInstance();
+
+    bool start(const StressConfig& config = StressConfig());
+    // Ends the current phase early; the report covers what ran
+    void stop();
+    bool isRunning() const
+    {
+        return _taskAlive.load(std::memory_order_acquire);
+    }
+    // The run in progress, or the last one
+    StressReport getReport();
+
+private:
+    StressTest() = default;
+    StressTest(const StressTest&) = delete;
+    StressTest& operator=(const StressTest&) = delete;
+
+    enum Load : uint8_t { LOAD_UI = 0, LOAD_SD, LOAD_WIFI, LOAD_COUNT };
+
+    static void runTask(void* arg);
+    void run();
+    bool runPhase(uint32_t seconds, StressPhase& phase);
+    float probeCopy();
+    bool startLoads();
+    void stopLoads();
+    bool startCamera();
+    void stopCamera();
+
+    static void loadTask(void* arg);
+    void uiLoop();
+    void sdLoop();
+    void wifiLoop();
+
+    std::mutex _mutex;  // start/stop, _report
+    StressConfig _config;
+    StressReport _report;
+    std::atomic<bool> _stopRequested{false};
+    std::atomic<bool> _taskAlive{false};
+    std::atomic<bool> _loadsRunning{false};
+    std::atomic<uint8_t> _loadsAlive{0};  // One bit per Load
+    TaskHandle_t _task = nullptr;
+
+    // Task-only
+    uint8_t* _probeSrc = nullptr;
+    uint8_t* _probeDst = nullptr;
+    void* _cameraImage = nullptr;  // lv_obj_t on the top layer while the harness owns the preview
+
+    // Generator counters, read into the report at the end
+    std::atomic<uint32_t> _uiFrames{0};
+    std::atomic<uint32_t> _sdKB{0};
+    std::atomic<uint32_t> _sdErrors{0};
+    std::atomic<uint32_t> _wifiKB{0};
+    std::atomic<uint32_t> _wifiDrops{0};
+};
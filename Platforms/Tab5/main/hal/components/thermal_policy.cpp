@@ -0,0 +1,156 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "thermal_policy.h"
+#include "audio_engine.h"
+#include "../utils/core_policy/core_policy.h"
+#include <mooncake_log.h>
+#include <algorithm>
+
+static const char* TAG = "Thermal";
+
+static constexpr int POLICY_STACK = 3072;
+static constexpr UBaseType_t POLICY_PRIORITY = 1;
+
+ThermalPolicy& ThermalPolicy::getInstance()
+{
+    static ThermalPolicy instance;
+    return instance;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Control
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool ThermalPolicy::start(temperature_sensor_handle_t sensor)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_running.load(std::memory_order_relaxed)) return true;
+    if (!sensor) return false;
+
+    _sensor = sensor;
+    _stats = {};
+    float temp = 0.0f;
+    if (temperature_sensor_get_celsius(_sensor, &temp) != ESP_OK) {
+        mclog::tagError(TAG, "temperature sensor unreadable");
+        return false;
+    }
+    _stats.tempC = temp;
+    _running.store(true, std::memory_order_release);
+    if (xTaskCreatePinnedToCore(policyTask, "thermal", POLICY_STACK, this, POLICY_PRIORITY, &_task,
+                                core_policy::SYSTEM_AFFINITY) != pdPASS) {
+        _running.store(false, std::memory_order_relaxed);
+        _task = nullptr;
+        mclog::tagError(TAG, "failed to create policy task");
+        return false;
+    }
+    mclog::tagInfo(TAG, "{:.1f} C, tiers at {:.0f}/{:.0f}/{:.0f} C", temp, TIER_ENTER_C[0], TIER_ENTER_C[1],
+                   TIER_ENTER_C[2]);
+    return true;
+}
+
+ThermalStats ThermalPolicy::getStats()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    ThermalStats s = _stats;
+    s.running = isRunning();
+    return s;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Policy task
+// ─────────────────────────────────────────────────────────────────────────────
+
+void ThermalPolicy::policyTask(void* param)
+{
+    static_cast<ThermalPolicy*>(param)->policyLoop();
+}
+
+void ThermalPolicy::policyLoop()
+{
+    const float dt = SAMPLE_MS / 1000.0f;
+    const float k = dt / (TEMP_TAU_S + dt);
+    float smoothed = getStats().tempC;
+    int tier = 0;
+    uint32_t belowMs = 0;
+
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(SAMPLE_MS));
+        float temp = 0.0f;
+        if (temperature_sensor_get_celsius(_sensor, &temp) == ESP_OK) smoothed += k * (temp - smoothed);
+
+        const int next = tierFor(smoothed, tier, belowMs);
+        if (next != tier) {
+            mclog::tagWarn(TAG, "{:.1f} C: tier {} -> {}", smoothed, tier, next);
+            tier = next;
+        }
+        enforce(tier);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats.tempC = smoothed;
+        if (_stats.tier != tier) _stats.changes++;
+        _stats.tier = tier;
+    }
+}
+
+int ThermalPolicy::tierFor(float tempC, int current, uint32_t& belowMs) const
+{
+    // Up at once, as far as the temperature says
+    int up = current;
+    while (up < TIER_COUNT && tempC >= TIER_ENTER_C[up]) up++;
+    if (up > current) {
+        belowMs = 0;
+        return up;
+    }
+    // Down one tier at a time, once it has been cool enough for HOLD_MS
+    if (current == 0 || tempC > TIER_ENTER_C[current - 1] - HYSTERESIS_C) {
+        belowMs = 0;
+        return current;
+    }
+    belowMs += SAMPLE_MS;
+    if (belowMs < HOLD_MS) return current;
+    belowMs = 0;
+    return current - 1;
+}
+
+void ThermalPolicy::enforce(int tier)
+{
+    AudioEngine& engine = AudioEngine::getInstance();
+    const AudioEngineParams p = engine.getParams();
+    int stepped = 0, restored = 0;
+
+    // One stage: cap it while its tier holds, give the old mode back after
+    auto apply = [&](Saved& saved, bool active, bool applies, int live, int capped, void (AudioEngine::*set)(int)) {
+        if (active && applies && live != capped) {
+            saved.before = live;  // An edit made while capped is the new original
+            saved.held = true;
+            saved.capped = capped;
+            (engine.*set)(capped);
+            stepped++;
+        } else if (!active && saved.held) {
+            saved.held = false;
+            if (live == saved.capped) {
+                (engine.*set)(saved.before);
+                restored++;
+            }
+        }
+    };
+
+    const bool aecOn = p.veEnabled && p.veMode == 1;
+    const bool aecHigh = p.veAecMode == 1 || p.veAecMode == 4;
+    engine.beginParamBatch();
+    apply(_aecMode, tier >= 1, aecOn, p.veAecMode,
+          aecHigh ? p.veAecMode - 1 : p.veAecMode, &AudioEngine::setVeAecMode);
+    apply(_veTaps, tier >= 2, p.veEnabled && (p.veMode == 0 || p.veMode == 3), p.veFilterLength,
+          std::min(p.veFilterLength, NLMS_TAPS_CAP), &AudioEngine::setVeFilterLength);
+    apply(_nsMode, tier >= 3, p.nsEnabled, p.nsMode, 0, &AudioEngine::setNsMode);
+    engine.endParamBatch();
+
+    if (stepped == 0 && restored == 0) return;
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stats.stepsDown += stepped;
+    _stats.restores += restored;
+    _stats.changes++;
+}
@@ -0,0 +1,90 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <driver/temperature_sensor.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+struct ThermalStats {
+    bool running = false;
+    float tempC = 0.0f;      // Smoothed die temperature
+    int tier = 0;            // 0 = full quality, ThermalPolicy::TIER_COUNT = every step taken
+    uint32_t changes = 0;    // Tier or engine param changes; the UI resyncs its controls when this moves
+    uint32_t stepsDown = 0;  // Engine params stepped down to a cheaper mode
+    uint32_t restores = 0;   // Stepped-down params given back
+};
+
+/**
+ * @brief DSP quality tiers from the ESP32-P4 die temperature
+ *
+ * Samples the internal temperature sensor every SAMPLE_MS on Core 0 and
+ * smooths it over TEMP_TAU_S. Each tier caps one of the costliest stages, in
+ * the order AudioCostModel::fitToBudget() gives them up:
+ *
+ *  1. AEC high perf -> low cost (SR and VOIP)
+ *  2. NLMS voice-extraction taps -> NLMS_TAPS_CAP
+ *  3. NS aggressive / medium -> mild
+ *
+ * Tier n is entered at TIER_ENTER_C[n - 1] and left HYSTERESIS_C below it,
+ * after the temperature has stayed there for HOLD_MS, so readings hovering
+ * around a threshold don't keep rebuilding the AEC handles. While a tier
+ * holds, the caps are re-applied each sample, so a profile loaded in the
+ * meantime is stepped down too. Leaving a tier gives each stage back its previous mode,
+ * unless it was edited since the policy changed it.
+ *
+ * The changes go through the AudioEngine setters like any edit (and are
+ * journaled by SessionStore). ThermalStats::changes tells the UI to show the
+ * tier and resync its controls.
+ */
+class ThermalPolicy {
+public:
+    static constexpr int TIER_COUNT = 3;
+    static constexpr float TIER_ENTER_C[TIER_COUNT] = {70.0f, 76.0f, 82.0f};
+    static constexpr float HYSTERESIS_C = 6.0f;
+    static constexpr uint32_t HOLD_MS = 30000;
+    static constexpr uint32_t SAMPLE_MS = 2000;
+    static constexpr float TEMP_TAU_S = 10.0f;
+    static constexpr int NLMS_TAPS_CAP = 128;
+
+    static ThermalPolicy& getInstance();
+
+    // The sensor must be installed and enabled; it is read from the policy task only after this
+    bool start(temperature_sensor_handle_t sensor);
+    bool isRunning() const
+    {
+        return _running.load(std::memory_order_relaxed);
+    }
+    ThermalStats getStats();
+
+private:
+    ThermalPolicy() = default;
+    ThermalPolicy(const ThermalPolicy&) = delete;
+    ThermalPolicy& operator=(const ThermalPolicy&) = delete;
+
+    static void policyTask(void* param);
+    void policyLoop();
+    int tierFor(float tempC, int current, uint32_t& belowMs) const;
+    void enforce(int tier);
+
+    std::mutex _mutex;  // _stats
+    std::atomic<bool> _running{false};
+    TaskHandle_t _task = nullptr;
+    temperature_sensor_handle_t _sensor = nullptr;
+    ThermalStats _stats;
+
+    // Policy task only: what each capped stage was set to before, for the way back
+    struct Saved {
+        bool held = false;
+        int before = 0;
+        int capped = 0;
+    };
+    Saved _aecMode;
+    Saved _veTaps;
+    Saved _nsMode;
+};
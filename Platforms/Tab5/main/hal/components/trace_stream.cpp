@@ -0,0 +1,264 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "trace_stream.h"
+#include "../utils/core_policy/core_policy.h"
+#include <algorithm>
+#include <cstring>
+#include <esp_app_desc.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <lwip/sockets.h>
+
+static const char* TAG = "TraceStream";
+
+static constexpr int SENDER_STACK = 3072;
+static constexpr UBaseType_t SENDER_PRIORITY = 2;  // Diagnostics: behind everything that does real work
+static constexpr size_t MAX_RECORD_BYTES = 22 + mclog::internal::trace_max_args * 9;
+
+TraceStream& TraceStream::getInstance()
+{
+    static TraceStream instance;
+    return instance;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Encoding
+// ─────────────────────────────────────────────────────────────────────────────
+
+static uint8_t* put(uint8_t* p, uint64_t v, int bytes)
+{
+    for (int i = 0; i < bytes; i++) *p++ = static_cast<uint8_t>(v >> (8 * i));
+    return p;
+}
+
+static uint32_t address(const void* p)
+{
+    return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(p));
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Control
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool TraceStream::start(const char* host, uint16_t port)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_senderAlive.load(std::memory_order_acquire)) return true;
+
+    sockaddr_in dest = {};
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(port);
+    if (!host || inet_pton(AF_INET, host, &dest.sin_addr) != 1) {
+        mclog::tagError(TAG, "bad collector '{}'", host ? host : "");
+        return false;
+    }
+    if (!_batches) {
+        _batches = static_cast<Batch*>(heap_caps_calloc(SLOTS, sizeof(Batch), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+        if (!_batches) {
+            mclog::tagError(TAG, "no PSRAM for the batch queue");
+            return false;
+        }
+    }
+    _socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (_socket < 0 || connect(_socket, reinterpret_cast<sockaddr*>(&dest), sizeof(dest)) != 0) {
+        mclog::tagError(TAG, "socket to {}:{} failed: errno {}", host, port, errno);
+        if (_socket >= 0) close(_socket);
+        _socket = -1;
+        return false;
+    }
+
+    std::memcpy(_buildId, esp_app_get_description()->app_elf_sha256, sizeof(_buildId));
+    _sequence = 0;
+    _ringDroppedAtStart = mclog::trace_dropped();
+    _records.store(0, std::memory_order_relaxed);
+    _batchesSent.store(0, std::memory_order_relaxed);
+    _rateDropped.store(0, std::memory_order_relaxed);
+    _sendErrors.store(0, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> batchLock(_batchMutex);
+        _head = _count = 0;
+        _batches[0].bytes = HEADER_BYTES;
+        _batches[0].records = 0;
+    }
+
+    _senderAlive.store(true, std::memory_order_release);
+    _streaming.store(true, std::memory_order_release);
+    if (xTaskCreatePinnedToCore(senderTask, "trace_tx", SENDER_STACK, this, SENDER_PRIORITY, &_task,
+                                core_policy::SYSTEM_AFFINITY) != pdPASS) {
+        _streaming.store(false, std::memory_order_relaxed);
+        _senderAlive.store(false, std::memory_order_relaxed);
+        _task = nullptr;
+        close(_socket);
+        _socket = -1;
+        mclog::tagError(TAG, "failed to create sender task");
+        return false;
+    }
+    mclog::tagInfo(TAG, "traces to {}:{}, {} B/s", host, port, RATE_BYTES_PER_S);
+    mclog::set_trace_sink(sink, this);
+    return true;
+}
+
+void TraceStream::stop()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_senderAlive.load(std::memory_order_acquire)) return;
+    mclog::set_trace_sink(nullptr);  // Returns once no flush is inside sink()
+    _streaming.store(false, std::memory_order_release);
+    xTaskNotifyGive(_task);
+    for (int i = 0; i < 50 && _senderAlive.load(std::memory_order_acquire); i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    if (_senderAlive.load(std::memory_order_acquire)) mclog::tagWarn(TAG, "sender did not finish in time");
+    _task = nullptr;
+    mclog::tagInfo(TAG, "stopped after {} batches, {} records dropped", _batchesSent.load(std::memory_order_relaxed),
+                   _rateDropped.load(std::memory_order_relaxed));
+}
+
+TraceStreamStats TraceStream::getStats()
+{
+    TraceStreamStats s;
+    s.streaming = isStreaming();
+    s.records = _records.load(std::memory_order_relaxed);
+    s.batches = _batchesSent.load(std::memory_order_relaxed);
+    s.rateDropped = _rateDropped.load(std::memory_order_relaxed);
+    s.sendErrors = _sendErrors.load(std::memory_order_relaxed);
+    return s;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Sink (flushing task)
+// ─────────────────────────────────────────────────────────────────────────────
+
+void TraceStream::sink(const mclog::TraceRecordView_t& record, void* user)
+{
+    static_cast<TraceStream*>(user)->append(record);
+}
+
+void TraceStream::append(const mclog::TraceRecordView_t& record)
+{
+    std::lock_guard<std::mutex> lock(_batchMutex);
+    Batch* batch = &_batches[(_head + _count) % SLOTS];
+    if (batch->bytes + MAX_RECORD_BYTES > BATCH_BYTES) {
+        if (_count == QUEUE_BATCHES) {
+            _rateDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        _count++;
+        batch = &_batches[(_head + _count) % SLOTS];
+        batch->bytes = HEADER_BYTES;
+        batch->records = 0;
+    }
+
+    uint8_t* p = batch->data + batch->bytes;
+    *p++ = static_cast<uint8_t>(record.level);
+    *p++ = static_cast<uint8_t>(record.count);
+    p = put(p, address(record.tag), 4);
+    p = put(p, address(record.format.data()), 4);
+    p = put(p, record.format.size(), 4);
+    p = put(p, static_cast<uint64_t>(record.time_us), 8);
+    for (int i = 0; i < record.count; i++) {
+        const mclog::internal::TraceValue_t& v = record.values[i];
+        *p++ = record.types[i];
+        switch (record.types[i]) {
+            case mclog::internal::trace_arg_bool:
+                *p++ = v.b ? 1 : 0;
+                break;
+            case mclog::internal::trace_arg_char:
+                *p++ = static_cast<uint8_t>(v.c);
+                break;
+            case mclog::internal::trace_arg_int:
+                p = put(p, static_cast<uint64_t>(v.i), 8);
+                break;
+            case mclog::internal::trace_arg_uint:
+                p = put(p, v.u, 8);
+                break;
+            case mclog::internal::trace_arg_double: {
+                uint64_t bits;
+                std::memcpy(&bits, &v.d, sizeof(bits));
+                p = put(p, bits, 8);
+                break;
+            }
+            default:
+                p = put(p, address(v.s), 4);
+                break;
+        }
+    }
+    batch->bytes = static_cast<uint16_t>(p - batch->data);
+    batch->records++;
+    _records.fetch_add(1, std::memory_order_relaxed);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Sender task
+// ─────────────────────────────────────────────────────────────────────────────
+
+void TraceStream::senderTask(void* param)
+{
+    auto* self = static_cast<TraceStream*>(param);
+    self->senderLoop();
+    close(self->_socket);
+    self->_socket = -1;
+    self->_senderAlive.store(false, std::memory_order_release);
+    vTaskDelete(nullptr);
+}
+
+void TraceStream::senderLoop()
+{
+    uint32_t tokens = BURST_BYTES;
+    int64_t lastUs = esp_timer_get_time();
+    bool streaming = true;
+    while (streaming) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(FLUSH_MS));
+        streaming = _streaming.load(std::memory_order_acquire);
+
+        const int64_t now = esp_timer_get_time();
+        tokens = static_cast<uint32_t>(std::min<int64_t>(BURST_BYTES, tokens + (now - lastUs) * RATE_BYTES_PER_S / 1000000));
+        lastUs = now;
+
+        // The filling batch goes out too, so a quiet system still delivers within FLUSH_MS
+        while (true) {
+            Batch* batch = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(_batchMutex);
+                if (_count == 0) {
+                    Batch& filling = _batches[_head];
+                    if (filling.records == 0) break;
+                    _count = 1;
+                    Batch& next = _batches[(_head + 1) % SLOTS];
+                    next.bytes = HEADER_BYTES;
+                    next.records = 0;
+                }
+                if (_batches[_head].bytes > tokens) break;  // Over the rate: wait for the bucket
+                batch = &_batches[_head];
+            }
+            // The sink only touches the batch after the queue, so this one is ours until popped
+            tokens -= batch->bytes;
+            sendBatch(*batch);
+            std::lock_guard<std::mutex> lock(_batchMutex);
+            _head = (_head + 1) % SLOTS;
+            _count--;
+        }
+    }
+}
+
+bool TraceStream::sendBatch(Batch& batch)
+{
+    const uint32_t dropped = (mclog::trace_dropped() - _ringDroppedAtStart) + _rateDropped.load(std::memory_order_relaxed);
+    uint8_t* p = batch.data;
+    p = put(p, MAGIC, 4);
+    p = put(p, VERSION, 2);
+    p = put(p, batch.records, 2);
+    p = put(p, _sequence++, 4);
+    p = put(p, dropped, 4);
+    std::memcpy(p, _buildId, sizeof(_buildId));
+
+    if (send(_socket, batch.data, batch.bytes, 0) != batch.bytes) {
+        _sendErrors.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    _batchesSent.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <mooncake_log.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+struct TraceStreamStats {
+    bool streaming = false;
+    uint32_t records = 0;      // Records queued for sending
+    uint32_t batches = 0;      // Datagrams sent
+    uint32_t rateDropped = 0;  // Records dropped because the queue was full (rate limit or a stalled link)
+    uint32_t sendErrors = 0;
+};
+
+/**
+ * @brief mooncake_log trace records to a UDP collector, undecoded
+ *
+ * While streaming, TraceStream is the trace ring's sink: trace_flush() (the
+ * audio control task's, or anyone's) hands records over raw and they go into
+ * datagram-sized batches instead of being formatted and printed. Nothing is
+ * formatted on the device: tag, format string and string arguments travel as
+ * their 32-bit addresses, which the collector resolves in the firmware ELF
+ * named by the batch's build id. The audio task's side is unchanged, it only
+ * ever pushes into the ring.
+ *
+ * A Core 0 task sends the filled batches every FLUSH_MS under a token bucket
+ * of RATE_BYTES_PER_S (BURST_BYTES deep). Batches the bucket holds back wait
+ * in a queue of QUEUE_BATCHES; once it is full new records are dropped and
+ * counted, and the count rides in every later header, so the host knows where
+ * the gaps are.
+ *
+ * Wire format, little endian. Batch header (HEADER_BYTES):
+ *   u32 magic 'HWTR' | u16 version | u16 records | u32 sequence |
+ *   u32 dropped (ring + rate, since start) | u8[8] build id (ELF SHA-256 prefix)
+ * Record:
+ *   u8 level | u8 argc | u32 tag | u32 format | u32 format length | i64 time_us |
+ *   argc x (u8 type, value: bool / char 1 byte, int / uint / double 8, string 4)
+ * with TraceArgType_t numbering the types.
+ */
+class TraceStream {
+public:
+    static constexpr uint32_t MAGIC = 0x52545748;  // "HWTR"
+    static constexpr uint16_t VERSION = 1;
+    static constexpr uint16_t DEFAULT_PORT = 5140;
+    static constexpr size_t BATCH_BYTES = 1400;  // One unfragmented datagram
+    static constexpr size_t HEADER_BYTES = 24;
+    static constexpr int QUEUE_BATCHES = 4;
+    static constexpr uint32_t FLUSH_MS = 250;
+    static constexpr uint32_t RATE_BYTES_PER_S = 8192;
+    static constexpr uint32_t BURST_BYTES = 4 * BATCH_BYTES;
+
+    static TraceStream& getInstance();
+
+    // host is a dotted IPv4 address; traces stop printing locally until stop()
+    bool start(const char* host, uint16_t port = DEFAULT_PORT);
+    void stop();
+    bool isStreaming() const
+    {
+        return _streaming.load(std::memory_order_relaxed);
+    }
+    TraceStreamStats getStats();
+
+private:
+    TraceStream() = default;
+    TraceStream(const TraceStream&) = delete;
+    TraceStream& operator=(const TraceStream&) = delete;
+
+    struct Batch {
+        uint16_t bytes;
+        uint16_t records;
+        uint8_t data[BATCH_BYTES];
+    };
+    static constexpr int SLOTS = QUEUE_BATCHES + 1;  // The queue plus the one filling
+
+    static void sink(const mclog::TraceRecordView_t& record, void* user);
+    void append(const mclog::TraceRecordView_t& record);
+    static void senderTask(void* param);
+    void senderLoop();
+    bool sendBatch(Batch& batch);
+
+    std::mutex _mutex;      // start/stop
+    std::mutex _batchMutex; // _batches, _head, _count: flushing task vs sender
+    Batch* _batches = nullptr;  // SLOTS, PSRAM, allocated on first start
+    int _head = 0;              // Oldest full batch
+    int _count = 0;             // Full batches queued; the one after them is filling
+    std::atomic<bool> _streaming{false};
+    std::atomic<bool> _senderAlive{false};
+    TaskHandle_t _task = nullptr;
+
+    // Sender task only
+    int _socket = -1;
+    uint32_t _sequence = 0;
+    uint8_t _buildId[8] = {};
+
+    std::atomic<uint32_t> _records{0};
+    std::atomic<uint32_t> _batchesSent{0};
+    std::atomic<uint32_t> _rateDropped{0};
+    std::atomic<uint32_t> _sendErrors{0};
+    uint32_t _ringDroppedAtStart = 0;
+};
@@ -0,0 +1,61 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+/*
+ * TinyUSB configuration for the device functions: the UAC2 microphone
+ * (usb_audio.cpp) and SD card mass storage (usb_msc.cpp), one at a time
+ * through usb_device.cpp. Device on the full-speed OTG port behind USB-C;
+ * the high-speed port stays with the IDF USB host stack (USB-A HID).
+ */
+
+#ifndef CFG_TUSB_MCU
+#define CFG_TUSB_MCU OPT_MCU_ESP32P4
+#endif
+#define CFG_TUSB_OS          OPT_OS_FREERTOS
+#define CFG_TUSB_OS_INC_PATH freertos/
+#define CFG_TUSB_RHPORT0_MODE (OPT_MODE_DEVICE | OPT_MODE_FULL_SPEED)
+#define CFG_TUSB_MEM_SECTION
+// Cache line: the MSC transfer buffer goes to the SDMMC DMA as is, no bounce copy
+#define CFG_TUSB_MEM_ALIGN __attribute__((aligned(64)))
+
+#define CFG_TUD_ENABLED       1
+#define CFG_TUD_ENDPOINT0_SIZE 64
+
+#define CFG_TUD_CDC    0
+#define CFG_TUD_MSC    1
+#define CFG_TUD_HID    0
+#define CFG_TUD_MIDI   0
+#define CFG_TUD_VENDOR 0
+#define CFG_TUD_AUDIO  1
+
+// ── Mass storage: one transfer buffer, split into sectors for the card ──
+// 32 sectors per read10 / write10 callback, so the card sees multi-block commands
+#define CFG_TUD_MSC_EP_BUFSIZE (32 * 512)
+
+// ── UAC2 microphone: 48kHz, 16-bit, stereo, asynchronous ──
+#define USB_AUDIO_SAMPLE_RATE   48000
+#define USB_AUDIO_CHANNELS      2
+#define USB_AUDIO_BYTES_PER_SAMPLE 2
+// One frame carries 47-49 samples per channel as the I2S clock is tracked
+#define USB_AUDIO_EP_SIZE (((USB_AUDIO_SAMPLE_RATE / 1000) + 1) * USB_AUDIO_CHANNELS * USB_AUDIO_BYTES_PER_SAMPLE)
+
+#define CFG_TUD_AUDIO_FUNC_1_DESC_LEN            USB_AUDIO_DESC_LEN
+#define CFG_TUD_AUDIO_FUNC_1_N_AS_INT            1
+#define CFG_TUD_AUDIO_FUNC_1_CTRL_BUF_SZ         64
+#define CFG_TUD_AUDIO_ENABLE_EP_IN               1
+#define CFG_TUD_AUDIO_FUNC_1_N_BYTES_PER_SAMPLE_TX USB_AUDIO_BYTES_PER_SAMPLE
+#define CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_TX       USB_AUDIO_CHANNELS
+#define CFG_TUD_AUDIO_EP_SZ_IN                   USB_AUDIO_EP_SIZE
+#define CFG_TUD_AUDIO_FUNC_1_EP_IN_SZ_MAX        CFG_TUD_AUDIO_EP_SZ_IN
+#define CFG_TUD_AUDIO_FUNC_1_EP_IN_SW_BUF_SZ     (4 * CFG_TUD_AUDIO_EP_SZ_IN)
+
+// Descriptor length, shared with usb_audio.cpp (sums the TUD_AUDIO_DESC_*_LEN pieces it emits)
+#define USB_AUDIO_DESC_LEN (TUD_AUDIO_DESC_IAD_LEN + TUD_AUDIO_DESC_STD_AC_LEN + TUD_AUDIO_DESC_CS_AC_LEN \
+    + TUD_AUDIO_DESC_CLK_SRC_LEN + TUD_AUDIO_DESC_INPUT_TERM_LEN + TUD_AUDIO_DESC_OUTPUT_TERM_LEN         \
+    + TUD_AUDIO_DESC_FEATURE_UNIT_TWO_CHANNEL_LEN + TUD_AUDIO_DESC_STD_AS_INT_LEN                          \
+    + TUD_AUDIO_DESC_STD_AS_INT_LEN + TUD_AUDIO_DESC_CS_AS_INT_LEN + TUD_AUDIO_DESC_TYPE_I_FORMAT_LEN      \
+    + TUD_AUDIO_DESC_STD_AS_ISO_EP_LEN + TUD_AUDIO_DESC_CS_AS_ISO_EP_LEN)
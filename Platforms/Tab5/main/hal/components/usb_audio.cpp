@@ -0,0 +1,341 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "usb_audio.h"
+#include "usb_device.h"
+#include <mooncake_log.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <esp_heap_caps.h>
+#include <tusb.h>
+
+static const char* TAG = "UsbAudio";
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Descriptors
+// ─────────────────────────────────────────────────────────────────────────────
+
+enum {
+    ITF_NUM_AUDIO_CONTROL = 0,
+    ITF_NUM_AUDIO_STREAMING,
+    ITF_NUM_TOTAL,
+};
+
+// Entity IDs: clock → input terminal → feature unit → USB streaming terminal
+static constexpr uint8_t UAC_ENTITY_INPUT_TERMINAL  = 0x01;
+static constexpr uint8_t UAC_ENTITY_FEATURE_UNIT    = 0x02;
+static constexpr uint8_t UAC_ENTITY_OUTPUT_TERMINAL = 0x03;
+static constexpr uint8_t UAC_ENTITY_CLOCK           = 0x04;
+static constexpr uint8_t EPNUM_AUDIO_IN             = 0x81;
+
+static const tusb_desc_device_t kDeviceDesc = {
+    .bLength            = sizeof(tusb_desc_device_t),
+    .bDescriptorType    = TUSB_DESC_DEVICE,
+    .bcdUSB             = 0x0200,
+    // IAD: the audio function is two interfaces
+    .bDeviceClass       = TUSB_CLASS_MISC,
+    .bDeviceSubClass    = MISC_SUBCLASS_COMMON,
+    .bDeviceProtocol    = MISC_PROTOCOL_IAD,
+    .bMaxPacketSize0    = CFG_TUD_ENDPOINT0_SIZE,
+    .idVendor           = 0x303A,
+    .idProduct          = 0x8173,
+    .bcdDevice          = 0x0100,
+    .iManufacturer      = 0x01,
+    .iProduct           = 0x02,
+    .iSerialNumber      = 0x03,
+    .bNumConfigurations = 0x01,
+};
+
+#define CONFIG_TOTAL_LEN (TUD_CONFIG_DESC_LEN + USB_AUDIO_DESC_LEN)
+
+static const uint8_t kConfigDesc[] = {
+    TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0x00, 100),
+
+    TUD_AUDIO_DESC_IAD(ITF_NUM_AUDIO_CONTROL, 0x02, 0x00),
+    TUD_AUDIO_DESC_STD_AC(ITF_NUM_AUDIO_CONTROL, 0x00, 0x04),
+    TUD_AUDIO_DESC_CS_AC(0x0200, AUDIO_FUNC_MICROPHONE,
+        TUD_AUDIO_DESC_CLK_SRC_LEN + TUD_AUDIO_DESC_INPUT_TERM_LEN + TUD_AUDIO_DESC_OUTPUT_TERM_LEN +
+            TUD_AUDIO_DESC_FEATURE_UNIT_TWO_CHANNEL_LEN,
+        AUDIO_CS_AS_INTERFACE_CTRL_LATENCY_POS),
+    // Fixed internal clock: the I2S clock, which is what the packet pacing tracks
+    TUD_AUDIO_DESC_CLK_SRC(UAC_ENTITY_CLOCK, AUDIO_CLOCK_SOURCE_ATT_INT_FIX_CLK,
+        (AUDIO_CTRL_R << AUDIO_CLOCK_SOURCE_CTRL_CLK_FRQ_POS), UAC_ENTITY_INPUT_TERMINAL, 0x00),
+    TUD_AUDIO_DESC_INPUT_TERM(UAC_ENTITY_INPUT_TERMINAL, AUDIO_TERM_TYPE_IN_GENERIC_MIC, UAC_ENTITY_OUTPUT_TERMINAL,
+        UAC_ENTITY_CLOCK, USB_AUDIO_CHANNELS, AUDIO_CHANNEL_CONFIG_NON_PREDEFINED, 0x00,
+        AUDIO_CTRL_R << AUDIO_IN_TERM_CTRL_CONNECTOR_POS, 0x00),
+    TUD_AUDIO_DESC_OUTPUT_TERM(UAC_ENTITY_OUTPUT_TERMINAL, AUDIO_TERM_TYPE_USB_STREAMING, UAC_ENTITY_INPUT_TERMINAL,
+        UAC_ENTITY_FEATURE_UNIT, UAC_ENTITY_CLOCK, 0x0000, 0x00),
+    TUD_AUDIO_DESC_FEATURE_UNIT_TWO_CHANNEL(UAC_ENTITY_FEATURE_UNIT, UAC_ENTITY_INPUT_TERMINAL,
+        AUDIO_CTRL_RW << AUDIO_FEATURE_UNIT_CTRL_MUTE_POS | AUDIO_CTRL_RW << AUDIO_FEATURE_UNIT_CTRL_VOLUME_POS,
+        AUDIO_CTRL_RW << AUDIO_FEATURE_UNIT_CTRL_MUTE_POS | AUDIO_CTRL_RW << AUDIO_FEATURE_UNIT_CTRL_VOLUME_POS,
+        AUDIO_CTRL_RW << AUDIO_FEATURE_UNIT_CTRL_MUTE_POS | AUDIO_CTRL_RW << AUDIO_FEATURE_UNIT_CTRL_VOLUME_POS,
+        0x00),
+
+    // Alt 0: zero bandwidth; alt 1: streaming
+    TUD_AUDIO_DESC_STD_AS_INT(ITF_NUM_AUDIO_STREAMING, 0x00, 0x00, 0x05),
+    TUD_AUDIO_DESC_STD_AS_INT(ITF_NUM_AUDIO_STREAMING, 0x01, 0x01, 0x05),
+    TUD_AUDIO_DESC_CS_AS_INT(UAC_ENTITY_OUTPUT_TERMINAL, AUDIO_CTRL_NONE, AUDIO_FORMAT_TYPE_I,
+        AUDIO_DATA_FORMAT_TYPE_I_PCM, USB_AUDIO_CHANNELS, AUDIO_CHANNEL_CONFIG_NON_PREDEFINED, 0x00),
+    TUD_AUDIO_DESC_TYPE_I_FORMAT(USB_AUDIO_BYTES_PER_SAMPLE, 16),
+    TUD_AUDIO_DESC_STD_AS_ISO_EP(EPNUM_AUDIO_IN,
+        (uint8_t)((uint8_t)TUSB_XFER_ISOCHRONOUS | (uint8_t)TUSB_ISO_EP_ATT_ASYNCHRONOUS | (uint8_t)TUSB_ISO_EP_ATT_DATA),
+        USB_AUDIO_EP_SIZE, 0x01),
+    TUD_AUDIO_DESC_CS_AS_ISO_EP(AUDIO_CS_AS_ISO_DATA_EP_ATT_NON_MAX_PACKETS_OK, AUDIO_CTRL_NONE,
+        AUDIO_CS_AS_ISO_DATA_EP_LOCK_DELAY_UNIT_UNDEFINED, 0x0000),
+};
+static_assert(sizeof(kConfigDesc) == CONFIG_TOTAL_LEN, "UAC2 descriptor length mismatch");
+
+static const char* const kStrings[] = {
+    nullptr,  // 0: language, answered by UsbDevice
+    "Howizard",
+    "Howizard Tab5",
+    "0001",
+    "Howizard Mic",
+    "Howizard Mic Stream",
+};
+
+static const UsbFunctionDescriptors kDescriptors = {
+    reinterpret_cast<const uint8_t*>(&kDeviceDesc),
+    kConfigDesc,
+    kStrings,
+    sizeof(kStrings) / sizeof(kStrings[0]),
+};
+
+extern "C" {
+
+// ─────────────────────────────────────────────────────────────────────────────
+// UAC2 class callbacks (USB task)
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool tud_audio_set_itf_cb(uint8_t rhport, tusb_control_request_t const* p_request)
+{
+    (void)rhport;
+    if (TU_U16_LOW(p_request->wIndex) == ITF_NUM_AUDIO_STREAMING) {
+        UsbAudio::getInstance().setStreaming(TU_U16_LOW(p_request->wValue) != 0);
+    }
+    return true;
+}
+
+bool tud_audio_set_itf_close_EP_cb(uint8_t rhport, tusb_control_request_t const* p_request)
+{
+    (void)rhport;
+    if (TU_U16_LOW(p_request->wIndex) == ITF_NUM_AUDIO_STREAMING) {
+        UsbAudio::getInstance().setStreaming(false);
+    }
+    return true;
+}
+
+bool tud_audio_get_req_entity_cb(uint8_t rhport, tusb_control_request_t const* p_request)
+{
+    UsbAudio& usb = UsbAudio::getInstance();
+    const uint8_t channel = TU_U16_LOW(p_request->wValue);
+    const uint8_t ctrl = TU_U16_HIGH(p_request->wValue);
+    const uint8_t entity = TU_U16_HIGH(p_request->wIndex);
+
+    if (entity == UAC_ENTITY_INPUT_TERMINAL && ctrl == AUDIO_TE_CTRL_CONNECTOR) {
+        audio_desc_channel_cluster_t cluster = {};
+        cluster.bNrChannels = USB_AUDIO_CHANNELS;
+        cluster.bmChannelConfig = AUDIO_CHANNEL_CONFIG_NON_PREDEFINED;
+        return tud_audio_buffer_and_schedule_control_xfer(rhport, p_request, &cluster, sizeof(cluster));
+    }
+    if (entity == UAC_ENTITY_FEATURE_UNIT && channel < 3) {
+        if (ctrl == AUDIO_FU_CTRL_MUTE) {
+            uint8_t mute = usb.mute[channel] ? 1 : 0;
+            return tud_audio_buffer_and_schedule_control_xfer(rhport, p_request, &mute, 1);
+        }
+        if (ctrl == AUDIO_FU_CTRL_VOLUME && p_request->bRequest == AUDIO_CS_REQ_CUR) {
+            return tud_audio_buffer_and_schedule_control_xfer(rhport, p_request, &usb.volume[channel],
+                sizeof(int16_t));
+        }
+        if (ctrl == AUDIO_FU_CTRL_VOLUME && p_request->bRequest == AUDIO_CS_REQ_RANGE) {
+            audio_control_range_2_n_t(1) range = {};
+            range.wNumSubRanges = tu_htole16(1);
+            range.subrange[0].bMin = tu_htole16(-90 * 256);
+            range.subrange[0].bMax = tu_htole16(0);
+            range.subrange[0].bRes = tu_htole16(256);
+            return tud_audio_buffer_and_schedule_control_xfer(rhport, p_request, &range, sizeof(range));
+        }
+    }
+    if (entity == UAC_ENTITY_CLOCK) {
+        if (ctrl == AUDIO_CS_CTRL_SAM_FREQ && p_request->bRequest == AUDIO_CS_REQ_CUR) {
+            audio_control_cur_4_t freq = {static_cast<int32_t>(tu_htole32(USB_AUDIO_SAMPLE_RATE))};
+            return tud_audio_buffer_and_schedule_control_xfer(rhport, p_request, &freq, sizeof(freq));
+        }
+        if (ctrl == AUDIO_CS_CTRL_SAM_FREQ && p_request->bRequest == AUDIO_CS_REQ_RANGE) {
+            audio_control_range_4_n_t(1) range = {};
+            range.wNumSubRanges = tu_htole16(1);
+            range.subrange[0].bMin = static_cast<int32_t>(tu_htole32(USB_AUDIO_SAMPLE_RATE));
+            range.subrange[0].bMax = static_cast<int32_t>(tu_htole32(USB_AUDIO_SAMPLE_RATE));
+            range.subrange[0].bRes = 0;
+            return tud_audio_buffer_and_schedule_control_xfer(rhport, p_request, &range, sizeof(range));
+        }
+        if (ctrl == AUDIO_CS_CTRL_CLK_VALID && p_request->bRequest == AUDIO_CS_REQ_CUR) {
+            audio_control_cur_1_t valid = {1};
+            return tud_audio_buffer_and_schedule_control_xfer(rhport, p_request, &valid, sizeof(valid));
+        }
+    }
+    return false;
+}
+
+bool tud_audio_set_req_entity_cb(uint8_t rhport, tusb_control_request_t const* p_request, uint8_t* pBuff)
+{
+    (void)rhport;
+    UsbAudio& usb = UsbAudio::getInstance();
+    const uint8_t channel = TU_U16_LOW(p_request->wValue);
+    const uint8_t ctrl = TU_U16_HIGH(p_request->wValue);
+    const uint8_t entity = TU_U16_HIGH(p_request->wIndex);
+    if (entity != UAC_ENTITY_FEATURE_UNIT || channel >= 3 || p_request->bRequest != AUDIO_CS_REQ_CUR) return false;
+
+    if (ctrl == AUDIO_FU_CTRL_MUTE) {
+        usb.mute[channel] = pBuff[0] ? 1 : 0;
+    } else if (ctrl == AUDIO_FU_CTRL_VOLUME) {
+        int16_t vol;
+        memcpy(&vol, pBuff, sizeof(vol));
+        usb.volume[channel] = std::clamp<int16_t>(vol, -90 * 256, 0);
+    } else {
+        return false;
+    }
+    usb.updateGains();
+    return true;
+}
+
+bool tud_audio_tx_done_pre_load_cb(uint8_t rhport, uint8_t itf, uint8_t ep_in, uint8_t cur_alt_setting)
+{
+    (void)rhport;
+    (void)itf;
+    (void)ep_in;
+    (void)cur_alt_setting;
+    return UsbAudio::getInstance().sendPacket();
+}
+
+}  // extern "C"
+
+// ─────────────────────────────────────────────────────────────────────────────
+// UsbAudio
+// ─────────────────────────────────────────────────────────────────────────────
+
+UsbAudio& UsbAudio::getInstance()
+{
+    static UsbAudio instance;
+    return instance;
+}
+
+bool UsbAudio::start(Source source)
+{
+    _source.store(source, std::memory_order_relaxed);
+    if (_enabled.load(std::memory_order_relaxed)) return true;
+
+    if (!_ring) {
+        _ring = static_cast<int16_t*>(heap_caps_calloc(RING_FRAMES * 2, sizeof(int16_t),
+            MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+        if (!_ring) {
+            mclog::tagError(TAG, "no PSRAM for the USB audio ring");
+            return false;
+        }
+    }
+    updateGains();
+    // Core 0 above the AEC worker: a late tud_task() misses a 1ms frame outright
+    if (!UsbDevice::getInstance().attach(UsbDevice::FUNCTION_AUDIO, kDescriptors, 11)) return false;
+    _enabled.store(true, std::memory_order_relaxed);
+    mclog::tagInfo(TAG, "USB microphone up ({})", source == SOURCE_OUTPUT ? "processed output" : "raw mics");
+    return true;
+}
+
+void UsbAudio::stop()
+{
+    if (!_enabled.load(std::memory_order_relaxed)) return;
+    _streaming.store(false, std::memory_order_relaxed);
+    _enabled.store(false, std::memory_order_relaxed);
+    UsbDevice::getInstance().detach(UsbDevice::FUNCTION_AUDIO);
+    mclog::tagInfo(TAG, "USB microphone detached");
+}
+
+UsbAudioStats UsbAudio::getStats()
+{
+    UsbAudioStats s;
+    s.enabled = isEnabled();
+    s.streaming = _streaming.load(std::memory_order_relaxed);
+    s.packets = _packets.load(std::memory_order_relaxed);
+    s.trims = _trims.load(std::memory_order_relaxed);
+    s.underruns = _underruns.load(std::memory_order_relaxed);
+    s.overflows = _overflows.load(std::memory_order_relaxed);
+    s.fillFrames = _head.load(std::memory_order_relaxed) - _tail.load(std::memory_order_relaxed);
+    return s;
+}
+
+void UsbAudio::push(const int16_t* stereo, int frames)
+{
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    const uint32_t tail = _tail.load(std::memory_order_acquire);
+    const uint32_t space = RING_FRAMES - (head - tail);
+    const uint32_t n = std::min<uint32_t>(frames, space);
+    if (n < static_cast<uint32_t>(frames)) _overflows.fetch_add(frames - n, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < n; i++, head++) {
+        const uint32_t pos = (head & (RING_FRAMES - 1)) * 2;
+        _ring[pos] = stereo[2 * i];
+        _ring[pos + 1] = stereo[2 * i + 1];
+    }
+    _head.store(head, std::memory_order_release);
+}
+
+void UsbAudio::setStreaming(bool on)
+{
+    if (on) {
+        // Start from an empty queue so the host doesn't get stale audio
+        _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+        _primed = false;
+        _fillAvg = 0.0f;
+    }
+    _streaming.store(on, std::memory_order_relaxed);
+}
+
+void UsbAudio::updateGains()
+{
+    for (int c = 0; c < 2; c++) {
+        const bool muted = mute[0] || mute[c + 1];
+        const float db = (volume[0] + volume[c + 1]) / 256.0f;
+        _gain[c] = muted ? 0.0f : powf(10.0f, db / 20.0f);
+    }
+}
+
+bool UsbAudio::sendPacket()
+{
+    constexpr int NOMINAL = USB_AUDIO_SAMPLE_RATE / 1000;
+    int16_t packet[(NOMINAL + 1) * 2];
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    const uint32_t fill = _head.load(std::memory_order_acquire) - tail;
+
+    // Engine blocks land in bursts; pace on the smoothed depth (~50ms)
+    _fillAvg += (static_cast<float>(fill) - _fillAvg) * 0.02f;
+    int frames = NOMINAL;
+    if (_fillAvg > TARGET_FRAMES + TRIM_HYSTERESIS) frames = NOMINAL + 1;
+    else if (_fillAvg < static_cast<float>(TARGET_FRAMES) - TRIM_HYSTERESIS) frames = NOMINAL - 1;
+    if (frames != NOMINAL) _trims.fetch_add(1, std::memory_order_relaxed);
+
+    // Build up the target depth before the first real packet (and after an underrun)
+    if (!_primed && fill >= TARGET_FRAMES) {
+        _primed = true;
+        _fillAvg = static_cast<float>(fill);
+    }
+    int n = 0;
+    if (_primed) {
+        n = std::min<int>(frames, fill);
+        for (int i = 0; i < n; i++, tail++) {
+            const uint32_t pos = (tail & (RING_FRAMES - 1)) * 2;
+            packet[2 * i] = static_cast<int16_t>(_ring[pos] * _gain[0]);
+            packet[2 * i + 1] = static_cast<int16_t>(_ring[pos + 1] * _gain[1]);
+        }
+        _tail.store(tail, std::memory_order_release);
+        if (n < frames) {
+            _underruns.fetch_add(1, std::memory_order_relaxed);
+            _primed = false;
+        }
+    }
+    memset(packet + 2 * n, 0, (frames - n) * 2 * sizeof(int16_t));
+    tud_audio_write(packet, static_cast<uint16_t>(frames * 2 * sizeof(int16_t)));
+    _packets.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
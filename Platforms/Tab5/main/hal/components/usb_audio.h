@@ -0,0 +1,94 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+struct UsbAudioStats {
+    bool enabled = false;
+    bool streaming = false;     // Host has the IN alt setting open
+    uint32_t packets = 0;       // 1ms packets sent
+    uint32_t trims = 0;         // 47/49-frame packets sent to track the I2S clock
+    uint32_t underruns = 0;     // Packets padded with silence (engine behind the host)
+    uint32_t overflows = 0;     // Frames the audio task couldn't queue (host not draining)
+    uint32_t fillFrames = 0;    // Smoothed queue depth
+};
+
+/**
+ * @brief UAC2 USB microphone streaming the engine to a PC
+ *
+ * Attaches to the TinyUSB device on the full-speed OTG port behind USB-C
+ * (UsbDevice, which takes it over from the USB-Serial-JTAG console until
+ * reboot) and presents a 48kHz / 16-bit stereo asynchronous microphone. The audio task
+ * queues frames into a wait-free ring; the USB task sends one packet per
+ * 1ms frame and paces by the queue depth, so 47 or 49 frames go out when the
+ * I2S clock runs slow or fast against the host's SOF. For an IN stream that
+ * is the asynchronous endpoint's timing: the data rate itself carries the
+ * device clock, no feedback endpoint is involved.
+ *
+ * The source is the processed output (what the earpieces hear) or the raw
+ * front mic pair for using the Tab5 as a plain USB mic.
+ */
+class UsbAudio {
+public:
+    enum Source : uint8_t {
+        SOURCE_OUTPUT,  // Processed engine output
+        SOURCE_MICS,    // MIC-L / MIC-R before any DSP
+    };
+
+    static UsbAudio& getInstance();
+
+    bool start(Source source = SOURCE_OUTPUT);
+    void stop();  // Detaches from the host; the port stays with TinyUSB for the next function
+    bool isEnabled() const
+    {
+        return _enabled.load(std::memory_order_relaxed);
+    }
+    UsbAudioStats getStats();
+
+    // ── Audio task (wait-free) ──
+    bool wants(Source s) const
+    {
+        return _streaming.load(std::memory_order_relaxed) && _source.load(std::memory_order_relaxed) == s;
+    }
+    void push(const int16_t* stereo, int frames);
+
+    // ── USB task (TinyUSB class callbacks in usb_audio.cpp) ──
+    void setStreaming(bool on);
+    bool sendPacket();
+    int16_t mute[3] = {};     // Feature unit CUR values: master, L, R
+    int16_t volume[3] = {};   // 1/256 dB
+    void updateGains();
+
+private:
+    UsbAudio() = default;
+    UsbAudio(const UsbAudio&) = delete;
+    UsbAudio& operator=(const UsbAudio&) = delete;
+
+    static constexpr uint32_t RING_FRAMES = 4096;  // ~85ms
+    // Queue depth the pacing settles on: half the largest engine block plus 2ms
+    static constexpr uint32_t TARGET_FRAMES = 240 + 96;
+    static constexpr uint32_t TRIM_HYSTERESIS = 24;
+
+    int16_t* _ring = nullptr;  // RING_FRAMES stereo frames, PSRAM, allocated on first start
+    std::atomic<uint32_t> _head{0};
+    std::atomic<uint32_t> _tail{0};
+    std::atomic<bool> _enabled{false};
+    std::atomic<bool> _streaming{false};
+    std::atomic<Source> _source{SOURCE_OUTPUT};
+
+    // USB task only
+    bool _primed = false;
+    float _fillAvg = 0.0f;
+    float _gain[2] = {1.0f, 1.0f};
+
+    std::atomic<uint32_t> _packets{0};
+    std::atomic<uint32_t> _trims{0};
+    std::atomic<uint32_t> _underruns{0};
+    std::atomic<uint32_t> _overflows{0};
+};
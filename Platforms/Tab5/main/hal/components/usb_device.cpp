@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "usb_device.h"
+#include <mooncake_log.h>
+#include <algorithm>
+#include <cstring>
+#include <esp_private/usb_phy.h>
+#include <tusb.h>
+
+static const char* TAG = "UsbDevice";
+
+extern "C" {
+
+uint8_t const* tud_descriptor_device_cb(void)
+{
+    const UsbFunctionDescriptors* desc = UsbDevice::getInstance().descriptors();
+    return desc ? desc->device : nullptr;
+}
+
+uint8_t const* tud_descriptor_configuration_cb(uint8_t index)
+{
+    (void)index;
+    const UsbFunctionDescriptors* desc = UsbDevice::getInstance().descriptors();
+    return desc ? desc->configuration : nullptr;
+}
+
+uint16_t const* tud_descriptor_string_cb(uint8_t index, uint16_t langid)
+{
+    (void)langid;
+    static uint16_t str[32];
+    const UsbFunctionDescriptors* desc = UsbDevice::getInstance().descriptors();
+    uint8_t chars;
+    if (index == 0) {
+        str[1] = 0x0409;  // English (US)
+        chars = 1;
+    } else {
+        if (!desc || index >= desc->stringCount) return nullptr;
+        const char* s = desc->strings[index];
+        chars = static_cast<uint8_t>(std::min<size_t>(strlen(s), 31));
+        for (uint8_t i = 0; i < chars; i++) str[1 + i] = s[i];
+    }
+    str[0] = static_cast<uint16_t>((TUSB_DESC_STRING << 8) | (2 * chars + 2));
+    return str;
+}
+
+}  // extern "C"
+
+UsbDevice& UsbDevice::getInstance()
+{
+    static UsbDevice instance;
+    return instance;
+}
+
+void UsbDevice::usbTask(void* param)
+{
+    (void)param;
+    while (true) tud_task();
+}
+
+bool UsbDevice::install(UBaseType_t taskPriority)
+{
+    // Full-speed OTG via the internal PHY (USB-C): USB-Serial-JTAG gives the port up
+    usb_phy_config_t phyConf = {};
+    phyConf.controller = USB_PHY_CTRL_OTG;
+    phyConf.target = USB_PHY_TARGET_INT;
+    phyConf.otg_mode = USB_OTG_MODE_DEVICE;
+    phyConf.otg_speed = USB_PHY_SPEED_FULL;
+    usb_phy_handle_t phy = nullptr;
+    if (usb_new_phy(&phyConf, &phy) != ESP_OK) {
+        mclog::tagError(TAG, "failed to claim the USB PHY");
+        return false;
+    }
+    if (!tusb_init()) {
+        mclog::tagError(TAG, "TinyUSB init failed");
+        usb_del_phy(phy);
+        return false;
+    }
+    if (xTaskCreatePinnedToCore(usbTask, "usb_device", 4096, nullptr, taskPriority, &_task, 0) != pdPASS) {
+        mclog::tagError(TAG, "failed to create USB task");
+        return false;
+    }
+    _installed = true;
+    return true;
+}
+
+bool UsbDevice::attach(Function function, const UsbFunctionDescriptors& desc, UBaseType_t taskPriority)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    const Function current = _attached.load(std::memory_order_relaxed);
+    if (current == function) return true;
+    if (current != FUNCTION_NONE) {
+        mclog::tagWarn(TAG, "USB port in use by another function");
+        return false;
+    }
+
+    // Set before connecting: the host asks for descriptors right away
+    _desc.store(&desc, std::memory_order_release);
+    if (!_installed) {
+        // tusb_init() connects on its own
+        if (!install(taskPriority)) return false;
+    } else {
+        vTaskPrioritySet(_task, taskPriority);
+        tud_connect();
+    }
+    _attached.store(function, std::memory_order_release);
+    return true;
+}
+
+void UsbDevice::detach(Function function)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_attached.load(std::memory_order_relaxed) != function) return;
+    tud_disconnect();
+    vTaskDelay(pdMS_TO_TICKS(DETACH_MS));
+    _attached.store(FUNCTION_NONE, std::memory_order_release);
+}
@@ -0,0 +1,76 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// One function's descriptor tables, as TinyUSB's descriptor callbacks hand them out
+struct UsbFunctionDescriptors {
+    const uint8_t* device;         // tusb_desc_device_t
+    const uint8_t* configuration;  // Full configuration descriptor
+    const char* const* strings;    // Index 0 (language) is answered here, its entry unused
+    uint8_t stringCount;
+};
+
+/**
+ * @brief Owner of the TinyUSB device on the USB-C port, shared by its functions
+ *
+ * TinyUSB is built with every class the app uses (usb/tusb_config.h), but the host
+ * sees one function at a time: attach() points the descriptor callbacks at that
+ * function's tables and connects, so going from the microphone to mass storage is
+ * a detach / attach and the host enumerates a different device.
+ *
+ * The first attach() claims the full-speed OTG PHY (USB-Serial-JTAG gives the port
+ * up until reboot) and starts the tud_task() loop on Core 0. Its priority follows
+ * the attached function: the audio class misses a 1ms frame when the task is late,
+ * the MSC class runs SD card I/O inside it and must not hold up the audio side.
+ */
+class UsbDevice {
+public:
+    enum Function : uint8_t {
+        FUNCTION_NONE,
+        FUNCTION_AUDIO,  // UsbAudio
+        FUNCTION_MSC,    // UsbMsc
+    };
+
+    // Long enough disconnected for the host to drop the old function
+    static constexpr uint32_t DETACH_MS = 200;
+
+    static UsbDevice& getInstance();
+
+    // desc has to outlive the attachment. false if another function holds the
+    // port or the bring-up failed.
+    bool attach(Function function, const UsbFunctionDescriptors& desc, UBaseType_t taskPriority);
+    // Disconnects from the host, if `function` is the one attached
+    void detach(Function function);
+    Function attached() const
+    {
+        return _attached.load(std::memory_order_acquire);
+    }
+
+    // TinyUSB descriptor callbacks (usb_device.cpp)
+    const UsbFunctionDescriptors* descriptors() const
+    {
+        return _desc.load(std::memory_order_acquire);
+    }
+
+private:
+    UsbDevice() = default;
+    UsbDevice(const UsbDevice&) = delete;
+    UsbDevice& operator=(const UsbDevice&) = delete;
+
+    static void usbTask(void* param);
+    bool install(UBaseType_t taskPriority);
+
+    std::mutex _mutex;  // attach / detach
+    std::atomic<Function> _attached{FUNCTION_NONE};
+    std::atomic<const UsbFunctionDescriptors*> _desc{nullptr};
+    bool _installed = false;
+    TaskHandle_t _task = nullptr;
+};
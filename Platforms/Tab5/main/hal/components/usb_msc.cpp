@@ -0,0 +1,322 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "usb_msc.h"
+#include "usb_device.h"
+#include "sd_storage.h"
+#include "audio_recorder.h"
+#include "video_recorder.h"
+#include "media_player.h"
+#include "stress_test.h"
+#include "sampling_profiler.h"
+#include "firmware_update.h"
+#include <mooncake_log.h>
+#include <bsp/m5stack_tab5.h>
+#include <cstring>
+#include <tusb.h>
+
+static const char* TAG = "UsbMsc";
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Descriptors
+// ─────────────────────────────────────────────────────────────────────────────
+
+enum {
+    ITF_NUM_MSC = 0,
+    ITF_NUM_TOTAL,
+};
+
+static constexpr uint8_t EPNUM_MSC_OUT = 0x01;
+static constexpr uint8_t EPNUM_MSC_IN  = 0x81;
+
+static const tusb_desc_device_t kDeviceDesc = {
+    .bLength            = sizeof(tusb_desc_device_t),
+    .bDescriptorType    = TUSB_DESC_DEVICE,
+    .bcdUSB             = 0x0200,
+    // Class per interface
+    .bDeviceClass       = 0x00,
+    .bDeviceSubClass    = 0x00,
+    .bDeviceProtocol    = 0x00,
+    .bMaxPacketSize0    = CFG_TUD_ENDPOINT0_SIZE,
+    .idVendor           = 0x303A,
+    // Not the microphone's: the host keeps its drivers for the two apart
+    .idProduct          = 0x8174,
+    .bcdDevice          = 0x0100,
+    .iManufacturer      = 0x01,
+    .iProduct           = 0x02,
+    .iSerialNumber      = 0x03,
+    .bNumConfigurations = 0x01,
+};
+
+#define MSC_CONFIG_TOTAL_LEN (TUD_CONFIG_DESC_LEN + TUD_MSC_DESC_LEN)
+
+static const uint8_t kConfigDesc[] = {
+    TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, MSC_CONFIG_TOTAL_LEN, 0x00, 100),
+    // Bulk endpoints are 64 bytes at full speed
+    TUD_MSC_DESCRIPTOR(ITF_NUM_MSC, 0x04, EPNUM_MSC_OUT, EPNUM_MSC_IN, 64),
+};
+static_assert(sizeof(kConfigDesc) == MSC_CONFIG_TOTAL_LEN, "MSC descriptor length mismatch");
+
+static const char* const kStrings[] = {
+    nullptr,  // 0: language, answered by UsbDevice
+    "Howizard",
+    "Howizard Tab5",
+    "0001",
+    "Howizard SD Card",
+};
+
+static const UsbFunctionDescriptors kDescriptors = {
+    reinterpret_cast<const uint8_t*>(&kDeviceDesc),
+    kConfigDesc,
+    kStrings,
+    sizeof(kStrings) / sizeof(kStrings[0]),
+};
+
+// ─────────────────────────────────────────────────────────────────────────────
+// MSC class callbacks (USB task)
+// ─────────────────────────────────────────────────────────────────────────────
+
+extern "C" {
+
+void tud_msc_inquiry_cb(uint8_t lun, uint8_t vendor_id[8], uint8_t product_id[16], uint8_t product_rev[4])
+{
+    (void)lun;
+    // Space padded, not NUL terminated
+    memcpy(vendor_id, "Howizard", 8);
+    memcpy(product_id, "Tab5 SD Card    ", 16);
+    memcpy(product_rev, "1.0 ", 4);
+}
+
+bool tud_msc_test_unit_ready_cb(uint8_t lun)
+{
+    if (UsbMsc::getInstance().ready()) return true;
+    // Medium not present
+    tud_msc_set_sense(lun, SCSI_SENSE_NOT_READY, 0x3A, 0x00);
+    return false;
+}
+
+void tud_msc_capacity_cb(uint8_t lun, uint32_t* block_count, uint16_t* block_size)
+{
+    (void)lun;
+    UsbMsc::getInstance().capacity(block_count, block_size);
+}
+
+bool tud_msc_start_stop_cb(uint8_t lun, uint8_t power_condition, bool start, bool load_eject)
+{
+    (void)lun;
+    (void)power_condition;
+    if (load_eject && !start) UsbMsc::getInstance().eject();
+    return true;
+}
+
+bool tud_msc_is_writable_cb(uint8_t lun)
+{
+    (void)lun;
+    return true;
+}
+
+int32_t tud_msc_read10_cb(uint8_t lun, uint32_t lba, uint32_t offset, void* buffer, uint32_t bufsize)
+{
+    const int32_t n = UsbMsc::getInstance().read(lba, offset, buffer, bufsize);
+    // Unrecovered read error
+    if (n < 0) tud_msc_set_sense(lun, SCSI_SENSE_MEDIUM_ERROR, 0x11, 0x00);
+    return n;
+}
+
+int32_t tud_msc_write10_cb(uint8_t lun, uint32_t lba, uint32_t offset, uint8_t* buffer, uint32_t bufsize)
+{
+    const int32_t n = UsbMsc::getInstance().write(lba, offset, buffer, bufsize);
+    // Write error
+    if (n < 0) tud_msc_set_sense(lun, SCSI_SENSE_MEDIUM_ERROR, 0x0C, 0x00);
+    return n;
+}
+
+int32_t tud_msc_scsi_cb(uint8_t lun, uint8_t const scsi_cmd[16], void* buffer, uint16_t bufsize)
+{
+    (void)buffer;
+    (void)bufsize;
+    switch (scsi_cmd[0]) {
+        case SCSI_CMD_PREVENT_ALLOW_MEDIUM_REMOVAL:
+        case 0x35:  // SYNCHRONIZE CACHE (10): writes go to the card before write10 returns
+            return 0;
+        default:
+            // Invalid command operation code
+            tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, 0x20, 0x00);
+            return -1;
+    }
+}
+
+}  // extern "C"
+
+// ─────────────────────────────────────────────────────────────────────────────
+// UsbMsc
+// ─────────────────────────────────────────────────────────────────────────────
+
+UsbMsc& UsbMsc::getInstance()
+{
+    static UsbMsc instance;
+    return instance;
+}
+
+bool UsbMsc::cardBusy()
+{
+    const char* owner = nullptr;
+    if (AudioRecorder::getInstance().isRecording()) owner = "audio recorder";
+    else if (VideoRecorder::getInstance().isRecording()) owner = "video recorder";
+    else if (MediaPlayer::getInstance().isPlaying()) owner = "media player";
+    else if (StressTest::getInstance().isRunning()) owner = "stress run";
+    else if (SamplingProfiler::getInstance().isRunning()) owner = "profiler";
+    else if (FirmwareUpdate::getInstance().isRunning()) owner = "firmware update";
+    if (owner) mclog::tagWarn(TAG, "SD card in use by the {}", owner);
+    return owner != nullptr;
+}
+
+bool UsbMsc::start()
+{
+    if (_state.load(std::memory_order_acquire) != STATE_IDLE) return true;
+    if (UsbDevice::getInstance().attached() == UsbDevice::FUNCTION_AUDIO) {
+        mclog::tagWarn(TAG, "USB port in use by the microphone");
+        return false;
+    }
+    if (cardBusy()) return false;
+    uint8_t idle = STATE_IDLE;
+    if (!_state.compare_exchange_strong(idle, STATE_STARTING)) return true;
+    // Behind whatever is queued on the card
+    if (!SdStorage::getInstance().post(handOverJob, this)) {
+        _state.store(STATE_IDLE, std::memory_order_release);
+        return false;
+    }
+    return true;
+}
+
+void UsbMsc::stop()
+{
+    uint8_t active = STATE_ACTIVE;
+    if (!_state.compare_exchange_strong(active, STATE_STOPPING)) return;
+    if (!SdStorage::getInstance().post(takeBackJob, this)) {
+        _state.store(STATE_ACTIVE, std::memory_order_release);
+    }
+}
+
+UsbMscStats UsbMsc::getStats()
+{
+    UsbMscStats s;
+    s.active = isActive();
+    s.ejected = _ejected.load(std::memory_order_relaxed);
+    s.capacityMB = static_cast<uint32_t>(static_cast<uint64_t>(_blocks) * _blockSize / (1024 * 1024));
+    s.readKB = static_cast<uint32_t>(_readBytes.load(std::memory_order_relaxed) / 1024);
+    s.writtenKB = static_cast<uint32_t>(_writtenBytes.load(std::memory_order_relaxed) / 1024);
+    s.errors = _errors.load(std::memory_order_relaxed);
+    return s;
+}
+
+void UsbMsc::handOverJob(void* arg)
+{
+    static_cast<UsbMsc*>(arg)->handOver();
+}
+
+void UsbMsc::takeBackJob(void* arg)
+{
+    static_cast<UsbMsc*>(arg)->takeBack();
+}
+
+// Storage task
+void UsbMsc::handOver()
+{
+    SdStorage& sd = SdStorage::getInstance();
+    sd.suspend();
+
+    sdmmc_card_t* card = nullptr;
+    if (bsp_sdcard_raw_init(&card) != ESP_OK) {
+        mclog::tagError(TAG, "no SD card to hand over");
+        sd.resume();
+        _state.store(STATE_IDLE, std::memory_order_release);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_ioMutex);
+        _card = card;
+        _blocks = static_cast<uint32_t>(card->csd.capacity);
+        _blockSize = static_cast<uint16_t>(card->csd.sector_size);
+    }
+    _readBytes.store(0, std::memory_order_relaxed);
+    _writtenBytes.store(0, std::memory_order_relaxed);
+    _errors.store(0, std::memory_order_relaxed);
+    _ejected.store(false, std::memory_order_relaxed);
+    _ready.store(true, std::memory_order_release);
+
+    if (!UsbDevice::getInstance().attach(UsbDevice::FUNCTION_MSC, kDescriptors, TASK_PRIORITY)) {
+        _ready.store(false, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(_ioMutex);
+            _card = nullptr;
+        }
+        bsp_sdcard_raw_deinit();
+        sd.resume();
+        _state.store(STATE_IDLE, std::memory_order_release);
+        return;
+    }
+    _state.store(STATE_ACTIVE, std::memory_order_release);
+    mclog::tagInfo(TAG, "SD card on USB ({} MB)", getStats().capacityMB);
+}
+
+// Storage task
+void UsbMsc::takeBack()
+{
+    _ready.store(false, std::memory_order_release);
+    UsbDevice::getInstance().detach(UsbDevice::FUNCTION_MSC);
+    {
+        // Waits out a read10 / write10 still on the card
+        std::lock_guard<std::mutex> lock(_ioMutex);
+        _card = nullptr;
+    }
+    bsp_sdcard_raw_deinit();
+    SdStorage::getInstance().resume();
+    _state.store(STATE_IDLE, std::memory_order_release);
+    const UsbMscStats s = getStats();
+    mclog::tagInfo(TAG, "SD card back from USB: {} KB read, {} KB written, {} errors", s.readKB, s.writtenKB,
+        s.errors);
+}
+
+void UsbMsc::capacity(uint32_t* blocks, uint16_t* blockSize)
+{
+    std::lock_guard<std::mutex> lock(_ioMutex);
+    *blocks = _card ? _blocks : 0;
+    *blockSize = _blockSize;
+}
+
+int32_t UsbMsc::read(uint32_t lba, uint32_t offset, void* buffer, uint32_t bytes)
+{
+    std::lock_guard<std::mutex> lock(_ioMutex);
+    if (!_card || !ready()) return -1;
+    // offset is how far into the command this piece is, whole sectors since the buffer is
+    if (sdmmc_read_sectors(_card, buffer, lba + offset / _blockSize, bytes / _blockSize) != ESP_OK) {
+        _errors.fetch_add(1, std::memory_order_relaxed);
+        return -1;
+    }
+    _readBytes.fetch_add(bytes, std::memory_order_relaxed);
+    return static_cast<int32_t>(bytes);
+}
+
+int32_t UsbMsc::write(uint32_t lba, uint32_t offset, const uint8_t* buffer, uint32_t bytes)
+{
+    std::lock_guard<std::mutex> lock(_ioMutex);
+    if (!_card || !ready()) return -1;
+    if (sdmmc_write_sectors(_card, buffer, lba + offset / _blockSize, bytes / _blockSize) != ESP_OK) {
+        _errors.fetch_add(1, std::memory_order_relaxed);
+        return -1;
+    }
+    _writtenBytes.fetch_add(bytes, std::memory_order_relaxed);
+    return static_cast<int32_t>(bytes);
+}
+
+// USB task: the host is done with the disk, so the card goes back
+void UsbMsc::eject()
+{
+    if (_ejected.exchange(true, std::memory_order_acq_rel)) return;
+    _ready.store(false, std::memory_order_release);
+    mclog::tagInfo(TAG, "ejected by the host");
+    stop();
+}
@@ -0,0 +1,90 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <sdmmc_cmd.h>
+
+struct UsbMscStats {
+    bool active = false;      // The host has the card (or it's being handed over / back)
+    bool ejected = false;     // The host ejected it; the card comes back to /sd
+    uint32_t capacityMB = 0;
+    uint32_t readKB = 0;      // Since start()
+    uint32_t writtenKB = 0;
+    uint32_t errors = 0;      // Sector reads or writes the card refused
+};
+
+/**
+ * @brief USB mass storage: the SD card as a disk on the PC
+ *
+ * For pulling recordings and profiles off without pulling the card. start()
+ * hands the card over on the storage task, after whatever is queued there:
+ * SdStorage unmounts /sd and keeps it unmounted (so nothing on the device
+ * writes the FAT under the host), the card comes back up raw, and the MSC
+ * function attaches to the USB-C port in place of the microphone (UsbDevice).
+ * The audio engine keeps running; only what needs the card is locked out.
+ *
+ * The host's read10 / write10 land in CFG_TUD_MSC_EP_BUFSIZE pieces (32
+ * sectors), each one multi-block SDMMC command straight from TinyUSB's
+ * cache-aligned buffer. The port is full speed, so expect ~1 MB/s, no more.
+ *
+ * stop() (or an eject from the host) detaches and gives the card back to
+ * SdStorage; the next mount is a new generation. Stopping while the host
+ * still has the disk mounted is pulling a USB stick: eject on the PC first.
+ * start() refuses while a recorder, player, stress run, profiler or firmware
+ * update has the card, or the microphone has the port.
+ */
+class UsbMsc {
+public:
+    // The MSC class does card I/O on the USB task; below the UI and audio side
+    static constexpr uint32_t TASK_PRIORITY = 4;
+
+    static UsbMsc& getInstance();
+
+    bool start();
+    void stop();
+    bool isActive() const
+    {
+        return _state.load(std::memory_order_acquire) != STATE_IDLE;
+    }
+    UsbMscStats getStats();
+
+    // ── USB task (TinyUSB MSC callbacks in usb_msc.cpp) ──
+    bool ready() const
+    {
+        return _ready.load(std::memory_order_acquire);
+    }
+    void capacity(uint32_t* blocks, uint16_t* blockSize);
+    int32_t read(uint32_t lba, uint32_t offset, void* buffer, uint32_t bytes);
+    int32_t write(uint32_t lba, uint32_t offset, const uint8_t* buffer, uint32_t bytes);
+    void eject();
+
+private:
+    UsbMsc() = default;
+    UsbMsc(const UsbMsc&) = delete;
+    UsbMsc& operator=(const UsbMsc&) = delete;
+
+    enum State : uint8_t { STATE_IDLE, STATE_STARTING, STATE_ACTIVE, STATE_STOPPING };
+
+    bool cardBusy();
+    static void handOverJob(void* arg);
+    static void takeBackJob(void* arg);
+    void handOver();
+    void takeBack();
+
+    std::atomic<uint8_t> _state{STATE_IDLE};
+    std::atomic<bool> _ready{false};    // Card up and attached; the host may do I/O
+    std::atomic<bool> _ejected{false};
+    std::mutex _ioMutex;                // Card I/O against takeBack()
+    sdmmc_card_t* _card = nullptr;      // Raw, from the BSP, while handed over
+    uint32_t _blocks = 0;
+    uint16_t _blockSize = 512;
+
+    std::atomic<uint64_t> _readBytes{0};
+    std::atomic<uint64_t> _writtenBytes{0};
+    std::atomic<uint32_t> _errors{0};
+};
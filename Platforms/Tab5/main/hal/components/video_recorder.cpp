@@ -0,0 +1,380 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "video_recorder.h"
+#include "audio_recorder.h"
+#include "sd_storage.h"
+#include <mooncake_log.h>
+#include <algorithm>
+#include <cstring>
+#include <esp_heap_caps.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "linux/videodev2.h"
+#include "esp_video_device.h"
+
+static const char* TAG = "VideoRec";
+
+static constexpr int ENCODER_STACK = 4096;
+
+VideoRecorder& VideoRecorder::getInstance()
+{
+    static VideoRecorder instance;
+    return instance;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// H.264 device
+// ─────────────────────────────────────────────────────────────────────────────
+
+static bool setControl(int fd, uint32_t id, int32_t value)
+{
+    struct v4l2_ext_control control = {};
+    struct v4l2_ext_controls controls = {};
+    control.id = id;
+    control.value = value;
+    controls.ctrl_class = V4L2_CTRL_CLASS_CODEC;
+    controls.count = 1;
+    controls.controls = &control;
+    return ioctl(fd, VIDIOC_S_EXT_CTRLS, &controls) == 0;
+}
+
+bool VideoRecorder::openEncoder()
+{
+    _fd = open(ESP_VIDEO_H264_DEVICE_NAME, O_RDONLY);
+    if (_fd < 0) {
+        mclog::tagError(TAG, "no H.264 device (CONFIG_ESP_VIDEO_ENABLE_HW_H264_VIDEO_DEVICE)");
+        return false;
+    }
+
+    // The encoder takes its fps from the GOP: FPS frames per IDR
+    if (!setControl(_fd, V4L2_CID_MPEG_VIDEO_H264_I_PERIOD, FPS) || !setControl(_fd, V4L2_CID_MPEG_VIDEO_BITRATE, BITRATE)) {
+        mclog::tagWarn(TAG, "encoder controls left at driver defaults");
+    }
+
+    struct v4l2_format format = {};
+    format.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+    format.fmt.pix.width = WIDTH;
+    format.fmt.pix.height = HEIGHT;
+    format.fmt.pix.pixelformat = V4L2_PIX_FMT_YUV420;
+    bool ok = ioctl(_fd, VIDIOC_S_FMT, &format) == 0;
+    format.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    format.fmt.pix.pixelformat = V4L2_PIX_FMT_H264;
+    ok = ok && ioctl(_fd, VIDIOC_S_FMT, &format) == 0;
+
+    // YUV frames go in from our buffers, NALs come back in one driver buffer
+    struct v4l2_requestbuffers req = {};
+    req.count = 1;
+    req.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+    req.memory = V4L2_MEMORY_USERPTR;
+    ok = ok && ioctl(_fd, VIDIOC_REQBUFS, &req) == 0;
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    ok = ok && ioctl(_fd, VIDIOC_REQBUFS, &req) == 0;
+
+    struct v4l2_buffer buf = {};
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    ok = ok && ioctl(_fd, VIDIOC_QUERYBUF, &buf) == 0;
+    if (ok) {
+        _nal = static_cast<uint8_t*>(mmap(nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, buf.m.offset));
+        ok = _nal != nullptr && ioctl(_fd, VIDIOC_QBUF, &buf) == 0;
+    }
+
+    int type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+    ok = ok && ioctl(_fd, VIDIOC_STREAMON, &type) == 0;
+    type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    ok = ok && ioctl(_fd, VIDIOC_STREAMON, &type) == 0;
+    if (!ok) {
+        mclog::tagError(TAG, "H.264 device setup failed");
+        closeEncoder();
+        return false;
+    }
+    return true;
+}
+
+void VideoRecorder::closeEncoder()
+{
+    if (_fd < 0) return;
+    int type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+    ioctl(_fd, VIDIOC_STREAMOFF, &type);
+    type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    ioctl(_fd, VIDIOC_STREAMOFF, &type);
+    close(_fd);
+    _fd = -1;
+    _nal = nullptr;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Control
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool VideoRecorder::start(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_encoderAlive.load(std::memory_order_acquire)) {
+        mclog::tagWarn(TAG, "already recording");
+        return false;
+    }
+
+    if (!_staging) {
+        _staging = static_cast<uint8_t*>(heap_caps_aligned_alloc(64, SdStorage::IO_CHUNK,
+            MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA | MALLOC_CAP_8BIT));
+    }
+    for (auto& yuv : _yuv) {
+        // Cache-line aligned for the PPA and the encoder's USERPTR queue
+        if (!yuv) yuv = static_cast<uint8_t*>(heap_caps_aligned_calloc(128, YUV_BYTES, 1, MALLOC_CAP_DMA | MALLOC_CAP_SPIRAM));
+    }
+    if (!_staging || !_yuv[0] || !_yuv[1]) {
+        mclog::tagError(TAG, "no memory for the frame buffers");
+        return false;
+    }
+    if (!_ppa) {
+        ppa_client_config_t config = {};
+        config.oper_type = PPA_OPERATION_SRM;
+        config.max_pending_trans_num = 1;
+        if (ppa_register_client(&config, &_ppa) != ESP_OK) {
+            mclog::tagError(TAG, "no PPA client");
+            _ppa = nullptr;
+            return false;
+        }
+    }
+    if (!SdStorage::getInstance().mount()) {
+        mclog::tagError(TAG, "failed to mount SD card");
+        return false;
+    }
+
+    struct stat sb;
+    const char* dir = AudioRecorder::RECORDINGS_DIR;
+    if (stat(dir, &sb) != 0) mkdir(dir, 0755);
+    std::string base = name;
+    for (int n = 1; base.empty() && n < 10000; n++) {
+        char candidate[48];
+        snprintf(candidate, sizeof(candidate), "rec_%04d", n);
+        const std::string probe = std::string(dir) + "/" + candidate;
+        if (stat((probe + ".h264").c_str(), &sb) != 0 && stat((probe + "_out.wav").c_str(), &sb) != 0) base = candidate;
+    }
+    const std::string prefix = std::string(dir) + "/" + base;
+
+    if (!openEncoder()) return false;
+    _video = fopen((prefix + ".h264").c_str(), "wb");
+    _timestamps = fopen((prefix + "_ts.txt").c_str(), "w");
+    if (!_video || !_timestamps) {
+        mclog::tagError(TAG, "failed to create {}.h264", prefix);
+        if (_video) fclose(_video);
+        if (_timestamps) fclose(_timestamps);
+        _video = _timestamps = nullptr;
+        closeEncoder();
+        return false;
+    }
+    setvbuf(_video, nullptr, _IONBF, 0);  // Whole IO_CHUNKs from _staging
+    fputs("# timestamp format v2\n", _timestamps);
+    _stagingUsed = 0;
+    _fileBytes = 0;
+    _reserved = 0;
+    if (!SdStorage::reserve(_video, _reserved, SdStorage::IO_CHUNK)) _reserved = UINT32_MAX;
+
+    // Same base name, so the pair is obvious; the WAV clock is the timeline
+    if (!AudioRecorder::getInstance().start(AudioRecorder::SOURCE_OUTPUT, base)) {
+        mclog::tagWarn(TAG, "audio not recorded, video timestamps from the audio clock will stand still");
+    }
+
+    _freeBuffers = xQueueCreate(YUV_BUFFERS, sizeof(int));
+    _frames = xQueueCreate(YUV_BUFFERS, sizeof(Frame));
+    for (int i = 0; i < YUV_BUFFERS; i++) xQueueSend(_freeBuffers, &i, 0);
+    _firstAudioFrames = AudioRecorder::getInstance().outputFrames();
+    _framesWritten.store(0, std::memory_order_relaxed);
+    _droppedFrames.store(0, std::memory_order_relaxed);
+    _bytesWritten.store(0, std::memory_order_relaxed);
+    _writeErrors.store(0, std::memory_order_relaxed);
+    _stopRequested.store(false, std::memory_order_relaxed);
+    _encoderAlive.store(true, std::memory_order_release);
+    // Core 0 with the audio recorder's writer: encoder and SD waits never reach the audio core
+    if (xTaskCreatePinnedToCore(encoderTask, "video_rec", ENCODER_STACK, this, 3, &_encoderHandle, 0) != pdPASS) {
+        _encoderAlive.store(false, std::memory_order_release);
+        _encoderHandle = nullptr;
+        AudioRecorder::getInstance().stop();
+        fclose(_video);
+        fclose(_timestamps);
+        _video = _timestamps = nullptr;
+        closeEncoder();
+        vQueueDelete(_frames);
+        vQueueDelete(_freeBuffers);
+        mclog::tagError(TAG, "failed to create encoder task");
+        return false;
+    }
+    _recording.store(true, std::memory_order_release);
+    mclog::tagInfo(TAG, "recording to {}.h264", prefix);
+    return true;
+}
+
+void VideoRecorder::stop()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_encoderAlive.load(std::memory_order_acquire)) return;
+    _recording.store(false, std::memory_order_release);
+    _stopRequested.store(true, std::memory_order_release);
+    // The encoder finishes the frames queued (two at most), then closes the files
+    for (int i = 0; i < 300 && _encoderAlive.load(std::memory_order_acquire); i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    if (_encoderAlive.load(std::memory_order_acquire)) {
+        mclog::tagWarn(TAG, "encoder did not finish in time");
+    } else {
+        vQueueDelete(_frames);
+        vQueueDelete(_freeBuffers);
+        _frames = _freeBuffers = nullptr;
+    }
+    _encoderHandle = nullptr;
+    AudioRecorder::getInstance().stop();
+}
+
+VideoRecorderStats VideoRecorder::getStats()
+{
+    VideoRecorderStats s;
+    s.recording = isRecording();
+    s.frames = _framesWritten.load(std::memory_order_relaxed);
+    s.droppedFrames = _droppedFrames.load(std::memory_order_relaxed);
+    s.bytesWritten = _bytesWritten.load(std::memory_order_relaxed);
+    s.writeErrors = _writeErrors.load(std::memory_order_relaxed);
+    return s;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Camera present task side
+// ─────────────────────────────────────────────────────────────────────────────
+
+void VideoRecorder::pushFrame(const uint8_t* rgb565, uint32_t size)
+{
+    if (!isRecording()) return;
+    Frame frame;
+    if (xQueueReceive(_freeBuffers, &frame.buffer, 0) != pdPASS) {
+        _droppedFrames.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    frame.audioFrames = AudioRecorder::getInstance().outputFrames();
+
+    // Colour conversion on the PPA; a 720p pass takes a few ms and the frame is only ours until we return
+    ppa_srm_oper_config_t srm = {};
+    srm.in.buffer = rgb565;
+    srm.in.pic_w = WIDTH;
+    srm.in.pic_h = HEIGHT;
+    srm.in.block_w = WIDTH;
+    srm.in.block_h = HEIGHT;
+    srm.in.srm_cm = PPA_SRM_COLOR_MODE_RGB565;
+    srm.out.buffer = _yuv[frame.buffer];
+    srm.out.buffer_size = YUV_BYTES;
+    srm.out.pic_w = WIDTH;
+    srm.out.pic_h = HEIGHT;
+    srm.out.srm_cm = PPA_SRM_COLOR_MODE_YUV420;
+    srm.rotation_angle = PPA_SRM_ROTATION_ANGLE_0;
+    srm.scale_x = 1;
+    srm.scale_y = 1;
+    srm.mode = PPA_TRANS_MODE_BLOCKING;
+    if (size < WIDTH * HEIGHT * 2 || ppa_do_scale_rotate_mirror(_ppa, &srm) != ESP_OK) {
+        xQueueSend(_freeBuffers, &frame.buffer, 0);
+        _droppedFrames.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    xQueueSend(_frames, &frame, 0);  // Can't be full: one slot per buffer
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Encoder task
+// ─────────────────────────────────────────────────────────────────────────────
+
+void VideoRecorder::encoderTask(void* param)
+{
+    auto* self = static_cast<VideoRecorder*>(param);
+    self->encoderLoop();
+    self->_encoderAlive.store(false, std::memory_order_release);
+    vTaskDelete(nullptr);
+}
+
+bool VideoRecorder::flushStaging()
+{
+    if (_stagingUsed == 0) return true;
+    if (_reserved != UINT32_MAX && !SdStorage::reserve(_video, _reserved, _fileBytes + _stagingUsed)) {
+        _reserved = UINT32_MAX;  // Keep writing into whatever space is left
+    }
+    const bool ok = fwrite(_staging, 1, _stagingUsed, _video) == _stagingUsed;
+    if (ok) {
+        _fileBytes += _stagingUsed;
+        _bytesWritten.fetch_add(_stagingUsed, std::memory_order_relaxed);
+    } else {
+        _writeErrors.fetch_add(1, std::memory_order_relaxed);
+        mclog::tagError(TAG, "SD write failed after {} bytes", _fileBytes);
+    }
+    _stagingUsed = 0;
+    return ok;
+}
+
+bool VideoRecorder::append(const uint8_t* data, uint32_t bytes)
+{
+    while (bytes > 0) {
+        const uint32_t n = std::min(bytes, SdStorage::IO_CHUNK - _stagingUsed);
+        memcpy(_staging + _stagingUsed, data, n);
+        _stagingUsed += n;
+        data += n;
+        bytes -= n;
+        if (_stagingUsed == SdStorage::IO_CHUNK && !flushStaging()) return false;
+    }
+    return true;
+}
+
+bool VideoRecorder::encode(const Frame& frame)
+{
+    struct v4l2_buffer src = {};
+    src.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+    src.memory = V4L2_MEMORY_USERPTR;
+    src.m.userptr = reinterpret_cast<unsigned long>(_yuv[frame.buffer]);
+    src.length = YUV_BYTES;
+    if (ioctl(_fd, VIDIOC_QBUF, &src) != 0) return false;
+
+    struct v4l2_buffer dst = {};
+    dst.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    dst.memory = V4L2_MEMORY_MMAP;
+    const bool encoded = ioctl(_fd, VIDIOC_DQBUF, &dst) == 0;
+    ioctl(_fd, VIDIOC_DQBUF, &src);
+    if (!encoded) return false;
+
+    bool ok = true;
+    if (dst.bytesused > 0) {
+        ok = append(_nal, dst.bytesused);
+        const uint64_t ms = static_cast<uint64_t>(frame.audioFrames - _firstAudioFrames) * 1000 / AudioRecorder::SAMPLE_RATE;
+        fprintf(_timestamps, "%llu\n", static_cast<unsigned long long>(ms));
+        _framesWritten.fetch_add(1, std::memory_order_relaxed);
+    }
+    ioctl(_fd, VIDIOC_QBUF, &dst);
+    return ok;
+}
+
+void VideoRecorder::encoderLoop()
+{
+    bool failed = false;
+    Frame frame;
+    while (true) {
+        if (xQueueReceive(_frames, &frame, pdMS_TO_TICKS(50)) == pdPASS) {
+            // After a write error, keep returning buffers so the present task sees drops, not a stall
+            if (!failed && !encode(frame)) failed = true;
+            xQueueSend(_freeBuffers, &frame.buffer, 0);
+            continue;
+        }
+        if (_stopRequested.load(std::memory_order_acquire)) break;
+    }
+
+    if (!failed) flushStaging();
+    fflush(_video);
+    if (_reserved != 0 && ftruncate(fileno(_video), _fileBytes) != 0) mclog::tagWarn(TAG, "could not trim preallocation");
+    fclose(_video);
+    fclose(_timestamps);
+    _video = _timestamps = nullptr;
+    closeEncoder();
+    mclog::tagInfo(TAG, "recording stopped: {} frames, {} dropped, {} bytes",
+        _framesWritten.load(std::memory_order_relaxed), _droppedFrames.load(std::memory_order_relaxed), _fileBytes);
+}
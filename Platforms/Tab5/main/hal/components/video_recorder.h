@@ -0,0 +1,117 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include <driver/ppa.h>
+
+struct VideoRecorderStats {
+    bool recording = false;
+    uint32_t frames = 0;         // Encoded and written
+    uint32_t droppedFrames = 0;  // Preview frames that found both YUV buffers busy
+    uint32_t bytesWritten = 0;   // H.264 stream
+    uint32_t writeErrors = 0;
+};
+
+/**
+ * @brief Camera + processed-audio session recording, hardware encoded
+ *
+ * Video: each preview frame the camera present task puts on screen is
+ * converted RGB565 -> YUV420 by the PPA into one of YUV_BUFFERS buffers and
+ * handed to a Core 0 encoder task, which runs it through the esp_video H.264
+ * M2M device (the P4 hardware encoder) and appends the Annex-B stream to
+ * /sd/Recordings/<name>.h264 in SdStorage::IO_CHUNK writes from internal RAM,
+ * in preallocated extents like the audio recorder. A frame that finds both
+ * buffers busy is dropped, never waited for.
+ *
+ * Audio: AudioRecorder writes the processed output to <name>_out.wav as usual.
+ * Sync: every encoded frame gets the WAV position (output frames the audio task
+ * had queued when the frame went on screen) as its timestamp, in milliseconds,
+ * in <name>_ts.txt (mkvmerge "timestamp format v2"). Both streams therefore sit
+ * on the I2S sample clock, and a mux needs no guessing:
+ *   mkvmerge -o <name>.mkv --timestamps 0:<name>_ts.txt <name>.h264 <name>_out.wav
+ *
+ * Nothing runs on the audio core; the audio path only gains the clock read.
+ */
+class VideoRecorder {
+public:
+    static constexpr uint32_t WIDTH = 1280;
+    static constexpr uint32_t HEIGHT = 720;
+    static constexpr int FPS = 30;             // Also the GOP: one IDR per second
+    static constexpr int BITRATE = 4000000;
+    static constexpr int YUV_BUFFERS = 2;
+
+    static VideoRecorder& getInstance();
+
+    // Camera capture must be running; name "" picks the next free rec_NNNN
+    bool start(const std::string& name = "");
+    void stop();
+    bool isRecording() const
+    {
+        return _recording.load(std::memory_order_relaxed);
+    }
+    VideoRecorderStats getStats();
+
+    // ── Camera present task ──
+    bool wanted() const
+    {
+        return isRecording();
+    }
+    // An RGB565 WIDTH x HEIGHT frame, valid for the duration of the call
+    void pushFrame(const uint8_t* rgb565, uint32_t size);
+
+private:
+    VideoRecorder() = default;
+    VideoRecorder(const VideoRecorder&) = delete;
+    VideoRecorder& operator=(const VideoRecorder&) = delete;
+
+    static constexpr uint32_t YUV_BYTES = WIDTH * HEIGHT * 3 / 2;
+
+    struct Frame {
+        int buffer;
+        uint32_t audioFrames;  // WAV position when shown
+    };
+
+    bool openEncoder();
+    void closeEncoder();
+    static void encoderTask(void* param);
+    void encoderLoop();
+    bool encode(const Frame& frame);
+    bool append(const uint8_t* data, uint32_t bytes);
+    bool flushStaging();
+
+    std::mutex _mutex;  // start/stop
+    std::atomic<bool> _recording{false};
+    std::atomic<bool> _stopRequested{false};
+    std::atomic<bool> _encoderAlive{false};
+    TaskHandle_t _encoderHandle = nullptr;
+
+    ppa_client_handle_t _ppa = nullptr;
+    uint8_t* _yuv[YUV_BUFFERS] = {};
+    QueueHandle_t _freeBuffers = nullptr;  // int
+    QueueHandle_t _frames = nullptr;       // Frame
+    int _fd = -1;                          // H.264 device
+    uint8_t* _nal = nullptr;               // Encoder CAPTURE buffer (mmapped)
+
+    FILE* _video = nullptr;
+    FILE* _timestamps = nullptr;
+    uint8_t* _staging = nullptr;  // IO_CHUNK, internal RAM
+    uint32_t _stagingUsed = 0;
+    uint32_t _fileBytes = 0;
+    uint32_t _reserved = 0;
+    uint32_t _firstAudioFrames = 0;
+
+    std::atomic<uint32_t> _framesWritten{0};
+    std::atomic<uint32_t> _droppedFrames{0};
+    std::atomic<uint32_t> _bytesWritten{0};
+    std::atomic<uint32_t> _writeErrors{0};
+};
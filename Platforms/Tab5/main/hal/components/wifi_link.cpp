@@ -0,0 +1,264 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "wifi_link.h"
+#include "nvs_storage.h"
+#include "../utils/core_policy/core_policy.h"
+#include <mooncake_log.h>
+#include <algorithm>
+#include <cstring>
+#include <esp_netif.h>
+#include <esp_wifi.h>
+#include <nvs.h>
+
+static const char* TAG = "WifiLink";
+
+static constexpr int LINK_STACK = 3072;
+static constexpr UBaseType_t LINK_PRIORITY = 4;
+static constexpr uint32_t POLL_MS = 1000;
+static constexpr uint32_t LINGER_MS = CONFIG_HOWIZARD_WIFI_STA_LINGER_S * 1000u;
+
+static uint32_t nowMs()
+{
+    return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+WifiLink& WifiLink::getInstance()
+{
+    static WifiLink instance;
+    return instance;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Setup
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool WifiLink::initStack()
+{
+    static std::mutex initMutex;
+    static bool initialized = false;
+    std::lock_guard<std::mutex> lock(initMutex);
+    if (initialized) return true;
+
+    // The driver keeps its settings in NVS; HalEsp32::init() already brought it up, this returns that result
+    esp_err_t ret = NvsStorage::getInstance().init() ? ESP_OK : ESP_ERR_NVS_NOT_INITIALIZED;
+    if (ret == ESP_OK) ret = esp_netif_init();
+    if (ret == ESP_OK) {
+        ret = esp_event_loop_create_default();
+        if (ret == ESP_ERR_INVALID_STATE) ret = ESP_OK;  // Someone else made it
+    }
+    if (ret == ESP_OK) {
+        wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+        ret = esp_wifi_init(&cfg);
+    }
+    if (ret != ESP_OK) {
+        mclog::tagError(TAG, "wifi stack init failed: {}", esp_err_to_name(ret));
+        return false;
+    }
+    initialized = true;
+    return true;
+}
+
+bool WifiLink::begin(void (*onConnected)())
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_running.load(std::memory_order_acquire)) return true;
+    if (std::strlen(CONFIG_HOWIZARD_WIFI_STA_SSID) == 0) {
+        mclog::tagWarn(TAG, "no station SSID configured, link disabled");
+        return false;
+    }
+    if (!initStack()) return false;
+
+    esp_netif_create_default_wifi_sta();
+    esp_event_handler_instance_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, eventHandler, this, nullptr);
+    esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, eventHandler, this, nullptr);
+
+    _onConnected = onConnected;
+    _running.store(true, std::memory_order_release);
+    if (xTaskCreatePinnedToCore(linkTask, "wifi_link", LINK_STACK, this, LINK_PRIORITY, &_task,
+                                core_policy::SYSTEM_AFFINITY) != pdPASS) {
+        _running.store(false, std::memory_order_relaxed);
+        _task = nullptr;
+        mclog::tagError(TAG, "failed to create link task");
+        return false;
+    }
+    mclog::tagInfo(TAG, "station link to '{}', linger {} s", CONFIG_HOWIZARD_WIFI_STA_SSID,
+                   CONFIG_HOWIZARD_WIFI_STA_LINGER_S);
+    return true;
+}
+
+void WifiLink::want(Client client, bool wanted)
+{
+    const uint8_t prev = wanted ? _demand.fetch_or(client, std::memory_order_acq_rel)
+                                : _demand.fetch_and(static_cast<uint8_t>(~client), std::memory_order_acq_rel);
+    if (((prev & client) != 0) == wanted) return;
+    _events.fetch_or(EVENT_DEMAND, std::memory_order_release);
+    if (_task) xTaskNotifyGive(_task);
+}
+
+void WifiLink::setAccessPointActive(bool active)
+{
+    _apActive.store(active, std::memory_order_release);
+}
+
+WifiLinkStats WifiLink::getStats()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    WifiLinkStats s = _stats;
+    s.radioOn = isRadioOn();
+    s.connected = isConnected();
+    return s;
+}
+
+void WifiLink::eventHandler(void* arg, esp_event_base_t base, int32_t id, void* data)
+{
+    auto* self = static_cast<WifiLink*>(arg);
+    const uint32_t event = base == IP_EVENT ? EVENT_GOT_IP : EVENT_DISCONNECTED;
+    self->_events.fetch_or(event, std::memory_order_release);
+    xTaskNotifyGive(self->_task);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Link task
+// ─────────────────────────────────────────────────────────────────────────────
+
+void WifiLink::linkTask(void* param)
+{
+    static_cast<WifiLink*>(param)->linkLoop();
+    vTaskDelete(nullptr);
+}
+
+void WifiLink::linkLoop()
+{
+    uint32_t radioSince = 0;    // Radio start
+    uint32_t attemptSince = 0;  // Radio start, or loss of the last association
+    uint32_t lingerSince = 0;
+    uint32_t restUntil = 0;
+    uint32_t retryAt = 0;
+    uint32_t retryMs = RETRY_MIN_MS;
+    bool lingering = false, retryPending = false, resting = false, starting = false;
+
+    while (_running.load(std::memory_order_acquire)) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(POLL_MS));
+        const uint32_t events = _events.exchange(0, std::memory_order_acq_rel);
+        const uint32_t now = nowMs();
+        const uint8_t demand = _demand.load(std::memory_order_acquire);
+        const bool startWanted = (demand & ~CLIENT_REMOTE_SESSION) != 0;
+        if (startWanted && !starting) resting = false;  // A fresh request doesn't wait out an old rest
+        starting = startWanted;
+
+        if (!isRadioOn()) {
+            if (!startWanted || (resting && static_cast<int32_t>(now - restUntil) < 0)) continue;
+            resting = false;
+            if (!startRadio()) {
+                resting = true;
+                restUntil = now + REST_MS;
+                continue;
+            }
+            radioSince = attemptSince = now;
+            retryMs = RETRY_MIN_MS;
+            retryPending = lingering = false;
+            continue;
+        }
+
+        if (events & EVENT_GOT_IP) {
+            wifi_ap_record_t ap = {};
+            const bool haveAp = esp_wifi_sta_get_ap_info(&ap) == ESP_OK;
+            _connected.store(true, std::memory_order_release);
+            retryMs = RETRY_MIN_MS;
+            retryPending = false;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stats.associations++;
+                if (haveAp) _stats.rssi = ap.rssi;
+            }
+            mclog::tagInfo(TAG, "associated, rssi {} dBm", haveAp ? ap.rssi : 0);
+            if (_onConnected) _onConnected();
+        }
+        if (events & EVENT_DISCONNECTED) {
+            if (_connected.exchange(false, std::memory_order_acq_rel)) attemptSince = now;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stats.disconnects++;
+            }
+            retryPending = true;
+            retryAt = now + retryMs;
+            retryMs = std::min(retryMs * 2, RETRY_MAX_MS);
+        }
+
+        if (demand == 0) {
+            if (!lingering) {
+                lingering = true;
+                lingerSince = now;
+            }
+            if (now - lingerSince >= LINGER_MS) {
+                stopRadio();
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stats.radioOnMs += now - radioSince;
+            }
+            continue;
+        }
+        lingering = false;
+
+        if (isConnected()) continue;
+        if (now - attemptSince >= CONNECT_TIMEOUT_MS) {
+            // Out of range or wrong credentials: rest the radio instead of scanning on
+            mclog::tagWarn(TAG, "no association in {} s, radio off for {} s", CONNECT_TIMEOUT_MS / 1000,
+                           REST_MS / 1000);
+            stopRadio();
+            resting = true;
+            restUntil = now + REST_MS;
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stats.radioOnMs += now - radioSince;
+            _stats.backoffs++;
+            continue;
+        }
+        if (retryPending && static_cast<int32_t>(now - retryAt) >= 0) {
+            retryPending = false;
+            esp_wifi_connect();
+        }
+    }
+}
+
+bool WifiLink::startRadio()
+{
+    wifi_config_t config = {};
+    std::strncpy(reinterpret_cast<char*>(config.sta.ssid), CONFIG_HOWIZARD_WIFI_STA_SSID, sizeof(config.sta.ssid));
+    std::strncpy(reinterpret_cast<char*>(config.sta.password), CONFIG_HOWIZARD_WIFI_STA_PASSWORD,
+                 sizeof(config.sta.password));
+    config.sta.threshold.authmode =
+        std::strlen(CONFIG_HOWIZARD_WIFI_STA_PASSWORD) > 0 ? WIFI_AUTH_WPA2_PSK : WIFI_AUTH_OPEN;
+    config.sta.pmf_cfg.capable = true;
+    // Beacons slept through between wakes; the AP buffers our frames meanwhile
+    config.sta.listen_interval = CONFIG_HOWIZARD_WIFI_STA_LISTEN_INTERVAL;
+
+    const bool ap = _apActive.load(std::memory_order_acquire);
+    esp_err_t ret = esp_wifi_set_mode(ap ? WIFI_MODE_APSTA : WIFI_MODE_STA);
+    if (ret == ESP_OK) ret = esp_wifi_set_config(WIFI_IF_STA, &config);
+    if (ret == ESP_OK && !ap) ret = esp_wifi_start();
+    if (ret != ESP_OK) {
+        mclog::tagError(TAG, "radio start failed: {}", esp_err_to_name(ret));
+        return false;
+    }
+    // Modem sleep needs the station alone; with the softAP up the driver keeps the radio awake regardless
+    if (!ap && esp_wifi_set_ps(WIFI_PS_MAX_MODEM) != ESP_OK) mclog::tagWarn(TAG, "max modem sleep refused");
+    _radioOn.store(true, std::memory_order_release);
+    esp_wifi_connect();
+    mclog::tagInfo(TAG, "radio on, joining '{}'", CONFIG_HOWIZARD_WIFI_STA_SSID);
+    return true;
+}
+
+void WifiLink::stopRadio()
+{
+    _radioOn.store(false, std::memory_order_release);
+    _connected.store(false, std::memory_order_release);
+    esp_wifi_disconnect();
+    if (_apActive.load(std::memory_order_acquire)) {
+        esp_wifi_set_mode(WIFI_MODE_AP);
+    } else {
+        esp_wifi_stop();
+    }
+    mclog::tagInfo(TAG, "radio off");
+}
@@ -0,0 +1,105 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_event.h>
+
+struct WifiLinkStats {
+    bool radioOn = false;
+    bool connected = false;
+    int8_t rssi = 0;              // dBm at the last association
+    uint32_t associations = 0;    // Got-IP events
+    uint32_t disconnects = 0;     // Link losses while associated or associating
+    uint32_t radioOnMs = 0;       // Total time the radio has been started
+    uint32_t backoffs = 0;        // Times association was given up on and the radio rested
+};
+
+/**
+ * @brief Station-mode Wi-Fi that is only up while something needs it
+ *
+ * Joins the Kconfig network (HOWIZARD_WIFI_STA_SSID) with WIFI_PS_MAX_MODEM and a
+ * listen interval of HOWIZARD_WIFI_STA_LISTEN_INTERVAL beacons, so between
+ * packets the radio sleeps through most beacons. Clients set demand bits with
+ * want(); the radio starts on the first and is stopped (esp_wifi_stop, no
+ * association kept) HOWIZARD_WIFI_STA_LINGER_S after the last goes, so a quick
+ * off/on doesn't cost a reassociation.
+ *
+ * CLIENT_REMOTE_SESSION is set by RemoteTuning while a WebSocket client is
+ * attached: it keeps a running link up but never starts the radio, so a
+ * session over the softAP doesn't bring up the station side.
+ *
+ * While wanted but unassociated the link retries with a doubling backoff; after
+ * CONNECT_TIMEOUT_MS without an IP it stops the radio for REST_MS before the
+ * next try, so an out-of-range network doesn't keep the radio scanning.
+ * Everything runs on the Core 0 "wifi_link" task; want() only sets bits and
+ * notifies it.
+ */
+class WifiLink {
+public:
+    enum Client : uint8_t {
+        CLIENT_REMOTE_TUNING = 1 << 0,   // The user enabled remote tuning
+        CLIENT_REMOTE_SESSION = 1 << 1,  // A tuning client is attached (keeps, never starts)
+        CLIENT_FIRMWARE_UPDATE = 1 << 2, // An OTA download from a URL
+        CLIENT_STRESS_TEST = 1 << 3,     // StressTest's Wi-Fi load
+    };
+
+    static constexpr uint32_t CONNECT_TIMEOUT_MS = 60000;
+    static constexpr uint32_t REST_MS = 5 * 60000;
+    static constexpr uint32_t RETRY_MIN_MS = 1000;
+    static constexpr uint32_t RETRY_MAX_MS = 16000;
+
+    static WifiLink& getInstance();
+
+    // netif, default event loop and esp_wifi_init, once; shared with the softAP path
+    static bool initStack();
+
+    // Creates the task; onConnected runs on it after every got-IP
+    bool begin(void (*onConnected)());
+    void want(Client client, bool wanted);
+    bool isConnected() const
+    {
+        return _connected.load(std::memory_order_relaxed);
+    }
+    bool isRadioOn() const
+    {
+        return _radioOn.load(std::memory_order_relaxed);
+    }
+    // The softAP is up: the radio runs APSTA and stopping the link only drops STA
+    void setAccessPointActive(bool active);
+    WifiLinkStats getStats();
+
+private:
+    WifiLink() = default;
+    WifiLink(const WifiLink&) = delete;
+    WifiLink& operator=(const WifiLink&) = delete;
+
+    enum Event : uint32_t {
+        EVENT_DEMAND = 1 << 0,
+        EVENT_GOT_IP = 1 << 1,
+        EVENT_DISCONNECTED = 1 << 2,
+    };
+
+    static void eventHandler(void* arg, esp_event_base_t base, int32_t id, void* data);
+    static void linkTask(void* param);
+    void linkLoop();
+    bool startRadio();
+    void stopRadio();
+
+    std::mutex _mutex;  // begin, _stats
+    std::atomic<bool> _running{false};
+    TaskHandle_t _task = nullptr;
+    void (*_onConnected)() = nullptr;
+    std::atomic<uint8_t> _demand{0};
+    std::atomic<uint32_t> _events{0};
+    std::atomic<bool> _connected{false};
+    std::atomic<bool> _apActive{false};
+    std::atomic<bool> _radioOn{false};
+    WifiLinkStats _stats;
+};
@@ -4,20 +4,64 @@
  * SPDX-License-Identifier: MIT
  */
 #include "hal/hal_esp32.h"
+#include "utils/core_policy/core_policy.h"
+#include "components/power_telemetry.h"
+#include "components/session_schedule.h"
+#include "components/nvs_storage.h"
+#include "components/keypad_controls.h"
+#include "components/thermal_policy.h"
+#include "components/firmware_update.h"
 extern "C" {
 #include "utils/rx8130/rx8130.h"
 }
 #include <mooncake_log.h>
+#include <algorithm>
+#include <atomic>
 #include <esp_timer.h>
+#include <esp_cpu.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <freertos/event_groups.h>
 #include <bsp/m5stack_tab5.h>
 #include <lv_demos.h>
+#include <sdkconfig.h>
 
 extern esp_lcd_touch_handle_t _lcd_touch_handle;
 
 static const std::string _tag = "hal";
 
+// Cache traffic of the LVGL task's core per refresh, start to ready; the PPA and the
+// LCD DMA bypass the caches and only show up as the CPU's misses getting slower
+static bsp_cache_counts_t _frame_cache_mark = {};
+static int _frame_cache_core = -1;
+static std::atomic<uint32_t> _frame_cache_frames{0};
+static std::atomic<uint32_t> _frame_cache_l1_miss{0};
+static std::atomic<uint32_t> _frame_cache_l2_miss{0};
+static std::atomic<uint32_t> _frame_cache_l2_max{0};
+
+static void lvgl_frame_cache_cb(lv_event_t* e)
+{
+    const int core = esp_cpu_get_core_id();
+    if (lv_event_get_code(e) == LV_EVENT_REFR_START) {
+        _frame_cache_core = core;
+        bsp_cache_counters_read(core, &_frame_cache_mark);
+        return;
+    }
+    if (_frame_cache_core != core) {
+        return;  // Not started, or the task moved mid-frame
+    }
+    bsp_cache_counts_t now;
+    bsp_cache_counters_read(core, &now);
+    const uint32_t l2Miss = now.l2_miss - _frame_cache_mark.l2_miss;
+    _frame_cache_frames.fetch_add(1, std::memory_order_relaxed);
+    _frame_cache_l1_miss.fetch_add(now.l1_miss - _frame_cache_mark.l1_miss, std::memory_order_relaxed);
+    _frame_cache_l2_miss.fetch_add(l2Miss, std::memory_order_relaxed);
+    if (l2Miss > _frame_cache_l2_max.load(std::memory_order_relaxed)) {
+        _frame_cache_l2_max.store(l2Miss, std::memory_order_relaxed);
+    }
+    _frame_cache_core = -1;
+}
+
 static void lvgl_read_cb(lv_indev_t* indev, lv_indev_data_t* data)
 {
     if (_lcd_touch_handle == NULL) {
@@ -30,7 +74,9 @@ static void lvgl_read_cb(lv_indev_t* indev, lv_indev_data_t* data)
     uint16_t touch_strength[1];
     uint8_t touch_cnt = 0;
 
+    bsp_i2c_acquire(BSP_I2C_CLASS_TOUCH, BSP_I2C_WAIT_FOREVER);
     esp_lcd_touch_read_data(_lcd_touch_handle);
+    bsp_i2c_release(BSP_I2C_CLASS_TOUCH);
     bool touchpad_pressed =
         esp_lcd_touch_get_coordinates(_lcd_touch_handle, touch_x, touch_y, touch_strength, &touch_cnt, 1);
     // mclog::tagInfo(_tag, "touchpad pressed: {}", touchpad_pressed);
@@ -44,10 +90,26 @@ static void lvgl_read_cb(lv_indev_t* indev, lv_indev_data_t* data)
     }
 }
 
+// Display, USB host, HID, RS485 and the keypad come up on this Core 0 task, beside the
+// app starting audio; no higher than the main task, so it doesn't hold the engine start up
+static constexpr uint32_t BRINGUP_STACK = 8192;
+static constexpr UBaseType_t BRINGUP_PRIORITY = 1;
+static constexpr EventBits_t DISPLAY_READY_BIT = BIT0;
+
+static EventGroupHandle_t bringup_events()
+{
+    static EventGroupHandle_t events = xEventGroupCreate();
+    return events;
+}
+
 void HalEsp32::init()
 {
     mclog::tagInfo(_tag, "init");
 
+    // Before anything opens the "howizard" namespace, starting with the session booking claimed below
+    mclog::tagInfo(_tag, "nvs init");
+    NvsStorage::getInstance().init();
+
     mclog::tagInfo(_tag, "camera init");
     bsp_cam_osc_init();
 
@@ -63,12 +125,26 @@ void HalEsp32::init()
     setChargeEnable(true);
     // setChargeEnable(false);
 
+    // The alarm flag is read before clearRtcIrq(): a session alarm wake-up boots with the display dark
+    mclog::tagInfo(_tag, "rx8130 init");
+    rx8130.begin(i2c_bus_handle, 0x32);
+    rx8130.initBat();
+    bsp_i2c_acquire(BSP_I2C_CLASS_TELEMETRY, BSP_I2C_WAIT_FOREVER);
+    const bool rtc_alarm = rx8130.isAlarmFired();
+    bsp_i2c_release(BSP_I2C_CLASS_TELEMETRY);
+    SessionSchedule::getInstance().claim(rtc_alarm);
+    clearRtcIrq();
+    update_system_time();
+
+#if CONFIG_HOWIZARD_BOOT_I2C_SCAN
     mclog::tagInfo(_tag, "i2c scan");
     bsp_i2c_scan();
+#endif
 
     mclog::tagInfo(_tag, "codec init");
     delay(200);
     bsp_codec_init();
+    sfx_cache_init();
 
     mclog::tagInfo(_tag, "imu init");
     imu_init();
@@ -79,17 +155,35 @@ void HalEsp32::init()
                      INA226_MODE_SHUNT_BUS_CONT);
     ina226.calibrate(0.005, 8.192);
     mclog::tagInfo(_tag, "bus voltage: {}", ina226.readBusVoltage());
+    PowerTelemetry::getInstance().start(&ina226, CONFIG_HOWIZARD_INA226_ALERT_GPIO);
+
+    pm_init();
+    thermal_init();
+
+    // The audio path needs nothing below: the app starts the engine while Core 0 brings up the
+    // display and USB, and its first lvglLock() is where it waits for them
+    mclog::tagInfo(_tag, "audio path up at {} ms", millis());
+    if (xTaskCreatePinnedToCore(peripheral_bringup_task, "hal_bringup", BRINGUP_STACK, this, BRINGUP_PRIORITY,
+                                nullptr, core_policy::SYSTEM_AFFINITY) != pdPASS) {
+        mclog::tagError(_tag, "bring-up task failed, bringing up inline");
+        peripheral_bringup();
+    }
+}
 
-    mclog::tagInfo(_tag, "rx8130 init");
-    rx8130.begin(i2c_bus_handle, 0x32);
-    rx8130.initBat();
-    clearRtcIrq();
-    update_system_time();
+void HalEsp32::peripheral_bringup_task(void* param)
+{
+    static_cast<HalEsp32*>(param)->peripheral_bringup();
+    vTaskDelete(nullptr);
+}
 
+void HalEsp32::peripheral_bringup()
+{
     mclog::tagInfo(_tag, "display init");
     bsp_reset_tp();
+    // The PPA rotates each dirty area straight into the panel frame buffer, so LVGL only needs
+    // strip-sized partial buffers: double buffered, it renders the next strip while the PPA moves this one
     bsp_display_cfg_t cfg = {.lvgl_port_cfg = ESP_LVGL_PORT_INIT_CONFIG(),
-                             .buffer_size   = BSP_LCD_H_RES * BSP_LCD_V_RES,
+                             .buffer_size   = BSP_LCD_H_RES * BSP_LCD_V_RES / 10,
                              .double_buffer = true,
                              .flags         = {
 #if CONFIG_BSP_LCD_COLOR_FORMAT_RGB888
@@ -99,10 +193,38 @@ void HalEsp32::init()
 #endif
                                  .buff_spiram = true,
                                  .sw_rotate   = true,
+                                 .ppa_direct  = true,
                              }};
+    // LVGL render and PPA rotation go through PSRAM: keep them off the DSP core
+    cfg.lvgl_port_cfg.task_affinity = core_policy::SYSTEM_CORE;
+    // The second SW draw thread: parked while the audio engine runs (AudioEngine::start())
+    cfg.lvgl_port_cfg.draw_assist_affinity = core_policy::DSP_CORE;
+    // LVGL reads esp_timer instead of taking a 200 Hz tick interrupt
+    cfg.lvgl_port_cfg.timer_period_ms = 0;
+    // LVGL heap: widgets, styles and text in internal RAM, layers, images and caches in PSRAM
+    cfg.lvgl_port_cfg.mem_internal_size = 64 * 1024;
+    cfg.lvgl_port_cfg.mem_psram_size    = 512 * 1024;
+    cfg.lvgl_port_cfg.mem_large_size    = 1024;
     lvDisp = bsp_display_start_with_config(&cfg);
     lv_display_set_rotation(lvDisp, LV_DISPLAY_ROTATION_90);
-    bsp_display_backlight_on();
+    // 60 Hz while touched, the meters' 30 Hz after; the touch task wakes LVGL itself, so idle polling is slow
+    lvgl_port_refresh_cfg_t refresh = {};
+    refresh.active_period_ms    = 16;
+    refresh.idle_period_ms      = 33;
+    refresh.active_hold_ms      = 500;
+    refresh.indev               = bsp_display_get_input_dev();
+    refresh.idle_read_period_ms = 100;
+    lvgl_port_disp_set_refresh(lvDisp, &refresh);
+    if (bsp_cache_counters_start() == ESP_OK) {
+        lv_display_add_event_cb(lvDisp, lvgl_frame_cache_cb, LV_EVENT_REFR_START, nullptr);
+        lv_display_add_event_cb(lvDisp, lvgl_frame_cache_cb, LV_EVENT_REFR_READY, nullptr);
+    }
+    if (isSessionWakeup()) {
+        // Dark until the app enters audio-only mode; a touch later lights the built UI
+        bsp_display_backlight_off();
+    } else {
+        bsp_display_backlight_on();
+    }
 
     // // Touchpad lvgl indev
     // mclog::tagInfo(_tag, "create lvgl touchpad indev");
@@ -115,15 +237,23 @@ void HalEsp32::init()
     bsp_usb_host_start(BSP_USB_HOST_POWER_MODE_USB_DEV, true);
 
     mclog::tagInfo(_tag, "hid init");
-    hid_init();
+    hid_init();  // Creates its cursor and indev under the display start's lock
+
+    bsp_display_unlock();
+    _display_ready.store(true, std::memory_order_release);
+    xEventGroupSetBits(bringup_events(), DISPLAY_READY_BIT);
+    mclog::tagInfo(_tag, "display up at {} ms", millis());
 
     mclog::tagInfo(_tag, "rs485 init");
     rs485_init();
 
+    mclog::tagInfo(_tag, "keypad init");
+    KeypadControls::getInstance().start(CONFIG_HOWIZARD_KEYPAD_INT_GPIO);
+
     mclog::tagInfo(_tag, "set gpio output capability");
     set_gpio_output_capability();
 
-    bsp_display_unlock();
+    FirmwareUpdate::getInstance().checkBoot();
 }
 
 static const gpio_num_t _driver_gpios[] = {
@@ -189,7 +319,46 @@ uint32_t HalEsp32::millis()
     return esp_timer_get_time() / 1000;
 }
 
-int HalEsp32::getCpuTemp()
+static constexpr EventBits_t MAIN_LOOP_WAKE_BIT = BIT0;
+
+static EventGroupHandle_t main_loop_events()
+{
+    static EventGroupHandle_t events = xEventGroupCreate();
+    return events;
+}
+
+// Audio-only mode: how often the held main loop looks for a knock in the IMU stream
+static constexpr uint32_t AUDIO_ONLY_POLL_MS = 100;
+
+void HalEsp32::waitMainLoopWake(uint32_t timeoutMs)
+{
+    if (!_audio_only.load(std::memory_order_acquire)) {
+        xEventGroupWaitBits(main_loop_events(), MAIN_LOOP_WAKE_BIT, pdTRUE, pdFALSE, pdMS_TO_TICKS(timeoutMs));
+        return;
+    }
+    // App updates are held here: apps asking for a pass do not end it, only a wake request does
+    while (_audio_only.load(std::memory_order_acquire)) {
+        if (_audio_only_wake.exchange(false, std::memory_order_acq_rel) || imu_tap_detected(_audio_only_imu_seq)) {
+            setAudioOnlyMode(false);
+            break;
+        }
+        xEventGroupWaitBits(main_loop_events(), MAIN_LOOP_WAKE_BIT, pdTRUE, pdFALSE,
+                            pdMS_TO_TICKS(AUDIO_ONLY_POLL_MS));
+    }
+}
+
+void HalEsp32::wakeMainLoop()
+{
+    xEventGroupSetBits(main_loop_events(), MAIN_LOOP_WAKE_BIT);
+}
+
+void HalEsp32::requestAudioOnlyWake()
+{
+    if (_audio_only_wake.exchange(true, std::memory_order_acq_rel)) return;
+    xEventGroupSetBits(main_loop_events(), MAIN_LOOP_WAKE_BIT);
+}
+
+static void temp_sensor_init()
 {
     if (_temp_sensor == nullptr) {
         temperature_sensor_config_t temp_sensor_config = {
@@ -199,7 +368,25 @@ int HalEsp32::getCpuTemp()
         temperature_sensor_install(&temp_sensor_config, &_temp_sensor);
         temperature_sensor_enable(_temp_sensor);
     }
+}
 
+void HalEsp32::thermal_init()
+{
+#if CONFIG_HOWIZARD_THERMAL_POLICY
+    temp_sensor_init();
+    ThermalPolicy::getInstance().start(_temp_sensor);
+#endif
+}
+
+int HalEsp32::getCpuTemp()
+{
+    auto& thermal = ThermalPolicy::getInstance();
+    if (thermal.isRunning()) {
+        // Sampled by the policy task; the sensor has one reader
+        return thermal.getStats().tempC;
+    }
+
+    temp_sensor_init();
     float temp = 0;
     temperature_sensor_get_celsius(_temp_sensor, &temp);
 
@@ -221,8 +408,70 @@ uint8_t HalEsp32::getDisplayBrightness()
     return _current_lcd_brightness;
 }
 
+static void fill_frame_hist(hal::HalBase::FrameHist_t& out, const lvgl_port_perf_hist_t& in)
+{
+    static_assert(hal::HalBase::FRAME_BUCKETS == LVGL_PORT_PERF_BUCKETS, "bucket layout must match the port");
+    out.count = in.count;
+    out.avgMs = in.count ? in.total_us / 1000.0f / in.count : 0.0f;
+    out.maxMs = in.max_us / 1000.0f;
+    std::copy(in.hist, in.hist + LVGL_PORT_PERF_BUCKETS, out.buckets);
+}
+
+static uint32_t _prev_frame_count = 0;
+static int64_t _prev_frame_time_us = 0;
+
+void HalEsp32::updateDisplayStats()
+{
+    lvgl_port_perf_stats_t perf;
+    lvgl_port_get_perf_stats(&perf);
+
+    fill_frame_hist(displayStats.frame, perf.frame);
+    fill_frame_hist(displayStats.render, perf.render);
+    fill_frame_hist(displayStats.rotate, perf.rotate);
+    fill_frame_hist(displayStats.flush, perf.flush);
+    fill_frame_hist(displayStats.ppaDraw, perf.ppa_draw);
+    std::copy(perf.dirty_hist, perf.dirty_hist + LVGL_PORT_PERF_BUCKETS, displayStats.dirtyBuckets);
+    if (perf.screen_px > 0 && perf.frame.count > 0) {
+        displayStats.dirtyAvgPct = 100.0f * perf.dirty_px_total / perf.frame.count / perf.screen_px;
+        displayStats.dirtyMaxPct = 100.0f * perf.dirty_px_max / perf.screen_px;
+    } else {
+        displayStats.dirtyAvgPct = 0.0f;
+        displayStats.dirtyMaxPct = 0.0f;
+    }
+
+    const uint32_t cacheFrames = _frame_cache_frames.load(std::memory_order_relaxed);
+    if (cacheFrames > 0) {
+        displayStats.cacheL1MissAvg = static_cast<float>(_frame_cache_l1_miss.load(std::memory_order_relaxed)) / cacheFrames;
+        displayStats.cacheL2MissAvg = static_cast<float>(_frame_cache_l2_miss.load(std::memory_order_relaxed)) / cacheFrames;
+        displayStats.cacheL2MissMax = _frame_cache_l2_max.load(std::memory_order_relaxed);
+    }
+
+    const int64_t now = esp_timer_get_time();
+    if (_prev_frame_time_us != 0 && now > _prev_frame_time_us && perf.frame.count >= _prev_frame_count) {
+        displayStats.fps = (perf.frame.count - _prev_frame_count) * 1e6f / (now - _prev_frame_time_us);
+    }
+    _prev_frame_count   = perf.frame.count;
+    _prev_frame_time_us = now;
+}
+
+void HalEsp32::resetDisplayStats()
+{
+    lvgl_port_reset_perf_stats();
+    displayStats        = DisplayStats_t();
+    _frame_cache_frames.store(0, std::memory_order_relaxed);
+    _frame_cache_l1_miss.store(0, std::memory_order_relaxed);
+    _frame_cache_l2_miss.store(0, std::memory_order_relaxed);
+    _frame_cache_l2_max.store(0, std::memory_order_relaxed);
+    _prev_frame_count   = 0;
+    _prev_frame_time_us = esp_timer_get_time();
+}
+
 void HalEsp32::lvglLock()
 {
+    // LVGL doesn't exist until the bring-up task has started the display
+    if (!_display_ready.load(std::memory_order_acquire)) {
+        xEventGroupWaitBits(bringup_events(), DISPLAY_READY_BIT, pdFALSE, pdFALSE, portMAX_DELAY);
+    }
     lvgl_port_lock(0);
 }
 
@@ -237,15 +486,19 @@ void HalEsp32::lvglUnlock()
 void HalEsp32::clearRtcIrq()
 {
     mclog::tagInfo(_tag, "clear rtc irq");
+    bsp_i2c_acquire(BSP_I2C_CLASS_TELEMETRY, BSP_I2C_WAIT_FOREVER);
     rx8130.clearIrqFlags();
     rx8130.disableIrq();
+    bsp_i2c_release(BSP_I2C_CLASS_TELEMETRY);
 }
 
 void HalEsp32::setRtcTime(tm time)
 {
     mclog::tagInfo(_tag, "set rtc time to {}/{}/{} {:02d}:{:02d}:{:02d}", time.tm_year + 1900, time.tm_mon + 1,
                    time.tm_mday, time.tm_hour, time.tm_min, time.tm_sec);
+    bsp_i2c_acquire(BSP_I2C_CLASS_TELEMETRY, BSP_I2C_WAIT_FOREVER);
     rx8130.setTime(&time);
+    bsp_i2c_release(BSP_I2C_CLASS_TELEMETRY);
     delay(50);
 
     update_system_time();
@@ -255,7 +508,9 @@ void HalEsp32::update_system_time()
 {
     mclog::tagInfo(_tag, "update system time");
     struct tm time;
+    bsp_i2c_acquire(BSP_I2C_CLASS_TELEMETRY, BSP_I2C_WAIT_FOREVER);
     rx8130.getTime(&time);
+    bsp_i2c_release(BSP_I2C_CLASS_TELEMETRY);
     mclog::tagInfo(_tag, "sync to rtc time: {}-{:02d}-{:02d} {:02d}:{:02d}:{:02d}", time.tm_year + 1900,
                    time.tm_mon + 1, time.tm_mday, time.tm_hour, time.tm_min, time.tm_sec);
     struct timeval now;
@@ -267,50 +522,36 @@ void HalEsp32::update_system_time()
 /* -------------------------------------------------------------------------- */
 /*                                   SD Card                                  */
 /* -------------------------------------------------------------------------- */
-#include <dirent.h>
-#include <sys/types.h>
+#include "components/sd_storage.h"
 
 bool HalEsp32::isSdCardMounted()
 {
-    return true;
+    return SdStorage::getInstance().isMounted();
 }
 
-std::vector<hal::HalBase::FileEntry_t> HalEsp32::scanSdCard(const std::string& dirPath)
+size_t HalEsp32::scanSdCardPage(const std::string& dirPath, size_t offset, size_t limit, DirVisitor_t visit,
+                                void* user, bool* more)
 {
-    std::vector<hal::HalBase::FileEntry_t> file_entries;
-
-    mclog::tagInfo(_tag, "init sd card");
-    if (bsp_sdcard_init("/sd", 25) != ESP_OK) {
+    if (more) *more = false;
+    if (!SdStorage::getInstance().mount()) {
         mclog::error("failed to mount sd card");
-        return file_entries;
-    }
-
-    std::string target_path = "/sd/" + dirPath;
-
-    DIR* dir = opendir(target_path.c_str());
-    if (dir == nullptr) {
-        mclog::error("failed to open directory: {}", target_path);
-        return file_entries;
+        return 0;
     }
 
-    struct dirent* entry;
-    while ((entry = readdir(dir)) != nullptr) {
-        if (std::string(entry->d_name) == "." || std::string(entry->d_name) == "..") {
-            continue;
-        }
-
-        hal::HalBase::FileEntry_t file_entry;
-        file_entry.name  = entry->d_name;
-        file_entry.isDir = (entry->d_type == DT_DIR);
-        file_entries.push_back(file_entry);
-    }
-
-    closedir(dir);
-
-    mclog::tagInfo(_tag, "deinit sd card");
-    bsp_sdcard_deinit("/sd");
-
-    return file_entries;
+    char target_path[272];
+    snprintf(target_path, sizeof(target_path), "%s/%s", SdStorage::MOUNT_POINT, dirPath.c_str());
+
+    struct Forward {
+        DirVisitor_t visit;
+        void* user;
+    } forward{visit, user};
+    return SdStorage::scanDir(
+        target_path,
+        [](const SdDirEntry& e, void* arg) {
+            auto* f = static_cast<Forward*>(arg);
+            return f->visit(DirEntry_t{e.name, e.isDir}, f->user);
+        },
+        &forward, offset, limit, more);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -327,10 +568,10 @@ bool HalEsp32::headPhoneDetect()
     return bsp_headphone_detect();
 }
 
-std::vector<uint8_t> HalEsp32::i2cScan(bool isInternal)
+size_t HalEsp32::i2cScanInto(bool isInternal, uint8_t* addrs, size_t capacity)
 {
     i2c_master_bus_handle_t i2c_bus_handle;
-    std::vector<uint8_t> addrs;
+    size_t found = 0;
 
     if (isInternal) {
         i2c_bus_handle = bsp_i2c_get_handle();
@@ -345,14 +586,17 @@ std::vector<uint8_t> HalEsp32::i2cScan(bool isInternal)
         for (int j = 0; j < 16; j++) {
             fflush(stdout);
             address = i + j;
-            ret     = i2c_master_probe(i2c_bus_handle, address, 50);
-            if (ret == ESP_OK) {
-                addrs.push_back(address);
+            // One probe per hold, so a scan of the sys bus never holds up the codec for long
+            if (isInternal) bsp_i2c_acquire(BSP_I2C_CLASS_TELEMETRY, BSP_I2C_WAIT_FOREVER);
+            ret = i2c_master_probe(i2c_bus_handle, address, 50);
+            if (isInternal) bsp_i2c_release(BSP_I2C_CLASS_TELEMETRY);
+            if (ret == ESP_OK && found < capacity) {
+                addrs[found++] = address;
             }
         }
     }
 
-    return addrs;
+    return found;
 }
 
 void HalEsp32::initPortAI2c()
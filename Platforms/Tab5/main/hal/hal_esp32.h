@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: MIT
  */
 #pragma once
+#include <atomic>
 #include <hal/hal.h>
 #include <ina226.hpp>
 #include <lvgl.h>
@@ -20,7 +21,11 @@ public:
 
     void delay(uint32_t ms) override;
     uint32_t millis() override;
+    void waitMainLoopWake(uint32_t timeoutMs) override;
+    void wakeMainLoop() override;
     int getCpuTemp() override;
+    void updateSystemStats() override;
+    void updateHeapStats() override;
 
     INA226 ina226;
     RX8130_Class rx8130;
@@ -29,13 +34,19 @@ public:
 
     void setDisplayBrightness(uint8_t brightness) override;
     uint8_t getDisplayBrightness() override;
+    void updateDisplayStats() override;
+    void resetDisplayStats() override;
 
     void lvglLock() override;
     void lvglUnlock() override;
 
     void updatePowerMonitorData() override;
+    size_t getPowerHistory(std::vector<PMData_t>& history) override;
     void updateImuData() override;
+    size_t getImuSamples(std::vector<IMUSample_t>& samples, uint32_t& seq) override;
     void clearImuIrq() override;
+    bool setMotionAwareAudio(bool enabled) override;
+    bool isMotionAwareAudio() override;
 
     void clearRtcIrq() override;
     void setRtcTime(tm time) override;
@@ -52,15 +63,31 @@ public:
     void sleepAndTouchWakeup() override;
     void sleepAndShakeWakeup() override;
     void sleepAndRtcWakeup() override;
+    bool sleepUntilSession(uint8_t hour, uint8_t minute) override;
+    bool isSessionWakeup() override;
+    bool setAudioOnlyMode(bool enabled) override;
+    bool isAudioOnlyMode() override;
+    // Ends audio-only mode on the main loop; any task or callback (touch, HID)
+    static void requestAudioOnlyWake();
 
     void startCameraCapture(lv_obj_t* imgCanvas) override;
     void stopCameraCapture() override;
     bool isCameraCapturing() override;
+    bool setCameraMirror(bool hmirror, bool vflip) override;
+    bool setCameraPreviewSize(uint32_t width, uint32_t height) override;
+    bool saveCameraSnapshot(std::string& savedPath) override;
+    bool startSessionRecording() override;
+    void stopSessionRecording() override;
+    bool isSessionRecording() override;
+    bool setFaceSteering(bool enabled) override;
+    bool isFaceSteering() override;
+    bool releaseCameraBuffers() override;
 
     void setSpeakerVolume(uint8_t volume) override;
     uint8_t getSpeakerVolume() override;
-    void audioRecord(std::vector<int16_t>& data, uint16_t durationMs, float gain = 80.0f) override;
-    void audioPlay(std::vector<int16_t>& data, bool async = true) override;
+    size_t audioRecordInto(int16_t* data, size_t samples, float gain = 80.0f) override;
+    bool audioPlayBuffer(const int16_t* data, size_t samples, bool async = true, AudioDone_t done = nullptr,
+                         void* user = nullptr) override;
     void startDualMicRecordTest() override;
     MicTestState_t getDualMicRecordTestState() override;
     void startHeadphoneMicRecordTest() override;
@@ -68,20 +95,30 @@ public:
     void startPlayMusicTest() override;
     MusicPlayState_t getMusicPlayTestState() override;
     void stopPlayMusicTest() override;
+    bool startMediaPlayback(const std::string& path, bool replaceMics = false) override;
+    void stopMediaPlayback() override;
+    bool isMediaPlaying() override;
     void playStartupSfx() override;
     void playShutdownSfx() override;
 
     void setExtAntennaEnable(bool enable) override;
     bool getExtAntennaEnable() override;
     void startWifiAp() override;
+    void setRemoteTuningEnabled(bool enabled) override;
+    bool isWifiConnected() override;
+
+    bool startFirmwareUpdate(const std::string& source) override;
+    void cancelFirmwareUpdate() override;
+    int getFirmwareUpdateProgress() override;
 
     bool isSdCardMounted() override;
-    std::vector<FileEntry_t> scanSdCard(const std::string& dirPath) override;
+    size_t scanSdCardPage(const std::string& dirPath, size_t offset, size_t limit, DirVisitor_t visit, void* user,
+                          bool* more = nullptr) override;
 
     bool usbCDetect() override;
     bool usbADetect() override;
     bool headPhoneDetect() override;
-    std::vector<uint8_t> i2cScan(bool isInternal) override;
+    size_t i2cScanInto(bool isInternal, uint8_t* addrs, size_t capacity) override;
     void initPortAI2c() override;
     void deinitPortAI2c() override;
     void gpioInitOutput(uint8_t pin) override;
@@ -93,8 +130,15 @@ private:
     void hid_init();
     void rs485_init();
     bool wifi_init();
+    bool wifi_station_begin();
     void imu_init();
     void update_system_time();
+    void sfx_cache_init();
+    void pm_init();
+    void thermal_init();
+    static void peripheral_bringup_task(void* param);
+    void peripheral_bringup();
+    bool imu_tap_detected(uint32_t& seq);
 
     uint8_t _current_lcd_brightness = 100;
     bool _charge_qc_enable          = false;
@@ -103,4 +147,9 @@ private:
     bool _usba_5v_enable            = true;
     bool _ext_antenna_enable        = false;
     bool _sd_card_mounted           = false;
+
+    std::atomic<bool> _display_ready{false};  // LVGL started, lvglLock() usable
+    std::atomic<bool> _audio_only{false};
+    inline static std::atomic<bool> _audio_only_wake{false};
+    uint32_t _audio_only_imu_seq = 0;
 };
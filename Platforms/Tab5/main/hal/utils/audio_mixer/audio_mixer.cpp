@@ -0,0 +1,252 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "audio_mixer.h"
+#include <algorithm>
+#include <cmath>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static constexpr uint32_t RING_MASK = AudioMixer::RING_FRAMES - 1;
+static_assert((AudioMixer::RING_FRAMES & RING_MASK) == 0, "RING_FRAMES must be a power of two");
+
+// Drift loop, run once per mix() call: fill error is relative to the target
+static constexpr float FILL_SMOOTHING = 0.02f;  // ~0.5 s at 10 ms blocks, averages out producer bursts
+static constexpr float DRIFT_KP_PPM = 2000.0f;
+static constexpr float DRIFT_KI_PPM = 2.0f;
+
+int AudioMixer::openVoice(uint32_t sampleRate, int channels, float gain, float duckDb, Bus bus)
+{
+    return claimVoice(sampleRate, channels, gain, duckDb, bus, 0);
+}
+
+int AudioMixer::openLiveVoice(uint32_t sampleRate, int channels, uint32_t targetFrames, Bus bus, float gain,
+                              float duckDb)
+{
+    if (targetFrames == 0 || targetFrames >= RING_FRAMES / 2) return -1;
+    return claimVoice(sampleRate, channels, gain, duckDb, bus, targetFrames);
+}
+
+int AudioMixer::claimVoice(uint32_t sampleRate, int channels, float gain, float duckDb, Bus bus, uint32_t target)
+{
+    if (sampleRate == 0 || (channels != 1 && channels != 2) || bus < 0 || bus >= BUS_COUNT) return -1;
+    for (int i = 0; i < MAX_VOICES; i++) {
+        Voice& v = _voices[i];
+        int expected = FREE;
+        if (!v.state.compare_exchange_strong(expected, CLAIMED, std::memory_order_acquire)) continue;
+
+        // Rings stay allocated once made; a few voices' worth is cheap in PSRAM
+        if (!v.ring) {
+            const size_t bytes = RING_FRAMES * 2 * sizeof(int16_t);
+            v.ring = static_cast<int16_t*>(heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+            if (!v.ring) v.ring = static_cast<int16_t*>(heap_caps_malloc(bytes, MALLOC_CAP_8BIT));
+            if (!v.ring) {
+                v.state.store(FREE, std::memory_order_release);
+                return -1;
+            }
+        }
+        v.head.store(0, std::memory_order_relaxed);
+        v.tail.store(0, std::memory_order_relaxed);
+        v.rate.store(sampleRate, std::memory_order_relaxed);
+        v.channels.store(channels, std::memory_order_relaxed);
+        v.gain.store(gain, std::memory_order_relaxed);
+        v.duckDb.store(std::max(duckDb, 0.0f), std::memory_order_relaxed);
+        v.drop.store(false, std::memory_order_relaxed);
+        v.bus.store(bus, std::memory_order_relaxed);
+        v.target.store(target, std::memory_order_relaxed);
+        v.driftPpm.store(0.0f, std::memory_order_relaxed);
+        v.frac = 0.0f;
+        v.fill = static_cast<float>(target);
+        v.trimI = 0.0f;
+        v.primed = false;
+        v.state.store(ACTIVE, std::memory_order_release);
+        return i;
+    }
+    return -1;
+}
+
+bool AudioMixer::setVoiceFormat(int voice, uint32_t sampleRate, int channels)
+{
+    if (!validVoice(voice) || sampleRate == 0 || (channels != 1 && channels != 2)) return false;
+    _voices[voice].rate.store(sampleRate, std::memory_order_relaxed);
+    _voices[voice].channels.store(channels, std::memory_order_relaxed);
+    return true;
+}
+
+void AudioMixer::setVoiceGain(int voice, float gain, float duckDb)
+{
+    if (!validVoice(voice)) return;
+    _voices[voice].gain.store(gain, std::memory_order_relaxed);
+    _voices[voice].duckDb.store(std::max(duckDb, 0.0f), std::memory_order_relaxed);
+}
+
+size_t AudioMixer::write(int voice, const int16_t* frames, size_t count, uint32_t timeoutMs)
+{
+    if (!validVoice(voice)) return 0;
+    Voice& v = _voices[voice];
+    if (v.state.load(std::memory_order_acquire) != ACTIVE) return 0;
+
+    const int channels = v.channels.load(std::memory_order_relaxed);
+    const TickType_t start = xTaskGetTickCount();
+    size_t done = 0;
+    while (done < count) {
+        uint32_t head = v.head.load(std::memory_order_relaxed);
+        uint32_t tail = v.tail.load(std::memory_order_acquire);
+        size_t n = std::min<size_t>(RING_FRAMES - (head - tail), count - done);
+        for (size_t i = 0; i < n; i++, head++) {
+            const int16_t* in = frames + (done + i) * channels;
+            int16_t* out = v.ring + (head & RING_MASK) * 2;
+            out[0] = in[0];
+            out[1] = in[channels - 1];
+        }
+        v.head.store(head, std::memory_order_release);
+        done += n;
+        if (done == count) break;
+        // Full: the audio task drains one block per period
+        if ((xTaskGetTickCount() - start) >= pdMS_TO_TICKS(timeoutMs)) break;
+        vTaskDelay(1);
+    }
+    return done;
+}
+
+void AudioMixer::closeVoice(int voice, bool drop)
+{
+    if (!validVoice(voice)) return;
+    Voice& v = _voices[voice];
+    if (v.state.load(std::memory_order_acquire) != ACTIVE) return;
+    v.drop.store(drop, std::memory_order_relaxed);
+    v.state.store(DRAINING, std::memory_order_release);
+}
+
+int AudioMixer::activeVoices() const
+{
+    int n = 0;
+    for (const Voice& v : _voices) {
+        int st = v.state.load(std::memory_order_relaxed);
+        if (st == ACTIVE || st == DRAINING) n++;
+    }
+    return n;
+}
+
+float AudioMixer::driftTrim(Voice& v, uint32_t queued)
+{
+    const uint32_t target = v.target.load(std::memory_order_relaxed);
+    if (target == 0) return 0.0f;
+    v.fill += FILL_SMOOTHING * (static_cast<float>(queued) - v.fill);
+    // Fuller than the target: the source clock is fast, consume a little faster
+    const float error = (v.fill - static_cast<float>(target)) / static_cast<float>(target);
+    v.trimI = std::clamp(v.trimI + DRIFT_KI_PPM * error, -MAX_DRIFT_PPM, MAX_DRIFT_PPM);
+    const float ppm = std::clamp(DRIFT_KP_PPM * error + v.trimI, -MAX_DRIFT_PPM, MAX_DRIFT_PPM);
+    v.driftPpm.store(ppm, std::memory_order_relaxed);
+    return ppm * 1e-6f;
+}
+
+void AudioMixer::mix(float* l, float* r, int frames, uint32_t outputRate, Bus bus)
+{
+    if (frames <= 0) return;
+    constexpr float scale = 1.0f / 32768.0f;
+
+    // Ducking target: the deepest duck among voices with audio still queued
+    float duckTarget = 1.0f;
+    bool any = false;
+    for (Voice& v : _voices) {
+        int st = v.state.load(std::memory_order_acquire);
+        if (st != ACTIVE && st != DRAINING) continue;
+        if (v.bus.load(std::memory_order_relaxed) != bus) continue;
+        if (st == DRAINING && v.drop.load(std::memory_order_relaxed)) {
+            v.tail.store(v.head.load(std::memory_order_acquire), std::memory_order_release);
+            v.primed = false;
+            v.state.store(FREE, std::memory_order_release);
+            continue;
+        }
+        any = true;
+        uint32_t queued = v.head.load(std::memory_order_acquire) - v.tail.load(std::memory_order_relaxed);
+        float duckDb = v.duckDb.load(std::memory_order_relaxed);
+        if ((queued > 0 || v.primed) && duckDb > 0.0f) {
+            duckTarget = std::min(duckTarget, powf(10.0f, -duckDb / 20.0f));
+        }
+    }
+    float& duckGain = _duckGain[bus];
+    if (!any && duckGain == 1.0f) return;
+
+    // 10ms attack, 300ms release, ramped across the block
+    const float tau = duckTarget < duckGain ? 0.010f : 0.300f;
+    const float coef = expf(-frames / (tau * outputRate));
+    float g1 = duckTarget + (duckGain - duckTarget) * coef;
+    if (fabsf(g1 - 1.0f) < 1e-4f) g1 = 1.0f;
+    if (duckGain != 1.0f || g1 != 1.0f) {
+        const float step = (g1 - duckGain) / frames;
+        for (int i = 0; i < frames; i++) {
+            float g = duckGain + step * i;
+            l[i] *= g;
+            r[i] *= g;
+        }
+    }
+    duckGain = g1;
+
+    for (Voice& v : _voices) {
+        int st = v.state.load(std::memory_order_acquire);
+        if (st != ACTIVE && st != DRAINING) continue;
+        if (v.bus.load(std::memory_order_relaxed) != bus) continue;
+
+        uint32_t tail = v.tail.load(std::memory_order_relaxed);
+        const uint32_t head = v.head.load(std::memory_order_acquire);
+        auto pop = [&](float* dst) {
+            if (tail == head) return false;
+            const int16_t* f = v.ring + (tail & RING_MASK) * 2;
+            dst[0] = f[0] * scale;
+            dst[1] = f[1] * scale;
+            tail++;
+            return true;
+        };
+
+        // Interpolation needs two frames in hand; a live voice waits for its jitter headroom
+        const uint32_t live = v.target.load(std::memory_order_relaxed);
+        if (!v.primed) {
+            if (head - tail >= std::max<uint32_t>(2, live) || (st == DRAINING && head - tail >= 2)) {
+                pop(v.prev);
+                pop(v.next);
+                v.frac = 0.0f;
+                v.fill = static_cast<float>(head - tail);
+                v.primed = true;
+            }
+        }
+
+        if (v.primed) {
+            const float trim = live ? driftTrim(v, head - tail) : 0.0f;
+            const float step = static_cast<float>(v.rate.load(std::memory_order_relaxed)) / outputRate * (1.0f + trim);
+            const float gain = v.gain.load(std::memory_order_relaxed);
+            for (int i = 0; i < frames; i++) {
+                l[i] += gain * (v.prev[0] + (v.next[0] - v.prev[0]) * v.frac);
+                r[i] += gain * (v.prev[1] + (v.next[1] - v.prev[1]) * v.frac);
+                v.frac += step;
+                bool dry = false;
+                while (v.frac >= 1.0f) {
+                    v.frac -= 1.0f;
+                    v.prev[0] = v.next[0];
+                    v.prev[1] = v.next[1];
+                    if (!pop(v.next)) {
+                        dry = true;
+                        break;
+                    }
+                }
+                if (dry) {
+                    // Starved mid-block: an open voice counts an underrun and re-primes later
+                    if (st == ACTIVE) _underruns.fetch_add(1, std::memory_order_relaxed);
+                    v.primed = false;
+                    break;
+                }
+            }
+        }
+        v.tail.store(tail, std::memory_order_release);
+
+        // A closed voice frees its slot once everything queued has played
+        if (st == DRAINING && !v.primed && head - tail < 2) {
+            v.tail.store(head, std::memory_order_release);
+            v.state.store(FREE, std::memory_order_release);
+        }
+    }
+}
@@ -0,0 +1,112 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Voice mixer feeding SFX and streamed content into the engine output
+ *
+ * Producer tasks (MP3 decoders, UI sounds) open a voice slot and write int16
+ * PCM at their own rate into that slot's wait-free SPSC ring; the audio task
+ * pulls every active voice once per block, resamples it to the output rate by
+ * linear interpolation and adds it to the program after ducking. One voice has
+ * one producer; slots are claimed and released without locks, so the audio
+ * task never blocks on a producer.
+ *
+ * Ducking: while a voice with duckDb > 0 has audio queued, the program is
+ * pulled down by the largest duckDb among them (fast attack, slow release).
+ *
+ * Buses: BUS_OUTPUT voices (UI sounds, prompts) join after the hearing chain.
+ * BUS_FITTED voices join ahead of the WDRC / multiband stages, so streamed
+ * media gets the user's fitting; each bus ducks the program at its own point.
+ *
+ * Live voices (openLiveVoice) come from a producer on another clock, e.g. a
+ * wireless stream. Playback starts once targetFrames are queued, and the
+ * resampling ratio is trimmed by up to MAX_DRIFT_PPM by a PI loop that holds
+ * the smoothed fill at that target, so the source and I2S clocks can drift
+ * apart without the ring ever running dry or over.
+ */
+class AudioMixer {
+public:
+    static constexpr int MAX_VOICES = 4;
+    static constexpr size_t RING_FRAMES = 4096;  // Stereo frames per voice (~85ms @48kHz)
+    static constexpr float MAX_DRIFT_PPM = 2000.0f;
+
+    enum Bus : int {
+        BUS_OUTPUT = 0,  // After the hearing chain
+        BUS_FITTED,      // Before WDRC / MBC: gets the hearing profile
+        BUS_COUNT,
+    };
+
+    // ── Producer side (any task, one per voice) ──
+    // Returns a voice id, or -1 when every slot is busy or the ring can't be allocated
+    int openVoice(uint32_t sampleRate, int channels, float gain = 1.0f, float duckDb = 0.0f, Bus bus = BUS_OUTPUT);
+    // Drift-compensated voice: targetFrames (source rate, < RING_FRAMES / 2) is the
+    // jitter headroom kept queued, and the latency it adds
+    int openLiveVoice(uint32_t sampleRate, int channels, uint32_t targetFrames, Bus bus = BUS_FITTED, float gain = 1.0f,
+                      float duckDb = 0.0f);
+    // Format of the frames written from now on (e.g. the next MP3 at another rate)
+    bool setVoiceFormat(int voice, uint32_t sampleRate, int channels);
+    void setVoiceGain(int voice, float gain, float duckDb);
+    // Interleaved frames in the voice's channel count; waits up to timeoutMs for
+    // ring space and returns the frames actually queued
+    size_t write(int voice, const int16_t* frames, size_t count, uint32_t timeoutMs);
+    // Lets queued audio play out, then frees the slot (drop = discard it instead)
+    void closeVoice(int voice, bool drop = false);
+
+    int activeVoices() const;
+    uint32_t underruns() const
+    {
+        return _underruns.load(std::memory_order_relaxed);
+    }
+    // A live voice's current ratio trim, + when the source runs fast
+    float driftPpm(int voice) const
+    {
+        return validVoice(voice) ? _voices[voice].driftPpm.load(std::memory_order_relaxed) : 0.0f;
+    }
+
+    // ── Consumer side (audio task) ──
+    // Ducks the program in l/r, then adds the bus's voices; frames at outputRate
+    void mix(float* l, float* r, int frames, uint32_t outputRate, Bus bus = BUS_OUTPUT);
+
+private:
+    enum State : int { FREE, CLAIMED, ACTIVE, DRAINING };
+
+    struct Voice {
+        std::atomic<int> state{FREE};
+        int16_t* ring = nullptr;  // RING_FRAMES stereo frames, allocated on first use
+        std::atomic<uint32_t> head{0};
+        std::atomic<uint32_t> tail{0};
+        std::atomic<uint32_t> rate{48000};
+        std::atomic<int> channels{2};
+        std::atomic<float> gain{1.0f};
+        std::atomic<float> duckDb{0.0f};
+        std::atomic<bool> drop{false};
+        std::atomic<int> bus{BUS_OUTPUT};
+        std::atomic<uint32_t> target{0};  // Live voices: fill the drift loop holds, 0 otherwise
+        std::atomic<float> driftPpm{0.0f};
+        // Consumer-only resampler state
+        float frac = 0.0f;
+        float fill = 0.0f;   // Smoothed queue depth, live voices
+        float trimI = 0.0f;  // Drift loop integrator
+        float prev[2] = {};
+        float next[2] = {};
+        bool primed = false;
+    };
+
+    bool validVoice(int voice) const
+    {
+        return voice >= 0 && voice < MAX_VOICES;
+    }
+    int claimVoice(uint32_t sampleRate, int channels, float gain, float duckDb, Bus bus, uint32_t target);
+    float driftTrim(Voice& v, uint32_t queued);
+
+    Voice _voices[MAX_VOICES];
+    float _duckGain[BUS_COUNT] = {1.0f, 1.0f};  // Consumer-only, smoothed program gain per bus
+    std::atomic<uint32_t> _underruns{0};
+};
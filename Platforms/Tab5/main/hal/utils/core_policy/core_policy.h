@@ -0,0 +1,33 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <sdkconfig.h>
+#include <freertos/FreeRTOS.h>
+
+/**
+ * @brief Which core each kind of task runs on
+ *
+ * Core 1 carries the audio block loop (and the off-line kernel benchmark);
+ * with CONFIG_HOWIZARD_RESERVE_DSP_CORE everything else is pinned to Core 0.
+ * The exception is LVGL's second draw thread, which only renders while the
+ * audio engine is stopped.
+ * Tasks whose placement is part of their design (the AEC worker, codec
+ * control, USB audio) pin Core 0 themselves and don't go through this.
+ */
+namespace core_policy {
+
+inline constexpr BaseType_t DSP_CORE = 1;
+
+#if CONFIG_HOWIZARD_RESERVE_DSP_CORE
+inline constexpr int SYSTEM_CORE = 0;  // esp_lvgl_port task_affinity convention: -1 = any core
+#else
+inline constexpr int SYSTEM_CORE = -1;
+#endif
+
+// For xTaskCreatePinnedToCore
+inline constexpr BaseType_t SYSTEM_AFFINITY = SYSTEM_CORE < 0 ? tskNO_AFFINITY : SYSTEM_CORE;
+
+}  // namespace core_policy
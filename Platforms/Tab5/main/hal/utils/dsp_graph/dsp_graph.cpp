@@ -0,0 +1,90 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "dsp_graph.h"
+#include <cstring>
+
+void DspGraph::setConverter(const Converter& converter, float* scratchL, float* scratchR, int maxFrames16k)
+{
+    _converter = converter;
+    _scratchL = scratchL;
+    _scratchR = scratchR;
+    _scratchFrames = maxFrames16k;
+    _dirty = true;
+}
+
+int DspGraph::addStage(const Stage& stage, bool enabled)
+{
+    if (_numStages >= MAX_STAGES || !stage.process) return -1;
+    const int id = _numStages++;
+    _stages[id] = stage;
+    _enabled[id] = enabled;
+    _inPlan[id] = false;
+    _dirty = true;
+    return id;
+}
+
+void DspGraph::compile()
+{
+    _dirty = false;
+
+    const bool canConvert = _converter.down && _converter.up && _scratchL && _scratchR && _scratchFrames > 0;
+    bool wasInPlan[MAX_STAGES];
+    std::memcpy(wasInPlan, _inPlan, sizeof(wasInPlan));
+    int16_t crossings[2 * MAX_SEGMENTS];
+    int numCrossings = 0;
+
+    _numSteps = 0;
+    _numSegments = 0;
+    Rate domain = RATE_48K;
+    auto convert = [&](StepKind kind, int nextId) {
+        if (kind == STEP_DOWN) _numSegments++;
+        _steps[_numSteps++] = Step{nullptr, nullptr, _converter.tag, kind, static_cast<int8_t>(_numSegments - 1)};
+        crossings[numCrossings++] = static_cast<int16_t>(nextId);
+    };
+
+    for (int id = 0; id < _numStages; id++) {
+        const Stage& stage = _stages[id];
+        _inPlan[id] = false;
+        if (!_enabled[id]) continue;
+        if (stage.rate != domain) {
+            if (stage.rate == RATE_16K) {
+                // No converter, or out of segments: the stage has nowhere to run
+                if (!canConvert || _numSegments >= MAX_SEGMENTS) continue;
+                convert(STEP_DOWN, id);
+            } else {
+                convert(STEP_UP, id);
+            }
+            domain = stage.rate;
+        }
+        _steps[_numSteps++] = Step{stage.process, stage.ctx, stage.tag,
+                                   stage.rate == RATE_16K ? STEP_STAGE_16K : STEP_STAGE_48K, 0};
+        _inPlan[id] = true;
+    }
+    if (domain == RATE_16K) convert(STEP_UP, _numStages);
+
+    // Entering stages start from clean history
+    for (int id = 0; id < _numStages; id++) {
+        if (_inPlan[id] && !wasInPlan[id] && _stages[id].reset) _stages[id].reset(_stages[id].ctx);
+    }
+
+    // The converters' history belongs to the crossings it was built on
+    const bool crossingsChanged = numCrossings != _numCrossings ||
+                                  std::memcmp(crossings, _crossings, numCrossings * sizeof(int16_t)) != 0;
+    if (crossingsChanged) {
+        std::memcpy(_crossings, crossings, numCrossings * sizeof(int16_t));
+        _numCrossings = numCrossings;
+        if (numCrossings > 0 && _converter.reset) _converter.reset(_converter.ctx);
+    }
+}
+
+void DspGraph::clear()
+{
+    std::memset(_inPlan, 0, sizeof(_inPlan));
+    _numSteps = 0;
+    _numSegments = 0;
+    _numCrossings = 0;
+    _dirty = true;
+}
@@ -0,0 +1,171 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <cstdint>
+
+/**
+ * @brief Block-processing chain compiled into a flat plan of the stages that are on
+ *
+ * Stages are registered once, in chain order, each with the rate it runs at.
+ * The owner switches them on and off with setEnabled(), and the next run()
+ * recompiles the plan if anything changed. A stage that is off is not in the
+ * plan at all. A conversion step goes in wherever two neighbouring stages run
+ * at different rates, plus one back to 48 kHz at the end. A run of 16 kHz
+ * stages therefore costs one down/up pair however many stages it holds, and
+ * nothing once they are all off.
+ *
+ * A stage entering the plan gets its reset callback first, so its history never
+ * replays audio from before it was switched off. The converter is reset
+ * whenever the plan's crossings change. Storage is fixed-size, and compiling
+ * and running never allocate. The graph belongs to one task.
+ */
+class DspGraph {
+public:
+    static constexpr int MAX_STAGES = 16;
+    static constexpr int MAX_SEGMENTS = 2;  // 16 kHz runs per plan; stages past the last one are left out
+    static constexpr int DECIMATION = 3;    // 48 kHz / 16 kHz
+
+    enum Rate : uint8_t {
+        RATE_48K = 0,
+        RATE_16K,
+    };
+
+    // Stereo block at one rate, processed in place
+    struct Block {
+        float* left;
+        float* right;
+        int frames;
+    };
+    using ProcessFn = void (*)(void* ctx, Block& block);
+    using ResetFn = void (*)(void* ctx);
+    // segment: which 16 kHz run of the plan (0..MAX_SEGMENTS-1); frames are counted at each block's own rate
+    using ConvertFn = void (*)(void* ctx, int segment, const Block& in, Block& out);
+
+    struct Stage {
+        ProcessFn process;
+        ResetFn reset;  // On entering the plan; may be nullptr
+        void* ctx;
+        Rate rate;
+        int tag;        // Owner's label, handed to run()'s step callback (e.g. a profiler stage)
+    };
+
+    struct Converter {
+        ConvertFn down;
+        ConvertFn up;
+        ResetFn reset;  // All segments' history
+        void* ctx;
+        int tag;
+    };
+
+    // Needed before any 16 kHz stage can be in a plan; scratch holds maxFrames16k per lane
+    void setConverter(const Converter& converter, float* scratchL, float* scratchR, int maxFrames16k);
+
+    // Registration order is chain order; returns the stage id, -1 when full
+    int addStage(const Stage& stage, bool enabled = false);
+    void setEnabled(int id, bool enabled)
+    {
+        if (id < 0 || id >= _numStages || _enabled[id] == enabled) return;
+        _enabled[id] = enabled;
+        _dirty = true;
+    }
+    bool isEnabled(int id) const
+    {
+        return id >= 0 && id < _numStages && _enabled[id];
+    }
+    // In the compiled plan (off, or a 16 kHz stage with nowhere to run, is not)
+    bool inPlan(int id) const
+    {
+        return id >= 0 && id < _numStages && _inPlan[id];
+    }
+
+    // Rebuilds the plan now; run() does it itself when something changed
+    void compile();
+    // Forgets the plan, so every stage is reset again as it enters the next one
+    void clear();
+
+    // Steps in the current plan, conversions included
+    int planSize() const
+    {
+        return _numSteps;
+    }
+    int segments() const
+    {
+        return _numSegments;
+    }
+
+    /**
+     * @brief Runs the plan in place on a 48 kHz block, calling onStep(tag) after each step
+     *
+     * The 16 kHz segments need frames divisible by DECIMATION and within the
+     * scratch; for a block that isn't, they are skipped and the block passes
+     * through there unconverted.
+     */
+    template <typename OnStep>
+    void run(float* left, float* right, int frames, OnStep&& onStep)
+    {
+        if (_dirty) compile();
+        Block full{left, right, frames};
+        Block low{_scratchL, _scratchR, frames / DECIMATION};
+        const bool lowOk = frames % DECIMATION == 0 && low.frames <= _scratchFrames;
+        for (int s = 0; s < _numSteps; s++) {
+            const Step& step = _steps[s];
+            switch (step.kind) {
+                case STEP_STAGE_48K:
+                    step.process(step.ctx, full);
+                    break;
+                case STEP_STAGE_16K:
+                    if (!lowOk) continue;
+                    step.process(step.ctx, low);
+                    break;
+                case STEP_DOWN:
+                    if (!lowOk) continue;
+                    _converter.down(_converter.ctx, step.segment, full, low);
+                    break;
+                case STEP_UP:
+                    if (!lowOk) continue;
+                    _converter.up(_converter.ctx, step.segment, low, full);
+                    break;
+            }
+            onStep(step.tag);
+        }
+    }
+
+private:
+    enum StepKind : uint8_t {
+        STEP_STAGE_48K = 0,
+        STEP_STAGE_16K,
+        STEP_DOWN,
+        STEP_UP,
+    };
+
+    struct Step {
+        ProcessFn process;
+        void* ctx;
+        int tag;
+        StepKind kind;
+        int8_t segment;
+    };
+
+    // Stages plus a down and an up per segment
+    static constexpr int MAX_STEPS = MAX_STAGES + 2 * MAX_SEGMENTS;
+
+    Stage _stages[MAX_STAGES] = {};
+    bool _enabled[MAX_STAGES] = {};
+    bool _inPlan[MAX_STAGES] = {};
+    int _numStages = 0;
+
+    Step _steps[MAX_STEPS] = {};
+    int _numSteps = 0;
+    int _numSegments = 0;
+    int16_t _crossings[2 * MAX_SEGMENTS] = {};  // Stage id after each conversion step, for the reset rule
+    int _numCrossings = 0;
+    bool _dirty = true;
+
+    Converter _converter = {};
+    float* _scratchL = nullptr;
+    float* _scratchR = nullptr;
+    int _scratchFrames = 0;
+};
@@ -0,0 +1,930 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "dsp_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#if __has_include(<sdkconfig.h>)
+#include <sdkconfig.h>
+#endif
+
+#if CONFIG_IDF_TARGET_ESP32P4 && CONFIG_DSP_OPTIMIZED
+#include <dsps_biquad.h>
+#define DSP_KERNELS_USE_DSPS_BIQUAD 1
+#endif
+
+static constexpr float K_WEIGHTING_RATE = 48000.0f;  // The only rate BS.1770 gives K-weighting constants for
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Biquad filter - Direct Form II Transposed
+// ─────────────────────────────────────────────────────────────────────────────
+
+float Biquad::process(float in)
+{
+    float out = b0 * in + z1;
+    z1 = b1 * in - a1 * out + z2;
+    z2 = b2 * in - a2 * out;
+    return out;
+}
+
+void Biquad::reset()
+{
+    z1 = 0.0f;
+    z2 = 0.0f;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Biquad cascade - block processing, stereo fused (right == nullptr: mono)
+// ─────────────────────────────────────────────────────────────────────────────
+
+static constexpr float kIdentityCoef[5] = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+static bool isIdentityCoef(const float* c)
+{
+    return c[0] == 1.0f && c[1] == 0.0f && c[2] == 0.0f && c[3] == 0.0f && c[4] == 0.0f;
+}
+
+void BiquadCascade::setSection(int slot, const Biquad& bq, bool enabled)
+{
+    if (slot < 0 || slot >= MAX_SECTIONS) return;
+
+    float* t = _target[slot];
+    t[0] = bq.b0; t[1] = bq.b1; t[2] = bq.b2;
+    t[3] = bq.a1; t[4] = bq.a2;
+
+    // Identity sections (0 dB EQ, bypassed shelf) cost nothing once faded out
+    bool active = enabled && !isIdentityCoef(t);
+    if (!active) {
+        std::memcpy(t, kIdentityCoef, sizeof(kIdentityCoef));
+    }
+
+    // Sections coming back fade in from identity with clean state
+    if (active && !_slotLive[slot]) {
+        std::memcpy(_current[slot], kIdentityCoef, sizeof(kIdentityCoef));
+        std::memset(_state[slot], 0, sizeof(_state[slot]));
+    }
+
+    _slotEnabled[slot] = active;
+    _slotRamping[slot] = std::memcmp(_current[slot], t, sizeof(_current[slot])) != 0;
+    _slotLive[slot] = active || (_slotLive[slot] && _slotRamping[slot]);
+    repack();
+}
+
+void BiquadCascade::repack()
+{
+    _numActive = 0;
+    _numRamping = 0;
+    for (int slot = 0; slot < MAX_SECTIONS; slot++) {
+        if (!_slotLive[slot]) continue;
+        _packedSlot[_numActive++] = slot;
+        if (_slotRamping[slot]) _numRamping++;
+    }
+}
+
+void BiquadCascade::process(float* left, float* right, int frames)
+{
+    if (right) {
+        processImpl<true>(left, right, frames);
+    } else {
+        processImpl<false>(left, nullptr, frames);
+    }
+}
+
+template <int N, bool Stereo>
+__attribute__((always_inline)) inline void BiquadCascade::processFused(float* left, float* right, int frames)
+{
+    // Steady state only: every section in turn on each sample, so the block is
+    // read and written once instead of once per section
+    float c[N][5];
+    float zL[N][2], zR[N][2];
+    for (int k = 0; k < N; k++) {
+        const int slot = _packedSlot[k];
+        std::memcpy(c[k], _current[slot], sizeof(c[k]));
+        zL[k][0] = _state[slot][0][0]; zL[k][1] = _state[slot][0][1];
+        zR[k][0] = _state[slot][1][0]; zR[k][1] = _state[slot][1][1];
+    }
+
+    for (int i = 0; i < frames; i++) {
+        float xL = left[i];
+        float xR = Stereo ? right[i] : 0.0f;
+        for (int k = 0; k < N; k++) {  // N is constant: fully unrolled
+            const float b0 = c[k][0], b1 = c[k][1], b2 = c[k][2], a1 = c[k][3], a2 = c[k][4];
+#if DSP_KERNELS_USE_DSPS_BIQUAD
+            // DF2, the state layout dsps_biquad_f32 and the ramping path use
+            float dL = xL - a1 * zL[k][0] - a2 * zL[k][1];
+            float dR = xR - a1 * zR[k][0] - a2 * zR[k][1];
+            xL = b0 * dL + b1 * zL[k][0] + b2 * zL[k][1];
+            xR = b0 * dR + b1 * zR[k][0] + b2 * zR[k][1];
+            zL[k][1] = zL[k][0]; zL[k][0] = dL;
+            zR[k][1] = zR[k][0]; zR[k][0] = dR;
+#else
+            float outL = b0 * xL + zL[k][0];
+            float outR = b0 * xR + zR[k][0];
+            zL[k][0] = b1 * xL - a1 * outL + zL[k][1];
+            zR[k][0] = b1 * xR - a1 * outR + zR[k][1];
+            zL[k][1] = b2 * xL - a2 * outL;
+            zR[k][1] = b2 * xR - a2 * outR;
+            xL = outL;
+            xR = outR;
+#endif
+        }
+        left[i] = xL;
+        if (Stereo) right[i] = xR;
+    }
+
+    for (int k = 0; k < N; k++) {
+        const int slot = _packedSlot[k];
+        _state[slot][0][0] = zL[k][0]; _state[slot][0][1] = zL[k][1];
+        if (Stereo) { _state[slot][1][0] = zR[k][0]; _state[slot][1][1] = zR[k][1]; }
+    }
+}
+
+template <bool Stereo>
+void BiquadCascade::processImpl(float* left, float* right, int frames)
+{
+    bool retired = false;
+    bool settled = false;
+
+    // Nothing gliding: one fused pass. Up to MAX_FUSED sections the coefficients
+    // and state mostly fit the FPU registers; past that the per-section path
+    // (esp-dsp's kernel where available) costs less than the spills.
+    int fused = _numRamping == 0 ? _numActive : 0;
+    switch (fused) {
+        case 1: processFused<1, Stereo>(left, right, frames); break;
+        case 2: processFused<2, Stereo>(left, right, frames); break;
+        case 3: processFused<3, Stereo>(left, right, frames); break;
+        case 4: processFused<4, Stereo>(left, right, frames); break;
+        default: fused = 0; break;
+    }
+    static_assert(MAX_FUSED == 4, "processImpl dispatches processFused<1..MAX_FUSED>");
+
+    const int perSection = fused ? 0 : _numActive;
+    for (int k = 0; k < perSection; k++) {
+        int slot = _packedSlot[k];
+        float* c = _current[slot];
+        float* wL = _state[slot][0];
+        float* wR = _state[slot][1];
+
+        if (_slotRamping[slot]) {
+            // Glide toward target this block, interpolating coefficients per sample
+            const float* t = _target[slot];
+            float next[5];
+            float maxDiff = 0.0f;
+            for (int j = 0; j < 5; j++) {
+                next[j] = c[j] + (t[j] - c[j]) * RAMP_ALPHA;
+                maxDiff = std::max(maxDiff, fabsf(t[j] - next[j]));
+            }
+            if (maxDiff < RAMP_EPSILON) {
+                std::memcpy(next, t, sizeof(next));
+            }
+
+            const float inv = 1.0f / static_cast<float>(frames);
+            float b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+            const float db0 = (next[0] - b0) * inv, db1 = (next[1] - b1) * inv, db2 = (next[2] - b2) * inv;
+            const float da1 = (next[3] - a1) * inv, da2 = (next[4] - a2) * inv;
+            float zL1 = wL[0], zL2 = wL[1];
+            float zR1 = wR[0], zR2 = wR[1];
+            for (int i = 0; i < frames; i++) {
+                b0 += db0; b1 += db1; b2 += db2; a1 += da1; a2 += da2;
+                float inL = left[i];
+                float inR = Stereo ? right[i] : 0.0f;  // Dead in mono; the compiler drops the R lane
+#if DSP_KERNELS_USE_DSPS_BIQUAD
+                // DF2, same state layout as dsps_biquad_f32 (w[0] = w[n-1], w[1] = w[n-2])
+                float dL = inL - a1 * zL1 - a2 * zL2;
+                float dR = inR - a1 * zR1 - a2 * zR2;
+                left[i] = b0 * dL + b1 * zL1 + b2 * zL2;
+                if (Stereo) right[i] = b0 * dR + b1 * zR1 + b2 * zR2;
+                zL2 = zL1; zL1 = dL;
+                zR2 = zR1; zR1 = dR;
+#else
+                float outL = b0 * inL + zL1;
+                float outR = b0 * inR + zR1;
+                zL1 = b1 * inL - a1 * outL + zL2;
+                zR1 = b1 * inR - a1 * outR + zR2;
+                zL2 = b2 * inL - a2 * outL;
+                zR2 = b2 * inR - a2 * outR;
+                left[i] = outL;
+                if (Stereo) right[i] = outR;
+#endif
+            }
+            wL[0] = zL1; wL[1] = zL2;
+            if (Stereo) { wR[0] = zR1; wR[1] = zR2; }
+
+            std::memcpy(c, next, sizeof(next));
+            if (std::memcmp(c, t, sizeof(next)) == 0) {
+                _slotRamping[slot] = false;
+                settled = true;
+                if (!_slotEnabled[slot]) {
+                    _slotLive[slot] = false;  // Finished fading out
+                    retired = true;
+                }
+            }
+            continue;
+        }
+
+#if DSP_KERNELS_USE_DSPS_BIQUAD
+        // esp-dsp PIE kernel (DF2, in-place safe), one call per channel
+        dsps_biquad_f32(left, left, frames, c, wL);
+        if (Stereo) dsps_biquad_f32(right, right, frames, c, wR);
+#else
+        // DF2T, both channels in one pass so the coefficients stay in registers
+        const float b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+        float zL1 = wL[0], zL2 = wL[1];
+        float zR1 = wR[0], zR2 = wR[1];
+        for (int i = 0; i < frames; i++) {
+            float inL = left[i];
+            float inR = Stereo ? right[i] : 0.0f;
+            float outL = b0 * inL + zL1;
+            float outR = b0 * inR + zR1;
+            zL1 = b1 * inL - a1 * outL + zL2;
+            zR1 = b1 * inR - a1 * outR + zR2;
+            zL2 = b2 * inL - a2 * outL;
+            zR2 = b2 * inR - a2 * outR;
+            left[i] = outL;
+            if (Stereo) right[i] = outR;
+        }
+        wL[0] = zL1; wL[1] = zL2;
+        if (Stereo) { wR[0] = zR1; wR[1] = zR2; }
+#endif
+    }
+
+    // No flush-to-zero mode on the P4's FPU: a decaying tail would sit in subnormals
+    for (int k = 0; k < _numActive; k++) {
+        float* w = &_state[_packedSlot[k]][0][0];
+        for (int j = 0; j < 4; j++) {
+            if (fabsf(w[j]) < DENORMAL_FLOOR) w[j] = 0.0f;
+        }
+    }
+
+    if (retired || settled) {
+        repack();
+    }
+}
+
+void BiquadCascade::reset()
+{
+    std::memset(_state, 0, sizeof(_state));
+}
+
+void BiquadCascade::takeChannel(const BiquadCascade& src, int srcCh, int dstCh, bool withCoeffs)
+{
+    if (this == &src) return;
+    if (withCoeffs) {
+        std::memcpy(_target, src._target, sizeof(_target));
+        std::memcpy(_current, src._current, sizeof(_current));
+        std::memcpy(_slotEnabled, src._slotEnabled, sizeof(_slotEnabled));
+        std::memcpy(_slotRamping, src._slotRamping, sizeof(_slotRamping));
+        std::memcpy(_slotLive, src._slotLive, sizeof(_slotLive));
+        repack();
+    }
+    for (int slot = 0; slot < MAX_SECTIONS; slot++) {
+        _state[slot][dstCh][0] = src._state[slot][srcCh][0];
+        _state[slot][dstCh][1] = src._state[slot][srcCh][1];
+    }
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Multiband compressor (48kHz, LR4 crossover tree)
+// ─────────────────────────────────────────────────────────────────────────────
+
+void MultibandDynamics::setSplit(int idx, const Biquad& lp, const Biquad& hp, const Biquad& ap)
+{
+    if (idx < 0 || idx >= MAX_BANDS - 1) return;
+    Split& s = _splits[idx];
+    for (int c = 0; c < 2; c++) {
+        s.lp[c][0] = s.lp[c][1] = lp;
+        s.hp[c][0] = s.hp[c][1] = hp;
+        for (auto& a : s.ap[c]) a = ap;
+    }
+    for (int c = 0; c < 2; c++) {
+        for (auto& b : s.lp[c]) b.reset();
+        for (auto& b : s.hp[c]) b.reset();
+        for (auto& b : s.ap[c]) b.reset();
+    }
+}
+
+void MultibandDynamics::setBandCount(int bands)
+{
+    _numBands = std::clamp(bands, 2, MAX_BANDS);
+}
+
+void MultibandDynamics::setBand(int idx, float thresholdDb, float ratio, float attackMs,
+                                             float releaseMs, float makeupDb, float sampleRate)
+{
+    if (idx < 0 || idx >= MAX_BANDS) return;
+    Band& b = _bands[idx];
+    b.threshold = powf(10.0f, thresholdDb / 20.0f);
+    b.slope = 1.0f / std::max(ratio, 1.0f) - 1.0f;
+    b.makeup = powf(10.0f, makeupDb / 20.0f);
+    b.attackCoef = expf(-1.0f / (std::max(attackMs, 0.01f) * 0.001f * sampleRate));
+    b.releaseCoef = expf(-1.0f / (std::max(releaseMs, 1.0f) * 0.001f * sampleRate));
+}
+
+void MultibandDynamics::process(float* left, float* right, int frames)
+{
+    const int splits = _numBands - 1;
+    float* io[2] = {left, right};
+
+    for (int i = 0; i < frames; i++) {
+        // Gain computer: static curve on the envelope, ramped over the next interval
+        if (_phase == 0) {
+            _phase = GAIN_INTERVAL;
+            for (int k = 0; k < _numBands; k++) {
+                Band& b = _bands[k];
+                // Above threshold: gain = (env / threshold)^(1/ratio - 1)
+                float g = b.env > b.threshold ? powf(b.env / b.threshold, b.slope) : 1.0f;
+                b.minGain = std::min(b.minGain, g);
+                b.gainStep = (g * b.makeup - b.gain) * (1.0f / GAIN_INTERVAL);
+            }
+        }
+        _phase--;
+
+        float band[2][MAX_BANDS];
+        for (int c = 0; c < 2; c++) {
+            float rest = io[c][i];
+            for (int s = 0; s < splits; s++) {
+                Split& sp = _splits[s];
+                float lo = sp.lp[c][1].process(sp.lp[c][0].process(rest));
+                rest = sp.hp[c][1].process(sp.hp[c][0].process(rest));
+                for (int k = 0; k < s; k++) band[c][k] = sp.ap[c][k].process(band[c][k]);
+                band[c][s] = lo;
+            }
+            band[c][splits] = rest;
+        }
+
+        float outL = 0.0f, outR = 0.0f;
+        for (int k = 0; k < _numBands; k++) {
+            Band& b = _bands[k];
+            // Stereo-linked peak envelope
+            float level = std::max(fabsf(band[0][k]), fabsf(band[1][k]));
+            float coef = level > b.env ? b.attackCoef : b.releaseCoef;
+            b.env = level + coef * (b.env - level);
+            b.gain += b.gainStep;
+            outL += band[0][k] * b.gain;
+            outR += band[1][k] * b.gain;
+        }
+        left[i] = outL;
+        right[i] = outR;
+    }
+}
+
+void MultibandDynamics::reset()
+{
+    for (auto& s : _splits) {
+        for (int c = 0; c < 2; c++) {
+            for (auto& b : s.lp[c]) b.reset();
+            for (auto& b : s.hp[c]) b.reset();
+            for (auto& b : s.ap[c]) b.reset();
+        }
+    }
+    for (auto& b : _bands) {
+        b.env = 0.0f;
+        b.gain = b.makeup;
+        b.gainStep = 0.0f;
+        b.minGain = 1.0f;
+    }
+    _phase = 0;
+}
+
+float MultibandDynamics::takeGainReductionDb(int band)
+{
+    if (band < 0 || band >= _numBands) return 0.0f;
+    float g = _bands[band].minGain;
+    _bands[band].minGain = 1.0f;
+    return 20.0f * log10f(std::max(g, 1e-5f));
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Audiogram-fitted WDRC filterbank (48kHz, per ear)
+// ─────────────────────────────────────────────────────────────────────────────
+
+namespace {
+
+// Response in dB of an RBJ peaking section at warped frequency omega =
+// tan(w/2) / tan(w0/2); the bilinear transform keeps the analog shape exact
+float peakingDb(float omega, float Q, float gainDb)
+{
+    float A2 = powf(10.0f, gainDb / 20.0f);
+    float p = (1.0f - omega * omega) * (1.0f - omega * omega);
+    float r = omega * omega / (Q * Q);
+    return 10.0f * log10f((p + A2 * r) / (p + r / A2));
+}
+
+// In-place Gauss-Jordan inverse of an n x n matrix (row stride MAX), false if singular
+template <int MAX>
+bool invertMatrix(float (*m)[MAX], float (*inv)[MAX], int n)
+{
+    for (int r = 0; r < n; r++) {
+        for (int c = 0; c < n; c++) inv[r][c] = r == c ? 1.0f : 0.0f;
+    }
+    for (int col = 0; col < n; col++) {
+        int pivot = col;
+        for (int r = col + 1; r < n; r++) {
+            if (fabsf(m[r][col]) > fabsf(m[pivot][col])) pivot = r;
+        }
+        if (fabsf(m[pivot][col]) < 1e-9f) return false;
+        for (int c = 0; c < n; c++) {
+            std::swap(m[col][c], m[pivot][c]);
+            std::swap(inv[col][c], inv[pivot][c]);
+        }
+        float scale = 1.0f / m[col][col];
+        for (int c = 0; c < n; c++) {
+            m[col][c] *= scale;
+            inv[col][c] *= scale;
+        }
+        for (int r = 0; r < n; r++) {
+            if (r == col || m[r][col] == 0.0f) continue;
+            float f = m[r][col];
+            for (int c = 0; c < n; c++) {
+                m[r][c] -= f * m[col][c];
+                inv[r][c] -= f * inv[col][c];
+            }
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+void WdrcFilterbank::setLayout(int bands, float loHz, float hiHz, float sampleRate)
+{
+    _numBands = std::clamp(bands, 2, MAX_BANDS);
+    // Centres are log-spaced in the bilinear-warped domain, so every section
+    // has the same shape relative to its neighbours (slightly tighter than
+    // geometric near the top band)
+    const float tanLo = tanf(M_PI * loHz / sampleRate);
+    const float tanHi = tanf(M_PI * hiHz / sampleRate);
+    const float ratio = powf(tanHi / tanLo, 1.0f / (_numBands - 1));
+    // Sections twice as wide as the spacing keep the ripple between centres low
+    const float Q = 0.5f * sqrtf(ratio) / (ratio - 1.0f);
+
+    for (int k = 0; k < _numBands; k++) {
+        float w0 = 2.0f * atanf(tanLo * powf(ratio, static_cast<float>(k)));
+        _centerHz[k] = w0 * sampleRate / (2.0f * M_PI);
+        _cosw0[k] = cosf(w0);
+        _alpha[k] = sinf(w0) / (2.0f * Q);
+
+        float a0 = 1.0f + _alpha[k];
+        Biquad bp;
+        bp.b0 = _alpha[k] / a0;
+        bp.b1 = 0.0f;
+        bp.b2 = -_alpha[k] / a0;
+        bp.a1 = (-2.0f * _cosw0[k]) / a0;
+        bp.a2 = (1.0f - _alpha[k]) / a0;
+        for (auto& ear : _bands) ear[k].detect = bp;
+    }
+
+    // Spread table: response d bands away per dB of section gain, at each
+    // gain step (a cut mirrors a boost)
+    for (int d = 0; d < _numBands; d++) {
+        float omega = powf(ratio, static_cast<float>(d));
+        for (int i = 0; i < SPREAD_STEPS; i++) {
+            float g = std::max(i * SPREAD_STEP_DB, 0.5f);
+            _spread[d][i] = peakingDb(omega, Q, g) / g;
+        }
+    }
+
+    // Interaction matrix at REF_DB and its inverse for the first guess
+    constexpr float REF_DB = 18.0f;
+    float m[MAX_BANDS][MAX_BANDS];
+    for (int j = 0; j < _numBands; j++) {
+        for (int k = 0; k < _numBands; k++) {
+            m[j][k] = peakingDb(powf(ratio, static_cast<float>(j > k ? j - k : k - j)), Q, REF_DB) / REF_DB;
+        }
+    }
+    if (!invertMatrix<MAX_BANDS>(m, _inverse, _numBands)) {
+        for (int j = 0; j < _numBands; j++) {
+            for (int k = 0; k < _numBands; k++) _inverse[j][k] = j == k ? 1.0f : 0.0f;
+        }
+    }
+    reset();
+}
+
+void WdrcFilterbank::setCurve(int ear, int band, float kneeDbfs, float gainDb, float ratio,
+                                           float maxGainDb)
+{
+    if (ear < 0 || ear > 1 || band < 0 || band >= MAX_BANDS) return;
+    Band& b = _bands[ear][band];
+    b.kneeDb = kneeDbfs;
+    b.gainDb = gainDb;
+    b.slope = 1.0f - 1.0f / std::max(ratio, 1.0f);
+    b.maxGainDb = maxGainDb;
+}
+
+void WdrcFilterbank::setTiming(float attackMs, float releaseMs, float sampleRate)
+{
+    _attackCoef = expf(-1.0f / (std::max(attackMs, 0.1f) * 0.001f * sampleRate));
+    _releaseCoef = expf(-1.0f / (std::max(releaseMs, 1.0f) * 0.001f * sampleRate));
+}
+
+// RBJ peaking section at the band's cached centre; only A depends on the gain
+void WdrcFilterbank::setShapeGain(Band& b, int band, float gainDb)
+{
+    float A = powf(10.0f, gainDb / 40.0f);
+    float alpha = _alpha[band];
+    float inv = 1.0f / (1.0f + alpha / A);
+    b.shape.b0 = (1.0f + alpha * A) * inv;
+    b.shape.b1 = (-2.0f * _cosw0[band]) * inv;
+    b.shape.b2 = (1.0f - alpha * A) * inv;
+    b.shape.a1 = b.shape.b1;
+    b.shape.a2 = (1.0f - alpha / A) * inv;
+    b.appliedDb = gainDb;
+}
+
+void WdrcFilterbank::updateGains()
+{
+    for (int e = 0; e < 2; e++) {
+        float target[MAX_BANDS];
+        float sum = 0.0f;
+        for (int k = 0; k < _numBands; k++) {
+            const Band& b = _bands[e][k];
+            float levelDb = 20.0f * log10f(std::max(b.env, 1e-6f));
+            float g = b.gainDb - b.slope * std::max(levelDb - b.kneeDb, 0.0f);
+            target[k] = std::clamp(g, 0.0f, b.maxGainDb);
+            sum += target[k];
+        }
+        _gainSum[e] += sum / _numBands;
+
+        // First guess through the inverse interaction matrix, then
+        // REFINE_PASSES corrections: predict the cascade at the band centres
+        // from the spread table and send the residual back through the inverse
+        float g[MAX_BANDS];
+        for (int k = 0; k < _numBands; k++) {
+            float sum = 0.0f;
+            for (int j = 0; j < _numBands; j++) sum += _inverse[k][j] * target[j];
+            g[k] = std::clamp(sum, -_bands[e][k].maxGainDb, _bands[e][k].maxGainDb);
+        }
+        for (int pass = 0; pass < REFINE_PASSES; pass++) {
+            float perDb[MAX_BANDS][2];  // Spread row and interpolation weight per section
+            int step[MAX_BANDS];
+            for (int k = 0; k < _numBands; k++) {
+                float pos = fabsf(g[k]) * (1.0f / SPREAD_STEP_DB);
+                step[k] = std::min(static_cast<int>(pos), SPREAD_STEPS - 2);
+                perDb[k][1] = std::min(pos - step[k], 1.0f);
+                perDb[k][0] = 1.0f - perDb[k][1];
+            }
+            float resid[MAX_BANDS];
+            for (int j = 0; j < _numBands; j++) {
+                float y = 0.0f;
+                for (int k = 0; k < _numBands; k++) {
+                    const float* r = _spread[j > k ? j - k : k - j] + step[k];
+                    y += g[k] * (perDb[k][0] * r[0] + perDb[k][1] * r[1]);
+                }
+                resid[j] = target[j] - y;
+            }
+            for (int k = 0; k < _numBands; k++) {
+                float sum = g[k];
+                for (int j = 0; j < _numBands; j++) sum += _inverse[k][j] * resid[j];
+                g[k] = std::clamp(sum, -_bands[e][k].maxGainDb, _bands[e][k].maxGainDb);
+            }
+        }
+
+        for (int k = 0; k < _numBands; k++) {
+            Band& b = _bands[e][k];
+            // Skip inaudible steps: the coefficient update is the expensive part
+            if (fabsf(g[k] - b.appliedDb) > 0.05f) setShapeGain(b, k, g[k]);
+        }
+    }
+    _gainCount++;
+}
+
+void WdrcFilterbank::process(float* left, float* right, int frames)
+{
+    float* io[2] = {left, right};
+    int done = 0;
+    while (done < frames) {
+        if (_phase == 0) {
+            _phase = GAIN_INTERVAL;
+            updateGains();
+        }
+        // Runs of up to GAIN_INTERVAL samples, one biquad at a time
+        const int n = std::min(_phase, frames - done);
+        for (int e = 0; e < 2; e++) {
+            float* x = io[e] + done;
+            for (int k = 0; k < _numBands; k++) {
+                Band& b = _bands[e][k];
+                float env = b.env;
+                for (int i = 0; i < n; i++) {
+                    float level = fabsf(b.detect.process(x[i]));
+                    env = level + (level > env ? _attackCoef : _releaseCoef) * (env - level);
+                }
+                b.env = env;
+            }
+            for (int k = 0; k < _numBands; k++) {
+                Biquad& sh = _bands[e][k].shape;
+                for (int i = 0; i < n; i++) x[i] = sh.process(x[i]);
+            }
+        }
+        _phase -= n;
+        done += n;
+    }
+}
+
+void WdrcFilterbank::reset()
+{
+    for (auto& ear : _bands) {
+        for (int k = 0; k < MAX_BANDS; k++) {
+            Band& b = ear[k];
+            b.detect.reset();
+            b.shape.reset();
+            b.env = 0.0f;
+            if (k < _numBands) setShapeGain(b, k, 0.0f);
+        }
+    }
+    _gainSum[0] = _gainSum[1] = 0.0f;
+    _gainCount = 0;
+    _phase = 0;
+}
+
+void WdrcFilterbank::takeMeanGainDb(float* gainDb)
+{
+    for (int e = 0; e < 2; e++) {
+        gainDb[e] = _gainCount > 0 ? _gainSum[e] / _gainCount : 0.0f;
+        _gainSum[e] = 0.0f;
+    }
+    _gainCount = 0;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Hearing-loss fitting
+// ─────────────────────────────────────────────────────────────────────────────
+
+WdrcFit fitWdrcBand(float hlDb, float maxGainDb)
+{
+    float soft = std::clamp(0.6f * hlDb, 0.0f, maxGainDb);
+    float loud = std::clamp(0.3f * hlDb, 0.0f, soft);
+    float ratio = 30.0f / (30.0f - std::min(soft - loud, 20.0f));
+    return {soft, ratio};
+}
+
+float audiogramAt(const float* f, const float* hlDb, int n, float hz)
+{
+    if (hz <= f[0]) return hlDb[0];
+    for (int i = 1; i < n; i++) {
+        if (hz <= f[i]) {
+            float t = log2f(hz / f[i - 1]) / log2f(f[i] / f[i - 1]);
+            return hlDb[i - 1] + t * (hlDb[i] - hlDb[i - 1]);
+        }
+    }
+    return hlDb[n - 1];
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Coefficient calculations (Audio EQ Cookbook - Robert Bristow-Johnson)
+// ─────────────────────────────────────────────────────────────────────────────
+
+namespace {
+
+// Compile-time Taylor series for the tables below (arguments well inside +-1)
+constexpr double ctExp(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int n = 1; n < 24; n++) {
+        term *= x / n;
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr void ctSinCos(double x, double& s, double& c)
+{
+    double ts = x, tc = 1.0;
+    s = ts;
+    c = tc;
+    for (int n = 1; n < 12; n++) {
+        ts *= -x * x / ((2 * n) * (2 * n + 1));
+        tc *= -x * x / ((2 * n - 1) * (2 * n));
+        s += ts;
+        c += tc;
+    }
+}
+
+// sqrt of linear gain, 10^(dB / 40), on the sliders' 0.1 dB grid over +-12 dB
+constexpr int GAIN_GRID_PER_DB = 10;
+constexpr int GAIN_GRID_RANGE_DB = 12;
+constexpr int GAIN_GRID_STEPS = 2 * GAIN_GRID_RANGE_DB * GAIN_GRID_PER_DB + 1;
+
+struct GainSqrtTable {
+    float a[GAIN_GRID_STEPS] = {};
+};
+
+constexpr GainSqrtTable makeGainSqrtTable()
+{
+    constexpr double LN10 = 2.302585092994046;
+    GainSqrtTable t;
+    for (int k = 0; k < GAIN_GRID_STEPS; k++) {
+        const double db = static_cast<double>(k - GAIN_GRID_RANGE_DB * GAIN_GRID_PER_DB) / GAIN_GRID_PER_DB;
+        t.a[k] = static_cast<float>(ctExp(db / 40.0 * LN10));
+    }
+    return t;
+}
+
+constexpr GainSqrtTable kGainSqrt = makeGainSqrtTable();
+
+inline float gainSqrt(float gainDb)
+{
+    const float pos = (gainDb + GAIN_GRID_RANGE_DB) * GAIN_GRID_PER_DB;
+    const int k = static_cast<int>(lrintf(pos));
+    if (k >= 0 && k < GAIN_GRID_STEPS && fabsf(pos - k) < 1e-3f) return kGainSqrt.a[k];
+    return powf(10.0f, gainDb / 40.0f);
+}
+
+// sin / cos of the normalized frequency, polynomial instead of libm (|error| < 3e-5,
+// and relative to w0 near DC, so low corner frequencies keep their accuracy). Corners
+// past Nyquist (a 20kHz LPF at 32kHz) sit just under it instead of aliasing down
+inline void w0SinCos(float freq, float sampleRate, float& sinw0, float& cosw0)
+{
+    fastSinCos(2.0f * static_cast<float>(M_PI) * std::min(freq, 0.49f * sampleRate) / sampleRate, sinw0, cosw0);
+}
+
+}  // namespace
+
+void calcHpfCoeffs(Biquad& bq, float freq, float sampleRate)
+{
+    float sinw0, cosw0;
+    w0SinCos(freq, sampleRate, sinw0, cosw0);
+    float alpha = sinw0 / (2.0f * 0.7071f);  // Q = 0.7071 (Butterworth)
+
+    float a0 = 1.0f + alpha;
+    bq.b0 = ((1.0f + cosw0) / 2.0f) / a0;
+    bq.b1 = (-(1.0f + cosw0)) / a0;
+    bq.b2 = ((1.0f + cosw0) / 2.0f) / a0;
+    bq.a1 = (-2.0f * cosw0) / a0;
+    bq.a2 = (1.0f - alpha) / a0;
+}
+
+void calcLpfCoeffs(Biquad& bq, float freq, float sampleRate)
+{
+    float sinw0, cosw0;
+    w0SinCos(freq, sampleRate, sinw0, cosw0);
+    float alpha = sinw0 / (2.0f * 0.7071f);  // Q = 0.7071 (Butterworth)
+
+    float a0 = 1.0f + alpha;
+    bq.b0 = ((1.0f - cosw0) / 2.0f) / a0;
+    bq.b1 = (1.0f - cosw0) / a0;
+    bq.b2 = ((1.0f - cosw0) / 2.0f) / a0;
+    bq.a1 = (-2.0f * cosw0) / a0;
+    bq.a2 = (1.0f - alpha) / a0;
+}
+
+void calcPeakEqCoeffs(Biquad& bq, float freq, float gainDb, float Q, float sampleRate)
+{
+    if (fabsf(gainDb) < 0.1f) {
+        // Unity gain - bypass
+        bq.b0 = 1.0f; bq.b1 = 0.0f; bq.b2 = 0.0f;
+        bq.a1 = 0.0f; bq.a2 = 0.0f;
+        return;
+    }
+
+    float sinw0, cosw0;
+    w0SinCos(freq, sampleRate, sinw0, cosw0);
+    calcPeakEqFromTrig(bq, gainSqrt(gainDb), cosw0, sinw0 / (2.0f * Q));
+}
+
+void calcPeakEqFromTrig(Biquad& bq, float A, float cosw0, float alpha)
+{
+    const float inv = 1.0f / (1.0f + alpha / A);
+    bq.b0 = (1.0f + alpha * A) * inv;
+    bq.b1 = -2.0f * cosw0 * inv;
+    bq.b2 = (1.0f - alpha * A) * inv;
+    bq.a1 = bq.b1;
+    bq.a2 = (1.0f - alpha / A) * inv;
+}
+
+void calcFixedEqCoeffs(Biquad& bq, int band, float gainDb, float sampleRate)
+{
+    struct BandTrig {
+        float cosw0, alpha;
+    };
+    struct BandTable {
+        BandTrig band[EQ_BANDS] = {};
+    };
+    static constexpr BandTable kBands = [] {
+        BandTable t;
+        for (int b = 0; b < EQ_BANDS; b++) {
+            double s = 0.0, c = 0.0;
+            ctSinCos(2.0 * M_PI * EQ_BAND_HZ[b] / FIXED_EQ_RATE, s, c);
+            t.band[b] = {static_cast<float>(c), static_cast<float>(s / (2.0 * EQ_BAND_Q))};
+        }
+        return t;
+    }();
+
+    if (sampleRate != FIXED_EQ_RATE) {
+        calcPeakEqCoeffs(bq, EQ_BAND_HZ[band], gainDb, EQ_BAND_Q, sampleRate);
+        return;
+    }
+    if (fabsf(gainDb) < 0.1f) {
+        bq.b0 = 1.0f; bq.b1 = 0.0f; bq.b2 = 0.0f;
+        bq.a1 = 0.0f; bq.a2 = 0.0f;
+        return;
+    }
+    const BandTrig& t = kBands.band[band];
+    calcPeakEqFromTrig(bq, gainSqrt(gainDb), t.cosw0, t.alpha);
+}
+
+// Notch filter coefficients (Audio EQ Cookbook - notch/band-stop)
+void calcNotchCoeffs(Biquad& bq, float freq, float Q, float sampleRate)
+{
+    float sinw0, cosw0;
+    w0SinCos(freq, sampleRate, sinw0, cosw0);
+    float alpha = sinw0 / (2.0f * Q);
+
+    float a0 = 1.0f + alpha;
+    bq.b0 = 1.0f / a0;
+    bq.b1 = (-2.0f * cosw0) / a0;
+    bq.b2 = 1.0f / a0;
+    bq.a1 = (-2.0f * cosw0) / a0;
+    bq.a2 = (1.0f - alpha) / a0;
+}
+
+// High-shelf filter coefficients (Audio EQ Cookbook)
+void calcHighShelfCoeffs(Biquad& bq, float freq, float gainDb, float sampleRate)
+{
+    if (fabsf(gainDb) < 0.1f) {
+        // Unity gain - bypass
+        bq.b0 = 1.0f; bq.b1 = 0.0f; bq.b2 = 0.0f;
+        bq.a1 = 0.0f; bq.a2 = 0.0f;
+        return;
+    }
+
+    float A = gainSqrt(gainDb);
+    float sinw0, cosw0;
+    w0SinCos(freq, sampleRate, sinw0, cosw0);
+    float S = 1.0f;  // Shelf slope
+    float alpha = sinw0 / 2.0f * sqrtf((A + 1.0f/A) * (1.0f/S - 1.0f) + 2.0f);
+    float sqrtA2alpha = 2.0f * sqrtf(A) * alpha;
+
+    float a0 = (A + 1.0f) - (A - 1.0f) * cosw0 + sqrtA2alpha;
+    bq.b0 = (A * ((A + 1.0f) + (A - 1.0f) * cosw0 + sqrtA2alpha)) / a0;
+    bq.b1 = (-2.0f * A * ((A - 1.0f) + (A + 1.0f) * cosw0)) / a0;
+    bq.b2 = (A * ((A + 1.0f) + (A - 1.0f) * cosw0 - sqrtA2alpha)) / a0;
+    bq.a1 = (2.0f * ((A - 1.0f) - (A + 1.0f) * cosw0)) / a0;
+    bq.a2 = ((A + 1.0f) - (A - 1.0f) * cosw0 - sqrtA2alpha) / a0;
+}
+
+// 2nd-order allpass (Audio EQ Cookbook); with Q = 0.7071 it matches an LR4 LP+HP pair
+void calcAllpassCoeffs(Biquad& bq, float freq, float sampleRate)
+{
+    float sinw0, cosw0;
+    w0SinCos(freq, sampleRate, sinw0, cosw0);
+    float alpha = sinw0 / (2.0f * 0.7071f);
+
+    float a0 = 1.0f + alpha;
+    bq.b0 = (1.0f - alpha) / a0;
+    bq.b1 = (-2.0f * cosw0) / a0;
+    bq.b2 = 1.0f;
+    bq.a1 = (-2.0f * cosw0) / a0;
+    bq.a2 = (1.0f - alpha) / a0;
+}
+
+// A-weighting (IEC 61672) as three bilinear sections: four zeros at DC, poles at
+// 20.6Hz (double), 107.7Hz, 737.9Hz and 12.2kHz (double), each prewarped, then
+// scaled to 0dB at 1kHz. K-weighting (BS.1770) is the standard's 48kHz shelf and
+// high-pass, whose constants only hold at that rate: elsewhere A stands in. Below
+// 48kHz the top pole is held under Nyquist.
+int calcWeightingCoeffs(Biquad* bq, int weighting, float sampleRate)
+{
+    if (weighting == 1 && sampleRate == K_WEIGHTING_RATE) {
+        bq[0].b0 = 1.53512485958697f; bq[0].b1 = -2.69169618940638f; bq[0].b2 = 1.19839281085285f;
+        bq[0].a1 = -1.69065929318241f; bq[0].a2 = 0.73248077421585f;
+        bq[1].b0 = 1.0f; bq[1].b1 = -2.0f; bq[1].b2 = 1.0f;
+        bq[1].a1 = -1.99004745483398f; bq[1].a2 = 0.99007225036621f;
+        return 2;
+    }
+
+    const double k = 2.0 * sampleRate;
+    auto warp = [&](double hz) { return k * tan(M_PI * hz / sampleRate); };
+    const double p1 = warp(20.598997), p2 = warp(107.65265), p3 = warp(737.86223), p4 = warp(std::min(12194.217, 0.45 * sampleRate));
+    // (s + p) -> ((k + p) - (k - p) z^-1) / (1 + z^-1); s -> k (1 - z^-1) / (1 + z^-1)
+    auto section = [&](Biquad& b, double p, double q, bool highPass) {
+        const double a0 = (k + p) * (k + q);
+        const double n = highPass ? k * k : 1.0;
+        const double sign = highPass ? -1.0 : 1.0;
+        b.b0 = static_cast<float>(n / a0);
+        b.b1 = static_cast<float>(2.0 * sign * n / a0);
+        b.b2 = static_cast<float>(n / a0);
+        b.a1 = static_cast<float>(-((k - p) * (k + q) + (k + p) * (k - q)) / a0);
+        b.a2 = static_cast<float>((k - p) * (k - q) / a0);
+    };
+    section(bq[0], p1, p1, true);
+    section(bq[1], p2, p3, true);
+    section(bq[2], p4, p4, false);
+
+    // Unity at 1kHz
+    const double w = 2.0 * M_PI * 1000.0 / sampleRate;
+    double mag = 1.0;
+    for (int i = 0; i < 3; i++) {
+        const double c1 = cos(w), s1 = sin(w), c2 = cos(2.0 * w), s2 = sin(2.0 * w);
+        const double nr = bq[i].b0 + bq[i].b1 * c1 + bq[i].b2 * c2, ni = -(bq[i].b1 * s1 + bq[i].b2 * s2);
+        const double dr = 1.0 + bq[i].a1 * c1 + bq[i].a2 * c2, di = -(bq[i].a1 * s1 + bq[i].a2 * s2);
+        mag *= sqrt((nr * nr + ni * ni) / (dr * dr + di * di));
+    }
+    const float norm = static_cast<float>(1.0 / mag);
+    bq[2].b0 *= norm;
+    bq[2].b1 *= norm;
+    bq[2].b2 *= norm;
+    return 3;
+}
@@ -0,0 +1,349 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// The 48kHz DSP kernels AudioEngine runs that need nothing from the SDK: biquads
+// and their coefficients, the multiband compressor, the audiogram-fitted WDRC,
+// the look-ahead limiter and the output stage. The desktop's HostChain runs the
+// same sources. Where esp-dsp is built with its PIE kernels (ESP32-P4), steady
+// biquad sections go through dsps_biquad_f32; elsewhere the code is plain C++.
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Biquads, the multiband compressor and the WDRC filterbank
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Biquad filter (Direct Form II Transposed)
+struct Biquad {
+    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f;
+    float a1 = 0.0f, a2 = 0.0f;
+    float z1 = 0.0f, z2 = 0.0f;
+
+    float process(float in);
+    void reset();
+};
+
+// Stereo biquad cascade: coefficients shared by L/R, state per channel.
+// Sections sit in fixed slots so their state survives re-packing; only
+// enabled (or still fading out) sections are in the active list. In the
+// steady state, up to MAX_FUSED of them run in one pass per sample through
+// a kernel compiled for that section count (what the HPF / LPF / EQ or
+// notch / HF-shelf settings add up to), coefficients and state in locals;
+// otherwise each runs over the whole block (L and R fused).
+//
+// Coefficient changes are not applied instantly: each block the live
+// coefficients glide toward the target and are linearly interpolated
+// per sample, so slider drags don't zipper. Sections fade in from and
+// out to identity. The stable (a1, a2) region is convex, so every
+// interpolated section is stable as long as both endpoints are.
+struct BiquadCascade {
+    static constexpr int MAX_SECTIONS = 8;
+    static constexpr int MAX_FUSED = 4;            // Largest section count with a fused kernel
+    static constexpr float RAMP_ALPHA = 0.35f;     // Per-block glide (~25ms to settle)
+    static constexpr float RAMP_EPSILON = 1e-6f;   // Snap to target below this
+    static constexpr float DENORMAL_FLOOR = 1e-20f; // State flushed to zero below this (-400 dB)
+
+    // Update a slot's target coefficients from bq (state in bq is ignored)
+    void setSection(int slot, const Biquad& bq, bool enabled);
+    void process(float* left, float* right, int frames);  // right may be nullptr (mono)
+    void reset();
+    int activeCount() const { return _numActive; }
+    // Carry on src's channel srcCh in channel dstCh here, so a lane moving between
+    // cascades keeps its history; withCoeffs also takes src's sections and glides
+    void takeChannel(const BiquadCascade& src, int srcCh, int dstCh, bool withCoeffs);
+
+private:
+    template <bool Stereo>
+    void processImpl(float* left, float* right, int frames);
+    template <int N, bool Stereo>
+    void processFused(float* left, float* right, int frames);
+    void repack();
+
+    float _target[MAX_SECTIONS][5] = {};         // b0, b1, b2, a1, a2
+    float _current[MAX_SECTIONS][5] = {};        // Live (interpolated) coefficients
+    bool _slotEnabled[MAX_SECTIONS] = {};
+    bool _slotRamping[MAX_SECTIONS] = {};
+    bool _slotLive[MAX_SECTIONS] = {};           // Enabled or still fading out
+    float _state[MAX_SECTIONS][2][2] = {};       // [slot][channel][2]
+    int _packedSlot[MAX_SECTIONS] = {};
+    int _numActive = 0;
+    int _numRamping = 0;                         // Active sections still gliding
+};
+
+// 48kHz multiband compressor. The crossover is a tree of Linkwitz-Riley
+// (LR4 = two Butterworth Biquads) splits; every band already split off
+// passes the later splits' 2nd-order allpass, so the bands sum back flat
+// in magnitude. Each band has a stereo-linked envelope and its gain is
+// recomputed every GAIN_INTERVAL samples and ramped in between.
+struct MultibandDynamics {
+    static constexpr int MAX_BANDS = 4;
+    static constexpr int GAIN_INTERVAL = 16;
+
+    // Split idx coefficients (low-pass, high-pass and the matching allpass); resets state
+    void setSplit(int idx, const Biquad& lp, const Biquad& hp, const Biquad& ap);
+    void setBandCount(int bands);
+    void setBand(int idx, float thresholdDb, float ratio, float attackMs, float releaseMs,
+                 float makeupDb, float sampleRate);
+    void process(float* left, float* right, int frames);
+    void reset();
+    // Deepest gain reduction since the last call (dB, <= 0)
+    float takeGainReductionDb(int band);
+
+private:
+    struct Split {
+        Biquad lp[2][2], hp[2][2];        // [channel][LR4 stage]
+        Biquad ap[2][MAX_BANDS - 1];      // [channel][earlier band]
+    };
+    struct Band {
+        float threshold = 1.0f;           // Linear envelope level where compression starts
+        float slope = 0.0f;               // 1/ratio - 1
+        float makeup = 1.0f;
+        float attackCoef = 0.0f, releaseCoef = 0.0f;
+        float env = 0.0f;
+        float gain = 1.0f, gainStep = 0.0f;
+        float minGain = 1.0f;
+    };
+    Split _splits[MAX_BANDS - 1];
+    Band _bands[MAX_BANDS];
+    int _numBands = 3;
+    int _phase = 0;  // Samples until the next gain update
+};
+
+// Audiogram-fitted wide dynamic range compression, one channel per ear.
+// Each of the N log-spaced bands reads its level from a bandpass side
+// chain on the input and applies its gain with a peaking section in the
+// signal path, so there is no crossover to sum and the cost is two biquads
+// per band and ear. Neighbouring peaking sections overlap; the requested
+// band gains go through the inverse of their interaction matrix, then
+// gain-dependent refinement passes, so the cascade hits them at the band
+// centres. Gains update every GAIN_INTERVAL samples.
+struct WdrcFilterbank {
+    static constexpr int MAX_BANDS = 16;
+    static constexpr int GAIN_INTERVAL = 32;
+    static constexpr int SPREAD_STEPS = 31;          // Gain steps of the spread table (0-60 dB)
+    static constexpr float SPREAD_STEP_DB = 2.0f;
+    static constexpr int REFINE_PASSES = 2;
+
+    // Log-spaced band layout from loHz to hiHz; resets state
+    void setLayout(int bands, float loHz, float hiHz, float sampleRate);
+    int bandCount() const { return _numBands; }
+    float centerHz(int band) const { return _centerHz[band]; }
+    // Static curve: gainDb up to kneeDbfs, (1 - 1/ratio) dB less per dB
+    // above, held within 0..maxGainDb
+    void setCurve(int ear, int band, float kneeDbfs, float gainDb, float ratio, float maxGainDb);
+    void setTiming(float attackMs, float releaseMs, float sampleRate);
+    void process(float* left, float* right, int frames);
+    void reset();
+    // Mean requested band gain per ear since the last call (dB, [0]=left)
+    void takeMeanGainDb(float* gainDb);
+
+private:
+    struct Band {
+        Biquad detect;            // Unity-peak bandpass side chain
+        Biquad shape;             // Peaking section carrying the band gain
+        float kneeDb = 0.0f, gainDb = 0.0f, slope = 0.0f, maxGainDb = 0.0f;
+        float env = 0.0f;
+        float appliedDb = 0.0f;   // Gain currently in the shape coefficients
+    };
+    void setShapeGain(Band& b, int band, float gainDb);
+    void updateGains();
+
+    Band _bands[2][MAX_BANDS];
+    float _centerHz[MAX_BANDS] = {};
+    float _cosw0[MAX_BANDS] = {}, _alpha[MAX_BANDS] = {};
+    float _inverse[MAX_BANDS][MAX_BANDS] = {};  // Interaction matrix inverse (per dB)
+    float _spread[MAX_BANDS][SPREAD_STEPS] = {}; // Response d bands away per dB, by gain step
+    float _attackCoef = 0.0f, _releaseCoef = 0.0f;
+    float _gainSum[2] = {};
+    int _gainCount = 0;
+    int _numBands = 0;
+    int _phase = 0;  // Samples until the next gain update
+};
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Coefficient calculations (Audio EQ Cookbook - Robert Bristow-Johnson)
+// ─────────────────────────────────────────────────────────────────────────────
+
+void calcHpfCoeffs(Biquad& bq, float freq, float sampleRate);
+void calcLpfCoeffs(Biquad& bq, float freq, float sampleRate);
+void calcPeakEqCoeffs(Biquad& bq, float freq, float gainDb, float Q, float sampleRate);
+// Peaking section from a centre's cos(w0) and alpha and the gain's A = 10^(dB / 40)
+void calcPeakEqFromTrig(Biquad& bq, float A, float cosw0, float alpha);
+// One of the fixed EQ bands, from tables built at compile time for FIXED_EQ_RATE (other rates compute it)
+constexpr int EQ_BANDS = 3;
+constexpr float EQ_BAND_HZ[EQ_BANDS] = {250.0f, 1000.0f, 4000.0f};
+constexpr float EQ_BAND_Q = 1.4f;
+constexpr int FIXED_EQ_RATE = 48000;
+void calcFixedEqCoeffs(Biquad& bq, int band, float gainDb, float sampleRate);
+void calcNotchCoeffs(Biquad& bq, float freq, float Q, float sampleRate);
+void calcHighShelfCoeffs(Biquad& bq, float freq, float gainDb, float sampleRate);
+void calcAllpassCoeffs(Biquad& bq, float freq, float sampleRate);
+// Level weighting (AudioEngineParams::doseWeighting) into bq[0..]; returns the sections used
+int calcWeightingCoeffs(Biquad* bq, int weighting, float sampleRate);
+
+// x in [-pi, pi]; |error| < 3e-5
+inline void fastSinCos(float x, float& s, float& c)
+{
+    // Fold into [-pi/2, pi/2], where cos >= 0
+    constexpr float HALF_PI = 0.5f * static_cast<float>(M_PI);
+    float sign = 1.0f;
+    if (x > HALF_PI) {
+        x = static_cast<float>(M_PI) - x;
+        sign = -1.0f;
+    } else if (x < -HALF_PI) {
+        x = -static_cast<float>(M_PI) - x;
+        sign = -1.0f;
+    }
+    float x2 = x * x;
+    s = x * (1.0f + x2 * (-1.6666667e-1f + x2 * (8.3333310e-3f + x2 * (-1.9840874e-4f + x2 * 2.7525562e-6f))));
+    c = sign * (1.0f + x2 * (-0.5f + x2 * (4.1666638e-2f + x2 * (-1.3888378e-3f + x2 * 2.4760495e-5f))));
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Hearing-loss fitting: WdrcFilterbank band curves from an audiogram
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Starting fit in the half-gain family, meant to be fine-tuned by ear: soft
+// input (the 50 dB SPL knee) gets 0.6 x HL, loud input (80 dB SPL) 0.3 x HL,
+// which sets the ratio over those 30 dB (at most 3:1)
+constexpr float WDRC_KNEE_SPL = 50.0f;
+
+struct WdrcFit {
+    float gainDb;
+    float ratio;
+};
+
+WdrcFit fitWdrcBand(float hlDb, float maxGainDb);
+// Audiogram threshold at hz from count (freqsHz, hlDb) points, linear in log
+// frequency, held flat past the ends
+float audiogramAt(const float* freqsHz, const float* hlDb, int count, float hz);
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Look-ahead brickwall limiter (final output, stereo-linked)
+//
+// The signal is delayed by LOOKAHEAD samples. Each incoming peak that would
+// exceed the ceiling sets a gain target, reached with a linear ramp exactly
+// by the time that peak leaves the delay line; the gain then holds for one
+// look-ahead and releases exponentially. A final clamp at the ceiling catches
+// whatever the ramp leaves, so the output never exceeds it.
+// ─────────────────────────────────────────────────────────────────────────────
+
+class LookaheadLimiter {
+public:
+    static constexpr int LOOKAHEAD = 64;  // 1.33ms @ 48kHz
+
+    void configure(float ceilingDb, float releaseMs, float sampleRate)
+    {
+        _ceiling = powf(10.0f, ceilingDb / 20.0f);
+        _releaseCoef = expf(-1.0f / (std::max(releaseMs, 1.0f) * 0.001f * sampleRate));
+    }
+
+    void reset()
+    {
+        std::memset(_delayL, 0, sizeof(_delayL));
+        std::memset(_delayR, 0, sizeof(_delayR));
+        _pos = 0;
+        _gain = _target = 1.0f;
+        _step = 0.0f;
+        _hold = 0;
+    }
+
+    // Applies inputGain, then limits in place. Returns the deepest gain this block (linear).
+    float process(float* left, float* right, int frames, float inputGain)
+    {
+        float minGain = 1.0f;
+        for (int i = 0; i < frames; i++) {
+            float inL = left[i] * inputGain;
+            float inR = right[i] * inputGain;
+
+            float peak = std::max(fabsf(inL), fabsf(inR));
+            if (peak > _ceiling) {
+                float req = _ceiling / peak;
+                if (req < _target) {
+                    _target = req;
+                    // Never ramp slower than a pending, earlier peak needs
+                    _step = std::max(_step, (_gain - req) * (1.0f / LOOKAHEAD));
+                }
+                _hold = LOOKAHEAD;
+            }
+
+            if (_gain > _target) {
+                _gain = std::max(_target, _gain - _step);
+            } else if (_hold > 0) {
+                _hold--;
+            } else {
+                _target = 1.0f;
+                _step = 0.0f;
+                _gain = 1.0f - (1.0f - _gain) * _releaseCoef;
+            }
+            minGain = std::min(minGain, _gain);
+
+            float outL = _delayL[_pos] * _gain;
+            float outR = _delayR[_pos] * _gain;
+            _delayL[_pos] = inL;
+            _delayR[_pos] = inR;
+            if (++_pos == LOOKAHEAD) _pos = 0;
+            left[i] = std::clamp(outL, -_ceiling, _ceiling);
+            right[i] = std::clamp(outR, -_ceiling, _ceiling);
+        }
+        return minGain;
+    }
+
+private:
+    float _delayL[LOOKAHEAD] = {};
+    float _delayR[LOOKAHEAD] = {};
+    int _pos = 0;
+    float _ceiling = 1.0f;
+    float _releaseCoef = 0.0f;
+    float _gain = 1.0f, _target = 1.0f, _step = 0.0f;
+    int _hold = 0;
+};
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Output stage
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Output stage in one pass: gain → [soft clip] → RMS/peak → clamp → int16
+// interleave. Soft clip is tanh(1.5x)/tanh(1.5) with tanh replaced by its
+// (3,2) Padé approximant x(27 + x²)/(27 + 9x²), which meets ±1 at |x| = 3 and
+// stays within ~2% of tanh below that. Muted blocks still meter (level match
+// and calibration read them) but skip the pack.
+template <bool Boost, bool Pack>
+void outputKernel(const float* inL, const float* inR, int16_t* out, int count, float gain,
+                  float& sumL, float& sumR, float& pkL, float& pkR)
+{
+    constexpr float drive = 1.5f;
+    constexpr float invNorm = 47.25f / 43.875f;  // 1 / padeTanh(drive)
+    auto softClip = [](float v) {
+        float x = std::clamp(v * drive, -3.0f, 3.0f);
+        float x2 = x * x;
+        return x * (27.0f + x2) / (27.0f + 9.0f * x2) * invNorm;
+    };
+    float sL = 0.0f, sR = 0.0f, mL = pkL, mR = pkR;
+    for (int i = 0; i < count; i++) {
+        float l = inL[i] * gain;
+        float r = inR[i] * gain;
+        if (Boost) {
+            l = softClip(l);
+            r = softClip(r);
+        }
+        sL += l * l;
+        sR += r * r;
+        mL = std::max(mL, fabsf(l));
+        mR = std::max(mR, fabsf(r));
+        if (Pack) {
+            out[i * 2 + 0] = static_cast<int16_t>(std::clamp(l, -1.0f, 1.0f) * 32767.0f);
+            out[i * 2 + 1] = static_cast<int16_t>(std::clamp(r, -1.0f, 1.0f) * 32767.0f);
+        }
+    }
+    sumL += sL;
+    sumR += sR;
+    pkL = mL;
+    pkR = mR;
+}
@@ -0,0 +1,102 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "mp3_decoder.h"
+#include <mp3dec.h>
+
+Mp3Decoder::~Mp3Decoder()
+{
+    close();
+}
+
+size_t Mp3Decoder::id3Size(const uint8_t* header)
+{
+    // ID3v2: 10-byte header, syncsafe tag size in bytes 6-9 (+10 more with a footer)
+    if (header[0] != 'I' || header[1] != 'D' || header[2] != '3') return 0;
+    size_t tag = 10 + ((header[6] & 0x7F) << 21 | (header[7] & 0x7F) << 14 | (header[8] & 0x7F) << 7 |
+                       (header[9] & 0x7F));
+    if (header[5] & 0x10) tag += 10;
+    return tag;
+}
+
+bool Mp3Decoder::open(const uint8_t* data, size_t size)
+{
+    close();
+    if (!data || size == 0) return false;
+
+    if (size >= 10) {
+        const size_t tag = id3Size(data);
+        if (tag >= size) return false;
+        data += tag;
+        size -= tag;
+    }
+
+    _decoder = MP3InitDecoder();
+    if (!_decoder) return false;
+    _pos = data;
+    _left = static_cast<int>(size);
+    return true;
+}
+
+bool Mp3Decoder::openStream()
+{
+    close();
+    _decoder = MP3InitDecoder();
+    return _decoder != nullptr;
+}
+
+void Mp3Decoder::close()
+{
+    if (_decoder) MP3FreeDecoder(static_cast<HMP3Decoder>(_decoder));
+    _decoder = nullptr;
+    _pos = nullptr;
+    _left = 0;
+    _sampleRate = 0;
+    _channels = 0;
+}
+
+int Mp3Decoder::decodeFrame(int16_t* pcm)
+{
+    if (!_decoder) return 0;
+    auto* hmp3 = static_cast<HMP3Decoder>(_decoder);
+    while (_left > 0) {
+        // libhelix takes a mutable pointer but only reads through it
+        int sync = MP3FindSyncWord(const_cast<unsigned char*>(_pos), _left);
+        if (sync < 0) {
+            // The last byte may be the first half of a sync word split across windows
+            _pos += _left - 1;
+            _left = 1;
+            return 0;
+        }
+        _pos += sync;
+        _left -= sync;
+
+        auto* in = const_cast<unsigned char*>(_pos);
+        int left = _left;
+        int err = MP3Decode(hmp3, &in, &left, pcm, 0);
+        if (err == ERR_MP3_INDATA_UNDERFLOW) return 0;  // Partial frame: stays for the next window
+        if (err == ERR_MP3_MAINDATA_UNDERFLOW) {
+            // Bit reservoir still filling from earlier frames: consumed, nothing to output
+            _pos = in;
+            _left = left;
+            continue;
+        }
+        if (err != ERR_MP3_NONE) {
+            // Corrupt frame: resync past this sync word
+            _pos += 1;
+            _left -= 1;
+            continue;
+        }
+        _pos = in;
+        _left = left;
+
+        MP3FrameInfo info;
+        MP3GetLastFrameInfo(hmp3, &info);
+        _sampleRate = info.samprate;
+        _channels = info.nChans;
+        return info.outputSamps;
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief MP3 decoder reading straight from a memory-mapped buffer
+ *
+ * Wraps libhelix over data that is already addressable (embedded flash
+ * binaries, PSRAM): frames are decoded in place from the mapped bytes, with
+ * no FILE*, stdio buffering or staging copy in between. A leading ID3v2 tag
+ * is skipped; bad frames are resynced past rather than ending the stream.
+ *
+ * Streaming: openStream() starts without data, and the caller hands over a
+ * window of the file with setInput(); decodeFrame() returns 0 once no whole
+ * frame is left in it, with the partial frame still in remaining(), so the
+ * caller moves that to the front, appends more and calls setInput() again.
+ */
+class Mp3Decoder {
+public:
+    static constexpr int MAX_FRAME_SAMPLES = 1152 * 2;  // Interleaved samples in one MPEG-1 Layer III frame
+    static constexpr int MAX_FRAME_BYTES = 1441;        // 320 kbps at 32 kHz, padded
+
+    Mp3Decoder() = default;
+    ~Mp3Decoder();
+    Mp3Decoder(const Mp3Decoder&) = delete;
+    Mp3Decoder& operator=(const Mp3Decoder&) = delete;
+
+    // data must stay mapped until close()
+    bool open(const uint8_t* data, size_t size);
+    bool openStream();
+    void close();
+
+    // Streaming: the next window of the file (the same bytes must stay put until the next call)
+    void setInput(const uint8_t* data, size_t size)
+    {
+        _pos = data;
+        _left = static_cast<int>(size);
+    }
+    // Unconsumed bytes: the last remaining() bytes of the window
+    size_t remaining() const
+    {
+        return _left;
+    }
+
+    // Bytes of a leading ID3v2 tag given the file's first 10 bytes, 0 if there is none
+    static size_t id3Size(const uint8_t* header);
+
+    // Decodes the next frame into pcm (MAX_FRAME_SAMPLES capacity).
+    // Returns the interleaved samples written, 0 at the end of the stream.
+    int decodeFrame(int16_t* pcm);
+
+    // Format of the last decoded frame
+    uint32_t sampleRate() const
+    {
+        return _sampleRate;
+    }
+    int channels() const
+    {
+        return _channels;
+    }
+
+private:
+    void* _decoder = nullptr;  // HMP3Decoder (typed in .cpp via mp3dec.h)
+    const uint8_t* _pos = nullptr;
+    int _left = 0;
+    uint32_t _sampleRate = 0;
+    int _channels = 0;
+};
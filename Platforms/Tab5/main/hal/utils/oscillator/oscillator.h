@@ -0,0 +1,76 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+/**
+ * @brief Wavetable sine oscillator on a 32-bit fixed-point phase accumulator
+ *
+ * The phase wraps naturally at 2^32, so it never loses precision however long
+ * the session runs; the only error is the frequency step quantized to
+ * sampleRate / 2^32 (~11 µHz at 48kHz). Output is a 1024-entry table with
+ * linear interpolation (~-105 dB error), a table read and one multiply-add
+ * per sample.
+ *
+ * Oscillators reset together keep an exact phase relationship, e.g. the two
+ * sides of a binaural beat never drift apart beyond the set beat frequency.
+ */
+class Oscillator {
+public:
+    static constexpr int TABLE_BITS = 10;
+    static constexpr int TABLE_SIZE = 1 << TABLE_BITS;
+
+    Oscillator() : _table(sineTable()) {}
+
+    void setFrequency(float hz, float sampleRate)
+    {
+        _inc = static_cast<uint32_t>(static_cast<int64_t>(std::llround(static_cast<double>(hz) / sampleRate * 4294967296.0)));
+    }
+
+    void reset(uint32_t phase = 0)
+    {
+        _phase = phase;
+    }
+
+    uint32_t phase() const
+    {
+        return _phase;
+    }
+
+    float next()
+    {
+        constexpr int FRAC_BITS = 32 - TABLE_BITS;
+        constexpr float FRAC_SCALE = 1.0f / (1u << FRAC_BITS);
+        uint32_t idx = _phase >> FRAC_BITS;
+        float frac = static_cast<float>(_phase & ((1u << FRAC_BITS) - 1)) * FRAC_SCALE;
+        float a = _table[idx];
+        float s = a + frac * (_table[idx + 1] - a);
+        _phase += _inc;
+        return s;
+    }
+
+private:
+    // One period plus a guard entry so idx + 1 never wraps
+    static const float* sineTable()
+    {
+        struct Table {
+            float v[TABLE_SIZE + 1];
+            Table()
+            {
+                for (int i = 0; i <= TABLE_SIZE; i++) {
+                    v[i] = static_cast<float>(std::sin(2.0 * M_PI * i / TABLE_SIZE));
+                }
+            }
+        };
+        static const Table table;
+        return table.v;
+    }
+
+    const float* _table;
+    uint32_t _phase = 0;
+    uint32_t _inc = 0;
+};
@@ -140,6 +140,11 @@ void RX8130_Class::disableIrq()
     writeRegister8(RX8130_REG_CTRL0, 0);
 }
 
+bool RX8130_Class::isAlarmFired()
+{
+    return (readRegister8(RX8130_REG_FLAG) & RX8130_BIT_FLAG_AF) != 0;
+}
+
 void RX8130_Class::setAlarmIrq(struct tm* time)
 {
     uint8_t buf = 0;
@@ -153,22 +158,27 @@ void RX8130_Class::setAlarmIrq(struct tm* time)
     buf = readRegister8(RX8130_REG_CTRL0);
     // debug_print_reg(0x1E, buf);
 
-    // Hour AE, week AE day AE
+    // Week / day AE: the alarm matches hour and minute, so it fires at the next such time
     buf = 0x80;
     writeRegister8(RX8130_REG_ALWDAY, buf);
     buf = readRegister8(RX8130_REG_ALWDAY);
     // debug_print_reg(0x19, buf);
 
-    buf = 0x80;
+    buf = dec2bcd(time->tm_hour) & 0x3f;
     writeRegister8(RX8130_REG_ALHOUR, buf);
     buf = readRegister8(RX8130_REG_ALHOUR);
     // debug_print_reg(0x18, buf);
 
-    buf = 0x80;
+    buf = dec2bcd(time->tm_min) & 0x7f;
     writeRegister8(RX8130_REG_ALMIN, buf);
     buf = readRegister8(RX8130_REG_ALMIN);
     // debug_print_reg(0x17, buf);
 
+    // A match before this call must not count
+    buf = readRegister8(RX8130_REG_FLAG);
+    buf &= ~RX8130_BIT_FLAG_AF;
+    writeRegister8(RX8130_REG_FLAG, buf);
+
     // Write 1 to AIE
     buf = readRegister8(RX8130_REG_CTRL0);
     setbit(buf, 3);
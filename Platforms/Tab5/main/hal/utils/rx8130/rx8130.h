@@ -22,6 +22,9 @@ public:
     void getTime(struct tm* time);
     void clearIrqFlags();
     void disableIrq();
+    // AF: the alarm time was reached since the flags were last cleared
+    bool isAlarmFired();
+    // Fires at the next time->tm_hour:tm_min, any day
     void setAlarmIrq(struct tm* time);
     void setTimerIrq(uint16_t seconds);
 
@@ -0,0 +1,93 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "scene_classifier.h"
+#include <algorithm>
+#include <cmath>
+
+static constexpr float ACTIVE_OVER_FLOOR_DB = 9.0f;  // A frame this far over the floor is someone talking
+static constexpr float SPEECH_ACTIVE = 0.2f;         // Share of active frames for a talk scene
+static constexpr float SPEECH_MODULATION_DB = 4.0f;
+static constexpr float STEADY_MODULATION_DB = 3.5f;  // Under it a loud floor is steady noise
+static constexpr float RUMBLE_SHARE = 0.7f;          // Low-band share of traffic and ventilation...
+static constexpr float RUMBLE_MODULATION_DB = 5.0f;  // ...which stays steady noise up to this spread
+
+static float powerDb(float p)
+{
+    return 10.0f * log10f(p + 1e-12f);
+}
+
+void SceneClassifier::reset()
+{
+    *this = SceneClassifier{};
+}
+
+bool SceneClassifier::push(const SceneFrame& frame, float quietDb)
+{
+    _levelDb[_frames++] = powerDb(frame.power);
+    _power += frame.power;
+    _lowPower += frame.lowPower;
+    _highPower += frame.highPower;
+    if (_frames < WINDOW_FRAMES) return false;
+
+    Features f;
+    f.levelDb = powerDb(_power / WINDOW_FRAMES);
+    if (_power > 0.0f) {
+        f.lowShare = std::min(1.0f, _lowPower / _power);
+        f.highShare = std::min(1.0f, _highPower / (4.0f * _power));
+    }
+    float mean = 0.0f;
+    for (float db : _levelDb) mean += db;
+    mean /= WINDOW_FRAMES;
+    float var = 0.0f;
+    for (float db : _levelDb) var += (db - mean) * (db - mean);
+    f.modulationDb = sqrtf(var / WINDOW_FRAMES);
+
+    // The floor and the speech activity come from the window's level distribution
+    float sorted[WINDOW_FRAMES];
+    std::copy(_levelDb, _levelDb + WINDOW_FRAMES, sorted);
+    std::nth_element(sorted, sorted + WINDOW_FRAMES / 10, sorted + WINDOW_FRAMES);
+    f.floorDb = sorted[WINDOW_FRAMES / 10];
+    int active = 0;
+    for (float db : _levelDb) active += db >= f.floorDb + ACTIVE_OVER_FLOOR_DB;
+    f.activeRatio = static_cast<float>(active) / WINDOW_FRAMES;
+
+    _features = f;
+    _frames = 0;
+    _power = _lowPower = _highPower = 0.0f;
+
+    const AudioScene seen = classify(f, quietDb);
+    if (seen == _scene) {
+        _candidateWins = 0;
+    } else {
+        _candidateWins = seen == _candidate ? _candidateWins + 1 : 1;
+        _candidate = seen;
+        if (_candidateWins >= (seen > _scene ? HOLD_UP : HOLD_DOWN)) {
+            _scene = seen;
+            _candidateWins = 0;
+        }
+    }
+    return true;
+}
+
+AudioScene SceneClassifier::classify(const Features& f, float quietDb) const
+{
+    const bool talk = f.activeRatio >= SPEECH_ACTIVE && f.modulationDb >= SPEECH_MODULATION_DB;
+    if (f.floorDb < quietDb) return talk ? AUDIO_SCENE_SPEECH : AUDIO_SCENE_QUIET;
+    const bool steady = f.modulationDb < STEADY_MODULATION_DB ||
+                        (f.lowShare > RUMBLE_SHARE && f.modulationDb < RUMBLE_MODULATION_DB);
+    return steady ? AUDIO_SCENE_STEADY : AUDIO_SCENE_BABBLE;
+}
+
+const char* SceneClassifier::name(AudioScene scene)
+{
+    switch (scene) {
+        case AUDIO_SCENE_QUIET: return "quiet";
+        case AUDIO_SCENE_SPEECH: return "speech";
+        case AUDIO_SCENE_STEADY: return "steady noise";
+        case AUDIO_SCENE_BABBLE: return "babble";
+        default: return "?";
+    }
+}
@@ -0,0 +1,79 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <cstdint>
+
+// Listening scenes, lightest processing first (AudioEngine::applySceneTier)
+enum AudioScene : uint8_t {
+    AUDIO_SCENE_QUIET = 0,  // Quiet room, nobody talking
+    AUDIO_SCENE_SPEECH,     // Talk over a quiet background
+    AUDIO_SCENE_STEADY,     // Steady noise: street, traffic, ventilation
+    AUDIO_SCENE_BABBLE,     // Modulated noise over a loud floor: restaurant, crowd
+    AUDIO_SCENE_COUNT,
+};
+
+// One ~30ms slice of the mics' mid channel, summed by the audio task
+struct SceneFrame {
+    float power = 0.0f;      // Mean square
+    float lowPower = 0.0f;   // Mean square below ~500Hz (one-pole low-pass)
+    float highPower = 0.0f;  // Mean square of the first difference (rises ~6dB/octave)
+};
+
+/**
+ * @brief Low-rate acoustic scene classifier over ~1s windows of SceneFrames
+ *
+ * Per window it takes the level, the noise floor (10th percentile of the
+ * frame levels), the modulation depth (spread of the frame levels in dB), the
+ * share of frames standing clear of the floor (a level-based speech activity
+ * ratio) and the low-band share of the power. A scene has to win HOLD_UP
+ * windows in a row to replace a lighter one and HOLD_DOWN to replace a
+ * heavier one, so the heavy stages come in within seconds and leave slowly.
+ * No allocation, no locks: the caller owns it.
+ */
+class SceneClassifier {
+public:
+    static constexpr int WINDOW_FRAMES = 32;  // ~1s of 30ms frames
+    static constexpr int HOLD_UP = 2;
+    static constexpr int HOLD_DOWN = 5;
+
+    struct Features {
+        float levelDb = -120.0f;      // Window power, dBFS
+        float floorDb = -120.0f;      // 10th percentile of the frame levels
+        float modulationDb = 0.0f;    // Standard deviation of the frame levels
+        float activeRatio = 0.0f;     // Frames 9dB or more over the floor
+        float lowShare = 0.0f;        // Power below ~500Hz over the total
+        float highShare = 0.0f;       // First-difference power over 4x the total (0..1)
+    };
+
+    void reset();
+    // quietDb: the floor under which the room counts as quiet. True when a window
+    // closed (features() and scene() are fresh)
+    bool push(const SceneFrame& frame, float quietDb);
+
+    AudioScene scene() const
+    {
+        return _scene;
+    }
+    const Features& features() const
+    {
+        return _features;
+    }
+    static const char* name(AudioScene scene);
+
+private:
+    AudioScene classify(const Features& f, float quietDb) const;
+
+    float _levelDb[WINDOW_FRAMES] = {};
+    float _power = 0.0f;
+    float _lowPower = 0.0f;
+    float _highPower = 0.0f;
+    int _frames = 0;
+
+    Features _features;
+    AudioScene _scene = AUDIO_SCENE_QUIET;
+    AudioScene _candidate = AUDIO_SCENE_QUIET;
+    int _candidateWins = 0;
+};
@@ -0,0 +1,19 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <utils/ring_buffer/spsc_ring_buffer.h>
+
+/**
+ * @brief Wait-free single-producer / single-consumer ring
+ *
+ * The producer never blocks: when the ring is full the new item is dropped
+ * and counted (the consumer is expected to drain regularly). N must be a
+ * power of two. This is the toolkit's spsc_ring_buffer under the firmware's
+ * name: push / pop move one item, push_n / pop_n move runs of samples or
+ * bytes in at most two copies.
+ */
+template <typename T, size_t N>
+using SpscRing = smooth_ui_toolkit::spsc_ring_buffer<T, N>;
@@ -6,51 +6,135 @@
 #pragma once
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
-#include <thread>
-#include <mutex>
+#include <freertos/event_groups.h>
+#include <atomic>
 
+/**
+ * @brief Owns one FreeRTOS task: create, stop request, join with a timeout
+ *
+ * create() runs `entry(arg)` in a new task through a trampoline that sets
+ * the EXITED bit of a static event group once entry returns, and then deletes
+ * the task. So entry just returns instead of calling vTaskDelete itself.
+ * join() blocks on that bit rather than polling, which means the owner frees
+ * what the task used only after the task has really stopped using it.
+ *
+ * sendKillSignal() raises the flag the task polls with checkKillSignal() and
+ * also notifies the task, so one blocked in ulTaskNotifyTake() wakes up to
+ * see it. Tasks that block elsewhere (a queue, a driver read) need their own
+ * wake-up. That wait should be bounded, so join() still returns in time.
+ *
+ * After a join() that timed out the task is still alive. handle() keeps
+ * pointing at it, isRunning() stays true and create() refuses, so nothing
+ * reuses its resources. The controller itself has to outlive the task:
+ * make it a member of a long-lived owner.
+ */
 class TaskController_t {
 public:
-    virtual ~TaskController_t()
+    TaskController_t()
     {
+        _events = xEventGroupCreateStatic(&_events_buffer);
     }
+    ~TaskController_t()
+    {
+        vEventGroupDelete(_events);
+    }
+    TaskController_t(const TaskController_t&) = delete;
+    TaskController_t& operator=(const TaskController_t&) = delete;
 
-    std::mutex mutex;
+    // false if the previous task hasn't been joined, or the task couldn't be created
+    bool create(TaskFunction_t entry, const char* name, uint32_t stackDepth, void* arg, UBaseType_t priority,
+                BaseType_t core)
+    {
+        if (isRunning()) {
+            return false;
+        }
+        _entry = entry;
+        _arg   = arg;
+        _kill_signal.store(false, std::memory_order_relaxed);
+        xEventGroupClearBits(_events, EXITED);
+        TaskHandle_t task = nullptr;
+        if (xTaskCreatePinnedToCore(trampoline, name, stackDepth, this, priority, &task, core) != pdPASS) {
+            return false;
+        }
+        _task.store(task, std::memory_order_release);
+        return true;
+    }
 
-    void sendKillSignal()
+    // ── From the task ──
+    bool checkKillSignal() const
     {
-        std::lock_guard<std::mutex> lock(mutex);
-        _kill_signal = true;
+        return _kill_signal.load(std::memory_order_acquire);
     }
 
-    bool checkKillSignal()
+    // ── From the owner ──
+    void sendKillSignal()
     {
-        std::lock_guard<std::mutex> lock(mutex);
-        return _kill_signal;
+        _kill_signal.store(true, std::memory_order_release);
+        notify();
     }
 
-    bool isTaskDeleted()
+    // Wakes a task blocked in ulTaskNotifyTake(); no-op when there is none
+    void notify()
     {
-        std::lock_guard<std::mutex> lock(mutex);
-        return _task_deleted = true;
+        TaskHandle_t task = handle();
+        if (task) {
+            xTaskNotifyGive(task);
+        }
     }
 
-    void setTaskDeleted()
+    // Waits up to timeout for the task to return from entry; true once it has (or if there is none)
+    bool join(TickType_t timeout = portMAX_DELAY)
     {
-        std::lock_guard<std::mutex> lock(mutex);
-        _task_deleted = true;
+        if (!handle()) {
+            return true;
+        }
+        if ((xEventGroupWaitBits(_events, EXITED, pdFALSE, pdTRUE, timeout) & EXITED) == 0) {
+            return false;
+        }
+        _task.store(nullptr, std::memory_order_release);
+        return true;
     }
 
-    void sendKillSignalAndWaitDelete(const TickType_t xTicksToDelay = pdMS_TO_TICKS(100))
+    bool sendKillSignalAndWaitDelete(TickType_t timeout = portMAX_DELAY)
     {
         sendKillSignal();
-        while (1) {
-            vTaskDelay(xTicksToDelay);
-            if (isTaskDeleted()) break;
-        }
+        return join(timeout);
+    }
+
+    // The task has returned from entry (or was never created)
+    bool isTaskDeleted() const
+    {
+        return !handle() || (xEventGroupGetBits(_events) & EXITED) != 0;
+    }
+
+    // Created and not joined yet
+    bool isRunning() const
+    {
+        return handle() != nullptr;
+    }
+
+    // The task, for notifications; nullptr once joined
+    TaskHandle_t handle() const
+    {
+        return _task.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr EventBits_t EXITED = BIT0;
+
+    static void trampoline(void* param)
+    {
+        auto* self = static_cast<TaskController_t*>(param);
+        self->_entry(self->_arg);
+        // Last touch of the controller: the joiner may free everything entry used from here on
+        xEventGroupSetBits(self->_events, EXITED);
+        vTaskDelete(nullptr);
     }
 
-protected:
-    bool _kill_signal  = false;
-    bool _task_deleted = false;
+    TaskFunction_t _entry = nullptr;
+    void* _arg            = nullptr;
+    std::atomic<TaskHandle_t> _task{nullptr};
+    std::atomic<bool> _kill_signal{false};
+    StaticEventGroup_t _events_buffer;
+    EventGroupHandle_t _events = nullptr;
 };
@@ -0,0 +1,56 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Wait-free single-writer / single-reader value handoff
+ *
+ * Three slots rotate between writer (back), shared (middle) and reader (front).
+ * The writer fills back() and publish()es it; the reader calls update() and,
+ * if a newer value was published, reads it from front(). Neither side ever
+ * blocks or sees a torn value, and the reader always gets the latest publish.
+ *
+ * Writer-side calls must be serialized by the caller (one writer at a time).
+ */
+template <typename T>
+class TripleBuffer {
+public:
+    // ── Writer ──
+    T& back()
+    {
+        return _slots[_back];
+    }
+
+    void publish()
+    {
+        _back = _middle.exchange(_back | DIRTY, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // ── Reader ──
+    // Returns true if front() now holds a value newer than the last update()
+    bool update()
+    {
+        if ((_middle.load(std::memory_order_acquire) & DIRTY) == 0) return false;
+        _front = _middle.exchange(_front, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    const T& front() const
+    {
+        return _slots[_front];
+    }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x03;
+    static constexpr uint8_t DIRTY      = 0x04;
+
+    T _slots[3];
+    uint8_t _back = 0;
+    std::atomic<uint8_t> _middle{1};
+    uint8_t _front = 2;
+};
@@ -0,0 +1,199 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "wola.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <esp_heap_caps.h>
+#include <sdkconfig.h>
+#include <dsps_fft2r.h>
+
+bool WolaProcessor::initFftTables()
+{
+    static std::once_flag once;
+    static bool ok = false;
+    std::call_once(once, [] {
+        // Touched by every butterfly: keep it out of PSRAM
+        auto* table = static_cast<float*>(heap_caps_aligned_calloc(16, CONFIG_DSP_MAX_FFT_SIZE, sizeof(float),
+            MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+        ok = table && dsps_fft2r_init_fc32(table, CONFIG_DSP_MAX_FFT_SIZE) == ESP_OK;
+        if (!ok) {
+            heap_caps_free(table);
+            // Last resort: let esp-dsp allocate wherever it can
+            ok = dsps_fft2r_init_fc32(nullptr, CONFIG_DSP_MAX_FFT_SIZE) == ESP_OK;
+        }
+    });
+    return ok;
+}
+
+bool WolaProcessor::init(int fftSize, int hop, float sampleRate)
+{
+    deinit();
+    if (fftSize < MIN_FFT || fftSize > std::min(MAX_FFT, CONFIG_DSP_MAX_FFT_SIZE) || (fftSize & (fftSize - 1))) {
+        return false;
+    }
+    if (hop <= 0 || hop > fftSize / 2 || fftSize % hop != 0) return false;
+    if (!initFftTables()) return false;
+
+    const int n = fftSize;
+    const int bins = n / 2 + 1;
+    // The FFT frame goes first so it keeps the allocation's 16-byte alignment
+    const size_t floats = 2 * n + 2 * n + 2 * (2 * n + hop + 2 * bins);
+    _mem = static_cast<float*>(heap_caps_aligned_calloc(16, floats, sizeof(float),
+        MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+    if (!_mem) return false;
+
+    float* p = _mem;
+    _fft = p;         p += 2 * n;
+    _window = p;      p += n;
+    _synth = p;       p += n;
+    for (int c = 0; c < 2; c++) {
+        _in[c] = p;   p += n;
+        _ola[c] = p;  p += n;
+        _out[c] = p;  p += hop;
+        _spec[c] = p; p += 2 * bins;
+    }
+
+    // Periodic sqrt-Hann on both sides: w^2 overlaps to fftSize / (2 * hop)
+    const float olaScale = 2.0f * hop / n;
+    for (int i = 0; i < n; i++) {
+        float w = sqrtf(0.5f - 0.5f * cosf(2.0f * static_cast<float>(M_PI) * i / n));
+        _window[i] = w;
+        _synth[i] = w * olaScale / n;
+    }
+
+    _fftSize = n;
+    _hop = hop;
+    _binHz = sampleRate / n;
+    _pos = 0;
+    return true;
+}
+
+void WolaProcessor::deinit()
+{
+    heap_caps_free(_mem);
+    _mem = nullptr;
+    _fft = _window = _synth = nullptr;
+    for (int c = 0; c < 2; c++) _in[c] = _ola[c] = _out[c] = _spec[c] = nullptr;
+    _fftSize = 0;
+    _hop = 0;
+    _pos = 0;
+}
+
+void WolaProcessor::reset()
+{
+    if (!isInitialized()) return;
+    for (int c = 0; c < 2; c++) {
+        std::memset(_in[c], 0, _fftSize * sizeof(float));
+        std::memset(_ola[c], 0, _fftSize * sizeof(float));
+        std::memset(_out[c], 0, _hop * sizeof(float));
+    }
+    _pos = 0;
+}
+
+bool WolaProcessor::addClient(BinCallback callback, void* ctx)
+{
+    if (!callback) return false;
+    for (int i = 0; i < _numClients; i++) {
+        if (_clients[i].callback == callback && _clients[i].ctx == ctx) return true;
+    }
+    if (_numClients == MAX_CLIENTS) return false;
+    _clients[_numClients++] = {callback, ctx};
+    return true;
+}
+
+void WolaProcessor::removeClient(BinCallback callback, void* ctx)
+{
+    for (int i = 0; i < _numClients; i++) {
+        if (_clients[i].callback == callback && _clients[i].ctx == ctx) {
+            // Keep the remaining clients in order
+            for (int j = i + 1; j < _numClients; j++) _clients[j - 1] = _clients[j];
+            _numClients--;
+            return;
+        }
+    }
+}
+
+void WolaProcessor::process(float* left, float* right, int frames)
+{
+    if (!isInitialized()) return;
+    float* io[2] = {left, right};
+    int done = 0;
+    while (done < frames) {
+        const int count = std::min(_hop - _pos, frames - done);
+        for (int c = 0; c < 2; c++) {
+            std::memcpy(_in[c] + _fftSize - _hop + _pos, io[c] + done, count * sizeof(float));
+            std::memcpy(io[c] + done, _out[c] + _pos, count * sizeof(float));
+        }
+        _pos += count;
+        done += count;
+        if (_pos == _hop) {
+            runFrame();
+            _pos = 0;
+        }
+    }
+}
+
+void WolaProcessor::runFrame()
+{
+    const int n = _fftSize;
+    const int half = n / 2;
+
+    // Analysis: L + jR in one complex transform
+    for (int i = 0; i < n; i++) {
+        _fft[2 * i] = _in[0][i] * _window[i];
+        _fft[2 * i + 1] = _in[1][i] * _window[i];
+    }
+    dsps_fft2r_fc32(_fft, n);
+    dsps_bit_rev_fc32(_fft, n);
+
+    // Split with Z[N-k]: L = (Z[k] + conj(Z[N-k])) / 2, R = (Z[k] - conj(Z[N-k])) / 2j
+    float* sl = _spec[0];
+    float* sr = _spec[1];
+    for (int k = 0; k <= half; k++) {
+        const int m = (n - k) & (n - 1);
+        float zr = _fft[2 * k], zi = _fft[2 * k + 1];
+        float mr = _fft[2 * m], mi = _fft[2 * m + 1];
+        sl[2 * k] = 0.5f * (zr + mr);
+        sl[2 * k + 1] = 0.5f * (zi - mi);
+        sr[2 * k] = 0.5f * (zi + mi);
+        sr[2 * k + 1] = 0.5f * (mr - zr);
+    }
+
+    Frame frame{sl, sr, half + 1, _hop, _binHz};
+    for (int i = 0; i < _numClients; i++) _clients[i].callback(_clients[i].ctx, frame);
+
+    // DC and Nyquist stay real so the rebuilt spectrum is Hermitian
+    sl[1] = sr[1] = sl[2 * half + 1] = sr[2 * half + 1] = 0.0f;
+
+    // Synthesis: conj(Z) over the full circle, forward FFT, conj again = N * IFFT(Z)
+    for (int k = 0; k <= half; k++) {
+        float xr = sl[2 * k], xi = sl[2 * k + 1];
+        float yr = sr[2 * k], yi = sr[2 * k + 1];
+        _fft[2 * k] = xr - yi;
+        _fft[2 * k + 1] = -(xi + yr);
+        if (k > 0 && k < half) {
+            _fft[2 * (n - k)] = xr + yi;
+            _fft[2 * (n - k) + 1] = xi - yr;
+        }
+    }
+    dsps_fft2r_fc32(_fft, n);
+    dsps_bit_rev_fc32(_fft, n);
+
+    for (int i = 0; i < n; i++) {
+        _ola[0][i] += _fft[2 * i] * _synth[i];
+        _ola[1][i] -= _fft[2 * i + 1] * _synth[i];
+    }
+
+    // Hand out the finished hop, slide the accumulator and the input history
+    for (int c = 0; c < 2; c++) {
+        std::memcpy(_out[c], _ola[c], _hop * sizeof(float));
+        std::memmove(_ola[c], _ola[c] + _hop, (n - _hop) * sizeof(float));
+        std::memset(_ola[c] + n - _hop, 0, _hop * sizeof(float));
+        std::memmove(_in[c], _in[c] + _hop, (n - _hop) * sizeof(float));
+    }
+}
@@ -0,0 +1,107 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <cstddef>
+
+/**
+ * @brief Stereo weighted-overlap-add STFT shared by the spectral stages
+ *
+ * Every hop samples the last fftSize input samples get a sqrt-Hann window and
+ * go through one complex FFT carrying L in the real and R in the imaginary
+ * part, which is then split into two half spectra. Registered clients edit
+ * the bins in place, in registration order, so any number of spectral stages
+ * cost one forward and one inverse transform per hop. The inverse runs through
+ * the same forward FFT (conjugate trick) and a sqrt-Hann synthesis window
+ * scaled for the overlap; the output is delayed by exactly fftSize samples.
+ *
+ * All buffers are allocated in init() from internal RAM, never while
+ * processing. The processor and its client list belong to one task.
+ */
+class WolaProcessor {
+public:
+    static constexpr int MIN_FFT = 64;
+    static constexpr int MAX_FFT = 1024;
+    static constexpr int MAX_CLIENTS = 4;
+
+    // Half spectra for one hop: bins (re, im) pairs from DC to Nyquist
+    struct Frame {
+        float* left;
+        float* right;
+        int bins;     // fftSize / 2 + 1
+        int hop;      // Samples since the previous frame
+        float binHz;  // sampleRate / fftSize
+    };
+    using BinCallback = void (*)(void* ctx, Frame& frame);
+
+    ~WolaProcessor()
+    {
+        deinit();
+    }
+
+    // esp-dsp keeps one radix-2 twiddle table for every FFT user; this installs
+    // it in internal RAM before anyone lets the library malloc it (idempotent)
+    static bool initFftTables();
+
+    // fftSize: power of two, MIN_FFT..MAX_FFT; hop: divides fftSize, at most fftSize / 2
+    bool init(int fftSize, int hop, float sampleRate);
+    void deinit();
+    void reset();
+    bool isInitialized() const
+    {
+        return _mem != nullptr;
+    }
+
+    // Clients survive init()/deinit(); the same (callback, ctx) pair is added once
+    bool addClient(BinCallback callback, void* ctx);
+    void removeClient(BinCallback callback, void* ctx);
+    int clientCount() const
+    {
+        return _numClients;
+    }
+
+    // In place; both channels come out latencySamples() late
+    void process(float* left, float* right, int frames);
+
+    int fftSize() const
+    {
+        return _fftSize;
+    }
+    int hop() const
+    {
+        return _hop;
+    }
+    float sampleRate() const
+    {
+        return _binHz * _fftSize;
+    }
+    int latencySamples() const
+    {
+        return _fftSize;
+    }
+
+private:
+    void runFrame();
+
+    struct Client {
+        BinCallback callback;
+        void* ctx;
+    };
+    Client _clients[MAX_CLIENTS] = {};
+    int _numClients = 0;
+
+    float* _mem = nullptr;       // One allocation carved into the buffers below
+    float* _window = nullptr;    // Analysis sqrt-Hann
+    float* _synth = nullptr;     // Synthesis sqrt-Hann with the overlap and 1/N folded in
+    float* _in[2] = {};          // Last fftSize input samples
+    float* _ola[2] = {};         // Overlap-add accumulator
+    float* _out[2] = {};         // Finished hop being played out
+    float* _fft = nullptr;       // Complex work frame (16-byte aligned)
+    float* _spec[2] = {};        // Half spectra handed to the clients
+    int _fftSize = 0;
+    int _hop = 0;
+    int _pos = 0;                // Samples of the current hop consumed
+    float _binHz = 0.0f;
+};
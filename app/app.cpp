@@ -5,11 +5,11 @@
  */
 #include "app.h"
 #include "hal/hal.h"
+#include "shared/shared.h"
 #include "apps/app_installer.h"
 #include <mooncake.h>
 #include <mooncake_log.h>
 #include <string>
-#include <thread>
 
 using namespace mooncake;
 
@@ -34,10 +34,19 @@ void app::Update()
 {
     GetMooncake().update();
 
-#if defined(__APPLE__) && defined(__MACH__)
-    auto time_till_next = lv_timer_handler();
-    std::this_thread::sleep_for(std::chrono::milliseconds(time_till_next));
-#endif
+    // Events other tasks queued since the last tick, delivered here so slots can touch LVGL
+    if (!GetSystemStateEvents().empty() || !GetInputEvents().empty()) {
+        LvglLockGuard lock;
+        GetSystemStateEvents().dispatch();
+        GetInputEvents().dispatch();
+    }
+
+    // All ticker-driven animations in one pass; nothing to lock for while they all sleep
+    auto& ticker = smooth_ui_toolkit::AnimateTicker::shared();
+    if (ticker.awakeNum() > 0) {
+        LvglLockGuard lock;
+        ticker.tick();
+    }
 }
 
 bool app::IsDone()
@@ -5,19 +5,42 @@
  */
 #include "app_audio_control.h"
 #include "view/wizard_ui.h"
+#include "shared/heap_tracker.h"
 #include <hal/hal.h>
 #include <mooncake.h>
 #include <mooncake_log.h>
 
 #ifdef ESP_PLATFORM
 #include "hal/components/audio_engine.h"
+#include "hal/components/audio_cost_model.h"
 #include "hal/components/profile_manager.h"
+#include "hal/components/sd_storage.h"
+#include "hal/components/session_store.h"
+#include "hal/components/session_schedule.h"
 #endif
 
 using namespace mooncake;
 
 static const std::string _tag = "AudioControl";
 
+#ifdef ESP_PLATFORM
+// A profile can stack more than one block period of DSP; step it down before it reaches the engine
+static void applyBootParams(AudioEngineParams& params, const char* source)
+{
+    auto cost = AudioCostModel::getInstance().estimate(params);
+    mclog::tagInfo(_tag, "{}: audio core {:.0f}%, AEC core {:.0f}% predicted{}", source, cost.audioCorePct,
+                   cost.aecCorePct, cost.calibrated ? "" : " (uncalibrated)");
+    if (cost.overBudget) AudioCostModel::getInstance().fitToBudget(params);
+    AudioEngine::getInstance().setParams(params);
+}
+
+// Storage task: mount the card and read the profile index while the app is already running
+static void warmProfiles(void*)
+{
+    ProfileManager::listProfiles();
+}
+#endif
+
 AppAudioControl::AppAudioControl()
 {
     setAppInfo().name = "AppAudioControl";
@@ -34,20 +57,31 @@ void AppAudioControl::onCreate()
 void AppAudioControl::onOpen()
 {
     mclog::tagInfo(_tag, "on open");
+    heap_tracker::Checkpoint("open");
 
 #ifdef ESP_PLATFORM
-    // Start the audio engine
-    AudioEngine::getInstance().start();
-    mclog::tagInfo(_tag, "audio engine started");
-
-    // Try to load default profile from SD card
+    // The last session from NVS, so the first block already runs the user's settings. Only
+    // without one (first boot, erased NVS) does the SD default profile gate the start.
     {
         AudioEngineParams params = AudioEngine::getInstance().getParams();
-        if (ProfileManager::loadDefaultProfile(params)) {
-            AudioEngine::getInstance().setParams(params);
+        if (SessionStore::getInstance().load(params)) {
+            applyBootParams(params, "last session");
+            SdStorage::getInstance().post(warmProfiles, nullptr);
+        } else if (ProfileManager::loadDefaultProfile(params)) {
+            applyBootParams(params, "default profile");
             mclog::tagInfo(_tag, "default profile loaded from SD");
         }
+        // A session alarm wake-up plays the booked profile, over the last session
+        if (GetHAL()->isSessionWakeup() && SessionSchedule::getInstance().loadSession(params)) {
+            applyBootParams(params, "scheduled session");
+        }
     }
+
+    // Start the audio engine
+    AudioEngine::getInstance().start();
+    mclog::tagInfo(_tag, "audio engine started");
+    heap_tracker::Checkpoint("engine started");
+    SessionStore::getInstance().start();
 #endif
 
     // Create the wizard UI
@@ -57,36 +91,53 @@ void AppAudioControl::onOpen()
         _ui->create(lv_screen_active());
     }
 
-    _frameCount = 0;
+    _openedAtMs = GetHAL()->millis();
+    heap_tracker::Checkpoint("ui created");
+
+    // Built but not shown: the session plays with the display off until a touch
+    if (GetHAL()->isSessionWakeup()) GetHAL()->setAudioOnlyMode(true);
     mclog::tagInfo(_tag, "audio control app opened");
 }
 
 void AppAudioControl::onRunning()
 {
-    _frameCount++;
-
-    // Update UI meters at ~15fps (every 4th frame at ~60fps)
-    if (_frameCount % 4 != 0) return;
-
-    LvglLockGuard lock;
-    if (_ui) {
-        _ui->update();
+    // The UI refreshes itself from an LVGL timer; only the soak is driven from here
+    if (heap_tracker::IsSoaking() && GetHAL()->millis() - _openedAtMs >= SOAK_OPEN_MS) {
+        _soakClosing = true;
+        close();
+        GetHAL()->wakeMainLoop();
     }
 }
 
+void AppAudioControl::onSleeping()
+{
+    if (!_soakClosing) return;
+    _soakClosing = false;
+    heap_tracker::SoakCycleDone();
+    // Reopen even after the last cycle so the app comes back when the soak ends
+    open();
+    GetHAL()->wakeMainLoop();
+}
+
 void AppAudioControl::onClose()
 {
     mclog::tagInfo(_tag, "on close");
 
 #ifdef ESP_PLATFORM
+    SessionStore::getInstance().flush();
+
     // Stop the audio engine
     AudioEngine::getInstance().stop();
+    heap_tracker::Checkpoint("engine stopped");
 #endif
 
-    LvglLockGuard lock;
-    if (_ui) {
-        _ui->destroy();
-        delete _ui;
-        _ui = nullptr;
+    {
+        LvglLockGuard lock;
+        if (_ui) {
+            _ui->destroy();
+            delete _ui;
+            _ui = nullptr;
+        }
     }
+    heap_tracker::Checkpoint("closed");
 }
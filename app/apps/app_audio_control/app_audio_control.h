@@ -23,9 +23,13 @@ public:
     void onCreate() override;
     void onOpen() override;
     void onRunning() override;
+    void onSleeping() override;
     void onClose() override;
 
 private:
+    static constexpr uint32_t SOAK_OPEN_MS = 2000;  // Open time per heap soak cycle
+
     WizardUI* _ui = nullptr;
-    uint32_t _frameCount = 0;
+    uint32_t _openedAtMs = 0;
+    bool _soakClosing = false;  // Closed by the heap soak; reopen from onSleeping
 };
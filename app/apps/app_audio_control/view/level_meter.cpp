@@ -0,0 +1,111 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "level_meter.h"
+#include <algorithm>
+
+using smooth_ui_toolkit::fixed_math::fixed_t;
+namespace fixed_math = smooth_ui_toolkit::fixed_math;
+
+static constexpr fixed_t DB_MIN_FIXED{static_cast<int>(LevelMeter::DB_MIN)};
+
+float LevelMeter::levelToNorm(float level)
+{
+    return static_cast<float>(fixed_math::level_to_norm(fixed_t(level), DB_MIN_FIXED));
+}
+
+void LevelMeter::attach(lv_obj_t* track, int maxWidth, int barHeight, const Zones& zones, uint32_t peakColor)
+{
+    _track = track;
+    _maxWidth = maxWidth;
+    _barHeight = barHeight;
+    _zones = zones;
+    _hotLevel = fixed_math::db_to_level(fixed_t(zones.hotDb));
+    _warmLevel = fixed_math::db_to_level(fixed_t(zones.warmDb));
+    _peakColor = peakColor;
+    _barW = 1;
+    _peakX = INSET;
+    _color = zones.cold;
+
+    lv_obj_add_event_cb(track, onDraw, LV_EVENT_DRAW_MAIN_END, this);
+    lv_obj_add_event_cb(track, onDelete, LV_EVENT_DELETE, this);
+    lv_obj_invalidate(track);
+}
+
+uint32_t LevelMeter::zoneColor(fixed_t rms) const
+{
+    if (rms > _hotLevel) return _zones.hot;
+    if (rms > _warmLevel) return _zones.warm;
+    return _zones.cold;
+}
+
+void LevelMeter::set(float rms, float peak)
+{
+    if (!_track) return;
+
+    const fixed_t rmsLevel(rms);
+    const fixed_t peakLevel(peak);
+    const int barW = std::max(1, fixed_math::level_to_pixels(rmsLevel, DB_MIN_FIXED, _maxWidth));
+    const int peakX = std::max(INSET, fixed_math::level_to_pixels(peakLevel, DB_MIN_FIXED, _maxWidth));
+    const uint32_t color = zoneColor(rmsLevel);
+
+    if (color != _color) {
+        // The whole bar changes color
+        invalidateColumns(INSET, INSET + std::max(barW, _barW) + BAR_RADIUS);
+    } else if (barW != _barW) {
+        // Only the strip between the old and new end, plus the rounded end caps
+        invalidateColumns(INSET + std::min(barW, _barW) - BAR_RADIUS, INSET + std::max(barW, _barW) + BAR_RADIUS);
+    }
+    if (peakX != _peakX) {
+        invalidateColumns(_peakX, _peakX + PEAK_W - 1);
+        invalidateColumns(peakX, peakX + PEAK_W - 1);
+    }
+    _barW = barW;
+    _peakX = peakX;
+    _color = color;
+}
+
+// Columns x1..x2 (content-relative) of the bar row, in screen coordinates
+void LevelMeter::barArea(int x1, int x2, lv_area_t* area) const
+{
+    lv_area_t content;
+    lv_obj_get_content_coords(_track, &content);
+    area->x1 = content.x1 + x1;
+    area->x2 = content.x1 + x2;
+    area->y1 = content.y1 + INSET;
+    area->y2 = area->y1 + _barHeight - 1;
+}
+
+void LevelMeter::invalidateColumns(int x1, int x2)
+{
+    lv_area_t area;
+    barArea(x1, x2, &area);
+    lv_obj_invalidate_area(_track, &area);
+}
+
+void LevelMeter::onDraw(lv_event_t* e)
+{
+    auto* meter = static_cast<LevelMeter*>(lv_event_get_user_data(e));
+    lv_layer_t* layer = lv_event_get_layer(e);
+
+    lv_draw_rect_dsc_t dsc;
+    lv_draw_rect_dsc_init(&dsc);
+    lv_area_t area;
+
+    dsc.bg_color = lv_color_hex(meter->_color);
+    dsc.radius = BAR_RADIUS;
+    meter->barArea(INSET, INSET + meter->_barW - 1, &area);
+    lv_draw_rect(layer, &dsc, &area);
+
+    dsc.bg_color = lv_color_hex(meter->_peakColor);
+    dsc.radius = 0;
+    meter->barArea(meter->_peakX, meter->_peakX + PEAK_W - 1, &area);
+    lv_draw_rect(layer, &dsc, &area);
+}
+
+void LevelMeter::onDelete(lv_event_t* e)
+{
+    static_cast<LevelMeter*>(lv_event_get_user_data(e))->_track = nullptr;
+}
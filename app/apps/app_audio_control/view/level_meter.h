@@ -0,0 +1,66 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <lvgl.h>
+#include <cstdint>
+#include <utils/fixed_math/fixed_math.h>
+
+/**
+ * @brief Dirty-checking RMS bar + peak marker drawn into a meter track
+ *
+ * The bar and marker are not objects of their own: they are drawn in the
+ * track's DRAW_MAIN_END event from the last set() values. set() converts the
+ * levels to pixels in fixed point (fixed_math's log2 table, no float math past
+ * taking the level in) and, when a pixel column or the color zone actually
+ * changed, invalidates only the strip between the old and new extent. A meter
+ * sitting on a steady or silent signal costs no redraw.
+ */
+class LevelMeter {
+public:
+    // Bar color by RMS level: hot above hotDb, warm above warmDb, cold below
+    struct Zones {
+        float hotDb = -3.0f;
+        uint32_t hot = 0xCC4444;
+        float warmDb = -10.0f;
+        uint32_t warm = 0xCCAA33;
+        uint32_t cold = 0x44CC66;
+    };
+
+    static constexpr float DB_MIN = -60.0f;  // Left edge of the scale; 0 dBFS is the right edge
+
+    // Draw into `track` (a styled, childless container); the bar spans maxWidth
+    // x barHeight, 2px inside the track's content area
+    void attach(lv_obj_t* track, int maxWidth, int barHeight, const Zones& zones, uint32_t peakColor);
+    void set(float rms, float peak);
+
+    // 0..1 position of a linear level on the DB_MIN..0 dB scale
+    static float levelToNorm(float level);
+
+private:
+    static constexpr int INSET = 2;
+    static constexpr int PEAK_W = 3;
+    static constexpr int BAR_RADIUS = 2;
+
+    static void onDraw(lv_event_t* e);
+    static void onDelete(lv_event_t* e);
+    void barArea(int x1, int x2, lv_area_t* area) const;
+    void invalidateColumns(int x1, int x2);
+    uint32_t zoneColor(smooth_ui_toolkit::fixed_math::fixed_t rms) const;
+
+    lv_obj_t* _track = nullptr;
+    int _maxWidth = 0;
+    int _barHeight = 0;
+    // Zone thresholds as linear levels
+    smooth_ui_toolkit::fixed_math::fixed_t _hotLevel{1};
+    smooth_ui_toolkit::fixed_math::fixed_t _warmLevel{1};
+    Zones _zones;
+    uint32_t _peakColor = 0;
+
+    // What the track last drew
+    int _barW = 1;
+    int _peakX = INSET;
+    uint32_t _color = 0;
+};
@@ -0,0 +1,27 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "param_coalescer.h"
+
+bool ParamCoalescer::post(Apply apply, int arg, float value)
+{
+    for (int i = 0; i < _count; i++) {
+        if (_edits[i].apply == apply && _edits[i].arg == arg) {
+            _edits[i].value = value;
+            return true;
+        }
+    }
+    if (_count == MAX_EDITS) return false;
+    _edits[_count++] = {apply, arg, value};
+    return true;
+}
+
+int ParamCoalescer::flush()
+{
+    const int n = _count;
+    for (int i = 0; i < n; i++) _edits[i].apply(_edits[i].arg, _edits[i].value);
+    _count = 0;
+    return n;
+}
@@ -0,0 +1,41 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+/**
+ * @brief Latest-value-wins queue of engine parameter edits for one UI frame
+ *
+ * A dragged slider fires VALUE_CHANGED on every touch sample. Instead of
+ * calling the engine setter each time, the handler post()s the edit; a second
+ * post() to the same setter and argument (notch index, say) before the next
+ * flush() only replaces the value. flush() then runs each setter once, in
+ * first-posted order. The owner brackets flush() with the engine's param batch
+ * so the whole frame lands as one params generation.
+ */
+class ParamCoalescer {
+public:
+    // Captureless lambdas convert to this; `arg` carries an index where the setter takes one
+    using Apply = void (*)(int arg, float value);
+    static constexpr int MAX_EDITS = 16;
+
+    // false when the queue is full and the edit was not taken; flush() and post again
+    bool post(Apply apply, int arg, float value);
+    // Runs and clears the queued edits; returns how many ran
+    int flush();
+    bool empty() const
+    {
+        return _count == 0;
+    }
+
+private:
+    struct Edit {
+        Apply apply;
+        int arg;
+        float value;
+    };
+    Edit _edits[MAX_EDITS] = {};
+    int _count = 0;
+};
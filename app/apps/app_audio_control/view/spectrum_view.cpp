@@ -0,0 +1,84 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "spectrum_view.h"
+#include <algorithm>
+
+void SpectrumView::attach(lv_obj_t* box, int bands, int plotHeight, uint32_t inputColor, uint32_t outputColor)
+{
+    _box = box;
+    _bands = std::clamp(bands, 0, MAX_BANDS);
+    _inputColor = inputColor;
+    _outputColor = outputColor;
+    _plotH = plotHeight;
+    std::fill(_inputH, _inputH + MAX_BANDS, 0);
+    std::fill(_outputH, _outputH + MAX_BANDS, 0);
+
+    lv_obj_add_event_cb(box, onDraw, LV_EVENT_DRAW_MAIN_END, this);
+    lv_obj_add_event_cb(box, onDelete, LV_EVENT_DELETE, this);
+    lv_obj_invalidate(box);
+}
+
+int SpectrumView::dbToHeight(float db) const
+{
+    const float norm = (std::clamp(db, DB_BOTTOM, DB_TOP) - DB_BOTTOM) / (DB_TOP - DB_BOTTOM);
+    return static_cast<int>(norm * _plotH);
+}
+
+void SpectrumView::set(const float* inputDb, const float* outputDb)
+{
+    if (!_box) return;
+
+    bool changed = false;
+    for (int b = 0; b < _bands; b++) {
+        const int16_t in = static_cast<int16_t>(dbToHeight(inputDb[b]));
+        const int16_t out = static_cast<int16_t>(dbToHeight(outputDb[b]));
+        changed |= in != _inputH[b] || out != _outputH[b];
+        _inputH[b] = in;
+        _outputH[b] = out;
+    }
+    if (changed) lv_obj_invalidate(_box);
+}
+
+void SpectrumView::onDraw(lv_event_t* e)
+{
+    auto* view = static_cast<SpectrumView*>(lv_event_get_user_data(e));
+    if (view->_bands == 0) return;
+    lv_layer_t* layer = lv_event_get_layer(e);
+
+    lv_area_t content;
+    lv_obj_get_content_coords(view->_box, &content);
+    const int x0 = content.x1 + INSET;
+    const int bottom = content.y2 - INSET;
+    const int slot = (lv_area_get_width(&content) - 2 * INSET) / view->_bands;
+    const int barW = std::max(1, (slot - 2 - BAR_GAP) / 2);  // 2px between bands
+
+    lv_draw_rect_dsc_t dsc;
+    lv_draw_rect_dsc_init(&dsc);
+    lv_area_t area;
+    area.y2 = bottom;
+    for (int b = 0; b < view->_bands; b++) {
+        const int x = x0 + b * slot + 1;
+        if (view->_inputH[b] > 0) {
+            dsc.bg_color = lv_color_hex(view->_inputColor);
+            area.x1 = x;
+            area.x2 = x + barW - 1;
+            area.y1 = bottom - view->_inputH[b] + 1;
+            lv_draw_rect(layer, &dsc, &area);
+        }
+        if (view->_outputH[b] > 0) {
+            dsc.bg_color = lv_color_hex(view->_outputColor);
+            area.x1 = x + barW + BAR_GAP;
+            area.x2 = area.x1 + barW - 1;
+            area.y1 = bottom - view->_outputH[b] + 1;
+            lv_draw_rect(layer, &dsc, &area);
+        }
+    }
+}
+
+void SpectrumView::onDelete(lv_event_t* e)
+{
+    static_cast<SpectrumView*>(lv_event_get_user_data(e))->_box = nullptr;
+}
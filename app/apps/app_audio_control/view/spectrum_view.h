@@ -0,0 +1,46 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <lvgl.h>
+#include <cstdint>
+
+/**
+ * @brief Paired input/output band bars drawn into one plot box
+ *
+ * Like LevelMeter, the bars are not objects: the box's DRAW_MAIN_END event
+ * paints every band from the last set() values, and set() invalidates the box
+ * once, only when some bar moved by a pixel. A new spectrum frame therefore
+ * costs one redraw of one area however many bands there are.
+ */
+class SpectrumView {
+public:
+    static constexpr int MAX_BANDS = 32;
+    static constexpr float DB_TOP = 0.0f;
+    static constexpr float DB_BOTTOM = -84.0f;
+
+    // Draw `bands` bar pairs into `box` (a styled, childless container); full scale
+    // is plotHeight px, 4px inside the box's content area
+    void attach(lv_obj_t* box, int bands, int plotHeight, uint32_t inputColor, uint32_t outputColor);
+    void set(const float* inputDb, const float* outputDb);
+
+private:
+    static constexpr int INSET = 4;
+    static constexpr int BAR_GAP = 1;  // Between the input and output bar of a band
+
+    static void onDraw(lv_event_t* e);
+    static void onDelete(lv_event_t* e);
+    int dbToHeight(float db) const;
+
+    lv_obj_t* _box = nullptr;
+    int _bands = 0;
+    int _plotH = 0;
+    uint32_t _inputColor = 0;
+    uint32_t _outputColor = 0;
+
+    // Bar heights the box last drew
+    int16_t _inputH[MAX_BANDS] = {};
+    int16_t _outputH[MAX_BANDS] = {};
+};
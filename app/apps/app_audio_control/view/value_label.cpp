@@ -0,0 +1,90 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "value_label.h"
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr int32_t POW10[] = {1, 10, 100, 1000};
+
+// Appends src to out[len..], always terminated; returns the new length
+int append(char* out, int size, int len, const char* src)
+{
+    while (*src && len + 1 < size) out[len++] = *src++;
+    out[len] = '\0';
+    return len;
+}
+
+// Sign, then `whole`, then `decimals` digits of `frac`
+int write_number(char* out, int size, bool negative, uint32_t whole, uint32_t frac, int decimals, bool plus)
+{
+    char digits[16];
+    int n = 0;
+    for (int d = 0; d < decimals; d++, frac /= 10) digits[n++] = char('0' + frac % 10);
+    if (decimals > 0) digits[n++] = '.';
+    do {
+        digits[n++] = char('0' + whole % 10);
+        whole /= 10;
+    } while (whole);
+    if (negative) {
+        digits[n++] = '-';
+    } else if (plus) {
+        digits[n++] = '+';
+    }
+
+    int len = 0;
+    while (n > 0 && len + 1 < size) out[len++] = digits[--n];
+    out[len] = '\0';
+    return len;
+}
+
+}  // namespace
+
+bool ValueLabel::setText(lv_obj_t* label, const char* text)
+{
+    if (!label) return false;
+    const char* shown = lv_label_get_text(label);
+    if (shown && strcmp(shown, text) == 0) return false;
+    lv_label_set_text(label, text);
+    return true;
+}
+
+bool ValueLabel::setInt(lv_obj_t* label, int32_t value, const char* suffix, bool plus)
+{
+    if (!label) return false;
+    char text[MAX_TEXT];
+    formatInt(text, sizeof(text), value, suffix, plus);
+    return setText(label, text);
+}
+
+bool ValueLabel::setFixed(lv_obj_t* label, float value, int decimals, const char* suffix, bool plus)
+{
+    if (!label) return false;
+    char text[MAX_TEXT];
+    formatFixed(text, sizeof(text), value, decimals, suffix, plus);
+    return setText(label, text);
+}
+
+int ValueLabel::formatInt(char* out, int size, int32_t value, const char* suffix, bool plus)
+{
+    if (size <= 0) return 0;
+    const uint32_t mag = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+    const int len = write_number(out, size, value < 0, mag, 0, 0, plus);
+    return append(out, size, len, suffix);
+}
+
+int ValueLabel::formatFixed(char* out, int size, float value, int decimals, const char* suffix, bool plus)
+{
+    if (size <= 0) return 0;
+    if (decimals < 0) decimals = 0;
+    if (decimals > 3) decimals = 3;
+    // Rounded once, so -0.04 at one decimal reads +0.0, not -0.0
+    const long scaled = lroundf(value * (float)POW10[decimals]);
+    const uint32_t mag = scaled < 0 ? (uint32_t)(-scaled) : (uint32_t)scaled;
+    const int len = write_number(out, size, scaled < 0, mag / POW10[decimals], mag % POW10[decimals], decimals, plus);
+    return append(out, size, len, suffix);
+}
@@ -0,0 +1,36 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <lvgl.h>
+#include <cstdint>
+
+/**
+ * @brief Label text setters that leave an unchanged label alone
+ *
+ * Slider events and syncUiToParams() set the same value labels over and over,
+ * mostly with the text they already show. lv_label_set_text() reallocates,
+ * lays out and invalidates every time; these compare against the label's
+ * current text first, so a repeat costs a short strcmp. Numbers are written by
+ * a small integer routine instead of printf. Comparing with the label itself
+ * instead of a cached number stays right across panel rebuilds.
+ *
+ * A null label is ignored, and every setter returns whether the text changed.
+ */
+class ValueLabel {
+public:
+    static constexpr int MAX_TEXT = 32;
+
+    static bool setText(lv_obj_t* label, const char* text);
+    // "<value><suffix>"; `plus` writes '+' before values >= 0
+    static bool setInt(lv_obj_t* label, int32_t value, const char* suffix = "", bool plus = false);
+    // Rounded to `decimals` digits (0..3)
+    static bool setFixed(lv_obj_t* label, float value, int decimals, const char* suffix = "", bool plus = false);
+
+    // Formatting only, for texts put together from several parts; return the length written
+    static int formatInt(char* out, int size, int32_t value, const char* suffix = "", bool plus = false);
+    static int formatFixed(char* out, int size, float value, int decimals, const char* suffix = "",
+                           bool plus = false);
+};
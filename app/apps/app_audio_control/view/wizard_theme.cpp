@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "wizard_theme.h"
+
+bool WizardTheme::_ready = false;
+lv_style_t WizardTheme::_sliderMain;
+lv_style_t WizardTheme::_sliderIndicator;
+lv_style_t WizardTheme::_sliderKnob;
+lv_style_t WizardTheme::_toggle;
+lv_style_t WizardTheme::_sectionLabel;
+lv_style_t WizardTheme::_valueLabel;
+lv_style_t WizardTheme::_compactText;
+lv_style_t WizardTheme::_captionText;
+lv_style_t WizardTheme::_divider;
+
+// Only ever called from the LVGL task or under the LVGL lock
+void WizardTheme::init()
+{
+    if (_ready) return;
+    _ready = true;
+
+    // Slider track
+    lv_style_init(&_sliderMain);
+    lv_style_set_bg_color(&_sliderMain, lv_color_hex(BG_TRACK));
+    lv_style_set_bg_opa(&_sliderMain, LV_OPA_COVER);
+    lv_style_set_radius(&_sliderMain, 4);
+    lv_style_set_border_color(&_sliderMain, lv_color_hex(DARK_BORDER));
+    lv_style_set_border_width(&_sliderMain, 1);
+
+    // Filled portion
+    lv_style_init(&_sliderIndicator);
+    lv_style_set_bg_color(&_sliderIndicator, lv_color_hex(LAVENDER));
+    lv_style_set_bg_opa(&_sliderIndicator, 180);
+    lv_style_set_radius(&_sliderIndicator, 4);
+
+    lv_style_init(&_sliderKnob);
+    lv_style_set_bg_color(&_sliderKnob, lv_color_hex(GOLD_BRIGHT));
+    lv_style_set_bg_opa(&_sliderKnob, LV_OPA_COVER);
+    lv_style_set_radius(&_sliderKnob, LV_RADIUS_CIRCLE);
+    lv_style_set_pad_all(&_sliderKnob, 6);
+    lv_style_set_border_color(&_sliderKnob, lv_color_hex(GOLD));
+    lv_style_set_border_width(&_sliderKnob, 2);
+    lv_style_set_shadow_width(&_sliderKnob, 8);
+    lv_style_set_shadow_color(&_sliderKnob, lv_color_hex(GOLD_BRIGHT));
+    lv_style_set_shadow_opa(&_sliderKnob, 80);
+
+    lv_style_init(&_toggle);
+    lv_style_set_bg_color(&_toggle, lv_color_hex(BG_DARK));
+    lv_style_set_radius(&_toggle, 8);
+    lv_style_set_border_color(&_toggle, lv_color_hex(GOLD));
+    lv_style_set_border_width(&_toggle, 1);
+    lv_style_set_shadow_width(&_toggle, 0);
+
+    lv_style_init(&_sectionLabel);
+    lv_style_set_text_font(&_sectionLabel, &lv_font_montserrat_16);
+    lv_style_set_text_color(&_sectionLabel, lv_color_hex(GOLD_BRIGHT));
+    lv_style_set_text_letter_space(&_sectionLabel, 2);
+
+    lv_style_init(&_valueLabel);
+    lv_style_set_text_font(&_valueLabel, &lv_font_montserrat_16);
+    lv_style_set_text_color(&_valueLabel, lv_color_hex(GOLD));
+
+    lv_style_init(&_compactText);
+    lv_style_set_text_font(&_compactText, &lv_font_montserrat_14);
+
+    lv_style_init(&_captionText);
+    lv_style_set_text_font(&_captionText, &lv_font_montserrat_12);
+
+    lv_style_init(&_divider);
+    lv_style_set_bg_color(&_divider, lv_color_hex(DARK_BORDER));
+    lv_style_set_bg_opa(&_divider, LV_OPA_COVER);
+}
+
+void WizardTheme::applySlider(lv_obj_t* slider)
+{
+    init();
+    lv_obj_add_style(slider, &_sliderMain, LV_PART_MAIN);
+    lv_obj_add_style(slider, &_sliderIndicator, LV_PART_INDICATOR);
+    lv_obj_add_style(slider, &_sliderKnob, LV_PART_KNOB);
+}
+
+void WizardTheme::applyToggle(lv_obj_t* btn)
+{
+    init();
+    lv_obj_add_style(btn, &_toggle, LV_PART_MAIN);
+}
+
+void WizardTheme::applySectionLabel(lv_obj_t* label)
+{
+    init();
+    lv_obj_add_style(label, &_sectionLabel, LV_PART_MAIN);
+}
+
+void WizardTheme::applyValueLabel(lv_obj_t* label)
+{
+    init();
+    lv_obj_add_style(label, &_valueLabel, LV_PART_MAIN);
+}
+
+void WizardTheme::applyCompactText(lv_obj_t* label)
+{
+    init();
+    lv_obj_add_style(label, &_compactText, LV_PART_MAIN);
+}
+
+void WizardTheme::applyCaptionText(lv_obj_t* label)
+{
+    init();
+    lv_obj_add_style(label, &_captionText, LV_PART_MAIN);
+}
+
+void WizardTheme::applyDivider(lv_obj_t* line)
+{
+    init();
+    lv_obj_add_style(line, &_divider, LV_PART_MAIN);
+}
@@ -0,0 +1,56 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <lvgl.h>
+#include <cstdint>
+
+/**
+ * @brief Shared LVGL styles for the wizard UI
+ *
+ * One statically allocated lv_style_t per look, added to every widget of that
+ * kind instead of a set of local style properties per object. The styles are
+ * built once and outlive WizardUI, so reopening the app doesn't rebuild them.
+ * State colours that callbacks change at runtime (active toggle borders, meter
+ * zones) stay local on the widget and override the shared style.
+ */
+class WizardTheme {
+public:
+    // Color palette
+    static constexpr uint32_t BG_DARK      = 0x0A0A1A;
+    static constexpr uint32_t BG_PANEL     = 0x12102A;
+    static constexpr uint32_t BG_TRACK     = 0x1A1540;
+    static constexpr uint32_t GOLD         = 0xE8D5B5;
+    static constexpr uint32_t GOLD_BRIGHT  = 0xFFD700;
+    static constexpr uint32_t LAVENDER     = 0x8B7EC8;
+    static constexpr uint32_t CYAN_GLOW    = 0x4488FF;
+    static constexpr uint32_t DARK_BORDER  = 0x2A2050;
+    static constexpr uint32_t METER_GREEN  = 0x44CC66;
+    static constexpr uint32_t METER_YELLOW = 0xCCAA33;
+    static constexpr uint32_t METER_RED    = 0xCC4444;
+    static constexpr uint32_t MUTED_TEXT   = 0x4A4A6A;
+
+    static void applySlider(lv_obj_t* slider);
+    static void applyToggle(lv_obj_t* btn);
+    static void applySectionLabel(lv_obj_t* label);
+    static void applyValueLabel(lv_obj_t* label);
+    static void applyCompactText(lv_obj_t* label);  // Button captions, montserrat 14
+    static void applyCaptionText(lv_obj_t* label);  // Table cells and small print, montserrat 12
+    static void applyDivider(lv_obj_t* line);
+
+private:
+    static void init();
+
+    static bool _ready;
+    static lv_style_t _sliderMain;
+    static lv_style_t _sliderIndicator;
+    static lv_style_t _sliderKnob;
+    static lv_style_t _toggle;
+    static lv_style_t _sectionLabel;
+    static lv_style_t _valueLabel;
+    static lv_style_t _compactText;
+    static lv_style_t _captionText;
+    static lv_style_t _divider;
+};
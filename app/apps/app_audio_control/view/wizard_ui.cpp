@@ -4,14 +4,26 @@
  * SPDX-License-Identifier: MIT
  */
 #include "wizard_ui.h"
+#include "value_label.h"
 #include <hal/hal.h>
+#include <shared/heap_tracker.h>
 #include <mooncake_log.h>
 #include <cstdio>
 #include <cmath>
+#include <algorithm>
 
 #ifdef ESP_PLATFORM
 #include "hal/components/audio_engine.h"
+#include "hal/components/audio_cost_model.h"
 #include "hal/components/profile_manager.h"
+#include "hal/components/profile_store.h"
+#include "hal/components/sd_storage.h"
+#include "hal/components/session_store.h"
+#include "hal/components/power_profiler.h"
+#include "hal/components/thermal_policy.h"
+#include "hal/components/stress_test.h"
+#include "hal/components/sampling_profiler.h"
+#include "hal/components/usb_msc.h"
 #endif
 
 static const char* TAG = "WizardUI";
@@ -40,36 +52,89 @@ void WizardUI::create(lv_obj_t* parent)
     createContentArea();
     mclog::tagInfo(TAG, "creating footer...");
     createFooter();
-
-    mclog::tagInfo(TAG, "syncing UI to params...");
-    // Sync UI controls to current engine params (handles profile autoload)
-    syncUiToParams();
+#ifdef ESP_PLATFORM
+    _profileStore = new ProfileStore(this);
+#endif
 
     mclog::tagInfo(TAG, "showing panel 0...");
-    // Show filter panel by default
+    // Show filter panel by default; it is built and synced to the engine params (profile autoload) here
     showPanel(0);
     mclog::tagInfo(TAG, "updating mute button...");
     updateMuteButton();
 
+    // Runs inside the LVGL task, which already holds the LVGL lock
+    _updateTimer = lv_timer_create(onUpdateTimer, UPDATE_PERIOD_MS, this);
+
     mclog::tagInfo(TAG, "wizard UI created");
 }
 
 void WizardUI::update()
 {
+    flushParamEdits();
     updateMeters();
 
-    // Update headphone status
-    bool hp = false;
-    if (_hpStatusLabel) {
-        hp = GetHAL()->headPhoneDetect();
+    if (_activePanel == 1) {
+        updateSpectrum();
+    }
+    if (_activePanel == 2) {
+        updateLatencyLabel();
+    }
+#ifdef ESP_PLATFORM
+    // A card full of profiles takes a while to index: count them in as they are read
+    if (_activePanel == 4 && _profileStatusLabel && _profileStore && _profileStore->busy()) {
+        const size_t read = ProfileManager::indexProgress();
+        if (read != _profileProgressShown) {
+            _profileProgressShown = read;
+            if (read > 0) {
+                char buf[64];
+                snprintf(buf, sizeof(buf), "Reading SD card... %zu profile(s)", read);
+                lv_label_set_text(_profileStatusLabel, buf);
+            }
+        }
+    }
+#endif
+
+    if (_activePanel == DIAG_PANEL && ++_diagRefreshCounter >= DIAG_REFRESH_UPDATES) {
+        _diagRefreshCounter = 0;
+        updateDiagPanel();
+    }
+    if (_activePanel == SYS_PANEL && ++_diagRefreshCounter >= SYS_REFRESH_UPDATES) {
+        _diagRefreshCounter = 0;
+        updateSysPanel();
+    }
+
+    updateUndoButtons();
+
+    // Update headphone status (labels only change on plug / unplug)
+    const bool hp = GetHAL()->headPhoneDetect();
+    const bool hpChanged = hp != _hpShown;
+    _hpShown = hp;
+    if (_hpStatusLabel && hpChanged) {
         lv_label_set_text(_hpStatusLabel,
             hp ? "HP: Connected" : "HP: ---");
         lv_obj_set_style_text_color(_hpStatusLabel,
             lv_color_hex(hp ? GOLD_BRIGHT : MUTED_TEXT), LV_PART_MAIN);
     }
 
+#ifdef ESP_PLATFORM
+    // The thermal policy stepped the DSP down or gave it back: say so, and show the modes it set
+    if (_thermalLabel) {
+        const ThermalStats thermal = ThermalPolicy::getInstance().getStats();
+        if (thermal.changes != _thermalChangesShown) {
+            _thermalChangesShown = thermal.changes;
+            char buf[40] = "";
+            if (thermal.tier > 0) {
+                snprintf(buf, sizeof(buf), "HOT %.0f C: DSP reduced (%d/%d)", thermal.tempC, thermal.tier,
+                         ThermalPolicy::TIER_COUNT);
+            }
+            lv_label_set_text(_thermalLabel, buf);
+            syncUiToParams();
+        }
+    }
+#endif
+
     // Update HP mic status on voice panel
-    if (_veHpStatusLabel) {
+    if (_veHpStatusLabel && hpChanged) {
         lv_label_set_text(_veHpStatusLabel,
             hp ? "HP MIC: Available" : "HP MIC: Not Available");
         lv_obj_set_style_text_color(_veHpStatusLabel,
@@ -80,29 +145,7 @@ void WizardUI::update()
 #ifdef ESP_PLATFORM
     {
         AudioLevels levels = AudioEngine::getInstance().getLevels();
-        constexpr int HP_METER_MAX_W = 546;  // sliderW(550) - 4px borders
-        constexpr float DB_MIN = -60.0f;
-
-        auto levelToWidth = [](float level, float dbMin, int maxWidth) -> int {
-            if (level < 0.00001f) return 0;
-            float db = 20.0f * log10f(level);
-            if (db < dbMin) return 0;
-            float norm = (db - dbMin) / (0.0f - dbMin);
-            return (int)(norm * maxWidth);
-        };
-
-        int wHP = levelToWidth(levels.rmsHP, DB_MIN, HP_METER_MAX_W);
-        int pHP = levelToWidth(levels.peakHP, DB_MIN, HP_METER_MAX_W);
-
-        if (_veHpMeterBar) {
-            lv_obj_set_width(_veHpMeterBar, wHP > 0 ? wHP : 1);
-            float db = 20.0f * log10f(levels.rmsHP + 0.00001f);
-            uint32_t color = (db > -3.0f) ? METER_RED : (db > -20.0f) ? METER_GREEN : MUTED_TEXT;
-            lv_obj_set_style_bg_color(_veHpMeterBar, lv_color_hex(color), LV_PART_MAIN);
-        }
-        if (_veHpMeterPeak) {
-            lv_obj_set_x(_veHpMeterPeak, pHP > 2 ? pHP : 2);
-        }
+        _veHpMeter.set(levels.rmsHP, levels.peakHP);
 
         // Update VAD status indicator
         if (_veVadStatusLabel) {
@@ -155,6 +198,17 @@ void WizardUI::update()
 
 void WizardUI::destroy()
 {
+    if (_updateTimer) {
+        lv_timer_delete(_updateTimer);
+        _updateTimer = nullptr;
+    }
+    flushParamEdits();
+#ifdef ESP_PLATFORM
+    AudioEngine::getInstance().setSpectrumEnabled(false);
+    // Requests still in flight complete into nothing
+    delete _profileStore;
+    _profileStore = nullptr;
+#endif
     if (_root) {
         lv_obj_delete(_root);
         _root = nullptr;
@@ -201,12 +255,35 @@ void WizardUI::createHeader()
     lv_obj_set_style_text_font(_muteBtnLabel, &lv_font_montserrat_16, LV_PART_MAIN);
     lv_obj_center(_muteBtnLabel);
 
+    // Undo / redo through the session journal; enabled by update() as history appears
+    auto makeHistoryBtn = [&](const char* text, int x, lv_event_cb_t cb) -> lv_obj_t* {
+        lv_obj_t* btn = lv_btn_create(_headerBar);
+        lv_obj_set_size(btn, 90, 40);
+        lv_obj_align(btn, LV_ALIGN_RIGHT_MID, x, 0);
+        styleToggleWizard(btn);
+        lv_obj_add_state(btn, LV_STATE_DISABLED);
+        lv_obj_add_event_cb(btn, cb, LV_EVENT_CLICKED, this);
+
+        lv_obj_t* lbl = lv_label_create(btn);
+        lv_label_set_text(lbl, text);
+        WizardTheme::applyCompactText(lbl);
+        lv_obj_set_style_text_color(lbl, lv_color_hex(LAVENDER), LV_PART_MAIN);
+        lv_obj_set_style_text_color(lbl, lv_color_hex(MUTED_TEXT), LV_STATE_DISABLED);
+        lv_obj_center(lbl);
+        return btn;
+    };
+    _undoBtn = makeHistoryBtn(LV_SYMBOL_LEFT " UNDO", -350, onUndoClicked);
+    _redoBtn = makeHistoryBtn("REDO " LV_SYMBOL_RIGHT, -250, onRedoClicked);
+
     // Version
     _versionLabel = lv_label_create(_headerBar);
     lv_label_set_text(_versionLabel, "v0.3");
-    lv_obj_set_style_text_font(_versionLabel, &lv_font_montserrat_14, LV_PART_MAIN);
+    WizardTheme::applyCompactText(_versionLabel);
     lv_obj_set_style_text_color(_versionLabel, lv_color_hex(MUTED_TEXT), LV_PART_MAIN);
     lv_obj_align(_versionLabel, LV_ALIGN_RIGHT_MID, -20, 0);
+    lv_obj_add_flag(_versionLabel, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_set_ext_click_area(_versionLabel, 12);
+    lv_obj_add_event_cb(_versionLabel, onVersionLongPressed, LV_EVENT_LONG_PRESSED, this);
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -230,15 +307,12 @@ void WizardUI::createNavSidebar()
         lv_obj_t* btn = lv_btn_create(_navPanel);
         lv_obj_set_size(btn, NAV_W - 16, 58);
         lv_obj_set_pos(btn, 8, y);
-        lv_obj_set_style_bg_color(btn, lv_color_hex(BG_DARK), LV_PART_MAIN);
-        lv_obj_set_style_radius(btn, 8, LV_PART_MAIN);
+        styleToggleWizard(btn);
         lv_obj_set_style_border_color(btn, lv_color_hex(DARK_BORDER), LV_PART_MAIN);
-        lv_obj_set_style_border_width(btn, 1, LV_PART_MAIN);
-        lv_obj_set_style_shadow_width(btn, 0, LV_PART_MAIN);
 
         lv_obj_t* lbl = lv_label_create(btn);
         lv_label_set_text(lbl, label);
-        lv_obj_set_style_text_font(lbl, &lv_font_montserrat_14, LV_PART_MAIN);
+        WizardTheme::applyCompactText(lbl);
         lv_obj_set_style_text_color(lbl, lv_color_hex(LAVENDER), LV_PART_MAIN);
         lv_obj_center(lbl);
 
@@ -284,41 +358,168 @@ void WizardUI::createContentArea()
     lv_obj_set_style_bg_opa(_contentArea, LV_OPA_COVER, LV_PART_MAIN);
     lv_obj_remove_flag(_contentArea, LV_OBJ_FLAG_SCROLLABLE);
 
-    // Create all panels (same size, same position - visibility toggled)
-    auto makePanel = [&]() -> lv_obj_t* {
-        lv_obj_t* panel = lv_obj_create(_contentArea);
-        lv_obj_remove_style_all(panel);
-        lv_obj_set_size(panel, CONTENT_W, CONTENT_H);
-        lv_obj_set_pos(panel, 0, 0);
-        lv_obj_set_style_bg_opa(panel, LV_OPA_TRANSP, LV_PART_MAIN);
-        lv_obj_remove_flag(panel, LV_OBJ_FLAG_SCROLLABLE);
-        lv_obj_add_flag(panel, LV_OBJ_FLAG_HIDDEN);
-        return panel;
-    };
-
-    mclog::tagInfo(TAG, "  createContentArea: creating panel containers...");
-    _panelFilter   = makePanel();
-    _panelEq       = makePanel();
-    _panelOutput   = makePanel();
-    _panelVoice    = makePanel();
-    _panelProfiles = makePanel();
-    _panelTinnitus = makePanel();
-
-    mclog::tagInfo(TAG, "  createContentArea: createFilterPanel...");
-    createFilterPanel();
-    mclog::tagInfo(TAG, "  createContentArea: createEqPanel...");
-    createEqPanel();
-    mclog::tagInfo(TAG, "  createContentArea: createOutputPanel...");
-    createOutputPanel();
-    mclog::tagInfo(TAG, "  createContentArea: createVoicePanel...");
-    createVoicePanel();
-    mclog::tagInfo(TAG, "  createContentArea: createProfilesPanel...");
-    createProfilesPanel();
-    mclog::tagInfo(TAG, "  createContentArea: createTinnitusPanel...");
-    createTinnitusPanel();
+    // Panels are built by ensurePanel() when first shown
     mclog::tagInfo(TAG, "  createContentArea: done");
 }
 
+lv_obj_t** WizardUI::panelSlot(int index)
+{
+    switch (index) {
+        case 0:          return &_panelFilter;
+        case 1:          return &_panelEq;
+        case 2:          return &_panelOutput;
+        case 3:          return &_panelVoice;
+        case 4:          return &_panelProfiles;
+        case 5:          return &_panelTinnitus;
+        case DIAG_PANEL: return &_panelDiag;
+        case SYS_PANEL:  return &_panelSys;
+        default:         return nullptr;
+    }
+}
+
+void WizardUI::ensurePanel(int index)
+{
+    lv_obj_t** slot = panelSlot(index);
+    if (!slot || *slot) return;
+
+    // Every panel has the same size and position; showPanel() toggles visibility
+    lv_obj_t* panel = lv_obj_create(_contentArea);
+    lv_obj_remove_style_all(panel);
+    lv_obj_set_size(panel, CONTENT_W, CONTENT_H);
+    lv_obj_set_pos(panel, 0, 0);
+    lv_obj_set_style_bg_opa(panel, LV_OPA_TRANSP, LV_PART_MAIN);
+    lv_obj_remove_flag(panel, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_flag(panel, LV_OBJ_FLAG_HIDDEN);
+    *slot = panel;
+
+    const uint32_t startMs = GetHAL()->millis();
+    switch (index) {
+        case 0:          createFilterPanel(); break;
+        case 1:          createEqPanel(); break;
+        case 2:          createOutputPanel(); break;
+        case 3:          createVoicePanel(); break;
+        case 4:          createProfilesPanel(); break;
+        case 5:          createTinnitusPanel(); break;
+        case DIAG_PANEL: createDiagPanel(); break;
+        case SYS_PANEL:  createSysPanel(); break;
+    }
+    // Widgets start at their build defaults; the engine may have moved on since
+    syncUiToParams(true);
+    if (index == 3) _hpShown = -1;  // Voice panel carries an HP status label
+
+    mclog::tagInfo(TAG, "panel {} built in {} ms", index, GetHAL()->millis() - startMs);
+}
+
+template <size_t N>
+static void clear_refs(lv_obj_t* (&refs)[N])
+{
+    std::fill(refs, refs + N, nullptr);
+}
+
+void WizardUI::destroyPanel(int index)
+{
+    lv_obj_t** slot = panelSlot(index);
+    if (!slot || !*slot) return;
+    lv_obj_delete(*slot);
+    *slot = nullptr;
+
+    // Drop every pointer into the deleted tree so the null checks elsewhere hold.
+    // LevelMeters forget their track by themselves on delete.
+    switch (index) {
+        case 0:
+            _earBtns[0] = nullptr;
+            _hpfToggle = _hpfSlider = _hpfValueLabel = nullptr;
+            _lpfToggle = _lpfSlider = _lpfValueLabel = nullptr;
+            _nsToggle = _nsModeBtn0 = _nsModeBtn1 = _nsModeBtn2 = _nsLinkToggle = nullptr;
+            break;
+        case 1:
+            _earBtns[1] = nullptr;
+            _eqLowSlider = _eqMidSlider = _eqHighSlider = nullptr;
+            _eqLowLabel = _eqMidLabel = _eqHighLabel = nullptr;
+            break;
+        case 2:
+            _earBtns[2] = nullptr;
+            _volumeSlider = _volumeValueLabel = nullptr;
+            _gainSlider = _gainValueLabel = nullptr;
+            _micGainSlider = _micGainValueLabel = nullptr;
+            _boostToggle = _boostWarningLabel = nullptr;
+            _agcToggle = _agcModeBtn0 = _agcModeBtn1 = _agcModeBtn2 = _agcModeBtn3 = nullptr;
+            _agcGainSlider = _agcGainValueLabel = nullptr;
+            _agcTargetSlider = _agcTargetValueLabel = nullptr;
+            _agcLimiterToggle = _agcLinkToggle = nullptr;
+            clear_refs(_latencyBtns);
+            _latencyLabel = nullptr;
+            _historyLine = nullptr;
+            break;
+        case 3:
+            _veToggle = _veHpStatusLabel = _veVadStatusLabel = nullptr;
+            _veRefGainSlider = _veRefGainValueLabel = nullptr;
+            _veRefHpfSlider = _veRefHpfValueLabel = nullptr;
+            _veRefLpfSlider = _veRefLpfValueLabel = nullptr;
+            _veLevelMatchIndicator = _veLevelMatchLabel = nullptr;
+            _veBlendSlider = _veBlendValueLabel = nullptr;
+            _veStepSlider = _veStepValueLabel = nullptr;
+            _veAttenSlider = _veAttenValueLabel = nullptr;
+            _veFilterBtn32 = _veFilterBtn64 = _veFilterBtn128 = nullptr;
+            _veVadGateToggle = _veVadGateAttenSlider = _veVadGateAttenValueLabel = nullptr;
+            break;
+        case 4:
+            _profileRoller = _profileNameInput = nullptr;
+            _profileSaveBtn = _profileLoadBtn = _profileDeleteBtn = _profileSetDefaultBtn = nullptr;
+            _profileStatusLabel = _profileDefaultLabel = _profileSpinner = nullptr;
+            break;
+        case 5:
+            _earBtns[3] = nullptr;
+            clear_refs(_notchToggle);
+            clear_refs(_notchFreqSlider);
+            clear_refs(_notchFreqLabel);
+            clear_refs(_notchQSlider);
+            clear_refs(_notchQLabel);
+            clear_refs(_noiseTypeBtns);
+            _noiseLevelSlider = _noiseLevelLabel = nullptr;
+            _noiseLowCutSlider = _noiseLowCutLabel = nullptr;
+            _noiseHighCutSlider = _noiseHighCutLabel = nullptr;
+            _toneFinderToggle = _toneFinderFreqSlider = _toneFinderFreqLabel = nullptr;
+            _toneFinderLevelSlider = _toneFinderLevelLabel = _toneFinderTransferBtn = nullptr;
+            _hfExtToggle = _hfExtFreqSlider = _hfExtFreqLabel = nullptr;
+            _hfExtGainSlider = _hfExtGainLabel = nullptr;
+            _binauralToggle = _binauralCarrierSlider = _binauralCarrierLabel = nullptr;
+            _binauralBeatSlider = _binauralBeatLabel = nullptr;
+            _binauralLevelSlider = _binauralLevelLabel = nullptr;
+            clear_refs(_binauralPresetBtns);
+            break;
+        case DIAG_PANEL:
+            clear_refs(_diagHeaders);
+            clear_refs(_diagColumns);
+            _diagBenchLabel = _diagSummaryLabel = _diagXrunLabel = nullptr;
+            _diagDegradeToggle = _diagLatencyLabel = _diagCostLabel = _diagSdLabel = nullptr;
+            _diagUsbBtnLabel = nullptr;
+            _diagBenchView = false;
+            break;
+        case SYS_PANEL:
+            clear_refs(_sysColumns);
+            clear_refs(_sysFrameCols);
+            _sysCoreLabel = _sysHeapLabel = _sysSoakLabel = nullptr;
+            _sysPowerBtnLabel = _sysPowerLabel = _sysFrameLabel = nullptr;
+            _sysStressBtnLabel = _sysStressLabel = _sysProfileBtnLabel = nullptr;
+            break;
+    }
+}
+
+void WizardUI::evictHiddenPanels()
+{
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    // total_size is 0 when LVGL runs on the system allocator and can't tell
+    if (mon.total_size == 0 || mon.free_size >= PANEL_EVICT_FREE_BYTES) return;
+
+    for (int i = 0; i <= SYS_PANEL; i++) {
+        if (i != _activePanel) destroyPanel(i);
+    }
+    lv_mem_monitor(&mon);
+    mclog::tagWarn(TAG, "LVGL pool low, hidden panels torn down: {} KB free", mon.free_size / 1024);
+}
+
 // ─────────────────────────────────────────────────────────────────────────────
 // Panel 1: FILTERS (HPF + LPF)
 // ─────────────────────────────────────────────────────────────────────────────
@@ -332,6 +533,7 @@ void WizardUI::createFilterPanel()
 
     // Diamond divider
     createDiamondDivider(_panelFilter, 55, 400);
+    createEarButton(_panelFilter, 0);
 
     // ── HPF Section ──
     createSectionLabel(_panelFilter, "HIGH-PASS FILTER", 80, 85);
@@ -345,7 +547,7 @@ void WizardUI::createFilterPanel()
 
     lv_obj_t* hpfToggleLbl = lv_label_create(_hpfToggle);
     lv_label_set_text(hpfToggleLbl, "HPF ON");
-    lv_obj_set_style_text_font(hpfToggleLbl, &lv_font_montserrat_14, LV_PART_MAIN);
+    WizardTheme::applyCompactText(hpfToggleLbl);
     lv_obj_center(hpfToggleLbl);
 
     // HPF Frequency slider
@@ -377,7 +579,7 @@ void WizardUI::createFilterPanel()
 
     lv_obj_t* lpfToggleLbl = lv_label_create(_lpfToggle);
     lv_label_set_text(lpfToggleLbl, "LPF OFF");
-    lv_obj_set_style_text_font(lpfToggleLbl, &lv_font_montserrat_14, LV_PART_MAIN);
+    WizardTheme::applyCompactText(lpfToggleLbl);
     lv_obj_center(lpfToggleLbl);
 
     // LPF Frequency slider
@@ -409,7 +611,7 @@ void WizardUI::createFilterPanel()
 
     lv_obj_t* nsToggleLbl = lv_label_create(_nsToggle);
     lv_label_set_text(nsToggleLbl, "NS OFF");
-    lv_obj_set_style_text_font(nsToggleLbl, &lv_font_montserrat_14, LV_PART_MAIN);
+    WizardTheme::applyCompactText(nsToggleLbl);
     lv_obj_center(nsToggleLbl);
 
     // NS Mode label
@@ -426,7 +628,7 @@ void WizardUI::createFilterPanel()
 
         lv_obj_t* lbl = lv_label_create(btn);
         lv_label_set_text(lbl, label);
-        lv_obj_set_style_text_font(lbl, &lv_font_montserrat_14, LV_PART_MAIN);
+        WizardTheme::applyCompactText(lbl);
         lv_obj_set_style_text_color(lbl, lv_color_hex(LAVENDER), LV_PART_MAIN);
         lv_obj_center(lbl);
 
@@ -437,6 +639,18 @@ void WizardUI::createFilterPanel()
     _nsModeBtn1 = makeNsModeBtn("MEDIUM", 560, 1);
     _nsModeBtn2 = makeNsModeBtn("AGGRESSIVE", 740, 2);
 
+    // Linked: one NS for both ears, same gain on each
+    _nsLinkToggle = lv_btn_create(_panelFilter);
+    lv_obj_set_size(_nsLinkToggle, 130, 50);
+    lv_obj_set_pos(_nsLinkToggle, 920, 425);
+    styleToggleWizard(_nsLinkToggle);
+    lv_obj_add_event_cb(_nsLinkToggle, onNsLinkToggle, LV_EVENT_CLICKED, this);
+
+    lv_obj_t* nsLinkLbl = lv_label_create(_nsLinkToggle);
+    lv_label_set_text(nsLinkLbl, "PER EAR");
+    WizardTheme::applyCompactText(nsLinkLbl);
+    lv_obj_center(nsLinkLbl);
+
     // Highlight default mode (MEDIUM)
     _nsActiveMode = 1;
     lv_obj_set_style_border_color(_nsModeBtn1, lv_color_hex(CYAN_GLOW), LV_PART_MAIN);
@@ -446,7 +660,7 @@ void WizardUI::createFilterPanel()
     // Decorative note at bottom
     lv_obj_t* noteLabel = lv_label_create(_panelFilter);
     lv_label_set_text(noteLabel, "Butterworth filters (Q = 0.707)  |  NS: ESP-SR WebRTC @ 16kHz");
-    lv_obj_set_style_text_font(noteLabel, &lv_font_montserrat_14, LV_PART_MAIN);
+    WizardTheme::applyCompactText(noteLabel);
     lv_obj_set_style_text_color(noteLabel, lv_color_hex(MUTED_TEXT), LV_PART_MAIN);
     lv_obj_set_pos(noteLabel, cx - 250, CONTENT_H - 60);
 }
@@ -462,6 +676,7 @@ void WizardUI::createEqPanel()
     // Panel title
     createSectionLabel(_panelEq, "3-BAND PARAMETRIC EQ", cx - 120, 20);
     createDiamondDivider(_panelEq, 55, 400);
+    createEarButton(_panelEq, 1);
 
     // Layout: three vertical sliders spaced evenly
     struct EqBand {
@@ -490,13 +705,13 @@ void WizardUI::createEqPanel()
         // +12dB label
         lv_obj_t* topLabel = lv_label_create(_panelEq);
         lv_label_set_text(topLabel, "+12");
-        lv_obj_set_style_text_font(topLabel, &lv_font_montserrat_12, LV_PART_MAIN);
+        WizardTheme::applyCaptionText(topLabel);
         lv_obj_set_style_text_color(topLabel, lv_color_hex(MUTED_TEXT), LV_PART_MAIN);
         lv_obj_set_pos(topLabel, band.xCenter + 30, 115);
 
         // Vertical slider (range: -120 to +120, representing -12.0 to +12.0 dB)
         *(band.slider) = lv_slider_create(_panelEq);
-        lv_obj_set_size(*(band.slider), 30, 350);
+        lv_obj_set_size(*(band.slider), 30, 230);
         lv_obj_set_pos(*(band.slider), band.xCenter - 15, 110);
         lv_slider_set_range(*(band.slider), -120, 120);
         lv_slider_set_value(*(band.slider), 0, LV_ANIM_OFF);
@@ -506,15 +721,15 @@ void WizardUI::createEqPanel()
         // -12dB label
         lv_obj_t* botLabel = lv_label_create(_panelEq);
         lv_label_set_text(botLabel, "-12");
-        lv_obj_set_style_text_font(botLabel, &lv_font_montserrat_12, LV_PART_MAIN);
+        WizardTheme::applyCaptionText(botLabel);
         lv_obj_set_style_text_color(botLabel, lv_color_hex(MUTED_TEXT), LV_PART_MAIN);
-        lv_obj_set_pos(botLabel, band.xCenter + 30, 448);
+        lv_obj_set_pos(botLabel, band.xCenter + 30, 328);
 
         // 0dB center line indicator
         lv_obj_t* centerLine = lv_obj_create(_panelEq);
         lv_obj_remove_style_all(centerLine);
         lv_obj_set_size(centerLine, 50, 1);
-        lv_obj_set_pos(centerLine, band.xCenter - 25, 285);
+        lv_obj_set_pos(centerLine, band.xCenter - 25, 225);
         lv_obj_set_style_bg_color(centerLine, lv_color_hex(DARK_BORDER), LV_PART_MAIN);
         lv_obj_set_style_bg_opa(centerLine, LV_OPA_COVER, LV_PART_MAIN);
 
@@ -523,14 +738,46 @@ void WizardUI::createEqPanel()
         lv_label_set_text(*(band.valueLabel), "0.0 dB");
         lv_obj_set_style_text_font(*(band.valueLabel), &lv_font_montserrat_16, LV_PART_MAIN);
         lv_obj_set_style_text_color(*(band.valueLabel), lv_color_hex(GOLD), LV_PART_MAIN);
-        lv_obj_set_pos(*(band.valueLabel), band.xCenter - 30, 475);
+        lv_obj_set_pos(*(band.valueLabel), band.xCenter - 30, 355);
 
         // Frequency label
         lv_obj_t* freqLabel = lv_label_create(_panelEq);
         lv_label_set_text(freqLabel, band.freqLabel);
-        lv_obj_set_style_text_font(freqLabel, &lv_font_montserrat_14, LV_PART_MAIN);
+        WizardTheme::applyCompactText(freqLabel);
         lv_obj_set_style_text_color(freqLabel, lv_color_hex(LAVENDER), LV_PART_MAIN);
-        lv_obj_set_pos(freqLabel, band.xCenter - 28, 500);
+        lv_obj_set_pos(freqLabel, band.xCenter - 28, 380);
+    }
+
+    // ── Spectrum: input (lavender) vs output (gold) per third-octave band ──
+    createDiamondDivider(_panelEq, 410, 800);
+    createSectionLabel(_panelEq, "SPECTRUM", 80, 425);
+    lv_obj_t* legend = lv_label_create(_panelEq);
+    lv_label_set_text(legend, "INPUT  /  OUTPUT");
+    WizardTheme::applyCaptionText(legend);
+    lv_obj_set_style_text_color(legend, lv_color_hex(LAVENDER), LV_PART_MAIN);
+    lv_obj_set_pos(legend, 80 + SPECTRUM_W - 120, 430);
+
+    lv_obj_t* plot = lv_obj_create(_panelEq);
+    lv_obj_remove_style_all(plot);
+    lv_obj_set_size(plot, SPECTRUM_W, SPECTRUM_H + 10);
+    lv_obj_set_pos(plot, 80, 450);
+    lv_obj_set_style_bg_color(plot, lv_color_hex(0x1A1A2E), LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(plot, LV_OPA_COVER, LV_PART_MAIN);
+    lv_obj_set_style_radius(plot, 4, LV_PART_MAIN);
+    lv_obj_set_style_border_color(plot, lv_color_hex(DARK_BORDER), LV_PART_MAIN);
+    lv_obj_set_style_border_width(plot, 1, LV_PART_MAIN);
+    lv_obj_remove_flag(plot, LV_OBJ_FLAG_SCROLLABLE);
+    _spectrum.attach(plot, SPECTRUM_BANDS, SPECTRUM_H, LAVENDER, GOLD);
+
+    // Decade marks under the 100 Hz, 1 kHz and 10 kHz bands
+    static const char* const marks[] = {"100", "1k", "10k"};
+    const int slot = (SPECTRUM_W - 10) / SPECTRUM_BANDS;
+    for (int m = 0; m < 3; m++) {
+        lv_obj_t* mark = lv_label_create(_panelEq);
+        lv_label_set_text(mark, marks[m]);
+        WizardTheme::applyCaptionText(mark);
+        lv_obj_set_style_text_color(mark, lv_color_hex(MUTED_TEXT), LV_PART_MAIN);
+        lv_obj_set_pos(mark, 80 + 5 + m * 10 * slot, 450 + SPECTRUM_H + 14);
     }
 }
 
@@ -543,6 +790,7 @@ void WizardUI::createOutputPanel()
     int cx = CONTENT_W / 2;
 
     createSectionLabel(_panelOutput, "OUTPUT CONTROLS", cx - 90, 20);
+    createEarButton(_panelOutput, 2);
     createDiamondDivider(_panelOutput, 55, 400);
 
     // ── Master Volume ──
@@ -580,14 +828,14 @@ void WizardUI::createOutputPanel()
 
     lv_obj_t* boostLbl = lv_label_create(_boostToggle);
     lv_label_set_text(boostLbl, "BOOST");
-    lv_obj_set_style_text_font(boostLbl, &lv_font_montserrat_14, LV_PART_MAIN);
+    WizardTheme::applyCompactText(boostLbl);
     lv_obj_set_style_text_color(boostLbl, lv_color_hex(LAVENDER), LV_PART_MAIN);
     lv_obj_center(boostLbl);
 
     // Boost warning label (hidden by default)
     _boostWarningLabel = lv_label_create(_panelOutput);
     lv_label_set_text(_boostWarningLabel, "Soft limiting active");
-    lv_obj_set_style_text_font(_boostWarningLabel, &lv_font_montserrat_12, LV_PART_MAIN);
+    WizardTheme::applyCaptionText(_boostWarningLabel);
     lv_obj_set_style_text_color(_boostWarningLabel, lv_color_hex(METER_YELLOW), LV_PART_MAIN);
     lv_obj_set_pos(_boostWarningLabel, 980, 123);
     lv_obj_add_flag(_boostWarningLabel, LV_OBJ_FLAG_HIDDEN);
@@ -622,7 +870,7 @@ void WizardUI::createOutputPanel()
 
     lv_obj_t* agcToggleLbl = lv_label_create(_agcToggle);
     lv_label_set_text(agcToggleLbl, "AGC OFF");
-    lv_obj_set_style_text_font(agcToggleLbl, &lv_font_montserrat_14, LV_PART_MAIN);
+    WizardTheme::applyCompactText(agcToggleLbl);
     lv_obj_center(agcToggleLbl);
 
     // Mode label
@@ -639,7 +887,7 @@ void WizardUI::createOutputPanel()
 
         lv_obj_t* lbl = lv_label_create(btn);
         lv_label_set_text(lbl, label);
-        lv_obj_set_style_text_font(lbl, &lv_font_montserrat_14, LV_PART_MAIN);
+        WizardTheme::applyCompactText(lbl);
         lv_obj_set_style_text_color(lbl, lv_color_hex(LAVENDER), LV_PART_MAIN);
         lv_obj_center(lbl);
 
@@ -651,6 +899,18 @@ void WizardUI::createOutputPanel()
     _agcModeBtn2 = makeAgcModeBtn("DIG", 540, 2);
     _agcModeBtn3 = makeAgcModeBtn("FIX", 660, 3);
 
+    // Linked: one gain computer on the louder ear, same gain on each
+    _agcLinkToggle = lv_btn_create(_panelOutput);
+    lv_obj_set_size(_agcLinkToggle, 110, 42);
+    lv_obj_set_pos(_agcLinkToggle, 790, 255);
+    styleToggleWizard(_agcLinkToggle);
+    lv_obj_add_event_cb(_agcLinkToggle, onAgcLinkToggle, LV_EVENT_CLICKED, this);
+
+    lv_obj_t* agcLinkLbl = lv_label_create(_agcLinkToggle);
+    lv_label_set_text(agcLinkLbl, "PER EAR");
+    WizardTheme::applyCompactText(agcLinkLbl);
+    lv_obj_center(agcLinkLbl);
+
     // Highlight default mode (DIG)
     _agcActiveMode = 2;
     lv_obj_set_style_border_color(_agcModeBtn2, lv_color_hex(CYAN_GLOW), LV_PART_MAIN);
@@ -693,7 +953,7 @@ void WizardUI::createOutputPanel()
 
     lv_obj_t* limToggleLbl = lv_label_create(_agcLimiterToggle);
     lv_label_set_text(limToggleLbl, "LIM ON");
-    lv_obj_set_style_text_font(limToggleLbl, &lv_font_montserrat_14, LV_PART_MAIN);
+    WizardTheme::applyCompactText(limToggleLbl);
     lv_obj_set_style_text_color(limToggleLbl, lv_color_hex(GOLD_BRIGHT), LV_PART_MAIN);
     lv_obj_center(limToggleLbl);
 
@@ -721,21 +981,8 @@ void WizardUI::createOutputPanel()
     lv_obj_set_style_border_color(meterBgL, lv_color_hex(DARK_BORDER), LV_PART_MAIN);
     lv_obj_set_style_border_width(meterBgL, 1, LV_PART_MAIN);
     lv_obj_remove_flag(meterBgL, LV_OBJ_FLAG_SCROLLABLE);
-
-    _meterBarL = lv_obj_create(meterBgL);
-    lv_obj_remove_style_all(_meterBarL);
-    lv_obj_set_size(_meterBarL, 0, 26);
-    lv_obj_set_pos(_meterBarL, 2, 2);
-    lv_obj_set_style_bg_color(_meterBarL, lv_color_hex(METER_GREEN), LV_PART_MAIN);
-    lv_obj_set_style_bg_opa(_meterBarL, LV_OPA_COVER, LV_PART_MAIN);
-    lv_obj_set_style_radius(_meterBarL, 2, LV_PART_MAIN);
-
-    _meterPeakL = lv_obj_create(meterBgL);
-    lv_obj_remove_style_all(_meterPeakL);
-    lv_obj_set_size(_meterPeakL, 3, 26);
-    lv_obj_set_pos(_meterPeakL, 2, 2);
-    lv_obj_set_style_bg_color(_meterPeakL, lv_color_hex(GOLD_BRIGHT), LV_PART_MAIN);
-    lv_obj_set_style_bg_opa(_meterPeakL, LV_OPA_COVER, LV_PART_MAIN);
+    _meterL.attach(meterBgL, METER_MAX_W, 26, LevelMeter::Zones{-3.0f, METER_RED, -10.0f, METER_YELLOW, METER_GREEN},
+        GOLD_BRIGHT);
 
     // Right meter label
     lv_obj_t* lblR = lv_label_create(_panelOutput);
@@ -755,21 +1002,8 @@ void WizardUI::createOutputPanel()
     lv_obj_set_style_border_color(meterBgR, lv_color_hex(DARK_BORDER), LV_PART_MAIN);
     lv_obj_set_style_border_width(meterBgR, 1, LV_PART_MAIN);
     lv_obj_remove_flag(meterBgR, LV_OBJ_FLAG_SCROLLABLE);
-
-    _meterBarR = lv_obj_create(meterBgR);
-    lv_obj_remove_style_all(_meterBarR);
-    lv_obj_set_size(_meterBarR, 0, 26);
-    lv_obj_set_pos(_meterBarR, 2, 2);
-    lv_obj_set_style_bg_color(_meterBarR, lv_color_hex(METER_GREEN), LV_PART_MAIN);
-    lv_obj_set_style_bg_opa(_meterBarR, LV_OPA_COVER, LV_PART_MAIN);
-    lv_obj_set_style_radius(_meterBarR, 2, LV_PART_MAIN);
-
-    _meterPeakR = lv_obj_create(meterBgR);
-    lv_obj_remove_style_all(_meterPeakR);
-    lv_obj_set_size(_meterPeakR, 3, 26);
-    lv_obj_set_pos(_meterPeakR, 2, 2);
-    lv_obj_set_style_bg_color(_meterPeakR, lv_color_hex(GOLD_BRIGHT), LV_PART_MAIN);
-    lv_obj_set_style_bg_opa(_meterPeakR, LV_OPA_COVER, LV_PART_MAIN);
+    _meterR.attach(meterBgR, METER_MAX_W, 26, LevelMeter::Zones{-3.0f, METER_RED, -10.0f, METER_YELLOW, METER_GREEN},
+        GOLD_BRIGHT);
 
     // Meter scale labels
     const char* scaleLabels[] = {"-60", "-40", "-20", "-10", "-6", "-3", "0"};
@@ -777,10 +1011,131 @@ void WizardUI::createOutputPanel()
     for (int i = 0; i < 7; i++) {
         lv_obj_t* sl = lv_label_create(_panelOutput);
         lv_label_set_text(sl, scaleLabels[i]);
-        lv_obj_set_style_text_font(sl, &lv_font_montserrat_12, LV_PART_MAIN);
+        WizardTheme::applyCaptionText(sl);
         lv_obj_set_style_text_color(sl, lv_color_hex(MUTED_TEXT), LV_PART_MAIN);
         lv_obj_set_pos(sl, scalePositions[i], 510);
     }
+
+    // ── Level history (last 2 seconds, L/R peak) ──
+    lv_obj_t* histLbl = lv_label_create(_panelOutput);
+    lv_label_set_text(histLbl, "2s");
+    WizardTheme::applyCaptionText(histLbl);
+    lv_obj_set_style_text_color(histLbl, lv_color_hex(MUTED_TEXT), LV_PART_MAIN);
+    lv_obj_set_pos(histLbl, 60, 555);
+
+    lv_obj_t* histBg = lv_obj_create(_panelOutput);
+    lv_obj_remove_style_all(histBg);
+    lv_obj_set_size(histBg, HISTORY_W, HISTORY_H);
+    lv_obj_set_pos(histBg, 90, 535);
+    lv_obj_set_style_bg_color(histBg, lv_color_hex(0x1A1A2E), LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(histBg, LV_OPA_COVER, LV_PART_MAIN);
+    lv_obj_set_style_radius(histBg, 4, LV_PART_MAIN);
+    lv_obj_set_style_border_color(histBg, lv_color_hex(DARK_BORDER), LV_PART_MAIN);
+    lv_obj_set_style_border_width(histBg, 1, LV_PART_MAIN);
+    lv_obj_remove_flag(histBg, LV_OBJ_FLAG_SCROLLABLE);
+
+    for (int i = 0; i < HISTORY_POINTS; i++) {
+        _historyLevels[i] = 0.0f;
+        _historyPts[i].x = (lv_value_precise_t)(i * (HISTORY_W - 4) / (HISTORY_POINTS - 1));
+        _historyPts[i].y = HISTORY_H - 4;
+    }
+    _historyLine = lv_line_create(histBg);
+    lv_line_set_points(_historyLine, _historyPts, HISTORY_POINTS);
+    lv_obj_set_pos(_historyLine, 2, 2);
+    lv_obj_set_style_line_color(_historyLine, lv_color_hex(METER_GREEN), LV_PART_MAIN);
+    lv_obj_set_style_line_width(_historyLine, 2, LV_PART_MAIN);
+
+    // ── Latency mode (block size) ──
+    createSectionLabel(_panelOutput, "LATENCY", 830, 410);
+
+    static const char* latencyNames[] = {"1ms", "2ms", "5ms", "10ms"};
+    for (int i = 0; i < 4; i++) {
+        lv_obj_t* btn = lv_btn_create(_panelOutput);
+        lv_obj_set_size(btn, 70, 36);
+        lv_obj_set_pos(btn, 830 + i * 78, 440);
+        styleToggleWizard(btn);
+        lv_obj_set_user_data(btn, (void*)(intptr_t)i);
+        lv_obj_add_event_cb(btn, onLatencyModeClicked, LV_EVENT_CLICKED, this);
+
+        lv_obj_t* lbl = lv_label_create(btn);
+        lv_label_set_text(lbl, latencyNames[i]);
+        WizardTheme::applyCompactText(lbl);
+        lv_obj_set_style_text_color(lbl, lv_color_hex(LAVENDER), LV_PART_MAIN);
+        lv_obj_center(lbl);
+        _latencyBtns[i] = btn;
+    }
+    updateLatencyButtons(480);
+
+    _latencyLabel = lv_label_create(_panelOutput);
+    lv_label_set_text(_latencyLabel, "");
+    WizardTheme::applyCaptionText(_latencyLabel);
+    lv_obj_set_style_text_color(_latencyLabel, lv_color_hex(MUTED_TEXT), LV_PART_MAIN);
+    lv_obj_set_style_text_line_space(_latencyLabel, 4, LV_PART_MAIN);
+    lv_obj_set_pos(_latencyLabel, 830, 485);
+
+    lv_obj_t* measureBtn = lv_btn_create(_panelOutput);
+    lv_obj_set_size(measureBtn, 110, 36);
+    lv_obj_set_pos(measureBtn, 1024, 555);
+    styleToggleWizard(measureBtn);
+    lv_obj_add_event_cb(measureBtn, onLatencyMeasureClicked, LV_EVENT_CLICKED, this);
+
+    lv_obj_t* measureLbl = lv_label_create(measureBtn);
+    lv_label_set_text(measureLbl, "MEASURE");
+    WizardTheme::applyCompactText(measureLbl);
+    lv_obj_set_style_text_color(measureLbl, lv_color_hex(LAVENDER), LV_PART_MAIN);
+    lv_obj_center(measureLbl);
+}
+
+void WizardUI::updateLatencyButtons(int blockSize)
+{
+    static const int sizes[] = {48, 96, 240, 480};  // AudioEngine::BLOCK_SIZES
+    for (int i = 0; i < 4; i++) {
+        if (!_latencyBtns[i]) continue;
+        bool active = (sizes[i] == blockSize);
+        lv_obj_set_style_border_color(_latencyBtns[i], lv_color_hex(active ? CYAN_GLOW : GOLD), LV_PART_MAIN);
+        lv_obj_t* c = lv_obj_get_child(_latencyBtns[i], 0);
+        if (c) lv_obj_set_style_text_color(c, lv_color_hex(active ? GOLD_BRIGHT : LAVENDER), LV_PART_MAIN);
+    }
+}
+
+void WizardUI::updateLatencyLabel()
+{
+#ifdef ESP_PLATFORM
+    if (!_latencyLabel) return;
+    AudioLatencyInfo lat = AudioEngine::getInstance().getLevels().latency;
+    int mode = 0;
+    for (int i = 0; i < AudioLatencyInfo::NUM_MODES; i++) {
+        if (AudioEngine::BLOCK_SIZES[i] == lat.blockSize) mode = i;
+    }
+
+    char measured[32];
+    if (lat.measuring) {
+        snprintf(measured, sizeof(measured), "measuring...");
+    } else if (lat.measuredMs[mode] >= 0.0f) {
+        snprintf(measured, sizeof(measured), "%.1f ms +/-%.2f%s", lat.measuredMs[mode], lat.jitterMs[mode],
+                 lat.lastFailed ? " (last failed)" : "");
+    } else {
+        snprintf(measured, sizeof(measured), "%s", lat.lastFailed ? "failed (unmute?)" : "---");
+    }
+
+    char aec[24] = "";
+    if (lat.aecDelayMs > 0.0f) snprintf(aec, sizeof(aec), " (AEC +%.0f)", lat.aecDelayMs);
+
+    char text[128];
+    snprintf(text, sizeof(text), "Block: %d samples\nEstimate: <= %.1f ms%s\nMeasured: %s",
+             lat.blockSize, lat.estimateMs, aec, measured);
+    lv_label_set_text(_latencyLabel, text);
+#endif
+}
+
+// One redraw of the plot per analysed frame (~25/s), none while the frame repeats
+void WizardUI::updateSpectrum()
+{
+#ifdef ESP_PLATFORM
+    static_assert(AudioSpectrum::BANDS == SPECTRUM_BANDS, "EQ panel plot is laid out for the engine's bands");
+    AudioSpectrum spec;
+    if (AudioEngine::getInstance().getSpectrum(spec)) _spectrum.set(spec.inputDb, spec.outputDb);
+#endif
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -802,12 +1157,12 @@ void WizardUI::createVoicePanel()
 
     lv_obj_t* veToggleLbl = lv_label_create(_veToggle);
     lv_label_set_text(veToggleLbl, "VE OFF");
-    lv_obj_set_style_text_font(veToggleLbl, &lv_font_montserrat_14, LV_PART_MAIN);
+    WizardTheme::applyCompactText(veToggleLbl);
     lv_obj_center(veToggleLbl);
 
     _veHpStatusLabel = lv_label_create(_panelVoice);
     lv_label_set_text(_veHpStatusLabel, "HP MIC: ---");
-    lv_obj_set_style_text_font(_veHpStatusLabel, &lv_font_montserrat_14, LV_PART_MAIN);
+    WizardTheme::applyCompactText(_veHpStatusLabel);
     lv_obj_set_style_text_color(_veHpStatusLabel, lv_color_hex(MUTED_TEXT), LV_PART_MAIN);
     lv_obj_set_pos(_veHpStatusLabel, 700, 15);
 
@@ -860,21 +1215,8 @@ void WizardUI::createVoicePanel()
     lv_obj_set_style_border_color(hpMeterBg, lv_color_hex(DARK_BORDER), LV_PART_MAIN);
     lv_obj_set_style_border_width(hpMeterBg, 1, LV_PART_MAIN);
     lv_obj_remove_flag(hpMeterBg, LV_OBJ_FLAG_SCROLLABLE);
-
-    _veHpMeterBar = lv_obj_create(hpMeterBg);
-    lv_obj_remove_style_all(_veHpMeterBar);
-    lv_obj_set_size(_veHpMeterBar, 1, 18);
-    lv_obj_set_pos(_veHpMeterBar, 2, 2);
-    lv_obj_set_style_bg_color(_veHpMeterBar, lv_color_hex(METER_GREEN), LV_PART_MAIN);
-    lv_obj_set_style_bg_opa(_veHpMeterBar, LV_OPA_COVER, LV_PART_MAIN);
-    lv_obj_set_style_radius(_veHpMeterBar, 2, LV_PART_MAIN);
-
-    _veHpMeterPeak = lv_obj_create(hpMeterBg);
-    lv_obj_remove_style_all(_veHpMeterPeak);
-    lv_obj_set_size(_veHpMeterPeak, 3, 18);
-    lv_obj_set_pos(_veHpMeterPeak, 2, 2);
-    lv_obj_set_style_bg_color(_veHpMeterPeak, lv_color_hex(GOLD_BRIGHT), LV_PART_MAIN);
-    lv_obj_set_style_bg_opa(_veHpMeterPeak, LV_OPA_COVER, LV_PART_MAIN);
+    _veHpMeter.attach(hpMeterBg, HP_METER_MAX_W, 18, LevelMeter::Zones{-3.0f, METER_RED, -20.0f, METER_GREEN, MUTED_TEXT},
+        GOLD_BRIGHT);
 
     // Level Match Indicator (HP mic vs Main mic ratio)
     // Green = good match (0.8-1.2), Yellow = adjust needed (0.5-0.8 or 1.2-2.0), Red = severe mismatch
@@ -888,7 +1230,7 @@ void WizardUI::createVoicePanel()
 
     _veLevelMatchLabel = lv_label_create(_panelVoice);
     lv_label_set_text(_veLevelMatchLabel, "---");
-    lv_obj_set_style_text_font(_veLevelMatchLabel, &lv_font_montserrat_12, LV_PART_MAIN);
+    WizardTheme::applyCaptionText(_veLevelMatchLabel);
     lv_obj_set_style_text_color(_veLevelMatchLabel, lv_color_hex(MUTED_TEXT), LV_PART_MAIN);
     lv_obj_set_pos(_veLevelMatchLabel, valX + 100, 187);
 
@@ -942,7 +1284,7 @@ void WizardUI::createVoicePanel()
 
         lv_obj_t* lbl = lv_label_create(btn);
         lv_label_set_text(lbl, label);
-        lv_obj_set_style_text_font(lbl, &lv_font_montserrat_14, LV_PART_MAIN);
+        WizardTheme::applyCompactText(lbl);
         lv_obj_set_style_text_color(lbl, lv_color_hex(LAVENDER), LV_PART_MAIN);
         lv_obj_center(lbl);
 
@@ -974,7 +1316,7 @@ void WizardUI::createVoicePanel()
 
     lv_obj_t* vadGateLbl = lv_label_create(_veVadGateToggle);
     lv_label_set_text(vadGateLbl, "GATE ON");
-    lv_obj_set_style_text_font(vadGateLbl, &lv_font_montserrat_14, LV_PART_MAIN);
+    WizardTheme::applyCompactText(vadGateLbl);
     lv_obj_set_style_text_color(vadGateLbl, lv_color_hex(GOLD_BRIGHT), LV_PART_MAIN);
     lv_obj_center(vadGateLbl);
 
@@ -991,13 +1333,13 @@ void WizardUI::createVoicePanel()
     // VAD status indicator
     _veVadStatusLabel = lv_label_create(_panelVoice);
     lv_label_set_text(_veVadStatusLabel, "SILENCE");
-    lv_obj_set_style_text_font(_veVadStatusLabel, &lv_font_montserrat_14, LV_PART_MAIN);
+    WizardTheme::applyCompactText(_veVadStatusLabel);
     lv_obj_set_style_text_color(_veVadStatusLabel, lv_color_hex(MUTED_TEXT), LV_PART_MAIN);
     lv_obj_set_pos(_veVadStatusLabel, 850, 453);
 
     lv_obj_t* nlmsNote = lv_label_create(_panelVoice);
     lv_label_set_text(nlmsNote, "VAD gate works with both NLMS & AEC  |  Reduces transients during silence  |  Match indicator: aim for green");
-    lv_obj_set_style_text_font(nlmsNote, &lv_font_montserrat_14, LV_PART_MAIN);
+    WizardTheme::applyCompactText(nlmsNote);
     lv_obj_set_style_text_color(nlmsNote, lv_color_hex(MUTED_TEXT), LV_PART_MAIN);
     lv_obj_set_pos(nlmsNote, 60, 495);
 }
@@ -1029,7 +1371,7 @@ void WizardUI::createProfilesPanel()
     // Default profile indicator
     _profileDefaultLabel = lv_label_create(_panelProfiles);
     lv_label_set_text(_profileDefaultLabel, "Default: (none)");
-    lv_obj_set_style_text_font(_profileDefaultLabel, &lv_font_montserrat_14, LV_PART_MAIN);
+    WizardTheme::applyCompactText(_profileDefaultLabel);
     lv_obj_set_style_text_color(_profileDefaultLabel, lv_color_hex(LAVENDER), LV_PART_MAIN);
     lv_obj_set_pos(_profileDefaultLabel, 60, 120);
 
@@ -1043,10 +1385,39 @@ void WizardUI::createProfilesPanel()
 
     lv_obj_t* refreshLbl = lv_label_create(_profileLoadBtn);
     lv_label_set_text(refreshLbl, "REFRESH");
-    lv_obj_set_style_text_font(refreshLbl, &lv_font_montserrat_14, LV_PART_MAIN);
+    WizardTheme::applyCompactText(refreshLbl);
     lv_obj_set_style_text_color(refreshLbl, lv_color_hex(LAVENDER), LV_PART_MAIN);
     lv_obj_center(refreshLbl);
 
+    _profileSpinner = lv_spinner_create(_panelProfiles);
+    lv_obj_set_size(_profileSpinner, 40, 40);
+    lv_obj_set_pos(_profileSpinner, 260, 185);
+    lv_obj_set_style_arc_width(_profileSpinner, 4, LV_PART_MAIN);
+    lv_obj_set_style_arc_color(_profileSpinner, lv_color_hex(DARK_BORDER), LV_PART_MAIN);
+    lv_obj_set_style_arc_width(_profileSpinner, 4, LV_PART_INDICATOR);
+    lv_obj_set_style_arc_color(_profileSpinner, lv_color_hex(GOLD_BRIGHT), LV_PART_INDICATOR);
+    lv_obj_add_flag(_profileSpinner, LV_OBJ_FLAG_HIDDEN);
+
+#ifdef ESP_PLATFORM
+    // Built-in presets: in flash, so they load with or without a card
+    createSectionLabel(_panelProfiles, "BUILT-IN PRESETS", 60, 270);
+    const std::vector<std::string> presets = ProfileManager::listBuiltinPresets();
+    for (size_t i = 0; i < presets.size(); i++) {
+        lv_obj_t* btn = lv_btn_create(_panelProfiles);
+        lv_obj_set_size(btn, 220, 50);
+        lv_obj_set_pos(btn, 60 + (int)(i % 4) * 240, 310 + (int)(i / 4) * 64);
+        styleToggleWizard(btn);
+        lv_obj_set_user_data(btn, (void*)(intptr_t)i);
+        lv_obj_add_event_cb(btn, onPresetClicked, LV_EVENT_CLICKED, this);
+
+        lv_obj_t* lbl = lv_label_create(btn);
+        lv_label_set_text(lbl, presets[i].c_str());
+        WizardTheme::applyCompactText(lbl);
+        lv_obj_set_style_text_color(lbl, lv_color_hex(LAVENDER), LV_PART_MAIN);
+        lv_obj_center(lbl);
+    }
+#endif
+
     // Note: Full profile management (save/load/delete) temporarily disabled
     // to conserve LVGL memory. Profiles are auto-loaded on boot if set.
     _profileRoller = nullptr;
@@ -1068,6 +1439,7 @@ void WizardUI::createTinnitusPanel()
     // Section 1: Notch Filters (2 visible, 6 available in engine)
     // ══════════════════════════════════════════════════════════════════════
     createSectionLabel(_panelTinnitus, "NOTCH FILTERS (Tinnitus Suppression)", 60, 10);
+    createEarButton(_panelTinnitus, 3);
 
     for (int n = 0; n < 2; n++) {
         int baseY = 40 + n * 70;
@@ -1082,7 +1454,7 @@ void WizardUI::createTinnitusPanel()
 
         lv_obj_t* togLbl = lv_label_create(_notchToggle[n]);
         lv_label_set_text(togLbl, "OFF");
-        lv_obj_set_style_text_font(togLbl, &lv_font_montserrat_12, LV_PART_MAIN);
+        WizardTheme::applyCaptionText(togLbl);
         lv_obj_center(togLbl);
 
         // Frequency slider
@@ -1133,7 +1505,7 @@ void WizardUI::createTinnitusPanel()
 
         lv_obj_t* lbl = lv_label_create(_noiseTypeBtns[t]);
         lv_label_set_text(lbl, noiseLabels[t]);
-        lv_obj_set_style_text_font(lbl, &lv_font_montserrat_12, LV_PART_MAIN);
+        WizardTheme::applyCaptionText(lbl);
         lv_obj_set_style_text_color(lbl, lv_color_hex(LAVENDER), LV_PART_MAIN);
         lv_obj_center(lbl);
     }
@@ -1187,7 +1559,7 @@ void WizardUI::createTinnitusPanel()
 
     lv_obj_t* toneTogLbl = lv_label_create(_toneFinderToggle);
     lv_label_set_text(toneTogLbl, "OFF");
-    lv_obj_set_style_text_font(toneTogLbl, &lv_font_montserrat_12, LV_PART_MAIN);
+    WizardTheme::applyCaptionText(toneTogLbl);
     lv_obj_center(toneTogLbl);
 
     createValueLabel(_panelTinnitus, "Freq:", 160, 337);
@@ -1220,7 +1592,7 @@ void WizardUI::createTinnitusPanel()
 
     lv_obj_t* transLbl = lv_label_create(_toneFinderTransferBtn);
     lv_label_set_text(transLbl, "Copy to Notch 1");
-    lv_obj_set_style_text_font(transLbl, &lv_font_montserrat_12, LV_PART_MAIN);
+    WizardTheme::applyCaptionText(transLbl);
     lv_obj_set_style_text_color(transLbl, lv_color_hex(GOLD_BRIGHT), LV_PART_MAIN);
     lv_obj_center(transLbl);
 
@@ -1239,7 +1611,7 @@ void WizardUI::createTinnitusPanel()
 
     lv_obj_t* hfTogLbl = lv_label_create(_hfExtToggle);
     lv_label_set_text(hfTogLbl, "OFF");
-    lv_obj_set_style_text_font(hfTogLbl, &lv_font_montserrat_12, LV_PART_MAIN);
+    WizardTheme::applyCaptionText(hfTogLbl);
     lv_obj_center(hfTogLbl);
 
     createValueLabel(_panelTinnitus, "Freq:", 140, 448);
@@ -1273,7 +1645,7 @@ void WizardUI::createTinnitusPanel()
 
     lv_obj_t* binTogLbl = lv_label_create(_binauralToggle);
     lv_label_set_text(binTogLbl, "OFF");
-    lv_obj_set_style_text_font(binTogLbl, &lv_font_montserrat_12, LV_PART_MAIN);
+    WizardTheme::applyCaptionText(binTogLbl);
     lv_obj_center(binTogLbl);
 
     // Binaural presets (Delta/Theta/Alpha/Beta)
@@ -1288,7 +1660,7 @@ void WizardUI::createTinnitusPanel()
 
         lv_obj_t* lbl = lv_label_create(_binauralPresetBtns[p]);
         lv_label_set_text(lbl, presetLabels[p]);
-        lv_obj_set_style_text_font(lbl, &lv_font_montserrat_14, LV_PART_MAIN);
+        WizardTheme::applyCompactText(lbl);
         lv_obj_set_style_text_color(lbl, lv_color_hex(LAVENDER), LV_PART_MAIN);
         lv_obj_center(lbl);
     }
@@ -1319,7 +1691,7 @@ void WizardUI::createTinnitusPanel()
     // Info note
     lv_obj_t* tinNote = lv_label_create(_panelTinnitus);
     lv_label_set_text(tinNote, "Notched sound: suppresses tinnitus frequency | Pink/brown: relaxing masking | Binaural: entrainment");
-    lv_obj_set_style_text_font(tinNote, &lv_font_montserrat_12, LV_PART_MAIN);
+    WizardTheme::applyCaptionText(tinNote);
     lv_obj_set_style_text_color(tinNote, lv_color_hex(MUTED_TEXT), LV_PART_MAIN);
     lv_obj_set_pos(tinNote, 60, 545);
 }
@@ -1327,10 +1699,54 @@ void WizardUI::createTinnitusPanel()
 void WizardUI::refreshProfileList()
 {
 #ifdef ESP_PLATFORM
-    // First check if SD card is accessible
-    if (!ProfileManager::isSdCardAccessible()) {
+    // One listing at a time; the one in flight will refresh the labels
+    if (!_profileStore || _profileStore->busy()) return;
+
+    const bool queued = _profileStore->list([](void* user, const ProfileStore::Result& r) {
+        auto* ui = static_cast<WizardUI*>(user);
+        ui->setProfileBusy(ui->_profileStore->busy());
+        ui->showProfileListing(r.ok, r.names.size(), r.builtins, r.defaultName.c_str());
+    });
+    setProfileBusy(queued);
+    if (!queued && _profileStatusLabel) {
+        lv_label_set_text(_profileStatusLabel, "SD Card: storage busy, try again");
+        lv_obj_set_style_text_color(_profileStatusLabel, lv_color_hex(METER_RED), LV_PART_MAIN);
+    }
+#else
+    if (_profileStatusLabel) {
+        lv_label_set_text(_profileStatusLabel, "SD Card: Not available (simulator)");
+    }
+#endif
+}
+
+void WizardUI::setProfileBusy(bool busy)
+{
+    if (_profileSpinner) {
+        if (busy)
+            lv_obj_remove_flag(_profileSpinner, LV_OBJ_FLAG_HIDDEN);
+        else
+            lv_obj_add_flag(_profileSpinner, LV_OBJ_FLAG_HIDDEN);
+    }
+    if (_profileLoadBtn) {
+        if (busy)
+            lv_obj_add_state(_profileLoadBtn, LV_STATE_DISABLED);
+        else
+            lv_obj_remove_state(_profileLoadBtn, LV_STATE_DISABLED);
+    }
+    if (busy && _profileStatusLabel) {
+        lv_label_set_text(_profileStatusLabel, "Checking SD card...");
+        lv_obj_set_style_text_color(_profileStatusLabel, lv_color_hex(GOLD), LV_PART_MAIN);
+    }
+}
+
+void WizardUI::showProfileListing(bool sdOk, size_t count, size_t builtins, const char* defaultName)
+{
+    count -= builtins;
+    if (!sdOk) {
         if (_profileStatusLabel) {
-            lv_label_set_text(_profileStatusLabel, "SD Card: Not inserted or not formatted");
+            char buf[96];
+            snprintf(buf, sizeof(buf), "SD Card: Not inserted or not formatted | %zu built-in", builtins);
+            lv_label_set_text(_profileStatusLabel, buf);
             lv_obj_set_style_text_color(_profileStatusLabel, lv_color_hex(METER_RED), LV_PART_MAIN);
         }
         if (_profileDefaultLabel) {
@@ -1339,35 +1755,672 @@ void WizardUI::refreshProfileList()
         return;
     }
 
-    auto names = ProfileManager::listProfiles();
-
     // Update status label with profile count
     if (_profileStatusLabel) {
         char buf[128];
-        if (names.empty()) {
-            snprintf(buf, sizeof(buf), "SD Card: OK | No profiles saved");
+        if (count == 0) {
+            snprintf(buf, sizeof(buf), "SD Card: OK | No profiles saved | %zu built-in", builtins);
         } else {
-            snprintf(buf, sizeof(buf), "SD Card: OK | %zu profile(s) found", names.size());
+            snprintf(buf, sizeof(buf), "SD Card: OK | %zu profile(s) found | %zu built-in", count, builtins);
         }
         lv_label_set_text(_profileStatusLabel, buf);
         lv_obj_set_style_text_color(_profileStatusLabel, lv_color_hex(METER_GREEN), LV_PART_MAIN);
     }
 
     // Update default profile indicator
-    auto defName = ProfileManager::getDefaultProfile();
     if (_profileDefaultLabel) {
-        if (defName.empty()) {
+        if (defaultName[0] == '\0') {
             lv_label_set_text(_profileDefaultLabel, "Default: (none)");
         } else {
             char buf[64];
-            snprintf(buf, sizeof(buf), "Default: %s", defName.c_str());
+            snprintf(buf, sizeof(buf), "Default: %s", defaultName);
             lv_label_set_text(_profileDefaultLabel, buf);
         }
     }
-#else
-    if (_profileStatusLabel) {
-        lv_label_set_text(_profileStatusLabel, "SD Card: Not available (simulator)");
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Hidden panel: DIAGNOSTICS (per-stage DSP cycle profile)
+// ─────────────────────────────────────────────────────────────────────────────
+
+void WizardUI::createDiagPanel()
+{
+    int cx = CONTENT_W / 2;
+
+    createSectionLabel(_panelDiag, "DSP STAGE PROFILE", cx - 100, 20);
+    createDiamondDivider(_panelDiag, 55, 400);
+
+    // Stage names left-aligned, numeric columns right-aligned
+    static const char* headers[] = {"STAGE", "MIN us", "AVG us", "P99 us", "MAX us", "P99 %"};
+    static const int colX[] = {80, 280, 410, 540, 670, 800};
+    constexpr int COL_W = 110;
+    for (int c = 0; c < 6; c++) {
+        lv_obj_t* hdr = _diagHeaders[c] = lv_label_create(_panelDiag);
+        lv_label_set_text(hdr, headers[c]);
+        WizardTheme::applyCompactText(hdr);
+        lv_obj_set_style_text_color(hdr, lv_color_hex(LAVENDER), LV_PART_MAIN);
+        lv_obj_set_width(hdr, c == 0 ? 180 : COL_W);
+        lv_obj_set_style_text_align(hdr, c == 0 ? LV_TEXT_ALIGN_LEFT : LV_TEXT_ALIGN_RIGHT, LV_PART_MAIN);
+        lv_obj_set_pos(hdr, colX[c], 80);
+
+        _diagColumns[c] = lv_label_create(_panelDiag);
+        lv_label_set_text(_diagColumns[c], "");
+        WizardTheme::applyCompactText(_diagColumns[c]);
+        lv_obj_set_style_text_color(_diagColumns[c], lv_color_hex(c == 0 ? MUTED_TEXT : GOLD_BRIGHT), LV_PART_MAIN);
+        lv_obj_set_style_text_line_space(_diagColumns[c], 6, LV_PART_MAIN);
+        lv_obj_set_width(_diagColumns[c], c == 0 ? 180 : COL_W);
+        lv_obj_set_style_text_align(_diagColumns[c], c == 0 ? LV_TEXT_ALIGN_LEFT : LV_TEXT_ALIGN_RIGHT, LV_PART_MAIN);
+        lv_obj_set_pos(_diagColumns[c], colX[c], 110);
+    }
+
+    _diagSummaryLabel = lv_label_create(_panelDiag);
+    lv_label_set_text(_diagSummaryLabel, "Profiler starts when this panel opens");
+    WizardTheme::applyCaptionText(_diagSummaryLabel);
+    lv_obj_set_style_text_color(_diagSummaryLabel, lv_color_hex(MUTED_TEXT), LV_PART_MAIN);
+    lv_obj_set_pos(_diagSummaryLabel, 80, CONTENT_H - 40);
+
+    // Deadline misses / DMA xruns and the auto-degrade policy
+    _diagXrunLabel = lv_label_create(_panelDiag);
+    lv_label_set_text(_diagXrunLabel, "");
+    WizardTheme::applyCompactText(_diagXrunLabel);
+    lv_obj_set_style_text_color(_diagXrunLabel, lv_color_hex(LAVENDER), LV_PART_MAIN);
+    lv_obj_set_style_text_line_space(_diagXrunLabel, 6, LV_PART_MAIN);
+    lv_obj_set_pos(_diagXrunLabel, 80, CONTENT_H - 110);
+
+    _diagDegradeToggle = lv_btn_create(_panelDiag);
+    lv_obj_set_size(_diagDegradeToggle, 150, 36);
+    lv_obj_set_pos(_diagDegradeToggle, 760, CONTENT_H - 110);
+    styleToggleWizard(_diagDegradeToggle);
+    lv_obj_add_event_cb(_diagDegradeToggle, onDiagDegradeToggle, LV_EVENT_CLICKED, this);
+
+    lv_obj_t* degradeLbl = lv_label_create(_diagDegradeToggle);
+    lv_label_set_text(degradeLbl, "AUTO-DEGRADE");
+    WizardTheme::applyCompactText(degradeLbl);
+    lv_obj_set_style_text_color(degradeLbl, lv_color_hex(LAVENDER), LV_PART_MAIN);
+    lv_obj_center(degradeLbl);
+
+    lv_obj_t* resetBtn = lv_btn_create(_panelDiag);
+    lv_obj_set_size(resetBtn, 100, 36);
+    lv_obj_set_pos(resetBtn, 930, CONTENT_H - 110);
+    styleToggleWizard(resetBtn);
+    lv_obj_add_event_cb(resetBtn, onDiagResetClicked, LV_EVENT_CLICKED, this);
+
+    lv_obj_t* resetLbl = lv_label_create(resetBtn);
+    lv_label_set_text(resetLbl, "RESET");
+    WizardTheme::applyCompactText(resetLbl);
+    lv_obj_set_style_text_color(resetLbl, lv_color_hex(LAVENDER), LV_PART_MAIN);
+    lv_obj_center(resetLbl);
+
+    // Kernel micro-benchmark: swaps the table over to per-kernel results
+    lv_obj_t* benchBtn = lv_btn_create(_panelDiag);
+    lv_obj_set_size(benchBtn, 100, 36);
+    lv_obj_set_pos(benchBtn, 930, CONTENT_H - 64);
+    styleToggleWizard(benchBtn);
+    lv_obj_add_event_cb(benchBtn, onDiagBenchClicked, LV_EVENT_CLICKED, this);
+
+    _diagBenchLabel = lv_label_create(benchBtn);
+    lv_label_set_text(_diagBenchLabel, "BENCH");
+    WizardTheme::applyCompactText(_diagBenchLabel);
+    lv_obj_set_style_text_color(_diagBenchLabel, lv_color_hex(LAVENDER), LV_PART_MAIN);
+    lv_obj_center(_diagBenchLabel);
+
+    // SD card sequential throughput (recorder path: 32KB aligned, unbuffered, preallocated)
+    lv_obj_t* sdBtn = lv_btn_create(_panelDiag);
+    lv_obj_set_size(sdBtn, 150, 36);
+    lv_obj_set_pos(sdBtn, 760, CONTENT_H - 64);
+    styleToggleWizard(sdBtn);
+    lv_obj_add_event_cb(sdBtn, onDiagSdClicked, LV_EVENT_CLICKED, this);
+
+    lv_obj_t* sdLbl = lv_label_create(sdBtn);
+    lv_label_set_text(sdLbl, "SD SPEED");
+    WizardTheme::applyCompactText(sdLbl);
+    lv_obj_set_style_text_color(sdLbl, lv_color_hex(LAVENDER), LV_PART_MAIN);
+    lv_obj_center(sdLbl);
+
+    // The card as a USB disk on the PC; /sd is unmounted here until it's ejected
+    lv_obj_t* usbBtn = lv_btn_create(_panelDiag);
+    lv_obj_set_size(usbBtn, 100, 36);
+    lv_obj_set_pos(usbBtn, 1050, CONTENT_H - 64);
+    styleToggleWizard(usbBtn);
+    lv_obj_add_event_cb(usbBtn, onDiagUsbClicked, LV_EVENT_CLICKED, this);
+
+    _diagUsbBtnLabel = lv_label_create(usbBtn);
+    lv_label_set_text(_diagUsbBtnLabel, "USB DISK");
+    WizardTheme::applyCompactText(_diagUsbBtnLabel);
+    lv_obj_set_style_text_color(_diagUsbBtnLabel, lv_color_hex(LAVENDER), LV_PART_MAIN);
+    lv_obj_center(_diagUsbBtnLabel);
+
+    _diagSdLabel = lv_label_create(_panelDiag);
+    lv_label_set_text(_diagSdLabel, "");
+    WizardTheme::applyCaptionText(_diagSdLabel);
+    lv_obj_set_style_text_color(_diagSdLabel, lv_color_hex(GOLD_BRIGHT), LV_PART_MAIN);
+    lv_obj_set_style_text_line_space(_diagSdLabel, 4, LV_PART_MAIN);
+    lv_obj_set_width(_diagSdLabel, 150);
+    lv_obj_set_pos(_diagSdLabel, 600, CONTENT_H - 64);
+
+    // Round-trip latency test (MLS bursts, electrical loopback or HP mic)
+    lv_obj_t* latHdr = lv_label_create(_panelDiag);
+    lv_label_set_text(latHdr, "ROUND TRIP");
+    WizardTheme::applyCompactText(latHdr);
+    lv_obj_set_style_text_color(latHdr, lv_color_hex(LAVENDER), LV_PART_MAIN);
+    lv_obj_set_pos(latHdr, 940, 80);
+
+    _diagLatencyLabel = lv_label_create(_panelDiag);
+    lv_label_set_text(_diagLatencyLabel, "");
+    WizardTheme::applyCompactText(_diagLatencyLabel);
+    lv_obj_set_style_text_color(_diagLatencyLabel, lv_color_hex(GOLD_BRIGHT), LV_PART_MAIN);
+    lv_obj_set_style_text_line_space(_diagLatencyLabel, 6, LV_PART_MAIN);
+    lv_obj_set_pos(_diagLatencyLabel, 940, 110);
+
+    static const char* latNames[] = {"LOOPBACK", "HP MIC"};  // AudioLatencyInfo::Source
+    for (int i = 0; i < 2; i++) {
+        lv_obj_t* btn = lv_btn_create(_panelDiag);
+        lv_obj_set_size(btn, 150, 36);
+        lv_obj_set_pos(btn, 940, 300 + i * 46);
+        styleToggleWizard(btn);
+        lv_obj_set_user_data(btn, (void*)(intptr_t)i);
+        lv_obj_add_event_cb(btn, onDiagLatencyClicked, LV_EVENT_CLICKED, this);
+
+        lv_obj_t* lbl = lv_label_create(btn);
+        lv_label_set_text(lbl, latNames[i]);
+        WizardTheme::applyCompactText(lbl);
+        lv_obj_set_style_text_color(lbl, lv_color_hex(LAVENDER), LV_PART_MAIN);
+        lv_obj_center(lbl);
+    }
+
+    lv_obj_t* costHdr = lv_label_create(_panelDiag);
+    lv_label_set_text(costHdr, "PREDICTED LOAD");
+    WizardTheme::applyCompactText(costHdr);
+    lv_obj_set_style_text_color(costHdr, lv_color_hex(LAVENDER), LV_PART_MAIN);
+    lv_obj_set_pos(costHdr, 940, 395);
+
+    _diagCostLabel = lv_label_create(_panelDiag);
+    lv_label_set_text(_diagCostLabel, "");
+    WizardTheme::applyCaptionText(_diagCostLabel);
+    lv_obj_set_style_text_color(_diagCostLabel, lv_color_hex(GOLD_BRIGHT), LV_PART_MAIN);
+    lv_obj_set_style_text_line_space(_diagCostLabel, 4, LV_PART_MAIN);
+    lv_obj_set_pos(_diagCostLabel, 940, 418);
+}
+
+void WizardUI::setDiagBenchView(bool bench)
+{
+    static const char* profileHeaders[] = {"STAGE", "MIN us", "AVG us", "P99 us", "MAX us", "P99 %"};
+    static const char* benchHeaders[] = {"KERNEL", "CYCLES", "CYC/SMP", "RT %", "LIMIT %", "RESULT"};
+    _diagBenchView = bench;
+    for (int c = 0; c < 6; c++) {
+        lv_label_set_text(_diagHeaders[c], bench ? benchHeaders[c] : profileHeaders[c]);
+        lv_label_set_text(_diagColumns[c], "");
+    }
+    lv_label_set_text(_diagBenchLabel, bench ? "PROFILE" : "BENCH");
+    lv_label_set_text(_diagSummaryLabel, bench ? "Benchmark running..." : "Collecting stage profile...");
+}
+
+void WizardUI::updateDiagBench()
+{
+#ifdef ESP_PLATFORM
+    AudioBenchReport report;
+    if (!AudioEngine::getInstance().getBenchmarkReport(report)) return;
+
+    char cols[6][AudioBenchReport::MAX_RESULTS * 16];
+    int len[6] = {};
+    for (int i = 0; i < report.count; i++) {
+        const auto& r = report.results[i];
+        const char* sep = (i + 1 < report.count) ? "\n" : "";
+        len[0] += snprintf(cols[0] + len[0], sizeof(cols[0]) - len[0], "%s%s", r.name, sep);
+        len[1] += snprintf(cols[1] + len[1], sizeof(cols[1]) - len[1], "%u%s", (unsigned)r.cycles, sep);
+        len[2] += snprintf(cols[2] + len[2], sizeof(cols[2]) - len[2], "%.1f%s", r.cyclesPerSample, sep);
+        len[3] += snprintf(cols[3] + len[3], sizeof(cols[3]) - len[3], "%.2f%s", r.realtimePct, sep);
+        len[4] += snprintf(cols[4] + len[4], sizeof(cols[4]) - len[4], "%.1f%s", r.limitPct, sep);
+        len[5] += snprintf(cols[5] + len[5], sizeof(cols[5]) - len[5], "%s%s", r.passed ? "PASS" : "FAIL", sep);
+    }
+    for (int c = 0; c < 6; c++) {
+        lv_label_set_text(_diagColumns[c], report.count ? cols[c] : "");
+    }
+
+    int checksPassed = 0;
+    for (int i = 0; i < report.checkCount; i++) checksPassed += report.checks[i].passed ? 1 : 0;
+
+    char summary[160];
+    snprintf(summary, sizeof(summary), "%s  |  reference checks %d/%d  |  %d kernels @ %u MHz, best of 16 calls%s",
+             report.passed ? "ALL PASS" : "FAILED", checksPassed, report.checkCount, report.count,
+             (unsigned)report.cpuMhz, report.engineRunning ? ", engine running" : "");
+    lv_label_set_text(_diagSummaryLabel, summary);
+#endif
+}
+
+void WizardUI::updateDiagLatency()
+{
+#ifdef ESP_PLATFORM
+    AudioLatencyInfo lat = AudioEngine::getInstance().getLevels().latency;
+    int mode = 0;
+    for (int i = 0; i < AudioLatencyInfo::NUM_MODES; i++) {
+        if (AudioEngine::BLOCK_SIZES[i] == lat.blockSize) mode = i;
+    }
+    const char* source = lat.source == AudioLatencyInfo::SOURCE_HP_MIC ? "hp mic" : "loopback";
+
+    char text[192];
+    if (lat.measuring) {
+        snprintf(text, sizeof(text), "Block %d\nMeasuring (%s)\nRun %d / %d", lat.blockSize, source,
+                 lat.runsDone + 1, AudioLatencyInfo::RUNS);
+    } else if (lat.measuredMs[mode] >= 0.0f) {
+        snprintf(text, sizeof(text), "Block %d (%s)\nMean: %.2f ms\nJitter: %.3f ms\nSpread: %.3f ms\nRuns: %d / %d, %.0f dB%s",
+                 lat.blockSize, source, lat.measuredMs[mode], lat.jitterMs[mode], lat.spreadMs, lat.runsValid,
+                 lat.runsDone, lat.peakRatioDb, lat.lastFailed ? "\nLast test failed" : "");
+    } else {
+        snprintf(text, sizeof(text), "Block %d\n%s", lat.blockSize,
+                 lat.lastFailed ? "No return (unmute?)" : "Not measured");
+    }
+    lv_label_set_text(_diagLatencyLabel, text);
+    lv_obj_set_style_text_color(_diagLatencyLabel, lv_color_hex(lat.lastFailed ? METER_RED : GOLD_BRIGHT),
+                                LV_PART_MAIN);
+#endif
+}
+
+void WizardUI::updateDiagCost()
+{
+#ifdef ESP_PLATFORM
+    AudioCostEstimate cost = AudioCostModel::getInstance().estimate(AudioEngine::getInstance().getParams());
+
+    // The three costliest stages under the per-core totals
+    int top[3] = {-1, -1, -1};
+    for (int i = 0; i < cost.count; i++) {
+        for (int t = 0; t < 3; t++) {
+            if (top[t] < 0 || cost.items[i].pct > cost.items[top[t]].pct) {
+                for (int m = 2; m > t; m--) top[m] = top[m - 1];
+                top[t] = i;
+                break;
+            }
+        }
+    }
+
+    char text[192];
+    int len = snprintf(text, sizeof(text), "Audio core: %.0f%%\nAEC core: %.0f%%  (%s)",
+                       cost.audioCorePct, cost.aecCorePct, cost.calibrated ? "bench" : "defaults");
+    for (int t = 0; t < 3 && top[t] >= 0 && len < (int)sizeof(text); t++) {
+        len += snprintf(text + len, sizeof(text) - len, "\n%s %.1f%%", cost.items[top[t]].name, cost.items[top[t]].pct);
+    }
+    lv_label_set_text(_diagCostLabel, text);
+    lv_obj_set_style_text_color(_diagCostLabel, lv_color_hex(cost.overBudget ? METER_RED : GOLD_BRIGHT), LV_PART_MAIN);
+#endif
+}
+
+void WizardUI::updateDiagSd()
+{
+#ifdef ESP_PLATFORM
+    auto& msc = UsbMsc::getInstance();
+    lv_label_set_text(_diagUsbBtnLabel, msc.isActive() ? "EJECT" : "USB DISK");
+    if (msc.isActive()) {
+        const UsbMscStats ms = msc.getStats();
+        char usb[96];
+        snprintf(usb, sizeof(usb), "On USB, %u MB\nR %.1f  W %.1f MB%s", (unsigned)ms.capacityMB, ms.readKB / 1024.0f,
+                 ms.writtenKB / 1024.0f, ms.errors ? ", errors" : "");
+        lv_label_set_text(_diagSdLabel, usb);
+        lv_obj_set_style_text_color(_diagSdLabel, lv_color_hex(ms.errors ? METER_RED : GOLD_BRIGHT), LV_PART_MAIN);
+        return;
+    }
+
+    auto& sd = SdStorage::getInstance();
+    if (sd.isBenchmarkRunning()) {
+        lv_label_set_text(_diagSdLabel, "Testing...");
+        return;
+    }
+    SdBenchResult r;
+    if (!sd.getBenchmark(r)) return;
+
+    char text[96];
+    if (r.ok) {
+        snprintf(text, sizeof(text), "W %.1f  R %.1f MB/s\n%u MHz %u-bit, %u ms max",
+                 r.writeKBps / 1024.0f, r.readKBps / 1024.0f, (unsigned)(r.freqKhz / 1000), (unsigned)r.busWidth,
+                 (unsigned)(r.worstWriteUs / 1000));
+    } else {
+        snprintf(text, sizeof(text), "No SD card");
+    }
+    lv_label_set_text(_diagSdLabel, text);
+    lv_obj_set_style_text_color(_diagSdLabel, lv_color_hex(r.ok ? GOLD_BRIGHT : METER_RED), LV_PART_MAIN);
+#endif
+}
+
+void WizardUI::updateDiagPanel()
+{
+#ifdef ESP_PLATFORM
+    if (_diagLatencyLabel) updateDiagLatency();
+    if (_diagCostLabel) updateDiagCost();
+    if (_diagSdLabel) updateDiagSd();
+
+    if (_diagXrunLabel) {
+        const AudioLevels levels = AudioEngine::getInstance().getLevels();
+        const AudioXrunStats& xrun = levels.xrun;
+        const AudioCacheStats& cache = levels.cache;
+        char text[384];
+        int n = snprintf(text, sizeof(text),
+                 "Deadline misses: %u   Late reads: %u   RX overruns: %u   TX underruns: %u\n"
+                 "Block: %u us   Worst block: %u us   Worst period: %u us   AEC late: %u%s\n"
+                 "TX lead: %d us   RX backlog: %u   Clock trims: %u   Ear late: %u",
+                 (unsigned)xrun.deadlineMisses, (unsigned)xrun.lateReads,
+                 (unsigned)xrun.rxOverruns, (unsigned)xrun.txUnderruns,
+                 (unsigned)xrun.blockUs, (unsigned)xrun.worstBlockUs, (unsigned)xrun.worstPeriodUs,
+                 (unsigned)xrun.aecLateFrames, xrun.aecDegraded ? "   AEC DEGRADED" : "",
+                 (int)xrun.txLeadUs, (unsigned)xrun.rxBacklog, (unsigned)xrun.clockTrims,
+                 (unsigned)xrun.earLateFrames);
+        if (cache.available) {
+            snprintf(text + n, sizeof(text) - n,
+                     "\nCache: L1 %.1f%% hit, %u miss   L2 miss: %u   worst %u   in worst block %u",
+                     cache.l1HitPct, (unsigned)cache.l1Miss, (unsigned)cache.l2Miss, (unsigned)cache.worstL2Miss,
+                     (unsigned)cache.worstBlockL2Miss);
+        }
+        lv_label_set_text(_diagXrunLabel, text);
+        lv_obj_set_style_text_color(_diagXrunLabel,
+            lv_color_hex(xrun.deadlineMisses || xrun.txUnderruns ? METER_RED : LAVENDER), LV_PART_MAIN);
+    }
+
+    if (_diagBenchView) {
+        updateDiagBench();
+        return;
+    }
+
+    AudioStageStats stats = AudioEngine::getInstance().getStageStats();
+    if (stats.windowBlocks == 0 || stats.cpuMhz == 0) return;
+
+    // One text buffer per column, one line per stage
+    char cols[6][AUDIO_STAGE_COUNT * 16];
+    int len[6] = {};
+    // One I/O block at the block size and rate the audio task runs
+    const AudioLevels levels = AudioEngine::getInstance().getLevels();
+    const int blockSize = levels.latency.blockSize > 0 ? levels.latency.blockSize : 480;
+    const int sampleRate = levels.sampleRate > 0 ? levels.sampleRate : 48000;
+    const float budgetUs = 1e6f * blockSize / sampleRate;
+    const float mhz = (float)stats.cpuMhz;
+    for (int s = 0; s < AUDIO_STAGE_COUNT; s++) {
+        const auto& st = stats.stages[s];
+        const char* sep = (s + 1 < AUDIO_STAGE_COUNT) ? "\n" : "";
+        float p99Us = st.p99Cycles / mhz;
+        len[0] += snprintf(cols[0] + len[0], sizeof(cols[0]) - len[0], "%s%s", st.name, sep);
+        len[1] += snprintf(cols[1] + len[1], sizeof(cols[1]) - len[1], "%.0f%s", st.minCycles / mhz, sep);
+        len[2] += snprintf(cols[2] + len[2], sizeof(cols[2]) - len[2], "%.0f%s", st.avgCycles / mhz, sep);
+        len[3] += snprintf(cols[3] + len[3], sizeof(cols[3]) - len[3], "%.0f%s", p99Us, sep);
+        len[4] += snprintf(cols[4] + len[4], sizeof(cols[4]) - len[4], "%.0f%s", st.maxCycles / mhz, sep);
+        len[5] += snprintf(cols[5] + len[5], sizeof(cols[5]) - len[5], "%.1f%s", 100.0f * p99Us / budgetUs, sep);
+    }
+    for (int c = 0; c < 6; c++) {
+        lv_label_set_text(_diagColumns[c], cols[c]);
+    }
+
+    char summary[96];
+    snprintf(summary, sizeof(summary), "%u blocks @ %u MHz, %u dropped  |  budget %.0f us per block",
+             (unsigned)stats.windowBlocks, (unsigned)stats.cpuMhz, (unsigned)stats.droppedBlocks, budgetUs);
+    lv_label_set_text(_diagSummaryLabel, summary);
+#endif
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Hidden panel: SYSTEM (per-core load, task run-time share, heap)
+// ─────────────────────────────────────────────────────────────────────────────
+
+void WizardUI::createSysPanel()
+{
+    int cx = CONTENT_W / 2;
+
+    createSectionLabel(_panelSys, "SYSTEM LOAD", cx - 70, 20);
+    createDiamondDivider(_panelSys, 55, 400);
+
+    _sysCoreLabel = lv_label_create(_panelSys);
+    lv_label_set_text(_sysCoreLabel, "");
+    lv_obj_set_style_text_font(_sysCoreLabel, &lv_font_montserrat_16, LV_PART_MAIN);
+    lv_obj_set_style_text_color(_sysCoreLabel, lv_color_hex(GOLD_BRIGHT), LV_PART_MAIN);
+    lv_obj_set_pos(_sysCoreLabel, 80, 70);
+
+    static const char* headers[] = {"TASK", "CORE", "PRIO", "CPU %", "STACK FREE"};
+    static const int colX[] = {80, 280, 390, 500, 630};
+    constexpr int COL_W = 110;
+    for (int c = 0; c < 5; c++) {
+        lv_obj_t* hdr = lv_label_create(_panelSys);
+        lv_label_set_text(hdr, headers[c]);
+        WizardTheme::applyCompactText(hdr);
+        lv_obj_set_style_text_color(hdr, lv_color_hex(LAVENDER), LV_PART_MAIN);
+        lv_obj_set_width(hdr, c == 0 ? 180 : (c == 4 ? 140 : COL_W));
+        lv_obj_set_style_text_align(hdr, c == 0 ? LV_TEXT_ALIGN_LEFT : LV_TEXT_ALIGN_RIGHT, LV_PART_MAIN);
+        lv_obj_set_pos(hdr, colX[c], 105);
+
+        _sysColumns[c] = lv_label_create(_panelSys);
+        lv_label_set_text(_sysColumns[c], "");
+        WizardTheme::applyCompactText(_sysColumns[c]);
+        lv_obj_set_style_text_color(_sysColumns[c], lv_color_hex(c == 0 ? MUTED_TEXT : GOLD_BRIGHT), LV_PART_MAIN);
+        lv_obj_set_style_text_line_space(_sysColumns[c], 6, LV_PART_MAIN);
+        lv_obj_set_width(_sysColumns[c], c == 0 ? 180 : (c == 4 ? 140 : COL_W));
+        lv_obj_set_style_text_align(_sysColumns[c], c == 0 ? LV_TEXT_ALIGN_LEFT : LV_TEXT_ALIGN_RIGHT, LV_PART_MAIN);
+        lv_obj_set_pos(_sysColumns[c], colX[c], 135);
+    }
+
+    _sysHeapLabel = lv_label_create(_panelSys);
+    lv_label_set_text(_sysHeapLabel, "");
+    WizardTheme::applyCompactText(_sysHeapLabel);
+    lv_obj_set_style_text_color(_sysHeapLabel, lv_color_hex(LAVENDER), LV_PART_MAIN);
+    lv_obj_set_style_text_line_space(_sysHeapLabel, 6, LV_PART_MAIN);
+    lv_obj_set_pos(_sysHeapLabel, 80, CONTENT_H - 120);
+
+    // Heap soak: the app closes and reopens itself, checkpoints log any fragmentation
+    lv_obj_t* soakBtn = lv_btn_create(_panelSys);
+    lv_obj_set_size(soakBtn, 150, 36);
+    lv_obj_set_pos(soakBtn, 880, 105);
+    styleToggleWizard(soakBtn);
+    lv_obj_add_event_cb(soakBtn, onSysSoakClicked, LV_EVENT_CLICKED, this);
+
+    _sysSoakLabel = lv_label_create(soakBtn);
+    WizardTheme::applyCompactText(_sysSoakLabel);
+    lv_obj_set_style_text_color(_sysSoakLabel, lv_color_hex(LAVENDER), LV_PART_MAIN);
+    lv_obj_center(_sysSoakLabel);
+    lv_label_set_text(_sysSoakLabel, heap_tracker::IsSoaking() ? "STOP SOAK" : "HEAP SOAK");
+
+    // Power profiler: INA226 samples tagged with the active features, fitted per feature
+    lv_obj_t* powerBtn = lv_btn_create(_panelSys);
+    lv_obj_set_size(powerBtn, 110, 36);
+    lv_obj_set_pos(powerBtn, 1040, 105);
+    styleToggleWizard(powerBtn);
+    lv_obj_add_event_cb(powerBtn, onSysPowerClicked, LV_EVENT_CLICKED, this);
+
+    _sysPowerBtnLabel = lv_label_create(powerBtn);
+    WizardTheme::applyCompactText(_sysPowerBtnLabel);
+    lv_obj_set_style_text_color(_sysPowerBtnLabel, lv_color_hex(LAVENDER), LV_PART_MAIN);
+    lv_obj_center(_sysPowerBtnLabel);
+    lv_label_set_text(_sysPowerBtnLabel, "POWER");
+
+    _sysPowerLabel = lv_label_create(_panelSys);
+    lv_label_set_text(_sysPowerLabel, "");
+    WizardTheme::applyCompactText(_sysPowerLabel);
+    lv_obj_set_style_text_color(_sysPowerLabel, lv_color_hex(LAVENDER), LV_PART_MAIN);
+    lv_obj_set_style_text_line_space(_sysPowerLabel, 6, LV_PART_MAIN);
+    lv_obj_set_pos(_sysPowerLabel, 880, 455);
+
+    // Contention run: the engine on a heavy profile alone, then next to the camera, UI, SD and Wi-Fi
+    lv_obj_t* stressBtn = lv_btn_create(_panelSys);
+    lv_obj_set_size(stressBtn, 150, 36);
+    lv_obj_set_pos(stressBtn, 880, 60);
+    styleToggleWizard(stressBtn);
+    lv_obj_add_event_cb(stressBtn, onSysStressClicked, LV_EVENT_CLICKED, this);
+
+    _sysStressBtnLabel = lv_label_create(stressBtn);
+    WizardTheme::applyCompactText(_sysStressBtnLabel);
+    lv_obj_set_style_text_color(_sysStressBtnLabel, lv_color_hex(LAVENDER), LV_PART_MAIN);
+    lv_obj_center(_sysStressBtnLabel);
+    lv_label_set_text(_sysStressBtnLabel, "STRESS");
+
+    _sysStressLabel = lv_label_create(_panelSys);
+    lv_label_set_text(_sysStressLabel, "");
+    WizardTheme::applyCaptionText(_sysStressLabel);
+    lv_obj_set_style_text_color(_sysStressLabel, lv_color_hex(GOLD_BRIGHT), LV_PART_MAIN);
+    lv_obj_set_style_text_line_space(_sysStressLabel, 4, LV_PART_MAIN);
+    lv_obj_set_pos(_sysStressLabel, 880, 565);
+
+    // Sampling profiler: PCs of both cores for 10s, folded into /sd/profile
+    lv_obj_t* profileBtn = lv_btn_create(_panelSys);
+    lv_obj_set_size(profileBtn, 110, 36);
+    lv_obj_set_pos(profileBtn, 1040, 60);
+    styleToggleWizard(profileBtn);
+    lv_obj_add_event_cb(profileBtn, onSysProfileClicked, LV_EVENT_CLICKED, this);
+
+    _sysProfileBtnLabel = lv_label_create(profileBtn);
+    WizardTheme::applyCompactText(_sysProfileBtnLabel);
+    lv_obj_set_style_text_color(_sysProfileBtnLabel, lv_color_hex(LAVENDER), LV_PART_MAIN);
+    lv_obj_center(_sysProfileBtnLabel);
+    lv_label_set_text(_sysProfileBtnLabel, "PROFILE");
+
+    // Display pipeline: replaces the LVGL perf monitor overlay
+    createSectionLabel(_panelSys, "FRAME TIME", 880, 165);
+
+    _sysFrameLabel = lv_label_create(_panelSys);
+    lv_label_set_text(_sysFrameLabel, "");
+    WizardTheme::applyCompactText(_sysFrameLabel);
+    lv_obj_set_style_text_color(_sysFrameLabel, lv_color_hex(GOLD_BRIGHT), LV_PART_MAIN);
+    lv_obj_set_style_text_line_space(_sysFrameLabel, 6, LV_PART_MAIN);
+    lv_obj_set_pos(_sysFrameLabel, 880, 195);
+
+    // Share of each stage's samples per bucket, header row first
+    constexpr int FRAME_COL_W = 28;
+    for (int c = 0; c < 9; c++) {
+        _sysFrameCols[c] = lv_label_create(_panelSys);
+        lv_label_set_text(_sysFrameCols[c], "");
+        WizardTheme::applyCaptionText(_sysFrameCols[c]);
+        lv_obj_set_style_text_color(_sysFrameCols[c], lv_color_hex(c == 0 ? LAVENDER : GOLD_BRIGHT), LV_PART_MAIN);
+        lv_obj_set_style_text_line_space(_sysFrameCols[c], 6, LV_PART_MAIN);
+        lv_obj_set_width(_sysFrameCols[c], c == 0 ? 52 : FRAME_COL_W);
+        lv_obj_set_style_text_align(_sysFrameCols[c], c == 0 ? LV_TEXT_ALIGN_LEFT : LV_TEXT_ALIGN_RIGHT,
+                                    LV_PART_MAIN);
+        lv_obj_set_pos(_sysFrameCols[c], c == 0 ? 880 : 932 + (c - 1) * FRAME_COL_W, 330);
+    }
+}
+
+void WizardUI::updateSysPanel()
+{
+    auto* hal = GetHAL();
+    hal->updateSystemStats();
+    const auto& stats = hal->systemStats;
+
+    char text[160];
+    snprintf(text, sizeof(text), "Core 0: %.1f%%    Core 1: %.1f%%    Tasks: %u",
+             stats.coreLoad[0], stats.coreLoad[1], (unsigned)stats.tasks.size());
+    lv_label_set_text(_sysCoreLabel, text);
+
+    // One text buffer per column, one line per task (busiest first)
+    char cols[5][SYS_TASK_ROWS * 24];
+    int len[5] = {};
+    const int rows = std::min<int>(SYS_TASK_ROWS, stats.tasks.size());
+    for (int i = 0; i < rows; i++) {
+        const auto& t = stats.tasks[i];
+        const char* sep = (i + 1 < rows) ? "\n" : "";
+        len[0] += snprintf(cols[0] + len[0], sizeof(cols[0]) - len[0], "%s%s", t.name.c_str(), sep);
+        if (t.core < 0) {
+            len[1] += snprintf(cols[1] + len[1], sizeof(cols[1]) - len[1], "-%s", sep);
+        } else {
+            len[1] += snprintf(cols[1] + len[1], sizeof(cols[1]) - len[1], "%d%s", t.core, sep);
+        }
+        len[2] += snprintf(cols[2] + len[2], sizeof(cols[2]) - len[2], "%d%s", t.priority, sep);
+        len[3] += snprintf(cols[3] + len[3], sizeof(cols[3]) - len[3], "%.1f%s", t.cpuPercent, sep);
+        len[4] += snprintf(cols[4] + len[4], sizeof(cols[4]) - len[4], "%u B%s", (unsigned)t.stackFreeBytes, sep);
+    }
+    for (int c = 0; c < 5; c++) {
+        lv_label_set_text(_sysColumns[c], rows ? cols[c] : "");
+    }
+
+    auto kb = [](uint32_t bytes) { return bytes / 1024.0f; };
+    char heap[512];
+    int n = 0;
+    const struct {
+        const char* name;
+        const hal::HalBase::HeapStats_t& h;
+    } heaps[] = {{"Internal", stats.heapInternal}, {"DMA", stats.heapDma}, {"PSRAM", stats.heapPsram}};
+    for (const auto& e : heaps) {
+        n += snprintf(heap + n, sizeof(heap) - n,
+                      "%s%-8s  free %.1f / %.1f KB   min free %.1f KB   largest block %.1f KB",
+                      n ? "\n" : "", e.name, kb(e.h.freeBytes), kb(e.h.totalBytes), kb(e.h.minFreeBytes),
+                      kb(e.h.largestFree));
+    }
+    // LVGL's own regions, when LVGL runs on the port's allocator
+    if (stats.lvglInternal.totalBytes) {
+        const auto& li = stats.lvglInternal;
+        const auto& lp = stats.lvglPsram;
+        n += snprintf(heap + n, sizeof(heap) - n,
+                      "\nLVGL      int %.1f / %.1f KB, min %.1f   PSRAM %.1f / %.1f KB, min %.1f   spilled %u",
+                      kb(li.freeBytes), kb(li.totalBytes), kb(li.minFreeBytes), kb(lp.freeBytes), kb(lp.totalBytes),
+                      kb(lp.minFreeBytes), (unsigned)stats.lvglSpilled);
     }
+    lv_label_set_text(_sysHeapLabel, heap);
+
+    hal->updateDisplayStats();
+    const auto& disp = hal->displayStats;
+    const uint32_t full = disp.dirtyBuckets[hal::HalBase::FRAME_BUCKETS - 1];
+    char frame[256];
+    snprintf(frame, sizeof(frame),
+             "%.1f fps   %u frames\n"
+             "frame   %.1f ms avg, %.1f max\n"
+             "render  %.1f ms, rotate %.1f, flush %.1f, ppa %.1f\n"
+             "dirty   %.0f%% avg, %.0f%% max, %u full\n"
+             "cache   L1 %.0f miss, L2 %.0f, max %u",
+             disp.fps, (unsigned)disp.frame.count, disp.frame.avgMs, disp.frame.maxMs, disp.render.avgMs,
+             disp.rotate.avgMs, disp.flush.avgMs, disp.ppaDraw.avgMs, disp.dirtyAvgPct, disp.dirtyMaxPct,
+             (unsigned)full, disp.cacheL1MissAvg, disp.cacheL2MissAvg, (unsigned)disp.cacheL2MissMax);
+    lv_label_set_text(_sysFrameLabel, frame);
+
+    static const char* bucketNames[hal::HalBase::FRAME_BUCKETS] = {"<1", "<2", "<4", "<8", "<16", "<32", "<64", "64+"};
+    const struct {
+        const char* name;
+        const hal::HalBase::FrameHist_t& h;
+    } stages[] = {{"frame", disp.frame}, {"render", disp.render}, {"rotate", disp.rotate}, {"flush", disp.flush}};
+    char hist[9][64];
+    int hlen[9] = {};
+    hlen[0] = snprintf(hist[0], sizeof(hist[0]), "ms %%");
+    for (int b = 0; b < hal::HalBase::FRAME_BUCKETS; b++) {
+        hlen[b + 1] = snprintf(hist[b + 1], sizeof(hist[b + 1]), "%s", bucketNames[b]);
+    }
+    for (const auto& st : stages) {
+        hlen[0] += snprintf(hist[0] + hlen[0], sizeof(hist[0]) - hlen[0], "\n%s", st.name);
+        for (int b = 0; b < hal::HalBase::FRAME_BUCKETS; b++) {
+            const int pct = st.h.count ? static_cast<int>(100.0f * st.h.buckets[b] / st.h.count + 0.5f) : 0;
+            hlen[b + 1] += snprintf(hist[b + 1] + hlen[b + 1], sizeof(hist[b + 1]) - hlen[b + 1], "\n%d", pct);
+        }
+    }
+    for (int c = 0; c < 9; c++) {
+        lv_label_set_text(_sysFrameCols[c], hist[c]);
+    }
+
+#ifdef ESP_PLATFORM
+    auto& profiler = PowerProfiler::getInstance();
+    lv_label_set_text(_sysPowerBtnLabel, profiler.isRunning() ? "STOP PWR" : "POWER");
+    const PowerProfileReport pr = profiler.getReport();
+    char power[256];
+    if (pr.samples == 0) {
+        snprintf(power, sizeof(power), "Power profiler off");
+    } else {
+        int pn = snprintf(power, sizeof(power), "%.0f mW now, %.0f avg, %.0f s\n", pr.lastMw, pr.avgMw, pr.seconds);
+        if (pr.featureCount == 0) {
+            snprintf(power + pn, sizeof(power) - pn, "collecting...");
+        } else {
+            pn += snprintf(power + pn, sizeof(power) - pn, "base %.0f mW, backlight %+.0f / 10%%", pr.baseMw,
+                           pr.perBrightnessMw);
+            // Costliest three the fit could separate
+            for (int i = 0; i < std::min(pr.featureCount, 3) && pr.features[i].observed; i++) {
+                pn += snprintf(power + pn, sizeof(power) - pn, "\n%-10s %+.0f mW", pr.features[i].name,
+                               pr.features[i].mW);
+            }
+        }
+    }
+    lv_label_set_text(_sysPowerLabel, power);
+
+    auto& stress = StressTest::getInstance();
+    lv_label_set_text(_sysStressBtnLabel, stress.isRunning() ? "STOP STRESS" : "STRESS");
+    lv_label_set_text(_sysProfileBtnLabel, SamplingProfiler::getInstance().isRunning() ? "STOP PROF" : "PROFILE");
+    const StressReport sr = stress.getReport();
+    char stressText[160] = "";
+    if (sr.running) {
+        snprintf(stressText, sizeof(stressText), "Stress running...\nUI %u frames, SD %u KB, Wi-Fi %u KB",
+                 (unsigned)sr.uiFrames, (unsigned)sr.sdKB, (unsigned)sr.wifiKB);
+    } else if (sr.baseline.blocks) {
+        snprintf(stressText, sizeof(stressText), "Misses %.2f%% -> %.2f%%, worst %u -> %u us\nPSRAM -%.0f%%%s",
+                 sr.baseline.missPct, sr.loaded.missPct, (unsigned)sr.baseline.worstBlockUs,
+                 (unsigned)sr.loaded.worstBlockUs, sr.bandwidthPressurePct, sr.ok ? "" : ", incomplete");
+    }
+    lv_label_set_text(_sysStressLabel, stressText);
+    lv_obj_set_style_text_color(_sysStressLabel,
+        lv_color_hex(sr.loaded.deadlineMisses || sr.loaded.txUnderruns ? METER_RED : GOLD_BRIGHT), LV_PART_MAIN);
 #endif
 }
 
@@ -1391,75 +2444,117 @@ void WizardUI::createFooter()
     // Headphone status
     _hpStatusLabel = lv_label_create(_footerBar);
     lv_label_set_text(_hpStatusLabel, "HP: ---");
-    lv_obj_set_style_text_font(_hpStatusLabel, &lv_font_montserrat_14, LV_PART_MAIN);
+    WizardTheme::applyCompactText(_hpStatusLabel);
     lv_obj_set_style_text_color(_hpStatusLabel, lv_color_hex(MUTED_TEXT), LV_PART_MAIN);
     lv_obj_set_pos(_hpStatusLabel, 30, 10);
 
     // Sample rate
     lv_obj_t* srLabel = lv_label_create(_footerBar);
     lv_label_set_text(srLabel, "Sample: 48kHz");
-    lv_obj_set_style_text_font(srLabel, &lv_font_montserrat_14, LV_PART_MAIN);
+    WizardTheme::applyCompactText(srLabel);
     lv_obj_set_style_text_color(srLabel, lv_color_hex(MUTED_TEXT), LV_PART_MAIN);
     lv_obj_set_pos(srLabel, 250, 10);
 
     // Block size
     lv_obj_t* bsLabel = lv_label_create(_footerBar);
     lv_label_set_text(bsLabel, "Block: 480");
-    lv_obj_set_style_text_font(bsLabel, &lv_font_montserrat_14, LV_PART_MAIN);
+    WizardTheme::applyCompactText(bsLabel);
     lv_obj_set_style_text_color(bsLabel, lv_color_hex(MUTED_TEXT), LV_PART_MAIN);
     lv_obj_set_pos(bsLabel, 450, 10);
 
     // Latency
     lv_obj_t* ltLabel = lv_label_create(_footerBar);
     lv_label_set_text(ltLabel, "Latency: ~10.0ms");
-    lv_obj_set_style_text_font(ltLabel, &lv_font_montserrat_14, LV_PART_MAIN);
+    WizardTheme::applyCompactText(ltLabel);
     lv_obj_set_style_text_color(ltLabel, lv_color_hex(MUTED_TEXT), LV_PART_MAIN);
     lv_obj_set_pos(ltLabel, 620, 10);
+
+    // Thermal policy tier, empty while at full quality
+    _thermalLabel = lv_label_create(_footerBar);
+    lv_label_set_text(_thermalLabel, "");
+    WizardTheme::applyCompactText(_thermalLabel);
+    lv_obj_set_style_text_color(_thermalLabel, lv_color_hex(METER_RED), LV_PART_MAIN);
+    lv_obj_set_pos(_thermalLabel, 850, 10);
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
-// Sync all UI controls to engine params (after profile load or init)
+// Sync UI controls to engine params (after profile load, remote edit or panel build)
+//
+// Each params field group carries the generation it last changed in; a sync touches
+// only the widgets of groups that moved since the previous one, or whose ear the
+// selector switched to. A panel just built starts at its defaults and takes `all`.
 // ─────────────────────────────────────────────────────────────────────────────
 
-void WizardUI::syncUiToParams()
+void WizardUI::syncUiToParams(bool all)
 {
 #ifdef ESP_PLATFORM
-    auto params = AudioEngine::getInstance().getParams();
+    AudioParamGenerations gens;
+    auto params = AudioEngine::getInstance().getParams(gens);
     char buf[32];
 
-    // ── Filter panel ──
-    if (_hpfSlider) {
-        lv_slider_set_value(_hpfSlider, (int)params.hpfFrequency, LV_ANIM_OFF);
-        snprintf(buf, sizeof(buf), "%d Hz", (int)params.hpfFrequency);
-        if (_hpfValueLabel) lv_label_set_text(_hpfValueLabel, buf);
+    // ── Ear selector: a profile may have linked or unlinked the ears under us ──
+    if (params.earsLinked) {
+        _editEar = AUDIO_EAR_BOTH;
+    } else if (_editEar == AUDIO_EAR_BOTH) {
+        _editEar = AUDIO_EAR_LEFT;
     }
-    if (_hpfToggle) {
-        lv_obj_t* lbl = lv_obj_get_child(_hpfToggle, 0);
-        if (lbl) lv_label_set_text(lbl, params.hpfEnabled ? "HPF ON" : "HPF OFF");
-        lv_obj_set_style_border_color(_hpfToggle,
-            lv_color_hex(params.hpfEnabled ? CYAN_GLOW : GOLD), LV_PART_MAIN);
+    const bool earMoved = _editEar != _syncedEar;
+    auto changed = [&](AudioParamField f) { return all || gens.changedSince(f, _syncedParamsGen); };
+    auto earChanged = [&](AudioParamField f) { return earMoved || changed(f); };
+
+    static const char* const EAR_TEXT[] = {"EDIT: LEFT", "EDIT: RIGHT", "EARS: L+R"};
+    if (earChanged(AUDIO_PARAM_EARS)) {
+        for (lv_obj_t* btn : _earBtns) {
+            if (!btn) continue;
+            lv_obj_t* lbl = lv_obj_get_child(btn, 0);
+            ValueLabel::setText(lbl, EAR_TEXT[_editEar]);
+            lv_obj_set_style_border_color(btn,
+                lv_color_hex(params.earsLinked ? GOLD : CYAN_GLOW), LV_PART_MAIN);
+        }
     }
-    if (_lpfSlider) {
-        lv_slider_set_value(_lpfSlider, (int)params.lpfFrequency, LV_ANIM_OFF);
-        snprintf(buf, sizeof(buf), "%d Hz", (int)params.lpfFrequency);
-        if (_lpfValueLabel) lv_label_set_text(_lpfValueLabel, buf);
+    const EarParams ear = params.ear(static_cast<AudioEar>(_editEar));
+
+    // ── Filter panel ──
+    if (earChanged(AUDIO_PARAM_HPF)) {
+        if (_hpfSlider) {
+            lv_slider_set_value(_hpfSlider, (int)ear.hpfFrequency, LV_ANIM_OFF);
+            ValueLabel::setInt(_hpfValueLabel, (int)ear.hpfFrequency, " Hz");
+        }
+        if (_hpfToggle) {
+            lv_obj_t* lbl = lv_obj_get_child(_hpfToggle, 0);
+            ValueLabel::setText(lbl, ear.hpfEnabled ? "HPF ON" : "HPF OFF");
+            lv_obj_set_style_border_color(_hpfToggle,
+                lv_color_hex(ear.hpfEnabled ? CYAN_GLOW : GOLD), LV_PART_MAIN);
+        }
     }
-    if (_lpfToggle) {
-        lv_obj_t* lbl = lv_obj_get_child(_lpfToggle, 0);
-        if (lbl) lv_label_set_text(lbl, params.lpfEnabled ? "LPF ON" : "LPF OFF");
-        lv_obj_set_style_border_color(_lpfToggle,
-            lv_color_hex(params.lpfEnabled ? CYAN_GLOW : GOLD), LV_PART_MAIN);
+    if (earChanged(AUDIO_PARAM_LPF)) {
+        if (_lpfSlider) {
+            lv_slider_set_value(_lpfSlider, (int)ear.lpfFrequency, LV_ANIM_OFF);
+            ValueLabel::setInt(_lpfValueLabel, (int)ear.lpfFrequency, " Hz");
+        }
+        if (_lpfToggle) {
+            lv_obj_t* lbl = lv_obj_get_child(_lpfToggle, 0);
+            ValueLabel::setText(lbl, ear.lpfEnabled ? "LPF ON" : "LPF OFF");
+            lv_obj_set_style_border_color(_lpfToggle,
+                lv_color_hex(ear.lpfEnabled ? CYAN_GLOW : GOLD), LV_PART_MAIN);
+        }
     }
 
     // NS
-    if (_nsToggle) {
-        lv_obj_t* lbl = lv_obj_get_child(_nsToggle, 0);
-        if (lbl) lv_label_set_text(lbl, params.nsEnabled ? "NS ON" : "NS OFF");
-        lv_obj_set_style_border_color(_nsToggle,
-            lv_color_hex(params.nsEnabled ? CYAN_GLOW : GOLD), LV_PART_MAIN);
-    }
-    _nsActiveMode = params.nsMode;
-    {
+    if (changed(AUDIO_PARAM_NS)) {
+        if (_nsToggle) {
+            lv_obj_t* lbl = lv_obj_get_child(_nsToggle, 0);
+            ValueLabel::setText(lbl, params.nsEnabled ? "NS ON" : "NS OFF");
+            lv_obj_set_style_border_color(_nsToggle,
+                lv_color_hex(params.nsEnabled ? CYAN_GLOW : GOLD), LV_PART_MAIN);
+        }
+        if (_nsLinkToggle) {
+            lv_obj_t* lbl = lv_obj_get_child(_nsLinkToggle, 0);
+            ValueLabel::setText(lbl, params.nsLinked ? "LINKED" : "PER EAR");
+            lv_obj_set_style_border_color(_nsLinkToggle,
+                lv_color_hex(params.nsLinked ? CYAN_GLOW : GOLD), LV_PART_MAIN);
+        }
+        _nsActiveMode = params.nsMode;
         lv_obj_t* nsBtns[] = {_nsModeBtn0, _nsModeBtn1, _nsModeBtn2};
         for (int i = 0; i < 3; i++) {
             if (!nsBtns[i]) continue;
@@ -1471,65 +2566,71 @@ void WizardUI::syncUiToParams()
     }
 
     // ── EQ panel ──
-    auto setEqSlider = [&](lv_obj_t* slider, lv_obj_t* label, float db) {
-        if (slider) lv_slider_set_value(slider, (int)(db * 10.0f), LV_ANIM_OFF);
-        if (label) {
-            snprintf(buf, sizeof(buf), "%+.1f dB", (double)db);
-            lv_label_set_text(label, buf);
-        }
-    };
-    setEqSlider(_eqLowSlider, _eqLowLabel, params.eqLowGain);
-    setEqSlider(_eqMidSlider, _eqMidLabel, params.eqMidGain);
-    setEqSlider(_eqHighSlider, _eqHighLabel, params.eqHighGain);
+    if (earChanged(AUDIO_PARAM_EQ)) {
+        auto setEqSlider = [&](lv_obj_t* slider, lv_obj_t* label, float db) {
+            if (slider) lv_slider_set_value(slider, (int)(db * 10.0f), LV_ANIM_OFF);
+            if (label) {
+                ValueLabel::setFixed(label, db, 1, " dB", true);
+            }
+        };
+        setEqSlider(_eqLowSlider, _eqLowLabel, ear.eqLowGain);
+        setEqSlider(_eqMidSlider, _eqMidLabel, ear.eqMidGain);
+        setEqSlider(_eqHighSlider, _eqHighLabel, ear.eqHighGain);
+    }
 
     // ── Output panel ──
-    if (_volumeSlider) {
-        lv_slider_set_value(_volumeSlider, params.outputVolume, LV_ANIM_OFF);
-        snprintf(buf, sizeof(buf), "%d", params.outputVolume);
-        if (_volumeValueLabel) lv_label_set_text(_volumeValueLabel, buf);
-    }
-    if (_gainSlider) {
-        lv_slider_set_value(_gainSlider, (int)(params.outputGain * 100.0f), LV_ANIM_OFF);
-        if (params.outputGain > 1.0f) {
-            snprintf(buf, sizeof(buf), "%.2fx (%d%%)", (double)params.outputGain, (int)(params.outputGain * 100.0f));
-        } else {
-            snprintf(buf, sizeof(buf), "%.2fx", (double)params.outputGain);
+    if (changed(AUDIO_PARAM_LEVELS)) {
+        if (_volumeSlider) {
+            lv_slider_set_value(_volumeSlider, params.outputVolume, LV_ANIM_OFF);
+            ValueLabel::setInt(_volumeValueLabel, params.outputVolume);
+        }
+        if (_micGainSlider) {
+            lv_slider_set_value(_micGainSlider, (int)params.micGain, LV_ANIM_OFF);
+            ValueLabel::setInt(_micGainValueLabel, (int)params.micGain);
         }
-        if (_gainValueLabel) lv_label_set_text(_gainValueLabel, buf);
     }
-    if (_micGainSlider) {
-        lv_slider_set_value(_micGainSlider, (int)params.micGain, LV_ANIM_OFF);
-        snprintf(buf, sizeof(buf), "%d", (int)params.micGain);
-        if (_micGainValueLabel) lv_label_set_text(_micGainValueLabel, buf);
+    if (earChanged(AUDIO_PARAM_OUTPUT_GAIN) && _gainSlider) {
+        lv_slider_set_value(_gainSlider, (int)(ear.outputGain * 100.0f), LV_ANIM_OFF);
+        if (ear.outputGain > 1.0f) {
+            snprintf(buf, sizeof(buf), "%.2fx (%d%%)", (double)ear.outputGain, (int)(ear.outputGain * 100.0f));
+        } else {
+            snprintf(buf, sizeof(buf), "%.2fx", (double)ear.outputGain);
+        }
+        ValueLabel::setText(_gainValueLabel, buf);
     }
 
     // Boost toggle
-    if (_boostToggle) {
-        lv_obj_t* lbl = lv_obj_get_child(_boostToggle, 0);
-        if (lbl) {
-            lv_obj_set_style_text_color(lbl,
-                lv_color_hex(params.boostEnabled ? GOLD_BRIGHT : LAVENDER), LV_PART_MAIN);
+    if (changed(AUDIO_PARAM_BOOST)) {
+        if (_boostToggle) {
+            lv_obj_t* lbl = lv_obj_get_child(_boostToggle, 0);
+            if (lbl) {
+                lv_obj_set_style_text_color(lbl,
+                    lv_color_hex(params.boostEnabled ? GOLD_BRIGHT : LAVENDER), LV_PART_MAIN);
+            }
+            lv_obj_set_style_border_color(_boostToggle,
+                lv_color_hex(params.boostEnabled ? CYAN_GLOW : GOLD), LV_PART_MAIN);
         }
-        lv_obj_set_style_border_color(_boostToggle,
-            lv_color_hex(params.boostEnabled ? CYAN_GLOW : GOLD), LV_PART_MAIN);
-    }
-    if (_boostWarningLabel) {
-        if (params.boostEnabled) {
-            lv_obj_remove_flag(_boostWarningLabel, LV_OBJ_FLAG_HIDDEN);
-        } else {
-            lv_obj_add_flag(_boostWarningLabel, LV_OBJ_FLAG_HIDDEN);
+        if (_boostWarningLabel) {
+            if (params.boostEnabled) {
+                lv_obj_remove_flag(_boostWarningLabel, LV_OBJ_FLAG_HIDDEN);
+            } else {
+                lv_obj_add_flag(_boostWarningLabel, LV_OBJ_FLAG_HIDDEN);
+            }
         }
     }
 
+    // Latency mode
+    if (changed(AUDIO_PARAM_BLOCK_SIZE)) updateLatencyButtons(params.blockSize);
+
     // AGC
-    if (_agcToggle) {
-        lv_obj_t* lbl = lv_obj_get_child(_agcToggle, 0);
-        if (lbl) lv_label_set_text(lbl, params.agcEnabled ? "AGC ON" : "AGC OFF");
-        lv_obj_set_style_border_color(_agcToggle,
-            lv_color_hex(params.agcEnabled ? CYAN_GLOW : GOLD), LV_PART_MAIN);
-    }
-    _agcActiveMode = params.agcMode;
-    {
+    if (changed(AUDIO_PARAM_AGC)) {
+        if (_agcToggle) {
+            lv_obj_t* lbl = lv_obj_get_child(_agcToggle, 0);
+            ValueLabel::setText(lbl, params.agcEnabled ? "AGC ON" : "AGC OFF");
+            lv_obj_set_style_border_color(_agcToggle,
+                lv_color_hex(params.agcEnabled ? CYAN_GLOW : GOLD), LV_PART_MAIN);
+        }
+        _agcActiveMode = params.agcMode;
         lv_obj_t* agcBtns[] = {_agcModeBtn0, _agcModeBtn1, _agcModeBtn2, _agcModeBtn3};
         for (int i = 0; i < 4; i++) {
             if (!agcBtns[i]) continue;
@@ -1538,67 +2639,65 @@ void WizardUI::syncUiToParams()
             lv_obj_t* c = lv_obj_get_child(agcBtns[i], 0);
             if (c) lv_obj_set_style_text_color(c, lv_color_hex(active ? GOLD_BRIGHT : LAVENDER), LV_PART_MAIN);
         }
-    }
-    if (_agcGainSlider) {
-        lv_slider_set_value(_agcGainSlider, params.agcCompressionGainDb, LV_ANIM_OFF);
-        snprintf(buf, sizeof(buf), "%d dB", params.agcCompressionGainDb);
-        if (_agcGainValueLabel) lv_label_set_text(_agcGainValueLabel, buf);
-    }
-    if (_agcTargetSlider) {
-        lv_slider_set_value(_agcTargetSlider, params.agcTargetLevelDbfs, LV_ANIM_OFF);
-        snprintf(buf, sizeof(buf), "%d dBFS", params.agcTargetLevelDbfs);
-        if (_agcTargetValueLabel) lv_label_set_text(_agcTargetValueLabel, buf);
-    }
-    if (_agcLimiterToggle) {
-        lv_obj_t* lbl = lv_obj_get_child(_agcLimiterToggle, 0);
-        if (lbl) {
-            lv_label_set_text(lbl, params.agcLimiterEnabled ? "LIM ON" : "LIM OFF");
-            lv_obj_set_style_text_color(lbl,
-                lv_color_hex(params.agcLimiterEnabled ? GOLD_BRIGHT : LAVENDER), LV_PART_MAIN);
+        if (_agcGainSlider) {
+            lv_slider_set_value(_agcGainSlider, params.agcCompressionGainDb, LV_ANIM_OFF);
+            ValueLabel::setInt(_agcGainValueLabel, params.agcCompressionGainDb, " dB");
+        }
+        if (_agcTargetSlider) {
+            lv_slider_set_value(_agcTargetSlider, params.agcTargetLevelDbfs, LV_ANIM_OFF);
+            ValueLabel::setInt(_agcTargetValueLabel, params.agcTargetLevelDbfs, " dBFS");
+        }
+        if (_agcLimiterToggle) {
+            lv_obj_t* lbl = lv_obj_get_child(_agcLimiterToggle, 0);
+            if (lbl) {
+                ValueLabel::setText(lbl, params.agcLimiterEnabled ? "LIM ON" : "LIM OFF");
+                lv_obj_set_style_text_color(lbl,
+                    lv_color_hex(params.agcLimiterEnabled ? GOLD_BRIGHT : LAVENDER), LV_PART_MAIN);
+            }
+            lv_obj_set_style_border_color(_agcLimiterToggle,
+                lv_color_hex(params.agcLimiterEnabled ? CYAN_GLOW : GOLD), LV_PART_MAIN);
+        }
+        if (_agcLinkToggle) {
+            lv_obj_t* lbl = lv_obj_get_child(_agcLinkToggle, 0);
+            ValueLabel::setText(lbl, params.agcLinked ? "LINKED" : "PER EAR");
+            lv_obj_set_style_border_color(_agcLinkToggle,
+                lv_color_hex(params.agcLinked ? CYAN_GLOW : GOLD), LV_PART_MAIN);
         }
-        lv_obj_set_style_border_color(_agcLimiterToggle,
-            lv_color_hex(params.agcLimiterEnabled ? CYAN_GLOW : GOLD), LV_PART_MAIN);
     }
 
     // ── Voice panel ──
-    if (_veToggle) {
-        lv_obj_t* lbl = lv_obj_get_child(_veToggle, 0);
-        if (lbl) lv_label_set_text(lbl, params.veEnabled ? "VE ON" : "VE OFF");
-        lv_obj_set_style_border_color(_veToggle,
-            lv_color_hex(params.veEnabled ? CYAN_GLOW : GOLD), LV_PART_MAIN);
-    }
-    if (_veRefGainSlider) {
-        lv_slider_set_value(_veRefGainSlider, (int)(params.veRefGain * 10.0f), LV_ANIM_OFF);
-        snprintf(buf, sizeof(buf), "%.1fx", (double)params.veRefGain);
-        if (_veRefGainValueLabel) lv_label_set_text(_veRefGainValueLabel, buf);
-    }
-    if (_veRefHpfSlider) {
-        lv_slider_set_value(_veRefHpfSlider, (int)params.veRefHpf, LV_ANIM_OFF);
-        snprintf(buf, sizeof(buf), "%d Hz", (int)params.veRefHpf);
-        if (_veRefHpfValueLabel) lv_label_set_text(_veRefHpfValueLabel, buf);
-    }
-    if (_veRefLpfSlider) {
-        lv_slider_set_value(_veRefLpfSlider, (int)params.veRefLpf, LV_ANIM_OFF);
-        snprintf(buf, sizeof(buf), "%d Hz", (int)params.veRefLpf);
-        if (_veRefLpfValueLabel) lv_label_set_text(_veRefLpfValueLabel, buf);
-    }
-    if (_veBlendSlider) {
-        lv_slider_set_value(_veBlendSlider, (int)(params.veBlend * 100.0f), LV_ANIM_OFF);
-        snprintf(buf, sizeof(buf), "%d%%", (int)(params.veBlend * 100.0f));
-        if (_veBlendValueLabel) lv_label_set_text(_veBlendValueLabel, buf);
-    }
-    if (_veStepSlider) {
-        lv_slider_set_value(_veStepSlider, (int)(params.veStepSize * 100.0f), LV_ANIM_OFF);
-        snprintf(buf, sizeof(buf), "%.2f", (double)params.veStepSize);
-        if (_veStepValueLabel) lv_label_set_text(_veStepValueLabel, buf);
-    }
-    if (_veAttenSlider) {
-        lv_slider_set_value(_veAttenSlider, (int)(params.veMaxAttenuation * 100.0f), LV_ANIM_OFF);
-        snprintf(buf, sizeof(buf), "%d%%", (int)(params.veMaxAttenuation * 100.0f));
-        if (_veAttenValueLabel) lv_label_set_text(_veAttenValueLabel, buf);
-    }
-    _veActiveFilterLen = params.veFilterLength;
-    {
+    if (changed(AUDIO_PARAM_VE)) {
+        if (_veToggle) {
+            lv_obj_t* lbl = lv_obj_get_child(_veToggle, 0);
+            ValueLabel::setText(lbl, params.veEnabled ? "VE ON" : "VE OFF");
+            lv_obj_set_style_border_color(_veToggle,
+                lv_color_hex(params.veEnabled ? CYAN_GLOW : GOLD), LV_PART_MAIN);
+        }
+        if (_veRefGainSlider) {
+            lv_slider_set_value(_veRefGainSlider, (int)(params.veRefGain * 10.0f), LV_ANIM_OFF);
+            ValueLabel::setFixed(_veRefGainValueLabel, params.veRefGain, 1, "x");
+        }
+        if (_veRefHpfSlider) {
+            lv_slider_set_value(_veRefHpfSlider, (int)params.veRefHpf, LV_ANIM_OFF);
+            ValueLabel::setInt(_veRefHpfValueLabel, (int)params.veRefHpf, " Hz");
+        }
+        if (_veRefLpfSlider) {
+            lv_slider_set_value(_veRefLpfSlider, (int)params.veRefLpf, LV_ANIM_OFF);
+            ValueLabel::setInt(_veRefLpfValueLabel, (int)params.veRefLpf, " Hz");
+        }
+        if (_veBlendSlider) {
+            lv_slider_set_value(_veBlendSlider, (int)(params.veBlend * 100.0f), LV_ANIM_OFF);
+            ValueLabel::setInt(_veBlendValueLabel, (int)(params.veBlend * 100.0f), "%");
+        }
+        if (_veStepSlider) {
+            lv_slider_set_value(_veStepSlider, (int)(params.veStepSize * 100.0f), LV_ANIM_OFF);
+            ValueLabel::setFixed(_veStepValueLabel, params.veStepSize, 2);
+        }
+        if (_veAttenSlider) {
+            lv_slider_set_value(_veAttenSlider, (int)(params.veMaxAttenuation * 100.0f), LV_ANIM_OFF);
+            ValueLabel::setInt(_veAttenValueLabel, (int)(params.veMaxAttenuation * 100.0f), "%");
+        }
+        _veActiveFilterLen = params.veFilterLength;
         lv_obj_t* fBtns[] = {_veFilterBtn32, _veFilterBtn64, _veFilterBtn128};
         int tapValues[] = {64, 128, 256};
         for (int i = 0; i < 3; i++) {
@@ -1611,25 +2710,151 @@ void WizardUI::syncUiToParams()
     }
 
     // VAD Gate controls
-    if (_veVadGateToggle) {
-        lv_obj_t* lbl = lv_obj_get_child(_veVadGateToggle, 0);
+    if (changed(AUDIO_PARAM_VE_GATE)) {
+        if (_veVadGateToggle) {
+            lv_obj_t* lbl = lv_obj_get_child(_veVadGateToggle, 0);
+            if (lbl) {
+                ValueLabel::setText(lbl, params.veVadGateEnabled ? "GATE ON" : "GATE OFF");
+                lv_obj_set_style_text_color(lbl,
+                    lv_color_hex(params.veVadGateEnabled ? GOLD_BRIGHT : LAVENDER), LV_PART_MAIN);
+            }
+            lv_obj_set_style_border_color(_veVadGateToggle,
+                lv_color_hex(params.veVadGateEnabled ? CYAN_GLOW : GOLD), LV_PART_MAIN);
+        }
+        if (_veVadGateAttenSlider) {
+            int attenPct = (int)(params.veVadGateAtten * 100.0f);
+            lv_slider_set_value(_veVadGateAttenSlider, attenPct, LV_ANIM_OFF);
+            if (_veVadGateAttenValueLabel) {
+                float db = (attenPct > 0) ? 20.0f * log10f(params.veVadGateAtten) : -40.0f;
+                snprintf(buf, sizeof(buf), "%d%% (%.0fdB)", attenPct, (double)db);
+                ValueLabel::setText(_veVadGateAttenValueLabel, buf);
+            }
+        }
+    }
+
+    syncTinnitusToParams(params, gens, all);
+    _syncedParamsGen = gens.latest;
+    _syncedEar = _editEar;
+#else
+    (void)all;
+#endif
+}
+
+#ifdef ESP_PLATFORM
+void WizardUI::syncTinnitusToParams(const AudioEngineParams& params, const AudioParamGenerations& gens, bool all)
+{
+    const TinnitusReliefParams& tin = params.tinnitus;
+    const EarParams ear = params.ear(static_cast<AudioEar>(_editEar));
+    const bool earMoved = _editEar != _syncedEar;
+    auto changed = [&](AudioParamField f) { return all || gens.changedSince(f, _syncedParamsGen); };
+    char buf[16];
+
+    auto setToggle = [&](lv_obj_t* btn, bool on) {
+        if (!btn) return;
+        lv_obj_t* lbl = lv_obj_get_child(btn, 0);
         if (lbl) {
-            lv_label_set_text(lbl, params.veVadGateEnabled ? "GATE ON" : "GATE OFF");
-            lv_obj_set_style_text_color(lbl,
-                lv_color_hex(params.veVadGateEnabled ? GOLD_BRIGHT : LAVENDER), LV_PART_MAIN);
+            ValueLabel::setText(lbl, on ? "ON" : "OFF");
+            lv_obj_set_style_text_color(lbl, lv_color_hex(on ? GOLD_BRIGHT : LAVENDER), LV_PART_MAIN);
         }
-        lv_obj_set_style_border_color(_veVadGateToggle,
-            lv_color_hex(params.veVadGateEnabled ? CYAN_GLOW : GOLD), LV_PART_MAIN);
-    }
-    if (_veVadGateAttenSlider) {
-        int attenPct = (int)(params.veVadGateAtten * 100.0f);
-        lv_slider_set_value(_veVadGateAttenSlider, attenPct, LV_ANIM_OFF);
-        if (_veVadGateAttenValueLabel) {
-            float db = (attenPct > 0) ? 20.0f * log10f(params.veVadGateAtten) : -40.0f;
-            snprintf(buf, sizeof(buf), "%d%% (%.0fdB)", attenPct, (double)db);
-            lv_label_set_text(_veVadGateAttenValueLabel, buf);
+        lv_obj_set_style_border_color(btn, lv_color_hex(on ? CYAN_GLOW : GOLD), LV_PART_MAIN);
+    };
+    auto setSlider = [&](lv_obj_t* slider, int value, lv_obj_t* label) {
+        if (slider) lv_slider_set_value(slider, value, LV_ANIM_OFF);
+        ValueLabel::setText(label, buf);
+    };
+    auto setButtonRow = [&](lv_obj_t* const* btns, int count, int active) {
+        for (int i = 0; i < count; i++) {
+            if (!btns[i]) continue;
+            lv_obj_set_style_border_color(btns[i], lv_color_hex(i == active ? CYAN_GLOW : GOLD), LV_PART_MAIN);
+            lv_obj_t* c = lv_obj_get_child(btns[i], 0);
+            if (c) lv_obj_set_style_text_color(c, lv_color_hex(i == active ? GOLD_BRIGHT : LAVENDER), LV_PART_MAIN);
+        }
+    };
+
+    if (earMoved || changed(AUDIO_PARAM_NOTCHES)) {
+        for (int n = 0; n < 2; n++) {
+            const auto& notch = ear.notches[n];
+            setToggle(_notchToggle[n], notch.enabled);
+            ValueLabel::formatInt(buf, sizeof(buf), (int)notch.frequency, " Hz");
+            setSlider(_notchFreqSlider[n], (int)notch.frequency, _notchFreqLabel[n]);
+            ValueLabel::formatFixed(buf, sizeof(buf), notch.Q, 1);
+            setSlider(_notchQSlider[n], (int)(notch.Q * 10.0f), _notchQLabel[n]);
         }
     }
+
+    if (changed(AUDIO_PARAM_NOISE)) {
+        _noiseActiveType = tin.noiseType;
+        setButtonRow(_noiseTypeBtns, 4, tin.noiseType);
+        ValueLabel::formatInt(buf, sizeof(buf), (int)(tin.noiseLevel * 100.0f), "%");
+        setSlider(_noiseLevelSlider, (int)(tin.noiseLevel * 100.0f), _noiseLevelLabel);
+        ValueLabel::formatInt(buf, sizeof(buf), (int)tin.noiseLowCut, " Hz");
+        setSlider(_noiseLowCutSlider, (int)tin.noiseLowCut, _noiseLowCutLabel);
+        ValueLabel::formatInt(buf, sizeof(buf), (int)tin.noiseHighCut, " Hz");
+        setSlider(_noiseHighCutSlider, (int)tin.noiseHighCut, _noiseHighCutLabel);
+    }
+
+    if (changed(AUDIO_PARAM_TONE_FINDER)) {
+        setToggle(_toneFinderToggle, tin.toneFinderEnabled);
+        ValueLabel::formatInt(buf, sizeof(buf), (int)tin.toneFinderFreq, " Hz");
+        setSlider(_toneFinderFreqSlider, (int)tin.toneFinderFreq, _toneFinderFreqLabel);
+        ValueLabel::formatInt(buf, sizeof(buf), (int)(tin.toneFinderLevel * 100.0f), "%");
+        setSlider(_toneFinderLevelSlider, (int)(tin.toneFinderLevel * 100.0f), _toneFinderLevelLabel);
+    }
+
+    if (changed(AUDIO_PARAM_HF_EXT)) {
+        setToggle(_hfExtToggle, tin.hfExtEnabled);
+        ValueLabel::formatInt(buf, sizeof(buf), (int)tin.hfExtFreq / 1000, "k");
+        setSlider(_hfExtFreqSlider, (int)tin.hfExtFreq, _hfExtFreqLabel);
+        ValueLabel::formatFixed(buf, sizeof(buf), tin.hfExtGainDb, 0, "dB");
+        setSlider(_hfExtGainSlider, (int)(tin.hfExtGainDb * 10.0f), _hfExtGainLabel);
+    }
+
+    if (changed(AUDIO_PARAM_BINAURAL)) {
+        setToggle(_binauralToggle, tin.binauralEnabled);
+        ValueLabel::formatInt(buf, sizeof(buf), (int)tin.binauralCarrier, " Hz");
+        setSlider(_binauralCarrierSlider, (int)tin.binauralCarrier, _binauralCarrierLabel);
+        ValueLabel::formatInt(buf, sizeof(buf), (int)tin.binauralBeat, "Hz");
+        setSlider(_binauralBeatSlider, (int)tin.binauralBeat, _binauralBeatLabel);
+        ValueLabel::formatInt(buf, sizeof(buf), (int)(tin.binauralLevel * 100.0f), "%");
+        setSlider(_binauralLevelSlider, (int)(tin.binauralLevel * 100.0f), _binauralLevelLabel);
+        // The preset highlight follows the beat when it sits on one of the presets
+        static const float presetBeats[] = {2.0f, 6.0f, 10.0f, 20.0f};
+        for (int p = 0; p < 4; p++) {
+            if (tin.binauralBeat == presetBeats[p]) _binauralActivePreset = p;
+        }
+        setButtonRow(_binauralPresetBtns, 4, _binauralActivePreset);
+    }
+}
+#endif
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Parameter edits
+//
+// Slider handlers post their setter instead of calling it, and each update tick
+// (or panel switch) sends whatever piled up as one engine params generation. A drag
+// costs the audio task one param change per UI frame, not one per touch sample.
+// Buttons and toggles still call the engine directly; the tick is short enough that
+// a click can't overtake a drag's pending value.
+// ─────────────────────────────────────────────────────────────────────────────
+
+void WizardUI::postParam(ParamCoalescer::Apply apply, int arg, float value)
+{
+    if (!_paramEdits.post(apply, arg, value)) {
+        flushParamEdits();
+        _paramEdits.post(apply, arg, value);
+    }
+}
+
+void WizardUI::flushParamEdits()
+{
+    if (_paramEdits.empty()) return;
+#ifdef ESP_PLATFORM
+    auto& engine = AudioEngine::getInstance();
+    engine.beginParamBatch();
+    _paramEdits.flush();
+    engine.endParamBatch();
+#else
+    _paramEdits.flush();
 #endif
 }
 
@@ -1639,23 +2864,40 @@ void WizardUI::syncUiToParams()
 
 void WizardUI::showPanel(int index)
 {
+    // A panel built now syncs to the engine's params, so they must include the last drag
+    flushParamEdits();
     _activePanel = index;
-
-    lv_obj_t* panels[] = {_panelFilter, _panelEq, _panelOutput, _panelVoice, _panelProfiles, _panelTinnitus};
-    for (int i = 0; i < NUM_PANELS; i++) {
-        if (panels[i]) {
-            if (i == index)
-                lv_obj_remove_flag(panels[i], LV_OBJ_FLAG_HIDDEN);
-            else
-                lv_obj_add_flag(panels[i], LV_OBJ_FLAG_HIDDEN);
-        }
+    ensurePanel(index);
+
+    for (int i = 0; i <= SYS_PANEL; i++) {
+        lv_obj_t* panel = *panelSlot(i);
+        if (!panel) continue;
+        if (i == index)
+            lv_obj_remove_flag(panel, LV_OBJ_FLAG_HIDDEN);
+        else
+            lv_obj_add_flag(panel, LV_OBJ_FLAG_HIDDEN);
     }
+    evictHiddenPanels();
 
     // Refresh profile list when entering profiles panel
     if (index == 4) {
         refreshProfileList();
     }
 
+#ifdef ESP_PLATFORM
+    // Only pay for the stage profiler while its panel is on screen
+    AudioEngine::getInstance().setProfilingEnabled(index == DIAG_PANEL);
+    AudioEngine::getInstance().setSpectrumEnabled(index == 1);
+    PowerProfiler::getInstance().setUiState(index);
+#endif
+    _diagRefreshCounter = 0;
+    if (index == SYS_PANEL) {
+        // Seed the run-time deltas so the first refresh shows a full interval
+        GetHAL()->updateSystemStats();
+        // Frame histograms cover the time the panel has been open
+        GetHAL()->resetDisplayStats();
+    }
+
     updateNavHighlight();
 }
 
@@ -1696,6 +2938,29 @@ void WizardUI::updateMuteButton()
     }
 }
 
+void WizardUI::updateUndoButtons()
+{
+    bool canUndo = false;
+    bool canRedo = false;
+#ifdef ESP_PLATFORM
+    auto& session = SessionStore::getInstance();
+    canUndo = session.canUndo();
+    canRedo = session.canRedo();
+#endif
+
+    // Only touch the state on a change, so the buttons aren't invalidated every update
+    const auto setEnabled = [](lv_obj_t* btn, bool enabled) {
+        if (!btn || enabled == !lv_obj_has_state(btn, LV_STATE_DISABLED)) return;
+        if (enabled) {
+            lv_obj_remove_state(btn, LV_STATE_DISABLED);
+        } else {
+            lv_obj_add_state(btn, LV_STATE_DISABLED);
+        }
+    };
+    setEnabled(_undoBtn, canUndo);
+    setEnabled(_redoBtn, canRedo);
+}
+
 // ─────────────────────────────────────────────────────────────────────────────
 // VU Meter update
 // ─────────────────────────────────────────────────────────────────────────────
@@ -1706,52 +2971,51 @@ void WizardUI::updateMeters()
     float peakL = 0.0f, peakR = 0.0f;
 
 #ifdef ESP_PLATFORM
-    AudioLevels levels = AudioEngine::getInstance().getLevels();
-    rmsL = levels.rmsLeft;
-    rmsR = levels.rmsRight;
-    peakL = levels.peakLeft;
-    peakR = levels.peakRight;
-#endif
-
-    // Convert RMS to dB-ish scale for display (log scale, 0dB = 1.0)
-    // Map to pixel width (max 696 pixels within the 700px background minus borders)
-    constexpr int METER_MAX_W = 696;
-    constexpr float DB_MIN = -60.0f;
-
-    auto levelToWidth = [](float level, float dbMin, int maxWidth) -> int {
-        if (level < 0.00001f) return 0;
-        float db = 20.0f * log10f(level);
-        if (db < dbMin) return 0;
-        float norm = (db - dbMin) / (0.0f - dbMin);  // 0..1
-        return (int)(norm * maxWidth);
-    };
-
-    auto levelToColor = [](float level) -> uint32_t {
-        float db = 20.0f * log10f(level + 0.00001f);
-        if (db > -3.0f) return 0xCC4444;      // Red
-        if (db > -10.0f) return 0xCCAA33;     // Yellow
-        return 0x44CC66;                        // Green
-    };
-
-    int wL = levelToWidth(rmsL, DB_MIN, METER_MAX_W);
-    int wR = levelToWidth(rmsR, DB_MIN, METER_MAX_W);
-    int pL = levelToWidth(peakL, DB_MIN, METER_MAX_W);
-    int pR = levelToWidth(peakR, DB_MIN, METER_MAX_W);
-
-    if (_meterBarL) {
-        lv_obj_set_width(_meterBarL, wL > 0 ? wL : 1);
-        lv_obj_set_style_bg_color(_meterBarL, lv_color_hex(levelToColor(rmsL)), LV_PART_MAIN);
-    }
-    if (_meterBarR) {
-        lv_obj_set_width(_meterBarR, wR > 0 ? wR : 1);
-        lv_obj_set_style_bg_color(_meterBarR, lv_color_hex(levelToColor(rmsR)), LV_PART_MAIN);
+    // Drain every block published since the last frame (~3 at 30 Hz) so the
+    // bars and history see all of them instead of one arbitrary sample.
+    static constexpr int HISTORY_BLOCKS_PER_POINT = 2;  // 100 points x 20ms = 2s
+    AudioLevels frames[32];
+    bool historyDirty = false;
+    size_t n;
+    while ((n = AudioEngine::getInstance().drainLevels(frames, 32)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            // Fast attack, ~150ms release per 10ms block
+            _smoothRmsL = std::max(frames[i].rmsLeft, _smoothRmsL * 0.93f);
+            _smoothRmsR = std::max(frames[i].rmsRight, _smoothRmsR * 0.93f);
+
+            _historyAccum = std::max(_historyAccum, std::max(frames[i].peakLeft, frames[i].peakRight));
+            if (++_historyPending >= HISTORY_BLOCKS_PER_POINT) {
+                _historyLevels[_historyHead] = _historyAccum;
+                _historyHead = (_historyHead + 1) % HISTORY_POINTS;
+                _historyAccum = 0.0f;
+                _historyPending = 0;
+                historyDirty = true;
+            }
+        }
+        peakL = frames[n - 1].peakLeft;
+        peakR = frames[n - 1].peakRight;
     }
-    if (_meterPeakL) {
-        lv_obj_set_x(_meterPeakL, pL > 2 ? pL : 2);
+    if (peakL == 0.0f && peakR == 0.0f) {
+        AudioLevels levels = AudioEngine::getInstance().getLevels();
+        peakL = levels.peakLeft;
+        peakR = levels.peakRight;
     }
-    if (_meterPeakR) {
-        lv_obj_set_x(_meterPeakR, pR > 2 ? pR : 2);
+    rmsL = _smoothRmsL;
+    rmsR = _smoothRmsR;
+
+    if (historyDirty && _historyLine) {
+        constexpr int plotH = HISTORY_H - 4;
+        for (int i = 0; i < HISTORY_POINTS; i++) {
+            float norm = LevelMeter::levelToNorm(_historyLevels[(_historyHead + i) % HISTORY_POINTS]);
+            _historyPts[i].y = (lv_value_precise_t)(plotH - norm * plotH);
+        }
+        lv_line_set_points(_historyLine, _historyPts, HISTORY_POINTS);
     }
+#endif
+
+    // Each meter only invalidates the columns that changed since its last draw
+    _meterL.set(rmsL, peakL);
+    _meterR.set(rmsR, peakR);
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -1760,46 +3024,19 @@ void WizardUI::updateMeters()
 
 void WizardUI::styleSliderWizard(lv_obj_t* slider)
 {
-    // Main track (background)
-    lv_obj_set_style_bg_color(slider, lv_color_hex(0x1A1540), LV_PART_MAIN);
-    lv_obj_set_style_bg_opa(slider, LV_OPA_COVER, LV_PART_MAIN);
-    lv_obj_set_style_radius(slider, 4, LV_PART_MAIN);
-    lv_obj_set_style_border_color(slider, lv_color_hex(DARK_BORDER), LV_PART_MAIN);
-    lv_obj_set_style_border_width(slider, 1, LV_PART_MAIN);
-
-    // Indicator (filled portion)
-    lv_obj_set_style_bg_color(slider, lv_color_hex(LAVENDER), LV_PART_INDICATOR);
-    lv_obj_set_style_bg_opa(slider, 180, LV_PART_INDICATOR);
-    lv_obj_set_style_radius(slider, 4, LV_PART_INDICATOR);
-
-    // Knob
-    lv_obj_set_style_bg_color(slider, lv_color_hex(GOLD_BRIGHT), LV_PART_KNOB);
-    lv_obj_set_style_bg_opa(slider, LV_OPA_COVER, LV_PART_KNOB);
-    lv_obj_set_style_radius(slider, LV_RADIUS_CIRCLE, LV_PART_KNOB);
-    lv_obj_set_style_pad_all(slider, 6, LV_PART_KNOB);
-    lv_obj_set_style_border_color(slider, lv_color_hex(GOLD), LV_PART_KNOB);
-    lv_obj_set_style_border_width(slider, 2, LV_PART_KNOB);
-    lv_obj_set_style_shadow_width(slider, 8, LV_PART_KNOB);
-    lv_obj_set_style_shadow_color(slider, lv_color_hex(GOLD_BRIGHT), LV_PART_KNOB);
-    lv_obj_set_style_shadow_opa(slider, 80, LV_PART_KNOB);
+    WizardTheme::applySlider(slider);
 }
 
 void WizardUI::styleToggleWizard(lv_obj_t* btn)
 {
-    lv_obj_set_style_bg_color(btn, lv_color_hex(BG_DARK), LV_PART_MAIN);
-    lv_obj_set_style_radius(btn, 8, LV_PART_MAIN);
-    lv_obj_set_style_border_color(btn, lv_color_hex(GOLD), LV_PART_MAIN);
-    lv_obj_set_style_border_width(btn, 1, LV_PART_MAIN);
-    lv_obj_set_style_shadow_width(btn, 0, LV_PART_MAIN);
+    WizardTheme::applyToggle(btn);
 }
 
 lv_obj_t* WizardUI::createSectionLabel(lv_obj_t* parent, const char* text, int x, int y)
 {
     lv_obj_t* label = lv_label_create(parent);
     lv_label_set_text(label, text);
-    lv_obj_set_style_text_font(label, &lv_font_montserrat_16, LV_PART_MAIN);
-    lv_obj_set_style_text_color(label, lv_color_hex(GOLD_BRIGHT), LV_PART_MAIN);
-    lv_obj_set_style_text_letter_space(label, 2, LV_PART_MAIN);
+    WizardTheme::applySectionLabel(label);
     lv_obj_set_pos(label, x, y);
     return label;
 }
@@ -1808,12 +3045,27 @@ lv_obj_t* WizardUI::createValueLabel(lv_obj_t* parent, const char* text, int x,
 {
     lv_obj_t* label = lv_label_create(parent);
     lv_label_set_text(label, text);
-    lv_obj_set_style_text_font(label, &lv_font_montserrat_16, LV_PART_MAIN);
-    lv_obj_set_style_text_color(label, lv_color_hex(GOLD), LV_PART_MAIN);
+    WizardTheme::applyValueLabel(label);
     lv_obj_set_pos(label, x, y);
     return label;
 }
 
+lv_obj_t* WizardUI::createEarButton(lv_obj_t* parent, int slot)
+{
+    lv_obj_t* btn = lv_btn_create(parent);
+    lv_obj_set_size(btn, 170, 36);
+    lv_obj_set_pos(btn, CONTENT_W - 200, 8);
+    styleToggleWizard(btn);
+    lv_obj_add_event_cb(btn, onEarSelect, LV_EVENT_CLICKED, this);
+
+    lv_obj_t* lbl = lv_label_create(btn);
+    lv_label_set_text(lbl, "EARS: L+R");
+    WizardTheme::applyCompactText(lbl);
+    lv_obj_center(lbl);
+    _earBtns[slot] = btn;
+    return btn;
+}
+
 lv_obj_t* WizardUI::createDiamondDivider(lv_obj_t* parent, int y, int width)
 {
     // Simplified divider - just a single horizontal line (no rotation = less memory)
@@ -1824,8 +3076,7 @@ lv_obj_t* WizardUI::createDiamondDivider(lv_obj_t* parent, int y, int width)
     lv_obj_remove_style_all(line);
     lv_obj_set_size(line, width, 1);
     lv_obj_set_pos(line, cx - halfW, y);
-    lv_obj_set_style_bg_color(line, lv_color_hex(DARK_BORDER), LV_PART_MAIN);
-    lv_obj_set_style_bg_opa(line, LV_OPA_COVER, LV_PART_MAIN);
+    WizardTheme::applyDivider(line);
 
     return line;
 }
@@ -1834,6 +3085,11 @@ lv_obj_t* WizardUI::createDiamondDivider(lv_obj_t* parent, int y, int width)
 // Event callbacks
 // ─────────────────────────────────────────────────────────────────────────────
 
+void WizardUI::onUpdateTimer(lv_timer_t* timer)
+{
+    static_cast<WizardUI*>(lv_timer_get_user_data(timer))->update();
+}
+
 void WizardUI::onNavBtnClicked(lv_event_t* e)
 {
     auto* ui = static_cast<WizardUI*>(lv_event_get_user_data(e));
@@ -1842,6 +3098,162 @@ void WizardUI::onNavBtnClicked(lv_event_t* e)
     ui->showPanel(panelIdx);
 }
 
+void WizardUI::onLatencyModeClicked(lv_event_t* e)
+{
+    auto* ui = static_cast<WizardUI*>(lv_event_get_user_data(e));
+    auto* btn = static_cast<lv_obj_t*>(lv_event_get_target(e));
+    int mode = (int)(intptr_t)lv_obj_get_user_data(btn);
+
+#ifdef ESP_PLATFORM
+    int blockSize = AudioEngine::BLOCK_SIZES[mode];
+    AudioEngine::getInstance().setBlockSize(blockSize);
+    ui->updateLatencyButtons(blockSize);
+#endif
+}
+
+void WizardUI::onLatencyMeasureClicked(lv_event_t* e)
+{
+#ifdef ESP_PLATFORM
+    AudioEngine::getInstance().requestLatencyMeasurement();
+#endif
+}
+
+void WizardUI::onVersionLongPressed(lv_event_t* e)
+{
+    auto* ui = static_cast<WizardUI*>(lv_event_get_user_data(e));
+    ui->showPanel(ui->_activePanel == DIAG_PANEL ? SYS_PANEL : DIAG_PANEL);
+}
+
+void WizardUI::onDiagDegradeToggle(lv_event_t* e)
+{
+#ifdef ESP_PLATFORM
+    auto& engine = AudioEngine::getInstance();
+    bool newEnabled = !engine.isAutoDegradeEnabled();
+    engine.setAutoDegradeEnabled(newEnabled);
+
+    auto* btn = static_cast<lv_obj_t*>(lv_event_get_target(e));
+    lv_obj_t* label = lv_obj_get_child(btn, 0);
+    if (label) {
+        lv_obj_set_style_text_color(label,
+            lv_color_hex(newEnabled ? GOLD_BRIGHT : LAVENDER), LV_PART_MAIN);
+    }
+    lv_obj_set_style_border_color(btn,
+        lv_color_hex(newEnabled ? CYAN_GLOW : GOLD), LV_PART_MAIN);
+#endif
+}
+
+void WizardUI::onDiagResetClicked(lv_event_t* e)
+{
+#ifdef ESP_PLATFORM
+    AudioEngine::getInstance().resetXrunStats();
+#endif
+}
+
+void WizardUI::onDiagBenchClicked(lv_event_t* e)
+{
+    auto* ui = static_cast<WizardUI*>(lv_event_get_user_data(e));
+    (void)ui;
+#ifdef ESP_PLATFORM
+    auto& engine = AudioEngine::getInstance();
+    if (ui->_diagBenchView) {
+        if (!engine.isBenchmarkRunning()) ui->setDiagBenchView(false);
+        return;
+    }
+    if (engine.startBenchmark()) ui->setDiagBenchView(true);
+#endif
+}
+
+void WizardUI::onDiagSdClicked(lv_event_t* e)
+{
+    auto* ui = static_cast<WizardUI*>(lv_event_get_user_data(e));
+    (void)ui;
+#ifdef ESP_PLATFORM
+    if (SdStorage::getInstance().startBenchmark()) lv_label_set_text(ui->_diagSdLabel, "Testing...");
+#endif
+}
+
+void WizardUI::onDiagUsbClicked(lv_event_t* e)
+{
+    auto* ui = static_cast<WizardUI*>(lv_event_get_user_data(e));
+    (void)ui;
+#ifdef ESP_PLATFORM
+    auto& msc = UsbMsc::getInstance();
+    if (msc.isActive()) {
+        msc.stop();  // Eject on the PC first
+    } else if (!msc.start()) {
+        lv_label_set_text(ui->_diagSdLabel, "SD card busy");
+        return;
+    }
+    lv_label_set_text(ui->_diagUsbBtnLabel, msc.isActive() ? "EJECT" : "USB DISK");
+#endif
+}
+
+void WizardUI::onDiagLatencyClicked(lv_event_t* e)
+{
+    auto* btn = static_cast<lv_obj_t*>(lv_event_get_target(e));
+    int source = (int)(intptr_t)lv_obj_get_user_data(btn);
+    (void)source;
+#ifdef ESP_PLATFORM
+    AudioEngine::getInstance().requestLatencyMeasurement(source);
+#endif
+}
+
+void WizardUI::onSysSoakClicked(lv_event_t* e)
+{
+    auto* ui = static_cast<WizardUI*>(lv_event_get_user_data(e));
+    if (heap_tracker::IsSoaking()) {
+        heap_tracker::StopSoak();
+    } else {
+        heap_tracker::StartSoak();
+    }
+    lv_label_set_text(ui->_sysSoakLabel, heap_tracker::IsSoaking() ? "STOP SOAK" : "HEAP SOAK");
+}
+
+void WizardUI::onSysPowerClicked(lv_event_t* e)
+{
+    auto* ui = static_cast<WizardUI*>(lv_event_get_user_data(e));
+    (void)ui;
+#ifdef ESP_PLATFORM
+    auto& profiler = PowerProfiler::getInstance();
+    if (profiler.isRunning()) {
+        profiler.stop();
+    } else {
+        profiler.start();
+    }
+    lv_label_set_text(ui->_sysPowerBtnLabel, profiler.isRunning() ? "STOP PWR" : "POWER");
+#endif
+}
+
+void WizardUI::onSysStressClicked(lv_event_t* e)
+{
+    auto* ui = static_cast<WizardUI*>(lv_event_get_user_data(e));
+    (void)ui;
+#ifdef ESP_PLATFORM
+    auto& stress = StressTest::getInstance();
+    if (stress.isRunning()) {
+        stress.stop();
+    } else {
+        stress.start();  // Needs the engine running
+    }
+    lv_label_set_text(ui->_sysStressBtnLabel, stress.isRunning() ? "STOP STRESS" : "STRESS");
+#endif
+}
+
+void WizardUI::onSysProfileClicked(lv_event_t* e)
+{
+    auto* ui = static_cast<WizardUI*>(lv_event_get_user_data(e));
+    (void)ui;
+#ifdef ESP_PLATFORM
+    auto& profiler = SamplingProfiler::getInstance();
+    if (profiler.isRunning()) {
+        profiler.stop();  // Still written
+    } else {
+        profiler.start();
+    }
+    lv_label_set_text(ui->_sysProfileBtnLabel, profiler.isRunning() ? "STOP PROF" : "PROFILE");
+#endif
+}
+
 void WizardUI::onMuteBtnClicked(lv_event_t* e)
 {
     auto* ui = static_cast<WizardUI*>(lv_event_get_user_data(e));
@@ -1854,14 +3266,58 @@ void WizardUI::onMuteBtnClicked(lv_event_t* e)
     ui->updateMuteButton();
 }
 
-void WizardUI::onHpfToggle(lv_event_t* e)
+void WizardUI::onUndoClicked(lv_event_t* e)
 {
     auto* ui = static_cast<WizardUI*>(lv_event_get_user_data(e));
+#ifdef ESP_PLATFORM
+    // Queued drag edits are part of the step being undone
+    ui->flushParamEdits();
+    if (SessionStore::getInstance().undo()) ui->syncUiToParams();
+#endif
+    ui->updateUndoButtons();
+}
+
+void WizardUI::onRedoClicked(lv_event_t* e)
+{
+    auto* ui = static_cast<WizardUI*>(lv_event_get_user_data(e));
+#ifdef ESP_PLATFORM
+    ui->flushParamEdits();
+    if (SessionStore::getInstance().redo()) ui->syncUiToParams();
+#endif
+    ui->updateUndoButtons();
+}
+
+// L+R → LEFT → RIGHT → L+R. Leaving L+R unlinks the ears with the right one a copy
+// of the left; coming back links them, and the right ear takes the left one's settings.
+void WizardUI::onEarSelect(lv_event_t* e)
+{
+    auto* ui = static_cast<WizardUI*>(lv_event_get_user_data(e));
+#ifdef ESP_PLATFORM
+    ui->flushParamEdits();
+    auto& engine = AudioEngine::getInstance();
+    if (ui->_editEar == AUDIO_EAR_BOTH) {
+        engine.setEarsLinked(false);
+        ui->_editEar = AUDIO_EAR_LEFT;
+    } else if (ui->_editEar == AUDIO_EAR_LEFT) {
+        ui->_editEar = AUDIO_EAR_RIGHT;
+    } else {
+        engine.setEarsLinked(true);
+        ui->_editEar = AUDIO_EAR_BOTH;
+    }
+    ui->syncUiToParams();
+#else
     (void)ui;
+#endif
+}
+
+void WizardUI::onHpfToggle(lv_event_t* e)
+{
+    auto* ui = static_cast<WizardUI*>(lv_event_get_user_data(e));
 #ifdef ESP_PLATFORM
     auto& engine = AudioEngine::getInstance();
-    auto params = engine.getParams();
-    engine.setHpf(!params.hpfEnabled, params.hpfFrequency);
+    const auto ear = static_cast<AudioEar>(ui->_editEar);
+    const EarParams params = engine.getParams().ear(ear);
+    engine.setHpf(!params.hpfEnabled, params.hpfFrequency, ear);
 
     // Update button label
     auto* btn = static_cast<lv_obj_t*>(lv_event_get_target(e));
@@ -1872,17 +3328,19 @@ void WizardUI::onHpfToggle(lv_event_t* e)
     // Update button style
     lv_obj_set_style_border_color(btn,
         lv_color_hex(!params.hpfEnabled ? CYAN_GLOW : GOLD), LV_PART_MAIN);
+#else
+    (void)ui;
 #endif
 }
 
 void WizardUI::onLpfToggle(lv_event_t* e)
 {
     auto* ui = static_cast<WizardUI*>(lv_event_get_user_data(e));
-    (void)ui;
 #ifdef ESP_PLATFORM
     auto& engine = AudioEngine::getInstance();
-    auto params = engine.getParams();
-    engine.setLpf(!params.lpfEnabled, params.lpfFrequency);
+    const auto ear = static_cast<AudioEar>(ui->_editEar);
+    const EarParams params = engine.getParams().ear(ear);
+    engine.setLpf(!params.lpfEnabled, params.lpfFrequency, ear);
 
     auto* btn = static_cast<lv_obj_t*>(lv_event_get_target(e));
     lv_obj_t* label = lv_obj_get_child(btn, 0);
@@ -1891,6 +3349,8 @@ void WizardUI::onLpfToggle(lv_event_t* e)
     }
     lv_obj_set_style_border_color(btn,
         lv_color_hex(!params.lpfEnabled ? CYAN_GLOW : GOLD), LV_PART_MAIN);
+#else
+    (void)ui;
 #endif
 }
 
@@ -1901,16 +3361,14 @@ void WizardUI::onHpfSliderChanged(lv_event_t* e)
     int val = lv_slider_get_value(slider);
 
 #ifdef ESP_PLATFORM
-    auto& engine = AudioEngine::getInstance();
-    auto params = engine.getParams();
-    engine.setHpf(params.hpfEnabled, (float)val);
+    ui->postParam([](int ear, float v) {
+        auto& engine = AudioEngine::getInstance();
+        const auto which = static_cast<AudioEar>(ear);
+        engine.setHpf(engine.getParams().ear(which).hpfEnabled, v, which);
+    }, ui->_editEar, (float)val);
 #endif
 
-    if (ui->_hpfValueLabel) {
-        char buf[16];
-        snprintf(buf, sizeof(buf), "%d Hz", val);
-        lv_label_set_text(ui->_hpfValueLabel, buf);
-    }
+    ValueLabel::setInt(ui->_hpfValueLabel, val, " Hz");
 }
 
 void WizardUI::onLpfSliderChanged(lv_event_t* e)
@@ -1920,16 +3378,14 @@ void WizardUI::onLpfSliderChanged(lv_event_t* e)
     int val = lv_slider_get_value(slider);
 
 #ifdef ESP_PLATFORM
-    auto& engine = AudioEngine::getInstance();
-    auto params = engine.getParams();
-    engine.setLpf(params.lpfEnabled, (float)val);
+    ui->postParam([](int ear, float v) {
+        auto& engine = AudioEngine::getInstance();
+        const auto which = static_cast<AudioEar>(ear);
+        engine.setLpf(engine.getParams().ear(which).lpfEnabled, v, which);
+    }, ui->_editEar, (float)val);
 #endif
 
-    if (ui->_lpfValueLabel) {
-        char buf[16];
-        snprintf(buf, sizeof(buf), "%d Hz", val);
-        lv_label_set_text(ui->_lpfValueLabel, buf);
-    }
+    ValueLabel::setInt(ui->_lpfValueLabel, val, " Hz");
 }
 
 void WizardUI::onEqSliderChanged(lv_event_t* e)
@@ -1940,28 +3396,25 @@ void WizardUI::onEqSliderChanged(lv_event_t* e)
     float db = (float)val / 10.0f;          // -12.0 to 12.0
 
 #ifdef ESP_PLATFORM
-    auto& engine = AudioEngine::getInstance();
     if (slider == ui->_eqLowSlider) {
-        engine.setEqLow(db);
+        ui->postParam([](int ear, float v) { AudioEngine::getInstance().setEqLow(v, static_cast<AudioEar>(ear)); },
+                      ui->_editEar, db);
     } else if (slider == ui->_eqMidSlider) {
-        engine.setEqMid(db);
+        ui->postParam([](int ear, float v) { AudioEngine::getInstance().setEqMid(v, static_cast<AudioEar>(ear)); },
+                      ui->_editEar, db);
     } else if (slider == ui->_eqHighSlider) {
-        engine.setEqHigh(db);
+        ui->postParam([](int ear, float v) { AudioEngine::getInstance().setEqHigh(v, static_cast<AudioEar>(ear)); },
+                      ui->_editEar, db);
     }
 #endif
 
     // Update the corresponding value label
-    char buf[16];
-    snprintf(buf, sizeof(buf), "%+.1f dB", (double)db);
-
     lv_obj_t* label = nullptr;
     if (slider == ui->_eqLowSlider) label = ui->_eqLowLabel;
     else if (slider == ui->_eqMidSlider) label = ui->_eqMidLabel;
     else if (slider == ui->_eqHighSlider) label = ui->_eqHighLabel;
 
-    if (label) {
-        lv_label_set_text(label, buf);
-    }
+    ValueLabel::setFixed(label, db, 1, " dB", true);
 }
 
 void WizardUI::onVolumeSliderChanged(lv_event_t* e)
@@ -1971,14 +3424,10 @@ void WizardUI::onVolumeSliderChanged(lv_event_t* e)
     int val = lv_slider_get_value(slider);
 
 #ifdef ESP_PLATFORM
-    AudioEngine::getInstance().setOutputVolume(val);
+    ui->postParam([](int, float v) { AudioEngine::getInstance().setOutputVolume((int)v); }, 0, val);
 #endif
 
-    if (ui->_volumeValueLabel) {
-        char buf[8];
-        snprintf(buf, sizeof(buf), "%d", val);
-        lv_label_set_text(ui->_volumeValueLabel, buf);
-    }
+    ValueLabel::setInt(ui->_volumeValueLabel, val);
 }
 
 void WizardUI::onGainSliderChanged(lv_event_t* e)
@@ -1989,7 +3438,8 @@ void WizardUI::onGainSliderChanged(lv_event_t* e)
     float gain = (float)val / 100.0f;       // 0.00-6.00
 
 #ifdef ESP_PLATFORM
-    AudioEngine::getInstance().setOutputGain(gain);
+    ui->postParam([](int ear, float v) { AudioEngine::getInstance().setOutputGain(v, static_cast<AudioEar>(ear)); },
+                  ui->_editEar, gain);
 #endif
 
     if (ui->_gainValueLabel) {
@@ -2000,7 +3450,7 @@ void WizardUI::onGainSliderChanged(lv_event_t* e)
         } else {
             snprintf(buf, sizeof(buf), "%.2fx", (double)gain);
         }
-        lv_label_set_text(ui->_gainValueLabel, buf);
+        ValueLabel::setText(ui->_gainValueLabel, buf);
     }
 }
 
@@ -2011,14 +3461,10 @@ void WizardUI::onMicGainSliderChanged(lv_event_t* e)
     int val = lv_slider_get_value(slider);
 
 #ifdef ESP_PLATFORM
-    AudioEngine::getInstance().setMicGain((float)val);
+    ui->postParam([](int, float v) { AudioEngine::getInstance().setMicGain(v); }, 0, (float)val);
 #endif
 
-    if (ui->_micGainValueLabel) {
-        char buf[8];
-        snprintf(buf, sizeof(buf), "%d", val);
-        lv_label_set_text(ui->_micGainValueLabel, buf);
-    }
+    ValueLabel::setInt(ui->_micGainValueLabel, val);
 }
 
 void WizardUI::onNsToggle(lv_event_t* e)
@@ -2041,6 +3487,25 @@ void WizardUI::onNsToggle(lv_event_t* e)
 #endif
 }
 
+void WizardUI::onNsLinkToggle(lv_event_t* e)
+{
+    auto* ui = static_cast<WizardUI*>(lv_event_get_user_data(e));
+    (void)ui;
+#ifdef ESP_PLATFORM
+    auto& engine = AudioEngine::getInstance();
+    bool newLinked = !engine.getParams().nsLinked;
+    engine.setNsLinked(newLinked);
+
+    auto* btn = static_cast<lv_obj_t*>(lv_event_get_target(e));
+    lv_obj_t* label = lv_obj_get_child(btn, 0);
+    if (label) {
+        lv_label_set_text(label, newLinked ? "LINKED" : "PER EAR");
+    }
+    lv_obj_set_style_border_color(btn,
+        lv_color_hex(newLinked ? CYAN_GLOW : GOLD), LV_PART_MAIN);
+#endif
+}
+
 void WizardUI::onNsModeClicked(lv_event_t* e)
 {
     auto* ui = static_cast<WizardUI*>(lv_event_get_user_data(e));
@@ -2128,14 +3593,10 @@ void WizardUI::onAgcGainChanged(lv_event_t* e)
     int val = lv_slider_get_value(slider);  // 0-90
 
 #ifdef ESP_PLATFORM
-    AudioEngine::getInstance().setAgcCompressionGain(val);
+    ui->postParam([](int, float v) { AudioEngine::getInstance().setAgcCompressionGain((int)v); }, 0, val);
 #endif
 
-    if (ui->_agcGainValueLabel) {
-        char buf[12];
-        snprintf(buf, sizeof(buf), "%d dB", val);
-        lv_label_set_text(ui->_agcGainValueLabel, buf);
-    }
+    ValueLabel::setInt(ui->_agcGainValueLabel, val, " dB");
 }
 
 void WizardUI::onAgcTargetChanged(lv_event_t* e)
@@ -2145,14 +3606,10 @@ void WizardUI::onAgcTargetChanged(lv_event_t* e)
     int val = lv_slider_get_value(slider);  // -31 to 0
 
 #ifdef ESP_PLATFORM
-    AudioEngine::getInstance().setAgcTargetLevel(val);
+    ui->postParam([](int, float v) { AudioEngine::getInstance().setAgcTargetLevel((int)v); }, 0, val);
 #endif
 
-    if (ui->_agcTargetValueLabel) {
-        char buf[12];
-        snprintf(buf, sizeof(buf), "%d dBFS", val);
-        lv_label_set_text(ui->_agcTargetValueLabel, buf);
-    }
+    ValueLabel::setInt(ui->_agcTargetValueLabel, val, " dBFS");
 }
 
 void WizardUI::onAgcLimiterToggle(lv_event_t* e)
@@ -2177,6 +3634,25 @@ void WizardUI::onAgcLimiterToggle(lv_event_t* e)
 #endif
 }
 
+void WizardUI::onAgcLinkToggle(lv_event_t* e)
+{
+    auto* ui = static_cast<WizardUI*>(lv_event_get_user_data(e));
+    (void)ui;
+#ifdef ESP_PLATFORM
+    auto& engine = AudioEngine::getInstance();
+    bool newLinked = !engine.getParams().agcLinked;
+    engine.setAgcLinked(newLinked);
+
+    auto* btn = static_cast<lv_obj_t*>(lv_event_get_target(e));
+    lv_obj_t* label = lv_obj_get_child(btn, 0);
+    if (label) {
+        lv_label_set_text(label, newLinked ? "LINKED" : "PER EAR");
+    }
+    lv_obj_set_style_border_color(btn,
+        lv_color_hex(newLinked ? CYAN_GLOW : GOLD), LV_PART_MAIN);
+#endif
+}
+
 // ─────────────────────────────────────────────────────────────────────────────
 // Voice Exclusion callbacks
 // ─────────────────────────────────────────────────────────────────────────────
@@ -2209,14 +3685,10 @@ void WizardUI::onVeBlendChanged(lv_event_t* e)
     float blend = (float)val / 100.0f;      // 0.0-1.0
 
 #ifdef ESP_PLATFORM
-    AudioEngine::getInstance().setVeBlend(blend);
+    ui->postParam([](int, float v) { AudioEngine::getInstance().setVeBlend(v); }, 0, blend);
 #endif
 
-    if (ui->_veBlendValueLabel) {
-        char buf[8];
-        snprintf(buf, sizeof(buf), "%d%%", val);
-        lv_label_set_text(ui->_veBlendValueLabel, buf);
-    }
+    ValueLabel::setInt(ui->_veBlendValueLabel, val, "%");
 }
 
 void WizardUI::onVeStepChanged(lv_event_t* e)
@@ -2227,14 +3699,10 @@ void WizardUI::onVeStepChanged(lv_event_t* e)
     float step = (float)val / 100.0f;        // 0.01-1.0
 
 #ifdef ESP_PLATFORM
-    AudioEngine::getInstance().setVeStepSize(step);
+    ui->postParam([](int, float v) { AudioEngine::getInstance().setVeStepSize(v); }, 0, step);
 #endif
 
-    if (ui->_veStepValueLabel) {
-        char buf[8];
-        snprintf(buf, sizeof(buf), "%.2f", (double)step);
-        lv_label_set_text(ui->_veStepValueLabel, buf);
-    }
+    ValueLabel::setFixed(ui->_veStepValueLabel, step, 2);
 }
 
 void WizardUI::onVeFilterLenClicked(lv_event_t* e)
@@ -2274,14 +3742,10 @@ void WizardUI::onVeAttenChanged(lv_event_t* e)
     float atten = (float)val / 100.0f;       // 0.0-1.0
 
 #ifdef ESP_PLATFORM
-    AudioEngine::getInstance().setVeMaxAttenuation(atten);
+    ui->postParam([](int, float v) { AudioEngine::getInstance().setVeMaxAttenuation(v); }, 0, atten);
 #endif
 
-    if (ui->_veAttenValueLabel) {
-        char buf[8];
-        snprintf(buf, sizeof(buf), "%d%%", val);
-        lv_label_set_text(ui->_veAttenValueLabel, buf);
-    }
+    ValueLabel::setInt(ui->_veAttenValueLabel, val, "%");
 }
 
 void WizardUI::onVeRefGainChanged(lv_event_t* e)
@@ -2292,14 +3756,10 @@ void WizardUI::onVeRefGainChanged(lv_event_t* e)
     float gain = (float)val / 10.0f;         // 0.1-5.0
 
 #ifdef ESP_PLATFORM
-    AudioEngine::getInstance().setVeRefGain(gain);
+    ui->postParam([](int, float v) { AudioEngine::getInstance().setVeRefGain(v); }, 0, gain);
 #endif
 
-    if (ui->_veRefGainValueLabel) {
-        char buf[8];
-        snprintf(buf, sizeof(buf), "%.1fx", (double)gain);
-        lv_label_set_text(ui->_veRefGainValueLabel, buf);
-    }
+    ValueLabel::setFixed(ui->_veRefGainValueLabel, gain, 1, "x");
 }
 
 void WizardUI::onVeRefHpfChanged(lv_event_t* e)
@@ -2309,14 +3769,10 @@ void WizardUI::onVeRefHpfChanged(lv_event_t* e)
     int val = lv_slider_get_value(slider);   // 20-500
 
 #ifdef ESP_PLATFORM
-    AudioEngine::getInstance().setVeRefHpf((float)val);
+    ui->postParam([](int, float v) { AudioEngine::getInstance().setVeRefHpf(v); }, 0, (float)val);
 #endif
 
-    if (ui->_veRefHpfValueLabel) {
-        char buf[16];
-        snprintf(buf, sizeof(buf), "%d Hz", val);
-        lv_label_set_text(ui->_veRefHpfValueLabel, buf);
-    }
+    ValueLabel::setInt(ui->_veRefHpfValueLabel, val, " Hz");
 }
 
 void WizardUI::onVeRefLpfChanged(lv_event_t* e)
@@ -2326,14 +3782,10 @@ void WizardUI::onVeRefLpfChanged(lv_event_t* e)
     int val = lv_slider_get_value(slider);   // 1000-8000
 
 #ifdef ESP_PLATFORM
-    AudioEngine::getInstance().setVeRefLpf((float)val);
+    ui->postParam([](int, float v) { AudioEngine::getInstance().setVeRefLpf(v); }, 0, (float)val);
 #endif
 
-    if (ui->_veRefLpfValueLabel) {
-        char buf[16];
-        snprintf(buf, sizeof(buf), "%d Hz", val);
-        lv_label_set_text(ui->_veRefLpfValueLabel, buf);
-    }
+    ValueLabel::setInt(ui->_veRefLpfValueLabel, val, " Hz");
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -2416,7 +3868,7 @@ void WizardUI::onVeVadGateAttenChanged(lv_event_t* e)
     float atten = (float)val / 100.0f;       // 0.0-0.5
 
 #ifdef ESP_PLATFORM
-    AudioEngine::getInstance().setVeVadGateAtten(atten);
+    ui->postParam([](int, float v) { AudioEngine::getInstance().setVeVadGateAtten(v); }, 0, atten);
 #endif
 
     if (ui->_veVadGateAttenValueLabel) {
@@ -2424,7 +3876,7 @@ void WizardUI::onVeVadGateAttenChanged(lv_event_t* e)
         // Show approximate dB value
         float db = (val > 0) ? 20.0f * log10f(atten) : -40.0f;
         snprintf(buf, sizeof(buf), "%d%% (%.0fdB)", val, (double)db);
-        lv_label_set_text(ui->_veVadGateAttenValueLabel, buf);
+        ValueLabel::setText(ui->_veVadGateAttenValueLabel, buf);
     }
 }
 
@@ -2440,13 +3892,8 @@ void WizardUI::onProfileSave(lv_event_t* e)
 
 void WizardUI::onProfileLoad(lv_event_t* e)
 {
-    // Now used as REFRESH button - just check SD card status
+    // Now used as REFRESH button - re-list the card in the background
     auto* ui = static_cast<WizardUI*>(lv_event_get_user_data(e));
-    if (ui->_profileStatusLabel) {
-        lv_label_set_text(ui->_profileStatusLabel, "Checking SD card...");
-        lv_obj_set_style_text_color(ui->_profileStatusLabel,
-            lv_color_hex(GOLD), LV_PART_MAIN);
-    }
     ui->refreshProfileList();
 }
 
@@ -2462,21 +3909,54 @@ void WizardUI::onProfileSetDefault(lv_event_t* e)
     (void)e;
 }
 
+void WizardUI::onPresetClicked(lv_event_t* e)
+{
+    auto* ui = static_cast<WizardUI*>(lv_event_get_user_data(e));
+    auto* btn = static_cast<lv_obj_t*>(lv_event_get_target(e));
+    size_t idx = (size_t)(intptr_t)lv_obj_get_user_data(btn);
+    (void)ui;
+    (void)idx;
+
+#ifdef ESP_PLATFORM
+    const std::vector<std::string> presets = ProfileManager::listBuiltinPresets();
+    AudioEngineParams params;
+    if (idx >= presets.size() || !ProfileManager::loadBuiltinPreset(presets[idx], params)) return;
+
+    // Drag edits still queued would land on top of the preset
+    ui->flushParamEdits();
+    auto& engine = AudioEngine::getInstance();
+    const AudioEngineParams current = engine.getParams();
+    params.outputVolume = current.outputVolume;
+    params.outputMute = current.outputMute;
+    auto& cost = AudioCostModel::getInstance();
+    if (cost.estimate(params).overBudget) cost.fitToBudget(params);
+    engine.setParams(params);
+    ui->syncUiToParams();
+
+    if (ui->_profileStatusLabel) {
+        char buf[96];
+        snprintf(buf, sizeof(buf), "Preset loaded: %s", presets[idx].c_str());
+        lv_label_set_text(ui->_profileStatusLabel, buf);
+        lv_obj_set_style_text_color(ui->_profileStatusLabel, lv_color_hex(METER_GREEN), LV_PART_MAIN);
+    }
+#endif
+}
+
 // ─────────────────────────────────────────────────────────────────────────────
 // Tinnitus Relief Callbacks
 // ─────────────────────────────────────────────────────────────────────────────
 
 void WizardUI::onNotchToggle(lv_event_t* e)
 {
-    (void)lv_event_get_user_data(e);  // ui not used in callback
+    auto* ui = static_cast<WizardUI*>(lv_event_get_user_data(e));
     auto* btn = static_cast<lv_obj_t*>(lv_event_get_target(e));
     int idx = (int)(intptr_t)lv_obj_get_user_data(btn);
 
 #ifdef ESP_PLATFORM
     auto& engine = AudioEngine::getInstance();
-    auto params = engine.getParams();
-    bool newEnabled = !params.tinnitus.notches[idx].enabled;
-    engine.setNotchEnabled(idx, newEnabled);
+    const auto ear = static_cast<AudioEar>(ui->_editEar);
+    bool newEnabled = !engine.getParams().ear(ear).notches[idx].enabled;
+    engine.setNotchEnabled(idx, newEnabled, ear);
 
     lv_obj_t* label = lv_obj_get_child(btn, 0);
     if (label) {
@@ -2487,6 +3967,7 @@ void WizardUI::onNotchToggle(lv_event_t* e)
     lv_obj_set_style_border_color(btn,
         lv_color_hex(newEnabled ? CYAN_GLOW : GOLD), LV_PART_MAIN);
 #else
+    (void)ui;
     (void)idx;
 #endif
 }
@@ -2499,14 +3980,13 @@ void WizardUI::onNotchFreqChanged(lv_event_t* e)
     int val = lv_slider_get_value(slider);
 
 #ifdef ESP_PLATFORM
-    AudioEngine::getInstance().setNotchFrequency(idx, (float)val);
+    // The coalescer arg carries the slot and the ear (slot + 8 * ear)
+    ui->postParam([](int arg, float v) {
+        AudioEngine::getInstance().setNotchFrequency(arg % 8, v, static_cast<AudioEar>(arg / 8));
+    }, idx + 8 * ui->_editEar, (float)val);
 #endif
 
-    if (idx < 2 && ui->_notchFreqLabel[idx]) {
-        char buf[16];
-        snprintf(buf, sizeof(buf), "%d Hz", val);
-        lv_label_set_text(ui->_notchFreqLabel[idx], buf);
-    }
+    if (idx < 2) ValueLabel::setInt(ui->_notchFreqLabel[idx], val, " Hz");
 }
 
 void WizardUI::onNotchQChanged(lv_event_t* e)
@@ -2518,14 +3998,12 @@ void WizardUI::onNotchQChanged(lv_event_t* e)
     float Q = (float)val / 10.0f;           // 1.0-16.0
 
 #ifdef ESP_PLATFORM
-    AudioEngine::getInstance().setNotchQ(idx, Q);
+    ui->postParam([](int arg, float v) {
+        AudioEngine::getInstance().setNotchQ(arg % 8, v, static_cast<AudioEar>(arg / 8));
+    }, idx + 8 * ui->_editEar, Q);
 #endif
 
-    if (idx < 2 && ui->_notchQLabel[idx]) {
-        char buf[8];
-        snprintf(buf, sizeof(buf), "%.1f", (double)Q);
-        lv_label_set_text(ui->_notchQLabel[idx], buf);
-    }
+    if (idx < 2) ValueLabel::setFixed(ui->_notchQLabel[idx], Q, 1);
 }
 
 void WizardUI::onNoiseTypeClicked(lv_event_t* e)
@@ -2562,14 +4040,10 @@ void WizardUI::onNoiseLevelChanged(lv_event_t* e)
     float level = (float)val / 100.0f;
 
 #ifdef ESP_PLATFORM
-    AudioEngine::getInstance().setNoiseLevel(level);
+    ui->postParam([](int, float v) { AudioEngine::getInstance().setNoiseLevel(v); }, 0, level);
 #endif
 
-    if (ui->_noiseLevelLabel) {
-        char buf[8];
-        snprintf(buf, sizeof(buf), "%d%%", val);
-        lv_label_set_text(ui->_noiseLevelLabel, buf);
-    }
+    ValueLabel::setInt(ui->_noiseLevelLabel, val, "%");
 }
 
 void WizardUI::onNoiseLowCutChanged(lv_event_t* e)
@@ -2579,14 +4053,10 @@ void WizardUI::onNoiseLowCutChanged(lv_event_t* e)
     int val = lv_slider_get_value(slider);
 
 #ifdef ESP_PLATFORM
-    AudioEngine::getInstance().setNoiseLowCut((float)val);
+    ui->postParam([](int, float v) { AudioEngine::getInstance().setNoiseLowCut(v); }, 0, (float)val);
 #endif
 
-    if (ui->_noiseLowCutLabel) {
-        char buf[16];
-        snprintf(buf, sizeof(buf), "%d Hz", val);
-        lv_label_set_text(ui->_noiseLowCutLabel, buf);
-    }
+    ValueLabel::setInt(ui->_noiseLowCutLabel, val, " Hz");
 }
 
 void WizardUI::onNoiseHighCutChanged(lv_event_t* e)
@@ -2596,14 +4066,10 @@ void WizardUI::onNoiseHighCutChanged(lv_event_t* e)
     int val = lv_slider_get_value(slider);
 
 #ifdef ESP_PLATFORM
-    AudioEngine::getInstance().setNoiseHighCut((float)val);
+    ui->postParam([](int, float v) { AudioEngine::getInstance().setNoiseHighCut(v); }, 0, (float)val);
 #endif
 
-    if (ui->_noiseHighCutLabel) {
-        char buf[16];
-        snprintf(buf, sizeof(buf), "%d Hz", val);
-        lv_label_set_text(ui->_noiseHighCutLabel, buf);
-    }
+    ValueLabel::setInt(ui->_noiseHighCutLabel, val, " Hz");
 }
 
 void WizardUI::onToneFinderToggle(lv_event_t* e)
@@ -2635,14 +4101,10 @@ void WizardUI::onToneFinderFreqChanged(lv_event_t* e)
     int val = lv_slider_get_value(slider);
 
 #ifdef ESP_PLATFORM
-    AudioEngine::getInstance().setToneFinderFreq((float)val);
+    ui->postParam([](int, float v) { AudioEngine::getInstance().setToneFinderFreq(v); }, 0, (float)val);
 #endif
 
-    if (ui->_toneFinderFreqLabel) {
-        char buf[16];
-        snprintf(buf, sizeof(buf), "%d Hz", val);
-        lv_label_set_text(ui->_toneFinderFreqLabel, buf);
-    }
+    ValueLabel::setInt(ui->_toneFinderFreqLabel, val, " Hz");
 }
 
 void WizardUI::onToneFinderLevelChanged(lv_event_t* e)
@@ -2653,14 +4115,10 @@ void WizardUI::onToneFinderLevelChanged(lv_event_t* e)
     float level = (float)val / 100.0f;
 
 #ifdef ESP_PLATFORM
-    AudioEngine::getInstance().setToneFinderLevel(level);
+    ui->postParam([](int, float v) { AudioEngine::getInstance().setToneFinderLevel(v); }, 0, level);
 #endif
 
-    if (ui->_toneFinderLevelLabel) {
-        char buf[8];
-        snprintf(buf, sizeof(buf), "%d%%", val);
-        lv_label_set_text(ui->_toneFinderLevelLabel, buf);
-    }
+    ValueLabel::setInt(ui->_toneFinderLevelLabel, val, "%");
 }
 
 void WizardUI::onToneFinderTransfer(lv_event_t* e)
@@ -2671,19 +4129,16 @@ void WizardUI::onToneFinderTransfer(lv_event_t* e)
     auto params = engine.getParams();
     float freq = params.tinnitus.toneFinderFreq;
 
-    // Copy tone finder frequency to notch 0 and enable it
-    engine.setNotchFrequency(0, freq);
-    engine.setNotchEnabled(0, true);
+    // Copy tone finder frequency to notch 0 of the ear being edited and enable it
+    const auto ear = static_cast<AudioEar>(ui->_editEar);
+    engine.setNotchFrequency(0, freq, ear);
+    engine.setNotchEnabled(0, true, ear);
 
     // Update UI
     if (ui->_notchFreqSlider[0]) {
         lv_slider_set_value(ui->_notchFreqSlider[0], (int)freq, LV_ANIM_OFF);
     }
-    if (ui->_notchFreqLabel[0]) {
-        char buf[16];
-        snprintf(buf, sizeof(buf), "%d Hz", (int)freq);
-        lv_label_set_text(ui->_notchFreqLabel[0], buf);
-    }
+    ValueLabel::setInt(ui->_notchFreqLabel[0], (int)freq, " Hz");
     if (ui->_notchToggle[0]) {
         lv_obj_set_style_border_color(ui->_notchToggle[0], lv_color_hex(CYAN_GLOW), LV_PART_MAIN);
         lv_obj_t* label = lv_obj_get_child(ui->_notchToggle[0], 0);
@@ -2726,14 +4181,10 @@ void WizardUI::onHfExtFreqChanged(lv_event_t* e)
     int val = lv_slider_get_value(slider);
 
 #ifdef ESP_PLATFORM
-    AudioEngine::getInstance().setHfExtFreq((float)val);
+    ui->postParam([](int, float v) { AudioEngine::getInstance().setHfExtFreq(v); }, 0, (float)val);
 #endif
 
-    if (ui->_hfExtFreqLabel) {
-        char buf[16];
-        snprintf(buf, sizeof(buf), "%dk", val / 1000);
-        lv_label_set_text(ui->_hfExtFreqLabel, buf);
-    }
+    ValueLabel::setInt(ui->_hfExtFreqLabel, val / 1000, "k");
 }
 
 void WizardUI::onHfExtGainChanged(lv_event_t* e)
@@ -2744,14 +4195,10 @@ void WizardUI::onHfExtGainChanged(lv_event_t* e)
     float gainDb = (float)val / 10.0f;      // 0-12 dB
 
 #ifdef ESP_PLATFORM
-    AudioEngine::getInstance().setHfExtGainDb(gainDb);
+    ui->postParam([](int, float v) { AudioEngine::getInstance().setHfExtGainDb(v); }, 0, gainDb);
 #endif
 
-    if (ui->_hfExtGainLabel) {
-        char buf[8];
-        snprintf(buf, sizeof(buf), "%.0fdB", (double)gainDb);
-        lv_label_set_text(ui->_hfExtGainLabel, buf);
-    }
+    ValueLabel::setFixed(ui->_hfExtGainLabel, gainDb, 0, "dB");
 }
 
 void WizardUI::onBinauralToggle(lv_event_t* e)
@@ -2783,14 +4230,10 @@ void WizardUI::onBinauralCarrierChanged(lv_event_t* e)
     int val = lv_slider_get_value(slider);
 
 #ifdef ESP_PLATFORM
-    AudioEngine::getInstance().setBinauralCarrier((float)val);
+    ui->postParam([](int, float v) { AudioEngine::getInstance().setBinauralCarrier(v); }, 0, (float)val);
 #endif
 
-    if (ui->_binauralCarrierLabel) {
-        char buf[16];
-        snprintf(buf, sizeof(buf), "%d Hz", val);
-        lv_label_set_text(ui->_binauralCarrierLabel, buf);
-    }
+    ValueLabel::setInt(ui->_binauralCarrierLabel, val, " Hz");
 }
 
 void WizardUI::onBinauralBeatChanged(lv_event_t* e)
@@ -2800,14 +4243,10 @@ void WizardUI::onBinauralBeatChanged(lv_event_t* e)
     int val = lv_slider_get_value(slider);  // 1-40 Hz
 
 #ifdef ESP_PLATFORM
-    AudioEngine::getInstance().setBinauralBeat((float)val);
+    ui->postParam([](int, float v) { AudioEngine::getInstance().setBinauralBeat(v); }, 0, (float)val);
 #endif
 
-    if (ui->_binauralBeatLabel) {
-        char buf[8];
-        snprintf(buf, sizeof(buf), "%dHz", val);
-        lv_label_set_text(ui->_binauralBeatLabel, buf);
-    }
+    ValueLabel::setInt(ui->_binauralBeatLabel, val, "Hz");
 }
 
 void WizardUI::onBinauralLevelChanged(lv_event_t* e)
@@ -2818,14 +4257,10 @@ void WizardUI::onBinauralLevelChanged(lv_event_t* e)
     float level = (float)val / 100.0f;
 
 #ifdef ESP_PLATFORM
-    AudioEngine::getInstance().setBinauralLevel(level);
+    ui->postParam([](int, float v) { AudioEngine::getInstance().setBinauralLevel(v); }, 0, level);
 #endif
 
-    if (ui->_binauralLevelLabel) {
-        char buf[8];
-        snprintf(buf, sizeof(buf), "%d%%", val);
-        lv_label_set_text(ui->_binauralLevelLabel, buf);
-    }
+    ValueLabel::setInt(ui->_binauralLevelLabel, val, "%");
 }
 
 void WizardUI::onBinauralPresetClicked(lv_event_t* e)
@@ -2847,11 +4282,7 @@ void WizardUI::onBinauralPresetClicked(lv_event_t* e)
     if (ui->_binauralBeatSlider) {
         lv_slider_set_value(ui->_binauralBeatSlider, (int)beatFreqs[preset], LV_ANIM_OFF);
     }
-    if (ui->_binauralBeatLabel) {
-        char buf[8];
-        snprintf(buf, sizeof(buf), "%.0fHz", (double)beatFreqs[preset]);
-        lv_label_set_text(ui->_binauralBeatLabel, buf);
-    }
+    ValueLabel::setFixed(ui->_binauralBeatLabel, beatFreqs[preset], 0, "Hz");
 
     // Update button highlights
     for (int i = 0; i < 4; i++) {
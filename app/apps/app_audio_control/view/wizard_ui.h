@@ -4,9 +4,18 @@
  * SPDX-License-Identifier: MIT
  */
 #pragma once
+#include "level_meter.h"
+#include "param_coalescer.h"
+#include "spectrum_view.h"
+#include "wizard_theme.h"
 #include <lvgl.h>
+#include <cstddef>
 #include <cstdint>
 
+class ProfileStore;
+struct AudioEngineParams;
+struct AudioParamGenerations;
+
 /**
  * @brief Wizard-themed audio control UI
  *
@@ -30,22 +39,22 @@
 class WizardUI {
 public:
     void create(lv_obj_t* parent);
-    void update();       // Called periodically for meter animation
+    void update();       // Meter animation, driven by the UI's own LVGL timer
     void destroy();
 
 private:
-    // Color palette
-    static constexpr uint32_t BG_DARK      = 0x0A0A1A;
-    static constexpr uint32_t BG_PANEL     = 0x12102A;
-    static constexpr uint32_t GOLD         = 0xE8D5B5;
-    static constexpr uint32_t GOLD_BRIGHT  = 0xFFD700;
-    static constexpr uint32_t LAVENDER     = 0x8B7EC8;
-    static constexpr uint32_t CYAN_GLOW    = 0x4488FF;
-    static constexpr uint32_t DARK_BORDER  = 0x2A2050;
-    static constexpr uint32_t METER_GREEN  = 0x44CC66;
-    static constexpr uint32_t METER_YELLOW = 0xCCAA33;
-    static constexpr uint32_t METER_RED    = 0xCC4444;
-    static constexpr uint32_t MUTED_TEXT   = 0x4A4A6A;
+    // Color palette (see WizardTheme)
+    static constexpr uint32_t BG_DARK      = WizardTheme::BG_DARK;
+    static constexpr uint32_t BG_PANEL     = WizardTheme::BG_PANEL;
+    static constexpr uint32_t GOLD         = WizardTheme::GOLD;
+    static constexpr uint32_t GOLD_BRIGHT  = WizardTheme::GOLD_BRIGHT;
+    static constexpr uint32_t LAVENDER     = WizardTheme::LAVENDER;
+    static constexpr uint32_t CYAN_GLOW    = WizardTheme::CYAN_GLOW;
+    static constexpr uint32_t DARK_BORDER  = WizardTheme::DARK_BORDER;
+    static constexpr uint32_t METER_GREEN  = WizardTheme::METER_GREEN;
+    static constexpr uint32_t METER_YELLOW = WizardTheme::METER_YELLOW;
+    static constexpr uint32_t METER_RED    = WizardTheme::METER_RED;
+    static constexpr uint32_t MUTED_TEXT   = WizardTheme::MUTED_TEXT;
 
     // Layout constants
     static constexpr int SCREEN_W    = 1280;
@@ -59,15 +68,32 @@ private:
     static constexpr int CONTENT_H   = SCREEN_H - HEADER_H - FOOTER_H;
 
     static constexpr int NUM_PANELS  = 6;
+    static constexpr int DIAG_PANEL  = NUM_PANELS;  // Hidden, opened by long-pressing the version label
+    static constexpr int SYS_PANEL   = NUM_PANELS + 1;  // Hidden, long-press the version label again on DIAG
+    static constexpr uint32_t UPDATE_PERIOD_MS = 33;  // 30 Hz meter refresh
+    static constexpr int DIAG_REFRESH_UPDATES = 15;   // ~0.5s at the 30 Hz update rate
+    static constexpr int SYS_REFRESH_UPDATES  = 30;   // ~1s
+    static constexpr int SYS_TASK_ROWS = 15;
+    // Panels are built on first visit; below this much free LVGL pool the hidden ones are torn down again
+    static constexpr size_t PANEL_EVICT_FREE_BYTES = 24 * 1024;
 
     // Root container
     lv_obj_t* _root = nullptr;
+    lv_timer_t* _updateTimer = nullptr;
+
+    // Slider edits since the last update tick, sent to the engine as one batch
+    ParamCoalescer _paramEdits;
+
+    // SD profile requests, completed back on the LVGL task (device only)
+    ProfileStore* _profileStore = nullptr;
 
     // Header
     lv_obj_t* _headerBar = nullptr;
     lv_obj_t* _titleLabel = nullptr;
     lv_obj_t* _muteBtn = nullptr;
     lv_obj_t* _muteBtnLabel = nullptr;
+    lv_obj_t* _undoBtn = nullptr;
+    lv_obj_t* _redoBtn = nullptr;
     lv_obj_t* _versionLabel = nullptr;
 
     // Navigation sidebar
@@ -88,6 +114,42 @@ private:
     lv_obj_t* _panelVoice = nullptr;
     lv_obj_t* _panelProfiles = nullptr;
     lv_obj_t* _panelTinnitus = nullptr;
+    lv_obj_t* _panelDiag = nullptr;
+    lv_obj_t* _panelSys = nullptr;
+
+    // Diagnostics panel (stage profiler table, one label per column)
+    lv_obj_t* _diagHeaders[6] = {};
+    lv_obj_t* _diagColumns[6] = {};  // stage, min, avg, p99, max, p99 % of budget
+    lv_obj_t* _diagBenchLabel = nullptr;
+    bool _diagBenchView = false;     // Columns show the kernel benchmark instead
+    lv_obj_t* _diagSummaryLabel = nullptr;
+    lv_obj_t* _diagXrunLabel = nullptr;
+    lv_obj_t* _diagDegradeToggle = nullptr;
+    lv_obj_t* _diagLatencyLabel = nullptr;  // Round-trip test result for the current block size
+    lv_obj_t* _diagCostLabel = nullptr;     // Cost model prediction for the current params
+    lv_obj_t* _diagSdLabel = nullptr;       // SD throughput test result, or USB disk transfer while on
+    lv_obj_t* _diagUsbBtnLabel = nullptr;
+    int _diagRefreshCounter = 0;
+
+    // System panel (per-core load, busiest tasks, heap per capability)
+    lv_obj_t* _sysCoreLabel = nullptr;
+    lv_obj_t* _sysColumns[5] = {};   // task, core, priority, cpu %, stack free
+    lv_obj_t* _sysHeapLabel = nullptr;
+    lv_obj_t* _sysSoakLabel = nullptr;
+    lv_obj_t* _sysPowerBtnLabel = nullptr;
+    lv_obj_t* _sysPowerLabel = nullptr;
+    lv_obj_t* _sysStressBtnLabel = nullptr;
+    lv_obj_t* _sysStressLabel = nullptr;   // Contention run: audio health alone vs under every load
+    lv_obj_t* _sysProfileBtnLabel = nullptr;
+    lv_obj_t* _sysFrameLabel = nullptr;
+    lv_obj_t* _sysFrameCols[9] = {};  // stage name, then one column per frame-time bucket
+
+    // Ear selector (L+R / LEFT / RIGHT) on the filter, EQ, output and tinnitus panels; the
+    // per-ear controls there edit _editEar (an AudioEar, AUDIO_EAR_BOTH while linked)
+    lv_obj_t* _earBtns[4] = {};
+    int _editEar = 2;
+    int _syncedEar = -1;              // _editEar as of the last syncUiToParams()
+    uint32_t _syncedParamsGen = 0;    // AudioParamGenerations::latest the controls reflect
 
     // Filter panel controls
     lv_obj_t* _hpfToggle = nullptr;
@@ -102,6 +164,7 @@ private:
     lv_obj_t* _nsModeBtn0 = nullptr;
     lv_obj_t* _nsModeBtn1 = nullptr;
     lv_obj_t* _nsModeBtn2 = nullptr;
+    lv_obj_t* _nsLinkToggle = nullptr;
     lv_obj_t* _nsModeLabel = nullptr;
     int _nsActiveMode = 1;
 
@@ -113,6 +176,12 @@ private:
     lv_obj_t* _eqHighSlider = nullptr;
     lv_obj_t* _eqHighLabel = nullptr;
 
+    // EQ panel spectrum: third-octave input vs output, 100 Hz - 16 kHz
+    static constexpr int SPECTRUM_BANDS = 23;
+    static constexpr int SPECTRUM_W = 1000;
+    static constexpr int SPECTRUM_H = 130;
+    SpectrumView _spectrum;
+
     // Output panel controls
     lv_obj_t* _volumeSlider = nullptr;
     lv_obj_t* _volumeValueLabel = nullptr;
@@ -135,12 +204,30 @@ private:
     lv_obj_t* _agcTargetSlider = nullptr;
     lv_obj_t* _agcTargetValueLabel = nullptr;
     lv_obj_t* _agcLimiterToggle = nullptr;
+    lv_obj_t* _agcLinkToggle = nullptr;
 
     // VU meters
-    lv_obj_t* _meterBarL = nullptr;
-    lv_obj_t* _meterBarR = nullptr;
-    lv_obj_t* _meterPeakL = nullptr;
-    lv_obj_t* _meterPeakR = nullptr;
+    static constexpr int METER_MAX_W = 696;     // 700px track minus borders and inset
+    static constexpr int HP_METER_MAX_W = 546;  // sliderW(550) minus borders and inset
+    LevelMeter _meterL;
+    LevelMeter _meterR;
+
+    // Level history trace (2s, one point per 2 audio blocks)
+    static constexpr int HISTORY_POINTS = 100;
+    static constexpr int HISTORY_W = 700;
+    static constexpr int HISTORY_H = 60;
+    lv_obj_t* _historyLine = nullptr;
+    lv_point_precise_t _historyPts[HISTORY_POINTS] = {};
+    float _historyLevels[HISTORY_POINTS] = {};  // Ring of per-point peak levels
+    int _historyHead = 0;
+    int _historyPending = 0;      // Blocks folded into the next point
+    float _historyAccum = 0.0f;
+    float _smoothRmsL = 0.0f;     // Meter ballistics across drained frames
+    float _smoothRmsR = 0.0f;
+
+    // Latency mode (block size) controls
+    lv_obj_t* _latencyBtns[4] = {};  // 1 / 2 / 5 / 10 ms
+    lv_obj_t* _latencyLabel = nullptr;
 
     // Voice Exclusion panel controls
     lv_obj_t* _veToggle = nullptr;
@@ -158,8 +245,8 @@ private:
     lv_obj_t* _veRefHpfValueLabel = nullptr;
     lv_obj_t* _veRefLpfSlider = nullptr;
     lv_obj_t* _veRefLpfValueLabel = nullptr;
-    lv_obj_t* _veHpMeterBar = nullptr;
-    lv_obj_t* _veHpMeterPeak = nullptr;
+    LevelMeter _veHpMeter;
+    int _hpShown = -1;  // Headphone state the status labels show; -1 before the first update
     lv_obj_t* _veLevelMatchIndicator = nullptr;  // Level match indicator (HP vs Main mic)
     lv_obj_t* _veLevelMatchLabel = nullptr;      // Shows ratio text
     lv_obj_t* _veBlendSlider = nullptr;
@@ -200,6 +287,8 @@ private:
     lv_obj_t* _profileSetDefaultBtn = nullptr;
     lv_obj_t* _profileStatusLabel = nullptr;
     lv_obj_t* _profileDefaultLabel = nullptr;
+    lv_obj_t* _profileSpinner = nullptr;  // Shown while a profile request is in flight
+    size_t _profileProgressShown = 0;     // Index rebuild count last written to the status label
 
     // Tinnitus relief panel controls
     // Notch filter controls (6 filters, simplified UI shows 2)
@@ -248,36 +337,76 @@ private:
     // Footer
     lv_obj_t* _footerBar = nullptr;
     lv_obj_t* _hpStatusLabel = nullptr;
+    lv_obj_t* _thermalLabel = nullptr;
+    uint32_t _thermalChangesShown = 0;  // ThermalStats::changes the label and controls reflect
 
     // Build helpers
     void createHeader();
     void createNavSidebar();
     void createContentArea();
+    lv_obj_t** panelSlot(int index);
+    void ensurePanel(int index);     // Build a panel on first visit and sync it to the engine params
+    void destroyPanel(int index);    // Delete a built panel and forget its widgets
+    void evictHiddenPanels();        // destroyPanel() everything but the active panel when LVGL memory is low
     void createFilterPanel();
     void createEqPanel();
     void createOutputPanel();
     void createVoicePanel();
     void createProfilesPanel();
     void createTinnitusPanel();
+    void createDiagPanel();
+    void updateDiagPanel();
+    void createSysPanel();
+    void updateSysPanel();
+    void updateDiagBench();
+    void updateDiagLatency();
+    void updateDiagCost();
+    void updateDiagSd();
+    void setDiagBenchView(bool bench);
     void createFooter();
     void showPanel(int index);
     void updateNavHighlight();
     void updateMuteButton();
+    void updateUndoButtons();
     void updateMeters();
-    void syncUiToParams();  // Update all UI controls to match engine params
+    void syncUiToParams(bool all = false);  // Update the controls whose engine params changed (all: every one)
+    void syncTinnitusToParams(const AudioEngineParams& params, const AudioParamGenerations& gens, bool all);
     void refreshProfileList();
+    void setProfileBusy(bool busy);
+    void showProfileListing(bool sdOk, size_t count, size_t builtins, const char* defaultName);
     void updateVoiceModeVisibility();
+    void updateLatencyButtons(int blockSize);
+    void updateLatencyLabel();
+    void updateSpectrum();
+    void postParam(ParamCoalescer::Apply apply, int arg, float value);
+    void flushParamEdits();
 
     // Style helpers
     void styleSliderWizard(lv_obj_t* slider);
     void styleToggleWizard(lv_obj_t* btn);
     lv_obj_t* createSectionLabel(lv_obj_t* parent, const char* text, int x, int y);
     lv_obj_t* createValueLabel(lv_obj_t* parent, const char* text, int x, int y);
+    lv_obj_t* createEarButton(lv_obj_t* parent, int slot);
     lv_obj_t* createDiamondDivider(lv_obj_t* parent, int y, int width);
 
     // Callbacks (static with user_data = WizardUI*)
+    static void onUpdateTimer(lv_timer_t* timer);
     static void onNavBtnClicked(lv_event_t* e);
+    static void onVersionLongPressed(lv_event_t* e);
+    static void onDiagDegradeToggle(lv_event_t* e);
+    static void onDiagResetClicked(lv_event_t* e);
+    static void onDiagBenchClicked(lv_event_t* e);
+    static void onDiagLatencyClicked(lv_event_t* e);
+    static void onDiagSdClicked(lv_event_t* e);
+    static void onDiagUsbClicked(lv_event_t* e);
+    static void onSysSoakClicked(lv_event_t* e);
+    static void onSysPowerClicked(lv_event_t* e);
+    static void onSysStressClicked(lv_event_t* e);
+    static void onSysProfileClicked(lv_event_t* e);
     static void onMuteBtnClicked(lv_event_t* e);
+    static void onUndoClicked(lv_event_t* e);
+    static void onRedoClicked(lv_event_t* e);
+    static void onEarSelect(lv_event_t* e);
     static void onHpfToggle(lv_event_t* e);
     static void onLpfToggle(lv_event_t* e);
     static void onHpfSliderChanged(lv_event_t* e);
@@ -287,12 +416,14 @@ private:
     static void onGainSliderChanged(lv_event_t* e);
     static void onMicGainSliderChanged(lv_event_t* e);
     static void onNsToggle(lv_event_t* e);
+    static void onNsLinkToggle(lv_event_t* e);
     static void onNsModeClicked(lv_event_t* e);
     static void onAgcToggle(lv_event_t* e);
     static void onAgcModeClicked(lv_event_t* e);
     static void onAgcGainChanged(lv_event_t* e);
     static void onAgcTargetChanged(lv_event_t* e);
     static void onAgcLimiterToggle(lv_event_t* e);
+    static void onAgcLinkToggle(lv_event_t* e);
     static void onVeToggle(lv_event_t* e);
     static void onVeModeClicked(lv_event_t* e);
     static void onVeRefGainChanged(lv_event_t* e);
@@ -307,12 +438,15 @@ private:
     static void onVeVadToggle(lv_event_t* e);
     static void onVeVadModeChanged(lv_event_t* e);
     static void onBoostToggle(lv_event_t* e);
+    static void onLatencyModeClicked(lv_event_t* e);
+    static void onLatencyMeasureClicked(lv_event_t* e);
     static void onVeVadGateToggle(lv_event_t* e);
     static void onVeVadGateAttenChanged(lv_event_t* e);
     static void onProfileSave(lv_event_t* e);
     static void onProfileLoad(lv_event_t* e);
     static void onProfileDelete(lv_event_t* e);
     static void onProfileSetDefault(lv_event_t* e);
+    static void onPresetClicked(lv_event_t* e);
 
     // Tinnitus panel callbacks
     static void onNotchToggle(lv_event_t* e);
@@ -5,6 +5,7 @@
  */
 #pragma once
 #include <mooncake.h>
+#include <cstdint>
 #include <memory>
 #include <hal/hal.h>
 #include "app_audio_control/app_audio_control.h"
@@ -17,8 +18,31 @@ inline void on_startup_anim()
     // Splash screen removed for faster boot and lower memory usage
 }
 
+// Free bytes per pool, for the app manager's budget checks at open and close
+inline mooncake::AppAbility::MemoryInfo_t app_memory_probe()
+{
+    mooncake::AppAbility::MemoryInfo_t free;
+    {
+        LvglLockGuard lock;
+        lv_mem_monitor_t monitor;
+        lv_mem_monitor(&monitor);
+        // total_size is 0 when LVGL runs on the system allocator and can't tell
+        if (monitor.total_size) free.lvglPool = monitor.free_size;
+    }
+    auto* hal = GetHAL();
+    hal->updateHeapStats();
+    // No figures (desktop): unknown counts as plenty, so budgets never hold an app back there
+    const auto& internal = hal->systemStats.heapInternal;
+    const auto& psram    = hal->systemStats.heapPsram;
+    free.internal = internal.totalBytes ? internal.freeBytes : SIZE_MAX;
+    free.psram    = psram.totalBytes ? psram.freeBytes : SIZE_MAX;
+    return free;
+}
+
 inline void on_install_apps()
 {
+    mooncake::GetMooncake().setAppMemoryProbe(app_memory_probe);
+
     // Direct launch to audio control - no splash screen
     mooncake::GetMooncake().installApp(std::make_unique<AppAudioControl>());
 }
@@ -4,13 +4,15 @@
  * SPDX-License-Identifier: MIT
  */
 #pragma once
+#include <cstddef>
 #include <cstdint>
+#include <iterator>
 #include <memory>
-#include <queue>
 #include <string>
 #include <lvgl.h>
 #include <mutex>
 #include <vector>
+#include <utils/ring_buffer/spsc_ring_buffer.h>
 
 /**
  * @brief Hardware abstraction layer
@@ -43,11 +45,55 @@ public:
     {
         return 0;
     }
+    // Main loop pacing: block until wakeMainLoop() or the timeout, whichever comes first
+    virtual void waitMainLoopWake(uint32_t timeoutMs)
+    {
+        delay(timeoutMs);
+    }
+    virtual void wakeMainLoop()
+    {
+    }
     virtual int getCpuTemp()
     {
         return 0.0f;
     }
 
+    /* ------------------------------ System stats ------------------------------ */
+    struct TaskStats_t {
+        std::string name;
+        int core                = -1;    // -1 = not pinned
+        int priority            = 0;
+        float cpuPercent        = 0.0f;  // Share of one core since the previous update
+        uint32_t stackFreeBytes = 0;     // High-water mark: least free stack ever seen
+    };
+    struct HeapStats_t {
+        uint32_t totalBytes   = 0;
+        uint32_t freeBytes    = 0;
+        uint32_t minFreeBytes = 0;       // Low-water mark since boot
+        uint32_t largestFree  = 0;       // Largest single allocation that can succeed
+    };
+    struct SystemStats_t {
+        float coreLoad[2] = {0.0f, 0.0f};  // Non-idle share per core since the previous update
+        uint32_t cpuMaxMhz = 0;            // CPU clock the DFS governor allows at the moment
+        std::vector<TaskStats_t> tasks;    // Busiest first
+        HeapStats_t heapInternal;
+        HeapStats_t heapDma;
+        HeapStats_t heapPsram;
+        // LVGL's own heap regions (esp_lvgl_port allocator); all 0 when LVGL uses another allocator
+        HeapStats_t lvglInternal;
+        HeapStats_t lvglPsram;
+        uint32_t lvglSpilled = 0;  // LVGL allocations that landed in the other region because theirs was full
+    };
+    SystemStats_t systemStats;
+    // Cheap enough for a 1 Hz refresh; loads are deltas against the previous call
+    virtual void updateSystemStats()
+    {
+    }
+    // Heap figures only (systemStats.heap*), no task snapshot
+    virtual void updateHeapStats()
+    {
+    }
+
     /* --------------------------------- Display -------------------------------- */
     virtual int getDisplayWidth()
     {
@@ -65,6 +111,38 @@ public:
         return 0;
     }
 
+    // Frame pipeline histograms since the last reset. Time buckets are <1, <2, <4 ... <64 and >=64 ms
+    static constexpr int FRAME_BUCKETS = 8;
+    struct FrameHist_t {
+        uint32_t count = 0;
+        float avgMs    = 0.0f;
+        float maxMs    = 0.0f;
+        uint32_t buckets[FRAME_BUCKETS] = {};
+    };
+    struct DisplayStats_t {
+        float fps = 0.0f;      // Redrawn frames per second since the previous update
+        FrameHist_t frame;     // Refresh start to ready
+        FrameHist_t render;    // LVGL drawing: the frame outside the flush callback
+        FrameHist_t rotate;    // Per flushed area
+        FrameHist_t flush;     // Per flushed area, draw call to transfer done
+        FrameHist_t ppaDraw;   // Per draw task the PPA draw unit took, dispatch to done
+        // Share of the screen redrawn per frame; buckets halve from a full redraw (last) down to <1/64 (first)
+        uint32_t dirtyBuckets[FRAME_BUCKETS] = {};
+        float dirtyAvgPct = 0.0f;
+        float dirtyMaxPct = 0.0f;
+        // Data cache misses of the LVGL core per frame (all 0 where the SoC has no counters)
+        float cacheL1MissAvg    = 0.0f;
+        float cacheL2MissAvg    = 0.0f;
+        uint32_t cacheL2MissMax = 0;
+    };
+    DisplayStats_t displayStats;
+    virtual void updateDisplayStats()
+    {
+    }
+    virtual void resetDisplayStats()
+    {
+    }
+
     /* ---------------------------------- Lvgl ---------------------------------- */
     lv_indev_t* lvTouchpad = nullptr;
     virtual void lvglLock()
@@ -80,11 +158,19 @@ public:
         float busPower     = 0.0f;
         float shuntVoltage = 0.0f;
         float shuntCurrent = 0.0f;
+        float chargeMah    = 0.0f;  // Coulomb counter, signed as shuntCurrent
+        float energyMwh    = 0.0f;
     };
     PMData_t powerMonitorData;
     virtual void updatePowerMonitorData()
     {
     }
+    // 1 s averages, oldest first, up to the last few minutes (counters left 0)
+    virtual size_t getPowerHistory(std::vector<PMData_t>& history)
+    {
+        history.clear();
+        return 0;
+    }
     virtual void setChargeQcEnable(bool enable)
     {
     }
@@ -125,6 +211,31 @@ public:
     virtual void sleepAndRtcWakeup()
     {
     }
+    // Scheduled tinnitus session: books the engine's current params as the
+    // session profile, sets the RTC alarm for the next hour:minute of RTC time
+    // and powers off. The alarm boots straight into audio-only mode with that
+    // profile, fading in; false if the booking failed (the device stays on)
+    virtual bool sleepUntilSession(uint8_t hour, uint8_t minute)
+    {
+        return false;
+    }
+    // This boot is a session alarm wake-up
+    virtual bool isSessionWakeup()
+    {
+        return false;
+    }
+    // Audio-only power mode: backlight and panel off, LVGL stopped, app updates
+    // held and, with CONFIG_PM_ENABLE, the CPU clock scaled down while the audio
+    // task waits on I2S. A touch, a knock on the case or USB HID input ends it;
+    // false if unavailable
+    virtual bool setAudioOnlyMode(bool enabled)
+    {
+        return false;
+    }
+    virtual bool isAudioOnlyMode()
+    {
+        return false;
+    }
 
     /* ----------------------------------- IMU ---------------------------------- */
     struct IMUData_t {
@@ -139,9 +250,30 @@ public:
     virtual void updateImuData()
     {
     }
+    struct IMUSample_t {
+        int64_t timeUs = 0;  // When taken, esp_timer microseconds
+        IMUData_t data;
+    };
+    // Batched samples (200 Hz) after seq, oldest first; seq 0 starts at the oldest kept
+    virtual size_t getImuSamples(std::vector<IMUSample_t>& samples, uint32_t& seq)
+    {
+        samples.clear();
+        return 0;
+    }
     virtual void clearImuIrq()
     {
     }
+    // Head motion from the IMU stream to the audio engine: VE adaptation held
+    // while turning, slowed while walking, beam steering turned against the
+    // head's yaw; false if unavailable
+    virtual bool setMotionAwareAudio(bool enabled)
+    {
+        return false;
+    }
+    virtual bool isMotionAwareAudio()
+    {
+        return false;
+    }
 
     /* ----------------------------------- RTC ---------------------------------- */
     virtual void getRtcTime(tm* time)
@@ -165,16 +297,52 @@ public:
     {
         return false;
     }
-
-    /* ---------------------------------- USB-A --------------------------------- */
-    struct HidMouseData_t {
-        std::mutex mutex;
-        int x         = 0;
-        int y         = 0;
-        bool btnLeft  = false;
-        bool btnRight = false;
-    };
-    HidMouseData_t hidMouseData;
+    // Preview orientation (default: mirrored, like a selfie view). Done by the sensor
+    // where it can, otherwise by a PPA pass; false if neither is available.
+    virtual bool setCameraMirror(bool hmirror, bool vflip)
+    {
+        return false;
+    }
+    // Preview frame size from the next start (0 x 0: the full 1280 x 720). Small
+    // sizes run the sensor in a binned mode; session recording needs full size.
+    virtual bool setCameraPreviewSize(uint32_t width, uint32_t height)
+    {
+        return false;
+    }
+    // JPEG of the next preview frame to /sd/DCIM; capture must be running
+    virtual bool saveCameraSnapshot(std::string& savedPath)
+    {
+        return false;
+    }
+    // H.264 of the preview plus the processed output WAV, both on the audio
+    // sample clock, to /sd/Recordings/rec_NNNN.*; capture must be running
+    virtual bool startSessionRecording()
+    {
+        return false;
+    }
+    virtual void stopSessionRecording()
+    {
+    }
+    virtual bool isSessionRecording()
+    {
+        return false;
+    }
+    // Point the beamformer at the face in the camera preview while one is in
+    // view (CONFIG_HOWIZARD_FACE_STEERING builds); false if unavailable
+    virtual bool setFaceSteering(bool enabled)
+    {
+        return false;
+    }
+    virtual bool isFaceSteering()
+    {
+        return false;
+    }
+    // Free the capture frame memory kept between captures (call when the camera
+    // UI closes); false while capturing
+    virtual bool releaseCameraBuffers()
+    {
+        return true;
+    }
 
     /* ---------------------------------- Audio --------------------------------- */
     virtual void setSpeakerVolume(uint8_t volume)
@@ -184,12 +352,62 @@ public:
     {
         return 0;
     }
-    // [MIC-L, AEC, MIC-R, MIC-HP]
-    virtual void audioRecord(std::vector<int16_t>& data, uint16_t durationMs, float gain = 80.0f)
+    // Record blocks point into the recorder's buffer and are only valid during the visit;
+    // return false to stop
+    using AudioBlockVisitor_t = bool (*)(const int16_t* block, size_t samples, void* user);
+    // Async playback is done with the caller's buffer
+    using AudioDone_t = void (*)(void* user);
+    static constexpr size_t AUDIO_RECORD_BLOCK_FRAMES = 128;
+
+    // [MIC-L, AEC, MIC-R, MIC-HP] frames at 48 kHz into the caller's buffer, `samples` long
+    // (4 per frame). Returns the samples filled.
+    virtual size_t audioRecordInto(int16_t* data, size_t samples, float gain = 80.0f)
     {
+        return 0;
+    }
+    // The same frames streamed through visit, on the calling thread, AUDIO_RECORD_BLOCK_FRAMES
+    // at a time, so a long capture needs no buffer of its own. Returns the samples visited.
+    virtual size_t audioRecordStream(uint16_t durationMs, AudioBlockVisitor_t visit, void* user, float gain = 80.0f)
+    {
+        int16_t block[AUDIO_RECORD_BLOCK_FRAMES * 4];
+        size_t remaining = 48000 * 4 * durationMs / 1000;
+        size_t visited   = 0;
+        while (remaining > 0) {
+            size_t got = audioRecordInto(block, remaining < std::size(block) ? remaining : std::size(block), gain);
+            if (got == 0) break;
+            visited += got;
+            remaining -= got;
+            if (!visit(block, got, user)) break;
+        }
+        return visited;
+    }
+    // Interleaved stereo at 48 kHz played from the caller's buffer, not copied. Sync returns
+    // once it's played; async returns at once and the buffer has to stay valid until
+    // done(user), called from the player. False when it didn't start (an async clip is still
+    // queued or playing), and done isn't called.
+    virtual bool audioPlayBuffer(const int16_t* data, size_t samples, bool async = true, AudioDone_t done = nullptr,
+                                 void* user = nullptr)
+    {
+        return false;
+    }
+    // Vector forms of the above
+    void audioRecord(std::vector<int16_t>& data, uint16_t durationMs, float gain = 80.0f)
+    {
+        data.resize(48000 * 4 * durationMs / 1000);
+        audioRecordInto(data.data(), data.size(), gain);
     }
-    virtual void audioPlay(std::vector<int16_t>& data, bool async = true)
+    // Async holds a copy, since data may be gone by the time it plays
+    void audioPlay(std::vector<int16_t>& data, bool async = true)
     {
+        if (!async) {
+            audioPlayBuffer(data.data(), data.size(), false);
+            return;
+        }
+        auto* copy = new std::vector<int16_t>(data);
+        if (!audioPlayBuffer(copy->data(), copy->size(), true,
+                             [](void* user) { delete static_cast<std::vector<int16_t>*>(user); }, copy)) {
+            delete copy;
+        }
     }
 
     // Mic record test
@@ -229,6 +447,20 @@ public:
     {
     }
 
+    // SD media: an MP3 or WAV file ("/sd/...") through the hearing profile while the engine runs,
+    // mixed with the mics or in their place
+    virtual bool startMediaPlayback(const std::string& path, bool replaceMics = false)
+    {
+        return false;
+    }
+    virtual void stopMediaPlayback()
+    {
+    }
+    virtual bool isMediaPlaying()
+    {
+        return false;
+    }
+
     // Sfx
     virtual void playStartupSfx()
     {
@@ -248,19 +480,65 @@ public:
     virtual void startWifiAp()
     {
     }
+    // Station link to the configured network for remote tuning; the radio goes off a linger time after disable
+    virtual void setRemoteTuningEnabled(bool enabled)
+    {
+    }
+    virtual bool isWifiConnected()
+    {
+        return false;
+    }
+
+    /* -------------------------------- Firmware -------------------------------- */
+    // OTA into the idle app slot from an SD path ("/sd/...") or an http(s):// URL, with audio running;
+    // the new image runs after a reboot and rolls back if it doesn't come up healthy
+    virtual bool startFirmwareUpdate(const std::string& source)
+    {
+        return false;
+    }
+    virtual void cancelFirmwareUpdate()
+    {
+    }
+    // 0-100 while writing (0 until the size is known), 100 once ready to reboot, -1 idle or failed
+    virtual int getFirmwareUpdateProgress()
+    {
+        return -1;
+    }
 
     /* --------------------------------- SD Card -------------------------------- */
     struct FileEntry_t {
         std::string name;
         bool isDir;
     };
+    // Name points into the scanner's buffer and is only valid during the visit
+    struct DirEntry_t {
+        const char* name;
+        bool isDir;
+    };
+    // Return false to stop the scan
+    using DirVisitor_t = bool (*)(const DirEntry_t& entry, void* user);
     virtual bool isSdCardMounted()
     {
         return false;
     }
-    virtual std::vector<FileEntry_t> scanSdCard(const std::string& dirPath)
+    // Streams one page of dirPath's entries through visit without allocating:
+    // skips `offset`, visits up to `limit` (0 = all). Returns the number visited;
+    // *more says whether entries remain past the page.
+    virtual size_t scanSdCardPage(const std::string& dirPath, size_t offset, size_t limit, DirVisitor_t visit,
+                                  void* user, bool* more = nullptr)
+    {
+        if (more) *more = false;
+        return 0;
+    }
+    // Whole directory at once, for small ones
+    std::vector<FileEntry_t> scanSdCard(const std::string& dirPath)
     {
-        return {};
+        std::vector<FileEntry_t> entries;
+        scanSdCardPage(dirPath, 0, 0, [](const DirEntry_t& e, void* user) {
+            static_cast<std::vector<FileEntry_t>*>(user)->push_back({e.name, e.isDir});
+            return true;
+        }, &entries);
+        return entries;
     }
 
     /* -------------------------------- Interface ------------------------------- */
@@ -276,9 +554,16 @@ public:
     {
         return false;
     }
-    virtual std::vector<uint8_t> i2cScan(bool isInternal)
+    // Addresses that acked into the caller's array, up to capacity; returns how many were stored
+    virtual size_t i2cScanInto(bool isInternal, uint8_t* addrs, size_t capacity)
     {
-        return {};
+        return 0;
+    }
+    std::vector<uint8_t> i2cScan(bool isInternal)
+    {
+        uint8_t addrs[128];
+        size_t n = i2cScanInto(isInternal, addrs, sizeof(addrs));
+        return std::vector<uint8_t>(addrs, addrs + n);
     }
     virtual void initPortAI2c()
     {
@@ -298,21 +583,23 @@ public:
     }
 
     /* ------------------------------ UART monitor ------------------------------ */
+    // RS485 bytes both ways. The UART task is the rx producer and the tx consumer;
+    // a full rx ring drops what arrives until the app reads, a message that doesn't
+    // fit in tx is dropped whole.
     struct UartMonitorData_t {
-        std::mutex mutex;
-        std::queue<uint8_t> rxQueue;
-        std::queue<uint8_t> txQueue;
+        static constexpr size_t RX_CAPACITY = 4096;
+        static constexpr size_t TX_CAPACITY = 1024;
+        smooth_ui_toolkit::spsc_ring_buffer<uint8_t, RX_CAPACITY> rx;
+        smooth_ui_toolkit::spsc_ring_buffer<uint8_t, TX_CAPACITY> tx;
+        std::mutex txMutex;  // Serializes uartMonitorSend() callers: the tx ring takes one producer
     };
     UartMonitorData_t uartMonitorData;
     virtual void uartMonitorSend(std::string msg, bool newLine = true)
     {
-        std::lock_guard<std::mutex> lock(uartMonitorData.mutex);
-        for (auto c : msg) {
-            uartMonitorData.txQueue.push(c);
-        }
-        if (newLine) {
-            uartMonitorData.txQueue.push('\n');
-        }
+        if (newLine) msg.push_back('\n');
+        std::lock_guard<std::mutex> lock(uartMonitorData.txMutex);
+        if (uartMonitorData.tx.available() < msg.size()) return;
+        uartMonitorData.tx.push_n(reinterpret_cast<const uint8_t*>(msg.data()), msg.size());
     }
 };
 
@@ -0,0 +1,141 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "heap_tracker.h"
+#include <hal/hal.h>
+#include <mooncake_log.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+static const std::string _tag = "heap";
+
+namespace {
+
+constexpr int HEAP_KINDS = 3;
+const char* const kHeapNames[HEAP_KINDS] = {"internal", "dma", "psram"};
+
+struct PointRecord_t {
+    std::string name;
+    uint32_t hits = 0;
+    hal::HalBase::HeapStats_t baseline[HEAP_KINDS];
+    hal::HalBase::HeapStats_t latest[HEAP_KINDS];
+    uint32_t worstLargest[HEAP_KINDS] = {};  // Lowest largest-free-block already warned about
+};
+
+std::mutex _mutex;
+std::vector<PointRecord_t> _points;
+
+std::atomic<int> _soak_total{0};
+std::atomic<int> _soak_done{0};
+
+float kb(uint32_t bytes)
+{
+    return bytes / 1024.0f;
+}
+
+}  // namespace
+
+void heap_tracker::Checkpoint(const std::string& point)
+{
+    auto* hal = GetHAL();
+    hal->updateHeapStats();
+    const hal::HalBase::HeapStats_t now[HEAP_KINDS] = {
+        hal->systemStats.heapInternal, hal->systemStats.heapDma, hal->systemStats.heapPsram};
+    if (now[0].totalBytes == 0) return;  // No heap figures on this platform
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    PointRecord_t* rec = nullptr;
+    for (auto& p : _points) {
+        if (p.name == point) {
+            rec = &p;
+            break;
+        }
+    }
+    if (!rec) {
+        _points.push_back({});
+        rec = &_points.back();
+        rec->name = point;
+        for (int k = 0; k < HEAP_KINDS; k++) {
+            rec->baseline[k] = now[k];
+            rec->worstLargest[k] = now[k].largestFree;
+        }
+    }
+    rec->hits++;
+
+    mclog::tagInfo(_tag, "[{}#{}] internal {:.1f} KB free, largest {:.1f} | dma {:.1f}, largest {:.1f} | psram {:.1f}, largest {:.1f}",
+                   point, rec->hits, kb(now[0].freeBytes), kb(now[0].largestFree), kb(now[1].freeBytes),
+                   kb(now[1].largestFree), kb(now[2].freeBytes), kb(now[2].largestFree));
+
+    for (int k = 0; k < HEAP_KINDS; k++) {
+        rec->latest[k] = now[k];
+        const uint32_t largest = now[k].largestFree;
+        // Warn once per new low so a slow leak shows up as a trail, not a flood
+        if (largest + LARGEST_SLACK_BYTES < rec->baseline[k].largestFree && largest < rec->worstLargest[k]) {
+            rec->worstLargest[k] = largest;
+            mclog::tagWarn(_tag, "[{}] {} largest free block shrank {:.1f} -> {:.1f} KB (free {:.1f} -> {:.1f} KB)",
+                           point, kHeapNames[k], kb(rec->baseline[k].largestFree), kb(largest),
+                           kb(rec->baseline[k].freeBytes), kb(now[k].freeBytes));
+        }
+    }
+}
+
+void heap_tracker::Report()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    mclog::tagInfo(_tag, "heap report: {} checkpoints", _points.size());
+    for (const auto& p : _points) {
+        for (int k = 0; k < HEAP_KINDS; k++) {
+            const auto& b = p.baseline[k];
+            const auto& l = p.latest[k];
+            mclog::tagInfo(_tag, "  {:<16} {:<8} x{}: free {:.1f} -> {:.1f} KB, largest {:.1f} -> {:.1f} KB, min free {:.1f} KB",
+                           p.name, kHeapNames[k], p.hits, kb(b.freeBytes), kb(l.freeBytes), kb(b.largestFree),
+                           kb(l.largestFree), kb(l.minFreeBytes));
+        }
+    }
+}
+
+void heap_tracker::StartSoak(int cycles)
+{
+    mclog::tagInfo(_tag, "soak: {} open/close cycles", cycles);
+    _soak_done.store(0);
+    _soak_total.store(cycles);
+    // The first close happens on the main loop, which may be idling
+    GetHAL()->wakeMainLoop();
+}
+
+void heap_tracker::StopSoak()
+{
+    if (_soak_total.exchange(0) != 0) {
+        mclog::tagInfo(_tag, "soak stopped after {} cycles", _soak_done.load());
+        Report();
+    }
+}
+
+bool heap_tracker::IsSoaking()
+{
+    return _soak_total.load() > 0;
+}
+
+bool heap_tracker::SoakCycleDone()
+{
+    if (!IsSoaking()) return false;
+    int done = _soak_done.fetch_add(1) + 1;
+    if (done < _soak_total.load()) return true;
+    mclog::tagInfo(_tag, "soak finished: {} cycles", done);
+    _soak_total.store(0);
+    Report();
+    return false;
+}
+
+int heap_tracker::SoakCyclesDone()
+{
+    return _soak_done.load();
+}
+
+int heap_tracker::SoakCyclesTotal()
+{
+    return _soak_total.load();
+}
@@ -0,0 +1,36 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Howizard Project
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Heap fragmentation tracker for app lifecycle points
+ *
+ * Each named checkpoint snapshots the internal, DMA and PSRAM heaps. The first
+ * snapshot of a point is its baseline; later ones warn when the largest free
+ * block has shrunk past LARGEST_SLACK_BYTES below it, i.e. when an open/close
+ * cycle left the heap more fragmented than it found it.
+ */
+namespace heap_tracker {
+
+static constexpr uint32_t LARGEST_SLACK_BYTES = 4096;
+static constexpr int SOAK_DEFAULT_CYCLES      = 200;
+
+void Checkpoint(const std::string& point);
+// Log baseline vs latest for every point seen so far
+void Report();
+
+// Soak mode: the app closes and reopens itself this many times, then reports
+void StartSoak(int cycles = SOAK_DEFAULT_CYCLES);
+void StopSoak();
+bool IsSoaking();
+// Called by the app once per finished close/open cycle; false once the soak is over
+bool SoakCycleDone();
+int SoakCyclesDone();
+int SoakCyclesTotal();
+
+}  // namespace heap_tracker
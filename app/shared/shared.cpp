@@ -22,3 +22,40 @@ void shared_data::Destroy()
         _shared_data_instance = nullptr;
     }
 }
+
+static const char* const _system_state_event_names[] = {
+    "None",
+    "HeadphoneInserted",
+    "HeadphoneRemoved",
+    "UsbPowerChanged",
+    "ThermalWarning",
+    "ThermalNormal",
+    "BatteryLow",
+    "WifiConnected",
+    "WifiDisconnected",
+    "FirmwareUpdateDone",
+};
+static_assert(sizeof(_system_state_event_names) / sizeof(_system_state_event_names[0]) ==
+                  static_cast<size_t>(shared_data::SystemStateEvent::Count),
+              "SystemStateEvent names out of step with the enum");
+
+static const char* const _input_event_names[] = {
+    "None",
+    "KeyDown",
+    "KeyUp",
+};
+static_assert(sizeof(_input_event_names) / sizeof(_input_event_names[0]) ==
+                  static_cast<size_t>(shared_data::InputEvent::Count),
+              "InputEvent names out of step with the enum");
+
+const char* shared_data::GetEventName(SystemStateEvent id)
+{
+    const auto index = static_cast<size_t>(id);
+    return index < static_cast<size_t>(SystemStateEvent::Count) ? _system_state_event_names[index] : "Unknown";
+}
+
+const char* shared_data::GetEventName(InputEvent id)
+{
+    const auto index = static_cast<size_t>(id);
+    return index < static_cast<size_t>(InputEvent::Count) ? _input_event_names[index] : "Unknown";
+}
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: MIT
  */
 #pragma once
+#include <cstdint>
 #include <string>
 #include <thread>
 #include <mutex>
@@ -15,9 +16,63 @@
 
 namespace shared_data {
 
+/* --------------------------------- Events --------------------------------- */
+// Emitted from any task, delivered on the UI loop by app::Update(), where
+// slots may touch LVGL. Slots switch on id; nothing is allocated on the way
+
+enum class SystemStateEvent : uint16_t {
+    None = 0,
+    HeadphoneInserted,
+    HeadphoneRemoved,
+    UsbPowerChanged,   // payload.value: 1 attached, 0 removed
+    ThermalWarning,    // payload.celsius
+    ThermalNormal,     // payload.celsius
+    BatteryLow,        // payload.value: percent
+    WifiConnected,
+    WifiDisconnected,
+    FirmwareUpdateDone,  // payload.value: esp_err_t, 0 when ready to reboot
+    Count,
+};
+
+enum class InputEvent : uint16_t {
+    None = 0,
+    KeyDown,  // payload.key
+    KeyUp,    // payload.key
+    Count,
+};
+
+enum class InputSource : uint16_t {
+    Keypad = 0,
+    UsbHid,
+};
+
+union EventPayload_t {
+    int32_t value = 0;
+    float celsius;
+    struct {
+        uint16_t code;       // Keypad key index, or HID usage ID
+        uint16_t modifiers;  // HID modifier bits
+    } key;
+};
+
+struct SystemStateEvent_t {
+    SystemStateEvent id = SystemStateEvent::None;
+    EventPayload_t payload;
+};
+
+struct InputEvent_t {
+    InputEvent id = InputEvent::None;
+    InputSource source = InputSource::Keypad;
+    EventPayload_t payload;
+};
+
+// Interned names for logs, never nullptr
+const char* GetEventName(SystemStateEvent id);
+const char* GetEventName(InputEvent id);
+
 struct SharedData_t {
-    smooth_ui_toolkit::Signal<std::string> systemStateEvents;
-    smooth_ui_toolkit::Signal<std::string> inputEvents;
+    smooth_ui_toolkit::QueuedSignal<SystemStateEvent_t, 32> systemStateEvents;
+    smooth_ui_toolkit::QueuedSignal<InputEvent_t, 32> inputEvents;
 };
 
 SharedData_t* Get();
@@ -30,12 +85,12 @@ inline shared_data::SharedData_t* GetSharedData()
     return shared_data::Get();
 }
 
-inline smooth_ui_toolkit::Signal<std::string>& GetSystemStateEvents()
+inline smooth_ui_toolkit::QueuedSignal<shared_data::SystemStateEvent_t, 32>& GetSystemStateEvents()
 {
     return GetSharedData()->systemStateEvents;
 }
 
-inline smooth_ui_toolkit::Signal<std::string>& GetInputEvents()
+inline smooth_ui_toolkit::QueuedSignal<shared_data::InputEvent_t, 32>& GetInputEvents()
 {
     return GetSharedData()->inputEvents;
 }
@@ -20,6 +20,10 @@ set(MOONCAKE_INCS
 add_library(${PROJECT_NAME} ${MOONCAKE_SRCS})
 target_include_directories(${PROJECT_NAME} PUBLIC ${MOONCAKE_INCS})
 
+# Worker Ability 独立线程
+find_package(Threads REQUIRED)
+target_link_libraries(${PROJECT_NAME} PUBLIC Threads::Threads)
+
 
 option(MOONCAKE_BUILD_EXAMPLE "Build example" ON)
 
@@ -38,3 +42,5 @@ add_test(basic_demo example/basic_demo)
 add_test(ability_manager_test example/ability_manager_test)
 add_test(extension_test example/extension_test)
 add_test(singleton_test example/singleton_test)
+add_test(worker_thread_test example/worker_thread_test)
+add_test(app_memory_test example/app_memory_test)
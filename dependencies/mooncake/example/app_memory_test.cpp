@@ -0,0 +1,109 @@
+/**
+ * @file app_memory_test.cpp
+ * @author Forairaaaaa
+ * @brief
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <ability/ability.h>
+#include <ability_manager/ability_manager.h>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+using namespace mooncake;
+
+// 假的 LVGL 内存池，App 在 onOpen 里占用，onClose 里归还
+static std::size_t _lvgl_free = 96 * 1024;
+
+class MemoryApp : public AppAbility {
+public:
+    MemoryApp(const std::string& name, std::size_t useBytes, std::size_t returnBytes)
+        : _use_bytes(useBytes), _return_bytes(returnBytes)
+    {
+        setAppInfo().name = name;
+    }
+    void onOpen() override
+    {
+        printf("[%s] on open\n", getAppInfo().name.c_str());
+        _lvgl_free -= _use_bytes;
+    }
+    void onClose() override
+    {
+        printf("[%s] on close\n", getAppInfo().name.c_str());
+        _lvgl_free += _return_bytes;
+    }
+    void onOpenRefused() override
+    {
+        printf("[%s] on open refused\n", getAppInfo().name.c_str());
+    }
+
+private:
+    std::size_t _use_bytes;
+    std::size_t _return_bytes;
+};
+
+int main()
+{
+    AbilityManager am;
+    am.setMemoryProbe([]() {
+        AppAbility::MemoryInfo_t free;
+        free.lvglPool = _lvgl_free;
+        free.internal = 100 * 1024;
+        free.psram = 1024 * 1024;
+        return free;
+    });
+
+    // 后台 App 没声明预算，允许被驱逐
+    auto background = std::make_unique<MemoryApp>("background", 60 * 1024, 60 * 1024);
+    background->setAppInfo().evictable = true;
+    auto background_id = am.createAbility(std::move(background));
+
+    // 前台 App 声明要 50 KB LVGL 内存，关闭时漏掉 10 KB
+    auto foreground = std::make_unique<MemoryApp>("foreground", 50 * 1024, 40 * 1024);
+    foreground->setAppInfo().memoryBudget.lvglPool = 50 * 1024;
+    auto foreground_id = am.createAbility(std::move(foreground));
+    am.updateAbilities();
+
+    printf(">> open background\n");
+    am.openAppAbility(background_id);
+    am.updateAbilities();
+    if (am.getAppAbilityMemoryStats(background_id).opened.lvglPool != 60 * 1024) {
+        printf("background usage not measured\n");
+        return 1;
+    }
+
+    // 只剩 36 KB，先关掉后台 App 再打开
+    printf(">> open foreground\n");
+    am.openAppAbility(foreground_id);
+    am.updateAbilities();
+    if (am.getAppAbilityCurrentState(background_id) != AppAbility::StateSleeping ||
+        am.getAppAbilityCurrentState(foreground_id) != AppAbility::StateRunning) {
+        printf("background was not evicted for foreground\n");
+        return 1;
+    }
+
+    // 后台 App 实测要 60 KB，前台不可驱逐，只剩 46 KB，拒绝
+    printf(">> reopen background\n");
+    am.openAppAbility(background_id);
+    am.updateAbilities();
+    if (am.getAppAbilityCurrentState(background_id) != AppAbility::StateSleeping ||
+        am.getAppAbilityMemoryStats(background_id).refusedNum != 1) {
+        printf("background was not refused\n");
+        return 1;
+    }
+
+    printf(">> close foreground\n");
+    am.closeAppAbility(foreground_id);
+    am.updateAbilities();
+    if (am.getAppAbilityMemoryStats(foreground_id).retained.lvglPool != 10 * 1024) {
+        printf("foreground leak not measured\n");
+        return 1;
+    }
+
+    printf(">> test over\n");
+    return 0;
+}
@@ -0,0 +1,124 @@
+/**
+ * @file worker_thread_test.cpp
+ * @author Forairaaaaa
+ * @brief
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <ability/ability.h>
+#include <ability_manager/ability_manager.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <thread>
+
+using namespace mooncake;
+
+class MyWorker : public WorkerAbility {
+public:
+    std::atomic<int> running_count{0};
+    std::atomic<bool> ran_on_caller{false};
+    std::thread::id caller_id = std::this_thread::get_id();
+
+    MyWorker()
+    {
+        printf("[worker] on construct\n");
+        setThreadInfo().threaded = true;
+        setThreadInfo().name = "test_worker";
+        setThreadInfo().intervalMs = 1;
+    }
+    ~MyWorker()
+    {
+        printf("[worker] on deconstruct\n");
+    }
+    void onCreate() override
+    {
+        printf("[worker] on create\n");
+    }
+    void onResume() override
+    {
+        printf("[worker] on resume\n");
+    }
+    void onRunning() override
+    {
+        if (std::this_thread::get_id() == caller_id) {
+            ran_on_caller = true;
+        }
+        running_count++;
+    }
+    void onPause() override
+    {
+        printf("[worker] on pause\n");
+    }
+    void onDestroy() override
+    {
+        printf("[worker] on ondestory\n");
+    }
+};
+
+// 等待条件成立，超时返回 false
+static bool wait_for(const std::function<bool()>& condition)
+{
+    for (int i = 0; i < 2000; i++) {
+        if (condition()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+int main()
+{
+    AbilityManager am;
+
+    printf(">> create threaded worker\n");
+    auto ability_id = am.createAbility(std::make_unique<MyWorker>());
+    auto worker = static_cast<MyWorker*>(am.getAbilityInstance(ability_id));
+    am.updateAbilities();
+    if (!worker->isThreaded()) {
+        printf("worker has no thread\n");
+        return 1;
+    }
+
+    // 管理器刷新不再回调 onRunning，由线程自己跑
+    int before = worker->running_count;
+    am.updateAbilities();
+    if (!wait_for([&] { return worker->running_count >= before + 3; }) || worker->ran_on_caller) {
+        printf("worker is not running in its own thread\n");
+        return 1;
+    }
+    printf(">> worker running in its own thread\n");
+
+    printf(">> pause worker\n");
+    am.pauseWorkerAbility(ability_id);
+    if (!wait_for([&] { return worker->currentState() == WorkerAbility::StatePausing; })) {
+        printf("worker did not pause\n");
+        return 1;
+    }
+    before = worker->running_count;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    if (worker->running_count != before) {
+        printf("worker kept running while paused\n");
+        return 1;
+    }
+
+    printf(">> resume worker\n");
+    am.resumeWorkerAbility(ability_id);
+    if (!wait_for([&] { return worker->running_count > before; })) {
+        printf("worker did not resume\n");
+        return 1;
+    }
+
+    printf(">> destroy worker\n");
+    am.destroyAbility(ability_id);
+    am.updateAbilities();
+
+    printf(">> test over\n");
+    return 0;
+}
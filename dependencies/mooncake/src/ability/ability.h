@@ -9,10 +9,15 @@
  *
  */
 #pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace mooncake {
 
+class AbilityManager;
+
 enum AbilityType_t {
     AbilityType_Null = 0,
     AbilityType_Base,
@@ -157,10 +162,15 @@ private:
  * @brief Worker
  * Ability，在三段式基础上扩展出运行、暂停状态切换。适合后台应用，比如数据监听、事件转发。或者简单二元状态的 UI 行为
  *
+ * 默认由管理器在 updateAbilities() 中轮询刷新。在 onCreate 之前（比如构造函数里）通过 setThreadInfo() 打开
+ * threaded，则改为在独立线程中运行：onResume/onRunning/onPause 都在该线程中回调，每 intervalMs 刷新一次；
+ * 暂停期间线程阻塞，不占 CPU，pause()/resume() 立即唤醒它。onCreate/onDestroy 仍在管理器线程中回调，
+ * destroy 时会等待线程退出后再回调 onDestroy。ESP-IDF 下是 FreeRTOS 任务（唤醒用任务通知），其他平台是 std::thread
+ *
  */
 class WorkerAbility : public AbilityBase {
 public:
-    virtual ~WorkerAbility() = default;
+    virtual ~WorkerAbility();
 
     enum State_t {
         StateNull = 0,
@@ -170,6 +180,15 @@ public:
         StatePausing,
     };
 
+    struct ThreadInfo_t {
+        bool threaded = false;
+        std::string name = "worker";
+        uint32_t stackSize = 4096; // 字节
+        int priority = 5;          // FreeRTOS 优先级，其他平台忽略
+        int coreId = -1;           // 绑定的核心，-1 不绑定，其他平台忽略
+        uint32_t intervalMs = 10;  // onRunning 的刷新间隔，0 为连续刷新（onRunning 自己阻塞等待）
+    };
+
     /**
      * @brief 暂停 Worker 运行
      *
@@ -189,7 +208,21 @@ public:
      */
     State_t currentState()
     {
-        return _current_state;
+        return _current_state.load();
+    }
+
+    const ThreadInfo_t& getThreadInfo();
+    ThreadInfo_t& setThreadInfo();
+
+    /**
+     * @brief 是否运行在独立线程中
+     *
+     * @return true
+     * @return false
+     */
+    bool isThreaded()
+    {
+        return _thread != nullptr;
     }
 
     // 生命周期回调
@@ -209,7 +242,17 @@ public:
     void baseDestroy() override;
 
 private:
-    State_t _current_state = StateRunning;
+    struct Thread_t;
+
+    std::atomic<State_t> _current_state{StateRunning};
+    ThreadInfo_t _thread_info;
+    Thread_t* _thread = nullptr;
+
+    void update_state();
+    void start_thread();
+    void stop_thread();
+    void wake_thread();
+    static void thread_loop(WorkerAbility* self);
 };
 
 /* -------------------------------------------------------------------------- */
@@ -220,15 +263,34 @@ private:
  * @brief App Ability，在三段式的基础上扩展出打开、关闭状态，以及 App 信息（名称、图标等），适合有 App
  * 信息需求的多应用行为
  *
+ * App 信息里可以声明打开后要占用的内存预算。管理器设置了内存探针（AbilityManager::setMemoryProbe）时，
+ * 会在 onOpen/onClose 前后测量实际占用；打开前剩余内存不够预算，就先关掉允许被驱逐的后台 App 腾地方，
+ * 还不够则拒绝打开，回调 onOpenRefused()。预算和实测取大者
+ *
  */
 class AppAbility : public AbilityBase {
 public:
     virtual ~AppAbility() = default;
 
+    // 字节数，预算、实测占用、探针返回的剩余量都用它
+    struct MemoryInfo_t {
+        std::size_t lvglPool = 0;
+        std::size_t internal = 0;
+        std::size_t psram = 0;
+    };
+
+    struct MemoryStats_t {
+        MemoryInfo_t opened;   // 最近一次 onOpen 占用的
+        MemoryInfo_t retained; // 最近一次 open 到 close 之后没还回来的
+        uint32_t refusedNum = 0;
+    };
+
     struct AppInfo_t {
         std::string name;
         void* icon = nullptr;
         void* userData = nullptr;
+        MemoryInfo_t memoryBudget;
+        bool evictable = false; // 其他 App 打开时内存不够，允许管理器关掉它
     };
 
     enum State_t {
@@ -254,6 +316,16 @@ public:
     const AppInfo_t& getAppInfo();
     AppInfo_t& setAppInfo();
 
+    /**
+     * @brief 获取内存实测统计，没有设置内存探针时全为 0
+     *
+     * @return const MemoryStats_t&
+     */
+    const MemoryStats_t& getMemoryStats()
+    {
+        return _memory_stats;
+    }
+
     /**
      * @brief 获取当前生命周期状态
      *
@@ -271,6 +343,7 @@ public:
     virtual void onSleeping() {}
     virtual void onClose() {}
     virtual void onDestroy() {}
+    virtual void onOpenRefused() {} // 内存不够，这次 open() 作废，仍在睡眠状态
 
     AbilityType_t abilityType() override
     {
@@ -282,8 +355,15 @@ public:
     void baseDestroy() override;
 
 private:
+    friend class AbilityManager;
+
     State_t _current_state = StateSleeping;
     AppInfo_t _app_info;
+    MemoryStats_t _memory_stats;
+    MemoryInfo_t _free_before_open;
+    uint32_t _open_order = 0; // 越大越晚打开，驱逐时先关最早打开的
+
+    void refuse_open();
 };
 
 } // namespace mooncake
\ No newline at end of file
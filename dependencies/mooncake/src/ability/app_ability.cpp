@@ -59,6 +59,13 @@ void AppAbility::close()
     _current_state = StateGoClose;
 }
 
+void AppAbility::refuse_open()
+{
+    _current_state = StateSleeping;
+    _memory_stats.refusedNum++;
+    onOpenRefused();
+}
+
 const AppAbility::AppInfo_t& AppAbility::getAppInfo()
 {
     return _app_info;
@@ -9,21 +9,185 @@
  *
  */
 #include "ability.h"
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#else
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
 
 using namespace mooncake;
 
+/* -------------------------------------------------------------------------- */
+/*                                   Thread                                   */
+/* -------------------------------------------------------------------------- */
+// 独立线程运行时的平台相关部分：创建、带超时的等待唤醒、唤醒、等待退出
+
+static constexpr uint32_t _wait_forever = UINT32_MAX;
+
+#ifdef ESP_PLATFORM
+
+struct WorkerAbility::Thread_t {
+    std::atomic<bool> stop{false};
+    TaskHandle_t task = nullptr;
+    SemaphoreHandle_t exited = nullptr;
+
+    static void task_entry(void* param)
+    {
+        auto self = static_cast<WorkerAbility*>(param);
+        thread_loop(self);
+        xSemaphoreGive(self->_thread->exited);
+        vTaskDelete(nullptr);
+    }
+
+    bool start(WorkerAbility* self, const ThreadInfo_t& info)
+    {
+        exited = xSemaphoreCreateBinary();
+        if (exited == nullptr) {
+            return false;
+        }
+        BaseType_t core = info.coreId < 0 ? tskNO_AFFINITY : info.coreId;
+        if (xTaskCreatePinnedToCore(task_entry, info.name.c_str(), info.stackSize, self, info.priority, &task, core) !=
+            pdPASS) {
+            vSemaphoreDelete(exited);
+            exited = nullptr;
+            task = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    void wait(uint32_t timeoutMs)
+    {
+        ulTaskNotifyTake(pdTRUE, timeoutMs == _wait_forever ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs));
+    }
+
+    void wake()
+    {
+        xTaskNotifyGive(task);
+    }
+
+    void join()
+    {
+        xSemaphoreTake(exited, portMAX_DELAY);
+        vSemaphoreDelete(exited);
+        exited = nullptr;
+        task = nullptr;
+    }
+};
+
+#else
+
+struct WorkerAbility::Thread_t {
+    std::atomic<bool> stop{false};
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool woken = false;
+
+    bool start(WorkerAbility* self, const ThreadInfo_t&)
+    {
+        // 栈大小、优先级、核心绑定在这里不生效
+        thread = std::thread(thread_loop, self);
+        return true;
+    }
+
+    void wait(uint32_t timeoutMs)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (timeoutMs == _wait_forever) {
+            cv.wait(lock, [this] { return woken; });
+        } else {
+            cv.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] { return woken; });
+        }
+        woken = false;
+    }
+
+    void wake()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            woken = true;
+        }
+        cv.notify_one();
+    }
+
+    void join()
+    {
+        thread.join();
+    }
+};
+
+#endif
+
+/* -------------------------------------------------------------------------- */
+/*                               Worker Ability                               */
+/* -------------------------------------------------------------------------- */
+
+WorkerAbility::~WorkerAbility()
+{
+    // 没经过 baseDestroy 直接析构时，这里派生类已经析构，线程不能再回调，只能尽量收尾
+    stop_thread();
+}
+
 void WorkerAbility::baseCreate()
 {
     onCreate();
+    if (_thread_info.threaded) {
+        start_thread();
+    }
 }
 
 void WorkerAbility::baseUpdate()
+{
+    // 独立线程运行时由线程刷新
+    if (_thread) {
+        return;
+    }
+    update_state();
+}
+
+void WorkerAbility::baseDestroy()
+{
+    stop_thread();
+    onDestroy();
+}
+
+void WorkerAbility::pause()
+{
+    _current_state = StateGoPause;
+    wake_thread();
+}
+
+void WorkerAbility::resume()
+{
+    _current_state = StateGoResume;
+    wake_thread();
+}
+
+const WorkerAbility::ThreadInfo_t& WorkerAbility::getThreadInfo()
+{
+    return _thread_info;
+}
+
+WorkerAbility::ThreadInfo_t& WorkerAbility::setThreadInfo()
+{
+    return _thread_info;
+}
+
+void WorkerAbility::update_state()
 {
     /* ----------------------------------- 状态机 ---------------------------------- */
-    switch (_current_state) {
+    // 切换用 compare_exchange，回调期间其他线程的 pause()/resume() 不会被覆盖
+    State_t state = _current_state.load();
+    switch (state) {
         case StateGoResume: {
             onResume();
-            _current_state = StateRunning;
+            _current_state.compare_exchange_strong(state, StateRunning);
             break;
         }
         case StateRunning: {
@@ -32,7 +196,7 @@ void WorkerAbility::baseUpdate()
         }
         case StateGoPause: {
             onPause();
-            _current_state = StatePausing;
+            _current_state.compare_exchange_strong(state, StatePausing);
             break;
         }
         case StatePausing: {
@@ -44,17 +208,45 @@ void WorkerAbility::baseUpdate()
     }
 }
 
-void WorkerAbility::baseDestroy()
+void WorkerAbility::start_thread()
 {
-    onDestroy();
+    if (_thread) {
+        return;
+    }
+    _thread = new Thread_t;
+    if (!_thread->start(this, _thread_info)) {
+        // 创建失败就退回管理器轮询
+        delete _thread;
+        _thread = nullptr;
+    }
 }
 
-void WorkerAbility::pause()
+void WorkerAbility::stop_thread()
 {
-    _current_state = StateGoPause;
+    if (!_thread) {
+        return;
+    }
+    _thread->stop = true;
+    _thread->wake();
+    _thread->join();
+    delete _thread;
+    _thread = nullptr;
 }
 
-void WorkerAbility::resume()
+void WorkerAbility::wake_thread()
 {
-    _current_state = StateGoResume;
+    if (_thread) {
+        _thread->wake();
+    }
+}
+
+void WorkerAbility::thread_loop(WorkerAbility* self)
+{
+    Thread_t* thread = self->_thread;
+    while (!thread->stop) {
+        self->update_state();
+        // 暂停时一直阻塞到 resume()/destroy 唤醒
+        bool pausing = self->_current_state == StatePausing;
+        thread->wait(pausing ? _wait_forever : self->_thread_info.intervalMs);
+    }
 }
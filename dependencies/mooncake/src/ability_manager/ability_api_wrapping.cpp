@@ -149,3 +149,15 @@ AppAbility::State_t AbilityManager::getAppAbilityCurrentState(int abilityID)
     }
     return AppAbility::StateNull;
 }
+
+AppAbility::MemoryStats_t AbilityManager::getAppAbilityMemoryStats(int abilityID)
+{
+    auto ability_instance = getAbilityInstance(abilityID);
+    if (ability_instance) {
+        // 类型校验
+        if (ability_instance->abilityType() == AbilityType_App) {
+            return static_cast<AppAbility*>(ability_instance)->getMemoryStats();
+        }
+    }
+    return AppAbility::MemoryStats_t();
+}
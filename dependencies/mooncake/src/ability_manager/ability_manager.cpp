@@ -166,12 +166,12 @@ void AbilityManager::update_ability(std::vector<mooncake::AbilityManager::Abilit
             abilityIter->ability->baseCreate();
             // 切到正常刷新状态
             abilityIter->state = StateUpdating;
-            abilityIter->ability->baseUpdate();
+            base_update(abilityIter->ability.get());
             abilityIter++;
             break;
         }
         case StateUpdating: {
-            abilityIter->ability->baseUpdate();
+            base_update(abilityIter->ability.get());
             abilityIter++;
             break;
         }
@@ -190,3 +190,13 @@ void AbilityManager::update_ability(std::vector<mooncake::AbilityManager::Abilit
         }
     }
 }
+
+void AbilityManager::base_update(AbilityBase* ability)
+{
+    // 有内存探针时 App 走带测量的刷新
+    if (_memory_probe && ability->abilityType() == AbilityType_App) {
+        update_app_ability(static_cast<AppAbility*>(ability));
+        return;
+    }
+    ability->baseUpdate();
+}
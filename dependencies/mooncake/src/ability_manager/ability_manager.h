@@ -11,6 +11,7 @@
 #pragma once
 #include "../ability/ability.h"
 #include <cstddef>
+#include <functional>
 #include <vector>
 #include <memory>
 
@@ -104,6 +105,21 @@ public:
     bool closeAppAbility(int abilityID);
     AppAbility::AppInfo_t getAppAbilityAppInfo(int abilityID);
     AppAbility::State_t getAppAbilityCurrentState(int abilityID);
+    AppAbility::MemoryStats_t getAppAbilityMemoryStats(int abilityID);
+
+    /* -------------------------------------------------------------------------- */
+    /*                                App Memory                                  */
+    /* -------------------------------------------------------------------------- */
+    // 返回各内存池当前剩余字节数
+    using MemoryProbe_t = std::function<AppAbility::MemoryInfo_t()>;
+
+    /**
+     * @brief 设置内存探针。设置后 App 的 onOpen/onClose 前后会测量内存，打开前按预算检查剩余内存，
+     * 不够时按打开先后关掉 evictable 的其他 App，还不够就拒绝打开。传空关闭检查
+     *
+     * @param probe
+     */
+    void setMemoryProbe(MemoryProbe_t probe);
 
 protected:
     enum AbilityState_t {
@@ -123,8 +139,14 @@ protected:
     int _next_ability_id = 0;
     std::vector<int> _available_ability_id_list;
 
+    MemoryProbe_t _memory_probe;
+    uint32_t _next_open_order = 0;
+
     int get_next_ability_id();
     void update_ability(std::vector<mooncake::AbilityManager::AbilityInfo_t>::iterator& abilityIter);
+    void base_update(AbilityBase* ability);
+    void update_app_ability(AppAbility* app);
+    bool make_room_for_app(AppAbility* app);
 };
 
 } // namespace mooncake
@@ -0,0 +1,110 @@
+/**
+ * @file app_memory.cpp
+ * @author Forairaaaaa
+ * @brief
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "ability_manager.h"
+#include "ability/ability.h"
+#include <algorithm>
+#include <utility>
+
+using namespace mooncake;
+
+static std::size_t used_bytes(std::size_t freeBefore, std::size_t freeAfter)
+{
+    return freeBefore > freeAfter ? freeBefore - freeAfter : 0;
+}
+
+static AppAbility::MemoryInfo_t used_memory(const AppAbility::MemoryInfo_t& freeBefore,
+                                            const AppAbility::MemoryInfo_t& freeAfter)
+{
+    AppAbility::MemoryInfo_t used;
+    used.lvglPool = used_bytes(freeBefore.lvglPool, freeAfter.lvglPool);
+    used.internal = used_bytes(freeBefore.internal, freeAfter.internal);
+    used.psram = used_bytes(freeBefore.psram, freeAfter.psram);
+    return used;
+}
+
+static bool is_enough(const AppAbility::MemoryInfo_t& free, const AppAbility::MemoryInfo_t& need)
+{
+    return free.lvglPool >= need.lvglPool && free.internal >= need.internal && free.psram >= need.psram;
+}
+
+void AbilityManager::setMemoryProbe(MemoryProbe_t probe)
+{
+    _memory_probe = std::move(probe);
+}
+
+void AbilityManager::update_app_ability(AppAbility* app)
+{
+    switch (app->currentState()) {
+        case AppAbility::StateGoOpen: {
+            if (!make_room_for_app(app)) {
+                app->refuse_open();
+                break;
+            }
+            app->_free_before_open = _memory_probe();
+            app->baseUpdate();
+            app->_memory_stats.opened = used_memory(app->_free_before_open, _memory_probe());
+            app->_open_order = ++_next_open_order;
+            break;
+        }
+        case AppAbility::StateGoClose: {
+            app->baseUpdate();
+            // 和打开前比，关掉之后还少的就是没还回来的
+            app->_memory_stats.retained = used_memory(app->_free_before_open, _memory_probe());
+            break;
+        }
+        default: {
+            app->baseUpdate();
+            break;
+        }
+    }
+}
+
+bool AbilityManager::make_room_for_app(AppAbility* app)
+{
+    // 预算和上次实测取大者，预算写少了也不会一直超
+    const auto& budget = app->_app_info.memoryBudget;
+    const auto& measured = app->_memory_stats.opened;
+    AppAbility::MemoryInfo_t need;
+    need.lvglPool = std::max(budget.lvglPool, measured.lvglPool);
+    need.internal = std::max(budget.internal, measured.internal);
+    need.psram = std::max(budget.psram, measured.psram);
+
+    if (is_enough(_memory_probe(), need)) {
+        return true;
+    }
+
+    // 可驱逐的后台 App，最早打开的先关
+    std::vector<AppAbility*> candidates;
+    for (auto& ability_info : _ability_list) {
+        if (ability_info.state != StateUpdating || ability_info.ability.get() == app) {
+            continue;
+        }
+        if (ability_info.ability->abilityType() != AbilityType_App) {
+            continue;
+        }
+        auto other = static_cast<AppAbility*>(ability_info.ability.get());
+        if (other->_app_info.evictable && other->currentState() == AppAbility::StateRunning) {
+            candidates.push_back(other);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](AppAbility* a, AppAbility* b) { return a->_open_order < b->_open_order; });
+
+    // 立即走完关闭流程，onClose 释放的内存马上能算上
+    for (auto other : candidates) {
+        other->close();
+        update_app_ability(other);
+        if (is_enough(_memory_probe(), need)) {
+            return true;
+        }
+    }
+    return false;
+}
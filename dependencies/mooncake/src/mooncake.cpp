@@ -152,6 +152,19 @@ AppAbility::State_t Mooncake::getAppCurrentState(int appID)
     return get_app_ability_manager()->getAppAbilityCurrentState(appID);
 }
 
+AppAbility::MemoryStats_t Mooncake::getAppMemoryStats(int appID)
+{
+    if (!_app_ability_manager) {
+        return AppAbility::MemoryStats_t();
+    }
+    return get_app_ability_manager()->getAppAbilityMemoryStats(appID);
+}
+
+void Mooncake::setAppMemoryProbe(AbilityManager::MemoryProbe_t probe)
+{
+    get_app_ability_manager()->setMemoryProbe(std::move(probe));
+}
+
 /* -------------------------------------------------------------------------- */
 /*                          Extension Ability Manager                         */
 /* -------------------------------------------------------------------------- */
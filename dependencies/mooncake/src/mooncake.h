@@ -119,6 +119,21 @@ public:
      */
     AppAbility::State_t getAppCurrentState(int appID);
 
+    /**
+     * @brief 获取指定 ID 的 App 内存实测统计
+     *
+     * @param appID
+     * @return AppAbility::MemoryStats_t
+     */
+    AppAbility::MemoryStats_t getAppMemoryStats(int appID);
+
+    /**
+     * @brief 设置 App 管理器的内存探针，返回各内存池当前剩余字节数，详见 AbilityManager::setMemoryProbe
+     *
+     * @param probe
+     */
+    void setAppMemoryProbe(AbilityManager::MemoryProbe_t probe);
+
     /* -------------------------------------------------------------------------- */
     /*                          Extension Ability Manager                         */
     /* -------------------------------------------------------------------------- */
@@ -30,3 +30,4 @@ endif()
 enable_testing()
 add_test(basic example/basic)
 add_test(fmt_native example/fmt_native)
+add_test(trace example/trace)
@@ -0,0 +1,60 @@
+/**
+ * @file trace.cpp
+ * @brief
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <mooncake_log.h>
+#include <thread>
+#include <vector>
+
+int main()
+{
+    // 只存原始参数, flush 时才格式化
+    mclog::traceInfo("dsp", "block {} gain {:.2f} mute {} mode {}", 42, 0.5f, false, "low");
+    mclog::traceWarn("dsp", "overrun {:#x}", 0xBEEFu);
+    mclog::trace_flush();
+    // [11:45:14.114] [info] [dsp] block 42 gain 0.50 mute false mode low
+    // [11:45:14.114] [warn] [dsp] overrun 0xbeef
+
+    // 多线程写入, 满了就丢, 不会阻塞
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 4; t++) {
+        producers.emplace_back([t]() {
+            for (int i = 0; i < 32; i++) {
+                mclog::traceDebug("worker", "thread {} event {}", t, i);
+            }
+        });
+    }
+    for (auto& p : producers) {
+        p.join();
+    }
+
+    int printed = 0;
+    while (int n = mclog::trace_flush()) {
+        printed += n;
+    }
+    mclog::info("printed {} dropped {}", printed, mclog::trace_dropped());
+    // [11:45:14.114] [warn] trace ring full, 64 records dropped
+    // [11:45:14.114] [info] printed 64 dropped 64
+
+    // 导出原始记录, 不格式化 (如网络发送, 主机端解码)
+    int exported = 0;
+    mclog::set_trace_sink(
+        [](const mclog::TraceRecordView_t& record, void* user) {
+            bool ok = record.count == 2 && record.types[0] == mclog::internal::trace_arg_int &&
+                      record.values[0].i == -7 && record.values[1].d == 1.5;
+            *static_cast<int*>(user) += ok ? 1 : 100;
+        },
+        &exported);
+    mclog::traceInfo("dsp", "delta {} ratio {}", -7, 1.5);
+    mclog::trace_flush();
+    mclog::set_trace_sink(nullptr);
+    mclog::info("exported {}", exported);
+    // [11:45:14.114] [info] exported 1
+
+    return printed + static_cast<int>(mclog::trace_dropped()) == 4 * 32 && exported == 1 ? 0 : 1;
+}
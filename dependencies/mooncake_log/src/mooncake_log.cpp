@@ -9,9 +9,11 @@
  *
  */
 #include "mooncake_log.h"
+#include <atomic>
 #include <chrono>
 #include <ctime>
 #include <functional>
+#include <mutex>
 #include <vector>
 
 #define COLOR_INFO  fg(fmt::terminal_color::green)
@@ -26,13 +28,8 @@ void mclog::set_time_tag_enable(bool enable)
     _enable_time_tag = enable;
 }
 
-void mclog::internal::printf_tag_time()
+static void printf_tag_time_at(std::chrono::system_clock::time_point now)
 {
-    if (!_enable_time_tag) {
-        return;
-    }
-
-    auto now = std::chrono::system_clock::now();
     auto now_c = std::chrono::system_clock::to_time_t(now);
     auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
 
@@ -46,6 +43,15 @@ void mclog::internal::printf_tag_time()
                milliseconds.count());                  // 毫秒
 }
 
+void mclog::internal::printf_tag_time()
+{
+    if (!_enable_time_tag) {
+        return;
+    }
+
+    printf_tag_time_at(std::chrono::system_clock::now());
+}
+
 void mclog::internal::print_tag_info()
 {
     fmt::print("[");
@@ -74,6 +80,183 @@ void mclog::internal::print_tag_debug()
     fmt::print("] ");
 }
 
+/* -------------------------------------------------------------------------- */
+/*                                    Trace                                   */
+/* -------------------------------------------------------------------------- */
+static_assert((MOONCAKE_LOG_TRACE_CAPACITY & (MOONCAKE_LOG_TRACE_CAPACITY - 1)) == 0,
+              "MOONCAKE_LOG_TRACE_CAPACITY must be a power of two");
+
+struct TraceRecord_t {
+    // Bounded MPSC ring, seq holds the lap: a slot is free for ticket n when seq == lap(n), holds
+    // its record when seq == lap(n) + 1. Zero is the free state of the first lap, so the static
+    // ring needs no init
+    std::atomic<uint32_t> seq;
+    uint8_t level;
+    uint8_t count;
+    uint8_t types[mclog::internal::trace_max_args];
+    const char* tag;
+    const char* format;
+    uint32_t format_size;
+    int64_t time_us;
+    mclog::internal::TraceValue_t values[mclog::internal::trace_max_args];
+};
+
+static TraceRecord_t _trace_ring[MOONCAKE_LOG_TRACE_CAPACITY];
+static std::atomic<uint32_t> _trace_head{0}; // Next ticket for producers
+static uint32_t _trace_tail = 0;             // Next ticket for the consumer, under _trace_flush_mutex
+static std::atomic<uint32_t> _trace_dropped{0};
+static uint32_t _trace_dropped_reported = 0;
+static std::mutex _trace_flush_mutex;
+static mclog::TraceSink_t _trace_sink = nullptr; // Under _trace_flush_mutex
+static void* _trace_sink_user = nullptr;
+
+static inline uint32_t trace_lap(uint32_t ticket)
+{
+    return ticket & ~static_cast<uint32_t>(MOONCAKE_LOG_TRACE_CAPACITY - 1);
+}
+
+bool mclog::internal::trace_push(LogLevel_t level, const char* tag, fmt::string_view format, const TraceArg_t* args,
+                                 int count)
+{
+    uint32_t ticket = _trace_head.load(std::memory_order_relaxed);
+    TraceRecord_t* record;
+    while (true) {
+        record = &_trace_ring[ticket & (MOONCAKE_LOG_TRACE_CAPACITY - 1)];
+        int32_t diff = static_cast<int32_t>(record->seq.load(std::memory_order_acquire) - trace_lap(ticket));
+        if (diff == 0) {
+            if (_trace_head.compare_exchange_weak(ticket, ticket + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Full: drop the new record rather than block a hot path
+            _trace_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            ticket = _trace_head.load(std::memory_order_relaxed);
+        }
+    }
+
+    record->level = static_cast<uint8_t>(level);
+    record->count = static_cast<uint8_t>(count);
+    record->tag = tag;
+    record->format = format.data();
+    record->format_size = static_cast<uint32_t>(format.size());
+    record->time_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    for (int i = 0; i < count; i++) {
+        record->types[i] = args[i].type;
+        record->values[i] = args[i].value;
+    }
+
+    record->seq.store(trace_lap(ticket) + 1, std::memory_order_release);
+    return true;
+}
+
+static void print_trace_record(const TraceRecord_t& record)
+{
+    fmt::format_context::format_arg args[mclog::internal::trace_max_args];
+    for (int i = 0; i < record.count; i++) {
+        const mclog::internal::TraceValue_t& v = record.values[i];
+        switch (record.types[i]) {
+            case mclog::internal::trace_arg_bool:
+                args[i] = fmt::detail::make_arg<fmt::format_context>(v.b);
+                break;
+            case mclog::internal::trace_arg_char:
+                args[i] = fmt::detail::make_arg<fmt::format_context>(v.c);
+                break;
+            case mclog::internal::trace_arg_int:
+                args[i] = fmt::detail::make_arg<fmt::format_context>(v.i);
+                break;
+            case mclog::internal::trace_arg_uint:
+                args[i] = fmt::detail::make_arg<fmt::format_context>(v.u);
+                break;
+            case mclog::internal::trace_arg_double:
+                args[i] = fmt::detail::make_arg<fmt::format_context>(v.d);
+                break;
+            default:
+                args[i] = fmt::detail::make_arg<fmt::format_context>(v.s);
+                break;
+        }
+    }
+    std::string msg = fmt::vformat(fmt::string_view(record.format, record.format_size),
+                                   fmt::format_args(args, record.count));
+
+    auto level = static_cast<mclog::LogLevel_t>(record.level);
+    if (_enable_time_tag) {
+        printf_tag_time_at(std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::microseconds(record.time_us))));
+    }
+    switch (level) {
+        case mclog::level_warn:
+            mclog::internal::print_tag_warn();
+            break;
+        case mclog::level_error:
+            mclog::internal::print_tag_error();
+            break;
+        case mclog::level_debug:
+            mclog::internal::print_tag_debug();
+            break;
+        default:
+            mclog::internal::print_tag_info();
+            break;
+    }
+    fmt::print("[{}] ", record.tag);
+    fmt::println("{}", msg);
+
+    if (mclog::internal::is_on_log_callback_exist()) {
+        mclog::internal::invoke_on_log_callbacks(level, std::move(msg));
+    }
+}
+
+int mclog::trace_flush(int maxRecords)
+{
+    std::lock_guard<std::mutex> lock(_trace_flush_mutex);
+
+    int printed = 0;
+    while (printed < maxRecords) {
+        TraceRecord_t& record = _trace_ring[_trace_tail & (MOONCAKE_LOG_TRACE_CAPACITY - 1)];
+        if (record.seq.load(std::memory_order_acquire) != trace_lap(_trace_tail) + 1) {
+            break; // Empty, or the producer holding this slot has not finished yet
+        }
+        if (_trace_sink) {
+            mclog::TraceRecordView_t view;
+            view.level = static_cast<mclog::LogLevel_t>(record.level);
+            view.time_us = record.time_us;
+            view.tag = record.tag;
+            view.format = fmt::string_view(record.format, record.format_size);
+            view.count = record.count;
+            view.types = record.types;
+            view.values = record.values;
+            _trace_sink(view, _trace_sink_user);
+        } else {
+            print_trace_record(record);
+        }
+        record.seq.store(trace_lap(_trace_tail) + MOONCAKE_LOG_TRACE_CAPACITY, std::memory_order_release);
+        _trace_tail++;
+        printed++;
+    }
+
+    uint32_t dropped = _trace_dropped.load(std::memory_order_relaxed);
+    if (dropped != _trace_dropped_reported) {
+        mclog::warn("trace ring full, {} records dropped", dropped - _trace_dropped_reported);
+        _trace_dropped_reported = dropped;
+    }
+    return printed;
+}
+
+void mclog::set_trace_sink(TraceSink_t sink, void* user)
+{
+    std::lock_guard<std::mutex> lock(_trace_flush_mutex);
+    _trace_sink = sink;
+    _trace_sink_user = user;
+}
+
+uint32_t mclog::trace_dropped()
+{
+    return _trace_dropped.load(std::memory_order_relaxed);
+}
+
 /* -------------------------------------------------------------------------- */
 /*                                  Callbacks                                 */
 /* -------------------------------------------------------------------------- */
@@ -16,6 +16,8 @@
 #include "fmt/chrono.h"
 #include <utility>
 #include <functional>
+#include <cstdint>
+#include <type_traits>
 
 namespace mclog {
 
@@ -34,6 +36,75 @@ void print_tag_error();
 void print_tag_debug();
 bool is_on_log_callback_exist();
 void invoke_on_log_callbacks(LogLevel_t level, std::string msg);
+
+/* ------------------------------- Trace record ------------------------------ */
+#ifndef MOONCAKE_LOG_TRACE_CAPACITY
+#define MOONCAKE_LOG_TRACE_CAPACITY 64 // Records, must be a power of two
+#endif
+static constexpr int trace_max_args = 16;
+
+enum TraceArgType_t : uint8_t {
+    trace_arg_bool = 0,
+    trace_arg_char,
+    trace_arg_int,
+    trace_arg_uint,
+    trace_arg_double,
+    trace_arg_cstr,
+};
+
+union TraceValue_t {
+    bool b;
+    char c;
+    int64_t i;
+    uint64_t u;
+    double d;
+    const char* s;
+};
+
+struct TraceArg_t {
+    TraceArgType_t type;
+    TraceValue_t value;
+};
+
+template <typename T>
+inline TraceArg_t make_trace_arg(T value)
+{
+    using V = std::decay_t<T>;
+    TraceArg_t arg;
+    if constexpr (std::is_same_v<V, bool>) {
+        arg.type = trace_arg_bool;
+        arg.value.b = value;
+    } else if constexpr (std::is_same_v<V, char>) {
+        arg.type = trace_arg_char;
+        arg.value.c = value;
+    } else if constexpr (std::is_integral_v<V> && std::is_signed_v<V>) {
+        arg.type = trace_arg_int;
+        arg.value.i = value;
+    } else if constexpr (std::is_integral_v<V>) {
+        arg.type = trace_arg_uint;
+        arg.value.u = value;
+    } else if constexpr (std::is_floating_point_v<V>) {
+        arg.type = trace_arg_double;
+        arg.value.d = value;
+    } else {
+        static_assert(std::is_convertible_v<V, const char*>,
+                      "trace arguments must be arithmetic or string literals, format anything else up front");
+        arg.type = trace_arg_cstr;
+        arg.value.s = value;
+    }
+    return arg;
+}
+
+// Copy one record into the ring, false if it was full and the record dropped
+bool trace_push(LogLevel_t level, const char* tag, fmt::string_view format, const TraceArg_t* args, int count);
+
+template <typename... Args>
+inline void trace(LogLevel_t level, const char* tag, fmt::string_view format, Args&&... args)
+{
+    static_assert(sizeof...(Args) <= trace_max_args, "too many trace arguments");
+    const TraceArg_t packed[sizeof...(Args) > 0 ? sizeof...(Args) : 1] = {make_trace_arg(args)...};
+    trace_push(level, tag, format, packed, sizeof...(Args));
+}
 } // namespace internal
 
 /* -------------------------------------------------------------------------- */
@@ -196,6 +267,112 @@ void tagDebug(const std::string& customTag, fmt::format_string<Args...> fmt, Arg
     }
 }
 
+/* -------------------------------------------------------------------------- */
+/*                                    Trace                                   */
+/* -------------------------------------------------------------------------- */
+/*
+ * Binary trace for hot paths: the traceXxx() calls only copy the raw arguments
+ * into a lock-free ring, formatting and printing happen later in trace_flush(),
+ * on whatever task calls it. The format string is checked at compile time like
+ * the normal log calls, but the tag, the format and any string argument are
+ * kept by pointer, so they must be literals or otherwise outlive the flush.
+ */
+
+/**
+ * @brief Trace info with a custom tag, formatted on the next trace_flush()
+ *
+ * @tparam Args
+ * @param customTag
+ * @param fmt
+ * @param args
+ */
+template <typename... Args>
+void traceInfo(const char* customTag, fmt::format_string<Args...> fmt, Args&&... args)
+{
+    internal::trace(level_info, customTag, fmt.get(), std::forward<Args>(args)...);
+}
+
+/**
+ * @brief Trace warning with a custom tag, formatted on the next trace_flush()
+ *
+ * @tparam Args
+ * @param customTag
+ * @param fmt
+ * @param args
+ */
+template <typename... Args>
+void traceWarn(const char* customTag, fmt::format_string<Args...> fmt, Args&&... args)
+{
+    internal::trace(level_warn, customTag, fmt.get(), std::forward<Args>(args)...);
+}
+
+/**
+ * @brief Trace error with a custom tag, formatted on the next trace_flush()
+ *
+ * @tparam Args
+ * @param customTag
+ * @param fmt
+ * @param args
+ */
+template <typename... Args>
+void traceError(const char* customTag, fmt::format_string<Args...> fmt, Args&&... args)
+{
+    internal::trace(level_error, customTag, fmt.get(), std::forward<Args>(args)...);
+}
+
+/**
+ * @brief Trace debug with a custom tag, formatted on the next trace_flush()
+ *
+ * @tparam Args
+ * @param customTag
+ * @param fmt
+ * @param args
+ */
+template <typename... Args>
+void traceDebug(const char* customTag, fmt::format_string<Args...> fmt, Args&&... args)
+{
+    internal::trace(level_debug, customTag, fmt.get(), std::forward<Args>(args)...);
+}
+
+/**
+ * @brief Format and print pending trace records through the normal log output and callbacks
+ *
+ * @param maxRecords
+ * @return int records printed
+ */
+int trace_flush(int maxRecords = MOONCAKE_LOG_TRACE_CAPACITY);
+
+/**
+ * @brief Records dropped because the ring was full, since boot
+ *
+ * @return uint32_t
+ */
+uint32_t trace_dropped();
+
+/**
+ * @brief A trace record as stored, for exporting it without formatting
+ */
+struct TraceRecordView_t {
+    LogLevel_t level;
+    int64_t time_us;
+    const char* tag;
+    fmt::string_view format;
+    int count;
+    const uint8_t* types;                 // internal::TraceArgType_t per argument
+    const internal::TraceValue_t* values; // Strings by pointer, like tag and format
+};
+
+typedef void (*TraceSink_t)(const TraceRecordView_t& record, void* user);
+
+/**
+ * @brief Hand trace records to sink instead of formatting them: trace_flush() then passes each
+ * record over raw, on the flushing task. nullptr goes back to printing
+ *
+ * @param sink
+ * @param user
+ */
+void set_trace_sink(TraceSink_t sink, void* user = nullptr);
+
 /* -------------------------------------------------------------------------- */
 /*                                  Callbacks                                 */
 /* -------------------------------------------------------------------------- */
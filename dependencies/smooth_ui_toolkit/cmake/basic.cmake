@@ -33,4 +33,8 @@ if(SMOOTH_UI_TOOLKIT_BUILD_TEST)
     add_subdirectory(./test/)
     enable_testing()
     add_test(ringbuffer test/ringbuffer_test)
+    add_test(queued_signal test/queued_signal_test)
+    add_test(spsc_ring_buffer test/spsc_ring_buffer_test)
+    add_test(animate_ticker test/animate_ticker_test)
+    add_test(fixed_math test/fixed_math_test)
 endif()
\ No newline at end of file
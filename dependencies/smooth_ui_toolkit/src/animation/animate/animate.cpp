@@ -14,6 +14,11 @@
 
 using namespace smooth_ui_toolkit;
 
+Animate::~Animate()
+{
+    setTicker(nullptr);
+}
+
 EasingOptions_t& Animate::easingOptions()
 {
     animationType = animation_type::easing;
@@ -42,16 +47,17 @@ void Animate::play()
 
     // If paused, add pause time to start time, resume animation
     if (_playing_state == animate_playing_state::paused) {
-        _start_time += ui_hal::get_tick_s() - _pause_time;
+        _start_time += now() - _pause_time;
     }
     // If not, reset repeat count and start time, start animation
     else {
         _repeat_count = repeat;
-        _start_time = ui_hal::get_tick_s();
+        _start_time = now();
     }
 
     _playing_state = animate_playing_state::playing;
     get_key_frame_generator().done = false;
+    wake_ticker();
 }
 
 void Animate::pause()
@@ -59,7 +65,7 @@ void Animate::pause()
     if (_playing_state == animate_playing_state::playing) {
         _playing_state = animate_playing_state::paused;
         _orchestration_state = animate_orchestration_state::on_delay;
-        _pause_time = ui_hal::get_tick_s();
+        _pause_time = now();
     }
 }
 
@@ -72,6 +78,7 @@ void Animate::complete()
     _orchestration_state = animate_orchestration_state::on_delay;
     get_key_frame_generator().done = false;
     get_key_frame_generator().value = end;
+    wake_ticker();
 }
 
 void Animate::cancel()
@@ -83,6 +90,7 @@ void Animate::cancel()
     _orchestration_state = animate_orchestration_state::on_delay;
     get_key_frame_generator().done = false;
     get_key_frame_generator().value = start;
+    wake_ticker();
 }
 
 void Animate::retarget(const float& start, const float& end)
@@ -118,7 +126,7 @@ void Animate::update_playing_state_fsm()
     }
 
     // Update key frame
-    get_key_frame_generator().next(ui_hal::get_tick_s() - _start_time);
+    get_key_frame_generator().next(now() - _start_time);
     if (_on_update) {
         _on_update(value());
     }
@@ -142,9 +150,9 @@ void Animate::update_orchestration_state_fsm()
                 _on_update(value());
             }
             // Check delay timeout
-            if (ui_hal::get_tick_s() - _start_time >= delay) {
+            if (now() - _start_time >= delay) {
                 _orchestration_state = animate_orchestration_state::on_playing;
-                _start_time = ui_hal::get_tick_s();
+                _start_time = now();
             }
         }
     }
@@ -158,14 +166,14 @@ void Animate::update_orchestration_state_fsm()
                 _repeat_count--;
             }
             _orchestration_state = animate_orchestration_state::on_repeat_delay;
-            _start_time = ui_hal::get_tick_s();
+            _start_time = now();
         }
     }
 
     // Handle on repeat delay
     else {
         // Check repeat delay timeout
-        if (ui_hal::get_tick_s() - _start_time >= repeatDelay) {
+        if (now() - _start_time >= repeatDelay) {
             // Reset animation
             if (repeatType == animate_repeat_type::reverse) {
                 std::swap(start, end);
@@ -173,7 +181,7 @@ void Animate::update_orchestration_state_fsm()
             init();
             _playing_state = animate_playing_state::playing;
             _orchestration_state = animate_orchestration_state::on_delay;
-            _start_time = ui_hal::get_tick_s();
+            _start_time = now();
         }
     }
 }
@@ -195,3 +203,43 @@ KeyFrameGenerator& Animate::get_key_frame_generator()
     }
     return *_key_frame_generator;
 }
+
+void Animate::setTicker(AnimateTicker* ticker)
+{
+    if (_ticker_link.ticker == ticker) {
+        return;
+    }
+    if (_ticker_link.ticker) {
+        _ticker_link.ticker->detach(this);
+    }
+    if (ticker) {
+        ticker->attach(this);
+    }
+}
+
+float Animate::now()
+{
+    if (_ticker_link.ticker) {
+        return _ticker_link.ticker->frameTime();
+    }
+    return ui_hal::get_tick_s();
+}
+
+void Animate::wake_ticker()
+{
+    if (_ticker_link.ticker) {
+        _ticker_link.ticker->wake(this);
+    }
+}
+
+// Nothing left to do until play(), retarget(), complete() or cancel()
+bool Animate::is_settled()
+{
+    if (_playing_state == animate_playing_state::idle || _playing_state == animate_playing_state::paused) {
+        return true;
+    }
+    if (_playing_state == animate_playing_state::completed || _playing_state == animate_playing_state::cancelled) {
+        return done() && _orchestration_state == animate_orchestration_state::on_playing;
+    }
+    return false;
+}
@@ -12,6 +12,7 @@
 #include "../generators/generators.h"
 #include "../generators/spring/spring.h"
 #include "../generators/easing/easing.h"
+#include "../ticker/animate_ticker.h"
 #include <functional>
 #include <memory>
 // 参数参考：https://motion.dev/docs/animate#options
@@ -46,7 +47,7 @@ enum State_t {
 class Animate {
 public:
     Animate() {}
-    virtual ~Animate() {}
+    virtual ~Animate();
 
     // Start value
     float start = 0.0f;
@@ -149,7 +150,35 @@ public:
         return _playing_state;
     }
 
+    /**
+     * @brief Let a ticker update this animation instead of calling update() yourself, nullptr to detach. The
+     * animation must not move in memory while attached
+     *
+     * @param ticker
+     */
+    void setTicker(AnimateTicker* ticker);
+
+    inline AnimateTicker* ticker()
+    {
+        return _ticker_link.ticker;
+    }
+
 protected:
+    friend class AnimateTicker;
+
+    // Ticker membership, not carried over by copies
+    struct TickerLink_t {
+        AnimateTicker* ticker = nullptr;
+        int slot = -1; // Index in the ticker's awake list, -1 asleep
+        TickerLink_t() = default;
+        TickerLink_t(const TickerLink_t&) {}
+        TickerLink_t& operator=(const TickerLink_t&)
+        {
+            return *this;
+        }
+    };
+    TickerLink_t _ticker_link;
+
     std::function<void(const float&)> _on_update;
     std::function<void()> _on_complete;
     std::shared_ptr<KeyFrameGenerator> _key_frame_generator;
@@ -162,6 +191,9 @@ protected:
 
     void update_playing_state_fsm();
     void update_orchestration_state_fsm();
+    float now();
+    void wake_ticker();
+    bool is_settled();
 };
 
 } // namespace smooth_ui_toolkit
@@ -86,7 +86,10 @@ float AnimateValue::value()
     if (!_is_begin) {
         return _default_value;
     }
-    update();
+    // With a ticker attached it does the updating, once per frame
+    if (!ticker()) {
+        update();
+    }
     return get_key_frame_generator().value;
 }
 
@@ -0,0 +1,109 @@
+/**
+ * @file animate_ticker.cpp
+ * @author Forairaaaaa
+ * @brief
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "animate_ticker.h"
+#include "../animate/animate.h"
+#include "utils/hal/hal.h"
+
+using namespace smooth_ui_toolkit;
+
+AnimateTicker& AnimateTicker::shared()
+{
+    static AnimateTicker instance;
+    return instance;
+}
+
+AnimateTicker::~AnimateTicker()
+{
+    // Animations that outlive the ticker fall back to updating themselves; sleeping ones aren't reachable from here,
+    // so a ticker must outlive what it drives
+    for (auto animate : _awake) {
+        if (animate) {
+            animate->_ticker_link.ticker = nullptr;
+            animate->_ticker_link.slot = -1;
+        }
+    }
+}
+
+void AnimateTicker::tick()
+{
+    _frame_time = ui_hal::get_tick_s();
+    _ticking = true;
+
+    // By index: callbacks may wake (append) or detach (clear a slot) animations mid pass
+    for (std::size_t i = 0; i < _awake.size(); i++) {
+        Animate* animate = _awake[i];
+        if (!animate) {
+            continue;
+        }
+        animate->update();
+        if (_awake[i] == animate && animate->is_settled()) {
+            _awake[i] = nullptr;
+            animate->_ticker_link.slot = -1;
+            _awake_num--;
+        }
+    }
+
+    _ticking = false;
+    compact();
+}
+
+float AnimateTicker::frameTime()
+{
+    return _ticking ? _frame_time : ui_hal::get_tick_s();
+}
+
+void AnimateTicker::attach(Animate* animate)
+{
+    animate->_ticker_link.ticker = this;
+    animate->_ticker_link.slot = -1;
+    _animation_num++;
+    wake(animate);
+}
+
+void AnimateTicker::detach(Animate* animate)
+{
+    int slot = animate->_ticker_link.slot;
+    if (slot >= 0) {
+        _awake[slot] = nullptr;
+        _awake_num--;
+        if (!_ticking) {
+            compact();
+        }
+    }
+    animate->_ticker_link.ticker = nullptr;
+    animate->_ticker_link.slot = -1;
+    _animation_num--;
+}
+
+void AnimateTicker::wake(Animate* animate)
+{
+    if (animate->_ticker_link.slot >= 0) {
+        return;
+    }
+    animate->_ticker_link.slot = static_cast<int>(_awake.size());
+    _awake.push_back(animate);
+    _awake_num++;
+}
+
+void AnimateTicker::compact()
+{
+    if (_awake_num == _awake.size()) {
+        return;
+    }
+    std::size_t next = 0;
+    for (auto animate : _awake) {
+        if (animate) {
+            animate->_ticker_link.slot = static_cast<int>(next);
+            _awake[next++] = animate;
+        }
+    }
+    _awake.resize(next);
+}
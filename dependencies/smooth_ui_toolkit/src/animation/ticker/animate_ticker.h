@@ -0,0 +1,84 @@
+/**
+ * @file animate_ticker.h
+ * @author Forairaaaaa
+ * @brief
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace smooth_ui_toolkit {
+
+class Animate;
+
+/**
+ * @brief Updates every attached animation in one pass per frame
+ *
+ * Call tick() once per UI frame. The frame's time is sampled once and every animation in the pass sees the same
+ * value. The ticker only walks a dense array of the awake ones. An animation that has settled goes to sleep after its
+ * update: idle or paused, or it has completed or been cancelled with no repeat pending. It costs nothing until play(),
+ * retarget(), complete() or cancel() wakes it, and since its update callback isn't called while asleep it stops
+ * invalidating whatever it drives.
+ *
+ * Attach with Animate::setTicker(). An attached animation is updated only by the ticker, and AnimateValue::value()
+ * just reads. Attached animations must stay put in memory: a copy or move starts out detached.
+ * Single threaded, like the animations themselves.
+ */
+class AnimateTicker {
+public:
+    /**
+     * @brief The ticker shared by the whole UI
+     *
+     * @return AnimateTicker&
+     */
+    static AnimateTicker& shared();
+
+    AnimateTicker() = default;
+    ~AnimateTicker();
+    AnimateTicker(const AnimateTicker&) = delete;
+    AnimateTicker& operator=(const AnimateTicker&) = delete;
+
+    /**
+     * @brief Update all awake animations, callbacks are invoked in this method
+     *
+     */
+    void tick();
+
+    /**
+     * @brief Time of the current tick() in seconds, or now outside of one
+     *
+     * @return float
+     */
+    float frameTime();
+
+    std::size_t animationNum()
+    {
+        return _animation_num;
+    }
+    std::size_t awakeNum()
+    {
+        return _awake_num;
+    }
+
+private:
+    friend class Animate;
+
+    void attach(Animate* animate);
+    void detach(Animate* animate);
+    void wake(Animate* animate);
+    void compact();
+
+    // Awake animations, dense. Slots emptied during a tick() are nullptr until it compacts
+    std::vector<Animate*> _awake;
+    std::size_t _animation_num = 0;
+    std::size_t _awake_num = 0;
+    bool _ticking = false;
+    float _frame_time = 0.0f;
+};
+
+} // namespace smooth_ui_toolkit
@@ -12,10 +12,14 @@
 #include "animation/animate/animate.h"
 #include "animation/animate_value/animate_value.h"
 #include "animation/sequence/animate_sequence.h"
+#include "animation/ticker/animate_ticker.h"
 #include "utils/easing/cubic_bezier/cubic_bezier.h"
 #include "utils/easing/ease.h"
 #include "utils/event/event_queue.h"
+#include "utils/event/queued_signal.h"
 #include "utils/event/signal.h"
 #include "utils/hal/hal.h"
 #include "utils/ring_buffer/ring_buffer.h"
+#include "utils/ring_buffer/spsc_ring_buffer.h"
 #include "utils/color/color.h"
+#include "utils/fixed_math/fixed_math.h"
@@ -0,0 +1,159 @@
+/**
+ * @file queued_signal.h
+ * @author Forairaaaaa
+ * @brief
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
+namespace smooth_ui_toolkit {
+
+/**
+ * @brief Signal that crosses threads: emit() queues, dispatch() calls the slots on the subscriber's thread
+ *
+ * Any number of threads (or ISRs) may emit(); one thread dispatch()es, typically from its UI tick, and that thread
+ * alone connects and disconnects slots. The queue is a fixed ring of Capacity events inside the object (bounded
+ * MPMC ring with per-cell sequence numbers, used single consumer), so emit() never allocates, never locks and
+ * never runs a slot. When the ring is full the event is dropped, counted, and emit() returns false.
+ *
+ * A producer preempted between claiming a cell and publishing it holds back the events behind it until it runs
+ * again; dispatch() simply finds the queue empty at that point and picks them up next time.
+ *
+ * @tparam T Event type, trivially copyable (a small POD)
+ * @tparam Capacity Ring size, a power of two
+ * @tparam MaxSlots Slots that can be connected at once
+ */
+template <typename T, size_t Capacity = 32, size_t MaxSlots = 4>
+class QueuedSignal {
+    static_assert(std::is_trivially_copyable<T>::value, "QueuedSignal events must be trivially copyable");
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "QueuedSignal capacity must be a power of two");
+
+public:
+    using SlotType = std::function<void(const T&)>;
+
+    QueuedSignal()
+    {
+        for (size_t i = 0; i < Capacity; i++) {
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    QueuedSignal(const QueuedSignal&) = delete;
+    QueuedSignal& operator=(const QueuedSignal&) = delete;
+
+    // Any thread
+    bool emit(const T& event)
+    {
+        size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &_cells[pos & (Capacity - 1)];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = _enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->event = event;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Events dropped on a full queue, since construction
+    uint32_t dropped() const
+    {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+    /* ------------------------------ Subscriber thread ----------------------------- */
+
+    // Returns a slot id for disconnect(), -1 when all MaxSlots are taken
+    int connect(const SlotType& slot)
+    {
+        for (size_t i = 0; i < MaxSlots; i++) {
+            if (!_slots[i]) {
+                _slots[i] = slot;
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    void disconnect(int slotId)
+    {
+        if (slotId >= 0 && static_cast<size_t>(slotId) < MaxSlots) {
+            _slots[slotId] = nullptr;
+        }
+    }
+
+    void clear()
+    {
+        for (auto& slot : _slots) {
+            slot = nullptr;
+        }
+    }
+
+    bool empty() const
+    {
+        const Cell& cell = _cells[_dequeue_pos & (Capacity - 1)];
+        return cell.sequence.load(std::memory_order_acquire) != _dequeue_pos + 1;
+    }
+
+    // Calls every slot for up to maxEvents queued events, oldest first; returns how many were taken
+    size_t dispatch(size_t maxEvents = Capacity)
+    {
+        size_t count = 0;
+        T event;
+        while (count < maxEvents && pop(event)) {
+            for (auto& slot : _slots) {
+                if (slot) {
+                    slot(event);
+                }
+            }
+            count++;
+        }
+        return count;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T event;
+    };
+
+    bool pop(T& event)
+    {
+        Cell& cell = _cells[_dequeue_pos & (Capacity - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) != _dequeue_pos + 1) {
+            return false;
+        }
+        event = cell.event;
+        cell.sequence.store(_dequeue_pos + Capacity, std::memory_order_release);
+        _dequeue_pos++;
+        return true;
+    }
+
+    std::array<Cell, Capacity> _cells;
+    std::atomic<size_t> _enqueue_pos{0};
+    size_t _dequeue_pos = 0;
+    std::atomic<uint32_t> _dropped{0};
+    std::array<SlotType, MaxSlots> _slots;
+};
+
+} // namespace smooth_ui_toolkit
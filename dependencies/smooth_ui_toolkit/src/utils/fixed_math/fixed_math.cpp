@@ -0,0 +1,293 @@
+/**
+ * @file fixed_math.cpp
+ * @author Forairaaaaa
+ * @brief
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "fixed_math.h"
+#include "../fpm/math.hpp"
+
+using namespace smooth_ui_toolkit;
+using fixed_math::fixed_t;
+
+// log2(1 + i/256) and 2^(i/256), Q16
+static const int32_t _log2_table[257] = {
+    0, 369, 736, 1102, 1466, 1829, 2190, 2551,
+    2909, 3267, 3623, 3978, 4331, 4683, 5034, 5384,
+    5732, 6079, 6425, 6769, 7112, 7454, 7795, 8134,
+    8473, 8810, 9146, 9480, 9814, 10146, 10477, 10807,
+    11136, 11464, 11791, 12116, 12440, 12764, 13086, 13407,
+    13727, 14046, 14363, 14680, 14996, 15310, 15624, 15937,
+    16248, 16559, 16868, 17177, 17484, 17791, 18096, 18401,
+    18704, 19007, 19308, 19609, 19909, 20207, 20505, 20802,
+    21098, 21393, 21687, 21980, 22272, 22564, 22854, 23144,
+    23433, 23720, 24007, 24293, 24579, 24863, 25146, 25429,
+    25711, 25992, 26272, 26551, 26830, 27108, 27384, 27660,
+    27936, 28210, 28484, 28757, 29029, 29300, 29571, 29840,
+    30109, 30378, 30645, 30912, 31178, 31443, 31707, 31971,
+    32234, 32496, 32758, 33019, 33279, 33538, 33797, 34055,
+    34312, 34569, 34825, 35080, 35334, 35588, 35841, 36094,
+    36346, 36597, 36847, 37097, 37346, 37595, 37842, 38090,
+    38336, 38582, 38827, 39072, 39316, 39559, 39802, 40044,
+    40286, 40527, 40767, 41006, 41246, 41484, 41722, 41959,
+    42196, 42432, 42667, 42902, 43137, 43370, 43603, 43836,
+    44068, 44300, 44530, 44761, 44990, 45220, 45448, 45676,
+    45904, 46131, 46357, 46583, 46809, 47034, 47258, 47482,
+    47705, 47928, 48150, 48372, 48593, 48813, 49034, 49253,
+    49472, 49691, 49909, 50127, 50344, 50560, 50776, 50992,
+    51207, 51422, 51636, 51850, 52063, 52276, 52488, 52700,
+    52911, 53122, 53332, 53542, 53751, 53960, 54169, 54377,
+    54584, 54791, 54998, 55204, 55410, 55615, 55820, 56025,
+    56229, 56432, 56635, 56838, 57040, 57242, 57443, 57644,
+    57845, 58045, 58245, 58444, 58643, 58841, 59039, 59237,
+    59434, 59631, 59827, 60023, 60219, 60414, 60609, 60803,
+    60997, 61190, 61384, 61576, 61769, 61961, 62152, 62343,
+    62534, 62725, 62915, 63104, 63294, 63483, 63671, 63859,
+    64047, 64234, 64421, 64608, 64794, 64980, 65166, 65351,
+    65536,
+};
+static const int32_t _exp2_table[257] = {
+    65536, 65714, 65892, 66071, 66250, 66429, 66609, 66790,
+    66971, 67153, 67335, 67517, 67700, 67884, 68068, 68252,
+    68438, 68623, 68809, 68996, 69183, 69370, 69558, 69747,
+    69936, 70126, 70316, 70507, 70698, 70889, 71082, 71274,
+    71468, 71661, 71856, 72050, 72246, 72442, 72638, 72835,
+    73032, 73230, 73429, 73628, 73828, 74028, 74229, 74430,
+    74632, 74834, 75037, 75240, 75444, 75649, 75854, 76060,
+    76266, 76473, 76680, 76888, 77096, 77305, 77515, 77725,
+    77936, 78147, 78359, 78572, 78785, 78998, 79212, 79427,
+    79642, 79858, 80075, 80292, 80510, 80728, 80947, 81166,
+    81386, 81607, 81828, 82050, 82273, 82496, 82719, 82944,
+    83169, 83394, 83620, 83847, 84074, 84302, 84531, 84760,
+    84990, 85220, 85451, 85683, 85915, 86148, 86382, 86616,
+    86851, 87086, 87322, 87559, 87796, 88034, 88273, 88513,
+    88752, 88993, 89234, 89476, 89719, 89962, 90206, 90451,
+    90696, 90942, 91188, 91436, 91684, 91932, 92181, 92431,
+    92682, 92933, 93185, 93438, 93691, 93945, 94200, 94455,
+    94711, 94968, 95226, 95484, 95743, 96002, 96263, 96524,
+    96785, 97048, 97311, 97575, 97839, 98104, 98370, 98637,
+    98905, 99173, 99442, 99711, 99982, 100253, 100524, 100797,
+    101070, 101344, 101619, 101895, 102171, 102448, 102726, 103004,
+    103283, 103564, 103844, 104126, 104408, 104691, 104975, 105260,
+    105545, 105831, 106118, 106406, 106694, 106984, 107274, 107565,
+    107856, 108149, 108442, 108736, 109031, 109326, 109623, 109920,
+    110218, 110517, 110816, 111117, 111418, 111720, 112023, 112327,
+    112631, 112937, 113243, 113550, 113858, 114167, 114476, 114787,
+    115098, 115410, 115723, 116036, 116351, 116667, 116983, 117300,
+    117618, 117937, 118257, 118577, 118899, 119221, 119544, 119869,
+    120194, 120519, 120846, 121174, 121502, 121832, 122162, 122493,
+    122825, 123158, 123492, 123827, 124163, 124500, 124837, 125176,
+    125515, 125855, 126197, 126539, 126882, 127226, 127571, 127917,
+    128263, 128611, 128960, 129310, 129660, 130012, 130364, 130718,
+    131072,
+};
+
+static constexpr fixed_t _db_per_octave = fixed_t::from_raw_value(394566);  // 20 / log2(10)
+static constexpr fixed_t _octave_per_db = fixed_t::from_raw_value(10885);   // log2(10) / 20
+
+static inline int32_t lerp_table(const int32_t* table, uint32_t index, uint32_t fraction)
+{
+    return table[index] + static_cast<int32_t>(((table[index + 1] - table[index]) * static_cast<int32_t>(fraction)) >> 8);
+}
+
+/* ---------------------------------- log/exp --------------------------------- */
+
+fixed_t fixed_math::log2(fixed_t x)
+{
+    int32_t raw = x.raw_value();
+    if (raw <= 0) {
+        return fixed_t(-16);
+    }
+    int msb = 31 - __builtin_clz(static_cast<uint32_t>(raw));
+    // Mantissa with its leading one at bit 31: next 8 bits pick the entry, the 8 after interpolate
+    uint32_t mantissa = static_cast<uint32_t>(raw) << (31 - msb);
+    int32_t log = lerp_table(_log2_table, (mantissa >> 23) & 0xFF, (mantissa >> 15) & 0xFF);
+    return fixed_t::from_raw_value(((msb - 16) << 16) + log);
+}
+
+fixed_t fixed_math::exp2(fixed_t x)
+{
+    int32_t raw = x.raw_value();
+    int32_t whole = raw >> 16; // Floor, also for negatives
+    uint32_t fraction = static_cast<uint32_t>(raw) & 0xFFFF;
+    int32_t mantissa = lerp_table(_exp2_table, fraction >> 8, fraction & 0xFF); // 1..2, Q16
+    if (whole >= 15) {
+        return fixed_t::from_raw_value(INT32_MAX);
+    }
+    if (whole >= 0) {
+        return fixed_t::from_raw_value(mantissa << whole);
+    }
+    if (whole <= -18) {
+        return fixed_t::from_raw_value(0);
+    }
+    return fixed_t::from_raw_value(mantissa >> -whole);
+}
+
+/* ------------------------------------ dB ------------------------------------ */
+
+fixed_t fixed_math::level_to_db(fixed_t level)
+{
+    if (level.raw_value() <= 1) {
+        return DB_FLOOR;
+    }
+    return log2(level) * _db_per_octave;
+}
+
+fixed_t fixed_math::db_to_level(fixed_t db)
+{
+    return exp2(db * _octave_per_db);
+}
+
+fixed_t fixed_math::level_to_norm(fixed_t level, fixed_t dbMin)
+{
+    fixed_t db = level_to_db(level);
+    if (db <= dbMin) {
+        return fixed_t(0);
+    }
+    if (db >= fixed_t(0)) {
+        return fixed_t(1);
+    }
+    return (db - dbMin) / -dbMin;
+}
+
+int fixed_math::level_to_pixels(fixed_t level, fixed_t dbMin, int width)
+{
+    fixed_t db = level_to_db(level);
+    if (db <= dbMin) {
+        return 0;
+    }
+    if (db >= fixed_t(0)) {
+        return width;
+    }
+    return static_cast<int>(static_cast<int64_t>((db - dbMin).raw_value()) * width / -dbMin.raw_value());
+}
+
+/* ---------------------------------- Easing ---------------------------------- */
+
+fixed_t fixed_math::linear(fixed_t t)
+{
+    return t;
+}
+
+fixed_t fixed_math::ease_in_sine(fixed_t t)
+{
+    return fixed_t(1) - fpm::cos(t * fixed_t::half_pi());
+}
+
+fixed_t fixed_math::ease_out_sine(fixed_t t)
+{
+    return fpm::sin(t * fixed_t::half_pi());
+}
+
+fixed_t fixed_math::ease_in_out_sine(fixed_t t)
+{
+    return (fixed_t(1) - fpm::cos(t * fixed_t::pi())) / 2;
+}
+
+fixed_t fixed_math::ease_in_quad(fixed_t t)
+{
+    return t * t;
+}
+
+fixed_t fixed_math::ease_out_quad(fixed_t t)
+{
+    fixed_t u = fixed_t(1) - t;
+    return fixed_t(1) - u * u;
+}
+
+fixed_t fixed_math::ease_in_out_quad(fixed_t t)
+{
+    if (t < fixed_t::from_raw_value(32768)) {
+        return 2 * t * t;
+    }
+    fixed_t u = fixed_t(2) - 2 * t;
+    return fixed_t(1) - u * u / 2;
+}
+
+fixed_t fixed_math::ease_in_cubic(fixed_t t)
+{
+    return t * t * t;
+}
+
+fixed_t fixed_math::ease_out_cubic(fixed_t t)
+{
+    fixed_t u = fixed_t(1) - t;
+    return fixed_t(1) - u * u * u;
+}
+
+fixed_t fixed_math::ease_in_out_cubic(fixed_t t)
+{
+    if (t < fixed_t::from_raw_value(32768)) {
+        return 4 * t * t * t;
+    }
+    fixed_t u = fixed_t(2) - 2 * t;
+    return fixed_t(1) - u * u * u / 2;
+}
+
+fixed_t fixed_math::ease_out_back(fixed_t t)
+{
+    constexpr fixed_t c1 = fixed_t::from_raw_value(111514); // 1.70158
+    constexpr fixed_t c3 = fixed_t::from_raw_value(177050); // c1 + 1
+    fixed_t u = t - fixed_t(1);
+    return fixed_t(1) + c3 * u * u * u + c1 * u * u;
+}
+
+/* ---------------------------------- Spring ---------------------------------- */
+
+void fixed_math::Spring_t::teleport(fixed_t value)
+{
+    _start = value;
+    _end = value;
+    _progress = fixed_t(1);
+    _velocity = fixed_t(0);
+    _done = true;
+}
+
+void fixed_math::Spring_t::retarget(fixed_t end)
+{
+    fixed_t current = value();
+    fixed_t speed = _velocity * (_end - _start); // Value units per second
+    fixed_t range = end - current;
+    _start = current;
+    _end = end;
+    // Closer than restDelta: snap rather than divide the velocity by almost nothing
+    if (fpm::abs(range) < restDelta) {
+        _progress = fixed_t(1);
+        _velocity = fixed_t(0);
+        _done = true;
+        return;
+    }
+    _progress = fixed_t(0);
+    _velocity = speed / range;
+    _done = false;
+}
+
+bool fixed_math::Spring_t::step(fixed_t dt)
+{
+    if (_done) {
+        return true;
+    }
+    fixed_t range = _end - _start;
+    while (dt > fixed_t(0)) {
+        fixed_t h = dt < MAX_STEP ? dt : MAX_STEP;
+        dt -= h;
+        fixed_t acceleration = stiffness * (fixed_t(1) - _progress) - damping * _velocity;
+        _velocity += acceleration * h;
+        _progress += _velocity * h;
+    }
+    if (fpm::abs((fixed_t(1) - _progress) * range) < restDelta && fpm::abs(_velocity * range) < restSpeed) {
+        _progress = fixed_t(1);
+        _velocity = fixed_t(0);
+        _done = true;
+    }
+    return _done;
+}
+
+fixed_t fixed_math::Spring_t::value() const
+{
+    return _start + (_end - _start) * _progress;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file fixed_math.h
+ * @author Forairaaaaa
+ * @brief
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include "../fpm/fixed.hpp"
+#include <cstdint>
+
+namespace smooth_ui_toolkit {
+
+/**
+ * @brief Integer-only UI math on 16.16 fixed point: dB mapping, easing and a spring
+ *
+ * log2/exp2 go through 257-entry tables (the mantissa's top 8 bits pick the entry, the next 8 interpolate), good to
+ * about 0.001 dB, which is far below a pixel on any meter. Everything here is integer arithmetic once the inputs are
+ * fixed_t, so UI ticks that use it leave the FPU alone.
+ *
+ * Range: fixed_t holds ±32767 with 1/65536 resolution, so linear levels bottom out at -96 dB (the level itself is
+ * only good to 0.06 dB at -60 dB) and the spring works in normalized progress to keep its products in range.
+ */
+namespace fixed_math {
+
+using fixed_t = fpm::fixed_16_16;
+
+/* ---------------------------------- log/exp --------------------------------- */
+
+// log2(x); x <= 0 gives the smallest representable level's log2 (-16)
+fixed_t log2(fixed_t x);
+// 2^x, saturating at the top of the range
+fixed_t exp2(fixed_t x);
+
+/* ------------------------------------ dB ------------------------------------ */
+
+static constexpr fixed_t DB_FLOOR = fixed_t::from_raw_value(-6313056); // -96.33 dB, 20*log10(1/65536)
+
+// 20*log10(level); DB_FLOOR for level <= 1/65536
+fixed_t level_to_db(fixed_t level);
+// 10^(db/20)
+fixed_t db_to_level(fixed_t db);
+
+// 0..1 position of a linear level on the dbMin..0 dB scale, clamped
+fixed_t level_to_norm(fixed_t level, fixed_t dbMin);
+// Same, scaled to 0..width pixels
+int level_to_pixels(fixed_t level, fixed_t dbMin, int width);
+
+/* ---------------------------------- Easing ---------------------------------- */
+// Same curves as ease::, t in 0..1
+
+fixed_t linear(fixed_t t);
+fixed_t ease_in_sine(fixed_t t);
+fixed_t ease_out_sine(fixed_t t);
+fixed_t ease_in_out_sine(fixed_t t);
+
+fixed_t ease_in_quad(fixed_t t);
+fixed_t ease_out_quad(fixed_t t);
+fixed_t ease_in_out_quad(fixed_t t);
+
+fixed_t ease_in_cubic(fixed_t t);
+fixed_t ease_out_cubic(fixed_t t);
+fixed_t ease_in_out_cubic(fixed_t t);
+
+fixed_t ease_out_back(fixed_t t);
+
+/* ---------------------------------- Spring ---------------------------------- */
+
+/**
+ * @brief Damped spring toward end, integrated step by step (semi-implicit Euler, at most MAX_STEP per substep)
+ *
+ * Unit mass. Unlike the float Spring's closed form it carries its own state, so retarget() keeps the velocity
+ * naturally. Position is kept as 0..1 progress from start to end so stiffness times displacement stays in range.
+ */
+struct Spring_t {
+    static constexpr fixed_t MAX_STEP = fixed_t::from_raw_value(262); // 4 ms
+
+    fixed_t stiffness{100};
+    fixed_t damping{10};
+    fixed_t restDelta = fixed_t::from_raw_value(6554); // 0.1, in value units
+    fixed_t restSpeed = fixed_t::from_raw_value(6554); // 0.1, in value units per second
+
+    void teleport(fixed_t value);
+    void retarget(fixed_t end);
+
+    // Advance by dt seconds; returns done()
+    bool step(fixed_t dt);
+
+    fixed_t value() const;
+    fixed_t target() const
+    {
+        return _end;
+    }
+    bool done() const
+    {
+        return _done;
+    }
+
+private:
+    fixed_t _start{0};
+    fixed_t _end{0};
+    fixed_t _progress{1}; // 0 at _start, 1 at _end
+    fixed_t _velocity{0}; // Progress per second
+    bool _done = true;
+};
+
+} // namespace fixed_math
+} // namespace smooth_ui_toolkit
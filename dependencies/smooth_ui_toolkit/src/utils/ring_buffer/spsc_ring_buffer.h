@@ -0,0 +1,151 @@
+/**
+ * @file spsc_ring_buffer.h
+ * @author Forairaaaaa
+ * @brief
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace smooth_ui_toolkit {
+
+/**
+ * @brief Fixed-capacity, wait-free single-producer / single-consumer ring
+ *
+ * The lock-free counterpart of ring_buffer: storage lives in the object, Capacity is a power of two and fixed at
+ * compile time, and there are no callbacks. One thread pushes, one other thread pops; each side owns its index and
+ * publishes it with a release store, reading the other's with an acquire load.
+ *
+ * The producer never blocks and never overwrites: items that don't fit are dropped and counted, so a consumer that
+ * falls behind shows up in dropped(). Bulk push_n/pop_n copy in at most two contiguous runs, which is what sample
+ * and byte streams want.
+ *
+ * @tparam T Item type, copy-assignable
+ * @tparam Capacity Ring size, a power of two
+ */
+template <typename T, size_t Capacity>
+class spsc_ring_buffer {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "spsc_ring_buffer capacity must be a power of two");
+
+public:
+    static constexpr size_t capacity()
+    {
+        return Capacity;
+    }
+
+    /* -------------------------------- Producer -------------------------------- */
+
+    bool push(const T& value)
+    {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        uint32_t tail = _tail.load(std::memory_order_acquire);
+        if (head - tail >= Capacity) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        _items[head & (Capacity - 1)] = value;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Pushes as many of the count values as fit, returns how many; the rest count as dropped
+    size_t push_n(const T* values, size_t count)
+    {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        uint32_t tail = _tail.load(std::memory_order_acquire);
+        size_t n = std::min(count, static_cast<size_t>(Capacity - (head - tail)));
+        size_t index = head & (Capacity - 1);
+        size_t first = std::min(n, Capacity - index);
+        std::copy(values, values + first, _items + index);
+        std::copy(values + first, values + n, _items);
+        _head.store(head + static_cast<uint32_t>(n), std::memory_order_release);
+        if (n < count) {
+            _dropped.fetch_add(static_cast<uint32_t>(count - n), std::memory_order_relaxed);
+        }
+        return n;
+    }
+
+    // Room for this many more items, as seen by the producer
+    size_t available() const
+    {
+        return Capacity - (_head.load(std::memory_order_relaxed) - _tail.load(std::memory_order_acquire));
+    }
+
+    /* -------------------------------- Consumer -------------------------------- */
+
+    // Copies up to maxCount of the oldest items into out and removes them, returns how many
+    size_t pop_n(T* out, size_t maxCount)
+    {
+        size_t n = peek_n(out, maxCount);
+        _tail.store(_tail.load(std::memory_order_relaxed) + static_cast<uint32_t>(n), std::memory_order_release);
+        return n;
+    }
+
+    // Moves the oldest item into out and removes it; false when empty
+    bool pop(T& out)
+    {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        out = _items[tail & (Capacity - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Copies up to maxCount of the oldest items into out without removing them
+    size_t peek_n(T* out, size_t maxCount) const
+    {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        uint32_t head = _head.load(std::memory_order_acquire);
+        size_t n = std::min(maxCount, static_cast<size_t>(head - tail));
+        size_t index = tail & (Capacity - 1);
+        size_t first = std::min(n, Capacity - index);
+        std::copy(_items + index, _items + index + first, out);
+        std::copy(_items, _items + (n - first), out + first);
+        return n;
+    }
+
+    // Removes up to count of the oldest items unread, returns how many
+    size_t skip(size_t count)
+    {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        uint32_t head = _head.load(std::memory_order_acquire);
+        size_t n = std::min(count, static_cast<size_t>(head - tail));
+        _tail.store(tail + static_cast<uint32_t>(n), std::memory_order_release);
+        return n;
+    }
+
+    // Items waiting, as seen by the consumer
+    size_t size() const
+    {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_relaxed);
+    }
+
+    bool empty() const
+    {
+        return _tail.load(std::memory_order_relaxed) == _head.load(std::memory_order_acquire);
+    }
+
+    /* ---------------------------------- Either --------------------------------- */
+
+    uint32_t dropped() const
+    {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    T _items[Capacity];
+    std::atomic<uint32_t> _head{0};
+    std::atomic<uint32_t> _tail{0};
+    std::atomic<uint32_t> _dropped{0};
+};
+
+} // namespace smooth_ui_toolkit
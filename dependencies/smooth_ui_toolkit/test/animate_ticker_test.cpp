@@ -0,0 +1,111 @@
+/**
+ * @file animate_ticker_test.cpp
+ * @author Forairaaaaa
+ * @brief
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <smooth_ui_toolkit.h>
+
+using namespace smooth_ui_toolkit;
+
+static uint32_t _tick_ms = 0;
+
+// 按 16ms 一帧推进时间并 tick
+static void run_frames(AnimateTicker& ticker, int frames)
+{
+    for (int i = 0; i < frames; i++) {
+        _tick_ms += 16;
+        ticker.tick();
+    }
+}
+
+// 一次 tick 更新所有动画，静止后休眠，不再回调
+void test_sleep_and_wake()
+{
+    std::cout << "Running sleep and wake tests on animate_ticker...\n";
+
+    AnimateTicker ticker;
+    AnimateValue x(0.0f);
+    AnimateValue y(0.0f);
+    int x_updates = 0;
+    x.onUpdate([&](const float&) { x_updates++; });
+    x.setTicker(&ticker);
+    y.setTicker(&ticker);
+    assert(ticker.animationNum() == 2 && "Both animations should be attached");
+
+    // 起点等于终点，一帧后休眠
+    run_frames(ticker, 2);
+    assert(ticker.awakeNum() == 0 && "Settled animations should sleep");
+
+    x = 100.0f;
+    y.easingOptions().duration = 0.3f;
+    y = 50.0f;
+    assert(ticker.awakeNum() == 2 && "Moving should wake the animations");
+
+    // 读取值不会推进动画，只有 tick 会
+    float before = x.value();
+    assert(x.value() == before && "Reading an attached value should not update it");
+
+    run_frames(ticker, 300);
+    assert(std::fabs(x.value() - 100.0f) < 0.5f && "Spring should reach its target");
+    assert(std::fabs(y.value() - 50.0f) < 0.01f && "Easing should reach its target");
+    assert(ticker.awakeNum() == 0 && "Finished animations should sleep");
+
+    int settled_updates = x_updates;
+    run_frames(ticker, 50);
+    assert(x_updates == settled_updates && "Sleeping animations should not invoke callbacks");
+
+    x.setTicker(nullptr);
+    assert(ticker.animationNum() == 1 && "Detach should leave one animation");
+    std::cout << "Test passed!\n";
+}
+
+// 回调里销毁、唤醒其他动画
+void test_changes_during_tick()
+{
+    std::cout << "Running mid tick change tests on animate_ticker...\n";
+
+    AnimateTicker ticker;
+    auto doomed = std::make_unique<AnimateValue>(0.0f);
+    AnimateValue trigger(0.0f);
+    AnimateValue follower(0.0f);
+    doomed->setTicker(&ticker);
+    trigger.setTicker(&ticker);
+    follower.setTicker(&ticker);
+    run_frames(ticker, 2);
+
+    bool fired = false;
+    trigger.onUpdate([&](const float& value) {
+        if (!fired && value > 10.0f) {
+            fired = true;
+            doomed.reset();
+            follower = 30.0f;
+        }
+    });
+    *doomed = 20.0f;
+    trigger = 20.0f;
+    run_frames(ticker, 300);
+
+    assert(fired && "Trigger should have fired");
+    assert(ticker.animationNum() == 2 && "Destroyed animation should detach itself");
+    assert(std::fabs(follower.value() - 30.0f) < 0.5f && "Animation woken mid tick should run");
+    assert(ticker.awakeNum() == 0 && "Everything should settle");
+    std::cout << "Test passed!\n";
+}
+
+int main()
+{
+    ui_hal::on_get_tick([]() { return _tick_ms; });
+    test_sleep_and_wake();
+    test_changes_during_tick();
+    return 0;
+}
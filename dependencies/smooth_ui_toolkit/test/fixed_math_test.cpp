@@ -0,0 +1,118 @@
+/**
+ * @file fixed_math_test.cpp
+ * @author Forairaaaaa
+ * @brief
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <utils/fixed_math/fixed_math.h>
+#include <utils/easing/ease.h>
+
+using namespace smooth_ui_toolkit;
+using fixed_math::fixed_t;
+
+// 和浮点版本对比误差
+void test_db()
+{
+    std::cout << "Running dB tests on fixed_math...\n";
+
+    float max_db_error = 0.0f;
+    for (float level = 0.0005f; level < 8.0f; level *= 1.01f) {
+        // Against the level as 16.16 holds it: the table, not the input's quantization
+        fixed_t quantized(level);
+        float expected = 20.0f * log10f(static_cast<float>(quantized));
+        float db = static_cast<float>(fixed_math::level_to_db(quantized));
+        max_db_error = std::max(max_db_error, std::fabs(db - expected));
+    }
+    std::cout << "max dB error: " << max_db_error << "\n";
+    assert(max_db_error < 0.002f && "level_to_db should track 20*log10");
+
+    float max_level_error = 0.0f;
+    for (float db = -60.0f; db <= 12.0f; db += 0.37f) {
+        float expected = powf(10.0f, db / 20.0f);
+        float level = static_cast<float>(fixed_math::db_to_level(fixed_t(db)));
+        max_level_error = std::max(max_level_error, std::fabs(level - expected) / expected);
+    }
+    std::cout << "max relative level error: " << max_level_error << "\n";
+    assert(max_level_error < 0.01f && "db_to_level should track 10^(dB/20)");
+
+    assert(fixed_math::level_to_db(fixed_t(0)) == fixed_math::DB_FLOOR && "Silence should map to the floor");
+    assert(fixed_math::level_to_pixels(fixed_t(0), fixed_t(-60), 400) == 0 && "Silence should be the left edge");
+    assert(fixed_math::level_to_pixels(fixed_t(2), fixed_t(-60), 400) == 400 && "Over 0 dB should clamp right");
+    int half = fixed_math::level_to_pixels(fixed_t(powf(10.0f, -30.0f / 20.0f)), fixed_t(-60), 400);
+    assert(std::abs(half - 200) <= 1 && "-30 dB should sit mid scale");
+    std::cout << "Test passed!\n";
+}
+
+void test_easing()
+{
+    std::cout << "Running easing tests on fixed_math...\n";
+
+    fixed_t (*fixed_curves[])(fixed_t) = {fixed_math::ease_in_sine,  fixed_math::ease_out_sine,
+                                          fixed_math::ease_in_out_sine, fixed_math::ease_in_quad,
+                                          fixed_math::ease_out_quad, fixed_math::ease_in_out_quad,
+                                          fixed_math::ease_in_cubic, fixed_math::ease_out_cubic,
+                                          fixed_math::ease_in_out_cubic, fixed_math::ease_out_back};
+    float (*float_curves[])(float) = {ease::ease_in_sine,      ease::ease_out_sine,  ease::ease_in_out_sine,
+                                      ease::ease_in_quad,      ease::ease_out_quad,  ease::ease_in_out_quad,
+                                      ease::ease_in_cubic,     ease::ease_out_cubic, ease::ease_in_out_cubic,
+                                      ease::ease_out_back};
+    for (int c = 0; c < 10; c++) {
+        for (int i = 0; i <= 100; i++) {
+            float t = i / 100.0f;
+            float error = std::fabs(static_cast<float>(fixed_curves[c](fixed_t(t))) - float_curves[c](t));
+            assert(error < 0.002f && "Fixed easing should track the float curve");
+        }
+    }
+    std::cout << "Test passed!\n";
+}
+
+void test_spring()
+{
+    std::cout << "Running spring tests on fixed_math...\n";
+
+    fixed_math::Spring_t spring;
+    spring.teleport(fixed_t(0));
+    assert(spring.done() && "Teleported spring should rest");
+
+    spring.retarget(fixed_t(300));
+    float peak = 0.0f;
+    int frames = 0;
+    fixed_t dt = fixed_t::from_raw_value(1049); // 16 ms
+    while (!spring.step(dt) && frames < 1000) {
+        peak = std::max(peak, static_cast<float>(spring.value()));
+        frames++;
+    }
+    std::cout << "settled in " << frames << " frames, peak " << peak << "\n";
+    assert(spring.done() && "Spring should settle");
+    assert(spring.value() == fixed_t(300) && "Settled spring should sit on its target");
+    assert(peak > 300.0f && peak < 450.0f && "Underdamped spring should overshoot a little");
+
+    // 中途改目标，速度延续
+    spring.retarget(fixed_t(0));
+    for (int i = 0; i < 5; i++) {
+        spring.step(dt);
+    }
+    float before = static_cast<float>(spring.value());
+    spring.retarget(fixed_t(100));
+    spring.step(dt);
+    assert(static_cast<float>(spring.value()) < before && "Retarget should keep the current velocity");
+    while (!spring.step(dt)) {
+    }
+    assert(spring.value() == fixed_t(100) && "Retargeted spring should settle on the new target");
+    std::cout << "Test passed!\n";
+}
+
+int main()
+{
+    test_db();
+    test_easing();
+    test_spring();
+    return 0;
+}
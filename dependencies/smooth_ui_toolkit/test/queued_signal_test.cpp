@@ -0,0 +1,105 @@
+/**
+ * @file queued_signal_test.cpp
+ * @author Forairaaaaa
+ * @brief
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <iostream>
+#include <cassert>
+#include <thread>
+#include <vector>
+#include <utils/event/queued_signal.h>
+
+using namespace smooth_ui_toolkit;
+
+struct Event_t {
+    int producer;
+    int sequence;
+};
+
+// 单线程：顺序、满了丢弃、断开
+void test_basic()
+{
+    std::cout << "Running basic tests on queued_signal...\n";
+
+    QueuedSignal<Event_t, 4> signal;
+    std::vector<int> received;
+    int slot_id = signal.connect([&](const Event_t& event) { received.push_back(event.sequence); });
+    assert(slot_id >= 0 && "Slot should connect");
+
+    // emit 不回调，dispatch 才回调
+    for (int i = 0; i < 4; i++) {
+        assert(signal.emit({0, i}) && "Emit should succeed while not full");
+    }
+    assert(received.empty() && "Slots should only run in dispatch");
+    assert(!signal.emit({0, 4}) && "Emit should fail when full");
+    assert(signal.dropped() == 1 && "Dropped event should be counted");
+
+    assert(signal.dispatch() == 4 && "Dispatch should take all queued events");
+    assert((received == std::vector<int>{0, 1, 2, 3}) && "Events should arrive in order");
+    assert(signal.empty() && "Queue should be empty after dispatch");
+
+    // 回绕后依旧可用，maxEvents 限制单次数量
+    for (int i = 0; i < 3; i++) {
+        signal.emit({0, 10 + i});
+    }
+    assert(signal.dispatch(2) == 2 && "Dispatch should respect maxEvents");
+    assert(signal.dispatch() == 1 && "Remaining event should dispatch next time");
+    assert(received.back() == 12 && "Last event should be the newest");
+
+    signal.disconnect(slot_id);
+    signal.emit({0, 20});
+    assert(signal.dispatch() == 1 && "Event is still taken without slots");
+    assert(received.size() == 7 && "Disconnected slot should not be called");
+    std::cout << "Test passed!\n";
+}
+
+// 多生产者：不丢不重，每个生产者内保持顺序
+void test_multi_producer()
+{
+    std::cout << "Running multi producer tests on queued_signal...\n";
+
+    constexpr int producer_num = 4;
+    constexpr int events_per_producer = 20000;
+    QueuedSignal<Event_t, 64> signal;
+    std::vector<int> next_sequence(producer_num, 0);
+    int total = 0;
+    signal.connect([&](const Event_t& event) {
+        assert(event.sequence == next_sequence[event.producer] && "Events of one producer should stay in order");
+        next_sequence[event.producer]++;
+        total++;
+    });
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < producer_num; p++) {
+        producers.emplace_back([&signal, p]() {
+            for (int i = 0; i < events_per_producer; i++) {
+                // 满了就等消费者
+                while (!signal.emit({p, i})) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    while (total < producer_num * events_per_producer) {
+        if (signal.dispatch() == 0) {
+            std::this_thread::yield();
+        }
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    assert(signal.empty() && "Nothing should be left over");
+    std::cout << "Test passed!\n";
+}
+
+int main()
+{
+    test_basic();
+    test_multi_producer();
+    return 0;
+}
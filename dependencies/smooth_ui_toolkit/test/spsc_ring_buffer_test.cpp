@@ -0,0 +1,111 @@
+/**
+ * @file spsc_ring_buffer_test.cpp
+ * @author Forairaaaaa
+ * @brief
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <iostream>
+#include <cassert>
+#include <thread>
+#include <vector>
+#include <utils/ring_buffer/spsc_ring_buffer.h>
+
+using namespace smooth_ui_toolkit;
+
+// 单线程：单个、批量、回绕、满了丢弃
+void test_basic()
+{
+    std::cout << "Running basic tests on spsc_ring_buffer...\n";
+
+    spsc_ring_buffer<int, 8> buffer;
+    assert(buffer.empty() && "Buffer should be empty initially");
+    assert(buffer.available() == 8 && "Whole capacity should be available");
+
+    for (int i = 0; i < 6; i++) {
+        assert(buffer.push(i) && "Push should succeed while not full");
+    }
+    int out[8] = {};
+    assert(buffer.pop_n(out, 4) == 4 && "Pop should take what was asked");
+    assert(out[0] == 0 && out[3] == 3 && "Items should come out in order");
+
+    // 跨越末尾的批量写入
+    int values[] = {6, 7, 8, 9, 10, 11, 12};
+    assert(buffer.push_n(values, 7) == 6 && "Push_n should stop at capacity");
+    assert(buffer.dropped() == 1 && "The item that did not fit should be dropped");
+    assert(buffer.size() == 8 && "Buffer should be full");
+    assert(!buffer.push(13) && "Push should fail when full");
+    assert(buffer.dropped() == 2 && "Failed push should be counted");
+
+    assert(buffer.peek_n(out, 3) == 3 && out[0] == 4 && out[2] == 6 && "Peek should read the oldest items");
+    assert(buffer.size() == 8 && "Peek should not remove items");
+    assert(buffer.skip(2) == 2 && "Skip should drop the oldest items");
+    assert(buffer.pop_n(out, 8) == 6 && "Pop_n should take the rest");
+    std::vector<int> expected = {6, 7, 8, 9, 10, 11};
+    assert(std::vector<int>(out, out + 6) == expected && "Wrapped items should come out in order");
+    assert(buffer.empty() && "Buffer should be empty after popping all items");
+
+    int one = -1;
+    assert(!buffer.pop(one) && one == -1 && "Pop should fail when empty");
+    buffer.push(42);
+    buffer.push(43);
+    assert(buffer.pop(one) && one == 42 && "Pop should take the oldest item");
+    assert(buffer.size() == 1 && "Pop should remove exactly one item");
+    std::cout << "Test passed!\n";
+}
+
+// 双线程：批量写入读出，不丢不乱
+void test_threads()
+{
+    std::cout << "Running producer / consumer tests on spsc_ring_buffer...\n";
+
+    constexpr uint32_t total = 1000000;
+    spsc_ring_buffer<uint32_t, 256> buffer;
+
+    std::thread producer([&buffer]() {
+        uint32_t chunk[37];
+        uint32_t next = 0;
+        while (next < total) {
+            size_t count = 0;
+            while (count < 37 && next + count < total) {
+                chunk[count] = next + count;
+                count++;
+            }
+            size_t written = 0;
+            while (written < count) {
+                size_t n = std::min(buffer.available(), count - written);
+                written += buffer.push_n(chunk + written, n);
+                if (n == 0) {
+                    std::this_thread::yield();
+                }
+            }
+            next += count;
+        }
+    });
+
+    uint32_t expected = 0;
+    uint32_t chunk[53];
+    while (expected < total) {
+        size_t n = buffer.pop_n(chunk, 53);
+        for (size_t i = 0; i < n; i++) {
+            assert(chunk[i] == expected && "Items should arrive in order");
+            expected++;
+        }
+        if (n == 0) {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    assert(buffer.dropped() == 0 && "Nothing should be dropped when the producer checks available()");
+    std::cout << "Test passed!\n";
+}
+
+int main()
+{
+    test_basic();
+    test_threads();
+    return 0;
+}